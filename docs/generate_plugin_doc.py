@@ -10,6 +10,7 @@ import re
 SHAPE_ORDERING = ['obj',
                   'ply',
                   'serialized',
+                  'mtsmesh',
                   'sphere',
                   'cylinder',
                   'disk',
@@ -58,10 +59,16 @@ SAMPLER_ORDERING = ['independent',
                     'stratified',
                     'multijitter',
                     'orthogonal',
-                    'ldsampler']
+                    'ldsampler',
+                    'halton',
+                    'sobol',
+                    'bluenoise']
 
 INTEGRATOR_ORDERING = ['direct',
                        'path',
+                       'ptracer',
+                       'photonmapper',
+                       'irrcache',
                        'aov']
 
 FILM_ORDERING = ['hdrfilm']
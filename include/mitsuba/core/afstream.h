@@ -0,0 +1,103 @@
+#pragma once
+
+#include <mitsuba/core/fstream.h>
+#include <memory>
+
+NAMESPACE_BEGIN(mitsuba)
+
+/** \brief Read-only \ref Stream implementation backed-up by a file, which
+ * reads ahead of the current position on a background thread.
+ *
+ * The file is loaded in blocks of \c block_size bytes into a pool of \c
+ * block_count buffers, which are refilled while the consumer decodes the
+ * contents of the previous ones. This lets mesh and image loaders overlap
+ * their parsing work with the I/O latency of the underlying storage (e.g. a
+ * network file system). Sequential reads are served from the pool and seeks
+ * within the buffered range are free, while other seeks restart the
+ * read-ahead at the new position.
+ *
+ * The stream must not be accessed concurrently from several threads.
+ */
+class MTS_EXPORT_CORE AsyncFileStream : public Stream {
+public:
+    using Stream::read;
+    using Stream::write;
+
+    /** \brief Opens the file pointed by <tt>p</tt> and starts reading it
+     *
+     * Throws an exception if the file cannot be opened.
+     */
+    AsyncFileStream(const fs::path &p, size_t block_size = 1024 * 1024,
+                    size_t block_count = 4);
+
+    /** \brief Stops the read-ahead and closes the underlying file.
+     * No further read operations are permitted.
+     *
+     * This function is idempotent.
+     * It is called automatically by the destructor.
+     */
+    virtual void close() override;
+
+    /// Whether the stream is closed (no read operations are then permitted)
+    virtual bool is_closed() const override;
+
+    /// Return the path descriptor associated with this stream
+    const fs::path &path() const;
+
+    /// Return the size of the blocks that are read ahead
+    size_t block_size() const;
+
+    /// Return the number of blocks that can be read ahead
+    size_t block_count() const;
+
+    // =========================================================================
+    //! @{ \name Implementation of the Stream interface
+    // =========================================================================
+
+    /**
+     * \brief Reads a specified amount of data from the stream.
+     * Throws an exception when the stream ended prematurely.
+     */
+    virtual void read(void *p, size_t size) override;
+
+    /// Not supported: always throws an exception
+    virtual void write(const void *p, size_t size) override;
+
+    /// Seeks to a position inside the stream
+    virtual void seek(size_t pos) override;
+
+    /// Not supported: always throws an exception
+    virtual void truncate(size_t size) override;
+
+    /// Gets the current position inside the file
+    virtual size_t tell() const override;
+
+    /// Returns the size of the file
+    virtual size_t size() const override;
+
+    /// No-op (the stream is read-only)
+    virtual void flush() override { }
+
+    /// Always returns false (the stream is read-only)
+    virtual bool can_write() const override { return false; }
+
+    /// True except if the stream was closed.
+    virtual bool can_read() const override { return !is_closed(); }
+
+    /// Returns a string representation
+    virtual std::string to_string() const override;
+
+    //! @}
+    // =========================================================================
+
+    MTS_DECLARE_CLASS()
+protected:
+    /// Protected destructor
+    virtual ~AsyncFileStream();
+
+private:
+    struct AsyncFileStreamPrivate;
+    std::unique_ptr<AsyncFileStreamPrivate> d;
+};
+
+NAMESPACE_END(mitsuba)
@@ -0,0 +1,114 @@
+#pragma once
+
+#include <mitsuba/mitsuba.h>
+#include <cstddef>
+#include <memory>
+#include <new>
+
+NAMESPACE_BEGIN(mitsuba)
+
+/**
+ * \brief Region-based allocator for many small allocations that share a
+ * common lifetime
+ *
+ * Allocations are carved out of large blocks by incrementing a pointer, and
+ * individual allocations are never freed: the memory of all of them is
+ * returned at once by \ref release() or by the destructor. This avoids the
+ * allocator overheads and the fragmentation caused by the many short-lived
+ * containers that are created while loading a scene (e.g. the entries of the
+ * \ref Properties instances of all scene objects).
+ *
+ * Destructors of the objects stored in the arena are not invoked: their
+ * owners (typically containers using \ref ArenaAllocator) must destroy them
+ * before the arena is released.
+ *
+ * All functions are thread-safe.
+ */
+class MTS_EXPORT_CORE MemoryArena {
+public:
+    /// Create an arena that reserves memory in blocks of \c block_size bytes
+    MemoryArena(size_t block_size = 64 * 1024);
+
+    MemoryArena(const MemoryArena &) = delete;
+    MemoryArena &operator=(const MemoryArena &) = delete;
+
+    /// Release all memory of the arena
+    ~MemoryArena();
+
+    /**
+     * \brief Allocate \c size bytes with the given alignment
+     *
+     * Requests that exceed a quarter of the block size receive a separate
+     * block, so that they don't waste the remainder of the current one.
+     */
+    void *allocate(size_t size, size_t align = alignof(std::max_align_t));
+
+    /// Release the memory of all allocations at once
+    void release();
+
+    /// Return the number of bytes that were allocated since the last release
+    size_t allocated() const;
+
+    /// Return the number of bytes that are reserved by the blocks of the arena
+    size_t capacity() const;
+
+    /// Return the size of the blocks of the arena
+    size_t block_size() const;
+
+private:
+    struct MemoryArenaPrivate;
+    std::unique_ptr<MemoryArenaPrivate> d;
+};
+
+/**
+ * \brief STL allocator that obtains its memory from a \ref MemoryArena
+ *
+ * Allocators without an arena forward to the global heap, which lets the
+ * same container type be used both inside and outside of an arena.
+ * Deallocation is a no-op for arena memory.
+ *
+ * Copies of a container never inherit the arena of the original. They use
+ * the heap instead, so that a copy can safely outlive the arena. This
+ * happens, for instance, when a plugin keeps the \ref Properties that it
+ * was constructed with.
+ */
+template <typename T> struct ArenaAllocator {
+    using value_type = T;
+    using propagate_on_container_copy_assignment = std::false_type;
+    using propagate_on_container_move_assignment = std::false_type;
+    using propagate_on_container_swap = std::false_type;
+
+    ArenaAllocator(MemoryArena *arena = nullptr) noexcept : arena(arena) { }
+
+    template <typename T2>
+    ArenaAllocator(const ArenaAllocator<T2> &other) noexcept : arena(other.arena) { }
+
+    T *allocate(size_t n) {
+        if (arena)
+            return (T *) arena->allocate(n * sizeof(T), alignof(T));
+        else
+            return std::allocator<T>().allocate(n);
+    }
+
+    void deallocate(T *ptr, size_t n) noexcept {
+        if (!arena)
+            std::allocator<T>().deallocate(ptr, n);
+    }
+
+    /// Copies of a container allocate from the heap
+    ArenaAllocator select_on_container_copy_construction() const {
+        return ArenaAllocator();
+    }
+
+    template <typename T2> bool operator==(const ArenaAllocator<T2> &other) const {
+        return arena == other.arena;
+    }
+
+    template <typename T2> bool operator!=(const ArenaAllocator<T2> &other) const {
+        return arena != other.arena;
+    }
+
+    MemoryArena *arena;
+};
+
+NAMESPACE_END(mitsuba)
@@ -295,6 +295,30 @@ public:
     /// Return whether the bitmap uses premultiplied alpha
     bool premultiplied_alpha() const { return m_premultiplied_alpha; }
 
+    /**
+     * \brief Specify the tile size of OpenEXR files written by \ref write()
+     *
+     * Tiled files let readers load parts of large images. The default value
+     * 0 writes scanline-based files.
+     */
+    void set_exr_tile_size(uint32_t value) { m_exr_tile_size = value; }
+
+    /// Return the tile size of OpenEXR files written by \ref write()
+    uint32_t exr_tile_size() const { return m_exr_tile_size; }
+
+    /**
+     * \brief Specify whether \ref write() produces multi-part OpenEXR files
+     *
+     * Multi-part files store the channels of each layer (e.g. \c albedo.R,
+     * \c albedo.G, and \c albedo.B) in a separate part, which readers can
+     * load without decompressing the other layers. The channels that do not
+     * belong to a layer form the \c default part.
+     */
+    void set_exr_multi_part(bool value) { m_exr_multi_part = value; }
+
+    /// Return whether \ref write() produces multi-part OpenEXR files
+    bool exr_multi_part() const { return m_exr_multi_part; }
+
     /// Specify whether the bitmap uses premultiplied alpha
     void set_premultiplied_alpha(bool value);
 
@@ -376,10 +400,20 @@ public:
     void write(const fs::path &path, FileFormat format = FileFormat::Auto,
                int quality = -1) const;
 
-    /// Equivalent to \ref write(), but executes asynchronously on a different thread
+    /**
+     * \brief Equivalent to \ref write(), but executes asynchronously on a
+     * different thread
+     *
+     * The bitmap must not be modified until the write has completed. When
+     * another asynchronous write to the same path is still in progress, this
+     * function first waits for its completion. Errors are reported as warnings.
+     */
     void write_async(const fs::path &path, FileFormat format = FileFormat::Auto,
                      int quality = -1) const;
 
+    /// Wait until all asynchronous writes (see \ref write_async()) have completed
+    static void wait_async_writes();
+
     /**
      * \brief Up- or down-sample this image to a different resolution
      *
@@ -561,6 +595,19 @@ public:
     /// Attempt to detect the bitmap file format in a given stream
     static FileFormat detect_file_format(Stream *stream);
 
+    /**
+     * \brief Only read the header of a bitmap file
+     *
+     * The returned bitmap has the size, pixel format, component format and
+     * metadata of the image stored in the file, but no pixel storage
+     * (\ref data() returns \c nullptr). This is considerably cheaper than
+     * decoding the entire image.
+     *
+     * OpenEXR files are described with the channels as stored, i.e. without
+     * the conversion of nonstandard chromaticities to XYZ.
+     */
+    static ref<Bitmap> read_header(const fs::path &path, FileFormat format = FileFormat::Auto);
+
     /// Vertically flip the bitmap
     void vflip();
 
@@ -581,6 +628,9 @@ public:
 
     MTS_DECLARE_CLASS()
  protected:
+     /// Create an empty bitmap, which is used by \ref read_header()
+     Bitmap() : m_owns_data(false), m_header_only(true) { }
+
      /// Protected destructor
      virtual ~Bitmap();
 
@@ -640,9 +690,81 @@ public:
      bool m_srgb_gamma;
      bool m_premultiplied_alpha;
      bool m_owns_data;
+     uint32_t m_exr_tile_size = 0;
+     bool m_exr_multi_part = false;
+     /// Only read the header in \ref read() (see \ref read_header())
+     bool m_header_only = false;
      Properties m_metadata;
 };
 
+/**
+ * \brief Incrementally writes a tiled OpenEXR file, one row of tiles at a time
+ *
+ * In contrast to \ref Bitmap::write(), the image never needs to be resident
+ * in memory as a whole: its rows are passed to \ref write() as a sequence of
+ * strips (bitmaps spanning the full width of the image) from top to bottom.
+ * This is used to develop very large images while they are being rendered.
+ */
+class MTS_EXPORT_CORE TiledOpenEXRWriter : public Object {
+public:
+    using Vector2u = Bitmap::Vector2u;
+
+    /**
+     * \brief Create the file and write its header
+     *
+     * \param filename
+     *    Path of the target file
+     *
+     * \param prototype
+     *    Bitmap whose pixel format, channels and metadata determine the
+     *    layout of the file (its size and contents are ignored)
+     *
+     * \param size
+     *    Resolution of the whole image
+     *
+     * \param tile_size
+     *    Width and height of the (square) tiles
+     *
+     * \param quality
+     *    Compression settings (see \ref Bitmap::write())
+     */
+    TiledOpenEXRWriter(const fs::path &filename, const Bitmap *prototype,
+                       const Vector2u &size, uint32_t tile_size, int quality = -1);
+
+    /**
+     * \brief Append the rows of \c strip to the image
+     *
+     * The strip must have the layout of the prototype bitmap and the width
+     * of the image. Its height must be a multiple of the tile size, unless
+     * it reaches the bottom of the image.
+     */
+    void write(const Bitmap *strip);
+
+    /// Finish writing the file. This happens automatically upon destruction.
+    void close();
+
+    /// Return the number of rows written so far
+    uint32_t rows_written() const;
+
+    /// Return the resolution of the image
+    const Vector2u &size() const;
+
+    /// Return the size of the tiles
+    uint32_t tile_size() const;
+
+    /// Return a human-readable summary
+    std::string to_string() const override;
+
+    MTS_DECLARE_CLASS()
+protected:
+    /// Protected destructor
+    virtual ~TiledOpenEXRWriter();
+
+private:
+    struct TiledOpenEXRWriterPrivate;
+    std::unique_ptr<TiledOpenEXRWriterPrivate> d;
+};
+
 
 /**
  * \brief Accumulate the contents of a source bitmap into a
@@ -202,6 +202,19 @@ public:                                             \
     MTS_VARIANT const Class *Name<Float, Spectrum>::class_() const { return m_class; }
 
 
+#if defined(MTS_MONOLITHIC_PLUGINS)
+NAMESPACE_BEGIN(detail)
+/// Register a plugin of the library of all plugins (\c name is the file name of the plugin)
+extern MTS_EXPORT_CORE bool register_plugin(const char *name, const char *plugin_name,
+                                            const char *plugin_descr);
+NAMESPACE_END(detail)
+
+/// Instantiate a Mitsuba plugin and register it when the library of all plugins is loaded
+#define MTS_EXPORT_PLUGIN(Name, Descr)                                                             \
+    [[maybe_unused]] static bool plugin_registered =                                               \
+        ::mitsuba::detail::register_plugin(MTS_PLUGIN_NAME, #Name, Descr);                         \
+    MTS_INSTANTIATE_CLASS(Name)
+#else
 /// Instantiate and export a Mitsuba plugin
 #define MTS_EXPORT_PLUGIN(Name, Descr)                                                             \
     extern "C" {                                                                                   \
@@ -209,6 +222,7 @@ public:                                             \
         MTS_EXPORT const char *plugin_descr() { return Descr; }                                    \
     }                                                                                              \
     MTS_INSTANTIATE_CLASS(Name)
+#endif
 
 // This macro is needed to get this to compile across all compilers
 #define MTS_IMPORT_BASE_HELPER(...) Base, ##__VA_ARGS__
@@ -3,9 +3,147 @@
 #include <mitsuba/core/logger.h>
 #include <mitsuba/core/vector.h>
 #include <mitsuba/core/math.h>
+#include <mitsuba/core/simd.h>
+#include <memory>
+#include <vector>
 
 NAMESPACE_BEGIN(mitsuba)
 
+/**
+ * \brief Alias table for sampling a discrete 1D distribution in constant time
+ *
+ * The table is built in linear time using Vose's method and stores, for each
+ * of its \c n entries, the probability of keeping the entry along with an
+ * alias that is chosen otherwise. Sampling therefore takes two lookups
+ * regardless of the number of entries. In contrast to the inversion of a CDF,
+ * the mapping from samples to indices is not monotonic, which does not
+ * preserve the stratification of the samples.
+ *
+ * This is used by the distributions below once their \c build_alias_table()
+ * method has been called.
+ */
+template <typename Float> struct AliasTable {
+    using FloatStorage = DynamicBuffer<Float>;
+    using Index = uint32_array_t<Float>;
+    using IndexStorage = DynamicBuffer<Index>;
+    using Mask = mask_t<Float>;
+
+    using ScalarFloat = scalar_t<Float>;
+
+public:
+    /// Create an unitialized AliasTable instance
+    AliasTable() { }
+
+    /// Build the table for the given non-negative (unnormalized) weights
+    template <typename T> AliasTable(const T *weights, size_t size) {
+        if (size == 0)
+            Throw("AliasTable: empty distribution!");
+
+        double sum = 0.0;
+        uint32_t fallback = (uint32_t) -1;
+        for (size_t i = 0; i < size; ++i) {
+            sum += (double) weights[i];
+            if (fallback == (uint32_t) -1 && weights[i] > 0)
+                fallback = (uint32_t) i;
+        }
+
+        if (!(sum > 0.0))
+            Throw("AliasTable: no probability mass found!");
+
+        std::vector<double> q(size);
+        std::vector<uint32_t> small, large;
+        for (size_t i = 0; i < size; ++i) {
+            q[i] = (double) weights[i] * (double) size / sum;
+            (q[i] < 1.0 ? small : large).push_back((uint32_t) i);
+        }
+
+        std::unique_ptr<ScalarFloat[]> prob(new ScalarFloat[size]);
+        std::unique_ptr<uint32_t[]> alias(new uint32_t[size]);
+
+        // Pair each entry below the average with one above it
+        while (!small.empty() && !large.empty()) {
+            uint32_t s = small.back(), l = large.back();
+            small.pop_back();
+
+            prob[s] = (ScalarFloat) q[s];
+            alias[s] = l;
+
+            q[l] -= 1.0 - q[s];
+            if (q[l] < 1.0) {
+                large.pop_back();
+                small.push_back(l);
+            }
+        }
+
+        // The remaining entries only differ from the average due to roundoff
+        for (uint32_t l : large) {
+            prob[l] = 1.f;
+            alias[l] = l;
+        }
+        for (uint32_t s : small) {
+            bool nonzero = weights[s] > 0;
+            prob[s] = nonzero ? 1.f : 0.f;
+            alias[s] = nonzero ? s : fallback;
+        }
+
+        m_prob = FloatStorage::copy(prob.get(), size);
+        m_alias = IndexStorage::copy(alias.get(), size);
+    }
+
+    /// Return the number of entries
+    size_t size() const { return m_prob.size(); }
+
+    /// Is the table empty/uninitialized?
+    bool empty() const { return m_prob.empty(); }
+
+    /**
+     * \brief %Transform a uniformly distributed sample to the stored
+     * distribution
+     *
+     * \param value
+     *     A uniformly distributed sample on the interval [0, 1].
+     *
+     * \return
+     *     A tuple consisting of
+     *
+     *     1. the discrete index associated with the sample, and
+     *     2. the re-scaled sample value.
+     */
+    std::pair<Index, Float> sample_reuse(Float value, Mask active = true) const {
+        MTS_MASK_ARGUMENT(active);
+
+        return sample_reuse_impl(value, active);
+    }
+
+    /**
+     * \brief Implementation of \ref sample_reuse() for an arbitrary value
+     * type, which lets the batched queries of the distributions below process
+     * packets of samples in the scalar variants
+     */
+    template <typename Value>
+    std::pair<uint32_array_t<Value>, Value>
+    sample_reuse_impl(Value value, mask_t<Value> active) const {
+        using IndexV = uint32_array_t<Value>;
+
+        uint32_t size = (uint32_t) m_prob.size();
+        value *= (ScalarFloat) size;
+
+        IndexV index = min(IndexV(value), size - 1u);
+        Value u = min(value - Value(index), math::OneMinusEpsilon<Value>),
+              prob = gather<Value>(m_prob, index, active);
+
+        mask_t<Value> keep = u < prob;
+        IndexV alias = gather<IndexV>(m_alias, index, active && !keep);
+
+        return { select(keep, index, alias),
+                 select(keep, u / prob, (u - prob) / (1.f - prob)) };
+    }
+
+private:
+    FloatStorage m_prob;
+    IndexStorage m_alias;
+};
+
 /**
  * \brief Discrete 1D probability distribution
  *
@@ -45,6 +183,20 @@ public:
         : DiscreteDistribution(FloatStorage::copy(values, size)) {
     }
 
+    /**
+     * \brief Restore a distribution from the state computed by an earlier
+     * call to \ref update() (e.g. after loading it from a file)
+     */
+    DiscreteDistribution(FloatStorage &&pmf, FloatStorage &&cdf, ScalarFloat sum,
+                         ScalarFloat normalization, const ScalarVector2u &valid)
+        : m_pmf(std::move(pmf)), m_cdf(std::move(cdf)), m_sum(sum),
+          m_normalization(normalization), m_valid(valid) {
+        if (m_pmf.size() == 0 || m_pmf.size() != m_cdf.size())
+            Throw("DiscreteDistribution: invalid PMF/CDF tables!");
+        m_pmf.managed();
+        m_cdf.managed();
+    }
+
     /// Update the internal state. Must be invoked when changing the pmf.
     void update() {
         size_t size = m_pmf.size();
@@ -85,8 +237,26 @@ public:
 
         m_sum = ScalarFloat(sum);
         m_normalization = ScalarFloat(1.0 / sum);
+
+        if (has_alias_table())
+            build_alias_table();
     }
 
+    /**
+     * \brief Build an alias table (see \ref AliasTable), so that \ref sample()
+     * and its variants take constant time instead of searching the CDF
+     *
+     * The table is kept up to date by \ref update(). Note that the samples
+     * are then no longer mapped to the indices in a monotonic way.
+     */
+    void build_alias_table() {
+        m_pmf.managed();
+        m_alias = AliasTable<Float>(m_pmf.data(), m_pmf.size());
+    }
+
+    /// Was \ref build_alias_table() called?
+    bool has_alias_table() const { return !m_alias.empty(); }
+
     /// Return the unnormalized probability mass function
     FloatStorage &pmf() { return m_pmf; }
 
@@ -105,6 +275,9 @@ public:
     /// \brief Return the normalization factor (i.e. the inverse of \ref sum())
     ScalarFloat normalization() const { return m_normalization; }
 
+    /// \brief Return the first and last index with nonzero probability mass
+    const ScalarVector2u &valid() const { return m_valid; }
+
     /// Return the number of entries
     size_t size() const { return m_pmf.size(); }
 
@@ -144,6 +317,9 @@ public:
     Index sample(Float value, Mask active = true) const {
         MTS_MASK_ARGUMENT(active);
 
+        if (has_alias_table())
+            return m_alias.sample_reuse(value, active).first;
+
         value *= m_sum;
 
         return enoki::binary_search(
@@ -194,6 +370,9 @@ public:
     sample_reuse(Float value, Mask active = true) const {
         MTS_MASK_ARGUMENT(active);
 
+        if (has_alias_table())
+            return m_alias.sample_reuse(value, active);
+
         Index index = sample(value, active);
 
         Float pmf = eval_pmf_normalized(index, active),
@@ -223,6 +402,11 @@ public:
     sample_reuse_pmf(Float value, Mask active = true) const {
         MTS_MASK_ARGUMENT(active);
 
+        if (has_alias_table()) {
+            auto [index, reused] = m_alias.sample_reuse(value, active);
+            return { index, reused, eval_pmf_normalized(index, active) };
+        }
+
         auto [index, pdf] = sample_pmf(value, active);
 
         Float pmf = eval_pmf_normalized(index, active),
@@ -241,6 +425,7 @@ private:
     ScalarFloat m_sum = 0.f;
     ScalarFloat m_normalization = 0.f;
     ScalarVector2u m_valid;
+    AliasTable<Float> m_alias;
 };
 
 /**
@@ -342,8 +527,31 @@ public:
         m_normalization = ScalarFloat(1. / integral);
         m_interval_size = ScalarFloat(interval_size);
         m_inv_interval_size = ScalarFloat(1. / interval_size);
+
+        if (has_alias_table())
+            build_alias_table();
     }
 
+    /**
+     * \brief Build an alias table (see \ref AliasTable) over the intervals,
+     * so that \ref sample() and \ref sample_pdf() select them in constant
+     * time instead of searching the CDF
+     *
+     * The table is kept up to date by \ref update(). Note that the samples
+     * are then no longer mapped to the positions in a monotonic way.
+     */
+    void build_alias_table() {
+        m_cdf.managed();
+        const ScalarFloat *cdf = m_cdf.data();
+        std::vector<ScalarFloat> mass(m_cdf.size());
+        for (size_t i = 0; i < mass.size(); ++i)
+            mass[i] = cdf[i] - (i > 0 ? cdf[i - 1] : 0.f);
+        m_alias = AliasTable<Float>(mass.data(), mass.size());
+    }
+
+    /// Was \ref build_alias_table() called?
+    bool has_alias_table() const { return !m_alias.empty(); }
+
     /// Return the range of the distribution
     ScalarVector2f &range() { return m_range; }
 
@@ -378,18 +586,7 @@ public:
     Float eval_pdf(Float x, Mask active = true) const {
         MTS_MASK_ARGUMENT(active);
 
-        active &= x >= m_range.x() && x <= m_range.y();
-        x = (x - m_range.x()) * m_inv_interval_size;
-
-        Index index = clamp(Index(x), 0u, uint32_t(m_pdf.size() - 2));
-
-        Float y0 = gather<Float>(m_pdf, index,      active),
-              y1 = gather<Float>(m_pdf, index + 1u, active);
-
-        Float w1 = x - Float(index),
-              w0 = 1.f - w1;
-
-        return fmadd(w0, y0, w1 * y1);
+        return eval_pdf_impl(x, active);
     }
 
     /// Evaluate the normalized probability mass function (PDF) at position \c x
@@ -400,22 +597,10 @@ public:
     }
 
     /// Evaluate the unnormalized cumulative distribution function (CDF) at position \c p
-    Float eval_cdf(Float x_, Mask active = true) const {
+    Float eval_cdf(Float x, Mask active = true) const {
         MTS_MASK_ARGUMENT(active);
 
-        Float x = (x_ - m_range.x()) * m_inv_interval_size;
-
-        Index index = clamp(Index(x), 0u, uint32_t(m_pdf.size() - 2));
-
-        Float y0 = gather<Float>(m_pdf, index,      active),
-              y1 = gather<Float>(m_pdf, index + 1u, active),
-              c0 = gather<Float>(m_cdf, index - 1u, active && index > 0u);
-
-
-        Float t   = clamp(x - Float(index), 0.f, 1.f),
-              cdf = c0 + t * (y0 + .5f * t * (y1 - y0)) * m_interval_size;
-
-        return cdf;
+        return eval_cdf_impl(x, active);
     }
 
     /// Evaluate the unnormalized cumulative distribution function (CDF) at position \c p
@@ -438,26 +623,7 @@ public:
     Float sample(Float value, Mask active = true) const {
         MTS_MASK_ARGUMENT(active);
 
-        value *= m_integral;
-
-        Index index = enoki::binary_search(
-            m_valid.x(), m_valid.y(),
-            [&](Index index) ENOKI_INLINE_LAMBDA {
-                return gather<Float>(m_cdf, index, active) < value;
-            }
-        );
-
-        Float y0 = gather<Float>(m_pdf, index,      active),
-              y1 = gather<Float>(m_pdf, index + 1u, active),
-              c0 = gather<Float>(m_cdf, index - 1u, active && index > 0);
-
-        value = (value - c0) * m_inv_interval_size;
-
-        Float t_linear = (y0 - safe_sqrt(sqr(y0) + 2.f * value * (y1 - y0))) / (y0 - y1),
-              t_const  = value / y0,
-              t        = select(eq(y0, y1), t_const, t_linear);
-
-        return fmadd(Float(index) + t, m_interval_size, m_range.x());
+        return sample_pdf_impl(value, active).first;
     }
 
     /**
@@ -476,30 +642,178 @@ public:
     std::pair<Float, Float> sample_pdf(Float value, Mask active = true) const {
         MTS_MASK_ARGUMENT(active);
 
-        value *= m_integral;
+        return sample_pdf_impl(value, active);
+    }
 
-        Index index = enoki::binary_search(
-            m_valid.x(), m_valid.y(),
-            [&](Index index) ENOKI_INLINE_LAMBDA {
-                return gather<Float>(m_cdf, index, active) < value;
-            }
-        );
+    /**
+     * \brief Evaluate the unnormalized probability mass function (PDF) at
+     * the \c count positions \c x and write the results to \c out
+     *
+     * This is equivalent to calling \ref eval_pdf() for each position, but
+     * the queries are processed in SIMD packets (also in the scalar variants).
+     */
+    void eval_pdf_batch(const ScalarFloat *x, ScalarFloat *out, size_t count) const {
+        eval_batch(x, out, count, [&](const FloatP &xp, const MaskP &active) {
+            return eval_pdf_impl(xp, active);
+        });
+    }
+
+    /// Batched version of \ref eval_pdf_normalized() (see \ref eval_pdf_batch())
+    void eval_pdf_normalized_batch(const ScalarFloat *x, ScalarFloat *out,
+                                   size_t count) const {
+        eval_batch(x, out, count, [&](const FloatP &xp, const MaskP &active) {
+            return eval_pdf_impl(xp, active) * m_normalization;
+        });
+    }
+
+    /// Batched version of \ref eval_cdf() (see \ref eval_pdf_batch())
+    void eval_cdf_batch(const ScalarFloat *x, ScalarFloat *out, size_t count) const {
+        eval_batch(x, out, count, [&](const FloatP &xp, const MaskP &active) {
+            return eval_cdf_impl(xp, active);
+        });
+    }
+
+    /// Batched version of \ref eval_cdf_normalized() (see \ref eval_pdf_batch())
+    void eval_cdf_normalized_batch(const ScalarFloat *x, ScalarFloat *out,
+                                   size_t count) const {
+        eval_batch(x, out, count, [&](const FloatP &xp, const MaskP &active) {
+            return eval_cdf_impl(xp, active) * m_normalization;
+        });
+    }
+
+    /**
+     * \brief %Transform \c count uniformly distributed samples to the stored
+     * distribution
+     *
+     * This is equivalent to calling \ref sample_pdf() for each sample, but
+     * the queries are processed in SIMD packets (also in the scalar variants).
+     *
+     * \param value
+     *     Array containing \c count uniformly distributed samples on the
+     *     interval [0, 1].
+     *
+     * \param out
+     *     Array receiving the sampled positions.
+     *
+     * \param pdf
+     *     Optional array receiving the normalized probability densities of
+     *     the samples (may be \c nullptr).
+     */
+    void sample_batch(const ScalarFloat *value, ScalarFloat *out, size_t count,
+                      ScalarFloat *pdf = nullptr) const {
+        static_assert(!is_cuda_array_v<Float>,
+                      "Batched queries are not supported by the GPU variants!");
+
+        for_each_packet<FloatP>(count, [&](size_t i, const MaskP &active) {
+            FloatP vp = load_unaligned<FloatP>(value + i, active);
+            auto [pos_p, pdf_p] = sample_pdf_impl(vp, active);
+
+            store_unaligned(out + i, pos_p, active);
+            if (pdf)
+                store_unaligned(pdf + i, pdf_p, active);
+        });
+    }
+
+private:
+    using FloatP = Packet<ScalarFloat>;
+    using MaskP = mask_t<FloatP>;
+
+    /// Apply 'func' to packets of the queries stored in 'x'
+    template <typename Func>
+    void eval_batch(const ScalarFloat *x, ScalarFloat *out, size_t count,
+                    Func func) const {
+        static_assert(!is_cuda_array_v<Float>,
+                      "Batched queries are not supported by the GPU variants!");
+
+        for_each_packet<FloatP>(count, [&](size_t i, const MaskP &active) {
+            FloatP xp = load_unaligned<FloatP>(x + i, active);
+            store_unaligned(out + i, func(xp, active), active);
+        });
+    }
+
+    template <typename Value>
+    Value eval_pdf_impl(Value x, mask_t<Value> active) const {
+        using IndexV = uint32_array_t<Value>;
+
+        active &= x >= m_range.x() && x <= m_range.y();
+        x = (x - m_range.x()) * m_inv_interval_size;
 
-        Float y0 = gather<Float>(m_pdf, index,      active),
-              y1 = gather<Float>(m_pdf, index + 1u, active),
-              c0 = gather<Float>(m_cdf, index - 1u, active && index > 0);
+        IndexV index = clamp(IndexV(x), 0u, uint32_t(m_pdf.size() - 2));
 
-        value = (value - c0) * m_inv_interval_size;
+        Value y0 = gather<Value>(m_pdf, index,      active),
+              y1 = gather<Value>(m_pdf, index + 1u, active);
+
+        Value w1 = x - Value(index),
+              w0 = 1.f - w1;
+
+        return fmadd(w0, y0, w1 * y1);
+    }
+
+    template <typename Value>
+    Value eval_cdf_impl(Value x_, mask_t<Value> active) const {
+        using IndexV = uint32_array_t<Value>;
+
+        Value x = (x_ - m_range.x()) * m_inv_interval_size;
+
+        IndexV index = clamp(IndexV(x), 0u, uint32_t(m_pdf.size() - 2));
+
+        Value y0 = gather<Value>(m_pdf, index,      active),
+              y1 = gather<Value>(m_pdf, index + 1u, active),
+              c0 = gather<Value>(m_cdf, index - 1u, active && index > 0u);
+
+        Value t   = clamp(x - Value(index), 0.f, 1.f),
+              cdf = c0 + t * (y0 + .5f * t * (y1 - y0)) * m_interval_size;
+
+        return cdf;
+    }
 
-        Float t_linear = (y0 - safe_sqrt(sqr(y0) + 2.f * value * (y1 - y0))) / (y0 - y1),
+    template <typename Value>
+    std::pair<Value, Value> sample_pdf_impl(Value value, mask_t<Value> active) const {
+        auto [index, offset] = sample_interval(value, active);
+
+        Value y0 = gather<Value>(m_pdf, index,      active),
+              y1 = gather<Value>(m_pdf, index + 1u, active);
+
+        value = offset * m_inv_interval_size;
+
+        Value t_linear = (y0 - safe_sqrt(sqr(y0) + 2.f * value * (y1 - y0))) / (y0 - y1),
               t_const  = value / y0,
               t        = select(eq(y0, y1), t_const, t_linear);
 
-        return { fmadd(Float(index) + t, m_interval_size, m_range.x()),
+        return { fmadd(Value(index) + t, m_interval_size, m_range.x()),
                  fmadd(t, y1 - y0, y0) * m_normalization };
     }
 
-private:
+    /**
+     * Select the interval associated with the sample \c value and return
+     * its index along with the (unnormalized) probability mass that precedes
+     * the sample within the interval
+     */
+    template <typename Value>
+    std::pair<uint32_array_t<Value>, Value>
+    sample_interval(Value value, mask_t<Value> active) const {
+        using IndexV = uint32_array_t<Value>;
+
+        if (has_alias_table()) {
+            auto [index, reused] = m_alias.sample_reuse_impl(value, active);
+            Value c0 = gather<Value>(m_cdf, index - 1u, active && index > 0),
+                  c1 = gather<Value>(m_cdf, index, active);
+            return { index, reused * (c1 - c0) };
+        }
+
+        value *= m_integral;
+
+        IndexV index = enoki::binary_search(
+            m_valid.x(), m_valid.y(),
+            [&](IndexV index) ENOKI_INLINE_LAMBDA {
+                return gather<Value>(m_cdf, index, active) < value;
+            }
+        );
+
+        Value c0 = gather<Value>(m_cdf, index - 1u, active && index > 0);
+        return { index, value - c0 };
+    }
+
     FloatStorage m_pdf;
     FloatStorage m_cdf;
     ScalarFloat m_integral = 0.f;
@@ -508,6 +822,7 @@ private:
     ScalarFloat m_inv_interval_size = 0.f;
     ScalarVector2f m_range { 0.f, 0.f };
     ScalarVector2u m_valid;
+    AliasTable<Float> m_alias;
 };
 
 /**
@@ -619,8 +934,34 @@ public:
 
         m_integral = ScalarFloat(integral);
         m_normalization = ScalarFloat(1. / integral);
+
+        if (has_alias_table())
+            build_alias_table();
+    }
+
+    /**
+     * \brief Build an alias table (see \ref AliasTable) over the intervals,
+     * so that \ref sample() and \ref sample_pdf() select them in constant
+     * time instead of searching the CDF
+     *
+     * The table is kept up to date by \ref update(). Note that the samples
+     * are then no longer mapped to the positions in a monotonic way.
+     */
+    void build_alias_table() {
+        m_cdf.managed();
+        const ScalarFloat *cdf = m_cdf.data();
+        std::vector<ScalarFloat> mass(m_cdf.size());
+        for (size_t i = 0; i < mass.size(); ++i)
+            mass[i] = cdf[i] - (i > 0 ? cdf[i - 1] : 0.f);
+        m_alias = AliasTable<Float>(mass.data(), mass.size());
     }
 
+    /// Was \ref build_alias_table() called?
+    bool has_alias_table() const { return !m_alias.empty(); }
+
+    /// Return the range of the distribution (i.e. of its nodes)
+    const ScalarVector2f &range() const { return m_range; }
+
     /// Return the nodes of the underlying discretization
     FloatStorage &nodes() { return m_nodes; }
 
@@ -655,25 +996,7 @@ public:
     Float eval_pdf(Float x, Mask active = true) const {
         MTS_MASK_ARGUMENT(active);
 
-        active &= x >= m_range.x() && x <= m_range.y();
-
-        Index index = enoki::binary_search(
-            0, (uint32_t) m_nodes.size(),
-            [&](Index index) ENOKI_INLINE_LAMBDA {
-                return gather<Float>(m_nodes, index, active) < x;
-            }
-        );
-
-        index = enoki::max(enoki::min(index, (uint32_t) m_nodes.size() - 1u), 1u) - 1u;
-
-        Float x0 = gather<Float>(m_nodes, index,      active),
-              x1 = gather<Float>(m_nodes, index + 1u, active),
-              y0 = gather<Float>(m_pdf,   index,      active),
-              y1 = gather<Float>(m_pdf,   index + 1u, active);
-
-        x = (x - x0) / (x1 - x0);
-
-        return select(active, fmadd(x, y1 - y0, y0), 0.f);
+        return eval_pdf_impl(x, active);
     }
 
     /// Evaluate the normalized probability mass function (PDF) at position \c x
@@ -687,26 +1010,7 @@ public:
     Float eval_cdf(Float x, Mask active = true) const {
         MTS_MASK_ARGUMENT(active);
 
-        Index index = enoki::binary_search(
-            0, (uint32_t) m_nodes.size(),
-            [&](Index index) ENOKI_INLINE_LAMBDA {
-                return gather<Float>(m_nodes, index, active) < x;
-            }
-        );
-
-        index = enoki::max(enoki::min(index, (uint32_t) m_nodes.size() - 1u), 1u) - 1u;
-
-        Float x0 = gather<Float>(m_nodes, index,      active),
-              x1 = gather<Float>(m_nodes, index + 1u, active),
-              y0 = gather<Float>(m_pdf,   index,      active),
-              y1 = gather<Float>(m_pdf,   index + 1u, active),
-              c0 = gather<Float>(m_cdf,   index - 1u, active && index > 0u);
-
-        Float w   = x1 - x0,
-              t   = clamp((x - x0) / w, 0.f, 1.f),
-              cdf = c0 + w * t * (y0 + .5f * t * (y1 - y0));
-
-        return cdf;
+        return eval_cdf_impl(x, active);
     }
 
     /// Evaluate the unnormalized cumulative distribution function (CDF) at position \c p
@@ -729,29 +1033,7 @@ public:
     Float sample(Float value, Mask active = true) const {
         MTS_MASK_ARGUMENT(active);
 
-        value *= m_integral;
-
-        Index index = enoki::binary_search(
-            m_valid.x(), m_valid.y(),
-            [&](Index index) ENOKI_INLINE_LAMBDA {
-                return gather<Float>(m_cdf, index, active) < value;
-            }
-        );
-
-        Float x0 = gather<Float>(m_nodes, index,      active),
-              x1 = gather<Float>(m_nodes, index + 1u, active),
-              y0 = gather<Float>(m_pdf,   index,      active),
-              y1 = gather<Float>(m_pdf,   index + 1u, active),
-              c0 = gather<Float>(m_cdf,   index - 1u, active && index > 0),
-              w  = x1 - x0;
-
-        value = (value - c0) / w;
-
-        Float t_linear = (y0 - safe_sqrt(sqr(y0) + 2.f * value * (y1 - y0))) / (y0 - y1),
-              t_const  = value / y0,
-              t        = select(eq(y0, y1), t_const, t_linear);
-
-        return fmadd(t, w, x0);
+        return sample_pdf_impl(value, active).first;
     }
 
     /**
@@ -770,33 +1052,193 @@ public:
     std::pair<Float, Float> sample_pdf(Float value, Mask active = true) const {
         MTS_MASK_ARGUMENT(active);
 
-        value *= m_integral;
+        return sample_pdf_impl(value, active);
+    }
 
-        Index index = enoki::binary_search(
-            m_valid.x(), m_valid.y(),
-            [&](Index index) ENOKI_INLINE_LAMBDA {
-                return gather<Float>(m_cdf, index, active) < value;
+    /**
+     * \brief Evaluate the unnormalized probability mass function (PDF) at
+     * the \c count positions \c x and write the results to \c out
+     *
+     * This is equivalent to calling \ref eval_pdf() for each position, but
+     * the queries are processed in SIMD packets (also in the scalar variants).
+     */
+    void eval_pdf_batch(const ScalarFloat *x, ScalarFloat *out, size_t count) const {
+        eval_batch(x, out, count, [&](const FloatP &xp, const MaskP &active) {
+            return eval_pdf_impl(xp, active);
+        });
+    }
+
+    /// Batched version of \ref eval_pdf_normalized() (see \ref eval_pdf_batch())
+    void eval_pdf_normalized_batch(const ScalarFloat *x, ScalarFloat *out,
+                                   size_t count) const {
+        eval_batch(x, out, count, [&](const FloatP &xp, const MaskP &active) {
+            return eval_pdf_impl(xp, active) * m_normalization;
+        });
+    }
+
+    /// Batched version of \ref eval_cdf() (see \ref eval_pdf_batch())
+    void eval_cdf_batch(const ScalarFloat *x, ScalarFloat *out, size_t count) const {
+        eval_batch(x, out, count, [&](const FloatP &xp, const MaskP &active) {
+            return eval_cdf_impl(xp, active);
+        });
+    }
+
+    /// Batched version of \ref eval_cdf_normalized() (see \ref eval_pdf_batch())
+    void eval_cdf_normalized_batch(const ScalarFloat *x, ScalarFloat *out,
+                                   size_t count) const {
+        eval_batch(x, out, count, [&](const FloatP &xp, const MaskP &active) {
+            return eval_cdf_impl(xp, active) * m_normalization;
+        });
+    }
+
+    /**
+     * \brief %Transform \c count uniformly distributed samples to the stored
+     * distribution
+     *
+     * This is equivalent to calling \ref sample_pdf() for each sample, but
+     * the queries are processed in SIMD packets (also in the scalar variants).
+     *
+     * \param value
+     *     Array containing \c count uniformly distributed samples on the
+     *     interval [0, 1].
+     *
+     * \param out
+     *     Array receiving the sampled positions.
+     *
+     * \param pdf
+     *     Optional array receiving the normalized probability densities of
+     *     the samples (may be \c nullptr).
+     */
+    void sample_batch(const ScalarFloat *value, ScalarFloat *out, size_t count,
+                      ScalarFloat *pdf = nullptr) const {
+        static_assert(!is_cuda_array_v<Float>,
+                      "Batched queries are not supported by the GPU variants!");
+
+        for_each_packet<FloatP>(count, [&](size_t i, const MaskP &active) {
+            FloatP vp = load_unaligned<FloatP>(value + i, active);
+            auto [pos_p, pdf_p] = sample_pdf_impl(vp, active);
+
+            store_unaligned(out + i, pos_p, active);
+            if (pdf)
+                store_unaligned(pdf + i, pdf_p, active);
+        });
+    }
+
+private:
+    using FloatP = Packet<ScalarFloat>;
+    using MaskP = mask_t<FloatP>;
+
+    /// Apply 'func' to packets of the queries stored in 'x'
+    template <typename Func>
+    void eval_batch(const ScalarFloat *x, ScalarFloat *out, size_t count,
+                    Func func) const {
+        static_assert(!is_cuda_array_v<Float>,
+                      "Batched queries are not supported by the GPU variants!");
+
+        for_each_packet<FloatP>(count, [&](size_t i, const MaskP &active) {
+            FloatP xp = load_unaligned<FloatP>(x + i, active);
+            store_unaligned(out + i, func(xp, active), active);
+        });
+    }
+
+    /// Find the interval containing the position \c x
+    template <typename Value>
+    uint32_array_t<Value> find_interval(const Value &x, const mask_t<Value> &active) const {
+        using IndexV = uint32_array_t<Value>;
+
+        IndexV index = enoki::binary_search(
+            0, (uint32_t) m_nodes.size(),
+            [&](IndexV index) ENOKI_INLINE_LAMBDA {
+                return gather<Value>(m_nodes, index, active) < x;
             }
         );
 
-        Float x0 = gather<Float>(m_nodes, index,      active),
-              x1 = gather<Float>(m_nodes, index + 1u, active),
-              y0 = gather<Float>(m_pdf,   index,      active),
-              y1 = gather<Float>(m_pdf,   index + 1u, active),
-              c0 = gather<Float>(m_cdf,   index - 1u, active && index > 0),
+        return enoki::max(enoki::min(index, (uint32_t) m_nodes.size() - 1u), 1u) - 1u;
+    }
+
+    template <typename Value>
+    Value eval_pdf_impl(Value x, mask_t<Value> active) const {
+        active &= x >= m_range.x() && x <= m_range.y();
+
+        uint32_array_t<Value> index = find_interval(x, active);
+
+        Value x0 = gather<Value>(m_nodes, index,      active),
+              x1 = gather<Value>(m_nodes, index + 1u, active),
+              y0 = gather<Value>(m_pdf,   index,      active),
+              y1 = gather<Value>(m_pdf,   index + 1u, active);
+
+        x = (x - x0) / (x1 - x0);
+
+        return select(active, fmadd(x, y1 - y0, y0), 0.f);
+    }
+
+    template <typename Value>
+    Value eval_cdf_impl(Value x, mask_t<Value> active) const {
+        uint32_array_t<Value> index = find_interval(x, active);
+
+        Value x0 = gather<Value>(m_nodes, index,      active),
+              x1 = gather<Value>(m_nodes, index + 1u, active),
+              y0 = gather<Value>(m_pdf,   index,      active),
+              y1 = gather<Value>(m_pdf,   index + 1u, active),
+              c0 = gather<Value>(m_cdf,   index - 1u, active && index > 0u);
+
+        Value w   = x1 - x0,
+              t   = clamp((x - x0) / w, 0.f, 1.f),
+              cdf = c0 + w * t * (y0 + .5f * t * (y1 - y0));
+
+        return cdf;
+    }
+
+    template <typename Value>
+    std::pair<Value, Value> sample_pdf_impl(Value value, mask_t<Value> active) const {
+        auto [index, offset] = sample_interval(value, active);
+
+        Value x0 = gather<Value>(m_nodes, index,      active),
+              x1 = gather<Value>(m_nodes, index + 1u, active),
+              y0 = gather<Value>(m_pdf,   index,      active),
+              y1 = gather<Value>(m_pdf,   index + 1u, active),
               w  = x1 - x0;
 
-        value = (value - c0) / w;
+        value = offset / w;
 
-        Float t_linear = (y0 - safe_sqrt(sqr(y0) + 2.f * value * (y1 - y0))) / (y0 - y1),
+        Value t_linear = (y0 - safe_sqrt(sqr(y0) + 2.f * value * (y1 - y0))) / (y0 - y1),
               t_const  = value / y0,
               t        = select(eq(y0, y1), t_const, t_linear);
 
         return { fmadd(t, w, x0),
-            fmadd(t, y1 - y0, y0) * m_normalization };
+                 fmadd(t, y1 - y0, y0) * m_normalization };
+    }
+
+    /**
+     * Select the interval associated with the sample \c value and return
+     * its index along with the (unnormalized) probability mass that precedes
+     * the sample within the interval
+     */
+    template <typename Value>
+    std::pair<uint32_array_t<Value>, Value>
+    sample_interval(Value value, mask_t<Value> active) const {
+        using IndexV = uint32_array_t<Value>;
+
+        if (has_alias_table()) {
+            auto [index, reused] = m_alias.sample_reuse_impl(value, active);
+            Value c0 = gather<Value>(m_cdf, index - 1u, active && index > 0),
+                  c1 = gather<Value>(m_cdf, index, active);
+            return { index, reused * (c1 - c0) };
+        }
+
+        value *= m_integral;
+
+        IndexV index = enoki::binary_search(
+            m_valid.x(), m_valid.y(),
+            [&](IndexV index) ENOKI_INLINE_LAMBDA {
+                return gather<Value>(m_cdf, index, active) < value;
+            }
+        );
+
+        Value c0 = gather<Value>(m_cdf, index - 1u, active && index > 0);
+        return { index, value - c0 };
     }
 
-private:
     FloatStorage m_nodes;
     FloatStorage m_pdf;
     FloatStorage m_cdf;
@@ -804,6 +1246,7 @@ private:
     ScalarFloat m_normalization = 0.f;
     ScalarVector2f m_range { 0.f, 0.f };
     ScalarVector2u m_valid;
+    AliasTable<Float> m_alias;
 };
 
 template <typename Float>
@@ -1,7 +1,11 @@
 #pragma once
 
+#include <mitsuba/core/object.h>
 #include <mitsuba/core/warp.h>
 #include <mitsuba/core/util.h>
+#include <mitsuba/core/simd.h>
+#include <enoki/half.h>
+#include <tbb/parallel_for.h>
 
 NAMESPACE_BEGIN(mitsuba)
 
@@ -77,6 +81,8 @@ public:
     /**
      * Construct a marginal sample warping scheme for floating point
      * data of resolution \c size.
+     *
+     * The rows of large inputs are processed in parallel.
      */
     DiscreteDistribution2D(const ScalarFloat *data,
                            const ScalarVector2u &size)
@@ -90,16 +96,28 @@ public:
         ScalarFloat *cond_cdf = m_cond_cdf.data(),
                     *marg_cdf = m_marg_cdf.data();
 
-        // Construct conditional and marginal CDFs
+        // Construct the conditional CDFs (independently for each row)
+        std::unique_ptr<double[]> row_sum(new double[m_size.y()]);
+        uint32_t grain = std::max(1u, 65536u / std::max(1u, m_size.x()));
+        tbb::parallel_for(
+            tbb::blocked_range<uint32_t>(0, m_size.y(), grain),
+            [&](const tbb::blocked_range<uint32_t> &range) {
+                for (uint32_t y = range.begin(); y != range.end(); ++y) {
+                    double accum_cond = 0.0;
+                    uint32_t idx = m_size.x() * y;
+                    for (uint32_t x = 0; x < m_size.x(); ++x, ++idx) {
+                        accum_cond += (double) data[idx];
+                        cond_cdf[idx] = (ScalarFloat) accum_cond;
+                    }
+                    row_sum[y] = accum_cond;
+                }
+            }
+        );
+
+        // Construct the marginal CDF
         double accum_marg = 0.0;
         for (uint32_t y = 0; y < m_size.y(); ++y) {
-            double accum_cond = 0.0;
-            uint32_t idx = m_size.x() * y;
-            for (uint32_t x = 0; x < m_size.x(); ++x, ++idx) {
-                accum_cond += (double) data[idx];
-                cond_cdf[idx] = (ScalarFloat) accum_cond;
-            }
-            accum_marg += accum_cond;
+            accum_marg += row_sum[y];
             marg_cdf[y] = accum_marg;
         }
 
@@ -280,6 +298,30 @@ protected:
     }
 
 protected:
+    /// Number of rows of width \c width that are processed by one parallel task
+    static uint32_t row_grain(uint32_t width) {
+        return std::max(1u, 65536u / std::max(1u, width));
+    }
+
+    /**
+     * \brief Run <tt>func(slice)</tt> for every slice of the distribution
+     *
+     * The slices are independent and are processed in parallel. The
+     * construction of each slice may itself use nested parallel loops over
+     * its rows, which TBB balances with the outer loop. This keeps all cores
+     * busy both for a single large slice (e.g. an environment map) and for
+     * many small ones (e.g. a measured BSDF).
+     */
+    template <typename Func> void for_each_slice(Func &&func) const {
+        tbb::parallel_for(
+            tbb::blocked_range<uint32_t>(0, m_slices, 1),
+            [&](const tbb::blocked_range<uint32_t> &range) {
+                for (uint32_t slice = range.begin(); slice != range.end(); ++slice)
+                    func(slice);
+            }
+        );
+    }
+
 #if !defined(_MSC_VER)
     static constexpr size_t DimensionInt = Dimension;
 #else
@@ -345,7 +387,7 @@ public:
     ENOKI_USING_MEMBERS(Base,
         Dimension, DimensionInt, m_patch_size, m_inv_patch_size,
         m_param_strides, m_param_values, m_slices,
-        interpolate_weights
+        interpolate_weights, row_grain, for_each_slice
     )
 
     Hierarchical2D() = default;
@@ -389,7 +431,7 @@ public:
             m_levels.reserve(1);
             m_levels.emplace_back(size, m_slices);
 
-            for (uint32_t slice = 0; slice < m_slices; ++slice) {
+            for_each_slice([&](uint32_t slice) {
                 uint32_t offset = m_levels[0].size * slice;
 
                 ScalarFloat scale = 1.f;
@@ -401,7 +443,7 @@ public:
                 }
                 for (uint32_t i = 0; i < m_levels[0].size; ++i)
                     m_levels[0].data_ptr[offset + i] = data[offset + i] * scale;
-            }
+            });
 
             return;
         }
@@ -417,34 +459,56 @@ public:
             level_size = sr<1>(level_size);
         }
 
-        for (uint32_t slice = 0; slice < m_slices; ++slice) {
+        // Build the MIP hierarchies of the slices in parallel
+        for_each_slice([&](uint32_t slice) {
             uint32_t offset0 = m_levels[0].size * slice,
                      offset1 = m_levels[1].size * slice;
 
-            // Integrate linear interpolant
-            const ScalarFloat *in = data + offset0;
+            // Integrate linear interpolant (independently for each row)
+            std::unique_ptr<double[]> row_sum(new double[n_patches.y()]);
+            tbb::parallel_for(
+                tbb::blocked_range<uint32_t>(0, n_patches.y(), row_grain(n_patches.x())),
+                [&](const tbb::blocked_range<uint32_t> &range) {
+                    for (uint32_t y = range.begin(); y != range.end(); ++y) {
+                        const ScalarFloat *in = data + offset0 + y * size.x();
+                        double sum = 0.0;
+                        for (uint32_t x = 0; x < n_patches.x(); ++x) {
+                            ScalarFloat avg = (in[0] + in[1] + in[size.x()] +
+                                         in[size.x() + 1]) * .25f;
+                            sum += (double) avg;
+                            *(m_levels[1].ptr(ScalarVector2u(x, y)) + offset1) = avg;
+                            ++in;
+                        }
+                        row_sum[y] = sum;
+                    }
+                }
+            );
 
             double sum = 0.0;
-            for (uint32_t y = 0; y < n_patches.y(); ++y) {
-                for (uint32_t x = 0; x < n_patches.x(); ++x) {
-                    ScalarFloat avg = (in[0] + in[1] + in[size.x()] +
-                                 in[size.x() + 1]) * .25f;
-                    sum += (double) avg;
-                    *(m_levels[1].ptr(ScalarVector2u(x, y)) + offset1) = avg;
-                    ++in;
-                }
-                ++in;
-            }
+            for (uint32_t y = 0; y < n_patches.y(); ++y)
+                sum += row_sum[y];
 
             // Copy and normalize fine resolution interpolant
             ScalarFloat scale = normalize ? (ScalarFloat) (hprod(n_patches) / sum) : 1.f;
-            for (uint32_t i = 0; i < m_levels[0].size; ++i)
-                m_levels[0].data_ptr[offset0 + i] = data[offset0 + i] * scale;
-            for (uint32_t i = 0; i < m_levels[1].size; ++i)
-                m_levels[1].data_ptr[offset1 + i] *= scale;
+            tbb::parallel_for(
+                tbb::blocked_range<uint32_t>(0, m_levels[0].size, 65536u),
+                [&](const tbb::blocked_range<uint32_t> &range) {
+                    for (uint32_t i = range.begin(); i != range.end(); ++i)
+                        m_levels[0].data_ptr[offset0 + i] = data[offset0 + i] * scale;
+                }
+            );
+            if (scale != 1.f) {
+                tbb::parallel_for(
+                    tbb::blocked_range<uint32_t>(0, m_levels[1].size, 65536u),
+                    [&](const tbb::blocked_range<uint32_t> &range) {
+                        for (uint32_t i = range.begin(); i != range.end(); ++i)
+                            m_levels[1].data_ptr[offset1 + i] *= scale;
+                    }
+                );
+            }
 
-            // Build a MIP hierarchy
-            level_size = n_patches;
+            // Build a MIP hierarchy (each level depends on the previous one)
+            ScalarVector2u level_size = n_patches;
             for (uint32_t level = 2; level <= max_level + 1; ++level) {
                 const Level &l0 = m_levels[level - 1];
                 Level &l1 = m_levels[level];
@@ -452,16 +516,21 @@ public:
                 offset1 = l1.size * slice;
                 level_size = sr<1>(level_size + 1u);
 
-                // Downsample
-                for (uint32_t y = 0; y < level_size.y(); ++y) {
-                    for (uint32_t x = 0; x < level_size.x(); ++x) {
-                        ScalarFloat *d1 = l1.ptr(ScalarVector2u(x, y)) + offset1;
-                        const ScalarFloat *d0 = l0.ptr(ScalarVector2u(x*2, y*2)) + offset0;
-                        *d1 = d0[0] + d0[1] + d0[2] + d0[3];
+                // Downsample (the rows of large levels are processed in parallel)
+                tbb::parallel_for(
+                    tbb::blocked_range<uint32_t>(0, level_size.y(), row_grain(level_size.x())),
+                    [&](const tbb::blocked_range<uint32_t> &range) {
+                        for (uint32_t y = range.begin(); y != range.end(); ++y) {
+                            for (uint32_t x = 0; x < level_size.x(); ++x) {
+                                ScalarFloat *d1 = l1.ptr(ScalarVector2u(x, y)) + offset1;
+                                const ScalarFloat *d0 = l0.ptr(ScalarVector2u(x*2, y*2)) + offset0;
+                                *d1 = d0[0] + d0[1] + d0[2] + d0[3];
+                            }
+                        }
                     }
-                }
+                );
             }
-        }
+        });
     }
 
     /**
@@ -827,7 +896,8 @@ public:
 
     ENOKI_USING_MEMBERS(Base,
         Dimension, DimensionInt, m_patch_size, m_inv_patch_size,
-        m_param_strides, m_param_values, m_slices, interpolate_weights
+        m_param_strides, m_param_values, m_slices, interpolate_weights,
+        row_grain, for_each_slice
     )
 
     Marginal2D() = default;
@@ -848,13 +918,22 @@ public:
      * construct the cdf needed for sample warping, which saves memory in case
      * this functionality is not needed (e.g. if only the interpolation in
      * ``eval()`` is used).
+     *
+     * If \c half_precision is set to \c true, the values are stored as half
+     * precision floating point numbers, which halves the memory usage of the
+     * table at the cost of roughly three significant digits. This requires
+     * <tt>enable_sampling=false</tt>.
      */
     Marginal2D(const ScalarFloat *data,
                const ScalarVector2u &size,
                const std::array<uint32_t, Dimension> &param_res = { },
                const std::array<const ScalarFloat *, Dimension> &param_values = { },
-               bool normalize = true, bool enable_sampling = true)
-        : Base(size, param_res, param_values), m_size(size), m_normalized(normalize) {
+               bool normalize = true, bool enable_sampling = true,
+               bool half_precision = false)
+        : Base(size, param_res, param_values), m_size(size), m_normalized(normalize),
+          m_half(half_precision) {
+        if (half_precision && enable_sampling)
+            Throw("Marginal2D(): half precision storage requires enable_sampling=false!");
 
         uint32_t w      = m_size.x(),
                  h      = m_size.y(),
@@ -875,29 +954,35 @@ public:
             m_cond_cdf = empty<FloatStorage>(m_slices * n_cond);
             m_cond_cdf.managed();
 
-            ScalarFloat *marg_cdf = m_marg_cdf.data(),
-                        *cond_cdf = m_cond_cdf.data(),
-                        *data_out = m_data.data();
+            // The slices are processed in parallel, and the rows of each slice as well
+            for_each_slice([&](uint32_t slice) {
+                const ScalarFloat *data_in = data + (size_t) slice * n_data;
+                ScalarFloat *marg_cdf = m_marg_cdf.data() + (size_t) slice * n_marg,
+                            *cond_cdf = m_cond_cdf.data() + (size_t) slice * n_cond,
+                            *data_out = m_data.data() + (size_t) slice * n_data;
 
-            std::unique_ptr<double[]> cond_cdf_sum(new double[h]);
-
-            for (uint32_t slice = 0; slice < m_slices; ++slice) {
+                std::unique_ptr<double[]> cond_cdf_sum(new double[h]);
                 ScalarFloat norm = 1.f;
 
                 /* The marginal/probability distribution computation
                    differs for the Continuous=false/true cases */
                 if constexpr (Continuous) {
                     // Construct conditional CDF
-                    for (uint32_t y = 0; y < h; ++y) {
-                        double accum = 0.0;
-                        uint32_t i = y * w, j = y * (w - 1);
-                        for (uint32_t x = 0; x < w - 1; ++x, ++i, ++j) {
-                            accum += scale_x * ((double) data[i] +
-                                                (double) data[i + 1]);
-                            cond_cdf[j] = (ScalarFloat) accum;
+                    tbb::parallel_for(
+                        tbb::blocked_range<uint32_t>(0, h, row_grain(w)),
+                        [&](const tbb::blocked_range<uint32_t> &range) {
+                            for (uint32_t y = range.begin(); y != range.end(); ++y) {
+                                double accum = 0.0;
+                                uint32_t i = y * w, j = y * (w - 1);
+                                for (uint32_t x = 0; x < w - 1; ++x, ++i, ++j) {
+                                    accum += scale_x * ((double) data_in[i] +
+                                                        (double) data_in[i + 1]);
+                                    cond_cdf[j] = (ScalarFloat) accum;
+                                }
+                                cond_cdf_sum[y] = accum;
+                            }
                         }
-                        cond_cdf_sum[y] = accum;
-                    }
+                    );
 
                     // Construct marginal CDF
                     double accum = 0.0;
@@ -912,18 +997,23 @@ public:
                     double scale = scale_x * scale_y;
 
                     // Construct conditional CDF
-                    for (uint32_t y = 0; y < h - 1; ++y) {
-                        double accum = 0.0;
-                        uint32_t i = y * w, j = y * (w - 1);
-                        for (uint32_t x = 0; x < w - 1; ++x, ++i, ++j) {
-                            accum += scale * ((double) data[i] +
-                                              (double) data[i + 1] +
-                                              (double) data[i + w] +
-                                              (double) data[i + w + 1]);
-                            cond_cdf[j] = (ScalarFloat) accum;
+                    tbb::parallel_for(
+                        tbb::blocked_range<uint32_t>(0, h - 1, row_grain(w)),
+                        [&](const tbb::blocked_range<uint32_t> &range) {
+                            for (uint32_t y = range.begin(); y != range.end(); ++y) {
+                                double accum = 0.0;
+                                uint32_t i = y * w, j = y * (w - 1);
+                                for (uint32_t x = 0; x < w - 1; ++x, ++i, ++j) {
+                                    accum += scale * ((double) data_in[i] +
+                                                      (double) data_in[i + 1] +
+                                                      (double) data_in[i + w] +
+                                                      (double) data_in[i + w + 1]);
+                                    cond_cdf[j] = (ScalarFloat) accum;
+                                }
+                                cond_cdf_sum[y] = accum;
+                            }
                         }
-                        cond_cdf_sum[y] = accum;
-                    }
+                    );
 
                     // Construct marginal CDF
                     double accum = 0.0;
@@ -936,37 +1026,116 @@ public:
                         norm = ScalarFloat(1.0 / accum);
                 }
 
-                for (size_t i = 0; i < n_cond; ++i)
-                    *cond_cdf++ *= norm;
                 for (size_t i = 0; i < n_marg; ++i)
-                    *marg_cdf++ *= norm;
-                for (size_t i = 0; i < n_data; ++i)
-                    *data_out++ = *data++ * norm;
-            }
+                    marg_cdf[i] *= norm;
+
+                tbb::parallel_for(
+                    tbb::blocked_range<size_t>(0, n_data, 65536u),
+                    [&](const tbb::blocked_range<size_t> &range) {
+                        for (size_t i = range.begin(); i != range.end(); ++i) {
+                            if (i < n_cond)
+                                cond_cdf[i] *= norm;
+                            data_out[i] = data_in[i] * norm;
+                        }
+                    }
+                );
+            });
         } else {
-            ScalarFloat *data_out = m_data.data();
-
-            for (uint32_t slice = 0; slice < m_slices; ++slice) {
+            for_each_slice([&](uint32_t slice) {
+                const ScalarFloat *data_in = data + (size_t) slice * n_data;
+                ScalarFloat *data_out = m_data.data() + (size_t) slice * n_data;
                 ScalarFloat norm = 1.f;
 
                 if (normalize) {
-                    double sum = 0.0;
-                    for (uint32_t y = 0; y < h - 1; ++y) {
-                        size_t i = y * w;
-                        for (uint32_t x = 0; x < w - 1; ++x, ++i) {
-                            sum += (double) data[i] +
-                                   (double) data[i + 1] +
-                                   (double) data[i + w] +
-                                   (double) data[i + w + 1];
+                    // Sum the rows in parallel and combine them in a fixed order
+                    std::unique_ptr<double[]> row_sum(new double[h - 1]);
+                    tbb::parallel_for(
+                        tbb::blocked_range<uint32_t>(0, h - 1, row_grain(w)),
+                        [&](const tbb::blocked_range<uint32_t> &range) {
+                            for (uint32_t y = range.begin(); y != range.end(); ++y) {
+                                double sum = 0.0;
+                                size_t i = y * w;
+                                for (uint32_t x = 0; x < w - 1; ++x, ++i) {
+                                    sum += (double) data_in[i] +
+                                           (double) data_in[i + 1] +
+                                           (double) data_in[i + w] +
+                                           (double) data_in[i + w + 1];
+                                }
+                                row_sum[y] = sum;
+                            }
                         }
-                    }
+                    );
+
+                    double sum = 0.0;
+                    for (uint32_t y = 0; y < h - 1; ++y)
+                        sum += row_sum[y];
                     norm = ScalarFloat(1.0 / (scale_x * scale_y * sum));
                 }
 
-                for (uint32_t k = 0; k < n_data; ++k)
-                    *data_out++ = *data++ * norm;
+                tbb::parallel_for(
+                    tbb::blocked_range<size_t>(0, n_data, 65536u),
+                    [&](const tbb::blocked_range<size_t> &range) {
+                        for (size_t i = range.begin(); i != range.end(); ++i)
+                            data_out[i] = data_in[i] * norm;
+                    }
+                );
+            });
+
+            if (half_precision) {
+                // Store the values as pairs of half precision values
+                size_t count = (size_t) m_slices * n_data;
+                const ScalarFloat *values = m_data.data();
+                std::vector<uint32_t> words((count + 1) / 2, 0u);
+                tbb::parallel_for(
+                    tbb::blocked_range<size_t>(0, words.size(), 65536u),
+                    [&](const tbb::blocked_range<size_t> &range) {
+                        for (size_t k = range.begin(); k != range.end(); ++k) {
+                            for (size_t i = 2 * k; i < std::min(2 * k + 2, count); ++i)
+                                words[k] |= (uint32_t) enoki::half::float32_to_float16(
+                                                (float) values[i]) << (16 * (i % 2));
+                        }
+                    }
+                );
+                m_data_half = DynamicBuffer<UInt32>::copy(words.data(), words.size());
+                m_data = FloatStorage();
+            }
+        }
+    }
+
+    /**
+     * \brief Construct an interpolant for evaluation only, which refers to
+     * the values at \c data instead of copying them
+     *
+     * This is equivalent to <tt>normalize=false</tt> and
+     * <tt>enable_sampling=false</tt> in the above constructor, while avoiding
+     * a copy of potentially large tables that are e.g. memory-mapped from a
+     * \ref TensorFile. The \c owner object holds the storage of \c data and
+     * is kept alive as long as the interpolant refers to it.
+     *
+     * The values are only referenced in the scalar and packet variants when
+     * \c data is aligned for packet access, and they are copied otherwise
+     * (including the GPU variants, which require a copy on the device).
+     */
+    Marginal2D(const Object *owner,
+               const ScalarFloat *data,
+               const ScalarVector2u &size,
+               const std::array<uint32_t, Dimension> &param_res = { },
+               const std::array<const ScalarFloat *, Dimension> &param_values = { })
+        : Base(size, param_res, param_values), m_size(size), m_normalized(false) {
+        size_t count = (size_t) m_slices * hprod(m_size);
+
+        if constexpr (!is_dynamic_array_v<Float>) {
+            using Packet = typename FloatStorage::Packet;
+            if ((uintptr_t) data % alignof(Packet) == 0) {
+                m_data = FloatStorage::map((void *) data, count);
+                m_owner = owner;
+                return;
             }
+        } else {
+            ENOKI_MARK_USED(owner);
         }
+
+        m_data = FloatStorage::copy(data, count);
     }
 
     /**
@@ -1023,6 +1192,15 @@ public:
         if (Dimension != 0)
             index += slice_offset * size;
 
+        if (m_half) {
+            Float v00 = lookup_half(index, size, param_weight, active),
+                  v10 = lookup_half(index + 1, size, param_weight, active),
+                  v01 = lookup_half(index + m_size.x(), size, param_weight, active),
+                  v11 = lookup_half(index + m_size.x() + 1, size, param_weight, active);
+
+            return warp::square_to_bilinear_pdf(v00, v10, v01, v11, pos);
+        }
+
         Float v00 = lookup(m_data.data(), index,
                            size, param_weight, active),
               v10 = lookup(m_data.data() + 1, index,
@@ -1057,8 +1235,10 @@ public:
         }
         oss << "  storage = { " << m_slices << " slice" << (m_slices > 1 ? "s" : "")
             << ", ";
-        size_t size = m_slices * (hprod(m_size) * 2 + m_size.y());
-        oss << util::mem_string(size * sizeof(ScalarFloat)) << " }" << std::endl
+        size_t size = m_half ? (m_slices * hprod(m_size) + 1) / 2 * sizeof(uint32_t)
+                             : (m_data.size() + m_marg_cdf.size() + m_cond_cdf.size()) *
+                                   sizeof(ScalarFloat);
+        oss << util::mem_string(size) << (m_half ? ", half precision" : "") << " }" << std::endl
             << "]";
         return oss.str();
     }
@@ -1086,6 +1266,26 @@ protected:
         }
     }
 
+    /// Variant of \ref lookup() for values stored in half precision
+    template <size_t Dim = Dimension>
+    MTS_INLINE Float lookup_half(UInt32 i0, uint32_t size, const Float *param_weight,
+                                 Mask active) const {
+        if constexpr (Dim != 0) {
+            UInt32 i1 = i0 + m_param_strides[Dim - 1] * size;
+
+            Float w0 = param_weight[2 * Dim - 2],
+                  w1 = param_weight[2 * Dim - 1],
+                  v0 = lookup_half<Dim - 1>(i0, size, param_weight, active),
+                  v1 = lookup_half<Dim - 1>(i1, size, param_weight, active);
+
+            return fmadd(v0, w0, v1 * w1);
+        } else {
+            ENOKI_MARK_USED(param_weight);
+            ENOKI_MARK_USED(size);
+            return Float(decode_half(gather_uint16(m_data_half, i0, active)));
+        }
+    }
+
     MTS_INLINE
     std::pair<Point2f, Float> sample_discrete(Point2f sample,
                                               const Float *param,
@@ -1427,12 +1627,21 @@ protected:
     /// Density values
     FloatStorage m_data;
 
+    /// Density values stored as pairs of half precision values (see \ref m_half)
+    DynamicBuffer<UInt32> m_data_half;
+
     /// Marginal and conditional PDFs
     FloatStorage m_marg_cdf;
     FloatStorage m_cond_cdf;
 
     /// Are the probability values normalized?
     bool m_normalized;
+
+    /// Are the density values stored in \ref m_data_half instead of \ref m_data?
+    bool m_half = false;
+
+    /// Holds the storage of \ref m_data when it refers to external values
+    ref<const Object> m_owner;
 };
 
 //! @}
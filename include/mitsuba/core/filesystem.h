@@ -209,6 +209,13 @@ extern MTS_EXPORT_CORE bool exists(const path& p) noexcept;
  */
 extern MTS_EXPORT_CORE size_t file_size(const path& p);
 
+/** \brief Returns the time of the last modification of the file or
+ * directory at <tt>p</tt> as an opaque value (it increases with the time,
+ * but its unit depends on the platform). Attempting to query a path that
+ * does not exist is treated as an error.
+ */
+extern MTS_EXPORT_CORE uint64_t last_write_time(const path& p);
+
 /** \brief Checks whether two paths refer to the same file system object.
  * Both must refer to an existing file or directory.
  * Symlinks are followed to determine equivalence.
@@ -22,6 +22,7 @@ template <typename> class ref;
 
 class AnimatedTransform;
 class AnnotatedStream;
+class AsyncFileStream;
 class Appender;
 class ArgParser;
 class Bitmap;
@@ -31,6 +32,7 @@ class FileResolver;
 class FileStream;
 class Formatter;
 class Logger;
+class MemoryArena;
 class MemoryStream;
 class Mutex;
 class PluginManager;
@@ -42,6 +44,7 @@ class Struct;
 class StructConverter;
 class Thread;
 class ThreadLocalBase;
+class ThreadPool;
 class TraversalCallback;
 class ZStream;
 enum LogLevel : int;
@@ -62,6 +65,7 @@ template <typename Value, size_t Size>          struct Normal;
 template <typename Value, size_t Size>          struct Color;
 template <typename Value, size_t Size>          struct Spectrum;
 template <typename Point>                       struct Transform;
+template <typename Point>                       struct AffineTransform;
 template <typename Point, typename Spectrum>    struct Ray;
 template <typename Point, typename Spectrum>    struct RayDifferential;
 template <typename Point>                       struct BoundingBox;
@@ -193,6 +197,7 @@ template <typename Float_> struct CoreAliases {
     using Frame3f          = Frame<Float>;
     using Transform3f      = Transform<Point3f>;
     using Transform4f      = Transform<Point4f>;
+    using AffineTransform4f = AffineTransform<Point4f>;
 
     using Color1f          = Color<Float, 1>;
     using Color3f          = Color<Float, 3>;
@@ -274,6 +279,7 @@ template <typename Float_> struct CoreAliases {
     using prefix ## Frame3f              = typename prefix ## CoreAliases::Frame3f;                \
     using prefix ## Transform3f          = typename prefix ## CoreAliases::Transform3f;            \
     using prefix ## Transform4f          = typename prefix ## CoreAliases::Transform4f;            \
+    using prefix ## AffineTransform4f    = typename prefix ## CoreAliases::AffineTransform4f;      \
     using prefix ## Color1f              = typename prefix ## CoreAliases::Color1f;                \
     using prefix ## Color3f              = typename prefix ## CoreAliases::Color3f;
 
@@ -288,7 +294,7 @@ template <typename Float_> struct CoreAliases {
         mask = true;
 
 #define MTS_MASKED_FUNCTION(profiler_phase, mask)                                                  \
-    ScopedPhase scope_phase(profiler_phase);                                                       \
+    ScopedPhase scope_phase(profiler_phase, this);                                                 \
     (void) mask;                                                                                   \
     if constexpr (is_scalar_v<Float>)                                                              \
         mask = true;
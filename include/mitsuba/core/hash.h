@@ -1,6 +1,7 @@
 #pragma once
 
 #include <mitsuba/core/object.h>
+#include <cstring>
 #include <functional>
 #include <vector>
 #include <tuple>
@@ -12,6 +13,44 @@ inline size_t hash_combine(size_t hash1, size_t hash2) {
     return hash2 ^ (hash1 + 0x9e3779b9 + (hash2 << 6) + (hash2 >> 2));
 }
 
+/**
+ * \brief Compute a 64-bit hash of a block of memory
+ *
+ * Processes the data eight bytes at a time (MurmurHash64A), which is fast
+ * enough to fingerprint large geometry buffers. Not suitable for
+ * cryptographic purposes.
+ */
+inline uint64_t hash_buffer(const void *ptr, size_t size, uint64_t seed = 0) {
+    const uint64_t m = 0xc6a4a7935bd1e995ull;
+    const int r = 47;
+
+    uint64_t h = seed ^ (size * m);
+    const uint8_t *data = (const uint8_t *) ptr;
+
+    for (size_t i = 0; i + 8 <= size; i += 8) {
+        uint64_t k;
+        memcpy(&k, data + i, sizeof(uint64_t));
+        k *= m;
+        k ^= k >> r;
+        k *= m;
+        h ^= k;
+        h *= m;
+    }
+
+    size_t tail = size & 7;
+    if (tail > 0) {
+        uint64_t k = 0;
+        memcpy(&k, data + size - tail, tail);
+        h ^= k;
+        h *= m;
+    }
+
+    h ^= h >> r;
+    h *= m;
+    h ^= h >> r;
+    return h;
+}
+
 template <typename T, std::enable_if_t<!std::is_enum_v<T>, int> = 0> size_t hash(const T &t) {
     return std::hash<T>()(t);
 }
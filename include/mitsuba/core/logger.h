@@ -23,6 +23,10 @@ enum LogLevel : int {
  * convert it into a human-readable form. Following that, it sends this
  * information to every registered Appender.
  *
+ * In asynchronous mode (see \ref set_async()), the formatted messages are
+ * instead pushed into a bounded lock-free queue owned by the calling thread,
+ * and a background thread passes them on to the appenders.
+ *
  * \ingroup libcore
  */
 class MTS_EXPORT_CORE Logger : public Object {
@@ -95,6 +99,35 @@ public:
     /// Return one of the appenders
     const Appender *appender(size_t index) const;
 
+    /**
+     * \brief Enable or disable the asynchronous mode
+     *
+     * In asynchronous mode, logging threads never wait for each other or
+     * for the appenders: every thread pushes its messages into its own
+     * bounded single-producer queue, which a background thread drains in
+     * order to invoke the appenders. When the queue of a thread is full,
+     * messages below the \ref Warn level are dropped (see \ref
+     * dropped_count()), while warnings wait until there is space in the
+     * queue. Messages of different threads may be reordered, and progress
+     * messages are still dispatched synchronously.
+     *
+     * \param queue_size
+     *    Capacity (in messages) of the queue of every thread
+     */
+    void set_async(bool value, size_t queue_size = 1024);
+
+    /// Is the asynchronous mode enabled?
+    bool is_async() const;
+
+    /**
+     * \brief Wait until all messages logged so far have been passed to
+     * the appenders (asynchronous mode)
+     */
+    void flush();
+
+    /// Return the number of messages that were dropped in asynchronous mode
+    size_t dropped_count() const;
+
     /// Set the logger's formatter implementation
     void set_formatter(Formatter *formatter);
 
@@ -0,0 +1,164 @@
+#pragma once
+
+#include <mitsuba/mitsuba.h>
+#include <mitsuba/core/logger.h>
+#include <string>
+#include <type_traits>
+
+NAMESPACE_BEGIN(mitsuba)
+
+/// Subsystems whose memory usage is tracked by \ref MemoryAccounting
+enum class MemoryCategory : uint32_t {
+    Geometry = 0,    /* Vertex, face and attribute buffers of meshes */
+    KDTree,          /* kd-tree nodes and indices, including temporary build storage */
+    Textures,        /* Texel data of bitmap textures */
+    Volumes,         /* Voxel data of grid volumes */
+    Film,            /* Image blocks of films and rendering threads */
+    Emitters,        /* Environment maps and their sampling distributions */
+
+    MemoryCategoryCount
+};
+
+constexpr const char
+    *memory_category_id[int(MemoryCategory::MemoryCategoryCount)] = {
+        "Geometry",
+        "kd-tree",
+        "Textures",
+        "Volumes",
+        "Film",
+        "Emitters"
+    };
+
+static_assert(std::extent_v<decltype(memory_category_id)> ==
+                  int(MemoryCategory::MemoryCategoryCount),
+              "Memory categories and descriptions don't have matching length!");
+
+/**
+ * \brief Registry of the memory used by the different subsystems of Mitsuba
+ *
+ * The classes that own large buffers report their allocations to one of the
+ * counters of \ref MemoryCategory (typically through a \ref MemoryRecord
+ * member), which track the current and the peak number of bytes. This only
+ * covers the data itself: the memory of the allocator, of small objects and
+ * of external libraries (e.g. Embree or OptiX) is not included.
+ *
+ * All functions are thread-safe.
+ */
+class MTS_EXPORT_CORE MemoryAccounting {
+public:
+    /// Account for \c size additional bytes in the given category
+    static void add(MemoryCategory category, size_t size);
+
+    /// Account for the release of \c size bytes in the given category
+    static void remove(MemoryCategory category, size_t size);
+
+    /// Return the number of bytes that are currently in use in the given category
+    static size_t current(MemoryCategory category);
+
+    /// Return the largest number of bytes that were in use in the given category
+    static size_t peak(MemoryCategory category);
+
+    /// Reset the peak values of all categories to their current values
+    static void reset_peak();
+
+    /// Return a table with the current and peak usage of all categories
+    static std::string report();
+
+    /// Log the table returned by \ref report()
+    static void print_report(LogLevel level = Info);
+
+private:
+    MemoryAccounting() = delete;
+};
+
+/**
+ * \brief Helper that accounts for the memory of one object in a category of
+ * \ref MemoryAccounting
+ *
+ * The owner of the buffers calls \ref set() whenever their total size
+ * changes, and the destructor releases the accounted memory.
+ */
+class MTS_EXPORT_CORE MemoryRecord {
+public:
+    MemoryRecord(MemoryCategory category) : m_category(category) { }
+
+    /// Copies start out empty: their owner sets their size
+    MemoryRecord(const MemoryRecord &other) : m_category(other.m_category) { }
+
+    MemoryRecord &operator=(const MemoryRecord &) = delete;
+
+    ~MemoryRecord() { set(0); }
+
+    /// Set the number of bytes accounted by this record
+    void set(size_t size);
+
+    /// Return the number of bytes accounted by this record
+    size_t size() const { return m_size; }
+
+private:
+    MemoryCategory m_category;
+    size_t m_size = 0;
+};
+
+/// Statistics of the \ref DeviceMemoryPool
+struct DeviceMemoryStats {
+    /// Number of bytes held by the callers of \ref DeviceMemoryPool::malloc()
+    size_t used = 0;
+    /// Number of bytes of released blocks that are kept for reuse
+    size_t cached = 0;
+    /// Largest value of \c used + \c cached
+    size_t peak = 0;
+    /// Maximum number of cached bytes (see \ref DeviceMemoryPool::set_limit())
+    size_t limit = 0;
+    /// Number of allocations served from the cache
+    size_t hits = 0;
+    /// Number of allocations requested from the device
+    size_t misses = 0;
+};
+
+/**
+ * \brief Caching allocator for the device buffers of the GPU variants
+ *
+ * Building and updating the OptiX acceleration data structures needs large
+ * temporary and output buffers, which are requested again whenever the scene
+ * parameters change (e.g. in every iteration of an optimization). Requests
+ * are rounded up to size classes (four per power of two, at least 256
+ * bytes), and released blocks are kept in per-class free lists for later
+ * requests of the same class. This avoids
+ * the synchronization of the CUDA allocator and limits fragmentation.
+ *
+ * At most \ref limit() bytes are kept in the cache; blocks released beyond
+ * this are returned to the device. All functions are thread-safe. Without
+ * GPU support, \ref malloc() raises an exception.
+ */
+class MTS_EXPORT_CORE DeviceMemoryPool {
+public:
+    /// Allocate a device buffer of at least \c size bytes
+    static void *malloc(size_t size);
+
+    /// Release a buffer allocated by \ref malloc() (\c nullptr is ignored)
+    static void free(void *ptr);
+
+    /// Set the maximum number of cached bytes and release the excess
+    static void set_limit(size_t limit);
+
+    /// Return the maximum number of cached bytes (default: 1 GiB)
+    static size_t limit();
+
+    /// Return all cached blocks (and those cached by Enoki) to the device
+    static void trim();
+
+    /// Return the size class of a request of \c size bytes
+    static size_t size_class(size_t size);
+
+    /// Return the current statistics of the pool
+    static DeviceMemoryStats stats();
+
+    /// Reset the peak to the current usage and the hit and miss counters to zero
+    static void reset_stats();
+
+private:
+    DeviceMemoryPool() = delete;
+};
+
+NAMESPACE_END(mitsuba)
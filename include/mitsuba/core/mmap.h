@@ -13,11 +13,29 @@ NAMESPACE_BEGIN(mitsuba)
  */
 class MTS_EXPORT_CORE MemoryMappedFile : public Object {
 public:
+    /// Expected access pattern of a mapping, see \ref advise()
+    enum class Access {
+        /// No particular pattern: use the default read-ahead of the OS
+        Normal,
+        /// Sweep from start to end: read ahead aggressively
+        Sequential,
+        /// Random accesses: only load the pages that are touched
+        Random
+    };
+
     /// Create a new memory-mapped file of the specified size
     MemoryMappedFile(const fs::path &filename, size_t size);
 
-    /// Map the specified file into memory
-    MemoryMappedFile(const fs::path &filename, bool write = false);
+    /**
+     * \brief Map the specified file into memory
+     *
+     * \param populate
+     *     Load the complete file before returning (\c MAP_POPULATE), which
+     *     avoids taking page faults later on. Only use this when most of the
+     *     file will be accessed.
+     */
+    MemoryMappedFile(const fs::path &filename, bool write = false,
+                     bool populate = false);
 
     /// Return a pointer to the file contents in memory
     void *data();
@@ -42,6 +60,24 @@ public:
     /// Return whether the mapped memory region can be modified
     bool can_write() const;
 
+    /**
+     * \brief Inform the OS about the expected access pattern of the mapping
+     *
+     * This only tunes the read-ahead of page faults and never changes the
+     * contents of the mapping (Linux/OSX only).
+     */
+    void advise(Access access);
+
+    /**
+     * \brief Asynchronously load a range of the mapping into memory
+     *
+     * Starts reading the \c size bytes at \c offset (clamped to the size of
+     * the mapping) in the background and returns immediately, so that later
+     * accesses to this range don't stall on I/O. Loaders call this for the
+     * parts of a file that they will process next.
+     */
+    void prefetch(size_t offset = 0, size_t size = (size_t) -1);
+
     /// Return a string representation
     std::string to_string() const override;
 
@@ -55,6 +91,29 @@ public:
      */
     static ref<MemoryMappedFile> create_temporary(size_t size);
 
+    /**
+     * \brief Create an anonymous mapping that is not backed by any file
+     *
+     * The memory is zero-initialized and released when the mapping is
+     * closed. It cannot be resized, and \ref filename() returns an empty path.
+     *
+     * \param huge_pages
+     *     Request transparent huge pages (Linux only), which reduces the
+     *     number of page faults and TLB misses when sweeping over large
+     *     temporary buffers.
+     */
+    static ref<MemoryMappedFile> create_anonymous(size_t size, bool huge_pages = true);
+
+    /**
+     * \brief Map a file with copy-on-write semantics
+     *
+     * The mapped memory can be modified, but the changes remain private to
+     * the mapping and are never written back to the file. Pages that were not
+     * modified are backed by the file, which lets the OS evict them under
+     * memory pressure and read them again on demand.
+     */
+    static ref<MemoryMappedFile> map_copy_on_write(const fs::path &filename);
+
     MTS_DECLARE_CLASS()
 protected:
     /// Internal constructor
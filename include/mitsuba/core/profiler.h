@@ -3,11 +3,16 @@
 #pragma once
 
 #include <mitsuba/core/object.h>
+#include <chrono>
 
 #if !defined(MTS_PROFILE_HASH_SIZE)
 #  define MTS_PROFILE_HASH_SIZE 256
 #endif
 
+#if !defined(MTS_PROFILE_OBJECT_HASH_SIZE)
+#  define MTS_PROFILE_OBJECT_HASH_SIZE 4096
+#endif
+
 NAMESPACE_BEGIN(mitsuba)
 
 /**
@@ -21,6 +26,7 @@ enum class ProfilerPhase : int {
     LoadTexture,                /* Texture loading */
     InitKDTree,                 /* kd-tree construction */
     Render,                     /* Integrator::render() */
+    RenderBlock,                /* SamplingIntegrator::render_block() */
     SamplingIntegratorSample,   /* SamplingIntegrator::sample() */
     SampleEmitterRay,           /* Scene::sample_emitter_ray() */
     SampleEmitterDirection,     /* Scene::sample_emitter_direction() */
@@ -39,6 +45,7 @@ enum class ProfilerPhase : int {
     EndpointSampleDirection,    /* Endpoint::sample_direction() */
     TextureSample,              /* Texture::sample() */
     TextureEvaluate,            /* Texture::eval() and Texture::pdf() */
+    TileCacheLoad,              /* TileCache::tile() loading a tile from disk */
 
     ProfilerPhaseCount
 };
@@ -50,6 +57,7 @@ constexpr const char
         "Texture loading",
         "kd-tree construction",
         "Integrator::render()",
+        "SamplingIntegrator::render_block()",
         "SamplingIntegrator::sample()",
         "Scene::sample_emitter_ray()",
         "Scene::sample_emitter_direction()",
@@ -67,7 +75,8 @@ constexpr const char
         "Endpoint::sample_ray()",
         "Endpoint::sample_direction()",
         "Texture::sample()",
-        "Texture::eval()"
+        "Texture::eval()",
+        "TileCache::tile() (load)"
     };
 
 
@@ -78,7 +87,46 @@ static_assert(std::extent_v<decltype(profiler_phase_id)> ==
                   int(ProfilerPhase::ProfilerPhaseCount),
               "Profiler phases and descriptions don't have matching length!");
 
+/// Event counters that are reported along with the sampled profile
+enum class ProfilerCounter : int {
+    OccluderCacheQueries = 0,   /* Scene::ray_test() with an occluder cache entry */
+    OccluderCacheHits,          /* .. that were resolved by the cached primitive */
+    TileCacheQueries,           /* Texel lookups of textures backed by the tile cache */
+    TileCacheMisses,            /* .. that had to load their tile */
+
+    ProfilerCounterCount
+};
+
+constexpr const char
+    *profiler_counter_id[int(ProfilerCounter::ProfilerCounterCount)] = {
+        "Occluder cache queries",
+        "Occluder cache hits",
+        "Tile cache queries",
+        "Tile cache misses"
+    };
+
+/// Counter to which a counter is relative (-1: none), used to print ratios
+constexpr int
+    profiler_counter_base[int(ProfilerCounter::ProfilerCounterCount)] = {
+        -1,
+        int(ProfilerCounter::OccluderCacheQueries),
+        -1,
+        int(ProfilerCounter::TileCacheQueries)
+    };
+
+static_assert(std::extent_v<decltype(profiler_counter_id)> ==
+                  int(ProfilerCounter::ProfilerCounterCount),
+              "Profiler counters and descriptions don't have matching length!");
+
 #if defined(MTS_ENABLE_PROFILER)
+/**
+ * \brief Add \c value to a profiler counter
+ *
+ * This performs an atomic operation: code on hot paths should accumulate
+ * the counts locally and only report them once in a while.
+ */
+extern MTS_EXPORT_CORE void profiler_count(ProfilerCounter counter, uint64_t value);
+
 /* Inlining the access to a thread_local variable produces *awful* machine code
    with Clang on OSX. The combination of weak and noinline is needed to prevent
    the compiler from inlining it (just noinline does not seem to be enough). It
@@ -87,17 +135,53 @@ static_assert(std::extent_v<decltype(profiler_phase_id)> ==
 extern MTS_EXPORT_CORE uint64_t *profiler_flags()
     __attribute__((noinline, weak, const));
 
+/// Is the timeline of the profiler being recorded? (see \ref Profiler::set_timeline())
+extern MTS_EXPORT_CORE bool profiler_timeline;
+
+/// Record the beginning or the end of a phase in the timeline of the current thread
+extern MTS_EXPORT_CORE void profiler_timeline_record(ProfilerPhase phase, bool begin);
+
+/// Are the samples of the profiler attributed to objects? (see \ref Profiler::set_object_attribution())
+extern MTS_EXPORT_CORE bool profiler_object_attribution;
+
+/// Innermost object-specific phase of a thread
+struct ProfilerTag {
+    const Object *object = nullptr;
+    ProfilerPhase phase = ProfilerPhase::ProfilerPhaseCount;
+};
+
+/// Return the tag of the current thread (see \ref profiler_flags())
+extern MTS_EXPORT_CORE ProfilerTag *profiler_tag()
+    __attribute__((noinline, weak, const));
+
 struct ScopedPhase {
-    ScopedPhase(ProfilerPhase phase)
-        : m_target(profiler_flags()), m_flag(1ull << int(phase)) {
-        if ((*m_target & m_flag) == 0)
+    /**
+     * \brief Enter a phase, optionally on behalf of an object (e.g. a BSDF
+     * instance) to which the samples of the phase are attributed
+     */
+    ScopedPhase(ProfilerPhase phase, const Object *object = nullptr)
+        : m_target(profiler_flags()), m_flag(1ull << int(phase)), m_phase(phase) {
+        if ((*m_target & m_flag) == 0) {
             *m_target |= m_flag;
-        else
+            if (unlikely(profiler_timeline))
+                profiler_timeline_record(m_phase, true);
+        } else {
             m_flag = 0;
+        }
+
+        if (unlikely(profiler_object_attribution) && object) {
+            m_tag = profiler_tag();
+            m_prev_tag = *m_tag;
+            *m_tag = ProfilerTag{ object, phase };
+        }
     }
 
     ~ScopedPhase() {
         *m_target &= ~m_flag;
+        if (unlikely(profiler_timeline) && m_flag != 0)
+            profiler_timeline_record(m_phase, false);
+        if (m_tag)
+            *m_tag = m_prev_tag;
     }
 
     ScopedPhase(const ScopedPhase &) = delete;
@@ -106,6 +190,9 @@ struct ScopedPhase {
 private:
     uint64_t* m_target;
     uint64_t  m_flag;
+    ProfilerPhase m_phase;
+    ProfilerTag *m_tag = nullptr;
+    ProfilerTag m_prev_tag;
 };
 
 class MTS_EXPORT_CORE Profiler : public Object {
@@ -113,6 +200,86 @@ public:
     static void static_initialization();
     static void static_shutdown();
     static void print_report();
+
+    /**
+     * \brief Return the share of the samples of every phase, counting each
+     * sample for the innermost phase of its thread (as in the flat profile
+     * of \ref print_report()), sorted by decreasing share
+     */
+    static std::vector<std::pair<std::string, float>> flat_profile();
+
+    /**
+     * \brief Enable or disable the recording of a timeline
+     *
+     * In addition to the sampled profile, the profiler then records the
+     * beginning and the end of every phase on every thread, which reveals
+     * e.g. the load imbalance between the image blocks of a rendering. The
+     * phases are stored in a ring buffer per thread, which retains the most
+     * recent \c capacity phases: the fine-grained phases (ray intersections,
+     * BSDF evaluations, ..) of a long rendering quickly fill it up.
+     *
+     * Enabling the timeline discards the phases recorded so far, and
+     * should not be done while other threads are recording phases.
+     */
+    static void set_timeline(bool enable, size_t capacity = 1 << 20);
+
+    /// Is the timeline being recorded?
+    static bool timeline() { return profiler_timeline; }
+
+    /**
+     * \brief Write the recorded timeline to a file in the JSON trace event
+     * format, which can be opened with \c chrome://tracing or Perfetto
+     *
+     * This function should not be called while other threads are recording
+     * phases.
+     */
+    static void write_timeline(const fs::path &filename);
+
+    /**
+     * \brief Enable or disable the sampling of hardware performance counters
+     * (Linux only)
+     *
+     * Every time the profiler samples the phases of a thread, it also reads
+     * the CPU cycle, instruction, last-level cache miss and branch miss
+     * counters of the thread using \c perf_event_open(), and attributes the
+     * events since the previous sample to the current phases. \ref
+     * print_report() then shows the instructions per cycle and the miss
+     * rates of every phase, which e.g. tells apart memory-bound phases.
+     *
+     * Depending on \c /proc/sys/kernel/perf_event_paranoid, the counters may
+     * not be accessible to unprivileged users.
+     */
+    static void set_hardware_counters(bool enable);
+
+    /// Are the hardware performance counters being sampled?
+    static bool hardware_counters();
+
+    /**
+     * \brief Enable or disable the attribution of the samples to objects
+     *
+     * The phases entered with \ref MTS_MASKED_FUNCTION are then tagged with
+     * the plugin instance that runs them, which tells apart e.g. the
+     * evaluation cost of the individual BSDFs of a scene. The samples are
+     * attributed to the innermost tagged phase (a texture evaluated by a
+     * BSDF counts for the texture), and \ref print_report() lists the \c
+     * top_count objects with the most samples.
+     *
+     * Objects are identified by the name registered with \ref
+     * register_object() when they were created.
+     */
+    static void set_object_attribution(bool enable, size_t top_count = 20);
+
+    /// Are the samples attributed to objects?
+    static bool object_attribution() { return profiler_object_attribution; }
+
+    /**
+     * \brief Register the name of an object for the report of \ref
+     * set_object_attribution() (no-op when it is disabled)
+     *
+     * This is done by the plugin manager for all the objects it creates.
+     */
+    static void register_object(const Object *object);
+
     MTS_DECLARE_CLASS()
 private:
     Profiler() = delete;
@@ -121,14 +288,123 @@ private:
 #else
 
 /* Profiler not supported on this platform */
-struct ScopedPhase { ScopedPhase(ProfilerPhase) { } };
+inline void profiler_count(ProfilerCounter, uint64_t) { }
+struct ScopedPhase { ScopedPhase(ProfilerPhase, const Object * = nullptr) { } };
 class Profiler {
 public:
     static void static_initialization() { }
     static void static_shutdown() { }
     static void print_report() { }
+    static std::vector<std::pair<std::string, float>> flat_profile() { return { }; }
+    static void set_timeline(bool, size_t = 0) { }
+    static bool timeline() { return false; }
+    static void write_timeline(const fs::path &) { }
+    static void set_hardware_counters(bool) { }
+    static bool hardware_counters() { return false; }
+    static void set_object_attribution(bool, size_t = 0) { }
+    static bool object_attribution() { return false; }
+    static void register_object(const Object *) { }
 };
 
 #endif
 
+/// Steps of the scene loading that are timed by the \ref LoadProfiler
+enum class LoadEvent : int {
+    PluginLoad = 0,             /* Loading of a plugin library */
+    ParseXML,                   /* Parsing of a scene description */
+    Instantiate,                /* Construction of an object of the scene */
+    LoadGeometry,               /* Loading of a mesh from a file */
+    LoadTexture,                /* Loading of an image from a file */
+    BuildAccel,                 /* Construction of the acceleration data structure */
+
+    LoadEventCount
+};
+
+constexpr const char *load_event_id[int(LoadEvent::LoadEventCount)] = {
+    "Plugin loading",
+    "XML parsing",
+    "Object instantiation",
+    "Mesh loading",
+    "Texture loading",
+    "Acceleration build"
+};
+
+/// Is the scene loading being timed? (see \ref LoadProfiler::set_enabled())
+extern MTS_EXPORT_CORE bool load_profiler_enabled;
+
+/**
+ * \brief Wall-clock timer of the individual steps of the scene loading
+ *
+ * Unlike the sampling profiler, which only reports the aggregate share of e.g.
+ * \ref ProfilerPhase::LoadGeometry, this records one entry per plugin, scene
+ * description, object, mesh and texture, which tells which assets make a
+ * scene slow to load. The steps are timed on the thread that runs them, and
+ * the objects of a scene are instantiated in parallel: the durations are
+ * inclusive (the instantiation of a mesh contains its loading), and their sum
+ * can exceed the total loading time.
+ */
+class MTS_EXPORT_CORE LoadProfiler {
+public:
+    /// Enable or disable the timing of the scene loading (discards the recorded steps)
+    static void set_enabled(bool enable);
+
+    /// Is the scene loading being timed?
+    static bool enabled() { return load_profiler_enabled; }
+
+    /**
+     * \brief Record a step that took \c time seconds (thread-safe)
+     *
+     * \param name
+     *     Asset of the step (e.g. a file name or the ID of an object)
+     *
+     * \param detail
+     *     Additional description (e.g. the plugin type of an object)
+     */
+    static void record(LoadEvent event, const std::string &name,
+                       const std::string &detail, double time);
+
+    /**
+     * \brief Print the total time of every kind of step, followed by the \c
+     * top_count slowest steps, and discard the recorded steps
+     */
+    static void print_report(size_t top_count = 50);
+
+    /// Return the total time (in seconds) of the recorded steps of the given kind
+    static double total(LoadEvent event);
+
+private:
+    LoadProfiler() = delete;
+};
+
+/// Time a step of the scene loading (no-op unless the \ref LoadProfiler is enabled)
+struct ScopedLoadEvent {
+    ScopedLoadEvent(LoadEvent event, const std::string &name,
+                    const std::string &detail = "") {
+        if (unlikely(load_profiler_enabled)) {
+            m_active = true;
+            m_event = event;
+            m_name = name;
+            m_detail = detail;
+            m_start = std::chrono::steady_clock::now();
+        }
+    }
+
+    ~ScopedLoadEvent() {
+        if (m_active) {
+            std::chrono::duration<double> elapsed =
+                std::chrono::steady_clock::now() - m_start;
+            LoadProfiler::record(m_event, m_name, m_detail, elapsed.count());
+        }
+    }
+
+    ScopedLoadEvent(const ScopedLoadEvent &) = delete;
+    ScopedLoadEvent &operator=(const ScopedLoadEvent &) = delete;
+
+private:
+    bool m_active = false;
+    LoadEvent m_event = LoadEvent::LoadEventCount;
+    std::string m_name, m_detail;
+    std::chrono::steady_clock::time_point m_start;
+};
+
 NAMESPACE_END(mitsuba)
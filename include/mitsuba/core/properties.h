@@ -59,8 +59,15 @@ public:
     /// Construct an empty property container
     Properties();
 
-    /// Construct an empty property container with a specific plugin name
-    Properties(const std::string &plugin_name);
+    /**
+     * \brief Construct an empty property container with a specific plugin name
+     *
+     * When \c arena is specified, the entries are stored in this \ref
+     * MemoryArena, which must outlive the container. Copies of the container
+     * (including those made by the copy constructor below) always store
+     * their entries on the heap.
+     */
+    Properties(const std::string &plugin_name, MemoryArena *arena = nullptr);
 
     /// Copy constructor
     Properties(const Properties &props);
@@ -143,6 +150,13 @@ public:
      */
     void merge(const Properties &props);
 
+    /**
+     * \brief Return the names of the properties whose values differ from
+     * those in \c props, including the properties that only exist in one
+     * of the two records (does not mark any property as queried)
+     */
+    std::vector<std::string> differing_properties(const Properties &props) const;
+
     /// Equality comparison operator
     bool operator==(const Properties &props) const;
 
@@ -226,4 +226,57 @@ Float sobol_2(UInt index, UInt scramble = 0) {
     }
 }
 
+
+/// Reverse the bits of a 32 bit integer
+template <typename UInt> UInt reverse_bits_32(UInt x) {
+    x = (x << 16) | (x >> 16);
+    x = ((x & 0x00ff00ff) << 8) | ((x & 0xff00ff00) >> 8);
+    x = ((x & 0x0f0f0f0f) << 4) | ((x & 0xf0f0f0f0) >> 4);
+    x = ((x & 0x33333333) << 2) | ((x & 0xcccccccc) >> 2);
+    x = ((x & 0x55555555) << 1) | ((x & 0xaaaaaaaa) >> 1);
+    return x;
+}
+
+/**
+ * \brief Hash-based nested uniform (Owen) scrambling of a 32 bit fixed-point
+ * value in base 2
+ *
+ * Each bit of the result is flipped depending on the seed and on all bits
+ * that precede it (i.e. the more significant ones). Applied to the
+ * coordinates of a (t, m, s)-net, this preserves its stratification while
+ * randomizing it. Applied to sample indices, it shuffles them so that
+ * aligned power-of-two blocks of indices are mapped onto each other.
+ *
+ * Based on "Practical Hash-based Owen Scrambling" by Brent Burley, which
+ * uses the permutation of "Stratified Sampling for Stochastic Transparency"
+ * by Samuli Laine and Tero Karras.
+ */
+template <typename UInt> UInt nested_uniform_scramble_2(UInt x, UInt seed) {
+    x = reverse_bits_32(x);
+
+    // Laine-Karras permutation: each bit only depends on lower bits
+    x += seed;
+    x ^= x * 0x6c50b47cu;
+    x ^= x * 0xb82f1e52u;
+    x ^= x * 0xc7afe638u;
+    x ^= x * 0x8d22f6e6u;
+
+    return reverse_bits_32(x);
+}
+
+/**
+ * \brief Second dimension of the Sobol' sequence as a 32 bit fixed-point value
+ *
+ * This is the unscrambled counterpart of \ref sobol_2() (the first dimension
+ * is given by \ref reverse_bits_32()). It always processes all 32 bits of
+ * the index, which avoids data-dependent loops in vectorized code.
+ */
+template <typename UInt> UInt sobol_2_bits(UInt index) {
+    UInt result = 0;
+    uint32_t v = 1u << 31;
+    ENOKI_UNROLL for (uint32_t i = 0; i < 32; ++i, v ^= v >> 1)
+        result ^= (UInt(0u) - ((index >> i) & 1u)) & v;
+    return result;
+}
+
 NAMESPACE_END(mitsuba)
@@ -3,6 +3,7 @@
 #include <mitsuba/core/object.h>
 #include <mitsuba/core/math.h>
 #include <mitsuba/core/logger.h>
+#include <enoki/dynamic.h>
 
 NAMESPACE_BEGIN(mitsuba)
 
@@ -64,6 +65,41 @@ public:
         return gather<Float>(m_values.data(), index, active);
     }
 
+    /**
+     * \brief Importance sample the discretized filter
+     *
+     * Maps a uniform sample \c u to an offset from the center of the filter
+     * that is distributed proportionally to the magnitude of \ref
+     * eval_discretized(). Rendering with such offsets lets every sample
+     * contribute to a single pixel (see the \c filter_importance_sampling
+     * parameter of the integrators).
+     *
+     * \return The offset and the weight of the sample. The weight is 1 for
+     *    nonnegative filters, and is negative for offsets within the negative
+     *    lobes of the others (e.g. \c lanczos). In both cases, the expected
+     *    weight of the samples matches the integral of the filter, up to
+     *    normalization.
+     */
+    std::pair<Float, Float> sample(Float u, Mask active = true) const {
+        // Use the first half of the sample interval for negative offsets
+        Mask negative = u < .5f;
+        u = select(negative, 2.f * u, 2.f * u - 1.f);
+
+        UInt32 index = math::find_interval(
+            MTS_FILTER_RESOLUTION + 1,
+            [&](UInt32 i, Mask active_) {
+                return gather<Float>(m_sample_cdf, i, active && active_) <= u;
+            }
+        );
+
+        Float cdf_0 = gather<Float>(m_sample_cdf, index, active),
+              cdf_1 = gather<Float>(m_sample_cdf, index + 1u, active),
+              t = min((u - cdf_0) / (cdf_1 - cdf_0), math::OneMinusEpsilon<Float>);
+
+        Float x = (Float(index) + t) / m_scale_factor;
+        return { select(negative, -x, x), gather<Float>(m_sample_weight, index, active) };
+    }
+
     MTS_DECLARE_CLASS()
 protected:
     /// Create a new reconstruction filter
@@ -79,6 +115,11 @@ protected:
     ScalarFloat m_radius, m_scale_factor;
     std::vector<ScalarFloat> m_values;
     uint32_t m_border_size;
+
+    /// Tabulated distribution of the magnitude of the discretized filter (see \ref sample())
+    DynamicBuffer<Float> m_sample_cdf;
+    /// Sample weight associated with every interval of the discretized filter
+    DynamicBuffer<Float> m_sample_weight;
 };
 
 /**
@@ -277,6 +318,74 @@ template <typename Scalar_> struct Resampler {
     }
 
 
+    /**
+     * \brief Resample the rows <tt>[begin, end)</tt> of an array of
+     * contiguous rows with \c row_size values each
+     *
+     * This performs the vertical pass of a separable 2D resampling operation.
+     * Each target row is computed as a weighted sum of entire source rows
+     * using the weights of that row, which accesses memory contiguously
+     * (unlike a call to \ref resample() per column). Different ranges of
+     * rows can be processed in parallel.
+     */
+    void resample_rows(const Scalar *source, Scalar *target, size_t row_size,
+                       uint32_t begin, uint32_t end) const {
+        const uint32_t half_taps = m_taps / 2;
+        const Scalar min = std::get<0>(m_clamp);
+        const Scalar max = std::get<1>(m_clamp);
+        bool clamp = m_clamp != std::make_pair(-std::numeric_limits<Scalar>::infinity(),
+                                               std::numeric_limits<Scalar>::infinity());
+
+        for (uint32_t i = begin; i < end; ++i) {
+            const int32_t offset = m_start ? m_start[i] : ((int32_t) i - (int32_t) half_taps);
+            const Scalar *weights = m_weights.get() + (m_start ? (size_t) i * m_taps : 0);
+            Scalar *t = target + i * row_size;
+
+            for (size_t k = 0; k < row_size; ++k)
+                t[k] = Scalar(0);
+
+            for (uint32_t j = 0; j < m_taps; ++j) {
+                int32_t pos = offset + (int32_t) j;
+                const Scalar weight = weights[j];
+
+                if (unlikely(pos < 0 || pos >= (int32_t) m_source_res)) {
+                    switch (m_bc) {
+                        case FilterBoundaryCondition::Clamp:
+                            pos = enoki::clamp(pos, 0, (int32_t) m_source_res - 1);
+                            break;
+
+                        case FilterBoundaryCondition::Repeat:
+                            pos = math::modulo(pos, (int32_t) m_source_res);
+                            break;
+
+                        case FilterBoundaryCondition::Mirror:
+                            pos = math::modulo(pos, 2 * (int32_t) m_source_res - 2);
+                            if (pos >= (int32_t) m_source_res - 1)
+                                pos = 2 * m_source_res - 2 - pos;
+                            break;
+
+                        case FilterBoundaryCondition::One:
+                            for (size_t k = 0; k < row_size; ++k)
+                                t[k] += weight;
+                            continue;
+
+                        case FilterBoundaryCondition::Zero:
+                            continue;
+                    }
+                }
+
+                const Scalar *s = source + pos * row_size;
+                for (size_t k = 0; k < row_size; ++k)
+                    t[k] += s[k] * weight;
+            }
+
+            if (clamp) {
+                for (size_t k = 0; k < row_size; ++k)
+                    t[k] = enoki::template clamp<Scalar>(t[k], min, max);
+            }
+        }
+    }
+
     /// Return a human-readable summary
     std::string to_string() const {
         return tfm::format("Resampler[source_res=%i, target_res=%i]",
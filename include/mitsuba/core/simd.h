@@ -52,4 +52,50 @@ inline size_t round_to_packet_size(size_t size) {
     return (size + PacketSize - 1) / PacketSize * PacketSize;
 }
 
+/**
+ * \brief Process \c count scalar queries in packets of type \c Value
+ *
+ * Calls <tt>func(offset, active)</tt> for consecutive packets of queries,
+ * where \c offset is the index of the first query of the packet and \c
+ * active disables the lanes of the last packet that lie beyond \c count.
+ * This is the driver of the batched evaluation routines of the splines and
+ * distributions, which load and store their queries with masked unaligned
+ * memory operations.
+ */
+template <typename Value, typename Func>
+MTS_INLINE void for_each_packet(size_t count, Func &&func) {
+    constexpr size_t PacketSize = Value::Size;
+    using Scalar = scalar_t<Value>;
+
+    for (size_t offset = 0; offset < count; offset += PacketSize) {
+        size_t remaining = std::min(count - offset, PacketSize);
+        func(offset, arange<Value>() < Scalar(remaining));
+    }
+}
+
+/// Returns the 16-bit value with index \c index in a buffer of packed pairs
+template <typename Buffer, typename Index>
+MTS_INLINE auto gather_uint16(const Buffer &buf, const Index &index,
+                              mask_t<Index> active = true) {
+    using UInt32Array = replace_scalar_t<Index, uint32_t>;
+    UInt32Array word = gather<UInt32Array>(buf, index >> 1, active);
+    return select(eq(index & 1u, 0u), word & 0xFFFFu, word >> 16);
+}
+
+/// Convert half precision values (stored in the low 16 bits) to single precision
+template <typename UInt32Array>
+MTS_INLINE auto decode_half(const UInt32Array &h) {
+    using Value = replace_scalar_t<UInt32Array, float>;
+
+    // Shift the exponent and mantissa into place and rebias (also handles denormals)
+    UInt32Array magnitude = (h & 0x7FFFu) << 13,
+                bits = reinterpret_array<UInt32Array>(
+                    reinterpret_array<Value>(magnitude) * 0x1p112f);
+
+    // Infinity and NaN
+    bits = select(magnitude >= (0x7C00u << 13), magnitude | 0x7F800000u, bits);
+
+    return reinterpret_array<Value>(bits | ((h & 0x8000u) << 16));
+}
+
 NAMESPACE_END(mitsuba)
@@ -96,6 +96,24 @@ template <typename T> auto unpolarized(const T &spectrum) {
     }
 }
 
+/**
+ * Product of two spectra or Mueller matrices. When \c polarizing is \c false,
+ * both matrices are assumed to be depolarizers (e.g. because the scene does
+ * not contain any polarizing BSDF), and only their (1,1) entries are
+ * multiplied. For all non-polarized modes, this is a plain product.
+ */
+template <typename T> T mueller_product(const T &a, const T &b, bool polarizing) {
+    if constexpr (is_polarized_v<T>) {
+        if (!polarizing) {
+            T result = zero<T>();
+            result(0, 0) = a(0, 0) * b(0, 0);
+            return result;
+        }
+    }
+    ENOKI_MARK_USED(polarizing);
+    return a * b;
+}
+
 //! @}
 // =======================================================================
 
@@ -137,6 +155,16 @@ extern MTS_EXPORT_CORE const float *cie1931_x_data;
 extern MTS_EXPORT_CORE const float *cie1931_y_data;
 extern MTS_EXPORT_CORE const float *cie1931_z_data;
 
+/**
+ * \brief Interleaved copy of the CIE 1931 tables, which stores the X, Y, and
+ * Z values of each wavelength in a 16 byte-aligned group of 4 entries (the
+ * last one is zero)
+ *
+ * This lets \ref cie1931_xyz fetch the three color matching functions at a
+ * wavelength using a single (packet) load per interpolation node.
+ */
+extern MTS_EXPORT_CORE const float *cie1931_xyzw_data;
+
 /// Allocate GPU memory for the CIE 1931 tables
 extern MTS_EXPORT_CORE void cie_alloc();
 
@@ -160,19 +188,17 @@ Result cie1931_xyz(Float wavelength, mask_t<Float> active = true) {
     Int32 i0 = clamp(Int32(t), zero<Int32>(), Int32(MTS_CIE_SAMPLES - 2)),
           i1 = i0 + 1;
 
-    Float v0_x = (Float) gather<Float32>(cie1931_x_data, i0, active),
-          v1_x = (Float) gather<Float32>(cie1931_x_data, i1, active),
-          v0_y = (Float) gather<Float32>(cie1931_y_data, i0, active),
-          v1_y = (Float) gather<Float32>(cie1931_y_data, i1, active),
-          v0_z = (Float) gather<Float32>(cie1931_z_data, i0, active),
-          v1_z = (Float) gather<Float32>(cie1931_z_data, i1, active);
+    // Fetch X, Y, and Z of both nodes from the interleaved table
+    using Entry = Array<Float32, 4>;
+    Entry v0 = gather<Entry>(cie1931_xyzw_data, i0, active),
+          v1 = gather<Entry>(cie1931_xyzw_data, i1, active);
 
     Float w1 = t - Float(i0),
           w0 = (ScalarFloat) 1.f - w1;
 
-    return Result(fmadd(w0, v0_x, w1 * v1_x),
-                  fmadd(w0, v0_y, w1 * v1_y),
-                  fmadd(w0, v0_z, w1 * v1_z)) & mask_t<Result>(active);
+    return Result(fmadd(w0, Float(v0.x()), w1 * Float(v1.x())),
+                  fmadd(w0, Float(v0.y()), w1 * Float(v1.y())),
+                  fmadd(w0, Float(v0.z()), w1 * Float(v1.z()))) & mask_t<Result>(active);
 }
 
 /**
@@ -284,6 +310,22 @@ std::pair<Value, Value> sample_rgb_spectrum(const Value &sample) {
     }
 }
 
+/**
+ * \brief Sample wavelengths using \ref sample_rgb_spectrum() and evaluate the
+ * CIE 1931 XYZ color matching functions at them
+ *
+ * Returns a tuple with the sampled wavelengths and the XYZ weights of each
+ * sample, i.e. the color matching functions multiplied by the inverse PDF.
+ * The mean of their product with a spectrum evaluated at the sampled
+ * wavelengths is an unbiased estimate of its XYZ tristimulus values.
+ */
+template <typename Value>
+std::pair<Value, Color<Value, 3>> sample_rgb_spectrum_xyz(const Value &sample,
+                                                          mask_t<Value> active = true) {
+    auto [wavelengths, weight] = sample_rgb_spectrum(sample);
+    return { wavelengths, cie1931_xyz(wavelengths, active) * weight };
+}
+
 /**
  * PDF for the \ref sample_rgb_spectrum strategy.
  * It is valid to call this function for a single wavelength (Float), a set
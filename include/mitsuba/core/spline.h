@@ -3,6 +3,7 @@
 #include <mitsuba/core/fwd.h>
 #include <mitsuba/core/frame.h>
 #include <mitsuba/core/math.h>
+#include <mitsuba/core/simd.h>
 #include <mitsuba/core/vector.h>
 
 NAMESPACE_BEGIN(mitsuba)
@@ -1024,5 +1025,164 @@ Value eval_2d(const Float *nodes1, uint32_t size1, const Float *nodes2,
 // =======================================================================
 /*! @} */
 
+// =======================================================================
+//! @{ \name Batched evaluation of spline interpolants
+// =======================================================================
+
+/**
+ * \brief Evaluate a cubic spline interpolant of a \a uniformly sampled 1D
+ * function at \c count positions
+ *
+ * This is equivalent to calling \ref eval_1d() for every entry of \c x, but
+ * processes the queries in SIMD packets. See \ref eval_1d() for a
+ * description of the remaining parameters.
+ *
+ * \param x
+ *      Array containing \c count evaluation points
+ * \param out
+ *      Array receiving the \c count interpolated values
+ */
+template <bool Extrapolate = false, typename Float>
+void eval_1d_batch(Float min, Float max, const Float *values, uint32_t size,
+                   const Float *x, Float *out, size_t count) {
+    using FloatP = Packet<Float>;
+
+    for_each_packet<FloatP>(count, [&](size_t i, const mask_t<FloatP> &active) {
+        FloatP xp = load_unaligned<FloatP>(x + i, active);
+        store_unaligned(out + i, eval_1d<Extrapolate>(min, max, values, size, xp), active);
+    });
+}
+
+/**
+ * \brief Evaluate a cubic spline interpolant of a \a non-uniformly sampled
+ * 1D function at \c count positions
+ *
+ * This is equivalent to calling \ref eval_1d() for every entry of \c x, but
+ * processes the queries in SIMD packets. See \ref eval_1d() for a
+ * description of the remaining parameters.
+ *
+ * \param x
+ *      Array containing \c count evaluation points
+ * \param out
+ *      Array receiving the \c count interpolated values
+ */
+template <bool Extrapolate = false, typename Float>
+void eval_1d_batch(const Float *nodes, const Float *values, uint32_t size,
+                   const Float *x, Float *out, size_t count) {
+    using FloatP = Packet<Float>;
+
+    for_each_packet<FloatP>(count, [&](size_t i, const mask_t<FloatP> &active) {
+        FloatP xp = load_unaligned<FloatP>(x + i, active);
+        store_unaligned(out + i, eval_1d<Extrapolate>(nodes, values, size, xp), active);
+    });
+}
+
+/**
+ * \brief Importance sample \c count positions of a \a uniformly sampled 1D
+ * Catmull-Rom spline interpolant
+ *
+ * This is equivalent to calling \ref sample_1d() for every entry of \c
+ * sample, but processes the queries in SIMD packets. See \ref sample_1d()
+ * for a description of the remaining parameters.
+ *
+ * \param sample
+ *      Array containing \c count uniformly distributed random samples
+ * \param pos
+ *      Array receiving the sampled positions
+ * \param fval
+ *      Optional array receiving the value of the spline at the sampled
+ *      positions (may be \c nullptr)
+ * \param pdf
+ *      Optional array receiving the probability density at the sampled
+ *      positions (may be \c nullptr)
+ */
+template <typename Float>
+void sample_1d_batch(Float min, Float max, const Float *values, const Float *cdf,
+                     uint32_t size, const Float *sample, Float *pos, Float *fval,
+                     Float *pdf, size_t count, Float eps = 1e-6f) {
+    using FloatP = Packet<Float>;
+
+    for_each_packet<FloatP>(count, [&](size_t i, const mask_t<FloatP> &active) {
+        FloatP sp = load_unaligned<FloatP>(sample + i, active);
+        auto [pos_p, fval_p, pdf_p] = sample_1d(min, max, values, cdf, size, sp, eps);
+
+        store_unaligned(pos + i, pos_p, active);
+        if (fval)
+            store_unaligned(fval + i, fval_p, active);
+        if (pdf)
+            store_unaligned(pdf + i, pdf_p, active);
+    });
+}
+
+/**
+ * \brief Importance sample \c count positions of a \a non-uniformly sampled
+ * 1D Catmull-Rom spline interpolant
+ *
+ * This is equivalent to calling \ref sample_1d() for every entry of \c
+ * sample, but processes the queries in SIMD packets. See \ref sample_1d()
+ * for a description of the remaining parameters.
+ *
+ * \param sample
+ *      Array containing \c count uniformly distributed random samples
+ * \param pos
+ *      Array receiving the sampled positions
+ * \param fval
+ *      Optional array receiving the value of the spline at the sampled
+ *      positions (may be \c nullptr)
+ * \param pdf
+ *      Optional array receiving the probability density at the sampled
+ *      positions (may be \c nullptr)
+ */
+template <typename Float>
+void sample_1d_batch(const Float *nodes, const Float *values, const Float *cdf,
+                     uint32_t size, const Float *sample, Float *pos, Float *fval,
+                     Float *pdf, size_t count, Float eps = 1e-6f) {
+    using FloatP = Packet<Float>;
+
+    for_each_packet<FloatP>(count, [&](size_t i, const mask_t<FloatP> &active) {
+        FloatP sp = load_unaligned<FloatP>(sample + i, active);
+        auto [pos_p, fval_p, pdf_p] = sample_1d(nodes, values, cdf, size, sp, eps);
+
+        store_unaligned(pos + i, pos_p, active);
+        if (fval)
+            store_unaligned(fval + i, fval_p, active);
+        if (pdf)
+            store_unaligned(pdf + i, pdf_p, active);
+    });
+}
+
+/**
+ * \brief Evaluate a cubic spline interpolant of a uniformly sampled 2D
+ * function at \c count positions
+ *
+ * This is equivalent to calling \ref eval_2d() for every pair of entries of
+ * \c x and \c y, but processes the queries in SIMD packets. See \ref
+ * eval_2d() for a description of the remaining parameters.
+ *
+ * \param x
+ *      Array containing the \c X coordinates of \c count evaluation points
+ * \param y
+ *      Array containing the \c Y coordinates of \c count evaluation points
+ * \param out
+ *      Array receiving the \c count interpolated values
+ */
+template <bool Extrapolate = false, typename Float>
+void eval_2d_batch(const Float *nodes1, uint32_t size1, const Float *nodes2,
+                   uint32_t size2, const Float *values, const Float *x,
+                   const Float *y, Float *out, size_t count) {
+    using FloatP = Packet<Float>;
+
+    for_each_packet<FloatP>(count, [&](size_t i, const mask_t<FloatP> &active) {
+        FloatP xp = load_unaligned<FloatP>(x + i, active),
+               yp = load_unaligned<FloatP>(y + i, active);
+        store_unaligned(out + i,
+                        eval_2d<Extrapolate>(nodes1, size1, nodes2, size2, values, xp, yp),
+                        active);
+    });
+}
+
+// =======================================================================
+/*! @} */
+
 NAMESPACE_END(spline)
 NAMESPACE_END(mitsuba)
@@ -0,0 +1,201 @@
+#pragma once
+
+#include <mitsuba/mitsuba.h>
+#include <mitsuba/core/logger.h>
+#include <enoki/array.h>
+#include <string>
+#include <vector>
+
+#if !defined(MTS_STATS_HISTOGRAM_BINS)
+#  define MTS_STATS_HISTOGRAM_BINS 32
+#endif
+
+NAMESPACE_BEGIN(mitsuba)
+
+/// Event counters of the rendering statistics (see \ref Statistics)
+enum class StatsCounter : int {
+    Rays = 0,                   /* Scene::ray_intersect() and ray_intersect_preliminary() */
+    ShadowRays,                 /* Scene::ray_test() */
+    KDTreeNodes,                /* kd-tree nodes visited by the rays */
+    PrimitiveTests,             /* Ray-primitive intersection tests in kd-tree leaves */
+    NullCollisions,             /* Null collisions of the volumetric path tracers */
+    RRTerminations,             /* Paths terminated by Russian roulette */
+
+    StatsCounterCount
+};
+
+constexpr const char
+    *stats_counter_id[int(StatsCounter::StatsCounterCount)] = {
+        "Rays traced",
+        "Shadow rays traced",
+        "kd-tree nodes visited",
+        "Primitive intersection tests",
+        "Null collisions",
+        "Russian roulette terminations"
+    };
+
+static_assert(std::extent_v<decltype(stats_counter_id)> ==
+                  int(StatsCounter::StatsCounterCount),
+              "Statistics counters and descriptions don't have matching length!");
+
+/// Histograms of the rendering statistics (see \ref Statistics)
+enum class StatsHistogram : int {
+    PathLength = 0,             /* Scattering events of the paths when they end */
+
+    StatsHistogramCount
+};
+
+constexpr const char
+    *stats_histogram_id[int(StatsHistogram::StatsHistogramCount)] = {
+        "Path length"
+    };
+
+static_assert(std::extent_v<decltype(stats_histogram_id)> ==
+                  int(StatsHistogram::StatsHistogramCount),
+              "Statistics histograms and descriptions don't have matching length!");
+
+#if defined(MTS_ENABLE_STATISTICS)
+constexpr bool stats_enabled = true;
+#else
+constexpr bool stats_enabled = false;
+#endif
+
+/// Counters and histograms of one thread, which are summed by \ref Statistics
+struct StatsStorage {
+    uint64_t counters[int(StatsCounter::StatsCounterCount)] = { };
+    uint64_t histograms[int(StatsHistogram::StatsHistogramCount)]
+                       [MTS_STATS_HISTOGRAM_BINS] = { };
+};
+
+/**
+ * \brief Return the statistics storage of the current thread
+ *
+ * Only defined when Mitsuba is compiled with \c MTS_ENABLE_STATISTICS. See
+ * \ref profiler_flags() regarding the attributes.
+ */
+extern MTS_EXPORT_CORE StatsStorage *stats_storage()
+    __attribute__((noinline, weak, const));
+
+/// Add \c value to a statistics counter (compiled out when statistics are disabled)
+inline void stats_add(StatsCounter counter, uint64_t value) {
+    if constexpr (stats_enabled)
+        stats_storage()->counters[int(counter)] += value;
+    ENOKI_MARK_USED(counter);
+    ENOKI_MARK_USED(value);
+}
+
+/**
+ * \brief Add the number of active lanes of \c active to a statistics counter
+ *
+ * This is a no-op in GPU variants, where counting the lanes would require a
+ * horizontal reduction (and thereby a kernel launch).
+ */
+template <typename Mask>
+MTS_INLINE void stats_count(StatsCounter counter, const Mask &active) {
+    if constexpr (stats_enabled && !is_cuda_array_v<Mask>) {
+        if constexpr (is_array_v<Mask>)
+            stats_add(counter, (uint64_t) enoki::count(active));
+        else
+            stats_add(counter, active ? 1 : 0);
+    }
+    ENOKI_MARK_USED(counter);
+    ENOKI_MARK_USED(active);
+}
+
+/**
+ * \brief Add the entries of \c value for which \c active is set to a
+ * statistics histogram (no-op in GPU variants)
+ *
+ * Values beyond the last bin are accumulated in the last bin.
+ */
+template <typename UInt, typename Mask>
+MTS_INLINE void stats_histogram(StatsHistogram histogram, const UInt &value,
+                                const Mask &active) {
+    if constexpr (stats_enabled && !is_cuda_array_v<Mask>) {
+        uint64_t *bins = stats_storage()->histograms[int(histogram)];
+        auto bin = [](uint64_t v) {
+            return std::min(v, (uint64_t) MTS_STATS_HISTOGRAM_BINS - 1);
+        };
+        if constexpr (is_array_v<Mask>) {
+            for (size_t i = 0; i < array_size_v<Mask>; ++i) {
+                if (active.coeff(i))
+                    bins[bin((uint64_t) value.coeff(i))]++;
+            }
+        } else if (active) {
+            bins[bin((uint64_t) value)]++;
+        }
+    }
+    ENOKI_MARK_USED(histogram);
+    ENOKI_MARK_USED(value);
+    ENOKI_MARK_USED(active);
+}
+
+/**
+ * \brief Counter that is accumulated locally (e.g. in a traversal loop), and
+ * added to the statistics when it goes out of scope
+ */
+struct ScopedStatsCounter {
+    ScopedStatsCounter(StatsCounter counter) : m_counter(counter) { }
+    ~ScopedStatsCounter() {
+        if constexpr (stats_enabled)
+            stats_add(m_counter, m_value);
+    }
+
+    ScopedStatsCounter &operator+=(uint64_t value) {
+        if constexpr (stats_enabled)
+            m_value += value;
+        ENOKI_MARK_USED(value);
+        return *this;
+    }
+
+    ScopedStatsCounter &operator++() { return operator+=(1); }
+
+    ScopedStatsCounter(const ScopedStatsCounter &) = delete;
+    ScopedStatsCounter &operator=(const ScopedStatsCounter &) = delete;
+
+private:
+    StatsCounter m_counter;
+    uint64_t m_value = 0;
+};
+
+/**
+ * \brief Rendering statistics in the spirit of the \c StatsCounter of Mitsuba
+ * 0.6: the number of rays traced, kd-tree nodes visited, the path length
+ * histogram, etc.
+ *
+ * Every thread increments its own counters (\ref stats_add(), \ref
+ * stats_count() and \ref stats_histogram()), which are summed when they are
+ * queried. The statistics are only collected when Mitsuba is compiled with
+ * the CMake option \c MTS_ENABLE_STATISTICS: otherwise, the calls are
+ * compiled out and all values are zero. They are not collected in GPU
+ * variants.
+ */
+class MTS_EXPORT_CORE Statistics {
+public:
+    /// Were the statistics compiled in?
+    static bool enabled() { return stats_enabled; }
+
+    /// Return the value of a counter, summed over all threads
+    static uint64_t counter(StatsCounter counter);
+
+    /// Return the bins of a histogram, summed over all threads
+    static std::vector<uint64_t> histogram(StatsHistogram histogram);
+
+    /**
+     * \brief Reset all counters and histograms
+     *
+     * This should not be done while other threads are rendering.
+     */
+    static void reset();
+
+    /// Return a table with the counters and histograms
+    static std::string report();
+
+    /// Log the table returned by \ref report()
+    static void print_report(LogLevel level = Info);
+
+private:
+    Statistics() = delete;
+};
+
+NAMESPACE_END(mitsuba)
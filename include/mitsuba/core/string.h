@@ -98,5 +98,17 @@ extern MTS_EXPORT_CORE std::string trim(const std::string &s,
 /// Check if a list of keys contains a specific key
 extern MTS_EXPORT_CORE bool contains(const std::vector<std::string> &keys, const std::string &key);
 
+/**
+ * \brief Fast locale-independent replacement for \c std::strtof()
+ *
+ * Skips leading spaces and tabs, and parses a decimal floating point number
+ * with optional sign and exponent. Numbers with up to 19 significant digits
+ * and moderate exponents are converted using exact floating point operations;
+ * the remaining cases are converted using the classic "C" locale, and \c inf,
+ * \c infinity and \c nan are recognized regardless of case. As with \c
+ * std::strtof(), \c end is set to \c str when no number could be parsed.
+ */
+extern MTS_EXPORT_CORE float parse_float(const char *str, char **end);
+
 NAMESPACE_END(string)
 NAMESPACE_END(mitsuba)
@@ -131,7 +131,7 @@ public:
         bool operator==(const Field &f) const {
             return name == f.name && type == f.type && size == f.size &&
                    offset == f.offset && flags == f.flags &&
-                   default_ == f.default_;
+                   default_ == f.default_ && blend == f.blend;
         }
 
         /// Equality operator
@@ -11,6 +11,12 @@ NAMESPACE_BEGIN(mitsuba)
  *
  * This class provides convenient memory-mapped read-only access to tensor
  * data, usually exported from NumPy.
+ *
+ * The fields are not copied: \ref Field::data points into the mapped file,
+ * which is only paged in on access and remains valid as long as the
+ * TensorFile instance is alive. Consumers that store large fields, such as
+ * the evaluation-only constructor of \ref Marginal2D, can therefore refer to
+ * the mapped values directly and keep a reference to the TensorFile.
  */
 class MTS_EXPORT_CORE TensorFile : public MemoryMappedFile {
 public:
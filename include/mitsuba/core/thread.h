@@ -1,7 +1,10 @@
 #pragma once
 
 #include <mitsuba/core/object.h>
+#include <functional>
 #include <memory>
+#include <string>
+#include <vector>
 
 NAMESPACE_BEGIN(mitsuba)
 
@@ -63,6 +66,49 @@ public:
     /// Return the core affinity
     int core_affinity() const;
 
+    /**
+     * \brief Restrict the thread to the cores of a NUMA node
+     *
+     * Only supported on Linux, where the topology is read from
+     * <tt>/sys/devices/system/node</tt>. Returns \c true upon success.
+     */
+    bool set_numa_node(int node);
+
+    /// Return the NUMA node this thread is pinned to (or -1)
+    int numa_node() const;
+
+    /**
+     * \brief Return the NUMA node of the calling thread (or -1)
+     *
+     * Unlike <tt>Thread::thread()->numa_node()</tt>, this is a plain
+     * thread-local variable lookup and can be used in inner loops, e.g. to
+     * select node-local replicas of read-only data structures.
+     */
+    static int current_numa_node();
+
+    /// Return the number of NUMA nodes of the machine (1 if unknown)
+    static int numa_node_count();
+
+    /**
+     * \brief Distribute TBB worker threads over the NUMA nodes
+     *
+     * When enabled, worker threads joining the TBB scheduler are pinned to
+     * the NUMA nodes in a round-robin fashion. Must be called before the
+     * worker threads are created. Has no effect on single-node machines.
+     */
+    static void set_numa_pinning(bool value);
+
+    /// Are TBB worker threads pinned to NUMA nodes?
+    static bool numa_pinning();
+
+    /**
+     * \brief Run a function on a temporary thread pinned to a NUMA node
+     *
+     * Memory allocated and first written by \c func is then (under the
+     * default first-touch policy) placed on that node.
+     */
+    static void run_on_numa_node(int node, const std::function<void()> &func);
+
     /**
      * \brief Specify whether or not this thread is critical
      *
@@ -207,6 +253,74 @@ private:
 #endif
 };
 
+/**
+ * \brief Pool of worker threads with a bounded concurrency, optionally pinned
+ * to a set of logical cores
+ *
+ * By default, the parallel loops of Mitsuba run on the global TBB scheduler,
+ * whose size is the global thread count (\ref set_thread_count()). Work
+ * submitted through \ref execute() instead runs in a separate task arena
+ * that uses at most \ref thread_count() threads (including the calling
+ * thread), which makes it possible to run several jobs side by side without
+ * oversubscribing the machine, or to restrict a job to some of the cores.
+ *
+ * When a list of cores is given, each worker thread is pinned to one of them
+ * while it executes tasks of the pool, and its previous affinity is restored
+ * when it leaves the pool. Core pinning is only supported on Linux.
+ */
+class MTS_EXPORT_CORE ThreadPool : public Object {
+public:
+    /**
+     * \brief Create a thread pool
+     *
+     * \param thread_count
+     *    Maximum number of threads executing the tasks of the pool. Zero
+     *    selects the number of cores, or the global thread count when no
+     *    cores are given.
+     *
+     * \param cores
+     *    Logical cores that the worker threads are pinned to (in turn, if
+     *    there are more threads than cores). An empty list disables pinning.
+     */
+    ThreadPool(size_t thread_count = 0, const std::vector<int> &cores = {});
+
+    /// Return the maximum number of threads executing the tasks of the pool
+    size_t thread_count() const;
+
+    /// Return the logical cores that the worker threads are pinned to
+    const std::vector<int> &cores() const;
+
+    /**
+     * \brief Run a function inside the pool
+     *
+     * Parallel loops started by \c func are executed by the threads of the
+     * pool. The function returns when \c func has finished, and exceptions
+     * raised by \c func are propagated to the caller.
+     */
+    void execute(const std::function<void()> &func);
+
+    /// Return the pool executing the current thread's work (or \c nullptr)
+    static ThreadPool *current();
+
+    /**
+     * \brief Parse a comma-separated list of logical cores or core ranges,
+     * e.g. \c "0-7,16-23"
+     */
+    static std::vector<int> parse_cores(const std::string &str);
+
+    /// Return a human-readable representation
+    std::string to_string() const override;
+
+    MTS_DECLARE_CLASS()
+protected:
+    /// Protected destructor
+    virtual ~ThreadPool();
+
+private:
+    struct ThreadPoolPrivate;
+    std::unique_ptr<ThreadPoolPrivate> d;
+};
+
 extern MTS_EXPORT_CORE size_t __global_thread_count;
 
 NAMESPACE_END(mitsuba)
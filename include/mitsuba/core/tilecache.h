@@ -0,0 +1,174 @@
+#pragma once
+
+#include <mitsuba/core/object.h>
+#include <mitsuba/core/mmap.h>
+#include <mitsuba/core/vector.h>
+#include <atomic>
+#include <memory>
+#include <vector>
+
+NAMESPACE_BEGIN(mitsuba)
+
+/**
+ * \brief MIP-mapped image that is stored on disk in square tiles
+ *
+ * The \c .mtstex format holds all levels of a MIP map pyramid as tiles of
+ * <tt>tile_size x tile_size</tt> single precision pixels, so that a texture
+ * only needs to read the parts of the image that are actually accessed. The
+ * tiles are loaded through the global \ref TileCache. Tiles at the right and
+ * bottom boundaries of a level are padded by repeating the last column or
+ * row. All values are stored in the byte order of the machine that wrote the
+ * file.
+ */
+class MTS_EXPORT_CORE TiledImage : public Object {
+public:
+    using Vector2u = Vector<uint32_t, 2>;
+
+    /// Open the tiled image file \c filename
+    TiledImage(const fs::path &filename);
+
+    /**
+     * \brief Write a tiled image file
+     *
+     * \param filename
+     *     Name of the resulting file. The file is written under a temporary
+     *     name and renamed once complete, so that concurrent readers never
+     *     see a partial file.
+     *
+     * \param levels
+     *     Pointers to the pixels of each level, which must be stored as
+     *     interleaved single precision values
+     *
+     * \param sizes
+     *     Resolution of each level
+     *
+     * \param channel_count
+     *     Number of channels per pixel
+     *
+     * \param tile_size
+     *     Edge length of the tiles (in pixels)
+     *
+     * \param tag
+     *     Arbitrary value stored in the header, which lets the caller check
+     *     whether the file is up to date (see \ref tag())
+     */
+    static void write(const fs::path &filename,
+                      const std::vector<const float *> &levels,
+                      const std::vector<Vector2u> &sizes,
+                      uint32_t channel_count, uint32_t tile_size, uint64_t tag);
+
+    /// Return the number of MIP map levels
+    uint32_t level_count() const { return (uint32_t) m_levels.size(); }
+
+    /// Return the resolution of the given level
+    const Vector2u &level_size(uint32_t level) const { return m_levels[level].size; }
+
+    /// Return the number of channels per pixel
+    uint32_t channel_count() const { return m_channel_count; }
+
+    /// Return the edge length of the tiles
+    uint32_t tile_size() const { return m_tile_size; }
+
+    /// Return the size of a tile in bytes
+    size_t tile_bytes() const {
+        return (size_t) m_tile_size * m_tile_size * m_channel_count * sizeof(float);
+    }
+
+    /// Return the value passed to \ref write() when the file was created
+    uint64_t tag() const { return m_tag; }
+
+    /// Unique identifier of this image within the \ref TileCache
+    uint64_t id() const { return m_id; }
+
+    /// Return the index of the tile containing pixel <tt>(x, y)</tt> of a level
+    uint64_t tile_index(uint32_t level, uint32_t x, uint32_t y) const {
+        const Level &l = m_levels[level];
+        return l.first_tile + (y / m_tile_size) * l.tiles_x + x / m_tile_size;
+    }
+
+    /// Copy the pixels of the tile with index \c index into \c target
+    void read_tile(uint64_t index, float *target) const;
+
+    std::string to_string() const override;
+
+    MTS_DECLARE_CLASS()
+protected:
+    virtual ~TiledImage();
+
+private:
+    struct Level {
+        Vector2u size;
+        uint32_t tiles_x;
+        uint64_t first_tile;
+    };
+
+    ref<MemoryMappedFile> m_file;
+    const uint8_t *m_tile_data;
+    std::vector<Level> m_levels;
+    uint32_t m_channel_count;
+    uint32_t m_tile_size;
+    uint64_t m_tile_count;
+    uint64_t m_tag;
+    uint64_t m_id;
+};
+
+/**
+ * \brief Global cache for the tiles of \ref TiledImage instances
+ *
+ * The cache holds up to \ref capacity() bytes of tiles that are shared by
+ * all images and evicts the least recently used ones when it is full. It is
+ * split into independently locked shards, so that threads that access
+ * different tiles rarely wait for each other. Tiles are returned as shared
+ * pointers that stay valid when they are evicted while in use.
+ */
+class MTS_EXPORT_CORE TileCache : public Object {
+public:
+    /// Pixels of a tile (see \ref TiledImage)
+    using Tile = std::shared_ptr<const float[]>;
+
+    /// Return the global tile cache
+    static TileCache *instance() { return m_instance; }
+
+    /**
+     * \brief Return the tile containing pixel <tt>(x, y)</tt> of level \c
+     * level, loading it if necessary
+     *
+     * \param hit
+     *     Set to \c true if the tile was already loaded
+     */
+    Tile tile(const TiledImage *image, uint32_t level, uint32_t x, uint32_t y,
+              bool &hit);
+
+    /// Set the maximum amount of memory used by the tiles (in bytes)
+    void set_capacity(size_t capacity);
+
+    /// Return the maximum amount of memory used by the tiles (in bytes)
+    size_t capacity() const;
+
+    /// Return the amount of memory currently used by the tiles (in bytes)
+    size_t size() const;
+
+    /// Return the number of lookups that found a loaded tile
+    uint64_t hit_count() const;
+
+    /// Return the number of lookups that had to load a tile
+    uint64_t miss_count() const;
+
+    /// Remove the tiles of \c image, or all tiles when \c image is \c nullptr
+    void clear(const TiledImage *image = nullptr);
+
+    std::string to_string() const override;
+
+    MTS_DECLARE_CLASS()
+protected:
+    TileCache();
+    virtual ~TileCache();
+
+private:
+    struct Shard;
+    std::unique_ptr<Shard[]> m_shards;
+    std::atomic<size_t> m_capacity;
+    static ref<TileCache> m_instance;
+};
+
+NAMESPACE_END(mitsuba)
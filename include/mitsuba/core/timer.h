@@ -19,6 +19,12 @@ public:
         return (size_t) duration.count();
     }
 
+    /// Return the elapsed time in a custom unit (e.g. <tt>std::chrono::microseconds</tt>)
+    template <typename T> size_t value_in() const {
+        auto now = std::chrono::system_clock::now();
+        return (size_t) std::chrono::duration_cast<T>(now - start).count();
+    }
+
     size_t reset() {
         auto now = std::chrono::system_clock::now();
         auto duration = std::chrono::duration_cast<Unit>(now - start);
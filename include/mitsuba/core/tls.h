@@ -25,8 +25,12 @@ NAMESPACE_BEGIN(mitsuba)
  *
  * The implementation is designed to make the ``get()`` operation as fast as as
  * possible at the cost of more involved locking when creating or destroying
- * threads and TLS objects. To actually instantiate a TLS object with a
- * specific type, use the \ref ThreadLocal class.
+ * threads and TLS objects: every TLS object is assigned a dense key upon
+ * construction (keys of destroyed objects are recycled), which indexes an
+ * array of slots owned by each thread. Once the entry of a thread has been
+ * created, ``get()`` thus reduces to an array lookup that requires no
+ * locking. To actually instantiate a TLS object with a specific type, use the
+ * \ref ThreadLocal class.
  *
  * \sa ThreadLocal
  */
@@ -46,6 +50,10 @@ public:
     /// Destroy the thread local storage object
     ~ThreadLocalBase();
 
+    /// TLS objects are identified by their key and cannot be copied
+    ThreadLocalBase(const ThreadLocalBase &) = delete;
+    ThreadLocalBase &operator=(const ThreadLocalBase &) = delete;
+
     /**
      * \brief Release all current instances associated with this TLS
      *
@@ -74,9 +82,14 @@ protected:
     /// A thread has died -- destroy any remaining TLS entries associated with it
     static bool unregister_thread();
 
+private:
+    /// Create the entry of the current thread (slow path of \ref get())
+    void *create();
+
 private:
     ConstructFunctor m_construct_functor;
     DestructFunctor m_destruct_functor;
+    uint32_t m_key;
 };
 
 /**
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <mitsuba/core/ray.h>
+#include <mitsuba/core/string.h>
 #include <enoki/transform.h>
 
 NAMESPACE_BEGIN(mitsuba)
@@ -353,6 +354,247 @@ template <typename Point_> struct Transform {
     ENOKI_STRUCT(Transform, matrix, inverse_transpose)
 };
 
+/**
+ * \brief Compact affine transformation that stores a 3x4 matrix
+ *
+ * \ref Transform stores a full homogeneous matrix along with its inverse
+ * transpose. Affine transformations (e.g. the ones of shape instances) only
+ * need the linear part and the translation, which this class stores in half
+ * the memory. As the bottom row is implicit, points are also transformed
+ * without a perspective division.
+ *
+ * The kind of the linear part (rigid, rigid with a uniform scale, or general)
+ * is determined on construction. The inverse is not stored: \ref inverse()
+ * computes it when needed, which only involves a transposition for rigid and
+ * uniformly scaled transformations. The same holds for the transformation of
+ * normals, which needs the inverse of the linear part in the general case
+ * only. The classification is only performed for scalar transformations,
+ * vectorized ones are always treated as general.
+ */
+template <typename Point_> struct AffineTransform {
+
+    // =============================================================
+    //! @{ \name Type declarations
+    // =============================================================
+
+    static constexpr size_t Size = Point_::Size;
+
+    using Float  = value_t<Point_>;
+    using Linear = enoki::Matrix<Float, Size - 1>;
+    using Offset = Vector<Float, Size - 1>;
+    using Mask   = mask_t<Float>;
+    using Scalar = scalar_t<Float>;
+
+    /// Classification of the linear part, from the most to the least constrained
+    enum class Kind : uint32_t {
+        /// Orthonormal linear part (rotations and reflections)
+        Rigid = 0,
+
+        /// Orthonormal linear part multiplied by a uniform scale factor
+        UniformScale = 1,
+
+        /// Arbitrary linear part
+        General = 2
+    };
+
+    //! @}
+    // =============================================================
+
+    // =============================================================
+    //! @{ \name Fields
+    // =============================================================
+
+    Linear linear      = identity<Linear>();
+    Offset translation = zero<Offset>();
+
+    /// Uniform scale factor of the linear part (equal to 1 unless <tt>kind == UniformScale</tt>)
+    Float scale = 1.f;
+
+    Kind kind = Kind::Rigid;
+
+    //! @}
+    // =============================================================
+
+    // =============================================================
+    //! @{ \name Constructors, methods, etc.
+    // =============================================================
+
+    /// Initialize with the identity transformation
+    AffineTransform() = default;
+
+    /// Initialize from a linear part and a translation
+    AffineTransform(const Linear &linear, const Offset &translation)
+        : linear(linear), translation(translation) {
+        classify();
+    }
+
+    /// Initialize from the upper 3x4 part of an affine homogeneous transformation
+    explicit AffineTransform(const Transform<Point_> &trafo)
+        : translation(trafo.translation()) {
+        for (size_t i = 0; i < Size - 1; ++i)
+            linear.coeff(i) = head<Size - 1>(trafo.matrix.coeff(i));
+        classify();
+    }
+
+    /// Convert to a homogeneous transformation (along with its inverse transpose)
+    Transform<Point_> to_transform() const {
+        using Matrix = typename Transform<Point_>::Matrix;
+
+        AffineTransform inv = inverse();
+        Matrix matrix = identity<Matrix>(), inv_matrix = identity<Matrix>();
+        for (size_t i = 0; i < Size - 1; ++i) {
+            matrix.coeff(i) = concat(linear.coeff(i), Scalar(0));
+            inv_matrix.coeff(i) = concat(inv.linear.coeff(i), Scalar(0));
+        }
+        matrix.coeff(Size - 1) = concat(translation, Scalar(1));
+        inv_matrix.coeff(Size - 1) = concat(inv.translation, Scalar(1));
+
+        return Transform<Point_>(matrix, transpose(inv_matrix));
+    }
+
+    /// Concatenate transformations
+    AffineTransform operator*(const AffineTransform &other) const {
+        AffineTransform result;
+        result.linear = linear * other.linear;
+        result.translation = linear * other.translation + translation;
+        result.kind = std::max(kind, other.kind);
+        result.scale = result.kind == Kind::General ? Float(1.f) : scale * other.scale;
+        return result;
+    }
+
+    /**
+     * \brief Compute the inverse of this transformation
+     *
+     * This only involves a transposition for rigid and uniformly scaled
+     * transformations, and a 3x3 matrix inversion otherwise.
+     */
+    AffineTransform inverse() const {
+        AffineTransform result;
+        if (kind == Kind::General)
+            result.linear = enoki::inverse(linear);
+        else if (kind == Kind::UniformScale)
+            result.linear = transpose(linear) * rcp(sqr(scale));
+        else
+            result.linear = transpose(linear);
+        result.translation = -(result.linear * translation);
+        result.kind = kind;
+        result.scale = kind == Kind::UniformScale ? rcp(scale) : Float(1.f);
+        return result;
+    }
+
+    /// Does the linear part contain a scale component?
+    bool has_scale() const { return kind != Kind::Rigid; }
+
+    /// Equality comparison operator
+    bool operator==(const AffineTransform &t) const {
+        return linear == t.linear && translation == t.translation;
+    }
+
+    /// Inequality comparison operator
+    bool operator!=(const AffineTransform &t) const {
+        return linear != t.linear || translation != t.translation;
+    }
+
+    /// Transform a 3D point
+    template <typename T, typename Expr = expr_t<Float, T>>
+    MTS_INLINE Point<Expr, Size - 1> operator*(const Point<T, Size - 1> &arg) const {
+        Array<Expr, Size - 1> result = translation;
+
+        ENOKI_UNROLL for (size_t i = 0; i < Size - 1; ++i)
+            result = fmadd(linear.coeff(i), arg.coeff(i), result);
+
+        return result;
+    }
+
+    /// Transform a 3D vector
+    template <typename T, typename Expr = expr_t<Float, T>>
+    MTS_INLINE Vector<Expr, Size - 1> operator*(const Vector<T, Size - 1> &arg) const {
+        Array<Expr, Size - 1> result = linear.coeff(0);
+        result *= arg.x();
+
+        ENOKI_UNROLL for (size_t i = 1; i < Size - 1; ++i)
+            result = fmadd(linear.coeff(i), arg.coeff(i), result);
+
+        return result;
+    }
+
+    /**
+     * \brief Transform a 3D normal vector
+     *
+     * This uses the linear part itself (up to a scale factor) unless the
+     * transformation is general, in which case its inverse transpose is
+     * computed on the fly.
+     */
+    template <typename T, typename Expr = expr_t<Float, T>>
+    MTS_INLINE Normal<Expr, Size - 1> operator*(const Normal<T, Size - 1> &arg) const {
+        Linear inv_t;
+        const Linear *m = &linear;
+        if (unlikely(kind == Kind::General)) {
+            inv_t = inverse_transpose(linear);
+            m = &inv_t;
+        }
+
+        Array<Expr, Size - 1> result = m->coeff(0);
+        result *= arg.x();
+
+        ENOKI_UNROLL for (size_t i = 1; i < Size - 1; ++i)
+            result = fmadd(m->coeff(i), arg.coeff(i), result);
+
+        if (kind == Kind::UniformScale)
+            result *= rcp(sqr(scale));
+
+        return result;
+    }
+
+    /// Transform a ray
+    template <typename T, typename Spectrum, typename Expr = expr_t<Float, T>,
+              typename Result = Ray<Point<Expr, Size - 1>, Spectrum>>
+    MTS_INLINE Result operator*(const Ray<Point<T, Size - 1>, Spectrum> &ray) const {
+        return Result(operator*(ray.o), operator*(ray.d), ray.mint,
+                      ray.maxt, ray.time, ray.wavelengths);
+    }
+
+    /**
+     * \brief Transform a 3D vector/point/normal/ray (for interface
+     * compatibility with \ref Transform, as all transformations are affine)
+     */
+    template <typename T>
+    MTS_INLINE auto transform_affine(const T &input) const {
+        return operator*(input);
+    }
+
+    //! @}
+    // =============================================================
+
+private:
+    /// Determine the kind of the linear part (up to roundoff errors)
+    void classify() {
+        kind = Kind::General;
+        scale = 1.f;
+
+        if constexpr (std::is_arithmetic_v<Float>) {
+            Linear m = transpose(linear) * linear;
+            Float s2 = m(0, 0);
+            if (!(s2 > 0.f))
+                return;
+
+            for (size_t i = 0; i < Size - 1; ++i) {
+                for (size_t j = 0; j < Size - 1; ++j) {
+                    if (std::abs(m(i, j) - (i == j ? s2 : 0.f)) > 1e-5f * s2)
+                        return;
+                }
+            }
+
+            if (std::abs(s2 - 1.f) <= 1e-5f) {
+                kind = Kind::Rigid;
+            } else {
+                kind = Kind::UniformScale;
+                scale = std::sqrt(s2);
+            }
+        }
+    }
+};
+
 /**
  * \brief Encapsulates an animated 4x4 homogeneous coordinate transformation
  *
@@ -529,6 +771,20 @@ std::ostream &operator<<(std::ostream &os, const Transform<Point> &t) {
     return os;
 }
 
+template <typename Point>
+std::ostream &operator<<(std::ostream &os, const AffineTransform<Point> &t) {
+    using Kind = typename AffineTransform<Point>::Kind;
+    os << "AffineTransform[" << std::endl
+       << "  linear = " << string::indent(t.linear, 11) << "," << std::endl
+       << "  translation = " << t.translation << "," << std::endl
+       << "  kind = " << (t.kind == Kind::Rigid ? "rigid" :
+                          (t.kind == Kind::UniformScale ? "uniform_scale" : "general"));
+    if (t.kind == Kind::UniformScale)
+        os << "," << std::endl << "  scale = " << t.scale;
+    os << std::endl << "]";
+    return os;
+}
+
 std::ostream &operator<<(std::ostream &os, const AnimatedTransform::Keyframe &frame);
 
 std::ostream &operator<<(std::ostream &os, const AnimatedTransform &t);
@@ -28,6 +28,9 @@ extern MTS_EXPORT_CORE std::string time_string(float time, bool precise = false)
 /// Turn a memory size into a human-readable string
 extern MTS_EXPORT_CORE std::string mem_string(size_t size, bool precise = false);
 
+/// Return the peak resident memory of the process in bytes (0 if unknown)
+extern MTS_EXPORT_CORE size_t peak_memory_usage();
+
 /// Returns 'true' if the application is running inside a debugger
 extern MTS_EXPORT_CORE bool detect_debugger();
 
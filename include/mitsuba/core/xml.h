@@ -1,6 +1,9 @@
 #pragma once
 
 #include <mitsuba/mitsuba.h>
+#include <mitsuba/core/filesystem.h>
+#include <mitsuba/core/object.h>
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -13,6 +16,55 @@ NAMESPACE_BEGIN(xml)
 /// Used to pass key=value pairs to the parser
 using ParameterList = std::vector<std::pair<std::string, std::string>>;
 
+NAMESPACE_BEGIN(detail)
+struct InstanceCacheData;
+NAMESPACE_END(detail)
+
+/**
+ * \brief Objects created by a previous call to \ref load_file(), which are
+ * reused when the same scene is loaded again with different parameters
+ *
+ * This speeds up the rendering of parameter sweeps. After parsing, every node
+ * of the scene description is compared to the one with the same ID in the
+ * previous load:
+ *
+ * - When the properties and referenced objects are identical, the previous
+ *   object is reused.
+ *
+ * - When only floating point properties differ, and the previous object
+ *   exposes them through \ref Object::traverse() (either directly or as the
+ *   \c value of a uniform texture with the same name), the new values are
+ *   written in place and \ref Object::parameters_changed() is called.
+ *
+ * - Otherwise, the object is instantiated again. This also applies to its
+ *   parents, whose references changed.
+ *
+ * Reused objects keep any state acquired since they were created, and files
+ * referenced by the scene are not checked for modifications.
+ */
+class MTS_EXPORT_CORE InstanceCache : public Object {
+public:
+    InstanceCache();
+
+    /// Number of objects reused without changes by the last load
+    size_t reused() const;
+
+    /// Number of objects updated through \ref Object::parameters_changed() by the last load
+    size_t updated() const;
+
+    /// Number of objects created by the last load
+    size_t created() const;
+
+    detail::InstanceCacheData *data() { return m_data.get(); }
+
+    MTS_DECLARE_CLASS()
+protected:
+    virtual ~InstanceCache();
+
+private:
+    std::unique_ptr<detail::InstanceCacheData> m_data;
+};
+
 /**
  * Load a Mitsuba scene from an XML file
  *
@@ -29,17 +81,57 @@ using ParameterList = std::vector<std::pair<std::string, std::string>>;
  * \param update_scene
  *     When Mitsuba updates scene to a newer version, should the
  *     updated XML file be written back to disk?
+ *
+ * \param cache
+ *     Optional cache of the objects of a previous load of the same scene,
+ *     which is updated with the objects of this one (see \ref InstanceCache)
  */
 extern MTS_EXPORT_CORE ref<Object> load_file(const fs::path &path,
                                              const std::string &variant,
                                              ParameterList parameters = ParameterList(),
-                                             bool update_scene = false);
+                                             bool update_scene = false,
+                                             InstanceCache *cache = nullptr);
 
 /// Load a Mitsuba scene from an XML string
 extern MTS_EXPORT_CORE ref<Object> load_string(const std::string &string,
                                                const std::string &variant,
                                                ParameterList parameters = ParameterList());
 
+/**
+ * \brief Set the directory of the scene cache
+ *
+ * When a cache directory is specified, \ref load_file() stores the parsed
+ * scene descriptions (i.e. the objects and their properties, before
+ * instantiation) in a binary format, and subsequent loads of the same file
+ * with the same variant and parameters skip the XML parsing stage. Entries
+ * are invalidated when the scene file, one of its included files or one of
+ * the spectrum files that it references changes. An empty path disables the
+ * cache (the default).
+ */
+extern MTS_EXPORT_CORE void set_cache_dir(const fs::path &path);
+
+/// Return the directory of the scene cache (empty when the cache is disabled)
+extern MTS_EXPORT_CORE fs::path cache_dir();
+
+/**
+ * \brief Share identical BSDFs and textures between their users
+ *
+ * Exported scenes often contain many identical material definitions. When
+ * enabled, the loader compares the plugin name and properties of every BSDF
+ * and texture node (including the RGB and spectrum values that are turned
+ * into textures) with the ones created before during the same load, and
+ * reuses the existing object when they are identical. The node IDs are not
+ * compared. Since nested objects are shared first, the comparison of their
+ * parents extends to the objects that they reference. Objects whose
+ * \c shared property is \c false (see the bitmap texture) are never shared.
+ *
+ * Shared objects are only exposed once by \ref Object::traverse(), hence
+ * this is disabled by default.
+ */
+extern MTS_EXPORT_CORE void set_deduplication(bool enabled);
+
+/// Are identical BSDFs and textures shared? (see \ref set_deduplication())
+extern MTS_EXPORT_CORE bool deduplication();
 
 
 NAMESPACE_BEGIN(detail)
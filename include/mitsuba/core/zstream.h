@@ -5,6 +5,8 @@
 extern "C" {
     struct z_stream_s;
     typedef struct z_stream_s z_stream;
+    struct ZSTD_CCtx_s;
+    struct ZSTD_DCtx_s;
 };
 
 NAMESPACE_BEGIN(mitsuba)
@@ -15,17 +17,22 @@ constexpr size_t kZStreamBufferSize = 32768;
 NAMESPACE_END(detail)
 
 /**
- * \brief Transparent compression/decompression stream based on \c zlib.
+ * \brief Transparent compression/decompression stream based on \c zlib
+ * or \c zstd.
  *
  * This class transparently decompresses and compresses reads and writes
- * to a nested stream, respectively.
+ * to a nested stream, respectively. The \c zstd backend decompresses
+ * several times faster than \c zlib at similar compression ratios and can
+ * compress on multiple threads, but it is only available when Mitsuba was
+ * compiled against the \c zstd library (see \ref has_zstd()).
  */
 class MTS_EXPORT_CORE ZStream : public Stream {
 public:
 
     enum EStreamType {
         EDeflateStream, ///< A raw deflate stream
-        EGZipStream ///< A gzip-compatible stream
+        EGZipStream, ///< A gzip-compatible stream
+        EZstdStream ///< A zstd stream (sequence of zstd frames)
     };
 
     using Stream::read;
@@ -34,9 +41,17 @@ public:
     /** \brief Creates a new compression stream with the given underlying stream.
      * This new instance takes ownership of the child stream. The child stream
      * must outlive the ZStream.
+     *
+     * \param level
+     *     Compression level, or \c -1 to use the default level of the backend
+     *
+     * \param threads
+     *     Number of threads used to compress the data written to a \c zstd
+     *     stream (\c -1: one per core, \c 0 or \c 1: compress on the calling
+     *     thread). Ignored by the \c zlib backend.
      */
     ZStream(Stream *child_stream, EStreamType stream_type = EDeflateStream,
-            int level = -1);
+            int level = -1, int threads = 1);
 
     /// Returns a string representation
     std::string to_string() const override;
@@ -62,6 +77,24 @@ public:
     /// Returns the child stream of this compression stream
     Stream *child_stream() { return m_child_stream; }
 
+    /// Returns the compression format of this stream
+    EStreamType stream_type() const { return m_stream_type; }
+
+    /// Was Mitsuba compiled with support for \ref EZstdStream?
+    static bool has_zstd();
+
+    /**
+     * \brief Decompress a self-contained block of compressed data
+     *
+     * Decompresses the \c src_size bytes at \c src into exactly \c dst_size
+     * bytes at \c dst. Throws an exception when the block is corrupt or
+     * does not decompress to the expected size. Since no \c ZStream
+     * instance is involved, this function can be called concurrently on
+     * different blocks.
+     */
+    static void decompress(const void *src, size_t src_size, void *dst,
+                           size_t dst_size, EStreamType stream_type = EDeflateStream);
+
     //! @}
     // =========================================================================
 
@@ -71,14 +104,14 @@ public:
 
     /**
      * \brief Reads a specified amount of data from the stream, decompressing
-     * it first using ZLib.
+     * it first using zlib or zstd.
      * Throws an exception when the stream ended prematurely.
      */
     virtual void read(void *p, size_t size) override;
 
     /**
      * \brief Writes a specified amount of data into the stream, compressing
-     * it first using ZLib.
+     * it first using zlib or zstd.
      * Throws an exception when not all data could be written.
      */
     virtual void write(const void *p, size_t size) override;
@@ -128,7 +161,12 @@ protected:
 
 private:
     ref<Stream> m_child_stream;
+    EStreamType m_stream_type;
     std::unique_ptr<z_stream> m_deflate_stream, m_inflate_stream;
+    ZSTD_CCtx_s *m_zstd_cctx = nullptr;
+    ZSTD_DCtx_s *m_zstd_dctx = nullptr;
+    /// Unconsumed part of \c m_inflate_buffer (zstd backend)
+    size_t m_zstd_in_pos = 0, m_zstd_in_size = 0;
     uint8_t m_deflate_buffer[detail::kZStreamBufferSize];
     uint8_t m_inflate_buffer[detail::kZStreamBufferSize];
     bool m_did_write;
@@ -0,0 +1,191 @@
+#pragma once
+
+#include <mitsuba/core/struct.h>
+#include <mitsuba/python/python.h>
+#include <vector>
+
+/*
+ * Zero-copy exchange of array data with other Python frameworks (NumPy,
+ * PyTorch, CuPy, ...) using the DLPack protocol. Only the subset of its
+ * (ABI-stable) data structures that is needed by the bindings is declared
+ * below. Tensors are always dense and stored in row-major order.
+ */
+
+NAMESPACE_BEGIN(mitsuba)
+NAMESPACE_BEGIN(dlpack)
+
+/// Device types (subset of \c DLDeviceType)
+enum DeviceType : int32_t { CPU = 1, CUDA = 2 };
+
+/// Type codes (subset of \c DLDataTypeCode)
+enum TypeCode : uint8_t { Int = 0, UInt = 1, Float = 2 };
+
+/// Equivalent of \c DLDevice
+struct Device {
+    int32_t device_type;
+    int32_t device_id;
+};
+
+/// Equivalent of \c DLDataType
+struct DataType {
+    uint8_t code;
+    uint8_t bits;
+    uint16_t lanes;
+};
+
+/// Equivalent of \c DLTensor
+struct Tensor {
+    void *data;
+    Device device;
+    int32_t ndim;
+    DataType dtype;
+    int64_t *shape;
+    int64_t *strides;
+    uint64_t byte_offset;
+};
+
+/// Equivalent of \c DLManagedTensor
+struct ManagedTensor {
+    Tensor dl_tensor;
+    void *manager_ctx;
+    void (*deleter)(ManagedTensor *self);
+};
+
+/// Convert a \ref Struct field type into a DLPack data type
+inline DataType data_type(Struct::Type type) {
+    switch (type) {
+        case Struct::Type::Int8:    return { Int,    8, 1 };
+        case Struct::Type::UInt8:   return { UInt,   8, 1 };
+        case Struct::Type::Int16:   return { Int,   16, 1 };
+        case Struct::Type::UInt16:  return { UInt,  16, 1 };
+        case Struct::Type::Int32:   return { Int,   32, 1 };
+        case Struct::Type::UInt32:  return { UInt,  32, 1 };
+        case Struct::Type::Int64:   return { Int,   64, 1 };
+        case Struct::Type::UInt64:  return { UInt,  64, 1 };
+        case Struct::Type::Float16: return { Float, 16, 1 };
+        case Struct::Type::Float32: return { Float, 32, 1 };
+        case Struct::Type::Float64: return { Float, 64, 1 };
+        default: Throw("dlpack::data_type(): unsupported component format %s!", type);
+    }
+}
+
+/// Convert a DLPack data type into a \ref Struct field type
+inline Struct::Type struct_type(const DataType &dtype) {
+    if (dtype.lanes == 1) {
+        switch (dtype.code) {
+            case Int:
+                switch (dtype.bits) {
+                    case 8:  return Struct::Type::Int8;
+                    case 16: return Struct::Type::Int16;
+                    case 32: return Struct::Type::Int32;
+                    case 64: return Struct::Type::Int64;
+                }
+                break;
+            case UInt:
+                switch (dtype.bits) {
+                    case 8:  return Struct::Type::UInt8;
+                    case 16: return Struct::Type::UInt16;
+                    case 32: return Struct::Type::UInt32;
+                    case 64: return Struct::Type::UInt64;
+                }
+                break;
+            case Float:
+                switch (dtype.bits) {
+                    case 16: return Struct::Type::Float16;
+                    case 32: return Struct::Type::Float32;
+                    case 64: return Struct::Type::Float64;
+                }
+                break;
+        }
+    }
+    Throw("dlpack::struct_type(): unsupported data type (code %i, %i bits, %i lanes)!",
+          (int) dtype.code, (int) dtype.bits, (int) dtype.lanes);
+}
+
+/// Does the tensor store its entries contiguously in row-major order?
+inline bool is_contiguous(const Tensor &tensor) {
+    if (!tensor.strides)
+        return true;
+    int64_t stride = 1;
+    for (int32_t i = tensor.ndim - 1; i >= 0; --i) {
+        if (tensor.shape[i] != 1 && tensor.strides[i] != stride)
+            return false;
+        stride *= tensor.shape[i];
+    }
+    return true;
+}
+
+/**
+ * \brief Wrap memory into a DLPack capsule without copying it
+ *
+ * \param owner
+ *    Python object owning the memory, which is kept alive until the
+ *    consumer of the capsule releases the tensor (or the capsule is
+ *    destroyed without having been consumed).
+ */
+inline py::capsule export_tensor(void *data, DataType dtype, std::vector<int64_t> shape,
+                                 DeviceType device, py::handle owner) {
+    struct Context {
+        ManagedTensor tensor;
+        std::vector<int64_t> shape;
+        py::object owner;
+    };
+
+    Context *ctx = new Context();
+    ctx->shape = std::move(shape);
+    ctx->owner = py::reinterpret_borrow<py::object>(owner);
+
+    Tensor &tensor = ctx->tensor.dl_tensor;
+    tensor.data = data;
+    tensor.device = { device, 0 };
+    tensor.ndim = (int32_t) ctx->shape.size();
+    tensor.dtype = dtype;
+    tensor.shape = ctx->shape.data();
+    tensor.strides = nullptr;
+    tensor.byte_offset = 0;
+
+    ctx->tensor.manager_ctx = ctx;
+    ctx->tensor.deleter = [](ManagedTensor *self) {
+        // The consumer may release the tensor from any thread
+        py::gil_scoped_acquire gil;
+        delete (Context *) self->manager_ctx;
+    };
+
+    return py::capsule(&ctx->tensor, "dltensor", [](PyObject *o) {
+        // Consumers rename the capsule, after which they own the tensor
+        if (PyCapsule_IsValid(o, "dltensor")) {
+            ManagedTensor *t = (ManagedTensor *) PyCapsule_GetPointer(o, "dltensor");
+            t->deleter(t);
+        }
+    });
+}
+
+/**
+ * \brief Take ownership of the tensor of a DLPack capsule, or of an object
+ * implementing the \c __dlpack__() protocol
+ *
+ * Returns the tensor along with a Python object that releases it once it is
+ * destroyed, and which must be kept alive as long as the data is accessed.
+ */
+inline std::pair<const Tensor *, py::object> import_tensor(py::handle obj) {
+    py::object capsule = py::hasattr(obj, "__dlpack__")
+                             ? obj.attr("__dlpack__")()
+                             : py::reinterpret_borrow<py::object>(obj);
+
+    if (!PyCapsule_IsValid(capsule.ptr(), "dltensor"))
+        throw py::type_error("Expected a DLPack capsule or an object implementing __dlpack__()!");
+
+    ManagedTensor *tensor = (ManagedTensor *) PyCapsule_GetPointer(capsule.ptr(), "dltensor");
+    PyCapsule_SetName(capsule.ptr(), "used_dltensor");
+
+    py::capsule owner(tensor, [](void *p) {
+        ManagedTensor *t = (ManagedTensor *) p;
+        if (t->deleter)
+            t->deleter(t);
+    });
+
+    return { &tensor->dl_tensor, std::move(owner) };
+}
+
+NAMESPACE_END(dlpack)
+NAMESPACE_END(mitsuba)
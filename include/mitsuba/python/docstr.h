@@ -81,6 +81,133 @@ static const char *__doc_get_shape_descr_idx =
 R"doc(Retrieve index of custom shape descriptor in the list above for a
 given shape)doc";
 
+static const char *__doc_mitsuba_AffineTransform =
+R"doc(Compact affine transformation that stores a 3x4 matrix
+
+Transform stores a full homogeneous matrix along with its inverse
+transpose. Affine transformations (e.g. the ones of shape instances)
+only need the linear part and the translation, which this class stores
+in half the memory. As the bottom row is implicit, points are also
+transformed without a perspective division.
+
+The kind of the linear part (rigid, rigid with a uniform scale, or
+general) is determined on construction. The inverse is not stored:
+inverse() computes it when needed, which only involves a
+transposition for rigid and uniformly scaled transformations. The same
+holds for the transformation of normals, which needs the inverse of
+the linear part in the general case only. The classification is only
+performed for scalar transformations, vectorized ones are always
+treated as general.)doc";
+
+static const char *__doc_mitsuba_AffineTransform_AffineTransform = R"doc(Initialize with the identity transformation)doc";
+
+static const char *__doc_mitsuba_AffineTransform_AffineTransform_2 = R"doc(Initialize from a linear part and a translation)doc";
+
+static const char *__doc_mitsuba_AffineTransform_AffineTransform_3 =
+R"doc(Initialize from the upper 3x4 part of an affine homogeneous
+transformation)doc";
+
+static const char *__doc_mitsuba_AffineTransform_Kind =
+R"doc(Classification of the linear part, from the most to the least
+constrained)doc";
+
+static const char *__doc_mitsuba_AffineTransform_Kind_General = R"doc(Arbitrary linear part)doc";
+
+static const char *__doc_mitsuba_AffineTransform_Kind_Rigid = R"doc(Orthonormal linear part (rotations and reflections))doc";
+
+static const char *__doc_mitsuba_AffineTransform_Kind_UniformScale = R"doc(Orthonormal linear part multiplied by a uniform scale factor)doc";
+
+static const char *__doc_mitsuba_AffineTransform_classify =
+R"doc(Determine the kind of the linear part (up to roundoff errors))doc";
+
+static const char *__doc_mitsuba_AffineTransform_has_scale = R"doc(Does the linear part contain a scale component?)doc";
+
+static const char *__doc_mitsuba_AffineTransform_inverse =
+R"doc(Compute the inverse of this transformation
+
+This only involves a transposition for rigid and uniformly scaled
+transformations, and a 3x3 matrix inversion otherwise.)doc";
+
+static const char *__doc_mitsuba_AffineTransform_kind = R"doc()doc";
+
+static const char *__doc_mitsuba_AffineTransform_linear = R"doc(//! @{ \name Fields)doc";
+
+static const char *__doc_mitsuba_AffineTransform_operator_eq = R"doc(Equality comparison operator)doc";
+
+static const char *__doc_mitsuba_AffineTransform_operator_mul = R"doc(Concatenate transformations)doc";
+
+static const char *__doc_mitsuba_AffineTransform_operator_mul_2 = R"doc(Transform a 3D point)doc";
+
+static const char *__doc_mitsuba_AffineTransform_operator_mul_3 = R"doc(Transform a 3D vector)doc";
+
+static const char *__doc_mitsuba_AffineTransform_operator_mul_4 =
+R"doc(Transform a 3D normal vector
+
+This uses the linear part itself (up to a scale factor) unless the
+transformation is general, in which case its inverse transpose is
+computed on the fly.)doc";
+
+static const char *__doc_mitsuba_AffineTransform_operator_mul_5 = R"doc(Transform a ray)doc";
+
+static const char *__doc_mitsuba_AffineTransform_operator_ne = R"doc(Inequality comparison operator)doc";
+
+static const char *__doc_mitsuba_AffineTransform_scale =
+R"doc(Uniform scale factor of the linear part (equal to 1 unless ``kind ==
+UniformScale``))doc";
+
+static const char *__doc_mitsuba_AffineTransform_to_transform =
+R"doc(Convert to a homogeneous transformation (along with its inverse
+transpose))doc";
+
+static const char *__doc_mitsuba_AffineTransform_transform_affine =
+R"doc(Transform a 3D vector/point/normal/ray (for interface compatibility
+with Transform, as all transformations are affine))doc";
+
+static const char *__doc_mitsuba_AffineTransform_translation = R"doc()doc";
+
+static const char *__doc_mitsuba_AliasTable =
+R"doc(Alias table for sampling a discrete 1D distribution in constant time
+
+The table is built in linear time using Vose's method and stores, for
+each of its ``n`` entries, the probability of keeping the entry along
+with an alias that is chosen otherwise. Sampling therefore takes two
+lookups regardless of the number of entries. In contrast to the
+inversion of a CDF, the mapping from samples to indices is not
+monotonic, which does not preserve the stratification of the samples.
+
+This is used by the distributions below once their
+``build_alias_table()`` method has been called.)doc";
+
+static const char *__doc_mitsuba_AliasTable_AliasTable = R"doc(Create an unitialized AliasTable instance)doc";
+
+static const char *__doc_mitsuba_AliasTable_AliasTable_2 =
+R"doc(Build the table for the given non-negative (unnormalized) weights)doc";
+
+static const char *__doc_mitsuba_AliasTable_empty = R"doc(Is the table empty/uninitialized?)doc";
+
+static const char *__doc_mitsuba_AliasTable_m_alias = R"doc()doc";
+
+static const char *__doc_mitsuba_AliasTable_m_prob = R"doc()doc";
+
+static const char *__doc_mitsuba_AliasTable_sample_reuse =
+R"doc(Transform a uniformly distributed sample to the stored distribution
+
+Parameter ``value``:
+    A uniformly distributed sample on the interval [0, 1].
+
+Returns:
+    A tuple consisting of
+
+1. the discrete index associated with the sample, and 2. the re-
+scaled sample value.)doc";
+
+static const char *__doc_mitsuba_AliasTable_sample_reuse_impl =
+R"doc(Implementation of sample_reuse() for an arbitrary value type, which
+lets the batched queries of the distributions below process packets of
+samples in the scalar variants)doc";
+
+static const char *__doc_mitsuba_AliasTable_size = R"doc(Return the number of entries)doc";
+
 static const char *__doc_mitsuba_AnimatedTransform =
 R"doc(Encapsulates an animated 4x4 homogeneous coordinate transformation
 
@@ -260,6 +387,65 @@ static const char *__doc_mitsuba_ArgParser_parse = R"doc(Parse the given set of
 
 static const char *__doc_mitsuba_ArgParser_parse_2 = R"doc(Parse the given set of command line arguments)doc";
 
+static const char *__doc_mitsuba_AsyncFileStream =
+R"doc(Read-only `Stream` implementation backed-up by a file, which
+reads ahead of the current position on a background thread.
+
+The file is loaded in blocks of ``block_size`` bytes into a pool of
+``block_count`` buffers, which are refilled while the consumer decodes
+the contents of the previous ones. This lets mesh and image loaders
+overlap their parsing work with the I/O latency of the underlying
+storage (e.g. a network file system). Sequential reads are served from
+the pool and seeks within the buffered range are free, while other
+seeks restart the read-ahead at the new position.
+
+The stream must not be accessed concurrently from several threads.)doc";
+
+static const char *__doc_mitsuba_AsyncFileStream_AsyncFileStream =
+R"doc(Opens the file pointed by ``p`` and starts reading it
+
+Throws an exception if the file cannot be opened.)doc";
+
+static const char *__doc_mitsuba_AsyncFileStream_block_count = R"doc(Return the number of blocks that can be read ahead)doc";
+
+static const char *__doc_mitsuba_AsyncFileStream_block_size = R"doc(Return the size of the blocks that are read ahead)doc";
+
+static const char *__doc_mitsuba_AsyncFileStream_can_read = R"doc(True except if the stream was closed.)doc";
+
+static const char *__doc_mitsuba_AsyncFileStream_can_write = R"doc(Always returns false (the stream is read-only))doc";
+
+static const char *__doc_mitsuba_AsyncFileStream_class = R"doc()doc";
+
+static const char *__doc_mitsuba_AsyncFileStream_close =
+R"doc(Stops the read-ahead and closes the underlying file. No further read
+operations are permitted.
+
+This function is idempotent. It is called automatically by the
+destructor.)doc";
+
+static const char *__doc_mitsuba_AsyncFileStream_flush = R"doc(No-op (the stream is read-only))doc";
+
+static const char *__doc_mitsuba_AsyncFileStream_is_closed =
+R"doc(Whether the stream is closed (no read operations are then permitted))doc";
+
+static const char *__doc_mitsuba_AsyncFileStream_path = R"doc(Return the path descriptor associated with this stream)doc";
+
+static const char *__doc_mitsuba_AsyncFileStream_read =
+R"doc(Reads a specified amount of data from the stream. Throws an exception
+when the stream ended prematurely.)doc";
+
+static const char *__doc_mitsuba_AsyncFileStream_seek = R"doc(Seeks to a position inside the stream)doc";
+
+static const char *__doc_mitsuba_AsyncFileStream_size = R"doc(Returns the size of the file)doc";
+
+static const char *__doc_mitsuba_AsyncFileStream_tell = R"doc(Gets the current position inside the file)doc";
+
+static const char *__doc_mitsuba_AsyncFileStream_to_string = R"doc(Returns a string representation)doc";
+
+static const char *__doc_mitsuba_AsyncFileStream_truncate = R"doc(Not supported: always throws an exception)doc";
+
+static const char *__doc_mitsuba_AsyncFileStream_write = R"doc(Not supported: always throws an exception)doc";
+
 static const char *__doc_mitsuba_AtomicFloat =
 R"doc(Atomic floating point data type
 
@@ -402,6 +588,9 @@ static const char *__doc_mitsuba_BSDFFlags_GlossyTransmission = R"doc(Glossy tra
 
 static const char *__doc_mitsuba_BSDFFlags_NeedsDifferentials = R"doc(Does the implementation require access to texture-space differentials)doc";
 
+static const char *__doc_mitsuba_BSDFFlags_Polarizing =
+R"doc(The lobe changes the polarization state of light (polarized variants only))doc";
+
 static const char *__doc_mitsuba_BSDFFlags_NonSymmetric = R"doc(Flags non-symmetry (e.g. transmission in dielectric materials))doc";
 
 static const char *__doc_mitsuba_BSDFFlags_None = R"doc(No flags set (default value))doc";
@@ -500,6 +689,30 @@ Parameter ``si``:
     surface position. The incident direction is obtained from the
     field ``si.wi``.)doc";
 
+static const char *__doc_mitsuba_BSDF_eval_pdf =
+R"doc(Jointly evaluate the BSDF and the probability per unit solid angle of
+sampling a given direction
+
+This method is equivalent to calling eval() and pdf() with the same
+arguments, but lets the implementation share the work that is common
+to both (e.g. microfacet terms, Fresnel factors, and texture lookups).
+The default implementation simply calls the two methods.
+
+Parameter ``ctx``:
+    A context data structure describing which lobes to evalute, and
+    whether radiance or importance are being transported.
+
+Parameter ``si``:
+    A surface interaction data structure describing the underlying
+    surface position. The incident direction is obtained from the
+    field <tt>si.wi</tt>.
+
+Parameter ``wo``:
+    The outgoing direction
+
+Returns:
+    A pair with the BSDF value and the sampling density)doc";
+
 static const char *__doc_mitsuba_BSDF_flags = R"doc(Flags for all components combined.)doc";
 
 static const char *__doc_mitsuba_BSDF_flags_2 = R"doc(Flags for a specific component of this BSDF.)doc";
@@ -876,6 +1089,10 @@ static const char *__doc_mitsuba_Bitmap_data_2 = R"doc(Return a pointer to the u
 
 static const char *__doc_mitsuba_Bitmap_detect_file_format = R"doc(Attempt to detect the bitmap file format in a given stream)doc";
 
+static const char *__doc_mitsuba_Bitmap_exr_multi_part = R"doc(Return whether write() produces multi-part OpenEXR files)doc";
+
+static const char *__doc_mitsuba_Bitmap_exr_tile_size = R"doc(Return the tile size of OpenEXR files written by write())doc";
+
 static const char *__doc_mitsuba_Bitmap_has_alpha = R"doc(Return whether this image has an alpha channel)doc";
 
 static const char *__doc_mitsuba_Bitmap_height = R"doc(Return the bitmap's height in pixels)doc";
@@ -916,6 +1133,17 @@ static const char *__doc_mitsuba_Bitmap_premultiplied_alpha = R"doc(Return wheth
 
 static const char *__doc_mitsuba_Bitmap_read = R"doc(Read a file from a stream)doc";
 
+static const char *__doc_mitsuba_Bitmap_read_header =
+R"doc(Only read the header of a bitmap file
+
+The returned bitmap has the size, pixel format, component format and
+metadata of the image stored in the file, but no pixel storage
+(data() returns ``nullptr``). This is considerably cheaper than
+decoding the entire image.
+
+OpenEXR files are described with the channels as stored, i.e. without
+the conversion of nonstandard chromaticities to XYZ.)doc";
+
 static const char *__doc_mitsuba_Bitmap_read_bmp = R"doc(Read a file encoded using the BMP file format)doc";
 
 static const char *__doc_mitsuba_Bitmap_read_jpeg = R"doc(Read a file encoded using the JPEG file format)doc";
@@ -995,6 +1223,20 @@ Parameter ``clamp``:
     Filtered image pixels will be clamped to the following range.
     Default: -infinity..infinity (i.e. no clamping is used))doc";
 
+static const char *__doc_mitsuba_Bitmap_set_exr_multi_part =
+R"doc(Specify whether write() produces multi-part OpenEXR files
+
+Multi-part files store the channels of each layer (e.g. ``albedo.R``,
+``albedo.G``, and ``albedo.B``) in a separate part, which readers can
+load without decompressing the other layers. The channels that do not
+belong to a layer form the ``default`` part.)doc";
+
+static const char *__doc_mitsuba_Bitmap_set_exr_tile_size =
+R"doc(Specify the tile size of OpenEXR files written by write()
+
+Tiled files let readers load parts of large images. The default value
+0 writes scanline-based files.)doc";
+
 static const char *__doc_mitsuba_Bitmap_set_metadata = R"doc(Set the a Properties object containing the image metadata)doc";
 
 static const char *__doc_mitsuba_Bitmap_set_premultiplied_alpha = R"doc(Specify whether the bitmap uses premultiplied alpha)doc";
@@ -1029,6 +1271,9 @@ static const char *__doc_mitsuba_Bitmap_uint8_data_2 = R"doc(Return a pointer to
 
 static const char *__doc_mitsuba_Bitmap_vflip = R"doc(Vertically flip the bitmap)doc";
 
+static const char *__doc_mitsuba_Bitmap_wait_async_writes =
+R"doc(Wait until all asynchronous writes (see write_async()) have completed)doc";
+
 static const char *__doc_mitsuba_Bitmap_width = R"doc(Return the bitmap's width in pixels)doc";
 
 static const char *__doc_mitsuba_Bitmap_write =
@@ -1089,7 +1334,12 @@ compressor.)doc";
 
 static const char *__doc_mitsuba_Bitmap_write_async =
 R"doc(Equivalent to write(), but executes asynchronously on a different
-thread)doc";
+thread
+
+The bitmap must not be modified until the write has completed. When
+another asynchronous write to the same path is still in progress, this
+function first waits for its completion. Errors are reported as
+warnings.)doc";
 
 static const char *__doc_mitsuba_Bitmap_write_jpeg = R"doc(Save a file using the JPEG file format)doc";
 
@@ -1438,6 +1688,14 @@ static const char *__doc_mitsuba_ContinuousDistribution_ContinuousDistribution_3
 
 static const char *__doc_mitsuba_ContinuousDistribution_ContinuousDistribution_4 = R"doc(Initialize from a given floating point array)doc";
 
+static const char *__doc_mitsuba_ContinuousDistribution_build_alias_table =
+R"doc(Build an alias table (see AliasTable) over the intervals, so that
+sample() and sample_pdf() select them in constant time instead of
+searching the CDF
+
+The table is kept up to date by update(). Note that the samples are
+then no longer mapped to the positions in a monotonic way.)doc";
+
 static const char *__doc_mitsuba_ContinuousDistribution_cdf =
 R"doc(Return the unnormalized discrete cumulative distribution function over
 intervals)doc";
@@ -1448,24 +1706,45 @@ intervals (const version))doc";
 
 static const char *__doc_mitsuba_ContinuousDistribution_empty = R"doc(Is the distribution object empty/uninitialized?)doc";
 
+static const char *__doc_mitsuba_ContinuousDistribution_eval_batch = R"doc(Apply 'func' to packets of the queries stored in 'x')doc";
+
 static const char *__doc_mitsuba_ContinuousDistribution_eval_cdf =
 R"doc(Evaluate the unnormalized cumulative distribution function (CDF) at
 position ``p``)doc";
 
+static const char *__doc_mitsuba_ContinuousDistribution_eval_cdf_batch = R"doc(Batched version of eval_cdf() (see eval_pdf_batch()))doc";
+
 static const char *__doc_mitsuba_ContinuousDistribution_eval_cdf_normalized =
 R"doc(Evaluate the unnormalized cumulative distribution function (CDF) at
 position ``p``)doc";
 
+static const char *__doc_mitsuba_ContinuousDistribution_eval_cdf_normalized_batch =
+R"doc(Batched version of eval_cdf_normalized() (see eval_pdf_batch()))doc";
+
 static const char *__doc_mitsuba_ContinuousDistribution_eval_pdf =
 R"doc(Evaluate the unnormalized probability mass function (PDF) at position
 ``x``)doc";
 
+static const char *__doc_mitsuba_ContinuousDistribution_eval_pdf_batch =
+R"doc(Evaluate the unnormalized probability mass function (PDF) at the
+``count`` positions ``x`` and write the results to ``out``
+
+This is equivalent to calling eval_pdf() for each position, but the
+queries are processed in SIMD packets (also in the scalar variants).)doc";
+
 static const char *__doc_mitsuba_ContinuousDistribution_eval_pdf_normalized =
 R"doc(Evaluate the normalized probability mass function (PDF) at position
 ``x``)doc";
 
+static const char *__doc_mitsuba_ContinuousDistribution_eval_pdf_normalized_batch =
+R"doc(Batched version of eval_pdf_normalized() (see eval_pdf_batch()))doc";
+
+static const char *__doc_mitsuba_ContinuousDistribution_has_alias_table = R"doc(Was build_alias_table() called?)doc";
+
 static const char *__doc_mitsuba_ContinuousDistribution_integral = R"doc(Return the original integral of PDF entries before normalization)doc";
 
+static const char *__doc_mitsuba_ContinuousDistribution_m_alias = R"doc()doc";
+
 static const char *__doc_mitsuba_ContinuousDistribution_m_cdf = R"doc()doc";
 
 static const char *__doc_mitsuba_ContinuousDistribution_m_integral = R"doc()doc";
@@ -1503,6 +1782,29 @@ Parameter ``value``:
 Returns:
     The sampled position.)doc";
 
+static const char *__doc_mitsuba_ContinuousDistribution_sample_batch =
+R"doc(Transform ``count`` uniformly distributed samples to the stored
+distribution
+
+This is equivalent to calling sample_pdf() for each sample, but the
+queries are processed in SIMD packets (also in the scalar variants).
+
+Parameter ``value``:
+    Array containing ``count`` uniformly distributed samples on the
+    interval [0, 1].
+
+Parameter ``out``:
+    Array receiving the sampled positions.
+
+Parameter ``pdf``:
+    Optional array receiving the normalized probability densities of
+    the samples (may be ``nullptr``).)doc";
+
+static const char *__doc_mitsuba_ContinuousDistribution_sample_interval =
+R"doc(Select the interval associated with the sample ``value`` and return
+its index along with the (unnormalized) probability mass that precedes
+the sample within the interval)doc";
+
 static const char *__doc_mitsuba_ContinuousDistribution_sample_pdf =
 R"doc(%Transform a uniformly distributed sample to the stored distribution
 
@@ -1563,6 +1865,131 @@ static const char *__doc_mitsuba_DefaultFormatter_set_has_log_level = R"doc(Shou
 
 static const char *__doc_mitsuba_DefaultFormatter_set_has_thread = R"doc(Should thread information be included? The default is yes.)doc";
 
+static const char *__doc_mitsuba_Denoiser =
+R"doc(Removes the Monte Carlo noise from developed images
+
+The denoiser operates on high dynamic range images, and optionally uses
+the albedo and the shading normals of the visible surfaces (e.g.
+produced by the ``aov`` integrator) as guides. These feature images are
+mostly noise-free, which lets the denoiser preserve the edges and the
+texture detail that the noisy image alone does not resolve.
+
+Two backends are available: Intel Open Image Denoise (when Mitsuba is
+compiled with ``MTS_ENABLE_OIDN``), which is based on a pretrained
+neural network, and a built-in edge-avoiding à-trous wavelet filter that
+has no external dependencies.)doc";
+
+static const char *__doc_mitsuba_Denoiser_Backend = R"doc(Denoising algorithms)doc";
+
+static const char *__doc_mitsuba_Denoiser_Backend_Auto =
+R"doc(Intel Open Image Denoise when available, the built-in filter otherwise)doc";
+
+static const char *__doc_mitsuba_Denoiser_Backend_Builtin = R"doc(Built-in edge-avoiding à-trous wavelet filter)doc";
+
+static const char *__doc_mitsuba_Denoiser_Backend_OIDN = R"doc(Intel Open Image Denoise)doc";
+
+static const char *__doc_mitsuba_Denoiser_Denoiser =
+R"doc(Create a denoiser
+
+Parameter ``backend``:
+    Denoising algorithm. Requesting Open Image Denoise in a build that
+    does not support it raises an exception.
+
+Parameter ``strength``:
+    Scale factor of the tolerance of the built-in filter towards color
+    differences between neighboring pixels. Values above 1 remove more
+    noise at the cost of blurring features that are missing from the
+    guides. (Ignored by Open Image Denoise))doc";
+
+static const char *__doc_mitsuba_Denoiser_backend = R"doc(Return the denoising algorithm (never Backend::Auto))doc";
+
+static const char *__doc_mitsuba_Denoiser_denoise =
+R"doc(Denoise an image
+
+All images must have the same size and use the Struct::Type::Float32
+component format.
+
+Parameter ``color``:
+    Noisy image. Its first channel (for the Bitmap::PixelFormat::Y and
+    Bitmap::PixelFormat::YA pixel formats) or its first three channels
+    are denoised, any other channels are ignored.
+
+Parameter ``albedo``:
+    Optional albedo guide (first three channels)
+
+Parameter ``normal``:
+    Optional shading normal guide (first three channels). Open Image
+    Denoise only uses it in combination with an albedo guide.
+
+Returns:
+    A bitmap with the Bitmap::PixelFormat::Y or
+    Bitmap::PixelFormat::RGB pixel format storing the denoised channels)doc";
+
+static const char *__doc_mitsuba_Denoiser_denoise_builtin = R"doc(Denoise interleaved RGB images using the built-in filter)doc";
+
+static const char *__doc_mitsuba_Denoiser_denoise_oidn = R"doc(Denoise interleaved RGB images using Open Image Denoise)doc";
+
+static const char *__doc_mitsuba_Denoiser_has_oidn =
+R"doc(Was Mitsuba compiled with support for Intel Open Image Denoise?)doc";
+
+static const char *__doc_mitsuba_Denoiser_strength = R"doc(Return the strength of the built-in filter)doc";
+
+static const char *__doc_mitsuba_Denoiser_to_string = R"doc(Return a human-readable representation)doc";
+
+static const char *__doc_mitsuba_DeviceMemoryPool =
+R"doc(Caching allocator for the device buffers of the GPU variants
+
+Building and updating the OptiX acceleration data structures needs
+large temporary and output buffers, which are requested again whenever
+the scene parameters change (e.g. in every iteration of an
+optimization). Requests are rounded up to size classes (four per power
+of two, at least 256 bytes), and released blocks are kept in per-class
+free lists for later requests of the same class. This avoids the
+synchronization of the CUDA allocator and limits fragmentation.
+
+At most limit() bytes are kept in the cache; blocks released beyond
+this are returned to the device. All functions are thread-safe.
+Without GPU support, malloc() raises an exception.)doc";
+
+static const char *__doc_mitsuba_DeviceMemoryPool_DeviceMemoryPool = R"doc()doc";
+
+static const char *__doc_mitsuba_DeviceMemoryPool_free =
+R"doc(Release a buffer allocated by malloc() (``nullptr`` is ignored))doc";
+
+static const char *__doc_mitsuba_DeviceMemoryPool_limit = R"doc(Return the maximum number of cached bytes (default: 1 GiB))doc";
+
+static const char *__doc_mitsuba_DeviceMemoryPool_malloc = R"doc(Allocate a device buffer of at least ``size`` bytes)doc";
+
+static const char *__doc_mitsuba_DeviceMemoryPool_reset_stats =
+R"doc(Reset the peak to the current usage and the hit and miss counters to
+zero)doc";
+
+static const char *__doc_mitsuba_DeviceMemoryPool_set_limit =
+R"doc(Set the maximum number of cached bytes and release the excess)doc";
+
+static const char *__doc_mitsuba_DeviceMemoryPool_size_class = R"doc(Return the size class of a request of ``size`` bytes)doc";
+
+static const char *__doc_mitsuba_DeviceMemoryPool_stats = R"doc(Return the current statistics of the pool)doc";
+
+static const char *__doc_mitsuba_DeviceMemoryPool_trim =
+R"doc(Return all cached blocks (and those cached by Enoki) to the device)doc";
+
+static const char *__doc_mitsuba_DeviceMemoryStats = R"doc(Statistics of the DeviceMemoryPool)doc";
+
+static const char *__doc_mitsuba_DeviceMemoryStats_cached = R"doc(Number of bytes of released blocks that are kept for reuse)doc";
+
+static const char *__doc_mitsuba_DeviceMemoryStats_hits = R"doc(Number of allocations served from the cache)doc";
+
+static const char *__doc_mitsuba_DeviceMemoryStats_limit =
+R"doc(Maximum number of cached bytes (see DeviceMemoryPool::set_limit()))doc";
+
+static const char *__doc_mitsuba_DeviceMemoryStats_misses = R"doc(Number of allocations requested from the device)doc";
+
+static const char *__doc_mitsuba_DeviceMemoryStats_peak = R"doc(Largest value of ``used`` + ``cached``)doc";
+
+static const char *__doc_mitsuba_DeviceMemoryStats_used =
+R"doc(Number of bytes held by the callers of DeviceMemoryPool::malloc())doc";
+
 static const char *__doc_mitsuba_DirectionSample =
 R"doc(Record for solid-angle based area sampling techniques
 
@@ -1705,7 +2132,9 @@ static const char *__doc_mitsuba_DiscreteDistribution2D_DiscreteDistribution2D =
 
 static const char *__doc_mitsuba_DiscreteDistribution2D_DiscreteDistribution2D_2 =
 R"doc(Construct a marginal sample warping scheme for floating point data of
-resolution ``size``.)doc";
+resolution ``size``.
+
+The rows of large inputs are processed in parallel.)doc";
 
 static const char *__doc_mitsuba_DiscreteDistribution2D_eval = R"doc(Evaluate the function value at the given integer position)doc";
 
@@ -1741,6 +2170,17 @@ static const char *__doc_mitsuba_DiscreteDistribution_DiscreteDistribution_3 = R
 
 static const char *__doc_mitsuba_DiscreteDistribution_DiscreteDistribution_4 = R"doc(Initialize from a given floating point array)doc";
 
+static const char *__doc_mitsuba_DiscreteDistribution_DiscreteDistribution_5 =
+R"doc(Restore a distribution from the state computed by an earlier call to
+update() (e.g. after loading it from a file))doc";
+
+static const char *__doc_mitsuba_DiscreteDistribution_build_alias_table =
+R"doc(Build an alias table (see AliasTable), so that sample() and its
+variants take constant time instead of searching the CDF
+
+The table is kept up to date by update(). Note that the samples are
+then no longer mapped to the indices in a monotonic way.)doc";
+
 static const char *__doc_mitsuba_DiscreteDistribution_cdf = R"doc(Return the unnormalized cumulative distribution function)doc";
 
 static const char *__doc_mitsuba_DiscreteDistribution_cdf_2 =
@@ -1765,6 +2205,10 @@ static const char *__doc_mitsuba_DiscreteDistribution_eval_pmf_normalized =
 R"doc(Evaluate the normalized probability mass function (PMF) at index
 ``index``)doc";
 
+static const char *__doc_mitsuba_DiscreteDistribution_has_alias_table = R"doc(Was build_alias_table() called?)doc";
+
+static const char *__doc_mitsuba_DiscreteDistribution_m_alias = R"doc()doc";
+
 static const char *__doc_mitsuba_DiscreteDistribution_m_cdf = R"doc()doc";
 
 static const char *__doc_mitsuba_DiscreteDistribution_m_normalization = R"doc()doc";
@@ -1838,12 +2282,24 @@ static const char *__doc_mitsuba_DiscreteDistribution_sum = R"doc(Return the ori
 
 static const char *__doc_mitsuba_DiscreteDistribution_update = R"doc(Update the internal state. Must be invoked when changing the pmf.)doc";
 
+static const char *__doc_mitsuba_DiscreteDistribution_valid =
+R"doc(Return the first and last index with nonzero probability mass)doc";
+
 static const char *__doc_mitsuba_Distribution2D = R"doc(Base class of Hierarchical2D and Marginal2D with common functionality)doc";
 
 static const char *__doc_mitsuba_Distribution2D_Distribution2D = R"doc()doc";
 
 static const char *__doc_mitsuba_Distribution2D_Distribution2D_2 = R"doc()doc";
 
+static const char *__doc_mitsuba_Distribution2D_for_each_slice =
+R"doc(Run ``func(slice)`` for every slice of the distribution
+
+The slices are independent and are processed in parallel. The
+construction of each slice may itself use nested parallel loops over
+its rows, which TBB balances with the outer loop. This keeps all cores
+busy both for a single large slice (e.g. an environment map) and for
+many small ones (e.g. a measured BSDF).)doc";
+
 static const char *__doc_mitsuba_Distribution2D_interpolate_weights = R"doc()doc";
 
 static const char *__doc_mitsuba_Distribution2D_m_inv_patch_size = R"doc(Inverse of the above)doc";
@@ -1856,6 +2312,10 @@ static const char *__doc_mitsuba_Distribution2D_m_patch_size = R"doc(Size of a b
 
 static const char *__doc_mitsuba_Distribution2D_m_slices = R"doc(Total number of slices (in case Dimension > 1))doc";
 
+static const char *__doc_mitsuba_Distribution2D_row_grain =
+R"doc(Number of rows of width ``width`` that are processed by one parallel
+task)doc";
+
 static const char *__doc_mitsuba_DummyStream =
 R"doc(Stream implementation that never writes to disk, but keeps track of
 the size of the content being written. It can be used, for example, to
@@ -1938,12 +2398,35 @@ static const char *__doc_mitsuba_Emitter_Emitter = R"doc()doc";
 
 static const char *__doc_mitsuba_Emitter_class = R"doc()doc";
 
+static const char *__doc_mitsuba_Emitter_emission_cone =
+R"doc(Return a conservative bound of the directions of emission
+
+The result is a tuple ``(axis, cos_theta_o, cos_theta_e)``: the normals
+(or main directions) of the emitter lie within the cone of half-angle
+``theta_o`` around ``axis``, and light is emitted within ``theta_e`` of
+them. The default implementation emits in all directions.)doc";
+
 static const char *__doc_mitsuba_Emitter_flags = R"doc(Flags for all components combined.)doc";
 
+static const char *__doc_mitsuba_Emitter_index = R"doc(Return the index of this emitter within Scene::emitters())doc";
+
 static const char *__doc_mitsuba_Emitter_is_environment = R"doc(Is this an environment map light emitter?)doc";
 
 static const char *__doc_mitsuba_Emitter_m_flags = R"doc(Combined flags for all properties of this emitter.)doc";
 
+static const char *__doc_mitsuba_Emitter_m_index = R"doc(Index of this emitter within the emitters of the scene)doc";
+
+static const char *__doc_mitsuba_Emitter_power =
+R"doc(Return an estimate of the power emitted by the emitter
+
+This is used to importance sample among many emitters (see
+Scene::sample_emitter_direction()) and only needs to be accurate up to
+a constant factor that is shared by all emitters. The default
+implementation returns 1.)doc";
+
+static const char *__doc_mitsuba_Emitter_set_index =
+R"doc(Set the index of this emitter within Scene::emitters() (called by the scene))doc";
+
 static const char *__doc_mitsuba_Endpoint =
 R"doc(Endpoint: an abstract interface to light sources and sensors
 
@@ -2281,6 +2764,18 @@ static const char *__doc_mitsuba_Film_4 = R"doc()doc";
 
 static const char *__doc_mitsuba_Film_Film = R"doc(Create a film)doc";
 
+static const char *__doc_mitsuba_Film_band_count =
+R"doc(Return the number of wavelength bands recorded by the film
+
+In spectral variants, the sampling integrators then add one channel
+per band (after the AOVs of the integrator), which accumulates the
+radiance of the samples averaged over the wavelengths of the band. The
+bands split band_range() into intervals of equal width. The default
+implementation returns zero.)doc";
+
+static const char *__doc_mitsuba_Film_band_range =
+R"doc(Return the wavelength range (in nanometers) covered by the bands of the film)doc";
+
 static const char *__doc_mitsuba_Film_bitmap = R"doc(Return a bitmap object storing the developed contents of the film)doc";
 
 static const char *__doc_mitsuba_Film_class = R"doc()doc";
@@ -2289,6 +2784,14 @@ static const char *__doc_mitsuba_Film_crop_offset = R"doc(Return the offset of t
 
 static const char *__doc_mitsuba_Film_crop_size = R"doc(Return the size of the crop window)doc";
 
+static const char *__doc_mitsuba_Film_denoised_bitmap =
+R"doc(Return a bitmap object storing the developed and denoised contents
+of the film
+
+This can be called between the passes of a progressive render to
+obtain a denoised preview (see Denoiser). The default implementation
+throws an exception.)doc";
+
 static const char *__doc_mitsuba_Film_destination_exists = R"doc(Does the destination file already exist?)doc";
 
 static const char *__doc_mitsuba_Film_develop =
@@ -2306,11 +2809,28 @@ image)
 Returns:
     ``True`` upon success)doc";
 
+static const char *__doc_mitsuba_Film_has_color_variance =
+R"doc(Does the film develop the variance of every color channel instead of
+the luminance?
+
+When has_variance() is also set, the image blocks then have the three
+channels ``variance.R``, ``variance.G`` and ``variance.B``, which
+accumulate the squared linear sRGB values of the samples. The default
+implementation returns ``False``.)doc";
+
 static const char *__doc_mitsuba_Film_has_high_quality_edges =
 R"doc(Should regions slightly outside the image plane be sampled to improve
 the quality of the reconstruction at the edges? This only makes sense
 when reconstruction filters other than the box filter are used.)doc";
 
+static const char *__doc_mitsuba_Film_has_variance =
+R"doc(Does the film develop the variance of the pixel estimates?
+
+The sampling integrators then add a ``variance`` channel to the image
+blocks (before the ``sample_count`` channel, if any), in which they
+accumulate the squared luminance of the samples (see also
+has_color_variance()). The default implementation returns ``False``.)doc";
+
 static const char *__doc_mitsuba_Film_m_crop_offset = R"doc()doc";
 
 static const char *__doc_mitsuba_Film_m_crop_size = R"doc()doc";
@@ -2327,6 +2847,15 @@ static const char *__doc_mitsuba_Film_put =
 R"doc(Merge an image block into the film. This methods should be thread-
 safe.)doc";
 
+static const char *__doc_mitsuba_Film_put_2 =
+R"doc(Merge an image block into the film, given its position ``index`` in
+the sequence of blocks produced by the current rendering job
+
+The indices of a job must be unique and contiguous, starting at zero
+after prepare(). Films may use them to accumulate the blocks in a
+fixed order (for instance, to obtain results that don't depend on the
+number of threads). The default implementation ignores the index.)doc";
+
 static const char *__doc_mitsuba_Film_reconstruction_filter = R"doc(Return the image reconstruction filter (const version))doc";
 
 static const char *__doc_mitsuba_Film_set_crop_window = R"doc(Set the size and offset of the crop window.)doc";
@@ -2337,8 +2866,56 @@ static const char *__doc_mitsuba_Film_size =
 R"doc(Ignoring the crop window, return the resolution of the underlying
 sensor)doc";
 
+static const char *__doc_mitsuba_Film_snapshot =
+R"doc(Develop the regions of the film that changed since the last call into a
+list of preview tiles
+
+Each entry holds the offset of a tile relative to the crop window and
+its sRGB-encoded 8 bit RGBA pixels. The first call following
+prepare() returns all regions that received contributions so far.
+Progressive previews can call this function between (or during)
+rendering passes and only upload the returned sub-rectangles. The
+default implementation throws an exception.)doc";
+
+static const char *__doc_mitsuba_Film_splat =
+R"doc(Add a contribution at an arbitrary position of the film
+
+Unlike put(), this is meant for algorithms whose samples land at
+unpredictable positions of the image (e.g. light or particle tracing),
+and may be called concurrently by any number of threads without an
+intermediate image block. The contribution is spread over the
+footprint of the reconstruction filter, whose weights are normalized,
+and is added to the developed image as is, i.e. without dividing it by
+the weights of the samples of put(). Callers must hence scale the
+values by the inverse of the number of samples. The default
+implementation throws an exception.
+
+Parameter ``pos``:
+    Position on the film in pixel coordinates (as for
+    ImageBlock::put())
+
+Parameter ``value``:
+    Spectral contribution of the sample
+
+Parameter ``wavelengths``:
+    Wavelengths of the contribution (ignored in RGB and monochromatic
+    modes))doc";
+
+static const char *__doc_mitsuba_Film_streaming =
+R"doc(Is the film written to disk while the image is being rendered?
+
+Streaming films only keep the rows of the image that may still receive
+contributions in memory, and write the others out as soon as all blocks
+overlapping them have been merged. Integrators must therefore render the
+image in a single pass over blocks issued in scanline order (see
+Spiral), and the film contents cannot be retrieved using bitmap() or
+write_state(). The default implementation returns ``False``.)doc";
+
 static const char *__doc_mitsuba_Film_to_string = R"doc(//! @})doc";
 
+static const char *__doc_mitsuba_Film_variance_channel_count =
+R"doc(Return the number of variance channels of the image blocks (0, 1 or 3))doc";
+
 static const char *__doc_mitsuba_FilterBoundaryCondition =
 R"doc(When resampling data to a different resolution using
 Resampler::resample(), this enumeration specifies how lookups
@@ -2489,6 +3066,14 @@ textures from mitsuba::Bitmap instances.)doc";
 
 static const char *__doc_mitsuba_GPUTexture_GPUTexture = R"doc()doc";
 
+static const char *__doc_mitsuba_GPUTexture_upload_region =
+R"doc(Update the rectangular region of the texture covered by ``bitmap``,
+starting at the pixel ``offset``
+
+The bitmap is converted to the format of the texture if needed. This
+is used to upload the tiles returned by Film::snapshot() during
+progressive rendering.)doc";
+
 static const char *__doc_mitsuba_Hierarchical2D =
 R"doc(Implements a hierarchical sample warping scheme for 2D distributions
 with linear interpolation and an optional dependence on additional
@@ -2697,6 +3282,8 @@ static const char *__doc_mitsuba_ImageBlock_m_data = R"doc()doc";
 
 static const char *__doc_mitsuba_ImageBlock_m_filter = R"doc()doc";
 
+static const char *__doc_mitsuba_ImageBlock_m_memory = R"doc()doc";
+
 static const char *__doc_mitsuba_ImageBlock_m_normalize = R"doc()doc";
 
 static const char *__doc_mitsuba_ImageBlock_m_offset = R"doc()doc";
@@ -2760,6 +3347,14 @@ Returns:
     negative. A warning is also printed if ``m_warn_negative`` or
     ``m_warn_invalid`` is enabled.)doc";
 
+static const char *__doc_mitsuba_ImageBlock_put_footprint =
+R"doc(Splat a sample over a footprint of ``Taps x Taps`` pixels starting at
+``lo`` (clipped to ``hi``)
+
+Specialization of put() for the footprints of the common filters
+(e.g. ``tent`` and ``gaussian`` with their default radii), with the
+loops over the footprint unrolled and the weights kept in registers.)doc";
+
 static const char *__doc_mitsuba_ImageBlock_set_offset =
 R"doc(Set the current block offset.
 
@@ -2817,8 +3412,39 @@ job. In this case, render() will quit with a return value of
 
 static const char *__doc_mitsuba_Integrator_class = R"doc()doc";
 
+static const char *__doc_mitsuba_Integrator_m_thread_pool = R"doc()doc";
+
 static const char *__doc_mitsuba_Integrator_render = R"doc(Perform the main rendering job. Returns ``True`` upon success)doc";
 
+static const char *__doc_mitsuba_Integrator_render_batch =
+R"doc(Render the scene from several sensors
+
+The default implementation calls render() for each sensor in turn.
+Returns ``True`` if all sensors were rendered successfully.)doc";
+
+static const char *__doc_mitsuba_Integrator_run_in_thread_pool =
+R"doc(Run a function in the thread pool of the integrator
+
+Returns ``false`` when there is no thread pool or when the calling
+thread already executes inside of it. Otherwise, ``func`` is run by the
+pool, and the function returns ``true``.)doc";
+
+static const char *__doc_mitsuba_Integrator_set_thread_pool =
+R"doc(Set the thread pool that executes the render jobs
+
+Render jobs started by `render()` and `render_batch()` then only use
+the threads (and cores) of this pool instead of the global scheduler.
+Passing ``nullptr`` restores the default behavior.)doc";
+
+static const char *__doc_mitsuba_Integrator_thread_count = R"doc(Return the number of threads used by render jobs)doc";
+
+static const char *__doc_mitsuba_Integrator_thread_pool =
+R"doc(Return the thread pool that executes the render jobs (if any))doc";
+
+static const char *__doc_mitsuba_Integrator_thread_pool_2 =
+R"doc(Return the thread pool that executes the render jobs (if any, const
+version))doc";
+
 static const char *__doc_mitsuba_Interaction = R"doc(Generic surface interaction data structure)doc";
 
 static const char *__doc_mitsuba_Interaction_Interaction = R"doc()doc";
@@ -2870,6 +3496,14 @@ static const char *__doc_mitsuba_IrregularContinuousDistribution_IrregularContin
 
 static const char *__doc_mitsuba_IrregularContinuousDistribution_IrregularContinuousDistribution_4 = R"doc(Initialize from a given floating point array)doc";
 
+static const char *__doc_mitsuba_IrregularContinuousDistribution_build_alias_table =
+R"doc(Build an alias table (see AliasTable) over the intervals, so that
+sample() and sample_pdf() select them in constant time instead of
+searching the CDF
+
+The table is kept up to date by update(). Note that the samples are
+then no longer mapped to the positions in a monotonic way.)doc";
+
 static const char *__doc_mitsuba_IrregularContinuousDistribution_cdf =
 R"doc(Return the unnormalized discrete cumulative distribution function over
 intervals)doc";
@@ -2880,24 +3514,47 @@ intervals (const version))doc";
 
 static const char *__doc_mitsuba_IrregularContinuousDistribution_empty = R"doc(Is the distribution object empty/uninitialized?)doc";
 
+static const char *__doc_mitsuba_IrregularContinuousDistribution_eval_batch = R"doc(Apply 'func' to packets of the queries stored in 'x')doc";
+
 static const char *__doc_mitsuba_IrregularContinuousDistribution_eval_cdf =
 R"doc(Evaluate the unnormalized cumulative distribution function (CDF) at
 position ``p``)doc";
 
+static const char *__doc_mitsuba_IrregularContinuousDistribution_eval_cdf_batch = R"doc(Batched version of eval_cdf() (see eval_pdf_batch()))doc";
+
 static const char *__doc_mitsuba_IrregularContinuousDistribution_eval_cdf_normalized =
 R"doc(Evaluate the unnormalized cumulative distribution function (CDF) at
 position ``p``)doc";
 
+static const char *__doc_mitsuba_IrregularContinuousDistribution_eval_cdf_normalized_batch =
+R"doc(Batched version of eval_cdf_normalized() (see eval_pdf_batch()))doc";
+
 static const char *__doc_mitsuba_IrregularContinuousDistribution_eval_pdf =
 R"doc(Evaluate the unnormalized probability mass function (PDF) at position
 ``x``)doc";
 
+static const char *__doc_mitsuba_IrregularContinuousDistribution_eval_pdf_batch =
+R"doc(Evaluate the unnormalized probability mass function (PDF) at the
+``count`` positions ``x`` and write the results to ``out``
+
+This is equivalent to calling eval_pdf() for each position, but the
+queries are processed in SIMD packets (also in the scalar variants).)doc";
+
 static const char *__doc_mitsuba_IrregularContinuousDistribution_eval_pdf_normalized =
 R"doc(Evaluate the normalized probability mass function (PDF) at position
 ``x``)doc";
 
+static const char *__doc_mitsuba_IrregularContinuousDistribution_eval_pdf_normalized_batch =
+R"doc(Batched version of eval_pdf_normalized() (see eval_pdf_batch()))doc";
+
+static const char *__doc_mitsuba_IrregularContinuousDistribution_find_interval = R"doc(Find the interval containing the position ``x``)doc";
+
+static const char *__doc_mitsuba_IrregularContinuousDistribution_has_alias_table = R"doc(Was build_alias_table() called?)doc";
+
 static const char *__doc_mitsuba_IrregularContinuousDistribution_integral = R"doc(Return the original integral of PDF entries before normalization)doc";
 
+static const char *__doc_mitsuba_IrregularContinuousDistribution_m_alias = R"doc()doc";
+
 static const char *__doc_mitsuba_IrregularContinuousDistribution_m_cdf = R"doc()doc";
 
 static const char *__doc_mitsuba_IrregularContinuousDistribution_m_integral = R"doc()doc";
@@ -2924,6 +3581,8 @@ static const char *__doc_mitsuba_IrregularContinuousDistribution_pdf_2 =
 R"doc(Return the unnormalized discretized probability density function
 (const version))doc";
 
+static const char *__doc_mitsuba_IrregularContinuousDistribution_range = R"doc(Return the range of the distribution (i.e. of its nodes))doc";
+
 static const char *__doc_mitsuba_IrregularContinuousDistribution_sample =
 R"doc(%Transform a uniformly distributed sample to the stored distribution
 
@@ -2933,6 +3592,29 @@ Parameter ``value``:
 Returns:
     The sampled position.)doc";
 
+static const char *__doc_mitsuba_IrregularContinuousDistribution_sample_batch =
+R"doc(Transform ``count`` uniformly distributed samples to the stored
+distribution
+
+This is equivalent to calling sample_pdf() for each sample, but the
+queries are processed in SIMD packets (also in the scalar variants).
+
+Parameter ``value``:
+    Array containing ``count`` uniformly distributed samples on the
+    interval [0, 1].
+
+Parameter ``out``:
+    Array receiving the sampled positions.
+
+Parameter ``pdf``:
+    Optional array receiving the normalized probability densities of
+    the samples (may be ``nullptr``).)doc";
+
+static const char *__doc_mitsuba_IrregularContinuousDistribution_sample_interval =
+R"doc(Select the interval associated with the sample ``value`` and return
+its index along with the (unnormalized) probability mass that precedes
+the sample within the interval)doc";
+
 static const char *__doc_mitsuba_IrregularContinuousDistribution_sample_pdf =
 R"doc(%Transform a uniformly distributed sample to the stored distribution
 
@@ -2972,6 +3654,10 @@ time. If not, the application is terminated via ``abort()``.)doc";
 
 static const char *__doc_mitsuba_Jit_static_shutdown = R"doc(Release all memory used by JIT-compiled routines)doc";
 
+static const char *__doc_mitsuba_LoadProfiler_total =
+R"doc(Return the total time (in seconds) of the recorded steps of the given
+kind)doc";
+
 static const char *__doc_mitsuba_LogLevel = R"doc(Available Log message types)doc";
 
 static const char *__doc_mitsuba_LogLevel_Debug = R"doc(< Debug message, usually turned off)doc";
@@ -3009,12 +3695,21 @@ static const char *__doc_mitsuba_Logger_clear_appenders = R"doc(Remove all appen
 
 static const char *__doc_mitsuba_Logger_d = R"doc()doc";
 
+static const char *__doc_mitsuba_Logger_dropped_count =
+R"doc(Return the number of messages that were dropped in asynchronous mode)doc";
+
 static const char *__doc_mitsuba_Logger_error_level = R"doc(Return the current error level)doc";
 
+static const char *__doc_mitsuba_Logger_flush =
+R"doc(Wait until all messages logged so far have been passed to the
+appenders (asynchronous mode))doc";
+
 static const char *__doc_mitsuba_Logger_formatter = R"doc(Return the logger's formatter implementation)doc";
 
 static const char *__doc_mitsuba_Logger_formatter_2 = R"doc(Return the logger's formatter implementation (const))doc";
 
+static const char *__doc_mitsuba_Logger_is_async = R"doc(Is the asynchronous mode enabled?)doc";
+
 static const char *__doc_mitsuba_Logger_log =
 R"doc(Process a log message
 
@@ -3067,6 +3762,21 @@ Throws a runtime exception upon failure)doc";
 
 static const char *__doc_mitsuba_Logger_remove_appender = R"doc(Remove an appender from this logger)doc";
 
+static const char *__doc_mitsuba_Logger_set_async =
+R"doc(Enable or disable the asynchronous mode
+
+In asynchronous mode, logging threads never wait for each other or for
+the appenders: every thread pushes its messages into its own bounded
+single-producer queue, which a background thread drains in order to
+invoke the appenders. When the queue of a thread is full, messages
+below the ``Warn`` level are dropped (see dropped_count()), while
+warnings wait until there is space in the queue. Messages of different
+threads may be reordered, and progress messages are still dispatched
+synchronously.
+
+Parameter ``queue_size``:
+    Capacity (in messages) of the queue of every thread)doc";
+
 static const char *__doc_mitsuba_Logger_set_error_level =
 R"doc(Set the error log level (this level and anything above will throw
 exceptions).
@@ -3141,7 +3851,12 @@ unnormalized values.
 If ``enable_sampling`` is set to ``False``, the implementation will
 not construct the cdf needed for sample warping, which saves memory in
 case this functionality is not needed (e.g. if only the interpolation
-in ``eval()`` is used).)doc";
+in ``eval()`` is used).
+
+If ``half_precision`` is set to ``True``, the values are stored as
+half precision floating point numbers, which halves the memory usage
+of the table at the cost of roughly three significant digits. This
+requires ``enable_sampling=false``.)doc";
 
 static const char *__doc_mitsuba_Marginal2D_eval =
 R"doc(Evaluate the density at position ``pos``. The distribution is
@@ -3157,10 +3872,18 @@ static const char *__doc_mitsuba_Marginal2D_invert_segment = R"doc()doc";
 
 static const char *__doc_mitsuba_Marginal2D_lookup = R"doc()doc";
 
+static const char *__doc_mitsuba_Marginal2D_lookup_half = R"doc(Variant of lookup() for values stored in half precision)doc";
+
 static const char *__doc_mitsuba_Marginal2D_m_cond_cdf = R"doc()doc";
 
 static const char *__doc_mitsuba_Marginal2D_m_data = R"doc(Density values)doc";
 
+static const char *__doc_mitsuba_Marginal2D_m_data_half =
+R"doc(Density values stored as pairs of half precision values (see m_half))doc";
+
+static const char *__doc_mitsuba_Marginal2D_m_half =
+R"doc(Are the density values stored in m_data_half instead of m_data?)doc";
+
 static const char *__doc_mitsuba_Marginal2D_m_marg_cdf = R"doc(Marginal and conditional PDFs)doc";
 
 static const char *__doc_mitsuba_Marginal2D_m_normalized = R"doc(Are the probability values normalized?)doc";
@@ -3243,8 +3966,41 @@ The evaluated PDF is spectrally varying. This allows to account for
 the fact that the free-flight distance sampling distribution can
 depend on the wavelength.
 
+Parameter ``ray``:
+    Ray that was passed to sample_interaction()
+
 Returns:
-    This method returns a pair of (Transmittance, PDF).)doc";
+    This method returns a pair of (Transmittance, PDF).
+
+The default implementation assumes that the majorant
+``mi.combined_extinction`` is constant along the ray. Media with a
+spatially varying majorant override it and integrate the majorant of
+each wavelength along the ray.)doc";
+
+static const char *__doc_mitsuba_Medium_eval_transmittance =
+R"doc(Estimate the transmittance along the segment ``[ray.mint, ray.maxt]``
+of a ray
+
+The default implementation uses ratio tracking, i.e. it marches through
+the tentative collisions sampled by sample_interaction() and multiplies
+the estimate by the probability of a null collision at each of them.
+This returns fractional values instead of the binary outcome of delta
+tracking.
+
+Parameter ``ray``:
+    Ray segment, which must not cross a surface
+
+Parameter ``sampler``:
+    Sampler that provides the random numbers of the estimator
+
+Parameter ``channel``:
+    The channel according to which the free-flight distances are
+    sampled. This argument is only used when rendering in RGB modes.
+
+Parameter ``residual``:
+    Use residual ratio tracking if the medium supports it, which tracks
+    only the difference to a control extinction whose transmittance is
+    known analytically.)doc";
 
 static const char *__doc_mitsuba_Medium_get_combined_extinction = R"doc(Returns the medium's majorant used for delta tracking)doc";
 
@@ -3309,12 +4065,68 @@ Parameter ``channel``:
 Returns:
     This method returns a MediumInteraction. The MediumInteraction
     will always be valid, except if the ray missed the Medium's
-    bounding box.)doc";
+    bounding box.
+
+The default implementation uses get_combined_extinction() as a
+constant majorant along the ray. Media with a spatially varying
+majorant override it, in which case ``combined_extinction`` holds the
+majorant at the sampled position.)doc";
 
 static const char *__doc_mitsuba_Medium_to_string = R"doc(Return a human-readable representation of the Medium)doc";
 
 static const char *__doc_mitsuba_Medium_use_emitter_sampling = R"doc(Returns whether this specific medium instance uses emitter sampling)doc";
 
+static const char *__doc_mitsuba_MemoryAccounting =
+R"doc(Registry of the memory used by the different subsystems of Mitsuba
+
+The classes that own large buffers report their allocations to one of
+the counters of MemoryCategory (typically through a MemoryRecord
+member), which track the current and the peak number of bytes. This
+only covers the data itself: the memory of the allocator, of small
+objects and of external libraries (e.g. Embree or OptiX) is not
+included.
+
+All functions are thread-safe.)doc";
+
+static const char *__doc_mitsuba_MemoryAccounting_MemoryAccounting = R"doc()doc";
+
+static const char *__doc_mitsuba_MemoryAccounting_add = R"doc(Account for ``size`` additional bytes in the given category)doc";
+
+static const char *__doc_mitsuba_MemoryAccounting_current =
+R"doc(Return the number of bytes that are currently in use in the given
+category)doc";
+
+static const char *__doc_mitsuba_MemoryAccounting_peak =
+R"doc(Return the largest number of bytes that were in use in the given
+category)doc";
+
+static const char *__doc_mitsuba_MemoryAccounting_print_report = R"doc(Log the table returned by report())doc";
+
+static const char *__doc_mitsuba_MemoryAccounting_remove =
+R"doc(Account for the release of ``size`` bytes in the given category)doc";
+
+static const char *__doc_mitsuba_MemoryAccounting_report =
+R"doc(Return a table with the current and peak usage of all categories)doc";
+
+static const char *__doc_mitsuba_MemoryAccounting_reset_peak =
+R"doc(Reset the peak values of all categories to their current values)doc";
+
+static const char *__doc_mitsuba_MemoryCategory = R"doc(Subsystems whose memory usage is tracked by MemoryAccounting)doc";
+
+static const char *__doc_mitsuba_MemoryCategory_Emitters = R"doc()doc";
+
+static const char *__doc_mitsuba_MemoryCategory_Film = R"doc()doc";
+
+static const char *__doc_mitsuba_MemoryCategory_Geometry = R"doc()doc";
+
+static const char *__doc_mitsuba_MemoryCategory_KDTree = R"doc()doc";
+
+static const char *__doc_mitsuba_MemoryCategory_MemoryCategoryCount = R"doc()doc";
+
+static const char *__doc_mitsuba_MemoryCategory_Textures = R"doc()doc";
+
+static const char *__doc_mitsuba_MemoryCategory_Volumes = R"doc()doc";
+
 static const char *__doc_mitsuba_MemoryMappedFile =
 R"doc(Basic cross-platform abstraction for memory mapped files
 
@@ -3323,18 +4135,49 @@ Remark:
     <tt>MemoryMappedFile(filename, array)<tt>, which creates a new
     file, maps it into memory, and copies the array contents.)doc";
 
+static const char *__doc_mitsuba_MemoryMappedFile_Access = R"doc(Expected access pattern of a mapping, see advise())doc";
+
+static const char *__doc_mitsuba_MemoryMappedFile_Access_Normal = R"doc(No particular pattern: use the default read-ahead of the OS)doc";
+
+static const char *__doc_mitsuba_MemoryMappedFile_Access_Random = R"doc(Random accesses: only load the pages that are touched)doc";
+
+static const char *__doc_mitsuba_MemoryMappedFile_Access_Sequential = R"doc(Sweep from start to end: read ahead aggressively)doc";
+
 static const char *__doc_mitsuba_MemoryMappedFile_MemoryMappedFile = R"doc(Create a new memory-mapped file of the specified size)doc";
 
-static const char *__doc_mitsuba_MemoryMappedFile_MemoryMappedFile_2 = R"doc(Map the specified file into memory)doc";
+static const char *__doc_mitsuba_MemoryMappedFile_MemoryMappedFile_2 =
+R"doc(Map the specified file into memory
+
+Parameter ``populate``:
+    Load the complete file before returning (``MAP_POPULATE``), which
+    avoids taking page faults later on. Only use this when most of the
+    file will be accessed.)doc";
 
 static const char *__doc_mitsuba_MemoryMappedFile_MemoryMappedFile_3 = R"doc(Internal constructor)doc";
 
 static const char *__doc_mitsuba_MemoryMappedFile_MemoryMappedFilePrivate = R"doc()doc";
 
+static const char *__doc_mitsuba_MemoryMappedFile_advise =
+R"doc(Inform the OS about the expected access pattern of the mapping
+
+This only tunes the read-ahead of page faults and never changes the
+contents of the mapping (Linux/OSX only).)doc";
+
 static const char *__doc_mitsuba_MemoryMappedFile_can_write = R"doc(Return whether the mapped memory region can be modified)doc";
 
 static const char *__doc_mitsuba_MemoryMappedFile_class = R"doc()doc";
 
+static const char *__doc_mitsuba_MemoryMappedFile_create_anonymous =
+R"doc(Create an anonymous mapping that is not backed by any file
+
+The memory is zero-initialized and released when the mapping is
+closed. It cannot be resized, and filename() returns an empty path.
+
+Parameter ``huge_pages``:
+    Request transparent huge pages (Linux only), which reduces the
+    number of page faults and TLB misses when sweeping over large
+    temporary buffers.)doc";
+
 static const char *__doc_mitsuba_MemoryMappedFile_create_temporary =
 R"doc(Create a temporary memory-mapped file
 
@@ -3352,6 +4195,22 @@ static const char *__doc_mitsuba_MemoryMappedFile_data_2 = R"doc(Return a pointe
 
 static const char *__doc_mitsuba_MemoryMappedFile_filename = R"doc(Return the associated filename)doc";
 
+static const char *__doc_mitsuba_MemoryMappedFile_map_copy_on_write =
+R"doc(Map a file with copy-on-write semantics
+
+The mapped memory can be modified, but the changes remain private to
+the mapping and are never written back to the file. Pages that were
+not modified are backed by the file, which lets the OS evict them
+under memory pressure and read them again on demand.)doc";
+
+static const char *__doc_mitsuba_MemoryMappedFile_prefetch =
+R"doc(Asynchronously load a range of the mapping into memory
+
+Starts reading the ``size`` bytes at ``offset`` (clamped to the size
+of the mapping) in the background and returns immediately, so that
+later accesses to this range don't stall on I/O. Loaders call this
+for the parts of a file that they will process next.)doc";
+
 static const char *__doc_mitsuba_MemoryMappedFile_resize =
 R"doc(Resize the memory-mapped file
 
@@ -3362,6 +4221,29 @@ static const char *__doc_mitsuba_MemoryMappedFile_size = R"doc(Return the size o
 
 static const char *__doc_mitsuba_MemoryMappedFile_to_string = R"doc(Return a string representation)doc";
 
+static const char *__doc_mitsuba_MemoryRecord =
+R"doc(Helper that accounts for the memory of one object in a category of
+MemoryAccounting
+
+The owner of the buffers calls set() whenever their total size
+changes, and the destructor releases the accounted memory.)doc";
+
+static const char *__doc_mitsuba_MemoryRecord_MemoryRecord = R"doc()doc";
+
+static const char *__doc_mitsuba_MemoryRecord_MemoryRecord_2 = R"doc(Copies start out empty: their owner sets their size)doc";
+
+static const char *__doc_mitsuba_MemoryRecord_MemoryRecord_3 = R"doc()doc";
+
+static const char *__doc_mitsuba_MemoryRecord_m_category = R"doc()doc";
+
+static const char *__doc_mitsuba_MemoryRecord_m_size = R"doc()doc";
+
+static const char *__doc_mitsuba_MemoryRecord_operator_assign = R"doc()doc";
+
+static const char *__doc_mitsuba_MemoryRecord_set = R"doc(Set the number of bytes accounted by this record)doc";
+
+static const char *__doc_mitsuba_MemoryRecord_size = R"doc(Return the number of bytes accounted by this record)doc";
+
 static const char *__doc_mitsuba_MemoryStream =
 R"doc(Simple memory buffer-based stream with automatic memory management. It
 always has read & write capabilities.
@@ -3476,22 +4358,33 @@ static const char *__doc_mitsuba_Mesh_MeshAttributeType_Vertex = R"doc()doc";
 
 static const char *__doc_mitsuba_Mesh_MeshAttribute_buf = R"doc()doc";
 
+static const char *__doc_mitsuba_Mesh_MeshAttribute_half_buf =
+R"doc(Pairs of half precision values that replace ``buf`` once compressed)doc";
+
 static const char *__doc_mitsuba_Mesh_MeshAttribute_size = R"doc()doc";
 
 static const char *__doc_mitsuba_Mesh_MeshAttribute_type = R"doc()doc";
 
 static const char *__doc_mitsuba_Mesh_add_attribute = R"doc(Add an attribute buffer with the given ``name`` and ``dim``)doc";
 
+static const char *__doc_mitsuba_Mesh_attribute =
+R"doc(Look up the attribute ``name`` and check its number of channels)doc";
+
 static const char *__doc_mitsuba_Mesh_attribute_buffer = R"doc(Return the mesh attribute associated with ``name``)doc";
 
 static const char *__doc_mitsuba_Mesh_barycentric_coordinates = R"doc()doc";
 
+static const char *__doc_mitsuba_Mesh_barycentric_coordinates_2 =
+R"doc(Barycentric coordinates within the triangle with the given face indices)doc";
+
 static const char *__doc_mitsuba_Mesh_bbox = R"doc(//! @{ \name Shape interface implementation)doc";
 
 static const char *__doc_mitsuba_Mesh_bbox_2 = R"doc()doc";
 
 static const char *__doc_mitsuba_Mesh_bbox_3 = R"doc()doc";
 
+static const char *__doc_mitsuba_Mesh_bbox_motion = R"doc()doc";
+
 static const char *__doc_mitsuba_Mesh_build_parameterization =
 R"doc(Initialize the ``m_parameterization`` field for mapping UV coordinates
 to positions
@@ -3507,8 +4400,40 @@ since it uses a mutex.)doc";
 
 static const char *__doc_mitsuba_Mesh_class = R"doc()doc";
 
+static const char *__doc_mitsuba_Mesh_compress_vertex_data =
+R"doc(Convert the vertex data into compact encodings
+
+Vertex normals are stored as two 16-bit octahedral coordinates,
+texture coordinates as two 16-bit values relative to the UV range of
+the mesh, and mesh attributes in half precision. This reduces the size
+of these arrays by a factor of three (normals) or two (texture
+coordinates and attributes) at the cost of a small quantization error.
+Meshes with at most 65536 vertices additionally store their face
+indices with 16 bits (except when Embree is used, which requires
+32-bit indices). The accessors such as vertex_normal() and
+face_indices() decode the data transparently, while the corresponding
+raw buffers become empty and are no longer exposed as differentiable
+parameters.
+
+The shape plugins call this function after loading when the
+``compress_vertex_data`` property is set. Compressed meshes cannot be
+exported, and the compression is not supported in GPU variants.)doc";
+
+static const char *__doc_mitsuba_Mesh_compress_vertex_normals =
+R"doc(Octahedral encoding of the vertex normals (see compress_vertex_data()))doc";
+
 static const char *__doc_mitsuba_Mesh_compute_surface_interaction = R"doc()doc";
 
+static const char *__doc_mitsuba_Mesh_decode_octahedral =
+R"doc(Decode a normal stored as two signed 16-bit octahedral coordinates)doc";
+
+static const char *__doc_mitsuba_Mesh_embree_update_geometry =
+R"doc(Update an Embree geometry created by embree_geometry()
+
+Re-binds the (possibly reallocated) vertex and face buffers, so that
+the next commit of the scene refits the geometry when accel_refit() is
+set. Embree rebuilds it when the face count changed.)doc";
+
 static const char *__doc_mitsuba_Mesh_ensure_pmf_built = R"doc()doc";
 
 static const char *__doc_mitsuba_Mesh_eval_attribute = R"doc()doc";
@@ -3517,6 +4442,20 @@ static const char *__doc_mitsuba_Mesh_eval_attribute_1 = R"doc()doc";
 
 static const char *__doc_mitsuba_Mesh_eval_attribute_3 = R"doc()doc";
 
+static const char *__doc_mitsuba_Mesh_eval_attributes =
+R"doc(Shared implementation of eval_attributes_1() and eval_attributes_3())doc";
+
+static const char *__doc_mitsuba_Mesh_eval_attributes_1 =
+R"doc(Evaluate several monochromatic attributes at once
+
+Equivalent to calling eval_attribute_1() for every name, except that the
+face indices and barycentric coordinates of the intersection are only
+computed once. This is useful when a material reads several vertex
+attributes at every hit.)doc";
+
+static const char *__doc_mitsuba_Mesh_eval_attributes_3 =
+R"doc(Trichromatic version of eval_attributes_1() (see eval_attribute_3()))doc";
+
 static const char *__doc_mitsuba_Mesh_eval_parameterization = R"doc()doc";
 
 static const char *__doc_mitsuba_Mesh_face_area = R"doc(Returns the surface area of the face with index ``index``)doc";
@@ -3531,11 +4470,30 @@ static const char *__doc_mitsuba_Mesh_faces_buffer = R"doc(Return face indices b
 
 static const char *__doc_mitsuba_Mesh_faces_buffer_2 = R"doc(Const variant of faces_buffer.)doc";
 
+static const char *__doc_mitsuba_Mesh_fetch_attribute =
+R"doc(Fetch the stored value of an attribute with ``Size`` channels)doc";
+
+static const char *__doc_mitsuba_Mesh_has_compressed_vertex_data =
+R"doc(Is any of the vertex or face data stored in compressed form? (see
+compress_vertex_data()))doc";
+
+static const char *__doc_mitsuba_Mesh_has_motion = R"doc()doc";
+
+static const char *__doc_mitsuba_Mesh_has_vertex_motion = R"doc(Do the vertices of this mesh move? (see set_vertex_motion()))doc";
+
 static const char *__doc_mitsuba_Mesh_has_vertex_normals = R"doc(Does this mesh have per-vertex normals?)doc";
 
 static const char *__doc_mitsuba_Mesh_has_vertex_texcoords = R"doc(Does this mesh have per-vertex texture coordinates?)doc";
 
-static const char *__doc_mitsuba_Mesh_interpolate_attribute = R"doc()doc";
+static const char *__doc_mitsuba_Mesh_interpolate_attribute =
+R"doc(Interpolate an attribute with ``Size`` channels
+
+The face indices ``fi`` and barycentric coordinates ``b`` of the
+intersection are passed in, so that several attributes can be evaluated
+without fetching the triangle again (they are only used for vertex
+attributes).)doc";
+
+static const char *__doc_mitsuba_Mesh_interpolate_attribute_2 = R"doc()doc";
 
 static const char *__doc_mitsuba_Mesh_m_area_pmf = R"doc()doc";
 
@@ -3549,6 +4507,8 @@ static const char *__doc_mitsuba_Mesh_m_face_count = R"doc()doc";
 
 static const char *__doc_mitsuba_Mesh_m_faces_buf = R"doc()doc";
 
+static const char *__doc_mitsuba_Mesh_m_memory = R"doc()doc";
+
 static const char *__doc_mitsuba_Mesh_m_mesh_attributes = R"doc()doc";
 
 static const char *__doc_mitsuba_Mesh_m_mutex = R"doc()doc";
@@ -3565,6 +4525,11 @@ static const char *__doc_mitsuba_Mesh_m_vertex_positions_buf = R"doc()doc";
 
 static const char *__doc_mitsuba_Mesh_m_vertex_texcoords_buf = R"doc()doc";
 
+static const char *__doc_mitsuba_Mesh_motion_time_range = R"doc()doc";
+
+static const char *__doc_mitsuba_Mesh_normal_cone =
+R"doc(Return a cone that bounds the normals of the faces of the mesh)doc";
+
 static const char *__doc_mitsuba_Mesh_parameters_changed = R"doc()doc";
 
 static const char *__doc_mitsuba_Mesh_parameters_grad_enabled = R"doc()doc";
@@ -3598,12 +4563,50 @@ static const char *__doc_mitsuba_Mesh_recompute_vertex_normals = R"doc(Compute s
 
 static const char *__doc_mitsuba_Mesh_sample_position = R"doc()doc";
 
+static const char *__doc_mitsuba_Mesh_set_children =
+R"doc(Register this mesh as the parent of its sub-objects (see
+Shape::set_children())
+
+The mesh plugins invoke this function once all buffers have been
+loaded, which also accounts for their memory in MemoryAccounting.)doc";
+
+static const char *__doc_mitsuba_Mesh_set_vertex_motion =
+R"doc(Enable linear vertex motion between two keyframes
+
+The vertex positions buffer holds the positions at ``time_start``, and
+a second buffer (see vertex_positions_end_buffer()) holds those at
+``time_end``. The latter is initialized with the current positions
+when the motion is first enabled. Intersections interpolate both using
+the time of the ray, and the mesh is at rest outside of the interval.
+Call recompute_bbox() after updating the buffer.)doc";
+
+static const char *__doc_mitsuba_Mesh_sort_spatially =
+R"doc(Reorder the faces and vertices of the mesh by their position
+
+The faces are sorted along a Morton curve through their centroids, and
+the vertices are renumbered in the order in which the sorted faces first
+reference them. Triangles that are close in space then also lie close
+in memory, which makes the accesses of the acceleration data structure
+more coherent. This matters most for meshes that are exported via
+write_mtsmesh() and later memory-mapped by the ``mtsmesh`` plugin,
+where every access to a new region of the file may require a disk read.
+
+The shape plugins call this function after loading when the
+``sort_spatially`` property is set, before compressing the vertex data.
+The mesh must not be part of a scene yet, since acceleration data
+structures refer to faces by their index. Meshes with compressed vertex
+data cannot be reordered, and the function is not supported in GPU
+variants.)doc";
+
 static const char *__doc_mitsuba_Mesh_surface_area = R"doc()doc";
 
 static const char *__doc_mitsuba_Mesh_to_string = R"doc(Return a human-readable string representation of the shape contents.)doc";
 
 static const char *__doc_mitsuba_Mesh_traverse = R"doc(@})doc";
 
+static const char *__doc_mitsuba_Mesh_update_memory_record =
+R"doc(Update the memory accounted for the vertex, face and attribute buffers)doc";
+
 static const char *__doc_mitsuba_Mesh_vertex_count = R"doc(Return the total number of vertices)doc";
 
 static const char *__doc_mitsuba_Mesh_vertex_data_bytes = R"doc()doc";
@@ -3616,18 +4619,43 @@ static const char *__doc_mitsuba_Mesh_vertex_normals_buffer_2 = R"doc(Const vari
 
 static const char *__doc_mitsuba_Mesh_vertex_position = R"doc(Returns the world-space position of the vertex with index ``index``)doc";
 
+static const char *__doc_mitsuba_Mesh_vertex_position_at =
+R"doc(Returns the world-space position of the vertex with index ``index``
+at the given time (see set_vertex_motion()))doc";
+
 static const char *__doc_mitsuba_Mesh_vertex_positions_buffer = R"doc(Return vertex positions buffer)doc";
 
 static const char *__doc_mitsuba_Mesh_vertex_positions_buffer_2 = R"doc(Const variant of vertex_positions_buffer.)doc";
 
+static const char *__doc_mitsuba_Mesh_vertex_positions_end_buffer =
+R"doc(Return the buffer of the vertex positions at the end of the motion
+(see set_vertex_motion()))doc";
+
+static const char *__doc_mitsuba_Mesh_vertex_positions_end_buffer_2 = R"doc(Const variant of vertex_positions_end_buffer.)doc";
+
 static const char *__doc_mitsuba_Mesh_vertex_texcoord = R"doc(Returns the UV texture coordinates of the vertex with index ``index``)doc";
 
 static const char *__doc_mitsuba_Mesh_vertex_texcoords_buffer = R"doc(Return vertex texcoords buffer)doc";
 
 static const char *__doc_mitsuba_Mesh_vertex_texcoords_buffer_2 = R"doc(Const variant of vertex_texcoords_buffer.)doc";
 
+static const char *__doc_mitsuba_Mesh_write_mtsmesh =
+R"doc(Export mesh as a ``.mtsmesh`` cache file
+
+Besides the vertex and face data, the file stores the bounding box and
+the area PMF used for position sampling, so that the ``mtsmesh``
+plugin can load the mesh without any computation. Vertex motion (see
+set_vertex_motion()) is not stored.)doc";
+
 static const char *__doc_mitsuba_Mesh_write_ply = R"doc(Export mesh as a binary PLY file)doc";
 
+static const char *__doc_mitsuba_Mesh_write_ply_async =
+R"doc(Equivalent to write_ply(), but executes asynchronously on a different
+thread
+
+The mesh must not be modified until the file has been written. Errors
+are reported as warnings.)doc";
+
 static const char *__doc_mitsuba_MicrofacetDistribution =
 R"doc(Implementation of the Beckman and GGX / Trowbridge-Reitz microfacet
 distributions and various useful sampling routines
@@ -3651,7 +4679,17 @@ Distribution" by Wenzel Jakob
 
 An improvement of the GGX model sampling routine is discussed in "A
 Simpler and Exact Sampling Routine for the GGX Distribution of Visible
-Normals" by Eric Heitz)doc";
+Normals" by Eric Heitz
+
+With <tt>tabulated_sampling</tt> enabled, the numerical inversion of
+the Beckmann visible normal sampling routine is replaced by a lookup
+into a precomputed table (detail::beckmann_visible_table()), which is
+shared by all roughness values since the routine operates on the
+stretched alpha=1 configuration. Sampled normals differ from the
+analytic ones by a relative error that is typically well below 0.1%,
+while the densities returned by pdf() and sample() remain exact. The
+table is unavailable in GPU variants, where this option has no
+effect.)doc";
 
 static const char *__doc_mitsuba_MicrofacetDistribution_G = R"doc(Smith's separable shadowing-masking approximation)doc";
 
@@ -3696,6 +4734,8 @@ static const char *__doc_mitsuba_MicrofacetDistribution_is_anisotropic = R"doc(I
 
 static const char *__doc_mitsuba_MicrofacetDistribution_is_isotropic = R"doc(Is this an isotropic microfacet distribution?)doc";
 
+static const char *__doc_mitsuba_MicrofacetDistribution_lookup_beckmann_visible = R"doc(Bilinearly interpolate detail::beckmann_visible_table())doc";
+
 static const char *__doc_mitsuba_MicrofacetDistribution_m_alpha_u = R"doc()doc";
 
 static const char *__doc_mitsuba_MicrofacetDistribution_m_alpha_v = R"doc()doc";
@@ -3741,6 +4781,9 @@ Parameter ``v``:
 Parameter ``m``:
     The microfacet normal)doc";
 
+static const char *__doc_mitsuba_MicrofacetDistribution_tabulated_sampling =
+R"doc(Return whether visible normals are sampled using a precomputed table)doc";
+
 static const char *__doc_mitsuba_MicrofacetDistribution_type = R"doc(Return the distribution type)doc";
 
 static const char *__doc_mitsuba_MicrofacetType = R"doc(Supported normal distribution functions)doc";
@@ -4282,6 +5325,8 @@ static const char *__doc_mitsuba_ProfilerPhase_RayTest = R"doc()doc";
 
 static const char *__doc_mitsuba_ProfilerPhase_Render = R"doc()doc";
 
+static const char *__doc_mitsuba_ProfilerPhase_RenderBlock = R"doc()doc";
+
 static const char *__doc_mitsuba_ProfilerPhase_SampleEmitterDirection = R"doc()doc";
 
 static const char *__doc_mitsuba_ProfilerPhase_SampleEmitterRay = R"doc()doc";
@@ -4292,16 +5337,86 @@ static const char *__doc_mitsuba_ProfilerPhase_TextureEvaluate = R"doc()doc";
 
 static const char *__doc_mitsuba_ProfilerPhase_TextureSample = R"doc()doc";
 
+static const char *__doc_mitsuba_ProfilerTag = R"doc(Innermost object-specific phase of a thread)doc";
+
+static const char *__doc_mitsuba_ProfilerTag_object = R"doc()doc";
+
+static const char *__doc_mitsuba_ProfilerTag_phase = R"doc()doc";
+
 static const char *__doc_mitsuba_Profiler_Profiler = R"doc()doc";
 
 static const char *__doc_mitsuba_Profiler_class = R"doc()doc";
 
+static const char *__doc_mitsuba_Profiler_flat_profile =
+R"doc(Return the share of the samples of every phase, counting each sample
+for the innermost phase of its thread (as in the flat profile of
+``print_report()``), sorted by decreasing share)doc";
+
+static const char *__doc_mitsuba_Profiler_hardware_counters = R"doc(Are the hardware performance counters being sampled?)doc";
+
+static const char *__doc_mitsuba_Profiler_object_attribution = R"doc(Are the samples attributed to objects?)doc";
+
 static const char *__doc_mitsuba_Profiler_print_report = R"doc()doc";
 
+static const char *__doc_mitsuba_Profiler_register_object =
+R"doc(Register the name of an object for the report of
+set_object_attribution() (no-op when it is disabled)
+
+This is done by the plugin manager for all the objects it creates.)doc";
+
+static const char *__doc_mitsuba_Profiler_set_hardware_counters =
+R"doc(Enable or disable the sampling of hardware performance counters
+(Linux only)
+
+Every time the profiler samples the phases of a thread, it also reads
+the CPU cycle, instruction, last-level cache miss and branch miss
+counters of the thread using ``perf_event_open()``, and attributes the
+events since the previous sample to the current phases. print_report()
+then shows the instructions per cycle and the miss rates of every
+phase, which e.g. tells apart memory-bound phases.
+
+Depending on ``/proc/sys/kernel/perf_event_paranoid``, the counters may
+not be accessible to unprivileged users.)doc";
+
+static const char *__doc_mitsuba_Profiler_set_object_attribution =
+R"doc(Enable or disable the attribution of the samples to objects
+
+The phases entered with MTS_MASKED_FUNCTION are then tagged with the
+plugin instance that runs them, which tells apart e.g. the evaluation
+cost of the individual BSDFs of a scene. The samples are attributed to
+the innermost tagged phase (a texture evaluated by a BSDF counts for
+the texture), and print_report() lists the ``top_count`` objects with
+the most samples.
+
+Objects are identified by the name registered with register_object()
+when they were created.)doc";
+
+static const char *__doc_mitsuba_Profiler_set_timeline =
+R"doc(Enable or disable the recording of a timeline
+
+In addition to the sampled profile, the profiler then records the
+beginning and the end of every phase on every thread, which reveals
+e.g. the load imbalance between the image blocks of a rendering. The
+phases are stored in a ring buffer per thread, which retains the most
+recent ``capacity`` phases: the fine-grained phases (ray intersections,
+BSDF evaluations, ..) of a long rendering quickly fill it up.
+
+Enabling the timeline discards the phases recorded so far, and should
+not be done while other threads are recording phases.)doc";
+
 static const char *__doc_mitsuba_Profiler_static_initialization = R"doc()doc";
 
 static const char *__doc_mitsuba_Profiler_static_shutdown = R"doc()doc";
 
+static const char *__doc_mitsuba_Profiler_timeline = R"doc(Is the timeline being recorded?)doc";
+
+static const char *__doc_mitsuba_Profiler_write_timeline =
+R"doc(Write the recorded timeline to a file in the JSON trace event format,
+which can be opened with ``chrome://tracing`` or Perfetto
+
+This function should not be called while other threads are recording
+phases.)doc";
+
 static const char *__doc_mitsuba_ProgressReporter =
 R"doc(General-purpose progress reporter
 
@@ -4398,7 +5513,13 @@ myProps["spectrumProperty"] = mitsuba.core.Spectrum(1.0)
 
 static const char *__doc_mitsuba_Properties_Properties = R"doc(Construct an empty property container)doc";
 
-static const char *__doc_mitsuba_Properties_Properties_2 = R"doc(Construct an empty property container with a specific plugin name)doc";
+static const char *__doc_mitsuba_Properties_Properties_2 =
+R"doc(Construct an empty property container with a specific plugin name
+
+When ``arena`` is specified, the entries are stored in this
+MemoryArena, which must outlive the container. Copies of the container
+(including those made by the copy constructor below) always store
+their entries on the heap.)doc";
 
 static const char *__doc_mitsuba_Properties_Properties_3 = R"doc(Copy constructor)doc";
 
@@ -4462,6 +5583,11 @@ rename it)doc";
 
 static const char *__doc_mitsuba_Properties_d = R"doc()doc";
 
+static const char *__doc_mitsuba_Properties_differing_properties =
+R"doc(Return the names of the properties whose values differ from those in
+``props``, including the properties that only exist in one of the two
+records (does not mark any property as queried))doc";
+
 static const char *__doc_mitsuba_Properties_find_object = R"doc()doc";
 
 static const char *__doc_mitsuba_Properties_float = R"doc(Retrieve a floating point value)doc";
@@ -4842,6 +5968,22 @@ static const char *__doc_mitsuba_ReconstructionFilter_m_values = R"doc()doc";
 
 static const char *__doc_mitsuba_ReconstructionFilter_radius = R"doc(Return the filter's width)doc";
 
+static const char *__doc_mitsuba_ReconstructionFilter_sample =
+R"doc(Importance sample the discretized filter
+
+Maps a uniform sample ``u`` to an offset from the center of the filter
+that is distributed proportionally to the magnitude of
+eval_discretized(). Rendering with such offsets lets every sample
+contribute to a single pixel (see the ``filter_importance_sampling``
+parameter of the integrators).
+
+Returns:
+    The offset and the weight of the sample. The weight is 1 for
+    nonnegative filters, and is negative for offsets within the
+    negative lobes of the others (e.g. ``lanczos``). In both cases, the
+    expected weight of the samples matches the integral of the filter,
+    up to normalization.)doc";
+
 static const char *__doc_mitsuba_Resampler =
 R"doc(Utility class for efficiently resampling discrete datasets to
 different resolutions
@@ -5002,6 +6144,13 @@ static const char *__doc_mitsuba_Sampler_compute_per_sequence_seed =
 R"doc(Generates a array of seeds where the seed values are unique per
 sequence)doc";
 
+static const char *__doc_mitsuba_Sampler_compute_per_sequence_seed_2 =
+R"doc(Variant of compute_per_sequence_seed() for a given offset of the
+lanes within the full wavefront (see seed_chunk())
+
+This is used by samplers that recompute the seeds on the fly instead
+of storing them when the sampler is seeded.)doc";
+
 static const char *__doc_mitsuba_Sampler_current_sample_index = R"doc(Return the index of the current sample)doc";
 
 static const char *__doc_mitsuba_Sampler_m_base_seed = R"doc(Base seed value)doc";
@@ -5014,12 +6163,24 @@ static const char *__doc_mitsuba_Sampler_m_sample_index = R"doc(Index of the cur
 
 static const char *__doc_mitsuba_Sampler_m_samples_per_wavefront = R"doc(Number of samples per pass in wavefront modes (default is 1))doc";
 
+static const char *__doc_mitsuba_Sampler_m_wavefront_offset =
+R"doc(Index of the first lane within the full wavefront (see seed_chunk()))doc";
+
 static const char *__doc_mitsuba_Sampler_m_wavefront_size = R"doc(Size of the wavefront (or 0, if not seeded))doc";
 
 static const char *__doc_mitsuba_Sampler_next_1d = R"doc(Retrieve the next component value from the current sample)doc";
 
 static const char *__doc_mitsuba_Sampler_next_2d = R"doc(Retrieve the next two component values from the current sample)doc";
 
+static const char *__doc_mitsuba_Sampler_next_nd =
+R"doc(Retrieve the next ``count`` component values from the current sample
+and write them into ``values``
+
+The result is equivalent to ``count / 2`` consecutive calls to
+next_2d(), followed by a call to next_1d() when ``count`` is odd.
+Implementations can override this function to generate all values at
+once, which avoids one virtual call per dimension.)doc";
+
 static const char *__doc_mitsuba_Sampler_sample_count = R"doc(Return the number of samples per pixel)doc";
 
 static const char *__doc_mitsuba_Sampler_seed =
@@ -5029,8 +6190,25 @@ In the context of wavefront ray tracing & dynamic arrays, this
 function must be called with ``wavefront_size`` matching the size of
 the wavefront.)doc";
 
+static const char *__doc_mitsuba_Sampler_seed_chunk =
+R"doc(Seed the sampler for a chunk of a larger wavefront
+
+The ``wavefront_size`` lanes of the sampler then produce the same
+samples as the lanes ``[offset, offset + wavefront_size)`` after a
+call to ``seed(seed_offset, n)`` with a larger ``n``. This is used to
+split up wavefronts that would not fit into memory. The ``offset``
+must be a multiple of the number of samples per wavefront.)doc";
+
 static const char *__doc_mitsuba_Sampler_seeded = R"doc(Return whether the sampler was seeded)doc";
 
+static const char *__doc_mitsuba_Sampler_set_pixel =
+R"doc(Inform the sampler about the pixel of the current sample
+
+The rendering algorithm calls this function after seed() and before
+generating the samples of a pixel (or of a packet of pixels). Samplers
+that distribute their error in screen space use it to correlate the
+samples of neighboring pixels; the default implementation ignores it.)doc";
+
 static const char *__doc_mitsuba_Sampler_set_samples_per_wavefront = R"doc(Set the number of samples per pass in wavefront modes (default is 1))doc";
 
 static const char *__doc_mitsuba_Sampler_wavefront_size = R"doc(Return the size of the wavefront (or 0, if not seeded))doc";
@@ -5056,16 +6234,78 @@ R"doc(For integrators that return one or more arbitrary output variables
 (AOVs), this function specifies a list of associated channel names.
 The default implementation simply returns an empty vector.)doc";
 
+static const char *__doc_mitsuba_SamplingIntegrator_block_filter =
+R"doc(Return the reconstruction filter of the image blocks rendered for
+``film``
+
+This is the filter of the film, or a box filter without block borders
+when the samples importance sample the filter of the film (see
+m_filter_importance_sampling).)doc";
+
+static const char *__doc_mitsuba_SamplingIntegrator_blocks_done =
+R"doc(Return the number of image blocks completed by the current (or last)
+call to ``render()``
+
+The counters are updated without locking and may be polled from
+another thread while rendering, e.g. to display live throughput
+figures together with ``render_time()``.)doc";
+
 static const char *__doc_mitsuba_SamplingIntegrator_cancel = R"doc()doc";
 
 static const char *__doc_mitsuba_SamplingIntegrator_class = R"doc()doc";
 
+static const char *__doc_mitsuba_SamplingIntegrator_eval_bands =
+R"doc(Write the wavelength bands of a sample into the band channels of
+``aovs`` (if the film records any, see Film::band_count())
+
+Parameter ``value``:
+    The spectral radiance of the sample divided by the PDF of its
+    wavelengths)doc";
+
+static const char *__doc_mitsuba_SamplingIntegrator_eval_sample =
+R"doc(Evaluate a camera sample of the pixel ``pos`` and write its
+``channel_count`` channels into ``aovs``
+
+This is render_sample() without splatting the sample into an image
+block and advancing the sampler.
+
+Returns:
+    The position at which the sample is splatted and the weight of the
+    sample (see sample_filter()))doc";
+
+static const char *__doc_mitsuba_SamplingIntegrator_eval_variance =
+R"doc(Write the squared luminance (or colors) of a sample with the given XYZ
+value into the variance channels of ``aovs`` (if the film develops the
+variance, see Film::has_variance()))doc";
+
 static const char *__doc_mitsuba_SamplingIntegrator_m_block_size = R"doc(Size of (square) image blocks to render per core.)doc";
 
+static const char *__doc_mitsuba_SamplingIntegrator_m_blocks_done = R"doc(Number of image blocks completed so far (see ``blocks_done()``))doc";
+
+static const char *__doc_mitsuba_SamplingIntegrator_m_filter_importance_sampling =
+R"doc(Importance sample the reconstruction filter of the film when choosing
+the position of the camera rays?
+
+Every sample then contributes to the pixel it was drawn for only (with
+a weight of 1 for nonnegative filters), which removes the block borders
+and the overlapping writes of the filter footprint.)doc";
+
 static const char *__doc_mitsuba_SamplingIntegrator_m_hide_emitters = R"doc(Flag for disabling direct visibility of emitters)doc";
 
+static const char *__doc_mitsuba_SamplingIntegrator_m_pass_times =
+R"doc(Duration of the passes of the last rendering (see ``pass_times()``))doc";
+
+static const char *__doc_mitsuba_SamplingIntegrator_m_render_time_aov =
+R"doc(Append a channel recording the time spent rendering each pixel (in
+microseconds)?
+
+The time is measured per call of ``render_sample()`` (and per block in
+wavefront mode), and divided evenly among the lanes of a packet.)doc";
+
 static const char *__doc_mitsuba_SamplingIntegrator_m_render_timer = R"doc(Timer used to enforce the timeout.)doc";
 
+static const char *__doc_mitsuba_SamplingIntegrator_m_samples_done = R"doc(Number of samples completed so far (see ``samples_done()``))doc";
+
 static const char *__doc_mitsuba_SamplingIntegrator_m_samples_per_pass =
 R"doc(Number of samples to compute for each pass over the image blocks.
 
@@ -5079,12 +6319,76 @@ R"doc(Maximum amount of time to spend rendering (excluding scene parsing).
 
 Specified in seconds. A negative values indicates no timeout.)doc";
 
+static const char *__doc_mitsuba_SamplingIntegrator_pass_times =
+R"doc(Return the duration (in seconds) of every pass rendered by the last
+call to ``render()``
+
+When several passes are rendered in a single job, the blocks of
+consecutive passes overlap: a pass then counts as completed once as
+many blocks as it contains are done. GPU variants render all passes in
+one kernel and report a single duration.)doc";
+
 static const char *__doc_mitsuba_SamplingIntegrator_render = R"doc(//! @{ \name Integrator interface implementation)doc";
 
+static const char *__doc_mitsuba_SamplingIntegrator_render_batch =
+R"doc(Render the scene from several sensors in a single parallel job
+
+The image blocks of all sensors are interleaved and processed by the
+same set of threads, which avoids the ramp-up and tail of separate
+render() calls. Each film is prepared and filled independently.
+Sampler seeds only depend on the block index, hence each film matches
+the result of render() with the same block size.
+
+Falls back to rendering the sensors one after the other when adaptive
+sampling, the "tuned" block scheduler or checkpoints are enabled, and
+on the GPU.)doc";
+
 static const char *__doc_mitsuba_SamplingIntegrator_render_block = R"doc()doc";
 
+static const char *__doc_mitsuba_SamplingIntegrator_render_coarse_block =
+R"doc(Render a coarse level of render_preview() into an image block
+
+Traces one ray through the central pixel of every square of ``stride``
+pixels of the block, and replicates the result over the square. The
+block must use a box filter without border.)doc";
+
+static const char *__doc_mitsuba_SamplingIntegrator_render_preview =
+R"doc(Render an interactive preview that is progressively refined until
+cancel() is called or the sampler's sample count is reached
+
+The film is first filled with one sample per square of
+``preview_stride`` pixels, then with the stride halved until it
+reaches 2 (CPU variants). These coarse levels enter the film with a
+negligible weight, so that the first full resolution pass of one
+sample per pixel replaces them. Further passes of one sample per pixel
+are accumulated afterwards. The ``update`` callback is invoked from
+the rendering thread after each level and pass with the current stride
+(1 at full resolution) and the completed number of samples per pixel,
+e.g. to upload Film::snapshot() tiles to the screen.
+
+The blocks are small and every pixel checks should_stop(), so that a
+canceled preview returns quickly, after which the caller can update
+the camera or scene parameters and restart it on the same scene
+(reusing its acceleration data structure). Checkpoints, adaptive
+sampling and the block schedulers are not used by this mode.)doc";
+
 static const char *__doc_mitsuba_SamplingIntegrator_render_sample = R"doc()doc";
 
+static const char *__doc_mitsuba_SamplingIntegrator_render_single_pixel =
+R"doc(Render a film of a single pixel (e.g. of a radiance meter)
+
+The ``sample_count`` samples are split into chunks that are rendered in
+parallel, and the sum of their channels is committed to the film at
+once, without the block traversal and image blocks of render(). Every
+chunk counts as a block in blocks_done().)doc";
+
+static const char *__doc_mitsuba_SamplingIntegrator_render_time =
+R"doc(Return the time (in seconds) elapsed since the rendering phase started)doc";
+
+static const char *__doc_mitsuba_SamplingIntegrator_render_time_channel =
+R"doc(Return the index of the "render_time" channel in the
+``channel_count`` channels of ``film``)doc";
+
 static const char *__doc_mitsuba_SamplingIntegrator_sample =
 R"doc(Sample the incident radiance along a ray.
 
@@ -5126,6 +6430,52 @@ Remark:
     mask, aov) = integrator.sample(scene, sampler, ray, medium,
     active) ``)doc";
 
+static const char *__doc_mitsuba_SamplingIntegrator_sample_adjoint =
+R"doc(Propagate the adjoint radiance of a set of paths to the scene
+parameters by replaying them (differentiable variants only)
+
+This is an alternative to reverse-mode differentiation of sample(),
+which records the computation graph of all path vertices and thus
+requires memory proportional to the path length. Instead,
+implementations retrace the paths of a previous call to sample() and
+backpropagate the contribution of every vertex right away, which
+requires the primal radiance as an input but keeps the memory
+footprint independent of the path length.
+
+Parameter ``sampler``:
+    Sample generator, which must produce the same sequence of samples
+    as in the call to sample() that computed ``radiance`` (i.e. it
+    should be re-seeded in the same way)
+
+Parameter ``radiance``:
+    Detached output of the corresponding call to sample()
+
+Parameter ``adjoint``:
+    Derivative of the objective function with respect to ``radiance``
+
+The gradients are accumulated in the parameters that require them.)doc";
+
+static const char *__doc_mitsuba_SamplingIntegrator_sample_with_interaction =
+R"doc(Sample the incident radiance along a ray whose first surface
+interaction is already known
+
+Integrators that combine the results of other integrators (e.g.
+``aov``) intersect the camera ray once and pass the interaction to all
+of them using this function, instead of tracing it again in every call
+to sample().
+
+Parameter ``si``:
+    The result of <tt>scene->ray_intersect(ray, active)</tt>
+
+The other parameters and the return value are the same as in sample().
+The default implementation ignores ``si`` and calls sample(), which is
+the only valid choice for integrators whose first event may be a medium
+interaction.)doc";
+
+static const char *__doc_mitsuba_SamplingIntegrator_samples_done =
+R"doc(Return the number of samples completed by the current (or last) call
+to ``render()``)doc";
+
 static const char *__doc_mitsuba_SamplingIntegrator_should_stop =
 R"doc(Indicates whether cancel() or a timeout have occured. Should be
 checked regularly in the integrator's main loop so that timeouts are
@@ -5148,8 +6498,16 @@ static const char *__doc_mitsuba_Scene_accel_init_cpu = R"doc(Create the ray-int
 
 static const char *__doc_mitsuba_Scene_accel_init_gpu = R"doc()doc";
 
+static const char *__doc_mitsuba_Scene_accel_name =
+R"doc(Return the name of the ray intersection acceleration data structure
+("kdtree", "bvh", "embree" or "optix"))doc";
+
 static const char *__doc_mitsuba_Scene_accel_parameters_changed_gpu = R"doc(Updates the ray-intersection acceleration data structure)doc";
 
+static const char *__doc_mitsuba_Scene_accel_refit_only =
+R"doc(Are all the given shapes meshes that requested refitting? (see
+Shape::accel_refit()))doc";
+
 static const char *__doc_mitsuba_Scene_accel_release_cpu = R"doc(Release the ray-intersection acceleration data structure)doc";
 
 static const char *__doc_mitsuba_Scene_accel_release_gpu = R"doc()doc";
@@ -5164,6 +6522,15 @@ static const char *__doc_mitsuba_Scene_emitters_2 = R"doc(Return the list of emi
 
 static const char *__doc_mitsuba_Scene_environment = R"doc(Return the environment emitter (if any))doc";
 
+static const char *__doc_mitsuba_Scene_has_polarizing_bsdfs =
+R"doc(Does the scene contain BSDFs that change the polarization state
+of light?
+
+Always ``False`` in unpolarized variants. When no such BSDF is
+present, all Mueller matrices arising during rendering are
+depolarizers, and the integrators only need to track their first
+entry (see BSDFFlags::Polarizing).)doc";
+
 static const char *__doc_mitsuba_Scene_integrator = R"doc(Return the scene's integrator)doc";
 
 static const char *__doc_mitsuba_Scene_integrator_2 = R"doc(Return the scene's integrator)doc";
@@ -5216,6 +6583,38 @@ Returns:
 
 static const char *__doc_mitsuba_Scene_ray_intersect_2 = R"doc()doc";
 
+static const char *__doc_mitsuba_Scene_ray_intersect_and_test =
+R"doc(Intersect a ray and test a shadow ray against the scene at once
+
+This is equivalent to calling ray_intersect() and ray_test(), but the
+GPU variants trace both sets of rays with a single OptiX launch, which
+halves the number of launches of integrators that trace the
+continuation ray and the shadow ray of each bounce. The two rays may
+have a different number of lanes.
+
+Returns:
+    The surface interaction of ``ray`` and whether ``shadow_ray`` is
+    occluded)doc";
+
+static const char *__doc_mitsuba_Scene_ray_intersect_batch =
+R"doc(Intersect a large buffer of rays against the scene
+
+Unlike ray_intersect_preliminary(), which traces the rays of a packet
+as they come, this function may reorder the rays (see sort_rays()) so
+that each packet dispatched to the acceleration data structure
+contains rays with similar origins and directions. The intersections
+are returned in the original order of ``rays``.
+
+Parameter ``rays``:
+    Buffer of rays (stored as dynamic arrays)
+
+Parameter ``sort``:
+    Should the rays be sorted before being packed into packets?
+
+Remark:
+    Only supported by CPU packet and GPU variants. The GPU variants
+    trace all rays at once and ignore ``sort``.)doc";
+
 static const char *__doc_mitsuba_Scene_ray_intersect_cpu = R"doc(Trace a ray)doc";
 
 static const char *__doc_mitsuba_Scene_ray_intersect_gpu = R"doc()doc";
@@ -5253,6 +6652,15 @@ Returns:
 
 static const char *__doc_mitsuba_Scene_ray_test_cpu = R"doc(Trace a shadow ray)doc";
 
+static const char *__doc_mitsuba_Scene_ray_test_emitter_directions =
+R"doc(Trace the shadow rays of emitter samples drawn by
+sample_emitter_directions() without visibility test
+
+The entries of ``values`` whose shadow ray is occluded are set to
+zero. Entries that are already zero are not traced, hence integrators
+can first multiply ``values`` by the BSDF and skip the shadow rays of
+samples that do not contribute.)doc";
+
 static const char *__doc_mitsuba_Scene_ray_test_gpu = R"doc()doc";
 
 static const char *__doc_mitsuba_Scene_sample_emitter_direction =
@@ -5265,6 +6673,13 @@ Ideally, the implementation should importance sample the product of
 the emission profile and the geometry term between the reference point
 and the position on the emitter.
 
+By default, the emitter is chosen uniformly at random. When the
+``emitter_sampler`` scene property is set to ``"power"``, it is chosen
+proportionally to its power (see Emitter::power()). When it is set to
+``"bvh"``, it is instead chosen using a LightBVH, i.e. proportionally
+to a conservative estimate of its contribution to the reference point,
+which is much more efficient in scenes with many emitters.
+
 Parameter ``ref``:
     A reference point somewhere within the scene
 
@@ -5280,6 +6695,50 @@ Returns:
     Radiance received along the sampled ray divided by the sample
     probability.)doc";
 
+static const char *__doc_mitsuba_Scene_sample_emitter_directions =
+R"doc(Batched variant of sample_emitter_direction(), which draws ``count``
+emitter samples for the same reference point
+
+All samples are drawn before the first shadow ray is traced, and the
+shadow rays are then traced back to back, which keeps the acceleration
+data structure and the occluder cache (see ray_test()) warm. Shadow
+rays are skipped for samples that carry no radiance.
+
+Parameter ``samples``:
+   ``count`` uniformly distributed 2D vectors
+
+Parameter ``ds``:
+   Receives the ``count`` direction samples
+
+Parameter ``spec``:
+   Receives the ``count`` radiance values divided by the sample
+   probability (see sample_emitter_direction()))doc";
+
+static const char *__doc_mitsuba_Scene_sample_emitter_ray =
+R"doc(Sample a ray leaving one of the emitters of the scene
+
+The emitter is chosen proportionally to its power when the ``emitter_sampler``
+scene property is set to ``"power"``, and uniformly at random otherwise (a
+LightBVH requires a reference point). The first sample selects the
+emitter and is then reused by Endpoint::sample_ray().
+
+Parameter ``time``:
+    The scene time associated with the ray
+
+Parameter ``sample1``:
+    A uniformly distributed 1D value that selects the emitter and the
+    wavelengths
+
+Parameter ``sample2``:
+    A uniformly distributed 2D value (e.g. the position on the emitter)
+
+Parameter ``sample3``:
+    A uniformly distributed 2D value (e.g. the direction of the ray)
+
+Returns:
+    The sampled ray and the emitted radiance along it divided by the
+    sample probability, including the discrete probability of the emitter.)doc";
+
 static const char *__doc_mitsuba_Scene_sensors = R"doc(Return the list of sensors)doc";
 
 static const char *__doc_mitsuba_Scene_sensors_2 = R"doc(Return the list of sensors (const version))doc";
@@ -5290,17 +6749,34 @@ static const char *__doc_mitsuba_Scene_shapes_2 = R"doc(Return the list of shape
 
 static const char *__doc_mitsuba_Scene_shapes_grad_enabled = R"doc(Return whether any of the shape's parameters require gradient)doc";
 
+static const char *__doc_mitsuba_Scene_sort_rays =
+R"doc(Sort ray indices to improve the coherence of packet traversal
+
+Each ray is assigned a key consisting of the octant of its direction
+followed by the Morton code of its origin on a 512^3 grid over the
+scene's bounding box. The ``count`` entries of ``indices`` (which
+refer to entries of ``rays``) are then sorted by this key, so that
+consecutive rays tend to share the kd-tree traversal order.)doc";
+
 static const char *__doc_mitsuba_Scene_to_string = R"doc(Return a human-readable string representation of the scene contents.)doc";
 
 static const char *__doc_mitsuba_Scene_traverse = R"doc(Perform a custom traversal over the scene graph)doc";
 
 static const char *__doc_mitsuba_ScopedPhase = R"doc()doc";
 
-static const char *__doc_mitsuba_ScopedPhase_ScopedPhase = R"doc()doc";
+static const char *__doc_mitsuba_ScopedPhase_ScopedPhase =
+R"doc(Enter a phase, optionally on behalf of an object (e.g. a BSDF
+instance) to which the samples of the phase are attributed)doc";
+
+static const char *__doc_mitsuba_ScopedPhase_ScopedPhase_2 = R"doc()doc";
+
+static const char *__doc_mitsuba_ScopedPhase_m_flag = R"doc()doc";
+
+static const char *__doc_mitsuba_ScopedPhase_m_phase = R"doc()doc";
 
-static const char *__doc_mitsuba_ScopedPhase_ScopedPhase_2 = R"doc()doc";
+static const char *__doc_mitsuba_ScopedPhase_m_prev_tag = R"doc()doc";
 
-static const char *__doc_mitsuba_ScopedPhase_m_flag = R"doc()doc";
+static const char *__doc_mitsuba_ScopedPhase_m_tag = R"doc()doc";
 
 static const char *__doc_mitsuba_ScopedPhase_m_target = R"doc()doc";
 
@@ -5420,6 +6896,55 @@ This class provides core functionality for sampling positions on
 surfaces, computing ray intersections, and bounding shapes within ray
 intersection acceleration data structures.)doc";
 
+static const char *__doc_mitsuba_ShapeGroup_build_emitter_distr = R"doc(Rebuild the distribution used by sample_emitter_position())doc";
+
+static const char *__doc_mitsuba_ShapeGroup_emitter_area =
+R"doc(Return the summed surface area of the emissive shapes (in object space))doc";
+
+static const char *__doc_mitsuba_ShapeGroup_emitter_power =
+R"doc(Return the summed power of the emitters of the group (in object space))doc";
+
+static const char *__doc_mitsuba_ShapeGroup_has_emitters = R"doc(Does the group contain shapes with an attached area emitter?)doc";
+
+static const char *__doc_mitsuba_ShapeGroup_has_polarizing_bsdfs =
+R"doc(Does the group contain shapes whose BSDF alters the polarization of
+light?)doc";
+
+static const char *__doc_mitsuba_ShapeGroup_m_emitter_shapes =
+R"doc(Shapes of the group with an area emitter, shared by all instances)doc";
+
+static const char *__doc_mitsuba_ShapeGroup_sample_emitter_position =
+R"doc(Sample a point on the emissive shapes of the group (in object space)
+
+A shape is chosen proportionally to its surface area, and the point is
+then sampled by the shape itself (e.g. using the area distribution of
+a mesh), which is assumed to be uniform. The density is thus constant
+and equal to the inverse of emitter_area(). The function also returns
+the chosen shape, whose emitter provides the emitted radiance.)doc";
+
+static const char *__doc_mitsuba_ShapeKDTree_m_memory = R"doc(Storage of the nodes, indices and triangle records)doc";
+
+static const char *__doc_mitsuba_ShapeKDTree_ray_intersect_stream =
+R"doc(Intersect a large buffer of rays against the tree at once
+
+Unlike ray_intersect_packet(), which traverses the tree for the rays of
+a single packet, this function traverses it breadth-first for all
+rays: every visited node receives the list of rays (along with their
+valid interval) that reach it, splits the list between its children,
+and leaves intersect their primitives with packets formed from the
+rays in their list. Rays that are shortened by a hit are culled from
+the lists that are still pending.
+
+The direction reciprocals of ``rays`` must be up to date (see
+Ray::update()). The intersections are returned in the order of
+``rays``. With ``shadow_ray`` set, hits only have a valid distance of
+zero, as with ray_intersect_preliminary().
+
+Remark:
+    Only supported by CPU packet variants.)doc";
+
+static const char *__doc_mitsuba_ShapeKDTree_ray_intersect_stream_impl = R"doc(Implementation of ray_intersect_stream())doc";
+
 static const char *__doc_mitsuba_Shape_2 = R"doc()doc";
 
 static const char *__doc_mitsuba_Shape_3 = R"doc()doc";
@@ -5487,6 +7012,15 @@ static const char *__doc_mitsuba_Shape_Shape = R"doc(//! @})doc";
 
 static const char *__doc_mitsuba_Shape_Shape_2 = R"doc()doc";
 
+static const char *__doc_mitsuba_Shape_accel_refit =
+R"doc(Should the acceleration data structure be refitted rather than
+rebuilt when this shape changes?
+
+Refitting only updates the bounding boxes of the existing hierarchy,
+which is much faster for small deformations (e.g. in inverse rendering
+loops), but the hierarchy quality degrades when the geometry moves
+significantly. Only meshes are refitted.)doc";
+
 static const char *__doc_mitsuba_Shape_bbox =
 R"doc(Return an axis aligned box that bounds all shape primitives (including
 any transformations that may have been applied to them))doc";
@@ -5506,12 +7040,25 @@ This is extremely important to construct high-quality kd-trees. The
 default implementation just takes the bounding box returned by
 bbox(ScalarIndex index) and clips it to *clip*.)doc";
 
+static const char *__doc_mitsuba_Shape_bbox_motion =
+R"doc(Return axis aligned boxes that bound a single shape primitive at
+times ``time_start`` and ``time_end``, such that their linear
+interpolation bounds the primitive at any time in between.
+
+This is used by ShapeBVH to interpolate the bounds of its nodes along
+the time of a ray.
+
+Remark:
+    The default implementation returns bbox(ScalarIndex) twice)doc";
+
 static const char *__doc_mitsuba_Shape_bsdf = R"doc(Return the shape's BSDF)doc";
 
 static const char *__doc_mitsuba_Shape_bsdf_2 = R"doc(Return the shape's BSDF)doc";
 
 static const char *__doc_mitsuba_Shape_class = R"doc()doc";
 
+static const char *__doc_mitsuba_Shape_clear_dirty = R"doc(Reset the flags of geometry_dirty() and emitter_dirty())doc";
+
 static const char *__doc_mitsuba_Shape_compute_surface_interaction =
 R"doc(Compute and return detailed information related to a surface
 interaction
@@ -5550,6 +7097,12 @@ static const char *__doc_mitsuba_Shape_emitter = R"doc(Return the area emitter a
 
 static const char *__doc_mitsuba_Shape_emitter_2 = R"doc(Return the area emitter associated with this shape (if any))doc";
 
+static const char *__doc_mitsuba_Shape_emitter_dirty =
+R"doc(Was the emitter of this shape (or the geometry of an area emitter)
+modified since the last call to clear_dirty()?
+
+The scene then rebuilds the distributions used to sample emitters.)doc";
+
 static const char *__doc_mitsuba_Shape_eval_attribute =
 R"doc(Evaluate a specific shape attribute at the given surface interaction.
 
@@ -5617,8 +7170,28 @@ The default implementation throws.)doc";
 
 static const char *__doc_mitsuba_Shape_exterior_medium = R"doc(Return the medium that lies on the exterior of this shape)doc";
 
+static const char *__doc_mitsuba_Shape_fit_linear_bounds =
+R"doc(Fit linearly interpolated bounds (see bbox_motion()) to boxes sampled
+at increasing times
+
+Both boxes of the result are enlarged until their interpolation
+contains every sample at its time. This is exact for primitives that
+move linearly between consecutive samples.)doc";
+
+static const char *__doc_mitsuba_Shape_geometry_dirty =
+R"doc(Was the geometry of this shape modified since the last call to
+clear_dirty()?
+
+This flag is set by parameters_changed() when the modified keys affect
+the geometry, and tells Scene::parameters_changed() that the bounding
+box and the acceleration data structure must be updated. Changes to
+the BSDF or to the textures of a shape leave it unset.)doc";
+
 static const char *__doc_mitsuba_Shape_get_children_string = R"doc()doc";
 
+static const char *__doc_mitsuba_Shape_has_motion =
+R"doc(Does the shape move while the shutter is open? (see bbox_motion()))doc";
+
 static const char *__doc_mitsuba_Shape_id = R"doc(Return a string identifier)doc";
 
 static const char *__doc_mitsuba_Shape_interior_medium = R"doc(Return the medium that lies on the interior of this shape)doc";
@@ -5631,12 +7204,20 @@ static const char *__doc_mitsuba_Shape_is_mesh = R"doc(Is this shape a triangle
 
 static const char *__doc_mitsuba_Shape_is_sensor = R"doc(Is this shape also an area sensor?)doc";
 
+static const char *__doc_mitsuba_Shape_m_accel_refit =
+R"doc(Refit the acceleration data structure on changes? (see accel_refit()))doc";
+
 static const char *__doc_mitsuba_Shape_m_bsdf = R"doc()doc";
 
 static const char *__doc_mitsuba_Shape_m_emitter = R"doc()doc";
 
+static const char *__doc_mitsuba_Shape_m_emitter_dirty = R"doc()doc";
+
 static const char *__doc_mitsuba_Shape_m_exterior_medium = R"doc()doc";
 
+static const char *__doc_mitsuba_Shape_m_geometry_dirty =
+R"doc(Derived data of the scene invalidated by changes (see geometry_dirty()))doc";
+
 static const char *__doc_mitsuba_Shape_m_id = R"doc()doc";
 
 static const char *__doc_mitsuba_Shape_m_interior_medium = R"doc()doc";
@@ -5649,6 +7230,21 @@ static const char *__doc_mitsuba_Shape_m_to_object = R"doc()doc";
 
 static const char *__doc_mitsuba_Shape_m_to_world = R"doc()doc";
 
+static const char *__doc_mitsuba_Shape_motion_time_range =
+R"doc(Return the time interval ``[start, end]`` during which the shape
+moves. The shape is at rest before and after this interval.
+
+Remark:
+    The default implementation returns an empty interval at time zero)doc";
+
+static const char *__doc_mitsuba_Shape_normal_cone =
+R"doc(Return a cone that bounds the normals of the shape
+
+The cone is returned as its (normalized) axis and the cosine of its
+half-angle. It is used to bound the emission of area emitters when
+importance sampling many of them (see LightBVH). The default
+implementation returns the whole sphere of directions.)doc";
+
 static const char *__doc_mitsuba_Shape_operator_delete = R"doc()doc";
 
 static const char *__doc_mitsuba_Shape_operator_delete_2 = R"doc()doc";
@@ -5730,6 +7326,17 @@ Parameter ``cache``:
     sizeof(Float[P])`` bytes) that must be supplied to cache
     information about the intersection.)doc";
 
+static const char *__doc_mitsuba_Shape_ray_intersect_primitive =
+R"doc(Intersect a single primitive of the shape (see primitive_count())
+
+This is used by the kd-tree and the BVH to test the primitives of
+shapes made of several ones (e.g. the segments of a curve) separately.
+The returned record must have its ``prim_index`` set to ``index``.
+
+Remark:
+    The default implementation ignores ``index`` and calls
+    ray_intersect_preliminary())doc";
+
 static const char *__doc_mitsuba_Shape_ray_test =
 R"doc(Fast ray shadow test
 
@@ -5746,6 +7353,13 @@ kd-tree, some optimizations are possible.
 Parameter ``ray``:
     The ray to be tested for an intersection)doc";
 
+static const char *__doc_mitsuba_Shape_ray_test_primitive =
+R"doc(Shadow ray test of a single primitive of the shape (see
+ray_intersect_primitive())
+
+Remark:
+    The default implementation ignores ``index`` and calls ray_test())doc";
+
 static const char *__doc_mitsuba_Shape_sample_direction =
 R"doc(Sample a direction towards this shape with respect to solid angles
 measured at a reference position within the scene
@@ -5839,10 +7453,26 @@ static const char *__doc_mitsuba_Spiral_Direction_Up = R"doc()doc";
 
 static const char *__doc_mitsuba_Spiral_Spiral =
 R"doc(Create a new spiral generator for the given size, offset into a larger
-frame, and block size)doc";
+frame, and block size
+
+When ``scanline`` is set, the blocks are generated row by row from the
+top of the image instead of along a spiral, which is required by films
+that write their output while rendering (see Film::streaming()).)doc";
 
 static const char *__doc_mitsuba_Spiral_Spiral_2 = R"doc()doc";
 
+static const char *__doc_mitsuba_Spiral_block =
+R"doc(Return the offset, size and unique identifer of the block with the given
+index in the traversal order (spanning all passes).
+
+The sequence of blocks matches the one produced by repeated calls to
+next_block(). In contrast to the latter, this function does not
+modify the spiral and can therefore be called concurrently from many
+threads without any locking (e.g. by incrementing an atomic counter).
+
+A size of zero indicates that the index is past the end of the
+traversal.)doc";
+
 static const char *__doc_mitsuba_Spiral_block_count = R"doc(Return the total number of blocks)doc";
 
 static const char *__doc_mitsuba_Spiral_class = R"doc()doc";
@@ -5851,6 +7481,9 @@ static const char *__doc_mitsuba_Spiral_m_block_count = R"doc()doc";
 
 static const char *__doc_mitsuba_Spiral_m_block_counter = R"doc()doc";
 
+static const char *__doc_mitsuba_Spiral_m_block_list =
+R"doc(Offset and size of each block of a single pass, in traversal order.)doc";
+
 static const char *__doc_mitsuba_Spiral_m_block_size = R"doc()doc";
 
 static const char *__doc_mitsuba_Spiral_m_blocks = R"doc()doc";
@@ -5861,10 +7494,14 @@ static const char *__doc_mitsuba_Spiral_m_mutex = R"doc(Protects the spiral's st
 
 static const char *__doc_mitsuba_Spiral_m_offset = R"doc()doc";
 
+static const char *__doc_mitsuba_Spiral_m_passes = R"doc(Total number of passes (used by block()).)doc";
+
 static const char *__doc_mitsuba_Spiral_m_position = R"doc()doc";
 
 static const char *__doc_mitsuba_Spiral_m_remaining_passes = R"doc(Number of times the spiral should automatically restart.)doc";
 
+static const char *__doc_mitsuba_Spiral_m_scanline = R"doc(Generate the blocks row by row instead of along a spiral.)doc";
+
 static const char *__doc_mitsuba_Spiral_m_size = R"doc()doc";
 
 static const char *__doc_mitsuba_Spiral_m_steps = R"doc(Step counters.)doc";
@@ -5882,10 +7519,59 @@ static const char *__doc_mitsuba_Spiral_reset =
 R"doc(Reset the spiral to its initial state. Does not affect the number of
 passes.)doc";
 
+static const char *__doc_mitsuba_Spiral_scanline =
+R"doc(Are the blocks generated in scanline order rather than along a spiral?)doc";
+
 static const char *__doc_mitsuba_Spiral_set_passes =
 R"doc(Sets the number of time the spiral should automatically reset. Not
 affected by a call to reset.)doc";
 
+static const char *__doc_mitsuba_Statistics =
+R"doc(Rendering statistics in the spirit of the ``StatsCounter`` of Mitsuba
+0.6: the number of rays traced, kd-tree nodes visited, the path length
+histogram, etc.
+
+Every thread increments its own counters (stats_add(), stats_count()
+and stats_histogram()), which are summed when they are queried. The
+statistics are only collected when Mitsuba is compiled with the CMake
+option ``MTS_ENABLE_STATISTICS``: otherwise, the calls are compiled out
+and all values are zero. They are not collected in GPU variants.)doc";
+
+static const char *__doc_mitsuba_Statistics_Statistics = R"doc()doc";
+
+static const char *__doc_mitsuba_Statistics_counter = R"doc(Return the value of a counter, summed over all threads)doc";
+
+static const char *__doc_mitsuba_Statistics_enabled = R"doc(Were the statistics compiled in?)doc";
+
+static const char *__doc_mitsuba_Statistics_histogram = R"doc(Return the bins of a histogram, summed over all threads)doc";
+
+static const char *__doc_mitsuba_Statistics_print_report = R"doc(Log the table returned by report())doc";
+
+static const char *__doc_mitsuba_Statistics_report = R"doc(Return a table with the counters and histograms)doc";
+
+static const char *__doc_mitsuba_Statistics_reset =
+R"doc(Reset all counters and histograms
+
+This should not be done while other threads are rendering.)doc";
+
+static const char *__doc_mitsuba_StatsCounter = R"doc(Event counters of the rendering statistics (see Statistics))doc";
+
+static const char *__doc_mitsuba_StatsCounter_KDTreeNodes = R"doc()doc";
+
+static const char *__doc_mitsuba_StatsCounter_NullCollisions = R"doc()doc";
+
+static const char *__doc_mitsuba_StatsCounter_PrimitiveTests = R"doc()doc";
+
+static const char *__doc_mitsuba_StatsCounter_RRTerminations = R"doc()doc";
+
+static const char *__doc_mitsuba_StatsCounter_Rays = R"doc()doc";
+
+static const char *__doc_mitsuba_StatsCounter_ShadowRays = R"doc()doc";
+
+static const char *__doc_mitsuba_StatsHistogram = R"doc(Histograms of the rendering statistics (see Statistics))doc";
+
+static const char *__doc_mitsuba_StatsHistogram_PathLength = R"doc()doc";
+
 static const char *__doc_mitsuba_Stream =
 R"doc(Abstract seekable stream class
 
@@ -6402,8 +8088,12 @@ static const char *__doc_mitsuba_SurfaceInteraction_duv_dx = R"doc(UV partials w
 static const char *__doc_mitsuba_SurfaceInteraction_duv_dy = R"doc(UV partials wrt. changes in screen-space)doc";
 
 static const char *__doc_mitsuba_SurfaceInteraction_emitter =
-R"doc(Return the emitter associated with the intersection (if any) \note
-Defined in scene.h)doc";
+R"doc(Return the emitter associated with the intersection (if any)
+
+Emissive shapes hit through an instance return the emitter of the
+instance. Rays that missed return the environment emitter of ``scene``.
+
+\note Defined in scene.h)doc";
 
 static const char *__doc_mitsuba_SurfaceInteraction_has_n_partials = R"doc()doc";
 
@@ -6607,6 +8297,13 @@ static const char *__doc_mitsuba_TShapeKDTree_BuildContext_temp_storage = R"doc(
 
 static const char *__doc_mitsuba_TShapeKDTree_BuildContext_work_units = R"doc()doc";
 
+static const char *__doc_mitsuba_TShapeKDTree_BuildStatistics =
+R"doc(Statistics gathered by the last call to build()
+
+The expected query costs are normalized by the surface area of the
+scene bounding box. All entries are zero when the tree was not built
+(e.g. for external storage, see set_external_storage()).)doc";
+
 static const char *__doc_mitsuba_TShapeKDTree_BuildTask =
 R"doc(TBB task for building subtrees in parallel
 
@@ -6887,6 +8584,8 @@ static const char *__doc_mitsuba_TShapeKDTree_bbox = R"doc(Return the bounding b
 
 static const char *__doc_mitsuba_TShapeKDTree_build = R"doc()doc";
 
+static const char *__doc_mitsuba_TShapeKDTree_build_statistics = R"doc(Return statistics about the construction of the tree)doc";
+
 static const char *__doc_mitsuba_TShapeKDTree_class = R"doc()doc";
 
 static const char *__doc_mitsuba_TShapeKDTree_clip_primitives = R"doc(Return whether primitive clipping is used during tree construction)doc";
@@ -7090,6 +8789,13 @@ default implementation throws an exception.
 Even if the operation is provided, it may only return an
 approximation.)doc";
 
+static const char *__doc_mitsuba_Texture_needs_differentials =
+R"doc(Does this texture filter its lookups using the UV partials (``duv_dx``
+and ``duv_dy``) of the surface interaction?
+
+BSDFs using such a texture set BSDFFlags::NeedsDifferentials so that
+the partials are computed from the ray differentials.)doc";
+
 static const char *__doc_mitsuba_Texture_pdf_position = R"doc(Returns the probability per unit area of sample_position())doc";
 
 static const char *__doc_mitsuba_Texture_pdf_spectrum =
@@ -7247,6 +8953,63 @@ static const char *__doc_mitsuba_ThreadLocal_operator_const_T0 =
 R"doc(Return a reference to the data associated with the current thread
 (const version))doc";
 
+static const char *__doc_mitsuba_ThreadPool =
+R"doc(Pool of worker threads with a bounded concurrency, optionally pinned
+to a set of logical cores
+
+By default, the parallel loops of Mitsuba run on the global TBB
+scheduler, whose size is the global thread count (`set_thread_count()`).
+Work submitted through `execute()` instead runs in a separate task arena
+that uses at most `thread_count()` threads (including the calling
+thread), which makes it possible to run several jobs side by side
+without oversubscribing the machine, or to restrict a job to some of
+the cores.
+
+When a list of cores is given, each worker thread is pinned to one of
+them while it executes tasks of the pool, and its previous affinity is
+restored when it leaves the pool. Core pinning is only supported on
+Linux.)doc";
+
+static const char *__doc_mitsuba_ThreadPool_ThreadPool =
+R"doc(Create a thread pool
+
+Parameter ``thread_count``:
+    Maximum number of threads executing the tasks of the pool. Zero
+    selects the number of cores, or the global thread count when no
+    cores are given.
+
+Parameter ``cores``:
+    Logical cores that the worker threads are pinned to (in turn, if
+    there are more threads than cores). An empty list disables pinning.)doc";
+
+static const char *__doc_mitsuba_ThreadPool_ThreadPoolPrivate = R"doc()doc";
+
+static const char *__doc_mitsuba_ThreadPool_class = R"doc()doc";
+
+static const char *__doc_mitsuba_ThreadPool_cores =
+R"doc(Return the logical cores that the worker threads are pinned to)doc";
+
+static const char *__doc_mitsuba_ThreadPool_current =
+R"doc(Return the pool executing the current thread's work (or ``nullptr``))doc";
+
+static const char *__doc_mitsuba_ThreadPool_d = R"doc()doc";
+
+static const char *__doc_mitsuba_ThreadPool_execute =
+R"doc(Run a function inside the pool
+
+Parallel loops started by ``func`` are executed by the threads of the
+pool. The function returns when ``func`` has finished, and exceptions
+raised by ``func`` are propagated to the caller.)doc";
+
+static const char *__doc_mitsuba_ThreadPool_parse_cores =
+R"doc(Parse a comma-separated list of logical cores or core ranges, e.g.
+``"0-7,16-23"``)doc";
+
+static const char *__doc_mitsuba_ThreadPool_thread_count =
+R"doc(Return the maximum number of threads executing the tasks of the pool)doc";
+
+static const char *__doc_mitsuba_ThreadPool_to_string = R"doc(Return a human-readable representation)doc";
+
 static const char *__doc_mitsuba_Thread_EPriority = R"doc(Possible priority values for Thread::set_priority())doc";
 
 static const char *__doc_mitsuba_Thread_EPriority_EHighPriority = R"doc()doc";
@@ -7278,6 +9041,13 @@ static const char *__doc_mitsuba_Thread_class = R"doc()doc";
 
 static const char *__doc_mitsuba_Thread_core_affinity = R"doc(Return the core affinity)doc";
 
+static const char *__doc_mitsuba_Thread_current_numa_node =
+R"doc(Return the NUMA node of the calling thread (or -1)
+
+Unlike <tt>Thread::thread()->numa_node()</tt>, this is a plain
+thread-local variable lookup and can be used in inner loops, e.g. to
+select node-local replicas of read-only data structures.)doc";
+
 static const char *__doc_mitsuba_Thread_d = R"doc()doc";
 
 static const char *__doc_mitsuba_Thread_detach =
@@ -7305,6 +9075,13 @@ static const char *__doc_mitsuba_Thread_logger = R"doc(Return the thread's logge
 
 static const char *__doc_mitsuba_Thread_name = R"doc(Return the name of this thread)doc";
 
+static const char *__doc_mitsuba_Thread_numa_node = R"doc(Return the NUMA node this thread is pinned to (or -1))doc";
+
+static const char *__doc_mitsuba_Thread_numa_node_count =
+R"doc(Return the number of NUMA nodes of the machine (1 if unknown))doc";
+
+static const char *__doc_mitsuba_Thread_numa_pinning = R"doc(Are TBB worker threads pinned to NUMA nodes?)doc";
+
 static const char *__doc_mitsuba_Thread_parent = R"doc(Return the parent thread)doc";
 
 static const char *__doc_mitsuba_Thread_parent_2 = R"doc(Return the parent thread (const version))doc";
@@ -7317,6 +9094,12 @@ Returns true upon success.)doc";
 
 static const char *__doc_mitsuba_Thread_run = R"doc(The thread's run method)doc";
 
+static const char *__doc_mitsuba_Thread_run_on_numa_node =
+R"doc(Run a function on a temporary thread pinned to a NUMA node
+
+Memory allocated and first written by ``func`` is then (under the
+default first-touch policy) placed on that node.)doc";
+
 static const char *__doc_mitsuba_Thread_set_core_affinity =
 R"doc(Set the core affinity
 
@@ -7337,6 +9120,19 @@ static const char *__doc_mitsuba_Thread_set_logger = R"doc(Set the logger instan
 
 static const char *__doc_mitsuba_Thread_set_name = R"doc(Set the name of this thread)doc";
 
+static const char *__doc_mitsuba_Thread_set_numa_node =
+R"doc(Restrict the thread to the cores of a NUMA node
+
+Only supported on Linux, where the topology is read from
+<tt>/sys/devices/system/node</tt>. Returns ``True`` upon success.)doc";
+
+static const char *__doc_mitsuba_Thread_set_numa_pinning =
+R"doc(Distribute TBB worker threads over the NUMA nodes
+
+When enabled, worker threads joining the TBB scheduler are pinned to
+the NUMA nodes in a round-robin fashion. Must be called before the
+worker threads are created. Has no effect on single-node machines.)doc";
+
 static const char *__doc_mitsuba_Thread_set_priority =
 R"doc(Set the thread priority
 
@@ -7364,6 +9160,159 @@ static const char *__doc_mitsuba_Thread_unregister_external_thread = R"doc(Unreg
 
 static const char *__doc_mitsuba_Thread_yield = R"doc(Yield to another processor)doc";
 
+static const char *__doc_mitsuba_TileCache =
+R"doc(Global cache for the tiles of TiledImage instances
+
+The cache holds up to capacity() bytes of tiles that are shared by all
+images and evicts the least recently used ones when it is full. It is
+split into independently locked shards, so that threads that access
+different tiles rarely wait for each other. Tiles are returned as
+shared pointers that stay valid when they are evicted while in use.)doc";
+
+static const char *__doc_mitsuba_TileCache_TileCache = R"doc()doc";
+
+static const char *__doc_mitsuba_TileCache_capacity =
+R"doc(Return the maximum amount of memory used by the tiles (in bytes))doc";
+
+static const char *__doc_mitsuba_TileCache_class = R"doc()doc";
+
+static const char *__doc_mitsuba_TileCache_clear =
+R"doc(Remove the tiles of ``image``, or all tiles when ``image`` is ``nullptr``)doc";
+
+static const char *__doc_mitsuba_TileCache_hit_count = R"doc(Return the number of lookups that found a loaded tile)doc";
+
+static const char *__doc_mitsuba_TileCache_instance = R"doc(Return the global tile cache)doc";
+
+static const char *__doc_mitsuba_TileCache_miss_count = R"doc(Return the number of lookups that had to load a tile)doc";
+
+static const char *__doc_mitsuba_TileCache_set_capacity =
+R"doc(Set the maximum amount of memory used by the tiles (in bytes))doc";
+
+static const char *__doc_mitsuba_TileCache_size =
+R"doc(Return the amount of memory currently used by the tiles (in bytes))doc";
+
+static const char *__doc_mitsuba_TileCache_tile =
+R"doc(Return the tile containing pixel ``(x, y)`` of level ``level``, loading
+it if necessary
+
+Parameter ``hit``:
+    Set to ``true`` if the tile was already loaded)doc";
+
+static const char *__doc_mitsuba_TileCache_to_string = R"doc()doc";
+
+static const char *__doc_mitsuba_TiledImage =
+R"doc(MIP-mapped image that is stored on disk in square tiles
+
+The ``.mtstex`` format holds all levels of a MIP map pyramid as tiles
+of ``tile_size x tile_size`` single precision pixels, so that a texture
+only needs to read the parts of the image that are actually accessed.
+The tiles are loaded through the global TileCache. Tiles at the right
+and bottom boundaries of a level are padded by repeating the last
+column or row. All values are stored in the byte order of the machine
+that wrote the file.)doc";
+
+static const char *__doc_mitsuba_TiledImage_TiledImage = R"doc(Open the tiled image file ``filename``)doc";
+
+static const char *__doc_mitsuba_TiledImage_channel_count = R"doc(Return the number of channels per pixel)doc";
+
+static const char *__doc_mitsuba_TiledImage_class = R"doc()doc";
+
+static const char *__doc_mitsuba_TiledImage_id = R"doc(Unique identifier of this image within the TileCache)doc";
+
+static const char *__doc_mitsuba_TiledImage_level_count = R"doc(Return the number of MIP map levels)doc";
+
+static const char *__doc_mitsuba_TiledImage_level_size = R"doc(Return the resolution of the given level)doc";
+
+static const char *__doc_mitsuba_TiledImage_read_tile =
+R"doc(Copy the pixels of the tile with index ``index`` into ``target``)doc";
+
+static const char *__doc_mitsuba_TiledImage_tag = R"doc(Return the value passed to write() when the file was created)doc";
+
+static const char *__doc_mitsuba_TiledImage_tile_bytes = R"doc(Return the size of a tile in bytes)doc";
+
+static const char *__doc_mitsuba_TiledImage_tile_index =
+R"doc(Return the index of the tile containing pixel ``(x, y)`` of a level)doc";
+
+static const char *__doc_mitsuba_TiledImage_tile_size = R"doc(Return the edge length of the tiles)doc";
+
+static const char *__doc_mitsuba_TiledImage_to_string = R"doc()doc";
+
+static const char *__doc_mitsuba_TiledImage_write =
+R"doc(Write a tiled image file
+
+Parameter ``filename``:
+    Name of the resulting file. The file is written under a temporary
+    name and renamed once complete, so that concurrent readers never
+    see a partial file.
+
+Parameter ``levels``:
+    Pointers to the pixels of each level, which must be stored as
+    interleaved single precision values
+
+Parameter ``sizes``:
+    Resolution of each level
+
+Parameter ``channel_count``:
+    Number of channels per pixel
+
+Parameter ``tile_size``:
+    Edge length of the tiles (in pixels)
+
+Parameter ``tag``:
+    Arbitrary value stored in the header, which lets the caller check
+    whether the file is up to date (see tag()))doc";
+
+static const char *__doc_mitsuba_TiledOpenEXRWriter =
+R"doc(Incrementally writes a tiled OpenEXR file, one row of tiles at a time
+
+In contrast to Bitmap::write(), the image never needs to be resident
+in memory as a whole: its rows are passed to write() as a sequence of
+strips (bitmaps spanning the full width of the image) from top to bottom.
+This is used to develop very large images while they are being rendered.)doc";
+
+static const char *__doc_mitsuba_TiledOpenEXRWriter_TiledOpenEXRWriter =
+R"doc(Create the file and write its header
+
+Parameter ``filename``:
+    Path of the target file
+
+Parameter ``prototype``:
+    Bitmap whose pixel format, channels and metadata determine the
+    layout of the file (its size and contents are ignored)
+
+Parameter ``size``:
+    Resolution of the whole image
+
+Parameter ``tile_size``:
+    Width and height of the (square) tiles
+
+Parameter ``quality``:
+    Compression settings (see Bitmap::write()))doc";
+
+static const char *__doc_mitsuba_TiledOpenEXRWriter_TiledOpenEXRWriterPrivate = R"doc()doc";
+
+static const char *__doc_mitsuba_TiledOpenEXRWriter_class = R"doc()doc";
+
+static const char *__doc_mitsuba_TiledOpenEXRWriter_close =
+R"doc(Finish writing the file. This happens automatically upon destruction.)doc";
+
+static const char *__doc_mitsuba_TiledOpenEXRWriter_d = R"doc()doc";
+
+static const char *__doc_mitsuba_TiledOpenEXRWriter_rows_written = R"doc(Return the number of rows written so far)doc";
+
+static const char *__doc_mitsuba_TiledOpenEXRWriter_size = R"doc(Return the resolution of the image)doc";
+
+static const char *__doc_mitsuba_TiledOpenEXRWriter_tile_size = R"doc(Return the size of the tiles)doc";
+
+static const char *__doc_mitsuba_TiledOpenEXRWriter_to_string = R"doc(Return a human-readable summary)doc";
+
+static const char *__doc_mitsuba_TiledOpenEXRWriter_write =
+R"doc(Append the rows of ``strip`` to the image
+
+The strip must have the layout of the prototype bitmap and the width
+of the image. Its height must be a multiple of the tile size, unless
+it reaches the bottom of the image.)doc";
+
 static const char *__doc_mitsuba_Timer = R"doc()doc";
 
 static const char *__doc_mitsuba_Timer_Timer = R"doc()doc";
@@ -7611,6 +9560,35 @@ static const char *__doc_mitsuba_Volume_m_world_to_local = R"doc(Used to bring p
 
 static const char *__doc_mitsuba_Volume_max = R"doc(Returns the maximum value of the texture over all dimensions.)doc";
 
+static const char *__doc_mitsuba_Volume_max_per_cell =
+R"doc(Returns the maximum value of the texture within each cell of a regular
+grid of resolution ``cells`` that covers the volume
+
+The values are conservative bounds of what eval() returns within the
+cells (including the effect of interpolation), and are stored in row-
+major order (``x`` varies fastest). The default implementation returns
+max() for every cell.)doc";
+
+static const char *__doc_mitsuba_Volume_max_per_cell_and_band =
+R"doc(Returns the maximum value of the texture within each cell of a regular
+grid of resolution ``cells`` and within each of ``bands`` spectral
+bands
+
+The bands are the color channels in RGB variants (which requires three
+bands), equal intervals of ``[MTS_WAVELENGTH_MIN,
+MTS_WAVELENGTH_MAX]`` in spectral variants, and a single band in
+monochromatic variants. The bands of a cell are stored contiguously, and
+the cells are ordered as in max_per_cell(). The default implementation
+returns max_per_cell() for every band.)doc";
+
+static const char *__doc_mitsuba_Volume_min_per_cell =
+R"doc(Returns the minimum value of the texture within each cell of a regular
+grid of resolution ``cells`` that covers the volume
+
+This is the counterpart of max_per_cell(). The default implementation
+returns zero for every cell, which is a conservative bound for non-
+negative volumes such as densities.)doc";
+
 static const char *__doc_mitsuba_Volume_resolution =
 R"doc(Returns the resolution of the volume, assuming that it is based on a
 discrete representation.
@@ -7621,11 +9599,19 @@ static const char *__doc_mitsuba_Volume_to_string = R"doc(Returns a human-reable
 
 static const char *__doc_mitsuba_Volume_update_bbox = R"doc()doc";
 
+static const char *__doc_mitsuba_Volume_world_to_local =
+R"doc(Returns the transformation from world space to the unit cube of the
+texture)doc";
+
 static const char *__doc_mitsuba_ZStream =
-R"doc(Transparent compression/decompression stream based on ``zlib``.
+R"doc(Transparent compression/decompression stream based on ``zlib`` or
+``zstd``.
 
 This class transparently decompresses and compresses reads and writes
-to a nested stream, respectively.)doc";
+to a nested stream, respectively. The ``zstd`` backend decompresses
+several times faster than ``zlib`` at similar compression ratios and
+can compress on multiple threads, but it is only available when
+Mitsuba was compiled against the ``zstd`` library (see has_zstd()).)doc";
 
 static const char *__doc_mitsuba_ZStream_EStreamType = R"doc()doc";
 
@@ -7633,10 +9619,21 @@ static const char *__doc_mitsuba_ZStream_EStreamType_EDeflateStream = R"doc(< A
 
 static const char *__doc_mitsuba_ZStream_EStreamType_EGZipStream = R"doc(< A gzip-compatible stream)doc";
 
+static const char *__doc_mitsuba_ZStream_EStreamType_EZstdStream = R"doc(< A zstd stream (sequence of zstd frames))doc";
+
 static const char *__doc_mitsuba_ZStream_ZStream =
 R"doc(Creates a new compression stream with the given underlying stream.
 This new instance takes ownership of the child stream. The child
-stream must outlive the ZStream.)doc";
+stream must outlive the ZStream.
+
+Parameter ``level``:
+    Compression level, or ``-1`` to use the default level of the
+    backend
+
+Parameter ``threads``:
+    Number of threads used to compress the data written to a ``zstd``
+    stream (``-1``: one per core, ``0`` or ``1``: compress on the
+    calling thread). Ignored by the ``zlib`` backend.)doc";
 
 static const char *__doc_mitsuba_ZStream_can_read = R"doc(Can we read from the stream?)doc";
 
@@ -7655,8 +9652,19 @@ read or write operations are permitted.
 This function is idempotent. It is called automatically by the
 destructor.)doc";
 
+static const char *__doc_mitsuba_ZStream_decompress =
+R"doc(Decompress a self-contained block of compressed data
+
+Decompresses the ``src_size`` bytes at ``src`` into exactly ``dst_size``
+bytes at ``dst``. Throws an exception when the block is corrupt or
+does not decompress to the expected size. Since no ``ZStream``
+instance is involved, this function can be called concurrently on
+different blocks.)doc";
+
 static const char *__doc_mitsuba_ZStream_flush = R"doc(Flushes any buffered data)doc";
 
+static const char *__doc_mitsuba_ZStream_has_zstd = R"doc(Was Mitsuba compiled with support for EZstdStream?)doc";
+
 static const char *__doc_mitsuba_ZStream_is_closed = R"doc(Whether the stream is closed (no read or write are then permitted).)doc";
 
 static const char *__doc_mitsuba_ZStream_m_child_stream = R"doc()doc";
@@ -7680,6 +9688,8 @@ static const char *__doc_mitsuba_ZStream_seek = R"doc(Unsupported. Always throws
 
 static const char *__doc_mitsuba_ZStream_size = R"doc(Unsupported. Always throws.)doc";
 
+static const char *__doc_mitsuba_ZStream_stream_type = R"doc(Returns the compression format of this stream)doc";
+
 static const char *__doc_mitsuba_ZStream_tell = R"doc(Unsupported. Always throws.)doc";
 
 static const char *__doc_mitsuba_ZStream_to_string = R"doc(Returns a string representation)doc";
@@ -7754,6 +9764,10 @@ Parameter ``frame``:
 
 static const char *__doc_mitsuba_coordinate_system = R"doc(Complete the set {a} to an orthonormal basis {a, b, c})doc";
 
+static const char *__doc_mitsuba_decode_half =
+R"doc(Convert half precision values (stored in the low 16 bits) to single
+precision)doc";
+
 static const char *__doc_mitsuba_depolarize =
 R"doc(Return the (1,1) entry of a Mueller matrix. Identity function for all
 other-types.)doc";
@@ -7766,6 +9780,22 @@ static const char *__doc_mitsuba_detail_Log = R"doc()doc";
 
 static const char *__doc_mitsuba_detail_Throw = R"doc()doc";
 
+static const char *__doc_mitsuba_detail_beckmann_visible_erf =
+R"doc(Invert the CDF of the first slope component of the Beckmann
+distribution of visible normals for the alpha=1 case
+
+The result is parameterized in the erf() domain, i.e., <tt>erfinv()</tt>
+of the return value is the slope.)doc";
+
+static const char *__doc_mitsuba_detail_beckmann_visible_table =
+R"doc(Return a table of beckmann_visible_erf() that is used by the
+tabulated visible normal sampling routine
+
+The rows are uniformly spaced in the elevation angle of the incident
+direction, and the columns are spaced as <tt>(1 - cos(pi * t)) / 2</tt>
+in the sample, which places more entries in the tails of the
+distribution. The table is computed on first use.)doc";
+
 static const char *__doc_mitsuba_detail_get_construct_functor = R"doc()doc";
 
 static const char *__doc_mitsuba_detail_get_construct_functor_2 = R"doc()doc";
@@ -7879,8 +9909,12 @@ static const char *__doc_mitsuba_detail_variant_helper_move = R"doc()doc";
 static const char *__doc_mitsuba_detail_variant_helper_visit = R"doc()doc";
 
 static const char *__doc_mitsuba_emitter =
-R"doc(Return the emitter associated with the intersection (if any) \note
-Defined in scene.h)doc";
+R"doc(Return the emitter associated with the intersection (if any)
+
+Emissive shapes hit through an instance return the emitter of the
+instance. Rays that missed return the environment emitter of ``scene``.
+
+\note Defined in scene.h)doc";
 
 static const char *__doc_mitsuba_eval_reflectance = R"doc()doc";
 
@@ -8025,6 +10059,16 @@ R"doc(Changes the size of the regular file named by ``p`` as if ``truncate``
 was called. If the file was larger than ``target_length``, the
 remainder is discarded. The file must exist.)doc";
 
+static const char *__doc_mitsuba_for_each_packet =
+R"doc(Process ``count`` scalar queries in packets of type ``Value``
+
+Calls ``func(offset, active)`` for consecutive packets of queries,
+where ``offset`` is the index of the first query of the packet and
+``active`` disables the lanes of the last packet that lie beyond
+``count``. This is the driver of the batched evaluation routines of
+the splines and distributions, which load and store their queries with
+masked unaligned memory operations.)doc";
+
 static const char *__doc_mitsuba_fresnel =
 R"doc(Calculates the unpolarized Fresnel reflection coefficient at a planar
 interface between two dielectrics
@@ -8151,6 +10195,9 @@ of travel. In the real-valued case, this also happens to be equal to
 the scale factor that must be applied to the X and Y component of the
 refracted direction.)doc";
 
+static const char *__doc_mitsuba_gather_uint16 =
+R"doc(Returns the 16-bit value with index ``index`` in a buffer of packed pairs)doc";
+
 static const char *__doc_mitsuba_has_flag = R"doc()doc";
 
 static const char *__doc_mitsuba_has_flag_2 = R"doc()doc";
@@ -8889,6 +10936,20 @@ static const char *__doc_mitsuba_perspective_projection = R"doc()doc";
 
 static const char *__doc_mitsuba_profiler_flags = R"doc()doc";
 
+static const char *__doc_mitsuba_profiler_object_attribution =
+R"doc(Are the samples of the profiler attributed to objects? (see
+Profiler::set_object_attribution()))doc";
+
+static const char *__doc_mitsuba_profiler_tag = R"doc(Return the tag of the current thread (see profiler_flags()))doc";
+
+static const char *__doc_mitsuba_profiler_timeline =
+R"doc(Is the timeline of the profiler being recorded? (see
+Profiler::set_timeline()))doc";
+
+static const char *__doc_mitsuba_profiler_timeline_record =
+R"doc(Record the beginning or the end of a phase in the timeline of the
+current thread)doc";
+
 static const char *__doc_mitsuba_quad_composite_simpson =
 R"doc(Computes the nodes and weights of a composite Simpson quadrature rule
 with the given number of evaluations.
@@ -9070,6 +11131,16 @@ Radziszewski, Boryczko, and Alda
 
 Returns a tuple with the sampled wavelength and inverse PDF)doc";
 
+static const char *__doc_mitsuba_sample_rgb_spectrum_xyz =
+R"doc(Sample wavelengths using sample_rgb_spectrum() and evaluate the CIE
+1931 XYZ color matching functions at them
+
+Returns a tuple with the sampled wavelengths and the XYZ weights of
+each sample, i.e. the color matching functions multiplied by the
+inverse PDF. The mean of their product with a spectrum evaluated at
+the sampled wavelengths is an unbiased estimate of its XYZ tristimulus
+values.)doc";
+
 static const char *__doc_mitsuba_sample_tea_32 =
 R"doc(Generate fast and reasonably good pseudorandom numbers using the Tiny
 Encryption Algorithm (TEA) by David Wheeler and Roger Needham.
@@ -9279,6 +11350,34 @@ Returns:
     The interpolated value or zero when ``Extrapolate=false`` and
     ``x`` lies outside of \a [``min``, ``max``])doc";
 
+static const char *__doc_mitsuba_spline_eval_1d_batch =
+R"doc(Evaluate a cubic spline interpolant of a *uniformly* sampled 1D
+function at ``count`` positions
+
+This is equivalent to calling eval_1d() for every entry of ``x``, but
+processes the queries in SIMD packets. See eval_1d() for a description
+of the remaining parameters.
+
+Parameter ``x``:
+    Array containing ``count`` evaluation points
+
+Parameter ``out``:
+    Array receiving the ``count`` interpolated values)doc";
+
+static const char *__doc_mitsuba_spline_eval_1d_batch_2 =
+R"doc(Evaluate a cubic spline interpolant of a *non-uniformly* sampled 1D
+function at ``count`` positions
+
+This is equivalent to calling eval_1d() for every entry of ``x``, but
+processes the queries in SIMD packets. See eval_1d() for a description
+of the remaining parameters.
+
+Parameter ``x``:
+    Array containing ``count`` evaluation points
+
+Parameter ``out``:
+    Array receiving the ``count`` interpolated values)doc";
+
 static const char *__doc_mitsuba_spline_eval_2d =
 R"doc(Evaluate a cubic spline interpolant of a uniformly sampled 2D function
 
@@ -9326,6 +11425,25 @@ Returns:
     The interpolated value or zero when ``Extrapolate=false``tt> and
     ``(x,y)`` lies outside of the node range)doc";
 
+static const char *__doc_mitsuba_spline_eval_2d_batch =
+R"doc(Evaluate a cubic spline interpolant of a uniformly sampled 2D
+function at ``count`` positions
+
+This is equivalent to calling eval_2d() for every pair of entries of
+``x`` and ``y``, but processes the queries in SIMD packets. See
+eval_2d() for a description of the remaining parameters.
+
+Parameter ``x``:
+    Array containing the ``X`` coordinates of ``count`` evaluation
+    points
+
+Parameter ``y``:
+    Array containing the ``Y`` coordinates of ``count`` evaluation
+    points
+
+Parameter ``out``:
+    Array receiving the ``count`` interpolated values)doc";
+
 static const char *__doc_mitsuba_spline_eval_spline =
 R"doc(Compute the definite integral and derivative of a cubic spline that is
 parameterized by the function values and derivatives at the endpoints
@@ -9640,6 +11758,50 @@ Returns:
     position (which only differs from item 2. when the function does
     not integrate to one))doc";
 
+static const char *__doc_mitsuba_spline_sample_1d_batch =
+R"doc(Importance sample ``count`` positions of a *uniformly* sampled 1D
+Catmull-Rom spline interpolant
+
+This is equivalent to calling sample_1d() for every entry of
+``sample``, but processes the queries in SIMD packets. See sample_1d()
+for a description of the remaining parameters.
+
+Parameter ``sample``:
+    Array containing ``count`` uniformly distributed random samples
+
+Parameter ``pos``:
+    Array receiving the sampled positions
+
+Parameter ``fval``:
+    Optional array receiving the value of the spline at the sampled
+    positions (may be ``nullptr``)
+
+Parameter ``pdf``:
+    Optional array receiving the probability density at the sampled
+    positions (may be ``nullptr``))doc";
+
+static const char *__doc_mitsuba_spline_sample_1d_batch_2 =
+R"doc(Importance sample ``count`` positions of a *non-uniformly* sampled 1D
+Catmull-Rom spline interpolant
+
+This is equivalent to calling sample_1d() for every entry of
+``sample``, but processes the queries in SIMD packets. See sample_1d()
+for a description of the remaining parameters.
+
+Parameter ``sample``:
+    Array containing ``count`` uniformly distributed random samples
+
+Parameter ``pos``:
+    Array receiving the sampled positions
+
+Parameter ``fval``:
+    Optional array receiving the value of the spline at the sampled
+    positions (may be ``nullptr``)
+
+Parameter ``pdf``:
+    Optional array receiving the probability density at the sampled
+    positions (may be ``nullptr``))doc";
+
 static const char *__doc_mitsuba_srgb_model_eval = R"doc()doc";
 
 static const char *__doc_mitsuba_srgb_model_fetch =
@@ -9717,6 +11879,9 @@ static const char *__doc_mitsuba_util_library_path = R"doc(Return the absolute p
 
 static const char *__doc_mitsuba_util_mem_string = R"doc(Turn a memory size into a human-readable string)doc";
 
+static const char *__doc_mitsuba_util_peak_memory_usage =
+R"doc(Return the peak resident memory of the process in bytes (0 if unknown))doc";
+
 static const char *__doc_mitsuba_util_terminal_width = R"doc(Determine the width of the terminal window that is used to run Mitsuba)doc";
 
 static const char *__doc_mitsuba_util_time_string =
@@ -9910,6 +12075,49 @@ static const char *__doc_mitsuba_warp_uniform_triangle_to_square = R"doc(Inverse
 
 static const char *__doc_mitsuba_warp_von_mises_fisher_to_square = R"doc(Inverse of the mapping von_mises_fisher_to_square)doc";
 
+static const char *__doc_mitsuba_xml_InstanceCache =
+R"doc(Objects created by a previous call to load_file(), which are reused
+when the same scene is loaded again with different parameters
+
+This speeds up the rendering of parameter sweeps. After parsing, every
+node of the scene description is compared to the one with the same ID
+in the previous load:
+
+- When the properties and referenced objects are identical, the
+previous object is reused.
+
+- When only floating point properties differ, and the previous object
+exposes them through Object::traverse() (either directly or as the
+``value`` of a uniform texture with the same name), the new values are
+written in place and Object::parameters_changed() is called.
+
+- Otherwise, the object is instantiated again. This also applies to its
+parents, whose references changed.
+
+Reused objects keep any state acquired since they were created, and
+files referenced by the scene are not checked for modifications.)doc";
+
+static const char *__doc_mitsuba_xml_InstanceCache_InstanceCache = R"doc()doc";
+
+static const char *__doc_mitsuba_xml_InstanceCache_class = R"doc()doc";
+
+static const char *__doc_mitsuba_xml_InstanceCache_created = R"doc(Number of objects created by the last load)doc";
+
+static const char *__doc_mitsuba_xml_InstanceCache_data = R"doc()doc";
+
+static const char *__doc_mitsuba_xml_InstanceCache_m_data = R"doc()doc";
+
+static const char *__doc_mitsuba_xml_InstanceCache_reused = R"doc(Number of objects reused without changes by the last load)doc";
+
+static const char *__doc_mitsuba_xml_InstanceCache_updated =
+R"doc(Number of objects updated through Object::parameters_changed() by the
+last load)doc";
+
+static const char *__doc_mitsuba_xml_cache_dir =
+R"doc(Return the directory of the scene cache (empty when the cache is disabled))doc";
+
+static const char *__doc_mitsuba_xml_deduplication = R"doc(Are identical BSDFs and textures shared? (see set_deduplication()))doc";
+
 static const char *__doc_mitsuba_xml_detail_create_texture_from_rgb = R"doc(Create a Texture object from RGB values)doc";
 
 static const char *__doc_mitsuba_xml_detail_create_texture_from_spectrum =
@@ -9932,10 +12140,41 @@ Parameter ``variant``:
 
 Parameter ``update_scene``:
     When Mitsuba updates scene to a newer version, should the updated
-    XML file be written back to disk?)doc";
+    XML file be written back to disk?
+
+Parameter ``cache``:
+    Optional cache of the objects of a previous load of the same scene,
+    which is updated with the objects of this one (see InstanceCache))doc";
 
 static const char *__doc_mitsuba_xml_load_string = R"doc(Load a Mitsuba scene from an XML string)doc";
 
+static const char *__doc_mitsuba_xml_set_cache_dir =
+R"doc(Set the directory of the scene cache
+
+When a cache directory is specified, `load_file()` stores the parsed
+scene descriptions (i.e. the objects and their properties, before
+instantiation) in a binary format, and subsequent loads of the same file
+with the same variant and parameters skip the XML parsing stage. Entries
+are invalidated when the scene file, one of its included files or one of
+the spectrum files that it references changes. An empty path disables the
+cache (the default).)doc";
+
+static const char *__doc_mitsuba_xml_set_deduplication =
+R"doc(Share identical BSDFs and textures between their users
+
+Exported scenes often contain many identical material definitions.
+When enabled, the loader compares the plugin name and properties of
+every BSDF and texture node (including the RGB and spectrum values
+that are turned into textures) with the ones created before during the
+same load, and reuses the existing object when they are identical. The
+node IDs are not compared. Since nested objects are shared first, the
+comparison of their parents extends to the objects that they
+reference. Objects whose ``shared`` property is ``false`` (see the
+bitmap texture) are never shared.
+
+Shared objects are only exposed once by Object::traverse(), hence this
+is disabled by default.)doc";
+
 static const char *__doc_mitsuba_xyz_to_srgb = R"doc(Convert XYZ tristimulus values to ITU-R Rec. BT.709 linear RGB)doc";
 
 static const char *__doc_mitsuba_xyz_to_srgb_2 = R"doc(Convert XYZ tristimulus values to ITU-R Rec. BT.709 linear RGB)doc";
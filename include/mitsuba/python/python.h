@@ -59,6 +59,8 @@ PYBIND11_DECLARE_HOLDER_TYPE(T, mitsuba::ref<T>, true);
         [](const std::string &name, std::function<py::object(const Properties *)> &constructor) {  \
             (void) new Class(name, #Name, ::mitsuba::detail::get_variant<Float, Spectrum>(),       \
                             [=](const Properties &p) {                                             \
+                                /* Scenes are loaded with the GIL released */                      \
+                                py::gil_scoped_acquire gil;                                        \
                                 py::object o = constructor(&p);                                    \
                                 return o.release().cast<ref<Name>>();                              \
                             },                                                                     \
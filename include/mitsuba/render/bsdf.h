@@ -92,6 +92,9 @@ enum class BSDFFlags : uint32_t {
     /// Does the implementation require access to texture-space differentials
     NeedsDifferentials   = 0x20000,
 
+    /// The lobe changes the polarization state of light (polarized variants only)
+    Polarizing           = 0x40000,
+
     // =============================================================
     //!                 Compound lobe attributes
     // =============================================================
@@ -393,6 +396,34 @@ public:
                       const Vector3f &wo,
                       Mask active = true) const = 0;
 
+    /**
+     * \brief Jointly evaluate the BSDF and the probability per unit solid
+     * angle of sampling a given direction
+     *
+     * This method is equivalent to calling \ref eval() and \ref pdf() with
+     * the same arguments, but lets the implementation share the work that is
+     * common to both (e.g. microfacet terms, Fresnel factors, and texture
+     * lookups). The default implementation simply calls the two methods.
+     *
+     * \param ctx
+     *     A context data structure describing which lobes to evalute,
+     *     and whether radiance or importance are being transported.
+     *
+     * \param si
+     *     A surface interaction data structure describing the underlying
+     *     surface position. The incident direction is obtained from
+     *     the field <tt>si.wi</tt>.
+     *
+     * \param wo
+     *     The outgoing direction
+     *
+     * \return A pair with the BSDF value and the sampling density
+     */
+    virtual std::pair<Spectrum, Float> eval_pdf(const BSDFContext &ctx,
+                                                const SurfaceInteraction3f &si,
+                                                const Vector3f &wo,
+                                                Mask active = true) const;
+
     /**
      * \brief Evaluate un-scattered transmission component of the BSDF
      *
@@ -524,6 +555,7 @@ ENOKI_CALL_SUPPORT_TEMPLATE_BEGIN(mitsuba::BSDF)
     ENOKI_CALL_SUPPORT_METHOD(eval)
     ENOKI_CALL_SUPPORT_METHOD(eval_null_transmission)
     ENOKI_CALL_SUPPORT_METHOD(pdf)
+    ENOKI_CALL_SUPPORT_METHOD(eval_pdf)
     ENOKI_CALL_SUPPORT_GETTER(flags, m_flags)
 
     auto needs_differentials() const {
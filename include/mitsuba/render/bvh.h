@@ -0,0 +1,481 @@
+#pragma once
+
+#include <mitsuba/core/bbox.h>
+#include <mitsuba/core/fwd.h>
+#include <mitsuba/core/object.h>
+#include <mitsuba/core/ray.h>
+#include <mitsuba/core/vector.h>
+#include <mitsuba/render/interaction.h>
+#include <mitsuba/render/mesh.h>
+#include <mitsuba/render/shape.h>
+#include <enoki/array.h>
+
+/// Compile-time BVH depth limit to enable traversal with stack memory
+#define MTS_BVH_MAXDEPTH 48u
+
+/// Number of children of a BVH node: matches the SIMD width of the host
+#if defined(ENOKI_X86_AVX)
+#  define MTS_BVH_WIDTH 8u
+#else
+#  define MTS_BVH_WIDTH 4u
+#endif
+
+/// Size of the traversal stack (each visited node pushes at most MTS_BVH_WIDTH entries)
+#define MTS_BVH_STACK_SIZE (MTS_BVH_MAXDEPTH * MTS_BVH_WIDTH)
+
+/// Grain size for TBB parallelization
+#define MTS_BVH_GRAIN_SIZE 4096u
+
+NAMESPACE_BEGIN(mitsuba)
+
+/**
+ * \brief Wide bounding volume hierarchy over the primitives of a set of shapes
+ *
+ * This is an alternative to \ref ShapeKDTree for the native (i.e. non-Embree)
+ * CPU ray tracing backend, which is selected using the \c accel parameter of
+ * the scene. The hierarchy is built top-down using the binned surface area
+ * heuristic in parallel, which is considerably faster than the exact split
+ * search of the kd-tree on large scenes. The resulting binary tree is then
+ * collapsed into nodes with \ref MTS_BVH_WIDTH children (8 on AVX, 4 on
+ * SSE/NEON machines), whose bounding boxes are stored in SoA layout so that
+ * scalar rays can test all children of a node with a single SIMD slab test.
+ *
+ * Primitives are accessed through the same interface as \ref ShapeKDTree,
+ * i.e. \ref Shape::bbox() during construction, and \ref
+ * Mesh::ray_intersect_triangle() or \ref Shape::ray_intersect_primitive()
+ * during traversal.
+ *
+ * When some of the shapes move (see \ref Shape::has_motion()), the nodes
+ * store the bounds of their children at the start and at the end of the
+ * motion (see \ref Shape::bbox_motion()), and the traversal interpolates
+ * them at the time of the ray. The topology is built from the bounds swept
+ * over the whole motion.
+ */
+template <typename Float, typename Spectrum>
+class MTS_EXPORT_RENDER ShapeBVH : public Object {
+public:
+    MTS_IMPORT_TYPES(Shape, Mesh)
+
+    using Size  = uint32_t;
+    using Index = uint32_t;
+
+    /// Child index of unused node slots
+    static constexpr Index InvalidChild = (Index) -1;
+
+    /// Bounding boxes of the children of a node
+    struct alignas(64) NodeBounds {
+        /// Child bounding boxes in SoA layout: <tt>bounds[min/max][axis][child]</tt>
+        ScalarFloat bounds[2][3][MTS_BVH_WIDTH];
+    };
+
+    /// BVH node storing the bounding boxes of up to \ref MTS_BVH_WIDTH children
+    struct alignas(64) Node : NodeBounds {
+        /// Index of an inner child node or offset of the primitives of a leaf
+        Index child[MTS_BVH_WIDTH];
+        /// Number of primitives of a leaf (zero for inner nodes and unused slots)
+        Index count[MTS_BVH_WIDTH];
+    };
+
+    /// Create an empty BVH and take build-related parameters from \c props.
+    ShapeBVH(const Properties &props);
+
+    /// Register a new shape with the BVH (to be called before \ref build())
+    void add_shape(Shape *shape);
+
+    /// Build the BVH
+    void build();
+
+    /**
+     * \brief Rebuild the BVH following a change of the registered shapes
+     *
+     * Refreshes the primitive map and the bounding box from the current
+     * state of the shapes before building a new hierarchy.
+     */
+    void rebuild();
+
+    /**
+     * \brief Refit the BVH following a deformation of the registered shapes
+     *
+     * Keeps the topology of the hierarchy and only recomputes the bounding
+     * boxes of its nodes bottom-up, which takes a fraction of the time of
+     * \ref rebuild(). The traversal cost grows when primitives move far
+     * from their original position. Falls back to \ref rebuild() when the
+     * primitive count of a shape changed.
+     */
+    void refit();
+
+    /// Return the number of registered shapes
+    Size shape_count() const { return Size(m_shapes.size()); }
+
+    /// Return the number of registered primitives
+    Size primitive_count() const { return m_primitive_map.back(); }
+
+    /// Return the i-th shape (const version)
+    const Shape *shape(size_t i) const { Assert(i < m_shapes.size()); return m_shapes[i]; }
+
+    /// Return the i-th shape
+    Shape *shape(size_t i) { Assert(i < m_shapes.size()); return m_shapes[i]; }
+
+    /// Return the bounding box of all registered shapes
+    const ScalarBoundingBox3f &bbox() const { return m_bbox; }
+
+    /// Return the bounding box of the i-th primitive
+    ScalarBoundingBox3f bbox(Index i) const {
+        Index shape_index = find_shape(i);
+        return m_shapes[shape_index]->bbox(i);
+    }
+
+    /**
+     * \brief Return the bounding boxes of the i-th primitive at the start and
+     * at the end of the motion of the BVH (see \ref motion_time_range())
+     */
+    std::pair<ScalarBoundingBox3f, ScalarBoundingBox3f> bbox_motion(Index i) const {
+        Index shape_index = find_shape(i);
+        return m_shapes[shape_index]->bbox_motion(i, m_motion_time_range.x(),
+                                                  m_motion_time_range.y());
+    }
+
+    /// Does the BVH interpolate its bounds along the time of the rays?
+    bool has_motion() const { return !m_motion_bounds.empty(); }
+
+    /// Return the time interval spanned by the motion of the shapes
+    const ScalarVector2f &motion_time_range() const { return m_motion_time_range; }
+
+    /// Has the BVH been built?
+    bool ready() const { return m_ready; }
+
+    template <bool ShadowRay>
+    MTS_INLINE PreliminaryIntersection3f ray_intersect_preliminary(const Ray3f &ray,
+                                                                   Mask active) const {
+        ENOKI_MARK_USED(active);
+        if constexpr (!is_array_v<Float>)
+            return ray_intersect_scalar<ShadowRay>(ray);
+        else
+            return ray_intersect_packet<ShadowRay>(ray, active);
+    }
+
+    template <bool ShadowRay>
+    MTS_INLINE PreliminaryIntersection3f ray_intersect_scalar(Ray3f ray) const {
+        using Vector = enoki::Array<ScalarFloat, MTS_BVH_WIDTH>;
+
+        /// Ray traversal stack entry
+        struct BVHStackEntry {
+            // Ray distance to the entry point of the child's bounding box
+            ScalarFloat mint;
+            // Child index / primitive offset and primitive count (see \ref Node)
+            Index child, count;
+        };
+
+        PreliminaryIntersection3f pi;
+        if (unlikely(m_nodes.empty()))
+            return pi;
+
+        /* Select the near and far planes of the child bounding boxes along
+           each axis: the near plane is the maximum for negative directions */
+        size_t near_max[3];
+        Vector o[3], d_rcp[3];
+        for (size_t a = 0; a < 3; ++a) {
+            near_max[a] = ray.d_rcp[a] < 0.f ? 1 : 0;
+            o[a]        = Vector(ray.o[a]);
+            d_rcp[a]    = Vector(ray.d_rcp[a]);
+        }
+
+        // Interpolate the child bounds of moving shapes at the time of the ray
+        bool motion = has_motion();
+        ScalarFloat alpha = motion_alpha(ray.time);
+        auto bounds = [&](Index n, size_t side, size_t a) ENOKI_INLINE_LAMBDA {
+            Vector b = load<Vector>(m_nodes[n].bounds[side][a]);
+            if (motion)
+                b = fmadd(load<Vector>(m_motion_bounds[n].bounds[side][a]) - b, alpha, b);
+            return b;
+        };
+
+        BVHStackEntry stack[MTS_BVH_STACK_SIZE];
+        int32_t stack_index = 0;
+        stack[stack_index++] = { ray.mint, 0, 0 };
+
+        const Index *indices = m_indices.data();
+        while (stack_index > 0) {
+            const BVHStackEntry entry = stack[--stack_index];
+            if (entry.mint > ray.maxt)
+                continue;
+
+            if (entry.count > 0) { // Arrived at a leaf
+                Index prim_end = entry.child + entry.count;
+                for (Index i = entry.child; i < prim_end; i++) {
+                    PreliminaryIntersection3f prim_pi =
+                        intersect_prim<ShadowRay>(indices[i], ray, true);
+
+                    if (unlikely(prim_pi.is_valid())) {
+                        if constexpr (ShadowRay)
+                            return prim_pi;
+
+                        Assert(prim_pi.t >= ray.mint && prim_pi.t <= ray.maxt);
+                        pi = prim_pi;
+                        ray.maxt = pi.t;
+                    }
+                }
+                continue;
+            }
+
+            /* Slab test against all children at once. The slab distance is
+               the first argument of min/max so that NaNs (which arise from
+               0 * inf) leave the current interval unchanged. */
+            const Node &node = m_nodes[entry.child];
+            Vector t_near = Vector(ray.mint),
+                   t_far  = Vector(ray.maxt);
+            for (size_t a = 0; a < 3; ++a) {
+                t_near = enoki::max((bounds(entry.child, near_max[a], a) - o[a]) * d_rcp[a], t_near);
+                t_far  = enoki::min((bounds(entry.child, 1 - near_max[a], a) - o[a]) * d_rcp[a], t_far);
+            }
+
+            alignas(64) ScalarFloat t_near_s[MTS_BVH_WIDTH], t_far_s[MTS_BVH_WIDTH];
+            store(t_near_s, t_near);
+            store(t_far_s, t_far);
+
+            /* Push the intersected children so that the closest one is
+               visited first (insertion sort on the entry distance) */
+            int32_t first = stack_index;
+            for (size_t i = 0; i < MTS_BVH_WIDTH; ++i) {
+                if (!(t_near_s[i] <= t_far_s[i]))
+                    continue;
+                BVHStackEntry child { t_near_s[i], node.child[i], node.count[i] };
+                int32_t j = stack_index++;
+                while (j > first && stack[j - 1].mint < child.mint) {
+                    stack[j] = stack[j - 1];
+                    --j;
+                }
+                stack[j] = child;
+            }
+        }
+
+        return pi;
+    }
+
+    template <bool ShadowRay>
+    MTS_INLINE PreliminaryIntersection3f ray_intersect_packet(Ray3f ray,
+                                                              Mask active) const {
+        /// Ray traversal stack entry
+        struct BVHStackEntry {
+            // Smallest distance to the entry point of the child's bounding box
+            ScalarFloat mint;
+            // Is the corresponding SIMD lane enabled?
+            Mask active;
+            // Child index / primitive offset and primitive count (see \ref Node)
+            Index child, count;
+        };
+
+        PreliminaryIntersection3f pi;
+        if (unlikely(m_nodes.empty()))
+            return pi;
+
+        // Select the near and far planes of the child bounding boxes along each axis
+        Mask near_max[3];
+        for (size_t a = 0; a < 3; ++a)
+            near_max[a] = ray.d_rcp[a] < 0.f;
+
+        bool motion = has_motion();
+        Float alpha = motion_alpha(ray.time);
+
+        BVHStackEntry stack[MTS_BVH_STACK_SIZE];
+        int32_t stack_index = 0;
+        stack[stack_index++] = { -math::Infinity<ScalarFloat>, active, 0, 0 };
+
+        const Index *indices = m_indices.data();
+        while (stack_index > 0) {
+            const BVHStackEntry entry = stack[--stack_index];
+            active = entry.active;
+            if constexpr (ShadowRay)
+                active &= !pi.is_valid();
+            if (none(active))
+                continue;
+
+            if (entry.count > 0) { // Arrived at a leaf
+                Index prim_end = entry.child + entry.count;
+                for (Index i = entry.child; i < prim_end; i++) {
+                    PreliminaryIntersection3f prim_pi =
+                        intersect_prim<ShadowRay>(indices[i], ray, active);
+
+                    masked(pi, prim_pi.is_valid()) = prim_pi;
+
+                    if constexpr (!ShadowRay) {
+                        Assert(all(!prim_pi.is_valid() ||
+                                   (prim_pi.t >= ray.mint &&
+                                    prim_pi.t <= ray.maxt)));
+                        masked(ray.maxt, prim_pi.is_valid()) = prim_pi.t;
+                    }
+                }
+                continue;
+            }
+
+            const Node &node = m_nodes[entry.child];
+            const NodeBounds *node_end = motion ? &m_motion_bounds[entry.child] : nullptr;
+            int32_t first = stack_index;
+            for (size_t i = 0; i < MTS_BVH_WIDTH; ++i) {
+                if (node.count[i] == 0 && node.child[i] == InvalidChild)
+                    continue;
+
+                Float t_near = ray.mint,
+                      t_far  = ray.maxt;
+                for (size_t a = 0; a < 3; ++a) {
+                    Float b_min = node.bounds[0][a][i],
+                          b_max = node.bounds[1][a][i];
+                    if (motion) {
+                        b_min = fmadd(node_end->bounds[0][a][i] - b_min, alpha, b_min);
+                        b_max = fmadd(node_end->bounds[1][a][i] - b_max, alpha, b_max);
+                    }
+                    Float t_min = (b_min - ray.o[a]) * ray.d_rcp[a],
+                          t_max = (b_max - ray.o[a]) * ray.d_rcp[a];
+                    t_near = enoki::max(select(near_max[a], t_max, t_min), t_near);
+                    t_far  = enoki::min(select(near_max[a], t_min, t_max), t_far);
+                }
+
+                Mask hit = active && t_near <= t_far;
+                if (none(hit))
+                    continue;
+
+                BVHStackEntry child { hmin(select(hit, t_near, math::Infinity<Float>)),
+                                      hit, node.child[i], node.count[i] };
+                int32_t j = stack_index++;
+                while (j > first && stack[j - 1].mint < child.mint) {
+                    stack[j] = stack[j - 1];
+                    --j;
+                }
+                stack[j] = child;
+            }
+        }
+
+        return pi;
+    }
+
+    /// Brute force intersection routine for debugging purposes
+    template <bool ShadowRay>
+    MTS_INLINE PreliminaryIntersection3f ray_intersect_naive(Ray3f ray,
+                                                             Mask active) const {
+        PreliminaryIntersection3f pi;
+
+        for (Size i = 0; i < primitive_count(); ++i) {
+            PreliminaryIntersection3f prim_pi =
+                intersect_prim<ShadowRay>(i, ray, active);
+
+            if constexpr (is_array_v<Float>) {
+                masked(pi, prim_pi.is_valid()) = prim_pi;
+            } else if (prim_pi.is_valid()) {
+                pi = prim_pi;
+                ray.maxt = prim_pi.t;
+            }
+
+            if (ShadowRay && all(pi.is_valid() || !active))
+                break;
+        }
+
+        return pi;
+    }
+
+    /// Return a human-readable string representation of the scene contents.
+    virtual std::string to_string() const override;
+
+    MTS_DECLARE_CLASS()
+protected:
+    /**
+     * \brief Map an abstract primitive index to a specific shape managed by
+     * the \ref ShapeBVH.
+     *
+     * The function returns the shape index and updates the \a idx parameter to
+     * point to the primitive index (e.g. triangle ID) within the shape.
+     */
+    MTS_INLINE Index find_shape(Index &i) const {
+        Assert(i < primitive_count());
+
+        Index shape_index = math::find_interval(
+            Size(m_primitive_map.size()),
+            [&](Index k) ENOKI_INLINE_LAMBDA {
+                return m_primitive_map[k] <= i;
+            }
+        );
+
+        Assert(shape_index < shape_count() &&
+               m_primitive_map.size() == shape_count() + 1);
+
+        Assert(i >= m_primitive_map[shape_index]);
+        Assert(i <  m_primitive_map[shape_index + 1]);
+        i -= m_primitive_map[shape_index];
+
+        return shape_index;
+    }
+
+    /// Relative position of \c time within the motion of the BVH
+    template <typename Value> MTS_INLINE Value motion_alpha(const Value &time) const {
+        return clamp((time - m_motion_time_range.x()) * m_motion_time_scale, 0.f, 1.f);
+    }
+
+    /**
+     * \brief Recompute the child bounds of all nodes bottom-up from the
+     * primitives (see \ref refit()), including the bounds at the end of the
+     * motion when the BVH has motion
+     */
+    void update_bounds();
+
+    /// Determine the time interval spanned by the motion of the shapes
+    bool update_motion_time_range();
+
+    /// Check whether a primitive is intersected by the given ray (see \ref ShapeKDTree)
+    template <bool ShadowRay = false>
+    MTS_INLINE PreliminaryIntersection3f
+    intersect_prim(Index prim_index, const Ray3f &ray, Mask active) const {
+        Index shape_index  = find_shape(prim_index);
+        const Shape *shape = this->shape(shape_index);
+
+        PreliminaryIntersection3f pi;
+
+        if constexpr (ShadowRay) {
+            Mask hit;
+            if (shape->is_mesh()) {
+                const Mesh *mesh = (const Mesh *) shape;
+                hit = mesh->ray_intersect_triangle(prim_index, ray, active).is_valid();
+            } else {
+                hit = shape->ray_test_primitive(prim_index, ray, active);
+            }
+
+            // Shadow rays only report the occluder (see \ref Scene::ray_test())
+            pi.t = select(hit, Float(0.f), math::Infinity<Float>);
+            pi.prim_index = prim_index;
+            pi.shape = shape;
+            return pi;
+        } else {
+            if (shape->is_mesh()) {
+                const Mesh *mesh = (const Mesh *) shape;
+                pi = mesh->ray_intersect_triangle(prim_index, ray, active);
+            } else {
+                pi = shape->ray_intersect_primitive(prim_index, ray, active);
+            }
+
+            return pi;
+        }
+    }
+
+protected:
+    std::vector<ref<Shape>> m_shapes;
+    std::vector<Size> m_primitive_map;
+    ScalarBoundingBox3f m_bbox;
+
+    /// BVH nodes (the root is stored at index 0)
+    std::vector<Node> m_nodes;
+    /// Primitive indices referenced by the leaves
+    std::vector<Index> m_indices;
+    /// Child bounds of each node at the end of the motion (empty without motion)
+    std::vector<NodeBounds> m_motion_bounds;
+    /// Time interval of the motion and its reciprocal length
+    ScalarVector2f m_motion_time_range = 0.f;
+    ScalarFloat m_motion_time_scale = 0.f;
+    bool m_ready;
+
+    /// Build parameters
+    Size m_max_leaf_size;
+    Size m_bin_count;
+    ScalarFloat m_traversal_cost;
+    ScalarFloat m_intersection_cost;
+};
+
+MTS_EXTERN_CLASS_RENDER(ShapeBVH)
+NAMESPACE_END(mitsuba)
@@ -0,0 +1,145 @@
+#pragma once
+
+#include <mitsuba/core/object.h>
+#include <mitsuba/core/vector.h>
+#include <mitsuba/render/fwd.h>
+
+NAMESPACE_BEGIN(mitsuba)
+
+/**
+ * \brief Texture object that performs lookups through the texture units of
+ * the GPU
+ *
+ * The values of a 2D or 3D grid are stored in a CUDA array, which is laid out
+ * for spatially coherent accesses. Lookups take normalized coordinates in
+ * \f$[0, 1]^n\f$ and are resolved by the texture hardware, which implements
+ * nearest neighbor lookups, bi- or trilinear interpolation and the wrap modes,
+ * and which has a dedicated cache. The grid coordinates are mapped to texels
+ * like the software lookups of the \c bitmap and \c gridvolume plugins, i.e.
+ * <tt>floor(p * resolution)</tt> for nearest neighbor lookups and
+ * <tt>p * resolution - 0.5</tt> for interpolated ones.
+ *
+ * The hardware computes the interpolation weights with 8 bits of fractional
+ * precision, and its lookups are not differentiable: callers must use a
+ * software implementation when gradients with respect to the values or the
+ * coordinates are needed.
+ *
+ * Texture objects are only available when Mitsuba is compiled with GPU
+ * support (\c MTS_ENABLE_OPTIX), the constructor raises an exception
+ * otherwise.
+ *
+ * \ingroup librender
+ */
+class MTS_EXPORT_RENDER CUDATexture : public Object {
+public:
+    /// Interpolation performed by the texture hardware
+    enum class FilterMode { Nearest, Linear };
+
+    /// Handling of coordinates outside of \f$[0, 1]\f$
+    enum class WrapMode { Repeat, Mirror, Clamp };
+
+    /**
+     * \brief Create a texture object and upload its values
+     *
+     * \param dimension
+     *    Number of dimensions of the grid (2 or 3)
+     *
+     * \param shape
+     *    Resolution of the grid along its \c dimension axes (x first)
+     *
+     * \param channels
+     *    Number of channels (1 to 4). Textures with 3 channels are padded
+     *    to 4 channels on the GPU.
+     *
+     * \param data
+     *    Host-accessible values of the grid in row-major order with
+     *    interleaved channels, i.e. the value of channel \c c of texel
+     *    <tt>(x, y)</tt> is <tt>data[(y * shape[0] + x) * channels + c]</tt>.
+     */
+    CUDATexture(size_t dimension, const size_t *shape, size_t channels, const float *data,
+                FilterMode filter_mode, WrapMode wrap_mode);
+
+    /// Replace the values of the texture (same layout as in the constructor)
+    void set_data(const float *data);
+
+    /**
+     * \brief Perform \c size lookups on the GPU
+     *
+     * \param pos
+     *    Device pointers to the \c dimension coordinates of the lookups
+     *
+     * \param out
+     *    Device pointers to the arrays receiving the \c channels values
+     *
+     * The lookups are enqueued on the default CUDA stream, i.e. they are
+     * ordered with the kernels launched by Enoki.
+     */
+    void eval(const float *const *pos, float *const *out, size_t size) const;
+
+    /**
+     * \brief Convenience wrapper of \ref eval() that looks up the texture at
+     * the coordinates stored in a point of Enoki CUDA arrays
+     *
+     * The coordinates are detached from the AD graph. The result is
+     * returned as an array of \c Channels CUDA arrays.
+     */
+    template <size_t Channels, typename Point>
+    auto eval(const Point &p_) const {
+        using Float  = value_t<Point>;
+        using FloatC = std::decay_t<decltype(detach(std::declval<Float>()))>;
+        using Result = Array<FloatC, Channels>;
+        constexpr size_t Dimension = array_size_v<Point>;
+
+        auto p = detach(p_);
+        size_t size = slices(p);
+        Result result = empty<Result>(size);
+
+        // Ensure that the coordinates and the result are allocated
+        cuda_eval();
+
+        const float *pos[Dimension];
+        float *out[Channels];
+        for (size_t i = 0; i < Dimension; ++i)
+            pos[i] = p[i].data();
+        for (size_t i = 0; i < Channels; ++i)
+            out[i] = result[i].data();
+
+        eval(pos, out, size);
+        return result;
+    }
+
+    /// Return the number of dimensions of the grid
+    size_t dimension() const { return m_dimension; }
+
+    /// Return the number of channels
+    size_t channels() const { return m_channels; }
+
+    /// Return the resolution of the grid along axis \c i
+    size_t shape(size_t i) const { return m_shape[i]; }
+
+    /// Return the memory used by the CUDA array in bytes
+    size_t size_bytes() const;
+
+    /// Return a human-readable representation
+    std::string to_string() const override;
+
+    MTS_DECLARE_CLASS()
+protected:
+    virtual ~CUDATexture();
+
+protected:
+    size_t m_dimension;
+    size_t m_shape[3];
+    size_t m_channels;
+    FilterMode m_filter_mode;
+    WrapMode m_wrap_mode;
+
+    /// CUDA array and texture object (\c CUarray and \c CUtexObject handles)
+    void *m_array = nullptr;
+    unsigned long long m_texture = 0;
+};
+
+extern MTS_EXPORT_RENDER std::ostream &operator<<(std::ostream &os, CUDATexture::FilterMode value);
+extern MTS_EXPORT_RENDER std::ostream &operator<<(std::ostream &os, CUDATexture::WrapMode value);
+
+NAMESPACE_END(mitsuba)
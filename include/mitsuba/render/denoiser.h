@@ -0,0 +1,112 @@
+#pragma once
+
+#include <mitsuba/core/bitmap.h>
+#include <mitsuba/core/object.h>
+#include <mitsuba/render/fwd.h>
+
+NAMESPACE_BEGIN(mitsuba)
+
+/**
+ * \brief Removes the Monte Carlo noise from developed images
+ *
+ * The denoiser operates on high dynamic range images, and optionally uses
+ * the albedo and the shading normals of the visible surfaces (e.g. produced
+ * by the \c aov integrator) as guides. These feature images are mostly
+ * noise-free, which lets the denoiser preserve the edges and the texture
+ * detail that the noisy image alone does not resolve.
+ *
+ * Two backends are available: Intel Open Image Denoise (when Mitsuba is
+ * compiled with \c MTS_ENABLE_OIDN), which is based on a pretrained neural
+ * network, and a built-in edge-avoiding à-trous wavelet filter that has no
+ * external dependencies.
+ *
+ * \ingroup librender
+ */
+class MTS_EXPORT_RENDER Denoiser : public Object {
+public:
+    using Float = float;
+    MTS_IMPORT_CORE_TYPES()
+
+    /// Denoising algorithms
+    enum class Backend {
+        /// Intel Open Image Denoise when available, the built-in filter otherwise
+        Auto,
+
+        /// Built-in edge-avoiding à-trous wavelet filter
+        Builtin,
+
+        /// Intel Open Image Denoise
+        OIDN
+    };
+
+    /**
+     * \brief Create a denoiser
+     *
+     * \param backend
+     *    Denoising algorithm. Requesting Open Image Denoise in a build that
+     *    does not support it raises an exception.
+     *
+     * \param strength
+     *    Scale factor of the tolerance of the built-in filter towards color
+     *    differences between neighboring pixels. Values above 1 remove more
+     *    noise at the cost of blurring features that are missing from the
+     *    guides. (Ignored by Open Image Denoise)
+     */
+    Denoiser(Backend backend = Backend::Auto, float strength = 1.f);
+
+    /**
+     * \brief Denoise an image
+     *
+     * All images must have the same size and use the \ref Struct::Type::Float32
+     * component format.
+     *
+     * \param color
+     *    Noisy image. Its first channel (for the \ref Bitmap::PixelFormat::Y
+     *    and \ref Bitmap::PixelFormat::YA pixel formats) or its first three
+     *    channels are denoised, any other channels are ignored.
+     *
+     * \param albedo
+     *    Optional albedo guide (first three channels)
+     *
+     * \param normal
+     *    Optional shading normal guide (first three channels). Open Image
+     *    Denoise only uses it in combination with an albedo guide.
+     *
+     * \return A bitmap with the \ref Bitmap::PixelFormat::Y or \ref
+     *    Bitmap::PixelFormat::RGB pixel format storing the denoised channels
+     */
+    ref<Bitmap> denoise(const Bitmap *color, const Bitmap *albedo = nullptr,
+                        const Bitmap *normal = nullptr) const;
+
+    /// Return the denoising algorithm (never \ref Backend::Auto)
+    Backend backend() const { return m_backend; }
+
+    /// Return the strength of the built-in filter
+    float strength() const { return m_strength; }
+
+    /// Was Mitsuba compiled with support for Intel Open Image Denoise?
+    static bool has_oidn();
+
+    /// Return a human-readable representation
+    std::string to_string() const override;
+
+    MTS_DECLARE_CLASS()
+protected:
+    virtual ~Denoiser();
+
+    /// Denoise interleaved RGB images using the built-in filter
+    void denoise_builtin(const Vector2i &size, const float *color,
+                         const float *albedo, const float *normal, float *output) const;
+
+    /// Denoise interleaved RGB images using Open Image Denoise
+    void denoise_oidn(const Vector2i &size, const float *color,
+                      const float *albedo, const float *normal, float *output) const;
+
+protected:
+    Backend m_backend;
+    float m_strength;
+};
+
+extern MTS_EXPORT_RENDER std::ostream &operator<<(std::ostream &os, Denoiser::Backend value);
+
+NAMESPACE_END(mitsuba)
@@ -0,0 +1,216 @@
+#pragma once
+
+#include <mitsuba/core/properties.h>
+#include <mitsuba/core/transform.h>
+#include <mitsuba/render/interaction.h>
+#include <mitsuba/render/srgb.h>
+#include <mitsuba/render/texture.h>
+
+NAMESPACE_BEGIN(mitsuba)
+
+/**
+ * \brief Constant texture (the \c uniform plugin)
+ *
+ * The definition lives in a header so that \ref dispatch_texture() can
+ * inline its evaluation into the BSDF plugins.
+ */
+template <typename Float, typename Spectrum>
+class UniformSpectrum final : public Texture<Float, Spectrum> {
+public:
+    MTS_IMPORT_BASE(Texture, m_texture_type)
+    MTS_IMPORT_TYPES(Texture)
+
+    UniformSpectrum(const Properties &props) : Texture(props) {
+        m_value = props.float_("value");
+        m_texture_type = TextureType::Uniform;
+    }
+
+    UnpolarizedSpectrum eval(const SurfaceInteraction3f &si,
+                             Mask active) const override {
+        MTS_MASKED_FUNCTION(ProfilerPhase::TextureEvaluate, active);
+
+        if constexpr (is_spectral_v<Spectrum>) {
+            auto active_w = (si.wavelengths >= MTS_WAVELENGTH_MIN) &&
+                            (si.wavelengths <= MTS_WAVELENGTH_MAX);
+
+            return select(active_w, UnpolarizedSpectrum(m_value),
+                                    UnpolarizedSpectrum(0.f));
+        } else {
+            return m_value;
+        }
+    }
+
+    Float eval_1(const SurfaceInteraction3f & /* it */, Mask active) const override {
+        MTS_MASKED_FUNCTION(ProfilerPhase::TextureEvaluate, active);
+        return m_value;
+    }
+
+    Wavelength pdf_spectrum(const SurfaceInteraction3f &si, Mask active) const override {
+        MTS_MASKED_FUNCTION(ProfilerPhase::TextureEvaluate, active);
+
+        if constexpr (is_spectral_v<Spectrum>) {
+            auto active_w = (si.wavelengths >= MTS_WAVELENGTH_MIN) &&
+                            (si.wavelengths <= MTS_WAVELENGTH_MAX);
+
+            return select(active_w,
+                Wavelength(1.f / (MTS_WAVELENGTH_MAX - MTS_WAVELENGTH_MIN)), Wavelength(0.f));
+        } else {
+            NotImplementedError("pdf");
+        }
+    }
+
+    std::pair<Wavelength, UnpolarizedSpectrum>
+    sample_spectrum(const SurfaceInteraction3f & /*si*/,
+                    const Wavelength &sample, Mask active) const override {
+        MTS_MASKED_FUNCTION(ProfilerPhase::TextureSample, active);
+
+        if constexpr (is_spectral_v<Spectrum>) {
+            return { MTS_WAVELENGTH_MIN + (MTS_WAVELENGTH_MAX - MTS_WAVELENGTH_MIN) * sample,
+                     m_value * (MTS_WAVELENGTH_MAX - MTS_WAVELENGTH_MIN) };
+        } else {
+            ENOKI_MARK_USED(sample);
+            NotImplementedError("sample");
+        }
+    }
+
+    ScalarFloat mean() const override { return scalar_cast(hmean(m_value)); }
+
+    void traverse(TraversalCallback *callback) override {
+        callback->put_parameter("value", m_value);
+    }
+
+    std::string to_string() const override {
+        return tfm::format("UniformSpectrum[value=%f]", m_value);
+    }
+
+    MTS_DECLARE_CLASS()
+private:
+    Float m_value;
+};
+
+/**
+ * \brief Constant sRGB reflectance (the \c srgb plugin)
+ *
+ * The definition lives in a header so that \ref dispatch_texture() can
+ * inline its evaluation into the BSDF plugins.
+ */
+template <typename Float, typename Spectrum>
+class SRGBReflectanceSpectrum final : public Texture<Float, Spectrum> {
+public:
+    MTS_IMPORT_BASE(Texture, m_texture_type)
+    MTS_IMPORT_TYPES(Texture)
+
+    SRGBReflectanceSpectrum(const Properties &props) : Texture(props) {
+        ScalarColor3f color = props.color("color");
+
+        if (any(color < 0 || color > 1) && !props.bool_("unbounded", false))
+            Throw("Invalid RGB reflectance value %s, must be in the range [0, 1]!", color);
+
+        if constexpr (is_spectral_v<Spectrum>) {
+            m_value = srgb_model_fetch(color);
+        } else if constexpr (is_rgb_v<Spectrum>) {
+            m_value = color;
+        } else {
+            static_assert(is_monochromatic_v<Spectrum>);
+            m_value = luminance(color);
+        }
+
+        m_texture_type = TextureType::SRGB;
+    }
+
+    UnpolarizedSpectrum eval(const SurfaceInteraction3f &si, Mask active) const override {
+        MTS_MASKED_FUNCTION(ProfilerPhase::TextureEvaluate, active);
+
+        if constexpr (is_spectral_v<Spectrum>)
+            return srgb_model_eval<UnpolarizedSpectrum>(m_value, si.wavelengths);
+        else
+            return m_value;
+    }
+
+    ScalarFloat mean() const override {
+        if constexpr (is_spectral_v<Spectrum>)
+            return scalar_cast(hmean(srgb_model_mean(m_value)));
+        else
+            return scalar_cast(hmean(hmean(m_value)));
+    }
+
+    void traverse(TraversalCallback *callback) override {
+        callback->put_parameter("value", m_value);
+    }
+
+    void parameters_changed(const std::vector<std::string> &/*keys*/) override {
+        if constexpr (!is_spectral_v<Spectrum>)
+            m_value = clamp(m_value, 0.f, 1.f);
+    }
+
+    std::string to_string() const override {
+        std::ostringstream oss;
+        oss << "SRGBReflectanceSpectrum[" << std::endl
+            << "  value = " << string::indent(m_value) << std::endl
+            << "]";
+        return oss.str();
+    }
+
+    MTS_DECLARE_CLASS()
+protected:
+    /**
+     * Depending on the compiled variant, this plugin either stores coefficients
+     * for a spectral upsampling model, or a plain RGB/monochromatic value.
+     */
+    static constexpr size_t ChannelCount = is_monochromatic_v<Spectrum> ? 1 : 3;
+
+    Color<Float, ChannelCount> m_value;
+};
+
+/**
+ * \brief Invoke \c func with a pointer to \c texture, whose static type
+ * is the final class of the plugin when it is one of the \ref TextureType
+ * entries
+ *
+ * The calls of \c func through such a pointer are not virtual and can be
+ * inlined, e.g. <tt>dispatch_texture(m_reflectance.get(), [&](auto *t) {
+ * return t->eval(si, active); })</tt>. Since most materials use constant
+ * parameters, this removes the texture lookups from the hot loop of the
+ * scalar variants.
+ *
+ * The type switch is only compiled when Mitsuba is built with
+ * <tt>MTS_ENABLE_DEVIRTUALIZATION</tt>, and in scalar variants (the cost
+ * of a virtual call is amortized over the lanes of the other ones).
+ * Otherwise, \c func is always called with the \ref Texture pointer.
+ */
+template <typename Float, typename Spectrum, typename Func>
+MTS_INLINE auto dispatch_texture(const Texture<Float, Spectrum> *texture, Func &&func) {
+#if defined(MTS_ENABLE_DEVIRTUALIZATION)
+    if constexpr (!is_array_v<Float>) {
+        switch (texture->texture_type()) {
+            case TextureType::Uniform:
+                return func(static_cast<const UniformSpectrum<Float, Spectrum> *>(texture));
+
+            case TextureType::SRGB:
+                return func(static_cast<const SRGBReflectanceSpectrum<Float, Spectrum> *>(texture));
+
+            default:
+                break;
+        }
+    }
+#endif
+    return func(texture);
+}
+
+/// Evaluate \c texture through \ref dispatch_texture()
+template <typename Float, typename Spectrum>
+MTS_INLINE auto eval_texture(const Texture<Float, Spectrum> *texture,
+                             const SurfaceInteraction<Float, Spectrum> &si,
+                             mask_t<Float> active = true) {
+    return dispatch_texture(texture, [&](auto *t) { return t->eval(si, active); });
+}
+
+/// Evaluate \c texture as a single-channel quantity through \ref dispatch_texture()
+template <typename Float, typename Spectrum>
+MTS_INLINE Float eval_texture_1(const Texture<Float, Spectrum> *texture,
+                                const SurfaceInteraction<Float, Spectrum> &si,
+                                mask_t<Float> active = true) {
+    return dispatch_texture(texture, [&](auto *t) { return t->eval_1(si, active); });
+}
+
+NAMESPACE_END(mitsuba)
@@ -61,6 +61,7 @@ template <typename Float, typename Spectrum>
 class MTS_EXPORT_RENDER Emitter : public Endpoint<Float, Spectrum> {
 public:
     MTS_IMPORT_BASE(Endpoint)
+    MTS_IMPORT_TYPES()
 
     /// Is this an environment map light emitter?
     bool is_environment() const {
@@ -70,6 +71,32 @@ public:
     /// Flags for all components combined.
     uint32_t flags(mask_t<Float> /*active*/ = true) const { return m_flags; }
 
+    /**
+     * \brief Return an estimate of the power emitted by the emitter
+     *
+     * This is used to importance sample among many emitters (see \ref
+     * Scene::sample_emitter_direction()) and only needs to be accurate up to
+     * a constant factor that is shared by all emitters. The default
+     * implementation returns 1.
+     */
+    virtual ScalarFloat power() const;
+
+    /**
+     * \brief Return a conservative bound of the directions of emission
+     *
+     * The result is a tuple <tt>(axis, cos_theta_o, cos_theta_e)</tt>: the
+     * normals (or main directions) of the emitter lie within the cone of
+     * half-angle \c theta_o around \c axis, and light is emitted within \c
+     * theta_e of them. The default implementation emits in all directions.
+     */
+    virtual std::tuple<ScalarVector3f, ScalarFloat, ScalarFloat> emission_cone() const;
+
+    /// Return the index of this emitter within \ref Scene::emitters()
+    uint32_t index() const { return m_index; }
+
+    /// Set the index of this emitter within \ref Scene::emitters() (called by the scene)
+    void set_index(uint32_t index) { m_index = index; }
+
 
     ENOKI_CALL_SUPPORT_FRIEND()
     MTS_DECLARE_CLASS()
@@ -81,6 +108,9 @@ protected:
 protected:
     /// Combined flags for all properties of this emitter.
     uint32_t m_flags;
+
+    /// Index of this emitter within the emitters of the scene
+    uint32_t m_index = 0;
 };
 
 MTS_EXTERN_CLASS_RENDER(Emitter)
@@ -98,6 +128,7 @@ ENOKI_CALL_SUPPORT_TEMPLATE_BEGIN(mitsuba::Emitter)
     ENOKI_CALL_SUPPORT_METHOD(pdf_direction)
     ENOKI_CALL_SUPPORT_METHOD(is_environment)
     ENOKI_CALL_SUPPORT_GETTER(flags, m_flags)
+    ENOKI_CALL_SUPPORT_GETTER(index, m_index)
 ENOKI_CALL_SUPPORT_TEMPLATE_END(mitsuba::Emitter)
 
 //! @}
@@ -4,6 +4,7 @@
 #include <mitsuba/core/logger.h>
 #include <mitsuba/core/object.h>
 #include <mitsuba/core/rfilter.h>
+#include <mitsuba/core/spectrum.h>
 #include <mitsuba/core/vector.h>
 #include <mitsuba/render/sampler.h>
 #include <mitsuba/render/fwd.h>
@@ -28,6 +29,45 @@ public:
     /// Merge an image block into the film. This methods should be thread-safe.
     virtual void put(const ImageBlock *block) = 0;
 
+    /**
+     * \brief Merge an image block into the film, given its position \c index
+     * in the sequence of blocks produced by the current rendering job
+     *
+     * The indices of a job must be unique and contiguous, starting at zero
+     * after \ref prepare(). Films may use them to accumulate the blocks in a
+     * fixed order (for instance, to obtain results that don't depend on the
+     * number of threads). The default implementation ignores the index.
+     */
+    virtual void put(const ImageBlock *block, size_t index) {
+        ENOKI_MARK_USED(index);
+        put(block);
+    }
+
+    /**
+     * \brief Add a contribution at an arbitrary position of the film
+     *
+     * Unlike \ref put(), this is meant for algorithms whose samples land at
+     * unpredictable positions of the image (e.g. light or particle tracing),
+     * and may be called concurrently by any number of threads without an
+     * intermediate image block. The contribution is spread over the footprint
+     * of the reconstruction filter, whose weights are normalized, and is added
+     * to the developed image as is, i.e. without dividing it by the weights of
+     * the samples of \ref put(). Callers must hence scale the values by the
+     * inverse of the number of samples. The default implementation throws an
+     * exception.
+     *
+     * \param pos
+     *    Position on the film in pixel coordinates (as for \ref ImageBlock::put())
+     *
+     * \param value
+     *    Spectral contribution of the sample
+     *
+     * \param wavelengths
+     *    Wavelengths of the contribution (ignored in RGB and monochromatic modes)
+     */
+    virtual void splat(const Point2f &pos, const Spectrum &value,
+                       const Wavelength &wavelengths, Mask active = true);
+
     /// Develop the film and write the result to the previously specified filename
     virtual void develop() = 0;
 
@@ -49,12 +89,110 @@ public:
     /// Return a bitmap object storing the developed contents of the film
     virtual ref<Bitmap> bitmap(bool raw = false) = 0;
 
+    /**
+     * \brief Return a bitmap object storing the developed and denoised
+     * contents of the film
+     *
+     * This can be called between the passes of a progressive render to
+     * obtain a denoised preview (see \ref Denoiser). The default
+     * implementation throws an exception.
+     */
+    virtual ref<Bitmap> denoised_bitmap();
+
+    /**
+     * \brief Develop the regions of the film that changed since the last
+     * call into a list of preview tiles
+     *
+     * Each entry holds the offset of a tile relative to the crop window and
+     * its sRGB-encoded 8 bit RGBA pixels. The first call following \ref
+     * prepare() returns all regions that received contributions so far.
+     * Progressive previews can call this function between (or during)
+     * rendering passes and only upload the returned sub-rectangles. The
+     * default implementation throws an exception.
+     */
+    virtual std::vector<std::pair<ScalarPoint2i, ref<Bitmap>>> snapshot();
+
     /// Set the target filename (with or without extension)
     virtual void set_destination_file(const fs::path &filename) = 0;
 
     /// Does the destination file already exist?
     virtual bool destination_exists(const fs::path &basename) const = 0;
 
+    /**
+     * \brief Serialize the accumulated contents of the film to a stream
+     *
+     * This is used to checkpoint long-running renders. The film must have
+     * been configured using \ref prepare(). The default implementation
+     * throws an exception.
+     */
+    virtual void write_state(Stream *stream);
+
+    /**
+     * \brief Restore the accumulated contents of the film from a stream
+     * previously written by \ref write_state()
+     *
+     * The film must have been configured using \ref prepare() with the same
+     * set of channels. When \c accumulate is set, the stored contents are
+     * added to those of the film instead of replacing them, which merges
+     * renders of disjoint image regions or sample sets. The default
+     * implementation throws an exception.
+     */
+    virtual void read_state(Stream *stream, bool accumulate = false);
+
+    /**
+     * \brief Is the film written to disk while the image is being rendered?
+     *
+     * Streaming films only keep the rows of the image that may still receive
+     * contributions in memory, and write the others out as soon as all blocks
+     * overlapping them have been merged. Integrators must therefore render the
+     * image in a single pass over blocks issued in scanline order (see \ref
+     * Spiral), and the film contents cannot be retrieved using \ref bitmap()
+     * or \ref write_state(). The default implementation returns \c false.
+     */
+    virtual bool streaming() const { return false; }
+
+    /**
+     * \brief Does the film develop the variance of the pixel estimates?
+     *
+     * The sampling integrators then add a \c variance channel to the image
+     * blocks (before the \c sample_count channel, if any), in which they
+     * accumulate the squared luminance of the samples (see also \ref
+     * has_color_variance()). The default implementation returns \c false.
+     */
+    virtual bool has_variance() const { return false; }
+
+    /**
+     * \brief Does the film develop the variance of every color channel
+     * instead of the luminance?
+     *
+     * When \ref has_variance() is also set, the image blocks then have the
+     * three channels \c variance.R, \c variance.G and \c variance.B, which
+     * accumulate the squared linear sRGB values of the samples. The default
+     * implementation returns \c false.
+     */
+    virtual bool has_color_variance() const { return false; }
+
+    /// Return the number of variance channels of the image blocks (0, 1 or 3)
+    size_t variance_channel_count() const {
+        return has_variance() ? (has_color_variance() ? 3 : 1) : 0;
+    }
+
+    /**
+     * \brief Return the number of wavelength bands recorded by the film
+     *
+     * In spectral variants, the sampling integrators then add one channel
+     * per band (after the AOVs of the integrator), which accumulates the
+     * radiance of the samples averaged over the wavelengths of the band. The
+     * bands split \ref band_range() into intervals of equal width. The
+     * default implementation returns zero.
+     */
+    virtual size_t band_count() const { return 0; }
+
+    /// Return the wavelength range (in nanometers) covered by the bands of the film
+    virtual ScalarVector2f band_range() const {
+        return ScalarVector2f(MTS_WAVELENGTH_MIN, MTS_WAVELENGTH_MAX);
+    }
+
     /**
      * Should regions slightly outside the image plane be sampled to improve
      * the quality of the reconstruction at the edges? This only makes
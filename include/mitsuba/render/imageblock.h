@@ -1,6 +1,7 @@
 #pragma once
 
 #include <mitsuba/core/fwd.h>
+#include <mitsuba/core/memory.h>
 #include <mitsuba/core/object.h>
 #include <mitsuba/core/vector.h>
 #include <mitsuba/render/fwd.h>
@@ -200,6 +201,18 @@ public:
 protected:
     /// Virtual destructor
     virtual ~ImageBlock();
+
+    /**
+     * \brief Splat a sample over a footprint of <tt>Taps x Taps</tt> pixels
+     * starting at \c lo (clipped to \c hi)
+     *
+     * Specialization of \ref put() for the footprints of the common filters
+     * (e.g. \c tent and \c gaussian with their default radii), with the
+     * loops over the footprint unrolled and the weights kept in registers.
+     */
+    template <uint32_t Taps>
+    void put_footprint(const Point2f &pos, const Point2u &lo, const Point2u &hi,
+                       const Float *value, Mask active);
 protected:
     ScalarPoint2i m_offset;
     ScalarVector2i m_size;
@@ -211,6 +224,7 @@ protected:
     bool m_warn_negative;
     bool m_warn_invalid;
     bool m_normalize;
+    MemoryRecord m_memory { MemoryCategory::Film };
 };
 
 MTS_EXTERN_CLASS_RENDER(ImageBlock)
@@ -1,9 +1,15 @@
 #pragma once
 
+#include <atomic>
+
+#include <enoki/dynamic.h>
+
+#include <mitsuba/core/filesystem.h>
 #include <mitsuba/core/fwd.h>
 #include <mitsuba/core/object.h>
 #include <mitsuba/core/properties.h>
 #include <mitsuba/core/spectrum.h>
+#include <mitsuba/core/thread.h>
 #include <mitsuba/core/timer.h>
 #include <mitsuba/core/tls.h>
 #include <mitsuba/core/vector.h>
@@ -50,13 +56,64 @@ public:
      */
     virtual void cancel() = 0;
 
+    /**
+     * \brief Render the scene from several sensors
+     *
+     * The default implementation calls \ref render() for each sensor in
+     * turn. Returns \c true if all sensors were rendered successfully.
+     */
+    virtual bool render_batch(Scene *scene, const std::vector<Sensor *> &sensors) {
+        for (Sensor *sensor : sensors) {
+            if (!render(scene, sensor))
+                return false;
+        }
+        return true;
+    }
+
+    /**
+     * \brief Set the thread pool that executes the render jobs
+     *
+     * Render jobs started by \ref render() and \ref render_batch() then only
+     * use the threads (and cores) of this pool instead of the global
+     * scheduler. Passing \c nullptr restores the default behavior.
+     */
+    void set_thread_pool(ThreadPool *pool) { m_thread_pool = pool; }
+
+    /// Return the thread pool that executes the render jobs (if any)
+    ThreadPool *thread_pool() { return m_thread_pool; }
+
+    /// Return the thread pool that executes the render jobs (if any, const version)
+    const ThreadPool *thread_pool() const { return m_thread_pool.get(); }
+
     MTS_DECLARE_CLASS()
 protected:
     /// Create an integrator
-    Integrator(const Properties & /*props*/) {}
+    Integrator(const Properties &props);
 
     /// Virtual destructor
     virtual ~Integrator() { }
+
+    /// Return the number of threads used by render jobs
+    size_t thread_count() const {
+        return m_thread_pool ? m_thread_pool->thread_count() : __global_thread_count;
+    }
+
+    /**
+     * \brief Run a function in the thread pool of the integrator
+     *
+     * Returns \c false when there is no thread pool or when the calling
+     * thread already executes inside of it. Otherwise, \c func is run by the
+     * pool, and the function returns \c true.
+     */
+    bool run_in_thread_pool(const std::function<void()> &func) {
+        if (!m_thread_pool || ThreadPool::current() == m_thread_pool.get())
+            return false;
+        m_thread_pool->execute(func);
+        return true;
+    }
+
+protected:
+    ref<ThreadPool> m_thread_pool;
 };
 
 /** \brief Integrator based on Monte Carlo sampling
@@ -69,8 +126,8 @@ protected:
 template <typename Float, typename Spectrum>
 class MTS_EXPORT_RENDER SamplingIntegrator : public Integrator<Float, Spectrum> {
 public:
-    MTS_IMPORT_BASE(Integrator)
-    MTS_IMPORT_TYPES(Scene, Sensor, Film, ImageBlock, Medium, Sampler)
+    MTS_IMPORT_BASE(Integrator, thread_count, run_in_thread_pool)
+    MTS_IMPORT_TYPES(Scene, Sensor, Film, ImageBlock, Medium, Sampler, ReconstructionFilter)
 
     /**
      * \brief Sample the incident radiance along a ray.
@@ -118,6 +175,65 @@ public:
                                              Float *aovs = nullptr,
                                              Mask active = true) const;
 
+    /**
+     * \brief Sample the incident radiance along a ray whose first surface
+     * interaction is already known
+     *
+     * Integrators that combine the results of other integrators (e.g. \c
+     * aov) intersect the camera ray once and pass the interaction to all of
+     * them using this function, instead of tracing it again in every call to
+     * \ref sample().
+     *
+     * \param si
+     *    The result of <tt>scene->ray_intersect(ray, active)</tt>
+     *
+     * The other parameters and the return value are the same as in \ref
+     * sample(). The default implementation ignores \c si and calls \ref
+     * sample(), which is the only valid choice for integrators whose first
+     * event may be a medium interaction.
+     */
+    virtual std::pair<Spectrum, Mask>
+    sample_with_interaction(const Scene *scene,
+                            Sampler *sampler,
+                            const RayDifferential3f &ray,
+                            const SurfaceInteraction3f &si,
+                            const Medium *medium = nullptr,
+                            Float *aovs = nullptr,
+                            Mask active = true) const;
+
+    /**
+     * \brief Propagate the adjoint radiance of a set of paths to the scene
+     * parameters by replaying them (differentiable variants only)
+     *
+     * This is an alternative to reverse-mode differentiation of \ref
+     * sample(), which records the computation graph of all path vertices
+     * and thus requires memory proportional to the path length. Instead,
+     * implementations retrace the paths of a previous call to \ref sample()
+     * and backpropagate the contribution of every vertex right away, which
+     * requires the primal radiance as an input but keeps the memory
+     * footprint independent of the path length.
+     *
+     * \param sampler
+     *    Sample generator, which must produce the same sequence of samples
+     *    as in the call to \ref sample() that computed \c radiance (i.e.
+     *    it should be re-seeded in the same way)
+     *
+     * \param radiance
+     *    Detached output of the corresponding call to \ref sample()
+     *
+     * \param adjoint
+     *    Derivative of the objective function with respect to \c radiance
+     *
+     * The gradients are accumulated in the parameters that require them.
+     */
+    virtual void sample_adjoint(const Scene *scene,
+                                Sampler *sampler,
+                                const RayDifferential3f &ray,
+                                const Medium *medium,
+                                const Spectrum &radiance,
+                                const Spectrum &adjoint,
+                                Mask active = true) const;
+
     /**
      * For integrators that return one or more arbitrary output variables
      * (AOVs), this function specifies a list of associated channel names. The
@@ -125,6 +241,57 @@ public:
      */
     virtual std::vector<std::string> aov_names() const;
 
+    /// Dynamic array types used by the wavefront interface
+    using DynamicUInt32            = make_dynamic_t<UInt32>;
+    using DynamicMask              = make_dynamic_t<Mask>;
+    using DynamicSpectrum          = make_dynamic_t<Spectrum>;
+    using DynamicRayDifferential3f = make_dynamic_t<RayDifferential3f>;
+
+    /**
+     * \brief Sample the incident radiance along a queue of rays (CPU packet
+     * variants only)
+     *
+     * This is the wavefront counterpart of \ref sample(), which is used by
+     * \ref render() when the \c wavefront parameter is set and \ref
+     * supports_wavefront() returns \c true. Instead of tracing one packet
+     * from the camera to the end of its path, implementations advance all
+     * paths of an image block by one bounce at a time and compact the set of
+     * active paths in between, so that packets remain fully occupied even
+     * after many paths have terminated.
+     *
+     * \param rays
+     *    Camera rays of all samples of the block
+     *
+     * \param seeds
+     *    Per-ray seed values. Random numbers of later bounces must be
+     *    derived from these instead of \c sampler, since a path no longer
+     *    occupies a fixed SIMD lane once the queue has been compacted.
+     *
+     * \param active
+     *    Specifies which entries of \c rays are valid
+     *
+     * \param result
+     *    Output radiance (same size as \c rays)
+     *
+     * \param valid
+     *    Output mask specifying whether a surface or medium interaction was
+     *    sampled (see \ref sample())
+     *
+     * Wavefront implementations do not return AOVs. Integrators implemented
+     * in Python may override this method to process the samples of a whole
+     * block with a single Python call.
+     */
+    virtual void sample_wavefront(const Scene *scene,
+                                  const DynamicRayDifferential3f &rays,
+                                  const DynamicUInt32 &seeds,
+                                  const Medium *medium,
+                                  const DynamicMask &active,
+                                  DynamicSpectrum &result,
+                                  DynamicMask &valid) const;
+
+    /// Does this integrator implement \ref sample_wavefront()?
+    virtual bool supports_wavefront() const { return false; }
+
     // =========================================================================
     //! @{ \name Integrator interface implementation
     // =========================================================================
@@ -132,6 +299,93 @@ public:
     bool render(Scene *scene, Sensor *sensor) override;
     void cancel() override;
 
+    /**
+     * \brief Render the scene from several sensors in a single parallel job
+     *
+     * The image blocks of all sensors are interleaved and processed by the
+     * same set of threads, which avoids the ramp-up and tail of separate
+     * \ref render() calls. Each film is prepared and filled independently.
+     * Sampler seeds only depend on the block index, hence each film matches
+     * the result of \ref render() with the same block size.
+     *
+     * Falls back to rendering the sensors one after the other when adaptive
+     * sampling, the "tuned" block scheduler, checkpoints or pass hooks (see
+     * \ref uses_pass_hooks()) are enabled, and on the GPU.
+     */
+    bool render_batch(Scene *scene, const std::vector<Sensor *> &sensors) override;
+
+    /**
+     * \brief Set the file used to store checkpoints of the render.
+     *
+     * When \c resume is \c true and the file exists, \ref render() continues
+     * from the passes recorded in the checkpoint instead of starting over.
+     * Checkpoints are only written when the \c checkpoint_interval property
+     * is positive.
+     */
+    void set_checkpoint(const fs::path &filename, bool resume);
+
+    /// Return the file used to store checkpoints (empty if unspecified)
+    const fs::path &checkpoint_file() const { return m_checkpoint_file; }
+
+    /**
+     * \brief Only render a slice of the image rows (GPU variants)
+     *
+     * The film rows are split into \c count contiguous slices, and only the
+     * slice \c index is rendered into the film, whose other rows stay empty.
+     * The samplers of the slice are seeded as in a full render, so that the
+     * accumulated film states of all slices sum up to the film of a full
+     * render (see \ref Film::read_state()). This is used to render a frame
+     * with one process per GPU, each holding its own copy of the scene.
+     */
+    void set_device_slice(uint32_t index, uint32_t count);
+
+    /**
+     * \brief Act as the master of a distributed render job
+     *
+     * Binds a ZeroMQ socket to \c address (e.g. <tt>tcp://\*:5555</tt>) and
+     * hands out the image blocks of all passes to workers running \ref
+     * render_worker() on the same scene. Finished blocks are merged into the
+     * sensor's film. Blocks that are not returned are reissued to idle
+     * workers once all others have been handed out.
+     *
+     * Requires Mitsuba to be compiled with ZeroMQ support
+     * (<tt>MTS_ENABLE_ZMQ</tt>). Returns \c true upon success.
+     */
+    bool render_master(Scene *scene, Sensor *sensor, const std::string &address);
+
+    /**
+     * \brief Render image blocks handed out by a remote master (see \ref
+     * render_master()) until it runs out of work
+     *
+     * Each rendering thread maintains its own connection to \c address
+     * (e.g. <tt>tcp://master:5555</tt>). The scene must match the one
+     * loaded by the master.
+     */
+    bool render_worker(Scene *scene, Sensor *sensor, const std::string &address);
+
+    /**
+     * \brief Render an interactive preview that is progressively refined
+     * until \ref cancel() is called or the sampler's sample count is reached
+     *
+     * The film is first filled with one sample per square of \c
+     * preview_stride pixels, then with the stride halved until it reaches 2
+     * (CPU variants). These coarse levels enter the film with a negligible
+     * weight, so that the first full resolution pass of one sample per pixel
+     * replaces them. Further passes of one sample per pixel are accumulated
+     * afterwards. The \c update callback is invoked from the rendering
+     * thread after each level and pass with the current stride (1 at full
+     * resolution) and the completed number of samples per pixel, e.g. to
+     * upload \ref Film::snapshot() tiles to the screen.
+     *
+     * The blocks are small and every pixel checks \ref should_stop(), so
+     * that a canceled preview returns quickly, after which the caller can
+     * update the camera or scene parameters and restart it on the same scene
+     * (reusing its acceleration data structure). Checkpoints, adaptive
+     * sampling and the block schedulers are not used by this mode.
+     */
+    bool render_preview(Scene *scene, Sensor *sensor,
+                        const std::function<void(uint32_t, size_t)> &update = { });
+
     /**
      * Indicates whether \ref cancel() or a timeout have occured. Should be
      * checked regularly in the integrator's main loop so that timeouts are
@@ -145,6 +399,33 @@ public:
                           m_render_timer.value() > 1000.f * m_timeout);
     }
 
+    /**
+     * \brief Return the number of image blocks completed by the current (or
+     * last) call to \ref render()
+     *
+     * The counters are updated without locking and may be polled from
+     * another thread while rendering, e.g. to display live throughput
+     * figures together with \ref render_time().
+     */
+    size_t blocks_done() const { return m_blocks_done.load(std::memory_order_relaxed); }
+
+    /// Return the number of samples completed by the current (or last) call to \ref render()
+    size_t samples_done() const { return m_samples_done.load(std::memory_order_relaxed); }
+
+    /// Return the time (in seconds) elapsed since the rendering phase started
+    float render_time() const { return m_render_timer.value() / 1000.f; }
+
+    /**
+     * \brief Return the duration (in seconds) of every pass rendered by the
+     * last call to \ref render()
+     *
+     * When several passes are rendered in a single job, the blocks of
+     * consecutive passes overlap: a pass then counts as completed once as
+     * many blocks as it contains are done. GPU variants render all passes in
+     * one kernel and report a single duration.
+     */
+    const std::vector<float> &pass_times() const { return m_pass_times; }
+
     //! @}
     // =========================================================================
 
@@ -153,13 +434,71 @@ protected:
     SamplingIntegrator(const Properties &props);
     virtual ~SamplingIntegrator();
 
+    /**
+     * \brief Render the pixels of an image block
+     *
+     * Pixels are visited in Morton order over a square of \c block_size
+     * pixels (or \ref m_block_size when zero), and the sampler is seeded
+     * based on \c block_id and that square's pixel count.
+     */
     virtual void render_block(const Scene *scene,
                               const Sensor *sensor,
                               Sampler *sampler,
                               ImageBlock *block,
                               Float *aovs,
                               size_t sample_count,
-                              size_t block_id) const;
+                              size_t block_id,
+                              uint32_t block_size = 0) const;
+
+    /**
+     * \brief Called by \ref render() before each pass over the image blocks
+     *
+     * Integrators that learn from the samples of the previous passes (e.g.
+     * path guiding) override this together with \ref finish_pass() and \ref
+     * uses_pass_hooks(). The default implementation does nothing.
+     */
+    virtual void prepare_pass(const Scene *scene, const Sensor *sensor,
+                              size_t pass, size_t pass_count);
+
+    /// Called by \ref render() after each completed pass (see \ref prepare_pass())
+    virtual void finish_pass(const Scene *scene, const Sensor *sensor,
+                             size_t pass, size_t pass_count);
+
+    /**
+     * \brief Should \ref render() call \ref prepare_pass() and \ref
+     * finish_pass()?
+     *
+     * The passes are then rendered one at a time (CPU variants). Batched
+     * and distributed renders do not support the hooks and render each
+     * sensor separately or ignore them.
+     */
+    virtual bool uses_pass_hooks() const { return false; }
+
+    /**
+     * \brief Render a coarse level of \ref render_preview() into an image
+     * block
+     *
+     * Traces one ray through the central pixel of every square of \c
+     * stride pixels of the block, and replicates the result over the square.
+     * The block must use a box filter without border.
+     */
+    void render_coarse_block(const Scene *scene,
+                             const Sensor *sensor,
+                             Sampler *sampler,
+                             ImageBlock *block,
+                             Float *aovs,
+                             uint32_t stride,
+                             size_t block_id) const;
+
+    /// Render a block in wavefront mode using \ref sample_wavefront()
+    void render_block_wavefront(const Scene *scene,
+                                const Sensor *sensor,
+                                Sampler *sampler,
+                                ImageBlock *block,
+                                Float *aovs,
+                                uint32_t pixel_count,
+                                uint32_t sample_count,
+                                ScalarFloat diff_scale_factor) const;
 
     void render_sample(const Scene *scene,
                        const Sensor *sensor,
@@ -170,6 +509,102 @@ protected:
                        ScalarFloat diff_scale_factor,
                        Mask active = true) const;
 
+    /**
+     * \brief Evaluate a camera sample of the pixel \c pos and write its
+     * \c channel_count channels into \c aovs
+     *
+     * This is \ref render_sample() without splatting the sample into an
+     * image block and advancing the sampler.
+     *
+     * \return The position at which the sample is splatted and the weight of
+     *    the sample (see \ref sample_filter())
+     */
+    std::pair<Vector2f, Float> eval_sample(const Scene *scene,
+                                           const Sensor *sensor,
+                                           Sampler *sampler,
+                                           Float *aovs,
+                                           size_t channel_count,
+                                           const Vector2f &pos,
+                                           ScalarFloat diff_scale_factor,
+                                           Mask active = true) const;
+
+    /**
+     * \brief Render a film of a single pixel (e.g. of a radiance meter)
+     *
+     * The \c sample_count samples are split into chunks that are rendered
+     * in parallel, and the sum of their channels is committed to the film at
+     * once, without the block traversal and image blocks of \ref render().
+     * Every chunk counts as a block in \ref blocks_done().
+     */
+    void render_single_pixel(const Scene *scene,
+                             const Sensor *sensor,
+                             const std::vector<std::string> &channels,
+                             size_t sample_count);
+
+    /**
+     * \brief Importance sample the reconstruction filter of the film of
+     * \c sensor for a sample of the pixel \c pos
+     *
+     * \return The position of the camera ray, the position at which the
+     *    sample is added to the image block (the center of the pixel) and
+     *    the weight of the sample (see \ref ReconstructionFilter::sample())
+     */
+    std::tuple<Vector2f, Vector2f, Float> sample_filter(const Sensor *sensor,
+                                                        const Vector2f &pos,
+                                                        const Vector2f &sample,
+                                                        Mask active) const;
+
+    /**
+     * \brief Return the list of film channels written by \ref render() into
+     * the given film (including XYZAW)
+     */
+    std::vector<std::string> film_channels(const Film *film) const;
+
+    /// Return the index of the "render_time" channel in the \c channel_count channels of \c film
+    size_t render_time_channel(const Film *film, size_t channel_count) const;
+
+    /**
+     * \brief Write the squared luminance (or colors) of a sample with the
+     * given XYZ value into the variance channels of \c aovs (if the film
+     * develops the variance, see \ref Film::has_variance())
+     */
+    void eval_variance(const Film *film, Float *aovs, size_t channel_count,
+                       const Color3f &xyz, Mask active) const;
+
+    /**
+     * \brief Write the wavelength bands of a sample into the band channels of
+     * \c aovs (if the film records any, see \ref Film::band_count())
+     *
+     * \param value
+     *    The spectral radiance of the sample divided by the PDF of its wavelengths
+     */
+    void eval_bands(const Film *film, Float *aovs, size_t channel_count,
+                    const UnpolarizedSpectrum &value,
+                    const Wavelength &wavelengths) const;
+
+    /**
+     * \brief Return the reconstruction filter of the image blocks rendered
+     * for \c film
+     *
+     * This is the filter of the film, or a box filter without block borders
+     * when the samples importance sample the filter of the film (see \ref
+     * m_filter_importance_sampling).
+     */
+    const ReconstructionFilter *block_filter(const Film *film) const;
+
+    /// Return the number of samples per pixel rendered in each pass
+    size_t pass_sample_count(const Sensor *sensor) const;
+
+    /// Choose a block size (if unspecified) so that all threads have work
+    void configure_block_size(const ScalarVector2i &film_size, size_t n_threads);
+
+    /// Save the film and the number of completed passes to \ref m_checkpoint_file
+    void write_checkpoint(Film *film, size_t total_spp, size_t samples_per_pass,
+                          size_t passes_done) const;
+
+    /// Restore a checkpoint into the film, returns the number of completed passes
+    size_t read_checkpoint(Film *film, size_t total_spp, size_t samples_per_pass);
+
 protected:
     /// Integrators should stop all work when this flag is set to true.
     bool m_stop;
@@ -177,6 +612,25 @@ protected:
     /// Size of (square) image blocks to render per core.
     uint32_t m_block_size;
 
+    /**
+     * \brief Hand out image blocks through a lock-free atomic cursor over
+     * a precomputed spiral traversal instead of locking the spiral.
+     *
+     * Idle threads then pick up remaining work by stealing index ranges
+     * from the TBB scheduler rather than contending on a mutex.
+     */
+    bool m_lock_free_scheduler;
+
+    /**
+     * \brief Re-tile the image based on the cost of the blocks measured
+     * during the first pass ("tuned" block scheduler).
+     *
+     * Later passes split expensive blocks into smaller ones, merge groups
+     * of cheap blocks, and hand out the result from the most to the least
+     * expensive block to minimize thread starvation at the end of a pass.
+     */
+    bool m_tuned_scheduler;
+
     /**
      * \brief Number of samples to compute for each pass over the image blocks.
      *
@@ -197,6 +651,87 @@ protected:
 
     /// Flag for disabling direct visibility of emitters
     bool m_hide_emitters;
+
+    /// Render packet variants in wavefront mode (see \ref sample_wavefront())
+    bool m_wavefront;
+
+    /**
+     * \brief Importance sample the reconstruction filter of the film when
+     * choosing the position of the camera rays?
+     *
+     * Every sample then contributes to the pixel it was drawn for only (with
+     * a weight of 1 for nonnegative filters), which removes the block borders
+     * and the overlapping writes of the filter footprint.
+     */
+    bool m_filter_importance_sampling;
+
+    /// Box filter of the image blocks in filter importance sampling mode
+    ref<ReconstructionFilter> m_box_filter;
+
+    /**
+     * \brief Relative error threshold used by adaptive sampling.
+     *
+     * When positive, blocks whose estimated relative error falls below this
+     * value stop receiving further passes. A value of zero (default)
+     * disables adaptive sampling.
+     */
+    float m_adaptive_threshold;
+
+    /// Minimum number of passes that each block receives in adaptive mode
+    uint32_t m_adaptive_min_passes;
+
+    /// Append a channel recording the number of samples per pixel?
+    bool m_sample_count_aov;
+
+    /**
+     * \brief Append a channel recording the time spent rendering each
+     * pixel (in microseconds)?
+     *
+     * The time is measured per call of \ref render_sample() (and per block
+     * in wavefront mode), and divided evenly among the lanes of a packet.
+     */
+    bool m_render_time_aov;
+
+    /// Initial stride (in pixels) of the coarse levels of \ref render_preview()
+    uint32_t m_preview_stride;
+
+    /**
+     * \brief Minimum time between two checkpoints (in seconds).
+     *
+     * Checkpoints are written after completed passes. A negative value
+     * disables checkpointing (default).
+     */
+    float m_checkpoint_interval;
+
+    /// File used to store checkpoints
+    fs::path m_checkpoint_file;
+
+    /// Resume from \ref m_checkpoint_file if it exists?
+    bool m_resume;
+
+    /**
+     * \brief Device memory budget (in bytes) of a GPU wavefront
+     *
+     * Larger wavefronts are split into chunks of image rows that are
+     * rendered one after the other. Zero means unlimited.
+     */
+    size_t m_gpu_memory_budget;
+
+    /// Evaluate GPU passes one at a time, overlapping their execution with the recording of the next one?
+    bool m_pipeline_passes;
+
+    /// Slice of the image rows rendered by GPU variants (see \ref set_device_slice())
+    uint32_t m_slice_index = 0;
+    uint32_t m_slice_count = 1;
+
+    /// Number of image blocks completed so far (see \ref blocks_done())
+    std::atomic<size_t> m_blocks_done;
+
+    /// Number of samples completed so far (see \ref samples_done())
+    std::atomic<size_t> m_samples_done;
+
+    /// Duration of the passes of the last rendering (see \ref pass_times())
+    std::vector<float> m_pass_times;
 };
 
 /*
@@ -167,6 +167,10 @@ struct SurfaceInteraction : Interaction<Float_, Spectrum_> {
 
     /**
      * Return the emitter associated with the intersection (if any)
+     *
+     * Emissive shapes hit through an instance return the emitter of the
+     * instance. Rays that missed return the environment emitter of \c scene.
+     *
      * \note Defined in scene.h
      */
     EmitterPtr emitter(const Scene *scene, Mask active = true) const;
@@ -0,0 +1,113 @@
+#pragma once
+
+#include <mitsuba/core/bbox.h>
+#include <mitsuba/core/object.h>
+#include <mitsuba/core/vector.h>
+#include <mitsuba/render/fwd.h>
+#include <atomic>
+
+NAMESPACE_BEGIN(mitsuba)
+
+/**
+ * \brief Irradiance cache for the interpolation of diffuse interreflection
+ *
+ * Following Ward et al. ("A Ray Tracing Solution for Diffuse
+ * Interreflection"), the cache stores irradiance records at sparse surface
+ * points, along with the harmonic mean distance to the surfaces seen from
+ * them and the rotational and translational gradients of Ward and Heckbert
+ * ("Irradiance Gradients"). The irradiance at other points is interpolated
+ * from the records whose weight exceeds the inverse of the error threshold.
+ *
+ * Records are stored in an octree, at the deepest node whose half size
+ * still covers the radius within which the record is used. Both lookups and
+ * inserts are lock-free: the nodes and records are published by atomic
+ * compare-and-swap operations and never modified afterwards, hence inserts
+ * from the rendering threads may run concurrently with lookups.
+ *
+ * Records store the irradiance as a color, hence the cache is only
+ * supported by the RGB and monochromatic variants.
+ */
+template <typename Float, typename Spectrum>
+class MTS_EXPORT_RENDER IrradianceCache : public Object {
+public:
+    MTS_IMPORT_TYPES()
+
+    struct Record {
+        ScalarPoint3f p;
+        ScalarVector3f n;
+        ScalarColor3f irradiance;
+        /// Harmonic mean distance to the surfaces seen from the record
+        ScalarFloat radius;
+        /// Rotational and translational gradients of each color channel
+        ScalarVector3f grad_r[3], grad_t[3];
+    };
+
+    /**
+     * \brief Create an empty cache
+     *
+     * \param bbox
+     *     Region that may contain records
+     *
+     * \param error
+     *     Error threshold, which scales the radius within which a record
+     *     is used relative to its harmonic mean distance
+     */
+    IrradianceCache(const ScalarBoundingBox3f &bbox, ScalarFloat error);
+
+    /// Insert a record, which is safe to call concurrently with other inserts and lookups
+    void insert(const Record &record) const;
+
+    /**
+     * \brief Interpolate the irradiance at \c p with normal \c n
+     *
+     * Returns \c false if no record is close enough.
+     */
+    bool lookup(const ScalarPoint3f &p, const ScalarVector3f &n,
+                ScalarColor3f &irradiance) const;
+
+    /// Remove all records (not thread-safe)
+    void clear();
+
+    /// Return the number of records
+    size_t record_count() const { return m_record_count.load(std::memory_order_relaxed); }
+
+    /// Return the error threshold
+    ScalarFloat error() const { return m_error; }
+
+    std::string to_string() const override;
+
+    MTS_DECLARE_CLASS()
+protected:
+    virtual ~IrradianceCache();
+
+    struct Entry {
+        Record record;
+        Entry *next;
+    };
+
+    struct Node {
+        std::atomic<Node *> children[8];
+        std::atomic<Entry *> entries;
+
+        Node();
+        ~Node();
+    };
+
+    /// Accumulate the weighted records of the subtree \c node with center \c c and half size \c h
+    void lookup(const Node *node, const ScalarPoint3f &c, ScalarFloat h,
+                const ScalarPoint3f &p, const ScalarVector3f &n,
+                ScalarColor3f &sum, ScalarFloat &weight_sum) const;
+
+    /// Maximum depth of the octree
+    static constexpr size_t MaxDepth = 24;
+
+private:
+    Node *m_root;
+    ScalarPoint3f m_center;
+    ScalarFloat m_half_size;
+    ScalarFloat m_error;
+    mutable std::atomic<size_t> m_record_count;
+};
+
+MTS_EXTERN_CLASS_RENDER(IrradianceCache)
+NAMESPACE_END(mitsuba)
@@ -2,11 +2,16 @@
 
 #include <unordered_set>
 #include <mitsuba/core/bbox.h>
+#include <mitsuba/core/filesystem.h>
 #include <mitsuba/core/fwd.h>
 #include <mitsuba/core/logger.h>
 #include <mitsuba/core/math.h>
+#include <mitsuba/core/memory.h>
 #include <mitsuba/core/object.h>
+#include <mitsuba/core/profiler.h>
 #include <mitsuba/core/ray.h>
+#include <mitsuba/core/statistics.h>
+#include <mitsuba/core/thread.h>
 #include <mitsuba/core/timer.h>
 #include <mitsuba/core/tls.h>
 #include <mitsuba/core/util.h>
@@ -16,6 +21,7 @@
 #include <mitsuba/render/shape.h>
 #include <tbb/tbb.h>
 #include <cstdlib>
+#include <cstring>
 
 /// Compile-time KD-tree depth limit to enable traversal with stack memory
 #define MTS_KD_MAXDEPTH 48u
@@ -26,6 +32,9 @@
 /// Grain size for TBB parallelization
 #define MTS_KD_GRAIN_SIZE 10240u
 
+/// Smallest grain size of the parallel loops near the top of the tree (see grain_size())
+#define MTS_KD_MIN_GRAIN_SIZE 1024u
+
 /**
  * Temporary scratch space that is used to cache intersection information
  * (# of floats)
@@ -183,17 +192,126 @@ public:
         m_exact_prim_threshold = value;
     }
 
+    /**
+     * \brief Return the budget for temporary memory used during the
+     * construction (in bytes, 0 means unlimited)
+     */
+    size_t memory_budget() const { return m_memory_budget; }
+
+    /**
+     * \brief Specify a budget for the temporary memory used during the
+     * construction (in bytes, 0 means unlimited)
+     *
+     * The budget covers the edge event lists and classification tables of
+     * the O(n log n) builder, which dominate the peak memory usage. When
+     * the budget is close, subtrees are built one after the other instead
+     * of in parallel, unused allocator chunks are released eagerly, and
+     * subtrees whose event lists would not fit anymore keep using min-max
+     * binning (which only requires O(n) storage).
+     */
+    void set_memory_budget(size_t value) { m_memory_budget = value; }
+
     /// Return the log level of kd-tree status messages
     LogLevel log_level() const { return m_log_level; }
 
     /// Return the log level of kd-tree status messages
     void set_log_level(LogLevel level) { m_log_level = level; }
 
-    bool ready() const { return (bool) m_nodes; }
+    bool ready() const { return m_node_data != nullptr; }
+
+    /// Release the node and index lists so that \ref build() can be invoked again
+    void clear() {
+        m_nodes.reset();
+        m_indices.reset();
+        m_node_data = nullptr;
+        m_index_data = nullptr;
+        m_external_storage = nullptr;
+        m_node_replicas.clear();
+        m_index_replicas.clear();
+        m_node_count = m_index_count = 0;
+        m_build_stats = BuildStatistics();
+    }
+
+    /**
+     * \brief Use node and index lists that were built previously instead of
+     * calling \ref build()
+     *
+     * The lists are not copied: \c storage (e.g. a \ref MemoryMappedFile
+     * containing them) is kept alive for as long as the tree uses them.
+     * \c bbox must be the bounding box of the original tree.
+     */
+    void set_external_storage(const KDNode *nodes, Size node_count,
+                              const Index *indices, Size index_count,
+                              const BoundingBox &bbox, Object *storage) {
+        clear();
+        m_node_data = nodes;
+        m_index_data = indices;
+        m_node_count = node_count;
+        m_index_count = index_count;
+        m_bbox = bbox;
+        m_external_storage = storage;
+        replicate_numa();
+    }
 
     /// Return the bounding box of the entire kd-tree
     const BoundingBox bbox() const { return m_bbox; }
 
+    /**
+     * \brief Statistics gathered by the last call to \ref build()
+     *
+     * The expected query costs are normalized by the surface area of the
+     * scene bounding box. All entries are zero when the tree was not built
+     * (e.g. for external storage, see \ref set_external_storage()).
+     */
+    struct BuildStatistics {
+        /// Cost of the tree under the cost model (SAH)
+        double final_cost = 0;
+        /// Expected number of inner node traversals per query
+        double exp_traversal_steps = 0;
+        /// Expected number of leaf visits per query
+        double exp_leaves_visited = 0;
+        /// Expected number of primitive intersections per query
+        double exp_primitives_queried = 0;
+
+        size_t node_count = 0;
+        size_t leaf_count = 0;
+        size_t nonempty_leaf_count = 0;
+        /// Number of primitive references stored by the leaves
+        size_t index_count = 0;
+        size_t max_depth = 0;
+        size_t max_prims_in_leaf = 0;
+        /// Average number of primitives per non-empty leaf
+        double avg_prims_in_leaf = 0;
+
+        size_t retracted_splits = 0;
+        size_t bad_refines = 0;
+        size_t pruned = 0;
+        /// Number of parallel build tasks
+        size_t work_units = 0;
+        /// Memory reserved by the per-thread chunk allocators and build lists (in bytes)
+        size_t temp_storage = 0;
+        /// Peak memory held by edge event lists and classification tables (in bytes)
+        size_t peak_storage = 0;
+        /// Number of subtrees that kept using min-max binning due to the memory budget
+        size_t budget_fallbacks = 0;
+        /// Number of splits whose subtrees were built sequentially due to the memory budget
+        size_t sequential_splits = 0;
+        /// Number of event lists that were generated and sorted in parallel
+        size_t parallel_sorts = 0;
+
+        /// Time spent creating the preliminary index list (in milliseconds)
+        float time_setup = 0;
+        /// Time spent building the tree (in milliseconds)
+        float time_construction = 0;
+        /// Time spent storing the tree in contiguous lists (in milliseconds)
+        float time_finalization = 0;
+        /// Time spent post-processing the lists in the derived class (in milliseconds)
+        float time_postprocessing = 0;
+    };
+
+    /// Return statistics about the construction of the tree
+    const BuildStatistics &build_statistics() const { return m_build_stats; }
+
     const Derived& derived() const { return (Derived&) *this; }
     Derived& derived() { return (Derived&) *this; }
 
@@ -382,6 +500,26 @@ protected:
         Size m_count = 0;
     };
 
+    /// Thread-safe counter of the temporary memory held by the builder
+    struct MemoryCounter {
+        std::atomic<size_t> used {0};
+        std::atomic<size_t> peak {0};
+
+        void add(size_t size) {
+            size_t value = used += size,
+                   peak_value = peak.load(std::memory_order_relaxed);
+            while (value > peak_value &&
+                   !peak.compare_exchange_weak(peak_value, value))
+                ;
+            MemoryAccounting::add(MemoryCategory::KDTree, size);
+        }
+
+        void remove(size_t size) {
+            used -= size;
+            MemoryAccounting::remove(MemoryCategory::KDTree, size);
+        }
+    };
+
     /**
      * During kd-tree construction, large amounts of memory are required to
      * temporarily hold index and edge event lists. When not implemented
@@ -402,9 +540,19 @@ protected:
         }
 
         ~OrderedChunkAllocator() {
+            if (m_counter)
+                m_counter->remove(size());
             m_chunks.clear();
         }
 
+        /// Report the size of all chunks to the given counter
+        void set_counter(MemoryCounter *counter) {
+            Assert(!m_counter);
+            m_counter = counter;
+            if (m_counter)
+                m_counter->add(size());
+        }
+
         /**
          * \brief Request a block of memory from the allocator
          *
@@ -428,6 +576,8 @@ protected:
             std::unique_ptr<uint8_t[]> data(new uint8_t[alloc_size]);
             uint8_t *start = data.get(), *cur = start + size;
             m_chunks.emplace_back(std::move(data), cur, alloc_size);
+            if (m_counter)
+                m_counter->add(alloc_size);
 
             return reinterpret_cast<T *>(start);
         }
@@ -478,6 +628,20 @@ protected:
             #endif
         }
 
+        /// Release all chunks that currently don't hold any allocations
+        void trim() {
+            size_t released = 0;
+            m_chunks.erase(std::remove_if(m_chunks.begin(), m_chunks.end(),
+                [&](const Chunk &chunk) {
+                    if (chunk.used() != 0)
+                        return false;
+                    released += chunk.size;
+                    return true;
+                }), m_chunks.end());
+            if (m_counter)
+                m_counter->remove(released);
+        }
+
         /// Return the currently allocated number of chunks
         size_t chunk_count() const { return m_chunks.size(); }
 
@@ -529,6 +693,7 @@ protected:
 
         size_t m_min_allocation;
         std::vector<Chunk> m_chunks;
+        MemoryCounter *m_counter = nullptr;
     };
 
     /* ==================================================================== */
@@ -537,6 +702,20 @@ protected:
 
     struct BuildContext;
 
+    /**
+     * \brief Grain size of the parallel loops over \c count primitives
+     *
+     * Nodes are split into enough chunks to occupy all threads of the
+     * current arena, which keeps the binning and partitioning steps parallel
+     * further down the tree, but chunks never hold fewer than \ref
+     * MTS_KD_MIN_GRAIN_SIZE primitives.
+     */
+    static Size grain_size(Size count) {
+        Size threads = (Size) tbb::this_task_arena::max_concurrency();
+        return std::max(Size(MTS_KD_MIN_GRAIN_SIZE),
+                        std::min(Size(MTS_KD_GRAIN_SIZE), count / (4 * threads)));
+    }
+
     /// Helper data structure used during tree construction (used by a single thread)
     struct LocalBuildContext {
         ClassificationStorage classification_storage;
@@ -547,9 +726,11 @@ protected:
         ~LocalBuildContext() {
             Assert(left_alloc.used() == 0);
             Assert(right_alloc.used() == 0);
-            if (ctx)
+            if (ctx) {
                 ctx->temp_storage += left_alloc.size() + right_alloc.size() +
                                      classification_storage.size();
+                ctx->memory.remove(classification_storage.size());
+            }
         }
     };
 
@@ -559,6 +740,7 @@ protected:
         ThreadEnvironment env;
         tbb::concurrent_vector<KDNode> node_storage;
         tbb::concurrent_vector<Index> index_storage;
+        MemoryCounter memory;
         ThreadLocal<LocalBuildContext> local;
 
         /* Keep some statistics about the build process */
@@ -567,10 +749,14 @@ protected:
         std::atomic<size_t> pruned {0};
         std::atomic<size_t> temp_storage {0};
         std::atomic<size_t> work_units {0};
+        std::atomic<size_t> budget_fallbacks {0};
+        std::atomic<size_t> sequential_splits {0};
+        std::atomic<size_t> parallel_sorts {0};
         double exp_traversal_steps = 0;
         double exp_leaves_visited = 0;
         double exp_primitives_queried = 0;
         Size max_prims_in_leaf = 0;
+        Size leaf_count = 0;
         Size nonempty_leaf_count = 0;
         Size max_depth = 0;
         Size prim_buckets[16] { };
@@ -865,7 +1051,8 @@ protected:
             BoundingBox left_bounds, right_bounds;
 
             tbb::parallel_for(
-                tbb::blocked_range<Size>(0u, Size(indices.size()), MTS_KD_GRAIN_SIZE),
+                tbb::blocked_range<Size>(0u, Size(indices.size()),
+                                         grain_size(Size(indices.size()))),
                 [&](const tbb::blocked_range<Index> &range) {
                     IndexVector left_indices_local, right_indices_local;
                     BoundingBox left_bounds_local, right_bounds_local;
@@ -942,19 +1129,19 @@ protected:
 
 
     /**
-     * \brief TBB task for building subtrees in parallel
+     * \brief Task for building subtrees in parallel
      *
      * This class is responsible for building a subtree of the final kd-tree.
-     * It recursively spawns new tasks for its respective subtrees to enable
-     * parallel construction.
+     * It recursively builds its two subtrees with \c tbb::parallel_invoke()
+     * to enable parallel construction.
      *
      * At the top of the tree, it uses min-max-binning and parallel reductions
      * to create sufficient parallelism. When the number of elements is
      * sufficiently small, it switches to a more accurate O(N log N) builder
      * which uses normal recursion on the stack (i.e. it does not spawn further
-     * parallel pieces of work).
+     * parallel pieces of work, except for sorting large event lists).
      */
-    class BuildTask : public tbb::task {
+    class BuildTask {
     public:
         using NodeIterator  = typename tbb::concurrent_vector<KDNode>::iterator;
         using IndexIterator = typename tbb::concurrent_vector<Index>::iterator;
@@ -997,8 +1184,9 @@ protected:
         }
 
         /// Run one iteration of min-max binning and spawn recursive tasks
-        task *execute() {
+        void execute() {
             ScopedSetThreadEnvironment env(m_ctx.env);
+            ScopedPhase sp(ProfilerPhase::InitKDTree);
             Size prim_count = Size(m_indices.size());
             const Derived &derived = m_ctx.derived;
 
@@ -1011,12 +1199,17 @@ protected:
             if (prim_count <= derived.stop_primitives() ||
                 m_depth >= derived.max_depth() || m_tight_bbox.collapsed()) {
                 make_leaf(std::move(m_indices));
-                return nullptr;
+                return;
             }
 
             if (prim_count <= derived.exact_primitive_threshold()) {
-                *m_cost = transition_to_nlogn();
-                return nullptr;
+                if (!exceeds_budget(nlogn_storage(prim_count))) {
+                    *m_cost = transition_to_nlogn();
+                    return;
+                }
+                /* Not enough memory left for the event lists: stay with
+                   min-max binning, which only needs O(n) storage */
+                m_ctx.budget_fallbacks++;
             }
 
             /* ==================================================================== */
@@ -1025,7 +1218,7 @@ protected:
 
             /* Accumulate all shapes into bins */
             MinMaxBins bins = tbb::parallel_reduce(
-                tbb::blocked_range<Size>(0u, prim_count, MTS_KD_GRAIN_SIZE),
+                tbb::blocked_range<Size>(0u, prim_count, grain_size(prim_count)),
                 MinMaxBins(derived.min_max_bins(), m_tight_bbox),
 
                 /* MAP: Bin a number of shapes and return the resulting 'MinMaxBins' data structure */
@@ -1060,7 +1253,7 @@ protected:
                 if ((best.cost > 4 * leaf_cost && prim_count < 16)
                     || m_bad_refines >= derived.max_bad_refines()) {
                     make_leaf(std::move(m_indices));
-                    return nullptr;
+                    return;
                 }
                 ++m_bad_refines;
                 m_ctx.bad_refines++;
@@ -1096,20 +1289,28 @@ protected:
 
             Scalar left_cost = 0, right_cost = 0;
 
-            BuildTask &left_task = *new (allocate_child()) BuildTask(
+            BuildTask left_task(
                 m_ctx, children, std::move(partition.left_indices),
-                left_bounds, partition.left_bounds, m_depth+1,
+                left_bounds, partition.left_bounds, m_depth + 1,
                 m_bad_refines, &left_cost);
 
-            BuildTask &right_task = *new (allocate_child()) BuildTask(
+            BuildTask right_task(
                 m_ctx, std::next(children), std::move(partition.right_indices),
                 right_bounds, partition.right_bounds, m_depth + 1,
                 m_bad_refines, &right_cost);
 
-            set_ref_count(3);
-            spawn(left_task);
-            spawn(right_task);
-            wait_for_all();
+            /* Close to the memory budget: build the subtrees one after the
+               other so that fewer event lists are alive at the same time */
+            if (unlikely(near_budget())) {
+                m_ctx.sequential_splits++;
+                left_task.execute();
+                right_task.execute();
+            } else {
+                tbb::parallel_invoke(
+                    [&] { left_task.execute(); },
+                    [&] { right_task.execute(); }
+                );
+            }
 
             /* ==================================================================== */
             /*                           Final decision                             */
@@ -1129,7 +1330,7 @@ protected:
                 make_leaf(std::move(temp));
             }
 
-            return nullptr;
+            return;
         }
 
         /// Recursively run the O(N log N builder)
@@ -1565,10 +1766,37 @@ protected:
             return final_cost;
         }
 
+        /**
+         * \brief Conservative estimate of the additional temporary memory
+         * required to run the O(N log N) builder on \c prim_count primitives
+         */
+        size_t nlogn_storage(Size prim_count) const {
+            /* Initial event list + event lists of the two children */
+            size_t events = (size_t) prim_count * 2 * Dimension * sizeof(EdgeEvent);
+            return 3 * events + (m_ctx.derived.primitive_count() + 3) / 4;
+        }
+
+        /// Check whether allocating \c size more bytes would exceed the memory budget
+        bool exceeds_budget(size_t size) const {
+            size_t budget = m_ctx.derived.memory_budget();
+            return budget != 0 && m_ctx.memory.used + size > budget;
+        }
+
+        /// Check whether more than half of the memory budget is in use
+        bool near_budget() const {
+            size_t budget = m_ctx.derived.memory_budget();
+            return budget != 0 && m_ctx.memory.used > budget / 2;
+        }
+
         /// Create an initial sorted edge event list and start the O(N log N) builder
         Scalar transition_to_nlogn() {
             const auto &derived = m_ctx.derived;
             m_local = &((LocalBuildContext &) m_ctx.local);
+            if (!m_local->ctx) {
+                m_local->ctx = &m_ctx;
+                m_local->left_alloc.set_counter(&m_ctx.memory);
+                m_local->right_alloc.set_counter(&m_ctx.memory);
+            }
 
             Size prim_count = Size(m_indices.size()), final_prim_count = prim_count;
 
@@ -1580,51 +1808,85 @@ protected:
                 m_local->left_alloc.template allocate<EdgeEvent>(initial_size),
                 *events_end = events_start + initial_size;
 
-            for (Size i = 0; i<prim_count; ++i) {
-                Index prim_index = m_indices[i];
-                BoundingBox prim_bbox = derived.bbox(prim_index, m_bbox);
-                bool valid = prim_bbox.valid() && prim_bbox.surface_area() > 0;
-
-                if (unlikely(!valid)) {
-                    --final_prim_count;
-                    m_ctx.pruned++;
-                }
-
-                for (Index axis = 0; axis < Dimension; ++axis) {
-                    Scalar min = prim_bbox.min[axis], max = prim_bbox.max[axis];
-                    Index offset = (Index) (axis * prim_count + i) * 2;
-
-                    if (unlikely(!valid)) {
-                        events_start[offset  ].set_invalid();
-                        events_start[offset+1].set_invalid();
-                    } else if (min == max) {
-                        events_start[offset  ] = EdgeEvent(EdgeEvent::Type::EdgePlanar, axis, min, prim_index);
-                        events_start[offset+1].set_invalid();
-                    } else {
-                        events_start[offset  ] = EdgeEvent(EdgeEvent::Type::EdgeStart, axis, min, prim_index);
-                        events_start[offset+1] = EdgeEvent(EdgeEvent::Type::EdgeEnd,   axis, max, prim_index);
+            /* Generate the events of the primitives [begin, end) and
+               return the number of pruned primitives */
+            auto generate_events = [&](Size begin, Size end) {
+                Size pruned = 0;
+                for (Size i = begin; i < end; ++i) {
+                    Index prim_index = m_indices[i];
+                    BoundingBox prim_bbox = derived.bbox(prim_index, m_bbox);
+                    bool valid = prim_bbox.valid() && prim_bbox.surface_area() > 0;
+
+                    if (unlikely(!valid))
+                        ++pruned;
+
+                    for (Index axis = 0; axis < Dimension; ++axis) {
+                        Scalar min = prim_bbox.min[axis], max = prim_bbox.max[axis];
+                        Index offset = (Index) (axis * prim_count + i) * 2;
+
+                        if (unlikely(!valid)) {
+                            events_start[offset  ].set_invalid();
+                            events_start[offset+1].set_invalid();
+                        } else if (min == max) {
+                            events_start[offset  ] = EdgeEvent(EdgeEvent::Type::EdgePlanar, axis, min, prim_index);
+                            events_start[offset+1].set_invalid();
+                        } else {
+                            events_start[offset  ] = EdgeEvent(EdgeEvent::Type::EdgeStart, axis, min, prim_index);
+                            events_start[offset+1] = EdgeEvent(EdgeEvent::Type::EdgeEnd,   axis, max, prim_index);
+                        }
                     }
                 }
+                return pruned;
+            };
+
+            /* Generate and sort the events lists (in parallel for the large
+               lists near the top of the tree) */
+            if (prim_count < MTS_KD_GRAIN_SIZE) {
+                final_prim_count -= generate_events(0u, prim_count);
+                std::sort(events_start, events_end);
+            } else {
+                /* Isolate the parallel work: a thread waiting for it must not
+                   pick up another build task that would reuse its allocators */
+                tbb::this_task_arena::isolate([&] {
+                    std::atomic<Size> pruned(0);
+                    tbb::parallel_for(
+                        tbb::blocked_range<Size>(0u, prim_count, grain_size(prim_count)),
+                        [&](const tbb::blocked_range<Size> &range) {
+                            pruned += generate_events(range.begin(), range.end());
+                        }
+                    );
+                    final_prim_count -= pruned;
+                    tbb::parallel_sort(events_start, events_end);
+                });
+                m_ctx.parallel_sorts++;
             }
+            m_ctx.pruned += prim_count - final_prim_count;
 
             /* Release index list */
             IndexVector().swap(m_indices);
 
-            /* Sort the events list and remove invalid ones from the end */
-            std::sort(events_start, events_end);
+            /* Remove invalid events from the end */
             while (events_start != events_end && !(events_end-1)->valid())
                 --events_end;
 
             m_local->left_alloc.template shrink_allocation<EdgeEvent>(
                 events_start, events_end - events_start);
+
+            size_t classification_size = m_local->classification_storage.size();
             m_local->classification_storage.resize(derived.primitive_count());
-            m_local->ctx = &m_ctx;
+            m_ctx.memory.add(m_local->classification_storage.size() - classification_size);
 
             Scalar cost = build_nlogn(m_node, final_prim_count, events_start,
                                      events_end, m_bbox, m_depth, 0);
 
             m_local->left_alloc.release(events_start);
 
+            /* Hand unused chunks back to the system if memory is tight */
+            if (derived.memory_budget() != 0) {
+                m_local->left_alloc.trim();
+                m_local->right_alloc.trim();
+            }
+
             return cost;
         }
 
@@ -1683,6 +1945,7 @@ protected:
             ctx.max_depth = depth;
 
         if (node->leaf()) {
+            ctx.leaf_count++;
             auto prim_count = node->primitive_count();
             double value = (double) CostModel::eval(bbox);
 
@@ -1708,6 +1971,8 @@ protected:
     }
 
     void build() {
+        ScopedPhase sp(ProfilerPhase::InitKDTree);
+
         /* Some sanity checks */
         if (ready())
             Throw("The kd-tree has already been built!");
@@ -1738,6 +2003,8 @@ protected:
             m_clip_primitives ? "yes" : "no");
         Log(m_log_level, "   Retract bad splits       : %s",
             m_retract_bad_splits ? "yes" : "no");
+        Log(m_log_level, "   Memory budget            : %s",
+            m_memory_budget != 0 ? util::mem_string(m_memory_budget) : "unlimited");
         Log(m_log_level, "");
 
         /* ==================================================================== */
@@ -1745,6 +2012,8 @@ protected:
         /* ==================================================================== */
 
         BuildContext ctx(derived());
+        m_build_stats = BuildStatistics();
+        Timer timer;
 
         ctx.node_storage.reserve(prim_count);
         ctx.index_storage.reserve(prim_count);
@@ -1768,13 +2037,13 @@ protected:
             IndexVector indices(prim_count);
             for (size_t i = 0; i < prim_count; ++i)
                 indices[i] = (Index) i;
+            m_build_stats.time_setup = timer.reset();
 
-            BuildTask &task = *new (tbb::task::allocate_root()) BuildTask(
-                ctx, ctx.node_storage.begin(), std::move(indices),
-                m_bbox, m_bbox, 0, 0, &final_cost);
-
-            tbb::task::spawn_root_and_wait(task);
+            BuildTask task(ctx, ctx.node_storage.begin(), std::move(indices),
+                           m_bbox, m_bbox, 0, 0, &final_cost);
+            task.execute();
         }
+        m_build_stats.time_construction = timer.reset();
 
         Log(m_log_level, "Structural kd-tree statistics:");
 
@@ -1806,28 +2075,57 @@ protected:
         );
         tbb::concurrent_vector<KDNode>().swap(ctx.node_storage);
 
+        m_node_data = m_nodes.get();
+        m_index_data = m_indices.get();
+
         /* Slightly avoid the bounding box to avoid numerical issues
            involving geometry that exactly lies on the boundary */
         Vector extra = (m_bbox.extents() + 1.f) * math::Epsilon<Scalar>;
         m_bbox.min -= extra;
         m_bbox.max += extra;
 
+        replicate_numa();
+        m_build_stats.time_finalization = timer.reset();
+
         /* ==================================================================== */
-        /*         Print various tree statistics if requested by the user       */
+        /*       Gather tree statistics, and print them if requested            */
         /* ==================================================================== */
 
-        if (Thread::thread()->logger()->log_level() <= m_log_level) {
-            compute_statistics(ctx, m_nodes.get(), m_bbox, 0);
-
-            // Trigger per-thread data release
-            ctx.local.clear();
-
-            ctx.exp_traversal_steps /= (double) CostModel::eval(m_bbox);
-            ctx.exp_leaves_visited /= (double) CostModel::eval(m_bbox);
-            ctx.exp_primitives_queried /= (double) CostModel::eval(m_bbox);
-            ctx.temp_storage += ctx.node_storage.size() * sizeof(KDNode);
-            ctx.temp_storage += ctx.index_storage.size() * sizeof(Index);
+        compute_statistics(ctx, m_nodes.get(), m_bbox, 0);
+
+        // Trigger per-thread data release
+        ctx.local.clear();
+
+        ctx.exp_traversal_steps /= (double) CostModel::eval(m_bbox);
+        ctx.exp_leaves_visited /= (double) CostModel::eval(m_bbox);
+        ctx.exp_primitives_queried /= (double) CostModel::eval(m_bbox);
+        ctx.temp_storage += ctx.node_storage.size() * sizeof(KDNode);
+        ctx.temp_storage += ctx.index_storage.size() * sizeof(Index);
+
+        BuildStatistics &stats = m_build_stats;
+        stats.final_cost = (double) final_cost;
+        stats.exp_traversal_steps = ctx.exp_traversal_steps;
+        stats.exp_leaves_visited = ctx.exp_leaves_visited;
+        stats.exp_primitives_queried = ctx.exp_primitives_queried;
+        stats.node_count = m_node_count;
+        stats.leaf_count = ctx.leaf_count;
+        stats.nonempty_leaf_count = ctx.nonempty_leaf_count;
+        stats.index_count = m_index_count;
+        stats.max_depth = ctx.max_depth;
+        stats.max_prims_in_leaf = ctx.max_prims_in_leaf;
+        stats.avg_prims_in_leaf = ctx.nonempty_leaf_count > 0
+            ? m_index_count / (double) ctx.nonempty_leaf_count : 0.0;
+        stats.retracted_splits = ctx.retracted_splits;
+        stats.bad_refines = ctx.bad_refines;
+        stats.pruned = ctx.pruned;
+        stats.work_units = ctx.work_units;
+        stats.temp_storage = ctx.temp_storage;
+        stats.peak_storage = ctx.memory.peak;
+        stats.budget_fallbacks = ctx.budget_fallbacks;
+        stats.sequential_splits = ctx.sequential_splits;
+        stats.parallel_sorts = ctx.parallel_sorts;
 
+        if (Thread::thread()->logger()->log_level() <= m_log_level) {
             Log(m_log_level, "   Primitive references        : %i (%s)",
                 m_index_count, util::mem_string(m_index_count * sizeof(Index)));
 
@@ -1840,9 +2138,15 @@ protected:
             Log(m_log_level, "   Temporary storage used      : %s",
                 util::mem_string(ctx.temp_storage));
 
+            Log(m_log_level, "   Peak event/classif. storage : %s",
+                util::mem_string(ctx.memory.peak));
+
             Log(m_log_level, "   Parallel work units         : %i",
                 ctx.work_units);
 
+            Log(m_log_level, "   Parallel event sorts        : %i",
+                ctx.parallel_sorts);
+
             std::ostringstream oss;
             Size prim_bucket_count = sizeof(ctx.prim_buckets) / sizeof(Size);
             oss << "   Leaf node histogram         : ";
@@ -1864,6 +2168,12 @@ protected:
                 ctx.bad_refines);
             Log(m_log_level, "   Pruned                      : %i",
                 ctx.pruned);
+            if (m_memory_budget != 0) {
+                Log(m_log_level, "   Budget: binned subtrees     : %i",
+                    ctx.budget_fallbacks);
+                Log(m_log_level, "   Budget: sequential splits   : %i",
+                    ctx.sequential_splits);
+            }
             Log(m_log_level, "   Largest leaf node           : %i primitives",
                 ctx.max_prims_in_leaf);
             Log(m_log_level, "   Avg. prims/nonempty leaf    : %.2f",
@@ -1880,12 +2190,70 @@ protected:
         }
     }
 
+    /// Return the node list that is local to the calling thread's NUMA node
+    MTS_INLINE const KDNode *local_nodes() const {
+        size_t node = (size_t) Thread::current_numa_node();
+        return node < m_node_replicas.size() ? m_node_replicas[node].get() : m_node_data;
+    }
+
+    /// Return the index list that is local to the calling thread's NUMA node
+    MTS_INLINE const Index *local_indices() const {
+        size_t node = (size_t) Thread::current_numa_node();
+        return node < m_index_replicas.size() ? m_index_replicas[node].get() : m_index_data;
+    }
+
+protected:
+    /**
+     * \brief Copy the node and index lists to every NUMA node
+     *
+     * Only done when worker threads are pinned to NUMA nodes (see \ref
+     * Thread::set_numa_pinning()). Each copy is written by a thread
+     * running on the target node, so that first-touch allocation places it
+     * in node-local memory.
+     */
+    void replicate_numa() {
+        m_node_replicas.clear();
+        m_index_replicas.clear();
+
+        int numa_node_count = Thread::numa_node_count();
+        if (!Thread::numa_pinning() || numa_node_count < 2 || m_node_count == 0)
+            return;
+
+        m_node_replicas.resize(numa_node_count);
+        m_index_replicas.resize(numa_node_count);
+        for (int i = 0; i < numa_node_count; ++i) {
+            Thread::run_on_numa_node(i, [&]() {
+                m_node_replicas[i].reset(new KDNode[m_node_count]);
+                std::copy(m_node_data, m_node_data + m_node_count,
+                          m_node_replicas[i].get());
+                m_index_replicas[i].reset(new Index[m_index_count]);
+                std::copy(m_index_data, m_index_data + m_index_count,
+                          m_index_replicas[i].get());
+            });
+        }
+
+        Log(m_log_level, "Replicated the kd-tree on %i NUMA nodes (%s per node)",
+            numa_node_count,
+            util::mem_string(m_node_count * sizeof(KDNode) + m_index_count * sizeof(Index)));
+    }
+
 protected:
     std::unique_ptr<KDNode[]> m_nodes;
     std::unique_ptr<Index[]> m_indices;
     Size m_node_count = 0;
     Size m_index_count = 0;
 
+    /// Node and index lists in use: \ref m_nodes and \ref m_indices, or external storage
+    const KDNode *m_node_data = nullptr;
+    const Index *m_index_data = nullptr;
+
+    /// Owner of externally provided node and index lists (see \ref set_external_storage())
+    ref<Object> m_external_storage;
+
+    /// Node-local copies of \ref m_nodes and \ref m_indices (see \ref replicate_numa())
+    std::vector<std::unique_ptr<KDNode[]>> m_node_replicas;
+    std::vector<std::unique_ptr<Index[]>> m_index_replicas;
+
     CostModel m_cost_model;
     bool m_clip_primitives = true;
     bool m_retract_bad_splits = true;
@@ -1894,8 +2262,10 @@ protected:
     Size m_max_bad_refines = 0;
     Size m_exact_prim_threshold = 65536;
     Size m_min_max_bins = 128;
+    size_t m_memory_budget = 0;
     LogLevel m_log_level = Debug;
     BoundingBox m_bbox;
+    BuildStatistics m_build_stats;
 };
 
 template <typename BoundingBox, typename Index, typename CostModel, typename Derived>
@@ -2019,18 +2389,93 @@ public:
     using Base = TShapeKDTree<ScalarBoundingBox3f, uint32_t, SurfaceAreaHeuristic3f, ShapeKDTree>;
     using typename Base::KDNode;
     using Base::ready;
+    using Base::clear;
     using Base::set_clip_primitives;
     using Base::set_exact_primitive_threshold;
+    using Base::set_memory_budget;
     using Base::set_max_depth;
     using Base::set_min_max_bins;
     using Base::set_retract_bad_splits;
     using Base::set_stop_primitives;
+    using Base::cost_model;
+    using Base::clip_primitives;
+    using Base::exact_primitive_threshold;
+    using Base::memory_budget;
+    using Base::max_bad_refines;
+    using Base::max_depth;
+    using Base::min_max_bins;
+    using Base::retract_bad_splits;
+    using Base::stop_primitives;
     using Base::bbox;
     using Base::m_bbox;
     using Base::m_nodes;
     using Base::m_indices;
     using Base::m_index_count;
     using Base::m_node_count;
+    using Base::m_node_data;
+    using Base::m_index_data;
+    using Base::m_build_stats;
+    using Base::set_external_storage;
+    using Base::local_nodes;
+    using Base::local_indices;
+
+    /// Leaf header of the compact index format marking 32-bit indices (see \ref for_each_primitive())
+    static constexpr Index CompactWide = (Index) -1;
+
+    /// Precomputed triangle data stored by the leaves (see \ref TriangleRecord)
+    enum class TriangleRecords : uint32_t {
+        /// Intersect the shapes directly (no additional storage)
+        None,
+        /// Store the first vertex and the two edges (Moeller-Trumbore test)
+        Edges,
+        /// Store the three vertices (watertight test of Woop et al. 2013)
+        Watertight
+    };
+
+    /**
+     * \brief Triangle data of a single index list entry, stored in leaf order
+     *
+     * Spares the traversal the lookup of the shape, the face indices, and the
+     * vertex positions when intersecting meshes. Depending on \ref
+     * TriangleRecords, \c v holds either the first vertex followed by the two
+     * edges or the three vertices of the triangle. For any other primitive,
+     * \c shape_index is \ref NonMeshRecord and \c prim_index holds the
+     * global primitive index.
+     */
+    struct alignas(16) TriangleRecord {
+        ScalarFloat v[3][3];
+        Index shape_index;
+        Index prim_index;
+    };
+
+    /// Shape index of the triangle records of non-mesh primitives
+    static constexpr Index NonMeshRecord = (Index) -1;
+
+    /// Number of analytic shapes intersected at once by \ref intersect_batch()
+    static constexpr size_t BatchSize = 8;
+
+    /**
+     * \brief Up to \ref BatchSize analytic shapes of the same kind, whose
+     * parameters (see \ref Shape::analytic_parameters()) are stored with one
+     * shape per SIMD lane
+     */
+    struct alignas(64) ShapeBatch {
+        ScalarFloat params[AnalyticParameterCount][BatchSize];
+        const Shape *shape[BatchSize];
+        /// Primitive index within the shape of each lane
+        Index prim_index[BatchSize];
+        AnalyticShape kind;
+        uint32_t size;
+    };
+
+    /**
+     * \brief Batches of a leaf node, followed by the primitives of the leaf
+     * that are intersected individually (their global indices)
+     */
+    struct LeafBatches {
+        Index batch_offset, batch_count;
+        Index index_offset, index_count;
+    };
 
     /// Create an empty kd-tree and take build-related parameters from \c props.
     ShapeKDTree(const Properties &props);
@@ -2038,9 +2483,34 @@ public:
     /// Register a new shape with the kd-tree (to be called before \ref build())
     void add_shape(Shape *shape);
 
-    /// Build the kd-tree
+    /**
+     * \brief Build the kd-tree
+     *
+     * When the \c kd_cache_dir property is set, the tree is memory-mapped
+     * from a cache file instead if one exists for the same geometry and
+     * build parameters (see \ref cache_key()). Otherwise, the tree is built
+     * and written to the cache.
+     */
     void build();
 
+    /**
+     * \brief Rebuild the kd-tree following a change of the registered shapes
+     *
+     * Refreshes the primitive map and the bounding box from the current
+     * state of the shapes (which may have moved or changed their primitive
+     * count) before building a new tree. The build parameters are kept.
+     * The cache is bypassed, since updated geometry is usually transient.
+     */
+    void rebuild();
+
+    /**
+     * \brief Return the key identifying the tree in the cache
+     *
+     * Hashes the vertex and face buffers of meshes, the primitive bounding
+     * boxes of other shapes, and the build parameters.
+     */
+    uint64_t cache_key() const;
+
     /// Return the number of registered shapes
     Size shape_count() const { return Size(m_shapes.size()); }
 
@@ -2092,14 +2562,19 @@ public:
         // Resulting intersection struct
         PreliminaryIntersection3f pi;
 
+        ScopedStatsCounter stats_nodes(StatsCounter::KDTreeNodes),
+                           stats_prims(StatsCounter::PrimitiveTests);
+
         // Intersect against the scene bounding box
         auto bbox_result = m_bbox.ray_intersect(ray);
 
         Float mint = std::max(ray.mint, std::get<1>(bbox_result));
         Float maxt = std::min(ray.maxt, std::get<2>(bbox_result));
 
-        const KDNode *node = m_nodes.get();
+        const KDNode *node = local_nodes();
+        const Index *indices = local_indices();
         while (mint <= maxt) {
+            ++stats_nodes;
             if (likely(!node->leaf())) { // Inner node
                 const Float split   = node->split();
                 const uint32_t axis = node->axis();
@@ -2137,23 +2612,22 @@ public:
                 maxt = t_plane;
                 continue;
             } else if (node->primitive_count() > 0) { // Arrived at a leaf node
-                Index prim_start = node->primitive_offset();
-                Index prim_end = prim_start + node->primitive_count();
-                for (Index i = prim_start; i < prim_end; i++) {
-                    Index prim_index = m_indices[i];
-
-                    PreliminaryIntersection3f prim_pi =
-                        intersect_prim<ShadowRay>(prim_index, ray, true);
-
-                    if (unlikely(prim_pi.is_valid())) {
-                        if constexpr (ShadowRay)
-                            return prim_pi;
+                stats_prims += node->primitive_count();
+                bool occluded = intersect_leaf<ShadowRay>(node, indices, ray, true,
+                    [&](const PreliminaryIntersection3f &prim_pi) {
+                        if (unlikely(prim_pi.is_valid())) {
+                            pi = prim_pi;
+                            if constexpr (ShadowRay)
+                                return true;
+
+                            Assert(prim_pi.t >= ray.mint && prim_pi.t <= ray.maxt);
+                            ray.maxt = pi.t;
+                        }
+                        return false;
+                    });
 
-                        Assert(prim_pi.t >= ray.mint && prim_pi.t <= ray.maxt);
-                        pi = prim_pi;
-                        ray.maxt = pi.t;
-                    }
-                }
+                if (ShadowRay && occluded)
+                    return pi;
             }
 
             if (likely(stack_index > 0)) {
@@ -2190,7 +2664,11 @@ public:
         // Resulting intersection struct
         PreliminaryIntersection3f pi;
 
-        const KDNode *node = m_nodes.get();
+        ScopedStatsCounter stats_nodes(StatsCounter::KDTreeNodes),
+                           stats_prims(StatsCounter::PrimitiveTests);
+
+        const KDNode *node = local_nodes();
+        const Index *indices = local_indices();
 
         /* Intersect against the scene bounding box */
         auto bbox_result = m_bbox.ray_intersect(ray);
@@ -2203,6 +2681,7 @@ public:
                 active = active && !pi.is_valid();
 
             if (likely(any(active))) {
+                ++stats_nodes;
                 if (likely(!node->leaf())) { // Inner node
                     const scalar_t<Float> split = node->split();
                     const uint32_t axis = node->axis();
@@ -2261,23 +2740,20 @@ public:
                     node = n_cur;
                     continue;
                 } else if (node->primitive_count() > 0) { // Arrived at a leaf node
-                    Index prim_start = node->primitive_offset();
-                    Index prim_end = prim_start + node->primitive_count();
-                    for (Index i = prim_start; i < prim_end; i++) {
-                        Index prim_index = m_indices[i];
-
-                        PreliminaryIntersection3f prim_pi =
-                            intersect_prim<ShadowRay>(prim_index, ray, active);
-
-                        masked(pi, prim_pi.is_valid()) = prim_pi;
-
-                        if constexpr (!ShadowRay) {
-                            Assert(all(!prim_pi.is_valid() ||
-                                       (prim_pi.t >= ray.mint &&
-                                        prim_pi.t <= ray.maxt)));
-                            masked(ray.maxt, prim_pi.is_valid()) = prim_pi.t;
-                        }
-                    }
+                    if constexpr (stats_enabled)
+                        stats_prims += node->primitive_count() * count(active);
+                    intersect_leaf<ShadowRay>(node, indices, ray, active,
+                        [&](const PreliminaryIntersection3f &prim_pi) {
+                            masked(pi, prim_pi.is_valid()) = prim_pi;
+
+                            if constexpr (!ShadowRay) {
+                                Assert(all(!prim_pi.is_valid() ||
+                                           (prim_pi.t >= ray.mint &&
+                                            prim_pi.t <= ray.maxt)));
+                                masked(ray.maxt, prim_pi.is_valid()) = prim_pi.t;
+                            }
+                            return false;
+                        });
                 }
             }
 
@@ -2296,6 +2772,31 @@ public:
         return pi;
     }
 
+    /// Dynamic array types used by the stream traversal
+    using DynamicRay3f = make_dynamic_t<Ray3f>;
+    using DynamicPreliminaryIntersection3f = make_dynamic_t<PreliminaryIntersection3f>;
+
+    /**
+     * \brief Intersect a large buffer of rays against the tree at once
+     *
+     * Unlike \ref ray_intersect_packet(), which traverses the tree for the
+     * rays of a single packet, this function traverses it breadth-first for
+     * all rays: every visited node receives the list of rays (along with
+     * their valid interval) that reach it, splits the list between its
+     * children, and leaves intersect their primitives with packets formed
+     * from the rays in their list. Rays that are shortened by a hit are
+     * culled from the lists that are still pending.
+     *
+     * The direction reciprocals of \c rays must be up to date (see \ref
+     * Ray::update()). The intersections are returned in the order of \c
+     * rays. With \c shadow_ray set, hits only have a valid distance of
+     * zero, as with \ref ray_intersect_preliminary().
+     *
+     * \remark Only supported by CPU packet variants.
+     */
+    DynamicPreliminaryIntersection3f ray_intersect_stream(const DynamicRay3f &rays,
+                                                          bool shadow_ray = false) const;
+
     /// Brute force intersection routine for debugging purposes
     template <bool ShadowRay>
     MTS_INLINE PreliminaryIntersection3f ray_intersect_naive(Ray3f ray,
@@ -2325,6 +2826,352 @@ public:
 
     MTS_DECLARE_CLASS()
 protected:
+    /// Build the kd-tree without consulting the cache
+    void build_tree();
+
+    /// Implementation of \ref ray_intersect_stream()
+    template <bool ShadowRay>
+    DynamicPreliminaryIntersection3f ray_intersect_stream_impl(const DynamicRay3f &rays) const;
+
+    /// Try to memory-map the tree from a cache file (returns \c false if it is unusable)
+    bool load_cache(const fs::path &filename, uint64_t key);
+
+    /// Write the tree to a cache file
+    void write_cache(const fs::path &filename, uint64_t key) const;
+
+    /**
+     * \brief Re-encode the index list of a freshly built tree in the compact
+     * format (see \ref m_compact_indices)
+     */
+    void compact_indices();
+
+    /**
+     * \brief Invoke \c func on the primitive indices of a leaf node until it
+     * returns \c true, decoding the compact format if needed
+     *
+     * In that format, the index list is a sequence of 16-bit words, and
+     * leaves refer to word offsets. A single primitive is stored as a 32-bit
+     * index. Larger leaves start with a 32-bit header holding the smallest
+     * primitive index, followed by the 16-bit offsets of all primitives
+     * relative to it. When the indices of a leaf span more than 16 bits, the
+     * header is \ref CompactWide and 32-bit indices follow.
+     */
+    template <typename Func>
+    MTS_INLINE bool for_each_primitive(const KDNode *node, const Index *indices,
+                                       Func &&func) const {
+        Index offset = node->primitive_offset(),
+              count  = node->primitive_count();
+
+        if (likely(!m_compact_indices)) {
+            for (Index i = offset; i < offset + count; ++i) {
+                if (func(indices[i]))
+                    return true;
+            }
+            return false;
+        }
+
+        const uint8_t *data = (const uint8_t *) indices + offset * sizeof(uint16_t);
+        auto read_16 = [](const uint8_t *ptr) {
+            uint16_t value;
+            memcpy(&value, ptr, sizeof(uint16_t));
+            return (Index) value;
+        };
+        auto read_32 = [&](const uint8_t *ptr) {
+            return read_16(ptr) | (read_16(ptr + sizeof(uint16_t)) << 16);
+        };
+
+        if (count == 1)
+            return func(read_32(data));
+
+        Index base = read_32(data);
+        data += 2 * sizeof(uint16_t);
+        if (unlikely(base == CompactWide)) {
+            for (Index i = 0; i < count; ++i) {
+                if (func(read_32(data + 2 * i * sizeof(uint16_t))))
+                    return true;
+            }
+        } else {
+            for (Index i = 0; i < count; ++i) {
+                if (func(base + read_16(data + i * sizeof(uint16_t))))
+                    return true;
+            }
+        }
+        return false;
+    }
+
+    /**
+     * \brief Precompute the triangle records of a freshly built or loaded
+     * tree (see \ref m_triangle_records)
+     */
+    void build_triangle_records();
+
+    /**
+     * \brief Gather the analytic shapes of the leaves into batches (see \ref
+     * ShapeBatch) for a freshly built or loaded tree
+     *
+     * A leaf gets batches for each kind of \ref AnalyticShape of which it
+     * holds at least \ref m_shape_batches shapes.
+     */
+    void build_shape_batches();
+
+    /// Return the storage of the triangle records and of the shape batches
+    size_t record_storage() const;
+
+    /**
+     * \brief Intersect the primitives of a leaf node and invoke \c func on
+     * each result until it returns \c true
+     *
+     * Uses the shape batches and the triangle records when available, and
+     * \ref intersect_prim() otherwise.
+     */
+    template <bool ShadowRay, typename Func>
+    MTS_INLINE bool intersect_leaf(const KDNode *node, const Index *indices,
+                                   const Ray3f &ray, const Mask &active,
+                                   Func &&func) const {
+        if constexpr (!is_array_v<Float>) {
+            const LeafBatches *leaf =
+                m_leaf_batches.empty() ? nullptr : &m_leaf_batches[node - local_nodes()];
+
+            if (leaf && leaf->batch_count > 0) {
+                for (Index i = 0; i < leaf->batch_count; ++i) {
+                    if (func(intersect_batch<ShadowRay>(m_batches[leaf->batch_offset + i], ray)))
+                        return true;
+                }
+                for (Index i = 0; i < leaf->index_count; ++i) {
+                    if (func(intersect_prim<ShadowRay>(m_batch_indices[leaf->index_offset + i],
+                                                       ray, active)))
+                        return true;
+                }
+                return false;
+            }
+        }
+
+        if (m_records) {
+            const TriangleRecord *records = m_records.get() + node->primitive_offset();
+            for (Index i = 0; i < node->primitive_count(); ++i) {
+                if (func(intersect_record<ShadowRay>(records[i], ray, active)))
+                    return true;
+            }
+            return false;
+        }
+
+        return for_each_primitive(node, indices, [&](Index prim_index) {
+            return func(intersect_prim<ShadowRay>(prim_index, ray, active));
+        });
+    }
+
+    /// Intersect the primitive described by a triangle record
+    template <bool ShadowRay>
+    MTS_INLINE PreliminaryIntersection3f
+    intersect_record(const TriangleRecord &rec, const Ray3f &ray, Mask active) const {
+        if (unlikely(rec.shape_index == NonMeshRecord))
+            return intersect_prim<ShadowRay>(rec.prim_index, ray, active);
+
+        Point3f p0(rec.v[0][0], rec.v[0][1], rec.v[0][2]);
+        Vector3f a(rec.v[1][0], rec.v[1][1], rec.v[1][2]),
+                 b(rec.v[2][0], rec.v[2][1], rec.v[2][2]);
+
+        Float t, u, v;
+        if (m_triangle_records == TriangleRecords::Edges) {
+            Vector3f pvec = cross(ray.d, b);
+            Float inv_det = rcp(dot(a, pvec));
+
+            Vector3f tvec = ray.o - p0;
+            u = dot(tvec, pvec) * inv_det;
+            active &= u >= 0.f && u <= 1.f;
+
+            Vector3f qvec = cross(tvec, a);
+            v = dot(ray.d, qvec) * inv_det;
+            active &= v >= 0.f && u + v <= 1.f;
+
+            t = dot(b, qvec) * inv_det;
+        } else {
+            /* Watertight test: permute the axes so that the largest component
+               of the direction is along z, and shear the vertices so that the
+               ray runs along the z axis through the origin */
+            Vector3f d_abs = abs(ray.d);
+            Mask z_max = d_abs.z() >= d_abs.x() && d_abs.z() >= d_abs.y(),
+                 y_max = !z_max && d_abs.y() >= d_abs.x();
+            auto permute = [&](const Vector3f &x) {
+                return Vector3f(select(z_max, x.x(), select(y_max, x.z(), x.y())),
+                                select(z_max, x.y(), select(y_max, x.x(), x.z())),
+                                select(z_max, x.z(), select(y_max, x.y(), x.x())));
+            };
+
+            Vector3f d = permute(ray.d);
+            Float sz = rcp(d.z()), sx = -d.x() * sz, sy = -d.y() * sz;
+
+            Vector3f v0 = permute(p0 - ray.o), v1 = permute(a - ray.o),
+                     v2 = permute(b - ray.o);
+            Float x0 = fmadd(sx, v0.z(), v0.x()), y0 = fmadd(sy, v0.z(), v0.y()),
+                  x1 = fmadd(sx, v1.z(), v1.x()), y1 = fmadd(sy, v1.z(), v1.y()),
+                  x2 = fmadd(sx, v2.z(), v2.x()), y2 = fmadd(sy, v2.z(), v2.y());
+
+            // Scaled barycentric coordinates from the edge functions
+            Float e0 = x2 * y1 - y2 * x1,
+                  e1 = x0 * y2 - y0 * x2,
+                  e2 = x1 * y0 - y1 * x0;
+            active &= !((e0 < 0.f || e1 < 0.f || e2 < 0.f) &&
+                        (e0 > 0.f || e1 > 0.f || e2 > 0.f));
+
+            Float det = e0 + e1 + e2;
+            active &= neq(det, 0.f);
+
+            Float inv_det = rcp(det);
+            t = (e0 * v0.z() + e1 * v1.z() + e2 * v2.z()) * sz * inv_det;
+            u = e1 * inv_det;
+            v = e2 * inv_det;
+        }
+        active &= t >= ray.mint && t <= ray.maxt;
+
+        PreliminaryIntersection3f pi;
+        if constexpr (ShadowRay) {
+            pi.t = select(active, Float(0.f), math::Infinity<Float>);
+            pi.prim_index = rec.prim_index;
+            pi.shape = m_shapes[rec.shape_index].get();
+        } else {
+            pi = zero<PreliminaryIntersection3f>();
+            pi.t = select(active, t, math::Infinity<Float>);
+            pi.prim_uv = Point2f(u, v);
+            pi.prim_index = rec.prim_index;
+            pi.shape = m_shapes[rec.shape_index].get();
+        }
+        return pi;
+    }
+
+    /**
+     * \brief Intersect all shapes of a batch at once and return the closest
+     * intersection (scalar variants only)
+     *
+     * The lanes evaluate the same tests as \ref
+     * Shape::ray_intersect_preliminary() of the corresponding shapes.
+     */
+    template <bool ShadowRay>
+    PreliminaryIntersection3f intersect_batch(const ShapeBatch &batch,
+                                              const Ray3f &ray) const {
+        using BatchFloat    = Packet<ScalarFloat, BatchSize>;
+        using BatchDouble   = Packet<double, BatchSize>;
+        using BatchVector3f = Vector<BatchFloat, 3>;
+        using BatchVector3d = Vector<BatchDouble, 3>;
+
+        auto param = [&](size_t k) { return load<BatchFloat>(batch.params[k]); };
+
+        auto lane_f = arange<BatchFloat>() < ScalarFloat(batch.size);
+        auto lane_d = arange<BatchDouble>() < double(batch.size);
+
+        // Map the ray to the local frames of the lanes, as Transform::transform_affine()
+        auto to_object = [&](BatchVector3f &o, BatchVector3f &d) {
+            for (size_t i = 0; i < 3; ++i) {
+                BatchFloat m0 = param(4 * i),     m1 = param(4 * i + 1),
+                           m2 = param(4 * i + 2), m3 = param(4 * i + 3);
+                o[i] = fmadd(m2, BatchFloat(ray.o.z()),
+                       fmadd(m1, BatchFloat(ray.o.y()),
+                       fmadd(m0, BatchFloat(ray.o.x()), m3)));
+                d[i] = fmadd(m2, BatchFloat(ray.d.z()),
+                       fmadd(m1, BatchFloat(ray.d.y()), m0 * ray.d.x()));
+            }
+        };
+
+        BatchFloat t = math::Infinity<ScalarFloat>, u = 0.f, v = 0.f;
+        BatchDouble mint = double(ray.mint), maxt = double(ray.maxt);
+
+        switch (batch.kind) {
+            case AnalyticShape::Sphere: {
+                BatchVector3d o(BatchDouble(ray.o.x()) - BatchDouble(param(0)),
+                                BatchDouble(ray.o.y()) - BatchDouble(param(1)),
+                                BatchDouble(ray.o.z()) - BatchDouble(param(2)));
+                BatchVector3d d(BatchDouble(ray.d.x()), BatchDouble(ray.d.y()),
+                                BatchDouble(ray.d.z()));
+
+                BatchDouble A = squared_norm(d),
+                            B = 2.0 * dot(o, d),
+                            C = squared_norm(o) - sqr(BatchDouble(param(3)));
+
+                auto [solution_found, near_t, far_t] = math::solve_quadratic(A, B, C);
+
+                auto out_bounds = !(near_t <= maxt && far_t >= mint); // NaN-aware conditionals
+                auto in_bounds  = near_t < mint && far_t > maxt;
+                auto hit = lane_d && solution_found && !out_bounds && !in_bounds;
+
+                t = BatchFloat(select(hit, select(near_t < mint, far_t, near_t),
+                                      BatchDouble(math::Infinity<double>)));
+            }
+            break;
+
+            case AnalyticShape::Disk:
+            case AnalyticShape::Rectangle: {
+                BatchVector3f o, d;
+                to_object(o, d);
+
+                BatchFloat t_plane = -o.z() * rcp(d.z());
+                u = fmadd(d.x(), t_plane, o.x());
+                v = fmadd(d.y(), t_plane, o.y());
+
+                auto hit = lane_f && t_plane >= ray.mint && t_plane <= ray.maxt;
+                if (batch.kind == AnalyticShape::Disk)
+                    hit &= u * u + v * v <= 1.f;
+                else
+                    hit &= abs(u) <= 1.f && abs(v) <= 1.f;
+
+                t = select(hit, t_plane, BatchFloat(math::Infinity<ScalarFloat>));
+            }
+            break;
+
+            case AnalyticShape::Cylinder: {
+                BatchVector3f o_, d_;
+                to_object(o_, d_);
+                BatchVector3d o(o_), d(d_);
+                BatchDouble radius = BatchDouble(param(12)),
+                            length = BatchDouble(param(13));
+
+                BatchDouble A = sqr(d.x()) + sqr(d.y()),
+                            B = 2.0 * (d.x() * o.x() + d.y() * o.y()),
+                            C = sqr(o.x()) + sqr(o.y()) - sqr(radius);
+
+                auto [solution_found, near_t, far_t] = math::solve_quadratic(A, B, C);
+
+                auto out_bounds = !(near_t <= maxt && far_t >= mint); // NaN-aware conditionals
+                auto in_bounds  = near_t < mint && far_t > maxt;
+
+                BatchDouble z_pos_near = o.z() + d.z() * near_t,
+                            z_pos_far  = o.z() + d.z() * far_t;
+                auto near_valid = z_pos_near >= 0.0 && z_pos_near <= length && near_t >= mint,
+                     far_valid  = z_pos_far  >= 0.0 && z_pos_far  <= length && far_t  <= maxt;
+
+                auto hit = lane_d && solution_found && !out_bounds && !in_bounds &&
+                           (near_valid || far_valid);
+
+                t = BatchFloat(select(hit, select(near_valid, near_t, far_t),
+                                      BatchDouble(math::Infinity<double>)));
+            }
+            break;
+
+            default:
+                break;
+        }
+
+        PreliminaryIntersection3f pi = zero<PreliminaryIntersection3f>();
+        pi.t = math::Infinity<Float>;
+
+        ScalarFloat t_min = hmin(t);
+        if (!(t_min < math::Infinity<ScalarFloat>))
+            return pi;
+
+        size_t lane = 0;
+        while (t.coeff(lane) != t_min)
+            ++lane;
+
+        if constexpr (ShadowRay) {
+            pi.t = 0.f;
+        } else {
+            pi.t = t_min;
+            pi.prim_uv = Point2f(u.coeff(lane), v.coeff(lane));
+        }
+        pi.prim_index = batch.prim_index[lane];
+        pi.shape = batch.shape[lane];
+        return pi;
+    }
+
     /**
      * \brief Map an abstract \ref TShapeKDTree primitive index to a specific
      * shape managed by the \ref ShapeKDTree.
@@ -2372,17 +3219,20 @@ protected:
                 const Mesh *mesh = (const Mesh *) shape;
                 hit = mesh->ray_intersect_triangle(prim_index, ray, active).is_valid();
             } else {
-                hit = shape->ray_test(ray, active);
+                hit = shape->ray_test_primitive(prim_index, ray, active);
             }
 
+            // Shadow rays only report the occluder (see \ref Scene::ray_test())
             pi.t = select(hit, Float(0.f), math::Infinity<Float>);
+            pi.prim_index = prim_index;
+            pi.shape = shape;
             return pi;
         } else {
             if (shape->is_mesh()) {
                 const Mesh *mesh = (const Mesh *) shape;
                 pi = mesh->ray_intersect_triangle(prim_index, ray, active);
             } else {
-                pi = shape->ray_intersect_preliminary(ray, active);
+                pi = shape->ray_intersect_primitive(prim_index, ray, active);
             }
 
             return pi;
@@ -2392,6 +3242,33 @@ protected:
 protected:
     std::vector<ref<Shape>> m_shapes;
     std::vector<Size> m_primitive_map;
+
+    /// Directory of the kd-tree cache (empty: disabled)
+    fs::path m_cache_dir;
+
+    /// Is the index list stored in the compact format? (see \ref for_each_primitive())
+    bool m_compact_indices = false;
+
+    /// Kind of the precomputed triangle records (see \ref TriangleRecord)
+    TriangleRecords m_triangle_records = TriangleRecords::None;
+
+    /// Triangle records parallel to the index list (empty when disabled)
+    std::unique_ptr<TriangleRecord[]> m_records;
+
+    /// Minimum number of shapes of the same kind batched in a leaf (0: disabled)
+    uint32_t m_shape_batches = 0;
+
+    /// Shape batches of all leaves (see \ref build_shape_batches())
+    std::vector<ShapeBatch> m_batches;
+
+    /// Batches of each node, indexed like the node list (empty when disabled)
+    std::vector<LeafBatches> m_leaf_batches;
+
+    /// Remaining primitives of the leaves with batches (see \ref LeafBatches)
+    std::vector<Index> m_batch_indices;
+
+    /// Storage of the nodes, indices and triangle records
+    MemoryRecord m_memory { MemoryCategory::KDTree };
 };
 
 MTS_EXTERN_CLASS_RENDER(ShapeKDTree)
@@ -0,0 +1,117 @@
+#pragma once
+
+#include <mitsuba/core/bbox.h>
+#include <mitsuba/core/object.h>
+#include <mitsuba/core/vector.h>
+#include <mitsuba/render/emitter.h>
+#include <mitsuba/render/interaction.h>
+#include <enoki/dynamic.h>
+
+NAMESPACE_BEGIN(mitsuba)
+
+/**
+ * \brief Bounding volume hierarchy over the emitters of a scene, which
+ * importance samples them according to their estimated contribution at a
+ * reference point
+ *
+ * Each node stores the bounds of its emitters: their bounding box, their
+ * total power (see \ref Emitter::power()), and a cone that bounds their
+ * directions of emission (see \ref Emitter::emission_cone()). Sampling
+ * descends from the root and picks each child with a probability that is
+ * proportional to a conservative estimate of its contribution, which
+ * accounts for the distance to the reference point and for the orientation
+ * of the emitters. Evaluating the probability of an emitter retraces its
+ * path through the tree, which is stored as a bit trail per emitter.
+ *
+ * Emitters that do not have a valid bounding box (e.g. environment maps or
+ * directional emitters) are sampled uniformly with a probability that is
+ * proportional to their number, where the whole hierarchy counts as one
+ * emitter. Emitters without power are never sampled.
+ *
+ * The hierarchy is a binary tree with one emitter per leaf, which is built by
+ * splitting the emitters at the median of their centers along the largest
+ * axis of the bounds of the centers.
+ */
+template <typename Float, typename Spectrum>
+class MTS_EXPORT_RENDER LightBVH : public Object {
+public:
+    MTS_IMPORT_TYPES(Emitter)
+
+    /// Build the hierarchy over the given emitters (see \ref Emitter::index())
+    LightBVH(const host_vector<ref<Emitter>, Float> &emitters);
+
+    /**
+     * \brief Sample an emitter for the reference interaction \c ref
+     *
+     * \return A tuple with the index of the sampled emitter, its discrete
+     * probability, and the sample \c sample rescaled to <tt>[0, 1)</tt> so
+     * that it can be reused. A probability of zero indicates that no emitter
+     * contributes to \c ref.
+     */
+    std::tuple<UInt32, Float, Float> sample(const Interaction3f &ref, Float sample,
+                                            Mask active = true) const;
+
+    /// Return the discrete probability of sampling the emitter \c index from \c ref
+    Float pdf(const Interaction3f &ref, UInt32 index, Mask active = true) const;
+
+    /**
+     * \brief Update the bounds of the emitters \c changed (e.g. following a
+     * change of their power), keeping the topology of the hierarchy
+     *
+     * Only the leaves of these emitters and the nodes on their paths from the
+     * root are updated, whose bounds remain conservative even when the
+     * emitters moved (the hierarchy may then be less efficient, though).
+     *
+     * \return \c false, leaving the hierarchy untouched, when an emitter
+     * gained or lost its power or its bounding box, in which case the
+     * hierarchy must be rebuilt.
+     */
+    bool refit(const host_vector<ref<Emitter>, Float> &emitters,
+               const std::vector<uint32_t> &changed);
+
+    /// Return the number of nodes of the hierarchy
+    size_t node_count() const { return m_node_count; }
+
+    std::string to_string() const override;
+
+    MTS_DECLARE_CLASS()
+protected:
+    virtual ~LightBVH();
+
+    /// Estimate the contribution of the emitters of the node \c node to \c p
+    Float importance(const Point3f &p, const UInt32 &node, Mask active) const;
+
+private:
+    /// Number of values per node in \ref m_node_data
+    static constexpr uint32_t NodeSize = 12;
+
+    /// Marks the leaves within \ref m_node_child
+    static constexpr uint32_t LeafFlag = 0x80000000u;
+
+    /// Kind of each emitter in \ref m_emitter_kind
+    enum EmitterKind : uint32_t { Unused = 0, Bounded = 1, Unbounded = 2 };
+
+    /* Bounds of the nodes in depth-first order: bounding box minimum and
+       maximum, cone axis, cosines of theta_o and theta_e, and power */
+    DynamicBuffer<Float> m_node_data;
+
+    /* Index of the second child of inner nodes (the first one follows its
+       parent), or emitter index with \ref LeafFlag set for leaves */
+    DynamicBuffer<UInt32> m_node_child;
+
+    /// Per-emitter kind and path from the root (bit \c i selects the child at depth \c i)
+    DynamicBuffer<UInt32> m_emitter_kind, m_emitter_trail;
+
+    /// Indices of the unbounded emitters
+    DynamicBuffer<UInt32> m_unbounded;
+
+    size_t m_node_count = 0;
+    uint32_t m_unbounded_count = 0;
+    uint32_t m_max_depth = 0;
+
+    /// Probability of sampling the unbounded emitters rather than the hierarchy
+    ScalarFloat m_unbounded_prob = 0.f;
+};
+
+MTS_EXTERN_CLASS_RENDER(LightBVH)
+NAMESPACE_END(mitsuba)
@@ -45,9 +45,14 @@ public:
      * \return         This method returns a MediumInteraction.
      *                 The MediumInteraction will always be valid,
      *                 except if the ray missed the Medium's bounding box.
+     *
+     * The default implementation uses \ref get_combined_extinction() as a
+     * constant majorant along the ray. Media with a spatially varying
+     * majorant override it, in which case \c combined_extinction holds the
+     * majorant at the sampled position.
      */
-    MediumInteraction3f sample_interaction(const Ray3f &ray, Float sample,
-                                           UInt32 channel, Mask active) const;
+    virtual MediumInteraction3f sample_interaction(const Ray3f &ray, Float sample,
+                                                   UInt32 channel, Mask active) const;
 
     /**
      * \brief Compute the transmittance and PDF
@@ -61,13 +66,41 @@ public:
      * fact that the free-flight distance sampling distribution can depend on
      * the wavelength.
      *
+     * \param ray  Ray that was passed to \ref sample_interaction()
+     *
      * \return   This method returns a pair of (Transmittance, PDF).
      *
+     * The default implementation assumes that the majorant \c
+     * mi.combined_extinction is constant along the ray. Media with a
+     * spatially varying majorant override it and integrate the majorant of
+     * each wavelength along the ray.
      */
-    std::pair<UnpolarizedSpectrum, UnpolarizedSpectrum>
-    eval_tr_and_pdf(const MediumInteraction3f &mi,
+    virtual std::pair<UnpolarizedSpectrum, UnpolarizedSpectrum>
+    eval_tr_and_pdf(const Ray3f &ray, const MediumInteraction3f &mi,
                     const SurfaceInteraction3f &si, Mask active) const;
 
+    /**
+     * \brief Estimate the transmittance along the segment <tt>[ray.mint,
+     * ray.maxt]</tt> of a ray
+     *
+     * The default implementation uses ratio tracking, i.e. it marches through
+     * the tentative collisions sampled by \ref sample_interaction() and
+     * multiplies the estimate by the probability of a null collision at each
+     * of them. This returns fractional values instead of the binary outcome
+     * of delta tracking.
+     *
+     * \param ray      Ray segment, which must not cross a surface
+     * \param sampler  Sampler that provides the random numbers of the estimator
+     * \param channel  The channel according to which the free-flight distances
+     * are sampled. This argument is only used when rendering in RGB modes.
+     * \param residual Use residual ratio tracking if the medium supports it,
+     * which tracks only the difference to a control extinction whose
+     * transmittance is known analytically.
+     */
+    virtual UnpolarizedSpectrum eval_transmittance(const Ray3f &ray, Sampler *sampler,
+                                                   UInt32 channel, bool residual,
+                                                   Mask active) const;
+
     /// Return the phase function of this medium
     MTS_INLINE const PhaseFunction *phase_function() const {
         return m_phase_function.get();
@@ -122,6 +155,7 @@ ENOKI_CALL_SUPPORT_TEMPLATE_BEGIN(mitsuba::Medium)
     ENOKI_CALL_SUPPORT_METHOD(intersect_aabb)
     ENOKI_CALL_SUPPORT_METHOD(sample_interaction)
     ENOKI_CALL_SUPPORT_METHOD(eval_tr_and_pdf)
+    ENOKI_CALL_SUPPORT_METHOD(eval_transmittance)
     ENOKI_CALL_SUPPORT_METHOD(get_scattering_coefficients)
 ENOKI_CALL_SUPPORT_TEMPLATE_END(mitsuba::Medium)
 
@@ -6,6 +6,7 @@
 #include <mitsuba/core/struct.h>
 #include <mitsuba/core/transform.h>
 #include <mitsuba/core/distr_1d.h>
+#include <mitsuba/core/memory.h>
 #include <mitsuba/core/properties.h>
 #include <tbb/spin_mutex.h>
 #include <unordered_map>
@@ -16,11 +17,12 @@ template <typename Float, typename Spectrum>
 class MTS_EXPORT_RENDER Mesh : public Shape<Float, Spectrum> {
 public:
     MTS_IMPORT_TYPES()
-    MTS_IMPORT_BASE(Shape, m_to_world, set_children)
+    MTS_IMPORT_BASE(Shape, m_to_world)
 
     // Mesh is always stored in single precision
     using InputFloat = float;
     using InputPoint3f  = Point<InputFloat, 3>;
+    using InputPoint2f  = Point<InputFloat, 2>;
     using InputVector2f = Vector<InputFloat, 2>;
     using InputVector3f = Vector<InputFloat, 3>;
     using InputNormal3f = Normal<InputFloat, 3>;
@@ -49,6 +51,11 @@ public:
     /// Const variant of \ref vertex_positions_buffer.
     const FloatStorage& vertex_positions_buffer() const { return m_vertex_positions_buf; }
 
+    /// Return the buffer of the vertex positions at the end of the motion (see \ref set_vertex_motion())
+    FloatStorage& vertex_positions_end_buffer() { return m_vertex_positions_end_buf; }
+    /// Const variant of \ref vertex_positions_end_buffer.
+    const FloatStorage& vertex_positions_end_buffer() const { return m_vertex_positions_end_buf; }
+
     /// Return vertex normals buffer
     FloatStorage& vertex_normals_buffer() { return m_vertex_normals_buf; }
     /// Const variant of \ref vertex_normals_buffer.
@@ -78,7 +85,14 @@ public:
     /// Returns the face indices associated with triangle \c index
     template <typename Index>
     MTS_INLINE auto face_indices(Index index, mask_t<Index> active = true) const {
-        using Result = Array<replace_scalar_t<Index, uint32_t>, 3>;
+        using UInt32Array = replace_scalar_t<Index, uint32_t>;
+        using Result = Array<UInt32Array, 3>;
+        if (unlikely(slices(m_faces_u16_buf) != 0)) {
+            UInt32Array offset = UInt32Array(index) * 3u;
+            return Result(gather_uint16(m_faces_u16_buf, offset, active),
+                          gather_uint16(m_faces_u16_buf, offset + 1u, active),
+                          gather_uint16(m_faces_u16_buf, offset + 2u, active));
+        }
         return gather<Result>(m_faces_buf, index, active);
     }
 
@@ -89,10 +103,33 @@ public:
         return gather<Result>(m_vertex_positions_buf, index, active);
     }
 
+    /**
+     * \brief Returns the world-space position of the vertex with index \c
+     * index at the given time (see \ref set_vertex_motion())
+     */
+    template <typename Index, typename Time>
+    MTS_INLINE auto vertex_position_at(Index index, const Time &time,
+                                       mask_t<Index> active = true) const {
+        using Result = Point<replace_scalar_t<Index, InputFloat>, 3>;
+        using Value  = value_t<Result>;
+        Result p0 = vertex_position(index, active);
+        if (likely(!has_vertex_motion()))
+            return p0;
+
+        Result p1 = gather<Result>(m_vertex_positions_end_buf, index, active);
+        Value alpha = clamp((Value(time) - Value(m_motion_time_start)) *
+                                Value(m_motion_time_scale), 0.f, 1.f);
+        return fmadd(p1 - p0, alpha, p0);
+    }
+
     /// Returns the normal direction of the vertex with index \c index
     template <typename Index>
     MTS_INLINE auto vertex_normal(Index index, mask_t<Index> active = true) const {
         using Result = Normal<replace_scalar_t<Index, InputFloat>, 3>;
+        using UInt32Array = replace_scalar_t<Index, uint32_t>;
+        if (unlikely(slices(m_vertex_normals_oct_buf) != 0))
+            return Result(decode_octahedral(
+                gather<UInt32Array>(m_vertex_normals_oct_buf, index, active)));
         return gather<Result>(m_vertex_normals_buf, index, active);
     }
 
@@ -100,6 +137,14 @@ public:
     template <typename Index>
     MTS_INLINE auto vertex_texcoord(Index index, mask_t<Index> active = true) const {
         using Result = Point<replace_scalar_t<Index, InputFloat>, 2>;
+        using UInt32Array = replace_scalar_t<Index, uint32_t>;
+        using Value = value_t<Result>;
+        if (unlikely(slices(m_vertex_texcoords_q_buf) != 0)) {
+            UInt32Array q = gather<UInt32Array>(m_vertex_texcoords_q_buf, index, active);
+            return Result(
+                fmadd(Value(q & 0xFFFFu), m_texcoord_scale.x(), m_texcoord_offset.x()),
+                fmadd(Value(q >> 16), m_texcoord_scale.y(), m_texcoord_offset.y()));
+        }
         return gather<Result>(m_vertex_texcoords_buf, index, active);
     }
 
@@ -116,10 +161,73 @@ public:
     }
 
     /// Does this mesh have per-vertex normals?
-    bool has_vertex_normals() const { return slices(m_vertex_normals_buf) != 0; }
+    bool has_vertex_normals() const {
+        return slices(m_vertex_normals_buf) != 0 || slices(m_vertex_normals_oct_buf) != 0;
+    }
 
     /// Does this mesh have per-vertex texture coordinates?
-    bool has_vertex_texcoords() const { return slices(m_vertex_texcoords_buf) != 0; }
+    bool has_vertex_texcoords() const {
+        return slices(m_vertex_texcoords_buf) != 0 || slices(m_vertex_texcoords_q_buf) != 0;
+    }
+
+    /// Is any of the vertex or face data stored in compressed form? (see \ref compress_vertex_data())
+    bool has_compressed_vertex_data() const;
+
+    /**
+     * \brief Convert the vertex data into compact encodings
+     *
+     * Vertex normals are stored as two 16-bit octahedral coordinates, texture
+     * coordinates as two 16-bit values relative to the UV range of the mesh,
+     * and mesh attributes in half precision. This reduces the size of these
+     * arrays by a factor of three (normals) or two (texture coordinates and
+     * attributes) at the cost of a small quantization error. Meshes with at
+     * most 65536 vertices additionally store their face indices with 16 bits
+     * (except when Embree is used, which requires 32-bit indices). The
+     * accessors such as \ref vertex_normal() and \ref face_indices() decode
+     * the data transparently, while the corresponding raw buffers become
+     * empty and are no longer exposed as differentiable parameters.
+     *
+     * The shape plugins call this function after loading when the
+     * \c compress_vertex_data property is set. Compressed meshes cannot be
+     * exported, and the compression is not supported in GPU variants.
+     */
+    void compress_vertex_data();
+
+    /**
+     * \brief Reorder the faces and vertices of the mesh by their position
+     *
+     * The faces are sorted along a Morton curve through their centroids,
+     * and the vertices are renumbered in the order in which the sorted faces
+     * first reference them. Triangles that are close in space then also lie
+     * close in memory, which makes the accesses of the acceleration data
+     * structure more coherent. This matters most for meshes that are
+     * exported via \ref write_mtsmesh() and later memory-mapped by the \c
+     * mtsmesh plugin, where every access to a new region of the file may
+     * require a disk read.
+     *
+     * The shape plugins call this function after loading when the
+     * \c sort_spatially property is set, before compressing the vertex data.
+     * The mesh must not be part of a scene yet, since acceleration data
+     * structures refer to faces by their index. Meshes with compressed
+     * vertex data cannot be reordered, and the function is not supported in
+     * GPU variants.
+     */
+    void sort_spatially();
+
+    /// Do the vertices of this mesh move? (see \ref set_vertex_motion())
+    bool has_vertex_motion() const { return slices(m_vertex_positions_end_buf) != 0; }
+
+    /**
+     * \brief Enable linear vertex motion between two keyframes
+     *
+     * The vertex positions buffer holds the positions at \c time_start,
+     * and a second buffer (see \ref vertex_positions_end_buffer()) holds
+     * those at \c time_end. The latter is initialized with the current
+     * positions when the motion is first enabled. Intersections interpolate
+     * both using the time of the ray, and the mesh is at rest outside of
+     * the interval. Call \ref recompute_bbox() after updating the buffer.
+     */
+    void set_vertex_motion(ScalarFloat time_start, ScalarFloat time_end);
 
     /// @}
     // =========================================================================
@@ -127,6 +235,48 @@ public:
     /// Export mesh as a binary PLY file
     void write_ply(const std::string &filename) const;
 
+    /**
+     * \brief Equivalent to \ref write_ply(), but executes asynchronously on
+     * a different thread
+     *
+     * The mesh must not be modified until the file has been written. Errors
+     * are reported as warnings.
+     */
+    void write_ply_async(const std::string &filename) const;
+
+    /**
+     * \brief Export mesh as a \c .mtsmesh cache file
+     *
+     * Besides the vertex and face data, the file stores the bounding box
+     * and the area PMF used for position sampling, so that the
+     * \c mtsmesh plugin can load the mesh without any computation. Vertex
+     * motion (see \ref set_vertex_motion()) is not stored.
+     */
+    void write_mtsmesh(const std::string &filename) const;
+
+    /**
+     * \brief Hash of the mesh data that does not depend on its placement
+     *
+     * Covers the face indices, texture coordinates and mesh attributes, but
+     * not the vertex positions and normals, which change with the \c
+     * to_world transformation. Meshes with equal hashes are candidates for
+     * \ref is_placed_copy_of().
+     */
+    uint64_t placement_invariant_hash() const;
+
+    /**
+     * \brief Is this mesh a copy of \c other placed by a different \c
+     * to_world transformation?
+     *
+     * The face indices, texture coordinates and attributes must be identical,
+     * and the vertex positions must match those of \c other mapped by the
+     * relative transformation of the two meshes up to a small tolerance.
+     * When this is the case, the function stores that transformation in \c
+     * transform and returns \c true. Meshes with vertex motion or
+     * compressed vertex data are never considered copies.
+     */
+    bool is_placed_copy_of(const Mesh *other, ScalarTransform4f &transform) const;
+
     /// Compute smooth vertex normals and replace the current normal values
     void recompute_vertex_normals();
 
@@ -144,10 +294,21 @@ public:
     virtual ScalarBoundingBox3f bbox(ScalarIndex index,
                                      const ScalarBoundingBox3f &clip) const override;
 
+    virtual bool has_motion() const override { return has_vertex_motion(); }
+
+    virtual ScalarVector2f motion_time_range() const override;
+
+    virtual std::pair<ScalarBoundingBox3f, ScalarBoundingBox3f>
+    bbox_motion(ScalarIndex index, ScalarFloat time_start,
+                ScalarFloat time_end) const override;
+
     virtual ScalarSize primitive_count() const override;
 
     virtual ScalarFloat surface_area() const override;
 
+    /// Return a cone that bounds the normals of the faces of the mesh
+    virtual std::pair<ScalarVector3f, ScalarFloat> normal_cone() const override;
+
     virtual PositionSample3f sample_position(Float time, const Point2f &sample,
                                              Mask active = true) const override;
 
@@ -157,6 +318,10 @@ public:
     barycentric_coordinates(const SurfaceInteraction3f &si,
                             Mask active = true) const;
 
+    /// Barycentric coordinates within the triangle with the given face indices
+    Point3f barycentric_coordinates(const SurfaceInteraction3f &si, const Vector3u &fi,
+                                    Mask active = true) const;
+
     virtual SurfaceInteraction3f compute_surface_interaction(const Ray3f &ray,
                                                              PreliminaryIntersection3f pi,
                                                              HitComputeFlags flags,
@@ -175,6 +340,23 @@ public:
     virtual SurfaceInteraction3f eval_parameterization(const Point2f &uv,
                                                        Mask active = true) const override;
 
+    /**
+     * \brief Evaluate several monochromatic attributes at once
+     *
+     * Equivalent to calling \ref eval_attribute_1() for every name, except
+     * that the face indices and barycentric coordinates of the intersection
+     * are only computed once. This is useful when a material reads several
+     * vertex attributes at every hit.
+     */
+    std::vector<Float> eval_attributes_1(const std::vector<std::string> &names,
+                                         const SurfaceInteraction3f &si,
+                                         Mask active = true) const;
+
+    /// Trichromatic version of \ref eval_attributes_1() (see \ref eval_attribute_3())
+    std::vector<Color3f> eval_attributes_3(const std::vector<std::string> &names,
+                                           const SurfaceInteraction3f &si,
+                                           Mask active = true) const;
+
     /** \brief Ray-triangle intersection test
      *
      * Uses the algorithm by Moeller and Trumbore discussed at
@@ -196,9 +378,9 @@ public:
                            Mask active = true) const {
         auto fi = face_indices(index);
 
-        Point3f p0 = vertex_position(fi[0]),
-                p1 = vertex_position(fi[1]),
-                p2 = vertex_position(fi[2]);
+        Point3f p0 = vertex_position_at(fi[0], ray.time),
+                p1 = vertex_position_at(fi[1], ray.time),
+                p2 = vertex_position_at(fi[2], ray.time);
 
         Vector3f e1 = p1 - p0, e2 = p2 - p0;
 
@@ -228,6 +410,15 @@ public:
 #if defined(MTS_ENABLE_EMBREE)
     /// Return the Embree version of this shape
     virtual RTCGeometry embree_geometry(RTCDevice device) override;
+
+    /**
+     * \brief Update an Embree geometry created by \ref embree_geometry()
+     *
+     * Re-binds the (possibly reallocated) vertex and face buffers, so that
+     * the next commit of the scene refits the geometry when \ref
+     * accel_refit() is set. Embree rebuilds it when the face count changed.
+     */
+    void embree_update_geometry(RTCGeometry geom);
 #endif
 
 #if defined(MTS_ENABLE_OPTIX)
@@ -254,6 +445,18 @@ protected:
     inline Mesh() {}
     virtual ~Mesh();
 
+    /**
+     * \brief Register this mesh as the parent of its sub-objects (see \ref
+     * Shape::set_children())
+     *
+     * The mesh plugins invoke this function once all buffers have been
+     * loaded, which also accounts for their memory in \ref MemoryAccounting.
+     */
+    void set_children();
+
+    /// Update the memory accounted for the vertex, face and attribute buffers
+    void update_memory_record();
+
     /**
      * \brief Build internal tables for sampling uniformly wrt. area.
      *
@@ -288,26 +491,62 @@ protected:
         size_t size;
         MeshAttributeType type;
         FloatStorage buf;
+
+        /// Pairs of half precision values that replace \c buf once compressed
+        DynamicBuffer<UInt32> half_buf;
     };
 
-    template <uint32_t Size, bool Raw>
-    auto interpolate_attribute(MeshAttributeType type,
-                               const FloatStorage &buf,
-                               const SurfaceInteraction3f &si,
-                               Mask active) const {
+    /**
+     * \brief Check the name and channel count of a new attribute
+     *
+     * Throws when an attribute with this name already exists, when the name
+     * does not start with \c "vertex_" or \c "face_", or when \c dim is zero.
+     * Returns whether the attribute is defined per vertex or per face.
+     */
+    MeshAttributeType check_attribute(const std::string &name, size_t dim) const;
+
+    /// Fetch the stored value of an attribute with \c Size channels
+    template <uint32_t Size>
+    auto fetch_attribute(const MeshAttribute &attribute, const UInt32 &index,
+                         Mask active) const {
         using StorageType =
             std::conditional_t<Size == 1,
                                replace_scalar_t<Float, InputFloat>,
                                replace_scalar_t<Color3f, InputFloat>>;
-        using ReturnType = std::conditional_t<Size == 1, Float, Color3f>;
 
-        if (type == MeshAttributeType::Vertex) {
-            auto fi = face_indices(si.prim_index, active);
-            Point3f b = barycentric_coordinates(si, active);
+        if (likely(slices(attribute.half_buf) == 0))
+            return gather<StorageType>(attribute.buf, index, active);
+
+        StorageType result;
+        if constexpr (Size == 1) {
+            result = decode_half(gather_uint16(attribute.half_buf, index, active));
+        } else {
+            for (uint32_t i = 0; i < Size; ++i)
+                result[i] = decode_half(
+                    gather_uint16(attribute.half_buf, index * Size + i, active));
+        }
+        return result;
+    }
+
+    /**
+     * \brief Interpolate an attribute with \c Size channels
+     *
+     * The face indices \c fi and barycentric coordinates \c b of the
+     * intersection are passed in, so that several attributes can be
+     * evaluated without fetching the triangle again (they are only used for
+     * vertex attributes).
+     */
+    template <uint32_t Size, bool Raw>
+    auto interpolate_attribute(const MeshAttribute &attribute,
+                               const SurfaceInteraction3f &si,
+                               const Vector3u &fi, const Point3f &b,
+                               Mask active) const {
+        using ReturnType = std::conditional_t<Size == 1, Float, Color3f>;
 
-            StorageType v0 = gather<StorageType>(buf, fi[0], active),
-                        v1 = gather<StorageType>(buf, fi[1], active),
-                        v2 = gather<StorageType>(buf, fi[2], active);
+        if (attribute.type == MeshAttributeType::Vertex) {
+            auto v0 = fetch_attribute<Size>(attribute, fi[0], active),
+                 v1 = fetch_attribute<Size>(attribute, fi[1], active),
+                 v2 = fetch_attribute<Size>(attribute, fi[2], active);
 
             // Barycentric interpolation
             if constexpr (is_spectral_v<Spectrum> && Size == 3 && !Raw) {
@@ -325,7 +564,7 @@ protected:
                 return (ReturnType) fmadd(v0, b[0], fmadd(v1, b[1], v2 * b[2]));
             }
         } else {
-            StorageType v = gather<StorageType>(buf, si.prim_index, active);
+            auto v = fetch_attribute<Size>(attribute, si.prim_index, active);
             if constexpr (is_spectral_v<Spectrum> && Size == 3 && !Raw) {
                 return srgb_model_eval<UnpolarizedSpectrum>(v, si.wavelengths);
             } else {
@@ -334,6 +573,50 @@ protected:
         }
     }
 
+    template <uint32_t Size, bool Raw>
+    auto interpolate_attribute(const MeshAttribute &attribute,
+                               const SurfaceInteraction3f &si,
+                               Mask active) const {
+        Vector3u fi;
+        Point3f b;
+        if (attribute.type == MeshAttributeType::Vertex) {
+            fi = face_indices(si.prim_index, active);
+            b = barycentric_coordinates(si, fi, active);
+        }
+        return interpolate_attribute<Size, Raw>(attribute, si, fi, b, active);
+    }
+
+    /// Look up the attribute \c name and check its number of channels
+    const MeshAttribute &attribute(const std::string &name, size_t size,
+                                   const char *caller) const;
+
+    /// Shared implementation of \ref eval_attributes_1() and \ref eval_attributes_3()
+    template <uint32_t Size, typename Result>
+    std::vector<Result> eval_attributes(const std::vector<std::string> &names,
+                                        const SurfaceInteraction3f &si, Mask active,
+                                        const char *caller) const;
+
+    /// Decode a normal stored as two signed 16-bit octahedral coordinates
+    template <typename UInt32Array>
+    MTS_INLINE static auto decode_octahedral(const UInt32Array &word) {
+        using Value = replace_scalar_t<UInt32Array, InputFloat>;
+        using Int32Array = replace_scalar_t<UInt32Array, int32_t>;
+
+        Value x = Value(reinterpret_array<Int32Array>(word << 16) >> 16) * (1.f / 32767.f),
+              y = Value(reinterpret_array<Int32Array>(word) >> 16) * (1.f / 32767.f),
+              z = 1.f - abs(x) - abs(y);
+
+        // Unfold the lower hemisphere
+        Value t = max(-z, 0.f);
+        x += select(x >= 0.f, -t, t);
+        y += select(y >= 0.f, -t, t);
+
+        return normalize(Normal<Value, 3>(x, y, z));
+    }
+
+    /// Octahedral encoding of the vertex normals (see \ref compress_vertex_data())
+    void compress_vertex_normals();
+
 protected:
     std::string m_name;
     ScalarBoundingBox3f m_bbox;
@@ -342,13 +625,29 @@ protected:
     ScalarSize m_face_count = 0;
 
     FloatStorage m_vertex_positions_buf;
+    FloatStorage m_vertex_positions_end_buf;
     FloatStorage m_vertex_normals_buf;
     FloatStorage m_vertex_texcoords_buf;
 
     DynamicBuffer<UInt32> m_faces_buf;
 
+    /* Compressed vertex and face data (see \ref compress_vertex_data()),
+       which replaces the corresponding buffers when present */
+    DynamicBuffer<UInt32> m_vertex_normals_oct_buf;
+    DynamicBuffer<UInt32> m_vertex_texcoords_q_buf;
+    DynamicBuffer<UInt32> m_faces_u16_buf;
+    InputPoint2f m_texcoord_offset = 0.f;
+    InputVector2f m_texcoord_scale = 0.f;
+
+    /// Time interval of the vertex motion (see \ref set_vertex_motion())
+    ScalarFloat m_motion_time_start = 0.f;
+    ScalarFloat m_motion_time_scale = 0.f;
+
     std::unordered_map<std::string, MeshAttribute> m_mesh_attributes;
 
+    /// Memory of the buffers (see \ref MemoryCategory::Geometry)
+    MemoryRecord m_memory { MemoryCategory::Geometry };
+
 #if defined(MTS_ENABLE_OPTIX)
     void* m_vertex_buffer_ptr;
 #endif
@@ -356,6 +655,10 @@ protected:
     /// Flag that can be set by the user to disable loading/computation of vertex normals
     bool m_disable_vertex_normals = false;
 
+    /// Should the plugin compress the vertex data after loading?
+    bool m_compress_vertex_data = false;
+    bool m_sort_spatially = false;
+
     /* Surface area distribution -- generated on demand when \ref
        prepare_area_pmf() is first called. */
     DiscreteDistribution<Float> m_area_pmf;
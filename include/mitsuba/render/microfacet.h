@@ -37,6 +37,87 @@ MTS_INLINE std::ostream &operator<<(std::ostream &os, MicrofacetType tp) {
     return os;
 }
 
+NAMESPACE_BEGIN(detail)
+
+/// Resolution (elevation, sample) of the table of \ref beckmann_visible_table()
+static constexpr uint32_t BeckmannTableResTheta = 128,
+                          BeckmannTableResU     = 256;
+
+/**
+ * \brief Invert the CDF of the first slope component of the Beckmann
+ * distribution of visible normals for the alpha=1 case
+ *
+ * The result is parameterized in the erf() domain, i.e., <tt>erfinv()</tt>
+ * of the return value is the slope.
+ */
+template <typename Value>
+Value beckmann_visible_erf(Value cos_theta_i, Value sample, size_t iterations = 3) {
+    constexpr auto InvSqrtPi = math::InvSqrtPi<scalar_t<Value>>;
+
+    Value tan_theta_i =
+        safe_sqrt(fnmadd(cos_theta_i, cos_theta_i, 1.f)) /
+        cos_theta_i;
+    Value cot_theta_i = rcp(tan_theta_i);
+
+    /* Search interval -- everything is parameterized
+       in the erf() domain */
+    Value maxval = erf(cot_theta_i);
+
+    /* Start with a good initial guess (analytic solution for
+       theta_i = pi/2, which is the most nonlinear case) */
+    Value x = maxval - (maxval + 1.f) * erf(sqrt(-log(sample)));
+
+    // Normalization factor for the CDF
+    sample *= 1.f + maxval + InvSqrtPi *
+              tan_theta_i * exp(-sqr(cot_theta_i));
+
+    // Newton iterations
+    ENOKI_NOUNROLL for (size_t i = 0; i < iterations; ++i) {
+        Value slope = erfinv(x),
+              value = 1.f + x + InvSqrtPi * tan_theta_i *
+                      exp(-sqr(slope)) - sample,
+              derivative = 1.f - slope * tan_theta_i;
+
+        x -= value / derivative;
+    }
+
+    return x;
+}
+
+/**
+ * \brief Return a table of \ref beckmann_visible_erf() that is used by the
+ * tabulated visible normal sampling routine
+ *
+ * The rows are uniformly spaced in the elevation angle of the incident
+ * direction, and the columns are spaced as <tt>(1 - cos(pi * t)) / 2</tt>
+ * in the sample, which places more entries in the tails of the
+ * distribution. The table is computed on first use.
+ */
+template <typename Scalar> const Scalar *beckmann_visible_table() {
+    static const std::unique_ptr<Scalar[]> table = []() {
+        std::unique_ptr<Scalar[]> data(
+            new Scalar[BeckmannTableResTheta * BeckmannTableResU]);
+
+        for (uint32_t i = 0; i < BeckmannTableResTheta; ++i) {
+            Scalar theta = i * (.5f * math::Pi<Scalar> / (BeckmannTableResTheta - 1)),
+                   cos_theta_i = std::max(std::cos(theta), Scalar(1e-4f));
+
+            for (uint32_t j = 0; j < BeckmannTableResU; ++j) {
+                Scalar u = .5f * (1.f - std::cos(j * (math::Pi<Scalar> /
+                                                      (BeckmannTableResU - 1))));
+                u = clamp(u, Scalar(1e-6f), Scalar(1.f - 1e-6f));
+                data[i * BeckmannTableResU + j] = beckmann_visible_erf(cos_theta_i, u, 8);
+            }
+        }
+
+        return data;
+    }();
+
+    return table.get();
+}
+
+NAMESPACE_END(detail)
+
 /**
  * \brief Implementation of the Beckman and GGX / Trowbridge-Reitz microfacet
  * distributions and various useful sampling routines
@@ -60,6 +141,15 @@ MTS_INLINE std::ostream &operator<<(std::ostream &os, MicrofacetType tp) {
  * An improvement of the GGX model sampling routine is discussed in
  *    "A Simpler and Exact Sampling Routine for the GGX Distribution of Visible Normals"
  *     by Eric Heitz
+ *
+ * With <tt>tabulated_sampling</tt> enabled, the numerical inversion of the
+ * Beckmann visible normal sampling routine is replaced by a lookup into a
+ * precomputed table (\ref detail::beckmann_visible_table()), which is
+ * shared by all roughness values since the routine operates on the
+ * stretched alpha=1 configuration. Sampled normals differ from the analytic
+ * ones by a relative error that is typically well below 0.1%, while the
+ * densities returned by \ref pdf() and \ref sample() remain exact. The
+ * table is unavailable in GPU variants, where this option has no effect.
  */
 template <typename Float, typename Spectrum>
 class MicrofacetDistribution {
@@ -77,9 +167,10 @@ public:
      * \param alpha
      *     The surface roughness
      */
-    MicrofacetDistribution(MicrofacetType type, Float alpha, bool sample_visible = true)
+    MicrofacetDistribution(MicrofacetType type, Float alpha, bool sample_visible = true,
+                           bool tabulated_sampling = false)
         : m_type(type), m_alpha_u(alpha), m_alpha_v(alpha),
-          m_sample_visible(sample_visible) {
+          m_sample_visible(sample_visible), m_tabulated_sampling(tabulated_sampling) {
         configure();
     }
 
@@ -94,9 +185,9 @@ public:
      *     The surface roughness in the bitangent direction
      */
     MicrofacetDistribution(MicrofacetType type, Float alpha_u, Float alpha_v,
-                           bool sample_visible = true)
+                           bool sample_visible = true, bool tabulated_sampling = false)
         : m_type(type), m_alpha_u(alpha_u), m_alpha_v(alpha_v),
-          m_sample_visible(sample_visible) {
+          m_sample_visible(sample_visible), m_tabulated_sampling(tabulated_sampling) {
         configure();
     }
 
@@ -143,6 +234,7 @@ public:
                 "Please use the corresponding smooth reflectance model to get zero roughness.");
 
         m_sample_visible = props.bool_("sample_visible", sample_visible);
+        m_tabulated_sampling = props.bool_("tabulated_sampling", false);
 
         configure();
     }
@@ -163,6 +255,9 @@ public:
     /// Return whether or not only visible normals are sampled?
     bool sample_visible() const { return m_sample_visible; }
 
+    /// Return whether visible normals are sampled using a precomputed table
+    bool tabulated_sampling() const { return m_tabulated_sampling; }
+
     /// Is this an isotropic microfacet distribution?
     bool is_isotropic() const { return m_alpha_u == m_alpha_v; }
 
@@ -361,33 +456,16 @@ public:
                discontinuities, which causes issues for QMC integration
                and techniques like Kelemen-style MLT. The following code
                performs a numerical inversion with better behavior */
-
-            Float tan_theta_i =
-                safe_sqrt(fnmadd(cos_theta_i, cos_theta_i, 1.f)) /
-                cos_theta_i;
-            Float cot_theta_i = rcp(tan_theta_i);
-
-            /* Search interval -- everything is parameterized
-               in the erf() domain */
-            Float maxval = erf(cot_theta_i);
-
-            /* Start with a good initial guess (analytic solution for
-               theta_i = pi/2, which is the most nonlinear case) */
             sample = max(min(sample, 1.f - 1e-6f), 1e-6f);
-            Float x = maxval - (maxval + 1.f) * erf(sqrt(-log(sample.x())));
-
-            // Normalization factor for the CDF
-            sample.x() *= 1.f + maxval + InvSqrtPi *
-                          tan_theta_i * exp(-sqr(cot_theta_i));
-
-            // Three Newton iterations
-            ENOKI_NOUNROLL for (size_t i = 0; i < 3; ++i) {
-                Float slope = erfinv(x),
-                      value = 1.f + x + InvSqrtPi * tan_theta_i *
-                              exp(-sqr(slope)) - sample.x(),
-                      derivative = 1.f - slope * tan_theta_i;
 
-                x -= value / derivative;
+            Float x;
+            if constexpr (!is_cuda_array_v<Float>) {
+                if (m_tabulated_sampling)
+                    x = lookup_beckmann_visible(cos_theta_i, sample.x());
+                else
+                    x = detail::beckmann_visible_erf(cos_theta_i, sample.x());
+            } else {
+                x = detail::beckmann_visible_erf(cos_theta_i, sample.x());
             }
 
             // Now convert back into a slope value
@@ -417,6 +495,30 @@ protected:
         m_alpha_v = max(m_alpha_v, 1e-4f);
     }
 
+    /// Bilinearly interpolate \ref detail::beckmann_visible_table()
+    Float lookup_beckmann_visible(Float cos_theta_i, Float sample) const {
+        using namespace detail;
+        const ScalarFloat *data = beckmann_visible_table<ScalarFloat>();
+
+        Float pt = safe_acos(cos_theta_i) * ((BeckmannTableResTheta - 1) * 2.f / Pi),
+              pu = safe_acos(fnmadd(2.f, sample, 1.f)) * ((BeckmannTableResU - 1) / Pi);
+
+        UInt32 it = min(UInt32(max(pt, 0.f)), BeckmannTableResTheta - 2),
+               iu = min(UInt32(max(pu, 0.f)), BeckmannTableResU - 2);
+
+        Float ft = pt - Float(it),
+              fu = pu - Float(iu);
+
+        UInt32 index = it * BeckmannTableResU + iu;
+
+        Float v00 = gather<Float>(data, index),
+              v01 = gather<Float>(data + 1, index),
+              v10 = gather<Float>(data + BeckmannTableResU, index),
+              v11 = gather<Float>(data + BeckmannTableResU + 1, index);
+
+        return lerp(lerp(v00, v01, fu), lerp(v10, v11, fu), ft);
+    }
+
     /// Compute the squared 1D roughness along direction \c v
     Float project_roughness_2(const Vector3f &v) const {
         if (is_isotropic())
@@ -432,6 +534,7 @@ protected:
     MicrofacetType m_type;
     Float m_alpha_u, m_alpha_v;
     bool  m_sample_visible;
+    bool  m_tabulated_sampling = false;
 };
 
 template <typename Float, typename Spectrum>
@@ -445,7 +548,8 @@ std::ostream &operator<<(std::ostream &os, const MicrofacetDistribution<Float, S
     os << "," << std::endl
        << "  alpha_u = " << md.alpha_u() << "," << std::endl
        << "  alpha_v = " << md.alpha_v() << "," << std::endl
-       << "  sample_visible = " << md.sample_visible() << std::endl
+       << "  sample_visible = " << md.sample_visible() << "," << std::endl
+       << "  tabulated_sampling = " << md.tabulated_sampling() << std::endl
        << "]";
     return os;
 }
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <mitsuba/mitsuba.h>
+
+/**
+ * Definition of the native \c .mtsmesh mesh cache format, which is written by
+ * \ref Mesh::write_mtsmesh() and loaded by the \c mtsmesh shape plugin.
+ *
+ * The file starts with a \ref detail::MeshCacheHeader, followed by the mesh
+ * name and the attribute table (one \ref detail::MeshCacheAttribute entry
+ * followed by the attribute name per attribute). The data arrays come last,
+ * and each of them starts at a multiple of \ref MTS_MESH_CACHE_ALIGNMENT
+ * bytes so that they can be accessed directly within a memory mapping. All
+ * values are stored in the byte order of the host that wrote the file.
+ */
+
+#define MTS_MESH_CACHE_MAGIC "MTSMESH"
+#define MTS_MESH_CACHE_VERSION 1
+
+/// Alignment of the data arrays within a mesh cache file
+#define MTS_MESH_CACHE_ALIGNMENT 64
+
+NAMESPACE_BEGIN(mitsuba)
+
+NAMESPACE_BEGIN(detail)
+/// Flags stored in the header of a mesh cache file
+enum class MeshCacheFlags : uint32_t {
+    HasNormals   = 0x01,
+    HasTexcoords = 0x02,
+    HasAreaPMF   = 0x04,
+    FaceNormals  = 0x08,
+
+    /// Color attributes hold spectral upsampling model coefficients
+    SpectralColors = 0x10
+};
+
+constexpr bool has_flag(uint32_t flags, MeshCacheFlags f) {
+    return (flags & (uint32_t) f) != 0;
+}
+
+/// Header of a mesh cache file
+struct MeshCacheHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t flags;
+    uint64_t vertex_count;
+    uint64_t face_count;
+    double bbox_min[3];
+    double bbox_max[3];
+    uint32_t name_length;
+    uint32_t attribute_count;
+    uint64_t positions_offset;
+    uint64_t normals_offset;
+    uint64_t texcoords_offset;
+    uint64_t faces_offset;
+
+    /* Area PMF of the faces (the state of a \ref DiscreteDistribution),
+       which is only present when \ref MeshCacheFlags::HasAreaPMF is set */
+    uint32_t pmf_scalar_size;
+    uint32_t pmf_valid[2];
+    double pmf_sum;
+    double pmf_normalization;
+    uint64_t pmf_offset;
+    uint64_t cdf_offset;
+};
+
+/// Entry of the attribute table of a mesh cache file
+struct MeshCacheAttribute {
+    uint32_t name_length;
+    uint32_t face_attribute;
+    uint32_t size;
+    uint32_t padding;
+    uint64_t offset;
+};
+
+inline uint64_t mesh_cache_align(uint64_t offset) {
+    return (offset + MTS_MESH_CACHE_ALIGNMENT - 1) / MTS_MESH_CACHE_ALIGNMENT *
+           MTS_MESH_CACHE_ALIGNMENT;
+}
+NAMESPACE_END(detail)
+
+NAMESPACE_END(mitsuba)
@@ -59,10 +59,27 @@ struct OptixParams {
     bool *out_hit;
     /// Handle for the acceleration data structure to trace against
     OptixTraversableHandle handle;
+    /**
+     * Input `active` mask and ray data pointers of the shadow rays, laid out
+     * like the regular inputs (appended to keep the offsets of the members
+     * above stable)
+     */
+    bool    *in_shadow_mask;
+    float   *in_shadow_o[3],
+            *in_shadow_d[3],
+            *in_shadow_mint, *in_shadow_maxt;
+    /**
+     * Launch index of the first shadow ray. A coalesced launch traces the
+     * regular rays first, followed by the shadow rays, while a plain
+     * \c ray_test launch only traces shadow rays and sets this to 0.
+     */
+    unsigned int shadow_offset;
 
 #ifdef __CUDACC__
-    /// Return whether the current kernel is tracing test rays
-    __device__ bool is_ray_test() { return out_hit; }
+    /// Return whether the ray of the given launch index is a shadow ray
+    __device__ bool is_ray_test(unsigned int launch_index) {
+        return out_hit && launch_index >= shadow_offset;
+    }
     /// Return whether the current kernel is tracing preliminary rays
     __device__ bool is_ray_intersect_preliminary() { return out_prim_uv[0]; }
 
@@ -92,6 +109,13 @@ extern "C" {
 
 using namespace optix;
 
+/// Write the result of a shadow ray to the data pointer stored in the OptixParams
+__device__ void write_output_hit_params(OptixParams &params,
+                                        unsigned int launch_index,
+                                        bool hit) {
+    params.out_hit[launch_index - params.shadow_offset] = hit;
+}
+
 /// Write PreliminaryIntersection fields to the data pointers stored in the OptixParams
 __device__ void write_output_pi_params(OptixParams &params,
                                        unsigned int launch_index,
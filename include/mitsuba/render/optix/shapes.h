@@ -10,6 +10,7 @@
 #include "sphere.cuh"
 #else
 
+#include <mitsuba/core/memory.h>
 #include <mitsuba/render/optix/common.h>
 #include <mitsuba/render/optix_api.h>
 #include <mitsuba/render/shape.h>
@@ -33,31 +34,52 @@ size_t get_shape_descr_idx(Shape *shape) {
           "'custom_optix_shapes' table.", name);
 }
 
-/// Stores two OptiXTraversables: one for the meshes and one for the custom shapes (e.g. sphere)
+/**
+ * \brief Stores three OptiXTraversables: one for the meshes, one for the
+ * meshes that are refitted on changes (see \ref Shape::accel_refit()), and
+ * one for the custom shapes (e.g. sphere)
+ */
 struct OptixAccelData {
     struct HandleData {
         OptixTraversableHandle handle = 0ull;
         void* buffer = nullptr;
         uint32_t count = 0u;
+        /// Size of \c buffer, needed to update the GAS in place
+        size_t size = 0;
+        /// Primitive count of every build input, which must match on updates
+        std::vector<uint32_t> prim_counts;
     };
     HandleData meshes;
+    HandleData meshes_refit;
     HandleData others;
 
+    /// Compact the GAS after their build? (\c optixAccelCompact)
+    bool compact = true;
+
     ~OptixAccelData() {
-        if (meshes.buffer) cuda_free(meshes.buffer);
-        if (others.buffer) cuda_free(others.buffer);
+        if (meshes.buffer) DeviceMemoryPool::free(meshes.buffer);
+        if (meshes_refit.buffer) DeviceMemoryPool::free(meshes_refit.buffer);
+        if (others.buffer) DeviceMemoryPool::free(others.buffer);
     }
 };
 
+/// Index of the GAS of \ref OptixAccelData containing a given shape (meshes, refitted meshes, others)
+template <typename Shape>
+size_t optix_gas_index(const Shape *shape) {
+    if (!shape->is_mesh())
+        return 2;
+    return shape->accel_refit() ? 1 : 0;
+}
+
 /// Creates and appends the HitGroupSbtRecord for a given list of shapes
 template <typename Shape>
 void fill_hitgroup_records(std::vector<ref<Shape>> &shapes,
                            std::vector<HitGroupSbtRecord> &out_hitgroup_records,
                            const OptixProgramGroup *program_groups) {
-    for (size_t i = 0; i < 2; i++) {
+    for (size_t i = 0; i < 3; i++) {
         for (Shape* shape: shapes) {
-            // This trick allows meshes to be processed first
-            if (i == !shape->is_mesh())
+            // Records are ordered like the build inputs of the GAS in OptixAccelData
+            if (i == optix_gas_index(shape))
                 shape->optix_fill_hitgroup_records(out_hitgroup_records, program_groups);
         }
     }
@@ -66,35 +88,104 @@ void fill_hitgroup_records(std::vector<ref<Shape>> &shapes,
 /**
  * \brief Build OptiX geometry acceleration structures (GAS) for a given list of shapes.
  *
- * Two different GAS will be created for the meshes and the custom shapes. Optix
- * handles to those GAS will be stored in an \ref OptixAccelData.
+ * Three different GAS will be created for the meshes, the refitted meshes and
+ * the custom shapes. Optix handles to those GAS will be stored in an \ref
+ * OptixAccelData.
+ *
+ * When \c refit is set, only the shapes of the refitted GAS changed: it is
+ * updated in place (\c OPTIX_BUILD_OPERATION_UPDATE) unless the primitive
+ * counts changed, and the two other GAS are kept.
+ *
+ * The GAS are compacted after their build unless \ref OptixAccelData::compact
+ * is disabled, which speeds up the build at the cost of device memory.
  */
 template <typename Shape>
 void build_gas(const OptixDeviceContext &context,
                const std::vector<ref<Shape>> &shapes,
-               OptixAccelData& out_accel) {
+               OptixAccelData& out_accel,
+               bool refit = false) {
 
-    // Separate meshes and custom shapes
-    std::vector<ref<Shape>> shape_meshes, shape_others;
+    // Separate meshes, refitted meshes and custom shapes
+    std::vector<ref<Shape>> shape_meshes, shape_meshes_refit, shape_others;
     for (auto shape: shapes) {
-        if (shape->is_mesh())           shape_meshes.push_back(shape);
-        else if (!shape->is_instance()) shape_others.push_back(shape);
+        if (shape->is_instance())
+            continue;
+        switch (optix_gas_index(shape.get())) {
+            case 0:  shape_meshes.push_back(shape); break;
+            case 1:  shape_meshes_refit.push_back(shape); break;
+            default: shape_others.push_back(shape); break;
+        }
     }
 
+    // Update a GAS built with OPTIX_BUILD_FLAG_ALLOW_UPDATE, returns false when a rebuild is needed
+    auto update_single_gas = [&context, compact = out_accel.compact](
+                                 const std::vector<ref<Shape>> &shape_subset,
+                                 OptixAccelData::HandleData &handle) {
+        size_t shapes_count = shape_subset.size();
+        if (!handle.buffer || shapes_count != handle.prim_counts.size())
+            return false;
+        for (size_t i = 0; i < shapes_count; i++) {
+            if (shape_subset[i]->primitive_count() != handle.prim_counts[i])
+                return false;
+        }
+
+        OptixAccelBuildOptions accel_options = {};
+        accel_options.buildFlags = (compact ? OPTIX_BUILD_FLAG_ALLOW_COMPACTION : OPTIX_BUILD_FLAG_NONE) |
+                                   OPTIX_BUILD_FLAG_ALLOW_UPDATE;
+        accel_options.operation  = OPTIX_BUILD_OPERATION_UPDATE;
+        accel_options.motionOptions.numKeys = 0;
+
+        std::vector<OptixBuildInput> build_inputs(shapes_count);
+        for (size_t i = 0; i < shapes_count; i++)
+            shape_subset[i]->optix_build_input(build_inputs[i]);
+
+        OptixAccelBufferSizes buffer_sizes;
+        rt_check(optixAccelComputeMemoryUsage(
+            context,
+            &accel_options,
+            build_inputs.data(),
+            (unsigned int) shapes_count,
+            &buffer_sizes
+        ));
+
+        void* d_temp_buffer = DeviceMemoryPool::malloc(buffer_sizes.tempUpdateSizeInBytes);
+        rt_check(optixAccelBuild(
+            context,
+            0,              // CUDA stream
+            &accel_options,
+            build_inputs.data(),
+            (unsigned int) shapes_count, // num build inputs
+            (CUdeviceptr)d_temp_buffer,
+            buffer_sizes.tempUpdateSizeInBytes,
+            (CUdeviceptr)handle.buffer,
+            handle.size,
+            &handle.handle,
+            0,              // emitted property list
+            0               // num emitted properties
+        ));
+        DeviceMemoryPool::free(d_temp_buffer);
+        return true;
+    };
 
     // Build a GAS given a subset of shape pointers
-    auto build_single_gas = [&context](const std::vector<ref<Shape>> &shape_subset,
-                                       OptixAccelData::HandleData &handle) {
+    auto build_single_gas = [&context, compact = out_accel.compact](
+                                const std::vector<ref<Shape>> &shape_subset,
+                                OptixAccelData::HandleData &handle,
+                                bool allow_update) {
 
         OptixAccelBuildOptions accel_options = {};
-        accel_options.buildFlags = OPTIX_BUILD_FLAG_ALLOW_COMPACTION;
+        accel_options.buildFlags = compact ? OPTIX_BUILD_FLAG_ALLOW_COMPACTION : OPTIX_BUILD_FLAG_NONE;
+        if (allow_update)
+            accel_options.buildFlags |= OPTIX_BUILD_FLAG_ALLOW_UPDATE;
         accel_options.operation  = OPTIX_BUILD_OPERATION_BUILD;
         accel_options.motionOptions.numKeys = 0;
         if (handle.buffer) {
-            cuda_free(handle.buffer);
+            DeviceMemoryPool::free(handle.buffer);
             handle.handle = 0ull;
             handle.buffer = nullptr;
             handle.count = 0;
+            handle.size = 0;
+            handle.prim_counts.clear();
         }
 
         size_t shapes_count = shape_subset.size();
@@ -115,8 +206,8 @@ void build_gas(const OptixDeviceContext &context,
             &buffer_sizes
         ));
 
-        void* d_temp_buffer = cuda_malloc(buffer_sizes.tempSizeInBytes);
-        void* output_buffer = cuda_malloc(buffer_sizes.outputSizeInBytes + 8);
+        void* d_temp_buffer = DeviceMemoryPool::malloc(buffer_sizes.tempSizeInBytes);
+        void* output_buffer = DeviceMemoryPool::malloc(buffer_sizes.outputSizeInBytes + 8);
 
         OptixAccelEmitDesc emit_property = {};
         emit_property.type   = OPTIX_PROPERTY_TYPE_COMPACTED_SIZE;
@@ -134,16 +225,18 @@ void build_gas(const OptixDeviceContext &context,
             (CUdeviceptr)output_buffer,
             buffer_sizes.outputSizeInBytes,
             &accel,
-            &emit_property,  // emitted property list
-            1                // num emitted properties
+            compact ? &emit_property : nullptr, // emitted property list
+            compact ? 1u : 0u                   // num emitted properties
         ));
 
-        cuda_free(d_temp_buffer);
+        DeviceMemoryPool::free(d_temp_buffer);
 
-        size_t compact_size;
-        cuda_memcpy_from_device(&compact_size, (void*)emit_property.result, sizeof(size_t));
+        size_t compact_size = buffer_sizes.outputSizeInBytes;
+        if (compact)
+            cuda_memcpy_from_device(&compact_size, (void*)emit_property.result, sizeof(size_t));
+        handle.size = buffer_sizes.outputSizeInBytes;
         if (compact_size < buffer_sizes.outputSizeInBytes) {
-            void* compact_buffer = cuda_malloc(compact_size);
+            void* compact_buffer = DeviceMemoryPool::malloc(compact_size);
             // Use handle as input and output
             rt_check(optixAccelCompact(
                 context,
@@ -153,17 +246,26 @@ void build_gas(const OptixDeviceContext &context,
                 compact_size,
                 &accel
             ));
-            cuda_free(output_buffer);
+            DeviceMemoryPool::free(output_buffer);
             output_buffer = compact_buffer;
+            handle.size = compact_size;
         }
 
         handle.handle = accel;
         handle.buffer = output_buffer;
         handle.count = (uint32_t) shapes_count;
+        for (size_t i = 0; i < shapes_count; i++)
+            handle.prim_counts.push_back(shape_subset[i]->primitive_count());
     };
 
-    build_single_gas(shape_meshes, out_accel.meshes);
-    build_single_gas(shape_others, out_accel.others);
+    if (refit && update_single_gas(shape_meshes_refit, out_accel.meshes_refit))
+        return;
+
+    if (!refit) {
+        build_single_gas(shape_meshes, out_accel.meshes, false);
+        build_single_gas(shape_others, out_accel.others, false);
+    }
+    build_single_gas(shape_meshes_refit, out_accel.meshes_refit, true);
 }
 
 /// Prepares and fills the \ref OptixInstance array associated with a given list of shapes.
@@ -212,6 +314,17 @@ void prepare_ias(const OptixDeviceContext &context,
         sbt_offset += (unsigned int) accel.meshes.count;
     }
 
+    // Create an OptixInstance for the refitted meshes if necessary
+    if (accel.meshes_refit.handle) {
+        OptixInstance meshes_instance = {
+            { T[0], T[1], T[2], T[3], T[4], T[5], T[6], T[7], T[8], T[9], T[10], T[11] },
+            instance_id, sbt_offset, /* visibilityMask = */ 255,
+            flags, accel.meshes_refit.handle, /* pads = */ { 0, 0 }
+        };
+        out_instances.push_back(meshes_instance);
+        sbt_offset += (unsigned int) accel.meshes_refit.count;
+    }
+
     // Create an OptixInstance for the custom shapes if necessary
     if (accel.others.handle) {
         OptixInstance others_instance = {
@@ -31,6 +31,7 @@
 # define OPTIX_COMPILE_DEBUG_LEVEL_LINEINFO 1
 # define OPTIX_COMPILE_DEBUG_LEVEL_FULL 2
 # define OPTIX_BUILD_FLAG_NONE 0
+# define OPTIX_BUILD_FLAG_ALLOW_UPDATE 1u
 # define OPTIX_BUILD_FLAG_ALLOW_COMPACTION 2u
 # define OPTIX_BUILD_FLAG_PREFER_FAST_TRACE 4u
 # define OPTIX_BUILD_FLAG_PREFER_FAST_BUILD 8u
@@ -228,6 +229,10 @@ extern MTS_EXPORT_RENDER const char* (*optixGetErrorName)(OptixResult);
 extern MTS_EXPORT_RENDER const char* (*optixGetErrorString)(OptixResult);
 extern MTS_EXPORT_RENDER OptixResult (*optixDeviceContextCreate)(CUcontext, const OptixDeviceContextOptions*, OptixDeviceContext*);
 extern MTS_EXPORT_RENDER OptixResult (*optixDeviceContextDestroy)(OptixDeviceContext);
+extern MTS_EXPORT_RENDER OptixResult (*optixDeviceContextSetCacheEnabled)(OptixDeviceContext, int);
+extern MTS_EXPORT_RENDER OptixResult (*optixDeviceContextSetCacheLocation)(OptixDeviceContext, const char*);
+extern MTS_EXPORT_RENDER OptixResult (*optixDeviceContextSetCacheDatabaseSizes)(OptixDeviceContext, size_t, size_t);
+extern MTS_EXPORT_RENDER OptixResult (*optixDeviceContextGetCacheEnabled)(OptixDeviceContext, int*);
 extern MTS_EXPORT_RENDER OptixResult (*optixModuleCreateFromPTX)(OptixDeviceContext, const OptixModuleCompileOptions*, const OptixPipelineCompileOptions*, const char*, size_t, char*, size_t*, OptixModule*);
 extern MTS_EXPORT_RENDER OptixResult (*optixModuleDestroy)(OptixModule);
 extern MTS_EXPORT_RENDER OptixResult (*optixProgramGroupCreate)(OptixDeviceContext, const OptixProgramGroupDesc*, unsigned int, const OptixProgramGroupOptions*, char*, size_t*, OptixProgramGroup*);
@@ -248,6 +253,42 @@ NAMESPACE_BEGIN(mitsuba)
 extern MTS_EXPORT_RENDER bool optix_initialize();
 extern MTS_EXPORT_RENDER void optix_shutdown();
 
+/**
+ * \brief Configure the disk cache of the compiled modules of an OptiX context
+ *
+ * OptiX caches the modules that it compiles from PTX on disk, keyed by the
+ * PTX, the compile options and the driver version, so that later processes
+ * skip the compilation. Unless the \c OPTIX_CACHE_PATH and \c
+ * OPTIX_CACHE_MAXSIZE environment variables specify otherwise, the cache is
+ * stored in the cache directory of the user (\c $XDG_CACHE_HOME/mitsuba/optix,
+ * \c ~/.cache/mitsuba/optix, or \c %LOCALAPPDATA%\\mitsuba\\optix on
+ * Windows) and may grow to 1 GiB. Setting \c OPTIX_CACHE_MAXSIZE to zero
+ * disables it.
+ *
+ * Must be called before the first module is created in the context.
+ */
+extern MTS_EXPORT_RENDER void optix_configure_cache(OptixDeviceContext context);
+
+/**
+ * \brief Configure the disk cache of the CUDA kernels compiled by the JIT
+ * compiler of Enoki
+ *
+ * The kernels that Enoki generates are compiled from PTX by the CUDA driver,
+ * which caches the result on disk keyed by the PTX, the GPU architecture and
+ * the driver version, so that identical kernels of later processes skip the
+ * compilation. The default location of this cache is often a temporary or
+ * per-container directory, and its default size (256 MiB) is quickly
+ * exhausted by optimizations. Unless the \c CUDA_CACHE_PATH and \c
+ * CUDA_CACHE_MAXSIZE environment variables specify otherwise, the cache is
+ * stored next to the one of OptiX (\c $XDG_CACHE_HOME/mitsuba/cuda, \c
+ * ~/.cache/mitsuba/cuda, or \c %LOCALAPPDATA%\\mitsuba\\cuda on Windows)
+ * and may grow to 1 GiB. Setting \c CUDA_CACHE_DISABLE to 1 disables it.
+ *
+ * The driver reads these variables when it is initialized, hence this
+ * function must be called before the first CUDA operation of the process.
+ */
+extern MTS_EXPORT_RENDER void cuda_configure_cache();
+
 static size_t optix_log_buffer_size;
 static char optix_log_buffer[2024];
 
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <mitsuba/core/object.h>
+#include <mitsuba/core/vector.h>
+#include <mitsuba/render/fwd.h>
+#include <vector>
+
+NAMESPACE_BEGIN(mitsuba)
+
+/**
+ * \brief Photon map for density estimation with a fixed lookup radius
+ *
+ * The photons are stored in a flat array, sorted by the bucket of a spatial
+ * hash grid whose cells are twice as large as the lookup radius. A lookup
+ * hence visits the photons of at most eight cells, which are contiguous in
+ * memory. The photon map is built in parallel by a counting sort that keeps
+ * the original order of the photons within each bucket, which makes the
+ * lookups deterministic.
+ *
+ * Photons are scalar and store their power as a color, hence the photon map
+ * is only supported by the RGB and monochromatic variants.
+ */
+template <typename Float, typename Spectrum>
+class MTS_EXPORT_RENDER PhotonMap : public Object {
+public:
+    MTS_IMPORT_TYPES()
+
+    struct Photon {
+        ScalarPoint3f p;
+        /// Direction towards the previous vertex of the photon path
+        ScalarVector3f d;
+        ScalarColor3f power;
+    };
+
+    /// Create an empty photon map
+    PhotonMap();
+
+    /// Replace the photons of the map and sort them for lookups within \c radius
+    void build(std::vector<Photon> &&photons, ScalarFloat radius);
+
+    /// Return the number of stored photons
+    size_t photon_count() const { return m_photons.size(); }
+
+    /// Return the lookup radius
+    ScalarFloat radius() const { return m_radius; }
+
+    /// Return the photon with index \c index
+    const Photon &photon(uint32_t index) const { return m_photons[index]; }
+
+    /// Append the indices of the photons within the lookup radius of \c p to \c result
+    void query(const ScalarPoint3f &p, std::vector<uint32_t> &result) const;
+
+    std::string to_string() const override;
+
+    MTS_DECLARE_CLASS()
+protected:
+    virtual ~PhotonMap();
+
+    /// Bucket of the grid cell with integer coordinates \c cell
+    uint32_t bucket(const Vector<int32_t, 3> &cell) const;
+
+private:
+    std::vector<Photon> m_photons;
+    /// Index of the first photon of each bucket (and the photon count at the end)
+    std::vector<uint32_t> m_bucket_start;
+    uint32_t m_bucket_mask = 0;
+    ScalarFloat m_radius = 0.f, m_inv_cell_size = 0.f;
+};
+
+MTS_EXTERN_CLASS_RENDER(PhotonMap)
+NAMESPACE_END(mitsuba)
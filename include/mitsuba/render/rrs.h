@@ -0,0 +1,163 @@
+#pragma once
+
+#include <mitsuba/core/atomic.h>
+#include <mitsuba/core/bbox.h>
+#include <mitsuba/core/object.h>
+#include <mitsuba/core/vector.h>
+#include <mitsuba/render/fwd.h>
+#include <memory>
+
+NAMESPACE_BEGIN(mitsuba)
+
+/**
+ * \brief Spatial cache of the statistics that drive efficiency-aware Russian
+ * roulette and splitting
+ *
+ * Following Rath et al. ("EARS: Efficiency-Aware Russian Roulette and
+ * Splitting"), a path that reaches a vertex \c x with weight \c T continues
+ * with the expected number of copies
+ *
+ * <tt>q = T * sqrt(E[L(x)^2] / Var[I] * C / C(x))</tt>,
+ *
+ * where \c E[L(x)^2] is the second moment of the radiance gathered by the
+ * remainder of the path, \c C(x) its cost, \c Var[I] the variance of a
+ * sample of a pixel and \c C its cost. Factors below one terminate paths by
+ * Russian roulette, and larger ones split them.
+ *
+ * The statistics of the remaining paths are learned in the cells of a
+ * regular grid over the bounds of the scene. Renderings are split into
+ * passes (see \ref SamplingIntegrator::prepare_pass()): the first
+ * <tt>rrs_learning_passes</tt> passes use the regular throughput-based
+ * Russian roulette and record their paths into the cache, while later
+ * passes use the learned factors. The variance and cost of the pixels are
+ * image-wide averages, as the integrators do not know the pixel of a
+ * sample. The cost of a path is its number of scattering vertices.
+ *
+ * The cache is only supported by the CPU variants.
+ */
+template <typename Float, typename Spectrum>
+class MTS_EXPORT_RENDER RRSCache : public Object {
+public:
+    MTS_IMPORT_TYPES()
+
+    /// Longest prefix of a path that is recorded into the cache
+    static constexpr uint32_t MaxVertices = 32;
+
+    /// Largest number of pending split paths per camera ray (further vertices are not split)
+    static constexpr size_t MaxBranches = 64;
+
+    /// Path vertex that is recorded during the learning passes
+    struct Vertex {
+        Point3f p;
+        /// Path weight after the vertex
+        Float weight;
+        /// Radiance gathered and length of the path when the vertex was reached
+        Float radiance;
+        UInt32 length;
+        Mask active;
+    };
+
+    /**
+     * \brief Create a cache from the \c rrs_* parameters of an integrator
+     *
+     * \c rrs_learning_passes (default: 4) is the number of learning passes,
+     * \c rrs_resolution (default: 16) the number of cells of the grid along
+     * each axis, and \c rrs_min_survival (default: 0.05) and \c
+     * rrs_max_split (default: 8) clamp the factors.
+     */
+    RRSCache(const Properties &props);
+
+    /// Called by the integrator before each pass (see \ref SamplingIntegrator::prepare_pass())
+    void prepare_pass(const Scene *scene, size_t pass);
+
+    /// Called by the integrator after each pass, updates the learned factors
+    void finish_pass(size_t pass);
+
+    /// Should the integrators record their paths during the current pass?
+    bool learning() const { return m_learning; }
+
+    /// Should the integrators use the learned factors during the current pass?
+    bool ready() const { return m_ready; }
+
+    /**
+     * \brief Return the expected number of copies of paths that reach the
+     * points \c p with the (luminance) weights \c weight
+     *
+     * The second entry marks the lanes whose cell has learned enough samples,
+     * the other ones should fall back to the regular Russian roulette.
+     */
+    std::pair<Float, Mask> factor(const Point3f &p, const Float &weight, Mask active) const;
+
+    /**
+     * \brief Russian roulette and splitting of the paths that reach the
+     * points \c p with the (luminance) weights \c weight
+     *
+     * \param rr_prob
+     *     Survival probability of the regular Russian roulette, which is used
+     *     by the lanes without learned factor (see \ref factor())
+     * \param sample
+     *     Uniformly distributed sample in <tt>[0, 1)</tt>
+     * \param allow_split
+     *     Can paths be split into several copies? (\c false e.g. once \ref
+     *     MaxBranches copies are pending)
+     *
+     * \return The number of copies of each path (zero for terminated paths),
+     * and the factor that divides their weights.
+     */
+    std::pair<UInt32, Float> split(const Point3f &p, const Float &weight, const Float &rr_prob,
+                                   const Float &sample, bool allow_split, Mask active) const;
+
+    /**
+     * \brief Record the paths of a packet of camera rays
+     *
+     * \param vertices
+     *     Vertices of the paths (see \ref Vertex)
+     * \param radiance
+     *     Total (luminance) radiance gathered by the paths
+     * \param length
+     *     Total number of scattering vertices of the paths
+     */
+    void record(const Vertex *vertices, uint32_t count, const Float &radiance,
+                const UInt32 &length, Mask active) const;
+
+    std::string to_string() const override;
+
+    MTS_DECLARE_CLASS()
+protected:
+    virtual ~RRSCache();
+
+    /// Index of the grid cell containing \c p
+    uint32_t cell_index(const ScalarPoint3f &p) const;
+
+private:
+    /// Statistics of the paths that left the vertices of a cell during the learning passes
+    struct Cell {
+        AtomicFloat<double> radiance2, cost;
+        std::atomic<uint32_t> count { 0 };
+    };
+
+    /// Cells with fewer recorded vertices fall back to the regular Russian roulette
+    static constexpr uint32_t MinCellSamples = 16;
+
+    size_t m_learning_passes;
+    uint32_t m_resolution;
+    ScalarFloat m_min_survival, m_max_split;
+
+    bool m_learning = false, m_ready = false;
+
+    ScalarBoundingBox3f m_bbox;
+    std::unique_ptr<Cell[]> m_cells;
+
+    /// Statistics of the camera rays (sum of the radiance, its square, and of the cost)
+    mutable AtomicFloat<double> m_pixel_radiance, m_pixel_radiance2, m_pixel_cost;
+    mutable std::atomic<uint32_t> m_pixel_count { 0 };
+
+    /// Learned factor <tt>sqrt(E[L(x)^2] / C(x))</tt> per cell (negative without data)
+    std::vector<ScalarFloat> m_cell_factor;
+
+    /// Learned factor <tt>sqrt(C / Var[I])</tt> of the pixels
+    ScalarFloat m_pixel_factor = 0.f;
+};
+
+MTS_EXTERN_CLASS_RENDER(RRSCache)
+NAMESPACE_END(mitsuba)
@@ -71,6 +71,17 @@ public:
      */
     virtual void seed(uint64_t seed_offset, size_t wavefront_size = 1);
 
+    /**
+     * \brief Seed the sampler for a chunk of a larger wavefront
+     *
+     * The \c wavefront_size lanes of the sampler then produce the same
+     * samples as the lanes <tt>[offset, offset + wavefront_size)</tt> after
+     * a call to <tt>seed(seed_offset, n)</tt> with a larger \c n. This is
+     * used to split up wavefronts that would not fit into memory. The
+     * \c offset must be a multiple of the number of samples per wavefront.
+     */
+    void seed_chunk(uint64_t seed_offset, size_t offset, size_t wavefront_size);
+
     /**
      * \brief Advance to the next sample.
      *
@@ -85,6 +96,28 @@ public:
     /// Retrieve the next two component values from the current sample
     virtual Point2f next_2d(Mask active = true);
 
+    /**
+     * \brief Retrieve the next \c count component values from the current
+     * sample and write them into \c values
+     *
+     * The result is equivalent to <tt>count / 2</tt> consecutive calls to
+     * \ref next_2d(), followed by a call to \ref next_1d() when \c count is
+     * odd. Implementations can override this function to generate all
+     * values at once, which avoids one virtual call per dimension.
+     */
+    virtual void next_nd(Float *values, size_t count, Mask active = true);
+
+    /**
+     * \brief Inform the sampler about the pixel of the current sample
+     *
+     * The rendering algorithm calls this function after \ref seed() and
+     * before generating the samples of a pixel (or of a packet of pixels).
+     * Samplers that distribute their error in screen space use it to
+     * correlate the samples of neighboring pixels; the default
+     * implementation ignores it.
+     */
+    virtual void set_pixel(const Point2u &pixel);
+
     /// Return the number of samples per pixel
     uint32_t sample_count() const { return m_sample_count; }
 
@@ -104,6 +137,15 @@ protected:
 
     /// Generates a array of seeds where the seed values are unique per sequence
     UInt32 compute_per_sequence_seed(uint32_t seed_offset) const;
+
+    /**
+     * \brief Variant of \ref compute_per_sequence_seed() for a given offset
+     * of the lanes within the full wavefront (see \ref seed_chunk())
+     *
+     * This is used by samplers that recompute the seeds on the fly instead
+     * of storing them when the sampler is seeded.
+     */
+    UInt32 compute_per_sequence_seed(uint32_t seed_offset, uint32_t wavefront_offset) const;
     /// Return the index of the current sample
     UInt32 current_sample_index() const;
 
@@ -116,6 +158,8 @@ protected:
     uint32_t m_samples_per_wavefront;
     /// Size of the wavefront (or 0, if not seeded)
     uint32_t m_wavefront_size;
+    /// Index of the first lane within the full wavefront (see \ref seed_chunk())
+    uint32_t m_wavefront_offset;
     /// Index of the current dimension in the sample
     uint32_t m_dimension_index;
     /// Index of the current sample in the sequence
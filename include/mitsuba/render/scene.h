@@ -1,6 +1,9 @@
 #pragma once
 
+#include <mitsuba/core/distr_1d.h>
+#include <mitsuba/core/profiler.h>
 #include <mitsuba/core/spectrum.h>
+#include <mitsuba/core/tls.h>
 #include <mitsuba/render/emitter.h>
 #include <mitsuba/render/shapegroup.h>
 #include <mitsuba/render/fwd.h>
@@ -12,7 +15,7 @@ template <typename Float, typename Spectrum>
 class MTS_EXPORT_RENDER Scene : public Object {
 public:
     MTS_IMPORT_TYPES(BSDF, Emitter, EmitterPtr, Film, Sampler, Shape, ShapePtr,
-                     ShapeGroup, Sensor, Integrator, Medium, MediumPtr)
+                     ShapeGroup, Sensor, Integrator, Medium, MediumPtr, Mesh)
 
     /// Instantiate a scene from a \ref Properties object
     Scene(const Properties &props);
@@ -68,10 +71,71 @@ public:
      *    extent information, as well as a time value (which matterns
      *    when the shapes are in motion)
      *
+     * With the \c occluder_cache scene property (native CPU backend), each
+     * thread first tests the primitive that occluded its previous shadow
+     * ray, which often resolves coherent shadow rays without a traversal.
+     * The hit rate is reported by the profiler.
+     *
      * \return \c true if an intersection was found
      */
     Mask ray_test(const Ray3f &ray, Mask active = true) const;
 
+    /**
+     * \brief Intersect a ray and test a shadow ray against the scene at once
+     *
+     * This is equivalent to calling \ref ray_intersect() and \ref
+     * ray_test(), but the GPU variants trace both sets of rays with a single
+     * OptiX launch, which halves the number of launches of integrators that
+     * trace the continuation ray and the shadow ray of each bounce. The two
+     * rays may have a different number of lanes.
+     *
+     * \return
+     *    The surface interaction of \c ray and whether \c shadow_ray is
+     *    occluded
+     */
+    std::pair<SurfaceInteraction3f, Mask>
+    ray_intersect_and_test(const Ray3f &ray, const Ray3f &shadow_ray,
+                           Mask active = true, Mask shadow_active = true,
+                           HitComputeFlags flags = HitComputeFlags::All) const;
+
+    /// Dynamic array types used by the batched ray tracing interface
+    using DynamicRay3f = make_dynamic_t<Ray3f>;
+    using DynamicPreliminaryIntersection3f = make_dynamic_t<PreliminaryIntersection3f>;
+
+    /**
+     * \brief Intersect a large buffer of rays against the scene
+     *
+     * Unlike \ref ray_intersect_preliminary(), which traces the rays of a
+     * packet as they come, this function may reorder the rays (see \ref
+     * sort_rays()) so that each packet dispatched to the acceleration data
+     * structure contains rays with similar origins and directions. The
+     * intersections are returned in the original order of \c rays.
+     *
+     * \param rays
+     *    Buffer of rays (stored as dynamic arrays)
+     *
+     * \param sort
+     *    Should the rays be sorted before being packed into packets?
+     *
+     * \remark Only supported by CPU packet and GPU variants. The GPU
+     * variants trace all rays at once and ignore \c sort, as does Embree,
+     * which receives the whole buffer through its stream interface and
+     * forms packets by itself.
+     */
+    DynamicPreliminaryIntersection3f ray_intersect_batch(const DynamicRay3f &rays,
+                                                         bool sort = true) const;
+
+    /**
+     * \brief Sort ray indices to improve the coherence of packet traversal
+     *
+     * Each ray is assigned a key consisting of the octant of its direction
+     * followed by the Morton code of its origin on a 512^3 grid over the
+     * scene's bounding box. The \c count entries of \c indices (which
+     * refer to entries of \c rays) are then sorted by this key, so that
+     * consecutive rays tend to share the kd-tree traversal order.
+     */
+    void sort_rays(const DynamicRay3f &rays, uint32_t *indices, size_t count) const;
+
     //! @}
     // =============================================================
 
@@ -79,6 +143,37 @@ public:
     //! @{ \name Sampling interface
     // =============================================================
 
+    /**
+     * \brief Sample a ray leaving one of the emitters of the scene
+     *
+     * The emitter is chosen proportionally to its power when the \c
+     * emitter_sampler scene property is set to \c "power", and uniformly at
+     * random otherwise (a \ref LightBVH requires a reference point). The
+     * first sample selects the emitter and is then reused by \ref
+     * Endpoint::sample_ray().
+     *
+     * \param time
+     *    The scene time associated with the ray
+     *
+     * \param sample1
+     *    A uniformly distributed 1D value that selects the emitter and the
+     *    wavelengths
+     *
+     * \param sample2
+     *    A uniformly distributed 2D value (e.g. the position on the emitter)
+     *
+     * \param sample3
+     *    A uniformly distributed 2D value (e.g. the direction of the ray)
+     *
+     * \return
+     *    The sampled ray and the emitted radiance along it divided by the
+     *    sample probability, including the discrete probability of the emitter.
+     */
+    std::pair<Ray3f, Spectrum> sample_emitter_ray(Float time, Float sample1,
+                                                  const Point2f &sample2,
+                                                  const Point2f &sample3,
+                                                  Mask active = true) const;
+
     /**
      * \brief Direct illumination sampling routine
      *
@@ -89,6 +184,14 @@ public:
      * emission profile and the geometry term between the reference point and
      * the position on the emitter.
      *
+     * By default, the emitter is chosen uniformly at random. When the \c
+     * emitter_sampler scene property is set to \c "power", it is chosen
+     * proportionally to its power (see \ref Emitter::power()). When it is
+     * set to \c "bvh", it is instead chosen using a \ref LightBVH, i.e.
+     * proportionally to a conservative estimate of its contribution to the
+     * reference point, which is much more efficient in scenes with many
+     * emitters.
+     *
      * \param ref
      *    A reference point somewhere within the scene
      *
@@ -109,6 +212,48 @@ public:
                              bool test_visibility = true,
                              Mask active = true) const;
 
+    /**
+     * \brief Batched variant of \ref sample_emitter_direction(), which
+     * draws \c count emitter samples for the same reference point
+     *
+     * All samples are drawn before the first shadow ray is traced, and the
+     * shadow rays are then traced back to back, which keeps the acceleration
+     * data structure and the occluder cache (see \ref ray_test()) warm.
+     * Shadow rays are skipped for samples that carry no radiance.
+     *
+     * \param samples
+     *    \c count uniformly distributed 2D vectors
+     *
+     * \param ds
+     *    Receives the \c count direction samples
+     *
+     * \param spec
+     *    Receives the \c count radiance values divided by the sample
+     *    probability (see \ref sample_emitter_direction())
+     */
+    void sample_emitter_directions(const Interaction3f &ref,
+                                   const Point2f *samples,
+                                   size_t count,
+                                   DirectionSample3f *ds,
+                                   Spectrum *spec,
+                                   bool test_visibility = true,
+                                   Mask active = true) const;
+
+    /**
+     * \brief Trace the shadow rays of emitter samples drawn by \ref
+     * sample_emitter_directions() without visibility test
+     *
+     * The entries of \c values whose shadow ray is occluded are set to zero.
+     * Entries that are already zero are not traced, hence integrators can
+     * first multiply \c values by the BSDF and skip the shadow rays of
+     * samples that do not contribute.
+     */
+    void ray_test_emitter_directions(const Interaction3f &ref,
+                                     const DirectionSample3f *ds,
+                                     size_t count,
+                                     Spectrum *values,
+                                     Mask active = true) const;
+
     /**
      * \brief Evaluate the probability density of the  \ref
      * sample_emitter_direct() technique given an filled-in \ref
@@ -137,6 +282,12 @@ public:
     /// Return a bounding box surrounding the scene
     const ScalarBoundingBox3f &bbox() const { return m_bbox; }
 
+    /**
+     * \brief Return the name of the ray intersection acceleration data
+     * structure ("kdtree", "bvh", "embree" or "optix")
+     */
+    std::string accel_name() const;
+
     /// Return the list of sensors
     std::vector<ref<Sensor>> &sensors() { return m_sensors; }
     /// Return the list of sensors (const version)
@@ -172,6 +323,17 @@ public:
     /// Return whether any of the shape's parameters require gradient
     bool shapes_grad_enabled() const { return m_shapes_grad_enabled; };
 
+    /**
+     * \brief Does the scene contain BSDFs that change the polarization state
+     * of light?
+     *
+     * Always \c false in unpolarized variants. When no such BSDF is present,
+     * all Mueller matrices arising during rendering are depolarizers, and the
+     * integrators only need to track their first entry (see
+     * \ref BSDFFlags::Polarizing).
+     */
+    bool has_polarizing_bsdfs() const { return m_polarizing; }
+
     /// Return a human-readable string representation of the scene contents.
     virtual std::string to_string() const override;
 
@@ -180,12 +342,55 @@ protected:
     /// Virtual destructor
     virtual ~Scene();
 
+    /**
+     * \brief Replace meshes that only differ by their placement with
+     * instances of shared shape groups
+     *
+     * Meshes with identical face indices, texture coordinates, attributes,
+     * BSDF and matching vertex positions (see \ref Mesh::is_placed_copy_of())
+     * are grouped. Each group with more than one member becomes a single
+     * shape group holding the first mesh, plus one instance per mesh. Meshes
+     * with emitters, sensors or media are left untouched. Enabled by the
+     * \c dedup_geometry scene parameter.
+     */
+    void deduplicate_geometry();
+
     /// Create the ray-intersection acceleration data structure
     void accel_init_cpu(const Properties &props);
     void accel_init_gpu(const Properties &props);
 
-    /// Updates the ray-intersection acceleration data structure
-    void accel_parameters_changed_gpu();
+    /**
+     * \brief Build the kd-trees of the shape groups concurrently (native CPU
+     * backend only)
+     *
+     * Called before the top-level acceleration data structure is built. The
+     * groups are processed from the largest to the smallest one, and the
+     * threads that run out of groups help with the parallel parts of the
+     * remaining builds.
+     */
+    void accel_build_shapegroups();
+
+    /**
+     * \brief Updates the ray-intersection acceleration data structure
+     *
+     * \c changed_shapes lists the indices of the modified entries of \ref
+     * m_shapes. On the CPU, Embree only re-creates their geometries, while
+     * the kd-tree rebuilds the top level of the scene. The kd-trees of
+     * unmodified shape groups are reused in both cases.
+     *
+     * Meshes that set \ref Shape::accel_refit() are refitted instead: Embree
+     * refits their geometries in place, OptiX updates their geometry
+     * acceleration structure, and the native backend refits its hierarchy
+     * when all modified shapes are refittable meshes and \c accel is \c bvh
+     * (the split planes of the kd-tree cannot be refitted). An empty list
+     * rebuilds everything on the GPU, while a list of instances only
+     * rebuilds the instance acceleration structures.
+     */
+    void accel_parameters_changed_cpu(const std::vector<uint32_t> &changed_shapes);
+    void accel_parameters_changed_gpu(const std::vector<uint32_t> &changed_shapes = {});
+
+    /// Are all the given shapes meshes that requested refitting? (see \ref Shape::accel_refit())
+    bool accel_refit_only(const std::vector<uint32_t> &changed_shapes) const;
 
     /// Release the ray-intersection acceleration data structure
     void accel_release_cpu();
@@ -197,19 +402,70 @@ protected:
 
     /// Trace a ray
     MTS_INLINE SurfaceInteraction3f ray_intersect_cpu(const Ray3f &ray, HitComputeFlags flags, Mask active) const;
-    MTS_INLINE SurfaceInteraction3f ray_intersect_gpu(const Ray3f &ray, HitComputeFlags flags, Mask active) const;
+    MTS_INLINE SurfaceInteraction3f ray_intersect_gpu(const Ray3f &ray, HitComputeFlags flags, Mask active,
+                                                      const Ray3f *shadow_ray = nullptr,
+                                                      Mask shadow_active = false,
+                                                      Mask *shadow_hit = nullptr) const;
     MTS_INLINE SurfaceInteraction3f ray_intersect_naive_cpu(const Ray3f &ray, Mask active) const;
 
     /// Trace a shadow ray
     MTS_INLINE Mask ray_test_cpu(const Ray3f &ray, Mask active) const;
     MTS_INLINE Mask ray_test_gpu(const Ray3f &ray, Mask active) const;
 
+#if defined(MTS_ENABLE_EMBREE)
+    /// Trace a buffer of rays using the stream interface of Embree (CPU packet variants)
+    DynamicPreliminaryIntersection3f ray_intersect_batch_cpu(const DynamicRay3f &rays) const;
+#endif
+
     using ShapeKDTree = mitsuba::ShapeKDTree<Float, Spectrum>;
+    using ShapeBVH = mitsuba::ShapeBVH<Float, Spectrum>;
+    using LightBVH = mitsuba::LightBVH<Float, Spectrum>;
 
 protected:
+    /**
+     * \brief Build \ref m_emitter_distr from the power of the emitters
+     *
+     * Only the power of the emitters \c changed is queried again, while an
+     * empty list queries all emitters.
+     */
+    void build_emitter_distr(const std::vector<uint32_t> &changed = {});
+
     /// Acceleration data structure (type depends on implementation)
     void *m_accel = nullptr;
 
+    /// Is \ref m_accel a \ref ShapeBVH rather than a \ref ShapeKDTree? (native CPU backend)
+    bool m_accel_bvh = false;
+
+    /**
+     * \brief Top-level BVH over the world bounds of the instances (native CPU
+     * backend with a kd-tree, \c nullptr if the scene has no instances)
+     *
+     * Instances overlap heavily, which produces poor kd-trees with lots of
+     * duplicated references. They are therefore kept out of \ref m_accel,
+     * and their shape groups share the bottom-level kd-trees.
+     */
+    ShapeBVH *m_instance_accel = nullptr;
+
+    /// Primitive that occluded the previous shadow ray of a thread (see \ref ray_test())
+    struct OccluderCache {
+        const Shape *shape = nullptr;
+        uint32_t prim_index = 0;
+
+        /* Statistics, reported to the profiler in batches */
+        uint32_t queries = 0, hits = 0;
+
+        ~OccluderCache() { flush(); }
+
+        void flush() {
+            profiler_count(ProfilerCounter::OccluderCacheQueries, queries);
+            profiler_count(ProfilerCounter::OccluderCacheHits, hits);
+            queries = hits = 0;
+        }
+    };
+
+    /// Per-thread occluder caches (native CPU backend, \c nullptr if disabled)
+    ThreadLocal<OccluderCache> *m_occluder_cache = nullptr;
+
     ScalarBoundingBox3f m_bbox;
 
     host_vector<ref<Emitter>, Float> m_emitters;
@@ -220,7 +476,16 @@ protected:
     ref<Integrator> m_integrator;
     ref<Emitter> m_environment;
 
+    /// Hierarchy used to sample the emitters (\c nullptr when they are sampled uniformly)
+    ref<LightBVH> m_light_bvh;
+
+    /// Distribution of the power of the emitters (empty unless \c emitter_sampler is \c "power")
+    DiscreteDistribution<Float> m_emitter_distr;
+    /// Power of each emitter, from which \ref m_emitter_distr is built
+    std::vector<ScalarFloat> m_emitter_power;
+
     bool m_shapes_grad_enabled;
+    bool m_polarizing;
 };
 
 /// Dummy function which can be called to ensure that the librender shared library is loaded
@@ -233,7 +498,7 @@ void DirectionSample<Float, Spectrum>::set_query(const Ray3f &ray, const Surface
     n      = si.sh_frame.n;
     uv     = si.uv;
     time   = si.time;
-    object = static_cast<ObjectPtr>(si.shape->emitter());
+    object = static_cast<ObjectPtr>(si.emitter(nullptr));
     d      = ray.d;
     dist   = si.t;
 }
@@ -242,13 +507,22 @@ void DirectionSample<Float, Spectrum>::set_query(const Ray3f &ray, const Surface
 template <typename Float, typename Spectrum>
 typename SurfaceInteraction<Float, Spectrum>::EmitterPtr
 SurfaceInteraction<Float, Spectrum>::emitter(const Scene *scene, Mask active) const {
+    /* The emitters of shapes within a shape group are shared by all instances,
+       which are emitters of their own (see the 'instance' plugin) */
     if constexpr (!is_array_v<ShapePtr>) {
-        if (is_valid())
-            return shape->emitter(active);
+        if (!is_valid())
+            return scene ? scene->environment() : nullptr;
+        else if (instance && shape->is_emitter())
+            return instance->emitter(active);
         else
-            return scene->environment();
+            return shape->emitter(active);
     } else {
-        return select(is_valid(), shape->emitter(active), scene->environment());
+        EmitterPtr emitter = shape->emitter(active);
+        Mask instanced = active && neq(instance, nullptr) && neq(emitter, nullptr);
+        if (any(instanced))
+            masked(emitter, instanced) = instance->emitter(instanced);
+        return select(is_valid(), emitter,
+                      scene ? scene->environment() : (const Emitter *) nullptr);
     }
 }
 
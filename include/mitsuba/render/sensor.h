@@ -16,7 +16,7 @@ template <typename Float, typename Spectrum>
 class MTS_EXPORT_RENDER Sensor : public Endpoint<Float, Spectrum> {
 public:
     MTS_IMPORT_TYPES(Film, Sampler)
-    MTS_IMPORT_BASE(Endpoint, sample_ray, m_needs_sample_3)
+    MTS_IMPORT_BASE(Endpoint, sample_ray, m_needs_sample_3, m_world_transform)
 
     // =============================================================
     //! @{ \name Sensor-specific sampling functions
@@ -110,13 +110,21 @@ public:
     // =============================================================
 
     void traverse(TraversalCallback *callback) override {
+        /* Expose a snapshot of the world transform at the shutter opening
+           time. Writing it replaces any animation by a static transform. */
+        m_to_world = m_world_transform->eval(m_shutter_open);
+
+        callback->put_parameter("to_world", m_to_world);
         callback->put_parameter("shutter_open", m_shutter_open);
         callback->put_parameter("shutter_open_time", m_shutter_open_time);
         callback->put_object("film", m_film.get());
         callback->put_object("sampler", m_sampler.get());
     }
 
-    void parameters_changed(const std::vector<std::string> &/*keys*/ = {}) override {
+    void parameters_changed(const std::vector<std::string> &keys = {}) override {
+        if (string::contains(keys, "to_world"))
+            m_world_transform = new AnimatedTransform(
+                AnimatedTransform::Transform4f(AnimatedTransform::Matrix4f(m_to_world.matrix)));
         m_resolution = ScalarVector2f(m_film->crop_size());
     }
 
@@ -132,6 +140,8 @@ protected:
     ScalarVector2f m_resolution;
     ScalarFloat m_shutter_open;
     ScalarFloat m_shutter_open_time;
+    /// Writable copy of the world transform exposed by \ref traverse()
+    ScalarTransform4f m_to_world;
 };
 
 
@@ -12,6 +12,29 @@
 
 NAMESPACE_BEGIN(mitsuba)
 
+/**
+ * \brief Analytic shapes that the kd-tree can intersect in batches (see \ref
+ * Shape::analytic_parameters())
+ *
+ * The comments specify the layout of the parameters of each kind, where
+ * transforms are given by the first three rows of their matrix.
+ */
+enum class AnalyticShape : uint32_t {
+    /// Not supported (intersected individually)
+    None,
+    /// Center and radius
+    Sphere,
+    /// World-to-object transform (unit disk in the XY plane)
+    Disk,
+    /// World-to-object transform (square <tt>[-1, 1]^2</tt> in the XY plane)
+    Rectangle,
+    /// Rigid world-to-object transform, radius, and length along Z
+    Cylinder
+};
+
+/// Maximum number of parameters of an \ref AnalyticShape
+static constexpr size_t AnalyticParameterCount = 14;
+
 /**
  * \brief Base class of all geometric shapes in Mitsuba
  *
@@ -155,6 +178,47 @@ public:
      */
     virtual Mask ray_test(const Ray3f &ray, Mask active = true) const;
 
+    /**
+     * \brief Intersect a single primitive of the shape (see \ref
+     * primitive_count())
+     *
+     * This is used by the kd-tree and the BVH to test the primitives of
+     * shapes made of several ones (e.g. the segments of a curve) separately.
+     * The returned record must have its \c prim_index set to \c index.
+     *
+     * \remark
+     *     The default implementation ignores \c index and calls \ref
+     *     ray_intersect_preliminary()
+     */
+    virtual PreliminaryIntersection3f ray_intersect_primitive(ScalarIndex index,
+                                                              const Ray3f &ray,
+                                                              Mask active = true) const;
+
+    /**
+     * \brief Shadow ray test of a single primitive of the shape (see \ref
+     * ray_intersect_primitive())
+     *
+     * \remark
+     *     The default implementation ignores \c index and calls \ref ray_test()
+     */
+    virtual Mask ray_test_primitive(ScalarIndex index, const Ray3f &ray,
+                                    Mask active = true) const;
+
+    /**
+     * \brief Describe the shape to the batched intersection routines of the
+     * kd-tree
+     *
+     * Analytic shapes write the parameters of their intersection test to
+     * \c params (see \ref AnalyticShape for the layout) and return their
+     * kind. This lets kd-tree leaves containing many shapes of the same kind
+     * intersect several of them at once (see the \c kd_shape_batches
+     * property of \ref ShapeKDTree).
+     *
+     * \remark
+     *     The default implementation returns \ref AnalyticShape::None
+     */
+    virtual AnalyticShape analytic_parameters(ScalarFloat params[AnalyticParameterCount]) const;
+
     /**
      * \brief Compute and return detailed information related to a surface interaction
      *
@@ -230,6 +294,32 @@ public:
     virtual ScalarBoundingBox3f bbox(ScalarIndex index,
                                      const ScalarBoundingBox3f &clip) const;
 
+    /// Does the shape move while the shutter is open? (see \ref bbox_motion())
+    virtual bool has_motion() const;
+
+    /**
+     * \brief Return the time interval <tt>[start, end]</tt> during which the
+     * shape moves. The shape is at rest before and after this interval.
+     *
+     * \remark
+     *     The default implementation returns an empty interval at time zero
+     */
+    virtual ScalarVector2f motion_time_range() const;
+
+    /**
+     * \brief Return axis aligned boxes that bound a single shape primitive at
+     * times \c time_start and \c time_end, such that their linear
+     * interpolation bounds the primitive at any time in between.
+     *
+     * This is used by \ref ShapeBVH to interpolate the bounds of its nodes
+     * along the time of a ray.
+     *
+     * \remark
+     *     The default implementation returns \ref bbox(ScalarIndex) twice
+     */
+    virtual std::pair<ScalarBoundingBox3f, ScalarBoundingBox3f>
+    bbox_motion(ScalarIndex index, ScalarFloat time_start, ScalarFloat time_end) const;
+
     /**
      * \brief Return the shape's surface area.
      *
@@ -240,6 +330,16 @@ public:
      */
     virtual ScalarFloat surface_area() const;
 
+    /**
+     * \brief Return a cone that bounds the normals of the shape
+     *
+     * The cone is returned as its (normalized) axis and the cosine of its
+     * half-angle. It is used to bound the emission of area emitters when
+     * importance sampling many of them (see \ref LightBVH). The default
+     * implementation returns the whole sphere of directions.
+     */
+    virtual std::pair<ScalarVector3f, ScalarFloat> normal_cone() const;
+
     /**
      * \brief Evaluate a specific shape attribute at the given surface interaction.
      *
@@ -337,6 +437,39 @@ public:
     /// Is this shape an instance?
     bool is_instance() const { return class_()->name() == "Instance"; };
 
+    /**
+     * \brief Should the acceleration data structure be refitted rather than
+     * rebuilt when this shape changes?
+     *
+     * Refitting only updates the bounding boxes of the existing hierarchy,
+     * which is much faster for small deformations (e.g. in inverse rendering
+     * loops), but the hierarchy quality degrades when the geometry moves
+     * significantly. Only meshes are refitted.
+     */
+    bool accel_refit() const { return m_accel_refit; }
+
+    /**
+     * \brief Was the geometry of this shape modified since the last call to
+     * \ref clear_dirty()?
+     *
+     * This flag is set by \ref parameters_changed() when the modified keys
+     * affect the geometry, and tells \ref Scene::parameters_changed() that
+     * the bounding box and the acceleration data structure must be updated.
+     * Changes to the BSDF or to the textures of a shape leave it unset.
+     */
+    bool geometry_dirty() const { return m_geometry_dirty; }
+
+    /**
+     * \brief Was the emitter of this shape (or the geometry of an area
+     * emitter) modified since the last call to \ref clear_dirty()?
+     *
+     * The scene then rebuilds the distributions used to sample emitters.
+     */
+    bool emitter_dirty() const { return m_emitter_dirty; }
+
+    /// Reset the flags of \ref geometry_dirty() and \ref emitter_dirty()
+    void clear_dirty() { m_geometry_dirty = m_emitter_dirty = false; }
+
     /// Does the surface of this shape mark a medium transition?
     bool is_medium_transition() const { return m_interior_medium.get() != nullptr ||
                                                m_exterior_medium.get() != nullptr; }
@@ -478,7 +611,7 @@ public:
 #endif
 
     void traverse(TraversalCallback *callback) override;
-    void parameters_changed(const std::vector<std::string> &/*keys*/ = {}) override;
+    void parameters_changed(const std::vector<std::string> &keys = {}) override;
 
     /// Return whether shape's parameters require gradients (default implementation return false)
     virtual bool parameters_grad_enabled() const;
@@ -498,6 +631,18 @@ protected:
     /// Explicitly register this shape as the parent of the provided sub-objects (emitters, etc.)
     void set_children();
     std::string get_children_string() const;
+
+    /**
+     * \brief Fit linearly interpolated bounds (see \ref bbox_motion()) to
+     * boxes sampled at increasing times
+     *
+     * Both boxes of the result are enlarged until their interpolation
+     * contains every sample at its time. This is exact for primitives that
+     * move linearly between consecutive samples.
+     */
+    static std::pair<ScalarBoundingBox3f, ScalarBoundingBox3f>
+    fit_linear_bounds(const std::vector<ScalarFloat> &times,
+                      const std::vector<ScalarBoundingBox3f> &boxes);
 protected:
     ref<BSDF> m_bsdf;
     ref<Emitter> m_emitter;
@@ -509,6 +654,13 @@ protected:
     ScalarTransform4f m_to_world;
     ScalarTransform4f m_to_object;
 
+    /// Refit the acceleration data structure on changes? (see \ref accel_refit())
+    bool m_accel_refit = false;
+
+    /// Derived data of the scene invalidated by changes (see \ref geometry_dirty())
+    bool m_geometry_dirty = false;
+    bool m_emitter_dirty = false;
+
 #if defined(MTS_ENABLE_OPTIX)
     /// OptiX hitgroup data buffer
     void* m_optix_data_ptr = nullptr;
@@ -524,6 +676,7 @@ NAMESPACE_END(mitsuba)
 
 ENOKI_CALL_SUPPORT_TEMPLATE_BEGIN(mitsuba::Shape)
     ENOKI_CALL_SUPPORT_METHOD(compute_surface_interaction)
+    ENOKI_CALL_SUPPORT_METHOD(sample_position)
     ENOKI_CALL_SUPPORT_METHOD(eval_attribute)
     ENOKI_CALL_SUPPORT_METHOD(eval_attribute_1)
     ENOKI_CALL_SUPPORT_METHOD(eval_attribute_3)
@@ -1,6 +1,9 @@
 #include <mitsuba/core/fwd.h>
 #include <mitsuba/render/fwd.h>
 #include <mitsuba/render/kdtree.h>
+#include <mitsuba/core/distr_1d.h>
+#include <atomic>
+#include <mutex>
 
 #if defined(MTS_ENABLE_EMBREE)
     #include <embree3/rtcore.h>
@@ -15,7 +18,7 @@ template <typename Float, typename Spectrum>
 class MTS_EXPORT_RENDER ShapeGroup : public Shape<Float, Spectrum> {
 public:
     MTS_IMPORT_BASE(Shape, m_id)
-    MTS_IMPORT_TYPES(ShapeKDTree)
+    MTS_IMPORT_TYPES(ShapeKDTree, Mesh)
 
     using typename Base::ScalarSize;
 
@@ -44,6 +47,54 @@ public:
 
     MTS_INLINE ScalarSize effective_primitive_count() const override { return 0; }
 
+    /// Does the group contain shapes with an attached area emitter?
+    bool has_emitters() const { return !m_emitter_shapes.empty(); }
+
+    /// Does the group contain shapes whose BSDF alters the polarization of light?
+    bool has_polarizing_bsdfs() const { return m_polarizing; }
+
+    /**
+     * \brief Sample a point on the emissive shapes of the group (in object space)
+     *
+     * A shape is chosen proportionally to its surface area, and the point is
+     * then sampled by the shape itself (e.g. using the area distribution of a
+     * mesh), which is assumed to be uniform. The density is thus constant and
+     * equal to the inverse of \ref emitter_area(). The function also returns
+     * the chosen shape, whose emitter provides the emitted radiance.
+     */
+    std::pair<PositionSample3f, ShapePtr>
+    sample_emitter_position(Float time, const Point2f &sample, Mask active = true) const;
+
+    /// Return the summed surface area of the emissive shapes (in object space)
+    ScalarFloat emitter_area() const { return m_emitter_area; }
+
+    /// Return the summed power of the emitters of the group (in object space)
+    ScalarFloat emitter_power() const;
+
+    void traverse(TraversalCallback *callback) override;
+
+#if !defined(MTS_ENABLE_EMBREE)
+    /**
+     * \brief Build the kd-tree of the group unless this already happened
+     *
+     * The constructor only registers the shapes, so that the scene can build
+     * the trees of all of its groups concurrently before its own acceleration
+     * data structure. Ray queries build a missing tree on demand. This
+     * function is safe to call from several threads.
+     */
+    void accel_build();
+#endif
+
+    /**
+     * \brief Rebuild the group's acceleration data structure if one of its
+     * shapes changed
+     *
+     * Instances referencing the group are unaffected apart from their
+     * bounding boxes, which the scene refreshes in its own
+     * \ref Scene::parameters_changed().
+     */
+    void parameters_changed(const std::vector<std::string> &keys = {}) override;
+
     std::string to_string() const override;
 
 #if defined(MTS_ENABLE_OPTIX)
@@ -55,9 +106,15 @@ public:
     void optix_fill_hitgroup_records(std::vector<HitGroupSbtRecord> &hitgroup_records,
                                      const OptixProgramGroup *program_groups) override;
 
-    /// Build OptiX geometry acceleration structures
-    void optix_build_gas(const OptixDeviceContext& context) {
+    /**
+     * \brief Build OptiX geometry acceleration structures
+     *
+     * They are kept across scene updates, until one of the group's shapes
+     * changes (see \ref parameters_changed()).
+     */
+    void optix_build_gas(const OptixDeviceContext& context, bool compact = true) {
         if (!optix_accel_ready) {
+            m_accel.compact = compact;
             build_gas(context, m_shapes, m_accel);
             optix_accel_ready = true;
         }
@@ -65,17 +122,31 @@ public:
 #endif
 
     MTS_DECLARE_CLASS()
+private:
+    /// Rebuild the distribution used by \ref sample_emitter_position()
+    void build_emitter_distr();
+
 private:
     ScalarBoundingBox3f m_bbox;
 
+    /// Shapes of the group with an area emitter, shared by all instances
+    std::vector<ref<Base>> m_emitter_shapes;
+    DiscreteDistribution<Float> m_emitter_distr;
+    ScalarFloat m_emitter_area = 0.f;
+
+    bool m_polarizing = false;
+
 #if defined(MTS_ENABLE_EMBREE) || defined(MTS_ENABLE_OPTIX)
     std::vector<ref<Base>> m_shapes;
 #endif
 
 #if defined(MTS_ENABLE_EMBREE)
     RTCScene m_embree_scene = nullptr;
+    RTCDevice m_embree_device = nullptr;
 #else
     ref<ShapeKDTree> m_kdtree;
+    std::mutex m_kdtree_mutex;
+    std::atomic<bool> m_kdtree_ready { false };
 #endif
 
 #if defined(MTS_ENABLE_OPTIX)
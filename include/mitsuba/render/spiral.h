@@ -27,12 +27,20 @@ public:
     using Float = float;
     MTS_IMPORT_CORE_TYPES()
 
-    /// Create a new spiral generator for the given size, offset into a larger frame, and block size
-    Spiral(Vector2i size, Vector2i offset, size_t block_size, size_t passes = 1);
+    /**
+     * \brief Create a new spiral generator for the given size, offset into a
+     * larger frame, and block size
+     *
+     * When \c scanline is set, the blocks are generated row by row from the
+     * top of the image instead of along a spiral, which is required by films
+     * that write their output while rendering (see \ref Film::streaming()).
+     */
+    Spiral(Vector2i size, Vector2i offset, size_t block_size, size_t passes = 1,
+           bool scanline = false);
 
     template <typename Film>
-    Spiral(const Film &film, size_t block_size, size_t passes = 1)
-        : Spiral(film->crop_size(), film->crop_offset(), block_size, passes) {}
+    Spiral(const Film &film, size_t block_size, size_t passes = 1, bool scanline = false)
+        : Spiral(film->crop_size(), film->crop_offset(), block_size, passes, scanline) {}
 
     /// Return the maximum block size
     size_t max_block_size() const { return m_block_size; }
@@ -40,6 +48,9 @@ public:
     /// Return the total number of blocks
     size_t block_count() { return m_block_count; }
 
+    /// Are the blocks generated in scanline order rather than along a spiral?
+    bool scanline() const { return m_scanline; }
+
     /// Reset the spiral to its initial state. Does not affect the number of passes.
     void reset();
 
@@ -49,6 +60,7 @@ public:
      */
     void set_passes(size_t passes) {
         m_remaining_passes = passes;
+        m_passes = passes;
     }
 
     /**
@@ -58,6 +70,19 @@ public:
      */
     std::tuple<Vector2i, Vector2i, size_t> next_block();
 
+    /**
+     * \brief Return the offset, size and unique identifer of the block with
+     * the given index in the traversal order (spanning all passes).
+     *
+     * The sequence of blocks matches the one produced by repeated calls to
+     * \ref next_block(). In contrast to the latter, this function does not
+     * modify the spiral and can therefore be called concurrently from many
+     * threads without any locking (e.g. by incrementing an atomic counter).
+     *
+     * A size of zero indicates that the index is past the end of the traversal.
+     */
+    std::tuple<Vector2i, Vector2i, size_t> block(size_t index) const;
+
     MTS_DECLARE_CLASS()
 protected:
     enum class Direction {
@@ -84,6 +109,15 @@ protected:
     /// Number of times the spiral should automatically restart.
     size_t m_remaining_passes;
 
+    /// Total number of passes (used by \ref block()).
+    size_t m_passes;
+
+    /// Offset and size of each block of a single pass, in traversal order.
+    std::vector<std::pair<Vector2i, Vector2i>> m_block_list;
+
+    /// Generate the blocks row by row instead of along a spiral.
+    bool m_scanline;
+
     /// Protects the spiral's state (thread safety).
     tbb::spin_mutex m_mutex;
 };
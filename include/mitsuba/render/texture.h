@@ -8,6 +8,16 @@
 
 NAMESPACE_BEGIN(mitsuba)
 
+/// Texture plugins whose evaluation can be inlined (see \ref dispatch_texture())
+enum class TextureType : uint32_t {
+    /// Any other texture, which is evaluated through a virtual function call
+    Generic,
+    /// \ref UniformSpectrum
+    Uniform,
+    /// \ref SRGBReflectanceSpectrum
+    SRGB
+};
+
 /**
  * \brief Base class of all surface texture implementations
  *
@@ -188,6 +198,18 @@ public:
     /// Does this texture evaluation depend on the UV coordinates
     virtual bool is_spatially_varying() const { return false; }
 
+    /**
+     * \brief Does this texture filter its lookups using the UV partials
+     * (\c duv_dx and \c duv_dy) of the surface interaction?
+     *
+     * BSDFs using such a texture set \ref BSDFFlags::NeedsDifferentials so
+     * that the partials are computed from the ray differentials.
+     */
+    virtual bool needs_differentials() const { return false; }
+
+    /// Which plugin implements this texture? (see \ref dispatch_texture())
+    TextureType texture_type() const { return m_texture_type; }
+
     /// Convenience method returning the standard D65 illuminant.
     static ref<Texture> D65(ScalarFloat scale = 1.f);
 
@@ -202,6 +224,7 @@ protected:
 
 protected:
     std::string m_id;
+    TextureType m_texture_type = TextureType::Generic;
 };
 
 
@@ -234,9 +257,48 @@ public:
     /// Returns the maximum value of the texture over all dimensions.
     virtual ScalarFloat max() const;
 
+    /**
+     * \brief Returns the maximum value of the texture within each cell of a
+     * regular grid of resolution \c cells that covers the volume
+     *
+     * The values are conservative bounds of what \ref eval() returns within
+     * the cells (including the effect of interpolation), and are stored in
+     * row-major order (\c x varies fastest). The default implementation
+     * returns \ref max() for every cell.
+     */
+    virtual std::vector<ScalarFloat> max_per_cell(const ScalarVector3i &cells) const;
+
+    /**
+     * \brief Returns the minimum value of the texture within each cell of a
+     * regular grid of resolution \c cells that covers the volume
+     *
+     * This is the counterpart of \ref max_per_cell(). The default
+     * implementation returns zero for every cell, which is a conservative
+     * bound for non-negative volumes such as densities.
+     */
+    virtual std::vector<ScalarFloat> min_per_cell(const ScalarVector3i &cells) const;
+
+    /**
+     * \brief Returns the maximum value of the texture within each cell of a
+     * regular grid of resolution \c cells and within each of \c bands
+     * spectral bands
+     *
+     * The bands are the color channels in RGB variants (which requires three
+     * bands), equal intervals of <tt>[MTS_WAVELENGTH_MIN,
+     * MTS_WAVELENGTH_MAX]</tt> in spectral variants, and a single band in
+     * monochromatic variants. The bands of a cell are stored contiguously,
+     * and the cells are ordered as in \ref max_per_cell(). The default
+     * implementation returns \ref max_per_cell() for every band.
+     */
+    virtual std::vector<ScalarFloat> max_per_cell_and_band(const ScalarVector3i &cells,
+                                                           uint32_t bands) const;
+
     /// Returns the bounding box of the 3d texture
     ScalarBoundingBox3f bbox() const { return m_bbox; }
 
+    /// Returns the transformation from world space to the unit cube of the texture
+    const ScalarTransform4f &world_to_local() const { return m_world_to_local; }
+
     /**
      * \brief Returns the resolution of the volume, assuming that it is based
      * on a discrete representation.
@@ -22,6 +22,16 @@ public:
             InterpolationMode mag_interpolation_mode = InterpolationMode::Bilinear,
             WrapMode wrap_mode                       = WrapMode::ClampToEdge);
 
+    /**
+     * \brief Update the rectangular region of the texture covered by \c
+     * bitmap, starting at the pixel \c offset
+     *
+     * The bitmap is converted to the format of the texture if needed. This
+     * is used to upload the tiles returned by \ref Film::snapshot() during
+     * progressive rendering.
+     */
+    void upload_region(const Bitmap *bitmap, const Vector<int, 2> &offset);
+
 protected:
     virtual ~GPUTexture();
 };
@@ -0,0 +1,160 @@
+"""
+Ray tracing throughput benchmark across variants and backends
+
+This script runs the 'bench_rays' executable (built with 'ninja bench_rays')
+on a set of reference scenes for several variants, and collects the results
+into a CSV file. The ray sets are generated once and stored in a directory,
+so that all variants (and different builds, e.g. with and without Embree)
+trace exactly the same rays. When a baseline CSV file from an earlier run is
+given, configurations whose throughput dropped by more than the specified
+tolerance are reported, and the script exits with an error code.
+
+Example:
+
+    python resources/bench_rays.py --rays rays -o results.csv \\
+        --variants scalar_rgb packet_rgb gpu_rgb -- scene1.xml scene2.xml
+"""
+
+import argparse
+import csv
+import io
+import os
+import shutil
+import subprocess
+import sys
+
+
+def find_executable(path):
+    if path is not None:
+        return path
+    found = shutil.which('bench_rays')
+    if found is None:
+        for candidate in ['build/dist/bench_rays', 'build/bench_rays',
+                          'dist/bench_rays']:
+            if os.path.exists(candidate):
+                return candidate
+        raise Exception('Could not find the "bench_rays" executable, '
+                        'please specify it using --executable!')
+    return found
+
+
+def default_variants():
+    try:
+        import mitsuba
+        return [v for v in mitsuba.variants()
+                if v.endswith('_rgb') and 'autodiff' not in v]
+    except ImportError:
+        return ['scalar_rgb']
+
+
+def run_variant(executable, variant, scenes, args):
+    cmd = [executable, '--csv', '-m', variant, '-r', str(args.repeat),
+           '-s', str(args.spp)]
+    if args.rays is not None:
+        cmd += ['-d', args.rays]
+    if args.threads is not None:
+        cmd += ['-t', str(args.threads)]
+    cmd += scenes
+
+    print('Running %s ..' % ' '.join(cmd), file=sys.stderr)
+    result = subprocess.run(cmd, stdout=subprocess.PIPE,
+                            universal_newlines=True)
+    if result.returncode != 0:
+        print('Variant "%s" failed, skipping it.' % variant, file=sys.stderr)
+        return []
+    return list(csv.DictReader(io.StringIO(result.stdout)))
+
+
+def key(row):
+    return (row['scene'], row['variant'], row['backend'], row['rays'],
+            row['query'])
+
+
+def compare(rows, baseline_file, tolerance):
+    with open(baseline_file) as f:
+        baseline = {key(row): row for row in csv.DictReader(f)}
+
+    regressions = 0
+    for row in rows:
+        ref = baseline.get(key(row))
+        if ref is None:
+            continue
+        ratio = float(row['mrays_per_s']) / float(ref['mrays_per_s'])
+        if ratio < 1 - tolerance:
+            regressions += 1
+            print('Regression: %s (%.2f -> %.2f Mrays/s, %+.1f%%)' %
+                  ('/'.join(key(row)), float(ref['mrays_per_s']),
+                   float(row['mrays_per_s']), (ratio - 1) * 100))
+    return regressions
+
+
+def print_summary(rows):
+    # Best variant per scene and ray set (using the ray_intersect query)
+    best = {}
+    for row in rows:
+        if row['query'] != 'ray_intersect':
+            continue
+        k = (row['scene'], row['rays'])
+        if k not in best or float(row['mrays_per_s']) > \
+                float(best[k]['mrays_per_s']):
+            best[k] = row
+
+    print('%-24s %-10s %-16s %-8s %s' %
+          ('scene', 'rays', 'best variant', 'backend', 'Mrays/s'))
+    for (scene, rays), row in sorted(best.items()):
+        print('%-24s %-10s %-16s %-8s %.2f' %
+              (scene, rays, row['variant'], row['backend'],
+               float(row['mrays_per_s'])))
+
+
+def main():
+    parser = argparse.ArgumentParser(
+        description='Ray tracing throughput benchmark')
+    parser.add_argument('scenes', nargs='+', help='Scene XML files')
+    parser.add_argument('--executable', help='Path of "bench_rays"')
+    parser.add_argument('--variants', nargs='+', default=None,
+                        help='Variants to benchmark (default: all enabled '
+                        'RGB variants)')
+    parser.add_argument('--rays', default='bench_rays',
+                        help='Directory storing the ray sets')
+    parser.add_argument('--spp', type=int, default=1,
+                        help='Primary rays per pixel')
+    parser.add_argument('--repeat', type=int, default=3,
+                        help='Repetitions per configuration')
+    parser.add_argument('--threads', type=int, default=None,
+                        help='Number of threads (CPU variants)')
+    parser.add_argument('-o', '--output', help='Output CSV file')
+    parser.add_argument('--baseline', help='CSV file of an earlier run')
+    parser.add_argument('--tolerance', type=float, default=0.05,
+                        help='Relative throughput loss reported as a '
+                        'regression (default: 0.05)')
+    args = parser.parse_args()
+
+    executable = find_executable(args.executable)
+    variants = args.variants or default_variants()
+
+    rows = []
+    for variant in variants:
+        rows += run_variant(executable, variant, args.scenes, args)
+
+    if not rows:
+        print('No results!', file=sys.stderr)
+        return 1
+
+    if args.output is not None:
+        with open(args.output, 'w', newline='') as f:
+            writer = csv.DictWriter(f, fieldnames=list(rows[0].keys()))
+            writer.writeheader()
+            writer.writerows(rows)
+
+    print_summary(rows)
+
+    if args.baseline is not None:
+        if compare(rows, args.baseline, args.tolerance) > 0:
+            return 1
+
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
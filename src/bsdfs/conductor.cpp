@@ -1,6 +1,7 @@
 #include <mitsuba/core/properties.h>
 #include <mitsuba/core/warp.h>
 #include <mitsuba/render/bsdf.h>
+#include <mitsuba/render/dispatch.h>
 #include <mitsuba/render/fresnel.h>
 #include <mitsuba/render/ior.h>
 #include <mitsuba/render/texture.h>
@@ -199,6 +200,8 @@ public:
 
     SmoothConductor(const Properties &props) : Base(props) {
         m_flags = BSDFFlags::DeltaReflection | BSDFFlags::FrontSide;
+        if constexpr (is_polarized_v<Spectrum>)
+            m_flags = m_flags | BSDFFlags::Polarizing;
         m_components.push_back(m_flags);
 
         m_specular_reflectance = props.texture<Texture>("specular_reflectance", 1.f);
@@ -235,9 +238,9 @@ public:
         bs.eta = 1.f;
         bs.pdf = 1.f;
 
-        Complex<UnpolarizedSpectrum> eta(m_eta->eval(si, active),
-                                         m_k->eval(si, active));
-        UnpolarizedSpectrum reflectance = m_specular_reflectance->eval(si, active);
+        Complex<UnpolarizedSpectrum> eta(eval_texture(m_eta.get(), si, active),
+                                         eval_texture(m_k.get(), si, active));
+        UnpolarizedSpectrum reflectance = eval_texture(m_specular_reflectance.get(), si, active);
 
         if constexpr (is_polarized_v<Spectrum>) {
             /* Due to lack of reciprocity in polarization-aware pBRDFs, they are
@@ -195,6 +195,11 @@ public:
         m_components.push_back(BSDFFlags::DeltaTransmission | BSDFFlags::FrontSide |
                                BSDFFlags::BackSide | BSDFFlags::NonSymmetric);
 
+        if constexpr (is_polarized_v<Spectrum>) {
+            for (auto &c : m_components)
+                c = c | BSDFFlags::Polarizing;
+        }
+
         m_flags = m_components[0] | m_components[1];
     }
 
@@ -2,6 +2,7 @@
 #include <mitsuba/core/spectrum.h>
 #include <mitsuba/core/warp.h>
 #include <mitsuba/render/bsdf.h>
+#include <mitsuba/render/dispatch.h>
 #include <mitsuba/render/texture.h>
 
 NAMESPACE_BEGIN(mitsuba)
@@ -72,6 +73,8 @@ public:
     SmoothDiffuse(const Properties &props) : Base(props) {
         m_reflectance = props.texture<Texture>("reflectance", .5f);
         m_flags = BSDFFlags::DiffuseReflection | BSDFFlags::FrontSide;
+        if (m_reflectance->needs_differentials())
+            m_flags = m_flags | BSDFFlags::NeedsDifferentials;
         m_components.push_back(m_flags);
     }
 
@@ -96,7 +99,7 @@ public:
         bs.sampled_type = +BSDFFlags::DiffuseReflection;
         bs.sampled_component = 0;
 
-        UnpolarizedSpectrum value = m_reflectance->eval(si, active);
+        UnpolarizedSpectrum value = eval_texture(m_reflectance.get(), si, active);
 
         return { bs, select(active && bs.pdf > 0.f, unpolarized<Spectrum>(value), 0.f) };
     }
@@ -114,7 +117,7 @@ public:
         active &= cos_theta_i > 0.f && cos_theta_o > 0.f;
 
         UnpolarizedSpectrum value =
-            m_reflectance->eval(si, active) * math::InvPi<Float> * cos_theta_o;
+            eval_texture(m_reflectance.get(), si, active) * math::InvPi<Float> * cos_theta_o;
 
         return select(active, unpolarized<Spectrum>(value), 0.f);
     }
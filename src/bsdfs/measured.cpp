@@ -4,6 +4,9 @@
 #include <mitsuba/core/distr_2d.h>
 #include <mitsuba/core/warp.h>
 #include <mitsuba/render/bsdf.h>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
 
 /// Set to 1 to fall back to cosine-weighted sampling (for debugging)
 #define MTS_SAMPLE_DIFFUSE     0
@@ -33,127 +36,9 @@ public:
         auto fs            = Thread::thread()->file_resolver();
         fs::path file_path = fs->resolve(props.string("filename"));
         m_name             = file_path.filename().string();
+        m_half             = props.bool_("half_precision", false);
 
-        ref<TensorFile> tf = new TensorFile(file_path);
-        auto theta_i       = tf->field("theta_i");
-        auto phi_i         = tf->field("phi_i");
-        auto ndf           = tf->field("ndf");
-        auto sigma         = tf->field("sigma");
-        auto vndf          = tf->field("vndf");
-        auto spectra       = tf->field("spectra");
-        auto luminance     = tf->field("luminance");
-        auto wavelengths   = tf->field("wavelengths");
-        auto description   = tf->field("description");
-        auto jacobian      = tf->field("jacobian");
-
-        if (!(description.shape.size() == 1 &&
-              description.dtype == Struct::Type::UInt8 &&
-
-              theta_i.shape.size() == 1 &&
-              theta_i.dtype == Struct::Type::Float32 &&
-
-              phi_i.shape.size() == 1 &&
-              phi_i.dtype == Struct::Type::Float32 &&
-
-              wavelengths.shape.size() == 1 &&
-              wavelengths.dtype == Struct::Type::Float32 &&
-
-              ndf.shape.size() == 2 &&
-              ndf.dtype == Struct::Type::Float32 &&
-
-              sigma.shape.size() == 2 &&
-              sigma.dtype == Struct::Type::Float32 &&
-
-              vndf.shape.size() == 4 &&
-              vndf.dtype == Struct::Type::Float32 &&
-              vndf.shape[0] == phi_i.shape[0] &&
-              vndf.shape[1] == theta_i.shape[0] &&
-
-              luminance.shape.size() == 4 &&
-              luminance.dtype == Struct::Type::Float32 &&
-              luminance.shape[0] == phi_i.shape[0] &&
-              luminance.shape[1] == theta_i.shape[0] &&
-              luminance.shape[2] == luminance.shape[3] &&
-
-              spectra.dtype == Struct::Type::Float32 &&
-              spectra.shape.size() == 5 &&
-              spectra.shape[0] == phi_i.shape[0] &&
-              spectra.shape[1] == theta_i.shape[0] &&
-              spectra.shape[2] == wavelengths.shape[0] &&
-              spectra.shape[3] == spectra.shape[4] &&
-
-              luminance.shape[2] == spectra.shape[3] &&
-              luminance.shape[3] == spectra.shape[4] &&
-
-              jacobian.shape.size() == 1 &&
-              jacobian.shape[0] == 1 &&
-              jacobian.dtype == Struct::Type::UInt8))
-              Throw("Invalid file structure: %s", tf);
-
-        m_isotropic = phi_i.shape[0] <= 2;
-        m_jacobian  = ((uint8_t *) jacobian.data)[0];
-
-        if (!m_isotropic) {
-            ScalarFloat *phi_i_data = (ScalarFloat *) phi_i.data;
-            m_reduction = (int) std::rint((2 * math::Pi<ScalarFloat>) /
-                (phi_i_data[phi_i.shape[0] - 1] - phi_i_data[0]));
-        }
-
-        // Construct NDF interpolant data structure
-        m_ndf = Warp2D0(
-            (ScalarFloat *) ndf.data,
-            ScalarVector2u(ndf.shape[1], ndf.shape[0]),
-            { }, { }, false, false
-        );
-
-        // Construct projected surface area interpolant data structure
-        m_sigma = Warp2D0(
-            (ScalarFloat *) sigma.data,
-            ScalarVector2u(sigma.shape[1], sigma.shape[0]),
-            { }, { }, false, false
-        );
-
-        // Construct VNDF warp data structure
-        m_vndf = Warp2D2(
-            (ScalarFloat *) vndf.data,
-            ScalarVector2u(vndf.shape[3], vndf.shape[2]),
-            {{ (uint32_t) phi_i.shape[0],
-               (uint32_t) theta_i.shape[0] }},
-            {{ (const ScalarFloat *) phi_i.data,
-               (const ScalarFloat *) theta_i.data }}
-        );
-
-        // Construct Luminance warp data structure
-        m_luminance = Warp2D2(
-            (ScalarFloat *) luminance.data,
-            ScalarVector2u(luminance.shape[3], luminance.shape[2]),
-            {{ (uint32_t) phi_i.shape[0],
-               (uint32_t) theta_i.shape[0] }},
-            {{ (const ScalarFloat *) phi_i.data,
-               (const ScalarFloat *) theta_i.data }}
-        );
-
-        // Construct spectral interpolant
-        m_spectra = Warp2D3(
-            (ScalarFloat *) spectra.data,
-            ScalarVector2u(spectra.shape[4], spectra.shape[3]),
-            {{ (uint32_t) phi_i.shape[0],
-               (uint32_t) theta_i.shape[0],
-               (uint32_t) wavelengths.shape[0] }},
-            {{ (const ScalarFloat *) phi_i.data,
-               (const ScalarFloat *) theta_i.data,
-               (const ScalarFloat *) wavelengths.data }},
-            false, false
-        );
-
-        std::string description_str(
-            (const char *) description.data,
-            (const char *) description.data + description.shape[0]
-        );
-
-        Log(Info, "Loaded material \"%s\" (resolution %i x %i x %i x %i x %i)",
-            description_str, spectra.shape[0], spectra.shape[1],
-            spectra.shape[3], spectra.shape[4], spectra.shape[2]);
+        load_shared(file_path);
     }
 
     /**
@@ -183,9 +68,9 @@ public:
 
         Float sx = -1.f, sy = -1.f;
 
-        if (m_reduction >= 2) {
+        if (m_data->reduction >= 2) {
             sy = wi.y();
-            sx = (m_reduction == 4) ? wi.x() : sy;
+            sx = (m_data->reduction == 4) ? wi.x() : sy;
             wi.x() = mulsign_neg(wi.x(), sx);
             wi.y() = mulsign_neg(wi.y(), sy);
         }
@@ -203,15 +88,15 @@ public:
         Float pdf = 1.f;
 
         #if MTS_SAMPLE_LUMINANCE == 1
-        std::tie(sample, pdf) = m_luminance.sample(sample, params, active);
+        std::tie(sample, pdf) = m_data->luminance.sample(sample, params, active);
         #endif
 
-        auto [u_m, ndf_pdf] = m_vndf.sample(sample, params, active);
+        auto [u_m, ndf_pdf] = m_data->vndf.sample(sample, params, active);
 
         Float phi_m   = u2phi(u_m.y()),
             theta_m = u2theta(u_m.x());
 
-        if (m_isotropic)
+        if (m_data->isotropic)
             phi_m += phi_i;
 
         // Spherical -> Cartesian coordinates
@@ -240,26 +125,22 @@ public:
             phi_m   = atan2(m.y(), m.x());
 
         Vector2f u_m(theta2u(theta_m),
-                    phi2u(m_isotropic ? (phi_m - phi_i) : phi_m));
+                    phi2u(m_data->isotropic ? (phi_m - phi_i) : phi_m));
 
         u_m[1] = u_m[1] - floor(u_m[1]);
 
-    std::tie(sample, std::ignore) = m_vndf.invert(u_m, params, active);
+    std::tie(sample, std::ignore) = m_data->vndf.invert(u_m, params, active);
 #endif // MTS_SAMPLE_DIFFUSE
 
         bs.eta               = 1.f;
         bs.sampled_type      = +BSDFFlags::GlossyReflection;
         bs.sampled_component = 0;
 
-        UnpolarizedSpectrum spec;
-        for (size_t i = 0; i < array_size_v<UnpolarizedSpectrum>; ++i) {
-            Float params_spec[3] = { phi_i, theta_i, si.wavelengths[i] };
-            spec[i] = m_spectra.eval(sample, params_spec, active);
-        }
+        UnpolarizedSpectrum spec = eval_spectrum(sample, phi_i, theta_i, si.wavelengths, active);
 
-        if (m_jacobian)
-            spec *= m_ndf.eval(u_m, params, active) /
-                    (4 * m_sigma.eval(u_wi, params, active));
+        if (m_data->jacobian)
+            spec *= m_data->ndf.eval(u_m, params, active) /
+                    (4 * m_data->sigma.eval(u_wi, params, active));
 
         bs.wo.x() = mulsign_neg(bs.wo.x(), sx);
         bs.wo.y() = mulsign_neg(bs.wo.y(), sy);
@@ -281,9 +162,9 @@ public:
         if (!ctx.is_enabled(BSDFFlags::GlossyReflection) || none_or<false>(active))
             return Spectrum(0.f);
 
-        if (m_reduction >= 2) {
+        if (m_data->reduction >= 2) {
             Float sy = wi.y(),
-                sx = (m_reduction == 4) ? wi.x() : sy;
+                sx = (m_data->reduction == 4) ? wi.x() : sy;
 
             wi.x() = mulsign_neg(wi.x(), sx);
             wi.y() = mulsign_neg(wi.y(), sy);
@@ -302,22 +183,18 @@ public:
         // Spherical coordinates -> unit coordinate system
         Vector2f u_wi(theta2u(theta_i), phi2u(phi_i)),
                 u_m (theta2u(theta_m), phi2u(
-                    m_isotropic ? (phi_m - phi_i) : phi_m));
+                    m_data->isotropic ? (phi_m - phi_i) : phi_m));
 
         u_m[1] = u_m[1] - floor(u_m[1]);
 
         Float params[2] = { phi_i, theta_i };
-        auto [sample, unused] = m_vndf.invert(u_m, params, active);
+        auto [sample, unused] = m_data->vndf.invert(u_m, params, active);
 
-        UnpolarizedSpectrum spec;
-        for (size_t i = 0; i < array_size_v<UnpolarizedSpectrum>; ++i) {
-            Float params_spec[3] = { phi_i, theta_i, si.wavelengths[i] };
-            spec[i] = m_spectra.eval(sample, params_spec, active);
-        }
+        UnpolarizedSpectrum spec = eval_spectrum(sample, phi_i, theta_i, si.wavelengths, active);
 
-        if (m_jacobian)
-            spec *= m_ndf.eval(u_m, params, active) /
-                    (4 * m_sigma.eval(u_wi, params, active));
+        if (m_data->jacobian)
+            spec *= m_data->ndf.eval(u_m, params, active) /
+                    (4 * m_data->sigma.eval(u_wi, params, active));
 
         return unpolarized<Spectrum>(spec) & active;
     }
@@ -334,9 +211,9 @@ public:
         if (!ctx.is_enabled(BSDFFlags::GlossyReflection) || none_or<false>(active))
             return 0.f;
 
-        if (m_reduction >= 2) {
+        if (m_data->reduction >= 2) {
             Float sy = wi.y(),
-                sx = (m_reduction == 4) ? wi.x() : sy;
+                sx = (m_data->reduction == 4) ? wi.x() : sy;
 
             wi.x() = mulsign_neg(wi.x(), sx);
             wi.y() = mulsign_neg(wi.y(), sy);
@@ -358,16 +235,16 @@ public:
         // Spherical coordinates -> unit coordinate system
         Vector2f u_wi(theta2u(theta_i), phi2u(phi_i));
         Vector2f u_m (theta2u(theta_m),
-                    phi2u(m_isotropic ? (phi_m - phi_i) : phi_m));
+                    phi2u(m_data->isotropic ? (phi_m - phi_i) : phi_m));
 
         u_m[1] = u_m[1] - floor(u_m[1]);
 
         Float params[2] = { phi_i, theta_i };
-        auto [sample, vndf_pdf] = m_vndf.invert(u_m, params, active);
+        auto [sample, vndf_pdf] = m_data->vndf.invert(u_m, params, active);
 
         Float pdf = 1.f;
         #if MTS_SAMPLE_LUMINANCE == 1
-        pdf = m_luminance.eval(sample, params, active);
+        pdf = m_data->luminance.eval(sample, params, active);
         #endif
 
         Float jacobian =
@@ -384,18 +261,297 @@ public:
         std::ostringstream oss;
         oss << "Measured[" << std::endl
             << "  filename = \"" << m_name << "\"," << std::endl
-            << "  ndf = " << string::indent(m_ndf.to_string()) << "," << std::endl
-            << "  sigma = " << string::indent(m_sigma.to_string()) << "," << std::endl
-            << "  vndf = " << string::indent(m_vndf.to_string()) << "," << std::endl
-            << "  luminance = " << string::indent(m_luminance.to_string()) << "," << std::endl
-            << "  spectra = " << string::indent(m_spectra.to_string()) << std::endl
-            << "]";
+            << "  half_precision = " << (m_half ? "true" : "false") << "," << std::endl
+            << "  ndf = " << string::indent(m_data->ndf.to_string()) << "," << std::endl
+            << "  sigma = " << string::indent(m_data->sigma.to_string()) << "," << std::endl
+            << "  vndf = " << string::indent(m_data->vndf.to_string()) << "," << std::endl
+            << "  luminance = " << string::indent(m_data->luminance.to_string()) << "," << std::endl;
+        if constexpr (is_spectral_v<Spectrum>)
+            oss << "  spectra = " << string::indent(m_data->spectra.to_string()) << std::endl;
+        else
+            oss << "  reduced = " << string::indent(m_data->reduced[0].to_string()) << std::endl;
+        oss << "]";
         return oss.str();
     }
 
     MTS_DECLARE_CLASS()
 private:
+    /// Tables of a material file, which are shared by all BSDFs that load it
+    struct Data {
+        Warp2D0 ndf;
+        Warp2D0 sigma;
+        Warp2D2 vndf;
+        Warp2D2 luminance;
+
+        /// Spectral interpolant (spectral variants)
+        Warp2D3 spectra;
+
+        /// Spectra reduced to linear sRGB or luminance (other variants)
+        Warp2D2 reduced[3];
+
+        bool isotropic;
+        bool jacobian;
+        int reduction = 0;
+    };
+
+    /// Entry of the cache of loaded materials (see \ref load_shared())
+    struct CacheEntry {
+        std::mutex mutex;
+        std::weak_ptr<const Data> data;
+    };
+
+    static std::mutex &cache_mutex() {
+        static std::mutex mutex;
+        return mutex;
+    }
+
+    static std::unordered_map<std::string, std::shared_ptr<CacheEntry>> &shared_cache() {
+        static std::unordered_map<std::string, std::shared_ptr<CacheEntry>> cache;
+        return cache;
+    }
+
+    /// Share the tables with the other BSDFs that load the same file
+    void load_shared(const fs::path &file_path) {
+        std::string key = tfm::format("%s|%i", file_path.string(), (int) m_half);
+
+        std::shared_ptr<CacheEntry> entry;
+        {
+            std::lock_guard<std::mutex> guard(cache_mutex());
+            auto &cache = shared_cache();
+
+            // Drop the materials that are no longer used by any BSDF
+            for (auto it = cache.begin(); it != cache.end(); ) {
+                if (it->first != key && it->second->data.expired())
+                    it = cache.erase(it);
+                else
+                    ++it;
+            }
+
+            auto &value = cache[key];
+            if (!value)
+                value = std::make_shared<CacheEntry>();
+            entry = value;
+        }
+
+        // Only one thread loads the file, the others wait for it
+        std::lock_guard<std::mutex> guard(entry->mutex);
+        m_data = entry->data.lock();
+        if (m_data) {
+            Log(Debug, "Reusing measured material \"%s\"", m_name);
+            return;
+        }
+
+        m_data = load(file_path, m_half);
+        entry->data = m_data;
+    }
+
+    /// Load the tables of a material file (see \ref load_shared())
+    static std::shared_ptr<const Data> load(const fs::path &file_path, bool half_precision) {
+        std::shared_ptr<Data> data = std::make_shared<Data>();
+
+        ref<TensorFile> tf = new TensorFile(file_path);
+        auto theta_i       = tf->field("theta_i");
+        auto phi_i         = tf->field("phi_i");
+        auto ndf           = tf->field("ndf");
+        auto sigma         = tf->field("sigma");
+        auto vndf          = tf->field("vndf");
+        auto spectra       = tf->field("spectra");
+        auto luminance     = tf->field("luminance");
+        auto wavelengths   = tf->field("wavelengths");
+        auto description   = tf->field("description");
+        auto jacobian      = tf->field("jacobian");
+
+        if (!(description.shape.size() == 1 &&
+              description.dtype == Struct::Type::UInt8 &&
+
+              theta_i.shape.size() == 1 &&
+              theta_i.dtype == Struct::Type::Float32 &&
+
+              phi_i.shape.size() == 1 &&
+              phi_i.dtype == Struct::Type::Float32 &&
+
+              wavelengths.shape.size() == 1 &&
+              wavelengths.dtype == Struct::Type::Float32 &&
+
+              ndf.shape.size() == 2 &&
+              ndf.dtype == Struct::Type::Float32 &&
+
+              sigma.shape.size() == 2 &&
+              sigma.dtype == Struct::Type::Float32 &&
+
+              vndf.shape.size() == 4 &&
+              vndf.dtype == Struct::Type::Float32 &&
+              vndf.shape[0] == phi_i.shape[0] &&
+              vndf.shape[1] == theta_i.shape[0] &&
+
+              luminance.shape.size() == 4 &&
+              luminance.dtype == Struct::Type::Float32 &&
+              luminance.shape[0] == phi_i.shape[0] &&
+              luminance.shape[1] == theta_i.shape[0] &&
+              luminance.shape[2] == luminance.shape[3] &&
+
+              spectra.dtype == Struct::Type::Float32 &&
+              spectra.shape.size() == 5 &&
+              spectra.shape[0] == phi_i.shape[0] &&
+              spectra.shape[1] == theta_i.shape[0] &&
+              spectra.shape[2] == wavelengths.shape[0] &&
+              spectra.shape[3] == spectra.shape[4] &&
+
+              luminance.shape[2] == spectra.shape[3] &&
+              luminance.shape[3] == spectra.shape[4] &&
+
+              jacobian.shape.size() == 1 &&
+              jacobian.shape[0] == 1 &&
+              jacobian.dtype == Struct::Type::UInt8))
+              Throw("Invalid file structure: %s", tf);
+
+        data->isotropic = phi_i.shape[0] <= 2;
+        data->jacobian  = ((uint8_t *) jacobian.data)[0];
+
+        if (!data->isotropic) {
+            ScalarFloat *phi_i_data = (ScalarFloat *) phi_i.data;
+            data->reduction = (int) std::rint((2 * math::Pi<ScalarFloat>) /
+                (phi_i_data[phi_i.shape[0] - 1] - phi_i_data[0]));
+        }
+
+        /* The interpolants that are only evaluated refer to the memory-mapped
+           tables instead of copying them, and keep the file mapped */
+
+        // Construct NDF interpolant data structure
+        data->ndf = Warp2D0(
+            tf.get(), (const ScalarFloat *) ndf.data,
+            ScalarVector2u(ndf.shape[1], ndf.shape[0])
+        );
+
+        // Construct projected surface area interpolant data structure
+        data->sigma = Warp2D0(
+            tf.get(), (const ScalarFloat *) sigma.data,
+            ScalarVector2u(sigma.shape[1], sigma.shape[0])
+        );
+
+        // Construct VNDF warp data structure
+        data->vndf = Warp2D2(
+            (ScalarFloat *) vndf.data,
+            ScalarVector2u(vndf.shape[3], vndf.shape[2]),
+            {{ (uint32_t) phi_i.shape[0],
+               (uint32_t) theta_i.shape[0] }},
+            {{ (const ScalarFloat *) phi_i.data,
+               (const ScalarFloat *) theta_i.data }}
+        );
+
+        // Construct Luminance warp data structure
+        data->luminance = Warp2D2(
+            (ScalarFloat *) luminance.data,
+            ScalarVector2u(luminance.shape[3], luminance.shape[2]),
+            {{ (uint32_t) phi_i.shape[0],
+               (uint32_t) theta_i.shape[0] }},
+            {{ (const ScalarFloat *) phi_i.data,
+               (const ScalarFloat *) theta_i.data }}
+        );
+
+        uint32_t n_phi        = (uint32_t) phi_i.shape[0],
+                 n_theta      = (uint32_t) theta_i.shape[0],
+                 n_wavelength = (uint32_t) wavelengths.shape[0];
+
+        if constexpr (is_spectral_v<Spectrum>) {
+            // Construct spectral interpolant
+            ScalarVector2u spectra_size(spectra.shape[4], spectra.shape[3]);
+            std::array<uint32_t, 3> spectra_res = {{ n_phi, n_theta, n_wavelength }};
+            std::array<const ScalarFloat *, 3> spectra_values = {{
+                (const ScalarFloat *) phi_i.data,
+                (const ScalarFloat *) theta_i.data,
+                (const ScalarFloat *) wavelengths.data
+            }};
+
+            if (half_precision)
+                data->spectra = Warp2D3((const ScalarFloat *) spectra.data, spectra_size,
+                                        spectra_res, spectra_values, false, false, true);
+            else
+                data->spectra = Warp2D3(tf.get(), (const ScalarFloat *) spectra.data,
+                                        spectra_size, spectra_res, spectra_values);
+        } else {
+            /* Integrate the spectra against the CIE 1931 matching functions
+               (trapezoid rule over the tabulated wavelengths) and convert
+               them to linear sRGB or luminance */
+            constexpr size_t Channels = array_size_v<UnpolarizedSpectrum>;
+            const ScalarFloat *lambda = (const ScalarFloat *) wavelengths.data;
+
+            std::vector<ScalarFloat> weights(n_wavelength * Channels);
+            ScalarFloat y_integral = 0.f;
+            for (uint32_t k = 0; k < n_wavelength; ++k) {
+                ScalarFloat width = .5f * (lambda[std::min(k + 1, n_wavelength - 1)] -
+                                           lambda[k > 0 ? k - 1 : 0]);
+                Color<ScalarFloat, 3> xyz = cie1931_xyz(lambda[k]) * width,
+                                      rgb = xyz_to_srgb(xyz);
+                y_integral += xyz.y();
+
+                for (size_t c = 0; c < Channels; ++c)
+                    weights[k * Channels + c] = Channels == 3 ? rgb[c] : xyz.y();
+            }
+
+            size_t n_pixels = (size_t) spectra.shape[3] * spectra.shape[4];
+            const ScalarFloat *values = (const ScalarFloat *) spectra.data;
+            std::vector<ScalarFloat> reduced(n_phi * n_theta * n_pixels);
+
+            for (size_t c = 0; c < Channels; ++c) {
+                for (size_t slice = 0; slice < (size_t) n_phi * n_theta; ++slice) {
+                    ScalarFloat *out = reduced.data() + slice * n_pixels;
+                    std::fill(out, out + n_pixels, 0.f);
+                    for (uint32_t k = 0; k < n_wavelength; ++k) {
+                        const ScalarFloat *in = values + (slice * n_wavelength + k) * n_pixels;
+                        ScalarFloat weight = weights[k * Channels + c] / y_integral;
+                        for (size_t i = 0; i < n_pixels; ++i)
+                            out[i] += weight * in[i];
+                    }
+                    for (size_t i = 0; i < n_pixels; ++i)
+                        out[i] = std::max(out[i], (ScalarFloat) 0.f);
+                }
+
+                data->reduced[c] = Warp2D2(
+                    reduced.data(),
+                    ScalarVector2u(spectra.shape[4], spectra.shape[3]),
+                    {{ n_phi, n_theta }},
+                    {{ (const ScalarFloat *) phi_i.data,
+                       (const ScalarFloat *) theta_i.data }},
+                    false, false, half_precision
+                );
+            }
+        }
+
+        std::string description_str(
+            (const char *) description.data,
+            (const char *) description.data + description.shape[0]
+        );
+
+        Log(Info, "Loaded material \"%s\" (resolution %i x %i x %i x %i x %i)",
+            description_str, spectra.shape[0], spectra.shape[1],
+            spectra.shape[3], spectra.shape[4], spectra.shape[2]);
+
+        return data;
+    }
+
+
+    /// Evaluate the tabulated reflectance for the given wavelengths (or color channels)
+    UnpolarizedSpectrum eval_spectrum(const Point2f &sample, const Float &phi_i,
+                                      const Float &theta_i, const Wavelength &wavelengths,
+                                      Mask active) const {
+        UnpolarizedSpectrum spec;
+        if constexpr (is_spectral_v<Spectrum>) {
+            for (size_t i = 0; i < array_size_v<UnpolarizedSpectrum>; ++i) {
+                Float params_spec[3] = { phi_i, theta_i, wavelengths[i] };
+                spec[i] = m_data->spectra.eval(sample, params_spec, active);
+            }
+        } else {
+            ENOKI_MARK_USED(wavelengths);
+            Float params[2] = { phi_i, theta_i };
+            for (size_t i = 0; i < array_size_v<UnpolarizedSpectrum>; ++i)
+                spec[i] = m_data->reduced[i].eval(sample, params, active);
+        }
+        return spec;
+    }
+
     template <typename Value> Value u2theta(Value u) const {
+
         return sqr(u) * (math::Pi<Float> / 2.f);
     }
 
@@ -413,14 +569,8 @@ private:
 
 private:
     std::string m_name;
-    Warp2D0 m_ndf;
-    Warp2D0 m_sigma;
-    Warp2D2 m_vndf;
-    Warp2D2 m_luminance;
-    Warp2D3 m_spectra;
-    bool m_isotropic;
-    bool m_jacobian;
-    int m_reduction;
+    std::shared_ptr<const Data> m_data;
+    bool m_half;
 };
 
 MTS_IMPLEMENT_CLASS_VARIANT(Measured, BSDF)
@@ -3,6 +3,7 @@
 #include <mitsuba/core/string.h>
 #include <mitsuba/core/warp.h>
 #include <mitsuba/render/bsdf.h>
+#include <mitsuba/render/dispatch.h>
 #include <mitsuba/render/fresnel.h>
 #include <mitsuba/render/ior.h>
 #include <mitsuba/render/texture.h>
@@ -155,6 +156,12 @@ public:
 
         m_components.push_back(BSDFFlags::DeltaReflection | BSDFFlags::FrontSide);
         m_components.push_back(BSDFFlags::DiffuseReflection | BSDFFlags::FrontSide);
+
+        // Filtered texture lookups require the UV partials
+        if (m_specular_reflectance && m_specular_reflectance->needs_differentials())
+            m_components[0] |= +BSDFFlags::NeedsDifferentials;
+        if (m_diffuse_reflectance->needs_differentials())
+            m_components[1] |= +BSDFFlags::NeedsDifferentials;
         m_flags = m_components[0] | m_components[1];
 
         parameters_changed();
@@ -221,7 +228,7 @@ public:
 
             UnpolarizedSpectrum value = f_i / bs.pdf;
             if (m_specular_reflectance)
-                value *= m_specular_reflectance->eval(si, sample_specular);
+                value *= eval_texture(m_specular_reflectance.get(), si, sample_specular);
             result[sample_specular] = value;
         }
 
@@ -232,7 +239,7 @@ public:
             masked(bs.sampled_type, sample_diffuse) = +BSDFFlags::DiffuseReflection;
 
             Float f_o = std::get<0>(fresnel(Frame3f::cos_theta(bs.wo), Float(m_eta)));
-            UnpolarizedSpectrum value = m_diffuse_reflectance->eval(si, sample_diffuse);
+            UnpolarizedSpectrum value = eval_texture(m_diffuse_reflectance.get(), si, sample_diffuse);
             value /= 1.f - (m_nonlinear ? (value * m_fdr_int) : m_fdr_int);
             value *= m_inv_eta_2 * (1.f - f_i) * (1.f - f_o) / prob_diffuse;
             result[sample_diffuse] = value;
@@ -258,7 +265,7 @@ public:
         Float f_i = std::get<0>(fresnel(cos_theta_i, Float(m_eta))),
               f_o = std::get<0>(fresnel(cos_theta_o, Float(m_eta)));
 
-        UnpolarizedSpectrum diff = m_diffuse_reflectance->eval(si, active);
+        UnpolarizedSpectrum diff = eval_texture(m_diffuse_reflectance.get(), si, active);
         diff /= 1.f - (m_nonlinear ? (diff * m_fdr_int) : m_fdr_int);
 
         diff *= warp::square_to_cosine_hemisphere_pdf(wo) *
@@ -293,6 +300,40 @@ public:
         return select(active, pdf, 0.f);
     }
 
+    std::pair<Spectrum, Float> eval_pdf(const BSDFContext &ctx,
+                                        const SurfaceInteraction3f &si,
+                                        const Vector3f &wo,
+                                        Mask active) const override {
+        MTS_MASKED_FUNCTION(ProfilerPhase::BSDFEvaluate, active);
+
+        Float cos_theta_i = Frame3f::cos_theta(si.wi),
+              cos_theta_o = Frame3f::cos_theta(wo);
+
+        active &= cos_theta_i > 0.f && cos_theta_o > 0.f;
+
+        if (unlikely(!ctx.is_enabled(BSDFFlags::DiffuseReflection, 1) || none_or<false>(active)))
+            return { 0.f, 0.f };
+
+        Float f_i = std::get<0>(fresnel(cos_theta_i, Float(m_eta))),
+              f_o = std::get<0>(fresnel(cos_theta_o, Float(m_eta)));
+
+        Float pdf_cos = warp::square_to_cosine_hemisphere_pdf(wo);
+
+        UnpolarizedSpectrum diff = eval_texture(m_diffuse_reflectance.get(), si, active);
+        diff /= 1.f - (m_nonlinear ? (diff * m_fdr_int) : m_fdr_int);
+        diff *= pdf_cos * m_inv_eta_2 * (1.f - f_i) * (1.f - f_o);
+
+        Float prob_diffuse = 1.f;
+        if (ctx.is_enabled(BSDFFlags::DeltaReflection, 0)) {
+            Float prob_specular = f_i * m_specular_sampling_weight;
+            prob_diffuse = (1.f - f_i) * (1.f - m_specular_sampling_weight);
+            prob_diffuse = prob_diffuse / (prob_specular + prob_diffuse);
+        }
+
+        return { select(active, unpolarized<Spectrum>(diff), zero<Spectrum>()),
+                 select(active, pdf_cos * prob_diffuse, 0.f) };
+    }
+
     void traverse(TraversalCallback *callback) override {
         callback->put_parameter("eta", m_eta);
         callback->put_object("diffuse_reflectance", m_diffuse_reflectance.get());
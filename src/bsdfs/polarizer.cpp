@@ -69,6 +69,8 @@ public:
         m_transmittance = props.texture<Texture>("transmittance", 1.f);
 
         m_flags = BSDFFlags::FrontSide | BSDFFlags::BackSide | BSDFFlags::Null;
+        if constexpr (is_polarized_v<Spectrum>)
+            m_flags = m_flags | BSDFFlags::Polarizing;
         m_components.push_back(m_flags);
     }
 
@@ -61,6 +61,8 @@ public:
         m_delta = props.texture<Texture>("delta", 90.f);
 
         m_flags = BSDFFlags::FrontSide | BSDFFlags::BackSide | BSDFFlags::Null;
+        if constexpr (is_polarized_v<Spectrum>)
+            m_flags = m_flags | BSDFFlags::Polarizing;
         m_components.push_back(m_flags);
     }
 
@@ -2,6 +2,7 @@
 #include <mitsuba/core/fwd.h>
 #include <mitsuba/core/plugin.h>
 #include <mitsuba/render/bsdf.h>
+#include <mitsuba/render/dispatch.h>
 #include <mitsuba/render/ior.h>
 #include <mitsuba/render/microfacet.h>
 #include <mitsuba/render/texture.h>
@@ -48,6 +49,12 @@ Rough conductor material (:monosp:`roughconductor`)
    - Enables a sampling technique proposed by Heitz and D'Eon :cite:`Heitz1014Importance`, which
      focuses computation on the visible parts of the microfacet normal distribution, considerably
      reducing variance in some cases. (Default: |true|, i.e. use visible normal sampling)
+ * - tabulated_sampling
+   - |bool|
+   - Replaces the numerical inversion performed by visible normal sampling with the Beckmann
+     distribution by a lookup into a precomputed table. This is faster, at the cost of a small
+     approximation error in the sampled directions. Has no effect in GPU variants.
+     (Default: |false|)
 
 This plugin implements a realistic microfacet scattering model for rendering
 rough conducting materials, such as metals.
@@ -169,6 +176,7 @@ public:
         }
 
         m_sample_visible = props.bool_("sample_visible", true);
+        m_tabulated_sampling = props.bool_("tabulated_sampling", false);
 
         if (props.has_property("alpha_u") || props.has_property("alpha_v")) {
             if (!props.has_property("alpha_u") || !props.has_property("alpha_v"))
@@ -188,6 +196,11 @@ public:
         m_flags = BSDFFlags::GlossyReflection | BSDFFlags::FrontSide;
         if (m_alpha_u != m_alpha_v)
             m_flags = m_flags | BSDFFlags::Anisotropic;
+        if (m_alpha_u->needs_differentials() || m_alpha_v->needs_differentials() ||
+            (m_specular_reflectance && m_specular_reflectance->needs_differentials()))
+            m_flags = m_flags | BSDFFlags::NeedsDifferentials;
+        if constexpr (is_polarized_v<Spectrum>)
+            m_flags = m_flags | BSDFFlags::Polarizing;
 
         m_components.clear();
         m_components.push_back(m_flags);
@@ -210,9 +223,10 @@ public:
         /* Construct a microfacet distribution matching the
            roughness values at the current surface position. */
         MicrofacetDistribution distr(m_type,
-                                     m_alpha_u->eval_1(si, active),
-                                     m_alpha_v->eval_1(si, active),
-                                     m_sample_visible);
+                                     eval_texture_1(m_alpha_u.get(), si, active),
+                                     eval_texture_1(m_alpha_v.get(), si, active),
+                                     m_sample_visible,
+                                     m_tabulated_sampling);
 
         // Sample M, the microfacet normal
         Normal3f m;
@@ -238,8 +252,8 @@ public:
         bs.pdf /= 4.f * dot(bs.wo, m);
 
         // Evaluate the Fresnel factor
-        Complex<UnpolarizedSpectrum> eta_c(m_eta->eval(si, active),
-                                           m_k->eval(si, active));
+        Complex<UnpolarizedSpectrum> eta_c(eval_texture(m_eta.get(), si, active),
+                                           eval_texture(m_k.get(), si, active));
 
         Spectrum F;
         if constexpr (is_polarized_v<Spectrum>) {
@@ -275,7 +289,7 @@ public:
 
         /* If requested, include the specular reflectance component */
         if (m_specular_reflectance)
-            weight *= m_specular_reflectance->eval(si, active);
+            weight *= eval_texture(m_specular_reflectance.get(), si, active);
 
         return { bs, (F * weight) & active };
     }
@@ -298,8 +312,8 @@ public:
         /* Construct a microfacet distribution matching the
            roughness values at the current surface position. */
         MicrofacetDistribution distr(m_type,
-                                     m_alpha_u->eval_1(si, active),
-                                     m_alpha_v->eval_1(si, active),
+                                     eval_texture_1(m_alpha_u.get(), si, active),
+                                     eval_texture_1(m_alpha_v.get(), si, active),
                                      m_sample_visible);
 
         // Evaluate the microfacet normal distribution
@@ -314,44 +328,11 @@ public:
         UnpolarizedSpectrum result = D * G / (4.f * Frame3f::cos_theta(si.wi));
 
         // Evaluate the Fresnel factor
-        Complex<UnpolarizedSpectrum> eta_c(m_eta->eval(si, active),
-                                           m_k->eval(si, active));
-
-        Spectrum F;
-        if constexpr (is_polarized_v<Spectrum>) {
-            /* Due to lack of reciprocity in polarization-aware pBRDFs, they are
-               always evaluated w.r.t. the actual light propagation direction, no
-               matter the transport mode. In the following, 'wi_hat' is toward the
-               light source. */
-            Vector3f wi_hat = ctx.mode == TransportMode::Radiance ? wo : si.wi,
-                     wo_hat = ctx.mode == TransportMode::Radiance ? si.wi : wo;
-
-            // Mueller matrix for specular reflection.
-            F = mueller::specular_reflection(UnpolarizedSpectrum(Frame3f::cos_theta(wi_hat)), eta_c);
-
-            /* Apply frame reflection, according to "Stellar Polarimetry" by
-               David Clarke, Appendix A.2 (A26) */
-            F = mueller::reverse(F);
-
-            /* The Stokes reference frame vector of this matrix lies in the plane
-               of reflection. */
-            Vector3f s_axis_in  = normalize(cross(H, -wi_hat)),
-                     p_axis_in  = normalize(cross(-wi_hat, s_axis_in)),
-                     s_axis_out = normalize(cross(H, wo_hat)),
-                     p_axis_out = normalize(cross(wo_hat, s_axis_out));
-
-            /* Rotate in/out reference vector of F s.t. it aligns with the implicit
-               Stokes bases of -wi_hat & wo_hat. */
-            F = mueller::rotate_mueller_basis(F,
-                                              -wi_hat, p_axis_in, mueller::stokes_basis(-wi_hat),
-                                               wo_hat, p_axis_out, mueller::stokes_basis(wo_hat));
-        } else {
-            F = fresnel_conductor(UnpolarizedSpectrum(dot(si.wi, H)), eta_c);
-        }
+        Spectrum F = eval_fresnel(ctx, si, wo, H, active);
 
         /* If requested, include the specular reflectance component */
         if (m_specular_reflectance)
-            result *= m_specular_reflectance->eval(si, active);
+            result *= eval_texture(m_specular_reflectance.get(), si, active);
 
         return (F * result) & active;
     }
@@ -379,8 +360,8 @@ public:
         /* Construct a microfacet distribution matching the
            roughness values at the current surface position. */
         MicrofacetDistribution distr(m_type,
-                                     m_alpha_u->eval_1(si, active),
-                                     m_alpha_v->eval_1(si, active),
+                                     eval_texture_1(m_alpha_u.get(), si, active),
+                                     eval_texture_1(m_alpha_v.get(), si, active),
                                      m_sample_visible);
 
         Float result;
@@ -393,6 +374,61 @@ public:
         return select(active, result, 0.f);
     }
 
+    std::pair<Spectrum, Float> eval_pdf(const BSDFContext &ctx,
+                                        const SurfaceInteraction3f &si,
+                                        const Vector3f &wo,
+                                        Mask active) const override {
+        MTS_MASKED_FUNCTION(ProfilerPhase::BSDFEvaluate, active);
+
+        Float cos_theta_i = Frame3f::cos_theta(si.wi),
+              cos_theta_o = Frame3f::cos_theta(wo);
+
+        active &= cos_theta_i > 0.f && cos_theta_o > 0.f;
+
+        if (unlikely(!ctx.is_enabled(BSDFFlags::GlossyReflection) || none_or<false>(active)))
+            return { 0.f, 0.f };
+
+        // Calculate the half-direction vector
+        Vector3f H = normalize(wo + si.wi);
+
+        /* Construct a microfacet distribution matching the
+           roughness values at the current surface position. */
+        MicrofacetDistribution distr(m_type,
+                                     eval_texture_1(m_alpha_u.get(), si, active),
+                                     eval_texture_1(m_alpha_v.get(), si, active),
+                                     m_sample_visible);
+
+        // Evaluate the microfacet normal distribution
+        Float D = distr.eval(H);
+
+        active &= neq(D, 0.f);
+
+        /* The density additionally requires the micro- and macro-surface to
+           agree on the side, see pdf() */
+        Mask active_pdf = active && dot(si.wi, H) > 0.f && dot(wo, H) > 0.f;
+
+        Float pdf;
+        if (likely(m_sample_visible))
+            pdf = D * distr.smith_g1(si.wi, H) / (4.f * cos_theta_i);
+        else
+            pdf = distr.pdf(si.wi, H) / (4.f * dot(wo, H));
+
+        // Evaluate Smith's shadow-masking function
+        Float G = distr.G(si.wi, wo, H);
+
+        // Evaluate the full microfacet model (except Fresnel)
+        UnpolarizedSpectrum result = D * G / (4.f * cos_theta_i);
+
+        // Evaluate the Fresnel factor
+        Spectrum F = eval_fresnel(ctx, si, wo, H, active);
+
+        /* If requested, include the specular reflectance component */
+        if (m_specular_reflectance)
+            result *= eval_texture(m_specular_reflectance.get(), si, active);
+
+        return { (F * result) & active, select(active_pdf, pdf, 0.f) };
+    }
+
     void traverse(TraversalCallback *callback) override {
         if (!has_flag(m_flags, BSDFFlags::Anisotropic))
             callback->put_object("alpha", m_alpha_u.get());
@@ -411,6 +447,7 @@ public:
         oss << "RoughConductor[" << std::endl
             << "  distribution = " << m_type << "," << std::endl
             << "  sample_visible = " << m_sample_visible << "," << std::endl
+            << "  tabulated_sampling = " << m_tabulated_sampling << "," << std::endl
             << "  alpha_u = " << string::indent(m_alpha_u) << "," << std::endl
             << "  alpha_v = " << string::indent(m_alpha_v) << "," << std::endl;
         if (m_specular_reflectance)
@@ -422,6 +459,48 @@ public:
     }
 
     MTS_DECLARE_CLASS()
+protected:
+    /// Evaluate the (possibly polarized) Fresnel term for the half-vector \c H
+    Spectrum eval_fresnel(const BSDFContext &ctx, const SurfaceInteraction3f &si,
+                          const Vector3f &wo, const Vector3f &H, Mask active) const {
+        Complex<UnpolarizedSpectrum> eta_c(eval_texture(m_eta.get(), si, active),
+                                           eval_texture(m_k.get(), si, active));
+
+        Spectrum F;
+        if constexpr (is_polarized_v<Spectrum>) {
+            /* Due to lack of reciprocity in polarization-aware pBRDFs, they are
+               always evaluated w.r.t. the actual light propagation direction, no
+               matter the transport mode. In the following, 'wi_hat' is toward the
+               light source. */
+            Vector3f wi_hat = ctx.mode == TransportMode::Radiance ? wo : si.wi,
+                     wo_hat = ctx.mode == TransportMode::Radiance ? si.wi : wo;
+
+            // Mueller matrix for specular reflection.
+            F = mueller::specular_reflection(UnpolarizedSpectrum(Frame3f::cos_theta(wi_hat)), eta_c);
+
+            /* Apply frame reflection, according to "Stellar Polarimetry" by
+               David Clarke, Appendix A.2 (A26) */
+            F = mueller::reverse(F);
+
+            /* The Stokes reference frame vector of this matrix lies in the plane
+               of reflection. */
+            Vector3f s_axis_in  = normalize(cross(H, -wi_hat)),
+                     p_axis_in  = normalize(cross(-wi_hat, s_axis_in)),
+                     s_axis_out = normalize(cross(H, wo_hat)),
+                     p_axis_out = normalize(cross(wo_hat, s_axis_out));
+
+            /* Rotate in/out reference vector of F s.t. it aligns with the implicit
+               Stokes bases of -wi_hat & wo_hat. */
+            F = mueller::rotate_mueller_basis(F,
+                                              -wi_hat, p_axis_in, mueller::stokes_basis(-wi_hat),
+                                               wo_hat, p_axis_out, mueller::stokes_basis(wo_hat));
+        } else {
+            F = fresnel_conductor(UnpolarizedSpectrum(dot(si.wi, H)), eta_c);
+        }
+
+        return F;
+    }
+
 private:
     /// Specifies the type of microfacet distribution
     MicrofacetType m_type;
@@ -429,6 +508,8 @@ private:
     ref<Texture> m_alpha_u, m_alpha_v;
     /// Importance sample the distribution of visible normals?
     bool m_sample_visible;
+    /// Use the precomputed table for visible normal sampling?
+    bool m_tabulated_sampling;
     /// Relative refractive index (real component)
     ref<Texture> m_eta;
     /// Relative refractive index (imaginary component).
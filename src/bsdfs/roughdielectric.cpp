@@ -52,6 +52,12 @@ Rough dielectric material (:monosp:`roughdielectric`)
    - Enables a sampling technique proposed by Heitz and D'Eon :cite:`Heitz1014Importance`, which
      focuses computation on the visible parts of the microfacet normal distribution, considerably
      reducing variance in some cases. (Default: |true|, i.e. use visible normal sampling)
+ * - tabulated_sampling
+   - |bool|
+   - Replaces the numerical inversion performed by visible normal sampling with the Beckmann
+     distribution by a lookup into a precomputed table. This is faster, at the cost of a small
+     approximation error in the sampled directions. Has no effect in GPU variants.
+     (Default: |false|)
 
 
 This plugin implements a realistic microfacet scattering model for rendering
@@ -173,6 +179,7 @@ public:
         }
 
         m_sample_visible = props.bool_("sample_visible", true);
+        m_tabulated_sampling = props.bool_("tabulated_sampling", false);
 
         if (props.has_property("alpha_u") || props.has_property("alpha_v")) {
             if (!props.has_property("alpha_u") || !props.has_property("alpha_v"))
@@ -222,7 +229,8 @@ public:
         MicrofacetDistribution distr(m_type,
                                      m_alpha_u->eval_1(si, active),
                                      m_alpha_v->eval_1(si, active),
-                                     m_sample_visible);
+                                     m_sample_visible,
+                                     m_tabulated_sampling);
 
         /* Trick by Walter et al.: slightly scale the roughness values to
            reduce importance sampling weights. Not needed for the
@@ -450,6 +458,108 @@ public:
         return select(active, prob * abs(dwh_dwo), 0.f);
     }
 
+    std::pair<Spectrum, Float> eval_pdf(const BSDFContext &ctx,
+                                        const SurfaceInteraction3f &si,
+                                        const Vector3f &wo,
+                                        Mask active) const override {
+        MTS_MASKED_FUNCTION(ProfilerPhase::BSDFEvaluate, active);
+
+        Float cos_theta_i = Frame3f::cos_theta(si.wi),
+              cos_theta_o = Frame3f::cos_theta(wo);
+
+        // Ignore perfectly grazing configurations
+        active &= neq(cos_theta_i, 0.f);
+
+        // Determine the type of interaction
+        bool has_reflection   = ctx.is_enabled(BSDFFlags::GlossyReflection, 0),
+             has_transmission = ctx.is_enabled(BSDFFlags::GlossyTransmission, 1);
+
+        Mask reflect = cos_theta_i * cos_theta_o > 0.f;
+
+        // Determine the relative index of refraction
+        Float eta     = select(cos_theta_i > 0.f, Float(m_eta), Float(m_inv_eta)),
+              inv_eta = select(cos_theta_i > 0.f, Float(m_inv_eta), Float(m_eta));
+
+        // Compute the half-vector
+        Vector3f m = normalize(si.wi + wo * select(reflect, Float(1.f), eta));
+
+        // Ensure that the half-vector points into the same hemisphere as the macrosurface normal
+        m = mulsign(m, Frame3f::cos_theta(m));
+
+        /* Construct the microfacet distribution matching the
+           roughness values at the current surface position. */
+        MicrofacetDistribution distr(m_type,
+                                     m_alpha_u->eval_1(si, active),
+                                     m_alpha_v->eval_1(si, active),
+                                     m_sample_visible);
+
+        // Evaluate the microfacet normal distribution
+        Float D = distr.eval(m);
+
+        // Fresnel factor
+        Float F = std::get<0>(fresnel(dot(si.wi, m), Float(m_eta)));
+
+        // Smith's shadow-masking function
+        Float G = distr.G(si.wi, wo, m);
+
+        UnpolarizedSpectrum result(0.f);
+
+        Mask eval_r = Mask(has_reflection) && reflect && active,
+             eval_t = Mask(has_transmission) && !reflect && active;
+
+        if (any_or<true>(eval_r)) {
+            UnpolarizedSpectrum value = F * D * G / (4.f * abs(cos_theta_i));
+
+            if (m_specular_reflectance)
+                value *= m_specular_reflectance->eval(si, eval_r);
+
+            result[eval_r] = value;
+        }
+
+        if (any_or<true>(eval_t)) {
+            // See eval() regarding the solid angle compression
+            Float scale = (ctx.mode == TransportMode::Radiance) ? sqr(inv_eta) : Float(1.f);
+
+            // Compute the total amount of transmission
+            UnpolarizedSpectrum value = abs(
+                (scale * (1.f - F) * D * G * eta * eta * dot(si.wi, m) * dot(wo, m)) /
+                (cos_theta_i * sqr(dot(si.wi, m) + eta * dot(wo, m))));
+
+            if (m_specular_transmittance)
+                value *= m_specular_transmittance->eval(si, eval_t);
+
+            result[eval_t] = value;
+        }
+
+        /* Filter cases where the micro/macro-surface don't agree on the side
+           (see pdf()) */
+        Mask active_pdf = (eval_r || eval_t) &&
+                          dot(si.wi, m) * cos_theta_i > 0.f &&
+                          dot(wo,    m) * cos_theta_o > 0.f;
+
+        // Jacobian of the half-direction mapping
+        Float dwh_dwo = select(reflect, rcp(4.f * dot(wo, m)),
+                               (eta * eta * dot(wo, m)) /
+                                   sqr(dot(si.wi, m) + eta * dot(wo, m)));
+
+        // Evaluate the microfacet model sampling density function
+        Float prob;
+        if (likely(m_sample_visible)) {
+            prob = distr.pdf(mulsign(si.wi, cos_theta_i), m);
+        } else {
+            // Same roughness scaling as in sample() and pdf()
+            MicrofacetDistribution sample_distr(distr);
+            sample_distr.scale_alpha(1.2f - .2f * sqrt(abs(cos_theta_i)));
+            prob = sample_distr.pdf(mulsign(si.wi, cos_theta_i), m);
+        }
+
+        if (likely(has_transmission && has_reflection))
+            prob *= select(reflect, F, 1.f - F);
+
+        return { unpolarized<Spectrum>(result),
+                 select(active_pdf, prob * abs(dwh_dwo), 0.f) };
+    }
+
     void traverse(TraversalCallback *callback) override {
         if (!has_flag(m_flags, BSDFFlags::Anisotropic))
             callback->put_object("alpha", m_alpha_u.get());
@@ -468,7 +578,8 @@ public:
         std::ostringstream oss;
         oss << "RoughDielectric[" << std::endl
             << "  distribution = "           << m_type           << "," << std::endl
-            << "  sample_visible = "         << (int) m_sample_visible << "," << std::endl;
+            << "  sample_visible = "         << (int) m_sample_visible << "," << std::endl
+            << "  tabulated_sampling = "     << (int) m_tabulated_sampling << "," << std::endl;
 
         if (!has_flag(m_flags, BSDFFlags::Anisotropic)) {
             oss << "  alpha = "                  << string::indent(m_alpha_v) << "," << std::endl;
@@ -496,6 +607,7 @@ private:
     ref<Texture> m_alpha_u, m_alpha_v;
     ScalarFloat m_eta, m_inv_eta;
     bool m_sample_visible;
+    bool m_tabulated_sampling;
 };
 
 MTS_IMPLEMENT_CLASS_VARIANT(RoughDielectric, BSDF)
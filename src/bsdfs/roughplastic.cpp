@@ -5,6 +5,7 @@
 #include <mitsuba/core/timer.h>
 #include <mitsuba/core/warp.h>
 #include <mitsuba/render/bsdf.h>
+#include <mitsuba/render/dispatch.h>
 #include <mitsuba/render/ior.h>
 #include <mitsuba/render/microfacet.h>
 #include <mitsuba/render/texture.h>
@@ -61,6 +62,12 @@ Rough plastic material (:monosp:`roughplastic`)
    - Enables a sampling technique proposed by Heitz and D'Eon :cite:`Heitz1014Importance`, which
      focuses computation on the visible parts of the microfacet normal distribution, considerably
      reducing variance in some cases. (Default: |true|, i.e. use visible normal sampling)
+ * - tabulated_sampling
+   - |bool|
+   - Replaces the numerical inversion performed by visible normal sampling with the Beckmann
+     distribution by a lookup into a precomputed table. This is faster, at the cost of a small
+     approximation error in the sampled directions. Has no effect in GPU variants.
+     (Default: |false|)
 
 
 
@@ -168,6 +175,7 @@ public:
         mitsuba::MicrofacetDistribution<ScalarFloat, Spectrum> distr(props);
         m_type = distr.type();
         m_sample_visible = distr.sample_visible();
+        m_tabulated_sampling = distr.tabulated_sampling();
 
         if (distr.is_anisotropic())
             Throw("The 'roughplastic' plugin currently does not support "
@@ -177,7 +185,13 @@ public:
 
         m_components.push_back(BSDFFlags::GlossyReflection | BSDFFlags::FrontSide);
         m_components.push_back(BSDFFlags::DiffuseReflection | BSDFFlags::FrontSide);
-        m_flags =  m_components[0] | m_components[1];
+
+        // Filtered texture lookups require the UV partials
+        if (m_specular_reflectance && m_specular_reflectance->needs_differentials())
+            m_components[0] |= +BSDFFlags::NeedsDifferentials;
+        if (m_diffuse_reflectance->needs_differentials())
+            m_components[1] |= +BSDFFlags::NeedsDifferentials;
+        m_flags = m_components[0] | m_components[1];
 
         parameters_changed();
     }
@@ -219,7 +233,8 @@ public:
         bs.eta = 1.f;
 
         if (any_or<true>(sample_specular)) {
-            MicrofacetDistribution distr(m_type, m_alpha, m_sample_visible);
+            MicrofacetDistribution distr(m_type, m_alpha, m_sample_visible,
+                                         m_tabulated_sampling);
             Normal3f m = std::get<0>(distr.sample(si.wi, sample2));
 
             masked(bs.wo, sample_specular) = reflect(si.wi, m);
@@ -275,7 +290,7 @@ public:
             UnpolarizedSpectrum value = F * D * G / (4.f * cos_theta_i);
 
             if (m_specular_reflectance)
-                value *= m_specular_reflectance->eval(si, active);
+                value *= eval_texture(m_specular_reflectance.get(), si, active);
 
             result += value;
         }
@@ -286,7 +301,7 @@ public:
                   t_o = lerp_gather(m_external_transmittance.data(), cos_theta_o,
                                     MTS_ROUGH_TRANSMITTANCE_RES, active);
 
-            UnpolarizedSpectrum diff = m_diffuse_reflectance->eval(si, active);
+            UnpolarizedSpectrum diff = eval_texture(m_diffuse_reflectance.get(), si, active);
             diff /= 1.f - (m_nonlinear ? (diff * m_internal_reflectance)
                                        : UnpolarizedSpectrum(m_internal_reflectance));
 
@@ -353,6 +368,84 @@ public:
         return result;
     }
 
+    std::pair<Spectrum, Float> eval_pdf(const BSDFContext &ctx,
+                                        const SurfaceInteraction3f &si,
+                                        const Vector3f &wo,
+                                        Mask active) const override {
+        MTS_MASKED_FUNCTION(ProfilerPhase::BSDFEvaluate, active);
+
+        bool has_specular = ctx.is_enabled(BSDFFlags::GlossyReflection, 0),
+             has_diffuse  = ctx.is_enabled(BSDFFlags::DiffuseReflection, 1);
+
+        Float cos_theta_i = Frame3f::cos_theta(si.wi),
+              cos_theta_o = Frame3f::cos_theta(wo);
+
+        active &= cos_theta_i > 0.f && cos_theta_o > 0.f;
+
+        if (unlikely((!has_specular && !has_diffuse) || none_or<false>(active)))
+            return { 0.f, 0.f };
+
+        MicrofacetDistribution distr(m_type, m_alpha, m_sample_visible);
+
+        // Calculate the reflection half-vector
+        Vector3f H = normalize(wo + si.wi);
+
+        // Evaluate the microfacet normal distribution
+        Float D = distr.eval(H);
+
+        Float t_i = lerp_gather(m_external_transmittance.data(), cos_theta_i,
+                                MTS_ROUGH_TRANSMITTANCE_RES, active);
+
+        UnpolarizedSpectrum value(0.f);
+        if (has_specular) {
+            // Fresnel term
+            Float F = std::get<0>(fresnel(dot(si.wi, H), Float(m_eta)));
+
+            // Smith's shadow-masking function
+            Float G = distr.G(si.wi, wo, H);
+
+            // Calculate the specular reflection component
+            UnpolarizedSpectrum spec = F * D * G / (4.f * cos_theta_i);
+
+            if (m_specular_reflectance)
+                spec *= eval_texture(m_specular_reflectance.get(), si, active);
+
+            value += spec;
+        }
+
+        if (has_diffuse) {
+            Float t_o = lerp_gather(m_external_transmittance.data(), cos_theta_o,
+                                    MTS_ROUGH_TRANSMITTANCE_RES, active);
+
+            UnpolarizedSpectrum diff = eval_texture(m_diffuse_reflectance.get(), si, active);
+            diff /= 1.f - (m_nonlinear ? (diff * m_internal_reflectance)
+                                       : UnpolarizedSpectrum(m_internal_reflectance));
+
+            value += diff * (math::InvPi<Float> * m_inv_eta_2 * cos_theta_o * t_i * t_o);
+        }
+
+        // Determine which component would have been sampled
+        Float prob_specular = (1.f - t_i) * m_specular_sampling_weight,
+              prob_diffuse  = t_i * (1.f - m_specular_sampling_weight);
+
+        if (unlikely(has_specular != has_diffuse))
+            prob_specular = has_specular ? 1.f : 0.f;
+        else
+            prob_specular = prob_specular / (prob_specular + prob_diffuse);
+        prob_diffuse = 1.f - prob_specular;
+
+        Float pdf;
+        if (m_sample_visible)
+            pdf = D * distr.smith_g1(si.wi, H) / (4.f * cos_theta_i);
+        else
+            pdf = distr.pdf(si.wi, H) / (4.f * dot(wo, H));
+        pdf = pdf * prob_specular +
+              prob_diffuse * warp::square_to_cosine_hemisphere_pdf(wo);
+
+        return { select(active, unpolarized<Spectrum>(value), 0.f),
+                 select(active, pdf, 0.f) };
+    }
+
     void traverse(TraversalCallback *callback) override {
         callback->put_parameter("alpha", m_alpha);
         callback->put_parameter("eta", m_eta);
@@ -400,6 +493,7 @@ public:
         oss << "RoughPlastic[" << std::endl
             << "  distribution = " << m_type << "," << std::endl
             << "  sample_visible = "           << m_sample_visible                    << "," << std::endl
+            << "  tabulated_sampling = "       << m_tabulated_sampling                << "," << std::endl
             << "  alpha = "                    << m_alpha                             << "," << std::endl
             << "  diffuse_reflectance = "      << m_diffuse_reflectance               << "," << std::endl;
 
@@ -424,6 +518,7 @@ private:
     ScalarFloat m_specular_sampling_weight;
     bool m_nonlinear;
     bool m_sample_visible;
+    bool m_tabulated_sampling;
     DynamicBuffer<Float> m_external_transmittance;
     ScalarFloat m_internal_reflectance;
 };
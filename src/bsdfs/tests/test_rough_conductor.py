@@ -95,3 +95,26 @@ def test05_chi2_aniso_ggx_visible(variant_packet_rgb):
     )
 
     assert chi2.run()
+
+
+def test06_eval_pdf(variant_scalar_rgb):
+    from mitsuba.core import Frame3f
+    from mitsuba.core.xml import load_string
+    from mitsuba.render import BSDFContext, SurfaceInteraction3f
+
+    bsdf = load_string("""<bsdf version="2.0.0" type="roughconductor">
+        <float name="alpha_u" value="0.2"/>
+        <float name="alpha_v" value="0.4"/>
+    </bsdf>""")
+
+    si = SurfaceInteraction3f()
+    si.p = [0, 0, 0]
+    si.n = [0, 0, 1]
+    si.sh_frame = Frame3f(si.n)
+    si.wi = [0.6, 0, 0.8]
+    ctx = BSDFContext()
+
+    for wo in [[0, 0, 1], [-0.48, 0.36, 0.8], [0.3, 0.4, -0.866]]:
+        value, pdf = bsdf.eval_pdf(ctx, si, wo)
+        assert ek.allclose(value, bsdf.eval(ctx, si, wo))
+        assert ek.allclose(pdf, bsdf.pdf(ctx, si, wo))
@@ -200,3 +200,28 @@ def test11_chi2_aniso_lobe_trans(variant_packet_rgb):
     )
 
     assert chi2.run()
+
+
+def test12_eval_pdf(variant_scalar_rgb):
+    from mitsuba.core import Frame3f
+    from mitsuba.core.xml import load_string
+    from mitsuba.render import BSDFContext, SurfaceInteraction3f
+
+    for sample_visible in ['true', 'false']:
+        bsdf = load_string("""<bsdf version="2.0.0" type="roughdielectric">
+            <float name="alpha" value="0.3"/>
+            <boolean name="sample_visible" value="{}"/>
+        </bsdf>""".format(sample_visible))
+
+        si = SurfaceInteraction3f()
+        si.p = [0, 0, 0]
+        si.n = [0, 0, 1]
+        si.sh_frame = Frame3f(si.n)
+        ctx = BSDFContext()
+
+        for wi in [[0, 0, 1], [0.6, 0, 0.8], [0, -0.6, -0.8]]:
+            si.wi = wi
+            for wo in [[0, 0, 1], [-0.48, 0, 0.877], [0.3, 0.4, -0.866]]:
+                value, pdf = bsdf.eval_pdf(ctx, si, wo)
+                assert ek.allclose(value, bsdf.eval(ctx, si, wo))
+                assert ek.allclose(pdf, bsdf.pdf(ctx, si, wo))
@@ -3,8 +3,12 @@
 # of PyCapsule object at 0x7ffa78041090>" by "allclose" which is arguably just
 # as informative and much more compact.
 
+import json
+import os
+import platform
 import pytest
 import re
+import time
 
 re1 = re.compile(r'<built-in method (\w*) of PyCapsule object at 0x[0-9a-f]*>')
 re2 = re.compile(r'<bound method PyCapsule.(\w*)[^>]*>')
@@ -98,3 +102,121 @@ def pytest_configure(config):
     config.addinivalue_line(
         "markers", "slow: marks tests as slow (deselect with -m 'not slow')"
     )
+    config.addinivalue_line(
+        "markers", "perf: marks timed benchmarks (only run with --perf)"
+    )
+
+
+# ------------------------------------------------------------------------------
+# Performance regression tests: the tests marked 'perf' time representative
+# operations through the 'benchmark' fixture. Their timings can be stored in a
+# baseline file (--perf-save) and compared against it (--perf-baseline), e.g.
+#
+#     pytest src -m perf --perf --perf-save baseline.json
+#     pytest src -m perf --perf --perf-baseline baseline.json
+#
+# Timings depend on the machine: baselines should be recorded on the machine
+# that runs the comparison.
+# ------------------------------------------------------------------------------
+
+def pytest_addoption(parser):
+    group = parser.getgroup('mitsuba', 'Mitsuba performance regression tests')
+    group.addoption('--perf', action='store_true', default=False,
+                    help='Run the timed benchmarks (tests marked "perf")')
+    group.addoption('--perf-baseline', metavar='FILE', default=None,
+                    help='Fail the benchmarks that are slower than in this '
+                    'baseline JSON file')
+    group.addoption('--perf-save', metavar='FILE', default=None,
+                    help='Write the timings of the benchmarks to this JSON file '
+                    '(entries of benchmarks that did not run are preserved)')
+    group.addoption('--perf-tolerance', type=float, default=0.2,
+                    help='Relative slowdown tolerated by --perf-baseline '
+                    '(default: 0.2)')
+    group.addoption('--perf-repeat', type=int, default=5,
+                    help='Timed runs per benchmark, the fastest one is '
+                    'reported (default: 5)')
+
+
+def pytest_collection_modifyitems(config, items):
+    if config.getoption('perf', False):
+        return
+    skip_perf = pytest.mark.skip(reason='timed benchmark (run with --perf)')
+    for item in items:
+        if 'perf' in item.keywords:
+            item.add_marker(skip_perf)
+
+
+def load_perf_file(filename):
+    with open(filename) as f:
+        return json.load(f).get('results', {})
+
+
+perf_results = {}
+
+
+class Benchmark:
+    """
+    Callable of the 'benchmark' fixture: ``benchmark(func)`` calls ``func``
+    once to warm up (plugin loading, caches, ..), then times ``repeat`` more
+    calls and returns the fastest time in seconds. An optional ``setup``
+    function runs before each call, outside of the timed region.
+    """
+
+    def __init__(self, request):
+        self.request = request
+        config = request.config
+        self.repeat = config.getoption('perf_repeat')
+        self.tolerance = config.getoption('perf_tolerance')
+        baseline = config.getoption('perf_baseline')
+        self.baseline = load_perf_file(baseline) if baseline else {}
+
+    def __call__(self, func, name=None, setup=None, repeat=None):
+        key = self.request.node.nodeid
+        if name is not None:
+            key += '::' + name
+
+        times = []
+        for i in range((repeat or self.repeat) + 1):
+            if setup is not None:
+                setup()
+            start = time.perf_counter()
+            func()
+            if i > 0:
+                times.append(time.perf_counter() - start)
+
+        best = min(times)
+        perf_results[key] = best
+
+        ref = self.baseline.get(key)
+        if ref is not None and best > ref * (1 + self.tolerance):
+            pytest.fail('Performance regression in "%s": %.4f s (baseline: %.4f s, '
+                        '%+.1f%%, tolerance: %.0f%%)' %
+                        (key, best, ref, (best / ref - 1) * 100,
+                         self.tolerance * 100))
+        return best
+
+
+@pytest.fixture
+def benchmark(request):
+    if 'perf' not in request.node.keywords:
+        raise Exception('The "benchmark" fixture requires the "perf" marker!')
+    return Benchmark(request)
+
+
+def pytest_sessionfinish(session, exitstatus):
+    filename = session.config.getoption('perf_save', None)
+    if not filename or not perf_results:
+        return
+
+    results = load_perf_file(filename) if os.path.exists(filename) else {}
+    results.update(perf_results)
+    with open(filename, 'w') as f:
+        json.dump({
+            'machine': {
+                'node': platform.node(),
+                'processor': platform.processor(),
+                'system': platform.platform(),
+                'cpu_count': os.cpu_count()
+            },
+            'results': dict(sorted(results.items()))
+        }, f, indent=4)
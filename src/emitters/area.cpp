@@ -188,6 +188,16 @@ public:
 
     ScalarBoundingBox3f bbox() const override { return m_shape->bbox(); }
 
+    ScalarFloat power() const override {
+        // Diffuse emission from one side of the surface
+        return math::Pi<ScalarFloat> * m_shape->surface_area() * m_radiance->mean();
+    }
+
+    std::tuple<ScalarVector3f, ScalarFloat, ScalarFloat> emission_cone() const override {
+        auto [axis, cos_theta_o] = m_shape->normal_cone();
+        return { axis, cos_theta_o, 0.f };
+    }
+
     void traverse(TraversalCallback *callback) override {
         callback->put_object("radiance", m_radiance.get());
     }
@@ -116,6 +116,11 @@ public:
         return ScalarBoundingBox3f();
     }
 
+    ScalarFloat power() const override {
+        // Flux through a disk of the scene's radius, integrated over all directions
+        return 4.f * sqr(math::Pi<ScalarFloat> * m_bsphere.radius) * m_radiance->mean();
+    }
+
     void traverse(TraversalCallback *callback) override {
         callback->put_object("radiance", m_radiance.get());
     }
@@ -146,6 +146,11 @@ public:
         return ScalarBoundingBox3f();
     }
 
+    ScalarFloat power() const override {
+        // Flux through a disk of the scene's radius
+        return math::Pi<ScalarFloat> * sqr(m_bsphere.radius) * m_irradiance->mean();
+    }
+
     void traverse(TraversalCallback *callback) override {
         callback->put_object("irradiance", m_irradiance.get());
     }
@@ -2,11 +2,13 @@
 #include <mitsuba/core/bsphere.h>
 #include <mitsuba/core/distr_2d.h>
 #include <mitsuba/core/fresolver.h>
+#include <mitsuba/core/memory.h>
 #include <mitsuba/core/plugin.h>
 #include <mitsuba/render/emitter.h>
 #include <mitsuba/render/scene.h>
 #include <mitsuba/render/texture.h>
 #include <mitsuba/render/srgb.h>
+#include <enoki/half.h>
 
 NAMESPACE_BEGIN(mitsuba)
 
@@ -31,6 +33,20 @@ Environment emitter (:monosp:`envmap`)
    - |transform|
    - Specifies an optional emitter-to-world transformation.  (Default: none, i.e. emitter space = world space)
 
+ * - half_precision
+   - |bool|
+   - Store the environment map in half precision, which halves its memory usage
+     and the bandwidth of its lookups. Values above 65504 (the largest half
+     precision value) are clamped, and the ``data`` parameter is not exposed.
+     The sampling distribution is unaffected. (Default: false)
+
+ * - sampling_downscale
+   - |int|
+   - Build the importance sampling distribution at a resolution that is
+     reduced by this factor along each axis, which makes very large
+     environment maps faster to load and reduces their memory usage. The
+     radiance is still evaluated at full resolution. (Default: 1)
+
 This plugin provides a HDRI (high dynamic range imaging) environment map,
 which is a type of light source that is well-suited for representing "natural"
 illumination.
@@ -85,6 +101,7 @@ public:
 
         ScalarFloat *ptr     = (ScalarFloat *) bitmap->data(),
                     *lum_ptr = (ScalarFloat *) luminance.get();
+        double lum_sum = 0.0;
 
         for (size_t y = 0; y < bitmap->size().y(); ++y) {
             ScalarFloat sin_theta =
@@ -111,16 +128,37 @@ public:
                 }
 
                 *lum_ptr++ = lum * sin_theta;
+                lum_sum += lum * sin_theta;
                 store_unaligned(ptr, coeff);
                 ptr += 4;
             }
         }
 
         m_resolution = bitmap->size();
-        m_data = DynamicBuffer<Float>::copy(bitmap->data(), hprod(m_resolution) * 4);
+        m_half = props.bool_("half_precision", false);
+        int downscale = props.int_("sampling_downscale", 1);
+        if (downscale < 1)
+            Throw("The \"sampling_downscale\" parameter must be at least 1!");
+        m_sampling_downscale = (uint32_t) downscale;
+
+        if (m_half) {
+            // Store each pixel as four half precision values in two words
+            size_t count = hprod(m_resolution) * 4;
+            const ScalarFloat *src = (const ScalarFloat *) bitmap->data();
+            std::vector<uint32_t> words(count / 2, 0u);
+            for (size_t i = 0; i < count; ++i) {
+                float value = std::min((float) src[i], 65504.f);
+                words[i / 2] |= (uint32_t) enoki::half::float32_to_float16(value)
+                                << (16 * (i % 2));
+            }
+            m_data_half = DynamicBuffer<UInt32>::copy(words.data(), words.size());
+        } else {
+            m_data = DynamicBuffer<Float>::copy(bitmap->data(), hprod(m_resolution) * 4);
+        }
 
         m_scale = props.float_("scale", 1.f);
-        m_warp = Warp(luminance.get(), m_resolution);
+        build_warp(luminance.get());
+        m_mean_luminance = mean_luminance(lum_sum);
         m_d65 = Texture::D65(1.f);
         m_flags = EmitterFlags::Infinite | EmitterFlags::SpatiallyVarying;
     }
@@ -213,45 +251,70 @@ public:
         return ScalarBoundingBox3f();
     }
 
+    ScalarFloat power() const override {
+        // Flux through a disk of the scene's radius, integrated over all directions
+        return 4.f * sqr(math::Pi<ScalarFloat> * m_bsphere.radius) * m_scale *
+               m_mean_luminance;
+    }
+
     void traverse(TraversalCallback *callback) override {
         callback->put_parameter("scale", m_scale);
-        callback->put_parameter("data", m_data);
+        if (!m_half)
+            callback->put_parameter("data", m_data);
         callback->put_parameter("resolution", m_resolution);
     }
 
     void parameters_changed(const std::vector<std::string> &keys = {}) override {
-        if (keys.empty() || string::contains(keys, "data")) {
+        if (!m_half && (keys.empty() || string::contains(keys, "data"))) {
             m_data.managed();
 
             std::unique_ptr<ScalarFloat[]> luminance(new ScalarFloat[hprod(m_resolution)]);
-
-            ScalarFloat *ptr     = (ScalarFloat *) m_data.data(),
-                        *lum_ptr = (ScalarFloat *) luminance.get();
-
-
-            for (size_t y = 0; y < m_resolution.y(); ++y) {
-                ScalarFloat sin_theta =
-                    std::sin(y / ScalarFloat(m_resolution.y() - 1) * math::Pi<ScalarFloat>);
-
-                for (size_t x = 0; x < m_resolution.x(); ++x) {
-                    ScalarVector4f coeff = load<ScalarVector4f>(ptr);
-                    ScalarFloat lum;
-
-                    if constexpr (is_monochromatic_v<Spectrum>) {
-                        lum = coeff.x();
-                    } else if constexpr (is_rgb_v<Spectrum>) {
-                        lum = mitsuba::luminance(ScalarColor3f(head<3>(coeff)));
-                    } else {
-                        static_assert(is_spectral_v<Spectrum>);
-                        lum = srgb_model_mean(head<3>(coeff)) * coeff.w();
+            std::vector<double> row_sum(m_resolution.y(), 0.0);
+
+            const ScalarFloat *data = (const ScalarFloat *) m_data.data();
+            ScalarFloat *lum_data   = luminance.get();
+
+            /* Optimization loops update the pixels after each step, hence the
+               rows are processed in parallel. The sums of the rows are added
+               in order, so that the result does not depend on the schedule. */
+            tbb::parallel_for(
+                tbb::blocked_range<size_t>(0, m_resolution.y()),
+                [&](const tbb::blocked_range<size_t> &range) {
+                    for (size_t y = range.begin(); y != range.end(); ++y) {
+                        ScalarFloat sin_theta = std::sin(
+                            y / ScalarFloat(m_resolution.y() - 1) * math::Pi<ScalarFloat>);
+                        const ScalarFloat *ptr = data + y * m_resolution.x() * 4;
+                        ScalarFloat *lum_ptr   = lum_data + y * m_resolution.x();
+                        double sum = 0.0;
+
+                        for (size_t x = 0; x < m_resolution.x(); ++x) {
+                            ScalarVector4f coeff = load<ScalarVector4f>(ptr);
+                            ScalarFloat lum;
+
+                            if constexpr (is_monochromatic_v<Spectrum>) {
+                                lum = coeff.x();
+                            } else if constexpr (is_rgb_v<Spectrum>) {
+                                lum = mitsuba::luminance(ScalarColor3f(head<3>(coeff)));
+                            } else {
+                                static_assert(is_spectral_v<Spectrum>);
+                                lum = srgb_model_mean(head<3>(coeff)) * coeff.w();
+                            }
+
+                            *lum_ptr++ = lum * sin_theta;
+                            sum += lum * sin_theta;
+                            ptr += 4;
+                        }
+                        row_sum[y] = sum;
                     }
-
-                    *lum_ptr++ = lum * sin_theta;
-                    ptr += 4;
                 }
-            }
+            );
+
+            double lum_sum = 0.0;
+            for (double sum : row_sum)
+                lum_sum += sum;
 
-            m_warp = Warp(luminance.get(), m_resolution);
+            build_warp(luminance.get());
+            m_mean_luminance = mean_luminance(lum_sum);
         }
     }
 
@@ -260,12 +323,81 @@ public:
         oss << "EnvironmentMapEmitter[" << std::endl
             << "  filename = \"" << m_filename << "\"," << std::endl
             << "  resolution = \"" << m_resolution << "\"," << std::endl
+            << "  half_precision = " << (m_half ? "true" : "false") << "," << std::endl
+            << "  sampling_downscale = " << m_sampling_downscale << "," << std::endl
             << "  bsphere = " << string::indent(m_bsphere) << std::endl
             << "]";
         return oss.str();
     }
 
 protected:
+    /**
+     * Build \ref m_warp from the luminance values weighted by \c sin_theta,
+     * at the resolution reduced by \ref m_sampling_downscale. Each vertex of
+     * the reduced grid averages the pixels within half a cell, so that the
+     * distribution never vanishes where the environment map emits light.
+     */
+    void build_warp(const ScalarFloat *luminance) {
+        uint32_t f = m_sampling_downscale;
+        if (f == 1) {
+            m_warp = Warp(luminance, m_resolution);
+            update_memory_record(hprod(m_resolution));
+            return;
+        }
+
+        ScalarVector2u res = max((m_resolution - 1u) / f + 1u, 2u);
+        std::unique_ptr<ScalarFloat[]> reduced(new ScalarFloat[hprod(res)]);
+
+        // Range of full resolution pixels around vertex 'i' of a grid with 'n' vertices
+        auto window = [f](uint32_t i, uint32_t n, uint32_t size) {
+            double c = i * double(size - 1) / double(n - 1);
+            int32_t lo = (int32_t) std::floor(c - .5 * f),
+                    hi = (int32_t) std::ceil(c + .5 * f);
+            return std::make_pair((uint32_t) std::max(lo, 0),
+                                  (uint32_t) std::min(hi, (int32_t) size - 1));
+        };
+
+        tbb::parallel_for(
+            tbb::blocked_range<uint32_t>(0, res.y()),
+            [&](const tbb::blocked_range<uint32_t> &range) {
+                for (uint32_t y = range.begin(); y != range.end(); ++y) {
+                    auto [y0, y1] = window(y, res.y(), m_resolution.y());
+                    for (uint32_t x = 0; x < res.x(); ++x) {
+                        auto [x0, x1] = window(x, res.x(), m_resolution.x());
+                        double sum = 0.0;
+                        for (uint32_t yi = y0; yi <= y1; ++yi)
+                            for (uint32_t xi = x0; xi <= x1; ++xi)
+                                sum += (double) luminance[yi * m_resolution.x() + xi];
+                        reduced[y * res.x() + x] =
+                            ScalarFloat(sum / ((y1 - y0 + 1) * (x1 - x0 + 1)));
+                    }
+                }
+            }
+        );
+
+        m_warp = Warp(reduced.get(), res);
+        update_memory_record(hprod(res));
+    }
+
+    /**
+     * Account for the memory of the pixels and of the sampling distribution,
+     * whose hierarchy holds about 4/3 as many values as its finest level
+     * (\c warp_size values)
+     */
+    void update_memory_record(size_t warp_size) {
+        m_memory.set(slices(m_data) * sizeof(ScalarFloat) +
+                     slices(m_data_half) * sizeof(uint32_t) +
+                     warp_size * 4 / 3 * sizeof(ScalarFloat));
+    }
+
+    /**
+     * Average luminance over the sphere of directions, given the sum of the
+     * luminance values weighted by \c sin_theta over all pixels
+     */
+    ScalarFloat mean_luminance(double lum_sum) const {
+        return ScalarFloat(.5 * math::Pi<double> * lum_sum / (double) hprod(m_resolution));
+    }
+
     UnpolarizedSpectrum eval_spectrum(Point2f uv, const Wavelength &wavelengths, Mask active) const {
         uv *= Vector2f(m_resolution - 1u);
 
@@ -277,10 +409,10 @@ protected:
         const uint32_t width = m_resolution.x();
         UInt32 index = pos.x() + pos.y() * width;
 
-        Vector4f v00 = gather<Vector4f>(m_data, index, active),
-                 v10 = gather<Vector4f>(m_data, index + 1, active),
-                 v01 = gather<Vector4f>(m_data, index + width, active),
-                 v11 = gather<Vector4f>(m_data, index + width + 1, active);
+        Vector4f v00 = fetch(index, active),
+                 v10 = fetch(index + 1, active),
+                 v01 = fetch(index + width, active),
+                 v11 = fetch(index + width + 1, active);
 
         if constexpr (is_spectral_v<Spectrum>) {
             UnpolarizedSpectrum s00, s10, s01, s11, s0, s1, s;
@@ -318,15 +450,37 @@ protected:
         }
     }
 
+    /// Fetch the four stored values of the pixel with index \c index
+    MTS_INLINE Vector4f fetch(const UInt32 &index, Mask active) const {
+        if (!m_half)
+            return gather<Vector4f>(m_data, index, active);
+
+        using UInt32x2 = Array<UInt32, 2>;
+        UInt32x2 words = gather<UInt32x2>(m_data_half, index, active);
+        return Vector4f(Float(decode_half(words.x() & 0xFFFFu)),
+                        Float(decode_half(words.x() >> 16)),
+                        Float(decode_half(words.y() & 0xFFFFu)),
+                        Float(decode_half(words.y() >> 16)));
+    }
+
     MTS_DECLARE_CLASS()
 protected:
     std::string m_filename;
     ScalarBoundingSphere3f m_bsphere;
     DynamicBuffer<Float> m_data;
+    /// Pixels stored as pairs of half precision values (if \c half_precision is set)
+    DynamicBuffer<UInt32> m_data_half;
+    bool m_half;
     ScalarVector2u m_resolution;
+    /// Factor by which the resolution of \ref m_warp is reduced
+    uint32_t m_sampling_downscale;
     Warp m_warp;
     ref<Texture> m_d65;
     ScalarFloat m_scale;
+    /// Average luminance over the sphere of directions (see \ref power())
+    ScalarFloat m_mean_luminance;
+    /// Memory of the pixels and of the sampling distribution (see \ref MemoryCategory::Emitters)
+    MemoryRecord m_memory { MemoryCategory::Emitters };
 };
 
 MTS_IMPLEMENT_CLASS_VARIANT(EnvironmentMapEmitter, Emitter)
@@ -72,7 +72,13 @@ mapping. In contrast to the perspective camera, it takes an extra texture
 projects into the scene, with an optional scaling factor.
 
 Pixels are importance sampled according to their density, hence this
-operation remains efficient even if only a single pixel is turned on.
+operation remains efficient even if only a single pixel is turned on. The
+sampling distribution of a :ref:`bitmap <texture-bitmap>` texture is built
+upon first use and belongs to the texture, which is shared with all other
+projectors (and textures) that load the same image with the same settings.
+The total power of the projector accounts for the mean of the texture, hence
+scenes with many projectors can sample them according to their power (see the
+``emitter_sampler`` parameter of the scene).
 
 .. subfigstart::
 .. subfigure:: ../../resources/data/docs/images/render/emitter_projector_constant.jpg
@@ -101,6 +107,14 @@ public:
 
         m_sample_to_camera = m_camera_to_sample.inverse();
 
+        // Corners of the virtual image plane at z=1
+        ScalarPoint3f p0 = m_sample_to_camera * ScalarPoint3f(0.f, 0.f, 0.f),
+                      p1 = m_sample_to_camera * ScalarPoint3f(1.f, 1.f, 0.f);
+        p0 /= p0.z();
+        p1 /= p1.z();
+        m_plane_area = std::abs((p1.x() - p0.x()) * (p1.y() - p0.y()));
+        m_cos_corner = rcp(norm(ScalarVector3f(p0)));
+
         m_flags = +EmitterFlags::DeltaPosition;
     }
 
@@ -114,7 +128,6 @@ public:
         return 0.f;
     }
 
-    /// TODO: Completely untested, need to revist once the particle tracer is merged.
     std::pair<Ray3f, Spectrum> sample_ray(Float time, Float wavelength_sample,
                                           const Point2f & /* spatial_sample */,
                                           const Point2f & direction_sample,
@@ -125,14 +138,17 @@ public:
         auto [wavelengths, weight] =
             sample_wavelength<Float, Spectrum>(wavelength_sample);
 
-        // 2. Sample position on film
+        // 2. Sample position on film proportionally to the irradiance
         auto [uv, pdf] = m_irradiance->sample_position(direction_sample, active);
 
-        // 3. Query irradiance on film
+        /* 3. Query irradiance on film. The radiant intensity of sample_direction()
+           is pi times the irradiance at z=1 divided by cos^3 theta, which cancels
+           with the change of variables from the image plane to solid angles */
         SurfaceInteraction3f si = zero<SurfaceInteraction3f>();
         si.uv = uv;
         si.wavelengths = wavelengths;
-        weight *= m_irradiance->eval(si, active) * m_intensity->eval(si, active);
+        weight *= m_irradiance->eval(si, active) * m_intensity->eval(si, active) *
+                  (math::Pi<ScalarFloat> * m_plane_area);
 
         // 4. Compute the sample position on the near plane (local camera space).
         Point3f near_p = m_sample_to_camera * Point3f(uv.x(), uv.y(), 0.f);
@@ -193,9 +209,23 @@ public:
     }
 
     ScalarBoundingBox3f bbox() const override {
-        /* This emitter does not occupy any particular region
-           of space, return an invalid bounding box */
-        return ScalarBoundingBox3f();
+        // Bound the pinhole, so that the light BVH can cull the projector
+        return m_world_transform->translation_bounds();
+    }
+
+    ScalarFloat power() const override {
+        // Irradiance integrated over the virtual image plane (see \ref sample_ray())
+        return math::Pi<ScalarFloat> * m_plane_area * m_irradiance->mean() *
+               m_intensity->mean();
+    }
+
+    std::tuple<ScalarVector3f, ScalarFloat, ScalarFloat> emission_cone() const override {
+        // The direction of an animated projector is not bounded
+        if (m_world_transform->size() > 1)
+            return Base::emission_cone();
+        ScalarTransform4f trafo = m_world_transform->eval(0.f);
+        ScalarVector3f axis = normalize(trafo * ScalarVector3f(0.f, 0.f, 1.f));
+        return { axis, m_cos_corner, 1.f };
     }
 
     void traverse(TraversalCallback *callback) override {
@@ -220,6 +250,10 @@ protected:
     ScalarTransform4f m_camera_to_sample;
     ScalarTransform4f m_sample_to_camera;
     ScalarFloat m_x_fov;
+    /// Area of the virtual image plane at z=1
+    ScalarFloat m_plane_area;
+    /// Cosine of the angle between the axis and the corners of the image plane
+    ScalarFloat m_cos_corner;
 };
 
 MTS_IMPLEMENT_CLASS_VARIANT(Projector, Emitter)
@@ -1,3 +1,4 @@
+#include <mitsuba/core/distr_1d.h>
 #include <mitsuba/core/properties.h>
 #include <mitsuba/core/warp.h>
 #include <mitsuba/render/emitter.h>
@@ -52,6 +53,8 @@ using the lookat tag, e.g.:
 
 The intensity linearly ramps up from cutoff_angle to beam_width (both specified in degrees),
 after which it remains at the maximum value. A projection texture may optionally be supplied.
+The ramp is tabulated over the cosine of the angle when the emitter is created, so that its
+evaluation does not need an inverse cosine.
 
 .. subfigstart::
 .. subfigure:: ../../resources/data/docs/images/render/emitter_spot_no_texture.jpg
@@ -92,6 +95,21 @@ public:
         m_cos_beam_width = cos(m_beam_width);
         Assert(m_cutoff_angle >= m_beam_width);
         m_uv_factor = tan(m_cutoff_angle);
+
+        // Tabulate the ramp between the cutoff angle and the beam width
+        if (m_cutoff_angle > m_beam_width) {
+            std::vector<ScalarFloat> falloff(FalloffResolution);
+            for (size_t i = 0; i < FalloffResolution; ++i) {
+                ScalarFloat cos_theta =
+                    m_cos_cutoff_angle + (m_cos_beam_width - m_cos_cutoff_angle) * i /
+                                             (ScalarFloat) (FalloffResolution - 1);
+                falloff[i] = clamp((m_cutoff_angle - std::acos(cos_theta)) * m_inv_transition_width,
+                                   0.f, 1.f);
+            }
+            m_falloff = ContinuousDistribution<Float>(
+                ScalarVector2f(m_cos_cutoff_angle, m_cos_beam_width), falloff.data(),
+                FalloffResolution);
+        }
     }
 
     UnpolarizedSpectrum falloff_curve(const Vector3f &d, Wavelength wavelengths, Mask active) const {
@@ -108,10 +126,13 @@ public:
             result *= m_texture->eval(si, active);
         }
 
-        UnpolarizedSpectrum beam_res = select(cos_theta >= m_cos_beam_width, result,
-                               result * ((m_cutoff_angle - acos(cos_theta)) * m_inv_transition_width));
+        Mask beam = cos_theta >= m_cos_beam_width;
+        Float falloff = select(beam, 1.f, 0.f);
+        if (m_cutoff_angle > m_beam_width)
+            masked(falloff, !beam) = m_falloff.eval_pdf(cos_theta, active && !beam);
 
-        return select(cos_theta <= m_cos_cutoff_angle, UnpolarizedSpectrum(0.0f), beam_res);
+        return select(cos_theta <= m_cos_cutoff_angle, UnpolarizedSpectrum(0.0f),
+                      result * falloff);
     }
 
     std::pair<Ray3f, Spectrum> sample_ray(Float time, Float wavelength_sample,
@@ -171,6 +192,23 @@ public:
         return m_world_transform->translation_bounds();
     }
 
+    ScalarFloat power() const override {
+        // Power within the cutoff cone including the falloff, but ignoring the texture
+        ScalarFloat solid_angle = 1.f - m_cos_beam_width;
+        if (m_cutoff_angle > m_beam_width)
+            solid_angle += m_falloff.integral();
+        return 2.f * math::Pi<ScalarFloat> * solid_angle * m_intensity->mean();
+    }
+
+    std::tuple<ScalarVector3f, ScalarFloat, ScalarFloat> emission_cone() const override {
+        // The direction of an animated spot light is not bounded
+        if (m_world_transform->size() > 1)
+            return Base::emission_cone();
+        ScalarTransform4f trafo = m_world_transform->eval(0.f);
+        ScalarVector3f axis = normalize(trafo * ScalarVector3f(0.f, 0.f, 1.f));
+        return { axis, m_cos_beam_width, std::cos(m_cutoff_angle - m_beam_width) };
+    }
+
     void traverse(TraversalCallback *callback) override {
         callback->put_object("intensity", m_intensity.get());
         callback->put_object("texture", m_texture.get());
@@ -191,8 +229,13 @@ public:
 
     MTS_DECLARE_CLASS()
 private:
+    /// Number of entries of the table of the falloff ramp
+    static constexpr size_t FalloffResolution = 1024;
+
     ref<Texture> m_intensity;
     ref<Texture> m_texture;
+    /// Falloff ramp as a function of the cosine between the beam width and the cutoff angle
+    ContinuousDistribution<Float> m_falloff;
     ScalarFloat m_beam_width, m_cutoff_angle, m_uv_factor;
     ScalarFloat m_cos_beam_width, m_cos_cutoff_angle, m_inv_transition_width;
 };
@@ -0,0 +1,59 @@
+import mitsuba
+import pytest
+import enoki as ek
+
+
+def create_projector(fov=60, scale=1.5, value=2.0):
+    from mitsuba.core.xml import load_dict
+    return load_dict({
+        'type' : 'projector',
+        'fov' : fov,
+        'scale' : scale,
+        'irradiance' : { 'type' : 'uniform', 'value' : value }
+    })
+
+
+@pytest.mark.parametrize("fov", [30, 60])
+def test01_power(variant_scalar_rgb, fov):
+    """The power is the irradiance integrated over the image plane at z=1"""
+    emitter = create_projector(fov=fov)
+    area = (2 * ek.tan(fov / 360 * ek.pi)) ** 2
+    assert ek.allclose(emitter.power(), ek.pi * area * 1.5 * 2.0)
+
+
+@pytest.mark.parametrize("sample", [[0.5, 0.5], [0.1, 0.8], [0.95, 0.2]])
+def test02_sample_ray_consistent(variant_scalar_rgb, sample):
+    """The weight of sample_ray() matches the radiant intensity seen by
+    sample_direction() divided by the density of the ray direction"""
+    from mitsuba.render import SurfaceInteraction3f
+
+    fov = 60
+    emitter = create_projector(fov=fov)
+    area = (2 * ek.tan(fov / 360 * ek.pi)) ** 2
+
+    ray, weight = emitter.sample_ray(0, 0.5, [0.5, 0.5], sample)
+    assert ek.allclose(ray.o, [0, 0, 0])
+    assert ray.d.z > 0
+
+    it = SurfaceInteraction3f.zero()
+    it.p = ray(3.0)
+    ds, spec = emitter.sample_direction(it, [0, 0])
+    assert ds.delta
+    assert ek.allclose(ds.d, -ray.d)
+
+    # The uniform irradiance is sampled uniformly over the image plane
+    pdf = 1 / (area * ray.d.z ** 3)
+    assert ek.allclose(weight, spec * 9.0 / pdf, rtol=1e-4)
+
+    # The mean weight of the rays is the power
+    assert ek.allclose(weight, emitter.power(), rtol=1e-4)
+
+
+def test03_emission_cone(variant_scalar_rgb):
+    """The emission cone contains the directions towards the corners of the image"""
+    emitter = create_projector(fov=90)
+    axis, cos_theta_o, cos_theta_e = emitter.emission_cone()
+    assert ek.allclose(axis, [0, 0, 1])
+    assert ek.allclose(cos_theta_o, 1 / ek.sqrt(3))
+    assert cos_theta_e == 1
+    assert emitter.bbox().valid()
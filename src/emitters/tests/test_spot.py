@@ -157,3 +157,21 @@ def test_eval(variant_packet_spectral, spectrum_key, lookat, cutoff_angle):
     it = SurfaceInteraction3f.zero(3)
     it.wi = [0, 1, 0]
     assert ek.allclose(emitter.eval(it), 0.)
+
+
+@pytest.mark.parametrize("cutoff_angle", [20, 80])
+def test_power(variant_scalar_rgb, cutoff_angle):
+    # The power integrates the falloff over the cutoff cone
+    emitter, _ = create_emitter_and_spectrum(lookat_transforms[0], cutoff_angle)
+
+    cutoff_angle_rad = cutoff_angle / 180 * ek.pi
+    beam_width_rad = cutoff_angle_rad * 0.75
+    steps = 10000
+    integral = 0
+    for i in range(steps):
+        theta = beam_width_rad + (i + 0.5) / steps * (cutoff_angle_rad - beam_width_rad)
+        falloff = (cutoff_angle_rad - theta) / (cutoff_angle_rad - beam_width_rad)
+        integral += falloff * ek.sin(theta) * (cutoff_angle_rad - beam_width_rad) / steps
+
+    power = 2 * ek.pi * (1 - ek.cos(beam_width_rad) + integral)
+    assert ek.allclose(emitter.power(), power, rtol=1e-4)
@@ -1,13 +1,21 @@
 #include <mitsuba/core/bitmap.h>
 #include <mitsuba/core/filesystem.h>
 #include <mitsuba/core/fstream.h>
+#include <mitsuba/core/stream.h>
 #include <mitsuba/core/spectrum.h>
 #include <mitsuba/core/string.h>
+#include <mitsuba/render/denoiser.h>
 #include <mitsuba/render/film.h>
 #include <mitsuba/render/fwd.h>
 #include <mitsuba/render/imageblock.h>
 
+#include <atomic>
+#include <cstring>
+#include <map>
 #include <mutex>
+#include <tbb/blocked_range.h>
+#include <tbb/enumerable_thread_specific.h>
+#include <tbb/parallel_for.h>
 
 NAMESPACE_BEGIN(mitsuba)
 
@@ -47,6 +55,80 @@ High dynamic range film (:monosp:`hdrfilm`)
    - If set to |true|, regions slightly outside of the film plane will also be sampled. This may
      improve the image quality at the edges, especially when using very large reconstruction
      filters. In general, this is not needed though. (Default: |false|, i.e. disabled)
+ * - accumulation
+   - |string|
+   - Specifies how image blocks are merged into the film. With :monosp:`locked`, every block is
+     accumulated into a single buffer protected by a mutex. With :monosp:`thread_local`, each
+     rendering thread accumulates into a private buffer the size of the crop window, and these
+     buffers are reduced in parallel when the film is developed. This removes the lock at the
+     cost of memory. With :monosp:`deterministic`, blocks are merged into the locked buffer in
+     the order in which the integrator issued them. Blocks that complete early are held back
+     until their predecessors have been merged, so that the contributions to every pixel
+     (including those of neighboring blocks through the filter border) are always summed in
+     the same order, and the result is bitwise identical for any number of threads (as long
+     as the integrator's :monosp:`block_size` is specified, since the automatic block size
+     shrinks when there are more threads than blocks). (Default: :monosp:`locked`)
+ * - accumulation_memory
+   - |int|
+   - Maximum amount of memory (in MiB) used by the per-thread buffers of the :monosp:`thread_local`
+     accumulation mode. Threads that would exceed this budget fall back to the locked path.
+     (Default: 1024)
+ * - exr_tile_size
+   - |int|
+   - Write tiled OpenEXR files with square tiles of the given size instead of scanline-based
+     ones, which lets viewers load parts of very large images. (Default: 0, i.e. scanlines)
+ * - exr_multi_part
+   - |bool|
+   - Write multi-part OpenEXR files with one part per layer of the image (e.g. each AOV), so
+     that readers can load a layer without decompressing the others. (Default: |false|)
+ * - async_write
+   - |bool|
+   - Let :code:`develop()` return as soon as the image is developed, while it is written to
+     disk on a background thread. This lets the next frame of a batch start rendering during
+     the write. The application waits for the pending writes before exiting, and they can be
+     awaited explicitly using :code:`Bitmap::wait_async_writes()`. (Default: |false|)
+ * - variance
+   - |bool|
+   - Add a :monosp:`variance` channel storing the estimated variance of the luminance of every
+     pixel, e.g. to stop rendering once a target noise level is reached. See below for
+     details. (Default: |false|)
+ * - variance_type
+   - |string|
+   - Quantity whose variance is developed: :monosp:`luminance` (a single :monosp:`variance`
+     channel) or :monosp:`rgb` (the channels :monosp:`variance.R`, :monosp:`variance.G` and
+     :monosp:`variance.B`). (Default: :monosp:`luminance`)
+ * - band_count
+   - |int|
+   - Spectral variants: number of wavelength bands recorded in separate channels
+     :monosp:`band_0`, :monosp:`band_1`, etc. See below for details. (Default: 0)
+ * - band_min, band_max
+   - |float|
+   - Spectral variants: wavelength range (in nanometers) split into bands of equal width.
+     (Default: 360 and 830)
+ * - streaming
+   - |bool|
+   - Write the image to a tiled OpenEXR file while it is being rendered instead of keeping
+     all of it in memory. See below for details. (Default: |false|)
+ * - aov_precision
+   - |string|
+   - Precision of the accumulated AOV channels, i.e. of all channels except the image itself:
+     :monosp:`float32` or :monosp:`float16`. See below for details. (Default: :monosp:`float32`)
+ * - denoise
+   - |bool|
+   - Denoise the image before writing it to disk. See below for details. (Default: |false|)
+ * - denoise_backend
+   - |string|
+   - Denoising algorithm: :monosp:`oidn` (Intel Open Image Denoise, if Mitsuba was compiled
+     with :monosp:`MTS_ENABLE_OIDN`), :monosp:`builtin` (an edge-avoiding à-trous wavelet
+     filter), or :monosp:`auto` (the former when available). (Default: :monosp:`auto`)
+ * - denoise_strength
+   - |float|
+   - Scale factor of the tolerance of the built-in filter towards color differences. Higher
+     values remove more noise, but blur features that the guides do not capture. (Default: 1)
+ * - denoise_albedo, denoise_normal
+   - |string|
+   - Names of the AOVs used as albedo and shading normal guides of the denoiser.
+     (Default: :monosp:`albedo` and :monosp:`normal`)
  * - (Nested plugin)
    - :paramtype:`rfilter`
    - Reconstruction filter that should be used by the film. (Default: :monosp:`gaussian`, a windowed
@@ -79,6 +161,76 @@ When RGB(A) output is selected, the measured spectral power distributions are
 converted to linear RGB based on the CIE 1931 XYZ color matching curves and
 the ITU-R Rec. BT.709-3 primaries with a D65 white point.
 
+When :monosp:`streaming` is enabled, the film only keeps a window of the rows that may still
+receive contributions in memory. The integrator hands out the image blocks in scanline order, and
+every row of tiles is written to the (tiled) OpenEXR output as soon as all blocks overlapping
+it, including their filter border, have been merged. The memory usage thus only depends on the
+width of the image and on the number of rendering threads, which makes it possible to render
+images that would not fit into memory otherwise. This mode requires OpenEXR output with locked
+accumulation and a single pass over the image (the :monosp:`samples_per_pass`, adaptive sampling
+and checkpointing features of the integrator are disabled), the image is written using tiles of
+size :monosp:`exr_tile_size` (64 by default), and it is not available in GPU variants.
+
+The memory usage of the film is dominated by the AOV channels when the integrator produces many
+of them. With :monosp:`aov_precision=float16`, these channels are stored with half precision,
+which halves their memory usage, while the image and its weights remain in single precision.
+Rather than their sums, the film stores the weighted means of the AOV values, which it updates
+from the single precision weights whenever a block is merged. The stored values thus remain in
+the range of the half precision format for any number of samples, and every merge only incurs a
+relative rounding error of about :math:`2^{-11}`. The AOVs are converted back to single precision
+in strips of rows when the film is developed. This mode is not available in GPU variants, and
+it uses locked accumulation and single precision in streaming mode.
+
+When :monosp:`denoise` is enabled, the developed image is denoised before it is written to disk,
+which avoids exporting the noisy image and its features for an external denoiser. The denoiser
+uses the albedo and shading normal of the visible surfaces as guides when the film records them,
+i.e. when it receives the :monosp:`albedo` and :monosp:`sh_normal` outputs of the
+:ref:`aov <integrator-aov>` integrator under the names given by :monosp:`denoise_albedo` and
+:monosp:`denoise_normal`. The built-in filter follows the
+edge-avoiding à-trous wavelet transform of Dammertz et al. :cite:`Dammertz2010Edge`. Only the main
+image (its RGB or luminance channels, the XYZ pixel formats are not supported) is denoised, the AOVs are written unchanged. The denoising step runs on the CPU in all variants, and
+its result can also be retrieved while rendering (e.g. after every pass of a progressive render)
+using :code:`Film::denoised_bitmap()`. Denoising is not available in streaming mode.
+
+.. code-block:: xml
+
+    <integrator type="aov">
+        <string name="aovs" value="albedo:albedo,normal:sh_normal"/>
+        <integrator type="path" name="image"/>
+    </integrator>
+
+    <film type="hdrfilm">
+        <boolean name="denoise" value="true"/>
+    </film>
+
+When :monosp:`variance` is enabled, the sampling integrators additionally accumulate the
+squared luminance of their samples, and the film computes the variance of the luminance
+estimate of every pixel from these second moments when it is developed. As the samples are
+weighted by the reconstruction filter, the variance is divided by the effective number of
+samples of the pixel, which is derived from its total weight and the shape of the filter.
+The resulting :monosp:`variance` channel can be compared to the squared luminance to obtain
+the relative error of the pixels. With :monosp:`filter_importance_sampling` (see
+:ref:`path <integrator-path>`), the estimate is conservative. Setting :monosp:`variance_type`
+to :monosp:`rgb` develops the variance of each color channel of the image instead, which
+replaces the second moments of the :ref:`moment <integrator-moment>` integrator without
+evaluating the integrator again or storing the moments as separate images.
+
+In spectral variants, the film can additionally record the radiance of :monosp:`band_count`
+wavelength bands, e.g. the spectral bands of a satellite instrument, in a single render.
+Each band accumulates the spectral samples of the pixels whose wavelength falls into it,
+and the developed channel contains the radiance averaged over the wavelengths of the band.
+As the wavelengths are importance sampled for the visible range, bands near the limits of
+the range receive fewer samples and are noisier.
+
+Besides image blocks, the film accepts individual contributions at arbitrary positions
+(:code:`Film::splat()`), as produced by light and particle tracing algorithms. These splats
+may be added concurrently by all rendering threads: CPU variants accumulate them into sparse
+per-thread buffers made of :math:`32\times 32` pixel tiles that are allocated on demand, and
+GPU variants into a single buffer using atomic additions. The buffers are summed when the
+film is developed, and the result is added to the normalized image (pixels that did not
+receive any image block only contain the splats). Splats are not supported in
+:monosp:`streaming` mode and are not included in the saved film state.
+
 The following XML snippet discribes a film that writes a full-HD RGBA OpenEXR file:
 
 .. code-block:: xml
@@ -180,6 +332,143 @@ public:
             }
         }
 
+        std::string accumulation = string::to_lower(
+            props.string("accumulation", "locked"));
+        m_thread_local = m_deterministic = false;
+        if (accumulation == "thread_local")
+            m_thread_local = true;
+        else if (accumulation == "deterministic")
+            m_deterministic = true;
+        else if (accumulation != "locked")
+            Throw("The \"accumulation\" parameter must either be equal to "
+                  "\"locked\", \"thread_local\" or \"deterministic\", found %s "
+                  "instead.", accumulation);
+
+        if constexpr (is_cuda_array_v<Float>) {
+            if (m_thread_local || m_deterministic)
+                Log(Warn, "Only locked accumulation is supported by GPU "
+                          "variants, using the locked path.");
+            m_thread_local = m_deterministic = false;
+        }
+
+        m_accumulation_memory = props.size_("accumulation_memory", 1024) * 1024 * 1024;
+
+        m_exr_tile_size = (uint32_t) props.size_("exr_tile_size", 0);
+        m_exr_multi_part = props.bool_("exr_multi_part", false);
+
+        /// Return from develop() while the image is written to disk on a background thread
+        m_async_write = props.bool_("async_write", false);
+
+        /// Output the variance of the pixel estimates (computed from a squared luminance channel)
+        m_variance = props.bool_("variance", false);
+        std::string variance_type = string::to_lower(props.string("variance_type", "luminance"));
+        if (variance_type == "luminance")
+            m_color_variance = false;
+        else if (variance_type == "rgb")
+            m_color_variance = true;
+        else
+            Throw("The \"variance_type\" parameter must either be equal to "
+                  "\"luminance\" or \"rgb\", found %s instead.", variance_type);
+
+        /* Samples are weighted by the filter: the effective sample count of a
+           pixel is its weight times (int f)^2 / (int f^2) of the 2D filter */
+        ScalarFloat radius = m_filter->radius(), sum = 0.f, sum_sqr = 0.f;
+        for (int i = 0; i < 1024; ++i) {
+            ScalarFloat value = m_filter->eval_discretized(radius * ((i + .5f) / 512.f - 1.f));
+            sum += value;
+            sum_sqr += value * value;
+        }
+        m_effective_sample_factor = sum_sqr > 0.f ? sqr(sum / sum_sqr) : 1.f;
+
+        /// Record wavelength bands of equal width in separate channels (spectral variants)
+        m_band_count = props.size_("band_count", 0);
+        m_band_range = ScalarVector2f(props.float_("band_min", MTS_WAVELENGTH_MIN),
+                                      props.float_("band_max", MTS_WAVELENGTH_MAX));
+        if (m_band_count > 0) {
+            if constexpr (!is_spectral_v<Spectrum>)
+                Throw("Wavelength bands can only be recorded by spectral variants!");
+            if (!(m_band_range.x() >= MTS_WAVELENGTH_MIN &&
+                  m_band_range.y() <= MTS_WAVELENGTH_MAX &&
+                  m_band_range.x() < m_band_range.y()))
+                Throw("The wavelength bands must cover a non-empty range within "
+                      "[%.0f, %.0f] nm!", MTS_WAVELENGTH_MIN, MTS_WAVELENGTH_MAX);
+        }
+
+        m_streaming = props.bool_("streaming", false);
+        if constexpr (is_cuda_array_v<Float>) {
+            if (m_streaming)
+                Log(Warn, "Streaming output is not supported by GPU variants, ignoring.");
+            m_streaming = false;
+        }
+
+        if (m_streaming) {
+            if (m_file_format != Bitmap::FileFormat::OpenEXR)
+                Throw("Streaming output requires file_format=\"openexr\"!");
+            if (m_thread_local || m_deterministic)
+                Log(Warn, "Streaming output only supports locked accumulation, "
+                          "using the locked path.");
+            if (m_exr_multi_part)
+                Log(Warn, "Streaming output does not support multi-part OpenEXR "
+                          "files, ignoring \"exr_multi_part\".");
+            m_thread_local = m_deterministic = m_exr_multi_part = false;
+            if (m_exr_tile_size == 0)
+                m_exr_tile_size = 64;
+        }
+
+        std::string aov_precision = string::to_lower(
+            props.string("aov_precision", "float32"));
+        if (aov_precision == "float16")
+            m_half_aovs = true;
+        else if (aov_precision == "float32")
+            m_half_aovs = false;
+        else
+            Throw("The \"aov_precision\" parameter must either be equal to "
+                  "\"float32\" or \"float16\", found %s instead.", aov_precision);
+
+        if constexpr (is_cuda_array_v<Float>) {
+            if (m_half_aovs)
+                Log(Warn, "Half precision AOVs are not supported by GPU variants, "
+                          "using single precision.");
+            m_half_aovs = false;
+        }
+
+        if (m_half_aovs && m_streaming) {
+            Log(Warn, "Half precision AOVs are not supported in streaming mode, "
+                      "using single precision.");
+            m_half_aovs = false;
+        } else if (m_half_aovs && m_thread_local) {
+            Log(Warn, "Half precision AOVs only support locked or deterministic "
+                      "accumulation, using the locked path.");
+            m_thread_local = false;
+        }
+
+        m_denoise = props.bool_("denoise", false);
+        std::string denoise_backend = string::to_lower(
+            props.string("denoise_backend", "auto"));
+        Denoiser::Backend backend;
+        if (denoise_backend == "auto")
+            backend = Denoiser::Backend::Auto;
+        else if (denoise_backend == "builtin")
+            backend = Denoiser::Backend::Builtin;
+        else if (denoise_backend == "oidn")
+            backend = Denoiser::Backend::OIDN;
+        else
+            Throw("The \"denoise_backend\" parameter must either be equal to "
+                  "\"auto\", \"builtin\" or \"oidn\", found %s instead.",
+                  denoise_backend);
+        m_denoiser = new Denoiser(backend, props.float_("denoise_strength", 1.f));
+        m_denoise_albedo = props.string("denoise_albedo", "albedo");
+        m_denoise_normal = props.string("denoise_normal", "normal");
+
+        if (m_denoise && m_streaming)
+            Throw("Denoising is not supported in streaming mode!");
+        if (m_denoise && m_pixel_format != Bitmap::PixelFormat::Y &&
+            m_pixel_format != Bitmap::PixelFormat::YA &&
+            m_pixel_format != Bitmap::PixelFormat::RGB &&
+            m_pixel_format != Bitmap::PixelFormat::RGBA)
+            Throw("Denoising requires the \"luminance\", \"luminance_alpha\", \"rgb\" "
+                  "or \"rgba\" pixel format!");
+
         props.mark_queried("banner"); // no banner in Mitsuba 2
     }
 
@@ -198,16 +487,193 @@ public:
                 Throw("Film::prepare(): duplicate channel name \"%s\"", channels[i]);
         }
 
-        m_storage = new ImageBlock(m_crop_size, channels.size());
+        // In streaming mode, the storage is a window over the first rows of the image
+        ScalarVector2i storage_size = m_crop_size;
+        if (m_streaming)
+            storage_size.y() = std::min(storage_size.y(), 2 * (int) m_exr_tile_size);
+
+        // In half precision mode, the storage only holds the image and its weights
+        m_aov_storage.clear();
+        size_t storage_channels = channels.size();
+        if (m_half_aovs && channels.size() > 5) {
+            storage_channels = 5;
+            m_aov_storage.resize(hprod(storage_size) * (channels.size() - 5), 0);
+        }
+
+        m_storage = new ImageBlock(storage_size, storage_channels);
         m_storage->set_offset(m_crop_offset);
         m_storage->clear();
         m_channels = channels;
+
+        const char *variance_name = m_color_variance ? "variance.R" : "variance";
+        auto it = std::find(channels.begin(), channels.end(), variance_name);
+        m_variance_channel = it != channels.end() ? (uint32_t) (it - channels.begin()) : 0;
+        if (m_variance && m_variance_channel == 0)
+            Log(Warn, "HDRFilm: the integrator did not provide a \"%s\" channel, "
+                      "the variance will not be developed.", variance_name);
+
+        m_local_storage.clear();
+        m_reduced = nullptr;
+        m_local_count = 0;
+
+        m_splat_storage.clear();
+        m_splat_block = nullptr;
+        m_splatted = false;
+        if constexpr (is_cuda_array_v<Float>) {
+            m_splat_block = new ImageBlock(m_crop_size, 3, m_filter, false, false, false, true);
+            m_splat_block->set_offset(m_crop_offset);
+            m_splat_block->clear();
+        }
+
+        m_pending.clear();
+        m_next_index = 0;
+
+        m_snapshot_tiles = (m_crop_size + SnapshotTileSize - 1) / SnapshotTileSize;
+        m_snapshot_dirty.reset(new std::atomic<bool>[hprod(m_snapshot_tiles)]);
+        for (int i = 0; i < hprod(m_snapshot_tiles); ++i)
+            m_snapshot_dirty[i] = false;
+        m_snapshot_all = false;
+        m_snapshot_splats = false;
+
+        m_writer = nullptr;
+        m_bands.clear();
+        m_window_y = m_next_band_y = 0;
+        m_late_block = false;
+
+        if (m_denoise) {
+            for (const std::string &name : { m_denoise_albedo + ".R", m_denoise_normal + ".X" }) {
+                if (std::find(channels.begin(), channels.end(), name) == channels.end())
+                    Log(Warn, "HDRFilm: the film has no \"%s\" channel, denoising without this "
+                              "guide (see the \"albedo\" and \"sh_normal\" AOVs of the aov "
+                              "integrator).", name);
+            }
+        }
     }
 
     void put(const ImageBlock *block) override {
+        Assert(m_storage != nullptr);
+
+        if (m_streaming) {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            put_streaming(block);
+            return;
+        }
+
+        if (m_thread_local) {
+            LocalStorage &local = m_local_storage.local();
+
+            if (unlikely(!local.block && !local.rejected)) {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                // One extra buffer is needed for the reduction
+                size_t bytes = m_crop_size.x() * (size_t) m_crop_size.y() *
+                               m_channels.size() * sizeof(ScalarFloat);
+                if ((m_local_count + 2) * bytes <= m_accumulation_memory) {
+                    local.block = new ImageBlock(m_crop_size, m_channels.size());
+                    local.block->set_offset(m_crop_offset);
+                    local.block->clear();
+                    m_local_count++;
+                } else {
+                    Log(Debug, "Per-thread accumulation memory budget exceeded, "
+                               "falling back to locked accumulation.");
+                    local.rejected = true;
+                }
+            }
+
+            if (likely(local.block)) {
+                local.block->put(block);
+                mark_dirty(block);
+                return;
+            }
+        }
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        merge(block);
+    }
+
+    void put(const ImageBlock *block, size_t index) override {
+        if (!m_deterministic) {
+            put(block);
+            return;
+        }
+
         Assert(m_storage != nullptr);
         std::lock_guard<std::mutex> lock(m_mutex);
-        m_storage->put(block);
+
+        if (index != m_next_index) {
+            // Hold back a copy until all preceding blocks have been merged
+            ref<ImageBlock> copy;
+            if (!m_spare.empty()) {
+                copy = m_spare.back();
+                m_spare.pop_back();
+                copy->set_size(block->size());
+            } else {
+                copy = new ImageBlock(block->size(), block->channel_count(),
+                                      m_filter.get(), false, false,
+                                      block->border_size() > 0);
+            }
+            Assert(copy->border_size() == block->border_size());
+            copy->set_offset(block->offset());
+            std::memcpy(copy->data().data(), block->data().data(),
+                        block->data().size() * sizeof(ScalarFloat));
+            m_pending.emplace(index, std::move(copy));
+            return;
+        }
+
+        merge(block);
+        m_next_index++;
+        merge_pending(false);
+    }
+
+    void splat(const Point2f &pos, const Spectrum &value, const Wavelength &wavelengths,
+               Mask active) override {
+        Assert(m_storage != nullptr);
+        if (m_streaming)
+            Throw("HDRFilm::splat(): not supported in streaming mode!");
+
+        // Splats may land anywhere, the next snapshot develops the whole film
+        if (!m_snapshot_all.load(std::memory_order_relaxed))
+            m_snapshot_all = true;
+
+        UnpolarizedSpectrum value_u = depolarize(value);
+        Color3f xyz;
+        if constexpr (is_monochromatic_v<Spectrum>) {
+            ENOKI_MARK_USED(wavelengths);
+            xyz = value_u.x();
+        } else if constexpr (is_rgb_v<Spectrum>) {
+            ENOKI_MARK_USED(wavelengths);
+            xyz = srgb_to_xyz(value_u, active);
+        } else {
+            static_assert(is_spectral_v<Spectrum>);
+            xyz = spectrum_to_xyz(value_u, wavelengths, active);
+        }
+
+        if constexpr (is_cuda_array_v<Float>) {
+            // The image block accumulates using atomic scatter-adds
+            Float values[3] = { xyz.x(), xyz.y(), xyz.z() };
+            m_splat_block->put(pos, values, active);
+            m_splatted = true;
+        } else {
+            SplatStorage &local = m_splat_storage.local();
+            if (unlikely(local.tiles.empty())) {
+                ScalarVector2i tile_count = (m_crop_size + SplatTileSize - 1) / SplatTileSize;
+                local.tiles.resize(hprod(tile_count));
+                local.weights.resize(2 * ((size_t) std::ceil(2 * m_filter->radius()) + 1));
+            }
+
+            if constexpr (!is_array_v<Float>) {
+                if (active)
+                    splat_sample(local, pos, xyz.data());
+            } else {
+                for (size_t i = 0; i < Float::Size; ++i) {
+                    if (!active.coeff(i))
+                        continue;
+                    ScalarFloat value_i[3] = { xyz.x().coeff(i), xyz.y().coeff(i),
+                                               xyz.z().coeff(i) };
+                    splat_sample(local, ScalarPoint2f(pos.x().coeff(i), pos.y().coeff(i)),
+                                 value_i);
+                }
+            }
+        }
     }
 
     bool develop(const ScalarPoint2i  &source_offset,
@@ -249,15 +715,392 @@ public:
     }
 
     ref<Bitmap> bitmap(bool raw = false) override {
+        if (m_streaming)
+            Throw("HDRFilm::bitmap(): the image is not available in streaming mode, "
+                  "it is written to disk while rendering!");
+
+        return develop_storage(raw, m_component_format);
+    }
+
+    ref<Bitmap> denoised_bitmap() override {
+        if (m_streaming)
+            Throw("HDRFilm::denoised_bitmap(): the image is not available in streaming mode, "
+                  "it is written to disk while rendering!");
+
+        ref<Bitmap> image = develop_storage(false, Struct::Type::Float32);
+
+        /* The developed image uses the multi-channel pixel format when AOVs are
+           present, hence the color channels are derived from the film's format */
+        size_t color_count;
+        switch (m_pixel_format) {
+            case Bitmap::PixelFormat::Y:
+            case Bitmap::PixelFormat::YA:
+                color_count = 1;
+                break;
+
+            case Bitmap::PixelFormat::RGB:
+            case Bitmap::PixelFormat::RGBA:
+                color_count = 3;
+                break;
+
+            default:
+                Throw("HDRFilm::denoised_bitmap(): denoising requires the \"luminance\", "
+                      "\"luminance_alpha\", \"rgb\" or \"rgba\" pixel format, found %s!",
+                      m_pixel_format);
+        }
+
+        const Struct *struct_ = image->struct_();
+        size_t channel_count = image->channel_count();
+
+        // Copy the given channels of the image into a new bitmap
+        auto extract = [&](Bitmap::PixelFormat pixel_format, const size_t *indices) -> ref<Bitmap> {
+            ref<Bitmap> result = new Bitmap(pixel_format, Struct::Type::Float32, image->size());
+            size_t count = result->channel_count();
+            const float *source = (const float *) image->data();
+            float *target = (float *) result->data();
+            tbb::parallel_for(
+                tbb::blocked_range<size_t>(0, image->pixel_count(), 4096),
+                [&](const tbb::blocked_range<size_t> &range) {
+                    for (size_t i = range.begin(); i != range.end(); ++i)
+                        for (size_t k = 0; k < count; ++k)
+                            target[i * count + k] = source[i * channel_count + indices[k]];
+                }
+            );
+            return result;
+        };
+
+        // Copy the channels "<name>.<suffix>" of the image into a new RGB bitmap
+        auto guide = [&](const std::string &name, const char *suffixes) -> ref<Bitmap> {
+            size_t indices[3];
+            for (size_t k = 0; k < 3; ++k) {
+                std::string field = name + "." + suffixes[k];
+                if (!struct_->has_field(field))
+                    return nullptr;
+                indices[k] = struct_->offset(field) / sizeof(float);
+            }
+            return extract(Bitmap::PixelFormat::RGB, indices);
+        };
+
+        const size_t color_indices[3] = { 0, 1, 2 };
+        ref<Bitmap> color = extract(color_count == 1 ? Bitmap::PixelFormat::Y
+                                                     : Bitmap::PixelFormat::RGB, color_indices),
+                    albedo = guide(m_denoise_albedo, "RGB"),
+                    normal = guide(m_denoise_normal, "XYZ");
+        ref<Bitmap> denoised = m_denoiser->denoise(color, albedo, normal);
+
+        // Replace the color channels by their denoised values
+        const float *source = (const float *) denoised->data();
+        float *target = (float *) image->data();
+        tbb::parallel_for(
+            tbb::blocked_range<size_t>(0, image->pixel_count(), 4096),
+            [&](const tbb::blocked_range<size_t> &range) {
+                for (size_t i = range.begin(); i != range.end(); ++i)
+                    for (size_t k = 0; k < color_count; ++k)
+                        target[i * channel_count + k] = source[i * color_count + k];
+            }
+        );
+
+        if (m_component_format == Struct::Type::Float32)
+            return image;
+
+        ref<Bitmap> result = new Bitmap(image->pixel_format(), m_component_format,
+                                        image->size(), channel_count);
+        for (size_t i = 0; i < channel_count; ++i)
+            result->struct_()->operator[](i).name = struct_->operator[](i).name;
+        image->convert(result);
+        return result;
+    }
+
+    std::vector<std::pair<ScalarPoint2i, ref<Bitmap>>> snapshot() override {
+        Assert(m_storage != nullptr);
+        if (m_streaming)
+            Throw("HDRFilm::snapshot(): the image is not available in streaming mode, "
+                  "it is written to disk while rendering!");
+
         if constexpr (is_cuda_array_v<Float>) {
             cuda_eval();
             cuda_sync();
         }
 
+        // Collect and reset the flags of the tiles that changed since the last call
+        bool all = m_snapshot_all.exchange(false);
+        std::vector<ScalarPoint2i> offsets;
+        for (int y = 0; y < m_snapshot_tiles.y(); ++y) {
+            for (int x = 0; x < m_snapshot_tiles.x(); ++x) {
+                if (m_snapshot_dirty[y * m_snapshot_tiles.x() + x].exchange(false) || all)
+                    offsets.emplace_back(x * SnapshotTileSize, y * SnapshotTileSize);
+            }
+        }
+
+        std::vector<std::pair<ScalarPoint2i, ref<Bitmap>>> result(offsets.size());
+        if (offsets.empty())
+            return result;
+
+        /* New splats always flag the whole film, the splats merged by an
+           earlier call are otherwise still up to date. Held back blocks of the
+           deterministic mode are not merged to preserve their order. */
+        if (all)
+            m_snapshot_splats = merge_splats();
+
+        // Sum the shared storage and the per-thread buffers tile by tile
+        std::vector<const ImageBlock *> sources;
+        /* scope */ {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            sources.push_back(m_storage.get());
+            for (const LocalStorage &local : m_local_storage) {
+                if (local.block)
+                    sources.push_back(local.block.get());
+            }
+        }
+
+        auto encode = [](ScalarFloat value) -> uint8_t {
+            value = clamp(value, (ScalarFloat) 0.f, (ScalarFloat) 1.f);
+            value = value <= 0.0031308f ? 12.92f * value
+                                        : 1.055f * std::pow(value, 1.f / 2.4f) - 0.055f;
+            return (uint8_t) (value * 255.f + .5f);
+        };
+
+        tbb::parallel_for(
+            tbb::blocked_range<size_t>(0, offsets.size()),
+            [&](const tbb::blocked_range<size_t> &range) {
+                for (size_t t = range.begin(); t != range.end(); ++t) {
+                    ScalarPoint2i offset = offsets[t];
+                    ScalarVector2i size =
+                        min(offset + SnapshotTileSize, ScalarPoint2i(m_crop_size)) - offset;
+                    ref<Bitmap> tile = new Bitmap(Bitmap::PixelFormat::RGBA,
+                                                  Struct::Type::UInt8, size);
+                    tile->set_srgb_gamma(true);
+                    uint8_t *target = tile->uint8_data();
+
+                    for (int y = 0; y < size.y(); ++y) {
+                        for (int x = 0; x < size.x(); ++x) {
+                            size_t index = (size_t) (offset.y() + y) * m_crop_size.x() +
+                                           offset.x() + x;
+
+                            ScalarFloat value[5] = { 0.f, 0.f, 0.f, 0.f, 0.f };
+                            for (const ImageBlock *source : sources) {
+                                const ScalarFloat *data =
+                                    (const ScalarFloat *) source->data().managed().data() +
+                                    index * source->channel_count();
+                                for (size_t k = 0; k < 5; ++k)
+                                    value[k] += data[k];
+                            }
+
+                            // Same normalization as finalize() and convert()
+                            ScalarFloat inv_weight = value[4] > 0.f ? 1.f / value[4] : 0.f;
+                            ScalarColor3f xyz(value[0], value[1], value[2]);
+                            xyz *= inv_weight;
+                            if (m_snapshot_splats)
+                                xyz += ScalarColor3f::load_unaligned(
+                                    m_splat_image.data() + 3 * index);
+
+                            ScalarColor3f rgb = xyz_to_srgb(xyz);
+                            for (size_t k = 0; k < 3; ++k)
+                                target[k] = encode(rgb[k]);
+                            target[3] = (uint8_t) (
+                                clamp(value[3] * inv_weight, (ScalarFloat) 0.f, (ScalarFloat) 1.f) * 255.f + .5f);
+                            target += 4;
+                        }
+                    }
+
+                    result[t] = { offset, tile };
+                }
+            }
+        );
+
+        return result;
+    }
+
+    void develop() override {
+        if (m_streaming) {
+            Assert(m_storage != nullptr);
+            std::lock_guard<std::mutex> lock(m_mutex);
+
+            // Write the remaining rows, including those of blocks that were never merged
+            while (m_window_y < m_crop_size.y())
+                flush(std::min(m_crop_size.y(), m_window_y + m_storage->size().y()));
+
+            Log(Info, "\U00002714  Developed \"%s\"", destination_file().string());
+            if (m_writer)
+                m_writer->close();
+            return;
+        }
+
+        fs::path filename = destination_file();
+        Log(Info, "\U00002714  Developing \"%s\" ..", filename.string());
+
+        ref<Bitmap> bitmap = m_denoise ? denoised_bitmap() : this->bitmap();
+        bitmap->set_exr_tile_size(m_exr_tile_size);
+        bitmap->set_exr_multi_part(m_exr_multi_part);
+        if (m_async_write)
+            bitmap->write_async(filename, m_file_format);
+        else
+            bitmap->write(filename, m_file_format);
+    }
+
+    void write_state(Stream *stream) override {
+        Assert(m_storage != nullptr);
+        if (m_streaming)
+            Throw("HDRFilm::write_state(): not supported in streaming mode!");
+
+        ImageBlock *storage = m_storage.get();
+        std::unique_lock<std::mutex> lock(m_mutex, std::defer_lock);
+        if (m_thread_local)
+            storage = reduce();
+        else
+            lock.lock();
+
+        size_t count = m_channels.size() * hprod(storage->size());
+        stream->write((uint32_t) m_channels.size());
+        stream->write((int32_t) storage->size().x());
+        stream->write((int32_t) storage->size().y());
+
+        if (!m_aov_storage.empty()) {
+            // Write the single precision values row by row
+            std::vector<ScalarFloat> row(m_crop_size.x() * m_channels.size());
+            for (int y = 0; y < m_crop_size.y(); ++y) {
+                expand(y, 1, row.data());
+                stream->write_array(row.data(), row.size());
+            }
+            return;
+        }
+
+        stream->write_array((const ScalarFloat *) storage->data().managed().data(), count);
+    }
+
+    void read_state(Stream *stream, bool accumulate) override {
+        Assert(m_storage != nullptr);
+        if (m_streaming)
+            Throw("HDRFilm::read_state(): not supported in streaming mode!");
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        uint32_t channel_count;
+        int32_t width, height;
+        stream->read(channel_count);
+        stream->read(width);
+        stream->read(height);
+        if (channel_count != m_channels.size() ||
+            width != m_crop_size.x() || height != m_crop_size.y())
+            Throw("HDRFilm::read_state(): incompatible film state (%ix%i, %i "
+                  "channels), expected %ix%i with %i channels!", width, height,
+                  channel_count, m_crop_size.x(), m_crop_size.y(),
+                  m_channels.size());
+
+        m_snapshot_all = true;
+
+        if (!m_aov_storage.empty()) {
+            std::vector<ScalarFloat> row(m_crop_size.x() * m_channels.size()),
+                                     current(accumulate ? row.size() : 0);
+            for (int y = 0; y < m_crop_size.y(); ++y) {
+                stream->read_array(row.data(), row.size());
+                if (accumulate) {
+                    expand(y, 1, current.data());
+                    for (size_t i = 0; i < row.size(); ++i)
+                        row[i] += current[i];
+                }
+                assign(y, 1, row.data());
+            }
+            return;
+        }
+
+        size_t count = channel_count * hprod(m_crop_size);
+        if (accumulate) {
+            // Per-thread buffers are summed on top of the storage when developing
+            std::unique_ptr<ScalarFloat[]> buf(new ScalarFloat[count]);
+            stream->read_array(buf.get(), count);
+            if constexpr (!is_cuda_array_v<Float>) {
+                ScalarFloat *target = (ScalarFloat *) m_storage->data().data();
+                for (size_t i = 0; i < count; ++i)
+                    target[i] += buf[i];
+            } else {
+                m_storage->data() += DynamicBuffer<Float>::copy(buf.get(), count);
+            }
+            return;
+        }
+
+        if constexpr (!is_cuda_array_v<Float>) {
+            stream->read_array((ScalarFloat *) m_storage->data().data(), count);
+        } else {
+            std::unique_ptr<ScalarFloat[]> buf(new ScalarFloat[count]);
+            stream->read_array(buf.get(), count);
+            m_storage->data() = DynamicBuffer<Float>::copy(buf.get(), count);
+        }
+
+        // The restored state replaces any contributions gathered so far
+        m_local_storage.clear();
+        m_local_count = 0;
+    }
+
+    bool streaming() const override { return m_streaming; }
+
+    bool has_variance() const override { return m_variance; }
+
+    bool has_color_variance() const override { return m_color_variance; }
+
+    size_t band_count() const override { return m_band_count; }
+
+    ScalarVector2f band_range() const override { return m_band_range; }
+
+    bool destination_exists(const fs::path &base_name) const override {
+        std::string proper_extension;
+        if (m_file_format == Bitmap::FileFormat::OpenEXR)
+            proper_extension = ".exr";
+        else if (m_file_format == Bitmap::FileFormat::RGBE)
+            proper_extension = ".rgbe";
+        else
+            proper_extension = ".pfm";
+
+        fs::path filename = base_name;
+
+        std::string extension = string::to_lower(filename.extension().string());
+        if (extension != proper_extension)
+            filename.replace_extension(proper_extension);
+
+        return fs::exists(filename);
+    }
+
+    std::string to_string() const override {
+        std::ostringstream oss;
+        oss << "HDRFilm[" << std::endl
+            << "  size = " << m_size        << "," << std::endl
+            << "  crop_size = " << m_crop_size   << "," << std::endl
+            << "  crop_offset = " << m_crop_offset << "," << std::endl
+            << "  high_quality_edges = " << m_high_quality_edges << "," << std::endl
+            << "  filter = " << m_filter << "," << std::endl
+            << "  file_format = " << m_file_format << "," << std::endl
+            << "  pixel_format = " << m_pixel_format << "," << std::endl
+            << "  component_format = " << m_component_format << "," << std::endl
+            << "  dest_file = \"" << m_dest_file << "\"," << std::endl
+            << "  accumulation = " << (m_thread_local ? "thread_local" :
+                                      (m_deterministic ? "deterministic" : "locked")) << "," << std::endl
+            << "  async_write = " << m_async_write << "," << std::endl
+            << "  variance = " << m_variance << "," << std::endl
+            << "  variance_type = " << (m_color_variance ? "rgb" : "luminance") << "," << std::endl
+            << "  band_count = " << m_band_count << "," << std::endl
+            << "  band_range = " << m_band_range << "," << std::endl
+            << "  streaming = " << m_streaming << "," << std::endl
+            << "  aov_precision = " << (m_half_aovs ? "float16" : "float32") << "," << std::endl
+            << "  denoise = " << m_denoise << "," << std::endl
+            << "  denoiser = " << string::indent(m_denoiser) << std::endl
+            << "]";
+        return oss.str();
+    }
+
+    MTS_DECLARE_CLASS()
+protected:
+    /**
+     * \brief Convert the accumulated values of a region of \c size pixels
+     * starting at \c data into the output format of the film, using the
+     * given component format
+     *
+     * When \c raw is set, the returned bitmap directly references \c data.
+     */
+    ref<Bitmap> convert(uint8_t *data, const ScalarVector2i &size, bool raw,
+                        Struct::Type component_format) const {
         ref<Bitmap> source = new Bitmap(m_channels.size() != 5 ? Bitmap::PixelFormat::MultiChannel
                                                                : Bitmap::PixelFormat::XYZAW,
-                          struct_type_v<ScalarFloat>, m_storage->size(), m_storage->channel_count(),
-                          (uint8_t *) m_storage->data().managed().data());
+                          struct_type_v<ScalarFloat>, size, m_channels.size(), data);
 
         if (raw)
             return source;
@@ -266,8 +1109,8 @@ public:
 
         ref<Bitmap> target = new Bitmap(
             has_aovs ? Bitmap::PixelFormat::MultiChannel : m_pixel_format,
-            m_component_format, m_storage->size(),
-            has_aovs ? (m_storage->channel_count() - 1) : 0);
+            component_format, size,
+            has_aovs ? (m_channels.size() - 1) : 0);
 
         if (has_aovs) {
             for (size_t i = 0, j = 0; i < m_channels.size(); ++i, ++j) {
@@ -319,9 +1162,439 @@ public:
         source->convert(target);
 
         return target;
-     };
+    }
 
-    void develop() override {
+    /**
+     * \brief Develop the contents of the film using the given component
+     * format (see \ref convert())
+     *
+     * In half precision mode, the accumulated values are reconstructed and
+     * converted in strips of rows (in parallel), which avoids allocating a
+     * single precision copy of all channels.
+     */
+    ref<Bitmap> develop_storage(bool raw, Struct::Type component_format) {
+        ImageBlock *storage = merged_storage();
+        bool has_splats = merge_splats(),
+             needs_finalize = has_splats || m_variance_channel != 0;
+        ScalarVector2i size = m_crop_size;
+
+        if (m_aov_storage.empty()) {
+            ScalarFloat *data = (ScalarFloat *) storage->data().managed().data();
+            if (!needs_finalize)
+                return convert((uint8_t *) data, size, raw, component_format);
+
+            // Finalize a copy of the accumulated values
+            ref<Bitmap> merged = new Bitmap(Bitmap::PixelFormat::MultiChannel,
+                                            struct_type_v<ScalarFloat>, size, m_channels.size());
+            std::memcpy(merged->data(), data, merged->buffer_size());
+            finalize(0, size.y(), (ScalarFloat *) merged->data(), has_splats);
+            if (raw)
+                return merged;
+            return convert(merged->uint8_data(), size, false, component_format);
+        }
+
+        if (raw) {
+            ref<Bitmap> result = new Bitmap(Bitmap::PixelFormat::MultiChannel,
+                                            struct_type_v<ScalarFloat>, size, m_channels.size());
+            expand(0, size.y(), (ScalarFloat *) result->data());
+            if (needs_finalize)
+                finalize(0, size.y(), (ScalarFloat *) result->data(), has_splats);
+            return result;
+        }
+
+        const int strip_rows = 64;
+        int strip_count = (size.y() + strip_rows - 1) / strip_rows;
+        ref<Bitmap> result;
+
+        auto develop_strip = [&](int index, std::vector<ScalarFloat> &buffer) {
+            int y = index * strip_rows, rows = std::min(strip_rows, size.y() - y);
+            buffer.resize((size_t) rows * size.x() * m_channels.size());
+            expand(y, rows, buffer.data());
+            if (needs_finalize)
+                finalize(y, rows, buffer.data(), has_splats);
+            ref<Bitmap> strip = convert((uint8_t *) buffer.data(),
+                                        ScalarVector2i(size.x(), rows), false, component_format);
+
+            if (!result) {
+                result = new Bitmap(strip->pixel_format(), component_format, size,
+                                    strip->channel_count());
+                for (size_t i = 0; i < strip->channel_count(); ++i)
+                    result->struct_()->operator[](i) = strip->struct_()->operator[](i);
+            }
+
+            std::memcpy(result->uint8_data() + (size_t) y * size.x() * result->bytes_per_pixel(),
+                        strip->uint8_data(), strip->buffer_size());
+        };
+
+        // The first strip determines the layout of the result
+        std::vector<ScalarFloat> buffer;
+        develop_strip(0, buffer);
+
+        tbb::parallel_for(
+            tbb::blocked_range<int>(1, std::max(strip_count, 1)),
+            [&](const tbb::blocked_range<int> &range) {
+                std::vector<ScalarFloat> local;
+                for (int i = range.begin(); i != range.end(); ++i)
+                    develop_strip(i, local);
+            }
+        );
+        return result;
+    }
+
+    /// Add the contribution \c value at the position \c pos to the splat tiles of a thread
+    void splat_sample(SplatStorage &local, ScalarPoint2f pos, const ScalarFloat *value) const {
+        ScalarFloat radius = m_filter->radius();
+        pos -= ScalarVector2f(m_crop_offset) + .5f;
+
+        ScalarPoint2i lo, hi;
+        ScalarFloat *weights_x = local.weights.data(),
+                    *weights_y = weights_x + local.weights.size() / 2;
+
+        if (radius > .5f + math::RayEpsilon<ScalarFloat>) {
+            // Normalize the weights over the full footprint, including the pixels outside the film
+            lo = ceil2int<ScalarPoint2i>(pos - radius);
+            hi = floor2int<ScalarPoint2i>(pos + radius);
+
+            ScalarFloat sum_x = 0.f, sum_y = 0.f;
+            for (int x = lo.x(); x <= hi.x(); ++x)
+                sum_x += weights_x[x - lo.x()] = m_filter->eval_discretized(x - pos.x());
+            for (int y = lo.y(); y <= hi.y(); ++y)
+                sum_y += weights_y[y - lo.y()] = m_filter->eval_discretized(y - pos.y());
+
+            if (sum_x == 0.f || sum_y == 0.f)
+                return;
+            ScalarFloat factor = 1.f / (sum_x * sum_y);
+            for (int x = lo.x(); x <= hi.x(); ++x)
+                weights_x[x - lo.x()] *= factor;
+        } else {
+            lo = hi = ceil2int<ScalarPoint2i>(pos - .5f);
+            weights_x[0] = weights_y[0] = 1.f;
+        }
+
+        int tiles_x = (m_crop_size.x() + SplatTileSize - 1) / SplatTileSize;
+        for (int y = std::max(lo.y(), 0); y <= std::min(hi.y(), m_crop_size.y() - 1); ++y) {
+            for (int x = std::max(lo.x(), 0); x <= std::min(hi.x(), m_crop_size.x() - 1); ++x) {
+                std::unique_ptr<ScalarFloat[]> &tile =
+                    local.tiles[(y / SplatTileSize) * tiles_x + x / SplatTileSize];
+                if (unlikely(!tile))
+                    tile.reset(new ScalarFloat[3 * SplatTileSize * SplatTileSize]());
+
+                ScalarFloat weight = weights_x[x - lo.x()] * weights_y[y - lo.y()],
+                            *target = tile.get() + 3 * ((y % SplatTileSize) * SplatTileSize +
+                                                        x % SplatTileSize);
+                for (int k = 0; k < 3; ++k)
+                    target[k] += value[k] * weight;
+            }
+        }
+    }
+
+    /**
+     * \brief Sum the splats of all threads into \c m_splat_image
+     *
+     * \return \c false if there are no splats
+     */
+    bool merge_splats() {
+        size_t pixels = hprod(m_crop_size);
+
+        if constexpr (is_cuda_array_v<Float>) {
+            if (!m_splatted)
+                return false;
+            m_splat_image.resize(pixels * 3);
+            std::memcpy(m_splat_image.data(), m_splat_block->data().managed().data(),
+                        pixels * 3 * sizeof(ScalarFloat));
+            return true;
+        } else {
+            std::vector<const SplatStorage *> sources;
+            for (const SplatStorage &local : m_splat_storage) {
+                if (!local.tiles.empty())
+                    sources.push_back(&local);
+            }
+            if (sources.empty())
+                return false;
+
+            m_splat_image.assign(pixels * 3, 0.f);
+            int tiles_x = (m_crop_size.x() + SplatTileSize - 1) / SplatTileSize;
+
+            tbb::parallel_for(
+                tbb::blocked_range<size_t>(0, sources[0]->tiles.size()),
+                [&](const tbb::blocked_range<size_t> &range) {
+                    for (size_t t = range.begin(); t != range.end(); ++t) {
+                        int x0 = (int) (t % tiles_x) * SplatTileSize,
+                            y0 = (int) (t / tiles_x) * SplatTileSize,
+                            x1 = std::min(x0 + SplatTileSize, m_crop_size.x()),
+                            y1 = std::min(y0 + SplatTileSize, m_crop_size.y());
+
+                        for (const SplatStorage *local : sources) {
+                            const ScalarFloat *tile = local->tiles[t].get();
+                            if (!tile)
+                                continue;
+                            for (int y = y0; y < y1; ++y) {
+                                const ScalarFloat *source =
+                                    tile + 3 * (y - y0) * SplatTileSize;
+                                ScalarFloat *target =
+                                    m_splat_image.data() + 3 * ((size_t) y * m_crop_size.x() + x0);
+                                for (int i = 0; i < 3 * (x1 - x0); ++i)
+                                    target[i] += source[i];
+                            }
+                        }
+                    }
+                }
+            );
+            return true;
+        }
+    }
+
+    /**
+     * \brief Finalize \c rows rows of accumulated values starting at row
+     * \c y before their conversion
+     *
+     * This replaces the accumulated squared luminance (or colors) of the \c
+     * variance channels by the variance of the pixel estimate, and adds the merged
+     * splats (when \c splats is set). Both are scaled by the weight of the
+     * pixels, so that the conversion yields their values. Pixels without any
+     * weight receive a weight of 1.
+     */
+    void finalize(int y, int rows, ScalarFloat *data, bool splats) const {
+        size_t channel_count = m_channels.size(),
+               first = (size_t) y * m_crop_size.x(),
+               pixels = (size_t) rows * m_crop_size.x();
+        const ScalarFloat *splat = splats ? m_splat_image.data() + 3 * first : nullptr;
+
+        for (size_t i = 0; i < pixels; ++i) {
+            ScalarFloat &weight = data[4];
+
+            if (m_variance_channel != 0 && weight > 0.f) {
+                /* Weighted mean and second moment of the luminance (or color)
+                   samples. The effective sample count of the weighted mean
+                   follows from the total weight and the shape of the filter. */
+                ScalarFloat inv_weight = 1.f / weight,
+                            sample_count = weight * m_effective_sample_factor,
+                            scale = weight / std::max(sample_count - 1.f, (ScalarFloat) 1.f);
+
+                ScalarColor3f mean(data[1] * inv_weight);
+                size_t count = 1;
+                if (m_color_variance) {
+                    mean = xyz_to_srgb(ScalarColor3f(data[0], data[1], data[2]) * inv_weight);
+                    count = 3;
+                }
+
+                for (size_t k = 0; k < count; ++k) {
+                    ScalarFloat &moment = data[m_variance_channel + k];
+                    moment = std::max(moment * inv_weight - mean[k] * mean[k],
+                                      (ScalarFloat) 0.f) * scale;
+                }
+            }
+
+            if (splat) {
+                if (weight == 0.f)
+                    weight = 1.f;
+                for (size_t k = 0; k < 3; ++k)
+                    data[k] += splat[k] * weight;
+                splat += 3;
+            }
+
+            data += channel_count;
+        }
+    }
+
+    /// Return the storage holding all contributions merged so far
+    ImageBlock *merged_storage() {
+        if constexpr (is_cuda_array_v<Float>) {
+            cuda_eval();
+            cuda_sync();
+        }
+
+        if (m_deterministic) {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            merge_pending(true);
+        }
+
+        return m_thread_local ? reduce() : m_storage.get();
+    }
+
+    /**
+     * \brief Sum the shared storage and all per-thread buffers into
+     * \c m_reduced, in parallel over the rows of the image.
+     *
+     * The per-thread buffers are left untouched so that rendering can resume
+     * after a (partial) development of the film.
+     */
+    ImageBlock *reduce() {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        if constexpr (!is_cuda_array_v<Float>) {
+            std::vector<const ScalarFloat *> sources;
+            sources.push_back((const ScalarFloat *) m_storage->data().data());
+            for (const LocalStorage &local : m_local_storage) {
+                if (local.block)
+                    sources.push_back((const ScalarFloat *) local.block->data().data());
+            }
+
+            if (sources.size() == 1)
+                return m_storage.get();
+
+            if (!m_reduced) {
+                m_reduced = new ImageBlock(m_crop_size, m_channels.size());
+                m_reduced->set_offset(m_crop_offset);
+            }
+
+            ScalarFloat *target = (ScalarFloat *) m_reduced->data().data();
+            size_t row_size = m_crop_size.x() * m_channels.size();
+
+            tbb::parallel_for(
+                tbb::blocked_range<size_t>(0, (size_t) m_crop_size.y()),
+                [&](const tbb::blocked_range<size_t> &range) {
+                    size_t start = range.begin() * row_size,
+                           end   = range.end() * row_size;
+                    for (size_t i = start; i < end; ++i)
+                        target[i] = sources[0][i];
+                    for (size_t j = 1; j < sources.size(); ++j) {
+                        const ScalarFloat *source = sources[j];
+                        for (size_t i = start; i < end; ++i)
+                            target[i] += source[i];
+                    }
+                }
+            );
+
+            return m_reduced.get();
+        } else {
+            return m_storage.get();
+        }
+    }
+
+    /**
+     * \brief Merge the held back blocks that directly follow the last merged
+     * one. The caller must hold \c m_mutex.
+     *
+     * When \c all is set, the remaining blocks are merged as well (in order).
+     * This only happens when the rendering job was interrupted, leaving gaps
+     * in the sequence.
+     */
+    void merge_pending(bool all) {
+        auto it = m_pending.begin();
+        while (it != m_pending.end() && (all || it->first == m_next_index)) {
+            merge(it->second.get());
+            m_next_index = it->first + 1;
+            m_spare.push_back(std::move(it->second));
+            it = m_pending.erase(it);
+        }
+    }
+
+    /**
+     * \brief Merge a block into the storage. The caller must hold \c m_mutex.
+     *
+     * In half precision mode, the weighted means of the AOVs are updated
+     * from the weights before and after the merge.
+     */
+    /// Flag the snapshot tiles overlapped by a block (including its border)
+    void mark_dirty(const ImageBlock *block) {
+        int border = block->border_size();
+        ScalarPoint2i origin = block->offset() - border - m_crop_offset,
+                      start  = max(origin, 0),
+                      end    = min(origin + block->size() + 2 * border,
+                                   ScalarPoint2i(m_crop_size));
+        if (any(end <= start))
+            return;
+
+        for (int y = start.y() / SnapshotTileSize; y <= (end.y() - 1) / SnapshotTileSize; ++y)
+            for (int x = start.x() / SnapshotTileSize; x <= (end.x() - 1) / SnapshotTileSize; ++x)
+                m_snapshot_dirty[y * m_snapshot_tiles.x() + x].store(true, std::memory_order_relaxed);
+    }
+
+    void merge(const ImageBlock *block) {
+        mark_dirty(block);
+
+        if (m_aov_storage.empty()) {
+            m_storage->put(block);
+            return;
+        }
+
+        size_t channel_count = m_channels.size(), aov_count = channel_count - 5;
+        if (unlikely(block->channel_count() != channel_count))
+            Throw("HDRFilm::put(): mismatched channel counts!");
+
+        int border = block->border_size();
+        ScalarVector2i source_size = block->size() + 2 * border;
+        ScalarPoint2i origin = block->offset() - border - m_storage->offset();
+
+        // Clip against the bounds of the film
+        ScalarPoint2i start = max(origin, 0),
+                      end   = min(origin + source_size, ScalarPoint2i(m_crop_size));
+
+        const ScalarFloat *source = (const ScalarFloat *) block->data().data();
+        ScalarFloat *target = (ScalarFloat *) m_storage->data().data();
+
+        for (int y = start.y(); y < end.y(); ++y) {
+            for (int x = start.x(); x < end.x(); ++x) {
+                const ScalarFloat *value = source +
+                    ((size_t) (y - origin.y()) * source_size.x() + (x - origin.x())) * channel_count;
+                size_t index = (size_t) y * m_crop_size.x() + x;
+                ScalarFloat *sum = target + index * 5;
+                uint16_t *mean = m_aov_storage.data() + index * aov_count;
+
+                ScalarFloat weight_old = sum[4];
+                for (size_t k = 0; k < 5; ++k)
+                    sum[k] += value[k];
+                ScalarFloat inv_weight = sum[4] != 0.f ? 1.f / sum[4] : 0.f;
+
+                for (size_t k = 0; k < aov_count; ++k) {
+                    ScalarFloat aov = enoki::half::float16_to_float32(mean[k]) * weight_old;
+                    mean[k] = to_half((aov + value[5 + k]) * inv_weight);
+                }
+            }
+        }
+    }
+
+    /**
+     * \brief Reconstruct the accumulated values of all channels of \c rows
+     * rows starting at row \c y (half precision mode)
+     */
+    void expand(int y, int rows, ScalarFloat *output) const {
+        size_t channel_count = m_channels.size(), aov_count = channel_count - 5,
+               first = (size_t) y * m_crop_size.x(),
+               pixels = (size_t) rows * m_crop_size.x();
+        const ScalarFloat *sum = (const ScalarFloat *) m_storage->data().data() + first * 5;
+        const uint16_t *mean = m_aov_storage.data() + first * aov_count;
+
+        for (size_t i = 0; i < pixels; ++i) {
+            for (size_t k = 0; k < 5; ++k)
+                output[k] = sum[k];
+            for (size_t k = 0; k < aov_count; ++k)
+                output[5 + k] = enoki::half::float16_to_float32(mean[k]) * sum[4];
+            output += channel_count;
+            sum += 5;
+            mean += aov_count;
+        }
+    }
+
+    /// Replace the accumulated values of \c rows rows starting at row \c y (half precision mode)
+    void assign(int y, int rows, const ScalarFloat *input) {
+        size_t channel_count = m_channels.size(), aov_count = channel_count - 5,
+               first = (size_t) y * m_crop_size.x(),
+               pixels = (size_t) rows * m_crop_size.x();
+        ScalarFloat *sum = (ScalarFloat *) m_storage->data().data() + first * 5;
+        uint16_t *mean = m_aov_storage.data() + first * aov_count;
+
+        for (size_t i = 0; i < pixels; ++i) {
+            for (size_t k = 0; k < 5; ++k)
+                sum[k] = input[k];
+            ScalarFloat inv_weight = sum[4] != 0.f ? 1.f / sum[4] : 0.f;
+            for (size_t k = 0; k < aov_count; ++k)
+                mean[k] = to_half(input[5 + k] * inv_weight);
+            input += channel_count;
+            sum += 5;
+            mean += aov_count;
+        }
+    }
+
+    /// Convert a value into half precision, clamping it to the representable range
+    static uint16_t to_half(ScalarFloat value) {
+        return enoki::half::float32_to_float16(
+            (float) std::min(std::max(value, (ScalarFloat) -65504.f), (ScalarFloat) 65504.f));
+    }
+
+    /// Return the destination file, with the extension of the file format
+    fs::path destination_file() const {
         if (m_dest_file.empty())
             Throw("Destination file not specified, cannot develop.");
 
@@ -337,48 +1610,128 @@ public:
         std::string extension = string::to_lower(filename.extension().string());
         if (extension != proper_extension)
             filename.replace_extension(proper_extension);
+        return filename;
+    }
 
-        Log(Info, "\U00002714  Developing \"%s\" ..", filename.string());
+    /**
+     * \brief Merge a block into the window of the streaming mode, and write out
+     * the rows that can no longer receive any contributions. The caller must
+     * hold \c m_mutex.
+     *
+     * The blocks of a row (band) of the image are expected to have the same
+     * vertical offset and height, which is the case in the scanline order of
+     * \ref Spiral. Rows are final once all bands overlapping them through the
+     * filter border have been merged completely.
+     */
+    void put_streaming(const ImageBlock *block) {
+        int height = m_crop_size.y(),
+            border = block->border_size();
+        ScalarPoint2i rel = block->offset() - m_crop_offset;
 
-        bitmap()->write(filename, m_file_format);
-    }
+        if (std::max(rel.y() - border, 0) < m_window_y && !m_late_block) {
+            Log(Warn, "HDRFilm: discarding the contributions of a block to rows that were "
+                      "already written (streaming output requires a single pass over the "
+                      "image in scanline order).");
+            m_late_block = true;
+        }
 
-    bool destination_exists(const fs::path &base_name) const override {
-        std::string proper_extension;
-        if (m_file_format == Bitmap::FileFormat::OpenEXR)
-            proper_extension = ".exr";
-        else if (m_file_format == Bitmap::FileFormat::RGBE)
-            proper_extension = ".rgbe";
-        else
-            proper_extension = ".pfm";
+        grow_window(std::min(rel.y() + block->size().y() + border, height));
+        m_storage->put(block);
 
-        fs::path filename = base_name;
+        std::pair<int, int> &band = m_bands[rel.y()];
+        band.first += block->size().x();
+        band.second = block->size().y();
 
-        std::string extension = string::to_lower(filename.extension().string());
-        if (extension != proper_extension)
-            filename.replace_extension(proper_extension);
+        for (auto it = m_bands.find(m_next_band_y);
+             it != m_bands.end() && it->second.first >= m_crop_size.x();
+             it = m_bands.find(m_next_band_y)) {
+            m_next_band_y += it->second.second;
+            m_bands.erase(it);
+        }
 
-        return fs::exists(filename);
+        // Write the final rows in whole rows of tiles
+        if (m_next_band_y >= height) {
+            while (m_window_y < height)
+                flush(std::min(height, m_window_y + m_storage->size().y()));
+        } else {
+            int tile = (int) m_exr_tile_size,
+                final_rows = m_next_band_y - (int) m_filter->border_size() - m_window_y;
+            if (final_rows >= tile)
+                flush(m_window_y + final_rows / tile * tile);
+        }
     }
 
-    std::string to_string() const override {
-        std::ostringstream oss;
-        oss << "HDRFilm[" << std::endl
-            << "  size = " << m_size        << "," << std::endl
-            << "  crop_size = " << m_crop_size   << "," << std::endl
-            << "  crop_offset = " << m_crop_offset << "," << std::endl
-            << "  high_quality_edges = " << m_high_quality_edges << "," << std::endl
-            << "  filter = " << m_filter << "," << std::endl
-            << "  file_format = " << m_file_format << "," << std::endl
-            << "  pixel_format = " << m_pixel_format << "," << std::endl
-            << "  component_format = " << m_component_format << "," << std::endl
-            << "  dest_file = \"" << m_dest_file << "\"" << std::endl
-            << "]";
-        return oss.str();
+    /// Enlarge the window of the streaming mode to cover the rows above \c end
+    void grow_window(int end) {
+        int rows = m_storage->size().y(),
+            tile = (int) m_exr_tile_size;
+        if (end <= m_window_y + rows)
+            return;
+
+        // Keep the window a whole number of rows of tiles high
+        rows = std::min((end - m_window_y + tile - 1) / tile * tile,
+                        m_crop_size.y() - m_window_y);
+
+        ref<ImageBlock> window =
+            new ImageBlock(ScalarVector2i(m_crop_size.x(), rows), m_channels.size());
+        window->set_offset(m_storage->offset());
+        window->clear();
+        std::memcpy(window->data().data(), m_storage->data().data(),
+                    m_storage->data().size() * sizeof(ScalarFloat));
+        m_storage = window;
+    }
+
+    /// Write the rows of the window above \c end to the output file and discard them
+    void flush(int end) {
+        int rows = end - m_window_y;
+        if (rows <= 0)
+            return;
+        Assert(rows <= m_storage->size().y());
+
+        ScalarFloat *data = (ScalarFloat *) m_storage->data().data();
+        ref<Bitmap> strip =
+            convert((uint8_t *) data, ScalarVector2i(m_crop_size.x(), rows), false,
+                    m_component_format);
+
+        if (!m_writer) {
+            fs::path filename = destination_file();
+            Log(Info, "Streaming the image to \"%s\" ..", filename.string());
+            m_writer = new TiledOpenEXRWriter(filename, strip,
+                                              TiledOpenEXRWriter::Vector2u(m_crop_size),
+                                              m_exr_tile_size);
+        }
+        m_writer->write(strip);
+
+        // Move the remaining rows to the top of the window
+        size_t row_size = (size_t) m_crop_size.x() * m_channels.size(),
+               kept = ((size_t) m_storage->size().y() - rows) * row_size;
+        std::memmove(data, data + rows * row_size, kept * sizeof(ScalarFloat));
+        std::memset(data + kept, 0, rows * row_size * sizeof(ScalarFloat));
+
+        m_window_y = end;
+        m_storage->set_offset(m_crop_offset + ScalarVector2i(0, m_window_y));
     }
 
-    MTS_DECLARE_CLASS()
 protected:
+    struct LocalStorage {
+        ref<ImageBlock> block;
+        bool rejected = false;
+    };
+
+    /// Size of the square tiles of the per-thread splat buffers
+    static constexpr int SplatTileSize = 32;
+
+    /// Size of the square tiles returned by \ref snapshot()
+    static constexpr int SnapshotTileSize = 64;
+
+    /// Sparse per-thread splat buffer (see \ref splat())
+    struct SplatStorage {
+        /// XYZ tiles of the crop window, allocated on the first splat that touches them
+        std::vector<std::unique_ptr<ScalarFloat[]>> tiles;
+        /// Temporary filter weights
+        std::vector<ScalarFloat> weights;
+    };
+
     Bitmap::FileFormat m_file_format;
     Bitmap::PixelFormat m_pixel_format;
     Struct::Type m_component_format;
@@ -386,6 +1739,83 @@ protected:
     ref<ImageBlock> m_storage;
     std::mutex m_mutex;
     std::vector<std::string> m_channels;
+
+    /// Accumulate into per-thread buffers instead of locking \c m_storage?
+    bool m_thread_local;
+    /// Memory budget (in bytes) for the per-thread buffers
+    size_t m_accumulation_memory;
+    /// Layout of the OpenEXR output (see \ref Bitmap::set_exr_tile_size())
+    uint32_t m_exr_tile_size;
+    bool m_exr_multi_part;
+    /// Write the developed image on a background thread?
+    bool m_async_write;
+    /// Develop the variance of the pixel estimates?
+    bool m_variance;
+    /// Develop the variance of the color channels instead of the luminance?
+    bool m_color_variance;
+    /// Index of the (first) \c variance channel (0 if there is none)
+    uint32_t m_variance_channel = 0;
+    /// Number of recorded wavelength bands
+    size_t m_band_count;
+    /// Wavelength range covered by the bands
+    ScalarVector2f m_band_range;
+    /// Ratio between the effective sample count and the weight of a pixel
+    ScalarFloat m_effective_sample_factor;
+    /// Number of allocated per-thread buffers
+    size_t m_local_count = 0;
+    tbb::enumerable_thread_specific<LocalStorage> m_local_storage;
+    /// Sum of all buffers, generated when the film is developed
+    ref<ImageBlock> m_reduced;
+
+    /// Per-thread splat buffers (CPU variants)
+    tbb::enumerable_thread_specific<SplatStorage> m_splat_storage;
+    /// Splat buffer updated using atomic scatter-adds (GPU variants)
+    ref<ImageBlock> m_splat_block;
+    bool m_splatted = false;
+    /// Sum of all splats, generated when the film is developed
+    std::vector<ScalarFloat> m_splat_image;
+
+    /// Number of snapshot tiles along each axis of the crop window
+    ScalarVector2i m_snapshot_tiles;
+    /// Tiles that changed since the last snapshot
+    std::unique_ptr<std::atomic<bool>[]> m_snapshot_dirty;
+    /// Should the next snapshot develop all tiles (set by splats)?
+    std::atomic<bool> m_snapshot_all { false };
+    /// Did the snapshots find any splats when they were last merged?
+    bool m_snapshot_splats = false;
+
+    /// Merge blocks in the order given by their index?
+    bool m_deterministic;
+    /// Index of the next block to be merged (deterministic accumulation)
+    size_t m_next_index = 0;
+    /// Blocks that completed before their predecessors, sorted by index
+    std::map<size_t, ref<ImageBlock>> m_pending;
+    /// Recycled copies (avoids an allocation per held back block)
+    std::vector<ref<ImageBlock>> m_spare;
+
+    /// Write the image to disk while rendering, only keeping a window of rows?
+    bool m_streaming;
+    /// Output file of the streaming mode (opened when the first rows are written)
+    ref<TiledOpenEXRWriter> m_writer;
+    /// First row of the image covered by the window \c m_storage (streaming mode)
+    int m_window_y = 0;
+    /// First row that is not covered by a sequence of completely merged bands
+    int m_next_band_y = 0;
+    /// Merged width and height of the incomplete bands, keyed by their first row
+    std::map<int, std::pair<int, int>> m_bands;
+    /// Was a block merged after some of its rows were written (warns once)?
+    bool m_late_block = false;
+
+    /// Store the AOV channels with half precision?
+    bool m_half_aovs;
+    /// Weighted means of the AOV channels in half precision (empty otherwise)
+    std::vector<uint16_t> m_aov_storage;
+
+    /// Denoise the image when developing the film?
+    bool m_denoise;
+    ref<Denoiser> m_denoiser;
+    /// Names of the AOVs used as guides of the denoiser
+    std::string m_denoise_albedo, m_denoise_normal;
 };
 
 MTS_IMPLEMENT_CLASS_VARIANT(HDRFilm, Film)
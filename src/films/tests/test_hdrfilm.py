@@ -142,3 +142,505 @@ def test03_develop(variant_scalar_rgb, file_format, tmpdir):
             assert ek.allclose(img[:, :, :3], contents[:, :, :3], atol=1e-5)
         # Alpha channel was ignored, alpha and weights should default to 1.0.
         assert ek.allclose(img[:, :, 3:5], 1.0, atol=1e-6)
+
+
+@pytest.mark.parametrize('memory', [1024, 0])
+def test04_thread_local_accumulation(variant_scalar_rgb, memory):
+    from mitsuba.core.xml import load_string
+    from mitsuba.render import ImageBlock
+    import numpy as np
+
+    """Per-thread buffers must produce the same image as the locked path, and
+    fall back to it when the memory budget is exhausted."""
+    film = load_string("""<film version="2.0.0" type="hdrfilm">
+            <integer name="width" value="41"/>
+            <integer name="height" value="37"/>
+            <string name="accumulation" value="thread_local"/>
+            <integer name="accumulation_memory" value="{}"/>
+            <rfilter type="box"/>
+        </film>""".format(memory))
+
+    contents = np.random.uniform(size=(film.size()[1], film.size()[0], 5))
+    contents[:, :, 4] = 1.0
+
+    block = ImageBlock(film.size(), 5, film.reconstruction_filter())
+    block.clear()
+    for x in range(film.size()[1]):
+        for y in range(film.size()[0]):
+            block.put([y+0.5, x+0.5], contents[x, y, :])
+
+    film.prepare(['X', 'Y', 'Z', 'A', 'W'])
+    film.put(block)
+    film.put(block)
+
+    img = np.array(film.bitmap(raw=True), copy=False)
+    assert ek.allclose(img, 2 * contents, atol=1e-5)
+
+    with pytest.raises(RuntimeError):
+        load_string("""<film version="2.0.0" type="hdrfilm">
+            <string name="accumulation" value="atomic"/>
+        </film>""")
+
+
+def test05_deterministic_accumulation(variant_scalar_rgb):
+    from mitsuba.core.xml import load_string
+    from mitsuba.render import ImageBlock
+    import numpy as np
+
+    """Blocks overlapping through the filter border must be merged in the
+    order of their index, regardless of the order in which they are put."""
+    def make_film():
+        film = load_string("""<film version="2.0.0" type="hdrfilm">
+                <integer name="width" value="16"/>
+                <integer name="height" value="16"/>
+                <string name="accumulation" value="deterministic"/>
+                <rfilter type="gaussian"/>
+            </film>""")
+        film.prepare(['X', 'Y', 'Z', 'A', 'W'])
+        return film
+
+    film = make_film()
+    np.random.seed(0)
+    blocks = []
+    for offset in [[0, 0], [8, 0], [0, 8], [8, 8]] * 2:
+        block = ImageBlock([8, 8], 5, film.reconstruction_filter())
+        block.set_offset(offset)
+        block.clear()
+        for i in range(64):
+            pos = np.random.uniform(size=2) * 8 + offset
+            block.put(pos, np.random.uniform(size=5))
+        blocks.append(block)
+
+    for index, block in enumerate(blocks):
+        film.put(block, index)
+    ref = np.array(film.bitmap(raw=True), copy=True)
+
+    film = make_film()
+    for index in [5, 3, 7, 0, 1, 6, 2, 4]:
+        film.put(blocks[index], index)
+    assert np.array_equal(np.array(film.bitmap(raw=True), copy=False), ref)
+
+    # Blocks following a gap (interrupted job) are merged on development
+    film = make_film()
+    for index in [1, 2]:
+        film.put(blocks[index], index)
+    img = np.array(film.bitmap(raw=True), copy=False)
+    assert np.any(img[:, 8:, :] != 0) and np.any(img[8:, :8, :] != 0)
+
+
+def test06_streaming(variant_scalar_rgb, tmpdir):
+    from mitsuba.core.xml import load_string
+    from mitsuba.core import Bitmap, Struct
+    from mitsuba.render import ImageBlock
+    import numpy as np
+
+    """Writing the rows of the image while the blocks are being merged must
+    produce the same file as developing the whole image at the end."""
+    def make_film(streaming):
+        film = load_string("""<film version="2.0.0" type="hdrfilm">
+                <integer name="width" value="20"/>
+                <integer name="height" value="27"/>
+                <string name="component_format" value="float32"/>
+                <integer name="exr_tile_size" value="4"/>
+                <boolean name="streaming" value="{}"/>
+                <rfilter type="gaussian"/>
+            </film>""".format('true' if streaming else 'false'))
+        film.prepare(['X', 'Y', 'Z', 'A', 'W'])
+        return film
+
+    np.random.seed(0)
+    blocks = []
+    for y in range(0, 27, 8):
+        for x in range(0, 20, 8):
+            size = [min(8, 20 - x), min(8, 27 - y)]
+            block = ImageBlock(size, 5, make_film(False).reconstruction_filter())
+            block.set_offset([x, y])
+            block.clear()
+            for i in range(64):
+                pos = np.random.uniform(size=2) * size + [x, y]
+                block.put(pos, np.random.uniform(size=5))
+            blocks.append(block)
+
+    images = []
+    for streaming in [False, True]:
+        film = make_film(streaming)
+        assert film.streaming() == streaming
+        # Blocks of a row complete in any order
+        for index in [1, 0, 2, 3, 5, 4, 8, 6, 7, 9, 11, 10]:
+            film.put(blocks[index])
+        filename = str(tmpdir.join('test_%i.exr' % streaming))
+        film.set_destination_file(filename)
+        film.develop()
+        images.append(np.array(Bitmap(filename).convert(
+            Bitmap.PixelFormat.RGBA, Struct.Type.Float32, srgb_gamma=False)))
+
+        if streaming:
+            with pytest.raises(RuntimeError):
+                film.bitmap()
+
+    assert np.array_equal(images[0], images[1])
+
+    # Streaming output requires OpenEXR files
+    with pytest.raises(RuntimeError):
+        load_string("""<film version="2.0.0" type="hdrfilm">
+                <string name="file_format" value="pfm"/>
+                <boolean name="streaming" value="true"/>
+            </film>""")
+
+
+def test07_denoise(variant_scalar_rgb):
+    from mitsuba.core.xml import load_string
+    from mitsuba.core import Bitmap, Struct
+    from mitsuba.render import ImageBlock
+    import numpy as np
+
+    """The denoised image of the film keeps the AOVs and the alpha channel,
+    and only changes the color channels"""
+    film = load_string("""<film version="2.0.0" type="hdrfilm">
+            <integer name="width" value="24"/>
+            <integer name="height" value="16"/>
+            <string name="component_format" value="float32"/>
+            <boolean name="denoise" value="true"/>
+            <string name="denoise_backend" value="builtin"/>
+            <rfilter type="box"/>
+        </film>""")
+    channels = ['X', 'Y', 'Z', 'A', 'W', 'albedo.R', 'albedo.G', 'albedo.B']
+    film.prepare(channels)
+
+    np.random.seed(0)
+    block = ImageBlock([24, 16], len(channels), film.reconstruction_filter())
+    block.clear()
+    for y in range(16):
+        for x in range(24):
+            value = np.random.uniform(0.0, 2.0)
+            block.put([x + 0.5, y + 0.5], [value, value, value, 1, 1, 0.5, 0.5, 0.5])
+    film.put(block)
+
+    noisy = np.array(film.bitmap())
+    denoised = np.array(film.denoised_bitmap())
+    assert noisy.shape == denoised.shape
+    assert np.std(denoised[:, :, 0]) < 0.5 * np.std(noisy[:, :, 0])
+    assert np.array_equal(noisy[:, :, 3:], denoised[:, :, 3:])
+
+    # With a luminance film, only the Y channel is denoised and the AOVs are kept
+    film = load_string("""<film version="2.0.0" type="hdrfilm">
+            <integer name="width" value="24"/>
+            <integer name="height" value="16"/>
+            <string name="component_format" value="float32"/>
+            <string name="pixel_format" value="luminance"/>
+            <boolean name="denoise" value="true"/>
+            <string name="denoise_backend" value="builtin"/>
+            <rfilter type="box"/>
+        </film>""")
+    film.prepare(channels)
+    film.put(block)
+
+    noisy = np.array(film.bitmap())
+    denoised = np.array(film.denoised_bitmap())
+    assert noisy.shape == denoised.shape
+    assert np.std(denoised[:, :, 0]) < 0.5 * np.std(noisy[:, :, 0])
+    assert np.array_equal(noisy[:, :, 1:], denoised[:, :, 1:])
+
+    with pytest.raises(RuntimeError):
+        load_string("""<film version="2.0.0" type="hdrfilm">
+                <string name="pixel_format" value="xyz"/>
+                <boolean name="denoise" value="true"/>
+            </film>""")
+
+
+def test08_half_precision_aovs(variant_scalar_rgb):
+    from mitsuba.core.xml import load_string
+    from mitsuba.core import MemoryStream
+    from mitsuba.render import ImageBlock
+    import numpy as np
+
+    """Storing the AOVs with half precision must closely match the single
+    precision film, also after a checkpoint"""
+    def make_film(precision):
+        film = load_string("""<film version="2.0.0" type="hdrfilm">
+                <integer name="width" value="19"/>
+                <integer name="height" value="13"/>
+                <string name="component_format" value="float32"/>
+                <string name="aov_precision" value="{}"/>
+                <rfilter type="gaussian"/>
+            </film>""".format(precision))
+        film.prepare(['X', 'Y', 'Z', 'A', 'W', 'depth.T', 'nn.X', 'nn.Y'])
+        return film
+
+    np.random.seed(0)
+    films = [make_film('float32'), make_film('float16')]
+    for it in range(4):
+        for y in range(0, 13, 8):
+            for x in range(0, 19, 8):
+                size = [min(8, 19 - x), min(8, 13 - y)]
+                block = ImageBlock(size, 8, films[0].reconstruction_filter())
+                block.set_offset([x, y])
+                block.clear()
+                for i in range(32):
+                    pos = np.random.uniform(size=2) * size + [x, y]
+                    value = np.random.uniform(size=8)
+                    value[5] *= 1000
+                    block.put(pos, value)
+                for film in films:
+                    film.put(block)
+
+    images = [np.array(film.bitmap()) for film in films]
+    assert np.allclose(images[0], images[1], rtol=2e-3, atol=1e-5)
+
+    stream = MemoryStream()
+    films[1].write_state(stream)
+    stream.seek(0)
+    restored = make_film('float16')
+    restored.read_state(stream)
+    assert np.allclose(np.array(restored.bitmap()), images[1], rtol=2e-3, atol=1e-5)
+
+
+def test09_async_write(variant_scalar_rgb, tmpdir):
+    from mitsuba.core.xml import load_string
+    from mitsuba.core import Bitmap, Struct
+    from mitsuba.render import ImageBlock
+    import numpy as np
+
+    """Developing the film in the background writes the same file, and
+    consecutive frames written to the same path do not interfere."""
+    film = load_string("""<film version="2.0.0" type="hdrfilm">
+            <integer name="width" value="32"/>
+            <integer name="height" value="200"/>
+            <string name="component_format" value="float32"/>
+            <string name="aov_precision" value="float16"/>
+            <boolean name="async_write" value="true"/>
+            <rfilter type="box"/>
+        </film>""")
+    channels = ['X', 'Y', 'Z', 'A', 'W', 'depth.T']
+    filename = str(tmpdir.join('test_async.exr'))
+    film.set_destination_file(filename)
+
+    np.random.seed(0)
+    for frame in range(3):
+        film.prepare(channels)
+        block = ImageBlock([32, 200], len(channels), film.reconstruction_filter())
+        block.clear()
+        for y in range(200):
+            for x in range(32):
+                block.put([x + 0.5, y + 0.5], np.random.uniform(size=len(channels)))
+        film.put(block)
+        film.develop()
+
+    Bitmap.wait_async_writes()
+    reference = str(tmpdir.join('test_sync.exr'))
+    film.bitmap().write(reference)
+    assert Bitmap(filename) == Bitmap(reference)
+
+
+def test10_splat(variant_scalar_rgb):
+    from mitsuba.core.xml import load_string
+    from mitsuba.render import ImageBlock
+    import numpy as np
+    import threading
+
+    """Splats are spread over the normalized filter footprint and added to
+    the normalized image, also when many threads splat concurrently."""
+    film = load_string("""<film version="2.0.0" type="hdrfilm">
+            <integer name="width" value="70"/>
+            <integer name="height" value="40"/>
+            <string name="component_format" value="float32"/>
+            <string name="pixel_format" value="rgb"/>
+            <rfilter type="tent"/>
+        </film>""")
+    film.prepare(['X', 'Y', 'Z', 'A', 'W'])
+
+    # A single splat preserves its energy, and adds to the image blocks
+    block = ImageBlock([70, 40], 5, film.reconstruction_filter())
+    block.clear()
+    block.put([3.5, 3.5], [1, 1, 1, 1, 1])
+    film.put(block)
+    film.splat([40.3, 20.7], [1, 2, 3], [])
+    image = np.array(film.bitmap())
+    assert np.allclose(np.sum(image[15:26, 35:46], axis=(0, 1)), [1, 2, 3], atol=1e-3)
+    assert np.allclose(image[3, 3], [1, 1, 1])
+
+    # Concurrent splats spanning several tiles
+    film.prepare(['X', 'Y', 'Z', 'A', 'W'])
+    np.random.seed(0)
+    positions = np.random.uniform(size=(4, 500, 2)) * [70, 40]
+    def run(index):
+        for p in positions[index]:
+            film.splat(p, [1, 1, 1], [])
+    threads = [threading.Thread(target=run, args=(i,)) for i in range(4)]
+    for t in threads:
+        t.start()
+    for t in threads:
+        t.join()
+
+    # Splats close to the border lose the part of their footprint outside the film
+    image = np.array(film.bitmap())
+    total = np.sum(image[:, :, 1])
+    assert total <= 2000 + 1e-2 and total > 1900
+
+
+def test11_variance(variant_scalar_rgb):
+    from mitsuba.core.xml import load_string
+    from mitsuba.render import ImageBlock
+    import numpy as np
+
+    """The variance channel estimates the variance of the pixel means from
+    the accumulated second moments."""
+    film = load_string("""<film version="2.0.0" type="hdrfilm">
+            <integer name="width" value="4"/>
+            <integer name="height" value="3"/>
+            <string name="component_format" value="float32"/>
+            <string name="pixel_format" value="rgb"/>
+            <boolean name="variance" value="true"/>
+            <rfilter type="box"/>
+        </film>""")
+    assert film.has_variance()
+    channels = ['X', 'Y', 'Z', 'A', 'W', 'variance']
+    film.prepare(channels)
+
+    np.random.seed(0)
+    block = ImageBlock([4, 3], len(channels), film.reconstruction_filter())
+    block.clear()
+    values = np.random.uniform(size=(3, 4, 16)) * np.arange(1, 13).reshape(3, 4, 1)
+    for y in range(3):
+        for x in range(4):
+            for v in values[y, x]:
+                pos = [x + np.random.uniform(), y + np.random.uniform()]
+                block.put(pos, [v, v, v, 1, 1, v * v])
+    film.put(block)
+
+    image = np.array(film.bitmap())
+    assert image.shape == (3, 4, 4)
+    expected = np.var(values, axis=2, ddof=1) / 16
+    assert np.allclose(image[:, :, 3], expected, rtol=1e-4)
+
+
+def test12_snapshot(variant_scalar_rgb):
+    from mitsuba.core import Bitmap, Struct
+    from mitsuba.core.xml import load_string
+    from mitsuba.render import ImageBlock
+    import numpy as np
+
+    """Snapshots only develop the tiles that changed since the previous call,
+    and match the developed film."""
+    film = load_string("""<film version="2.0.0" type="hdrfilm">
+            <integer name="width" value="150"/>
+            <integer name="height" value="100"/>
+            <string name="pixel_format" value="rgba"/>
+            <rfilter type="box"/>
+        </film>""")
+    film.prepare(['X', 'Y', 'Z', 'A', 'W'])
+    assert film.snapshot() == []
+
+    block = ImageBlock([20, 20], 5, film.reconstruction_filter())
+    block.set_offset([70, 10])
+    block.clear()
+    for y in range(20):
+        for x in range(20):
+            block.put([70.5 + x, 10.5 + y], [0.2, 0.3 * x / 20, 0.1, 1, 1])
+    film.put(block)
+
+    tiles = film.snapshot()
+    assert [list(offset) for offset, _ in tiles] == [[64, 0]]
+    assert film.snapshot() == []
+
+    reference = np.array(film.bitmap().convert(Bitmap.PixelFormat.RGBA,
+                                               Struct.Type.UInt8, True))
+    offset, tile = tiles[0]
+    tile = np.array(tile)
+    assert tile.shape == (64, 64, 4)
+    assert np.max(np.abs(tile.astype(int) - reference[0:64, 64:128].astype(int))) <= 1
+
+    # Splats flag the whole film, including the clipped tiles at its border
+    film.splat([10.5, 90.5], [1, 1, 1], [])
+    tiles = film.snapshot()
+    assert len(tiles) == 6
+    sizes = sorted(np.array(tile).shape[:2] for _, tile in tiles)
+    assert sizes == [(36, 22), (36, 64), (36, 64), (64, 22), (64, 64), (64, 64)]
+
+
+def test13_bands(variant_scalar_spectral):
+    from mitsuba.core.xml import load_string
+    import numpy as np
+
+    """Wavelength bands record the mean radiance of their wavelengths."""
+    scene = load_string("""
+        <scene version="2.0.0">
+            <sensor type="radiancemeter">
+                <film type="hdrfilm">
+                    <integer name="width" value="1"/>
+                    <integer name="height" value="1"/>
+                    <integer name="band_count" value="3"/>
+                    <float name="band_min" value="400"/>
+                    <float name="band_max" value="700"/>
+                    <rfilter type="box"/>
+                </film>
+                <sampler type="independent">
+                    <integer name="sample_count" value="20000"/>
+                </sampler>
+            </sensor>
+            <emitter type="constant">
+                <spectrum name="radiance" value="2"/>
+            </emitter>
+        </scene>""")
+
+    sensor = scene.sensors()[0]
+    film = sensor.film()
+    assert film.band_count() == 3
+    assert np.allclose(film.band_range(), [400, 700])
+
+    assert scene.integrator().render(scene, sensor)
+    bitmap = film.bitmap()
+    names = [field.name for field in bitmap.struct_()]
+    assert names[-3:] == ['band_0', 'band_1', 'band_2']
+    assert np.allclose(np.array(bitmap).ravel()[-3:], 2, rtol=5e-2)
+
+    with pytest.raises(RuntimeError):
+        load_string("""<film version="2.0.0" type="hdrfilm">
+                <integer name="band_count" value="2"/>
+                <float name="band_max" value="900"/>
+            </film>""")
+
+
+def test14_color_variance(variant_scalar_rgb):
+    from mitsuba.core.xml import load_string
+    from mitsuba.render import ImageBlock
+    import numpy as np
+
+    """With variance_type=rgb, every color channel has its own variance."""
+    film = load_string("""<film version="2.0.0" type="hdrfilm">
+            <integer name="width" value="4"/>
+            <integer name="height" value="3"/>
+            <string name="component_format" value="float32"/>
+            <string name="pixel_format" value="rgb"/>
+            <boolean name="variance" value="true"/>
+            <string name="variance_type" value="rgb"/>
+            <rfilter type="box"/>
+        </film>""")
+    assert film.has_variance() and film.has_color_variance()
+    assert film.variance_channel_count() == 3
+    channels = ['X', 'Y', 'Z', 'A', 'W', 'variance.R', 'variance.G', 'variance.B']
+    film.prepare(channels)
+
+    # Gray samples (v, v, v) in linear sRGB
+    white = np.array([0.950456, 1.0, 1.088754])
+    np.random.seed(0)
+    block = ImageBlock([4, 3], len(channels), film.reconstruction_filter())
+    block.clear()
+    values = np.random.uniform(size=(3, 4, 16)) * np.arange(1, 13).reshape(3, 4, 1)
+    for y in range(3):
+        for x in range(4):
+            for v in values[y, x]:
+                pos = [x + np.random.uniform(), y + np.random.uniform()]
+                block.put(pos, list(white * v) + [1, 1, v * v, v * v, v * v])
+    film.put(block)
+
+    image = np.array(film.bitmap())
+    assert image.shape == (3, 4, 6)
+    expected = np.var(values, axis=2, ddof=1) / 16
+    for k in range(3):
+        assert np.allclose(image[:, :, 3 + k], expected, rtol=1e-3)
+
+    with pytest.raises(RuntimeError):
+        load_string("""<film version="2.0.0" type="hdrfilm">
+                <string name="variance_type" value="xyz"/>
+            </film>""")
@@ -1,3 +1,4 @@
+#include <mitsuba/render/bsdf.h>
 #include <mitsuba/render/integrator.h>
 #include <mitsuba/render/records.h>
 
@@ -58,6 +59,15 @@ Currently, the following AOVs types are available:
     - :monosp:`sh_normal`: Shading normal.
     - :monosp:`dp_du`, :monosp:`dp_dv`: Position partials wrt. the UV parameterization.
     - :monosp:`duv_dx`, :monosp:`duv_dy`: UV partials wrt. changes in screen-space.
+    - :monosp:`albedo`: Single-sample estimate of the directional albedo (i.e. the BSDF
+      sampling weight) in RGB.
+
+The camera ray is intersected once per sample: the nested integrators continue from this
+intersection instead of tracing the ray again (unless their first event may be a medium
+interaction, as in :ref:`volpath <integrator-volpath>`).
+
+The *albedo* and *shading normal* AOVs are the guides of the denoiser of the
+:ref:`hdrfilm <film-hdrfilm>` plugin.
 
  */
 
@@ -65,7 +75,7 @@ template <typename Float, typename Spectrum>
 class AOVIntegrator final : public SamplingIntegrator<Float, Spectrum> {
 public:
     MTS_IMPORT_BASE(SamplingIntegrator)
-    MTS_IMPORT_TYPES(Scene, Sampler, Medium)
+    MTS_IMPORT_TYPES(Scene, Sampler, Medium, BSDF, BSDFPtr)
 
     enum class Type {
         Depth,
@@ -77,6 +87,7 @@ public:
         dPdV,
         dUVdx,
         dUVdy,
+        Albedo,
         IntegratorRGBA
     };
 
@@ -129,6 +140,11 @@ public:
                 m_aov_types.push_back(Type::dUVdy);
                 m_aov_names.push_back(item[0] + ".U");
                 m_aov_names.push_back(item[0] + ".V");
+            } else if (item[1] == "albedo") {
+                m_aov_types.push_back(Type::Albedo);
+                m_aov_names.push_back(item[0] + ".R");
+                m_aov_names.push_back(item[0] + ".G");
+                m_aov_names.push_back(item[0] + ".B");
             } else {
                 Throw("Invalid AOV type \"%s\"!", item[1]);
             }
@@ -163,8 +179,12 @@ public:
 
         std::pair<Spectrum, Mask> result { 0.f, false };
 
-        SurfaceInteraction3f si = scene->ray_intersect(ray, active);
-        si[!si.is_valid()] = zero<SurfaceInteraction3f>();
+        /* The camera ray is traced once: the nested integrators start from
+           the same interaction as the geometric AOVs */
+        SurfaceInteraction3f si_primary = scene->ray_intersect(ray, active);
+        Mask hit = si_primary.is_valid();
+        SurfaceInteraction3f si = si_primary;
+        si[!hit] = zero<SurfaceInteraction3f>();
         size_t ctr = 0;
 
         for (size_t i = 0; i < m_aov_types.size(); ++i) {
@@ -218,25 +238,28 @@ public:
                     *aovs++ = si.duv_dy.y();
                     break;
 
+                case Type::Albedo: {
+                        Color3f rgb = 0.f;
+                        if (any_or<true>(hit)) {
+                            BSDFContext ctx;
+                            BSDFPtr bsdf = si.bsdf(ray);
+                            auto [bs, weight] = bsdf->sample(ctx, si, sampler->next_1d(hit),
+                                                             sampler->next_2d(hit), hit);
+                            ENOKI_MARK_USED(bs);
+                            rgb = select(hit, to_rgb(weight, ray.wavelengths, hit), 0.f);
+                        }
+
+                        *aovs++ = rgb.r(); *aovs++ = rgb.g(); *aovs++ = rgb.b();
+                    }
+                    break;
+
                 case Type::IntegratorRGBA: {
                         std::pair<Spectrum, Mask> result_sub =
-                            m_integrators[ctr].first->sample(scene, sampler, ray, medium, aovs, active);
+                            m_integrators[ctr].first->sample_with_interaction(
+                                scene, sampler, ray, si_primary, medium, aovs, active);
                         aovs += m_integrators[ctr].second;
 
-                        UnpolarizedSpectrum spec_u = depolarize(result_sub.first);
-
-                        Color3f rgb;
-                        if constexpr (is_monochromatic_v<Spectrum>) {
-                            rgb = spec_u.x();
-                        } else if constexpr (is_rgb_v<Spectrum>) {
-                            rgb = spec_u;
-                        } else {
-                            static_assert(is_spectral_v<Spectrum>);
-                            /// Note: this assumes that sensor used sample_rgb_spectrum() to generate 'ray.wavelengths'
-                            auto pdf = pdf_rgb_spectrum(ray.wavelengths);
-                            spec_u *= select(neq(pdf, 0.f), rcp(pdf), 0.f);
-                            rgb = xyz_to_srgb(spectrum_to_xyz(spec_u, ray.wavelengths, active));
-                        }
+                        Color3f rgb = to_rgb(result_sub.first, ray.wavelengths, active);
 
                         *aovs++ = rgb.r(); *aovs++ = rgb.g(); *aovs++ = rgb.b();
                         *aovs++ = select(result_sub.second, Float(1.f), Float(0.f));
@@ -279,6 +302,28 @@ public:
     }
 
     MTS_DECLARE_CLASS()
+private:
+    /// Convert a spectrum sampled at the given wavelengths into linear sRGB
+    Color3f to_rgb(const Spectrum &spec, const Wavelength &wavelengths, Mask active) const {
+        UnpolarizedSpectrum spec_u = depolarize(spec);
+
+        if constexpr (is_monochromatic_v<Spectrum>) {
+            ENOKI_MARK_USED(wavelengths);
+            ENOKI_MARK_USED(active);
+            return Color3f(spec_u.x());
+        } else if constexpr (is_rgb_v<Spectrum>) {
+            ENOKI_MARK_USED(wavelengths);
+            ENOKI_MARK_USED(active);
+            return Color3f(spec_u);
+        } else {
+            static_assert(is_spectral_v<Spectrum>);
+            /// Note: this assumes that sensor used sample_rgb_spectrum() to generate 'ray.wavelengths'
+            auto pdf = pdf_rgb_spectrum(wavelengths);
+            spec_u *= select(neq(pdf, 0.f), rcp(pdf), 0.f);
+            return xyz_to_srgb(spectrum_to_xyz(spec_u, wavelengths, active));
+        }
+    }
+
 private:
     std::vector<Type> m_aov_types;
     std::vector<std::string> m_aov_names;
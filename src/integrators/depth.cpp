@@ -17,14 +17,24 @@ public:
     DepthIntegrator(const Properties &props) : Base(props) { }
 
     std::pair<Spectrum, Mask> sample(const Scene *scene,
-                                     Sampler * /* sampler */,
+                                     Sampler *sampler,
                                      const RayDifferential3f &ray,
-                                     const Medium * /* medium */,
-                                     Float * /* aovs */,
+                                     const Medium *medium,
+                                     Float *aovs,
                                      Mask active) const override {
-        MTS_MASKED_FUNCTION(ProfilerPhase::SamplingIntegratorSample, active);
+        return sample_with_interaction(scene, sampler, ray, scene->ray_intersect(ray, active),
+                                       medium, aovs, active);
+    }
 
-        SurfaceInteraction3f si = scene->ray_intersect(ray, active);
+    std::pair<Spectrum, Mask>
+    sample_with_interaction(const Scene * /* scene */,
+                            Sampler * /* sampler */,
+                            const RayDifferential3f & /* ray */,
+                            const SurfaceInteraction3f &si,
+                            const Medium * /* medium */,
+                            Float * /* aovs */,
+                            Mask active) const override {
+        MTS_MASKED_FUNCTION(ProfilerPhase::SamplingIntegratorSample, active);
 
         return {
             select(si.is_valid(), si.t, 0.f),
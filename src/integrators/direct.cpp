@@ -105,14 +105,29 @@ public:
     std::pair<Spectrum, Mask> sample(const Scene *scene,
                                      Sampler *sampler,
                                      const RayDifferential3f &ray,
-                                     const Medium * /* medium */,
-                                     Float * /* aovs */,
+                                     const Medium *medium,
+                                     Float *aovs,
                                      Mask active) const override {
+        return sample_with_interaction(scene, sampler, ray, scene->ray_intersect(ray, active),
+                                       medium, aovs, active);
+    }
+
+    std::pair<Spectrum, Mask>
+    sample_with_interaction(const Scene *scene,
+                            Sampler *sampler,
+                            const RayDifferential3f &ray,
+                            const SurfaceInteraction3f &si_,
+                            const Medium * /* medium */,
+                            Float * /* aovs */,
+                            Mask active) const override {
         MTS_MASKED_FUNCTION(ProfilerPhase::SamplingIntegratorSample, active);
 
-        SurfaceInteraction3f si = scene->ray_intersect(ray, active);
+        SurfaceInteraction3f si = si_;
         Mask valid_ray = si.is_valid();
 
+        // Only track the (1,1) entries of depolarizing Mueller matrices
+        bool polarizing = scene->has_polarizing_bsdfs();
+
         Spectrum result(0.f);
 
         // ----------------------- Visible emitters -----------------------
@@ -133,29 +148,46 @@ public:
         Mask sample_emitter = active && has_flag(bsdf->flags(), BSDFFlags::Smooth);
 
         if (any_or<true>(sample_emitter)) {
-            for (size_t i = 0; i < m_emitter_samples; ++i) {
-                Mask active_e = sample_emitter;
-                DirectionSample3f ds;
-                Spectrum emitter_val;
-                std::tie(ds, emitter_val) = scene->sample_emitter_direction(
-                    si, sampler->next_2d(active_e), true, active_e);
-                active_e &= neq(ds.pdf, 0.f);
-                if (none_or<false>(active_e))
-                    continue;
-
-                // Query the BSDF for that emitter-sampled direction
-                Vector3f wo = si.to_local(ds.d);
-
-                Spectrum bsdf_val = bsdf->eval(ctx, si, wo, active_e);
-                bsdf_val = si.to_world_mueller(bsdf_val, -wo, si.wi);
-
-                /* Determine probability of having sampled that same
-                   direction using BSDF sampling. */
-                Float bsdf_pdf = bsdf->pdf(ctx, si, wo, active_e);
-
-                Float mis = select(ds.delta, Float(1.f), mis_weight(
-                    ds.pdf * m_frac_lum, bsdf_pdf * m_frac_bsdf) * m_weight_lum);
-                result[active_e] += mis * bsdf_val * emitter_val;
+            Point2f samples[EmitterBatch];
+            DirectionSample3f ds[EmitterBatch];
+            Spectrum contrib[EmitterBatch];
+
+            for (size_t offset = 0; offset < m_emitter_samples; offset += EmitterBatch) {
+                size_t count = std::min(m_emitter_samples - offset, EmitterBatch);
+                for (size_t i = 0; i < count; ++i)
+                    samples[i] = sampler->next_2d(sample_emitter);
+
+                /* Draw a batch of emitter samples, weight them by the BSDF,
+                   and only then trace the shadow rays of those that contribute */
+                scene->sample_emitter_directions(si, samples, count, ds, contrib, false,
+                                                 sample_emitter);
+
+                for (size_t i = 0; i < count; ++i) {
+                    Mask active_e = sample_emitter && neq(ds[i].pdf, 0.f);
+                    if (none_or<false>(active_e)) {
+                        contrib[i] = 0.f;
+                        continue;
+                    }
+
+                    // Query the BSDF for that emitter-sampled direction
+                    Vector3f wo = si.to_local(ds[i].d);
+
+                    /* Also determine the probability of having sampled that
+                       same direction using BSDF sampling. */
+                    auto [bsdf_val, bsdf_pdf] = bsdf->eval_pdf(ctx, si, wo, active_e);
+                    if (polarizing)
+                        bsdf_val = si.to_world_mueller(bsdf_val, -wo, si.wi);
+
+                    Float mis = select(ds[i].delta, Float(1.f), mis_weight(
+                        ds[i].pdf * m_frac_lum, bsdf_pdf * m_frac_bsdf) * m_weight_lum);
+                    contrib[i] = mis * mueller_product(bsdf_val, contrib[i], polarizing);
+                    contrib[i][!active_e] = 0.f;
+                }
+
+                scene->ray_test_emitter_directions(si, ds, count, contrib, sample_emitter);
+
+                for (size_t i = 0; i < count; ++i)
+                    result += contrib[i];
             }
         }
 
@@ -164,7 +196,8 @@ public:
         for (size_t i = 0; i < m_bsdf_samples; ++i) {
             auto [bs, bsdf_val] = bsdf->sample(ctx, si, sampler->next_1d(active),
                                                sampler->next_2d(active), active);
-            bsdf_val = si.to_world_mueller(bsdf_val, -bs.wo, si.wi);
+            if (polarizing)
+                bsdf_val = si.to_world_mueller(bsdf_val, -bs.wo, si.wi);
 
             Mask active_b = active && any(neq(depolarize(bsdf_val), 0.f));
 
@@ -189,7 +222,7 @@ public:
                     select(delta, 0.f, scene->pdf_emitter_direction(si, ds, active_b));
 
                 result[active_b] +=
-                    bsdf_val * emitter_val *
+                    mueller_product(bsdf_val, emitter_val, polarizing) *
                     mis_weight(bs.pdf * m_frac_bsdf, emitter_pdf * m_frac_lum) *
                     m_weight_bsdf;
             }
@@ -215,6 +248,9 @@ public:
 
     MTS_DECLARE_CLASS()
 private:
+    /// Number of emitter samples whose shadow rays are traced together
+    static constexpr size_t EmitterBatch = 8;
+
     size_t m_emitter_samples;
     size_t m_bsdf_samples;
     ScalarFloat m_frac_bsdf, m_frac_lum;
@@ -0,0 +1,747 @@
+#include <array>
+#include <atomic>
+#include <memory>
+#include <enoki/stl.h>
+#include <mitsuba/core/atomic.h>
+#include <mitsuba/core/bbox.h>
+#include <mitsuba/core/ray.h>
+#include <mitsuba/core/properties.h>
+#include <mitsuba/render/bsdf.h>
+#include <mitsuba/render/emitter.h>
+#include <mitsuba/render/integrator.h>
+#include <mitsuba/render/records.h>
+#include <tbb/parallel_for.h>
+
+NAMESPACE_BEGIN(mitsuba)
+
+/**!
+
+.. _integrator-guided:
+
+Guided path tracer (:monosp:`guided`)
+-------------------------------------------
+
+.. pluginparameters::
+
+ * - max_depth
+   - |int|
+   - Specifies the longest path depth in the generated output image (where -1 corresponds to
+     :math:`\infty`). A value of 1 will only render directly visible light sources. 2 will lead
+     to single-bounce (direct-only) illumination, and so on. (Default: -1)
+ * - rr_depth
+   - |int|
+   - Specifies the minimum path depth, after which the implementation will start to use the
+     *russian roulette* path termination criterion. (Default: 5)
+ * - bsdf_sampling_fraction
+   - |float|
+   - Probability of sampling directions from the BSDF rather than from the learned
+     distribution of incident radiance. (Default: 0.5)
+ * - spatial_threshold
+   - |float|
+   - A cell of the spatial tree is split in two once it receives more than this value times
+     the square root of the number of samples per pixel of a pass. (Default: 12000)
+ * - directional_threshold
+   - |float|
+   - A quadrant of a directional tree is subdivided when it holds more than this fraction of
+     the energy of the tree. (Default: 0.01)
+ * - learning_passes
+   - |int|
+   - Number of passes that update the guiding distributions. Later passes keep sampling
+     the distributions learned so far. (Default: all passes)
+
+This integrator extends the :ref:`path tracer <integrator-path>` with *path guiding*
+following Müller et al. ("Practical Path Guiding for Efficient Light-Transport Simulation"):
+it learns the distribution of incident radiance in the scene while rendering and samples
+new directions proportionally to it, which greatly reduces noise in scenes where most of the
+light arrives through narrow openings or from indirectly lit surfaces.
+
+The learned distribution is stored in a *spatial-directional tree*: a binary tree
+over the bounding box of the scene, whose cells each hold a quadtree over the sphere of
+directions. The trees are learned over the rendering passes (see the ``samples_per_pass``
+parameter of the integrator): during each pass, all render threads record the radiance
+found along their paths into a second copy of each quadtree, which replaces the sampled one
+after the pass. The trees are then refined where they received many samples or much energy.
+Hence, renders should use several passes, e.g. 8 passes of 4 samples per pixel.
+
+New directions are chosen with the learned distribution or with the BSDF, and both
+strategies are combined by one-sample multiple importance sampling. Surfaces with delta
+lobes (e.g. smooth glass or mirrors) only use BSDF sampling.
+
+.. note:: This integrator does not handle participating media and is only supported by the
+   CPU variants. Every render pass learns from the previous ones, which makes the result
+   depend on the number of passes.
+
+ */
+
+template <typename Float, typename Spectrum>
+class GuidedPathIntegrator : public MonteCarloIntegrator<Float, Spectrum> {
+public:
+    MTS_IMPORT_BASE(MonteCarloIntegrator, m_max_depth, m_rr_depth)
+    MTS_IMPORT_TYPES(Scene, Sensor, Sampler, Medium, Emitter, EmitterPtr, BSDF, BSDFPtr)
+
+    GuidedPathIntegrator(const Properties &props) : Base(props) {
+        if constexpr (is_cuda_array_v<Float>)
+            Throw("The guided path tracer is only supported by the CPU variants.");
+
+        m_bsdf_fraction = props.float_("bsdf_sampling_fraction", .5f);
+        if (m_bsdf_fraction < 0.f || m_bsdf_fraction > 1.f)
+            Throw("\"bsdf_sampling_fraction\" must be in the range [0, 1]!");
+
+        m_spatial_threshold     = props.float_("spatial_threshold", 12000.f);
+        m_directional_threshold = props.float_("directional_threshold", .01f);
+        m_learning_passes       = props.size_("learning_passes", (size_t) -1);
+
+        reset_tree(ScalarBoundingBox3f(ScalarPoint3f(0.f), ScalarPoint3f(1.f)));
+    }
+
+    bool uses_pass_hooks() const override { return true; }
+
+    void prepare_pass(const Scene *scene, const Sensor * /* sensor */, size_t pass,
+                      size_t /* pass_count */) override {
+        // Start learning from scratch in every render job
+        if (pass == 0) {
+            ScalarBoundingBox3f bbox = scene->bbox();
+            if (!bbox.valid())
+                bbox = ScalarBoundingBox3f(ScalarPoint3f(0.f), ScalarPoint3f(1.f));
+
+            // Cubic cells keep the directional trees of the children comparable
+            ScalarPoint3f center = bbox.center();
+            ScalarFloat size = hmax(bbox.extents()) * .5005f + math::Epsilon<ScalarFloat>;
+            reset_tree(ScalarBoundingBox3f(center - size, center + size));
+        }
+
+        m_learning = pass < m_learning_passes;
+    }
+
+    void finish_pass(const Scene * /* scene */, const Sensor *sensor, size_t pass,
+                     size_t /* pass_count */) override {
+        if (!m_learning)
+            return;
+
+        // Swap the learned directional trees in and refine the next ones
+        std::vector<uint32_t> counts(m_leaves.size());
+        tbb::parallel_for(
+            tbb::blocked_range<size_t>(0, m_leaves.size()),
+            [&](const tbb::blocked_range<size_t> &range) {
+                for (size_t i = range.begin(); i != range.end(); ++i) {
+                    Leaf &leaf = *m_leaves[i];
+                    counts[i] = leaf.building.sample_count;
+                    if (counts[i] > 0)
+                        leaf.sampling = leaf.building.build();
+                    leaf.building.reset(refine(leaf.sampling));
+                }
+            }
+        );
+
+        /* Split the spatial cells that received many samples. The children
+           inherit the directional trees and half of the samples each, which
+           splits busy regions repeatedly. */
+        ScalarFloat threshold =
+            m_spatial_threshold * std::sqrt((ScalarFloat) Base::pass_sample_count(sensor));
+
+        std::vector<uint32_t> node_counts(m_nodes.size(), 0);
+        for (size_t i = 0; i < m_nodes.size(); ++i) {
+            if (m_nodes[i].child == 0)
+                node_counts[i] = counts[m_nodes[i].leaf];
+        }
+
+        for (size_t i = 0; i < m_nodes.size(); ++i) {
+            if (m_nodes[i].child != 0 || (ScalarFloat) node_counts[i] <= threshold)
+                continue;
+
+            uint32_t child = (uint32_t) m_nodes.size(),
+                     axis  = (m_nodes[i].axis + 1) % 3,
+                     leaf  = m_nodes[i].leaf,
+                     count = node_counts[i] / 2;
+
+            m_leaves.push_back(std::make_unique<Leaf>(*m_leaves[leaf]));
+            m_nodes[i].child = child;
+            m_nodes.push_back(SNode{ 0, axis, leaf });
+            m_nodes.push_back(SNode{ 0, axis, (uint32_t) m_leaves.size() - 1 });
+            node_counts.push_back(count);
+            node_counts.push_back(count);
+        }
+
+        Log(Debug, "Guiding after pass %i: %i spatial cells, %i spatial nodes.",
+            pass + 1, m_leaves.size(), m_nodes.size());
+    }
+
+    std::pair<Spectrum, Mask> sample(const Scene *scene,
+                                     Sampler *sampler,
+                                     const RayDifferential3f &ray_,
+                                     const Medium * /* medium */,
+                                     Float * /* aovs */,
+                                     Mask active) const override {
+        MTS_MASKED_FUNCTION(ProfilerPhase::SamplingIntegratorSample, active);
+
+        if constexpr (is_cuda_array_v<Float>) {
+            ENOKI_MARK_USED(scene);
+            ENOKI_MARK_USED(sampler);
+            ENOKI_MARK_USED(ray_);
+            Throw("sample(): the guided path tracer is only supported by the CPU variants.");
+        } else {
+            RayDifferential3f ray = ray_;
+
+            // Tracks radiance scaling due to index of refraction changes
+            Float eta(1.f);
+
+            // MIS weight for intersected emitters (set by prev. iteration)
+            Float emission_weight(1.f);
+
+            Spectrum throughput(1.f), result(0.f);
+
+            // Path vertices whose incident radiance is recorded into the building trees
+            Vertex vertices[MaxVertices];
+            uint32_t vertex_count = 0;
+
+            // ---------------------- First intersection ----------------------
+
+            SurfaceInteraction3f si = scene->ray_intersect(ray, active);
+            Mask valid_ray = si.is_valid();
+            EmitterPtr emitter = si.emitter(scene);
+
+            for (int depth = 1;; ++depth) {
+
+                // ---------------- Intersection with emitters ----------------
+
+                if (any_or<true>(neq(emitter, nullptr))) {
+                    Spectrum emitted = throughput * emitter->eval(si, active);
+                    result[active] += emission_weight * emitted;
+
+                    /* The vertex that sampled this direction learns the full
+                       emission, earlier ones the MIS-weighted contribution */
+                    if (vertex_count > 0 && vertex_count + 1 == (uint32_t) depth) {
+                        add_radiance(vertices, vertex_count - 1, emission_weight * emitted, active);
+                        add_radiance(vertices + vertex_count - 1, 1, emitted, active);
+                    } else {
+                        add_radiance(vertices, vertex_count, emission_weight * emitted, active);
+                    }
+                }
+
+                active &= si.is_valid();
+
+                // Russian roulette (see the path tracer)
+                if (depth > m_rr_depth) {
+                    Float q = min(hmax(depolarize(throughput)) * sqr(eta), .95f);
+                    active &= sampler->next_1d(active) < q;
+                    throughput *= rcp(q);
+                }
+
+                if ((uint32_t) depth >= (uint32_t) m_max_depth || none(active))
+                    break;
+
+                BSDFContext ctx;
+                BSDFPtr bsdf = si.bsdf(ray);
+
+                /* Guide the lanes whose BSDF has no delta lobes and whose
+                   spatial cell has already learned something */
+                const Leaf *leaves[Lanes];
+                Mask guided = active && has_flag(bsdf->flags(), BSDFFlags::Smooth) &&
+                              !has_flag(bsdf->flags(), BSDFFlags::Delta);
+                guided &= lookup(si.p, guided, leaves);
+
+                // --------------------- Emitter sampling ---------------------
+
+                Mask active_e = active && has_flag(bsdf->flags(), BSDFFlags::Smooth);
+
+                if (likely(any_or<true>(active_e))) {
+                    auto [ds, emitter_val] = scene->sample_emitter_direction(
+                        si, sampler->next_2d(active_e), true, active_e);
+                    active_e &= neq(ds.pdf, 0.f);
+
+                    // Query the BSDF for that emitter-sampled direction
+                    Vector3f wo = si.to_local(ds.d);
+                    auto [bsdf_val, bsdf_pdf] = bsdf->eval_pdf(ctx, si, wo, active_e);
+                    bsdf_val = si.to_world_mueller(bsdf_val, -wo, si.wi);
+
+                    // Determine density of sampling that same direction with the mixture
+                    Mask guided_e = guided && active_e;
+                    if (any(guided_e))
+                        bsdf_pdf = select(guided_e, mix_pdf(bsdf_pdf, guide_pdf(leaves, ds.d, guided_e)),
+                                          bsdf_pdf);
+
+                    Float mis = select(ds.delta, 1.f, mis_weight(ds.pdf, bsdf_pdf));
+                    Spectrum contrib = mis * throughput * bsdf_val * emitter_val;
+                    result[active_e] += contrib;
+                    add_radiance(vertices, vertex_count, contrib, active_e);
+                }
+
+                // ----------------- BSDF and guided sampling -----------------
+
+                Float sample_strategy = sampler->next_1d(active);
+                Point2f sample_dir    = sampler->next_2d(active);
+
+                auto [bs, bsdf_weight] = bsdf->sample(ctx, si, sampler->next_1d(active),
+                                                      sample_dir, active);
+
+                /* One-sample MIS: guided lanes pick one of the strategies and
+                   divide by the pdf of the mixture */
+                Mask use_guide = guided && sample_strategy >= m_bsdf_fraction;
+                Vector3f wo = bs.wo;
+                Float pdf = bs.pdf;
+
+                if (any(guided)) {
+                    if (any(use_guide))
+                        masked(wo, use_guide) = si.to_local(guide_sample(leaves, sample_dir, use_guide));
+
+                    Mask valid = use_guide || neq(bs.pdf, 0.f);
+                    auto [bsdf_val, bsdf_pdf] = bsdf->eval_pdf(ctx, si, wo, guided);
+                    Float mixture_pdf =
+                        mix_pdf(bsdf_pdf, guide_pdf(leaves, si.to_world(wo), guided));
+
+                    bsdf_weight = select(guided, bsdf_val * select(valid && mixture_pdf > 0.f,
+                                                                   rcp(mixture_pdf), 0.f),
+                                         bsdf_weight);
+                    pdf = select(guided, mixture_pdf, pdf);
+                }
+
+                bsdf_weight = si.to_world_mueller(bsdf_weight, -wo, si.wi);
+
+                throughput = throughput * bsdf_weight;
+                active &= any(neq(depolarize(throughput), 0.f));
+                if (none_or<false>(active))
+                    break;
+
+                eta *= select(use_guide, 1.f, bs.eta);
+                Mask delta = !guided && has_flag(bs.sampled_type, BSDFFlags::Delta);
+
+                // Intersect the sampled ray against the scene geometry
+                ray = si.spawn_ray(si.to_world(wo));
+                SurfaceInteraction3f si_bsdf = scene->ray_intersect(ray, active);
+
+                if (m_learning && vertex_count < MaxVertices) {
+                    Vertex &v    = vertices[vertex_count++];
+                    v.p          = si.p;
+                    v.d          = ray.d;
+                    v.throughput = depolarize(throughput);
+                    v.radiance   = 0.f;
+                    v.pdf        = pdf;
+                    v.active     = active && !delta && pdf > 0.f;
+                }
+
+                /* Determine probability of having sampled that same
+                   direction using emitter sampling. */
+                emitter = si_bsdf.emitter(scene, active);
+                DirectionSample3f ds(si_bsdf, si);
+                ds.object = emitter;
+
+                if (any_or<true>(neq(emitter, nullptr))) {
+                    Float emitter_pdf =
+                        select(neq(emitter, nullptr) && !delta,
+                               scene->pdf_emitter_direction(si, ds),
+                               0.f);
+
+                    emission_weight = mis_weight(pdf, emitter_pdf);
+                }
+
+                si = std::move(si_bsdf);
+            }
+
+            if (m_learning)
+                record(vertices, vertex_count);
+
+            return { result, valid_ray };
+        }
+    }
+
+    //! @}
+    // =============================================================
+
+    std::string to_string() const override {
+        return tfm::format("GuidedPathIntegrator[\n"
+            "  max_depth = %i,\n"
+            "  rr_depth = %i,\n"
+            "  bsdf_sampling_fraction = %f,\n"
+            "  spatial_threshold = %f,\n"
+            "  directional_threshold = %f,\n"
+            "  spatial_cells = %i\n"
+            "]", m_max_depth, m_rr_depth, m_bsdf_fraction, m_spatial_threshold,
+            m_directional_threshold, m_leaves.size());
+    }
+
+    Float mis_weight(Float pdf_a, Float pdf_b) const {
+        pdf_a *= pdf_a;
+        pdf_b *= pdf_b;
+        return select(pdf_a > 0.f, pdf_a / (pdf_a + pdf_b), 0.f);
+    }
+
+    MTS_DECLARE_CLASS()
+private:
+    /// Number of values per packet (the tree queries process one lane at a time)
+    static constexpr size_t Lanes =
+        (is_array_v<Float> && !is_cuda_array_v<Float>) ? array_size_v<Float> : 1;
+
+    /// Longest prefix of a path that is recorded into the guiding trees
+    static constexpr uint32_t MaxVertices = 32;
+
+    /// Maximum depth of the directional trees
+    static constexpr uint32_t MaxDirectionalDepth = 20;
+
+    /// Scattering vertex of a path
+    struct Vertex {
+        Point3f p;
+        Vector3f d;
+        /// Path throughput after the vertex, and radiance arriving from \c d
+        UnpolarizedSpectrum throughput, radiance;
+        /// Solid angle density of sampling \c d
+        Float pdf;
+        Mask active;
+    };
+
+    /**
+     * \brief Quadtree over the square <tt>[0, 1]^2</tt>, which maps to the
+     * sphere of directions (see \ref square_to_dir())
+     *
+     * Each node stores the energy of its four quadrants (indexed by
+     * <tt>x + 2 * y</tt>) and the index of the node that subdivides them,
+     * or zero for leaf quadrants. Children follow their parents.
+     */
+    struct DTree {
+        struct Node {
+            uint32_t child[4] = { 0, 0, 0, 0 };
+            ScalarFloat sum[4] = { 0.f, 0.f, 0.f, 0.f };
+
+            ScalarFloat total() const { return sum[0] + sum[1] + sum[2] + sum[3]; }
+        };
+
+        std::vector<Node> nodes = std::vector<Node>(1);
+
+        ScalarFloat total() const { return nodes[0].total(); }
+
+        /// Sample a point proportionally to the energy, returns the point and its density
+        std::pair<ScalarPoint2f, ScalarFloat> sample(ScalarPoint2f u) const {
+            ScalarPoint2f origin(0.f);
+            ScalarFloat size = 1.f, pdf = 1.f;
+            uint32_t index = 0;
+
+            while (true) {
+                const Node &node = nodes[index];
+                ScalarFloat total = node.total();
+                if (!(total > 0.f))
+                    break;
+
+                // Choose the column, then the quadrant within the column
+                ScalarFloat left = node.sum[0] + node.sum[2],
+                            p    = left / total;
+                uint32_t qx = u.x() < p ? 0 : 1;
+                u.x() = qx == 0 ? u.x() / p : (u.x() - p) / (1.f - p);
+
+                ScalarFloat column = qx == 0 ? left : (total - left);
+                p = node.sum[qx] / column;
+                uint32_t qy = u.y() < p ? 0 : 1;
+                u.y() = qy == 0 ? u.y() / p : (u.y() - p) / (1.f - p);
+                u = min(u, math::OneMinusEpsilon<ScalarFloat>);
+
+                uint32_t q = qx + 2 * qy;
+                pdf *= 4.f * node.sum[q] / total;
+                size *= .5f;
+                origin += ScalarVector2f((ScalarFloat) qx, (ScalarFloat) qy) * size;
+
+                if (node.child[q] == 0)
+                    break;
+                index = node.child[q];
+            }
+
+            return { origin + u * size, pdf };
+        }
+
+        /// Evaluate the density of \ref sample()
+        ScalarFloat pdf(ScalarPoint2f p) const {
+            ScalarFloat pdf = 1.f;
+            uint32_t index = 0;
+
+            while (true) {
+                const Node &node = nodes[index];
+                ScalarFloat total = node.total();
+                if (!(total > 0.f))
+                    return pdf;
+
+                uint32_t qx = p.x() < .5f ? 0 : 1,
+                         qy = p.y() < .5f ? 0 : 1,
+                         q  = qx + 2 * qy;
+                pdf *= 4.f * node.sum[q] / total;
+                p = 2.f * p - ScalarVector2f((ScalarFloat) qx, (ScalarFloat) qy);
+
+                if (node.child[q] == 0 || pdf == 0.f)
+                    return pdf;
+                index = node.child[q];
+            }
+        }
+    };
+
+    /// Topology of a \ref DTree (child indices per node)
+    using Topology = std::vector<std::array<uint32_t, 4>>;
+
+    /**
+     * \brief Directional tree that accumulates the samples of the current
+     * pass
+     *
+     * The topology stays fixed during a pass, and samples are added
+     * atomically to the leaf quadrants only, which keeps the contention
+     * between the render threads low. \ref build() sums up the inner nodes.
+     */
+    struct BuildingDTree {
+        Topology children;
+        std::unique_ptr<AtomicFloat<ScalarFloat>[]> sums;
+        mutable std::atomic<uint32_t> sample_count { 0 };
+
+        void reset(const Topology &topology) {
+            children = topology;
+            sums = std::unique_ptr<AtomicFloat<ScalarFloat>[]>(
+                new AtomicFloat<ScalarFloat>[children.size() * 4]);
+            sample_count = 0;
+        }
+
+        /// Add a sample with weight \c value at the point \c p (thread-safe)
+        void record(ScalarPoint2f p, ScalarFloat value) const {
+            uint32_t index = 0;
+            while (true) {
+                uint32_t qx = p.x() < .5f ? 0 : 1,
+                         qy = p.y() < .5f ? 0 : 1,
+                         q  = qx + 2 * qy;
+                p = 2.f * p - ScalarVector2f((ScalarFloat) qx, (ScalarFloat) qy);
+
+                uint32_t child = children[index][q];
+                if (child == 0) {
+                    if (value > 0.f)
+                        sums[index * 4 + q] += value;
+                    break;
+                }
+                index = child;
+            }
+            sample_count.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        /// Convert into a \ref DTree with the accumulated energies
+        DTree build() const {
+            DTree tree;
+            tree.nodes.resize(children.size());
+            for (size_t i = children.size(); i-- > 0;) {
+                typename DTree::Node &node = tree.nodes[i];
+                for (uint32_t q = 0; q < 4; ++q) {
+                    uint32_t child = children[i][q];
+                    node.child[q] = child;
+                    node.sum[q] = child != 0 ? tree.nodes[child].total()
+                                             : (ScalarFloat) sums[i * 4 + q];
+                }
+            }
+            return tree;
+        }
+    };
+
+    /// Cell of the spatial tree with its sampled and its building directional tree
+    struct Leaf {
+        Leaf() { building.reset(Topology(1, { 0, 0, 0, 0 })); }
+
+        Leaf(const Leaf &other) : sampling(other.sampling) {
+            building.reset(other.building.children);
+        }
+
+        DTree sampling;
+        BuildingDTree building;
+    };
+
+    /// Node of the spatial tree, which splits its cell in half along \c axis
+    struct SNode {
+        /// Index of the first of the two children, or zero for leaves
+        uint32_t child;
+        uint32_t axis;
+        /// Index into \ref m_leaves (leaves only)
+        uint32_t leaf;
+    };
+
+    /// Discard the learned distributions and cover the given (cubic) bounds
+    void reset_tree(const ScalarBoundingBox3f &bbox) {
+        m_bbox = bbox;
+        m_nodes.assign(1, SNode{ 0, 0, 0 });
+        m_leaves.clear();
+        m_leaves.push_back(std::make_unique<Leaf>());
+    }
+
+    /**
+     * \brief Topology of the next building tree: subdivide the quadrants
+     * that hold more than a fraction \ref m_directional_threshold of the
+     * energy, assuming that the energy of leaf quadrants is uniform
+     */
+    Topology refine(const DTree &tree) const {
+        constexpr uint32_t None = (uint32_t) -1;
+        struct Entry { uint32_t src, dst, depth; ScalarFloat energy; };
+
+        Topology result(1, { 0, 0, 0, 0 });
+        ScalarFloat threshold = tree.total() * m_directional_threshold;
+        if (!(threshold > 0.f))
+            return result;
+
+        std::vector<Entry> stack{ Entry{ 0, 0, 1, tree.total() } };
+        while (!stack.empty()) {
+            Entry e = stack.back();
+            stack.pop_back();
+
+            for (uint32_t q = 0; q < 4; ++q) {
+                ScalarFloat energy = e.src != None ? tree.nodes[e.src].sum[q] : e.energy * .25f;
+                if (e.depth >= MaxDirectionalDepth || energy <= threshold)
+                    continue;
+
+                uint32_t dst = (uint32_t) result.size(),
+                         src = e.src != None ? tree.nodes[e.src].child[q] : 0;
+                result.push_back({ 0, 0, 0, 0 });
+                result[e.dst][q] = dst;
+                stack.push_back(Entry{ src != 0 ? src : None, dst, e.depth + 1, energy });
+            }
+        }
+
+        return result;
+    }
+
+    /// Return the spatial cell containing \c p
+    const Leaf *lookup(const ScalarPoint3f &p) const {
+        ScalarVector3f x = (p - m_bbox.min) / m_bbox.extents();
+        uint32_t index = 0;
+        while (m_nodes[index].child != 0) {
+            const SNode &node = m_nodes[index];
+            ScalarFloat &v = x[node.axis];
+            if (v < .5f) {
+                v *= 2.f;
+                index = node.child;
+            } else {
+                v = 2.f * v - 1.f;
+                index = node.child + 1;
+            }
+        }
+        return m_leaves[m_nodes[index].leaf].get();
+    }
+
+    /// Look up the cells of the active lanes, returns lanes whose cell has learned something
+    Mask lookup(const Point3f &p, const Mask &active, const Leaf **leaves) const {
+        Float valid(0.f);
+        for (size_t i = 0; i < Lanes; ++i) {
+            leaves[i] = nullptr;
+            if (!lane_mask(active, i))
+                continue;
+            leaves[i] = lookup(lane(p, i));
+            set_lane(valid, i, leaves[i]->sampling.total() > 0.f ? 1.f : 0.f);
+        }
+        return valid > 0.f;
+    }
+
+    /// Sample a world space direction from the cells of the active lanes
+    Vector3f guide_sample(const Leaf *const *leaves, const Point2f &sample, const Mask &active) const {
+        Vector3f d(0.f);
+        for (size_t i = 0; i < Lanes; ++i) {
+            if (!lane_mask(active, i))
+                continue;
+            ScalarPoint2f u(lane(sample.x(), i), lane(sample.y(), i));
+            ScalarVector3f v = square_to_dir(leaves[i]->sampling.sample(u).first);
+            set_lane(d.x(), i, v.x());
+            set_lane(d.y(), i, v.y());
+            set_lane(d.z(), i, v.z());
+        }
+        return d;
+    }
+
+    /// Solid angle density of \ref guide_sample()
+    Float guide_pdf(const Leaf *const *leaves, const Vector3f &d, const Mask &active) const {
+        Float pdf(0.f);
+        for (size_t i = 0; i < Lanes; ++i) {
+            if (!lane_mask(active, i))
+                continue;
+            ScalarFloat value = leaves[i]->sampling.pdf(dir_to_square(lane(d, i)));
+            set_lane(pdf, i, value * math::InvFourPi<ScalarFloat>);
+        }
+        return pdf;
+    }
+
+    Float mix_pdf(const Float &bsdf_pdf, const Float &guide_pdf) const {
+        return m_bsdf_fraction * bsdf_pdf + (1.f - m_bsdf_fraction) * guide_pdf;
+    }
+
+    /// Add the contribution \c contrib to the incident radiance of the given vertices
+    void add_radiance(Vertex *vertices, uint32_t count, const Spectrum &contrib,
+                      const Mask &active) const {
+        if (!m_learning)
+            return;
+        UnpolarizedSpectrum value = depolarize(contrib);
+        for (uint32_t i = 0; i < count; ++i) {
+            Vertex &v = vertices[i];
+            masked(v.radiance, active && v.active) +=
+                select(neq(v.throughput, 0.f), value / v.throughput, 0.f);
+        }
+    }
+
+    /// Splat the incident radiance of the vertices into the building trees
+    void record(const Vertex *vertices, uint32_t count) const {
+        for (uint32_t i = 0; i < count; ++i) {
+            const Vertex &v = vertices[i];
+            Float value = hmean(v.radiance) / v.pdf;
+            for (size_t j = 0; j < Lanes; ++j) {
+                ScalarFloat value_j = lane(value, j);
+                if (!lane_mask(v.active, j) || !std::isfinite(value_j))
+                    continue;
+                lookup(lane(v.p, j))->building.record(dir_to_square(lane(v.d, j)), value_j);
+            }
+        }
+    }
+
+    /// Map a direction to the unit square (cosine of theta and azimuth)
+    static ScalarPoint2f dir_to_square(const ScalarVector3f &d) {
+        ScalarFloat cos_theta = std::min(std::max(d.z(), (ScalarFloat) -1.f), (ScalarFloat) 1.f),
+                    phi = std::atan2(d.y(), d.x()) * math::InvTwoPi<ScalarFloat>;
+        return ScalarPoint2f((cos_theta + 1.f) * .5f, phi < 0.f ? phi + 1.f : phi);
+    }
+
+    /// Inverse of \ref dir_to_square(), which preserves areas up to a factor of 4 pi
+    static ScalarVector3f square_to_dir(const ScalarPoint2f &p) {
+        ScalarFloat cos_theta = 2.f * p.x() - 1.f,
+                    sin_theta = safe_sqrt(1.f - sqr(cos_theta));
+        auto [s, c] = sincos(math::TwoPi<ScalarFloat> * p.y());
+        return ScalarVector3f(sin_theta * c, sin_theta * s, cos_theta);
+    }
+
+    static ScalarFloat lane(const Float &v, size_t i) {
+        if constexpr (is_array_v<Float>) {
+            return v.coeff(i);
+        } else {
+            ENOKI_MARK_USED(i);
+            return v;
+        }
+    }
+
+    static ScalarPoint3f lane(const Point3f &p, size_t i) {
+        return ScalarPoint3f(lane(p.x(), i), lane(p.y(), i), lane(p.z(), i));
+    }
+
+    static ScalarVector3f lane(const Vector3f &v, size_t i) {
+        return ScalarVector3f(lane(v.x(), i), lane(v.y(), i), lane(v.z(), i));
+    }
+
+    static bool lane_mask(const Mask &m, size_t i) {
+        return lane(select(m, Float(1.f), Float(0.f)), i) != 0.f;
+    }
+
+    static void set_lane(Float &v, size_t i, ScalarFloat value) {
+        if constexpr (is_array_v<Float>) {
+            v.coeff(i) = value;
+        } else {
+            ENOKI_MARK_USED(i);
+            v = value;
+        }
+    }
+
+private:
+    ScalarFloat m_bsdf_fraction;
+    ScalarFloat m_spatial_threshold;
+    ScalarFloat m_directional_threshold;
+    size_t m_learning_passes;
+
+    /// Are the building trees updated during the current pass?
+    bool m_learning = false;
+
+    /// Spatial tree over the cubic bounds \ref m_bbox, the root is the first node
+    ScalarBoundingBox3f m_bbox;
+    std::vector<SNode> m_nodes;
+    std::vector<std::unique_ptr<Leaf>> m_leaves;
+};
+
+MTS_IMPLEMENT_CLASS_VARIANT(GuidedPathIntegrator, MonteCarloIntegrator)
+MTS_EXPORT_PLUGIN(GuidedPathIntegrator, "Guided path tracer integrator");
+NAMESPACE_END(mitsuba)
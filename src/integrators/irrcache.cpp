@@ -0,0 +1,442 @@
+#include <mitsuba/core/properties.h>
+#include <mitsuba/core/ray.h>
+#include <mitsuba/render/bsdf.h>
+#include <mitsuba/render/emitter.h>
+#include <mitsuba/render/integrator.h>
+#include <mitsuba/render/irradiancecache.h>
+#include <mitsuba/render/records.h>
+#include <mitsuba/render/sampler.h>
+
+NAMESPACE_BEGIN(mitsuba)
+
+/**!
+
+.. _integrator-irrcache:
+
+Irradiance caching path tracer (:monosp:`irrcache`)
+---------------------------------------------------
+
+.. pluginparameters::
+
+ * - max_depth
+   - |int|
+   - Specifies the longest path depth in the generated output image (where -1
+     corresponds to :math:`\infty`). (Default: -1)
+ * - rr_depth
+   - |int|
+   - Specifies the minimum path depth, after which the implementation will start to use the
+     *russian roulette* path termination criterion. (Default: 5)
+ * - cache_samples
+   - |int|
+   - Number of hemisphere rays that estimate the irradiance of a cache record. (Default: 256)
+ * - cache_error
+   - |float|
+   - Error threshold of the interpolation, which scales the radius within which a record
+     is used. Larger values create fewer records. (Default: 0.2)
+ * - hide_emitters
+   - |bool|
+   - Hide directly visible emitters. (Default: no, i.e. |false|)
+
+This integrator is a variant of the :ref:`path tracer <integrator-path>` for fast,
+noise-free previews. The first bounce of the camera paths is sampled as usual, but at
+the following vertices with a purely diffuse BSDF, the path is terminated and the
+reflected radiance is computed from the irradiance cache of Ward et al. ("A Ray Tracing
+Solution for Diffuse Interreflection").
+
+The cache is filled on demand: when no record is close enough to a vertex, a new record
+is created there by tracing ``cache_samples`` stratified cosine-weighted rays over the
+hemisphere, each of which is continued by a regular path. The irradiance of the records
+is interpolated with the rotational and translational gradients of Ward and Heckbert
+("Irradiance Gradients"). The records are shared by all rendering threads through a
+lock-free octree, and they are kept between the passes of a render job.
+
+The result is biased, and it depends on the order in which the records are created,
+hence the rendering is not deterministic. It is typically free of noise in the indirect
+illumination at a fraction of the cost of the path tracer.
+
+.. note:: This integrator does not handle participating media and is only supported
+   by the RGB and monochromatic CPU variants.
+
+ */
+
+template <typename Float, typename Spectrum>
+class IrradianceCacheIntegrator : public MonteCarloIntegrator<Float, Spectrum> {
+public:
+    MTS_IMPORT_BASE(MonteCarloIntegrator, m_max_depth, m_rr_depth, m_hide_emitters)
+    MTS_IMPORT_TYPES(Scene, Sensor, Sampler, Medium, Emitter, EmitterPtr, BSDF, BSDFPtr)
+    using IrradianceCache = mitsuba::IrradianceCache<Float, Spectrum>;
+    using Record = typename IrradianceCache::Record;
+
+    IrradianceCacheIntegrator(const Properties &props) : Base(props) {
+        if constexpr (is_cuda_array_v<Float>)
+            Throw("The irradiance cache is only supported by the CPU variants.");
+        if constexpr (is_spectral_v<Spectrum> || is_polarized_v<Spectrum>)
+            Throw("The irradiance cache is only supported by the RGB and monochromatic variants.");
+
+        size_t samples = props.size_("cache_samples", 256);
+        if (samples == 0)
+            Throw("\"cache_samples\" must be at least 1!");
+
+        // Stratification of Ward and Heckbert with N = pi * M
+        m_strata_theta = std::max((uint32_t) 1,
+            (uint32_t) std::lround(std::sqrt(samples / math::Pi<double>)));
+        m_strata_phi = std::max((uint32_t) 1,
+            (uint32_t) std::lround((double) samples / m_strata_theta));
+
+        m_error = props.float_("cache_error", .2f);
+        if (!(m_error > 0.f))
+            Throw("\"cache_error\" must be a value > 0!");
+    }
+
+    bool uses_pass_hooks() const override { return true; }
+
+    void prepare_pass(const Scene *scene, const Sensor * /* sensor */, size_t pass,
+                      size_t /* pass_count */) override {
+        // Start from an empty cache in every render job
+        if (pass != 0)
+            return;
+
+        ScalarBoundingBox3f bbox = scene->bbox();
+        ScalarFloat diagonal = bbox.valid() ? norm(bbox.extents()) : 1.f;
+        m_min_radius = 1e-3f * diagonal;
+        m_max_radius = .1f * diagonal;
+        m_cache = new IrradianceCache(bbox, m_error);
+    }
+
+    void finish_pass(const Scene * /* scene */, const Sensor * /* sensor */, size_t pass,
+                     size_t /* pass_count */) override {
+        if (m_cache)
+            Log(Debug, "Irradiance caching pass %i: %i records.", pass + 1,
+                m_cache->record_count());
+    }
+
+    std::pair<Spectrum, Mask> sample(const Scene *scene,
+                                     Sampler *sampler,
+                                     const RayDifferential3f &ray,
+                                     const Medium * /* medium */,
+                                     Float * /* aovs */,
+                                     Mask active) const override {
+        MTS_MASKED_FUNCTION(ProfilerPhase::SamplingIntegratorSample, active);
+
+        if (!m_cache)
+            Throw("IrradianceCacheIntegrator: the cache was not created by prepare_pass()!");
+
+        SurfaceInteraction3f si = scene->ray_intersect(ray, active);
+        Mask valid_ray = si.is_valid();
+
+        Spectrum result = trace(scene, sampler, ray, si, m_max_depth, true,
+                                !m_hide_emitters, active);
+        return { result, valid_ray };
+    }
+
+    std::string to_string() const override {
+        return tfm::format("IrradianceCacheIntegrator[\n"
+            "  max_depth = %i,\n"
+            "  rr_depth = %i,\n"
+            "  cache_samples = %i,\n"
+            "  cache_error = %f\n"
+            "]", m_max_depth, m_rr_depth, m_strata_theta * m_strata_phi, m_error);
+    }
+
+    MTS_DECLARE_CLASS()
+protected:
+    /**
+     * \brief Path tracer with emitter sampling, starting at the first
+     * intersection \c si of \c ray
+     *
+     * When \c use_cache is set, the paths are terminated at their diffuse
+     * vertices after the first bounce, which reflect the cached irradiance.
+     */
+    Spectrum trace(const Scene *scene, Sampler *sampler, const RayDifferential3f &ray_,
+                   SurfaceInteraction3f si, int max_depth, bool use_cache,
+                   Mask count_emission, Mask active) const {
+        RayDifferential3f ray = ray_;
+        Spectrum throughput(1.f), result(0.f);
+        Float emission_weight(1.f);
+
+        for (int depth = 1;; ++depth) {
+            // ----------------- Intersection with emitters -----------------
+
+            EmitterPtr emitter = si.emitter(scene, active);
+            Mask active_e = active && count_emission && neq(emitter, nullptr);
+            if (any_or<true>(active_e))
+                result[active_e] += emission_weight * throughput * emitter->eval(si, active_e);
+
+            active &= si.is_valid();
+            if ((uint32_t) depth >= (uint32_t) max_depth || none_or<false>(active))
+                break;
+
+            BSDFContext ctx;
+            BSDFPtr bsdf = si.bsdf(ray);
+
+            // --------------------- Irradiance cache ---------------------
+
+            if (use_cache && depth > 1) {
+                UInt32 flags = bsdf->flags();
+                Mask cached = active && has_flag(flags, BSDFFlags::DiffuseReflection) &&
+                              !has_flag(flags, BSDFFlags::Glossy) &&
+                              !has_flag(flags, BSDFFlags::Delta) &&
+                              !has_flag(flags, BSDFFlags::Transmission) &&
+                              !has_flag(flags, BSDFFlags::Null) &&
+                              Frame3f::cos_theta(si.wi) > 0.f;
+
+                if (any_or<true>(cached)) {
+                    // The diffuse BSDF reflects albedo / pi of the irradiance in every direction
+                    Spectrum bsdf_val =
+                        bsdf->eval(ctx, si, Vector3f(0.f, 0.f, 1.f), cached);
+                    result[cached] +=
+                        throughput * bsdf_val * irradiance(scene, sampler, si, cached);
+                    active &= !cached;
+                    if (none_or<false>(active))
+                        break;
+                }
+            }
+
+            // --------------------- Emitter sampling ---------------------
+
+            Mask active_s = active && has_flag(bsdf->flags(), BSDFFlags::Smooth);
+            if (likely(any_or<true>(active_s))) {
+                auto [ds, emitter_val] = scene->sample_emitter_direction(
+                    si, sampler->next_2d(active_s), true, active_s);
+                active_s &= neq(ds.pdf, 0.f);
+
+                auto [bsdf_val, bsdf_pdf] =
+                    bsdf->eval_pdf(ctx, si, si.to_local(ds.d), active_s);
+                Float mis = select(ds.delta, Float(1.f), mis_weight(ds.pdf, bsdf_pdf));
+                result[active_s] += mis * throughput * bsdf_val * emitter_val;
+            }
+
+            // ----------------------- BSDF sampling ----------------------
+
+            auto [bs, bsdf_weight] = bsdf->sample(ctx, si, sampler->next_1d(active),
+                                                  sampler->next_2d(active), active);
+            throughput *= bsdf_weight;
+            active &= any(neq(depolarize(throughput), 0.f));
+            if (none_or<false>(active))
+                break;
+
+            ray = si.spawn_ray(si.to_world(bs.wo));
+            SurfaceInteraction3f si_bsdf = scene->ray_intersect(ray, active);
+
+            /* Determine probability of having sampled that same
+               direction using emitter sampling. */
+            emitter = si_bsdf.emitter(scene, active);
+            DirectionSample3f ds(si_bsdf, si);
+            ds.object = emitter;
+
+            if (any_or<true>(neq(emitter, nullptr))) {
+                Float emitter_pdf =
+                    select(neq(emitter, nullptr) && !has_flag(bs.sampled_type, BSDFFlags::Delta),
+                           scene->pdf_emitter_direction(si, ds),
+                           0.f);
+                emission_weight = mis_weight(bs.pdf, emitter_pdf);
+            }
+
+            si = std::move(si_bsdf);
+            count_emission = true;
+
+            if (depth >= m_rr_depth) {
+                Float q = min(hmax(depolarize(throughput)), .95f);
+                active &= sampler->next_1d(active) < q;
+                throughput *= rcp(q);
+            }
+        }
+
+        return result;
+    }
+
+    /// Interpolated irradiance at \c si, which creates the missing records
+    Spectrum irradiance(const Scene *scene, Sampler *sampler, const SurfaceInteraction3f &si,
+                        Mask active) const {
+        Spectrum result(0.f);
+        for (size_t i = 0; i < Lanes; ++i) {
+            if (!lane_mask(active, i))
+                continue;
+
+            ScalarPoint3f p = lane(si.p, i);
+            ScalarVector3f n = lane(Vector3f(si.sh_frame.n), i);
+
+            ScalarColor3f value;
+            if (!m_cache->lookup(p, n, value)) {
+                Record record = create_record(scene, sampler, p, n, lane(si.time, i));
+                m_cache->insert(record);
+                value = record.irradiance;
+            }
+
+            for (size_t j = 0; j < array_size_v<Spectrum>; ++j)
+                set_lane(result[j], i, value[j]);
+        }
+        return result;
+    }
+
+    /// Estimate the irradiance and its gradients at \c p from stratified hemisphere rays
+    Record create_record(const Scene *scene, Sampler *sampler, const ScalarPoint3f &p,
+                         const ScalarVector3f &n, ScalarFloat time) const {
+        const uint32_t M = m_strata_theta, N = m_strata_phi, count = M * N;
+        ScalarFrame3f frame(n);
+
+        std::vector<ScalarColor3f> radiance(count);
+        std::vector<ScalarFloat> distance(count);
+
+        // The records are shared by the whole path, hence their paths start at its first bounce
+        int max_depth = m_max_depth < 0 ? -1 : std::max(m_max_depth - 2, 1);
+        ScalarFloat mint = (1.f + hmax(abs(p))) * math::RayEpsilon<ScalarFloat>;
+
+        for (uint32_t offset = 0; offset < count; offset += (uint32_t) Lanes) {
+            UInt32 index;
+            if constexpr (is_array_v<Float>)
+                index = offset + arange<UInt32>();
+            else
+                index = offset;
+            Mask active = index < count;
+
+            UInt32 j = index / N, k = index - j * N;
+            Point2f sample = sampler->next_2d(active);
+
+            // Cosine-weighted direction within stratum (j, k)
+            Float cos_theta = sqrt(max(1.f - (Float(j) + sample.x()) / (ScalarFloat) M, 0.f)),
+                  sin_theta = safe_sqrt(1.f - sqr(cos_theta));
+            auto [sin_phi, cos_phi] =
+                sincos((Float(k) + sample.y()) * (math::TwoPi<ScalarFloat> / N));
+
+            Vector3f d = Vector3f(frame.s) * (sin_theta * cos_phi) +
+                         Vector3f(frame.t) * (sin_theta * sin_phi) +
+                         Vector3f(frame.n) * cos_theta;
+
+            RayDifferential3f ray(Ray3f(Point3f(p), d, mint, math::Infinity<Float>,
+                                        Float(time), Wavelength()));
+            SurfaceInteraction3f si = scene->ray_intersect(ray, active);
+            Float t = select(si.is_valid(), si.t, math::Infinity<Float>);
+
+            Spectrum value = trace(scene, sampler, ray, si, max_depth, false, true, active);
+
+            for (size_t i = 0; i < Lanes && offset + i < count; ++i) {
+                for (size_t c = 0; c < 3; ++c)
+                    radiance[offset + i][c] =
+                        lane(value[std::min(c, array_size_v<Spectrum> - 1)], i);
+                distance[offset + i] = lane(t, i);
+            }
+        }
+
+        Record record;
+        record.p = p;
+        record.n = n;
+
+        // Irradiance and harmonic mean distance
+        ScalarColor3f sum(0.f);
+        ScalarFloat inv_distance_sum = 0.f;
+        for (uint32_t i = 0; i < count; ++i) {
+            sum += radiance[i];
+            inv_distance_sum += 1.f / distance[i];
+        }
+        record.irradiance = sum * (math::Pi<ScalarFloat> / count);
+        record.radius = inv_distance_sum > 0.f ? count / inv_distance_sum : m_max_radius;
+        record.radius = clamp(record.radius, m_min_radius, m_max_radius);
+
+        // Gradients of Ward and Heckbert in the local frame of the record
+        ScalarVector3f grad_r[3], grad_t[3];
+        for (size_t c = 0; c < 3; ++c)
+            grad_r[c] = grad_t[c] = 0.f;
+
+        auto L = [&](uint32_t j, uint32_t k) -> const ScalarColor3f & {
+            return radiance[j * N + k];
+        };
+        auto R = [&](uint32_t j, uint32_t k) { return distance[j * N + k]; };
+
+        for (uint32_t k = 0; k < N; ++k) {
+            uint32_t k_prev = (k + N - 1) % N;
+            ScalarFloat phi_minus = k * (math::TwoPi<ScalarFloat> / N),
+                        phi = (k + .5f) * (math::TwoPi<ScalarFloat> / N);
+            ScalarVector3f u_k(std::cos(phi_minus), std::sin(phi_minus), 0.f),
+                           v_k_minus(-std::sin(phi_minus), std::cos(phi_minus), 0.f),
+                           v_k(-std::sin(phi), std::cos(phi), 0.f);
+
+            for (uint32_t j = 0; j < M; ++j) {
+                ScalarFloat cos2_minus = 1.f - (ScalarFloat) j / M,
+                            cos_minus  = std::sqrt(cos2_minus),
+                            cos_plus   = std::sqrt(std::max(1.f - (j + 1.f) / M, 0.f)),
+                            cos_center = std::sqrt(1.f - (j + .5f) / M),
+                            sin_center = std::sqrt(std::max(1.f - sqr(cos_center), 0.f)),
+                            tan_center = sin_center / cos_center;
+
+                for (size_t c = 0; c < 3; ++c) {
+                    grad_r[c] -= v_k * (tan_center * L(j, k)[c]);
+
+                    // Change of the solid angle of the boundary between strata along theta
+                    if (j > 0) {
+                        ScalarFloat sin_minus = std::sqrt((ScalarFloat) j / M);
+                        grad_t[c] += u_k * (math::TwoPi<ScalarFloat> / N * sin_minus *
+                                            cos2_minus / std::min(R(j, k), R(j - 1, k)) *
+                                            (L(j, k)[c] - L(j - 1, k)[c]));
+                    }
+
+                    // ... and along phi
+                    if (N > 1)
+                        grad_t[c] += v_k_minus * ((cos_minus - cos_plus) /
+                                                  (sin_center * std::min(R(j, k), R(j, k_prev))) *
+                                                  (L(j, k)[c] - L(j, k_prev)[c]));
+                }
+            }
+        }
+
+        for (size_t c = 0; c < 3; ++c) {
+            record.grad_r[c] = frame.to_world(grad_r[c] * (math::Pi<ScalarFloat> / count));
+            record.grad_t[c] = frame.to_world(grad_t[c]);
+        }
+
+        return record;
+    }
+
+    Float mis_weight(Float pdf_a, Float pdf_b) const {
+        pdf_a *= pdf_a;
+        pdf_b *= pdf_b;
+        return select(pdf_a > 0.f, pdf_a / (pdf_a + pdf_b), Float(0.f));
+    }
+
+    static ScalarFloat lane(const Float &v, size_t i) {
+        if constexpr (is_array_v<Float>) {
+            return v.coeff(i);
+        } else {
+            ENOKI_MARK_USED(i);
+            return v;
+        }
+    }
+
+    static ScalarPoint3f lane(const Point3f &p, size_t i) {
+        return ScalarPoint3f(lane(p.x(), i), lane(p.y(), i), lane(p.z(), i));
+    }
+
+    static ScalarVector3f lane(const Vector3f &v, size_t i) {
+        return ScalarVector3f(lane(v.x(), i), lane(v.y(), i), lane(v.z(), i));
+    }
+
+    static bool lane_mask(const Mask &m, size_t i) {
+        return lane(select(m, Float(1.f), Float(0.f)), i) != 0.f;
+    }
+
+    static void set_lane(Float &v, size_t i, ScalarFloat value) {
+        if constexpr (is_array_v<Float>) {
+            v.coeff(i) = value;
+        } else {
+            ENOKI_MARK_USED(i);
+            v = value;
+        }
+    }
+
+private:
+    /// Number of values per packet (the cache processes one lane at a time)
+    static constexpr size_t Lanes =
+        (is_array_v<Float> && !is_cuda_array_v<Float>) ? array_size_v<Float> : 1;
+
+    /// Number of hemisphere strata along theta and phi
+    uint32_t m_strata_theta, m_strata_phi;
+    ScalarFloat m_error;
+
+    /// Bounds of the harmonic mean distance of the records
+    ScalarFloat m_min_radius = 0.f, m_max_radius = 0.f;
+    ref<IrradianceCache> m_cache;
+};
+
+MTS_IMPLEMENT_CLASS_VARIANT(IrradianceCacheIntegrator, MonteCarloIntegrator)
+MTS_EXPORT_PLUGIN(IrradianceCacheIntegrator, "Irradiance caching path tracer");
+NAMESPACE_END(mitsuba)
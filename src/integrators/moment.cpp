@@ -22,6 +22,11 @@ Moment integrator (:monosp:`moment`)
 This integrator returns one AOVs recording the second moment of the samples of the nested
 integrator.
 
+To estimate the variance of a rendered image, enabling the :monosp:`variance` option of the
+:ref:`hdrfilm <film-hdrfilm>` plugin (with :monosp:`variance_type` set to :monosp:`rgb`) is
+usually preferable: it works with any integrator, and the film computes the variance of every
+pixel from second moments that are accumulated along with the image.
+
  */
 
 template <typename Float, typename Spectrum>
@@ -1,11 +1,15 @@
+#include <algorithm>
 #include <random>
 #include <enoki/stl.h>
 #include <mitsuba/core/ray.h>
 #include <mitsuba/core/properties.h>
+#include <mitsuba/core/random.h>
+#include <mitsuba/core/statistics.h>
 #include <mitsuba/render/bsdf.h>
 #include <mitsuba/render/emitter.h>
 #include <mitsuba/render/integrator.h>
 #include <mitsuba/render/records.h>
+#include <mitsuba/render/rrs.h>
 
 NAMESPACE_BEGIN(mitsuba)
 
@@ -27,9 +31,59 @@ Path tracer (:monosp:`path`)
    - |int|
    - Specifies the minimum path depth, after which the implementation will start to use the
      *russian roulette* path termination criterion. (Default: 5)
+ * - emitter_samples
+   - |int|
+   - Number of emitter samples per path vertex. Their shadow rays are traced together after
+     the samples are weighted by the BSDF, which skips the rays of samples that do not
+     contribute. Values above one are not supported in wavefront mode, which is then
+     disabled. (Default: 1)
+ * - wavefront
+   - |bool|
+   - In packet variants, advance all paths of an image block by one bounce at a time and
+     compact the terminated paths between bounces, which keeps SIMD lanes occupied in scenes
+     with many short paths. (Default: |false|)
+ * - sort_rays
+   - |bool|
+   - In wavefront mode, sort the secondary rays of each bounce by direction octant and origin
+     before packing them into packets, which improves the coherence of kd-tree traversal.
+     (Default: |true|)
+ * - sort_materials
+   - |bool|
+   - In wavefront mode, group the surface interactions of each bounce by BSDF before emitter
+     and BSDF sampling, so that each packet mostly evaluates a single material instead of one
+     masked evaluation per distinct BSDF. (Default: |true|)
+ * - coalesce_rays
+   - |bool|
+   - In GPU variants, trace the shadow ray of the emitter sample and the continuation ray
+     of each bounce with a single OptiX launch (see :py:meth:`mitsuba.render.Scene.ray_intersect_and_test`)
+     instead of one launch each. Only used with a single emitter sample per vertex.
+     (Default: |true|)
+ * - filter_importance_sampling
+   - |bool|
+   - Place the camera rays of each pixel according to the reconstruction filter of the
+     film and add every sample to its own pixel only, instead of splatting it over the
+     footprint of the filter. This removes the image block borders and the overlapping
+     writes, at the cost of a slightly noisier image for wide filters. Filters with negative
+     lobes (e.g. :monosp:`lanczos`) produce samples with negative weights. (Default: |false|)
  * - hide_emitters
    - |bool|
    - Hide directly visible emitters. (Default: no, i.e. |false|)
+ * - rr_mode
+   - |string|
+   - Russian roulette strategy: ``throughput`` terminates paths based on their throughput
+     after ``rr_depth`` bounces, ``adaptive`` learns efficiency-aware Russian roulette and
+     splitting factors during the first passes (see below). (Default: ``throughput``)
+ * - rrs_learning_passes
+   - |int|
+   - Number of passes that learn the adaptive factors (Default: 4)
+ * - rrs_resolution
+   - |int|
+   - Number of cells of the grid over the scene that stores the adaptive factors, along
+     each axis. (Default: 16)
+ * - rrs_min_survival, rrs_max_split
+   - |float|
+   - Smallest survival probability and largest splitting factor of the adaptive
+     mode. (Default: 0.05 and 8)
 
 This integrator implements a basic path tracer and is a **good default choice**
 when there is no strong reason to prefer another method.
@@ -63,6 +117,25 @@ sampling to combine BSDF and emitter samples. The main difference in comparison
 to the former plugin is that it considers light paths of arbitrary length to compute
 both direct and indirect illumination.
 
+The adaptive Russian roulette and splitting mode (``rr_mode="adaptive"``) follows
+Rath et al. ("EARS: Efficiency-Aware Russian Roulette and Splitting"). It
+terminates paths that reach regions whose remaining paths contribute little, and
+splits paths in regions that contribute much of the variance of the image, so
+as to maximize the efficiency of the estimator. The factors are learned over
+the first ``rrs_learning_passes`` passes (see the ``samples_per_pass`` parameter),
+which use the regular Russian roulette, hence renders should use several passes
+(e.g. 16 passes of 4 samples per pixel). This mode is only supported by the CPU
+variants and disables the wavefront mode.
+
+In differentiable variants, the path tracer also supports *path replay
+backpropagation* (see :py:func:`mitsuba.python.autodiff.render_adjoint`):
+instead of recording the computation graph of entire paths for reverse-mode
+differentiation, whose size grows with the number of samples and the path
+length, the paths are traced a second time with the same random numbers, and
+the gradient of each vertex is propagated to the scene parameters before the
+next one is visited. Memory usage is then independent of the path length.
+Gradients with respect to the scene geometry are not supported in this mode.
+
 .. _sec-path-strictnormals:
 
 .. Commented out for now
@@ -93,20 +166,71 @@ template <typename Float, typename Spectrum>
 class PathIntegrator : public MonteCarloIntegrator<Float, Spectrum> {
 public:
     MTS_IMPORT_BASE(MonteCarloIntegrator, m_max_depth, m_rr_depth)
-    MTS_IMPORT_TYPES(Scene, Sampler, Medium, Emitter, EmitterPtr, BSDF, BSDFPtr)
+    MTS_IMPORT_TYPES(Scene, Sensor, Sampler, Medium, Emitter, EmitterPtr, BSDF, BSDFPtr)
+    using RRSCache = mitsuba::RRSCache<Float, Spectrum>;
+    using RRSVertex = typename RRSCache::Vertex;
+
+    PathIntegrator(const Properties &props) : Base(props) {
+        m_sort_rays = props.bool_("sort_rays", true);
+        m_sort_materials = props.bool_("sort_materials", true);
+        m_emitter_samples = props.size_("emitter_samples", 1);
+        if (m_emitter_samples == 0)
+            Throw("\"emitter_samples\" must be at least 1!");
+        m_coalesce_rays = is_cuda_array_v<Float> && m_emitter_samples == 1 &&
+                          props.bool_("coalesce_rays", true);
+
+        std::string rr_mode = props.string("rr_mode", "throughput");
+        if (rr_mode == "adaptive") {
+            if constexpr (is_diff_array_v<Float>)
+                Throw("Adaptive Russian roulette and splitting is not supported by the "
+                      "differentiable variants.");
+            m_rrs = new RRSCache(props);
+        } else if (rr_mode != "throughput") {
+            Throw("Invalid Russian roulette mode \"%s\", must be one of: \"throughput\" "
+                  "or \"adaptive\"!", rr_mode);
+        }
+    }
+
+    bool uses_pass_hooks() const override { return m_rrs != nullptr; }
 
-    PathIntegrator(const Properties &props) : Base(props) { }
+    void prepare_pass(const Scene *scene, const Sensor * /* sensor */, size_t pass,
+                      size_t /* pass_count */) override {
+        if (m_rrs)
+            m_rrs->prepare_pass(scene, pass);
+    }
+
+    void finish_pass(const Scene * /* scene */, const Sensor * /* sensor */, size_t pass,
+                     size_t /* pass_count */) override {
+        if (m_rrs)
+            m_rrs->finish_pass(pass);
+    }
 
     std::pair<Spectrum, Mask> sample(const Scene *scene,
                                      Sampler *sampler,
-                                     const RayDifferential3f &ray_,
-                                     const Medium * /* medium */,
-                                     Float * /* aovs */,
+                                     const RayDifferential3f &ray,
+                                     const Medium *medium,
+                                     Float *aovs,
                                      Mask active) const override {
+        return sample_with_interaction(scene, sampler, ray, scene->ray_intersect(ray, active),
+                                       medium, aovs, active);
+    }
+
+    std::pair<Spectrum, Mask>
+    sample_with_interaction(const Scene *scene,
+                            Sampler *sampler,
+                            const RayDifferential3f &ray_,
+                            const SurfaceInteraction3f &si_,
+                            const Medium * /* medium */,
+                            Float * /* aovs */,
+                            Mask active) const override {
         MTS_MASKED_FUNCTION(ProfilerPhase::SamplingIntegratorSample, active);
 
         RayDifferential3f ray = ray_;
 
+        /* Without polarizing BSDFs, all Mueller matrices are depolarizers:
+           skip their change of basis and only track the (1,1) entries */
+        bool polarizing = scene->has_polarizing_bsdfs();
+
         // Tracks radiance scaling due to index of refraction changes
         Float eta(1.f);
 
@@ -117,36 +241,74 @@ public:
 
         // ---------------------- First intersection ----------------------
 
-        SurfaceInteraction3f si = scene->ray_intersect(ray, active);
+        SurfaceInteraction3f si = si_;
         Mask valid_ray = si.is_valid();
         EmitterPtr emitter = si.emitter(scene);
 
-        for (int depth = 1;; ++depth) {
-
-            // ---------------- Intersection with emitters ----------------
-
-            if (any_or<true>(neq(emitter, nullptr)))
-                result[active] += emission_weight * throughput * emitter->eval(si, active);
+        // Number of surface interactions of each path (for the statistics)
+        UInt32 path_length = 0;
 
-            active &= si.is_valid();
+        /* Adaptive Russian roulette and splitting: the learning passes record
+           the vertices of the paths, later passes continue the split copies
+           of a path once the path itself has terminated */
+        bool rrs_learning = m_rrs && m_rrs->learning(),
+             rrs_ready    = m_rrs && m_rrs->ready();
+        RRSVertex rrs_vertices[RRSCache::MaxVertices];
+        uint32_t rrs_vertex_count = 0;
+        std::vector<Branch> branches;
+        bool resume = false;
 
-            /* Russian roulette: try to keep path weights equal to one,
-               while accounting for the solid angle compression at refractive
-               index boundaries. Stop with at least some probability to avoid
-               getting stuck (e.g. due to total internal reflection) */
-            if (depth > m_rr_depth) {
-                Float q = min(hmax(depolarize(throughput)) * sqr(eta), .95f);
-                active &= sampler->next_1d(active) < q;
-                throughput *= rcp(q);
+        for (int depth = 1;; ++depth) {
+            if (!resume) {
+                // ---------------- Intersection with emitters ----------------
+
+                if (any_or<true>(neq(emitter, nullptr)))
+                    result[active] += emission_weight *
+                        mueller_product(throughput, emitter->eval(si, active), polarizing);
+
+                active &= si.is_valid();
+                if (stats_enabled || rrs_learning)
+                    masked(path_length, active) = (uint32_t) depth;
+
+                if (rrs_ready) {
+                    // Paths at the maximal depth are not worth splitting
+                    if ((uint32_t) depth < (uint32_t) m_max_depth)
+                        split(si, ray, throughput, eta, active, depth, sampler, branches);
+                } else if (depth > m_rr_depth) {
+                    /* Russian roulette: try to keep path weights equal to one,
+                       while accounting for the solid angle compression at refractive
+                       index boundaries. Stop with at least some probability to avoid
+                       getting stuck (e.g. due to total internal reflection) */
+                    Float q = min(hmax(depolarize(throughput)) * sqr(eta), .95f);
+                    Mask rr_continue = sampler->next_1d(active) < q;
+                    stats_count(StatsCounter::RRTerminations, active && !rr_continue);
+                    active &= rr_continue;
+                    throughput *= rcp(q);
+                }
+
+                if (rrs_learning && rrs_vertex_count < RRSCache::MaxVertices) {
+                    RRSVertex &v = rrs_vertices[rrs_vertex_count++];
+                    v.p        = si.p;
+                    v.weight   = hmean(depolarize(throughput));
+                    v.radiance = hmean(depolarize(result));
+                    v.length   = path_length;
+                    v.active   = active;
+                }
             }
+            resume = false;
 
             // Stop if we've exceeded the number of requested bounces, or
             // if there are no more active lanes. Only do this latter check
             // in GPU mode when the number of requested bounces is infinite
             // since it causes a costly synchronization.
             if ((uint32_t) depth >= (uint32_t) m_max_depth ||
-                ((!is_cuda_array_v<Float> || m_max_depth < 0) && none(active)))
-                break;
+                ((!is_cuda_array_v<Float> || m_max_depth < 0) && none(active))) {
+                if (branches.empty())
+                    break;
+                resume_branch(si, ray, throughput, eta, active, depth, branches);
+                resume = true;
+                continue;
+            }
 
             // --------------------- Emitter sampling ---------------------
 
@@ -154,21 +316,21 @@ public:
             BSDFPtr bsdf = si.bsdf(ray);
             Mask active_e = active && has_flag(bsdf->flags(), BSDFFlags::Smooth);
 
-            if (likely(any_or<true>(active_e))) {
-                auto [ds, emitter_val] = scene->sample_emitter_direction(
-                    si, sampler->next_2d(active_e), true, active_e);
-                active_e &= neq(ds.pdf, 0.f);
-
-                // Query the BSDF for that emitter-sampled direction
-                Vector3f wo = si.to_local(ds.d);
-                Spectrum bsdf_val = bsdf->eval(ctx, si, wo, active_e);
-                bsdf_val = si.to_world_mueller(bsdf_val, -wo, si.wi);
-
-                // Determine density of sampling that same direction using BSDF sampling
-                Float bsdf_pdf = bsdf->pdf(ctx, si, wo, active_e);
+            /* When coalescing rays, the shadow ray is only traced along with
+               the continuation ray below, and \c emitter_result is added
+               to the result of the unoccluded lanes then */
+            Ray3f shadow_ray;
+            Mask active_shadow = false;
+            Spectrum emitter_result(0.f);
 
-                Float mis = select(ds.delta, 1.f, mis_weight(ds.pdf, bsdf_pdf));
-                result[active_e] += mis * throughput * bsdf_val * emitter_val;
+            if (likely(any_or<true>(active_e))) {
+                emitter_result[active_e] = mueller_product(
+                    throughput,
+                    sample_emitters(scene, sampler, si, bsdf, active_e, polarizing,
+                                    m_coalesce_rays ? &shadow_ray : nullptr, &active_shadow),
+                    polarizing);
+                if (!m_coalesce_rays)
+                    result += emitter_result;
             }
 
             // ----------------------- BSDF sampling ----------------------
@@ -176,18 +338,35 @@ public:
             // Sample BSDF * cos(theta)
             auto [bs, bsdf_val] = bsdf->sample(ctx, si, sampler->next_1d(active),
                                                sampler->next_2d(active), active);
-            bsdf_val = si.to_world_mueller(bsdf_val, -bs.wo, si.wi);
+            if (polarizing)
+                bsdf_val = si.to_world_mueller(bsdf_val, -bs.wo, si.wi);
 
-            throughput = throughput * bsdf_val;
+            throughput = mueller_product(throughput, bsdf_val, polarizing);
             active &= any(neq(depolarize(throughput), 0.f));
-            if (none_or<false>(active))
-                break;
+            if (none_or<false>(active)) {
+                if (m_coalesce_rays && any_or<true>(active_shadow))
+                    result[active_shadow && !scene->ray_test(shadow_ray, active_shadow)] +=
+                        emitter_result;
+                if (branches.empty())
+                    break;
+                resume_branch(si, ray, throughput, eta, active, depth, branches);
+                resume = true;
+                continue;
+            }
 
             eta *= bs.eta;
 
             // Intersect the BSDF ray against the scene geometry
             ray = si.spawn_ray(si.to_world(bs.wo));
-            SurfaceInteraction3f si_bsdf = scene->ray_intersect(ray, active);
+            SurfaceInteraction3f si_bsdf;
+            if (m_coalesce_rays) {
+                Mask occluded;
+                std::tie(si_bsdf, occluded) =
+                    scene->ray_intersect_and_test(ray, shadow_ray, active, active_shadow);
+                result[active_shadow && !occluded] += emitter_result;
+            } else {
+                si_bsdf = scene->ray_intersect(ray, active);
+            }
 
             /* Determine probability of having sampled that same
                direction using emitter sampling. */
@@ -201,23 +380,539 @@ public:
                            scene->pdf_emitter_direction(si, ds),
                            0.f);
 
-                emission_weight = mis_weight(bs.pdf, emitter_pdf);
+                emission_weight = mis_weight(bs.pdf, emitter_pdf * (ScalarFloat) m_emitter_samples);
             }
 
             si = std::move(si_bsdf);
         }
 
+        if (rrs_learning)
+            m_rrs->record(rrs_vertices, rrs_vertex_count, hmean(depolarize(result)),
+                          path_length, valid_ray);
+
+        stats_histogram(StatsHistogram::PathLength, path_length, valid_ray);
         return { result, valid_ray };
     }
 
+    /// Path state at a scattering vertex, which is continued by \ref resume_branch()
+    struct Branch {
+        SurfaceInteraction3f si;
+        RayDifferential3f ray;
+        Spectrum throughput;
+        Float eta;
+        Mask active;
+        int depth;
+    };
+
+    /**
+     * \brief Adaptive Russian roulette and splitting at a scattering vertex
+     *
+     * The path itself is one of the copies chosen by \ref m_rrs (or is
+     * terminated), and the other ones are pushed onto \c branches.
+     */
+    void split(const SurfaceInteraction3f &si, const RayDifferential3f &ray, Spectrum &throughput,
+               const Float &eta, Mask &active, int depth, Sampler *sampler,
+               std::vector<Branch> &branches) const {
+        // Regions that have not learned anything use the regular Russian roulette
+        Float rr_prob = 1.f;
+        if (depth > m_rr_depth)
+            rr_prob = min(hmax(depolarize(throughput)) * sqr(eta), .95f);
+
+        auto [copies, q] = m_rrs->split(si.p, hmean(depolarize(throughput)), rr_prob,
+                                        sampler->next_1d(active),
+                                        branches.size() < RRSCache::MaxBranches, active);
+        stats_count(StatsCounter::RRTerminations, active && eq(copies, 0u));
+        active &= copies > 0u;
+        throughput *= rcp(q);
+
+        uint32_t max_copies = hmax(copies);
+        for (uint32_t i = 1; i < max_copies; ++i)
+            branches.push_back(Branch{ si, ray, throughput, eta, active && copies > i, depth });
+    }
+
+    /// Continue with the most recent branch of \ref split()
+    void resume_branch(SurfaceInteraction3f &si, RayDifferential3f &ray, Spectrum &throughput,
+                       Float &eta, Mask &active, int &depth, std::vector<Branch> &branches) const {
+        Branch &branch = branches.back();
+        si         = branch.si;
+        ray        = branch.ray;
+        throughput = branch.throughput;
+        eta        = branch.eta;
+        active     = branch.active;
+        // The loop increment leads back to the depth of the vertex
+        depth      = branch.depth - 1;
+        branches.pop_back();
+    }
+
+    /**
+     * \brief Next event estimation with \ref m_emitter_samples samples,
+     * which are MIS-weighted against the single BSDF sample
+     *
+     * Returns the emitted radiance reflected by \c bsdf towards <tt>si.wi</tt>.
+     * When \c polarizing is \c false, the Mueller matrices are treated as
+     * depolarizers (see \ref Scene::has_polarizing_bsdfs()).
+     *
+     * When \c shadow_ray is given (which requires a single emitter sample),
+     * the visibility test is left to the caller: the returned radiance
+     * ignores occlusion, and \c shadow_ray and \c shadow_active receive the
+     * shadow ray and the lanes that need tracing it.
+     */
+    Spectrum sample_emitters(const Scene *scene, Sampler *sampler,
+                             const SurfaceInteraction3f &si, const BSDFPtr &bsdf,
+                             Mask active, bool polarizing = true,
+                             Ray3f *shadow_ray = nullptr,
+                             Mask *shadow_active = nullptr) const {
+        BSDFContext ctx;
+        Point2f samples[EmitterBatch];
+        DirectionSample3f ds[EmitterBatch];
+        Spectrum contrib[EmitterBatch], result(0.f);
+        ScalarFloat n = (ScalarFloat) m_emitter_samples;
+
+        for (size_t offset = 0; offset < m_emitter_samples; offset += EmitterBatch) {
+            size_t count = std::min(m_emitter_samples - offset, EmitterBatch);
+            for (size_t i = 0; i < count; ++i)
+                samples[i] = sampler->next_2d(active);
+
+            /* Draw a batch of emitter samples, weight them by the BSDF, and
+               only then trace the shadow rays of those that contribute */
+            scene->sample_emitter_directions(si, samples, count, ds, contrib, false, active);
+
+            for (size_t i = 0; i < count; ++i) {
+                Mask active_e = active && neq(ds[i].pdf, 0.f);
+
+                // Query the BSDF for that emitter-sampled direction
+                Vector3f wo = si.to_local(ds[i].d);
+                // Also determine the density of sampling that same direction using BSDF sampling
+                auto [bsdf_val, bsdf_pdf] = bsdf->eval_pdf(ctx, si, wo, active_e);
+                if (polarizing)
+                    bsdf_val = si.to_world_mueller(bsdf_val, -wo, si.wi);
+
+                Float mis = select(ds[i].delta, 1.f, mis_weight(ds[i].pdf * n, bsdf_pdf)) / n;
+                contrib[i] = mis * mueller_product(bsdf_val, contrib[i], polarizing);
+                contrib[i][!active_e] = 0.f;
+            }
+
+            if (shadow_ray) {
+                Assert(count == 1);
+                *shadow_ray = Ray3f(si.p, ds[0].d,
+                                    math::RayEpsilon<Float> * (1.f + hmax(abs(si.p))),
+                                    ds[0].dist * (1.f - math::ShadowEpsilon<Float>),
+                                    si.time, si.wavelengths);
+                *shadow_active = active && neq(ds[0].pdf, 0.f) &&
+                                 any(neq(depolarize(contrib[0]), 0.f));
+            } else {
+                scene->ray_test_emitter_directions(si, ds, count, contrib, active);
+            }
+
+            for (size_t i = 0; i < count; ++i)
+                result += contrib[i];
+        }
+
+        return result;
+    }
+
+    /**
+     * \brief Path replay backpropagation
+     *
+     * Retraces the paths of \ref sample() with the same random numbers and
+     * backpropagates the contribution of each vertex before moving on to
+     * the next one. The radiance scattered by the remainder of the path is
+     * recovered by subtracting the contributions of the visited vertices
+     * from the primal radiance, hence only the current vertex is part of
+     * the computation graph at any time.
+     *
+     * Gradients with respect to the BSDF, emitter and texture parameters are
+     * computed. Gradients with respect to the geometry are not supported, and
+     * the indirect illumination scattered by delta lobes does not contribute
+     * to the gradient of their parameters.
+     */
+    void sample_adjoint(const Scene *scene,
+                        Sampler *sampler,
+                        const RayDifferential3f &ray_,
+                        const Medium * /* medium */,
+                        const Spectrum &radiance,
+                        const Spectrum &adjoint_,
+                        Mask active) const override {
+        if constexpr (is_diff_array_v<Float> && !is_polarized_v<Spectrum>) {
+            RayDifferential3f ray = detach(ray_);
+            Spectrum adjoint = detach(adjoint_),
+                     L       = detach(radiance);
+
+            Float eta(1.f), emission_weight(1.f);
+            Spectrum throughput(1.f);
+
+            SurfaceInteraction3f si = scene->ray_intersect(ray, active);
+            EmitterPtr emitter = si.emitter(scene);
+
+            /* The control flow and the use of the sampler below must match
+               sample() exactly so that the same paths are generated. */
+            for (int depth = 1;; ++depth) {
+                Spectrum contrib(0.f);
+
+                // ---------------- Intersection with emitters ----------------
+
+                if (any_or<true>(neq(emitter, nullptr))) {
+                    Spectrum Le = emission_weight * throughput * emitter->eval(si, active);
+                    Le[!active] = 0.f;
+                    L -= detach(Le);
+                    contrib += Le;
+                }
+
+                active &= si.is_valid();
+
+                // Russian roulette (see sample())
+                if (depth > m_rr_depth) {
+                    Float q = min(hmax(throughput) * sqr(eta), .95f);
+                    active &= sampler->next_1d(active) < q;
+                    throughput *= rcp(q);
+                }
+
+                if ((uint32_t) depth >= (uint32_t) m_max_depth ||
+                    ((!is_cuda_array_v<Float> || m_max_depth < 0) && none(active))) {
+                    backpropagate(adjoint, contrib);
+                    break;
+                }
+
+                // --------------------- Emitter sampling ---------------------
+
+                BSDFContext ctx;
+                BSDFPtr bsdf = si.bsdf(ray);
+                Mask active_e = active && has_flag(bsdf->flags(), BSDFFlags::Smooth);
+
+                if (likely(any_or<true>(active_e))) {
+                    Spectrum Lr_dir = throughput * sample_emitters(scene, sampler, si, bsdf, active_e);
+                    Lr_dir[!active_e] = 0.f;
+                    L -= detach(Lr_dir);
+                    contrib += Lr_dir;
+                }
+
+                // ----------------------- BSDF sampling ----------------------
+
+                auto [bs, bsdf_weight] = bsdf->sample(ctx, si, sampler->next_1d(active),
+                                                      sampler->next_2d(active), active);
+                bsdf_weight = detach(bsdf_weight);
+
+                /* The remaining radiance 'L' arrives along the sampled
+                   direction and is scaled by the BSDF value of this vertex.
+                   Attach it to the (differentiable) BSDF value, which is
+                   normalized by its detached value. */
+                Spectrum bsdf_val = bsdf->eval(ctx, si, bs.wo, active);
+                Spectrum bsdf_val_d = detach(bsdf_val);
+                Spectrum Lr_ind = select(neq(bsdf_val_d, 0.f), L * bsdf_val / bsdf_val_d, 0.f);
+                Lr_ind[!active] = 0.f;
+                contrib += Lr_ind;
+
+                // Release the graph of this vertex before the next bounce
+                backpropagate(adjoint, contrib);
+
+                throughput = throughput * bsdf_weight;
+                active &= any(neq(throughput, 0.f));
+                if (none_or<false>(active))
+                    break;
+
+                eta *= bs.eta;
+
+                ray = si.spawn_ray(si.to_world(bs.wo));
+                SurfaceInteraction3f si_bsdf = scene->ray_intersect(ray, active);
+
+                emitter = si_bsdf.emitter(scene, active);
+                DirectionSample3f ds(si_bsdf, si);
+                ds.object = emitter;
+
+                if (any_or<true>(neq(emitter, nullptr))) {
+                    Float emitter_pdf =
+                        select(neq(emitter, nullptr) && !has_flag(bs.sampled_type, BSDFFlags::Delta),
+                               scene->pdf_emitter_direction(si, ds),
+                               0.f);
+
+                    emission_weight = detach(
+                        mis_weight(bs.pdf, emitter_pdf * (ScalarFloat) m_emitter_samples));
+                }
+
+                si = std::move(si_bsdf);
+            }
+        } else {
+            ENOKI_MARK_USED(scene);
+            ENOKI_MARK_USED(sampler);
+            ENOKI_MARK_USED(ray_);
+            ENOKI_MARK_USED(radiance);
+            ENOKI_MARK_USED(adjoint_);
+            ENOKI_MARK_USED(active);
+            Throw("sample_adjoint(): only supported by unpolarized differentiable variants.");
+        }
+    }
+
+    /// Backpropagate the product of \c adjoint and \c contrib
+    void backpropagate(const Spectrum &adjoint, const Spectrum &contrib) const {
+        if constexpr (is_diff_array_v<Float>) {
+            Float loss = hsum(hsum(adjoint * contrib));
+            if (requires_gradient(loss))
+                backward(loss);
+        } else {
+            ENOKI_MARK_USED(adjoint);
+            ENOKI_MARK_USED(contrib);
+        }
+    }
+
+    /// Wavefront mode draws a single emitter sample per vertex
+    bool supports_wavefront() const override { return m_emitter_samples == 1 && !m_rrs; }
+
+    void sample_wavefront(const Scene *scene,
+                          const DynamicRayDifferential3f &rays,
+                          const DynamicUInt32 &seeds,
+                          const Medium * /* medium */,
+                          const DynamicMask &active_in,
+                          DynamicSpectrum &result,
+                          DynamicMask &valid) const override {
+        if constexpr (is_array_v<Float> && !is_cuda_array_v<Float>) {
+            using DynamicFloat   = make_dynamic_t<Float>;
+            using DynamicPoint3f = make_dynamic_t<Point3f>;
+            using DynamicRay3f   = make_dynamic_t<Ray3f>;
+            using DynamicSurfaceInteraction3f = make_dynamic_t<SurfaceInteraction3f>;
+
+            size_t ray_count    = slices(rays),
+                   packet_count = (ray_count + Float::Size - 1) / Float::Size;
+            bool polarizing     = scene->has_polarizing_bsdfs();
+
+            /* State of all paths, indexed by their camera ray. The pdf of
+               the last BSDF sample (zero for delta lobes) and the position of
+               the last vertex are needed to MIS-weight emitter hits. */
+            DynamicRay3f ray_s;
+            DynamicSpectrum throughput_s;
+            DynamicFloat eta_s, pdf_s;
+            DynamicPoint3f p_s;
+            set_slices(ray_s, ray_count);
+            set_slices(throughput_s, ray_count);
+            set_slices(eta_s, ray_count);
+            set_slices(pdf_s, ray_count);
+            set_slices(p_s, ray_count);
+
+            // Surface interactions and their BSDFs, which are shaded in a second phase
+            DynamicSurfaceInteraction3f si_s;
+            set_slices(si_s, ray_count);
+            std::vector<const BSDF *> bsdf_s(ray_count, nullptr);
+
+            /* Indices of the paths that are still active, and of the paths
+               that remain to be shaded (padded to full packets) */
+            std::vector<uint32_t> queue(ray_count + Float::Size, 0),
+                                  queue_next(ray_count + Float::Size, 0),
+                                  queue_shade(ray_count + Float::Size, 0);
+            size_t queue_size = ray_count;
+
+            for (int depth = 1; queue_size > 0; ++depth) {
+                if (depth > 1) {
+                    packet_count = (queue_size + Float::Size - 1) / Float::Size;
+
+                    // Group secondary rays with similar origins and directions
+                    if (m_sort_rays)
+                        scene->sort_rays(ray_s, queue.data(), queue_size);
+                }
+
+                auto next_1d = [depth](const UInt32 &seed, uint32_t dim) {
+                    return Float(sample_tea_float32(seed, UInt32((uint32_t) depth * 6u + dim)));
+                };
+
+                // ------------- Phase 1: intersection and emitter hits -------------
+
+                uint32_t *shade_ptr = queue_shade.data();
+                for (size_t i = 0; i < packet_count; ++i) {
+                    UInt32 index;
+                    Mask lanes;
+                    RayDifferential3f ray;
+                    Spectrum throughput, result_p;
+                    Float eta, prev_pdf;
+                    Point3f prev_p;
+
+                    if (depth == 1) {
+                        // The first bounce processes the camera rays in order
+                        index      = UInt32((uint32_t) (i * Float::Size)) + arange<UInt32>();
+                        lanes      = packet(active_in, i);
+                        ray        = packet(rays, i);
+                        throughput = 1.f;
+                        result_p   = 0.f;
+                        eta        = 1.f;
+                        prev_pdf   = 0.f;
+                        prev_p     = 0.f;
+                    } else {
+                        UInt32 offset = UInt32((uint32_t) (i * Float::Size)) + arange<UInt32>();
+                        index      = load_unaligned<UInt32>(queue.data() + i * Float::Size);
+                        lanes      = offset < UInt32((uint32_t) queue_size);
+                        ray        = gather<Ray3f>(ray_s, index, lanes);
+                        throughput = gather<Spectrum>(throughput_s, index, lanes);
+                        result_p   = gather<Spectrum>(result, index, lanes);
+                        eta        = gather<Float>(eta_s, index, lanes);
+                        prev_pdf   = gather<Float>(pdf_s, index, lanes);
+                        prev_p     = gather<Point3f>(p_s, index, lanes);
+                    }
+
+                    /* Random numbers are derived from the path's seed and
+                       the current dimension, since paths migrate between
+                       SIMD lanes when the queue is compacted */
+                    UInt32 seed = gather<UInt32>(seeds, index, lanes);
+
+                    Mask active = lanes;
+
+                    SurfaceInteraction3f si = scene->ray_intersect(ray, active);
+                    EmitterPtr emitter = si.emitter(scene, active);
+
+                    if (depth == 1)
+                        packet(valid, i) = si.is_valid();
+
+                    if (any_or<true>(neq(emitter, nullptr))) {
+                        Float emission_weight(1.f);
+                        if (depth > 1) {
+                            Interaction3f prev_it = zero<Interaction3f>();
+                            prev_it.p           = prev_p;
+                            prev_it.time        = ray.time;
+                            prev_it.wavelengths = ray.wavelengths;
+
+                            DirectionSample3f ds(si, prev_it);
+                            ds.object = emitter;
+
+                            Mask active_m = neq(emitter, nullptr) && prev_pdf > 0.f;
+                            Float emitter_pdf =
+                                select(active_m, scene->pdf_emitter_direction(prev_it, ds, active_m), 0.f);
+                            emission_weight =
+                                select(prev_pdf > 0.f, mis_weight(prev_pdf, emitter_pdf), 1.f);
+                        }
+
+                        result_p[active] += emission_weight *
+                            mueller_product(throughput, emitter->eval(si, active), polarizing);
+                    }
+
+                    active &= si.is_valid();
+
+                    // Russian roulette (see sample())
+                    if (depth > m_rr_depth) {
+                        Float q = min(hmax(depolarize(throughput)) * sqr(eta), .95f);
+                        Mask rr_continue = next_1d(seed, 0) < q;
+                        stats_count(StatsCounter::RRTerminations, active && !rr_continue);
+                        active &= rr_continue;
+                        throughput *= rcp(q);
+                    }
+
+                    if ((uint32_t) depth >= (uint32_t) m_max_depth)
+                        active = false;
+
+                    scatter(result, result_p, index, lanes);
+
+                    if (any(active)) {
+                        // Also computes the texture coordinate partials of camera rays
+                        BSDFPtr bsdf = si.bsdf(ray);
+
+                        scatter(si_s, si, index, active);
+                        scatter(throughput_s, throughput, index, active);
+                        scatter(eta_s, eta, index, active);
+
+                        for (size_t j = 0; j < Float::Size; ++j) {
+                            if (active.coeff(j))
+                                bsdf_s[index.coeff(j)] = bsdf.coeff(j);
+                        }
+
+                        compress(shade_ptr, index, active);
+                    }
+                }
+
+                size_t shade_size = (size_t) (shade_ptr - queue_shade.data());
+
+                /* Group the paths by BSDF, so that the virtual function calls
+                   below dispatch packets that mostly refer to a single
+                   material rather than one masked call per distinct BSDF */
+                if (m_sort_materials)
+                    std::stable_sort(queue_shade.begin(), queue_shade.begin() + shade_size,
+                                     [&](uint32_t a, uint32_t b) {
+                                         return std::less<const BSDF *>()(bsdf_s[a], bsdf_s[b]);
+                                     });
+
+                // --------------- Phase 2: emitter and BSDF sampling ---------------
+
+                uint32_t *queue_ptr = queue_next.data();
+                size_t shade_packets = (shade_size + Float::Size - 1) / Float::Size;
+                for (size_t i = 0; i < shade_packets; ++i) {
+                    UInt32 offset = UInt32((uint32_t) (i * Float::Size)) + arange<UInt32>(),
+                           index  = load_unaligned<UInt32>(queue_shade.data() + i * Float::Size);
+                    Mask active   = offset < UInt32((uint32_t) shade_size);
+
+                    SurfaceInteraction3f si = gather<SurfaceInteraction3f>(si_s, index, active);
+                    Spectrum throughput = gather<Spectrum>(throughput_s, index, active),
+                             result_p   = gather<Spectrum>(result, index, active);
+                    Float eta = gather<Float>(eta_s, index, active);
+                    UInt32 seed = gather<UInt32>(seeds, index, active);
+                    Mask lanes = active;
+
+                    // --------------------- Emitter sampling ---------------------
+
+                    BSDFContext ctx;
+                    BSDFPtr bsdf = si.bsdf();
+                    Mask active_e = active && has_flag(bsdf->flags(), BSDFFlags::Smooth);
+
+                    if (likely(any_or<true>(active_e))) {
+                        auto [ds, emitter_val] = scene->sample_emitter_direction(
+                            si, Point2f(next_1d(seed, 1), next_1d(seed, 2)), true, active_e);
+                        active_e &= neq(ds.pdf, 0.f);
+
+                        Vector3f wo = si.to_local(ds.d);
+                        auto [bsdf_val, bsdf_pdf] = bsdf->eval_pdf(ctx, si, wo, active_e);
+                        if (polarizing)
+                            bsdf_val = si.to_world_mueller(bsdf_val, -wo, si.wi);
+
+                        Float mis = select(ds.delta, 1.f, mis_weight(ds.pdf, bsdf_pdf));
+                        result_p[active_e] += mis * mueller_product(
+                            mueller_product(throughput, bsdf_val, polarizing), emitter_val,
+                            polarizing);
+                    }
+
+                    // ----------------------- BSDF sampling ----------------------
+
+                    auto [bs, bsdf_val] = bsdf->sample(ctx, si, next_1d(seed, 3),
+                                                       Point2f(next_1d(seed, 4), next_1d(seed, 5)),
+                                                       active);
+                    if (polarizing)
+                        bsdf_val = si.to_world_mueller(bsdf_val, -bs.wo, si.wi);
+
+                    throughput = mueller_product(throughput, bsdf_val, polarizing);
+                    active &= any(neq(depolarize(throughput), 0.f));
+
+                    eta *= bs.eta;
+                    Ray3f ray = si.spawn_ray(si.to_world(bs.wo));
+                    Float prev_pdf = select(has_flag(bs.sampled_type, BSDFFlags::Delta), 0.f, bs.pdf);
+
+                    scatter(ray_s, ray, index, active);
+                    scatter(throughput_s, throughput, index, active);
+                    scatter(eta_s, eta, index, active);
+                    scatter(pdf_s, prev_pdf, index, active);
+                    scatter(p_s, si.p, index, active);
+                    scatter(result, result_p, index, lanes);
+
+                    // Compact the surviving paths into the next queue
+                    compress(queue_ptr, index, active);
+                }
+
+                queue_size = (size_t) (queue_ptr - queue_next.data());
+                std::swap(queue, queue_next);
+            }
+        } else {
+            ENOKI_MARK_USED(scene);
+            ENOKI_MARK_USED(rays);
+            ENOKI_MARK_USED(seeds);
+            ENOKI_MARK_USED(active_in);
+            ENOKI_MARK_USED(result);
+            ENOKI_MARK_USED(valid);
+            Throw("sample_wavefront(): only supported by CPU packet variants.");
+        }
+    }
+
     //! @}
     // =============================================================
 
     std::string to_string() const override {
         return tfm::format("PathIntegrator[\n"
             "  max_depth = %i,\n"
-            "  rr_depth = %i\n"
-            "]", m_max_depth, m_rr_depth);
+            "  rr_depth = %i,\n"
+            "  rr_mode = %s,\n"
+            "  emitter_samples = %i\n"
+            "]", m_max_depth, m_rr_depth, m_rrs ? "adaptive" : "throughput",
+            m_emitter_samples);
     }
 
     Float mis_weight(Float pdf_a, Float pdf_b) const {
@@ -227,6 +922,23 @@ public:
     }
 
     MTS_DECLARE_CLASS()
+private:
+    /// Number of emitter samples whose shadow rays are traced together
+    static constexpr size_t EmitterBatch = 8;
+
+    /// Sort the path queue by ray origin and direction in wavefront mode?
+    bool m_sort_rays;
+
+    /// Group the shaded paths by BSDF in wavefront mode?
+    bool m_sort_materials;
+
+    /// Number of emitter samples per path vertex
+    size_t m_emitter_samples;
+    /// Trace the shadow ray and the continuation ray of a bounce together (GPU variants)
+    bool m_coalesce_rays;
+
+    /// Statistics of the adaptive Russian roulette and splitting (\c nullptr if disabled)
+    ref<RRSCache> m_rrs;
 };
 
 MTS_IMPLEMENT_CLASS_VARIANT(PathIntegrator, MonteCarloIntegrator)
@@ -0,0 +1,417 @@
+#include <mitsuba/core/properties.h>
+#include <mitsuba/core/ray.h>
+#include <mitsuba/render/bsdf.h>
+#include <mitsuba/render/emitter.h>
+#include <mitsuba/render/integrator.h>
+#include <mitsuba/render/photonmap.h>
+#include <mitsuba/render/records.h>
+#include <mitsuba/render/sampler.h>
+#include <mitsuba/render/sensor.h>
+#include <tbb/blocked_range.h>
+#include <tbb/parallel_for.h>
+
+NAMESPACE_BEGIN(mitsuba)
+
+/**!
+
+.. _integrator-photonmapper:
+
+Progressive photon mapper (:monosp:`photonmapper`)
+--------------------------------------------------
+
+.. pluginparameters::
+
+ * - max_depth
+   - |int|
+   - Specifies the longest depth of the camera paths and of the photon paths (where -1
+     corresponds to :math:`\infty`). (Default: -1)
+ * - rr_depth
+   - |int|
+   - Specifies the minimum path depth, after which the implementation will start to use the
+     *russian roulette* path termination criterion. (Default: 5)
+ * - photon_count
+   - |int|
+   - Number of photons emitted in every pass. (Default: 250000)
+ * - radius
+   - |float|
+   - Lookup radius of the first pass in world units. (Default: 0, i.e. 1% of the diagonal
+     of the bounding box of the scene)
+ * - alpha
+   - |float|
+   - Radius reduction parameter between the passes, in the range (0, 1). Lower values
+     shrink the radius faster. (Default: 0.7)
+ * - hide_emitters
+   - |bool|
+   - Hide directly visible emitters. (Default: no, i.e. |false|)
+
+This integrator renders the light that reaches the sensor through specular chains,
+e.g. caustics cast by glass fixtures, which the :ref:`path tracer <integrator-path>`
+can only find by chance. Before every pass (see the ``samples_per_pass`` parameter of
+the integrator), photons are emitted by the emitters of the scene and traced through
+it in parallel. They are stored in a photon map at every non-specular surface they
+reach after at least one bounce.
+
+Camera paths follow specular (delta) lobes, and at the first surface with a
+non-specular lobe, they compute direct illumination by emitter sampling and add the
+density estimate of the photons within the lookup radius, which accounts for all
+indirect illumination. Packets of camera paths evaluate the BSDF for one photon of
+each lane at a time.
+
+The method is progressive following Knaus and Zwicker ("Progressive Photon Mapping:
+A Probabilistic Approach"): every pass renders an independent image with a new photon
+map, and the lookup radius shrinks between the passes, so that the average of the
+passes converges to the correct solution. Renders should hence use several passes,
+e.g. 16 passes of 4 samples per pixel.
+
+.. note:: This integrator does not handle participating media and is only supported
+   by the RGB and monochromatic CPU variants.
+
+ */
+
+template <typename Float, typename Spectrum>
+class PhotonMapperIntegrator : public MonteCarloIntegrator<Float, Spectrum> {
+public:
+    MTS_IMPORT_BASE(MonteCarloIntegrator, m_max_depth, m_rr_depth, m_hide_emitters,
+                    thread_count)
+    MTS_IMPORT_TYPES(Scene, Sensor, Sampler, Medium, Emitter, EmitterPtr, BSDF, BSDFPtr)
+    using PhotonMap = mitsuba::PhotonMap<Float, Spectrum>;
+    using Photon = typename PhotonMap::Photon;
+
+    PhotonMapperIntegrator(const Properties &props) : Base(props) {
+        if constexpr (is_cuda_array_v<Float>)
+            Throw("The photon mapper is only supported by the CPU variants.");
+        if constexpr (is_spectral_v<Spectrum> || is_polarized_v<Spectrum>)
+            Throw("The photon mapper is only supported by the RGB and monochromatic variants.");
+
+        m_photon_count = props.size_("photon_count", 250000);
+        if (m_photon_count == 0)
+            Throw("\"photon_count\" must be at least 1!");
+
+        m_initial_radius = props.float_("radius", 0.f);
+        if (m_initial_radius < 0.f)
+            Throw("\"radius\" must be a value >= 0!");
+
+        m_alpha = props.float_("alpha", .7f);
+        if (!(m_alpha > 0.f && m_alpha < 1.f))
+            Throw("\"alpha\" must be in the range (0, 1)!");
+
+        m_photon_map = new PhotonMap();
+    }
+
+    bool uses_pass_hooks() const override { return true; }
+
+    void prepare_pass(const Scene *scene, const Sensor *sensor, size_t pass,
+                      size_t /* pass_count */) override {
+        // Start from the initial radius in every render job
+        if (pass == 0) {
+            m_radius = m_initial_radius;
+            if (m_radius == 0.f) {
+                ScalarBoundingBox3f bbox = scene->bbox();
+                m_radius = bbox.valid() ? .01f * norm(bbox.extents()) : .01f;
+            }
+        } else {
+            // Knaus and Zwicker: r_{i+1}^2 = r_i^2 * (i + alpha) / (i + 1)
+            m_radius *= std::sqrt((pass + m_alpha) / (pass + 1));
+        }
+
+        m_photon_map->build(trace_photons(scene, sensor, pass), m_radius);
+
+        Log(Debug, "Photon mapping pass %i: %i photons, radius %f.", pass + 1,
+            m_photon_map->photon_count(), m_radius);
+    }
+
+    std::pair<Spectrum, Mask> sample(const Scene *scene,
+                                     Sampler *sampler,
+                                     const RayDifferential3f &ray_,
+                                     const Medium * /* medium */,
+                                     Float * /* aovs */,
+                                     Mask active) const override {
+        MTS_MASKED_FUNCTION(ProfilerPhase::SamplingIntegratorSample, active);
+
+        RayDifferential3f ray = ray_;
+        Spectrum throughput(1.f), result(0.f);
+
+        SurfaceInteraction3f si = scene->ray_intersect(ray, active);
+        Mask valid_ray = si.is_valid();
+
+        // Only specular lobes are followed, hence all the emitters hit are added
+        Mask count_emission = !m_hide_emitters;
+
+        for (int depth = 1; (uint32_t) depth <= (uint32_t) m_max_depth; ++depth) {
+            // ----------------- Intersection with emitters -----------------
+
+            EmitterPtr emitter = si.emitter(scene, active);
+            Mask active_e = active && count_emission && neq(emitter, nullptr);
+            if (any_or<true>(active_e))
+                result[active_e] += throughput * emitter->eval(si, active_e);
+
+            active &= si.is_valid();
+            if ((uint32_t) depth >= (uint32_t) m_max_depth || none_or<false>(active))
+                break;
+
+            BSDFContext ctx;
+            BSDFPtr bsdf = si.bsdf(ray);
+            Mask smooth = active && has_flag(bsdf->flags(), BSDFFlags::Smooth);
+
+            // ---------- Emitter sampling and photon density estimate ----------
+
+            if (any_or<true>(smooth)) {
+                auto [ds, emitter_val] = scene->sample_emitter_direction(
+                    si, sampler->next_2d(smooth), true, smooth);
+                Mask active_s = smooth && neq(ds.pdf, 0.f);
+                Spectrum bsdf_val = bsdf->eval(ctx, si, si.to_local(ds.d), active_s);
+                result[active_s] += throughput * bsdf_val * emitter_val;
+
+                result[smooth] += throughput * density_estimate(si, bsdf, smooth);
+            }
+
+            // ------------------- Specular lobes only -------------------
+
+            BSDFContext ctx_delta(TransportMode::Radiance, (uint32_t) BSDFFlags::Delta,
+                                  (uint32_t) -1);
+            active &= has_flag(bsdf->flags(), BSDFFlags::Delta);
+            if (none_or<false>(active))
+                break;
+
+            auto [bs, bsdf_weight] = bsdf->sample(ctx_delta, si, sampler->next_1d(active),
+                                                  sampler->next_2d(active), active);
+            throughput *= bsdf_weight;
+            active &= any(neq(depolarize(throughput), 0.f));
+
+            ray = si.spawn_ray(si.to_world(bs.wo));
+            si = scene->ray_intersect(ray, active);
+            count_emission = true;
+
+            if (depth >= m_rr_depth) {
+                Float q = min(hmax(depolarize(throughput)), .95f);
+                active &= sampler->next_1d(active) < q;
+                throughput *= rcp(q);
+            }
+        }
+
+        return { result, valid_ray };
+    }
+
+    std::string to_string() const override {
+        return tfm::format("PhotonMapperIntegrator[\n"
+            "  max_depth = %i,\n"
+            "  rr_depth = %i,\n"
+            "  photon_count = %i,\n"
+            "  radius = %f,\n"
+            "  alpha = %f\n"
+            "]", m_max_depth, m_rr_depth, m_photon_count, m_initial_radius, m_alpha);
+    }
+
+    MTS_DECLARE_CLASS()
+protected:
+    /// Trace the photons of a pass in parallel
+    std::vector<Photon> trace_photons(const Scene *scene, const Sensor *sensor, size_t pass) const {
+        // Several chunks per thread, each a multiple of the packet size
+        size_t chunk_count = std::max((size_t) 1, std::min(4 * thread_count(),
+                                                           m_photon_count / Lanes)),
+               chunk_size  = (m_photon_count + chunk_count - 1) / chunk_count;
+        chunk_size = (chunk_size + Lanes - 1) / Lanes * Lanes;
+        chunk_count = (m_photon_count + chunk_size - 1) / chunk_size;
+
+        // Photons of every chunk, concatenated in a deterministic order
+        std::vector<std::vector<Photon>> chunks(chunk_count);
+        ScalarFloat scale = 1.f / (ScalarFloat) m_photon_count;
+
+        ThreadEnvironment env;
+        tbb::parallel_for(
+            tbb::blocked_range<size_t>(0, chunk_count, 1),
+            [&](const tbb::blocked_range<size_t> &chunk_range) {
+                ScopedSetThreadEnvironment set_env(env);
+                ref<Sampler> sampler = sensor->sampler()->clone();
+                for (size_t i = chunk_range.begin(); i != chunk_range.end(); ++i) {
+                    size_t begin = i * chunk_size,
+                           count = std::min(chunk_size, m_photon_count - begin);
+                    // Distinct from the seeds of the camera samples
+                    sampler->seed(((uint64_t) (pass + 1) << 32) + i);
+
+                    if constexpr (!is_array_v<Float>) {
+                        for (size_t j = 0; j < count; ++j) {
+                            trace_photon(scene, sensor, sampler, scale, chunks[i], true);
+                            sampler->advance();
+                        }
+                    } else {
+                        for (auto [index, active] : range<UInt32>((uint32_t) count)) {
+                            ENOKI_MARK_USED(index);
+                            trace_photon(scene, sensor, sampler, scale, chunks[i], active);
+                            sampler->advance();
+                        }
+                    }
+                }
+            });
+
+        size_t total = 0;
+        for (const auto &chunk : chunks)
+            total += chunk.size();
+
+        std::vector<Photon> photons;
+        photons.reserve(total);
+        for (auto &chunk : chunks)
+            photons.insert(photons.end(), chunk.begin(), chunk.end());
+        return photons;
+    }
+
+    /// Trace a packet of photons and append the ones stored in the photon map to \c photons
+    void trace_photon(const Scene *scene, const Sensor *sensor, Sampler *sampler,
+                      ScalarFloat scale, std::vector<Photon> &photons, Mask active) const {
+        Float time = sensor->shutter_open();
+        if (sensor->shutter_open_time() > 0.f)
+            time += sampler->next_1d(active) * sensor->shutter_open_time();
+
+        Float emitter_sample = sampler->next_1d(active);
+        Point2f sample2 = sampler->next_2d(active),
+                sample3 = sampler->next_2d(active);
+
+        auto [ray, power] =
+            scene->sample_emitter_ray(time, emitter_sample, sample2, sample3, active);
+        ray.mint = (1.f + hmax(abs(ray.o))) * math::RayEpsilon<Float>;
+        power *= scale;
+        active &= any(neq(depolarize(power), 0.f));
+
+        // Initial power of the photon, which Russian roulette tries to preserve
+        Float initial_power = hmax(depolarize(power));
+
+        // The BSDFs evaluate the adjoint transport from the emitters to the sensor
+        BSDFContext ctx(TransportMode::Importance);
+
+        for (int depth = 1; (uint32_t) depth < (uint32_t) m_max_depth; ++depth) {
+            SurfaceInteraction3f si = scene->ray_intersect(ray, active);
+            active &= si.is_valid();
+            if (none_or<false>(active))
+                break;
+
+            BSDFPtr bsdf = si.bsdf(ray);
+
+            // Direct illumination is computed by emitter sampling instead
+            if (depth > 1) {
+                Mask store = active && has_flag(bsdf->flags(), BSDFFlags::Smooth);
+                for (size_t i = 0; i < Lanes; ++i) {
+                    if (!lane_mask(store, i))
+                        continue;
+                    Photon photon;
+                    photon.p = lane(si.p, i);
+                    photon.d = lane(-ray.d, i);
+                    for (size_t k = 0; k < 3; ++k)
+                        photon.power[k] = lane(power[std::min(k, array_size_v<Spectrum> - 1)], i);
+                    photons.push_back(photon);
+                }
+            }
+
+            auto [bs, bsdf_weight] = bsdf->sample(ctx, si, sampler->next_1d(active),
+                                                  sampler->next_2d(active), active);
+            power *= bsdf_weight;
+            active &= any(neq(depolarize(power), 0.f));
+            if (none_or<false>(active))
+                break;
+
+            ray = si.spawn_ray(si.to_world(bs.wo));
+
+            if (depth >= m_rr_depth) {
+                Float q = min(hmax(depolarize(power)) / initial_power, .95f);
+                active &= sampler->next_1d(active) < q;
+                power *= rcp(q);
+            }
+        }
+    }
+
+    /// Radiance reflected by the non-specular lobes, estimated from the nearby photons
+    Spectrum density_estimate(const SurfaceInteraction3f &si, const BSDFPtr &bsdf,
+                              Mask active) const {
+        std::vector<uint32_t> indices[Lanes];
+        size_t max_count = 0;
+        for (size_t i = 0; i < Lanes; ++i) {
+            if (!lane_mask(active, i))
+                continue;
+            m_photon_map->query(lane(si.p, i), indices[i]);
+            max_count = std::max(max_count, indices[i].size());
+        }
+
+        // Evaluate the BSDF for one photon of every lane at a time
+        BSDFContext ctx;
+        Spectrum result(0.f);
+        for (size_t k = 0; k < max_count; ++k) {
+            Vector3f d(0.f);
+            Spectrum power(0.f);
+            Mask valid = false;
+            for (size_t i = 0; i < Lanes; ++i) {
+                if (k >= indices[i].size())
+                    continue;
+                const Photon &photon = m_photon_map->photon(indices[i][k]);
+                for (size_t j = 0; j < 3; ++j)
+                    set_lane(d[j], i, photon.d[j]);
+                for (size_t j = 0; j < array_size_v<Spectrum>; ++j)
+                    set_lane(power[j], i, photon.power[j]);
+                set_lane_mask(valid, i);
+            }
+
+            // The photon power already accounts for the cosine at the surface
+            Vector3f wo = si.to_local(d);
+            Spectrum bsdf_val = bsdf->eval(ctx, si, wo, valid);
+            Float inv_cos = rcp(abs(Frame3f::cos_theta(wo)));
+            result[valid] += bsdf_val * power * inv_cos;
+        }
+
+        ScalarFloat radius = m_photon_map->radius();
+        return result * (1.f / (math::Pi<ScalarFloat> * radius * radius));
+    }
+
+    static ScalarFloat lane(const Float &v, size_t i) {
+        if constexpr (is_array_v<Float>) {
+            return v.coeff(i);
+        } else {
+            ENOKI_MARK_USED(i);
+            return v;
+        }
+    }
+
+    static ScalarPoint3f lane(const Point3f &p, size_t i) {
+        return ScalarPoint3f(lane(p.x(), i), lane(p.y(), i), lane(p.z(), i));
+    }
+
+    static ScalarVector3f lane(const Vector3f &v, size_t i) {
+        return ScalarVector3f(lane(v.x(), i), lane(v.y(), i), lane(v.z(), i));
+    }
+
+    static bool lane_mask(const Mask &m, size_t i) {
+        return lane(select(m, Float(1.f), Float(0.f)), i) != 0.f;
+    }
+
+    static void set_lane(Float &v, size_t i, ScalarFloat value) {
+        if constexpr (is_array_v<Float>) {
+            v.coeff(i) = value;
+        } else {
+            ENOKI_MARK_USED(i);
+            v = value;
+        }
+    }
+
+    static void set_lane_mask(Mask &m, size_t i) {
+        if constexpr (is_array_v<Float>) {
+            m.coeff(i) = true;
+        } else {
+            ENOKI_MARK_USED(i);
+            m = true;
+        }
+    }
+
+private:
+    /// Number of values per packet (the photon map processes one lane at a time)
+    static constexpr size_t Lanes =
+        (is_array_v<Float> && !is_cuda_array_v<Float>) ? array_size_v<Float> : 1;
+
+    size_t m_photon_count;
+    ScalarFloat m_initial_radius;
+    ScalarFloat m_alpha;
+
+    /// Lookup radius of the current pass
+    ScalarFloat m_radius = 0.f;
+    ref<PhotonMap> m_photon_map;
+};
+
+MTS_IMPLEMENT_CLASS_VARIANT(PhotonMapperIntegrator, MonteCarloIntegrator)
+MTS_EXPORT_PLUGIN(PhotonMapperIntegrator, "Progressive photon mapper");
+NAMESPACE_END(mitsuba)
@@ -0,0 +1,354 @@
+#include <atomic>
+#include <mutex>
+#include <mitsuba/core/progress.h>
+#include <mitsuba/core/properties.h>
+#include <mitsuba/core/ray.h>
+#include <mitsuba/core/timer.h>
+#include <mitsuba/core/util.h>
+#include <mitsuba/render/bsdf.h>
+#include <mitsuba/render/emitter.h>
+#include <mitsuba/render/film.h>
+#include <mitsuba/render/integrator.h>
+#include <mitsuba/render/records.h>
+#include <mitsuba/render/sampler.h>
+#include <mitsuba/render/sensor.h>
+#include <tbb/blocked_range.h>
+#include <tbb/parallel_for.h>
+
+NAMESPACE_BEGIN(mitsuba)
+
+/**!
+
+.. _integrator-ptracer:
+
+Particle tracer (:monosp:`ptracer`)
+-----------------------------------
+
+.. pluginparameters::
+
+ * - max_depth
+   - |int|
+   - Specifies the longest path depth in the generated output image (where -1 corresponds to
+     :math:`\infty`). A value of 1 will only render directly visible light sources. 2 will lead
+     to single-bounce (direct-only) illumination, and so on. (Default: -1)
+ * - rr_depth
+   - |int|
+   - Specifies the minimum path depth, after which the implementation will start to use the
+     *russian roulette* path termination criterion. (Default: 5)
+ * - samples_count
+   - |int|
+   - Number of light paths. (Default: 0, i.e. the sample count of the sensor's sampler times
+     the number of pixels of the crop window)
+ * - hide_emitters
+   - |bool|
+   - Hide directly visible emitters. (Default: no, i.e. |false|)
+ * - timeout
+   - |float|
+   - Stop the render job after this many seconds. (Default: -1, i.e. no timeout)
+
+This integrator traces paths from the emitters instead of the sensor (also known as
+*light tracing*): rays are sampled by the emitters of the scene (see
+:py:meth:`mitsuba.render.Scene.sample_emitter_ray`), and every vertex of their
+random walk is connected to the sensor (see
+:py:meth:`mitsuba.render.Endpoint.sample_direction`). The contributions are splatted
+into the film at the position of the connection, from all rendering threads at once.
+
+Light tracing efficiently renders effects that are hard to reach from the sensor,
+e.g. caustics seen through a diffuse surface, but cannot render paths whose
+vertices next to the sensor are specular. Emitters that are directly visible are
+rendered by tracing rays from the sensor (one per sample of the sensor's sampler
+and pixel).
+
+The sensor must implement direction sampling, which is e.g. the case of the
+:ref:`perspective <sensor-perspective>` camera, and the film must support splats
+that are not written while rendering (e.g. :ref:`hdrfilm <film-hdrfilm>`).
+
+.. note:: This integrator does not handle participating media, polarization, and
+   is only supported by the CPU variants.
+
+ */
+
+template <typename Float, typename Spectrum>
+class ParticleTracerIntegrator final : public Integrator<Float, Spectrum> {
+public:
+    MTS_IMPORT_BASE(Integrator, thread_count, run_in_thread_pool)
+    MTS_IMPORT_TYPES(Scene, Sensor, Film, Sampler, Emitter, EmitterPtr, BSDF, BSDFPtr)
+
+    ParticleTracerIntegrator(const Properties &props) : Base(props) {
+        if constexpr (is_cuda_array_v<Float>)
+            Throw("The particle tracer is only supported by the CPU variants.");
+        if constexpr (is_polarized_v<Spectrum>)
+            Throw("The particle tracer does not support polarized variants.");
+
+        m_rr_depth = props.int_("rr_depth", 5);
+        if (m_rr_depth <= 0)
+            Throw("\"rr_depth\" must be set to a value greater than zero!");
+
+        m_max_depth = props.int_("max_depth", -1);
+        if (m_max_depth < 0 && m_max_depth != -1)
+            Throw("\"max_depth\" must be set to -1 (infinite) or a value >= 0");
+
+        m_samples_count = props.size_("samples_count", 0);
+        m_hide_emitters = props.bool_("hide_emitters", false);
+        m_timeout = props.float_("timeout", -1.f);
+        m_stop = false;
+    }
+
+    bool render(Scene *scene, Sensor *sensor) override {
+        bool result = false;
+        if (run_in_thread_pool([&]() { result = render(scene, sensor); }))
+            return result;
+
+        ScopedPhase sp(ProfilerPhase::Render);
+        m_stop = false;
+        m_timer.reset();
+
+        ref<Film> film = sensor->film();
+        if (film->streaming())
+            Throw("The particle tracer requires a film that is not written while rendering!");
+
+        ScalarVector2i film_size = film->crop_size();
+        size_t pixel_count = (size_t) hprod(film_size),
+               spp         = sensor->sampler()->sample_count(),
+               path_count  = m_samples_count > 0 ? m_samples_count : spp * pixel_count;
+
+        film->prepare({ "X", "Y", "Z", "A", "W" });
+
+        // Several chunks of light paths per thread, each a multiple of the packet size
+        size_t n_threads   = thread_count(),
+               packet_size = array_size_v<Float>,
+               chunk_count = std::max((size_t) 1, std::min(4 * n_threads,
+                                      path_count / packet_size)),
+               chunk_size  = (path_count + chunk_count - 1) / chunk_count;
+        chunk_size = (chunk_size + packet_size - 1) / packet_size * packet_size;
+        chunk_count = (path_count + chunk_size - 1) / chunk_size;
+
+        Log(Info, "Starting render job (%ix%i, %i light paths, %i thread%s)",
+            film_size.x(), film_size.y(), path_count, n_threads, n_threads == 1 ? "" : "s");
+        if (m_timeout > 0.f)
+            Log(Info, "Timeout specified: %.2f seconds.", m_timeout);
+
+        ThreadEnvironment env;
+        ref<ProgressReporter> progress = new ProgressReporter("Rendering");
+        bool visible_emitters = !m_hide_emitters && m_max_depth != 0;
+        size_t work_total = chunk_count + (visible_emitters ? (size_t) film_size.y() : 0),
+               work_done  = 0;
+        std::mutex progress_mutex;
+        auto update_progress = [&]() {
+            std::lock_guard<std::mutex> guard(progress_mutex);
+            progress->update(++work_done / (float) work_total);
+        };
+
+        // 1. Directly visible emitters, traced from the sensor one row at a time
+        if (visible_emitters) {
+            tbb::parallel_for(
+                tbb::blocked_range<int>(0, film_size.y(), 1),
+                [&](const tbb::blocked_range<int> &rows) {
+                    ScopedSetThreadEnvironment set_env(env);
+                    ref<Sampler> sampler = sensor->sampler()->clone();
+                    scoped_flush_denormals flush_denormals(true);
+
+                    for (int y = rows.begin(); y != rows.end() && !should_stop(); ++y) {
+                        for (int x = 0; x < film_size.x() && !should_stop(); ++x) {
+                            ScalarPoint2u pixel(x, y);
+                            sampler->seed((uint64_t) y * film_size.x() + x);
+                            sampler->set_pixel(pixel);
+
+                            if constexpr (!is_array_v<Float>) {
+                                for (size_t i = 0; i < spp; ++i)
+                                    sample_visible_emitters(scene, sensor, film, sampler,
+                                                            pixel, spp, true);
+                            } else {
+                                for (auto [index, active] : range<UInt32>((uint32_t) spp)) {
+                                    ENOKI_MARK_USED(index);
+                                    sample_visible_emitters(scene, sensor, film, sampler,
+                                                            pixel, spp, active);
+                                }
+                            }
+                        }
+                        update_progress();
+                    }
+                });
+        }
+
+        // 2. Light paths, connected to the sensor at every vertex
+        ScalarFloat scale = (ScalarFloat) pixel_count / (ScalarFloat) path_count;
+        tbb::parallel_for(
+            tbb::blocked_range<size_t>(0, chunk_count, 1),
+            [&](const tbb::blocked_range<size_t> &chunks) {
+                ScopedSetThreadEnvironment set_env(env);
+                ScopedPhase sp2(ProfilerPhase::RenderBlock);
+                ref<Sampler> sampler = sensor->sampler()->clone();
+                scoped_flush_denormals flush_denormals(true);
+
+                for (auto i = chunks.begin(); i != chunks.end() && !should_stop(); ++i) {
+                    size_t begin = i * chunk_size,
+                           count = std::min(chunk_size, path_count - begin);
+
+                    // Distinct from the seeds of the pixels above
+                    sampler->seed(pixel_count + i);
+
+                    if constexpr (!is_array_v<Float>) {
+                        for (size_t j = 0; j < count && !should_stop(); ++j) {
+                            trace_light_path(scene, sensor, film, sampler, scale, true);
+                            sampler->advance();
+                        }
+                    } else {
+                        for (auto [index, active] : range<UInt32>((uint32_t) count)) {
+                            if (should_stop())
+                                break;
+                            ENOKI_MARK_USED(index);
+                            trace_light_path(scene, sensor, film, sampler, scale, active);
+                            sampler->advance();
+                        }
+                    }
+                    update_progress();
+                }
+            });
+
+        if (!m_stop)
+            Log(Info, "Rendering finished. (took %s)",
+                util::time_string(m_timer.value(), true));
+
+        return !m_stop;
+    }
+
+    void cancel() override { m_stop = true; }
+
+    /// Add the radiance of the emitters seen by a camera ray through \c pixel
+    void sample_visible_emitters(const Scene *scene, const Sensor *sensor, Film *film,
+                                 Sampler *sampler, const ScalarPoint2u &pixel, size_t spp,
+                                 Mask active) const {
+        Point2f position_sample = ScalarPoint2f(pixel) + sampler->next_2d(active);
+
+        Point2f aperture_sample(.5f);
+        if (sensor->needs_aperture_sample())
+            aperture_sample = sampler->next_2d(active);
+
+        Float time = sensor->shutter_open();
+        if (sensor->shutter_open_time() > 0.f)
+            time += sampler->next_1d(active) * sensor->shutter_open_time();
+
+        Float wavelength_sample = sampler->next_1d(active);
+        sampler->advance();
+
+        auto [ray, ray_weight] = sensor->sample_ray(
+            time, wavelength_sample, position_sample / ScalarVector2f(film->crop_size()),
+            aperture_sample, active);
+
+        /* Emitters that are hit by the camera ray, or the environment
+           emitter for rays that leave the scene */
+        SurfaceInteraction3f si = scene->ray_intersect(ray, active);
+        EmitterPtr emitter = si.emitter(scene, active);
+        active &= neq(emitter, nullptr);
+        if (none_or<false>(active))
+            return;
+
+        Spectrum value = ray_weight * emitter->eval(si, active) * (1.f / (ScalarFloat) spp);
+        film->splat(position_sample + ScalarVector2f(film->crop_offset()), value,
+                    ray.wavelengths, active);
+    }
+
+    /// Trace a path from the emitters and connect each of its vertices to the sensor
+    void trace_light_path(const Scene *scene, const Sensor *sensor, Film *film,
+                          Sampler *sampler, ScalarFloat scale, Mask active) const {
+        Float time = sensor->shutter_open();
+        if (sensor->shutter_open_time() > 0.f)
+            time += sampler->next_1d(active) * sensor->shutter_open_time();
+
+        Float emitter_sample = sampler->next_1d(active);
+        Point2f sample2 = sampler->next_2d(active),
+                sample3 = sampler->next_2d(active);
+
+        auto [ray, throughput] =
+            scene->sample_emitter_ray(time, emitter_sample, sample2, sample3, active);
+        ray.mint = (1.f + hmax(abs(ray.o))) * math::RayEpsilon<Float>;
+        throughput *= scale;
+        active &= any(neq(depolarize(throughput), 0.f));
+
+        // Initial weight of the path, which Russian roulette tries to preserve
+        Float initial_weight = hmax(depolarize(throughput));
+
+        // The BSDFs evaluate the adjoint transport from the emitters to the sensor
+        BSDFContext ctx(TransportMode::Importance);
+
+        /* A light path with 'depth' surface interactions reaches the sensor
+           with a path depth of 'depth + 1' */
+        for (int depth = 1; (uint32_t) depth < (uint32_t) m_max_depth; ++depth) {
+            if (none_or<false>(active))
+                break;
+
+            SurfaceInteraction3f si = scene->ray_intersect(ray, active);
+            active &= si.is_valid();
+            if (none_or<false>(active))
+                break;
+
+            BSDFPtr bsdf = si.bsdf(ray);
+
+            // ------------------- Connection to the sensor -------------------
+
+            Mask active_c = active && has_flag(bsdf->flags(), BSDFFlags::Smooth);
+            Point2f sensor_sample = sampler->next_2d(active_c);
+            if (any_or<true>(active_c)) {
+                auto [ds, importance] = sensor->sample_direction(si, sensor_sample, active_c);
+                active_c &= ds.pdf > 0.f;
+
+                Spectrum bsdf_val = bsdf->eval(ctx, si, si.to_local(ds.d), active_c);
+                Spectrum value = throughput * bsdf_val * importance;
+                active_c &= any(neq(depolarize(value), 0.f));
+
+                if (any_or<true>(active_c)) {
+                    active_c &= !scene->ray_test(si.spawn_ray_to(ds.p), active_c);
+                    film->splat(ds.uv, value, si.wavelengths, active_c);
+                }
+            }
+
+            // ------------------------ BSDF sampling -------------------------
+
+            auto [bs, bsdf_weight] = bsdf->sample(ctx, si, sampler->next_1d(active),
+                                                  sampler->next_2d(active), active);
+            throughput *= bsdf_weight;
+            active &= any(neq(depolarize(throughput), 0.f));
+
+            ray = si.spawn_ray(si.to_world(bs.wo));
+
+            if (depth >= m_rr_depth) {
+                /* Russian roulette: try to keep path weights equal to the
+                   initial weight (the adjoint BSDFs do not scale the weights
+                   at refractive index boundaries) */
+                Float q = min(hmax(depolarize(throughput)) / initial_weight, .95f);
+                active &= sampler->next_1d(active) < q;
+                throughput *= rcp(q);
+            }
+        }
+    }
+
+    std::string to_string() const override {
+        return tfm::format("ParticleTracerIntegrator[\n"
+            "  max_depth = %i,\n"
+            "  rr_depth = %i,\n"
+            "  samples_count = %i,\n"
+            "  hide_emitters = %s\n"
+            "]", m_max_depth, m_rr_depth, m_samples_count,
+            m_hide_emitters ? "true" : "false");
+    }
+
+    MTS_DECLARE_CLASS()
+protected:
+    bool should_stop() const {
+        return m_stop || (m_timeout > 0.f && m_timer.value() > 1000.f * m_timeout);
+    }
+
+private:
+    int m_max_depth;
+    int m_rr_depth;
+    size_t m_samples_count;
+    bool m_hide_emitters;
+    float m_timeout;
+    Timer m_timer;
+    std::atomic<bool> m_stop;
+};
+
+MTS_IMPLEMENT_CLASS_VARIANT(ParticleTracerIntegrator, Integrator)
+MTS_EXPORT_PLUGIN(ParticleTracerIntegrator, "Particle tracer integrator");
+NAMESPACE_END(mitsuba)
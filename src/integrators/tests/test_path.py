@@ -0,0 +1,96 @@
+import numpy as np
+import enoki as ek
+import pytest
+import mitsuba
+
+
+def make_scene():
+    from mitsuba.core.xml import load_string
+
+    return load_string("""
+        <scene version="2.0.0">
+            <integrator type="path">
+                <integer name="max_depth" value="4"/>
+            </integrator>
+            <sensor type="perspective">
+                <transform name="to_world">
+                    <lookat origin="0, 0, 4" target="0, 0, 0" up="0, 1, 0"/>
+                </transform>
+                <film type="hdrfilm">
+                    <integer name="width" value="8"/>
+                    <integer name="height" value="8"/>
+                    <rfilter type="box"/>
+                </film>
+                <sampler type="independent">
+                    <integer name="sample_count" value="4"/>
+                </sampler>
+            </sensor>
+            <bsdf type="diffuse" id="red">
+                <rgb name="reflectance" value="0.8, 0.2, 0.2"/>
+            </bsdf>
+            <shape type="rectangle">
+                <ref id="red"/>
+            </shape>
+            <shape type="sphere">
+                <point name="center" x="0" y="0" z="1"/>
+                <float name="radius" value="0.3"/>
+                <ref id="red"/>
+            </shape>
+            <emitter type="constant"/>
+        </scene>
+    """)
+
+
+def test01_path_replay_gradient(variant_gpu_autodiff_rgb):
+    from mitsuba.core import Float
+    from mitsuba.python.util import traverse
+    from mitsuba.python.autodiff import render, render_adjoint, SGD
+
+    key = 'red.reflectance.value'
+    pixel_count = 8 * 8
+
+    def gradient(use_replay):
+        scene = make_scene()
+        params = traverse(scene)
+        params.keep([key])
+        opt = SGD(params, lr=1.0)
+
+        # Gradient of the sum of a weighted image
+        image_adjoint = ek.linspace(Float, 0, 1, pixel_count * 3)
+        if use_replay:
+            render_adjoint(scene, image_adjoint, opt, spp=4)
+        else:
+            image = render(scene, spp=4)
+            ek.backward(ek.hsum(image * image_adjoint))
+        return ek.gradient(params[key]).numpy()
+
+    grad_ref = gradient(False)
+    grad_replay = gradient(True)
+
+    assert np.allclose(grad_ref, grad_replay, rtol=1e-3, atol=1e-5)
+
+
+@pytest.mark.parametrize('int_name', ['path', 'direct', 'depth'])
+def test02_nested_in_aov(variants_cpu_rgb, int_name):
+    from mitsuba.core.xml import load_string
+
+    """Nested integrators continue from the primary intersection of the AOV
+    integrator and produce the same image as on their own."""
+    scene = make_scene()
+    sensor = scene.sensors()[0]
+
+    def render(xml):
+        integrator = load_string(xml)
+        assert integrator.render(scene, sensor)
+        return np.array(sensor.film().bitmap(raw=True), copy=True)
+
+    reference = render("""<integrator version="2.0.0" type="%s"/>""" % int_name)
+    image = render("""<integrator version="2.0.0" type="aov">
+            <string name="aovs" value="dd:depth"/>
+            <integrator type="%s" name="image"/>
+        </integrator>""" % int_name)
+
+    # Channels: XYZAW, dd, image.RGBA
+    assert image.shape[2] == 10
+    assert np.allclose(image[:, :, 3], reference[:, :, 3])
+    assert np.allclose(image[:, :, 0:3], reference[:, :, 0:3], atol=1e-5)
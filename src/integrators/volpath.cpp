@@ -2,12 +2,14 @@
 #include <enoki/stl.h>
 #include <mitsuba/core/ray.h>
 #include <mitsuba/core/properties.h>
+#include <mitsuba/core/statistics.h>
 #include <mitsuba/render/bsdf.h>
 #include <mitsuba/render/emitter.h>
 #include <mitsuba/render/integrator.h>
 #include <mitsuba/render/records.h>
 #include <mitsuba/render/medium.h>
 #include <mitsuba/render/phase.h>
+#include <mitsuba/render/rrs.h>
 
 
 NAMESPACE_BEGIN(mitsuba)
@@ -17,10 +19,54 @@ class VolumetricPathIntegrator : public MonteCarloIntegrator<Float, Spectrum> {
 
 public:
     MTS_IMPORT_BASE(MonteCarloIntegrator, m_max_depth, m_rr_depth, m_hide_emitters)
-    MTS_IMPORT_TYPES(Scene, Sampler, Emitter, EmitterPtr, BSDF, BSDFPtr,
+    MTS_IMPORT_TYPES(Scene, Sensor, Sampler, Emitter, EmitterPtr, BSDF, BSDFPtr,
                      Medium, MediumPtr, PhaseFunctionContext)
+    using RRSCache = mitsuba::RRSCache<Float, Spectrum>;
+    using RRSVertex = typename RRSCache::Vertex;
 
     VolumetricPathIntegrator(const Properties &props) : Base(props) {
+        /* Estimator of the transmittance towards emitters through media (for
+           emitter sampling and for emitters hit by BSDF sampling): ratio
+           tracking ("ratio"), or residual ratio tracking ("residual_ratio")
+           for media that provide a control extinction. Homogeneous media
+           always use the analytic transmittance (see Medium::eval_transmittance) */
+        std::string estimator = props.string("transmittance_estimator", "ratio");
+        if (estimator == "ratio")
+            m_residual_ratio_tracking = false;
+        else if (estimator == "residual_ratio")
+            m_residual_ratio_tracking = true;
+        else
+            Throw("Invalid transmittance estimator \"%s\", must be one of: \"ratio\" "
+                  "or \"residual_ratio\"!", estimator);
+
+        /* Russian roulette based on the throughput ("throughput"), or
+           efficiency-aware Russian roulette and splitting ("adaptive"), whose
+           factors are learned during the first passes (see RRSCache and the
+           documentation of the path tracer) */
+        std::string rr_mode = props.string("rr_mode", "throughput");
+        if (rr_mode == "adaptive") {
+            if constexpr (is_diff_array_v<Float>)
+                Throw("Adaptive Russian roulette and splitting is not supported by the "
+                      "differentiable variants.");
+            m_rrs = new RRSCache(props);
+        } else if (rr_mode != "throughput") {
+            Throw("Invalid Russian roulette mode \"%s\", must be one of: \"throughput\" "
+                  "or \"adaptive\"!", rr_mode);
+        }
+    }
+
+    bool uses_pass_hooks() const override { return m_rrs != nullptr; }
+
+    void prepare_pass(const Scene *scene, const Sensor * /* sensor */, size_t pass,
+                      size_t /* pass_count */) override {
+        if (m_rrs)
+            m_rrs->prepare_pass(scene, pass);
+    }
+
+    void finish_pass(const Scene * /* scene */, const Sensor * /* sensor */, size_t pass,
+                     size_t /* pass_count */) override {
+        if (m_rrs)
+            m_rrs->finish_pass(pass);
     }
 
     MTS_INLINE
@@ -69,22 +115,95 @@ public:
         SurfaceInteraction3f si = zero<SurfaceInteraction3f>();
         si.t = math::Infinity<Float>;
         Mask needs_intersection = true;
+
+        /* Adaptive Russian roulette and splitting: the learning passes record
+           the scattering vertices of the paths, later passes continue the
+           split copies of a path once the path itself has terminated */
+        bool rrs_learning = m_rrs && m_rrs->learning(),
+             rrs_ready    = m_rrs && m_rrs->ready();
+        RRSVertex rrs_vertices[RRSCache::MaxVertices];
+        uint32_t rrs_vertex_count = 0;
+        std::vector<Branch> branches;
+        bool resume = false;
+
+        // Depth of the last vertex handled by the adaptive mode (null collisions keep the depth)
+        UInt32 rrs_depth = 0;
+
         for (int bounce = 0;; ++bounce) {
             // ----------------- Handle termination of paths ------------------
 
-            // Russian roulette: try to keep path weights equal to one, while accounting for the
-            // solid angle compression at refractive index boundaries. Stop with at least some
-            // probability to avoid  getting stuck (e.g. due to total internal reflection)
+            if (!resume) {
+                // Russian roulette: try to keep path weights equal to one, while accounting for the
+                // solid angle compression at refractive index boundaries. Stop with at least some
+                // probability to avoid  getting stuck (e.g. due to total internal reflection)
+
+                active &= any(neq(depolarize(throughput), 0.f));
+                Float q = min(hmax(depolarize(throughput)) * sqr(eta), .95f);
+                Mask perform_rr = (depth > (uint32_t) m_rr_depth);
+
+                // Scattering vertex (the origin of the current ray) that is new to the adaptive mode
+                Mask rrs_vertex = active && depth > rrs_depth;
+
+                if (rrs_ready) {
+                    Mask split_active = rrs_vertex && depth < (uint32_t) m_max_depth;
+                    auto [copies, q_rrs] = m_rrs->split(
+                        ray.o, hmean(depolarize(throughput)), select(perform_rr, q, 1.f),
+                        sampler->next_1d(split_active), branches.size() < RRSCache::MaxBranches,
+                        split_active);
+                    stats_count(StatsCounter::RRTerminations, split_active && eq(copies, 0u));
+                    active &= !split_active || copies > 0u;
+                    masked(throughput, split_active) *= rcp(q_rrs);
+
+                    masked(rrs_depth, rrs_vertex) = depth;
+
+                    Branch branch{ ray, si, mi, medium, throughput, eta, depth, rrs_depth,
+                                   specular_chain, needs_intersection, active };
+                    uint32_t max_copies = hmax(copies);
+                    for (uint32_t i = 1; i < max_copies; ++i) {
+                        branch.active = split_active && copies > i;
+                        branches.push_back(branch);
+                    }
+                } else {
+                    Mask rr_continue = sampler->next_1d(active) < q || !perform_rr;
+                    stats_count(StatsCounter::RRTerminations, active && !rr_continue);
+                    active &= rr_continue;
+                    masked(throughput, perform_rr) *= rcp(detach(q));
+                }
 
-            active &= any(neq(depolarize(throughput), 0.f));
-            Float q = min(hmax(depolarize(throughput)) * sqr(eta), .95f);
-            Mask perform_rr = (depth > (uint32_t) m_rr_depth);
-            active &= sampler->next_1d(active) < q || !perform_rr;
-            masked(throughput, perform_rr) *= rcp(detach(q));
+                if (rrs_learning && any(rrs_vertex) && rrs_vertex_count < RRSCache::MaxVertices) {
+                    RRSVertex &v = rrs_vertices[rrs_vertex_count++];
+                    v.p        = ray.o;
+                    v.weight   = hmean(depolarize(throughput));
+                    v.radiance = hmean(depolarize(result));
+                    v.length   = depth;
+                    v.active   = rrs_vertex && active;
+                    masked(rrs_depth, rrs_vertex) = depth;
+                }
+            }
+            resume = false;
 
             Mask exceeded_max_depth = depth >= (uint32_t) m_max_depth;
-            if (none(active) || all(exceeded_max_depth))
-                break;
+            if (none(active) || all(exceeded_max_depth)) {
+                if (branches.empty())
+                    break;
+
+                // Continue with the most recent copy of a split path
+                Branch &branch     = branches.back();
+                ray                = branch.ray;
+                si                 = branch.si;
+                mi                 = branch.mi;
+                medium             = branch.medium;
+                throughput         = branch.throughput;
+                eta                = branch.eta;
+                depth              = branch.depth;
+                rrs_depth          = branch.rrs_depth;
+                specular_chain     = branch.specular_chain;
+                needs_intersection = branch.needs_intersection;
+                active             = branch.active;
+                branches.pop_back();
+                resume = true;
+                continue;
+            }
 
             // ----------------------- Sampling the RTE -----------------------
             Mask active_medium  = active && neq(medium, nullptr);
@@ -111,7 +230,7 @@ public:
 
                 masked(mi.t, active_medium && (si.t < mi.t)) = math::Infinity<Float>;
                 if (any_or<true>(is_spectral)) {
-                    auto [tr, free_flight_pdf] = medium->eval_tr_and_pdf(mi, si, is_spectral);
+                    auto [tr, free_flight_pdf] = medium->eval_tr_and_pdf(ray, mi, si, is_spectral);
                     Float tr_pdf = index_spectrum(free_flight_pdf, channel);
                     masked(throughput, is_spectral) *= select(tr_pdf > 0.f, tr / tr_pdf, 0.f);
                 }
@@ -123,6 +242,7 @@ public:
                 Mask null_scatter = sampler->next_1d(active_medium) >= index_spectrum(mi.sigma_t, channel) / index_spectrum(mi.combined_extinction, channel);
 
                 act_null_scatter |= null_scatter && active_medium;
+                stats_count(StatsCounter::NullCollisions, null_scatter && active_medium);
                 act_medium_scatter |= !act_null_scatter && active_medium;
 
                 if (any_or<true>(is_spectral && act_null_scatter))
@@ -202,12 +322,10 @@ public:
 
                     // Query the BSDF for that emitter-sampled direction
                     Vector3f wo       = si.to_local(ds.d);
-                    Spectrum bsdf_val = bsdf->eval(ctx, si, wo, active_e);
+                    // Also determine the probability of having sampled that
+                    // same direction using BSDF sampling.
+                    auto [bsdf_val, bsdf_pdf] = bsdf->eval_pdf(ctx, si, wo, active_e);
                     bsdf_val = si.to_world_mueller(bsdf_val, -wo, si.wi);
-
-                    // Determine probability of having sampled that same
-                    // direction using BSDF sampling.
-                    Float bsdf_pdf = bsdf->pdf(ctx, si, wo, active_e);
                     result[active_e] += throughput * bsdf_val * mis_weight(ds.pdf, select(ds.delta, 0.f, bsdf_pdf)) * emitted;
                 }
 
@@ -253,9 +371,27 @@ public:
             }
             active &= (active_surface | active_medium);
         }
+
+        if (rrs_learning)
+            m_rrs->record(rrs_vertices, rrs_vertex_count, hmean(depolarize(result)), depth,
+                          valid_ray);
+
+        stats_histogram(StatsHistogram::PathLength, depth, valid_ray);
         return { result, valid_ray };
     }
 
+    /// Path state at the start of a bounce, which is continued once the path terminates
+    struct Branch {
+        Ray3f ray;
+        SurfaceInteraction3f si;
+        MediumInteraction3f mi;
+        MediumPtr medium;
+        Spectrum throughput;
+        Float eta;
+        UInt32 depth, rrs_depth;
+        Mask specular_chain, needs_intersection, active;
+    };
+
 
     /// Samples an emitter in the scene and evaluates it's attenuated contribution
     std::tuple<Spectrum, DirectionSample3f>
@@ -291,46 +427,20 @@ public:
             Mask active_surface = active && !active_medium;
 
             if (any_or<true>(active_medium)) {
-                auto mi = medium->sample_interaction(ray, sampler->next_1d(active_medium), channel, active_medium);
-                masked(ray.maxt, active_medium && medium->is_homogeneous() && mi.is_valid()) = min(mi.t, remaining_dist);
+                // Find the end of the segment that lies within the current medium
                 Mask intersect = needs_intersection && active_medium;
                 if (any_or<true>(intersect))
                     masked(si, intersect) = scene->ray_intersect(ray, intersect);
-
-                masked(mi.t, active_medium && (si.t < mi.t)) = math::Infinity<Float>;
                 needs_intersection &= !active_medium;
 
-                Mask is_spectral = medium->has_spectral_extinction() && active_medium;
-                Mask not_spectral = !is_spectral && active_medium;
-                if (any_or<true>(is_spectral)) {
-                    Float t      = min(remaining_dist, min(mi.t, si.t)) - mi.mint;
-                    UnpolarizedSpectrum tr  = exp(-t * mi.combined_extinction);
-                    UnpolarizedSpectrum free_flight_pdf = select(si.t < mi.t || mi.t > remaining_dist, tr, tr * mi.combined_extinction);
-                    Float tr_pdf = index_spectrum(free_flight_pdf, channel);
-                    masked(transmittance, is_spectral) *= select(tr_pdf > 0.f, tr / tr_pdf, 0.f);
-                }
-
-                // Handle exceeding the maximum distance by medium sampling
-                masked(total_dist, active_medium && (mi.t > remaining_dist) && mi.is_valid()) = ds.dist;
-                masked(mi.t, active_medium && (mi.t > remaining_dist)) = math::Infinity<Float>;
-
-                escaped_medium = active_medium && !mi.is_valid();
-                active_medium &= mi.is_valid();
-                is_spectral &= active_medium;
-                not_spectral &= active_medium;
+                Ray3f segment(ray);
+                segment.maxt = min(si.t, remaining_dist);
+                masked(transmittance, active_medium) *= medium->eval_transmittance(
+                    segment, sampler, channel, m_residual_ratio_tracking, active_medium);
 
-                masked(total_dist, active_medium) += mi.t;
-
-                if (any_or<true>(active_medium)) {
-                    masked(ray.o, active_medium)    = mi.p;
-                    masked(ray.mint, active_medium) = 0.f;
-                    masked(si.t, active_medium) = si.t - mi.t;
-
-                    if (any_or<true>(is_spectral))
-                        masked(transmittance, is_spectral) *= mi.sigma_n;
-                    if (any_or<true>(not_spectral))
-                        masked(transmittance, not_spectral) *= mi.sigma_n / mi.combined_extinction;
-                }
+                // Continue at the surface that bounds the segment
+                escaped_medium = active_medium;
+                active_medium  = false;
             }
 
             // Handle interactions with surfaces
@@ -386,38 +496,21 @@ public:
             Mask escaped_medium = false;
             Mask active_medium  = active && neq(medium, nullptr);
             Mask active_surface = active && !active_medium;
-            SurfaceInteraction3f si_medium;
             if (any_or<true>(active_medium)) {
-                auto mi = medium->sample_interaction(ray, sampler->next_1d(active_medium), channel, active_medium);
-                masked(ray.maxt, active_medium && medium->is_homogeneous() && mi.is_valid()) = mi.t;
+                // Find the end of the segment that lies within the current medium
                 Mask intersect = needs_intersection && active_medium;
                 if (any_or<true>(intersect))
                     masked(si, intersect) = scene->ray_intersect(ray, intersect);
-
-                masked(mi.t, active_medium && (si.t < mi.t)) = math::Infinity<Float>;
-
-                Mask is_spectral = medium->has_spectral_extinction() && active_medium;
-                Mask not_spectral = !is_spectral && active_medium;
-                if (any_or<true>(is_spectral)) {
-                    auto [tr, free_flight_pdf] = medium->eval_tr_and_pdf(mi, si, is_spectral);
-                    Float tr_pdf = index_spectrum(free_flight_pdf, channel);
-                    masked(transmittance, is_spectral) *= select(tr_pdf > 0.f, tr / tr_pdf, 0.f);
-                }
-
                 needs_intersection &= !active_medium;
-                escaped_medium = active_medium && !mi.is_valid();
-                active_medium &= mi.is_valid();
 
-                if (any_or<true>(active_medium)) {
-                    masked(ray.o, active_medium)    = mi.p;
-                    masked(ray.mint, active_medium) = 0.f;
-                    masked(si.t, active_medium) = si.t - mi.t;
+                Ray3f segment(ray);
+                segment.maxt = min(si.t, ray.maxt);
+                masked(transmittance, active_medium) *= medium->eval_transmittance(
+                    segment, sampler, channel, m_residual_ratio_tracking, active_medium);
 
-                    if (any_or<true>(is_spectral))
-                        masked(transmittance, is_spectral && active_medium) *= mi.sigma_n;
-                    if (any_or<true>(not_spectral))
-                        masked(transmittance, not_spectral && active_medium) *= mi.sigma_n / mi.combined_extinction;
-                }
+                // Continue at the surface that bounds the segment
+                escaped_medium = active_medium;
+                active_medium  = false;
             }
 
             // Handle interactions with surfaces
@@ -471,9 +564,11 @@ public:
     std::string to_string() const override {
         return tfm::format("VolumetricSimplePathIntegrator[\n"
                            "  max_depth = %i,\n"
-                           "  rr_depth = %i\n"
+                           "  rr_depth = %i,\n"
+                           "  transmittance_estimator = %s\n"
                            "]",
-                           m_max_depth, m_rr_depth);
+                           m_max_depth, m_rr_depth,
+                           m_residual_ratio_tracking ? "residual_ratio" : "ratio");
     }
 
     Float mis_weight(Float pdf_a, Float pdf_b) const {
@@ -483,6 +578,12 @@ public:
     };
 
     MTS_DECLARE_CLASS()
+private:
+    /// Use residual ratio tracking for the transmittance towards emitters
+    bool m_residual_ratio_tracking;
+
+    /// Statistics of the adaptive Russian roulette and splitting (\c nullptr if disabled)
+    ref<RRSCache> m_rrs;
 };
 
 MTS_IMPLEMENT_CLASS_VARIANT(VolumetricPathIntegrator, MonteCarloIntegrator);
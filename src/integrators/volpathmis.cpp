@@ -2,6 +2,7 @@
 #include <enoki/stl.h>
 #include <mitsuba/core/ray.h>
 #include <mitsuba/core/properties.h>
+#include <mitsuba/core/statistics.h>
 #include <mitsuba/render/bsdf.h>
 #include <mitsuba/render/emitter.h>
 #include <mitsuba/render/integrator.h>
@@ -136,7 +137,9 @@ public:
             Spectrum mis_throughput = mis_weight(p_over_f);
             Float q = min(hmax(depolarize(mis_throughput)) * sqr(eta), .95f);
             Mask perform_rr = active && !last_event_was_null && (depth > (uint32_t) m_rr_depth);
-            active &= !(sampler->next_1d(active) >= q && perform_rr);
+            Mask rr_terminate = sampler->next_1d(active) >= q && perform_rr;
+            stats_count(StatsCounter::RRTerminations, active && rr_terminate);
+            active &= !rr_terminate;
             update_weights(p_over_f, detach(q), 1.0f, channel, perform_rr);
 
             last_event_was_null = false;
@@ -173,7 +176,7 @@ public:
                 masked(mi.t, active_medium && (si.t < mi.t)) = math::Infinity<Float>;
 
                 if (any_or<true>(is_spectral)) {
-                    auto [tr, free_flight_pdf] = medium->eval_tr_and_pdf(mi, si, is_spectral);
+                    auto [tr, free_flight_pdf] = medium->eval_tr_and_pdf(ray, mi, si, is_spectral);
                     update_weights(p_over_f, free_flight_pdf, tr, channel, is_spectral);
                     update_weights(p_over_f_nee, free_flight_pdf, tr, channel, is_spectral);
                 }
@@ -186,6 +189,7 @@ public:
             if (any_or<true>(active_medium)) {
                 Mask null_scatter = sampler->next_1d(active_medium) >= index_spectrum(mi.sigma_t, channel) / index_spectrum(mi.combined_extinction, channel);
                 act_null_scatter |= null_scatter && active_medium;
+                stats_count(StatsCounter::NullCollisions, null_scatter && active_medium);
                 act_medium_scatter |= !act_null_scatter && active_medium;
 
                 // Count this as a bounce
@@ -288,8 +292,7 @@ public:
                 if (likely(any_or<true>(active_e))) {
                     auto [p_over_f_nee_end, p_over_f_end, emitted, ds] = sample_emitter(si, false, scene, sampler, medium, p_over_f, channel, active_e);
                     Vector3f wo_local       = si.to_local(ds.d);
-                    Spectrum bsdf_val = bsdf->eval(ctx, si, wo_local, active_e);
-                    Float bsdf_pdf =  bsdf->pdf(ctx, si, wo_local, active_e);
+                    auto [bsdf_val, bsdf_pdf] = bsdf->eval_pdf(ctx, si, wo_local, active_e);
                     update_weights(p_over_f_nee_end, 1.0f, depolarize(bsdf_val), channel, active_e);
                     update_weights(p_over_f_end, select(ds.delta, 0.f, bsdf_pdf), depolarize(bsdf_val), channel, active_e);
                     masked(result, active_e) += mis_weight(p_over_f_nee_end, p_over_f_end) * emitted;
@@ -324,6 +327,7 @@ public:
             active &= (active_surface | active_medium);
         }
 
+        stats_histogram(StatsHistogram::PathLength, depth, valid_ray);
         return { result, valid_ray };
     }
 
@@ -374,9 +378,13 @@ public:
                 Mask is_spectral = medium->has_spectral_extinction() && active_medium;
                 Mask not_spectral = !is_spectral && active_medium;
                 if (any_or<true>(is_spectral)) {
-                    Float t      = min(remaining_dist, min(mi.t, si.t)) - mi.mint;
-                    UnpolarizedSpectrum tr  = exp(-t * mi.combined_extinction);
-                    UnpolarizedSpectrum free_flight_pdf = select(si.t < mi.t || mi.t > remaining_dist, tr, tr * mi.combined_extinction);
+                    // The segment ends at the emitter when the sampled distance exceeds it
+                    MediumInteraction3f mi_segment = mi;
+                    masked(mi_segment.t, mi.t > remaining_dist) = math::Infinity<Float>;
+                    SurfaceInteraction3f si_segment = si;
+                    si_segment.t = min(si.t, remaining_dist);
+                    auto [tr, free_flight_pdf] =
+                        medium->eval_tr_and_pdf(ray, mi_segment, si_segment, is_spectral);
                     update_weights(p_over_f_nee, free_flight_pdf, tr, channel, is_spectral);
                     update_weights(p_over_f_uni, free_flight_pdf, tr, channel, is_spectral);
                 }
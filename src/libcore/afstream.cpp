@@ -0,0 +1,267 @@
+#include <mitsuba/core/afstream.h>
+#include <mitsuba/core/logger.h>
+#include <mitsuba/core/util.h>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <fstream>
+#include <mutex>
+#include <sstream>
+#include <thread>
+
+NAMESPACE_BEGIN(mitsuba)
+
+struct AsyncFileStream::AsyncFileStreamPrivate {
+    struct Block {
+        std::unique_ptr<uint8_t[]> data;
+        size_t offset = 0;
+        size_t size = 0;
+    };
+
+    fs::path path;
+    size_t block_size, block_count, file_size;
+
+    /// Current position of the reader
+    size_t pos = 0;
+
+    /// Offset of the next block that will be read by the worker thread
+    size_t next_offset = 0;
+
+    /// Incremented whenever the read-ahead restarts at a new position
+    size_t generation = 0;
+
+    /// Filled blocks in file order, and blocks that are available for reading
+    std::deque<Block *> ready, free;
+    std::vector<Block> blocks;
+
+    std::string error;
+    bool stop = false, closed = false;
+
+    std::mutex mutex;
+    std::condition_variable cv_ready, cv_free;
+    std::thread worker;
+
+    /// Body of the worker thread: fill the free blocks in file order
+    void run() {
+        std::ifstream file(path.string(), std::ios::binary | std::ios::in);
+        std::unique_lock<std::mutex> guard(mutex);
+        if (!file.good()) {
+            error = tfm::format("\"%s\": I/O error while attempting to open file: %s",
+                                path.string(), strerror(errno));
+            cv_ready.notify_all();
+            return;
+        }
+
+        while (true) {
+            cv_free.wait(guard, [&] {
+                return stop || (!free.empty() && next_offset < file_size);
+            });
+            if (stop)
+                break;
+
+            Block *block = free.front();
+            free.pop_front();
+            size_t offset = next_offset,
+                   size   = std::min(block_size, file_size - offset),
+                   gen    = generation;
+            next_offset += size;
+
+            guard.unlock();
+            file.seekg((std::streamoff) offset);
+            file.read((char *) block->data.get(), (std::streamsize) size);
+            bool good = file.good();
+            guard.lock();
+
+            if (!good) {
+                error = tfm::format("\"%s\": I/O error while attempting to read %zu bytes "
+                                    "at offset %zu: %s", path.string(), size, offset,
+                                    strerror(errno));
+                free.push_back(block);
+                cv_ready.notify_all();
+                break;
+            }
+
+            block->offset = offset;
+            block->size = size;
+
+            if (gen == generation) {
+                ready.push_back(block);
+                cv_ready.notify_all();
+            } else {
+                // The reader moved elsewhere while this block was being read
+                free.push_back(block);
+            }
+        }
+    }
+
+    /// Recycle all buffered blocks and restart the read-ahead at 'pos' (mutex must be held)
+    void restart() {
+        while (!ready.empty()) {
+            free.push_back(ready.front());
+            ready.pop_front();
+        }
+        generation++;
+        next_offset = pos;
+        cv_free.notify_all();
+    }
+};
+
+AsyncFileStream::AsyncFileStream(const fs::path &p, size_t block_size, size_t block_count)
+    : Stream(), d(new AsyncFileStreamPrivate()) {
+    if (!fs::exists(p))
+        Throw("\"%s\": I/O error while attempting to open file: file does not exist",
+              p.string());
+    if (block_size == 0 || block_count == 0)
+        Throw("AsyncFileStream: the block size and count must be nonzero!");
+
+    d->path = p;
+    d->block_size = block_size;
+    d->block_count = block_count;
+    d->file_size = fs::file_size(p);
+
+    d->blocks.resize(block_count);
+    for (auto &block : d->blocks) {
+        block.data.reset(new uint8_t[block_size]);
+        d->free.push_back(&block);
+    }
+
+    d->worker = std::thread([this] { d->run(); });
+}
+
+AsyncFileStream::~AsyncFileStream() {
+    close();
+}
+
+void AsyncFileStream::close() {
+    /* scope */ {
+        std::lock_guard<std::mutex> guard(d->mutex);
+        if (d->closed)
+            return;
+        d->stop = d->closed = true;
+        d->cv_free.notify_all();
+    }
+    d->worker.join();
+}
+
+bool AsyncFileStream::is_closed() const {
+    return d->closed;
+}
+
+const fs::path &AsyncFileStream::path() const { return d->path; }
+size_t AsyncFileStream::block_size() const { return d->block_size; }
+size_t AsyncFileStream::block_count() const { return d->block_count; }
+
+void AsyncFileStream::read(void *p_, size_t size) {
+    uint8_t *p = (uint8_t *) p_;
+    std::unique_lock<std::mutex> guard(d->mutex);
+    if (d->closed)
+        Throw("\"%s\": attempting to read from a closed stream", d->path.string());
+
+    size_t available = d->pos < d->file_size ? d->file_size - d->pos : 0,
+           remaining = std::min(size, available);
+
+    while (remaining > 0) {
+        d->cv_ready.wait(guard, [&] { return !d->ready.empty() || !d->error.empty(); });
+        if (!d->error.empty())
+            Throw("%s", d->error);
+
+        AsyncFileStreamPrivate::Block *block = d->ready.front();
+        if (d->pos < block->offset) {
+            // Cannot happen for sequential reads, but be defensive
+            d->restart();
+            continue;
+        }
+
+        size_t block_end = block->offset + block->size;
+        if (d->pos < block_end) {
+            size_t amount = std::min(remaining, block_end - d->pos);
+            std::memcpy(p, block->data.get() + (d->pos - block->offset), amount);
+            p += amount;
+            d->pos += amount;
+            remaining -= amount;
+        }
+
+        if (d->pos >= block_end) {
+            // The block was consumed: hand it back to the worker thread
+            d->ready.pop_front();
+            d->free.push_back(block);
+            d->cv_free.notify_all();
+        }
+    }
+
+    if (size > available) {
+        size_t gcount = available;
+        throw EOFException(tfm::format("\"%s\": read %zu out of %zu bytes",
+                                       d->path.string(), gcount, size), gcount);
+    }
+}
+
+void AsyncFileStream::write(const void *, size_t size) {
+    Throw("\"%s\": attempting to write %zu bytes to a read-only AsyncFileStream",
+          d->path.string(), size);
+}
+
+void AsyncFileStream::seek(size_t pos) {
+    std::lock_guard<std::mutex> guard(d->mutex);
+    if (d->closed)
+        Throw("\"%s\": attempting to seek in a closed stream", d->path.string());
+
+    d->pos = pos;
+
+    // Drop the blocks before the new position if it lies within the buffered range
+    while (!d->ready.empty()) {
+        AsyncFileStreamPrivate::Block *block = d->ready.front();
+        if (pos >= block->offset && pos < block->offset + block->size)
+            return;
+        if (pos < block->offset)
+            break;
+        d->ready.pop_front();
+        d->free.push_back(block);
+        d->cv_free.notify_all();
+    }
+
+    // Blocks that are still being read ahead will arrive next
+    if (d->ready.empty() && pos == d->next_offset)
+        return;
+
+    d->restart();
+}
+
+void AsyncFileStream::truncate(size_t) {
+    Throw("\"%s\": attempting to truncate a read-only AsyncFileStream",
+          d->path.string());
+}
+
+size_t AsyncFileStream::tell() const {
+    std::lock_guard<std::mutex> guard(d->mutex);
+    return d->pos;
+}
+
+size_t AsyncFileStream::size() const {
+    return d->file_size;
+}
+
+std::string AsyncFileStream::to_string() const {
+    std::ostringstream oss;
+
+    oss << class_()->name() << "[" << std::endl;
+    if (is_closed()) {
+        oss << "  closed" << std::endl;
+    } else {
+        oss << "  path = \"" << d->path.string() << "\"" << "," << std::endl
+            << "  host_byte_order = " << host_byte_order() << "," << std::endl
+            << "  byte_order = " << byte_order() << "," << std::endl
+            << "  block_size = " << util::mem_string(d->block_size) << "," << std::endl
+            << "  block_count = " << d->block_count << "," << std::endl
+            << "  pos = " << tell() << "," << std::endl
+            << "  size = " << size() << std::endl;
+    }
+
+    oss << "]";
+
+    return oss.str();
+}
+
+MTS_IMPLEMENT_CLASS(AsyncFileStream, Stream)
+
+NAMESPACE_END(mitsuba)
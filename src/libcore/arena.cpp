@@ -0,0 +1,97 @@
+#include <mitsuba/core/arena.h>
+#include <mitsuba/core/logger.h>
+#include <tbb/spin_mutex.h>
+#include <cstdint>
+#include <vector>
+
+NAMESPACE_BEGIN(mitsuba)
+
+struct MemoryArena::MemoryArenaPrivate {
+    struct Block {
+        std::unique_ptr<uint8_t[]> data;
+        size_t size;
+    };
+
+    size_t block_size;
+
+    /// All blocks; the last one is the block that is currently being filled
+    std::vector<Block> blocks;
+
+    /// Position within the current block
+    size_t offset = 0;
+
+    size_t allocated = 0, capacity = 0;
+
+    tbb::spin_mutex mutex;
+
+    uint8_t *add_block(size_t size) {
+        blocks.push_back(Block { std::unique_ptr<uint8_t[]>(new uint8_t[size]), size });
+        capacity += size;
+        return blocks.back().data.get();
+    }
+};
+
+MemoryArena::MemoryArena(size_t block_size) : d(new MemoryArenaPrivate()) {
+    if (block_size == 0)
+        Throw("MemoryArena: the block size must be nonzero!");
+    d->block_size = block_size;
+}
+
+MemoryArena::~MemoryArena() { }
+
+void *MemoryArena::allocate(size_t size, size_t align) {
+    if (size == 0)
+        size = 1;
+
+    tbb::spin_mutex::scoped_lock guard(d->mutex);
+    d->allocated += size;
+
+    /* Large allocations get their own block, which is inserted before the
+       current one so that the latter can still be filled */
+    if (size > d->block_size / 4) {
+        uint8_t *ptr = d->add_block(size + align);
+        if (d->blocks.size() > 1)
+            std::swap(d->blocks.back(), d->blocks[d->blocks.size() - 2]);
+        else
+            d->offset = size + align; // There is no current block: mark this one as full
+        return (void *) (((uintptr_t) ptr + align - 1) / align * align);
+    }
+
+    if (!d->blocks.empty()) {
+        const auto &block = d->blocks.back();
+        uintptr_t base  = (uintptr_t) block.data.get(),
+                  start = (base + d->offset + align - 1) / align * align;
+        if (start + size <= base + block.size) {
+            d->offset = start + size - base;
+            return (void *) start;
+        }
+    }
+
+    // The blocks are allocated with new[], which aligns them to max_align_t
+    uint8_t *ptr = d->add_block(d->block_size + (align > alignof(std::max_align_t) ? align : 0));
+    uintptr_t start = ((uintptr_t) ptr + align - 1) / align * align;
+    d->offset = start + size - (uintptr_t) ptr;
+    return (void *) start;
+}
+
+void MemoryArena::release() {
+    tbb::spin_mutex::scoped_lock guard(d->mutex);
+    d->blocks.clear();
+    d->offset = d->allocated = d->capacity = 0;
+}
+
+size_t MemoryArena::allocated() const {
+    tbb::spin_mutex::scoped_lock guard(d->mutex);
+    return d->allocated;
+}
+
+size_t MemoryArena::capacity() const {
+    tbb::spin_mutex::scoped_lock guard(d->mutex);
+    return d->capacity;
+}
+
+size_t MemoryArena::block_size() const {
+    return d->block_size;
+}
+
+NAMESPACE_END(mitsuba)
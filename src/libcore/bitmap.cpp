@@ -6,7 +6,10 @@
 #include <mitsuba/core/rfilter.h>
 #include <mitsuba/core/transform.h>
 #include <mitsuba/core/fstream.h>
+#include <mitsuba/core/thread.h>
 #include <tbb/tbb.h>
+#include <condition_variable>
+#include <mutex>
 #include <unordered_map>
 
 /* libpng */
@@ -36,6 +39,14 @@ extern "C" {
 #include <ImfStandardAttributes.h>
 #include <ImfRgbaYca.h>
 #include <ImfOutputFile.h>
+#include <ImfMultiPartInputFile.h>
+#include <ImfMultiPartOutputFile.h>
+#include <ImfInputPart.h>
+#include <ImfOutputPart.h>
+#include <ImfTiledOutputFile.h>
+#include <ImfTiledOutputPart.h>
+#include <ImfPartType.h>
+#include <ImfThreading.h>
 #include <ImfChannelList.h>
 #include <ImfStringAttribute.h>
 #include <ImfIntAttribute.h>
@@ -84,7 +95,9 @@ Bitmap::Bitmap(const Bitmap &bitmap)
       m_size(bitmap.m_size),
       m_struct(new Struct(*bitmap.m_struct)),
       m_srgb_gamma(bitmap.m_srgb_gamma),
-      m_owns_data(true) {
+      m_owns_data(true),
+      m_exr_tile_size(bitmap.m_exr_tile_size),
+      m_exr_multi_part(bitmap.m_exr_multi_part) {
     size_t size = buffer_size();
     m_data = std::unique_ptr<uint8_t[]>(new uint8_t[size]);
     memcpy(m_data.get(), bitmap.m_data.get(), size);
@@ -98,7 +111,9 @@ Bitmap::Bitmap(Bitmap &&bitmap)
       m_size(bitmap.m_size),
       m_struct(std::move(bitmap.m_struct)),
       m_srgb_gamma(bitmap.m_srgb_gamma),
-      m_owns_data(bitmap.m_owns_data) {
+      m_owns_data(bitmap.m_owns_data),
+      m_exr_tile_size(bitmap.m_exr_tile_size),
+      m_exr_multi_part(bitmap.m_exr_multi_part) {
 }
 
 Bitmap::Bitmap(Stream *stream, FileFormat format) {
@@ -110,6 +125,13 @@ Bitmap::Bitmap(const fs::path &filename, FileFormat format) {
     read(fs, format);
 }
 
+ref<Bitmap> Bitmap::read_header(const fs::path &path, FileFormat format) {
+    ref<FileStream> fs = new FileStream(path);
+    ref<Bitmap> bitmap = new Bitmap();
+    bitmap->read(fs, format);
+    return bitmap;
+}
+
 Bitmap::~Bitmap() {
     if (!m_owns_data)
         m_data.release();
@@ -228,6 +250,44 @@ void Bitmap::vflip() {
     }
 }
 
+/// Number of rows per parallel task when each one involves \c work operations
+static size_t row_grain(size_t work) {
+    return std::max((size_t) 1, (size_t) 16384 / std::max(work, (size_t) 1));
+}
+
+/**
+ * \brief Run a StructConverter over an image in parallel bands of rows
+ *
+ * The bands start at multiples of 256 rows, which is the period of the
+ * dither matrix that is used when quantizing to integers. The result is
+ * thus identical to a single call to \ref StructConverter::convert_2d().
+ */
+static bool convert_2d_parallel(const StructConverter &conv, size_t width, size_t height,
+                                const uint8_t *source, uint8_t *target) {
+    const size_t band_size = 256;
+    size_t source_row = conv.source()->size() * width,
+           target_row = conv.target()->size() * width,
+           band_count = (height + band_size - 1) / band_size;
+
+    if (band_count <= 1)
+        return conv.convert_2d(width, height, source, target);
+
+    std::atomic<bool> success(true);
+    tbb::parallel_for(
+        tbb::blocked_range<size_t>(0, band_count),
+        [&](const tbb::blocked_range<size_t> &range) {
+            for (size_t i = range.begin(); i != range.end(); ++i) {
+                size_t y = i * band_size;
+                if (!conv.convert_2d(width, std::min(band_size, height - y),
+                                     source + y * source_row, target + y * target_row))
+                    success = false;
+            }
+        }
+    );
+
+    return success;
+}
+
 template <typename Scalar, bool Filter,
           typename ReconstructionFilter = typename Bitmap::ReconstructionFilter>
 static void
@@ -274,7 +334,7 @@ resample(Bitmap *target, const Bitmap *source,
         }
 
         tbb::parallel_for(
-            tbb::blocked_range<size_t>(0, source->height(), 100),
+            tbb::blocked_range<size_t>(0, source->height(), row_grain(target->width())),
             [&](const tbb::blocked_range<size_t> &range) {
                 for (auto y = range.begin(); y != range.end(); ++y) {
                     const Scalar *s = (const Scalar *) source->uint8_data() +
@@ -296,16 +356,15 @@ resample(Bitmap *target, const Bitmap *source,
         r.set_boundary_condition(bc.second);
         r.set_clamp(clamp);
 
+        // Process bands of target rows, each of which combines entire source rows
         tbb::parallel_for(
-            tbb::blocked_range<size_t>(0, source->width(), 100),
-            [&](const tbb::blocked_range<size_t> &range) {
-                for (auto x = range.begin(); x != range.end(); ++x) {
-                    const Scalar *s = (const Scalar *) source->uint8_data() +
-                                      x * channels;
-                    Scalar *t       = (Scalar *) target->uint8_data() +
-                                      x * channels;
-                    r.resample(s, source->width(), t, target->width(), (uint32_t) channels);
-                }
+            tbb::blocked_range<uint32_t>(0, (uint32_t) target->height(),
+                                         (uint32_t) row_grain(target->width() * r.taps())),
+            [&](const tbb::blocked_range<uint32_t> &range) {
+                r.resample_rows((const Scalar *) source->uint8_data(),
+                                (Scalar *) target->uint8_data(),
+                                (size_t) target->width() * channels,
+                                range.begin(), range.end());
             }
         );
     }
@@ -497,7 +556,8 @@ void Bitmap::convert(Bitmap *target) const {
     }
 
     StructConverter conv(m_struct, target_struct, true);
-    bool rv = conv.convert_2d(m_size.x(), m_size.y(), uint8_data(), target->uint8_data());
+    bool rv = convert_2d_parallel(conv, m_size.x(), m_size.y(), uint8_data(),
+                                  target->uint8_data());
     if (!rv)
         Throw("Bitmap::convert(): conversion kernel indicated a failure!");
 }
@@ -648,8 +708,8 @@ std::vector<std::pair<std::string, ref<Bitmap>>> Bitmap::split() const {
                 link_field("A", a);
 
             StructConverter conv(m_struct, target_struct, true);
-            bool rv = conv.convert_2d(m_size.x(), m_size.y(),
-                                      uint8_data(), target->uint8_data());
+            bool rv = convert_2d_parallel(conv, m_size.x(), m_size.y(),
+                                          uint8_data(), target->uint8_data());
             if (!rv)
                 Throw("Bitmap::split(): conversion kernel indicated a failure!");
             result.push_back({ prefix, target });
@@ -668,8 +728,8 @@ std::vector<std::pair<std::string, ref<Bitmap>>> Bitmap::split() const {
         ref<Struct> target_struct = new Struct(*target->struct_());
         target_struct->field("Y").name = it->second.second->name;
         StructConverter conv(m_struct, target_struct, true);
-        bool rv = conv.convert_2d(m_size.x(), m_size.y(),
-                                  uint8_data(), target->uint8_data());
+        bool rv = convert_2d_parallel(conv, m_size.x(), m_size.y(),
+                                      uint8_data(), target->uint8_data());
         if (!rv)
             Throw("Bitmap::split(): conversion kernel indicated a failure!");
         result.push_back({ it->first + "." + it->second.first, target });
@@ -806,6 +866,11 @@ void Bitmap::write(Stream *stream, FileFormat format, int quality) const {
     }
 }
 
+/// Paths of the asynchronous writes that are in progress
+static std::vector<fs::path> async_writes;
+static std::mutex async_writes_mutex;
+static std::condition_variable async_writes_cv;
+
 void Bitmap::write_async(const fs::path &path_, FileFormat format_, int quality_) const {
     class WriteTask : public tbb::task {
         ref<const Bitmap> bitmap;
@@ -818,16 +883,40 @@ void Bitmap::write_async(const fs::path &path_, FileFormat format_, int quality_
             : bitmap(bitmap), path(path), format(format), quality(quality) { }
 
         tbb::task* execute() override {
-            bitmap->write(path, format, quality);
+            try {
+                bitmap->write(path, format, quality);
+            } catch (const std::exception &e) {
+                Log(Warn, "Bitmap::write_async(): could not write \"%s\": %s",
+                    path.string(), e.what());
+            }
+
+            std::lock_guard<std::mutex> guard(async_writes_mutex);
+            async_writes.erase(std::find(async_writes.begin(), async_writes.end(), path));
+            async_writes_cv.notify_all();
             return nullptr;
         }
     };
 
+    {
+        // Serialize the writes to the same file
+        std::unique_lock<std::mutex> lock(async_writes_mutex);
+        async_writes_cv.wait(lock, [&]() {
+            return std::find(async_writes.begin(), async_writes.end(), path_) ==
+                   async_writes.end();
+        });
+        async_writes.push_back(path_);
+    }
+
     WriteTask *t = new (tbb::task::allocate_root())
         WriteTask(this, path_, format_, quality_);
     tbb::task::enqueue(*t);
 }
 
+void Bitmap::wait_async_writes() {
+    std::unique_lock<std::mutex> lock(async_writes_mutex);
+    async_writes_cv.wait(lock, []() { return async_writes.empty(); });
+}
+
 bool Bitmap::operator==(const Bitmap &bitmap) const {
     if (m_pixel_format != bitmap.m_pixel_format ||
         m_component_format != bitmap.m_component_format ||
@@ -916,15 +1005,40 @@ private:
     ref<Stream> m_stream;
 };
 
+/// Use as many OpenEXR (de)compression threads as the rest of the renderer
+static void openexr_set_thread_count() {
+    static std::mutex mutex;
+    std::lock_guard<std::mutex> guard(mutex);
+    int thread_count = (int) std::max(__global_thread_count, (size_t) 1);
+    if (Imf::globalThreadCount() != thread_count)
+        Imf::setGlobalThreadCount(thread_count);
+}
+
 void Bitmap::read_openexr(Stream *stream) {
-    if (Imf::globalThreadCount() == 0)
-        Imf::setGlobalThreadCount(std::min(8, util::core_count()));
+    openexr_set_thread_count();
 
     EXRIStream istr(stream);
-    Imf::InputFile file(istr);
-
-    const Imf::Header &header = file.header();
-    const Imf::ChannelList &channels = header.channels();
+    Imf::MultiPartInputFile file(istr);
+
+    /* Merge the channels of all parts, whose metadata and data windows
+       are taken from the first one */
+    const Imf::Header &header = file.header(0);
+    Imf::ChannelList channels;
+    std::unordered_map<std::string, int> channel_part;
+    for (int i = 0; i < file.parts(); ++i) {
+        const Imf::Header &part_header = file.header(i);
+        if (part_header.hasType() && Imf::isDeepData(part_header.type())) {
+            Log(Warn, "read_openexr(): skipping the deep data part %i!", i);
+            continue;
+        }
+        const Imf::ChannelList &part_channels = part_header.channels();
+        for (auto it = part_channels.begin(); it != part_channels.end(); ++it) {
+            if (channel_part.find(it.name()) != channel_part.end())
+                continue;
+            channels.insert(it.name(), it.channel());
+            channel_part[it.name()] = i;
+        }
+    }
 
     if (channels.begin() == channels.end())
         Throw("read_openexr(): Image does not contain any channels!");
@@ -1068,8 +1182,8 @@ void Bitmap::read_openexr(Stream *stream) {
 
     // Check if there is a chromaticity header entry
     Imf::Chromaticities file_chroma;
-    if (Imf::hasChromaticities(file.header()))
-        file_chroma = Imf::chromaticities(file.header());
+    if (Imf::hasChromaticities(header))
+        file_chroma = Imf::chromaticities(header);
 
     auto chroma_eq = [](const Imf::Chromaticities &a,
                         const Imf::Chromaticities &b) {
@@ -1086,7 +1200,7 @@ void Bitmap::read_openexr(Stream *stream) {
         return name;
     };
 
-    Imath::Box2i data_window = file.header().dataWindow();
+    Imath::Box2i data_window = header.dataWindow();
     m_size = Vector2u(data_window.max.x - data_window.min.x + 1,
                       data_window.max.y - data_window.min.y + 1);
 
@@ -1095,6 +1209,9 @@ void Bitmap::read_openexr(Stream *stream) {
            row_stride = pixel_stride * m_size.x(),
            pixel_count = this->pixel_count();
 
+    if (m_header_only)
+        return;
+
     // Finally, allocate memory for it
     m_data = std::unique_ptr<uint8_t[]>(new uint8_t[row_stride * m_size.y()]);
     m_owns_data = true;
@@ -1105,8 +1222,8 @@ void Bitmap::read_openexr(Stream *stream) {
     uint8_t *ptr = m_data.get() -
         (data_window.min.x + data_window.min.y * m_size.x()) * pixel_stride;
 
-    // Tell OpenEXR where the image data should be put
-    Imf::FrameBuffer framebuffer;
+    // Tell OpenEXR where the image data should be put (one frame buffer per part)
+    std::vector<Imf::FrameBuffer> framebuffers(file.parts());
     for (auto const &field: *m_struct) {
         const Imf::Channel &channel = channels[field.name];
         Vector2i sampling(channel.xSampling, channel.ySampling);
@@ -1133,7 +1250,7 @@ void Bitmap::read_openexr(Stream *stream) {
             resample_buffers.emplace_back(field.name, std::move(bitmap));
         }
 
-        framebuffer.insert(field.name, slice);
+        framebuffers[channel_part[field.name]].insert(field.name, slice);
     }
 
     auto fs = dynamic_cast<FileStream *>(stream);
@@ -1141,8 +1258,15 @@ void Bitmap::read_openexr(Stream *stream) {
         fs ? fs->path().string() : "<stream>", m_size.x(), m_size.y(),
         m_pixel_format, m_component_format);
 
-    file.setFrameBuffer(framebuffer);
-    file.readPixels(data_window.min.y, data_window.max.y);
+    for (int i = 0; i < file.parts(); ++i) {
+        if (framebuffers[i].begin() == framebuffers[i].end())
+            continue;
+        Imf::InputPart part(file, i);
+        if (part.header().dataWindow() != data_window)
+            Throw("read_openexr(): the parts of the image have different data windows!");
+        part.setFrameBuffer(framebuffers[i]);
+        part.readPixels(data_window.min.y, data_window.max.y);
+    }
 
     for (auto &buf: resample_buffers) {
         Log(Debug, "Upsampling layer \"%s\" from %ix%i to %ix%i pixels",
@@ -1278,21 +1402,18 @@ void Bitmap::read_openexr(Stream *stream) {
     }
 }
 
-void Bitmap::write_openexr(Stream *stream, int quality) const {
-    if (Imf::globalThreadCount() == 0)
-        Imf::setGlobalThreadCount(std::min(8, util::core_count()));
-
-    PixelFormat pixel_format = m_pixel_format;
-
-    Properties metadata(m_metadata);
+/// Create an OpenEXR header with the metadata of \c bitmap for an image of the given size
+static Imf::Header openexr_header(const Bitmap *bitmap, const Bitmap::Vector2u &size,
+                                  int quality) {
+    Properties metadata(bitmap->metadata());
     if (!metadata.has_property("generatedBy"))
         metadata.set_string("generatedBy", "Mitsuba version " MTS_VERSION);
 
     std::vector<std::string> keys = metadata.property_names();
 
     Imf::Header header(
-        (int) m_size.x(),  // width
-        (int) m_size.y(),  // height,
+        (int) size.x(),    // width
+        (int) size.y(),    // height,
         1.f,               // pixelAspectRatio
         Imath::V2f(0, 0),  // screenWindowCenter,
         1.f,               // screenWindowWidth
@@ -1319,19 +1440,19 @@ void Bitmap::write_openexr(Stream *stream, int quality) const {
                 header.insert(it->c_str(), Imf::IntAttribute(metadata.int_(*it)));
                 break;
             case Type::Float:
-                if constexpr (is_double_v<Float>)
+                if constexpr (is_double_v<Bitmap::Float>)
                     header.insert(it->c_str(), Imf::DoubleAttribute((double)metadata.float_(*it)));
                 else
                     header.insert(it->c_str(), Imf::FloatAttribute(metadata.float_(*it)));
                 break;
             case Type::Array3f: {
-                    Vector3f val = metadata.array3f(*it);
+                    Bitmap::Vector3f val = metadata.array3f(*it);
                     header.insert(it->c_str(), Imf::V3fAttribute(
                         Imath::V3f((float) val.x(), (float) val.y(), (float) val.z())));
                 }
                 break;
             case Type::Transform: {
-                    Matrix4f val = metadata.transform(*it).matrix;
+                    Bitmap::Matrix4f val = metadata.transform(*it).matrix;
                     header.insert(it->c_str(), Imf::M44fAttribute(Imath::M44f(
                         (float) val(0, 0), (float) val(0, 1),
                         (float) val(0, 2), (float) val(0, 3),
@@ -1349,7 +1470,9 @@ void Bitmap::write_openexr(Stream *stream, int quality) const {
         }
     }
 
-    if (pixel_format == PixelFormat::XYZ || pixel_format == PixelFormat::XYZA) {
+    Bitmap::PixelFormat pixel_format = bitmap->pixel_format();
+    if (pixel_format == Bitmap::PixelFormat::XYZ ||
+        pixel_format == Bitmap::PixelFormat::XYZA) {
         Imf::addChromaticities(header, Imf::Chromaticities(
             Imath::V2f(1.f, 0.f),
             Imath::V2f(0.f, 1.f),
@@ -1357,30 +1480,188 @@ void Bitmap::write_openexr(Stream *stream, int quality) const {
             Imath::V2f(1.f / 3.f, 1.f / 3.f)));
     }
 
+    return header;
+}
+
+/// Return the OpenEXR pixel type corresponding to a component format
+static Imf::PixelType openexr_pixel_type(Struct::Type type) {
+    switch (type) {
+        case Struct::Type::Float32: return Imf::FLOAT;
+        case Struct::Type::Float16: return Imf::HALF;
+        case Struct::Type::UInt32: return Imf::UINT;
+        default: Throw("Unexpected field type!");
+    }
+}
+
+void Bitmap::write_openexr(Stream *stream, int quality) const {
+    openexr_set_thread_count();
+
+    Imf::Header header = openexr_header(this, m_size, quality);
+
+    if (m_exr_tile_size > 0)
+        header.setTileDescription(Imf::TileDescription(m_exr_tile_size, m_exr_tile_size,
+                                                       Imf::ONE_LEVEL));
+
+    /* Multi-part files store each layer (the part of the channel names before
+       the last '.') in a separate part, so that readers can load them separately */
+    std::vector<std::string> part_names;
+    std::vector<size_t> field_part;
+    for (auto field : *m_struct) {
+        std::string name;
+        auto it = field.name.rfind(".");
+        if (m_exr_multi_part && it != std::string::npos)
+            name = field.name.substr(0, it);
+        auto it2 = std::find(part_names.begin(), part_names.end(), name);
+        field_part.push_back((size_t) (it2 - part_names.begin()));
+        if (it2 == part_names.end())
+            part_names.push_back(name);
+    }
+
     size_t pixel_stride = m_struct->size(),
            row_stride = pixel_stride * m_size.x();
 
-    Imf::ChannelList &channels = header.channels();
-    Imf::FrameBuffer framebuffer;
+    std::vector<Imf::Header> headers(part_names.size(), header);
+    std::vector<Imf::FrameBuffer> framebuffers(part_names.size());
     const uint8_t *ptr = uint8_data();
-    for (auto field : *m_struct) {
-        Imf::PixelType comp_type;
-        switch (field.type) {
-            case Struct::Type::Float32: comp_type = Imf::FLOAT; break;
-            case Struct::Type::Float16: comp_type = Imf::HALF; break;
-            case Struct::Type::UInt32: comp_type = Imf::UINT; break;
-            default: Throw("Unexpected field type!");
-        }
+    for (size_t i = 0; i < m_struct->field_count(); ++i) {
+        const Struct::Field &field = (*m_struct)[i];
+        Imf::PixelType comp_type = openexr_pixel_type(field.type);
 
         Imf::Slice slice(comp_type, (char *) (ptr + field.offset), pixel_stride, row_stride);
-        channels.insert(field.name, Imf::Channel(comp_type));
-        framebuffer.insert(field.name, slice);
+        headers[field_part[i]].channels().insert(field.name, Imf::Channel(comp_type));
+        framebuffers[field_part[i]].insert(field.name, slice);
     }
 
     EXROStream ostr(stream);
-    Imf::OutputFile file(ostr, header);
-    file.setFrameBuffer(framebuffer);
-    file.writePixels((int) m_size.y());
+    if (!m_exr_multi_part) {
+        /* Both variants compress and write the chunks (scanline blocks or
+           tiles) on the threads of the OpenEXR thread pool */
+        if (m_exr_tile_size > 0) {
+            Imf::TiledOutputFile file(ostr, headers[0]);
+            file.setFrameBuffer(framebuffers[0]);
+            file.writeTiles(0, file.numXTiles() - 1, 0, file.numYTiles() - 1);
+        } else {
+            Imf::OutputFile file(ostr, headers[0]);
+            file.setFrameBuffer(framebuffers[0]);
+            file.writePixels((int) m_size.y());
+        }
+        return;
+    }
+
+    for (size_t i = 0; i < headers.size(); ++i) {
+        headers[i].setName(part_names[i].empty() ? "default" : part_names[i]);
+        headers[i].setType(m_exr_tile_size > 0 ? Imf::TILEDIMAGE : Imf::SCANLINEIMAGE);
+    }
+
+    Imf::MultiPartOutputFile file(ostr, headers.data(), (int) headers.size());
+    for (size_t i = 0; i < headers.size(); ++i) {
+        if (m_exr_tile_size > 0) {
+            Imf::TiledOutputPart part(file, (int) i);
+            part.setFrameBuffer(framebuffers[i]);
+            part.writeTiles(0, part.numXTiles() - 1, 0, part.numYTiles() - 1);
+        } else {
+            Imf::OutputPart part(file, (int) i);
+            part.setFrameBuffer(framebuffers[i]);
+            part.writePixels((int) m_size.y());
+        }
+    }
+}
+
+struct TiledOpenEXRWriter::TiledOpenEXRWriterPrivate {
+    fs::path filename;
+    Vector2u size;
+    uint32_t tile_size;
+    uint32_t rows_written = 0;
+    ref<const Struct> struct_;
+    ref<Stream> stream;
+    std::unique_ptr<EXROStream> ostream;
+    std::unique_ptr<Imf::TiledOutputFile> file;
+};
+
+TiledOpenEXRWriter::TiledOpenEXRWriter(const fs::path &filename, const Bitmap *prototype,
+                                       const Vector2u &size, uint32_t tile_size, int quality)
+    : d(new TiledOpenEXRWriterPrivate()) {
+    if (tile_size == 0)
+        Throw("TiledOpenEXRWriter: the tile size must be > 0!");
+    for (const Struct::Field &field : *prototype->struct_())
+        openexr_pixel_type(field.type); // throws for unsupported component formats
+
+    openexr_set_thread_count();
+
+    d->filename = filename;
+    d->size = size;
+    d->tile_size = tile_size;
+    d->struct_ = prototype->struct_();
+
+    Imf::Header header = openexr_header(prototype, size, quality);
+    header.setTileDescription(Imf::TileDescription(tile_size, tile_size, Imf::ONE_LEVEL));
+    for (const Struct::Field &field : *d->struct_)
+        header.channels().insert(field.name, Imf::Channel(openexr_pixel_type(field.type)));
+
+    d->stream = new FileStream(filename, FileStream::ETruncReadWrite);
+    d->ostream.reset(new EXROStream(d->stream));
+    d->file.reset(new Imf::TiledOutputFile(*d->ostream, header));
+}
+
+TiledOpenEXRWriter::~TiledOpenEXRWriter() {
+    close();
+}
+
+void TiledOpenEXRWriter::write(const Bitmap *strip) {
+    if (!d->file)
+        Throw("TiledOpenEXRWriter::write(): the file \"%s\" was already closed!",
+              d->filename.string());
+
+    uint32_t rows = strip->height();
+    if (*strip->struct_() != *d->struct_ || strip->width() != d->size.x())
+        Throw("TiledOpenEXRWriter::write(): the strip must have the layout of the "
+              "prototype bitmap and a width of %i pixels!", d->size.x());
+    if (rows == 0 || rows > d->size.y() - d->rows_written ||
+        (rows % d->tile_size != 0 && d->rows_written + rows != d->size.y()))
+        Throw("TiledOpenEXRWriter::write(): invalid strip height %i (%i of %i rows "
+              "written, tile size %i)!", rows, d->rows_written, d->size.y(), d->tile_size);
+
+    /* The slices are addressed with absolute pixel coordinates, hence the
+       shift of their base pointer by the index of the first row */
+    size_t pixel_stride = d->struct_->size(),
+           row_stride = pixel_stride * d->size.x();
+    const uint8_t *ptr = strip->uint8_data() - d->rows_written * row_stride;
+
+    Imf::FrameBuffer framebuffer;
+    for (const Struct::Field &field : *d->struct_)
+        framebuffer.insert(field.name, Imf::Slice(openexr_pixel_type(field.type),
+                                                  (char *) (ptr + field.offset),
+                                                  pixel_stride, row_stride));
+
+    uint32_t first = d->rows_written / d->tile_size,
+             last = (d->rows_written + rows - 1) / d->tile_size;
+    d->file->setFrameBuffer(framebuffer);
+    d->file->writeTiles(0, d->file->numXTiles() - 1, (int) first, (int) last);
+    d->rows_written += rows;
+}
+
+void TiledOpenEXRWriter::close() {
+    // The destructor of the file writes the table of tile offsets
+    d->file.reset();
+    d->ostream.reset();
+    d->stream = nullptr;
+}
+
+uint32_t TiledOpenEXRWriter::rows_written() const { return d->rows_written; }
+
+const TiledOpenEXRWriter::Vector2u &TiledOpenEXRWriter::size() const { return d->size; }
+
+uint32_t TiledOpenEXRWriter::tile_size() const { return d->tile_size; }
+
+std::string TiledOpenEXRWriter::to_string() const {
+    std::ostringstream oss;
+    oss << "TiledOpenEXRWriter[" << std::endl
+        << "  filename = \"" << d->filename.string() << "\"," << std::endl
+        << "  size = " << d->size << "," << std::endl
+        << "  tile_size = " << d->tile_size << "," << std::endl
+        << "  rows_written = " << d->rows_written << std::endl
+        << "]";
+    return oss.str();
 }
 
 // -----------------------------------------------------------------------------
@@ -1495,7 +1776,10 @@ void Bitmap::read_jpeg(Stream *stream) {
     jbuf.stream = stream;
 
     jpeg_read_header(&cinfo, TRUE);
-    jpeg_start_decompress(&cinfo);
+    if (m_header_only)
+        jpeg_calc_output_dimensions(&cinfo);
+    else
+        jpeg_start_decompress(&cinfo);
 
     m_size = Vector2u(cinfo.output_width, cinfo.output_height);
     m_component_format = Struct::Type::UInt8;
@@ -1510,6 +1794,11 @@ void Bitmap::read_jpeg(Stream *stream) {
 
     rebuild_struct();
 
+    if (m_header_only) {
+        jpeg_destroy_decompress(&cinfo);
+        return;
+    }
+
     auto fs = dynamic_cast<FileStream *>(stream);
     Log(Debug, "Loading JPEG file \"%s\" (%ix%i, %s, %s) ..",
         fs ? fs->path().string() : "<stream>", m_size.x(), m_size.y(),
@@ -1702,6 +1991,11 @@ void Bitmap::read_png(Stream *stream) {
     for (int i = 0; i < text_idx; ++i, text_ptr++)
         m_metadata.set_string(text_ptr->key, text_ptr->text);
 
+    if (m_header_only) {
+        png_destroy_read_struct(&png_ptr, &info_ptr, nullptr);
+        return;
+    }
+
     auto fs = dynamic_cast<FileStream *>(stream);
     Log(Debug, "Loading PNG file \"%s\" (%ix%i, %s, %s) ..",
         fs ? fs->path().string() : "<stream>", m_size.x(), m_size.y(),
@@ -1866,6 +2160,9 @@ void Bitmap::read_ppm(Stream *stream) {
         fs ? fs->path().string() : "<stream>", m_size.x(), m_size.y(),
         m_pixel_format, m_component_format);
 
+    if (m_header_only)
+        return;
+
     size_t size = buffer_size();
     m_data = std::unique_ptr<uint8_t[]>(new uint8_t[size]);
     m_owns_data = true;
@@ -2007,6 +2304,9 @@ void Bitmap::read_rgbe(Stream *stream) {
     m_premultiplied_alpha = false;
 
     rebuild_struct();
+    if (m_header_only)
+        return;
+
     m_data = std::unique_ptr<uint8_t[]>(new uint8_t[buffer_size()]);
     m_owns_data = true;
 
@@ -2171,6 +2471,8 @@ void Bitmap::read_pfm(Stream *stream) {
     }
 
     rebuild_struct();
+    if (m_header_only)
+        return;
 
     size_t size_in_bytes = buffer_size();
     m_data = std::unique_ptr<uint8_t[]>(new uint8_t[size_in_bytes]);
@@ -2303,6 +2605,10 @@ void Bitmap::read_bmp(Stream *stream) {
         }
 
         rebuild_struct();
+        if (m_header_only) {
+            stream->set_byte_order(byte_order);
+            return;
+        }
 
         size_t size = buffer_size();
         m_data = std::unique_ptr<uint8_t[]>(new uint8_t[size]);
@@ -2387,6 +2693,11 @@ void Bitmap::read_tga(Stream *stream) {
             fs ? fs->path().string() : "<stream>", m_size.x(), m_size.y(),
             m_pixel_format, m_component_format);
 
+        if (m_header_only) {
+            stream->set_byte_order(byte_order);
+            return;
+        }
+
         size_t size = buffer_size(),
                row_size = size / m_size.y();
 
@@ -2484,9 +2795,11 @@ void Bitmap::static_initialization() {
 }
 
 void Bitmap::static_shutdown() {
+    wait_async_writes();
     Imf::setGlobalThreadCount(0);
 }
 
 MTS_IMPLEMENT_CLASS(Bitmap, Object)
+MTS_IMPLEMENT_CLASS(TiledOpenEXRWriter, Object)
 
 NAMESPACE_END(mitsuba)
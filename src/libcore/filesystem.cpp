@@ -133,6 +133,27 @@ size_t file_size(const path& p) {
     return (size_t) sb.st_size;
 }
 
+uint64_t last_write_time(const path& p) {
+#if defined(__WINDOWS__)
+    WIN32_FILE_ATTRIBUTE_DATA data;
+    if (!GetFileAttributesExW(p.native().c_str(), GetFileExInfoStandard, &data))
+        throw std::runtime_error("filesystem::last_write_time(): cannot stat file \"" + p.string() + "\"!");
+    return ((uint64_t) data.ftLastWriteTime.dwHighDateTime << 32) |
+           (uint64_t) data.ftLastWriteTime.dwLowDateTime;
+#else
+    struct stat sb;
+    if (stat(p.native().c_str(), &sb) != 0)
+        throw std::runtime_error("filesystem::last_write_time(): cannot stat file \"" + p.string() + "\"!");
+#  if defined(__LINUX__)
+    return (uint64_t) sb.st_mtim.tv_sec * 1000000000ull + (uint64_t) sb.st_mtim.tv_nsec;
+#  elif defined(__OSX__)
+    return (uint64_t) sb.st_mtimespec.tv_sec * 1000000000ull + (uint64_t) sb.st_mtimespec.tv_nsec;
+#  else
+    return (uint64_t) sb.st_mtime;
+#  endif
+#endif
+}
+
 bool equivalent(const path& p1, const path& p2) {
 #if defined(__WINDOWS__)
     struct _stati64 sb1, sb2;
@@ -8,21 +8,223 @@
 #include <vector>
 #include <iostream>
 #include <algorithm>
+#include <atomic>
+#include <condition_variable>
 #include <mutex>
+#include <unordered_map>
 
 NAMESPACE_BEGIN(mitsuba)
 
+/// Bounded lock-free queue of log messages, written by a single thread
+struct MessageQueue {
+    struct Message {
+        LogLevel level;
+        std::string text;
+    };
+
+    std::unique_ptr<Message[]> messages;
+    size_t capacity;
+    std::atomic<size_t> head { 0 }, tail { 0 };
+
+    MessageQueue(size_t capacity) : messages(new Message[capacity]), capacity(capacity) { }
+
+    /// Append a message (producer thread), returns \c false when the queue is full
+    bool push(LogLevel level, std::string &text) {
+        size_t t = tail.load(std::memory_order_relaxed);
+        if (t - head.load(std::memory_order_acquire) == capacity)
+            return false;
+        Message &message = messages[t % capacity];
+        message.level = level;
+        message.text.swap(text);
+        tail.store(t + 1, std::memory_order_release);
+        return true;
+    }
+
+    /// Remove a message (consumer thread), returns \c false when the queue is empty
+    bool pop(Message &result) {
+        size_t h = head.load(std::memory_order_relaxed);
+        if (h == tail.load(std::memory_order_acquire))
+            return false;
+        Message &message = messages[h % capacity];
+        result.level = message.level;
+        result.text.swap(message.text);
+        head.store(h + 1, std::memory_order_release);
+        return true;
+    }
+};
+
+/// Source of the identifiers that associate the per-thread queues with loggers
+static std::atomic<uint64_t> logger_id_counter { 0 };
+
+/// Queue of the current thread for a logger, valid while the epoch of the logger matches
+struct LocalQueue {
+    uint64_t epoch;
+    MessageQueue *queue;
+};
+
+/// Queues of the current thread, indexed by the identifier of their logger
+static thread_local std::unordered_map<uint64_t, LocalQueue> local_queues;
+
 struct Logger::LoggerPrivate {
     std::mutex mutex;
     LogLevel error_level = Error;
     std::vector<ref<Appender>> appenders;
     ref<Formatter> formatter;
+
+    // Asynchronous mode
+    const uint64_t id = logger_id_counter++;
+    std::atomic<bool> async { false };
+    uint64_t epoch = 0;
+    std::atomic<size_t> writers { 0 };
+    std::mutex queue_mutex;
+    std::vector<std::unique_ptr<MessageQueue>> queues;
+    size_t queue_size = 0;
+    std::thread consumer;
+    std::condition_variable cv;
+    bool stop = false;
+    size_t flush_requests = 0, flushes_done = 0;
+    std::atomic<size_t> dropped { 0 };
+
+    /**
+     * \brief Return the queue of the current thread in asynchronous mode, or
+     * \c nullptr
+     *
+     * The caller must be registered in \c writers until it has pushed its
+     * message, which lets \ref Logger::set_async() wait for it.
+     */
+    MessageQueue *queue() {
+        if (!async.load())
+            return nullptr;
+
+        auto it = local_queues.find(id);
+        if (likely(it != local_queues.end() && it->second.epoch == epoch))
+            return it->second.queue;
+
+        std::lock_guard<std::mutex> guard(queue_mutex);
+        queues.emplace_back(new MessageQueue(queue_size));
+        local_queues[id] = { epoch, queues.back().get() };
+        return queues.back().get();
+    }
+
+    /// Pass the queued messages to the appenders, returns the number of messages
+    size_t drain() {
+        std::vector<MessageQueue *> sources;
+        {
+            std::lock_guard<std::mutex> guard(queue_mutex);
+            for (auto &q : queues)
+                sources.push_back(q.get());
+        }
+
+        size_t count = 0;
+        MessageQueue::Message message;
+        for (MessageQueue *q : sources) {
+            while (q->pop(message)) {
+                std::lock_guard<std::mutex> guard(mutex);
+                for (auto entry : appenders)
+                    entry->append(message.level, message.text);
+                count++;
+            }
+        }
+        return count;
+    }
+
+    /// Body of the consumer thread
+    void run() {
+        size_t reported = 0;
+        std::unique_lock<std::mutex> lock(queue_mutex);
+        while (true) {
+            size_t requests = flush_requests;
+            bool done = stop;
+            lock.unlock();
+
+            size_t count = drain();
+
+            // Report the messages that were dropped since the last report
+            size_t dropped_now = dropped.load(std::memory_order_relaxed);
+            if (dropped_now != reported) {
+                std::string text = tfm::format(
+                    "Logger: the message queues were full, dropped %i message%s.",
+                    dropped_now - reported, dropped_now - reported == 1 ? "" : "s");
+                std::lock_guard<std::mutex> guard(mutex);
+                for (auto entry : appenders)
+                    entry->append(Warn, text);
+                reported = dropped_now;
+            }
+
+            lock.lock();
+            if (count == 0) {
+                flushes_done = requests;
+                cv.notify_all();
+                if (done)
+                    break;
+                cv.wait_for(lock, std::chrono::milliseconds(10),
+                            [&]() { return stop || flush_requests != requests; });
+            }
+        }
+    }
 };
 
 Logger::Logger(LogLevel log_level)
     : m_log_level(log_level), d(new LoggerPrivate()) { }
 
-Logger::~Logger() { }
+Logger::~Logger() {
+    set_async(false);
+}
+
+void Logger::set_async(bool value, size_t queue_size) {
+    if (value == is_async())
+        return;
+
+    if (value) {
+        if (queue_size == 0)
+            Throw("Logger::set_async(): the queue size must be > 0!");
+        /* The queues of the threads are reused when the mode is enabled
+           again, unless their capacity changes */
+        if (queue_size != d->queue_size) {
+            std::lock_guard<std::mutex> guard(d->queue_mutex);
+            d->queues.clear();
+            d->queue_size = queue_size;
+            d->epoch++;
+        }
+        d->stop = false;
+        d->consumer = std::thread([this]() { d->run(); });
+        d->async = true;
+    } else {
+        // New messages are dispatched synchronously, then drain the queues
+        d->async = false;
+        {
+            std::lock_guard<std::mutex> guard(d->queue_mutex);
+            d->stop = true;
+        }
+        d->cv.notify_all();
+        d->consumer.join();
+
+        /* Threads that obtained their queue before the mode changed may still
+           be pushing a message: keep draining until all of them are done */
+        while (d->writers.load() != 0) {
+            d->drain();
+            std::this_thread::yield();
+        }
+        d->drain();
+    }
+}
+
+bool Logger::is_async() const {
+    return d->async.load(std::memory_order_relaxed);
+}
+
+void Logger::flush() {
+    if (!is_async())
+        return;
+    std::unique_lock<std::mutex> lock(d->queue_mutex);
+    size_t request = ++d->flush_requests;
+    d->cv.notify_all();
+    d->cv.wait(lock, [&]() { return d->flushes_done >= request || d->stop; });
+}
+
+size_t Logger::dropped_count() const {
+    return d->dropped.load(std::memory_order_relaxed);
+}
 
 void Logger::set_formatter(Formatter *formatter) {
     std::lock_guard<std::mutex> guard(d->mutex);
@@ -69,6 +271,23 @@ void Logger::log(LogLevel level, const Class *class_, const char *file,
     std::string text = d->formatter->format(level, class_,
         Thread::thread(), file, line, msg);
 
+    d->writers.fetch_add(1);
+    MessageQueue *queue = d->queue();
+    if (queue) {
+        if (unlikely(!queue->push(level, text))) {
+            if (level < Warn) {
+                d->dropped.fetch_add(1, std::memory_order_relaxed);
+            } else {
+                // Warnings are never dropped
+                while (!queue->push(level, text))
+                    std::this_thread::yield();
+            }
+        }
+        d->writers.fetch_sub(1, std::memory_order_release);
+        return;
+    }
+    d->writers.fetch_sub(1, std::memory_order_release);
+
     std::lock_guard<std::mutex> guard(d->mutex);
     for (auto entry : d->appenders)
         entry->append(level, text);
@@ -93,6 +312,7 @@ void Logger::remove_appender(Appender *appender) {
 }
 
 std::string Logger::read_log() {
+    flush();
     std::lock_guard<std::mutex> guard(d->mutex);
     for (auto appender: d->appenders) {
         if (appender->class_()->derives_from(MTS_CLASS(StreamAppender))) {
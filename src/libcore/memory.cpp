@@ -0,0 +1,245 @@
+#include <mitsuba/core/memory.h>
+#include <mitsuba/core/logger.h>
+#include <mitsuba/core/math.h>
+#include <mitsuba/core/util.h>
+#include <array>
+#include <atomic>
+#include <mutex>
+#include <sstream>
+#include <unordered_map>
+#include <vector>
+
+#if defined(MTS_ENABLE_OPTIX)
+#  include <enoki/cuda.h>
+#endif
+
+NAMESPACE_BEGIN(mitsuba)
+
+struct CategoryCounter {
+    std::atomic<size_t> current { 0 };
+    std::atomic<size_t> peak { 0 };
+};
+
+static std::array<CategoryCounter, int(MemoryCategory::MemoryCategoryCount)> memory_counters;
+
+void MemoryAccounting::add(MemoryCategory category, size_t size) {
+    CategoryCounter &counter = memory_counters[int(category)];
+    size_t value = counter.current += size,
+           peak_value = counter.peak.load(std::memory_order_relaxed);
+    while (value > peak_value && !counter.peak.compare_exchange_weak(peak_value, value))
+        ;
+}
+
+void MemoryAccounting::remove(MemoryCategory category, size_t size) {
+    memory_counters[int(category)].current -= size;
+}
+
+size_t MemoryAccounting::current(MemoryCategory category) {
+    return memory_counters[int(category)].current;
+}
+
+size_t MemoryAccounting::peak(MemoryCategory category) {
+    return memory_counters[int(category)].peak;
+}
+
+void MemoryAccounting::reset_peak() {
+    for (CategoryCounter &counter : memory_counters)
+        counter.peak = counter.current.load();
+}
+
+std::string MemoryAccounting::report() {
+    std::ostringstream oss;
+    oss << "Memory usage:" << std::endl;
+    size_t total_current = 0, total_peak = 0;
+
+    auto print_row = [&](const std::string &name, size_t current, size_t peak) {
+        std::string current_str = util::mem_string(current);
+        oss << "   " << name << std::string(12 - name.length(), ' ')
+            << current_str << std::string(current_str.length() < 14 ? 14 - current_str.length() : 1, ' ')
+            << "(peak " << util::mem_string(peak) << ")" << std::endl;
+    };
+
+    for (int i = 0; i < int(MemoryCategory::MemoryCategoryCount); ++i) {
+        size_t current = memory_counters[i].current, peak = memory_counters[i].peak;
+        print_row(memory_category_id[i], current, peak);
+        total_current += current;
+        total_peak += peak;
+    }
+
+    // The peaks of the categories are not simultaneous, hence the sum is an upper bound
+    print_row("Total", total_current, total_peak);
+    return oss.str();
+}
+
+void MemoryAccounting::print_report(LogLevel level) {
+    std::string str = report();
+    if (!str.empty() && str.back() == '\n')
+        str.pop_back();
+    Log(level, "%s", str);
+}
+
+void MemoryRecord::set(size_t size) {
+    if (size > m_size)
+        MemoryAccounting::add(m_category, size - m_size);
+    else if (size < m_size)
+        MemoryAccounting::remove(m_category, m_size - size);
+    m_size = size;
+}
+
+struct DevicePoolState {
+    std::mutex mutex;
+    /// Released blocks, keyed by their size class
+    std::unordered_map<size_t, std::vector<void *>> free_blocks;
+    /// Size class of the blocks held by the callers
+    std::unordered_map<void *, size_t> used_blocks;
+    DeviceMemoryStats stats { 0, 0, 0, 1024ull * 1024 * 1024, 0, 0 };
+};
+
+static DevicePoolState device_pool;
+
+static void *device_malloc(size_t size) {
+#if defined(MTS_ENABLE_OPTIX)
+    return enoki::cuda_malloc(size);
+#else
+    Throw("DeviceMemoryPool::malloc(): Mitsuba was compiled without GPU support "
+          "(%zu bytes requested)!", size);
+#endif
+}
+
+static void device_free(void *ptr) {
+#if defined(MTS_ENABLE_OPTIX)
+    enoki::cuda_free(ptr);
+#else
+    (void) ptr;
+#endif
+}
+
+/// Remove cached blocks until at most 'target' bytes remain (the mutex must be held)
+static std::vector<void *> device_pool_evict(size_t target) {
+    std::vector<void *> evicted;
+    DeviceMemoryStats &stats = device_pool.stats;
+    for (auto it = device_pool.free_blocks.begin();
+         it != device_pool.free_blocks.end() && stats.cached > target;) {
+        std::vector<void *> &blocks = it->second;
+        while (!blocks.empty() && stats.cached > target) {
+            evicted.push_back(blocks.back());
+            blocks.pop_back();
+            stats.cached -= it->first;
+        }
+        it = blocks.empty() ? device_pool.free_blocks.erase(it) : std::next(it);
+    }
+    return evicted;
+}
+
+size_t DeviceMemoryPool::size_class(size_t size) {
+    if (size <= 256)
+        return 256;
+    size_t step = math::round_to_power_of_two(size) / 8;
+    return (size + step - 1) / step * step;
+}
+
+void *DeviceMemoryPool::malloc(size_t size) {
+    size_t bytes = size_class(size);
+    void *ptr = nullptr;
+
+    /* scope */ {
+        std::lock_guard<std::mutex> guard(device_pool.mutex);
+        auto it = device_pool.free_blocks.find(bytes);
+        if (it != device_pool.free_blocks.end() && !it->second.empty()) {
+            ptr = it->second.back();
+            it->second.pop_back();
+            device_pool.stats.cached -= bytes;
+            device_pool.stats.hits++;
+        } else {
+            device_pool.stats.misses++;
+        }
+    }
+
+    if (!ptr) {
+        try {
+            ptr = device_malloc(bytes);
+        } catch (const std::exception &) {
+            // Return the cached blocks to the device and try once more
+            trim();
+            ptr = device_malloc(bytes);
+        }
+    }
+
+    std::lock_guard<std::mutex> guard(device_pool.mutex);
+    DeviceMemoryStats &stats = device_pool.stats;
+    device_pool.used_blocks[ptr] = bytes;
+    stats.used += bytes;
+    stats.peak = std::max(stats.peak, stats.used + stats.cached);
+    return ptr;
+}
+
+void DeviceMemoryPool::free(void *ptr) {
+    if (!ptr)
+        return;
+
+    std::vector<void *> evicted;
+    /* scope */ {
+        std::lock_guard<std::mutex> guard(device_pool.mutex);
+        auto it = device_pool.used_blocks.find(ptr);
+        if (it == device_pool.used_blocks.end())
+            Throw("DeviceMemoryPool::free(): %p was not allocated by the pool!", ptr);
+        size_t bytes = it->second;
+        device_pool.used_blocks.erase(it);
+
+        DeviceMemoryStats &stats = device_pool.stats;
+        stats.used -= bytes;
+        if (bytes <= stats.limit) {
+            device_pool.free_blocks[bytes].push_back(ptr);
+            stats.cached += bytes;
+            evicted = device_pool_evict(stats.limit);
+        } else {
+            evicted.push_back(ptr);
+        }
+    }
+
+    for (void *block : evicted)
+        device_free(block);
+}
+
+void DeviceMemoryPool::set_limit(size_t limit) {
+    std::vector<void *> evicted;
+    /* scope */ {
+        std::lock_guard<std::mutex> guard(device_pool.mutex);
+        device_pool.stats.limit = limit;
+        evicted = device_pool_evict(limit);
+    }
+    for (void *block : evicted)
+        device_free(block);
+}
+
+size_t DeviceMemoryPool::limit() {
+    std::lock_guard<std::mutex> guard(device_pool.mutex);
+    return device_pool.stats.limit;
+}
+
+void DeviceMemoryPool::trim() {
+    std::vector<void *> evicted;
+    /* scope */ {
+        std::lock_guard<std::mutex> guard(device_pool.mutex);
+        evicted = device_pool_evict(0);
+    }
+    for (void *block : evicted)
+        device_free(block);
+#if defined(MTS_ENABLE_OPTIX)
+    enoki::cuda_malloc_trim();
+#endif
+}
+
+DeviceMemoryStats DeviceMemoryPool::stats() {
+    std::lock_guard<std::mutex> guard(device_pool.mutex);
+    return device_pool.stats;
+}
+
+void DeviceMemoryPool::reset_stats() {
+    std::lock_guard<std::mutex> guard(device_pool.mutex);
+    DeviceMemoryStats &stats = device_pool.stats;
+    stats.peak = stats.used + stats.cached;
+    stats.hits = stats.misses = 0;
+}
+
+NAMESPACE_END(mitsuba)
@@ -11,6 +11,17 @@
 
 NAMESPACE_BEGIN(mitsuba)
 
+/// Return the granularity of the virtual memory pages
+static size_t page_size() {
+    #if defined(__WINDOWS__)
+        SYSTEM_INFO info;
+        GetSystemInfo(&info);
+        return (size_t) info.dwPageSize;
+    #else
+        return (size_t) sysconf(_SC_PAGESIZE);
+    #endif
+}
+
 struct MemoryMappedFile::MemoryMappedFilePrivate {
     fs::path filename;
 #if defined(__WINDOWS__)
@@ -20,10 +31,43 @@ struct MemoryMappedFile::MemoryMappedFilePrivate {
     size_t size;
     void *data;
     bool can_write;
+    bool copy_on_write;
     bool temp;
+    bool populate;
+    bool anonymous;
 
     MemoryMappedFilePrivate(const fs::path &f = "", size_t s = 0)
-        : filename(f), size(s), data(nullptr), can_write(false), temp(false) { }
+        : filename(f), size(s), data(nullptr), can_write(false),
+          copy_on_write(false), temp(false), populate(false), anonymous(false) { }
+
+    /// Return the page-aligned subrange of the mapping that covers [offset, offset+count)
+    std::pair<uint8_t *, size_t> page_range(size_t offset, size_t count) const {
+        if (offset >= size)
+            return { nullptr, 0 };
+        count = std::min(count, size - offset);
+        size_t page = page_size(),
+               start = offset / page * page;
+        return { (uint8_t *) data + start, count + (offset - start) };
+    }
+
+    /// Pass an access hint about a range of the mapping to the OS
+    void prefetch(size_t offset, size_t count) const {
+        auto [ptr, length] = page_range(offset, count);
+        if (length == 0)
+            return;
+        #if defined(__LINUX__) || defined(__OSX__)
+            if (madvise(ptr, length, MADV_WILLNEED) != 0)
+                Log(Debug, "madvise(): unable to prefetch \"%s\": %s",
+                    filename.string(), strerror(errno));
+        #elif defined(__WINDOWS__) && _WIN32_WINNT >= 0x0602
+            WIN32_MEMORY_RANGE_ENTRY entry;
+            entry.VirtualAddress = ptr;
+            entry.NumberOfBytes = length;
+            if (!PrefetchVirtualMemory(GetCurrentProcess(), 1, &entry, 0))
+                Log(Debug, "PrefetchVirtualMemory(): unable to prefetch \"%s\": %s",
+                    filename.string(), util::last_error());
+        #endif
+    }
 
     void create() {
         #if defined(__LINUX__) || defined(__OSX__)
@@ -138,11 +182,19 @@ struct MemoryMappedFile::MemoryMappedFilePrivate {
         size = (size_t) fs::file_size(filename);
 
         #if defined(__LINUX__) || defined(__OSX__)
-            int fd = open(filename.string().c_str(), can_write ? O_RDWR : O_RDONLY);
+            int fd = open(filename.string().c_str(),
+                          (can_write && !copy_on_write) ? O_RDWR : O_RDONLY);
             if (fd == -1)
                 Throw("Could not open \"%s\"!", filename.string());
 
-            data = mmap(nullptr, size, PROT_READ | (can_write ? PROT_WRITE : 0), MAP_SHARED, fd, 0);
+            int flags = copy_on_write ? MAP_PRIVATE : MAP_SHARED;
+            #if defined(MAP_POPULATE)
+                if (populate)
+                    flags |= MAP_POPULATE;
+            #endif
+
+            data = mmap(nullptr, size, PROT_READ | (can_write ? PROT_WRITE : 0),
+                        flags, fd, 0);
             if (data == MAP_FAILED) {
                 data = nullptr;
                 Throw("Could not map \"%s\" to memory!", filename.string());
@@ -150,8 +202,14 @@ struct MemoryMappedFile::MemoryMappedFilePrivate {
 
             if (close(fd) != 0)
                 Throw("close(): unable to close file!");
+
+            #if !defined(MAP_POPULATE)
+                if (populate)
+                    prefetch(0, size);
+            #endif
         #elif defined(__WINDOWS__)
-            file = CreateFileW(filename.native().c_str(), GENERIC_READ | (can_write ? GENERIC_WRITE : 0),
+            bool write_file = can_write && !copy_on_write;
+            file = CreateFileW(filename.native().c_str(), GENERIC_READ | (write_file ? GENERIC_WRITE : 0),
                 FILE_SHARE_WRITE|FILE_SHARE_READ, nullptr, OPEN_EXISTING,
                 FILE_ATTRIBUTE_NORMAL, nullptr);
 
@@ -159,21 +217,73 @@ struct MemoryMappedFile::MemoryMappedFilePrivate {
                 Throw("Could not open \"%s\": %s", filename.string(),
                     util::last_error());
 
-            file_mapping = CreateFileMappingW(file, nullptr, can_write ? PAGE_READWRITE : PAGE_READONLY, 0, 0, nullptr);
+            file_mapping = CreateFileMappingW(file, nullptr,
+                copy_on_write ? PAGE_WRITECOPY : (can_write ? PAGE_READWRITE : PAGE_READONLY),
+                0, 0, nullptr);
             if (file_mapping == nullptr)
                 Throw("CreateFileMapping: Could not map \"%s\" to memory: %s",
                     filename.string(), util::last_error());
 
-            data = (void *) MapViewOfFile(file_mapping, can_write ? FILE_MAP_WRITE : FILE_MAP_READ, 0, 0, 0);
+            data = (void *) MapViewOfFile(file_mapping,
+                copy_on_write ? FILE_MAP_COPY : (can_write ? FILE_MAP_WRITE : FILE_MAP_READ),
+                0, 0, 0);
             if (data == nullptr)
                 Throw("MapViewOfFile: Could not map \"%s\" to memory: %s",
                     filename.string(), util::last_error());
+
+            if (populate)
+                prefetch(0, size);
+        #endif
+    }
+
+    void create_anonymous(bool huge_pages) {
+        if (size == 0)
+            Throw("Cannot create an anonymous mapping of size zero!");
+        can_write = true;
+        anonymous = true;
+
+        #if defined(__LINUX__) || defined(__OSX__)
+            data = mmap(nullptr, size, PROT_READ | PROT_WRITE,
+                        MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+            if (data == MAP_FAILED) {
+                data = nullptr;
+                Throw("Could not create an anonymous mapping of %s: %s",
+                      util::mem_string(size), strerror(errno));
+            }
+
+            #if defined(MADV_HUGEPAGE)
+                // Fails when transparent huge pages are disabled, which is harmless
+                if (huge_pages && madvise(data, size, MADV_HUGEPAGE) != 0)
+                    Log(Debug, "madvise(): transparent huge pages are unavailable: %s",
+                        strerror(errno));
+            #else
+                (void) huge_pages;
+            #endif
+        #elif defined(__WINDOWS__)
+            (void) huge_pages;
+            data = VirtualAlloc(nullptr, size, MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE);
+            if (data == nullptr)
+                Throw("VirtualAlloc(): could not create an anonymous mapping of %s: %s",
+                      util::mem_string(size), util::last_error());
         #endif
     }
 
     void unmap() {
         Log(Trace, "Unmapping \"%s\" from memory", filename.string());
 
+        if (anonymous) {
+            #if defined(__LINUX__) || defined(__OSX__)
+                if (munmap(data, size) != 0)
+                    Throw("munmap(): unable to unmap memory: %s", strerror(errno));
+            #elif defined(__WINDOWS__)
+                if (!VirtualFree(data, 0, MEM_RELEASE))
+                    Throw("VirtualFree(): unable to release memory: %s", util::last_error());
+            #endif
+            data = nullptr;
+            size = 0;
+            return;
+        }
+
         #if defined(__LINUX__) || defined(__OSX__)
             if (temp) {
                 /* Temporary file that will be deleted in any case:
@@ -218,9 +328,10 @@ MemoryMappedFile::MemoryMappedFile(const fs::path &filename, size_t size)
     d->create();
 }
 
-MemoryMappedFile::MemoryMappedFile(const fs::path &filename, bool write)
+MemoryMappedFile::MemoryMappedFile(const fs::path &filename, bool write, bool populate)
     : d(new MemoryMappedFilePrivate(filename)) {
     d->can_write = write;
+    d->populate = populate;
     d->map();
     Log(Trace, "Mapped \"%s\" into memory (%s)..",
         filename.filename().string(), util::mem_string(d->size));
@@ -240,6 +351,10 @@ MemoryMappedFile::~MemoryMappedFile() {
 void MemoryMappedFile::resize(size_t size) {
     if (!d->data)
         Throw("Internal error in MemoryMappedFile::resize()!");
+    if (d->copy_on_write)
+        Throw("MemoryMappedFile::resize(): not supported for copy-on-write mappings!");
+    if (d->anonymous)
+        Throw("MemoryMappedFile::resize(): not supported for anonymous mappings!");
     bool temp = d->temp;
     d->temp = false;
     d->unmap();
@@ -269,6 +384,40 @@ const fs::path &MemoryMappedFile::filename() const {
     return d->filename;
 }
 
+void MemoryMappedFile::advise(Access access) {
+    if (!d->data)
+        return;
+    #if defined(__LINUX__) || defined(__OSX__)
+        int advice = MADV_NORMAL;
+        switch (access) {
+            case Access::Normal:     advice = MADV_NORMAL; break;
+            case Access::Sequential: advice = MADV_SEQUENTIAL; break;
+            case Access::Random:     advice = MADV_RANDOM; break;
+        }
+        if (madvise(d->data, d->size, advice) != 0)
+            Log(Debug, "madvise(): unable to set the access pattern of \"%s\": %s",
+                d->filename.string(), strerror(errno));
+    #else
+        (void) access;
+    #endif
+}
+
+void MemoryMappedFile::prefetch(size_t offset, size_t size) {
+    if (d->data)
+        d->prefetch(offset, size);
+}
+
+ref<MemoryMappedFile> MemoryMappedFile::map_copy_on_write(const fs::path &filename) {
+    ref<MemoryMappedFile> result = new MemoryMappedFile();
+    result->d->filename = filename;
+    result->d->can_write = true;
+    result->d->copy_on_write = true;
+    result->d->map();
+    Log(Trace, "Mapped \"%s\" into memory (copy-on-write, %s)..",
+        filename.filename().string(), util::mem_string(result->d->size));
+    return result;
+}
+
 ref<MemoryMappedFile> MemoryMappedFile::create_temporary(size_t size) {
     ref<MemoryMappedFile> result = new MemoryMappedFile();
     result->d->size = size;
@@ -276,6 +425,14 @@ ref<MemoryMappedFile> MemoryMappedFile::create_temporary(size_t size) {
     return result;
 }
 
+ref<MemoryMappedFile> MemoryMappedFile::create_anonymous(size_t size, bool huge_pages) {
+    ref<MemoryMappedFile> result = new MemoryMappedFile();
+    result->d->size = size;
+    result->d->create_anonymous(huge_pages);
+    Log(Trace, "Created an anonymous mapping (%s)..", util::mem_string(size));
+    return result;
+}
+
 std::string MemoryMappedFile::to_string() const {
     std::ostringstream oss;
     oss << "MemoryMappedFile[" << std::endl
@@ -4,6 +4,7 @@
 #include <mitsuba/core/properties.h>
 #include <mitsuba/core/filesystem.h>
 #include <mitsuba/core/fresolver.h>
+#include <mitsuba/core/profiler.h>
 #include <mutex>
 #include <unordered_map>
 
@@ -15,9 +16,10 @@
 
 NAMESPACE_BEGIN(mitsuba)
 
-class Plugin {
+/// Handle to a dynamically loaded shared library
+class SharedLibrary {
 public:
-    Plugin(const fs::path &path) : m_path(path) {
+    SharedLibrary(const fs::path &path) : m_path(path) {
         #if defined(__WINDOWS__)
             m_handle = LoadLibraryW(path.native().c_str());
             if (!m_handle)
@@ -29,18 +31,9 @@ public:
                 Throw("Error while loading plugin \"%s\": %s", path.string(),
                       dlerror());
         #endif
-
-        try {
-            using StringFunc = const char *(*)();
-            plugin_name  = ((StringFunc) symbol("plugin_name"))();
-            plugin_descr = ((StringFunc) symbol("plugin_descr"))();
-        } catch (...) {
-            this->~Plugin();
-            throw;
-        }
     }
 
-    ~Plugin() {
+    ~SharedLibrary() {
         #if defined(__WINDOWS__)
             FreeLibrary(m_handle);
         #else
@@ -48,7 +41,6 @@ public:
         #endif
     }
 
-private:
     void *symbol(const std::string &name) const {
         #if defined(__WINDOWS__)
             void *ptr = GetProcAddress(m_handle, name.c_str());
@@ -64,10 +56,6 @@ private:
         return ptr;
     }
 
-public:
-    const char *plugin_name  = nullptr;
-    const char *plugin_descr = nullptr;
-
 private:
     #if defined(__WINDOWS__)
         HMODULE m_handle;
@@ -77,9 +65,71 @@ private:
     fs::path m_path;
 };
 
+class Plugin {
+public:
+    /// Load a plugin from its own shared library
+    Plugin(const fs::path &path) : m_library(new SharedLibrary(path)) {
+        using StringFunc = const char *(*)();
+        plugin_name  = ((StringFunc) m_library->symbol("plugin_name"))();
+        plugin_descr = ((StringFunc) m_library->symbol("plugin_descr"))();
+    }
+
+    /// Plugin that is part of the library of all plugins (see \ref MTS_MONOLITHIC_PLUGINS)
+    Plugin(const char *plugin_name, const char *plugin_descr)
+        : plugin_name(plugin_name), plugin_descr(plugin_descr) { }
+
+public:
+    const char *plugin_name  = nullptr;
+    const char *plugin_descr = nullptr;
+
+private:
+    std::unique_ptr<SharedLibrary> m_library;
+};
+
+/// Plugins registered by the library of all plugins when it is loaded
+struct StaticPluginRegistry {
+    struct Entry {
+        const char *plugin_name;
+        const char *plugin_descr;
+    };
+
+    std::unordered_map<std::string, Entry> entries;
+    std::mutex mutex;
+
+    static StaticPluginRegistry &instance() {
+        static StaticPluginRegistry registry;
+        return registry;
+    }
+};
+
+NAMESPACE_BEGIN(detail)
+bool register_plugin(const char *name, const char *plugin_name, const char *plugin_descr) {
+    StaticPluginRegistry &registry = StaticPluginRegistry::instance();
+    std::lock_guard<std::mutex> guard(registry.mutex);
+    registry.entries[name] = { plugin_name, plugin_descr };
+    return true;
+}
+NAMESPACE_END(detail)
+
+/// Return the file name of a plugin library (relative to the file resolver)
+static fs::path plugin_filename(const std::string &name) {
+    fs::path filename = fs::path("plugins") / name;
+
+    #if defined(__WINDOWS__)
+        filename.replace_extension(".dll");
+    #elif defined(__OSX__)
+        filename.replace_extension(".dylib");
+    #else
+        filename.replace_extension(".so");
+    #endif
+
+    return filename;
+}
+
 struct PluginManager::PluginManagerPrivate {
     std::unordered_map<std::string, Plugin *> m_plugins;
     std::vector<std::string> m_python_plugins;
+    std::unique_ptr<SharedLibrary> m_monolithic_library;
     std::mutex m_mutex;
 
     Plugin *plugin(const std::string &name) {
@@ -90,22 +140,39 @@ struct PluginManager::PluginManagerPrivate {
         if (it != m_plugins.end())
             return it->second;
 
-        // Build the full plugin file name
-        fs::path filename = fs::path("plugins") / name;
+#if defined(MTS_MONOLITHIC_PLUGINS)
+        /* All plugins are part of a single library, which registers them
+           when it is loaded (a single dlopen() call in total) */
+        if (!m_monolithic_library) {
+            fs::path filename = plugin_filename("mitsuba-plugins");
+            fs::path resolved = Thread::thread()->file_resolver()->resolve(filename);
+            if (!fs::exists(resolved))
+                Throw("Plugin library \"%s\" not found!", filename.string());
+            Log(Info, "Loading plugin library \"%s\" ..", filename.string());
+            ScopedLoadEvent load_event(LoadEvent::PluginLoad, filename.string());
+            m_monolithic_library.reset(new SharedLibrary(resolved));
+            // New classes must be registered within the class hierarchy
+            Class::static_initialization();
+        }
 
-        #if defined(__WINDOWS__)
-            filename.replace_extension(".dll");
-        #elif defined(__OSX__)
-            filename.replace_extension(".dylib");
-        #else
-            filename.replace_extension(".so");
-        #endif
+        StaticPluginRegistry &registry = StaticPluginRegistry::instance();
+        std::lock_guard<std::mutex> registry_guard(registry.mutex);
+        auto it2 = registry.entries.find(name);
+        if (it2 != registry.entries.end()) {
+            Plugin *plugin = new Plugin(it2->second.plugin_name, it2->second.plugin_descr);
+            m_plugins[name] = plugin;
+            return plugin;
+        }
+#else
+        // Build the full plugin file name
+        fs::path filename = plugin_filename(name);
 
         const FileResolver *resolver = Thread::thread()->file_resolver();
         fs::path resolved = resolver->resolve(filename);
 
         if (fs::exists(resolved)) {
             Log(Info, "Loading plugin \"%s\" ..", filename.string());
+            ScopedLoadEvent load_event(LoadEvent::PluginLoad, name);
             Plugin *plugin = new Plugin(resolved);
             // New classes must be registered within the class hierarchy
             Class::static_initialization();
@@ -113,6 +180,7 @@ struct PluginManager::PluginManagerPrivate {
             m_plugins[name] = plugin;
             return plugin;
         }
+#endif
 
         // Plugin not found!
         Throw("Plugin \"%s\" not found!", name.c_str());
@@ -162,8 +230,11 @@ void PluginManager::register_python_plugin(const std::string &plugin_name) {
 
 ref<Object> PluginManager::create_object(const Properties &props, const Class *class_) {
     Assert(class_ != nullptr);
-    if (class_->name() == "Scene")
-       return class_->construct(props);
+    if (class_->name() == "Scene") {
+        ref<Object> scene = class_->construct(props);
+        Profiler::register_object(scene);
+        return scene;
+    }
 
     const Class *plugin_class = get_plugin_class(props.plugin_name(), class_->variant());
 
@@ -181,7 +252,8 @@ ref<Object> PluginManager::create_object(const Properties &props, const Class *c
               oc->name(), oc->variant());
     }
 
-   return object;
+    Profiler::register_object(object);
+    return object;
 }
 
 MTS_IMPLEMENT_CLASS(PluginManager, Object)
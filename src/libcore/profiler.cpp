@@ -1,6 +1,10 @@
 #include <mitsuba/core/profiler.h>
+#include <mitsuba/core/fstream.h>
 #include <mitsuba/core/logger.h>
+#include <mitsuba/core/thread.h>
 #include <mitsuba/core/util.h>
+#include <algorithm>
+#include <mutex>
 
 #if defined(MTS_ENABLE_PROFILER)
 #include <sys/time.h>
@@ -8,20 +12,330 @@
 #include <stdio.h>
 #include <tbb/tbb.h>
 #include <array>
+#include <atomic>
+#include <chrono>
 #include <map>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+#if defined(__LINUX__)
+#  include <linux/perf_event.h>
+#  include <sys/syscall.h>
+#  include <unistd.h>
+#endif
 
 NAMESPACE_BEGIN(mitsuba)
 
 static thread_local uint64_t profiler_flags_storage = 0;
 uint64_t *profiler_flags() { return &profiler_flags_storage; }
 
+static thread_local ProfilerTag profiler_tag_storage;
+ProfilerTag *profiler_tag() { return &profiler_tag_storage; }
+
+/// Hardware performance counters that are sampled along with the phases
+enum HardwareCounter : uint32_t {
+    HWCycles = 0,
+    HWInstructions,
+    HWCacheMisses,
+    HWBranchMisses,
+    HWCounterCount
+};
+
 struct ProfilerSample {
     uint64_t flags = (uint64_t) -1;
     uint64_t count = 0;
+    uint64_t hw[HWCounterCount] = { };
 };
 
 static std::array<ProfilerSample, MTS_PROFILE_HASH_SIZE> profiler_samples;
 
+static std::array<std::atomic<uint64_t>, int(ProfilerCounter::ProfilerCounterCount)>
+    profiler_counters { };
+
+void profiler_count(ProfilerCounter counter, uint64_t value) {
+    profiler_counters[int(counter)].fetch_add(value, std::memory_order_relaxed);
+}
+
+// =======================================================================
+//! @{ \name Timeline
+// =======================================================================
+
+bool profiler_timeline = false;
+
+/// Phase that was recorded in the timeline (times in nanoseconds)
+struct TimelineEvent {
+    uint64_t start;
+    uint64_t duration;
+    ProfilerPhase phase;
+};
+
+/// Ring buffer storing the most recent phases of one thread
+struct TimelineBuffer {
+    std::vector<TimelineEvent> events;
+    /// Total number of recorded phases (the buffer holds the last ones)
+    size_t count = 0;
+    /// Start time of the currently active phases
+    std::array<uint64_t, int(ProfilerPhase::ProfilerPhaseCount)> start { };
+    uint32_t thread_id;
+    std::string thread_name;
+};
+
+static std::mutex timeline_mutex;
+static std::vector<std::unique_ptr<TimelineBuffer>> timeline_buffers;
+static std::atomic<uint32_t> timeline_generation { 0 };
+static size_t timeline_capacity = 0;
+static std::chrono::steady_clock::time_point timeline_origin;
+
+static thread_local TimelineBuffer *timeline_local = nullptr;
+static thread_local uint32_t timeline_local_generation = (uint32_t) -1;
+
+static uint64_t timeline_time() {
+    return (uint64_t) std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - timeline_origin).count();
+}
+
+void profiler_timeline_record(ProfilerPhase phase, bool begin) {
+    uint32_t generation = timeline_generation.load(std::memory_order_acquire);
+    if (unlikely(timeline_local_generation != generation)) {
+        // First phase of this thread since the timeline was enabled
+        std::unique_ptr<TimelineBuffer> buffer(new TimelineBuffer());
+        buffer->events.resize(timeline_capacity);
+        buffer->thread_id = Thread::thread_id();
+        Thread *thread = Thread::thread();
+        buffer->thread_name = thread ? thread->name()
+                                     : tfm::format("thread %i", buffer->thread_id);
+
+        std::lock_guard<std::mutex> guard(timeline_mutex);
+        timeline_local = buffer.get();
+        timeline_local_generation = generation;
+        timeline_buffers.push_back(std::move(buffer));
+    }
+
+    TimelineBuffer *buffer = timeline_local;
+    uint64_t time = timeline_time();
+    uint64_t &start = buffer->start[int(phase)];
+
+    if (begin) {
+        start = time + 1;
+    } else if (start != 0 && !buffer->events.empty()) {
+        // The phase may have begun before the timeline was enabled
+        buffer->events[buffer->count++ % buffer->events.size()] =
+            TimelineEvent{ start - 1, time + 1 - start, phase };
+        start = 0;
+    }
+}
+
+void Profiler::set_timeline(bool enable, size_t capacity) {
+    std::lock_guard<std::mutex> guard(timeline_mutex);
+    if (enable) {
+        timeline_buffers.clear();
+        timeline_capacity = capacity;
+        timeline_origin = std::chrono::steady_clock::now();
+        timeline_generation++;
+    }
+    profiler_timeline = enable;
+}
+
+void Profiler::write_timeline(const fs::path &filename) {
+    std::lock_guard<std::mutex> guard(timeline_mutex);
+
+    auto escape = [](const std::string &str) {
+        std::string result;
+        for (char c : str) {
+            if (c == '"' || c == '\\')
+                result += '\\';
+            result += c;
+        }
+        return result;
+    };
+
+    std::ostringstream oss;
+    oss << "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [" << std::endl;
+
+    size_t event_count = 0, dropped_count = 0;
+    bool first = true;
+    for (const auto &buffer : timeline_buffers) {
+        oss << (first ? "" : ",\n")
+            << "{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 0, \"tid\": "
+            << buffer->thread_id << ", \"args\": {\"name\": \""
+            << escape(buffer->thread_name) << "\"}}";
+        first = false;
+
+        size_t size = std::min(buffer->count, buffer->events.size());
+        for (size_t i = buffer->count - size; i < buffer->count; ++i) {
+            const TimelineEvent &event = buffer->events[i % buffer->events.size()];
+            oss << ",\n{\"name\": \"" << profiler_phase_id[int(event.phase)]
+                << "\", \"ph\": \"X\", \"pid\": 0, \"tid\": " << buffer->thread_id
+                << ", \"ts\": " << event.start / 1000.0
+                << ", \"dur\": " << event.duration / 1000.0 << "}";
+        }
+        event_count += size;
+        dropped_count += buffer->count - size;
+    }
+    oss << std::endl << "]}" << std::endl;
+
+    ref<FileStream> stream = new FileStream(filename, FileStream::ETruncReadWrite);
+    std::string str = oss.str();
+    stream->write(str.data(), str.size());
+
+    if (dropped_count > 0)
+        Log(Warn, "Profiler::write_timeline(): the ring buffers dropped the %i oldest "
+                  "phases -- increase their capacity to record the complete timeline.",
+            dropped_count);
+    Log(Info, "Wrote a timeline with %i phases of %i threads to \"%s\".", event_count,
+        timeline_buffers.size(), filename.string());
+}
+
+//! @}
+// =======================================================================
+
+// =======================================================================
+//! @{ \name Hardware performance counters
+// =======================================================================
+
+static bool profiler_hw_enabled = false;
+static std::atomic<uint32_t> profiler_hw_failures { 0 };
+
+/* Per-thread state of the perf_event counter group. These are only accessed by
+   the signal handler, and hence use constant initializers (no TLS guards). */
+static thread_local int hw_fd = -2; // -2: not opened yet, -1: not available
+static thread_local uint32_t hw_count = 0;
+static thread_local uint32_t hw_index[HWCounterCount];
+static thread_local uint64_t hw_last[HWCounterCount];
+
+#if defined(__LINUX__)
+/// Open the counters of the calling thread (only uses async-signal-safe calls)
+static void hw_open() {
+    const uint64_t configs[HWCounterCount] = {
+        PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS,
+        PERF_COUNT_HW_CACHE_MISSES, PERF_COUNT_HW_BRANCH_MISSES
+    };
+
+    hw_fd = -1;
+    hw_count = 0;
+    for (uint32_t i = 0; i < HWCounterCount; ++i) {
+        perf_event_attr attr;
+        memset(&attr, 0, sizeof(attr));
+        attr.type = PERF_TYPE_HARDWARE;
+        attr.size = sizeof(attr);
+        attr.config = configs[i];
+        attr.read_format = PERF_FORMAT_GROUP;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+
+        int fd = (int) syscall(__NR_perf_event_open, &attr, 0, -1,
+                               i == 0 ? -1 : hw_fd, 0);
+        if (fd < 0) {
+            // The remaining counters are optional, but the cycle counter leads the group
+            if (i == 0) {
+                profiler_hw_failures++;
+                return;
+            }
+            continue;
+        }
+        if (i == 0)
+            hw_fd = fd;
+        hw_index[hw_count++] = i;
+    }
+}
+
+/// Add the counts since the previous sample of the calling thread to \c sample
+static void hw_sample(ProfilerSample &sample) {
+    if (unlikely(hw_fd == -2))
+        hw_open();
+    if (hw_fd < 0)
+        return;
+
+    uint64_t values[HWCounterCount + 1];
+    ssize_t size = read(hw_fd, values, sizeof(uint64_t) * (hw_count + 1));
+    if (size != (ssize_t) (sizeof(uint64_t) * (hw_count + 1)) || values[0] != hw_count)
+        return;
+
+    for (uint32_t i = 0; i < hw_count; ++i) {
+        uint32_t index = hw_index[i];
+        sample.hw[index] += values[i + 1] - hw_last[index];
+        hw_last[index] = values[i + 1];
+    }
+}
+#else
+static void hw_sample(ProfilerSample &) { }
+#endif
+
+void Profiler::set_hardware_counters(bool enable) {
+#if defined(__LINUX__)
+    profiler_hw_enabled = enable;
+#else
+    if (enable)
+        Log(Warn, "Profiler: hardware performance counters are only supported on Linux!");
+#endif
+}
+
+bool Profiler::hardware_counters() { return profiler_hw_enabled; }
+
+//! @}
+// =======================================================================
+
+// =======================================================================
+//! @{ \name Attribution to objects
+// =======================================================================
+
+bool profiler_object_attribution = false;
+
+struct ObjectSample {
+    const Object *object = nullptr;
+    ProfilerPhase phase = ProfilerPhase::ProfilerPhaseCount;
+    uint64_t count = 0;
+};
+
+/// Separate hash table keyed by (object, phase), so that the phase table does not fill up
+static std::array<ObjectSample, MTS_PROFILE_OBJECT_HASH_SIZE> profiler_object_samples;
+static bool profiler_object_overflow = false;
+static size_t profiler_object_top_count = 20;
+
+static std::mutex profiler_object_mutex;
+static std::unordered_map<const Object *, std::string> profiler_object_names;
+
+static void object_sample(const ProfilerTag &tag) {
+    uint64_t bucket_id =
+        (std::hash<const void *>{}(tag.object) ^ (uint64_t(tag.phase) * 0x9e3779b97f4a7c15ull)) %
+        profiler_object_samples.size();
+
+    for (size_t tries = 0; tries < profiler_object_samples.size(); ++tries) {
+        ObjectSample &bucket = profiler_object_samples[bucket_id];
+        if (bucket.object == nullptr || (bucket.object == tag.object && bucket.phase == tag.phase)) {
+            bucket.object = tag.object;
+            bucket.phase = tag.phase;
+            bucket.count++;
+            return;
+        }
+        if (++bucket_id == profiler_object_samples.size())
+            bucket_id = 0;
+    }
+
+    profiler_object_overflow = true;
+}
+
+void Profiler::set_object_attribution(bool enable, size_t top_count) {
+    profiler_object_attribution = enable;
+    profiler_object_top_count = top_count;
+}
+
+void Profiler::register_object(const Object *object) {
+    if (!profiler_object_attribution)
+        return;
+
+    std::string name = object->class_()->name(), id = object->id();
+    if (!id.empty())
+        name += " \"" + id + "\"";
+
+    std::lock_guard<std::mutex> guard(profiler_object_mutex);
+    profiler_object_names[object] = name;
+}
+
+//! @}
+// =======================================================================
+
 static void profiler_callback(int, siginfo_t *, void *) {
     uint64_t flags = *profiler_flags();
 
@@ -48,6 +362,17 @@ static void profiler_callback(int, siginfo_t *, void *) {
     ProfilerSample &bucket = profiler_samples[bucket_id];
     bucket.flags = flags;
     bucket.count++;
+
+    /* Attribute the events since the previous sample of this thread to the
+       current phases, just like the elapsed time */
+    if (profiler_hw_enabled)
+        hw_sample(bucket);
+
+    if (profiler_object_attribution) {
+        const ProfilerTag &tag = *profiler_tag();
+        if (tag.object)
+            object_sample(tag);
+    }
 }
 
 void Profiler::static_initialization() {
@@ -85,6 +410,34 @@ void Profiler::static_shutdown() {
         Throw("profiler_stop(): failure in setitimer(): %s", strerror(errno));
 }
 
+std::vector<std::pair<std::string, float>> Profiler::flat_profile() {
+    std::map<std::string, uint64_t> leaf_results;
+    uint64_t event_count_total = 0;
+
+    for (auto const &sample: profiler_samples) {
+        if (sample.count == 0)
+            continue;
+        event_count_total += sample.count;
+
+        // The innermost phase has the highest index
+        const char *name = "Idle";
+        for (int i = int(ProfilerPhase::ProfilerPhaseCount) - 1; i >= 0; --i) {
+            if (sample.flags & (1ull << i)) {
+                name = profiler_phase_id[i];
+                break;
+            }
+        }
+        leaf_results[name] += sample.count;
+    }
+
+    std::vector<std::pair<std::string, float>> result;
+    for (const auto &kv : leaf_results)
+        result.emplace_back(kv.first, kv.second / float(event_count_total));
+    std::sort(result.begin(), result.end(),
+              [](const auto &a, const auto &b) { return a.second > b.second; });
+    return result;
+}
+
 void Profiler::print_report() {
     using SampleMap = std::map<std::string, uint64_t>;
 
@@ -92,6 +445,7 @@ void Profiler::print_report() {
              buckets_used = 0;
 
     SampleMap leaf_results, hierarchical_results;
+    std::map<std::string, std::array<uint64_t, HWCounterCount>> leaf_hw;
 
     size_t prefix_length = 0;
     size_t max_indent = 0;
@@ -116,8 +470,11 @@ void Profiler::print_report() {
                 prefix_length = std::max(prefix_length, strlen(name));
                 hierarchical_results[name_hierarchical] += sample.count;
                 sample_flags &= ~flag;
-                if (sample_flags == 0)
+                if (sample_flags == 0) {
                     leaf_results[name] += sample.count;
+                    for (uint32_t k = 0; k < HWCounterCount; ++k)
+                        leaf_hw[name][k] += sample.hw[k];
+                }
                 indent += 1;
             }
             max_indent = std::max(indent, max_indent);
@@ -126,6 +483,8 @@ void Profiler::print_report() {
         if (name_hierarchical.empty()) {
             hierarchical_results["Idle"] += sample.count;
             leaf_results["Idle"] += sample.count;
+            for (uint32_t k = 0; k < HWCounterCount; ++k)
+                leaf_hw["Idle"][k] += sample.hw[k];
         }
     }
 
@@ -172,8 +531,165 @@ void Profiler::print_report() {
             std::string(prefix_length - kv.first.length() - 4, ' '),
             kv.second / float(event_count_total) * 100.f);
     }
+
+    if (profiler_object_attribution) {
+        std::vector<ObjectSample> objects;
+        for (const ObjectSample &sample : profiler_object_samples) {
+            if (sample.count > 0)
+                objects.push_back(sample);
+        }
+        std::sort(objects.begin(), objects.end(),
+                  [](const ObjectSample &a, const ObjectSample &b) { return a.count > b.count; });
+        if (objects.size() > profiler_object_top_count)
+            objects.resize(profiler_object_top_count);
+
+        if (profiler_object_overflow)
+            Log(Warn, "Profiler object table filled up -- you may need to increase "
+                      "MTS_PROFILE_OBJECT_HASH_SIZE.");
+
+        std::lock_guard<std::mutex> guard(profiler_object_mutex);
+        std::vector<std::string> names;
+        size_t name_length = 0;
+        for (const ObjectSample &sample : objects) {
+            auto it = profiler_object_names.find(sample.object);
+            names.push_back(tfm::format("%s / %s",
+                it != profiler_object_names.end() ? it->second : "(unregistered object)",
+                profiler_phase_id[int(sample.phase)]));
+            name_length = std::max(name_length, names.back().length());
+        }
+
+        Log(Info, "\U000023F1  Profile (top %i objects):", objects.size());
+        for (size_t i = 0; i < objects.size(); ++i) {
+            Log(Info, "    %s%s%.2f%%", names[i],
+                std::string(name_length - names[i].length() + 4, ' '),
+                objects[i].count / float(event_count_total) * 100.f);
+        }
+    }
+
+    if (profiler_hw_enabled) {
+        if (profiler_hw_failures > 0)
+            Log(Warn, "Could not open the hardware performance counters of %i threads "
+                      "(check /proc/sys/kernel/perf_event_paranoid).",
+                (uint32_t) profiler_hw_failures);
+
+        Log(Info, "\U000023F1  Hardware counters (flat):");
+        Log(Info, "    %s%s%s%s%s", "Phase",
+            std::string(prefix_length - 9, ' '),
+            "IPC     ", "LLC misses/kinstr.  ", "Branch misses/kinstr.");
+        for (auto kv : leaf_results_sorted) {
+            const auto &hw = leaf_hw[kv.first];
+            if (hw[HWCycles] == 0 || hw[HWInstructions] == 0)
+                continue;
+            double kinstr = hw[HWInstructions] / 1000.0;
+            Log(Info, "    %s%s%-8.2f%-20.2f%.2f", kv.first,
+                std::string(prefix_length - kv.first.length() - 4, ' '),
+                hw[HWInstructions] / double(hw[HWCycles]),
+                hw[HWCacheMisses] / kinstr, hw[HWBranchMisses] / kinstr);
+        }
+    }
+
+    bool counters_used = false;
+    for (int i = 0; i < int(ProfilerCounter::ProfilerCounterCount); ++i)
+        counters_used |= profiler_counters[i] != 0;
+    if (!counters_used)
+        return;
+
+    Log(Info, "\U000023F1  Counters:");
+    for (int i = 0; i < int(ProfilerCounter::ProfilerCounterCount); ++i) {
+        uint64_t value = profiler_counters[i];
+        if (value == 0)
+            continue;
+        std::string name = profiler_counter_id[i];
+        std::string padding(std::max(prefix_length, name.length() + 5) - name.length() - 4, ' ');
+        int base = profiler_counter_base[i];
+        if (base >= 0 && profiler_counters[base] != 0)
+            Log(Info, "    %s%s%i (%.2f%%)", name, padding, value,
+                value / double(profiler_counters[base]) * 100.0);
+        else
+            Log(Info, "    %s%s%i", name, padding, value);
+    }
 }
 
 MTS_IMPLEMENT_CLASS(Profiler, Object)
 NAMESPACE_END(mitsuba)
 #endif
+
+NAMESPACE_BEGIN(mitsuba)
+
+bool load_profiler_enabled = false;
+
+struct LoadStep {
+    LoadEvent event;
+    std::string name, detail;
+    double time;
+};
+
+static std::mutex load_profiler_mutex;
+static std::vector<LoadStep> load_profiler_steps;
+
+void LoadProfiler::set_enabled(bool enable) {
+    std::lock_guard<std::mutex> guard(load_profiler_mutex);
+    load_profiler_steps.clear();
+    load_profiler_enabled = enable;
+}
+
+void LoadProfiler::record(LoadEvent event, const std::string &name,
+                          const std::string &detail, double time) {
+    std::lock_guard<std::mutex> guard(load_profiler_mutex);
+    load_profiler_steps.push_back(LoadStep{ event, name, detail, time });
+}
+
+void LoadProfiler::print_report(size_t top_count) {
+    std::vector<LoadStep> steps;
+    {
+        std::lock_guard<std::mutex> guard(load_profiler_mutex);
+        steps.swap(load_profiler_steps);
+    }
+
+    if (steps.empty()) {
+        Log(Info, "\U000023F1  Load profile: no steps were recorded.");
+        return;
+    }
+
+    double totals[int(LoadEvent::LoadEventCount)] = { };
+    size_t counts[int(LoadEvent::LoadEventCount)] = { };
+    for (const LoadStep &step : steps) {
+        totals[int(step.event)] += step.time;
+        counts[int(step.event)]++;
+    }
+
+    Log(Info, "\U000023F1  Load profile (totals):");
+    for (int i = 0; i < int(LoadEvent::LoadEventCount); ++i) {
+        if (counts[i] == 0)
+            continue;
+        Log(Info, "    %-24s%-12s%i step%s", load_event_id[i],
+            util::time_string(float(totals[i] * 1000), true), counts[i],
+            counts[i] > 1 ? "s" : "");
+    }
+
+    std::sort(steps.begin(), steps.end(),
+              [](const LoadStep &a, const LoadStep &b) { return a.time > b.time; });
+
+    size_t shown = std::min(top_count, steps.size());
+    Log(Info, "\U000023F1  Load profile (slowest %i of %i steps):", shown, steps.size());
+    for (size_t i = 0; i < shown; ++i) {
+        const LoadStep &step = steps[i];
+        std::string name = "\"" + step.name + "\"";
+        if (!step.detail.empty())
+            name += " (" + step.detail + ")";
+        Log(Info, "    %-12s%-24s%s", util::time_string(float(step.time * 1000), true),
+            load_event_id[int(step.event)], name);
+    }
+}
+
+double LoadProfiler::total(LoadEvent event) {
+    std::lock_guard<std::mutex> guard(load_profiler_mutex);
+    double result = 0.0;
+    for (const LoadStep &step : load_profiler_steps) {
+        if (step.event == event)
+            result += step.time;
+    }
+    return result;
+}
+
+NAMESPACE_END(mitsuba)
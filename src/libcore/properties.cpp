@@ -3,11 +3,14 @@
 #  define _ENABLE_EXTENDED_ALIGNED_STORAGE
 #endif
 
+#include <algorithm>
 #include <cstdlib>
 #include <iostream>
-#include <map>
 #include <sstream>
+#include <unordered_map>
+#include <vector>
 
+#include <mitsuba/core/arena.h>
 #include <mitsuba/core/logger.h>
 #include <mitsuba/core/properties.h>
 #include <mitsuba/core/transform.h>
@@ -35,7 +38,7 @@ using VariantType = variant<
 
 struct alignas(16) Entry {
     VariantType data;
-    bool queried;
+    bool queried = false;
 };
 
 struct SortKey {
@@ -63,37 +66,144 @@ struct SortKey {
     }
 };
 
+/**
+ * \brief Storage of the entries of a \ref Properties instance
+ *
+ * Plugins typically receive a handful of parameters, which are kept in a flat
+ * array and found by comparing the precomputed hashes of their names. Large
+ * instances (e.g. the parameters of a scene with many children) additionally
+ * maintain a hash table index. The array is only sorted according to \ref
+ * SortKey when the entries are iterated over.
+ *
+ * The array and the index can be stored in a \ref MemoryArena, while copies
+ * of the map always use the heap (see \ref ArenaAllocator).
+ */
+struct EntryMap {
+    struct Item {
+        std::string name;
+        size_t hash;
+        Entry entry;
+    };
+
+    using ItemVector = std::vector<Item, ArenaAllocator<Item>>;
+    using Index = std::unordered_map<std::string, size_t, std::hash<std::string>,
+                                     std::equal_to<std::string>,
+                                     ArenaAllocator<std::pair<const std::string, size_t>>>;
+
+    /// Number of entries above which the hash table index is used
+    static constexpr size_t IndexThreshold = 16;
+
+    EntryMap(MemoryArena *arena = nullptr)
+        : items(ArenaAllocator<Item>(arena)),
+          index(0, std::hash<std::string>(), std::equal_to<std::string>(),
+                ArenaAllocator<std::pair<const std::string, size_t>>(arena)) { }
+
+    Entry *find(const std::string &name) {
+        if (!index.empty()) {
+            auto it = index.find(name);
+            return it != index.end() ? &items[it->second].entry : nullptr;
+        }
+        size_t hash = std::hash<std::string>()(name);
+        for (Item &item : items) {
+            if (item.hash == hash && item.name == name)
+                return &item.entry;
+        }
+        return nullptr;
+    }
+
+    /// Return the entry with the given name, creating it if necessary
+    Entry &operator[](const std::string &name) {
+        Entry *entry = find(name);
+        if (entry)
+            return *entry;
+
+        if (!items.empty() && !SortKey()(items.back().name, name))
+            sorted = false;
+        items.push_back(Item { name, std::hash<std::string>()(name), Entry() });
+
+        if (!index.empty())
+            index.emplace(name, items.size() - 1);
+        else if (items.size() > IndexThreshold)
+            rebuild_index();
+        return items.back().entry;
+    }
+
+    bool erase(const std::string &name) {
+        auto it = std::find_if(items.begin(), items.end(),
+                               [&](const Item &item) { return item.name == name; });
+        if (it == items.end())
+            return false;
+        items.erase(it);
+        if (!index.empty())
+            rebuild_index();
+        return true;
+    }
+
+    /// Return the entries sorted by name
+    ItemVector &ordered() {
+        if (!sorted) {
+            std::sort(items.begin(), items.end(), [](const Item &a, const Item &b) {
+                return SortKey()(a.name, b.name);
+            });
+            sorted = true;
+            if (!index.empty())
+                rebuild_index();
+        }
+        return items;
+    }
+
+    size_t size() const { return items.size(); }
+
+private:
+    void rebuild_index() {
+        index.clear();
+        if (items.size() <= IndexThreshold)
+            return;
+        index.reserve(items.size());
+        for (size_t i = 0; i < items.size(); ++i)
+            index.emplace(items[i].name, i);
+    }
+
+private:
+    ItemVector items;
+    Index index;
+    bool sorted = true;
+};
+
 struct Properties::PropertiesPrivate {
-    std::map<std::string, Entry, SortKey> entries;
+    EntryMap entries;
     std::string id, plugin_name;
+
+    PropertiesPrivate(MemoryArena *arena = nullptr) : entries(arena) { }
 };
 
 #define DEFINE_PROPERTY_ACCESSOR(Type, TagName, SetterName, GetterName) \
     void Properties::SetterName(const std::string &name, Type const &value, bool error_duplicates) { \
         if (has_property(name) && error_duplicates) \
             Log(Error, "Property \"%s\" was specified multiple times!", name); \
-        d->entries[name].data = (Type) value; \
-        d->entries[name].queried = false; \
+        Entry &entry = d->entries[name]; \
+        entry.data = (Type) value; \
+        entry.queried = false; \
     } \
     \
     Type const & Properties::GetterName(const std::string &name) const { \
-        const auto it = d->entries.find(name); \
-        if (it == d->entries.end()) \
+        Entry *entry = d->entries.find(name); \
+        if (!entry) \
             Throw("Property \"%s\" has not been specified!", name); \
-        if (!it->second.data.is<Type>()) \
+        if (!entry->data.is<Type>()) \
             Throw("The property \"%s\" has the wrong type (expected <" #TagName ">).", name); \
-        it->second.queried = true; \
-        return (Type const &) it->second.data; \
+        entry->queried = true; \
+        return (Type const &) entry->data; \
     } \
     \
     Type const & Properties::GetterName(const std::string &name, Type const &def_val) const { \
-        const auto it = d->entries.find(name); \
-        if (it == d->entries.end()) \
+        Entry *entry = d->entries.find(name); \
+        if (!entry) \
             return def_val; \
-        if (!it->second.data.is<Type>()) \
+        if (!entry->data.is<Type>()) \
             Throw("The property \"%s\" has the wrong type (expected <" #TagName ">).", name); \
-        it->second.queried = true; \
-        return (Type const &) it->second.data; \
+        entry->queried = true; \
+        return (Type const &) entry->data; \
     }
 
 DEFINE_PROPERTY_ACCESSOR(bool,              boolean,   set_bool,              bool_)
@@ -109,8 +219,8 @@ DEFINE_PROPERTY_ACCESSOR(const void *,      pointer,   set_pointer,           po
 Properties::Properties()
     : d(new PropertiesPrivate()) { }
 
-Properties::Properties(const std::string &plugin_name)
-    : d(new PropertiesPrivate()) {
+Properties::Properties(const std::string &plugin_name, MemoryArena *arena)
+    : d(new PropertiesPrivate(arena)) {
     d->plugin_name = plugin_name;
 }
 
@@ -124,7 +234,7 @@ void Properties::operator=(const Properties &props) {
 }
 
 bool Properties::has_property(const std::string &name) const {
-    return d->entries.find(name) != d->entries.end();
+    return d->entries.find(name) != nullptr;
 }
 
 namespace {
@@ -161,34 +271,30 @@ namespace {
 }
 
 Properties::Type Properties::type(const std::string &name) const {
-    const auto it = d->entries.find(name);
-    if (it == d->entries.end())
+    Entry *entry = d->entries.find(name);
+    if (!entry)
         Throw("type(): Could not find property named \"%s\"!", name);
 
-    return it->second.data.visit(PropertyTypeVisitor());
+    return entry->data.visit(PropertyTypeVisitor());
 }
 
 bool Properties::mark_queried(const std::string &name) const {
-    auto it = d->entries.find(name);
-    if (it == d->entries.end())
+    Entry *entry = d->entries.find(name);
+    if (!entry)
         return false;
-    it->second.queried = true;
+    entry->queried = true;
     return true;
 }
 
 bool Properties::was_queried(const std::string &name) const {
-    const auto it = d->entries.find(name);
-    if (it == d->entries.end())
+    Entry *entry = d->entries.find(name);
+    if (!entry)
         Throw("Could not find property named \"%s\"!", name);
-    return it->second.queried;
+    return entry->queried;
 }
 
 bool Properties::remove_property(const std::string &name) {
-    const auto it = d->entries.find(name);
-    if (it == d->entries.end())
-        return false;
-    d->entries.erase(it);
-    return true;
+    return d->entries.erase(name);
 }
 
 const std::string &Properties::plugin_name() const {
@@ -210,29 +316,31 @@ void Properties::set_id(const std::string &id) {
 void Properties::copy_attribute(const Properties &properties,
                                 const std::string &source_name,
                                 const std::string &target_name) {
-    const auto it = properties.d->entries.find(source_name);
-    if (it == properties.d->entries.end())
+    Entry *entry = properties.d->entries.find(source_name);
+    if (!entry)
         Throw("copy_attribute(): Could not find parameter \"%s\"!", source_name);
-    d->entries[target_name] = it->second;
+    // Copy first: inserting the target may reallocate the entries of 'properties'
+    Entry value = *entry;
+    d->entries[target_name] = value;
 }
 
 std::vector<std::string> Properties::property_names() const {
     std::vector<std::string> result;
-    for (const auto &e : d->entries)
-        result.push_back(e.first);
+    for (const auto &e : d->entries.ordered())
+        result.push_back(e.name);
     return result;
 }
 
 std::vector<std::pair<std::string, NamedReference>> Properties::named_references() const {
     std::vector<std::pair<std::string, NamedReference>> result;
     result.reserve(d->entries.size());
-    for (auto &e : d->entries) {
-        auto type = e.second.data.visit(PropertyTypeVisitor());
+    for (auto &e : d->entries.ordered()) {
+        auto type = e.entry.data.visit(PropertyTypeVisitor());
         if (type != Type::NamedReference)
             continue;
-        auto const &value = (const NamedReference &) e.second.data;
-        result.push_back(std::make_pair(e.first, value));
-        e.second.queried = true;
+        auto const &value = (const NamedReference &) e.entry.data;
+        result.push_back(std::make_pair(e.name, value));
+        e.entry.queried = true;
     }
     return result;
 }
@@ -240,29 +348,29 @@ std::vector<std::pair<std::string, NamedReference>> Properties::named_references
 std::vector<std::pair<std::string, ref<Object>>> Properties::objects(bool mark_queried) const {
     std::vector<std::pair<std::string, ref<Object>>> result;
     result.reserve(d->entries.size());
-    for (auto &e : d->entries) {
-        auto type = e.second.data.visit(PropertyTypeVisitor());
+    for (auto &e : d->entries.ordered()) {
+        auto type = e.entry.data.visit(PropertyTypeVisitor());
         if (type != Type::Object)
             continue;
-        result.push_back(std::make_pair(e.first, (const ref<Object> &) e.second));
+        result.push_back(std::make_pair(e.name, (const ref<Object> &) e.entry.data));
         if (mark_queried)
-            e.second.queried = true;
+            e.entry.queried = true;
     }
     return result;
 }
 
 std::vector<std::string> Properties::unqueried() const {
     std::vector<std::string> result;
-    for (const auto &e : d->entries) {
-        if (!e.second.queried)
-            result.push_back(e.first);
+    for (const auto &e : d->entries.ordered()) {
+        if (!e.entry.queried)
+            result.push_back(e.name);
     }
     return result;
 }
 
 void Properties::merge(const Properties &p) {
-    for (const auto &e : p.d->entries)
-        d->entries[e.first] = e.second;
+    for (const auto &e : p.d->entries.ordered())
+        d->entries[e.name] = e.entry;
 }
 
 bool Properties::operator==(const Properties &p) const {
@@ -271,58 +379,61 @@ bool Properties::operator==(const Properties &p) const {
         d->entries.size() != p.d->entries.size())
         return false;
 
-    for (const auto &e : d->entries) {
-        auto it = p.d->entries.find(e.first);
-        if (it == p.d->entries.end())
+    for (const auto &e : d->entries.ordered()) {
+        const Entry *entry = p.d->entries.find(e.name);
+        if (!entry)
             return false;
-        if (e.second.data != it->second.data)
+        if (e.entry.data != entry->data)
             return false;
     }
 
     return true;
 }
 
+std::vector<std::string> Properties::differing_properties(const Properties &p) const {
+    std::vector<std::string> result;
+    for (const auto &e : d->entries.ordered()) {
+        const Entry *entry = p.d->entries.find(e.name);
+        if (!entry || e.entry.data != entry->data)
+            result.push_back(e.name);
+    }
+    for (const auto &e : p.d->entries.ordered()) {
+        if (!d->entries.find(e.name))
+            result.push_back(e.name);
+    }
+    return result;
+}
+
 std::string Properties::as_string(const std::string &name) const {
+    Entry *entry = d->entries.find(name);
+    if (!entry)
+        Throw("Property \"%s\" has not been specified!", name);
     std::ostringstream oss;
-    bool found = false;
-    for (auto &e : d->entries) {
-        if (e.first != name)
-            continue;
-        e.second.data.visit(StreamVisitor(oss));
-        found = true;
-        break;
-    }
-    if (!found)
-        Throw("Property \"%s\" has not been specified!", name); \
+    entry->data.visit(StreamVisitor(oss));
     return oss.str();
 }
 
 std::string Properties::as_string(const std::string &name, const std::string &def_val) const {
-    std::ostringstream oss;
-    bool found = false;
-    for (auto &e : d->entries) {
-        if (e.first != name)
-            continue;
-        e.second.data.visit(StreamVisitor(oss));
-        found = true;
-        break;
-    }
-    if (!found)
+    Entry *entry = d->entries.find(name);
+    if (!entry)
         return def_val;
+    std::ostringstream oss;
+    entry->data.visit(StreamVisitor(oss));
     return oss.str();
 }
 
 std::ostream &operator<<(std::ostream &os, const Properties &p) {
-    auto it = p.d->entries.begin();
+    auto &entries = p.d->entries.ordered();
+    auto it = entries.begin();
 
     os << "Properties[" << std::endl
        << "  plugin_name = \"" << (p.d->plugin_name) << "\"," << std::endl
        << "  id = \"" << p.d->id << "\"," << std::endl
        << "  elements = {" << std::endl;
-    while (it != p.d->entries.end()) {
-        os << "    \"" << it->first << "\" -> ";
-        it->second.data.visit(StreamVisitor(os));
-        if (++it != p.d->entries.end()) os << ",";
+    while (it != entries.end()) {
+        os << "    \"" << it->name << "\" -> ";
+        it->entry.data.visit(StreamVisitor(os));
+        if (++it != entries.end()) os << ",";
         os << std::endl;
     }
     os << "  }" << std::endl
@@ -337,32 +448,32 @@ std::ostream &operator<<(std::ostream &os, const Properties &p) {
 
 // size_t getter
 size_t Properties::size_(const std::string &name) const {
-    const auto it = d->entries.find(name);
-    if (it == d->entries.end())
+    Entry *entry = d->entries.find(name);
+    if (!entry)
         Throw("Property \"%s\" has not been specified!", name);
-    if (!it->second.data.is<int64_t>())
+    if (!entry->data.is<int64_t>())
         Throw("The property \"%s\" has the wrong type (expected <integer>).", name);
 
-    auto v = (int64_t) it->second.data;
+    auto v = (int64_t) entry->data;
     if (v < 0) {
         Throw("Property \"%s\" has negative value %i, but was queried as a"
               " size_t (unsigned).", name, v);
     }
-    it->second.queried = true;
+    entry->queried = true;
     return (size_t) v;
 }
 // size_t getter (with default value)
 size_t Properties::size_(const std::string &name, const size_t &def_val) const {
-    const auto it = d->entries.find(name);
-    if (it == d->entries.end())
+    Entry *entry = d->entries.find(name);
+    if (!entry)
         return def_val;
 
-    auto v = (int64_t) it->second.data;
+    auto v = (int64_t) entry->data;
     if (v < 0) {
         Throw("Property \"%s\" has negative value %i, but was queried as a"
               " size_t (unsigned).", name, v);
     }
-    it->second.queried = true;
+    entry->queried = true;
     return (size_t) v;
 }
 
@@ -370,64 +481,66 @@ size_t Properties::size_(const std::string &name, const size_t &def_val) const {
 void Properties::set_float(const std::string &name, const Float &value, bool error_duplicates) {
     if (has_property(name) && error_duplicates)
         Log(Error, "Property \"%s\" was specified multiple times!", name);
-    d->entries[name].data = (Float) value;
-    d->entries[name].queried = false;
+    Entry &entry = d->entries[name];
+    entry.data = (Float) value;
+    entry.queried = false;
 }
 
 /// Float getter (without default)
 Float Properties::float_(const std::string &name) const {
-    const auto it = d->entries.find(name);
-    if (it == d->entries.end())
+    Entry *entry = d->entries.find(name);
+    if (!entry)
         Throw("Property \"%s\" has not been specified!", name);
-    if (!(it->second.data.is<Float>() || it->second.data.is<int64_t>()))
+    if (!(entry->data.is<Float>() || entry->data.is<int64_t>()))
         Throw("The property \"%s\" has the wrong type (expected <float>).", name);
-    it->second.queried = true;
-    if (it->second.data.is<int64_t>())
-        return (int64_t) it->second.data;
-    return (Float) it->second.data;
+    entry->queried = true;
+    if (entry->data.is<int64_t>())
+        return (int64_t) entry->data;
+    return (Float) entry->data;
 }
 
 /// Float getter (with default)
 Float Properties::float_(const std::string &name, const Float &def_val) const {
-    const auto it = d->entries.find(name);
-    if (it == d->entries.end())
+    Entry *entry = d->entries.find(name);
+    if (!entry)
         return def_val;
-    if (!(it->second.data.is<Float>() || it->second.data.is<int64_t>()))
+    if (!(entry->data.is<Float>() || entry->data.is<int64_t>()))
         Throw("The property \"%s\" has the wrong type (expected <float>).", name);
-    it->second.queried = true;
-    if (it->second.data.is<int64_t>())
-        return (int64_t) it->second.data;
-    return (Float) it->second.data;
+    entry->queried = true;
+    if (entry->data.is<int64_t>())
+        return (int64_t) entry->data;
+    return (Float) entry->data;
 }
 
 /// Array3f setter
 void Properties::set_array3f(const std::string &name, const Array3f &value, bool error_duplicates) {
     if (has_property(name) && error_duplicates)
         Log(Error, "Property \"%s\" was specified multiple times!", name);
-    d->entries[name].data = (Array3f) value;
-    d->entries[name].queried = false;
+    Entry &entry = d->entries[name];
+    entry.data = (Array3f) value;
+    entry.queried = false;
 }
 
 /// Array3f getter (without default)
 Array3f Properties::array3f(const std::string &name) const {
-    const auto it = d->entries.find(name);
-    if (it == d->entries.end())
+    Entry *entry = d->entries.find(name);
+    if (!entry)
         Throw("Property \"%s\" has not been specified!", name);
-    if (!it->second.data.is<Array3f>())
+    if (!entry->data.is<Array3f>())
         Throw("The property \"%s\" has the wrong type (expected <vector> or <point>).", name);
-    it->second.queried = true;
-    return it->second.data.operator Array3f&();
+    entry->queried = true;
+    return entry->data.operator Array3f&();
 }
 
 /// Array3f getter (with default)
 Array3f Properties::array3f(const std::string &name, const Array3f &def_val) const {
-    const auto it = d->entries.find(name);
-    if (it == d->entries.end())
+    Entry *entry = d->entries.find(name);
+    if (!entry)
         return def_val;
-    if (!it->second.data.is<Array3f>())
+    if (!entry->data.is<Array3f>())
         Throw("The property \"%s\" has the wrong type (expected <vector> or <point>).", name);
-    it->second.queried = true;
-    return it->second.data.operator Array3f&();
+    entry->queried = true;
+    return entry->data.operator Array3f&();
 }
 
 /// AnimatedTransform setter.
@@ -436,8 +549,9 @@ void Properties::set_animated_transform(const std::string &name,
                                         bool error_duplicates) {
     if (has_property(name) && error_duplicates)
         Log(Error, "Property \"%s\" was specified multiple times!", name);
-    d->entries[name].data = ref<Object>(value.get());
-    d->entries[name].queried = false;
+    Entry &entry = d->entries[name];
+    entry.data = ref<Object>(value.get());
+    entry.queried = false;
 }
 
 /// AnimatedTransform setter (from a simple Transform).
@@ -450,50 +564,50 @@ void Properties::set_animated_transform(const std::string &name,
 
 /// AnimatedTransform getter (without default value).
 ref<AnimatedTransform> Properties::animated_transform(const std::string &name) const {
-    const auto it = d->entries.find(name);
-    if (it == d->entries.end())
+    Entry *entry = d->entries.find(name);
+    if (!entry)
         Throw("Property \"%s\" has not been specified!", name);
-    if (it->second.data.is<Transform4f>()) {
+    if (entry->data.is<Transform4f>()) {
         // Also accept simple transforms, from which we can build
         // an AnimatedTransform.
-        it->second.queried = true;
+        entry->queried = true;
         return new AnimatedTransform(
-            static_cast<const Transform4f &>(it->second.data));
+            static_cast<const Transform4f &>(entry->data));
     }
-    if (!it->second.data.is<ref<Object>>()) {
+    if (!entry->data.is<ref<Object>>()) {
         Throw("The property \"%s\" has the wrong type (expected "
               " <animated_transform> or <transform>).", name);
     }
-    ref<Object> o = it->second.data;
+    ref<Object> o = entry->data;
     if (!o->class_()->derives_from(MTS_CLASS(AnimatedTransform)))
         Throw("The property \"%s\" has the wrong type (expected "
               " <animated_transform> or <transform>).", name);
-    it->second.queried = true;
+    entry->queried = true;
     return (AnimatedTransform *) o.get();
 }
 
 /// AnimatedTransform getter (with default value).
 ref<AnimatedTransform> Properties::animated_transform(
         const std::string &name, ref<AnimatedTransform> def_val) const {
-    const auto it = d->entries.find(name);
-    if (it == d->entries.end())
+    Entry *entry = d->entries.find(name);
+    if (!entry)
         return def_val;
-    if (it->second.data.is<Transform4f>()) {
+    if (entry->data.is<Transform4f>()) {
         // Also accept simple transforms, from which we can build
         // an AnimatedTransform.
-        it->second.queried = true;
+        entry->queried = true;
         return new AnimatedTransform(
-            static_cast<const Transform4f &>(it->second.data));
+            static_cast<const Transform4f &>(entry->data));
     }
-    if (!it->second.data.is<ref<Object>>()) {
+    if (!entry->data.is<ref<Object>>()) {
         Throw("The property \"%s\" has the wrong type (expected "
               " <animated_transform> or <transform>).", name);
     }
-    ref<Object> o = it->second.data;
+    ref<Object> o = entry->data;
     if (!o->class_()->derives_from(MTS_CLASS(AnimatedTransform)))
         Throw("The property \"%s\" has the wrong type (expected "
               " <animated_transform> or <transform>).", name);
-    it->second.queried = true;
+    entry->queried = true;
     return (AnimatedTransform *) o.get();
 }
 
@@ -504,14 +618,14 @@ ref<AnimatedTransform> Properties::animated_transform(
 }
 
 ref<Object> Properties::find_object(const std::string &name) const {
-    const auto it = d->entries.find(name);
-    if (it == d->entries.end())
+    Entry *entry = d->entries.find(name);
+    if (!entry)
         return ref<Object>();
 
-    if (!it->second.data.is<ref<Object>>())
+    if (!entry->data.is<ref<Object>>())
         Throw("The property \"%s\" has the wrong type.", name);
 
-    return it->second.data;
+    return entry->data;
 }
 
 NAMESPACE_END(mitsuba)
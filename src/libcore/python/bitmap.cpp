@@ -3,6 +3,21 @@
 #include <mitsuba/core/stream.h>
 #include <pybind11/numpy.h>
 #include <mitsuba/python/python.h>
+#include <mitsuba/python/dlpack.h>
+
+/// Pixel format of an image array with the given number of channels
+static Bitmap::PixelFormat pixel_format_for(size_t channel_count, py::object pixel_format) {
+    if (!pixel_format.is_none())
+        return pixel_format.cast<Bitmap::PixelFormat>();
+
+    switch (channel_count) {
+        case 1: return Bitmap::PixelFormat::Y;
+        case 2: return Bitmap::PixelFormat::YA;
+        case 3: return Bitmap::PixelFormat::RGB;
+        case 4: return Bitmap::PixelFormat::RGBA;
+        default: return Bitmap::PixelFormat::MultiChannel;
+    }
+}
 
 MTS_PY_EXPORT(Bitmap) {
     using Float = typename Bitmap::Float;
@@ -50,21 +65,8 @@ MTS_PY_EXPORT(Bitmap) {
             if (obj.ndim() != 2 && obj.ndim() != 3)
                 throw py::type_error("Expected an array of size 2 or 3");
 
-            Bitmap::PixelFormat pixel_format = Bitmap::PixelFormat::Y;
-            size_t channel_count = 1;
-            if (obj.ndim() == 3) {
-                channel_count = obj.shape()[2];
-                switch (channel_count) {
-                    case 1: pixel_format = Bitmap::PixelFormat::Y; break;
-                    case 2: pixel_format = Bitmap::PixelFormat::YA; break;
-                    case 3: pixel_format = Bitmap::PixelFormat::RGB; break;
-                    case 4: pixel_format = Bitmap::PixelFormat::RGBA; break;
-                    default: pixel_format = Bitmap::PixelFormat::MultiChannel; break;
-                }
-            }
-
-            if (!pixel_format_.is_none())
-                pixel_format = pixel_format_.cast<Bitmap::PixelFormat>();
+            size_t channel_count = obj.ndim() == 3 ? obj.shape()[2] : 1;
+            Bitmap::PixelFormat pixel_format = pixel_format_for(channel_count, pixel_format_);
 
             obj = py::array::ensure(obj, py::array::c_style);
             Vector2u size(obj.shape()[1], obj.shape()[0]);
@@ -72,6 +74,30 @@ MTS_PY_EXPORT(Bitmap) {
             memcpy(bitmap->data(), obj.data(), bitmap->buffer_size());
             return bitmap;
         }), "array"_a, "pixel_format"_a = py::none(), "Initialize a Bitmap from a NumPy array")
+        .def_static("from_dlpack", [](py::handle obj, py::object pixel_format_) {
+            auto [tensor, owner] = dlpack::import_tensor(obj);
+            if (tensor->device.device_type != dlpack::CPU)
+                throw py::type_error("Bitmap.from_dlpack(): the tensor must reside in host memory");
+            if (tensor->ndim != 2 && tensor->ndim != 3)
+                throw py::type_error("Expected a tensor with 2 or 3 dimensions");
+            if (!dlpack::is_contiguous(*tensor))
+                throw py::type_error("Bitmap.from_dlpack(): the tensor must be contiguous");
+
+            size_t channel_count = tensor->ndim == 3 ? (size_t) tensor->shape[2] : 1;
+            ref<Bitmap> bitmap = new Bitmap(
+                pixel_format_for(channel_count, pixel_format_),
+                dlpack::struct_type(tensor->dtype),
+                Vector2u((uint32_t) tensor->shape[1], (uint32_t) tensor->shape[0]),
+                channel_count, (uint8_t *) tensor->data + tensor->byte_offset);
+
+            // The bitmap aliases the memory of the tensor, which must outlive it
+            py::object result = py::cast(bitmap);
+            py::detail::keep_alive_impl(result, owner);
+            return result;
+        }, "tensor"_a, "pixel_format"_a = py::none(),
+        "Create a Bitmap that aliases the memory of a DLPack tensor (without copying "
+        "it). The argument can be a DLPack capsule or any object implementing "
+        "``__dlpack__()``, e.g. a NumPy array or a PyTorch tensor.")
         .def(py::init<const Bitmap &>())
         .def_method(Bitmap, pixel_format)
         .def_method(Bitmap, component_format)
@@ -87,6 +113,10 @@ MTS_PY_EXPORT(Bitmap) {
         .def_method(Bitmap, set_srgb_gamma)
         .def_method(Bitmap, premultiplied_alpha)
         .def_method(Bitmap, set_premultiplied_alpha)
+        .def_method(Bitmap, exr_tile_size)
+        .def_method(Bitmap, set_exr_tile_size)
+        .def_method(Bitmap, exr_multi_part)
+        .def_method(Bitmap, set_exr_multi_part)
         .def_method(Bitmap, clear)
         .def("metadata", py::overload_cast<>(&Bitmap::metadata), D(Bitmap, metadata),
             py::return_value_policy::reference_internal)
@@ -166,8 +196,13 @@ MTS_PY_EXPORT(Bitmap) {
                 &Bitmap::write_async, py::const_),
             "path"_a, "format"_a = Bitmap::FileFormat::Auto, "quality"_a = -1,
             D(Bitmap, write_async))
+        .def_static("wait_async_writes", &Bitmap::wait_async_writes,
+            D(Bitmap, wait_async_writes), py::call_guard<py::gil_scoped_release>())
         .def("split", &Bitmap::split, D(Bitmap, split))
         .def_static("detect_file_format", &Bitmap::detect_file_format, D(Bitmap, detect_file_format))
+        .def_static("read_header", &Bitmap::read_header, "path"_a,
+            "format"_a = Bitmap::FileFormat::Auto, D(Bitmap, read_header),
+            py::call_guard<py::gil_scoped_release>())
         .def_property_readonly("__array_interface__", [](Bitmap &bitmap) -> py::object {
             if (bitmap.struct_()->size() == 0)
                 return py::none();
@@ -203,5 +238,18 @@ MTS_PY_EXPORT(Bitmap) {
             result["data"] = py::make_tuple(size_t(bitmap.uint8_data()), false);
             result["version"] = 3;
             return py::object(result);
+        })
+        .def("__dlpack__", [](py::object self, py::object /* stream */) {
+            Bitmap &bitmap = self.cast<Bitmap &>();
+            return dlpack::export_tensor(
+                bitmap.data(), dlpack::data_type(bitmap.component_format()),
+                { (int64_t) bitmap.height(), (int64_t) bitmap.width(),
+                  (int64_t) bitmap.channel_count() },
+                dlpack::CPU, self);
+        }, "stream"_a = py::none(),
+        "Export the pixel data as a DLPack capsule with shape ``(height, width, "
+        "channel_count)`` that aliases the memory of the bitmap")
+        .def("__dlpack_device__", [](const Bitmap &) {
+            return py::make_tuple((int) dlpack::CPU, 0);
         });
 }
@@ -1,6 +1,43 @@
 #include <mitsuba/core/distr_1d.h>
 #include <mitsuba/python/python.h>
 
+/// Bind the batched queries of a continuous distribution (only supported on the CPU)
+template <typename Float, typename Distr>
+void bind_batch_queries(py::class_<Distr> &cls,
+                        const char *doc_eval_pdf,
+                        const char *doc_eval_pdf_normalized,
+                        const char *doc_eval_cdf,
+                        const char *doc_eval_cdf_normalized,
+                        const char *doc_sample) {
+    if constexpr (!is_cuda_array_v<Float>) {
+        using ScalarFloat = scalar_t<Float>;
+        using NumPyArray  = py::array_t<ScalarFloat, py::array::c_style | py::array::forcecast>;
+
+        auto query = [](auto method) {
+            return [method](const Distr &distr, const NumPyArray &x) {
+                NumPyArray result((size_t) x.size());
+                (distr.*method)(x.data(), result.mutable_data(), (size_t) x.size());
+                return result;
+            };
+        };
+
+        cls.def("eval_pdf_batch", query(&Distr::eval_pdf_batch), "x"_a, doc_eval_pdf)
+           .def("eval_pdf_normalized_batch", query(&Distr::eval_pdf_normalized_batch),
+                "x"_a, doc_eval_pdf_normalized)
+           .def("eval_cdf_batch", query(&Distr::eval_cdf_batch), "x"_a, doc_eval_cdf)
+           .def("eval_cdf_normalized_batch", query(&Distr::eval_cdf_normalized_batch),
+                "x"_a, doc_eval_cdf_normalized)
+           .def("sample_batch",
+                [](const Distr &distr, const NumPyArray &value) {
+                    NumPyArray pos((size_t) value.size()), pdf((size_t) value.size());
+                    distr.sample_batch(value.data(), pos.mutable_data(),
+                                       (size_t) value.size(), pdf.mutable_data());
+                    return std::make_pair(pos, pdf);
+                },
+                "value"_a, doc_sample);
+    }
+}
+
 MTS_PY_EXPORT(DiscreteDistribution) {
     MTS_PY_IMPORT_TYPES()
 
@@ -28,6 +65,8 @@ MTS_PY_EXPORT(DiscreteDistribution) {
         .def("eval_cdf_normalized", vectorize(&DiscreteDistribution::eval_cdf_normalized),
              "index"_a, "active"_a = true, D(DiscreteDistribution, eval_cdf_normalized))
         .def_method(DiscreteDistribution, update)
+        .def_method(DiscreteDistribution, build_alias_table)
+        .def_method(DiscreteDistribution, has_alias_table)
         .def_method(DiscreteDistribution, sum)
         .def_method(DiscreteDistribution, normalization)
         .def("sample",
@@ -51,7 +90,7 @@ MTS_PY_EXPORT(ContinuousDistribution) {
     using ContinuousDistribution = mitsuba::ContinuousDistribution<Float>;
     using FloatStorage = DynamicBuffer<Float>;
 
-    MTS_PY_STRUCT(ContinuousDistribution, py::module_local())
+    auto distr = MTS_PY_STRUCT(ContinuousDistribution, py::module_local())
         .def(py::init<>(), D(ContinuousDistribution))
         .def(py::init<const ContinuousDistribution &>(), "Copy constructor")
         .def(py::init<const ScalarVector2f &, const FloatStorage &>(),
@@ -74,6 +113,8 @@ MTS_PY_EXPORT(ContinuousDistribution) {
         .def("eval_cdf_normalized", vectorize(&ContinuousDistribution::eval_cdf_normalized),
              "x"_a, "active"_a = true, D(ContinuousDistribution, eval_cdf_normalized))
         .def_method(ContinuousDistribution, update)
+        .def_method(ContinuousDistribution, build_alias_table)
+        .def_method(ContinuousDistribution, has_alias_table)
         .def_method(ContinuousDistribution, integral)
         .def_method(ContinuousDistribution, normalization)
         .def("sample",
@@ -83,6 +124,13 @@ MTS_PY_EXPORT(ContinuousDistribution) {
             vectorize(&ContinuousDistribution::sample_pdf),
             "value"_a, "active"_a = true, D(ContinuousDistribution, sample_pdf))
         .def_repr(ContinuousDistribution);
+
+    bind_batch_queries<Float>(distr,
+        D(ContinuousDistribution, eval_pdf_batch),
+        D(ContinuousDistribution, eval_pdf_normalized_batch),
+        D(ContinuousDistribution, eval_cdf_batch),
+        D(ContinuousDistribution, eval_cdf_normalized_batch),
+        D(ContinuousDistribution, sample_batch));
 }
 
 MTS_PY_EXPORT(IrregularContinuousDistribution) {
@@ -91,7 +139,7 @@ MTS_PY_EXPORT(IrregularContinuousDistribution) {
     using IrregularContinuousDistribution = mitsuba::IrregularContinuousDistribution<Float>;
     using FloatStorage = DynamicBuffer<Float>;
 
-    MTS_PY_STRUCT(IrregularContinuousDistribution, py::module_local())
+    auto distr = MTS_PY_STRUCT(IrregularContinuousDistribution, py::module_local())
         .def(py::init<>(), D(IrregularContinuousDistribution))
         .def(py::init<const IrregularContinuousDistribution &>(), "Copy constructor")
         .def(py::init<const FloatStorage &, const FloatStorage &>(),
@@ -114,6 +162,8 @@ MTS_PY_EXPORT(IrregularContinuousDistribution) {
         .def("eval_cdf_normalized", vectorize(&IrregularContinuousDistribution::eval_cdf_normalized),
              "x"_a, "active"_a = true, D(IrregularContinuousDistribution, eval_cdf_normalized))
         .def_method(IrregularContinuousDistribution, update)
+        .def_method(IrregularContinuousDistribution, build_alias_table)
+        .def_method(IrregularContinuousDistribution, has_alias_table)
         .def_method(IrregularContinuousDistribution, integral)
         .def_method(IrregularContinuousDistribution, normalization)
         .def("sample",
@@ -123,4 +173,11 @@ MTS_PY_EXPORT(IrregularContinuousDistribution) {
             vectorize(&IrregularContinuousDistribution::sample_pdf),
             "value"_a, "active"_a = true, D(IrregularContinuousDistribution, sample_pdf))
         .def_repr(IrregularContinuousDistribution);
+
+    bind_batch_queries<Float>(distr,
+        D(IrregularContinuousDistribution, eval_pdf_batch),
+        D(IrregularContinuousDistribution, eval_pdf_normalized_batch),
+        D(IrregularContinuousDistribution, eval_cdf_batch),
+        D(IrregularContinuousDistribution, eval_cdf_normalized_batch),
+        D(IrregularContinuousDistribution, sample_batch));
 }
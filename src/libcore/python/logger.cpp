@@ -39,6 +39,12 @@ MTS_PY_EXPORT(Logger) {
         .def("appender", (Appender * (Logger::*)(size_t)) &Logger::appender, D(Logger, appender))
         .def("formatter", (Formatter * (Logger::*)()) &Logger::formatter, D(Logger, formatter))
         .def_method(Logger, set_formatter, py::keep_alive<1, 2>())
+        .def("set_async", &Logger::set_async, "value"_a, "queue_size"_a = 1024,
+            D(Logger, set_async), py::call_guard<py::gil_scoped_release>())
+        .def_method(Logger, is_async)
+        .def("flush", &Logger::flush, D(Logger, flush),
+            py::call_guard<py::gil_scoped_release>())
+        .def_method(Logger, dropped_count)
         .def_method(Logger, read_log);
 
     m.def("Log", &PyLog, "level"_a, "msg"_a);
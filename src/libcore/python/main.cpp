@@ -18,15 +18,20 @@ MTS_PY_DECLARE(Bitmap);
 MTS_PY_DECLARE(Formatter);
 MTS_PY_DECLARE(FileResolver);
 MTS_PY_DECLARE(Logger);
+MTS_PY_DECLARE(MemoryAccounting);
 MTS_PY_DECLARE(MemoryMappedFile);
 MTS_PY_DECLARE(Stream);
 MTS_PY_DECLARE(DummyStream);
 MTS_PY_DECLARE(FileStream);
+MTS_PY_DECLARE(AsyncFileStream);
 MTS_PY_DECLARE(MemoryStream);
 MTS_PY_DECLARE(ZStream);
 MTS_PY_DECLARE(ProgressReporter);
 MTS_PY_DECLARE(rfilter);
+MTS_PY_DECLARE(Statistics);
 MTS_PY_DECLARE(Thread);
+MTS_PY_DECLARE(TileCache);
+MTS_PY_DECLARE(InstanceCache);
 MTS_PY_DECLARE(util);
 
 PYBIND11_MODULE(core_ext, m) {
@@ -112,13 +117,18 @@ PYBIND11_MODULE(core_ext, m) {
     MTS_PY_IMPORT(Formatter);
     MTS_PY_IMPORT(FileResolver);
     MTS_PY_IMPORT(Logger);
+    MTS_PY_IMPORT(MemoryAccounting);
     MTS_PY_IMPORT(MemoryMappedFile);
     MTS_PY_IMPORT(DummyStream);
     MTS_PY_IMPORT(FileStream);
+    MTS_PY_IMPORT(AsyncFileStream);
     MTS_PY_IMPORT(MemoryStream);
     MTS_PY_IMPORT(ZStream);
     MTS_PY_IMPORT(ProgressReporter);
+    MTS_PY_IMPORT(Statistics);
     MTS_PY_IMPORT(Thread);
+    MTS_PY_IMPORT(TileCache);
+    MTS_PY_IMPORT(InstanceCache);
     MTS_PY_IMPORT(util);
 
     /* Register a cleanup callback function that is invoked when
@@ -0,0 +1,58 @@
+#include <mitsuba/core/memory.h>
+#include <mitsuba/core/util.h>
+#include <mitsuba/python/python.h>
+
+MTS_PY_EXPORT(MemoryAccounting) {
+    py::enum_<MemoryCategory>(m, "MemoryCategory", D(MemoryCategory))
+        .value("Geometry", MemoryCategory::Geometry, D(MemoryCategory, Geometry))
+        .value("KDTree", MemoryCategory::KDTree, D(MemoryCategory, KDTree))
+        .value("Textures", MemoryCategory::Textures, D(MemoryCategory, Textures))
+        .value("Volumes", MemoryCategory::Volumes, D(MemoryCategory, Volumes))
+        .value("Film", MemoryCategory::Film, D(MemoryCategory, Film))
+        .value("Emitters", MemoryCategory::Emitters, D(MemoryCategory, Emitters));
+
+    py::class_<MemoryAccounting>(m, "MemoryAccounting", D(MemoryAccounting))
+        .def_static("add", &MemoryAccounting::add, "category"_a, "size"_a,
+            D(MemoryAccounting, add))
+        .def_static("remove", &MemoryAccounting::remove, "category"_a, "size"_a,
+            D(MemoryAccounting, remove))
+        .def_static("current", &MemoryAccounting::current, "category"_a,
+            D(MemoryAccounting, current))
+        .def_static("peak", &MemoryAccounting::peak, "category"_a,
+            D(MemoryAccounting, peak))
+        .def_static("reset_peak", &MemoryAccounting::reset_peak,
+            D(MemoryAccounting, reset_peak))
+        .def_static("report", &MemoryAccounting::report, D(MemoryAccounting, report))
+        .def_static("print_report", &MemoryAccounting::print_report, "level"_a = Info,
+            D(MemoryAccounting, print_report));
+
+    py::class_<DeviceMemoryStats>(m, "DeviceMemoryStats", D(DeviceMemoryStats))
+        .def_readonly("used", &DeviceMemoryStats::used, D(DeviceMemoryStats, used))
+        .def_readonly("cached", &DeviceMemoryStats::cached, D(DeviceMemoryStats, cached))
+        .def_readonly("peak", &DeviceMemoryStats::peak, D(DeviceMemoryStats, peak))
+        .def_readonly("limit", &DeviceMemoryStats::limit, D(DeviceMemoryStats, limit))
+        .def_readonly("hits", &DeviceMemoryStats::hits, D(DeviceMemoryStats, hits))
+        .def_readonly("misses", &DeviceMemoryStats::misses, D(DeviceMemoryStats, misses))
+        .def("__repr__", [](const DeviceMemoryStats &s) {
+            return tfm::format("DeviceMemoryStats[used=%s, cached=%s, peak=%s, limit=%s, "
+                               "hits=%zu, misses=%zu]", util::mem_string(s.used),
+                               util::mem_string(s.cached), util::mem_string(s.peak),
+                               util::mem_string(s.limit), s.hits, s.misses);
+        });
+
+    // Buffers are passed as integer device addresses
+    py::class_<DeviceMemoryPool>(m, "DeviceMemoryPool", D(DeviceMemoryPool))
+        .def_static("malloc", [](size_t size) { return (uintptr_t) DeviceMemoryPool::malloc(size); },
+            "size"_a, D(DeviceMemoryPool, malloc))
+        .def_static("free", [](uintptr_t ptr) { DeviceMemoryPool::free((void *) ptr); },
+            "ptr"_a, D(DeviceMemoryPool, free))
+        .def_static("set_limit", &DeviceMemoryPool::set_limit, "limit"_a,
+            D(DeviceMemoryPool, set_limit))
+        .def_static("limit", &DeviceMemoryPool::limit, D(DeviceMemoryPool, limit))
+        .def_static("trim", &DeviceMemoryPool::trim, D(DeviceMemoryPool, trim))
+        .def_static("size_class", &DeviceMemoryPool::size_class, "size"_a,
+            D(DeviceMemoryPool, size_class))
+        .def_static("stats", &DeviceMemoryPool::stats, D(DeviceMemoryPool, stats))
+        .def_static("reset_stats", &DeviceMemoryPool::reset_stats,
+            D(DeviceMemoryPool, reset_stats));
+}
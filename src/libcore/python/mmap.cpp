@@ -4,11 +4,19 @@
 #include <mitsuba/python/python.h>
 
 MTS_PY_EXPORT(MemoryMappedFile) {
-    MTS_PY_CLASS(MemoryMappedFile, Object, py::buffer_protocol())
-        .def(py::init<const mitsuba::filesystem::path &, size_t>(),
+    auto mmap = MTS_PY_CLASS(MemoryMappedFile, Object, py::buffer_protocol());
+
+    py::enum_<MemoryMappedFile::Access>(mmap, "Access", D(MemoryMappedFile, Access))
+        .value("Normal", MemoryMappedFile::Access::Normal, D(MemoryMappedFile, Access, Normal))
+        .value("Sequential", MemoryMappedFile::Access::Sequential,
+            D(MemoryMappedFile, Access, Sequential))
+        .value("Random", MemoryMappedFile::Access::Random, D(MemoryMappedFile, Access, Random));
+
+    mmap.def(py::init<const mitsuba::filesystem::path &, size_t>(),
             D(MemoryMappedFile, MemoryMappedFile), "filename"_a, "size"_a)
-        .def(py::init<const mitsuba::filesystem::path &, bool>(),
-            D(MemoryMappedFile, MemoryMappedFile, 2), "filename"_a, "write"_a = false)
+        .def(py::init<const mitsuba::filesystem::path &, bool, bool>(),
+            D(MemoryMappedFile, MemoryMappedFile, 2), "filename"_a, "write"_a = false,
+            "populate"_a = false)
         .def(py::init([](const mitsuba::filesystem::path &p, py::array array) {
             size_t size = array.size() * array.itemsize();
             auto m = new MemoryMappedFile(p, size);
@@ -20,7 +28,14 @@ MTS_PY_EXPORT(MemoryMappedFile) {
         .def("resize", &MemoryMappedFile::resize, D(MemoryMappedFile, resize))
         .def("filename", &MemoryMappedFile::filename, D(MemoryMappedFile, filename))
         .def("can_write", &MemoryMappedFile::can_write, D(MemoryMappedFile, can_write))
+        .def("advise", &MemoryMappedFile::advise, "access"_a, D(MemoryMappedFile, advise))
+        .def("prefetch", &MemoryMappedFile::prefetch, "offset"_a = 0,
+            "size"_a = (size_t) -1, D(MemoryMappedFile, prefetch))
         .def_static("create_temporary", &MemoryMappedFile::create_temporary, D(MemoryMappedFile, create_temporary))
+        .def_static("create_anonymous", &MemoryMappedFile::create_anonymous,
+            "size"_a, "huge_pages"_a = true, D(MemoryMappedFile, create_anonymous))
+        .def_static("map_copy_on_write", &MemoryMappedFile::map_copy_on_write,
+            "filename"_a, D(MemoryMappedFile, map_copy_on_write))
         .def_buffer([](MemoryMappedFile &m) -> py::buffer_info {
             return py::buffer_info(
                 m.data(),
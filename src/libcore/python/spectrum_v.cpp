@@ -21,6 +21,9 @@ MTS_PY_EXPORT(Spectrum) {
         D(sample_rgb_spectrum))
     .def("sample_rgb_spectrum", vectorize(&sample_rgb_spectrum<Spectrum>), "sample"_a,
         D(sample_rgb_spectrum))
+    .def("sample_rgb_spectrum_xyz", vectorize([](Float sample, Mask active) {
+            return sample_rgb_spectrum_xyz(sample, active);
+        }), "sample"_a, "active"_a = true, D(sample_rgb_spectrum_xyz))
     .def("pdf_rgb_spectrum", vectorize(&pdf_rgb_spectrum<Float>), "wavelengths"_a,
         D(pdf_rgb_spectrum))
     .def("pdf_rgb_spectrum", vectorize(&pdf_rgb_spectrum<Spectrum>), "wavelengths"_a,
@@ -0,0 +1,25 @@
+#include <mitsuba/core/statistics.h>
+#include <mitsuba/python/python.h>
+
+MTS_PY_EXPORT(Statistics) {
+    py::enum_<StatsCounter>(m, "StatsCounter", D(StatsCounter))
+        .value("Rays", StatsCounter::Rays, D(StatsCounter, Rays))
+        .value("ShadowRays", StatsCounter::ShadowRays, D(StatsCounter, ShadowRays))
+        .value("KDTreeNodes", StatsCounter::KDTreeNodes, D(StatsCounter, KDTreeNodes))
+        .value("PrimitiveTests", StatsCounter::PrimitiveTests, D(StatsCounter, PrimitiveTests))
+        .value("NullCollisions", StatsCounter::NullCollisions, D(StatsCounter, NullCollisions))
+        .value("RRTerminations", StatsCounter::RRTerminations, D(StatsCounter, RRTerminations));
+
+    py::enum_<StatsHistogram>(m, "StatsHistogram", D(StatsHistogram))
+        .value("PathLength", StatsHistogram::PathLength, D(StatsHistogram, PathLength));
+
+    py::class_<Statistics>(m, "Statistics", D(Statistics))
+        .def_static("enabled", &Statistics::enabled, D(Statistics, enabled))
+        .def_static("counter", &Statistics::counter, "counter"_a, D(Statistics, counter))
+        .def_static("histogram", &Statistics::histogram, "histogram"_a,
+            D(Statistics, histogram))
+        .def_static("reset", &Statistics::reset, D(Statistics, reset))
+        .def_static("report", &Statistics::report, D(Statistics, report))
+        .def_static("print_report", &Statistics::print_report, "level"_a = Info,
+            D(Statistics, print_report));
+}
@@ -1,4 +1,5 @@
 #include <mitsuba/core/stream.h>
+#include <mitsuba/core/afstream.h>
 #include <mitsuba/core/dstream.h>
 #include <mitsuba/core/fstream.h>
 #include <mitsuba/core/mstream.h>
@@ -89,6 +90,16 @@ MTS_PY_EXPORT(FileStream) {
         "p"_a, "mode"_a = FileStream::ERead, D(FileStream, FileStream));
 }
 
+MTS_PY_EXPORT(AsyncFileStream) {
+    MTS_PY_CLASS(AsyncFileStream, Stream)
+        .def(py::init<const mitsuba::filesystem::path &, size_t, size_t>(),
+            "p"_a, "block_size"_a = 1024 * 1024, "block_count"_a = 4,
+            D(AsyncFileStream, AsyncFileStream))
+        .def_method(AsyncFileStream, path)
+        .def_method(AsyncFileStream, block_size)
+        .def_method(AsyncFileStream, block_count);
+}
+
 MTS_PY_EXPORT(MemoryStream) {
     MTS_PY_CLASS(MemoryStream, Stream)
         .def(py::init<size_t>(), D(MemoryStream, MemoryStream),
@@ -103,14 +114,18 @@ MTS_PY_EXPORT(ZStream) {
     py::enum_<ZStream::EStreamType>(c, "EStreamType", D(ZStream, EStreamType))
         .value("EDeflateStream", ZStream::EDeflateStream, D(ZStream, EStreamType, EDeflateStream))
         .value("EGZipStream", ZStream::EGZipStream, D(ZStream, EStreamType, EGZipStream))
+        .value("EZstdStream", ZStream::EZstdStream, D(ZStream, EStreamType, EZstdStream))
         .export_values();
 
 
-    c.def(py::init<Stream*, ZStream::EStreamType, int>(), D(ZStream, ZStream),
+    c.def(py::init<Stream*, ZStream::EStreamType, int, int>(), D(ZStream, ZStream),
         "child_stream"_a,
         "stream_type"_a = ZStream::EDeflateStream,
-        "level"_a = -1)
+        "level"_a = -1,
+        "threads"_a = 1)
         .def("child_stream", [](ZStream &stream) {
             return py::cast(stream.child_stream());
-        }, D(ZStream, child_stream));
+        }, D(ZStream, child_stream))
+        .def_method(ZStream, stream_type)
+        .def_static_method(ZStream, has_zstd);
 }
@@ -84,6 +84,12 @@ MTS_PY_EXPORT(Thread) {
        .def_method(Thread, priority)
        .def_method(Thread, set_core_affinity)
        .def_method(Thread, core_affinity)
+       .def_method(Thread, set_numa_node, "node"_a)
+       .def_method(Thread, numa_node)
+       .def_static_method(Thread, current_numa_node)
+       .def_static_method(Thread, numa_node_count)
+       .def_static_method(Thread, set_numa_pinning, "value"_a)
+       .def_static_method(Thread, numa_pinning)
        .def_method(Thread, set_critical)
        .def_method(Thread, is_critical)
        .def_method(Thread, set_name)
@@ -108,5 +114,13 @@ MTS_PY_EXPORT(Thread) {
         .def(py::init<const ThreadEnvironment &>())
         .def("__enter__", &PyScopedSetThreadEnvironment::enter)
         .def("__exit__", &PyScopedSetThreadEnvironment::exit);
+
+    py::class_<ThreadPool, Object, ref<ThreadPool>>(m, "ThreadPool", D(ThreadPool))
+        .def(py::init<size_t, const std::vector<int> &>(), "thread_count"_a = 0,
+             "cores"_a = std::vector<int>(), D(ThreadPool, ThreadPool))
+        .def_method(ThreadPool, thread_count)
+        .def_method(ThreadPool, cores)
+        .def_static_method(ThreadPool, current)
+        .def_static_method(ThreadPool, parse_cores, "str"_a);
 }
 
@@ -0,0 +1,24 @@
+#include <mitsuba/core/tilecache.h>
+#include <mitsuba/python/python.h>
+
+MTS_PY_EXPORT(TileCache) {
+    MTS_PY_CLASS(TiledImage, Object)
+        .def(py::init<const mitsuba::filesystem::path &>(), "filename"_a,
+            D(TiledImage, TiledImage))
+        .def("level_count", &TiledImage::level_count, D(TiledImage, level_count))
+        .def("level_size", &TiledImage::level_size, "level"_a, D(TiledImage, level_size))
+        .def("channel_count", &TiledImage::channel_count, D(TiledImage, channel_count))
+        .def("tile_size", &TiledImage::tile_size, D(TiledImage, tile_size))
+        .def("tag", &TiledImage::tag, D(TiledImage, tag));
+
+    MTS_PY_CLASS(TileCache, Object)
+        .def_static("instance", &TileCache::instance, py::return_value_policy::reference,
+            D(TileCache, instance))
+        .def("set_capacity", &TileCache::set_capacity, "capacity"_a,
+            D(TileCache, set_capacity))
+        .def("capacity", &TileCache::capacity, D(TileCache, capacity))
+        .def("size", &TileCache::size, D(TileCache, size))
+        .def("hit_count", &TileCache::hit_count, D(TileCache, hit_count))
+        .def("miss_count", &TileCache::miss_count, D(TileCache, miss_count))
+        .def("clear", [](TileCache &cache) { cache.clear(); }, D(TileCache, clear));
+}
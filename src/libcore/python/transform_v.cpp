@@ -128,6 +128,49 @@ void bind_transform4f(py::module &m, const char *name) {
     bind_slicing_operators<Transform4f, ScalarTransform4f>(trans4);
 }
 
+template <typename Float>
+void bind_affine_transform4f(py::module &m, const char *name) {
+    MTS_IMPORT_CORE_TYPES()
+    using Kind = typename AffineTransform4f::Kind;
+
+    auto affine = py::class_<AffineTransform4f>(m, name, D(AffineTransform))
+        .def(py::init<>(), D(AffineTransform, AffineTransform))
+        .def(py::init<const AffineTransform4f &>(), "Copy constructor")
+        .def(py::init<const Matrix3f &, const Vector3f &>(), "linear"_a, "translation"_a,
+             D(AffineTransform, AffineTransform, 2))
+        .def(py::init<const Transform4f &>(), "trafo"_a, D(AffineTransform, AffineTransform, 3))
+        .def("transform_point",
+            [](const AffineTransform4f &t, const Point3f &v) {
+                return t*v;
+            })
+        .def("transform_vector",
+            [](const AffineTransform4f &t, const Vector3f &v) {
+                return t*v;
+            })
+        .def("transform_normal",
+            [](const AffineTransform4f &t, const Normal3f &v) {
+                return t*v;
+            }, D(AffineTransform, operator_mul, 4))
+        .def("inverse", &AffineTransform4f::inverse, D(AffineTransform, inverse))
+        .def("to_transform", &AffineTransform4f::to_transform, D(AffineTransform, to_transform))
+        .def("has_scale", &AffineTransform4f::has_scale, D(AffineTransform, has_scale))
+        /// Operators
+        .def(py::self == py::self)
+        .def(py::self != py::self)
+        .def(py::self * py::self)
+        /// Fields
+        .def_readwrite("linear", &AffineTransform4f::linear)
+        .def_readwrite("translation", &AffineTransform4f::translation)
+        .def_readonly("scale", &AffineTransform4f::scale, D(AffineTransform, scale))
+        .def_readonly("kind", &AffineTransform4f::kind)
+        .def_repr(AffineTransform4f);
+
+    py::enum_<Kind>(affine, "Kind", D(AffineTransform, Kind))
+        .value("Rigid", Kind::Rigid, D(AffineTransform, Kind, Rigid))
+        .value("UniformScale", Kind::UniformScale, D(AffineTransform, Kind, UniformScale))
+        .value("General", Kind::General, D(AffineTransform, Kind, General));
+}
+
 MTS_PY_EXPORT(Transform) {
     MTS_PY_IMPORT_TYPES_DYNAMIC()
 
@@ -155,6 +198,10 @@ MTS_PY_EXPORT(Transform) {
 
     py::implicitly_convertible<py::array, Transform4f>();
     py::implicitly_convertible<Matrix4f, Transform4f>();
+
+    MTS_PY_CHECK_ALIAS(ScalarAffineTransform4f, "ScalarAffineTransform4f") {
+        bind_affine_transform4f<ScalarFloat>(m, "ScalarAffineTransform4f");
+    }
 }
 
 MTS_PY_EXPORT(AnimatedTransform) {
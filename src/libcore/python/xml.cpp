@@ -0,0 +1,11 @@
+#include <mitsuba/core/xml.h>
+#include <mitsuba/python/python.h>
+
+MTS_PY_EXPORT(InstanceCache) {
+    using xml::InstanceCache;
+    py::class_<InstanceCache, Object, ref<InstanceCache>>(m, "InstanceCache", D(xml, InstanceCache))
+        .def(py::init<>(), D(xml, InstanceCache, InstanceCache))
+        .def("reused", &InstanceCache::reused, D(xml, InstanceCache, reused))
+        .def("updated", &InstanceCache::updated, D(xml, InstanceCache, updated))
+        .def("created", &InstanceCache::created, D(xml, InstanceCache, created));
+}
@@ -22,7 +22,8 @@ MTS_PY_EXPORT(xml) {
 
     m.def(
         "load_file",
-        [](const std::string &name, bool update_scene, py::kwargs kwargs) {
+        [](const std::string &name, bool update_scene, xml::InstanceCache *cache,
+           py::kwargs kwargs) {
             xml::ParameterList param;
             if (kwargs) {
                 for (auto [k, v] : kwargs)
@@ -31,10 +32,15 @@ MTS_PY_EXPORT(xml) {
                         (std::string) py::str(v)
                     );
             }
-            py::gil_scoped_release release;
-            return cast_object(xml::load_file(name, GET_VARIANT(), param, update_scene));
+            ref<Object> obj;
+            /* scope */ {
+                // Python plugins re-acquire the GIL when they are instantiated
+                py::gil_scoped_release release;
+                obj = xml::load_file(name, GET_VARIANT(), param, update_scene, cache);
+            }
+            return cast_object(obj);
         },
-        "path"_a, "update_scene"_a = false, D(xml, load_file));
+        "path"_a, "update_scene"_a = false, "cache"_a = nullptr, D(xml, load_file));
 
     m.def(
         "load_string",
@@ -47,11 +53,21 @@ MTS_PY_EXPORT(xml) {
                         (std::string) py::str(v)
                     );
             }
-            py::gil_scoped_release release;
-            return cast_object(xml::load_string(name, GET_VARIANT(), param));
+            ref<Object> obj;
+            /* scope */ {
+                py::gil_scoped_release release;
+                obj = xml::load_string(name, GET_VARIANT(), param);
+            }
+            return cast_object(obj);
         },
         "string"_a, D(xml, load_string));
 
+    m.def("set_cache_dir", &xml::set_cache_dir, "path"_a, D(xml, set_cache_dir));
+    m.def("cache_dir", &xml::cache_dir, D(xml, cache_dir));
+    m.def("set_deduplication", &xml::set_deduplication, "enabled"_a,
+          D(xml, set_deduplication));
+    m.def("deduplication", &xml::deduplication, D(xml, deduplication));
+
     m.def(
         "load_dict",
         [](const py::dict dict) {
@@ -262,8 +278,12 @@ ref<Object> load_dict(const py::dict &dict, std::map<std::string, ref<Object>> &
         Throw("Unkown value type: %s", value.get_type());
     }
 
-    // Construct the object with the parsed Properties
-    auto obj = PluginManager::instance()->create_object(props, class_);
+    // Construct the object with the parsed Properties (e.g. a scene that builds its BVH)
+    ref<Object> obj;
+    /* scope */ {
+        py::gil_scoped_release release;
+        obj = PluginManager::instance()->create_object(props, class_);
+    }
 
     if (!props.unqueried().empty())
         Throw("Unreferenced attribute %s in %s", props.unqueried()[0], type);
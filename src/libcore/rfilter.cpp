@@ -17,6 +17,30 @@ MTS_VARIANT void ReconstructionFilter<Float, Spectrum>::init_discretization() {
     m_values[MTS_FILTER_RESOLUTION] = 0;
     m_scale_factor = MTS_FILTER_RESOLUTION / m_radius;
     m_border_size = (int) std::ceil(m_radius - .5f - 2.f * math::RayEpsilon<ScalarFloat>);
+
+    /* Tabulate the intervals of the discretized filter proportionally to the
+       magnitude of their values. Samples within negative lobes receive a
+       negative weight, and all weights are scaled so that their expected
+       value matches the normalized filter. */
+    std::vector<ScalarFloat> cdf(MTS_FILTER_RESOLUTION + 1), weight(MTS_FILTER_RESOLUTION);
+    ScalarFloat sum = 0, sum_abs = 0;
+    cdf[0] = 0;
+    for (size_t i = 0; i < MTS_FILTER_RESOLUTION; ++i) {
+        sum += m_values[i];
+        sum_abs += std::abs(m_values[i]);
+        cdf[i + 1] = sum_abs;
+    }
+
+    ScalarFloat normalization = sum > 0 ? sum_abs / sum : 1;
+    for (size_t i = 0; i < MTS_FILTER_RESOLUTION; ++i) {
+        if (sum_abs > 0)
+            cdf[i + 1] /= sum_abs;
+        weight[i] = m_values[i] < 0 ? -normalization : normalization;
+    }
+    cdf[MTS_FILTER_RESOLUTION] = 1;
+
+    m_sample_cdf = DynamicBuffer<Float>::copy(cdf.data(), cdf.size());
+    m_sample_weight = DynamicBuffer<Float>::copy(weight.data(), weight.size());
 }
 
 std::ostream &operator<<(std::ostream &os, const FilterBoundaryCondition &value) {
@@ -1,6 +1,7 @@
 #include <mitsuba/core/fresolver.h>
 #include <mitsuba/core/fstream.h>
 #include <mitsuba/core/spectrum.h>
+#include <array>
 
 NAMESPACE_BEGIN(mitsuba)
 
@@ -107,7 +108,7 @@ spectrum_to_rgb(const std::vector<double> &wavelengths,
 // =======================================================================
 using Float = float;
 
-static const Float cie1931_tbl[MTS_CIE_SAMPLES * 3] = {
+static constexpr Float cie1931_tbl[MTS_CIE_SAMPLES * 3] = {
     Float(0.000129900000), Float(0.000232100000), Float(0.000414900000), Float(0.000741600000),
     Float(0.001368000000), Float(0.002236000000), Float(0.004243000000), Float(0.007650000000),
     Float(0.014310000000), Float(0.023190000000), Float(0.043510000000), Float(0.077630000000),
@@ -188,6 +189,21 @@ const Float *cie1931_x_data = cie1931_tbl;
 const Float *cie1931_y_data = cie1931_tbl + MTS_CIE_SAMPLES;
 const Float *cie1931_z_data = cie1931_tbl + MTS_CIE_SAMPLES * 2;
 
+/// Interleave the X, Y, and Z tables into groups of 4 entries (at compile time)
+static constexpr std::array<Float, MTS_CIE_SAMPLES * 4> cie1931_interleave() {
+    std::array<Float, MTS_CIE_SAMPLES * 4> result { };
+    for (size_t i = 0; i < MTS_CIE_SAMPLES; ++i) {
+        for (size_t j = 0; j < 3; ++j)
+            result[i * 4 + j] = cie1931_tbl[i + j * MTS_CIE_SAMPLES];
+        result[i * 4 + 3] = Float(0);
+    }
+    return result;
+}
+
+alignas(16) static constexpr std::array<Float, MTS_CIE_SAMPLES * 4> cie1931_xyzw_tbl =
+    cie1931_interleave();
+
+const Float *cie1931_xyzw_data = cie1931_xyzw_tbl.data();
 
 void cie_alloc() {
 #if defined(MTS_ENABLE_OPTIX)
@@ -201,6 +217,12 @@ void cie_alloc() {
     cie1931_x_data = src;
     cie1931_y_data = src + MTS_CIE_SAMPLES;
     cie1931_z_data = src + MTS_CIE_SAMPLES * 2;
+
+    const size_t size_xyzw = MTS_CIE_SAMPLES * 4 * sizeof(Float);
+    Float *src_xyzw = (Float *) cuda_managed_malloc(size_xyzw);
+    memcpy(src_xyzw, cie1931_xyzw_tbl.data(), size_xyzw);
+    cie1931_xyzw_data = src_xyzw;
+
     cie_alloc_done = true;
 #endif
 }
@@ -0,0 +1,103 @@
+#include <mitsuba/core/statistics.h>
+#include <memory>
+#include <mutex>
+#include <sstream>
+
+NAMESPACE_BEGIN(mitsuba)
+
+/* The storage of a thread is never released, so that the counts of threads
+   that exit before the statistics are queried are not lost */
+static std::mutex stats_mutex;
+static std::vector<std::unique_ptr<StatsStorage>> stats_threads;
+
+#if defined(MTS_ENABLE_STATISTICS)
+static thread_local StatsStorage *stats_local = nullptr;
+
+StatsStorage *stats_storage() {
+    if (unlikely(!stats_local)) {
+        std::lock_guard<std::mutex> guard(stats_mutex);
+        stats_threads.emplace_back(new StatsStorage());
+        stats_local = stats_threads.back().get();
+    }
+    return stats_local;
+}
+#endif
+
+uint64_t Statistics::counter(StatsCounter counter) {
+    std::lock_guard<std::mutex> guard(stats_mutex);
+    uint64_t result = 0;
+    for (const auto &storage : stats_threads)
+        result += storage->counters[int(counter)];
+    return result;
+}
+
+std::vector<uint64_t> Statistics::histogram(StatsHistogram histogram) {
+    std::lock_guard<std::mutex> guard(stats_mutex);
+    std::vector<uint64_t> result(MTS_STATS_HISTOGRAM_BINS, 0);
+    for (const auto &storage : stats_threads)
+        for (size_t i = 0; i < MTS_STATS_HISTOGRAM_BINS; ++i)
+            result[i] += storage->histograms[int(histogram)][i];
+    return result;
+}
+
+void Statistics::reset() {
+    std::lock_guard<std::mutex> guard(stats_mutex);
+    for (auto &storage : stats_threads)
+        *storage = StatsStorage();
+}
+
+std::string Statistics::report() {
+    if (!stats_enabled)
+        return "Statistics: disabled (compile with MTS_ENABLE_STATISTICS).\n";
+
+    std::ostringstream oss;
+    oss << "Statistics:" << std::endl;
+
+    uint64_t counters[int(StatsCounter::StatsCounterCount)];
+    for (int i = 0; i < int(StatsCounter::StatsCounterCount); ++i) {
+        counters[i] = counter(StatsCounter(i));
+        std::string name = stats_counter_id[i];
+        oss << "   " << name << std::string(32 - name.length(), ' ') << counters[i];
+        if (StatsCounter(i) == StatsCounter::KDTreeNodes ||
+            StatsCounter(i) == StatsCounter::PrimitiveTests) {
+            uint64_t rays = counters[int(StatsCounter::Rays)] +
+                            counters[int(StatsCounter::ShadowRays)];
+            if (rays > 0)
+                oss << tfm::format(" (%.2f per ray)", counters[i] / double(rays));
+        }
+        oss << std::endl;
+    }
+
+    for (int i = 0; i < int(StatsHistogram::StatsHistogramCount); ++i) {
+        std::vector<uint64_t> bins = histogram(StatsHistogram(i));
+        uint64_t total = 0, last = 0;
+        for (size_t j = 0; j < bins.size(); ++j) {
+            total += bins[j];
+            if (bins[j] > 0)
+                last = j;
+        }
+        if (total == 0)
+            continue;
+
+        oss << "   " << stats_histogram_id[i] << ":" << std::endl;
+        for (size_t j = 0; j <= last; ++j) {
+            std::string label = std::to_string(j);
+            if (j + 1 == bins.size())
+                label += "+";
+            oss << "      " << label << std::string(8 - label.length(), ' ')
+                << tfm::format("%-14i(%.2f%%)", bins[j], bins[j] * 100.0 / total)
+                << std::endl;
+        }
+    }
+
+    return oss.str();
+}
+
+void Statistics::print_report(LogLevel level) {
+    std::string str = report();
+    if (!str.empty() && str.back() == '\n')
+        str.pop_back();
+    Log(level, "%s", str);
+}
+
+NAMESPACE_END(mitsuba)
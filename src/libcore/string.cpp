@@ -1,5 +1,9 @@
 #include <mitsuba/core/string.h>
 #include <mitsuba/core/object.h>
+#include <cstring>
+#include <limits>
+#include <locale>
+#include <sstream>
 
 NAMESPACE_BEGIN(mitsuba)
 NAMESPACE_BEGIN(string)
@@ -59,5 +63,132 @@ bool contains(const std::vector<std::string> &keys, const std::string &key) {
     return false;
 }
 
+/// Convert the well-formed decimal number [begin, end) using the "C" locale
+static float parse_float_classic(const char *begin, const char *end) {
+    std::istringstream is(std::string(begin, end));
+    is.imbue(std::locale::classic());
+    float value = 0.f;
+    is >> value;
+    // The stream only fails when the number overflows
+    return is.fail() ? std::numeric_limits<float>::infinity() : value;
+}
+
+/// Case-insensitive check whether \c str starts with the lower-case \c prefix
+static bool starts_with_nocase(const char *str, const char *prefix) {
+    for (; *prefix; ++str, ++prefix) {
+        if ((*str | 0x20) != *prefix)
+            return false;
+    }
+    return true;
+}
+
+float parse_float(const char *str, char **end) {
+    // Powers of ten that are exactly representable in single/double precision
+    static const float  pow10_f[] = { 1e0f, 1e1f, 1e2f, 1e3f, 1e4f, 1e5f,
+                                      1e6f, 1e7f, 1e8f, 1e9f, 1e10f };
+    static const double pow10_d[] = { 1e0,  1e1,  1e2,  1e3,  1e4,  1e5,
+                                      1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+                                      1e12, 1e13, 1e14, 1e15, 1e16, 1e17,
+                                      1e18, 1e19, 1e20, 1e21, 1e22 };
+
+    const char *ptr = str;
+    while (*ptr == ' ' || *ptr == '\t')
+        ++ptr;
+
+    bool negative = *ptr == '-';
+    if (*ptr == '-' || *ptr == '+')
+        ++ptr;
+    const char *number = ptr;
+
+    uint64_t mantissa = 0;
+    int digits = 0, exponent = 0;
+    bool has_digits = false, truncated = false;
+    auto is_digit = [](char c) { return c >= '0' && c <= '9'; };
+
+    for (; is_digit(*ptr); ++ptr) {
+        has_digits = true;
+        if (digits < 19) {
+            mantissa = mantissa * 10 + (uint64_t) (*ptr - '0');
+            digits += mantissa != 0;
+        } else {
+            truncated |= *ptr != '0';
+            exponent++;
+        }
+    }
+
+    if (*ptr == '.') {
+        for (++ptr; is_digit(*ptr); ++ptr) {
+            has_digits = true;
+            if (digits < 19) {
+                mantissa = mantissa * 10 + (uint64_t) (*ptr - '0');
+                digits += mantissa != 0;
+                exponent--;
+            } else {
+                truncated |= *ptr != '0';
+            }
+        }
+    }
+
+    // Special values and malformed input
+    if (!has_digits) {
+        float result;
+        if (starts_with_nocase(ptr, "nan")) {
+            result = std::numeric_limits<float>::quiet_NaN();
+            ptr += 3;
+        } else if (starts_with_nocase(ptr, "inf")) {
+            result = std::numeric_limits<float>::infinity();
+            ptr += starts_with_nocase(ptr, "infinity") ? 8 : 3;
+        } else {
+            if (end)
+                *end = (char *) str;
+            return 0.f;
+        }
+        if (end)
+            *end = (char *) ptr;
+        return negative ? -result : result;
+    }
+
+    if (*ptr == 'e' || *ptr == 'E') {
+        const char *exp_ptr = ptr + 1;
+        bool exp_negative = *exp_ptr == '-';
+        if (*exp_ptr == '-' || *exp_ptr == '+')
+            ++exp_ptr;
+        if (is_digit(*exp_ptr)) {
+            int value = 0;
+            for (; is_digit(*exp_ptr); ++exp_ptr)
+                value = std::min(value * 10 + (*exp_ptr - '0'), 100000);
+            exponent += exp_negative ? -value : value;
+            ptr = exp_ptr;
+        }
+    }
+
+    float result;
+    if (mantissa == 0) {
+        result = 0.f;
+    } else if (!truncated && mantissa <= (1ull << 24) && exponent >= -10 && exponent <= 10) {
+        // Both operands are exact, hence the result is correctly rounded
+        float value = (float) mantissa;
+        result = exponent < 0 ? value / pow10_f[-exponent] : value * pow10_f[exponent];
+    } else if (!truncated && mantissa <= (1ull << 53) && exponent >= -22 && exponent <= 22) {
+        double value = (double) mantissa;
+        value = exponent < 0 ? value / pow10_d[-exponent] : value * pow10_d[exponent];
+
+        /* The double is correctly rounded, but rounding it once more would
+           be wrong when it lies exactly halfway between two floats */
+        uint64_t bits;
+        memcpy(&bits, &value, sizeof(double));
+        if ((bits & 0x1FFFFFFFull) == 0x10000000ull)
+            result = parse_float_classic(number, ptr);
+        else
+            result = (float) value;
+    } else {
+        result = parse_float_classic(number, ptr);
+    }
+
+    if (end)
+        *end = (char *) ptr;
+    return negative ? -result : result;
+}
+
 NAMESPACE_END(string)
 NAMESPACE_END(mitsuba)
@@ -1206,6 +1206,7 @@ size_t hash(const Struct::Field &f) {
     value = hash_combine(value, hash(f.offset));
     value = hash_combine(value, hash(f.flags));
     value = hash_combine(value, hash(f.default_));
+    value = hash_combine(value, hash(f.blend));
     return value;
 }
 
@@ -1214,10 +1215,137 @@ size_t hash(const Struct &s) {
                         hash(s.m_byte_order));
 }
 
-static std::unordered_map<
-           std::pair<ref<const Struct>, ref<const Struct>>, void *,
-    hasher<std::pair<ref<const Struct>, ref<const Struct>>>,
-    comparator<std::pair<ref<const Struct>, ref<const Struct>>>> __cache;
+#if MTS_STRUCTCONVERTER_USE_JIT == 1
+/// Key of the process-wide cache of compiled conversion routines
+struct ConverterKey {
+    /* Private copies, since the caller may still modify its
+       Struct instances after constructing the converter */
+    ref<const Struct> source;
+    ref<const Struct> target;
+    bool dither;
+
+    bool operator==(const ConverterKey &k) const {
+        return *source == *k.source && *target == *k.target && dither == k.dither;
+    }
+};
+
+struct ConverterKeyHasher {
+    size_t operator()(const ConverterKey &k) const {
+        return hash_combine(hash_combine(hash(*k.source), hash(*k.target)),
+                            hash(k.dither));
+    }
+};
+
+static std::unordered_map<ConverterKey, void *, ConverterKeyHasher> __cache;
+
+#if defined(ENOKI_X86_AVX2) && defined(__F16C__)
+NAMESPACE_BEGIN(detail)
+/**
+ * Check whether a conversion only changes the representation of a sequence of
+ * uniformly typed single or half precision values, which is vectorized
+ */
+static bool is_bulk_conversion(const Struct *source, const Struct *target) {
+    uint32_t allowed_flags = Struct::Flags::Normalized | Struct::Flags::Alpha |
+                             Struct::Flags::PremultipliedAlpha | Struct::Flags::Weight;
+
+    if (source->field_count() == 0 || source->field_count() != target->field_count() ||
+        source->byte_order() != Struct::host_byte_order() ||
+        target->byte_order() != Struct::host_byte_order())
+        return false;
+
+    auto is_half_or_single = [](Struct::Type type) {
+        return type == Struct::Type::Float16 || type == Struct::Type::Float32;
+    };
+
+    Struct::Type source_type = (*source)[0].type, target_type = (*target)[0].type;
+    if (!is_half_or_single(source_type) || !is_half_or_single(target_type))
+        return false;
+
+    for (size_t i = 0; i < source->field_count(); ++i) {
+        const Struct::Field &fs = (*source)[i], &ft = (*target)[i];
+        if (fs.name != ft.name || fs.type != source_type || ft.type != target_type ||
+            fs.offset != i * fs.size || ft.offset != i * ft.size ||
+            fs.flags != ft.flags || (fs.flags & ~allowed_flags) != 0 ||
+            !ft.blend.empty())
+            return false;
+    }
+
+    return source->size() == source->field_count() * (*source)[0].size &&
+           target->size() == target->field_count() * (*target)[0].size;
+}
+
+/// Emit a vectorized loop converting the values of \ref is_bulk_conversion()
+static void compile_bulk_conversion(X86Compiler &cc, const Struct *source,
+                                    const Struct *target, const X86Gp &width,
+                                    const X86Gp &height, const X86Gp &input,
+                                    const X86Gp &output) {
+    Struct::Type source_type = (*source)[0].type, target_type = (*target)[0].type;
+    uint32_t source_size = (*source)[0].size, target_size = (*target)[0].size;
+
+    Label loop_8 = cc.newLabel(), loop_1 = cc.newLabel(), done = cc.newLabel();
+
+    // Process the image as one sequence of values
+    X86Gp count = cc.newUInt64("count");
+    cc.mov(count, width);
+    cc.imul(count, height);
+    cc.imul(count, count, Imm(source->field_count()));
+
+    // Convert 8 values at a time
+    cc.bind(loop_8);
+    cc.cmp(count, Imm(8));
+    cc.jb(loop_1);
+
+    X86Ymm value = cc.newYmm();
+    if (source_type == Struct::Type::Float32)
+        cc.vmovups(value, x86::yword_ptr(input));
+    else
+        cc.vcvtph2ps(value, x86::xmmword_ptr(input));
+
+    if (target_type == Struct::Type::Float32)
+        cc.vmovups(x86::yword_ptr(output), value);
+    else
+        cc.vcvtps2ph(x86::xmmword_ptr(output), value, 0);
+
+    cc.add(input,  Imm(8 * source_size));
+    cc.add(output, Imm(8 * target_size));
+    cc.sub(count, Imm(8));
+    cc.jmp(loop_8);
+
+    // Remaining values
+    cc.bind(loop_1);
+    cc.test(count, count);
+    cc.jz(done);
+
+    X86Xmm scalar = cc.newXmm();
+    if (source_type == Struct::Type::Float32) {
+        cc.vmovss(scalar, x86::dword_ptr(input));
+    } else {
+        X86Gp temp = cc.newUInt32();
+        cc.movzx(temp.r32(), x86::word_ptr(input));
+        cc.vmovd(scalar, temp.r32());
+        cc.vcvtph2ps(scalar, scalar);
+    }
+
+    if (target_type == Struct::Type::Float32) {
+        cc.vmovss(x86::dword_ptr(output), scalar);
+    } else {
+        X86Xmm half = cc.newXmm();
+        X86Gp temp = cc.newUInt32();
+        cc.vcvtps2ph(half, scalar, 0);
+        cc.vmovd(temp.r32(), half);
+        cc.mov(x86::word_ptr(output), temp.r16());
+    }
+
+    cc.add(input,  Imm(source_size));
+    cc.add(output, Imm(target_size));
+    cc.dec(count);
+    cc.jmp(loop_1);
+
+    cc.bind(done);
+}
+NAMESPACE_END(detail)
+#endif
+#endif
 
 StructConverter::StructConverter(const Struct *source, const Struct *target, bool dither)
  : m_source(source), m_target(target) {
@@ -1228,7 +1356,7 @@ StructConverter::StructConverter(const Struct *source, const Struct *target, boo
     auto jit = Jit::get_instance();
     std::lock_guard<std::mutex> guard(jit->mutex);
 
-    auto key = std::make_pair(ref<const Struct>(source), ref<const Struct>(target));
+    ConverterKey key { source, target, dither };
     auto it = __cache.find(key);
 
     if (it != __cache.end()) {
@@ -1267,175 +1395,185 @@ StructConverter::StructConverter(const Struct *source, const Struct *target, boo
     Label loop_y_end = cc.newLabel();
     Label loop_fail  = cc.newLabel();
 
-    detail::StructCompiler sc(cc, x, y, dither, loop_fail);
+    bool has_assert = false, bulk = false;
+
+#if defined(ENOKI_X86_AVX2) && defined(__F16C__)
+    // Uniform arrays of single/half precision values are converted with a vectorized loop
+    bulk = detail::is_bulk_conversion(source, target);
+    if (bulk)
+        detail::compile_bulk_conversion(cc, source, target, width, height, input, output);
+#endif
 
-    cc.test(width, width);
-    cc.jz(loop_y_end);
-    cc.xor_(x, x);
+    if (!bulk) {
+        detail::StructCompiler sc(cc, x, y, dither, loop_fail);
 
-    cc.test(height, height);
-    cc.jz(loop_y_end);
-    cc.xor_(y, y);
+        cc.test(width, width);
+        cc.jz(loop_y_end);
+        cc.xor_(x, x);
 
-    cc.bind(loop_start);
+        cc.test(height, height);
+        cc.jz(loop_y_end);
+        cc.xor_(y, y);
 
-    bool has_assert = false;
-    // Ensure that fields with an EAssert flag are loaded
-    for (const Struct::Field &f : *source) {
-        if (has_flag(f.flags, Struct::Flags::Assert)) {
-            sc.load(source, input, f.name);
-            has_assert = true;
+        cc.bind(loop_start);
+
+        // Ensure that fields with an EAssert flag are loaded
+        for (const Struct::Field &f : *source) {
+            if (has_flag(f.flags, Struct::Flags::Assert)) {
+                sc.load(source, input, f.name);
+                has_assert = true;
+            }
         }
-    }
 
-    const Struct::Field *source_weight = nullptr;
-    const Struct::Field *target_weight = nullptr;
+        const Struct::Field *source_weight = nullptr;
+        const Struct::Field *target_weight = nullptr;
 
-    for (const Struct::Field &f : *source) {
-        if (!has_flag(f.flags, Struct::Flags::Weight))
-            continue;
-        if (source_weight != nullptr)
-            Throw("Internal error: source structure has more than one weight field!");
-        source_weight = &f;
-    }
+        for (const Struct::Field &f : *source) {
+            if (!has_flag(f.flags, Struct::Flags::Weight))
+                continue;
+            if (source_weight != nullptr)
+                Throw("Internal error: source structure has more than one weight field!");
+            source_weight = &f;
+        }
 
-    for (const Struct::Field &f : *target) {
-        if (!has_flag(f.flags, Struct::Flags::Weight))
-            continue;
-        if (target_weight != nullptr)
-            Throw("Internal error: target structure has more than one weight field!");
-        target_weight = &f;
-    }
+        for (const Struct::Field &f : *target) {
+            if (!has_flag(f.flags, Struct::Flags::Weight))
+                continue;
+            if (target_weight != nullptr)
+                Throw("Internal error: target structure has more than one weight field!");
+            target_weight = &f;
+        }
 
-    if (source_weight != nullptr && target_weight != nullptr) {
-        if (source_weight->name != target_weight->name)
-            Throw("Internal error: source and target weights have mismatched names!");
-    }
+        if (source_weight != nullptr && target_weight != nullptr) {
+            if (source_weight->name != target_weight->name)
+                Throw("Internal error: source and target weights have mismatched names!");
+        }
 
-    X86Xmm scale_factor;
-    if (source_weight != nullptr && target_weight == nullptr) {
-        scale_factor = cc.newXmm();
-        X86Xmm value = sc.linearize(sc.load(source, input, source_weight->name)).second.xmm;
-        sc.movs(scale_factor, sc.const_(1.0));
-        sc.divs(scale_factor, value);
-    }
+        X86Xmm scale_factor;
+        if (source_weight != nullptr && target_weight == nullptr) {
+            scale_factor = cc.newXmm();
+            X86Xmm value = sc.linearize(sc.load(source, input, source_weight->name)).second.xmm;
+            sc.movs(scale_factor, sc.const_(1.0));
+            sc.divs(scale_factor, value);
+        }
 
-    const Struct::Field *source_alpha = nullptr;
-    const Struct::Field *target_alpha = nullptr;
-    bool has_multiple_alpha_channels = false;
-    for (const Struct::Field &f : *source) {
-        if (!has_flag(f.flags, Struct::Flags::Alpha))
-            continue;
-        if (source_alpha != nullptr) {
-            has_multiple_alpha_channels = true;
-            break;
+        const Struct::Field *source_alpha = nullptr;
+        const Struct::Field *target_alpha = nullptr;
+        bool has_multiple_alpha_channels = false;
+        for (const Struct::Field &f : *source) {
+            if (!has_flag(f.flags, Struct::Flags::Alpha))
+                continue;
+            if (source_alpha != nullptr) {
+                has_multiple_alpha_channels = true;
+                break;
+            }
+            source_alpha = &f;
         }
-        source_alpha = &f;
-    }
 
-    for (const Struct::Field &f : *target) {
-        if (!has_flag(f.flags, Struct::Flags::Alpha))
-            continue;
-        target_alpha = &f;
-        break;
-    }
+        for (const Struct::Field &f : *target) {
+            if (!has_flag(f.flags, Struct::Flags::Alpha))
+                continue;
+            target_alpha = &f;
+            break;
+        }
 
-    if (source_alpha != nullptr && target_alpha != nullptr) {
-        if (source_alpha->name != target_alpha->name)
-            Throw("Internal error: source and target alpha have mismatched names!");
-    }
+        if (source_alpha != nullptr && target_alpha != nullptr) {
+            if (source_alpha->name != target_alpha->name)
+                Throw("Internal error: source and target alpha have mismatched names!");
+        }
 
-    X86Xmm alpha, inv_alpha;
-    if (source_alpha != nullptr && target_alpha != nullptr) {
-        alpha = cc.newXmm();
-        inv_alpha = cc.newXmm();
-        X86Xmm value = sc.linearize(sc.load(source, input, source_alpha->name)).second.xmm;
-        sc.movs(alpha, value);
-        sc.movs(inv_alpha, sc.const_(1.0));
-        sc.divs(inv_alpha, value);
-
-        // Check if alpha is zero and set inv_alpha to zero if that is the case
-        X86Xmm zero = cc.newXmm();
-        sc.movs(zero, sc.const_(0.0));
-
-        X86Xmm mask = cc.newXmm();
-        sc.movs(mask, value);
-        sc.cmps(mask, zero, 2);
-        sc.blend(inv_alpha, zero, mask);
-    }
+        X86Xmm alpha, inv_alpha;
+        if (source_alpha != nullptr && target_alpha != nullptr) {
+            alpha = cc.newXmm();
+            inv_alpha = cc.newXmm();
+            X86Xmm value = sc.linearize(sc.load(source, input, source_alpha->name)).second.xmm;
+            sc.movs(alpha, value);
+            sc.movs(inv_alpha, sc.const_(1.0));
+            sc.divs(inv_alpha, value);
+
+            // Check if alpha is zero and set inv_alpha to zero if that is the case
+            X86Xmm zero = cc.newXmm();
+            sc.movs(zero, sc.const_(0.0));
+
+            X86Xmm mask = cc.newXmm();
+            sc.movs(mask, value);
+            sc.cmps(mask, zero, 2);
+            sc.blend(inv_alpha, zero, mask);
+        }
 
 
-    for (const Struct::Field &f : *target) {
-        std::pair<detail::StructCompiler::Key, detail::StructCompiler::Value> kv;
-        if (f.blend.empty()) {
-            if (source->has_field(f.name)) {
-                kv = sc.load(source, input, f.name);
-            } else if (has_flag(f.flags, Struct::Flags::Default)) {
-                kv = sc.load_default(f);
+        for (const Struct::Field &f : *target) {
+            std::pair<detail::StructCompiler::Key, detail::StructCompiler::Value> kv;
+            if (f.blend.empty()) {
+                if (source->has_field(f.name)) {
+                    kv = sc.load(source, input, f.name);
+                } else if (has_flag(f.flags, Struct::Flags::Default)) {
+                    kv = sc.load_default(f);
+                } else {
+                    Throw("Unable to find field \"%s\"!", f.name);
+                }
             } else {
-                Throw("Unable to find field \"%s\"!", f.name);
-            }
-        } else {
-            X86Xmm accum = cc.newXmm();
-            for (size_t i = 0; i<f.blend.size(); ++i) {
-                kv = sc.linearize(sc.load(source, input, f.blend[i].second));
-                if (i == 0)
-                    sc.muls(accum, kv.second.xmm, sc.const_(f.blend[i].first));
-                else
-                    sc.fmadd231(accum, kv.second.xmm, sc.const_(f.blend[i].first));
+                X86Xmm accum = cc.newXmm();
+                for (size_t i = 0; i<f.blend.size(); ++i) {
+                    kv = sc.linearize(sc.load(source, input, f.blend[i].second));
+                    if (i == 0)
+                        sc.muls(accum, kv.second.xmm, sc.const_(f.blend[i].first));
+                    else
+                        sc.fmadd231(accum, kv.second.xmm, sc.const_(f.blend[i].first));
+                }
+                kv.first.name = "_" + f.name + "_blend";
+                kv.second.xmm = accum;
             }
-            kv.first.name = "_" + f.name + "_blend";
-            kv.second.xmm = accum;
-        }
-
-        uint32_t flag_mask = Struct::Flags::Normalized | Struct::Flags::Gamma;
-        if (!((kv.first.type == f.type || (Struct::is_integer(kv.first.type) &&
-                                           Struct::is_integer(f.type) &&
-                                           !has_flag(f.flags, Struct::Flags::Normalized))) &&
-            ((kv.first.flags & flag_mask) == (f.flags & flag_mask))))
-            kv = sc.linearize(kv);
 
-        if (source_weight != nullptr && target_weight == nullptr) {
-            X86Xmm result = cc.newXmm();
-            if (kv.first.type != struct_type_v<Float>)
+            uint32_t flag_mask = Struct::Flags::Normalized | Struct::Flags::Gamma;
+            if (!((kv.first.type == f.type || (Struct::is_integer(kv.first.type) &&
+                                               Struct::is_integer(f.type) &&
+                                               !has_flag(f.flags, Struct::Flags::Normalized))) &&
+                ((kv.first.flags & flag_mask) == (f.flags & flag_mask))))
                 kv = sc.linearize(kv);
-            sc.muls(result, kv.second.xmm, scale_factor);
-            kv.second.xmm = result;
-        }
 
-        uint32_t special_channels_mask = Struct::Flags::Weight | Struct::Flags::Alpha;
-        bool source_premult = has_flag(kv.first.flags, Struct::Flags::PremultipliedAlpha);
-        bool target_premult = has_flag(f.flags, Struct::Flags::PremultipliedAlpha);
-
-        if (source_alpha != nullptr && target_alpha != nullptr && ((f.flags & special_channels_mask) == 0) &&
-            source_premult != target_premult) {
-            if (has_multiple_alpha_channels)
-                Throw("Found multiple alpha channels: Alpha (un)premultiplication expects a single alpha channel");
-            X86Xmm result = cc.newXmm();
-            if (kv.first.type != struct_type_v<Float>)
-                kv = sc.linearize(kv);
-            if (target_premult && !source_premult) {
-                sc.muls(result, kv.second.xmm, alpha);
-                kv.second.xmm = result;
-            } else if (!target_premult && source_premult) {
-                sc.muls(result, kv.second.xmm, inv_alpha);
+            if (source_weight != nullptr && target_weight == nullptr) {
+                X86Xmm result = cc.newXmm();
+                if (kv.first.type != struct_type_v<Float>)
+                    kv = sc.linearize(kv);
+                sc.muls(result, kv.second.xmm, scale_factor);
                 kv.second.xmm = result;
             }
-        }
-        sc.save(target, output, f, kv);
-    }
 
-    cc.inc(x);
-    cc.add(input,  Imm(source->size()));
-    cc.add(output, Imm(target->size()));
-    cc.cmp(x, width);
-    cc.jne(loop_start);
+            uint32_t special_channels_mask = Struct::Flags::Weight | Struct::Flags::Alpha;
+            bool source_premult = has_flag(kv.first.flags, Struct::Flags::PremultipliedAlpha);
+            bool target_premult = has_flag(f.flags, Struct::Flags::PremultipliedAlpha);
+
+            if (source_alpha != nullptr && target_alpha != nullptr && ((f.flags & special_channels_mask) == 0) &&
+                source_premult != target_premult) {
+                if (has_multiple_alpha_channels)
+                    Throw("Found multiple alpha channels: Alpha (un)premultiplication expects a single alpha channel");
+                X86Xmm result = cc.newXmm();
+                if (kv.first.type != struct_type_v<Float>)
+                    kv = sc.linearize(kv);
+                if (target_premult && !source_premult) {
+                    sc.muls(result, kv.second.xmm, alpha);
+                    kv.second.xmm = result;
+                } else if (!target_premult && source_premult) {
+                    sc.muls(result, kv.second.xmm, inv_alpha);
+                    kv.second.xmm = result;
+                }
+            }
+            sc.save(target, output, f, kv);
+        }
 
-    cc.bind(loop_x_end);
-    cc.xor_(x, x);
-    cc.inc(y);
-    cc.cmp(y, height);
-    cc.jne(loop_start);
+        cc.inc(x);
+        cc.add(input,  Imm(source->size()));
+        cc.add(output, Imm(target->size()));
+        cc.cmp(x, width);
+        cc.jne(loop_start);
+
+        cc.bind(loop_x_end);
+        cc.xor_(x, x);
+        cc.inc(y);
+        cc.cmp(y, height);
+        cc.jne(loop_start);
+    }
 
     cc.bind(loop_y_end);
     auto rv = cc.newInt64("rv");
@@ -1458,6 +1596,8 @@ StructConverter::StructConverter(const Struct *source, const Struct *target, boo
        Log(Info, "Assembly:\n%s", logger.getString());
     #endif
 
+    key.source = new Struct(*source);
+    key.target = new Struct(*target);
     __cache[key] = (void *) m_func;
 #else
     m_dither = dither;
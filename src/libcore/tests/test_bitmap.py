@@ -76,6 +76,48 @@ def test_read_write_complex_exr(tmpdir):
     assert str(b3) != str(b1)
 
 
+
+@pytest.mark.parametrize('tile_size', [0, 2])
+@pytest.mark.parametrize('multi_part', [False, True])
+def test_read_write_exr_layout(tmpdir, tile_size, multi_part):
+    # Tests tiled and multi-part OpenEXR files with several layers
+    b1 = Bitmap(Bitmap.PixelFormat.MultiChannel, Struct.Type.Float32, [7, 5], 5)
+    a = b1.struct_()
+    for i, name in enumerate(['albedo.B', 'albedo.G', 'albedo.R', 'depth.Y', 'extra']):
+        a[i].name = name
+    b2 = np.array(b1, copy=False)
+    b2[:] = np.arange(7*5*5).reshape((5, 7, 5))
+
+    b1.set_exr_tile_size(tile_size)
+    b1.set_exr_multi_part(multi_part)
+    assert b1.exr_tile_size() == tile_size and b1.exr_multi_part() == multi_part
+
+    tmp_file = os.path.join(str(tmpdir), "out.exr")
+    b1.write(tmp_file)
+    b3 = Bitmap(tmp_file)
+    os.remove(tmp_file)
+
+    assert [f.name for f in b3.struct_()] == [f.name for f in b1.struct_()]
+    assert np.all(np.array(b3) == b2)
+
+
+
+def test_resample_convert_parallel():
+    # Tests the row-parallel resampling and conversion of large images
+    b = Bitmap(Bitmap.PixelFormat.RGB, Struct.Type.Float32, [300, 530])
+    data = np.array(b, copy=False)
+    data[:] = np.random.rand(530, 300, 3)
+
+    # Downsampling by two with a box filter averages blocks of 2x2 pixels
+    rfilter = mitsuba.core.xml.load_string("<rfilter version='2.0.0' type='box'/>")
+    b2 = np.array(b.resample([150, 265], rfilter))
+    ref = data.reshape(265, 2, 150, 2, 3).mean(axis=(1, 3))
+    assert np.allclose(b2, ref, atol=1e-5)
+
+    b3 = np.array(b.convert(Bitmap.PixelFormat.Y, Struct.Type.Float32, False))
+    ref = data @ np.array([0.212671, 0.715160, 0.072169], dtype=np.float32)
+    assert np.allclose(b3[..., 0], ref, atol=1e-5)
+
 def test_convert_rgb_y(tmpdir):
     # Tests RGBA(float64) -> Y (float32) conversion
     b1 = Bitmap(Bitmap.PixelFormat.RGBA, Struct.Type.Float64, [3, 1])
@@ -220,6 +262,25 @@ def test_read_tga():
     assert b1 == b2
 
 
+@pytest.mark.parametrize('ext', ['png', 'jpg', 'exr', 'hdr', 'pfm', 'ppm'])
+def test_read_header(tmpdir, ext):
+    pixel_format = Bitmap.PixelFormat.RGBA if ext in ['png', 'exr'] else Bitmap.PixelFormat.RGB
+    component_format = Struct.Type.Float32 if ext in ['exr', 'hdr', 'pfm'] else Struct.Type.UInt8
+
+    b = Bitmap(pixel_format, component_format, [13, 7])
+    b.clear()
+    tmp_file = os.path.join(str(tmpdir), "out." + ext)
+    b.write(tmp_file)
+
+    h = Bitmap.read_header(tmp_file)
+    b2 = Bitmap(tmp_file)
+    assert h.size() == b2.size()
+    assert h.pixel_format() == b2.pixel_format()
+    assert h.component_format() == b2.component_format()
+    assert h.channel_count() == b2.channel_count()
+    os.remove(tmp_file)
+
+
 def test_accumulate():
     # ----- Accumulate the whole bitmap
     b1 = Bitmap(Bitmap.PixelFormat.RGB, Struct.Type.UInt8, [10, 10])
@@ -244,3 +305,33 @@ def test_accumulate():
     # but (row, column) in arrays.
     b1.accumulate(b2, [5, 3], [3, 1], [1, 5])
     assert np.all(np.array(b1, copy=False) == ref)
+
+
+def test_dlpack():
+    b = Bitmap(Bitmap.PixelFormat.RGB, Struct.Type.Float32, [4, 3])
+    np.array(b, copy=False)[:] = np.arange(36, dtype=np.float32).reshape(3, 4, 3)
+    assert b.__dlpack_device__() == (1, 0)
+
+    # The imported bitmap aliases the memory of the exported one
+    b2 = Bitmap.from_dlpack(b.__dlpack__())
+    assert b2.pixel_format() == Bitmap.PixelFormat.RGB
+    assert b2.component_format() == Struct.Type.Float32
+    assert b2.size() == b.size()
+    assert b2 == b
+    np.array(b, copy=False)[1, 2, 0] = -1
+    assert np.array(b2, copy=False)[1, 2, 0] == -1
+
+    # The exporting bitmap is kept alive by the importing one
+    del b
+    assert np.array(b2, copy=False)[1, 2, 0] == -1
+
+    if hasattr(np, 'from_dlpack'):
+        a = np.arange(12, dtype=np.uint8).reshape(2, 3, 2)
+        b3 = Bitmap.from_dlpack(a)
+        assert b3.pixel_format() == Bitmap.PixelFormat.YA
+        a[1, 1, 1] = 100
+        assert np.array(b3, copy=False)[1, 1, 1] == 100
+        assert np.all(np.from_dlpack(b3) == a)
+
+    with pytest.raises(TypeError):
+        Bitmap.from_dlpack(1)
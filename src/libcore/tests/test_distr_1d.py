@@ -302,3 +302,70 @@ def test18_irrcont_simple_function(variant_packet_rgb):
                 0.48734, 0.654313, 0.786607, 0.899653, 1.])
          * d.normalization())
     )
+
+
+def test19_discr_alias(variant_packet_rgb):
+    # Alias table sampling must reproduce the PMF and never pick empty entries
+    from mitsuba.core import DiscreteDistribution, Float
+    import numpy as np
+
+    pmf = [0, 1, 0, 2, 5, 0, 0.5, 1.5, 0]
+    d = DiscreteDistribution(pmf)
+    d.build_alias_table()
+    assert d.has_alias_table()
+
+    x = ek.linspace(Float, 0, 1, 100000)
+    index, reused, prob = d.sample_reuse_pmf(x)
+    assert ek.allclose(prob, d.eval_pmf_normalized(index))
+    assert ek.all((reused >= 0) & (reused <= 1))
+
+    hist = np.bincount(np.array(index), minlength=len(pmf)) / len(x)
+    assert np.allclose(hist, np.array(pmf) / np.sum(pmf), atol=1e-3)
+
+    # The table is kept when the distribution is updated
+    d.update()
+    assert d.has_alias_table()
+
+
+def test20_cont_alias(variant_packet_rgb):
+    # Alias table interval selection must produce the same density
+    from mitsuba.core import ContinuousDistribution, IrregularContinuousDistribution, Float
+
+    x = ek.linspace(Float, -2, 2, 129)
+    y = ek.exp(-ek.sqr(x))
+
+    for d in [ContinuousDistribution([-2, 2], y),
+              IrregularContinuousDistribution(x, y)]:
+        d.build_alias_table()
+        pos, pdf = d.sample_pdf(ek.linspace(Float, 0, 1, 1000))
+        assert ek.all((pos >= -2) & (pos <= 2))
+        assert ek.allclose(pdf, d.eval_pdf_normalized(pos, True), rtol=1e-3, atol=1e-5)
+
+
+@pytest.mark.parametrize("alias", [False, True])
+def test21_cont_batch(variant_scalar_rgb, alias):
+    # The batched queries must match the per-query path (including a partial packet)
+    from mitsuba.core import ContinuousDistribution, IrregularContinuousDistribution
+    import numpy as np
+
+    nodes = np.linspace(-2, 2, 33)
+    values = np.exp(-nodes**2) + 0.1
+
+    for d in [ContinuousDistribution([-2, 2], values),
+              IrregularContinuousDistribution(nodes, values)]:
+        if alias:
+            d.build_alias_table()
+
+        x = np.linspace(-2.5, 2.5, 1001)
+        assert np.allclose(d.eval_pdf_batch(x), [d.eval_pdf(v) for v in x])
+        assert np.allclose(d.eval_pdf_normalized_batch(x),
+                           [d.eval_pdf_normalized(v, True) for v in x])
+        assert np.allclose(d.eval_cdf_batch(x), [d.eval_cdf(v) for v in x])
+        assert np.allclose(d.eval_cdf_normalized_batch(x),
+                           [d.eval_cdf_normalized(v) for v in x])
+
+        u = np.linspace(0, 1, 1001)
+        pos, pdf = d.sample_batch(u)
+        ref = [d.sample_pdf(v) for v in u]
+        assert np.allclose(pos, [r[0] for r in ref], atol=1e-5)
+        assert np.allclose(pdf, [r[1] for r in ref], atol=1e-5)
@@ -186,3 +186,25 @@ def test05_discrete_distribution_2d(variant_scalar_rgb):
     assert ac(d.sample([1, 0]), ([2, 0], .3, [1, 0]))
     assert ac(d.sample([0, 6 / 10 - 1e-7]), ([0, 0], .1, [0, 1]))
     assert ac(d.sample([0, 6 / 10 + 1e-7]), ([1, 1], .1, [0, 0]))
+
+
+@pytest.mark.parametrize("warp", ['Hierarchical2D', 'MarginalDiscrete2D', 'MarginalContinuous2D'])
+def test06_parallel_slices(variant_scalar_rgb, warp):
+    # The slices (and rows) are built in parallel: every slice must match a
+    # distribution built from its data alone
+    cls0 = getattr(mitsuba.core, warp + '0')
+    cls1 = getattr(mitsuba.core, warp + '1')
+    np.random.seed(0)
+
+    values = np.random.rand(3, 300, 500) * 10
+    param = [0.0, 0.5, 1.0]
+    instance = cls1(values, [param])
+
+    for k in range(len(param)):
+        reference = cls0(values[k])
+        for j in range(10):
+            p_i = np.random.rand(2)
+            p_o, pdf = instance.sample(p_i, param=[param[k]])
+            p_o_ref, pdf_ref = reference.sample(p_i)
+            assert ek.allclose(p_o, p_o_ref, atol=1e-5)
+            assert ek.allclose(pdf, pdf_ref, rtol=1e-4)
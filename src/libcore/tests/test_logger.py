@@ -41,3 +41,75 @@ def test01_custom(variant_scalar_rgb):
         for app in appenders:
             logger.add_appender(app)
         logger.set_formatter(formatter)
+
+
+def test02_async(variant_scalar_rgb):
+    from mitsuba.core import Thread, Appender, Log, LogLevel
+
+    # Messages logged in asynchronous mode reach the appenders after a flush
+    messages = []
+
+    logger = Thread.thread().logger()
+    appenders = []
+    while logger.appender_count() > 0:
+        app = logger.appender(0)
+        appenders.append(app)
+        logger.remove_appender(app)
+
+    try:
+        class MyAppender(Appender):
+            def append(self, level, text):
+                messages.append(text)
+
+        logger.add_appender(MyAppender())
+        logger.set_async(True)
+        assert logger.is_async()
+
+        for i in range(10):
+            Log(LogLevel.Warn, "Message %i" % i)
+        logger.flush()
+
+        assert len(messages) == 10
+        assert all("Message %i" % i in messages[i] for i in range(10))
+    finally:
+        logger.set_async(False)
+        logger.clear_appenders()
+        for app in appenders:
+            logger.add_appender(app)
+
+    assert not logger.is_async()
+
+
+def test03_async_toggle(variant_scalar_rgb):
+    from mitsuba.core import Thread, Appender, Log, LogLevel
+
+    # Disabling the asynchronous mode delivers the pending messages, also
+    # when the mode is toggled repeatedly
+    messages = []
+
+    logger = Thread.thread().logger()
+    appenders = []
+    while logger.appender_count() > 0:
+        app = logger.appender(0)
+        appenders.append(app)
+        logger.remove_appender(app)
+
+    try:
+        class MyAppender(Appender):
+            def append(self, level, text):
+                messages.append(text)
+
+        logger.add_appender(MyAppender())
+        for k in range(5):
+            logger.set_async(True, 16 if k < 3 else 32)
+            for i in range(10):
+                Log(LogLevel.Warn, "Message %i" % (10 * k + i))
+            logger.set_async(False)
+
+        assert len(messages) == 50
+        assert all("Message %i" % i in messages[i] for i in range(50))
+    finally:
+        logger.set_async(False)
+        logger.clear_appenders()
+        for app in appenders:
+            logger.add_appender(app)
@@ -0,0 +1,67 @@
+import mitsuba
+import pytest
+
+
+def test01_counters(variant_scalar_rgb):
+    from mitsuba.core import MemoryAccounting, MemoryCategory
+
+    category = MemoryCategory.Volumes
+    current = MemoryAccounting.current(category)
+    MemoryAccounting.reset_peak()
+    assert MemoryAccounting.peak(category) == current
+
+    MemoryAccounting.add(category, 1000)
+    MemoryAccounting.add(category, 500)
+    MemoryAccounting.remove(category, 1200)
+    assert MemoryAccounting.current(category) == current + 300
+    assert MemoryAccounting.peak(category) == current + 1500
+
+    MemoryAccounting.remove(category, 300)
+    assert MemoryAccounting.current(category) == current
+    assert 'Volumes' in MemoryAccounting.report()
+
+
+
+def test02_device_pool(variant_scalar_rgb):
+    from mitsuba.core import DeviceMemoryPool, MTS_ENABLE_OPTIX
+
+    # Four size classes per power of two, at least 256 bytes
+    assert DeviceMemoryPool.size_class(1) == 256
+    assert DeviceMemoryPool.size_class(256) == 256
+    assert DeviceMemoryPool.size_class(257) == 320
+    assert DeviceMemoryPool.size_class(1000) == 1024
+    assert DeviceMemoryPool.size_class(1025) == 1280
+    assert DeviceMemoryPool.size_class(3 * 2**20 + 1) == 3.5 * 2**20
+
+    limit = DeviceMemoryPool.limit()
+    DeviceMemoryPool.set_limit(2**20)
+    assert DeviceMemoryPool.stats().limit == 2**20
+
+    if not MTS_ENABLE_OPTIX:
+        with pytest.raises(RuntimeError):
+            DeviceMemoryPool.malloc(1000)
+        DeviceMemoryPool.set_limit(limit)
+        return
+
+    # Released blocks are reused by requests of the same size class
+    DeviceMemoryPool.trim()
+    DeviceMemoryPool.reset_stats()
+    used = DeviceMemoryPool.stats().used
+    a = DeviceMemoryPool.malloc(1000)
+    DeviceMemoryPool.free(a)
+    assert DeviceMemoryPool.stats().cached == 1024
+    b = DeviceMemoryPool.malloc(900)
+    assert b == a
+    stats = DeviceMemoryPool.stats()
+    assert stats.hits == 1 and stats.misses == 1
+    assert stats.used == used + 1024 and stats.cached == 0
+
+    # Blocks beyond the limit are returned to the device
+    c = DeviceMemoryPool.malloc(2**21)
+    DeviceMemoryPool.free(c)
+    DeviceMemoryPool.free(b)
+    assert DeviceMemoryPool.stats().cached == 1024
+
+    DeviceMemoryPool.trim()
+    assert DeviceMemoryPool.stats().cached == 0
+    DeviceMemoryPool.set_limit(limit)
@@ -1,4 +1,5 @@
 import numpy as np
+import pytest
 import os
 
 import mitsuba
@@ -67,3 +68,55 @@ def test04_create_temp():
     assert mmap.can_write()
     del mmap
     assert not os.path.exists(fname)
+
+
+def test05_copy_on_write(tmpdir):
+    tmp_file = os.path.join(str(tmpdir), "mmap_test")
+    with open(tmp_file, "w") as f:
+        f.write('hello!')
+    mmap = MemoryMappedFile.map_copy_on_write(tmp_file)
+    assert mmap.size() == 6
+    assert mmap.can_write()
+    array_view = np.array(mmap, copy=False)
+    array_view[1] = ord('a')
+    assert np.all(array_view == np.array('hallo!', 'c').view(np.uint8))
+    with open(tmp_file, "r") as f:
+        assert f.readline() == 'hello!'
+    del array_view
+    del mmap
+    os.remove(tmp_file)
+
+
+def test06_hints(tmpdir):
+    tmp_file = os.path.join(str(tmpdir), "mmap_test")
+    data = np.arange(100000, dtype=np.uint32)
+    data.tofile(tmp_file)
+
+    # Hints must never change the contents of the mapping
+    mmap = MemoryMappedFile(tmp_file, populate=True)
+    for access in [MemoryMappedFile.Access.Sequential, MemoryMappedFile.Access.Random,
+                   MemoryMappedFile.Access.Normal]:
+        mmap.advise(access)
+    mmap.prefetch()
+    mmap.prefetch(offset=5000, size=10000)
+    mmap.prefetch(offset=mmap.size() + 1)
+    array_view = np.array(mmap, copy=False).view(np.uint32)
+    assert np.all(array_view == data)
+    del array_view
+    del mmap
+    os.remove(tmp_file)
+
+
+def test07_create_anonymous():
+    mmap = MemoryMappedFile.create_anonymous(1 << 22)
+    assert mmap.size() == 1 << 22
+    assert mmap.can_write()
+    assert str(mmap.filename()) == ''
+    array_view = np.array(mmap, copy=False)
+    assert np.all(array_view == 0)
+    array_view[1000] = 42
+    assert array_view[1000] == 42
+    del array_view
+    with pytest.raises(RuntimeError):
+        mmap.resize(100)
+    del mmap
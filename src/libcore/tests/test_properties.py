@@ -162,3 +162,29 @@ def test08_animated_transforms(variant_scalar_rgb):
     assert type(p["trafo"]) is Transform4f
     assert type(p["atrafo"]) is AnimatedTransform
 
+
+
+def test09_many_properties(variant_scalar_rgb):
+    """Large instances use a hash table index, which must not affect the
+    lookup results, the removal of entries or the (natural) ordering."""
+    from mitsuba.core import Properties as Prop
+
+    p = Prop()
+    names = ['item_%i' % i for i in range(100)]
+    # Insert the entries out of order
+    for name in reversed(names):
+        p[name] = int(name.split('_')[1])
+    p['a_first'] = 'x'
+
+    assert p.property_names() == ['a_first'] + names
+    for i, name in enumerate(names):
+        assert p[name] == i
+
+    assert p.remove_property('item_50')
+    assert not p.has_property('item_50')
+    assert p['item_51'] == 51
+    assert len(p.property_names()) == 100
+
+    p['item_50'] = -1
+    assert p['item_50'] == -1
+    assert p.property_names() == ['a_first'] + names
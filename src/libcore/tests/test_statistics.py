@@ -0,0 +1,55 @@
+import mitsuba
+import pytest
+
+
+def test01_disabled(variant_scalar_rgb):
+    from mitsuba.core import Statistics, StatsCounter, StatsHistogram
+
+    if Statistics.enabled():
+        pytest.skip('Mitsuba was compiled with statistics')
+
+    # All calls are compiled out
+    assert Statistics.counter(StatsCounter.Rays) == 0
+    assert sum(Statistics.histogram(StatsHistogram.PathLength)) == 0
+    assert 'disabled' in Statistics.report()
+
+
+def test02_render_counters(variant_scalar_rgb):
+    from mitsuba.core import xml, Statistics, StatsCounter, StatsHistogram
+
+    if not Statistics.enabled():
+        pytest.skip('Mitsuba was compiled without statistics')
+
+    scene = xml.load_dict({
+        'type' : 'scene',
+        'sensor' : {
+            'type' : 'perspective',
+            'film' : {
+                'type' : 'hdrfilm',
+                'width' : 8, 'height' : 8,
+                'rfilter' : { 'type' : 'box' }
+            },
+            'sampler' : { 'type' : 'independent', 'sample_count' : 4 }
+        },
+        'shape' : { 'type' : 'sphere', 'center' : [0, 0, 3] },
+        'emitter' : { 'type' : 'constant' },
+        'integrator' : { 'type' : 'path', 'max_depth' : 4, 'rr_depth' : 1 }
+    })
+
+    Statistics.reset()
+    assert Statistics.counter(StatsCounter.Rays) == 0
+    scene.integrator().render(scene, scene.sensors()[0])
+
+    # One camera ray per sample, at least one shadow ray per surface interaction
+    rays = Statistics.counter(StatsCounter.Rays)
+    assert rays >= 8 * 8 * 4
+    assert Statistics.counter(StatsCounter.ShadowRays) > 0
+    assert Statistics.counter(StatsCounter.KDTreeNodes) > 0
+    assert Statistics.counter(StatsCounter.PrimitiveTests) > 0
+    assert Statistics.counter(StatsCounter.NullCollisions) == 0
+
+    # Every valid camera ray ends up in the histogram, with at most 'max_depth' vertices
+    histogram = Statistics.histogram(StatsHistogram.PathLength)
+    assert 0 < sum(histogram) <= 8 * 8 * 4
+    assert sum(histogram[5:]) == 0
+    assert 'Rays traced' in Statistics.report()
@@ -5,7 +5,8 @@ import mitsuba
 
 mitsuba.set_variant('scalar_rgb')
 
-from mitsuba.core import Stream, DummyStream, FileStream, MemoryStream, ZStream
+from mitsuba.core import Stream, DummyStream, FileStream, MemoryStream, ZStream, \
+    AsyncFileStream
 from mitsuba.python.test.util import tmpfile, make_tmpfile
 
 parameters = [
@@ -283,3 +284,70 @@ def test08_fstream(rw, tmpfile):
     else:
         with pytest.raises(RuntimeError):
             FileStream(new_name)
+
+
+@pytest.mark.parametrize('block_size,block_count', [(7, 2), (1024, 4)])
+def test09_async_fstream(block_size, block_count, tmpfile):
+    s = FileStream(tmpfile, FileStream.ETruncReadWrite)
+    write_contents(s)
+    size = s.size()
+    s.close()
+
+    s = AsyncFileStream(tmpfile, block_size, block_count)
+    assert s.can_read() and not s.can_write()
+    assert s.block_size() == block_size
+    assert s.block_count() == block_count
+    assert s.size() == size
+
+    # Sequential reads, then again after seeking backwards
+    check_contents(s)
+    assert s.tell() == size
+    check_contents(s)
+
+    # Seeks within and beyond the blocks that were read ahead
+    s.seek(12)
+    assert s.read_string() == 'some sentence'
+    s.seek(0)
+    assert ek.abs(s.read_single() - 82.548) < 1e-4
+
+    s.seek(size - 1)
+    with pytest.raises(RuntimeError):
+        s.read_int64()
+
+    with pytest.raises(RuntimeError):
+        s.write_int64(42)
+    with pytest.raises(RuntimeError):
+        s.truncate(5)
+
+    s.close()
+    assert s.is_closed()
+    with pytest.raises(RuntimeError):
+        AsyncFileStream(tmpfile + "_2")
+
+
+@pytest.mark.skipif(not ZStream.has_zstd(), reason='Compiled without zstd support')
+@pytest.mark.parametrize('threads', [1, 4])
+def test10_zstd_stream(threads):
+    stream = MemoryStream()
+    zstream = ZStream(stream, ZStream.EZstdStream, threads=threads)
+    assert zstream.stream_type() == ZStream.EZstdStream
+
+    # Flushing in between must still yield a stream that decodes in one go
+    write_contents(zstream)
+    data = bytes(range(256)) * 1000
+    zstream.write(data)
+    zstream.close()
+
+    stream.seek(0)
+    zstream = ZStream(stream, ZStream.EZstdStream)
+    check_contents(zstream)
+    assert zstream.read(len(data)) == data
+    with pytest.raises(RuntimeError):
+        zstream.read_uint8()
+
+
+def test11_zstd_unsupported():
+    if ZStream.has_zstd():
+        pytest.skip('Compiled with zstd support')
+    with pytest.raises(RuntimeError):
+        ZStream(MemoryStream(), ZStream.EZstdStream)
@@ -447,3 +447,33 @@ def test19_alpha_4():
     dst_data = (src_data_float[0], src_data_float[1], src_data[2])
     check_conversion(s, '@BBB', '@BBB',
                      src_data, dst_data)
+
+
+def test20_cache_blend_weights():
+    # Converters that only differ in their blend weights must not be shared
+    src = Struct().append('a', Struct.Type.Float32) \
+                  .append('b', Struct.Type.Float32)
+
+    for weights in [(1.0, 2.0), (3.0, 4.0), (1.0, 2.0)]:
+        target = Struct().append('v', Struct.Type.Float32)
+        target.field('v').blend = [(weights[0], 'a'), (weights[1], 'b')]
+        s = StructConverter(src, target)
+        check_conversion(s, '@ff', '@f', (1.0, 2.0),
+                         (weights[0] + 2.0 * weights[1],))
+
+
+@pytest.mark.parametrize('count', [1, 7, 8, 19])
+@pytest.mark.parametrize('types', [('f', 'e'), ('e', 'f'), ('f', 'f')])
+def test21_bulk_conversion(count, types):
+    # Uniform single/half precision arrays (vectorized when supported)
+    type_map = dict(supported_types)
+    src = Struct()
+    target = Struct()
+    for i in range(3):
+        src.append(str(i), type_map[types[0]])
+        target.append(str(i), type_map[types[1]])
+
+    s = StructConverter(src, target)
+    data = [0.25 * i - 3.0 for i in range(count * 3)]
+    check_conversion(s, '@' + types[0] * (3 * count),
+                     '@' + types[1] * (3 * count), data)
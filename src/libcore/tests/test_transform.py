@@ -255,3 +255,48 @@ def test06_transform_normal(variant_scalar_rgb):
 #     assert ek.allclose(a.eval(-10).matrix, trafo0.matrix)
 #     assert ek.allclose(a.eval(2.5).matrix, trafo_mid.matrix)
 #     assert ek.allclose(a.eval( 10).matrix, trafo1.matrix)
+
+
+def test12_affine_transform_kind(variant_scalar_rgb):
+    from mitsuba.core import Transform4f, ScalarAffineTransform4f as AffineTransform4f
+
+    Kind = AffineTransform4f.Kind
+    rigid = Transform4f.translate([1, 2, 3]) * Transform4f.rotate([1, 2, 3], 30)
+    uniform = rigid * Transform4f.scale([2, 2, 2])
+    general = rigid * Transform4f.scale([1, 2, 3])
+
+    assert AffineTransform4f().kind == Kind.Rigid
+    assert AffineTransform4f(rigid).kind == Kind.Rigid
+    assert not AffineTransform4f(rigid).has_scale()
+    assert AffineTransform4f(uniform).kind == Kind.UniformScale
+    assert ek.allclose(AffineTransform4f(uniform).scale, 2)
+    assert AffineTransform4f(general).kind == Kind.General
+    assert AffineTransform4f(general).has_scale()
+
+    t = AffineTransform4f(uniform) * AffineTransform4f(uniform)
+    assert t.kind == Kind.UniformScale
+    assert ek.allclose(t.scale, 4)
+    assert (AffineTransform4f(rigid) * AffineTransform4f(general)).kind == Kind.General
+
+
+def test13_affine_transform_ops(variant_scalar_rgb):
+    from mitsuba.core import Transform4f, ScalarAffineTransform4f as AffineTransform4f
+
+    rigid = Transform4f.translate([1, 2, 3]) * Transform4f.rotate([1, 2, 3], 30)
+    for trafo in [rigid, rigid * Transform4f.scale([2, 2, 2]),
+                  rigid * Transform4f.scale([1, 2, 3])]:
+        a = AffineTransform4f(trafo)
+        a_inv = a.inverse()
+        trafo_inv = trafo.inverse()
+
+        assert ek.allclose(a.to_transform().matrix, trafo.matrix)
+        assert ek.allclose(a.to_transform().inverse_transpose,
+                           trafo.inverse_transpose, atol=1e-6)
+        assert ek.allclose(a_inv.to_transform().matrix, trafo_inv.matrix, atol=1e-6)
+        assert a_inv.kind == a.kind
+
+        for v in [[1, 0, 0], [0.5, -2, 3], [-1, 4, 0.25]]:
+            assert ek.allclose(a.transform_point(v), trafo.transform_point(v))
+            assert ek.allclose(a.transform_vector(v), trafo.transform_vector(v))
+            assert ek.allclose(a.transform_normal(v), trafo.transform_normal(v), atol=1e-6)
+            assert ek.allclose(a_inv.transform_point(a.transform_point(v)), v, atol=1e-5)
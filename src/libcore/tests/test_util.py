@@ -27,3 +27,11 @@ def test01_mem_string(variant_scalar_rgb):
         assert mem_string(2 * 1024 ** 4, precise=True) == '2 TiB'
         assert mem_string(2 * 1024 ** 5, precise=True) == '2 PiB'
         assert mem_string(2 * 1024 ** 6, precise=True) == '2 EiB'
+
+
+def test03_peak_memory_usage(variant_scalar_rgb):
+    from mitsuba.core.util import peak_memory_usage
+
+    # At least the size of the Python interpreter and the Mitsuba libraries
+    if sys.platform.startswith('linux') or sys.platform == 'darwin':
+        assert peak_memory_usage() > 1024 ** 2
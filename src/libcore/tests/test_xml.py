@@ -1,5 +1,6 @@
 import enoki as ek
 import pytest
+import os
 import mitsuba
 
 from mitsuba.python.test.util import fresolver_append_path
@@ -359,4 +360,155 @@ def test24_properties_duplicated(variant_scalar_rgb):
                                 <rgb name="reflectance" value="0.44"/>
                             </bsdf>
                         </scene>""")
-    e.match(err_str)
\ No newline at end of file
+    e.match(err_str)
+
+def test25_shared_references(variant_scalar_rgb):
+    from mitsuba.core import xml
+
+    # Many shapes referencing the same BSDF, which references a texture
+    shapes = "".join("""<shape type="sphere">
+                            <point name="center" x="{}" y="0" z="0"/>
+                            <ref id="mat"/>
+                        </shape>""".format(i) for i in range(50))
+    scene = xml.load_string("""<scene version="2.0.0">
+                                   <texture type="checkerboard" id="tex"/>
+                                   <bsdf type="diffuse" id="mat">
+                                       <ref name="reflectance" id="tex"/>
+                                   </bsdf>
+                                   {}
+                               </scene>""".format(shapes))
+
+    assert len(scene.shapes()) == 50
+    bsdf = scene.shapes()[0].bsdf()
+    assert all(shape.bsdf() == bsdf for shape in scene.shapes())
+
+    with pytest.raises(Exception) as e:
+        xml.load_string("""<scene version="2.0.0">
+                               <bsdf type="diffuse" id="mat">
+                                   <ref name="reflectance" id="unknown"/>
+                               </bsdf>
+                               <shape type="sphere">
+                                   <ref id="mat"/>
+                               </shape>
+                           </scene>""")
+    e.match('reference to unknown object "unknown"')
+
+
+def test26_scene_cache(variant_scalar_rgb, tmpdir):
+    from mitsuba.core import xml
+
+    cache_dir = str(tmpdir.join('cache'))
+    filename = str(tmpdir.join('scene.xml'))
+
+    def write_scene(radius):
+        with open(filename, 'w') as f:
+            f.write("""<scene version="2.0.0">
+                          <bsdf type="diffuse" id="mat">
+                              <rgb name="reflectance" value="0.2, 0.4, 0.6"/>
+                          </bsdf>
+                          <shape type="sphere">
+                              <float name="radius" value="{}"/>
+                              <transform name="to_world">
+                                  <translate x="1" y="2" z="3"/>
+                              </transform>
+                              <ref id="mat"/>
+                          </shape>
+                      </scene>""".format(radius))
+
+    write_scene(2)
+    xml.set_cache_dir(cache_dir)
+    try:
+        assert xml.cache_dir() == cache_dir
+        scene1 = xml.load_file(filename)
+        assert len(os.listdir(cache_dir)) == 1
+
+        # The second load is restored from the cache
+        scene2 = xml.load_file(filename)
+        assert scene1.bbox() == scene2.bbox()
+        assert len(scene2.shapes()) == 1
+
+        # Changing the file invalidates the cache entry
+        write_scene(3)
+        scene3 = xml.load_file(filename)
+        assert ek.allclose(scene3.bbox().max, [4, 5, 6])
+        assert xml.load_file(filename).bbox() == scene3.bbox()
+    finally:
+        xml.set_cache_dir('')
+
+
+def test27_instance_cache(variant_scalar_rgb, tmpdir):
+    from mitsuba.core import xml
+
+    filename = str(tmpdir.join('scene.xml'))
+    with open(filename, 'w') as f:
+        f.write("""<scene version="2.0.0">
+                      <bsdf type="diffuse" id="mat">
+                          <float name="reflectance" value="$refl"/>
+                      </bsdf>
+                      <shape type="sphere">
+                          <float name="radius" value="$radius"/>
+                          <ref id="mat"/>
+                      </shape>
+                  </scene>""")
+
+    cache = xml.InstanceCache()
+    scene1 = xml.load_file(filename, refl='0.5', radius='1', cache=cache)
+    assert cache.reused() == 0 and cache.updated() == 0 and cache.created() > 0
+
+    # Nothing changed: all objects are reused
+    scene2 = xml.load_file(filename, refl='0.5', radius='1', cache=cache)
+    assert cache.reused() > 0 and cache.updated() == 0 and cache.created() == 0
+    assert scene2.bbox() == scene1.bbox()
+
+    # The reflectance is a parameter of the BSDF, which is updated in place
+    xml.load_file(filename, refl='0.25', radius='1', cache=cache)
+    assert cache.updated() == 1 and cache.created() == 0
+
+    # The radius is not: the sphere and the scene that references it are recreated
+    scene4 = xml.load_file(filename, refl='0.25', radius='2', cache=cache)
+    assert cache.updated() == 0 and cache.created() == 2
+    assert ek.allclose(scene4.bbox().max, [2, 2, 2])
+
+
+def test28_deduplication(variant_scalar_rgb):
+    from mitsuba.core import xml
+
+    scene_xml = """<scene version="2.0.0">
+                       <shape type="sphere">
+                           <float name="radius" value="1"/>
+                           <bsdf type="diffuse">
+                               <rgb name="reflectance" value="0.2, 0.4, 0.6"/>
+                           </bsdf>
+                       </shape>
+                       <shape type="sphere">
+                           <float name="radius" value="2"/>
+                           <bsdf type="diffuse" id="named">
+                               <rgb name="reflectance" value="0.2, 0.4, 0.6"/>
+                           </bsdf>
+                       </shape>
+                       <shape type="sphere">
+                           <float name="radius" value="3"/>
+                           <bsdf type="diffuse">
+                               <rgb name="reflectance" value="0.2, 0.4, 0.7"/>
+                           </bsdf>
+                       </shape>
+                   </scene>"""
+
+    def bsdfs():
+        shapes = sorted(xml.load_string(scene_xml).shapes(),
+                        key=lambda s: s.bbox().max.x)
+        return [s.bsdf() for s in shapes]
+
+    # By default, every node creates its own object
+    assert not xml.deduplication()
+    b = bsdfs()
+    assert b[0] is not b[1]
+
+    xml.set_deduplication(True)
+    try:
+        # Identical nodes share their object regardless of their ID
+        b = bsdfs()
+        assert b[0] is b[1]
+        assert b[0] is not b[2]
+    finally:
+        xml.set_deduplication(False)
@@ -1,11 +1,20 @@
+/* Local (per-arena) task scheduler observers are a preview feature of
+   older TBB releases */
+#define TBB_PREVIEW_LOCAL_OBSERVER 1
+
 #include <mitsuba/core/thread.h>
 #include <mitsuba/core/logger.h>
 #include <mitsuba/core/tls.h>
 #include <mitsuba/core/util.h>
 #include <mitsuba/core/fresolver.h>
 #include <mitsuba/core/profiler.h>
+#include <mitsuba/core/string.h>
+#include <tbb/task_arena.h>
 #include <tbb/task_scheduler_observer.h>
+#include <algorithm>
 #include <condition_variable>
+#include <exception>
+#include <fstream>
 #include <thread>
 #include <sstream>
 #include <chrono>
@@ -30,6 +39,83 @@ static pthread_key_t this_thread_id;
 static __declspec(thread) int this_thread_id;
 #endif
 
+/// Logical CPUs of each NUMA node that has CPUs (empty if unknown)
+static std::vector<std::vector<int>> numa_cpus;
+static bool numa_pinning_enabled = false;
+static std::atomic<uint32_t> numa_worker_ctr { 0 };
+static thread_local int this_numa_node = -1;
+
+/// Parse a comma-separated list of CPUs or CPU ranges, e.g. "0-15,32-47"
+static std::vector<int> parse_cpu_list(const std::string &str) {
+    std::vector<int> cpus;
+    for (const std::string &item : string::tokenize(str, ",")) {
+        std::vector<std::string> range = string::tokenize(item, "-");
+        if (range.empty())
+            continue;
+        int first = std::stoi(range[0]),
+            last  = range.size() > 1 ? std::stoi(range[1]) : first;
+        for (int cpu = first; cpu <= last; ++cpu)
+            cpus.push_back(cpu);
+    }
+    return cpus;
+}
+
+#if defined(__LINUX__)
+/// Read the NUMA topology from sysfs
+static void numa_detect() {
+    numa_cpus.clear();
+    for (int node = 0;; ++node) {
+        std::ifstream is(tfm::format("/sys/devices/system/node/node%i/cpulist", node));
+        if (!is.good())
+            break;
+
+        std::string line;
+        std::getline(is, line);
+        std::vector<int> cpus;
+        try {
+            cpus = parse_cpu_list(line);
+        } catch (const std::exception &) {
+            // Called before the logger is initialized: silently skip the node
+            continue;
+        }
+
+        // Skip memory-only nodes
+        if (!cpus.empty())
+            numa_cpus.push_back(std::move(cpus));
+    }
+}
+
+/// Restrict a thread to a set of logical CPUs
+static bool cpu_pin(pthread_t handle, const std::vector<int> &cpus, const char *caller) {
+    int cpu_count = *std::max_element(cpus.begin(), cpus.end()) + 1;
+
+    size_t size = CPU_ALLOC_SIZE(cpu_count);
+    cpu_set_t *cpuset = CPU_ALLOC(cpu_count);
+    if (!cpuset) {
+        Log(Warn, "%s: could not allocate cpu_set_t", caller);
+        return false;
+    }
+
+    CPU_ZERO_S(size, cpuset);
+    for (int cpu : cpus)
+        CPU_SET_S(cpu, size, cpuset);
+
+    int retval = pthread_setaffinity_np(handle, size, cpuset);
+    CPU_FREE(cpuset);
+
+    if (retval) {
+        Log(Warn, "%s: pthread_setaffinity_np: failed: %s", caller, strerror(retval));
+        return false;
+    }
+    return true;
+}
+
+/// Restrict a thread to the CPUs of a NUMA node
+static bool numa_pin(pthread_t handle, int node) {
+    return cpu_pin(handle, numa_cpus[node], "Thread::set_numa_node()");
+}
+#endif
+
 #if defined(_MSC_VER)
 namespace {
     // Helper function to set a native thread name. MSDN:
@@ -93,6 +179,7 @@ struct Thread::ThreadPrivate {
     bool tbb_thread = false;
     bool critical = false;
     int core_affinity = -1;
+    int numa_node = -1;
     Thread::EPriority priority;
     ref<Logger> logger;
     ref<Thread> parent;
@@ -169,6 +256,72 @@ int Thread::core_affinity() const {
     return d->core_affinity;
 }
 
+int Thread::numa_node() const {
+    return d->numa_node;
+}
+
+int Thread::current_numa_node() {
+    return this_numa_node;
+}
+
+int Thread::numa_node_count() {
+    return numa_cpus.empty() ? 1 : (int) numa_cpus.size();
+}
+
+void Thread::set_numa_pinning(bool value) {
+    numa_pinning_enabled = value;
+}
+
+bool Thread::numa_pinning() {
+    return numa_pinning_enabled;
+}
+
+bool Thread::set_numa_node(int node) {
+    if (node < 0 || node >= numa_node_count()) {
+        Log(Warn, "Thread::set_numa_node(): invalid node %i (%i available)!",
+            node, numa_node_count());
+        return false;
+    }
+
+    d->numa_node = node;
+    if (!d->running)
+        return true; // Applied in dispatch()
+
+    if (this != Thread::thread()) {
+        Log(Warn, "Thread::set_numa_node(): running threads can only pin themselves!");
+        return false;
+    }
+
+#if defined(__LINUX__)
+    if (numa_cpus.empty() || !numa_pin(d->native_handle, node))
+        return false;
+    this_numa_node = node;
+    return true;
+#else
+    return false;
+#endif
+}
+
+void Thread::run_on_numa_node(int node, const std::function<void()> &func) {
+    std::exception_ptr exception;
+
+    std::thread worker([&]() {
+#if defined(__LINUX__)
+        if (node >= 0 && node < (int) numa_cpus.size() && numa_pin(pthread_self(), node))
+            this_numa_node = node;
+#endif
+        try {
+            func();
+        } catch (...) {
+            exception = std::current_exception();
+        }
+    });
+    worker.join();
+
+    if (exception)
+        std::rethrow_exception(exception);
+}
+
 uint32_t Thread::thread_id() {
 #if defined(__WINDOWS__)
     return this_thread_id;
@@ -395,6 +548,9 @@ void Thread::dispatch() {
     if (d->core_affinity != -1)
         set_core_affinity(d->core_affinity);
 
+    if (d->numa_node != -1)
+        set_numa_node(d->numa_node);
+
     try {
         run();
     } catch (std::exception &e) {
@@ -489,6 +645,9 @@ public:
 
     void on_scheduler_entry(bool) {
         if (register_external_thread("tbb")) {
+            if (numa_pinning_enabled && numa_node_count() > 1)
+                thread()->set_numa_node((int) (numa_worker_ctr++ % numa_node_count()));
+
             std::unique_lock<std::mutex> lock(m_mutex);
             m_started_counter++;
         }
@@ -525,6 +684,10 @@ void Thread::static_initialization() {
 
     __global_thread_count = util::core_count();
 
+    #if defined(__LINUX__)
+        numa_detect();
+    #endif
+
     self = new ThreadLocal<Thread>();
     Thread *main_thread = new MainThread();
 
@@ -583,8 +746,149 @@ ScopedSetThreadEnvironment::~ScopedSetThreadEnvironment() {
 #endif
 }
 
+// -----------------------------------------------------------------------
+
+static thread_local ThreadPool *current_pool = nullptr;
+
+/// Pins the worker threads entering the arena of a thread pool
+class PoolAffinityObserver : public tbb::task_scheduler_observer {
+public:
+    PoolAffinityObserver(tbb::task_arena &arena, const std::vector<int> &cores)
+        : tbb::task_scheduler_observer(arena), m_cores(cores) {
+        observe(true);
+    }
+
+    ~PoolAffinityObserver() { observe(false); }
+
+    void on_scheduler_entry(bool is_worker) override {
+#if defined(__LINUX__)
+        // The calling thread of ThreadPool::execute() keeps its affinity
+        if (!is_worker)
+            return;
+
+        m_saved_valid = pthread_getaffinity_np(pthread_self(), sizeof(cpu_set_t),
+                                               &m_saved) == 0;
+
+        int index = tbb::this_task_arena::current_thread_index();
+        if (index < 0)
+            return;
+        cpu_pin(pthread_self(), { m_cores[(size_t) index % m_cores.size()] },
+                "ThreadPool");
+#else
+        (void) is_worker;
+#endif
+    }
+
+    void on_scheduler_exit(bool is_worker) override {
+#if defined(__LINUX__)
+        if (is_worker && m_saved_valid) {
+            pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &m_saved);
+            m_saved_valid = false;
+        }
+#else
+        (void) is_worker;
+#endif
+    }
+
+private:
+    std::vector<int> m_cores;
+#if defined(__LINUX__)
+    /// Affinity of the worker thread before it entered the arena
+    static thread_local cpu_set_t m_saved;
+    static thread_local bool m_saved_valid;
+#endif
+};
+
+#if defined(__LINUX__)
+thread_local cpu_set_t PoolAffinityObserver::m_saved;
+thread_local bool PoolAffinityObserver::m_saved_valid = false;
+#endif
+
+struct ThreadPool::ThreadPoolPrivate {
+    size_t thread_count;
+    std::vector<int> cores;
+    std::unique_ptr<tbb::task_arena> arena;
+    std::unique_ptr<PoolAffinityObserver> observer;
+};
+
+ThreadPool::ThreadPool(size_t thread_count, const std::vector<int> &cores)
+    : d(new ThreadPoolPrivate()) {
+    for (int core : cores) {
+        if (core < 0 || core >= util::core_count())
+            Throw("ThreadPool: invalid core %i (%i available)!", core, util::core_count());
+    }
+
+    if (thread_count == 0)
+        thread_count = cores.empty() ? std::max(__global_thread_count, (size_t) 1)
+                                     : cores.size();
+
+    d->thread_count = thread_count;
+    d->cores = cores;
+    d->arena.reset(new tbb::task_arena((int) thread_count));
+    d->arena->initialize();
+
+    if (!cores.empty()) {
+#if defined(__LINUX__)
+        d->observer.reset(new PoolAffinityObserver(*d->arena, cores));
+#else
+        Log(Warn, "ThreadPool: core pinning is only supported on Linux, ignoring.");
+#endif
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    // Detach the observer before the arena is released
+    d->observer.reset();
+    d->arena.reset();
+}
+
+size_t ThreadPool::thread_count() const { return d->thread_count; }
+
+const std::vector<int> &ThreadPool::cores() const { return d->cores; }
+
+void ThreadPool::execute(const std::function<void()> &func) {
+    /* The function may run on a worker thread of the arena if all slots that
+       are reserved for calling threads are taken */
+    ThreadEnvironment env;
+    d->arena->execute([&]() {
+        ScopedSetThreadEnvironment set_env(env);
+        ThreadPool *prev = current_pool;
+        current_pool = this;
+        try {
+            func();
+        } catch (...) {
+            current_pool = prev;
+            throw;
+        }
+        current_pool = prev;
+    });
+}
+
+ThreadPool *ThreadPool::current() { return current_pool; }
+
+std::vector<int> ThreadPool::parse_cores(const std::string &str) {
+    try {
+        return parse_cpu_list(str);
+    } catch (const std::exception &) {
+        Throw("ThreadPool: could not parse the core list \"%s\"!", str);
+    }
+}
+
+std::string ThreadPool::to_string() const {
+    std::ostringstream oss;
+    oss << "ThreadPool[" << std::endl
+        << "  thread_count = " << d->thread_count << "," << std::endl
+        << "  cores = [";
+    for (size_t i = 0; i < d->cores.size(); ++i)
+        oss << d->cores[i] << (i + 1 < d->cores.size() ? ", " : "");
+    oss << "]" << std::endl
+        << "]";
+    return oss.str();
+}
+
 MTS_IMPLEMENT_CLASS(Thread, Object)
 MTS_IMPLEMENT_CLASS(MainThread, Thread)
 MTS_IMPLEMENT_CLASS(WorkerThread, Thread)
+MTS_IMPLEMENT_CLASS(ThreadPool, Object)
 
 NAMESPACE_END(mitsuba)
@@ -0,0 +1,345 @@
+#include <mitsuba/core/tilecache.h>
+#include <mitsuba/core/fstream.h>
+#include <mitsuba/core/profiler.h>
+#include <mitsuba/core/util.h>
+#include <list>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+
+#define MTS_TILED_IMAGE_MAGIC "MTSTEX"
+#define MTS_TILED_IMAGE_VERSION 1
+
+/// Alignment of the tile data within a tiled image file
+#define MTS_TILED_IMAGE_ALIGNMENT 4096
+
+NAMESPACE_BEGIN(mitsuba)
+
+NAMESPACE_BEGIN(detail)
+/// Header of a tiled image file, followed by the (width, height) of each level
+struct TiledImageHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t channel_count;
+    uint32_t tile_size;
+    uint32_t level_count;
+    uint64_t tag;
+    uint64_t tile_count;
+    uint64_t tile_offset;
+};
+
+/// Bits of a cache key that hold the tile index (the rest holds the image ID)
+constexpr uint32_t tile_index_bits = 40;
+NAMESPACE_END(detail)
+
+// =======================================================================
+//! @{ \name TiledImage
+// =======================================================================
+
+static std::atomic<uint64_t> tiled_image_id { 0 };
+
+TiledImage::TiledImage(const fs::path &filename)
+    : m_id(tiled_image_id++) {
+    ref<MemoryMappedFile> mmap = new MemoryMappedFile(filename, false);
+    const uint8_t *data = (const uint8_t *) mmap->data();
+    size_t size = mmap->size();
+
+    detail::TiledImageHeader header;
+    if (size < sizeof(header))
+        Throw("\"%s\": file is truncated!", filename.string());
+    memcpy(&header, data, sizeof(header));
+
+    if (strncmp(header.magic, MTS_TILED_IMAGE_MAGIC, 8) != 0)
+        Throw("\"%s\": not a tiled image file!", filename.string());
+    if (header.version != MTS_TILED_IMAGE_VERSION)
+        Throw("\"%s\": unsupported version %u (expected %u)!", filename.string(),
+              header.version, MTS_TILED_IMAGE_VERSION);
+
+    m_channel_count = header.channel_count;
+    m_tile_size     = header.tile_size;
+    m_tile_count    = header.tile_count;
+    m_tag           = header.tag;
+
+    if (m_tile_size == 0 || m_channel_count == 0 ||
+        sizeof(header) + header.level_count * 2 * sizeof(uint32_t) > size)
+        Throw("\"%s\": invalid header!", filename.string());
+
+    const uint32_t *sizes = (const uint32_t *) (data + sizeof(header));
+    uint64_t tile_count = 0;
+    for (uint32_t i = 0; i < header.level_count; ++i) {
+        Level level;
+        level.size       = Vector2u(sizes[2 * i], sizes[2 * i + 1]);
+        level.tiles_x    = (level.size.x() + m_tile_size - 1) / m_tile_size;
+        level.first_tile = tile_count;
+        tile_count += (uint64_t) level.tiles_x *
+                      ((level.size.y() + m_tile_size - 1) / m_tile_size);
+        m_levels.push_back(level);
+    }
+
+    if (tile_count != m_tile_count ||
+        m_tile_count >= (uint64_t(1) << detail::tile_index_bits) ||
+        header.tile_offset > size || m_tile_count * tile_bytes() > size - header.tile_offset)
+        Throw("\"%s\": file is truncated!", filename.string());
+
+    m_tile_data = data + header.tile_offset;
+    m_file = mmap;
+
+    // Tiles are fetched on demand: don't read ahead of them
+    mmap->advise(MemoryMappedFile::Access::Random);
+}
+
+TiledImage::~TiledImage() {
+    TileCache::instance()->clear(this);
+}
+
+void TiledImage::write(const fs::path &filename,
+                       const std::vector<const float *> &levels,
+                       const std::vector<Vector2u> &sizes,
+                       uint32_t channel_count, uint32_t tile_size, uint64_t tag) {
+    if (levels.size() != sizes.size())
+        Throw("TiledImage::write(): expected one size per level!");
+
+    detail::TiledImageHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, MTS_TILED_IMAGE_MAGIC, sizeof(MTS_TILED_IMAGE_MAGIC));
+    header.version       = MTS_TILED_IMAGE_VERSION;
+    header.channel_count = channel_count;
+    header.tile_size     = tile_size;
+    header.level_count   = (uint32_t) levels.size();
+    header.tag           = tag;
+
+    for (const Vector2u &size : sizes)
+        header.tile_count += (uint64_t) ((size.x() + tile_size - 1) / tile_size) *
+                             ((size.y() + tile_size - 1) / tile_size);
+
+    size_t header_size = sizeof(header) + levels.size() * 2 * sizeof(uint32_t);
+    header.tile_offset = (header_size + MTS_TILED_IMAGE_ALIGNMENT - 1) /
+                         MTS_TILED_IMAGE_ALIGNMENT * MTS_TILED_IMAGE_ALIGNMENT;
+
+    // Write to a temporary file that replaces the target once complete
+    fs::path temp_path = filename.string() +
+        tfm::format(".%x.tmp", std::hash<std::thread::id>()(std::this_thread::get_id()));
+
+    {
+        ref<FileStream> stream = new FileStream(temp_path, FileStream::ETruncReadWrite);
+        stream->write(&header, sizeof(header));
+        for (const Vector2u &size : sizes)
+            stream->write(size.data(), 2 * sizeof(uint32_t));
+
+        std::vector<uint8_t> padding(header.tile_offset - header_size, 0);
+        stream->write(padding.data(), padding.size());
+
+        std::unique_ptr<float[]> tile(new float[(size_t) tile_size * tile_size * channel_count]);
+        for (size_t i = 0; i < levels.size(); ++i) {
+            const float *pixels = levels[i];
+            uint32_t width = sizes[i].x(), height = sizes[i].y();
+
+            for (uint32_t ty = 0; ty < height; ty += tile_size) {
+                for (uint32_t tx = 0; tx < width; tx += tile_size) {
+                    // Pad boundary tiles by repeating the last column and row
+                    float *target = tile.get();
+                    for (uint32_t y = 0; y < tile_size; ++y) {
+                        size_t row = std::min(ty + y, height - 1) * (size_t) width;
+                        for (uint32_t x = 0; x < tile_size; ++x) {
+                            const float *source =
+                                pixels + (row + std::min(tx + x, width - 1)) * channel_count;
+                            memcpy(target, source, channel_count * sizeof(float));
+                            target += channel_count;
+                        }
+                    }
+                    stream->write(tile.get(),
+                                  (size_t) tile_size * tile_size * channel_count * sizeof(float));
+                }
+            }
+        }
+    }
+
+    if (fs::exists(filename))
+        fs::remove(filename);
+    if (!fs::rename(temp_path, filename))
+        Throw("TiledImage::write(): could not rename \"%s\" to \"%s\"!",
+              temp_path.string(), filename.string());
+}
+
+void TiledImage::read_tile(uint64_t index, float *target) const {
+    if (index >= m_tile_count)
+        Throw("TiledImage::read_tile(): tile index %i is out of bounds!", index);
+    memcpy(target, m_tile_data + index * tile_bytes(), tile_bytes());
+}
+
+std::string TiledImage::to_string() const {
+    std::ostringstream oss;
+    oss << "TiledImage[" << std::endl
+        << "  filename = \"" << m_file->filename().string() << "\"," << std::endl
+        << "  size = " << level_size(0) << "," << std::endl
+        << "  levels = " << level_count() << "," << std::endl
+        << "  channel_count = " << m_channel_count << "," << std::endl
+        << "  tile_size = " << m_tile_size << std::endl
+        << "]";
+    return oss.str();
+}
+
+//! @}
+// =======================================================================
+
+// =======================================================================
+//! @{ \name TileCache
+// =======================================================================
+
+/// Number of independently locked parts of the cache
+static constexpr size_t tile_cache_shard_count = 64;
+
+struct TileCache::Shard {
+    struct Entry {
+        uint64_t key;
+        size_t size;
+        Tile tile;
+    };
+
+    std::mutex mutex;
+    /// Tiles ordered from the most to the least recently used one
+    std::list<Entry> lru;
+    std::unordered_map<uint64_t, std::list<Entry>::iterator> map;
+    size_t size = 0;
+    uint64_t hits = 0, misses = 0;
+
+    /**
+     * Evict tiles until at most \c capacity bytes remain, but keep the
+     * \c keep most recently used ones (requires the lock)
+     */
+    void trim(size_t capacity, size_t keep = 0) {
+        while (size > capacity && lru.size() > keep) {
+            const Entry &entry = lru.back();
+            size -= entry.size;
+            map.erase(entry.key);
+            lru.pop_back();
+        }
+    }
+};
+
+ref<TileCache> TileCache::m_instance = new TileCache();
+
+TileCache::TileCache()
+    : m_shards(new Shard[tile_cache_shard_count]), m_capacity((size_t) 1 << 30) { }
+
+TileCache::~TileCache() { }
+
+TileCache::Tile TileCache::tile(const TiledImage *image, uint32_t level, uint32_t x,
+                                uint32_t y, bool &hit) {
+    uint64_t index = image->tile_index(level, x, y),
+             key   = (image->id() << detail::tile_index_bits) | index;
+
+    // Spread neighboring tiles over different shards
+    Shard &shard = m_shards[(key * 0x9E3779B97F4A7C15ull) >> 58];
+    static_assert(tile_cache_shard_count == 64, "The shard index uses 6 bits");
+
+    {
+        std::lock_guard<std::mutex> guard(shard.mutex);
+        auto it = shard.map.find(key);
+        if (it != shard.map.end()) {
+            shard.lru.splice(shard.lru.begin(), shard.lru, it->second);
+            shard.hits++;
+            hit = true;
+            return it->second->tile;
+        }
+        shard.misses++;
+    }
+
+    // Load the tile without holding the lock
+    hit = false;
+    Tile tile;
+    {
+        ScopedPhase sp(ProfilerPhase::TileCacheLoad);
+        std::shared_ptr<float[]> data(new float[image->tile_bytes() / sizeof(float)]);
+        image->read_tile(index, data.get());
+        tile = std::move(data);
+    }
+
+    std::lock_guard<std::mutex> guard(shard.mutex);
+    auto it = shard.map.find(key);
+    if (it != shard.map.end()) // Another thread loaded the tile in the meantime
+        return it->second->tile;
+
+    shard.lru.push_front({ key, image->tile_bytes(), tile });
+    shard.map[key] = shard.lru.begin();
+    shard.size += image->tile_bytes();
+
+    // Keep the new tile even if it exceeds the capacity of the shard
+    shard.trim(m_capacity / tile_cache_shard_count, 1);
+
+    return tile;
+}
+
+void TileCache::set_capacity(size_t capacity) {
+    m_capacity = capacity;
+    for (size_t i = 0; i < tile_cache_shard_count; ++i) {
+        std::lock_guard<std::mutex> guard(m_shards[i].mutex);
+        m_shards[i].trim(capacity / tile_cache_shard_count);
+    }
+}
+
+size_t TileCache::capacity() const {
+    return m_capacity;
+}
+
+size_t TileCache::size() const {
+    size_t result = 0;
+    for (size_t i = 0; i < tile_cache_shard_count; ++i) {
+        std::lock_guard<std::mutex> guard(m_shards[i].mutex);
+        result += m_shards[i].size;
+    }
+    return result;
+}
+
+uint64_t TileCache::hit_count() const {
+    uint64_t result = 0;
+    for (size_t i = 0; i < tile_cache_shard_count; ++i) {
+        std::lock_guard<std::mutex> guard(m_shards[i].mutex);
+        result += m_shards[i].hits;
+    }
+    return result;
+}
+
+uint64_t TileCache::miss_count() const {
+    uint64_t result = 0;
+    for (size_t i = 0; i < tile_cache_shard_count; ++i) {
+        std::lock_guard<std::mutex> guard(m_shards[i].mutex);
+        result += m_shards[i].misses;
+    }
+    return result;
+}
+
+void TileCache::clear(const TiledImage *image) {
+    for (size_t i = 0; i < tile_cache_shard_count; ++i) {
+        Shard &shard = m_shards[i];
+        std::lock_guard<std::mutex> guard(shard.mutex);
+        for (auto it = shard.lru.begin(); it != shard.lru.end(); ) {
+            if (!image || (it->key >> detail::tile_index_bits) == image->id()) {
+                shard.size -= it->size;
+                shard.map.erase(it->key);
+                it = shard.lru.erase(it);
+            } else {
+                ++it;
+            }
+        }
+    }
+}
+
+std::string TileCache::to_string() const {
+    std::ostringstream oss;
+    oss << "TileCache[" << std::endl
+        << "  capacity = " << util::mem_string(capacity()) << "," << std::endl
+        << "  size = " << util::mem_string(size()) << "," << std::endl
+        << "  hits = " << hit_count() << "," << std::endl
+        << "  misses = " << miss_count() << std::endl
+        << "]";
+    return oss.str();
+}
+
+//! @}
+// =======================================================================
+
+MTS_IMPLEMENT_CLASS(TiledImage, Object)
+MTS_IMPLEMENT_CLASS(TileCache, Object)
+
+NAMESPACE_END(mitsuba)
@@ -1,10 +1,11 @@
 #include <mitsuba/core/tls.h>
 #include <tbb/spin_mutex.h>
 #include <tbb/mutex.h>
+#include <algorithm>
 #include <stdexcept>
-#include <unordered_map>
 #include <unordered_set>
 #include <list>
+#include <vector>
 
 #if defined(__OSX__)
   #include <pthread.h>
@@ -13,15 +14,19 @@
 NAMESPACE_BEGIN(mitsuba)
 
 struct TLSEntry {
-    void *data;
-    ThreadLocalBase::DestructFunctor destruct;
-    std::list<TLSEntry *>::iterator iterator;
+    void *data = nullptr;
+    ThreadLocalBase::DestructFunctor destruct = nullptr;
+    std::list<uint32_t>::iterator iterator;
 };
 
 struct PerThreadData {
+    /* Protects the slots against concurrent modification. Only the owning
+       thread resizes 'slots', hence it may read them without locking */
     tbb::spin_mutex mutex;
-    std::unordered_map<ThreadLocalBase *, TLSEntry> entries;
-    std::list<TLSEntry *> entries_ordered;
+    /// TLS entries indexed by the key of their TLS object (data == nullptr if unset)
+    std::vector<TLSEntry> slots;
+    /// Keys of the entries in the order of their creation
+    std::list<uint32_t> entries_ordered;
     uint32_t ref_count = 1;
 };
 
@@ -36,15 +41,32 @@ struct PerThreadData {
 /// List of all PerThreadData data structures (one for each thread)
 static std::unordered_set<PerThreadData *> ptd_global;
 
-/// Lock to protect ptd_global
+/// Lock to protect ptd_global and the key allocator
 static tbb::mutex ptd_global_lock;
 
+/// Number of keys that were handed out, and keys of destroyed TLS objects
+static uint32_t key_count = 0;
+static std::vector<uint32_t> free_keys;
+
 ThreadLocalBase::ThreadLocalBase(const ConstructFunctor &construct_functor,
                                  const DestructFunctor &destruct_functor)
-    : m_construct_functor(construct_functor), m_destruct_functor(destruct_functor) { }
+    : m_construct_functor(construct_functor), m_destruct_functor(destruct_functor) {
+    tbb::mutex::scoped_lock guard(ptd_global_lock);
+    if (!free_keys.empty()) {
+        m_key = free_keys.back();
+        free_keys.pop_back();
+    } else {
+        m_key = key_count++;
+    }
+}
 
 ThreadLocalBase::~ThreadLocalBase() {
     clear();
+
+    /* No thread holds an entry with this key anymore, which makes it
+       available for the next TLS object */
+    tbb::mutex::scoped_lock guard(ptd_global_lock);
+    free_keys.push_back(m_key);
 }
 
 void ThreadLocalBase::clear() {
@@ -55,15 +77,15 @@ void ThreadLocalBase::clear() {
         tbb::spin_mutex::scoped_lock guard2(ptd->mutex);
 
         /* If the current TLS object is referenced, destroy the contents */
-        auto it2 = ptd->entries.find(this);
-        if (it2 == ptd->entries.end())
+        if (m_key >= ptd->slots.size() || !ptd->slots[m_key].data)
             continue;
 
-        auto entry = it2->second;
+        TLSEntry &entry = ptd->slots[m_key];
+        void *data = entry.data;
         ptd->entries_ordered.erase(entry.iterator);
-        ptd->entries.erase(it2);
+        entry.data = nullptr;
         guard2.release();
-        m_destruct_functor(entry.data);
+        m_destruct_functor(data);
     }
 }
 
@@ -81,26 +103,40 @@ void *ThreadLocalBase::get() {
             "Internal error: call to ThreadLocalPrivate::get() precedes the "
             "construction of thread-specific data structures!");
 
-    /* This is an uncontended thread-local lock (i.e. not to worry) */
-    tbb::spin_mutex::scoped_lock guard(ptd->mutex);
+    /* Lock-free: the slots of a thread are only resized by the thread itself,
+       and other threads only release entries in clear() (which must not run
+       concurrently with accesses) */
+    if (likely(m_key < ptd->slots.size())) {
+        void *data = ptd->slots[m_key].data;
+        if (likely(data))
+            return data;
+    }
 
-    auto it = ptd->entries.find(this);
-    if (likely(it != ptd->entries.end()))
-        return it->second.data;
+    return create();
+}
+
+void *ThreadLocalBase::create() {
+    #if defined(__OSX__)
+        PerThreadData *ptd = (PerThreadData *) pthread_getspecific(ptd_local);
+    #else
+        PerThreadData *ptd = ptd_local;
+    #endif
 
-    /* This is the first access from this thread */
-    ptd->entries.insert(std::make_pair(this, TLSEntry {
-        m_construct_functor(),
-        m_destruct_functor,
-        std::list<TLSEntry *>::iterator()
-    }));
+    /* This is the first access from this thread. Construct the data before
+       locking, since the constructor may itself access TLS objects. */
+    void *data = m_construct_functor();
 
-    TLSEntry &entry = ptd->entries.find(this)->second;
+    tbb::spin_mutex::scoped_lock guard(ptd->mutex);
+    if (m_key >= ptd->slots.size())
+        ptd->slots.resize(std::max((size_t) m_key + 1, ptd->slots.size() * 2));
 
-    ptd->entries_ordered.push_back(&entry);
+    TLSEntry &entry = ptd->slots[m_key];
+    entry.data = data;
+    entry.destruct = m_destruct_functor;
+    ptd->entries_ordered.push_back(m_key);
     entry.iterator = --ptd->entries_ordered.end();
 
-    return entry.data;
+    return data;
 }
 
 void ThreadLocalBase::static_initialization() {
@@ -158,8 +194,10 @@ bool ThreadLocalBase::unregister_thread() {
     if (ptd->ref_count == 0) {
         tbb::spin_mutex::scoped_lock local_guard(ptd->mutex);
         for (auto it = ptd->entries_ordered.rbegin();
-             it != ptd->entries_ordered.rend(); ++it)
-            (*it)->destruct((*it)->data);
+             it != ptd->entries_ordered.rend(); ++it) {
+            TLSEntry &entry = ptd->slots[*it];
+            entry.destruct(entry.data);
+        }
 
         local_guard.release();
         ptd_global.erase(ptd);
@@ -12,13 +12,16 @@
 #  include <unistd.h>
 #  include <limits.h>
 #  include <sys/ioctl.h>
+#  include <sys/resource.h>
 #elif defined(__OSX__)
 #  include <sys/sysctl.h>
 #  include <mach-o/dyld.h>
 #  include <unistd.h>
 #  include <sys/ioctl.h>
+#  include <sys/resource.h>
 #elif defined(__WINDOWS__)
 #  include <windows.h>
+#  include <psapi.h>
 #endif
 
 NAMESPACE_BEGIN(mitsuba)
@@ -118,6 +121,24 @@ done:
 #endif
 }
 
+size_t peak_memory_usage() {
+#if defined(__WINDOWS__)
+    PROCESS_MEMORY_COUNTERS counters;
+    if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+        return 0;
+    return (size_t) counters.PeakWorkingSetSize;
+#else
+    rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0)
+        return 0;
+#  if defined(__OSX__)
+    return (size_t) usage.ru_maxrss; // bytes
+#  else
+    return (size_t) usage.ru_maxrss * 1024; // kilobytes
+#  endif
+#endif
+}
+
 bool detect_debugger() {
 #if defined(__LINUX__)
     char exePath[PATH_MAX];
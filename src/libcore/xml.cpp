@@ -1,12 +1,17 @@
+#include <atomic>
 #include <cctype>
 #include <fstream>
+#include <mutex>
 #include <set>
 #include <unordered_map>
 
+#include <mitsuba/core/arena.h>
 #include <mitsuba/core/class.h>
 #include <mitsuba/core/config.h>
 #include <mitsuba/core/filesystem.h>
 #include <mitsuba/core/fresolver.h>
+#include <mitsuba/core/fstream.h>
+#include <mitsuba/core/hash.h>
 #include <mitsuba/core/logger.h>
 #include <mitsuba/core/math.h>
 #include <mitsuba/core/object.h>
@@ -30,13 +35,16 @@
 #  undef minor
 #endif
 
+#define MTS_XML_CACHE_MAGIC "MTS_XMC"
+#define MTS_XML_CACHE_VERSION 1
+
 NAMESPACE_BEGIN(mitsuba)
 NAMESPACE_BEGIN(xml)
 
 // Set of supported XML tags
 enum class Tag {
     Boolean, Integer, Float, String, Point, Vector, Spectrum, RGB,
-    Transform, Translate, Matrix, Rotate, Scale, LookAt, Object,
+    Transform, Translate, Matrix, Rotate, Scale, LookAt, Animation, Object,
     NamedReference, Include, Alias, Default, Resource, Invalid
 };
 
@@ -84,6 +92,13 @@ bool is_unbounded_spectrum(const std::string &name) {
     return name == "eta" || name == "k" || name == "int_ior" || name == "ext_ior";
 }
 
+/// Directory of the scene cache (disabled when empty)
+static fs::path xml_cache_dir;
+static std::mutex xml_cache_mutex;
+
+/// Share identical BSDFs and textures between their users? (see set_deduplication())
+static std::atomic<bool> xml_deduplication { false };
+
 NAMESPACE_BEGIN(detail)
 
 using Float = float;
@@ -141,6 +156,7 @@ void register_class(const Class *class_) {
         (*tags)["rotate"]        = Tag::Rotate;
         (*tags)["scale"]         = Tag::Scale;
         (*tags)["lookat"]        = Tag::LookAt;
+        (*tags)["animation"]     = Tag::Animation;
         (*tags)["ref"]           = Tag::NamedReference;
         (*tags)["spectrum"]      = Tag::Spectrum;
         (*tags)["rgb"]           = Tag::RGB;
@@ -225,6 +241,8 @@ struct XMLSource {
 };
 
 struct XMLObject {
+    XMLObject(MemoryArena *arena = nullptr) : props("", arena) { }
+
     Properties props;
     const Class *class_ = nullptr;
     std::string src_id;
@@ -262,19 +280,99 @@ bool check_cuda() {
 }
 
 
+/// Arguments of an object that was created while parsing (used by the scene cache)
+struct ParsedObject {
+    enum class Kind : uint32_t { RGB, Spectrum, Animation };
+
+    Kind kind = Kind::RGB;
+    std::string name;
+    bool within_emitter = false;
+    Color3f color;                                        // Kind::RGB
+    Float const_value = 1.f;                              // Kind::Spectrum
+    std::vector<Float> wavelengths, values;               // Kind::Spectrum
+    std::vector<std::pair<Float, Transform4f>> keyframes; // Kind::Animation
+
+    /// Compare the arguments of RGB and spectrum textures (see InstanceCache)
+    bool operator==(const ParsedObject &p) const {
+        return kind == p.kind && name == p.name && within_emitter == p.within_emitter &&
+               color == p.color && const_value == p.const_value &&
+               wavelengths == p.wavelengths && values == p.values;
+    }
+};
+
+/// Storage of an \ref InstanceCache
+struct InstanceCacheData {
+    struct Instance {
+        const Class *class_;
+        Properties props;
+        ref<Object> object;
+    };
+
+    using InstanceMap = std::unordered_map<std::string, Instance>;
+    using ParsedList  = std::vector<std::pair<ParsedObject, ref<Object>>>;
+
+    /// Objects of the previous load by node ID, and the textures created while parsing it
+    InstanceMap instances;
+    ParsedList parsed;
+
+    /// Objects of the current load, which replace the above once it succeeds
+    InstanceMap next_instances;
+    std::mutex mutex;
+
+    std::atomic<size_t> reused { 0 }, updated { 0 }, created { 0 };
+};
+
 struct XMLParseContext {
-    std::unordered_map<std::string, XMLObject> instances;
+    /* Storage of the intermediate objects of the parser, which is released at
+       once with the context (declared first so that it is destroyed last) */
+    MemoryArena arena;
+
+    using InstanceMap =
+        std::unordered_map<std::string, XMLObject, std::hash<std::string>,
+                           std::equal_to<std::string>,
+                           ArenaAllocator<std::pair<const std::string, XMLObject>>>;
+    InstanceMap instances;
     Transform4f transform;
+    ref<AnimatedTransform> animation;
     size_t id_counter = 0;
     bool parallelize;
     ColorMode color_mode;
 
-    XMLParseContext(const std::string &variant) : variant(variant) {
+    /// Files read while parsing (included XML files and spectra)
+    std::vector<fs::path> dependencies;
+
+    /// Arguments of the objects created while parsing
+    std::unordered_map<const Object *, ParsedObject> parsed_objects;
+
+    /// Objects of the previous load of the scene (may be \c nullptr)
+    InstanceCacheData *cache = nullptr;
+
+    /// An object that is shared by all nodes with identical properties
+    struct SharedObject {
+        const Class *class_;
+        Properties props;
+        ref<Object> object;
+    };
+
+    /// Share identical BSDFs and textures? (see \ref xml::set_deduplication())
+    bool deduplicate = false;
+
+    /// Shared objects and textures created while parsing, by the hash of their properties
+    std::unordered_map<size_t, std::vector<SharedObject>> shared_objects;
+    std::unordered_map<size_t, std::vector<std::pair<ParsedObject, ref<Object>>>> shared_parsed;
+    std::mutex shared_mutex;
+    std::atomic<size_t> shared_count { 0 };
+
+    XMLParseContext(const std::string &variant)
+        : instances(0, std::hash<std::string>(), std::equal_to<std::string>(),
+                    InstanceMap::allocator_type(&arena)),
+          variant(variant) {
         color_mode = MTS_INVOKE_VARIANT(variant, variant_to_color_mode);
 
         /* Don't load the scene in parallel when running in GPU mode
            (The Enoki CUDA backend is currently not multi-threaded) */
         parallelize = !MTS_INVOKE_VARIANT(variant, check_cuda);
+        deduplicate = xml_deduplication;
     }
 
     std::string variant;
@@ -439,6 +537,122 @@ void upgrade_tree(XMLSource &src, pugi::xml_node &node, const Version &version)
     src.modified = true;
 }
 
+/// Return an identical texture created while parsing the previous load (see InstanceCache)
+static ref<Object> cached_parsed_object(XMLParseContext &ctx, const ParsedObject &parsed) {
+    if (!ctx.cache)
+        return nullptr;
+    for (const auto &kv : ctx.cache->parsed) {
+        if (kv.first == parsed)
+            return kv.second;
+    }
+    return nullptr;
+}
+
+/// Hash of the arguments compared by ParsedObject::operator==()
+static size_t hash_parsed_object(const ParsedObject &parsed) {
+    size_t value = hash_combine(hash(parsed.kind), hash(parsed.name));
+    value = hash_combine(value, (size_t) parsed.within_emitter);
+    for (size_t i = 0; i < 3; ++i)
+        value = hash_combine(value, hash(parsed.color[i]));
+    value = hash_combine(value, hash(parsed.const_value));
+    value = hash_combine(value, (size_t) hash_buffer(parsed.wavelengths.data(),
+                                                     parsed.wavelengths.size() * sizeof(Float)));
+    return hash_combine(value, (size_t) hash_buffer(parsed.values.data(),
+                                                    parsed.values.size() * sizeof(Float)));
+}
+
+/**
+ * \brief Return the texture created for \c parsed, reusing an identical one
+ * from this load or from the previous load (see InstanceCache) if possible
+ *
+ * \c create is only invoked when neither exists.
+ */
+template <typename Create>
+static ref<Object> parsed_object(XMLParseContext &ctx, const ParsedObject &parsed,
+                                 Create &&create) {
+    ref<Object> obj = cached_parsed_object(ctx, parsed);
+    if (!ctx.deduplicate)
+        return obj ? obj : create();
+
+    // The parser runs on a single thread, no locking is needed
+    auto &bucket = ctx.shared_parsed[hash_parsed_object(parsed)];
+    for (const auto &kv : bucket) {
+        if (kv.first == parsed) {
+            ctx.shared_count++;
+            return kv.second;
+        }
+    }
+
+    if (!obj)
+        obj = create();
+    bucket.emplace_back(parsed, obj);
+    return obj;
+}
+
+/**
+ * \brief Hash of the plugin name and the properties of a node, whose
+ * references were already replaced by the objects that they refer to
+ *
+ * Identical nested objects are shared before their parents are created,
+ * hence a comparison of the object pointers suffices.
+ */
+static size_t hash_properties(const Class *class_, const Properties &props) {
+    size_t value = hash_combine(hash(class_), hash(props.plugin_name()));
+
+    std::vector<std::string> names = props.property_names();
+    std::sort(names.begin(), names.end());
+    for (const std::string &name : names) {
+        value = hash_combine(value, hash(name));
+        Properties::Type type = props.type(name);
+        value = hash_combine(value, hash(type));
+        // Objects are hashed below, without marking them as queried
+        if (type != Properties::Type::Object)
+            value = hash_combine(value, hash(props.as_string(name)));
+    }
+
+    for (const auto &kv : props.objects(false))
+        value = hash_combine(value, hash((const Object *) kv.second.get()));
+    return value;
+}
+
+/**
+ * \brief Can an object be shared by several parents? (see set_deduplication())
+ *
+ * Only BSDFs and textures are shared, unless they opt out with a \c shared
+ * property equal to \c false (e.g. bitmap textures that are optimized
+ * separately). The property is not marked as queried.
+ */
+static bool is_shareable(const Class *class_, const Properties &props) {
+    if (class_->name() != "BSDF" && class_->name() != "Texture")
+        return false;
+    return !(props.has_property("shared") &&
+             props.type("shared") == Properties::Type::Bool &&
+             props.as_string("shared") == "false");
+}
+
+/**
+ * \brief Look up an object with the same class and properties as \c inst
+ * that was created during this load
+ *
+ * When \c object is specified and no such object exists, \c object is
+ * registered for the following nodes instead. The node IDs are ignored.
+ */
+static ref<Object> shared_object(XMLParseContext &ctx, size_t key, const XMLObject &inst,
+                                 Object *object = nullptr) {
+    std::lock_guard<std::mutex> guard(ctx.shared_mutex);
+    auto &bucket = ctx.shared_objects[key];
+    for (const XMLParseContext::SharedObject &shared : bucket) {
+        if (shared.class_ == inst.class_ &&
+            shared.props.plugin_name() == inst.props.plugin_name() &&
+            shared.props.differing_properties(inst.props).empty())
+            return shared.object;
+    }
+
+    if (object)
+        bucket.push_back({ inst.class_, inst.props, object });
+    return object;
+}
+
 static std::pair<std::string, std::string> parse_xml(XMLSource &src, XMLParseContext &ctx,
                                                      pugi::xml_node &node, Tag parent_tag,
                                                      Properties &props, ParameterList &param,
@@ -480,6 +694,7 @@ static std::pair<std::string, std::string> parse_xml(XMLSource &src, XMLParseCon
         bool parent_is_object        = has_parent && parent_tag == Tag::Object;
         bool current_is_object       = tag == Tag::Object;
         bool parent_is_transform     = parent_tag == Tag::Transform;
+        bool parent_is_animation     = parent_tag == Tag::Animation;
         bool current_is_transform_op = tag == Tag::Translate || tag == Tag::Rotate ||
                                        tag == Tag::Scale || tag == Tag::LookAt ||
                                        tag == Tag::Matrix;
@@ -494,7 +709,11 @@ static std::pair<std::string, std::string> parse_xml(XMLSource &src, XMLParseCon
                 src.throw_error(node, "transform operations can only occur in a transform node");
         }
 
-        if (has_parent && !parent_is_object && !(parent_is_transform && current_is_transform_op))
+        if (parent_is_animation && tag != Tag::Transform)
+            src.throw_error(node, "animation nodes can only contain transform nodes");
+
+        if (has_parent && !parent_is_object && !(parent_is_transform && current_is_transform_op) &&
+            !parent_is_animation)
             src.throw_error(node, "node \"%s\" cannot occur as child of a property", node.name());
 
         auto version_attr = node.attribute("version");
@@ -549,7 +768,7 @@ static std::pair<std::string, std::string> parse_xml(XMLSource &src, XMLParseCon
                                 type      = node.attribute("type").value(),
                                 node_name = node.name();
 
-                    Properties props_nested(type);
+                    Properties props_nested(type, &ctx.arena);
                     props_nested.set_id(id);
 
                     auto it_inst = ctx.instances.find(id);
@@ -573,7 +792,7 @@ static std::pair<std::string, std::string> parse_xml(XMLSource &src, XMLParseCon
                             props_nested.set_named_reference(arg_name, nested_id);
                     }
 
-                    auto &inst = ctx.instances[id];
+                    auto &inst = ctx.instances.try_emplace(id, &ctx.arena).first->second;
                     inst.props = props_nested;
                     inst.class_ = it2->second;
                     inst.offset = src.offset;
@@ -603,7 +822,7 @@ static std::pair<std::string, std::string> parse_xml(XMLSource &src, XMLParseCon
                     if (it_alias_src == ctx.instances.end())
                         src.throw_error(node, "referenced id \"%s\" not found", alias_src);
 
-                    auto &inst = ctx.instances[alias_dst];
+                    auto &inst = ctx.instances.try_emplace(alias_dst, &ctx.arena).first->second;
                     inst.alias = alias_src;
                     inst.offset = src.offset;
                     inst.src_id = src.id;
@@ -656,6 +875,7 @@ static std::pair<std::string, std::string> parse_xml(XMLSource &src, XMLParseCon
                     fs::path filename = fs->resolve(node.attribute("filename").value());
                     if (!fs::exists(filename))
                         src.throw_error(node, "included file \"%s\" not found", filename);
+                    ctx.dependencies.push_back(filename);
 
                     Log(Info, "Loading included XML file \"%s\" ..", filename);
 
@@ -794,9 +1014,18 @@ static std::pair<std::string, std::string> parse_xml(XMLSource &src, XMLParseCon
 
                     if (!within_spectrum) {
                         std::string name = node.attribute("name").value();
-                        ref<Object> obj = detail::create_texture_from_rgb(
-                            name, color, ctx.variant, within_emitter);
+                        ParsedObject parsed;
+                        parsed.kind = ParsedObject::Kind::RGB;
+                        parsed.name = name;
+                        parsed.within_emitter = within_emitter;
+                        parsed.color = color;
+
+                        ref<Object> obj = parsed_object(ctx, parsed, [&]() {
+                            return detail::create_texture_from_rgb(
+                                name, color, ctx.variant, within_emitter);
+                        });
                         props.set_object(name, obj);
+                        ctx.parsed_objects[obj.get()] = std::move(parsed);
                     } else {
                         props.set_color("color", color);
                     }
@@ -848,25 +1077,46 @@ static std::pair<std::string, std::string> parse_xml(XMLSource &src, XMLParseCon
                             }
                         } else if (has_filename) {
                             spectrum_from_file(node.attribute("filename").value(), wavelengths, values);
+                            ctx.dependencies.push_back(Thread::thread()->file_resolver()->resolve(
+                                node.attribute("filename").value()));
                         }
                     }
 
-                    ref<Object> obj = detail::create_texture_from_spectrum(
-                        name, const_value, wavelengths, values, ctx.variant,
-                        within_emitter,
-                        ctx.color_mode == ColorMode::Spectral,
-                        ctx.color_mode == ColorMode::Monochromatic);
+                    // Keep the parsed values, which are rescaled by create_texture_from_spectrum()
+                    ParsedObject parsed;
+                    parsed.kind = ParsedObject::Kind::Spectrum;
+                    parsed.name = name;
+                    parsed.within_emitter = within_emitter;
+                    parsed.const_value = const_value;
+                    parsed.wavelengths = wavelengths;
+                    parsed.values = values;
+
+                    ref<Object> obj = parsed_object(ctx, parsed, [&]() {
+                        return detail::create_texture_from_spectrum(
+                            name, const_value, wavelengths, values, ctx.variant,
+                            within_emitter,
+                            ctx.color_mode == ColorMode::Spectral,
+                            ctx.color_mode == ColorMode::Monochromatic);
+                    });
 
                     props.set_object(name, obj);
+                    ctx.parsed_objects[obj.get()] = std::move(parsed);
                 }
                 break;
 
             case Tag::Transform: {
-                    check_attributes(src, node, { "name" });
+                    // Transforms within an animation are keyframes
+                    check_attributes(src, node, { parent_is_animation ? "time" : "name" });
                     ctx.transform = Transform4f();
                 }
                 break;
 
+            case Tag::Animation: {
+                    check_attributes(src, node, { "name" });
+                    ctx.animation = new AnimatedTransform();
+                }
+                break;
+
             case Tag::Rotate: {
                     detail::expand_value_to_xyz(src, node);
                     check_attributes(src, node, { "angle", "x", "y", "z" }, false);
@@ -961,8 +1211,27 @@ static std::pair<std::string, std::string> parse_xml(XMLSource &src, XMLParseCon
         for (pugi::xml_node &ch: node.children())
             parse_xml(src, ctx, ch, tag, props, param, arg_counter, depth + 1);
 
-        if (tag == Tag::Transform)
+        if (tag == Tag::Transform && parent_tag == Tag::Animation) {
+            std::string time = node.attribute("time").value();
+            Float time_float;
+            try {
+                time_float = detail::stof(time);
+            } catch (...) {
+                src.throw_error(node, "could not parse floating point value \"%s\"", time);
+            }
+            ctx.animation->append(time_float, ctx.transform);
+            ctx.parsed_objects[ctx.animation.get()].keyframes.emplace_back(time_float, ctx.transform);
+        } else if (tag == Tag::Transform) {
             props.set_transform(node.attribute("name").value(), ctx.transform);
+        } else if (tag == Tag::Animation) {
+            if (ctx.animation->size() == 0)
+                src.throw_error(node, "animation must contain at least one keyframe");
+            props.set_animated_transform(node.attribute("name").value(), ctx.animation);
+            ParsedObject &parsed = ctx.parsed_objects[ctx.animation.get()];
+            parsed.kind = ParsedObject::Kind::Animation;
+            parsed.name = node.attribute("name").value();
+            ctx.animation = nullptr;
+        }
     } catch (const std::exception &e) {
         if (strstr(e.what(), "Error while loading") == nullptr)
             src.throw_error(node, "%s", e.what());
@@ -973,6 +1242,94 @@ static std::pair<std::string, std::string> parse_xml(XMLSource &src, XMLParseCon
     return std::make_pair("", "");
 }
 
+/// Collects the parameters of an object and of its direct children
+struct ParameterCollector : public TraversalCallback {
+    struct Parameter {
+        const std::type_info *type;
+        void *ptr;
+        Object *owner;
+    };
+
+    ParameterCollector(Object *owner, const std::string &prefix = "", bool recurse = true)
+        : owner(owner), prefix(prefix), recurse(recurse) { }
+
+    void put_parameter_impl(const std::string &name, const std::type_info &type,
+                            void *ptr) override {
+        params[prefix + name] = Parameter{ &type, ptr, owner };
+    }
+
+    void put_object(const std::string &name, Object *obj) override {
+        if (!recurse || !obj)
+            return;
+        ParameterCollector child(obj, prefix + name + ".", false);
+        obj->traverse(&child);
+        params.insert(child.params.begin(), child.params.end());
+    }
+
+    std::unordered_map<std::string, Parameter> params;
+    Object *owner;
+    std::string prefix;
+    bool recurse;
+};
+
+/**
+ * \brief Try to reuse the object that the previous load created for the
+ * node \c id (see \ref InstanceCache)
+ *
+ * The properties must be identical, except for floating point values that
+ * the object exposes through traverse(), which are then updated in place.
+ */
+static bool reuse_instance(XMLParseContext &ctx, const std::string &id, XMLObject &inst) {
+    auto it = ctx.cache->instances.find(id);
+    if (it == ctx.cache->instances.end() || it->second.class_ != inst.class_)
+        return false;
+    const InstanceCacheData::Instance &prev = it->second;
+
+    std::vector<std::string> changed = inst.props.differing_properties(prev.props);
+    if (!changed.empty()) {
+        for (const std::string &name : changed) {
+            if (!inst.props.has_property(name) || !prev.props.has_property(name) ||
+                inst.props.type(name) != Properties::Type::Float ||
+                prev.props.type(name) != Properties::Type::Float)
+                return false;
+        }
+
+        ParameterCollector collector(prev.object.get());
+        prev.object->traverse(&collector);
+
+        // Either a parameter with the same name, or the value of a uniform texture created from it
+        std::vector<ParameterCollector::Parameter> targets;
+        for (const std::string &name : changed) {
+            auto it2 = collector.params.find(name);
+            if (it2 == collector.params.end())
+                it2 = collector.params.find(name + ".value");
+            if (it2 == collector.params.end() ||
+                (*it2->second.type != typeid(float) && *it2->second.type != typeid(double)))
+                return false;
+            targets.push_back(it2->second);
+        }
+
+        for (size_t i = 0; i < changed.size(); ++i) {
+            Properties::Float value = inst.props.float_(changed[i]);
+            const ParameterCollector::Parameter &target = targets[i];
+            if (*target.type == typeid(float))
+                *(float *) target.ptr = (float) value;
+            else
+                *(double *) target.ptr = (double) value;
+
+            if (target.owner != prev.object.get())
+                target.owner->parameters_changed({ "value" });
+        }
+        prev.object->parameters_changed(changed);
+        ctx.cache->updated++;
+    } else {
+        ctx.cache->reused++;
+    }
+
+    inst.object = prev.object;
+    return true;
+}
+
 static ref<Object> instantiate_node(XMLParseContext &ctx, const std::string &id) {
     auto it = ctx.instances.find(id);
     if (it == ctx.instances.end())
@@ -992,6 +1349,10 @@ static ref<Object> instantiate_node(XMLParseContext &ctx, const std::string &id)
     Properties &props = inst.props;
     const auto &named_references = props.named_references();
 
+    /* The expanded children of each reference, which are only added to 'props'
+       once all of them are available (Properties is not thread-safe) */
+    std::vector<std::vector<ref<Object>>> results(named_references.size());
+
     ThreadEnvironment env;
 
     auto functor = [&](const tbb::blocked_range<uint32_t> &range) {
@@ -1011,16 +1372,9 @@ static ref<Object> instantiate_node(XMLParseContext &ctx, const std::string &id)
                     instantiate_recursively();
 
                 // Give the object a chance to recursively expand into sub-objects
-                std::vector<ref<Object>> children = obj->expand();
-                if (children.empty()) {
-                    props.set_object(kv.first, obj, false);
-                } else if (children.size() == 1) {
-                    props.set_object(kv.first, children[0], false);
-                } else {
-                    int ctr = 0;
-                    for (auto c : children)
-                        props.set_object(kv.first + "_" + std::to_string(ctr++), c, false);
-                }
+                results[i] = obj->expand();
+                if (results[i].empty())
+                    results[i].push_back(obj);
             } catch (const std::exception &e) {
                 if (strstr(e.what(), "Error while loading") == nullptr)
                     Throw("Error while loading \"%s\" (near %s): %s",
@@ -1038,7 +1392,46 @@ static ref<Object> instantiate_node(XMLParseContext &ctx, const std::string &id)
     else
         functor(range);
 
+    for (size_t i = 0; i < named_references.size(); ++i) {
+        const std::string &name = named_references[i].first;
+        const std::vector<ref<Object>> &children = results[i];
+        if (children.size() == 1) {
+            props.set_object(name, children[0], false);
+        } else {
+            int ctr = 0;
+            for (auto c : children)
+                props.set_object(name + "_" + std::to_string(ctr++), c, false);
+        }
+    }
+
+    // Share the object of an identical node (see set_deduplication())
+    bool shareable = ctx.deduplicate && is_shareable(inst.class_, props);
+    size_t shared_key = shareable ? hash_properties(inst.class_, props) : 0;
+    if (shareable) {
+        ref<Object> shared = shared_object(ctx, shared_key, inst);
+        if (shared) {
+            inst.object = shared;
+            ctx.shared_count++;
+            if (ctx.cache) {
+                std::lock_guard<std::mutex> guard(ctx.cache->mutex);
+                ctx.cache->next_instances[id] = { inst.class_, props, inst.object };
+            }
+            return inst.object;
+        }
+    }
+
+    if (ctx.cache && reuse_instance(ctx, id, inst)) {
+        if (shareable)
+            inst.object = shared_object(ctx, shared_key, inst, inst.object);
+        std::lock_guard<std::mutex> guard(ctx.cache->mutex);
+        ctx.cache->next_instances[id] = { inst.class_, props, inst.object };
+        return inst.object;
+    }
+
     try {
+        ScopedLoadEvent load_event(LoadEvent::Instantiate, id,
+                                   string::to_lower(inst.class_->name()) +
+                                   (props.plugin_name().empty() ? "" : ", " + props.plugin_name()));
         inst.object = PluginManager::instance()->create_object(props, inst.class_);
     } catch (const std::exception &e) {
         Throw("Error while loading \"%s\" (near %s): could not instantiate "
@@ -1067,9 +1460,124 @@ static ref<Object> instantiate_node(XMLParseContext &ctx, const std::string &id)
               unqueried.size() > 1 ? "properties" : "property", unqueried,
               string::to_lower(inst.class_->name()), props.plugin_name());
     }
+
+    // Another thread may have created an identical object first, which is then used instead
+    if (shareable)
+        inst.object = shared_object(ctx, shared_key, inst, inst.object);
+
+    if (ctx.cache) {
+        std::lock_guard<std::mutex> guard(ctx.cache->mutex);
+        ctx.cache->next_instances[id] = { inst.class_, props, inst.object };
+        ctx.cache->created++;
+    }
     return inst.object;
 }
 
+/**
+ * \brief Instantiate the objects referenced (directly or indirectly) by the
+ * node \c id, ordered by their dependencies
+ *
+ * \ref instantiate_node() creates the references of a node in parallel,
+ * but the objects that are shared by several parents (e.g. a BSDF used by
+ * many shapes) make the threads that reach them wait for the first one.
+ * This function instead groups the nodes by their height in the dependency
+ * graph and creates each group in parallel, starting with the nodes that
+ * have no references. Every node then finds the objects that it references
+ * ready when it is instantiated.
+ */
+static void instantiate_graph(XMLParseContext &ctx, const std::string &id) {
+    // Height of each node in the dependency graph (-1: being visited)
+    std::unordered_map<std::string, int> height;
+    std::vector<std::vector<std::string>> levels;
+
+    std::function<int(const std::string &)> visit = [&](const std::string &node_id) -> int {
+        auto it = ctx.instances.find(node_id);
+        if (it == ctx.instances.end())
+            Throw("reference to unknown object \"%s\"!", node_id);
+        XMLObject &inst = it->second;
+        if (!inst.alias.empty())
+            return visit(inst.alias);
+
+        auto it2 = height.find(node_id);
+        if (it2 != height.end()) {
+            if (it2->second < 0)
+                Throw("Error while loading \"%s\" (near %s): cyclic reference to \"%s\"!",
+                      inst.src_id, inst.offset(inst.location), node_id);
+            return it2->second;
+        }
+        height[node_id] = -1;
+
+        int h = 0;
+        if (!inst.object) {
+            for (const auto &kv : inst.props.named_references()) {
+                if (ctx.instances.find(kv.second) == ctx.instances.end())
+                    Throw("Error while loading \"%s\" (near %s): reference to unknown "
+                          "object \"%s\"!", inst.src_id, inst.offset(inst.location), kv.second);
+                h = std::max(h, visit(kv.second) + 1);
+            }
+        }
+
+        height[node_id] = h;
+        if (levels.size() <= (size_t) h)
+            levels.resize(h + 1);
+        levels[h].push_back(node_id);
+        return h;
+    };
+
+    visit(id);
+
+    // The root node is created by the caller
+    levels.pop_back();
+
+    ThreadEnvironment env;
+    for (const auto &level : levels) {
+        tbb::parallel_for(
+            tbb::blocked_range<size_t>(0, level.size(), 1),
+            [&](const tbb::blocked_range<size_t> &range) {
+                ScopedSetThreadEnvironment set_env(env);
+                for (size_t i = range.begin(); i != range.end(); ++i)
+                    instantiate_node(ctx, level[i]);
+            }
+        );
+    }
+}
+
+/// Instantiate the root node of a scene description and everything that it references
+static ref<Object> instantiate_root(XMLParseContext &ctx, const std::string &id) {
+    if (ctx.parallelize)
+        instantiate_graph(ctx, id);
+    ref<Object> obj = instantiate_node(ctx, id);
+    if (ctx.deduplicate)
+        Log(Info, "Deduplication: shared %i identical BSDFs and textures.",
+            ctx.shared_count.load());
+    return obj;
+}
+
+/// Prepare the instance cache of a load (see InstanceCache)
+static void begin_cache(XMLParseContext &ctx, InstanceCache *cache) {
+    if (!cache)
+        return;
+    ctx.cache = cache->data();
+    ctx.cache->next_instances.clear();
+    ctx.cache->reused = ctx.cache->updated = ctx.cache->created = 0;
+}
+
+/// Replace the contents of the instance cache by the objects of a successful load
+static void commit_cache(XMLParseContext &ctx) {
+    InstanceCacheData *cache = ctx.cache;
+    if (!cache)
+        return;
+    cache->instances.swap(cache->next_instances);
+    cache->next_instances.clear();
+    cache->parsed.clear();
+    for (const auto &kv : ctx.parsed_objects) {
+        if (kv.second.kind != ParsedObject::Kind::Animation)
+            cache->parsed.emplace_back(kv.second, const_cast<Object *>(kv.first));
+    }
+    Log(Info, "Instance cache: reused %i objects, updated %i and created %i.",
+        cache->reused.load(), cache->updated.load(), cache->created.load());
+}
+
 ref<Object> create_texture_from_rgb(const std::string &name,
                                     Color<float, 3> color,
                                     const std::string &variant,
@@ -1173,11 +1681,358 @@ ref<Object> create_texture_from_spectrum(const std::string &name,
     }
 }
 
+/// Header of a scene cache file
+struct XMLCacheHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t scalar_size;
+    uint64_t key;
+};
+
+/// Hash the contents of a file
+static uint64_t file_hash(const fs::path &filename, uint64_t &size) {
+    ref<FileStream> stream = new FileStream(filename, FileStream::ERead);
+    size = (uint64_t) stream->size();
+    std::unique_ptr<uint8_t[]> data(new uint8_t[size]);
+    stream->read(data.get(), size);
+    return hash_buffer(data.get(), size);
+}
+
+/// Compute the key of the cache entry of a scene (depends on everything but the files)
+static uint64_t cache_key(const fs::path &filename, const std::string &variant,
+                          const ParameterList &param) {
+    uint64_t key = 0;
+    auto add_string = [&](const std::string &s) {
+        key = hash_buffer(s.data(), s.size() + 1, key);
+    };
+
+    add_string(MTS_VERSION);
+    add_string(variant);
+    add_string(fs::absolute(filename).string());
+    for (const auto &kv : param) {
+        add_string(kv.first);
+        add_string(kv.second);
+    }
+    for (const fs::path &path : *Thread::thread()->file_resolver())
+        add_string(path.string());
+    return key;
+}
+
+static void write_properties(Stream *stream, const XMLParseContext &ctx, const Properties &props_) {
+    using Type = Properties::Type;
+
+    // Query a copy, which leaves the flags of unqueried properties untouched
+    Properties props(props_);
+    std::vector<std::string> names = props.property_names();
+    stream->write(props.plugin_name());
+    stream->write(props.id());
+    stream->write((uint32_t) names.size());
+
+    for (const std::string &name : names) {
+        Type type = props.type(name);
+        stream->write(name);
+        stream->write((uint32_t) type);
+
+        switch (type) {
+            case Type::Bool:   stream->write(props.bool_(name)); break;
+            case Type::Long:   stream->write(props.long_(name)); break;
+            case Type::Float:  stream->write(props.float_(name)); break;
+            case Type::String: stream->write(props.string(name)); break;
+            case Type::NamedReference:
+                stream->write((const std::string &) props.named_reference(name));
+                break;
+
+            case Type::Array3f: {
+                    Properties::Array3f value = props.array3f(name);
+                    stream->write_array(value.data(), 3);
+                }
+                break;
+
+            case Type::Color: {
+                    Color3f value = props.color(name);
+                    stream->write_array(value.data(), 3);
+                }
+                break;
+
+            case Type::Transform: {
+                    const Transform4f &value = props.transform(name);
+                    for (size_t i = 0; i < 4; ++i)
+                        for (size_t j = 0; j < 4; ++j)
+                            stream->write(value.matrix(i, j));
+                }
+                break;
+
+            case Type::AnimatedTransform:
+            case Type::Object: {
+                    const Object *obj = type == Type::Object
+                        ? props.object(name).get()
+                        : (const Object *) props.animated_transform(name).get();
+                    auto it = ctx.parsed_objects.find(obj);
+                    if (it == ctx.parsed_objects.end())
+                        Throw("property \"%s\" refers to an object that cannot be cached", name);
+
+                    const ParsedObject &parsed = it->second;
+                    stream->write((uint32_t) parsed.kind);
+                    stream->write(parsed.name);
+                    stream->write(parsed.within_emitter);
+                    stream->write_array(parsed.color.data(), 3);
+                    stream->write(parsed.const_value);
+                    stream->write((uint32_t) parsed.wavelengths.size());
+                    stream->write_array(parsed.wavelengths.data(), parsed.wavelengths.size());
+                    stream->write_array(parsed.values.data(), parsed.values.size());
+                    stream->write((uint32_t) parsed.keyframes.size());
+                    for (const auto &kv : parsed.keyframes) {
+                        stream->write(kv.first);
+                        for (size_t i = 0; i < 4; ++i)
+                            for (size_t j = 0; j < 4; ++j)
+                                stream->write(kv.second.matrix(i, j));
+                    }
+                }
+                break;
+
+            default:
+                Throw("property \"%s\" has a type that cannot be cached", name);
+        }
+    }
+}
+
+static Transform4f read_transform(Stream *stream) {
+    Matrix4f matrix;
+    for (size_t i = 0; i < 4; ++i)
+        for (size_t j = 0; j < 4; ++j)
+            stream->read(matrix(i, j));
+    return Transform4f(matrix);
+}
+
+static Properties read_properties(Stream *stream, const XMLParseContext &ctx) {
+    using Type = Properties::Type;
+
+    std::string plugin_name, id;
+    uint32_t count;
+    stream->read(plugin_name);
+    stream->read(id);
+    stream->read(count);
+
+    Properties props(plugin_name);
+    props.set_id(id);
+
+    for (uint32_t k = 0; k < count; ++k) {
+        std::string name;
+        uint32_t type;
+        stream->read(name);
+        stream->read(type);
+
+        switch ((Type) type) {
+            case Type::Bool:   { bool value;    stream->read(value); props.set_bool(name, value); } break;
+            case Type::Long:   { int64_t value; stream->read(value); props.set_long(name, value); } break;
+            case Type::Float:  { Float value;   stream->read(value); props.set_float(name, value); } break;
+            case Type::String: { std::string value; stream->read(value); props.set_string(name, value); } break;
+            case Type::NamedReference: {
+                    std::string value;
+                    stream->read(value);
+                    props.set_named_reference(name, NamedReference(value));
+                }
+                break;
+
+            case Type::Array3f: {
+                    Properties::Array3f value;
+                    stream->read_array(value.data(), 3);
+                    props.set_array3f(name, value);
+                }
+                break;
+
+            case Type::Color: {
+                    Color3f value;
+                    stream->read_array(value.data(), 3);
+                    props.set_color(name, value);
+                }
+                break;
+
+            case Type::Transform:
+                props.set_transform(name, read_transform(stream));
+                break;
+
+            case Type::AnimatedTransform:
+            case Type::Object: {
+                    ParsedObject parsed;
+                    uint32_t kind, size, keyframe_count;
+                    stream->read(kind);
+                    parsed.kind = (ParsedObject::Kind) kind;
+                    stream->read(parsed.name);
+                    stream->read(parsed.within_emitter);
+                    stream->read_array(parsed.color.data(), 3);
+                    stream->read(parsed.const_value);
+                    stream->read(size);
+                    parsed.wavelengths.resize(size);
+                    parsed.values.resize(size);
+                    stream->read_array(parsed.wavelengths.data(), size);
+                    stream->read_array(parsed.values.data(), size);
+                    stream->read(keyframe_count);
+
+                    if (parsed.kind == ParsedObject::Kind::Animation) {
+                        ref<AnimatedTransform> trafo = new AnimatedTransform();
+                        for (uint32_t i = 0; i < keyframe_count; ++i) {
+                            Float time;
+                            stream->read(time);
+                            trafo->append(time, read_transform(stream));
+                        }
+                        props.set_animated_transform(name, trafo);
+                    } else if (parsed.kind == ParsedObject::Kind::RGB) {
+                        props.set_object(name, create_texture_from_rgb(
+                            parsed.name, parsed.color, ctx.variant, parsed.within_emitter));
+                    } else {
+                        props.set_object(name, create_texture_from_spectrum(
+                            parsed.name, parsed.const_value, parsed.wavelengths,
+                            parsed.values, ctx.variant, parsed.within_emitter,
+                            ctx.color_mode == ColorMode::Spectral,
+                            ctx.color_mode == ColorMode::Monochromatic));
+                    }
+                }
+                break;
+
+            default:
+                Throw("invalid property type %i", type);
+        }
+    }
+
+    return props;
+}
+
+/// Write the parsed scene description to the cache (before it is instantiated)
+static void write_cache(const fs::path &filename, uint64_t key, const XMLParseContext &ctx,
+                        const std::string &scene_id) {
+    XMLCacheHeader header;
+    memset(&header, 0, sizeof(XMLCacheHeader));
+    strncpy(header.magic, MTS_XML_CACHE_MAGIC, sizeof(header.magic));
+    header.version     = MTS_XML_CACHE_VERSION;
+    header.scalar_size = sizeof(Float);
+    header.key         = key;
+
+    // Write to a temporary file first so that readers never see a truncated cache
+    fs::path tmp_file = filename;
+    tmp_file.replace_extension(".tmp");
+
+    /* scope */ {
+        ref<FileStream> stream = new FileStream(tmp_file, FileStream::ETruncReadWrite);
+        stream->write(&header, sizeof(XMLCacheHeader));
+
+        stream->write((uint32_t) ctx.dependencies.size());
+        for (const fs::path &path : ctx.dependencies) {
+            uint64_t size, hash = file_hash(path, size);
+            stream->write(fs::absolute(path).string());
+            stream->write(size);
+            stream->write(hash);
+        }
+
+        const FileResolver *fs = Thread::thread()->file_resolver();
+        stream->write((uint32_t) fs->size());
+        for (const fs::path &path : *fs)
+            stream->write(path.string());
+
+        stream->write(scene_id);
+        stream->write((uint32_t) ctx.instances.size());
+        for (const auto &kv : ctx.instances) {
+            const XMLObject &inst = kv.second;
+            stream->write(kv.first);
+            stream->write(inst.class_ ? inst.class_->name() : std::string());
+            stream->write(inst.src_id);
+            stream->write(inst.alias);
+            stream->write((uint64_t) inst.location);
+            write_properties(stream, ctx, inst.props);
+        }
+        stream->close();
+    }
+
+    if (!fs::rename(tmp_file, filename))
+        Throw("could not rename \"%s\" to \"%s\"!", tmp_file.string(), filename.string());
+
+    Log(Info, "Wrote the parsed scene to the cache \"%s\".", filename.string());
+}
+
+/**
+ * Restore a parsed scene description from the cache. Returns \c false when
+ * the cache is invalid, or when one of the files that were read while parsing
+ * the scene has changed since.
+ */
+static bool load_cache(const fs::path &filename, uint64_t key, XMLParseContext &ctx,
+                       std::string &scene_id) {
+    try {
+        ref<FileStream> stream = new FileStream(filename, FileStream::ERead);
+
+        XMLCacheHeader header;
+        stream->read(&header, sizeof(XMLCacheHeader));
+        if (strncmp(header.magic, MTS_XML_CACHE_MAGIC, sizeof(header.magic)) != 0 ||
+            header.version != MTS_XML_CACHE_VERSION ||
+            header.scalar_size != sizeof(Float) || header.key != key) {
+            Log(Warn, "Ignoring the invalid or outdated scene cache \"%s\".", filename.string());
+            return false;
+        }
+
+        uint32_t count;
+        stream->read(count);
+        for (uint32_t i = 0; i < count; ++i) {
+            std::string path;
+            uint64_t size, hash, current_size;
+            stream->read(path);
+            stream->read(size);
+            stream->read(hash);
+            if (!fs::exists(path) || fs::file_size(path) != size ||
+                file_hash(path, current_size) != hash) {
+                Log(Info, "Ignoring the scene cache \"%s\": \"%s\" has changed.",
+                    filename.string(), path);
+                return false;
+            }
+        }
+
+        ref<FileResolver> fs = Thread::thread()->file_resolver();
+        fs->clear();
+        stream->read(count);
+        for (uint32_t i = 0; i < count; ++i) {
+            std::string path;
+            stream->read(path);
+            fs->append(path);
+        }
+
+        stream->read(scene_id);
+        stream->read(count);
+        for (uint32_t i = 0; i < count; ++i) {
+            std::string id, class_name;
+            uint64_t location;
+            stream->read(id);
+            stream->read(class_name);
+
+            XMLObject &inst = ctx.instances.try_emplace(id, &ctx.arena).first->second;
+            if (!class_name.empty()) {
+                inst.class_ = Class::for_name(class_name, ctx.variant);
+                if (!inst.class_)
+                    Throw("unknown class \"%s\"", class_name);
+            }
+            stream->read(inst.src_id);
+            stream->read(inst.alias);
+            stream->read(location);
+            inst.location = (size_t) location;
+            inst.offset = [src_id = inst.src_id](ptrdiff_t pos) {
+                return file_offset(src_id, pos);
+            };
+            inst.props = read_properties(stream, ctx);
+        }
+    } catch (const std::exception &e) {
+        Log(Warn, "Could not read the scene cache \"%s\": %s", filename.string(), e.what());
+        ctx.instances.clear();
+        return false;
+    }
+
+    Log(Info, "Loaded the parsed scene from the cache \"%s\".", filename.string());
+    return true;
+}
+
 NAMESPACE_END(detail)
 
 ref<Object> load_string(const std::string &string, const std::string &variant,
                         ParameterList param) {
     ScopedPhase sp(ProfilerPhase::InitScene);
+    std::unique_ptr<ScopedLoadEvent> parse_event(
+        new ScopedLoadEvent(LoadEvent::ParseXML, "<string>"));
     pugi::xml_document doc;
     pugi::xml_parse_result result = doc.load_buffer(string.c_str(), string.length(),
                                                     pugi::parse_default |
@@ -1202,7 +2057,8 @@ ref<Object> load_string(const std::string &string, const std::string &variant,
         size_t arg_counter; // Unused
         auto scene_id = detail::parse_xml(src, ctx, root, Tag::Invalid, prop,
                                           param, arg_counter, 0).second;
-        ref<Object> obj = detail::instantiate_node(ctx, scene_id);
+        parse_event.reset();
+        ref<Object> obj = detail::instantiate_root(ctx, scene_id);
         Thread::thread()->set_file_resolver(fs_backup.get());
         return obj;
     } catch(...) {
@@ -1212,7 +2068,7 @@ ref<Object> load_string(const std::string &string, const std::string &variant,
 }
 
 ref<Object> load_file(const fs::path &filename_, const std::string &variant,
-                      ParameterList param, bool write_update) {
+                      ParameterList param, bool write_update, InstanceCache *cache) {
     ScopedPhase sp(ProfilerPhase::InitScene);
     fs::path filename = filename_;
     if (!fs::exists(filename))
@@ -1221,6 +2077,38 @@ ref<Object> load_file(const fs::path &filename_, const std::string &variant,
     Log(Info, "Loading XML file \"%s\" ..", filename);
     Log(Info, "Using variant \"%s\"", variant);
 
+    // Skip the parsing stage if the scene can be restored from the cache
+    fs::path cache_dir_ = cache_dir(), cache_file;
+    uint64_t cache_key = 0;
+    if (!cache_dir_.empty()) {
+        cache_key = detail::cache_key(filename, variant, param);
+        cache_file = cache_dir_ / fs::path(tfm::format("%016x.xmlcache", cache_key));
+
+        if (fs::exists(cache_file)) {
+            ref<FileResolver> fs_backup = Thread::thread()->file_resolver();
+            Thread::thread()->set_file_resolver(new FileResolver(*fs_backup));
+            try {
+                detail::XMLParseContext ctx(variant);
+                std::string scene_id;
+                ref<Object> obj;
+                if (detail::load_cache(cache_file, cache_key, ctx, scene_id)) {
+                    detail::begin_cache(ctx, cache);
+                    obj = detail::instantiate_root(ctx, scene_id);
+                    detail::commit_cache(ctx);
+                }
+                Thread::thread()->set_file_resolver(fs_backup.get());
+                if (obj)
+                    return obj;
+            } catch(...) {
+                Thread::thread()->set_file_resolver(fs_backup.get());
+                throw;
+            }
+        }
+    }
+
+    // The parsing stage ends before the instantiation of the objects
+    std::unique_ptr<ScopedLoadEvent> parse_event(
+        new ScopedLoadEvent(LoadEvent::ParseXML, filename.filename().string()));
     pugi::xml_document doc;
     pugi::xml_parse_result result = doc.load_file(filename.native().c_str(),
                                                   pugi::parse_default |
@@ -1242,6 +2130,8 @@ ref<Object> load_file(const fs::path &filename_, const std::string &variant,
     try {
         pugi::xml_node root = doc.document_element();
         detail::XMLParseContext ctx(variant);
+        ctx.dependencies.push_back(filename);
+        detail::begin_cache(ctx, cache);
         Properties prop;
         size_t arg_counter = 0; // Unused
         auto scene_id = detail::parse_xml(src, ctx, root, Tag::Invalid, prop,
@@ -1269,9 +2159,20 @@ ref<Object> load_file(const fs::path &filename_, const std::string &variant,
 
             // Update for detail::file_offset
             filename = backup;
+        } else if (!cache_file.empty()) {
+            // Instantiation consumes the properties: write the cache beforehand
+            try {
+                if (!fs::exists(cache_dir_))
+                    fs::create_directory(cache_dir_);
+                detail::write_cache(cache_file, cache_key, ctx, scene_id);
+            } catch (const std::exception &e) {
+                Log(Warn, "Could not write the scene cache \"%s\": %s", cache_file.string(), e.what());
+            }
         }
 
-        ref<Object> obj = detail::instantiate_node(ctx, scene_id);
+        parse_event.reset();
+        ref<Object> obj = detail::instantiate_root(ctx, scene_id);
+        detail::commit_cache(ctx);
         Thread::thread()->set_file_resolver(fs_backup.get());
         return obj;
     } catch(...) {
@@ -1280,5 +2181,28 @@ ref<Object> load_file(const fs::path &filename_, const std::string &variant,
     }
 }
 
+void set_cache_dir(const fs::path &path) {
+    std::lock_guard<std::mutex> guard(xml_cache_mutex);
+    xml_cache_dir = path;
+}
+
+fs::path cache_dir() {
+    std::lock_guard<std::mutex> guard(xml_cache_mutex);
+    return xml_cache_dir;
+}
+
+void set_deduplication(bool enabled) { xml_deduplication = enabled; }
+
+bool deduplication() { return xml_deduplication; }
+
+InstanceCache::InstanceCache() : m_data(new detail::InstanceCacheData()) { }
+InstanceCache::~InstanceCache() { }
+
+size_t InstanceCache::reused() const { return m_data->reused; }
+size_t InstanceCache::updated() const { return m_data->updated; }
+size_t InstanceCache::created() const { return m_data->created; }
+
+MTS_IMPLEMENT_CLASS(InstanceCache, Object)
+
 NAMESPACE_END(xml)
 NAMESPACE_END(mitsuba)
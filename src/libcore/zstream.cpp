@@ -1,13 +1,55 @@
 #include <mitsuba/core/zstream.h>
+#include <mitsuba/core/util.h>
 #include <zlib.h>
+#include <limits>
+
+#if defined(MTS_HAS_ZSTD)
+#  include <zstd.h>
+#endif
 
 NAMESPACE_BEGIN(mitsuba)
 
-ZStream::ZStream(Stream *child_stream, EStreamType stream_type, int level)
-    : m_child_stream(child_stream),
-      m_deflate_stream(new z_stream()),
-      m_inflate_stream(new z_stream()),
-      m_did_write(false) {
+#if defined(MTS_HAS_ZSTD)
+/// Throw an exception if the return value of a zstd function denotes an error
+static size_t zstd_check(size_t retval, const char *func) {
+    if (ZSTD_isError(retval))
+        Throw("%s(): %s", func, ZSTD_getErrorName(retval));
+    return retval;
+}
+#endif
+
+ZStream::ZStream(Stream *child_stream, EStreamType stream_type, int level, int threads)
+    : m_child_stream(child_stream), m_stream_type(stream_type), m_did_write(false) {
+    if (stream_type == EZstdStream) {
+#if defined(MTS_HAS_ZSTD)
+        m_zstd_cctx = ZSTD_createCCtx();
+        m_zstd_dctx = ZSTD_createDCtx();
+        if (!m_zstd_cctx || !m_zstd_dctx)
+            Throw("Could not initialize zstd!");
+
+        zstd_check(ZSTD_CCtx_setParameter(m_zstd_cctx, ZSTD_c_compressionLevel,
+                                          level < 0 ? ZSTD_CLEVEL_DEFAULT : level),
+                   "ZSTD_CCtx_setParameter");
+
+        if (threads < 0)
+            threads = (int) util::core_count();
+        if (threads > 1) {
+            // Fails when the zstd library was built without multithreading support
+            size_t retval = ZSTD_CCtx_setParameter(m_zstd_cctx, ZSTD_c_nbWorkers, threads);
+            if (ZSTD_isError(retval))
+                Log(Warn, "ZStream: multithreaded compression is unavailable (%s), "
+                    "compressing on a single thread.", ZSTD_getErrorName(retval));
+        }
+        return;
+#else
+        (void) level; (void) threads;
+        Throw("ZStream: zstd streams are unsupported, since Mitsuba was compiled "
+              "without the zstd library!");
+#endif
+    }
+
+    m_deflate_stream.reset(new z_stream());
+    m_inflate_stream.reset(new z_stream());
     m_deflate_stream->zalloc = Z_NULL;
     m_deflate_stream->zfree = Z_NULL;
     m_deflate_stream->opaque = Z_NULL;
@@ -34,6 +76,20 @@ ZStream::ZStream(Stream *child_stream, EStreamType stream_type, int level)
 void ZStream::write(const void *ptr, size_t size) {
     Assert(m_child_stream != nullptr);
 
+#if defined(MTS_HAS_ZSTD)
+    if (m_stream_type == EZstdStream) {
+        ZSTD_inBuffer in = { ptr, size, 0 };
+        while (in.pos < in.size) {
+            ZSTD_outBuffer out = { m_deflate_buffer, sizeof(m_deflate_buffer), 0 };
+            zstd_check(ZSTD_compressStream2(m_zstd_cctx, &out, &in, ZSTD_e_continue),
+                       "ZSTD_compressStream2");
+            m_child_stream->write(m_deflate_buffer, out.pos);
+        }
+        m_did_write = true;
+        return;
+    }
+#endif
+
     m_deflate_stream->avail_in = (uInt) size;
     m_deflate_stream->next_in = (uint8_t *) ptr;
 
@@ -60,6 +116,39 @@ void ZStream::read(void *ptr, size_t size) {
     Assert(m_child_stream != nullptr);
 
     uint8_t *targetPtr = (uint8_t *) ptr;
+
+#if defined(MTS_HAS_ZSTD)
+    if (m_stream_type == EZstdStream) {
+        ZSTD_outBuffer out = { targetPtr, size, 0 };
+        size_t retval = 0;
+        while (out.pos < out.size) {
+            /* Decompress the buffered input first: the decoder may also hold
+               output of a previous call that did not fit into its buffer */
+            size_t out_pos = out.pos;
+            ZSTD_inBuffer in = { m_inflate_buffer, m_zstd_in_size, m_zstd_in_pos };
+            retval = zstd_check(ZSTD_decompressStream(m_zstd_dctx, &out, &in),
+                                "ZSTD_decompressStream");
+            bool progress = out.pos != out_pos || in.pos != m_zstd_in_pos;
+            m_zstd_in_pos = in.pos;
+            if (progress || out.pos == out.size)
+                continue;
+
+            size_t remaining = m_child_stream->size() - m_child_stream->tell();
+            m_zstd_in_pos = 0;
+            m_zstd_in_size = std::min(remaining, sizeof(m_inflate_buffer));
+            if (m_zstd_in_size == 0) {
+                if (retval == 0)
+                    Throw("ZSTD_decompressStream(): attempting to read past the "
+                          "end of the stream!");
+                Throw("Read less data than expected (%i more bytes required)",
+                      out.size - out.pos);
+            }
+            m_child_stream->read(m_inflate_buffer, m_zstd_in_size);
+        }
+        return;
+    }
+#endif
+
     while (size > 0) {
         if (m_inflate_stream->avail_in == 0) {
             size_t remaining = m_child_stream->size() - m_child_stream->tell();
@@ -101,6 +190,23 @@ void ZStream::read(void *ptr, size_t size) {
 void ZStream::flush() {
     Assert(m_child_stream != nullptr);
 
+#if defined(MTS_HAS_ZSTD)
+    if (m_stream_type == EZstdStream) {
+        if (m_did_write) {
+            size_t remaining;
+            do {
+                ZSTD_inBuffer in = { nullptr, 0, 0 };
+                ZSTD_outBuffer out = { m_deflate_buffer, sizeof(m_deflate_buffer), 0 };
+                remaining = zstd_check(ZSTD_compressStream2(m_zstd_cctx, &out, &in, ZSTD_e_flush),
+                                       "ZSTD_compressStream2");
+                m_child_stream->write(m_deflate_buffer, out.pos);
+            } while (remaining != 0);
+            m_child_stream->flush();
+        }
+        return;
+    }
+#endif
+
     if (m_did_write) {
         m_deflate_stream->avail_in = 0;
         m_deflate_stream->next_in = NULL;
@@ -127,6 +233,28 @@ void ZStream::close() {
     if (!m_child_stream)
         return;
 
+#if defined(MTS_HAS_ZSTD)
+    if (m_stream_type == EZstdStream) {
+        if (m_did_write) {
+            size_t remaining;
+            do {
+                ZSTD_inBuffer in = { nullptr, 0, 0 };
+                ZSTD_outBuffer out = { m_deflate_buffer, sizeof(m_deflate_buffer), 0 };
+                remaining = zstd_check(ZSTD_compressStream2(m_zstd_cctx, &out, &in, ZSTD_e_end),
+                                       "ZSTD_compressStream2");
+                m_child_stream->write(m_deflate_buffer, out.pos);
+            } while (remaining != 0);
+        }
+
+        ZSTD_freeCCtx(m_zstd_cctx);
+        ZSTD_freeDCtx(m_zstd_dctx);
+        m_zstd_cctx = nullptr;
+        m_zstd_dctx = nullptr;
+        m_child_stream = nullptr;
+        return;
+    }
+#endif
+
     if (m_did_write) {
         m_deflate_stream->avail_in = 0;
         m_deflate_stream->next_in = NULL;
@@ -152,6 +280,90 @@ void ZStream::close() {
     m_child_stream = nullptr;
 }
 
+void ZStream::decompress(const void *src, size_t src_size, void *dst,
+                         size_t dst_size, EStreamType stream_type) {
+    if (stream_type == EZstdStream) {
+#if defined(MTS_HAS_ZSTD)
+        size_t size = zstd_check(ZSTD_decompress(dst, dst_size, src, src_size),
+                                 "ZSTD_decompress");
+        if (size != dst_size)
+            Throw("ZSTD_decompress(): the block decompresses to fewer than %i bytes!",
+                  dst_size);
+        return;
+#else
+        Throw("ZStream: zstd streams are unsupported, since Mitsuba was compiled "
+              "without the zstd library!");
+#endif
+    }
+
+    z_stream stream;
+    stream.zalloc = Z_NULL;
+    stream.zfree = Z_NULL;
+    stream.opaque = Z_NULL;
+    stream.avail_in = 0;
+    stream.next_in = Z_NULL;
+    stream.avail_out = 0;
+    stream.next_out = Z_NULL;
+
+    int window_bits = 15 + (stream_type == EGZipStream ? 16 : 0);
+    int retval = inflateInit2(&stream, window_bits);
+    if (retval != Z_OK)
+        Throw("Could not initialize ZLIB: error code %i", retval);
+
+    uint8_t *in = (uint8_t *) src, *out = (uint8_t *) dst;
+    size_t in_remaining = src_size, out_remaining = dst_size;
+
+    // zlib counts bytes using 32-bit integers, so feed large blocks in pieces
+    const size_t max_step = std::numeric_limits<uInt>::max();
+    do {
+        if (stream.avail_in == 0) {
+            stream.avail_in = (uInt) std::min(in_remaining, max_step);
+            stream.next_in = in;
+            in += stream.avail_in;
+            in_remaining -= stream.avail_in;
+        }
+        if (stream.avail_out == 0) {
+            stream.avail_out = (uInt) std::min(out_remaining, max_step);
+            stream.next_out = out;
+            out += stream.avail_out;
+            out_remaining -= stream.avail_out;
+        }
+        retval = inflate(&stream, Z_NO_FLUSH);
+    } while (retval == Z_OK);
+
+    bool complete = retval == Z_STREAM_END && stream.avail_out == 0 &&
+                    out_remaining == 0;
+    inflateEnd(&stream);
+
+    switch (retval) {
+        case Z_STREAM_END:
+            break;
+        case Z_NEED_DICT:
+            Throw("inflate(): need dictionary!");
+        case Z_DATA_ERROR:
+            Throw("inflate(): data error!");
+        case Z_MEM_ERROR:
+            Throw("inflate(): memory error!");
+        case Z_BUF_ERROR:
+        case Z_OK:
+            Throw("inflate(): the block decompresses to more than %i bytes or is truncated!",
+                  dst_size);
+        default:
+            Throw("inflate(): stream error!");
+    }
+
+    if (!complete)
+        Throw("inflate(): the block decompresses to fewer than %i bytes!", dst_size);
+}
+
+bool ZStream::has_zstd() {
+#if defined(MTS_HAS_ZSTD)
+    return true;
+#else
+    return false;
+#endif
+}
+
 ZStream::~ZStream() {
     close();
 }
@@ -13,6 +13,14 @@ MTS_VARIANT Spectrum BSDF<Float, Spectrum>::eval_null_transmission(
     return 0.f;
 }
 
+MTS_VARIANT std::pair<Spectrum, Float>
+BSDF<Float, Spectrum>::eval_pdf(const BSDFContext &ctx,
+                                const SurfaceInteraction3f &si,
+                                const Vector3f &wo,
+                                Mask active) const {
+    return { eval(ctx, si, wo, active), pdf(ctx, si, wo, active) };
+}
+
 MTS_VARIANT std::string BSDF<Float, Spectrum>::id() const { return m_id; }
 
 template <typename Index>
@@ -0,0 +1,437 @@
+#include <mitsuba/render/bvh.h>
+#include <mitsuba/core/properties.h>
+#include <mitsuba/core/string.h>
+#include <mitsuba/core/timer.h>
+#include <mitsuba/core/util.h>
+#include <tbb/parallel_for.h>
+#include <tbb/parallel_invoke.h>
+#include <algorithm>
+#include <memory>
+
+NAMESPACE_BEGIN(mitsuba)
+
+NAMESPACE_BEGIN(detail)
+/// Bounding box and centroid of a primitive during the BVH construction
+template <typename BoundingBox> struct BVHPrimitive {
+    BoundingBox bbox;
+    typename BoundingBox::Point center;
+    uint32_t index;
+};
+
+/// Node of the binary hierarchy, which is later collapsed into wide nodes
+template <typename BoundingBox> struct BVHBuildNode {
+    BoundingBox bbox;
+    std::unique_ptr<BVHBuildNode> left, right;
+    uint32_t offset = 0, count = 0;
+
+    bool leaf() const { return !left; }
+};
+
+/// Top-down binned SAH construction of a binary BVH
+template <typename BoundingBox> class BVHBuilder {
+public:
+    using Scalar    = typename BoundingBox::Value;
+    using Primitive = BVHPrimitive<BoundingBox>;
+    using BuildNode = BVHBuildNode<BoundingBox>;
+
+    BVHBuilder(Primitive *prims, uint32_t max_leaf_size, uint32_t bin_count,
+               Scalar traversal_cost, Scalar intersection_cost)
+        : m_prims(prims), m_max_leaf_size(max_leaf_size), m_bin_count(bin_count),
+          m_traversal_cost(traversal_cost), m_intersection_cost(intersection_cost) { }
+
+    /// Recursively build the subtree of the primitives [begin, end)
+    std::unique_ptr<BuildNode> build(uint32_t begin, uint32_t end, uint32_t depth) const {
+        std::unique_ptr<BuildNode> node(new BuildNode());
+
+        BoundingBox centroid_bbox;
+        for (uint32_t i = begin; i < end; ++i) {
+            node->bbox.expand(m_prims[i].bbox);
+            centroid_bbox.expand(m_prims[i].center);
+        }
+
+        uint32_t count = end - begin;
+        node->offset = begin;
+        node->count  = count;
+        if (count <= 1 || depth + 1 >= MTS_BVH_MAXDEPTH)
+            return node;
+
+        uint32_t axis = centroid_bbox.major_axis();
+        Scalar extent = centroid_bbox.max[axis] - centroid_bbox.min[axis];
+
+        uint32_t mid = begin + count / 2;
+        if (extent > 0) {
+            // Bin the primitive centroids along the major axis
+            std::vector<BoundingBox> bin_bbox(m_bin_count);
+            std::vector<uint32_t> bin_count(m_bin_count, 0);
+            Scalar bin_scale = m_bin_count / extent * (1 - math::Epsilon<Scalar>);
+            auto bin_index = [&](const Primitive &p) {
+                return std::min(m_bin_count - 1, (uint32_t)
+                                ((p.center[axis] - centroid_bbox.min[axis]) * bin_scale));
+            };
+
+            for (uint32_t i = begin; i < end; ++i) {
+                uint32_t b = bin_index(m_prims[i]);
+                bin_bbox[b].expand(m_prims[i].bbox);
+                bin_count[b]++;
+            }
+
+            // Sweep from the right to compute the cost of the right halves
+            std::vector<Scalar> right_cost(m_bin_count);
+            BoundingBox right_bbox;
+            uint32_t right_count = 0;
+            for (uint32_t b = m_bin_count - 1; b > 0; --b) {
+                right_bbox.expand(bin_bbox[b]);
+                right_count += bin_count[b];
+                right_cost[b] = right_count == 0 ? 0 : right_bbox.surface_area() * right_count;
+            }
+
+            // Sweep from the left and find the split with the lowest cost
+            BoundingBox left_bbox;
+            uint32_t left_count = 0, best_bin = 0;
+            Scalar best_cost = math::Infinity<Scalar>;
+            for (uint32_t b = 0; b + 1 < m_bin_count; ++b) {
+                left_bbox.expand(bin_bbox[b]);
+                left_count += bin_count[b];
+                if (left_count == 0 || left_count == count)
+                    continue;
+                Scalar cost = left_bbox.surface_area() * left_count + right_cost[b + 1];
+                if (cost < best_cost) {
+                    best_cost = cost;
+                    best_bin = b;
+                }
+            }
+
+            Scalar area = node->bbox.surface_area();
+            best_cost = m_traversal_cost +
+                m_intersection_cost * (area > 0 ? best_cost / area : (Scalar) count);
+
+            // Create a leaf when no split is cheaper than intersecting all primitives
+            if (count <= m_max_leaf_size && m_intersection_cost * count <= best_cost)
+                return node;
+
+            if (best_cost < math::Infinity<Scalar>) {
+                mid = (uint32_t) (std::partition(m_prims + begin, m_prims + end,
+                    [&](const Primitive &p) { return bin_index(p) <= best_bin; }) - m_prims);
+            } else {
+                std::nth_element(m_prims + begin, m_prims + mid, m_prims + end,
+                    [&](const Primitive &a, const Primitive &b) {
+                        return a.center[axis] < b.center[axis];
+                    });
+            }
+        } else if (count <= m_max_leaf_size) {
+            // All centroids coincide: splitting cannot separate the primitives
+            return node;
+        }
+
+        if (count > MTS_BVH_GRAIN_SIZE) {
+            tbb::parallel_invoke(
+                [&] { node->left  = build(begin, mid, depth + 1); },
+                [&] { node->right = build(mid, end, depth + 1); }
+            );
+        } else {
+            node->left  = build(begin, mid, depth + 1);
+            node->right = build(mid, end, depth + 1);
+        }
+
+        return node;
+    }
+
+private:
+    Primitive *m_prims;
+    uint32_t m_max_leaf_size;
+    uint32_t m_bin_count;
+    Scalar m_traversal_cost;
+    Scalar m_intersection_cost;
+};
+NAMESPACE_END(detail)
+
+MTS_VARIANT ShapeBVH<Float, Spectrum>::ShapeBVH(const Properties &props) {
+    /* BVH construction: Nodes containing this many or fewer primitives are
+       turned into leaves when this is cheaper than splitting them */
+    m_max_leaf_size = (Size) props.size_("bvh_max_leaf_prims", 4);
+
+    /* BVH construction: Number of bins used to evaluate the surface area
+       heuristic */
+    m_bin_count = (Size) props.size_("bvh_bins", 16);
+    if (m_bin_count < 2)
+        Throw("\"bvh_bins\" must be at least 2!");
+
+    /* BVH construction: Relative cost of a traversal step and a primitive
+       intersection in the surface area heuristic */
+    m_traversal_cost = props.float_("bvh_traversal_cost", 1.f);
+    m_intersection_cost = props.float_("bvh_intersection_cost", 1.f);
+
+    m_primitive_map.push_back(0);
+    m_ready = false;
+}
+
+MTS_VARIANT void ShapeBVH<Float, Spectrum>::add_shape(Shape *shape) {
+    Assert(!ready());
+    m_primitive_map.push_back(m_primitive_map.back() +
+                              shape->primitive_count());
+    m_shapes.push_back(shape);
+    m_bbox.expand(shape->bbox());
+}
+
+MTS_VARIANT void ShapeBVH<Float, Spectrum>::build() {
+    using Primitive = detail::BVHPrimitive<ScalarBoundingBox3f>;
+    using BuildNode = detail::BVHBuildNode<ScalarBoundingBox3f>;
+
+    Timer timer;
+    Size prim_count = primitive_count();
+    bool motion = update_motion_time_range();
+    if (motion)
+        Log(Info, "Building a binned SAH BVH (%i primitives, %i-wide nodes, "
+                  "motion over [%.4g, %.4g]) ..", prim_count, MTS_BVH_WIDTH,
+            m_motion_time_range.x(), m_motion_time_range.y());
+    else
+        Log(Info, "Building a binned SAH BVH (%i primitives, %i-wide nodes) ..",
+            prim_count, MTS_BVH_WIDTH);
+
+    m_nodes.clear();
+    m_indices.clear();
+    m_motion_bounds.clear();
+
+    if (prim_count == 0) {
+        m_ready = true;
+        return;
+    }
+
+    // Compute the bounding boxes and centroids of all primitives
+    std::vector<Primitive> prims(prim_count);
+    tbb::parallel_for(
+        tbb::blocked_range<Size>(0u, prim_count, MTS_BVH_GRAIN_SIZE),
+        [&](const tbb::blocked_range<Size> &range) {
+            for (Size i = range.begin(); i != range.end(); ++i) {
+                prims[i].bbox   = bbox(i);
+                prims[i].center = prims[i].bbox.center();
+                prims[i].index  = i;
+            }
+        }
+    );
+
+    detail::BVHBuilder<ScalarBoundingBox3f> builder(
+        prims.data(), m_max_leaf_size, m_bin_count,
+        m_traversal_cost, m_intersection_cost);
+    std::unique_ptr<BuildNode> root = builder.build(0, prim_count, 0);
+
+    m_indices.resize(prim_count);
+    for (Size i = 0; i < prim_count; ++i)
+        m_indices[i] = prims[i].index;
+    prims = std::vector<Primitive>();
+
+    /* Collapse the binary hierarchy: each wide node takes the children of a
+       binary node and repeatedly replaces the inner child with the largest
+       surface area by its own children until all slots are used */
+    auto collapse = [&](auto &collapse_, const BuildNode *node) -> Index {
+        const BuildNode *children[MTS_BVH_WIDTH];
+        size_t n = 0;
+        if (node->leaf()) {
+            children[n++] = node;
+        } else {
+            children[n++] = node->left.get();
+            children[n++] = node->right.get();
+        }
+
+        while (n < MTS_BVH_WIDTH) {
+            size_t best = n;
+            ScalarFloat best_area = -1.f;
+            for (size_t i = 0; i < n; ++i) {
+                ScalarFloat area = children[i]->bbox.surface_area();
+                if (!children[i]->leaf() && area > best_area) {
+                    best = i;
+                    best_area = area;
+                }
+            }
+            if (best == n)
+                break;
+            const BuildNode *c = children[best];
+            children[best] = c->left.get();
+            children[n++] = c->right.get();
+        }
+
+        Index index = (Index) m_nodes.size();
+        m_nodes.emplace_back();
+
+        for (size_t i = 0; i < MTS_BVH_WIDTH; ++i) {
+            ScalarBoundingBox3f child_bbox;
+            Index child = InvalidChild, count = 0;
+            if (i < n) {
+                child_bbox = children[i]->bbox;
+                if (children[i]->leaf()) {
+                    child = children[i]->offset;
+                    count = children[i]->count;
+                } else {
+                    child = collapse_(collapse_, children[i]);
+                }
+            }
+
+            // 'm_nodes' may have been reallocated by the recursive calls
+            Node &target = m_nodes[index];
+            for (size_t a = 0; a < 3; ++a) {
+                target.bounds[0][a][i] = child_bbox.min[a];
+                target.bounds[1][a][i] = child_bbox.max[a];
+            }
+            target.child[i] = child;
+            target.count[i] = count;
+        }
+
+        return index;
+    };
+    collapse(collapse, root.get());
+
+    /* The topology is built from the bounds swept over the whole motion.
+       Fill in the bounds at its start and end from the primitives. */
+    if (motion) {
+        m_motion_bounds.resize(m_nodes.size());
+        update_bounds();
+    }
+    m_ready = true;
+
+    Log(Info, "Finished. (%i nodes, %s of storage, took %s)", m_nodes.size(),
+        util::mem_string(m_nodes.size() * sizeof(Node) +
+                         m_motion_bounds.size() * sizeof(NodeBounds) +
+                         m_indices.size() * sizeof(Index)),
+        util::time_string(timer.value())
+    );
+}
+
+MTS_VARIANT bool ShapeBVH<Float, Spectrum>::update_motion_time_range() {
+    ScalarVector2f range(math::Infinity<ScalarFloat>, -math::Infinity<ScalarFloat>);
+    for (Shape *shape : m_shapes) {
+        if (!shape->has_motion())
+            continue;
+        ScalarVector2f shape_range = shape->motion_time_range();
+        range.x() = std::min(range.x(), shape_range.x());
+        range.y() = std::max(range.y(), shape_range.y());
+    }
+
+    // Shapes at rest, or moving instantaneously: use the swept bounds
+    if (!(range.y() > range.x())) {
+        m_motion_time_range = ScalarVector2f(0.f);
+        m_motion_time_scale = 0.f;
+        return false;
+    }
+
+    m_motion_time_range = range;
+    m_motion_time_scale = 1.f / (range.y() - range.x());
+    return true;
+}
+
+MTS_VARIANT void ShapeBVH<Float, Spectrum>::update_bounds() {
+    bool motion = has_motion();
+    auto set_bounds = [](NodeBounds &node, size_t slot, const ScalarBoundingBox3f &bbox) {
+        for (size_t a = 0; a < 3; ++a) {
+            node.bounds[0][a][slot] = bbox.min[a];
+            node.bounds[1][a][slot] = bbox.max[a];
+        }
+    };
+
+    // Leaf bounds only depend on the primitives, which can be processed in parallel
+    tbb::parallel_for(
+        tbb::blocked_range<size_t>(0u, m_nodes.size(), 64),
+        [&](const tbb::blocked_range<size_t> &range) {
+            for (size_t n = range.begin(); n != range.end(); ++n) {
+                Node &node = m_nodes[n];
+                for (size_t i = 0; i < MTS_BVH_WIDTH; ++i) {
+                    if (node.count[i] == 0)
+                        continue;
+                    ScalarBoundingBox3f leaf_bbox, leaf_bbox_end;
+                    for (Index k = 0; k < node.count[i]; ++k) {
+                        Index prim_index = m_indices[node.child[i] + k];
+                        if (motion) {
+                            auto [start, end] = bbox_motion(prim_index);
+                            leaf_bbox.expand(start);
+                            leaf_bbox_end.expand(end);
+                        } else {
+                            leaf_bbox.expand(bbox(prim_index));
+                        }
+                    }
+                    set_bounds(node, i, leaf_bbox);
+                    if (motion)
+                        set_bounds(m_motion_bounds[n], i, leaf_bbox_end);
+                }
+            }
+        }
+    );
+
+    /* Inner bounds bottom-up: child nodes are always stored after their
+       parent (see build()), hence a reverse sweep visits children first */
+    auto merge_bounds = [&](NodeBounds &target, size_t slot, const NodeBounds &child) {
+        ScalarBoundingBox3f child_bbox;
+        for (size_t j = 0; j < MTS_BVH_WIDTH; ++j) {
+            for (size_t a = 0; a < 3; ++a) {
+                child_bbox.min[a] = std::min(child_bbox.min[a], child.bounds[0][a][j]);
+                child_bbox.max[a] = std::max(child_bbox.max[a], child.bounds[1][a][j]);
+            }
+        }
+        set_bounds(target, slot, child_bbox);
+    };
+
+    for (size_t n = m_nodes.size(); n-- > 0; ) {
+        Node &node = m_nodes[n];
+        for (size_t i = 0; i < MTS_BVH_WIDTH; ++i) {
+            if (node.count[i] != 0 || node.child[i] == InvalidChild)
+                continue;
+            merge_bounds(node, i, m_nodes[node.child[i]]);
+            if (motion)
+                merge_bounds(m_motion_bounds[n], i, m_motion_bounds[node.child[i]]);
+        }
+    }
+}
+
+MTS_VARIANT void ShapeBVH<Float, Spectrum>::rebuild() {
+    m_ready = false;
+
+    m_primitive_map.clear();
+    m_primitive_map.push_back(0);
+    m_bbox.reset();
+    for (Shape *shape : m_shapes) {
+        m_primitive_map.push_back(m_primitive_map.back() +
+                                  shape->primitive_count());
+        m_bbox.expand(shape->bbox());
+    }
+
+    build();
+}
+
+MTS_VARIANT void ShapeBVH<Float, Spectrum>::refit() {
+    bool topology_changed = m_nodes.empty();
+    for (size_t i = 0; i < m_shapes.size(); ++i)
+        topology_changed |= m_primitive_map[i + 1] - m_primitive_map[i] !=
+                            m_shapes[i]->primitive_count();
+
+    // Shapes that started or stopped moving require the other node layout
+    bool motion = update_motion_time_range();
+    if (topology_changed || motion != has_motion()) {
+        rebuild();
+        return;
+    }
+
+    Timer timer;
+    update_bounds();
+
+    m_bbox.reset();
+    for (Shape *shape : m_shapes)
+        m_bbox.expand(shape->bbox());
+
+    Log(Debug, "Refitted the BVH (%i nodes, took %s)", m_nodes.size(),
+        util::time_string(timer.value()));
+}
+
+MTS_VARIANT std::string ShapeBVH<Float, Spectrum>::to_string() const {
+    std::ostringstream oss;
+    oss << "ShapeBVH[" << std::endl
+        << "  width = " << MTS_BVH_WIDTH << "," << std::endl
+        << "  nodes = " << m_nodes.size() << "," << std::endl
+        << "  shapes = [" << std::endl;
+    for (auto shape : m_shapes)
+        oss << "    " << string::indent(shape, 4)
+            << "," << std::endl;
+    oss << "  ]" << std::endl << "]";
+    return oss.str();
+}
+
+MTS_IMPLEMENT_CLASS_VARIANT(ShapeBVH, Object)
+MTS_INSTANTIATE_CLASS(ShapeBVH)
+NAMESPACE_END(mitsuba)
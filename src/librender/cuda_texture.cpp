@@ -0,0 +1,303 @@
+#include <mitsuba/render/cuda_texture.h>
+#include <mitsuba/core/logger.h>
+#include <mitsuba/core/util.h>
+#include <memory>
+#include <mutex>
+
+#if defined(MTS_ENABLE_OPTIX)
+#  include <cuda.h>
+#endif
+
+NAMESPACE_BEGIN(mitsuba)
+
+#if defined(MTS_ENABLE_OPTIX)
+
+#define cu_check(err) cu_check_impl(err, __FILE__, __LINE__)
+
+static void cu_check_impl(CUresult errval, const char *file, const int line) {
+    if (errval != CUDA_SUCCESS) {
+        const char *name = nullptr, *msg = nullptr;
+        cuGetErrorName(errval, &name);
+        cuGetErrorString(errval, &msg);
+        Throw("CUDATexture: CUDA error %s (%s) at %s:%i!", name ? name : "unknown",
+              msg ? msg : "unknown", file, line);
+    }
+}
+
+/* Lookup kernel: every thread fetches the coordinates of one query, performs
+   a 2D or 3D texture lookup and stores the first 'channels' values. */
+static const char *lookup_ptx = R"(
+.version 6.0
+.target sm_50
+.address_size 64
+
+.visible .entry lookup(.param .u64 tex, .param .u32 size, .param .u32 dimension,
+                       .param .u32 channels, .param .u64 pos_0, .param .u64 pos_1,
+                       .param .u64 pos_2, .param .u64 out_0, .param .u64 out_1,
+                       .param .u64 out_2, .param .u64 out_3) {
+    .reg .pred %p<5>;
+    .reg .b32 %r<7>;
+    .reg .b64 %rd<10>;
+    .reg .f32 %f<8>;
+
+    ld.param.u32 %r0, [size];
+    mov.u32 %r1, %ctaid.x;
+    mov.u32 %r2, %ntid.x;
+    mov.u32 %r3, %tid.x;
+    mad.lo.u32 %r4, %r1, %r2, %r3;
+    setp.ge.u32 %p0, %r4, %r0;
+    @%p0 bra done;
+
+    mul.wide.u32 %rd0, %r4, 4;
+    ld.param.u64 %rd1, [tex];
+    ld.param.u32 %r5, [dimension];
+    ld.param.u32 %r6, [channels];
+
+    ld.param.u64 %rd2, [pos_0];
+    cvta.to.global.u64 %rd2, %rd2;
+    add.u64 %rd2, %rd2, %rd0;
+    ld.global.nc.f32 %f0, [%rd2];
+    ld.param.u64 %rd3, [pos_1];
+    cvta.to.global.u64 %rd3, %rd3;
+    add.u64 %rd3, %rd3, %rd0;
+    ld.global.nc.f32 %f1, [%rd3];
+
+    setp.eq.u32 %p1, %r5, 3;
+    @%p1 bra lookup_3d;
+    tex.2d.v4.f32.f32 {%f4, %f5, %f6, %f7}, [%rd1, {%f0, %f1}];
+    bra.uni store;
+
+lookup_3d:
+    ld.param.u64 %rd4, [pos_2];
+    cvta.to.global.u64 %rd4, %rd4;
+    add.u64 %rd4, %rd4, %rd0;
+    ld.global.nc.f32 %f2, [%rd4];
+    mov.f32 %f3, 0f00000000;
+    tex.3d.v4.f32.f32 {%f4, %f5, %f6, %f7}, [%rd1, {%f0, %f1, %f2, %f3}];
+
+store:
+    ld.param.u64 %rd5, [out_0];
+    cvta.to.global.u64 %rd5, %rd5;
+    add.u64 %rd5, %rd5, %rd0;
+    st.global.f32 [%rd5], %f4;
+    setp.lt.u32 %p2, %r6, 2;
+    @%p2 bra done;
+
+    ld.param.u64 %rd6, [out_1];
+    cvta.to.global.u64 %rd6, %rd6;
+    add.u64 %rd6, %rd6, %rd0;
+    st.global.f32 [%rd6], %f5;
+    setp.lt.u32 %p3, %r6, 3;
+    @%p3 bra done;
+
+    ld.param.u64 %rd7, [out_2];
+    cvta.to.global.u64 %rd7, %rd7;
+    add.u64 %rd7, %rd7, %rd0;
+    st.global.f32 [%rd7], %f6;
+    setp.lt.u32 %p4, %r6, 4;
+    @%p4 bra done;
+
+    ld.param.u64 %rd8, [out_3];
+    cvta.to.global.u64 %rd8, %rd8;
+    add.u64 %rd8, %rd8, %rd0;
+    st.global.f32 [%rd8], %f7;
+
+done:
+    ret;
+}
+)";
+
+/// Return the lookup kernel, which is compiled upon first use
+static CUfunction lookup_kernel() {
+    static std::mutex mutex;
+    static CUmodule module = nullptr;
+    static CUfunction kernel = nullptr;
+
+    std::lock_guard<std::mutex> guard(mutex);
+    if (!kernel) {
+        cu_check(cuModuleLoadData(&module, lookup_ptx));
+        cu_check(cuModuleGetFunction(&kernel, module, "lookup"));
+    }
+    return kernel;
+}
+
+#endif
+
+/// The CUDA arrays store 1, 2 or 4 channels
+static size_t padded_channels(size_t channels) { return channels == 3 ? 4 : channels; }
+
+CUDATexture::CUDATexture(size_t dimension, const size_t *shape, size_t channels,
+                         const float *data, FilterMode filter_mode, WrapMode wrap_mode)
+    : m_dimension(dimension), m_shape{ 1, 1, 1 }, m_channels(channels),
+      m_filter_mode(filter_mode), m_wrap_mode(wrap_mode) {
+    if (dimension != 2 && dimension != 3)
+        Throw("CUDATexture: the dimension must be 2 or 3 (got %zu)!", dimension);
+    if (channels < 1 || channels > 4)
+        Throw("CUDATexture: the channel count must be between 1 and 4 (got %zu)!", channels);
+    for (size_t i = 0; i < dimension; ++i) {
+        if (shape[i] == 0)
+            Throw("CUDATexture: the resolution must be positive!");
+        m_shape[i] = shape[i];
+    }
+
+#if defined(MTS_ENABLE_OPTIX)
+    CUDA_ARRAY3D_DESCRIPTOR array_desc = {};
+    array_desc.Width = m_shape[0];
+    array_desc.Height = m_shape[1];
+    array_desc.Depth = dimension == 3 ? m_shape[2] : 0;
+    array_desc.Format = CU_AD_FORMAT_FLOAT;
+    array_desc.NumChannels = (unsigned int) padded_channels(channels);
+
+    CUarray array = nullptr;
+    cu_check(cuArray3DCreate(&array, &array_desc));
+    m_array = array;
+
+    set_data(data);
+
+    CUDA_RESOURCE_DESC res_desc = {};
+    res_desc.resType = CU_RESOURCE_TYPE_ARRAY;
+    res_desc.res.array.hArray = array;
+
+    CUaddress_mode address_mode;
+    switch (wrap_mode) {
+        case WrapMode::Repeat: address_mode = CU_TR_ADDRESS_MODE_WRAP; break;
+        case WrapMode::Mirror: address_mode = CU_TR_ADDRESS_MODE_MIRROR; break;
+        default:               address_mode = CU_TR_ADDRESS_MODE_CLAMP; break;
+    }
+
+    CUDA_TEXTURE_DESC tex_desc = {};
+    for (size_t i = 0; i < 3; ++i)
+        tex_desc.addressMode[i] = address_mode;
+    tex_desc.filterMode = filter_mode == FilterMode::Linear ? CU_TR_FILTER_MODE_LINEAR
+                                                            : CU_TR_FILTER_MODE_POINT;
+    tex_desc.flags = CU_TRSF_NORMALIZED_COORDINATES;
+
+    CUtexObject texture = 0;
+    cu_check(cuTexObjectCreate(&texture, &res_desc, &tex_desc, nullptr));
+    m_texture = (unsigned long long) texture;
+#else
+    ENOKI_MARK_USED(data);
+    Throw("CUDATexture: Mitsuba was compiled without GPU support (set "
+          "MTS_ENABLE_OPTIX in CMake)!");
+#endif
+}
+
+CUDATexture::~CUDATexture() {
+#if defined(MTS_ENABLE_OPTIX)
+    // Lookups that are still in flight may access the texture
+    if (m_texture || m_array)
+        cuCtxSynchronize();
+    if (m_texture)
+        cuTexObjectDestroy((CUtexObject) m_texture);
+    if (m_array)
+        cuArrayDestroy((CUarray) m_array);
+#endif
+}
+
+void CUDATexture::set_data(const float *data) {
+#if defined(MTS_ENABLE_OPTIX)
+    size_t texels = m_shape[0] * m_shape[1] * m_shape[2],
+           channels = padded_channels(m_channels);
+
+    // Add a fourth channel to textures with 3 channels
+    std::unique_ptr<float[]> padded;
+    if (channels != m_channels) {
+        padded.reset(new float[texels * channels]);
+        for (size_t i = 0; i < texels; ++i) {
+            for (size_t c = 0; c < m_channels; ++c)
+                padded[i * channels + c] = data[i * m_channels + c];
+            padded[i * channels + m_channels] = 0.f;
+        }
+        data = padded.get();
+    }
+
+    // Wait for the lookups that are still in flight
+    cu_check(cuCtxSynchronize());
+
+    CUDA_MEMCPY3D copy = {};
+    copy.srcMemoryType = CU_MEMORYTYPE_HOST;
+    copy.srcHost = data;
+    copy.srcPitch = m_shape[0] * channels * sizeof(float);
+    copy.srcHeight = m_shape[1];
+    copy.dstMemoryType = CU_MEMORYTYPE_ARRAY;
+    copy.dstArray = (CUarray) m_array;
+    copy.WidthInBytes = m_shape[0] * channels * sizeof(float);
+    copy.Height = m_shape[1];
+    copy.Depth = m_shape[2];
+    cu_check(cuMemcpy3D(&copy));
+#else
+    ENOKI_MARK_USED(data);
+#endif
+}
+
+void CUDATexture::eval(const float *const *pos, float *const *out, size_t size) const {
+#if defined(MTS_ENABLE_OPTIX)
+    if (size == 0)
+        return;
+
+    CUtexObject texture = (CUtexObject) m_texture;
+    unsigned int size_u = (unsigned int) size,
+                 dimension = (unsigned int) m_dimension,
+                 channels = (unsigned int) m_channels;
+    const float *pos_ptr[3] = { pos[0], pos[1], m_dimension == 3 ? pos[2] : nullptr };
+    float *out_ptr[4] = { nullptr, nullptr, nullptr, nullptr };
+    for (size_t i = 0; i < m_channels; ++i)
+        out_ptr[i] = out[i];
+
+    void *args[] = { &texture, &size_u, &dimension, &channels,
+                     &pos_ptr[0], &pos_ptr[1], &pos_ptr[2],
+                     &out_ptr[0], &out_ptr[1], &out_ptr[2], &out_ptr[3] };
+
+    const unsigned int block_size = 128,
+                       block_count = (size_u + block_size - 1) / block_size;
+
+    cu_check(cuLaunchKernel(lookup_kernel(), block_count, 1, 1, block_size, 1, 1,
+                            0, nullptr, args, nullptr));
+#else
+    ENOKI_MARK_USED(pos);
+    ENOKI_MARK_USED(out);
+    ENOKI_MARK_USED(size);
+#endif
+}
+
+size_t CUDATexture::size_bytes() const {
+    return m_shape[0] * m_shape[1] * m_shape[2] * padded_channels(m_channels) * sizeof(float);
+}
+
+std::string CUDATexture::to_string() const {
+    std::ostringstream oss;
+    oss << "CUDATexture[" << std::endl
+        << "  shape = [" << m_shape[0] << ", " << m_shape[1];
+    if (m_dimension == 3)
+        oss << ", " << m_shape[2];
+    oss << "]," << std::endl
+        << "  channels = " << m_channels << "," << std::endl
+        << "  filter_mode = " << m_filter_mode << "," << std::endl
+        << "  wrap_mode = " << m_wrap_mode << "," << std::endl
+        << "  size = " << util::mem_string(size_bytes()) << std::endl
+        << "]";
+    return oss.str();
+}
+
+std::ostream &operator<<(std::ostream &os, CUDATexture::FilterMode value) {
+    switch (value) {
+        case CUDATexture::FilterMode::Nearest: os << "nearest"; break;
+        case CUDATexture::FilterMode::Linear:  os << "linear"; break;
+        default:                               os << "invalid"; break;
+    }
+    return os;
+}
+
+std::ostream &operator<<(std::ostream &os, CUDATexture::WrapMode value) {
+    switch (value) {
+        case CUDATexture::WrapMode::Repeat: os << "repeat"; break;
+        case CUDATexture::WrapMode::Mirror: os << "mirror"; break;
+        case CUDATexture::WrapMode::Clamp:  os << "clamp"; break;
+        default:                            os << "invalid"; break;
+    }
+    return os;
+}
+
+MTS_IMPLEMENT_CLASS(CUDATexture, Object)
+
+NAMESPACE_END(mitsuba)
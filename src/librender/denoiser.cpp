@@ -0,0 +1,239 @@
+#include <mitsuba/render/denoiser.h>
+#include <mitsuba/core/logger.h>
+#include <mitsuba/core/thread.h>
+#include <tbb/blocked_range.h>
+#include <tbb/parallel_for.h>
+#include <cstring>
+
+#if defined(MTS_ENABLE_OIDN)
+#  include <OpenImageDenoise/oidn.hpp>
+#endif
+
+NAMESPACE_BEGIN(mitsuba)
+
+Denoiser::Denoiser(Backend backend, float strength)
+    : m_backend(backend), m_strength(strength) {
+    if (m_backend == Backend::Auto)
+        m_backend = has_oidn() ? Backend::OIDN : Backend::Builtin;
+    else if (m_backend == Backend::OIDN && !has_oidn())
+        Throw("Denoiser: Mitsuba was compiled without support for Intel Open Image "
+              "Denoise (set MTS_ENABLE_OIDN in CMake)!");
+
+    if (!(m_strength > 0.f))
+        Throw("Denoiser: the strength must be > 0!");
+}
+
+Denoiser::~Denoiser() { }
+
+bool Denoiser::has_oidn() {
+#if defined(MTS_ENABLE_OIDN)
+    return true;
+#else
+    return false;
+#endif
+}
+
+/// Copy the first channel or the first three channels of a float32 bitmap into an interleaved RGB buffer
+static std::vector<float> gather_rgb(const Bitmap *bitmap, const Bitmap::Vector2u &size,
+                                     const char *name, bool single_channel) {
+    if (bitmap->component_format() != Struct::Type::Float32)
+        Throw("Denoiser::denoise(): the %s image must use the float32 component format!", name);
+    if (bitmap->size() != size)
+        Throw("Denoiser::denoise(): the %s image must have the size of the color image!", name);
+    if (!single_channel && bitmap->channel_count() < 3)
+        Throw("Denoiser::denoise(): the %s image must have at least three channels!", name);
+
+    size_t pixels = (size_t) size.x() * size.y(),
+           channel_count = bitmap->channel_count();
+
+    const float *data = (const float *) bitmap->data();
+    std::vector<float> result(pixels * 3);
+    for (size_t i = 0; i < pixels; ++i) {
+        for (size_t k = 0; k < 3; ++k) {
+            float value = data[i * channel_count + (single_channel ? 0 : k)];
+            result[i * 3 + k] = std::isfinite(value) ? value : 0.f;
+        }
+    }
+    return result;
+}
+
+ref<Bitmap> Denoiser::denoise(const Bitmap *color, const Bitmap *albedo,
+                              const Bitmap *normal) const {
+    const Bitmap::Vector2u &size = color->size();
+
+    /* The pixel format rather than the channel count tells whether the image
+       stores a luminance: a Y/YA image may carry further (e.g. AOV) channels */
+    bool single_channel = color->pixel_format() == Bitmap::PixelFormat::Y ||
+                          color->pixel_format() == Bitmap::PixelFormat::YA;
+
+    std::vector<float> color_data = gather_rgb(color, size, "color", single_channel),
+                       albedo_data, normal_data,
+                       output(color_data.size());
+    if (albedo)
+        albedo_data = gather_rgb(albedo, size, "albedo", albedo->channel_count() < 3);
+    if (normal)
+        normal_data = gather_rgb(normal, size, "normal", normal->channel_count() < 3);
+
+    const float *albedo_ptr = albedo ? albedo_data.data() : nullptr,
+                *normal_ptr = normal ? normal_data.data() : nullptr;
+
+    if (m_backend == Backend::OIDN)
+        denoise_oidn(Vector2i(size), color_data.data(), albedo_ptr, normal_ptr, output.data());
+    else
+        denoise_builtin(Vector2i(size), color_data.data(), albedo_ptr, normal_ptr, output.data());
+
+    ref<Bitmap> result = new Bitmap(single_channel ? Bitmap::PixelFormat::Y
+                                                   : Bitmap::PixelFormat::RGB,
+                                    Struct::Type::Float32, size);
+    float *target = (float *) result->data();
+    size_t pixels = (size_t) size.x() * size.y();
+    if (single_channel) {
+        for (size_t i = 0; i < pixels; ++i)
+            target[i] = output[i * 3];
+    } else {
+        std::memcpy(target, output.data(), pixels * 3 * sizeof(float));
+    }
+    return result;
+}
+
+void Denoiser::denoise_builtin(const Vector2i &size, const float *color, const float *albedo,
+                               const float *normal, float *output) const {
+    /* Edge-avoiding à-trous wavelet filter (Dammertz et al. 2010): a 5x5
+       B3-spline kernel is applied with exponentially growing spacing, and
+       the contributions of neighbors whose color, albedo or normal differ
+       from those of the center pixel are attenuated. */
+    const int iterations = 5;
+    const float kernel[5] = { 1.f / 16.f, 1.f / 4.f, 3.f / 8.f, 1.f / 4.f, 1.f / 16.f };
+    const float sigma_color = .4f * m_strength, sigma_albedo = .1f, sigma_normal = .2f;
+    const float albedo_epsilon = 1e-2f;
+
+    size_t pixels = (size_t) size.x() * size.y();
+
+    /* Filter the irradiance (color divided by albedo) rather than the color,
+       which keeps the texture detail out of the filter */
+    std::vector<float> current(color, color + pixels * 3), next(pixels * 3), tonemapped(pixels * 3);
+    if (albedo) {
+        for (size_t i = 0; i < pixels * 3; ++i)
+            current[i] /= albedo[i] + albedo_epsilon;
+    }
+
+    auto sqr_dist = [](const float *a, const float *b) {
+        float dx = a[0] - b[0], dy = a[1] - b[1], dz = a[2] - b[2];
+        return dx * dx + dy * dy + dz * dz;
+    };
+
+    for (int it = 0; it < iterations; ++it) {
+        int step = 1 << it;
+
+        // Compare colors on a compressed scale, with a tolerance that decreases with the spacing
+        float inv_var_color = 1.f / (sigma_color * sigma_color * std::ldexp(1.f, -it)),
+              inv_var_albedo = 1.f / (sigma_albedo * sigma_albedo),
+              inv_var_normal = 1.f / (sigma_normal * sigma_normal);
+
+        for (size_t i = 0; i < pixels * 3; ++i)
+            tonemapped[i] = current[i] / (1.f + std::abs(current[i]));
+
+        tbb::parallel_for(
+            tbb::blocked_range<int>(0, size.y()),
+            [&](const tbb::blocked_range<int> &range) {
+                for (int y = range.begin(); y != range.end(); ++y) {
+                    for (int x = 0; x < size.x(); ++x) {
+                        size_t p = (size_t) y * size.x() + x;
+                        float sum[3] = { 0.f, 0.f, 0.f }, weight_sum = 0.f;
+
+                        for (int j = 0; j < 5; ++j) {
+                            int yq = y + (j - 2) * step;
+                            if (yq < 0 || yq >= size.y())
+                                continue;
+
+                            for (int i = 0; i < 5; ++i) {
+                                int xq = x + (i - 2) * step;
+                                if (xq < 0 || xq >= size.x())
+                                    continue;
+
+                                size_t q = (size_t) yq * size.x() + xq;
+                                float exponent = sqr_dist(&tonemapped[3 * p], &tonemapped[3 * q]) *
+                                                 inv_var_color;
+                                if (albedo)
+                                    exponent += sqr_dist(&albedo[3 * p], &albedo[3 * q]) *
+                                                inv_var_albedo;
+                                if (normal)
+                                    exponent += sqr_dist(&normal[3 * p], &normal[3 * q]) *
+                                                inv_var_normal;
+
+                                float weight = kernel[i] * kernel[j] * std::exp(-exponent);
+                                for (int k = 0; k < 3; ++k)
+                                    sum[k] += weight * current[3 * q + k];
+                                weight_sum += weight;
+                            }
+                        }
+
+                        // The center pixel always contributes, hence weight_sum > 0
+                        for (int k = 0; k < 3; ++k)
+                            next[3 * p + k] = sum[k] / weight_sum;
+                    }
+                }
+            }
+        );
+
+        current.swap(next);
+    }
+
+    for (size_t i = 0; i < pixels * 3; ++i)
+        output[i] = albedo ? current[i] * (albedo[i] + albedo_epsilon) : current[i];
+}
+
+void Denoiser::denoise_oidn(const Vector2i &size, const float *color, const float *albedo,
+                            const float *normal, float *output) const {
+#if defined(MTS_ENABLE_OIDN)
+    oidn::DeviceRef device = oidn::newDevice();
+    device.set("numThreads", (int) std::max(__global_thread_count, (size_t) 1));
+    device.commit();
+
+    oidn::FilterRef filter = device.newFilter("RT");
+    filter.setImage("color", (void *) color, oidn::Format::Float3, size.x(), size.y());
+    if (albedo) {
+        filter.setImage("albedo", (void *) albedo, oidn::Format::Float3, size.x(), size.y());
+        // The normal guide is only supported in combination with the albedo
+        if (normal)
+            filter.setImage("normal", (void *) normal, oidn::Format::Float3, size.x(), size.y());
+    }
+    filter.setImage("output", output, oidn::Format::Float3, size.x(), size.y());
+    filter.set("hdr", true);
+    filter.commit();
+    filter.execute();
+
+    const char *message = nullptr;
+    if (device.getError(message) != oidn::Error::None)
+        Throw("Denoiser: Open Image Denoise failed: %s", message ? message : "unknown error");
+#else
+    ENOKI_MARK_USED(size);
+    ENOKI_MARK_USED(color);
+    ENOKI_MARK_USED(albedo);
+    ENOKI_MARK_USED(normal);
+    ENOKI_MARK_USED(output);
+    Throw("Denoiser: Mitsuba was compiled without support for Intel Open Image Denoise!");
+#endif
+}
+
+std::string Denoiser::to_string() const {
+    std::ostringstream oss;
+    oss << "Denoiser[" << std::endl
+        << "  backend = " << m_backend << "," << std::endl
+        << "  strength = " << m_strength << std::endl
+        << "]";
+    return oss.str();
+}
+
+std::ostream &operator<<(std::ostream &os, Denoiser::Backend value) {
+    switch (value) {
+        case Denoiser::Backend::Auto:    os << "auto"; break;
+        case Denoiser::Backend::Builtin: os << "builtin"; break;
+        case Denoiser::Backend::OIDN:    os << "oidn"; break;
+        default:                         os << "invalid"; break;
+    }
+    return os;
+}
+
+MTS_IMPLEMENT_CLASS(Denoiser, Object)
+NAMESPACE_END(mitsuba)
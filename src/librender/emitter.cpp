@@ -7,6 +7,18 @@ NAMESPACE_BEGIN(mitsuba)
 MTS_VARIANT Emitter<Float, Spectrum>::Emitter(const Properties &props) : Base(props) { }
 MTS_VARIANT Emitter<Float, Spectrum>::~Emitter() { }
 
+MTS_VARIANT typename Emitter<Float, Spectrum>::ScalarFloat
+Emitter<Float, Spectrum>::power() const {
+    return 1.f;
+}
+
+MTS_VARIANT std::tuple<typename Emitter<Float, Spectrum>::ScalarVector3f,
+                       typename Emitter<Float, Spectrum>::ScalarFloat,
+                       typename Emitter<Float, Spectrum>::ScalarFloat>
+Emitter<Float, Spectrum>::emission_cone() const {
+    return { ScalarVector3f(0.f, 0.f, 1.f), -1.f, 0.f };
+}
+
 MTS_IMPLEMENT_CLASS_VARIANT(Emitter, Endpoint, "emitter")
 MTS_INSTANTIATE_CLASS(Emitter)
 NAMESPACE_END(mitsuba)
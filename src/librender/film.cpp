@@ -62,6 +62,30 @@ MTS_VARIANT void Film<Float, Spectrum>::set_crop_window(const ScalarPoint2i &cro
     m_crop_offset = crop_offset;
 }
 
+MTS_VARIANT void Film<Float, Spectrum>::splat(const Point2f & /* pos */,
+                                              const Spectrum & /* value */,
+                                              const Wavelength & /* wavelengths */,
+                                              Mask /* active */) {
+    NotImplementedError("splat");
+}
+
+MTS_VARIANT ref<Bitmap> Film<Float, Spectrum>::denoised_bitmap() {
+    NotImplementedError("denoised_bitmap");
+}
+
+MTS_VARIANT std::vector<std::pair<typename Film<Float, Spectrum>::ScalarPoint2i, ref<Bitmap>>>
+Film<Float, Spectrum>::snapshot() {
+    NotImplementedError("snapshot");
+}
+
+MTS_VARIANT void Film<Float, Spectrum>::write_state(Stream * /* stream */) {
+    NotImplementedError("write_state");
+}
+
+MTS_VARIANT void Film<Float, Spectrum>::read_state(Stream * /* stream */, bool /* accumulate */) {
+    NotImplementedError("read_state");
+}
+
 MTS_VARIANT std::string Film<Float, Spectrum>::to_string() const {
     std::ostringstream oss;
     oss << "Film[" << std::endl
@@ -44,6 +44,7 @@ MTS_VARIANT void ImageBlock<Float, Spectrum>::set_size(const ScalarVector2i &siz
     m_size = size;
     m_data = empty<DynamicBuffer<Float>>(
         m_channel_count * hprod(size + 2 * m_border_size));
+    m_memory.set(slices(m_data) * sizeof(ScalarFloat));
 }
 
 MTS_VARIANT void ImageBlock<Float, Spectrum>::put(const ImageBlock *block) {
@@ -121,6 +122,13 @@ ImageBlock<Float, Spectrum>::put(const Point2f &pos_, const Float *value, Mask a
 
         uint32_t n = ceil2int<uint32_t>((m_filter->radius() - 2.f * math::RayEpsilon<ScalarFloat>) * 2.f);
 
+        switch (n) {
+            case 2: put_footprint<2>(pos, lo, hi, value, active); return active;
+            case 3: put_footprint<3>(pos, lo, hi, value, active); return active;
+            case 4: put_footprint<4>(pos, lo, hi, value, active); return active;
+            default: break;
+        }
+
         Point2f base = lo - pos;
         for (uint32_t i = 0; i < n; ++i) {
             Point2f p = base + i;
@@ -171,6 +179,79 @@ ImageBlock<Float, Spectrum>::put(const Point2f &pos_, const Float *value, Mask a
     return active;
 }
 
+MTS_VARIANT template <uint32_t Taps>
+void ImageBlock<Float, Spectrum>::put_footprint(const Point2f &pos, const Point2u &lo,
+                                                const Point2u &hi, const Float *value,
+                                                Mask active) {
+    Float weights_x[Taps], weights_y[Taps];
+
+    Point2f base = lo - pos;
+    ENOKI_UNROLL for (uint32_t i = 0; i < Taps; ++i) {
+        Point2f p = base + i;
+        if constexpr (!is_cuda_array_v<Float>) {
+            weights_x[i] = m_filter->eval_discretized(p.x(), active);
+            weights_y[i] = m_filter->eval_discretized(p.y(), active);
+        } else {
+            weights_x[i] = m_filter->eval(p.x(), active);
+            weights_y[i] = m_filter->eval(p.y(), active);
+        }
+    }
+
+    if (unlikely(m_normalize)) {
+        Float wx(0), wy(0);
+        ENOKI_UNROLL for (uint32_t i = 0; i < Taps; ++i) {
+            wx += weights_x[i];
+            wy += weights_y[i];
+        }
+
+        Float factor = rcp(wx * wy);
+        ENOKI_UNROLL for (uint32_t i = 0; i < Taps; ++i)
+            weights_x[i] *= factor;
+    }
+
+    ScalarVector2i size = m_size + 2 * m_border_size;
+
+    if constexpr (!is_array_v<Float>) {
+        /* The pixels of a row of the footprint are adjacent in memory: add the
+           weighted channels in place, which the compiler vectorizes */
+        if (!active)
+            return;
+
+        ScalarFloat *data = (ScalarFloat *) m_data.data();
+        ENOKI_UNROLL for (uint32_t yr = 0; yr < Taps; ++yr) {
+            uint32_t y = lo.y() + yr;
+            if (y > hi.y())
+                break;
+
+            ScalarFloat *row = data + m_channel_count * ((size_t) y * size.x() + lo.x());
+            ENOKI_UNROLL for (uint32_t xr = 0; xr < Taps; ++xr) {
+                if (lo.x() + xr > hi.x())
+                    break;
+
+                ScalarFloat weight = weights_y[yr] * weights_x[xr],
+                            *target = row + (size_t) xr * m_channel_count;
+                for (uint32_t k = 0; k < m_channel_count; ++k)
+                    target[k] += value[k] * weight;
+            }
+        }
+    } else {
+        ENOKI_UNROLL for (uint32_t yr = 0; yr < Taps; ++yr) {
+            UInt32 y = lo.y() + yr;
+            Mask enabled = active && y <= hi.y();
+
+            ENOKI_UNROLL for (uint32_t xr = 0; xr < Taps; ++xr) {
+                UInt32 x       = lo.x() + xr,
+                       offset  = m_channel_count * (y * size.x() + x);
+                Float weight = weights_y[yr] * weights_x[xr];
+
+                enabled &= x <= hi.x();
+                ENOKI_NOUNROLL for (uint32_t k = 0; k < m_channel_count; ++k)
+                    scatter_add(m_data, value[k] * weight, offset + k, enabled);
+            }
+        }
+    }
+}
+
 MTS_VARIANT std::string ImageBlock<Float, Spectrum>::to_string() const {
     std::ostringstream oss;
     oss << "ImageBlock[" << std::endl
@@ -1,10 +1,19 @@
-#include <thread>
+#include <algorithm>
+#include <atomic>
 #include <mutex>
+#include <numeric>
+#include <thread>
 
 #include <enoki/morton.h>
+#include <mitsuba/core/filesystem.h>
+#include <mitsuba/core/fstream.h>
+#include <mitsuba/core/plugin.h>
 #include <mitsuba/core/profiler.h>
 #include <mitsuba/core/progress.h>
+#include <mitsuba/core/properties.h>
+#include <mitsuba/core/random.h>
 #include <mitsuba/core/spectrum.h>
+#include <mitsuba/core/string.h>
 #include <mitsuba/core/timer.h>
 #include <mitsuba/core/util.h>
 #include <mitsuba/core/warp.h>
@@ -14,12 +23,90 @@
 #include <mitsuba/render/sensor.h>
 #include <mitsuba/render/spiral.h>
 #include <tbb/blocked_range.h>
+#include <tbb/enumerable_thread_specific.h>
 #include <tbb/parallel_for.h>
 
+#if defined(MTS_ENABLE_ZMQ)
+#  include <mitsuba/core/zmq11.h>
+#endif
+
+#define MTS_CHECKPOINT_MAGIC "MTS_CHECKPOINT"
+#define MTS_CHECKPOINT_VERSION 1
+
+/// Rough device memory footprint of one wavefront lane (path state and temporaries)
+#define MTS_GPU_BYTES_PER_SAMPLE 1024
+
 NAMESPACE_BEGIN(mitsuba)
 
+#if defined(MTS_ENABLE_ZMQ)
+NAMESPACE_BEGIN(detail)
+/// Image block handed out by the master of a distributed render job
+struct RemoteWorkItem {
+    int32_t offset[2];
+    int32_t size[2];
+    uint32_t block_size;
+    uint64_t block_id;
+    uint64_t pass;
+    /// Position in the master's list of work items
+    uint64_t index;
+};
+NAMESPACE_END(detail)
+#endif
+
+NAMESPACE_BEGIN(detail)
+/**
+ * Lock-free progress accounting shared by the rendering threads. Completed
+ * work is added to an atomic counter, and only the thread that crosses the
+ * next update threshold refreshes the (not thread-safe) progress reporter.
+ * The reported value is <tt>bias + scale * done / total</tt>.
+ */
+class ProgressCounter {
+public:
+    ProgressCounter(ProgressReporter *reporter, size_t total,
+                    float scale = 1.f, float bias = 0.f)
+        : m_reporter(reporter), m_total(total), m_scale(scale), m_bias(bias),
+          m_step(std::max(total / 200, (size_t) 1)), m_done(0), m_next(m_step) { }
+
+    void add(size_t amount = 1) {
+        size_t done = m_done.fetch_add(amount, std::memory_order_relaxed) + amount;
+        bool last = done >= m_total;
+        if (!last && done < m_next.load(std::memory_order_relaxed))
+            return;
+
+        // Another thread is refreshing the reporter: skip, unless this is the final update
+        while (m_busy.test_and_set(std::memory_order_acquire)) {
+            if (!last)
+                return;
+            std::this_thread::yield();
+        }
+
+        done = m_done.load(std::memory_order_relaxed);
+        m_next.store(done + m_step, std::memory_order_relaxed);
+        m_reporter->update(m_bias + m_scale * std::min(done / (float) m_total, 1.f));
+        m_busy.clear(std::memory_order_release);
+    }
+
+private:
+    ProgressReporter *m_reporter;
+    size_t m_total;
+    float m_scale, m_bias;
+    size_t m_step;
+    std::atomic<size_t> m_done, m_next;
+    std::atomic_flag m_busy = ATOMIC_FLAG_INIT;
+};
+NAMESPACE_END(detail)
+
 // -----------------------------------------------------------------------------
 
+MTS_VARIANT Integrator<Float, Spectrum>::Integrator(const Properties &props) {
+    /* Run the render jobs in a separate task arena with at most "thread_count"
+       threads, optionally pinned to the cores listed in "thread_affinity" */
+    size_t thread_count = props.size_("thread_count", 0);
+    std::vector<int> cores = ThreadPool::parse_cores(props.string("thread_affinity", ""));
+    if (thread_count > 0 || !cores.empty())
+        m_thread_pool = new ThreadPool(thread_count, cores);
+}
+
 MTS_VARIANT SamplingIntegrator<Float, Spectrum>::SamplingIntegrator(const Properties &props)
     : Base(props) {
 
@@ -31,11 +118,72 @@ MTS_VARIANT SamplingIntegrator<Float, Spectrum>::SamplingIntegrator(const Proper
         m_block_size = block_size;
     }
 
+    /* Block scheduling strategy: "spiral" hands out blocks from a spiral
+       protected by a mutex, "atomic" walks a precomputed spiral traversal
+       through a lock-free atomic cursor, and "tuned" additionally re-tiles
+       the image after the first pass based on the measured block costs. */
+    std::string scheduler = string::to_lower(props.string("block_scheduler", "spiral"));
+    m_lock_free_scheduler = scheduler == "atomic" || scheduler == "tuned";
+    m_tuned_scheduler = scheduler == "tuned";
+    if (scheduler != "spiral" && scheduler != "atomic" && scheduler != "tuned")
+        Throw("The \"block_scheduler\" parameter must either be equal to "
+              "\"spiral\", \"atomic\" or \"tuned\", found %s instead.", scheduler);
+
     m_samples_per_pass = (uint32_t) props.size_("samples_per_pass", (size_t) -1);
     m_timeout = props.float_("timeout", -1.f);
 
     /// Disable direct visibility of emitters if needed
     m_hide_emitters = props.bool_("hide_emitters", false);
+
+    /// Trace the samples of each block bounce by bounce (CPU packet variants)
+    m_wavefront = props.bool_("wavefront", false);
+    if (m_wavefront && (!is_array_v<Float> || is_cuda_array_v<Float>)) {
+        Log(Warn, "Wavefront mode is only supported by CPU packet variants, ignoring.");
+        m_wavefront = false;
+    }
+
+    /// Draw the camera ray positions from the filter instead of splatting the samples
+    m_filter_importance_sampling = props.bool_("filter_importance_sampling", false);
+    if (m_filter_importance_sampling)
+        m_box_filter = PluginManager::instance()->create_object<ReconstructionFilter>(
+            Properties("box"));
+
+    /// Stop sampling blocks whose estimated relative error is below this value
+    m_adaptive_threshold = props.float_("adaptive_threshold", 0.f);
+    if (m_adaptive_threshold < 0.f)
+        Throw("\"adaptive_threshold\" must be a value >= 0!");
+
+    m_adaptive_min_passes = (uint32_t) props.size_("adaptive_min_passes", 2);
+    if (m_adaptive_min_passes < 2)
+        Throw("\"adaptive_min_passes\" must be set to a value >= 2!");
+
+    /// Record the number of samples per pixel in an extra "sample_count" channel
+    m_sample_count_aov = props.bool_("sample_count_aov", false);
+
+    /// Record the time spent per pixel (in microseconds) in a "render_time" channel
+    m_render_time_aov = props.bool_("render_time_aov", false);
+    if (m_render_time_aov && is_cuda_array_v<Float>) {
+        Log(Warn, "The render time AOV is not supported by GPU variants, ignoring.");
+        m_render_time_aov = false;
+    }
+
+    /// Initial stride of the coarse levels of interactive previews (1 = disabled)
+    m_preview_stride = std::max(
+        math::round_to_power_of_two((uint32_t) props.size_("preview_stride", 8)), 1u);
+
+    /// Periodically save the film after completed passes (in seconds, -1 = disabled)
+    m_checkpoint_interval = props.float_("checkpoint_interval", -1.f);
+    m_checkpoint_file = props.string("checkpoint_file", "");
+    m_resume = props.bool_("resume", false);
+
+    // Device memory budget of the GPU wavefront in MiB (0 = unlimited)
+    m_gpu_memory_budget = props.size_("gpu_memory_budget", 0) * 1024 * 1024;
+
+    // Launch each GPU pass asynchronously while the next one is being recorded?
+    m_pipeline_passes = props.bool_("pipeline_passes", false);
+
+    m_blocks_done = 0;
+    m_samples_done = 0;
 }
 
 MTS_VARIANT SamplingIntegrator<Float, Spectrum>::~SamplingIntegrator() { }
@@ -44,11 +192,155 @@ MTS_VARIANT void SamplingIntegrator<Float, Spectrum>::cancel() {
     m_stop = true;
 }
 
+MTS_VARIANT void SamplingIntegrator<Float, Spectrum>::set_checkpoint(const fs::path &filename,
+                                                                     bool resume) {
+    m_checkpoint_file = filename;
+    m_resume = resume;
+}
+
+MTS_VARIANT void SamplingIntegrator<Float, Spectrum>::set_device_slice(uint32_t index,
+                                                                       uint32_t count) {
+    if (count == 0 || index >= count)
+        Throw("set_device_slice(): invalid slice %i/%i!", index, count);
+    if (!is_cuda_array_v<Float> && count > 1) {
+        Log(Warn, "set_device_slice(): only supported by GPU variants, rendering the full image.");
+        return;
+    }
+    m_slice_index = index;
+    m_slice_count = count;
+}
+
+MTS_VARIANT void SamplingIntegrator<Float, Spectrum>::write_checkpoint(Film *film,
+                                                                       size_t total_spp,
+                                                                       size_t samples_per_pass,
+                                                                       size_t passes_done) const {
+    // Write to a temporary file first so that a crash never leaves a truncated checkpoint
+    fs::path tmp_file = m_checkpoint_file;
+    tmp_file.replace_extension(".tmp");
+
+    /* scope */ {
+        ref<FileStream> stream = new FileStream(tmp_file, FileStream::ETruncReadWrite);
+        stream->write(std::string(MTS_CHECKPOINT_MAGIC));
+        stream->write((uint32_t) MTS_CHECKPOINT_VERSION);
+        stream->write((uint32_t) m_block_size);
+        stream->write((uint64_t) total_spp);
+        stream->write((uint64_t) samples_per_pass);
+        stream->write((uint64_t) passes_done);
+        film->write_state(stream);
+        stream->close();
+    }
+
+    if (!fs::rename(tmp_file, m_checkpoint_file))
+        Throw("write_checkpoint(): could not rename \"%s\" to \"%s\"!",
+              tmp_file.string(), m_checkpoint_file.string());
+
+    Log(Info, "Wrote checkpoint \"%s\" after %i passes.",
+        m_checkpoint_file.string(), passes_done);
+}
+
+MTS_VARIANT size_t SamplingIntegrator<Float, Spectrum>::read_checkpoint(Film *film,
+                                                                        size_t total_spp,
+                                                                        size_t samples_per_pass) {
+    ref<FileStream> stream = new FileStream(m_checkpoint_file, FileStream::ERead);
+
+    std::string magic;
+    uint32_t version, block_size;
+    uint64_t file_spp, file_samples_per_pass, passes_done;
+    stream->read(magic);
+    if (magic != MTS_CHECKPOINT_MAGIC)
+        Throw("read_checkpoint(): \"%s\" is not a checkpoint file!",
+              m_checkpoint_file.string());
+    stream->read(version);
+    if (version != MTS_CHECKPOINT_VERSION)
+        Throw("read_checkpoint(): unsupported checkpoint version %i!", version);
+
+    stream->read(block_size);
+    stream->read(file_spp);
+    stream->read(file_samples_per_pass);
+    stream->read(passes_done);
+
+    /* Blocks are seeded from their identifiers, which depend on the block
+       size and the pass structure. These must match for the result to be
+       identical to an uninterrupted render. */
+    if (block_size != m_block_size || file_spp != total_spp ||
+        file_samples_per_pass != samples_per_pass)
+        Throw("read_checkpoint(): the checkpoint was created with different render "
+              "settings (block size %i, %i samples, %i samples per pass)!",
+              block_size, file_spp, file_samples_per_pass);
+
+    film->read_state(stream);
+    return (size_t) passes_done;
+}
+
 MTS_VARIANT std::vector<std::string> SamplingIntegrator<Float, Spectrum>::aov_names() const {
     return { };
 }
 
+MTS_VARIANT std::vector<std::string>
+SamplingIntegrator<Float, Spectrum>::film_channels(const Film *film) const {
+    std::vector<std::string> channels = aov_names();
+    if (film) {
+        for (size_t i = 0; i < film->band_count(); ++i)
+            channels.push_back("band_" + std::to_string(i));
+    }
+    if (m_render_time_aov)
+        channels.push_back("render_time");
+    if (film && film->has_color_variance() && film->has_variance()) {
+        for (const char *name : { "variance.R", "variance.G", "variance.B" })
+            channels.push_back(name);
+    } else if (film && film->has_variance()) {
+        channels.push_back("variance");
+    }
+    if (m_sample_count_aov)
+        channels.push_back("sample_count");
+
+    // Insert default channels
+    for (size_t i = 0; i < 5; ++i)
+        channels.insert(channels.begin() + i, std::string(1, "XYZAW"[i]));
+    return channels;
+}
+
+MTS_VARIANT const typename SamplingIntegrator<Float, Spectrum>::ReconstructionFilter *
+SamplingIntegrator<Float, Spectrum>::block_filter(const Film *film) const {
+    return m_filter_importance_sampling ? m_box_filter.get() : film->reconstruction_filter();
+}
+
+MTS_VARIANT void
+SamplingIntegrator<Float, Spectrum>::configure_block_size(const ScalarVector2i &film_size,
+                                                          size_t n_threads) {
+    if (m_block_size != 0)
+        return;
+
+    uint32_t block_size = MTS_BLOCK_SIZE;
+    while (true) {
+        if (block_size == 1 || hprod((film_size + block_size - 1) / block_size) >= n_threads)
+            break;
+        block_size /= 2;
+    }
+    m_block_size = block_size;
+}
+
+MTS_VARIANT void SamplingIntegrator<Float, Spectrum>::prepare_pass(const Scene *, const Sensor *,
+                                                                  size_t, size_t) { }
+
+MTS_VARIANT void SamplingIntegrator<Float, Spectrum>::finish_pass(const Scene *, const Sensor *,
+                                                                 size_t, size_t) { }
+
+MTS_VARIANT size_t SamplingIntegrator<Float, Spectrum>::pass_sample_count(const Sensor *sensor) const {
+    size_t total_spp        = sensor->sampler()->sample_count();
+    size_t samples_per_pass = (m_samples_per_pass == (uint32_t) -1)
+                               ? total_spp : std::min((size_t) m_samples_per_pass, total_spp);
+    if ((total_spp % samples_per_pass) != 0)
+        Throw("sample_count (%d) must be a multiple of samples_per_pass (%d).",
+              total_spp, samples_per_pass);
+    return samples_per_pass;
+}
+
 MTS_VARIANT bool SamplingIntegrator<Float, Spectrum>::render(Scene *scene, Sensor *sensor) {
+    bool result = false;
+    if (run_in_thread_pool([&]() { result = render(scene, sensor); }))
+        return result;
+
     ScopedPhase sp(ProfilerPhase::Render);
     m_stop = false;
 
@@ -56,26 +348,42 @@ MTS_VARIANT bool SamplingIntegrator<Float, Spectrum>::render(Scene *scene, Senso
     ScalarVector2i film_size = film->crop_size();
 
     size_t total_spp        = sensor->sampler()->sample_count();
-    size_t samples_per_pass = (m_samples_per_pass == (size_t) -1)
-                               ? total_spp : std::min((size_t) m_samples_per_pass, total_spp);
-    if ((total_spp % samples_per_pass) != 0)
-        Throw("sample_count (%d) must be a multiple of samples_per_pass (%d).",
-              total_spp, samples_per_pass);
+    size_t samples_per_pass = pass_sample_count(sensor);
 
+    /* Films that are written to disk while rendering need all samples of a
+       row of blocks before they can release it */
+    bool streaming = film->streaming();
+    if (streaming && samples_per_pass != total_spp) {
+        Log(Warn, "The film is written while rendering, which requires a single "
+                  "pass: ignoring \"samples_per_pass\".");
+        samples_per_pass = total_spp;
+    }
     size_t n_passes = (total_spp + samples_per_pass - 1) / samples_per_pass;
 
-    std::vector<std::string> channels = aov_names();
-    bool has_aovs = !channels.empty();
-
-    // Insert default channels and set up the film
-    for (size_t i = 0; i < 5; ++i)
-        channels.insert(channels.begin() + i, std::string(1, "XYZAW"[i]));
+    std::vector<std::string> channels = film_channels(film);
+    bool has_aovs = channels.size() > 5;
     film->prepare(channels);
 
+    /* The film normalizes all channels by the accumulated filter weight.
+       Writing (2k + 1) * samples_per_pass during the k-th pass over a block
+       makes the normalized channel equal to the total sample count after
+       any number of (equally weighted) passes. */
+    size_t sample_count_channel = channels.size() - 1;
+    auto sample_count_value = [samples_per_pass](size_t pass) {
+        return ScalarFloat((2 * pass + 1) * samples_per_pass);
+    };
+
+    if (m_wavefront && !supports_wavefront())
+        Log(Warn, "This integrator has no wavefront implementation, tracing "
+                  "packets one at a time instead.");
+
     m_render_timer.reset();
+    m_blocks_done = 0;
+    m_samples_done = 0;
+    m_pass_times.clear();
     if constexpr (!is_cuda_array_v<Float>) {
         /// Render on the CPU using a spiral pattern
-        size_t n_threads = __global_thread_count;
+        size_t n_threads = thread_count();
         Log(Info, "Starting render job (%ix%i, %i sample%s,%s %i thread%s)",
             film_size.x(), film_size.y(),
             total_spp, total_spp == 1 ? "" : "s",
@@ -85,58 +393,488 @@ MTS_VARIANT bool SamplingIntegrator<Float, Spectrum>::render(Scene *scene, Senso
         if (m_timeout > 0.f)
             Log(Info, "Timeout specified: %.2f seconds.", m_timeout);
 
+        /* Single-pixel sensors (e.g. radiance and irradiance meters) do not
+           need the block traversal: split their samples across the threads */
+        if (hprod(film_size) == 1 && !streaming && !m_resume &&
+            (m_checkpoint_interval <= 0.f || m_checkpoint_file.empty()) &&
+            m_adaptive_threshold <= 0.f && !uses_pass_hooks()) {
+            render_single_pixel(scene, sensor, channels, total_spp);
+            if (!should_stop())
+                m_pass_times.push_back(render_time());
+            if (!m_stop)
+                Log(Info, "Rendering finished. (took %s)",
+                    util::time_string(m_render_timer.value(), true));
+            return !m_stop;
+        }
+
         // Find a good block size to use for splitting up the total workload.
-        if (m_block_size == 0) {
-            uint32_t block_size = MTS_BLOCK_SIZE;
-            while (true) {
-                if (block_size == 1 || hprod((film_size + block_size - 1) / block_size) >= n_threads)
-                    break;
-                block_size /= 2;
-            }
-            m_block_size = block_size;
+        configure_block_size(film_size, n_threads);
+
+        bool adaptive = m_adaptive_threshold > 0.f;
+        if (adaptive && streaming) {
+            Log(Warn, "Adaptive sampling is not supported when the film is written "
+                      "while rendering, disabling it.");
+            adaptive = false;
+        } else if (adaptive && n_passes < m_adaptive_min_passes) {
+            Log(Warn, "Adaptive sampling requires at least %i passes, disabling "
+                      "it (decrease \"samples_per_pass\" to enable it).",
+                m_adaptive_min_passes);
+            adaptive = false;
         }
 
-        Spiral spiral(film, m_block_size, n_passes);
+        // Streaming films receive the blocks in scanline order
+        Spiral spiral(film, m_block_size, adaptive ? 1 : n_passes, streaming);
 
         ThreadEnvironment env;
         ref<ProgressReporter> progress = new ProgressReporter("Rendering");
-        std::mutex mutex;
+
+        /* Sampler, image block and AOV buffer of every worker thread, which
+           are reused by all blocks and passes of the render job */
+        struct Worker {
+            ref<Sampler> sampler;
+            ref<ImageBlock> block;
+            std::vector<Float> aovs;
+            bool busy = false;
+        };
+        tbb::enumerable_thread_specific<Worker> workers;
+
+        /* A thread that starts another block while its state is in use
+           (through nested parallelism within render_block()) receives the
+           temporary state instead */
+        auto acquire_worker = [&](Worker &temporary) -> Worker & {
+            Worker &local = workers.local();
+            Worker &worker = local.busy ? temporary : local;
+            if (!worker.sampler) {
+                worker.sampler = sensor->sampler()->clone();
+                worker.block = new ImageBlock(m_block_size, channels.size(),
+                                              block_filter(film), !has_aovs);
+                worker.aovs.resize(channels.size());
+            }
+            worker.busy = true;
+            return worker;
+        };
 
         // Total number of blocks to be handled, including multiple passes.
-        size_t total_blocks = spiral.block_count() * n_passes,
-               blocks_done = 0;
+        size_t total_blocks = spiral.block_count() * n_passes;
+        detail::ProgressCounter blocks_done(progress, total_blocks);
 
-        tbb::parallel_for(
-            tbb::blocked_range<size_t>(0, total_blocks, 1),
-            [&](const tbb::blocked_range<size_t> &range) {
-                ScopedSetThreadEnvironment set_env(env);
-                ref<Sampler> sampler = sensor->sampler()->clone();
-                ref<ImageBlock> block = new ImageBlock(m_block_size, channels.size(),
-                                                       film->reconstruction_filter(),
-                                                       !has_aovs);
-                scoped_flush_denormals flush_denormals(true);
-                std::unique_ptr<Float[]> aovs(new Float[channels.size()]);
+        /* Position of the next block in the sequence of blocks committed to
+           the film by this job (see Film::put(block, index)) */
+        size_t sequence_base = 0;
 
-                // For each block
-                for (auto i = range.begin(); i != range.end() && !should_stop(); ++i) {
-                    auto [offset, size, block_id] = spiral.next_block();
-                    Assert(hprod(size) != 0);
-                    block->set_size(size);
-                    block->set_offset(offset);
+        // Completion time of every pass in seconds (negative: not rendered)
+        std::vector<float> pass_end(n_passes, -1.f);
+        auto end_pass = [&](size_t pass) { pass_end[pass] = render_time(); };
+
+        if (!adaptive) {
+            bool checkpoint = m_checkpoint_interval > 0.f && !m_checkpoint_file.empty();
+            if (streaming && (checkpoint || m_resume)) {
+                Log(Warn, "Checkpointing is not supported when the film is written "
+                          "while rendering, ignoring.");
+                checkpoint = false;
+            }
+
+            size_t start_pass = 0;
+            if (m_resume && !streaming && !m_checkpoint_file.empty() &&
+                fs::exists(m_checkpoint_file)) {
+                start_pass = read_checkpoint(film, total_spp, samples_per_pass);
+                blocks_done.add(start_pass * spiral.block_count());
+                Log(Info, "Resuming from checkpoint \"%s\" (%i/%i passes done).",
+                    m_checkpoint_file.string(), start_pass, n_passes);
+            }
+
+            // Per-block cost (in microseconds) measured for the "tuned" scheduler
+            std::vector<ScalarFloat> block_cost;
+
+            /* Number of blocks completed by render_blocks(): every multiple of
+               the block count of a pass marks the end of a pass */
+            std::atomic<size_t> spiral_blocks_done(0);
+
+            /* Render the blocks with indices [begin, end) of the traversal. When
+               'random_access' is set, blocks are claimed through an atomic
+               cursor instead of locking the spiral. */
+            auto render_blocks = [&](size_t begin, size_t end, bool random_access) {
+                std::atomic<size_t> block_cursor(begin);
+
+                tbb::parallel_for(
+                    tbb::blocked_range<size_t>(begin, end, 1),
+                    [&](const tbb::blocked_range<size_t> &range) {
+                        ScopedSetThreadEnvironment set_env(env);
+                        Worker temporary, &worker = acquire_worker(temporary);
+                        Sampler *sampler = worker.sampler;
+                        ImageBlock *block = worker.block;
+                        Float *aovs = worker.aovs.data();
+                        scoped_flush_denormals flush_denormals(true);
+
+                        // For each block
+                        for (auto i = range.begin(); i != range.end() && !should_stop(); ++i) {
+                            size_t index = random_access ? block_cursor++ : 0;
+                            auto [offset, size, block_id] =
+                                random_access ? spiral.block(index)
+                                              : spiral.next_block();
+                            Assert(hprod(size) != 0);
+                            block->set_size(size);
+                            block->set_offset(offset);
+
+                            // Position of the block in the spiral traversal
+                            size_t pass = n_passes - 1 - block_id / spiral.block_count(),
+                                   traversal_index = pass * spiral.block_count() +
+                                                     block_id % spiral.block_count();
+
+                            if (m_sample_count_aov)
+                                aovs[sample_count_channel] = sample_count_value(pass);
+
+                            Timer block_timer;
+                            render_block(scene, sensor, sampler, block,
+                                         aovs, samples_per_pass, block_id);
+                            if (!block_cost.empty())
+                                block_cost[index % spiral.block_count()] = (ScalarFloat)
+                                    block_timer.value_in<std::chrono::microseconds>();
+
+                            film->put(block, sequence_base + traversal_index - begin);
+
+                            size_t spiral_done = ++spiral_blocks_done;
+                            if (spiral_done % spiral.block_count() == 0)
+                                end_pass(start_pass + spiral_done / spiral.block_count() - 1);
+
+                            m_blocks_done.fetch_add(1, std::memory_order_relaxed);
+                            m_samples_done.fetch_add(hprod(size) * samples_per_pass,
+                                                     std::memory_order_relaxed);
+                            blocks_done.add();
+                        }
+                        worker.busy = false;
+                    }
+                );
+
+                sequence_base += end - begin;
+            };
+
+            struct TunedBlock {
+                ScalarPoint2i offset;
+                ScalarVector2i size;
+                uint32_t block_size;
+                ScalarFloat cost;
+                size_t seed_offset;
+            };
+
+            /* Block layout of the "tuned" scheduler, sorted by decreasing cost.
+               Sampler seeds are allocated in units of pixels past the range used
+               by the spiral: block j of pass k uses the block id
+               (seed_base + (k - 1) * seed_stride + seed_offset_j) / block_size_j^2,
+               which keeps the seeded pixel ranges of all blocks disjoint. */
+            std::vector<TunedBlock> tuned;
+            size_t max_units = 4 * (size_t) m_block_size * m_block_size,
+                   seed_base = (total_blocks * m_block_size * m_block_size + max_units - 1) /
+                               max_units * max_units,
+                   seed_stride = 0;
+
+            // Derive the tuned layout from the block costs measured during a pass
+            auto tune_blocks = [&]() {
+                size_t block_count = spiral.block_count();
+                ScalarFloat total_cost =
+                    std::accumulate(block_cost.begin(), block_cost.end(), ScalarFloat(0));
+
+                // No block should take longer than this, so that every thread gets several
+                ScalarFloat target = total_cost / (4.f * (ScalarFloat) n_threads);
+                uint32_t min_size = std::min(m_block_size, 8u);
+
+                ScalarVector2i grid = (film_size + (int) m_block_size - 1) / (int) m_block_size;
+                std::vector<size_t> grid_index((size_t) hprod(grid));
+                for (size_t i = 0; i < block_count; ++i) {
+                    ScalarVector2i g = ScalarVector2i(std::get<0>(spiral.block(i)) -
+                                                      film->crop_offset()) / (int) m_block_size;
+                    grid_index[(size_t) (g.y() * grid.x() + g.x())] = i;
+                }
+
+                std::vector<bool> done(block_count, false);
+                size_t merged = 0, split = 0;
+
+                // Merge aligned groups of 2x2 cheap blocks
+                for (int y = 0; y + 1 < grid.y(); y += 2) {
+                    for (int x = 0; x + 1 < grid.x(); x += 2) {
+                        size_t ids[4] = { grid_index[y * grid.x() + x],
+                                          grid_index[y * grid.x() + x + 1],
+                                          grid_index[(y + 1) * grid.x() + x],
+                                          grid_index[(y + 1) * grid.x() + x + 1] };
+                        ScalarFloat cost = block_cost[ids[0]] + block_cost[ids[1]] +
+                                           block_cost[ids[2]] + block_cost[ids[3]];
+                        if (cost > .5f * target)
+                            continue;
+
+                        auto [offset, size, block_id] = spiral.block(ids[0]);
+                        ScalarVector2i size_x = std::get<1>(spiral.block(ids[1])),
+                                       size_y = std::get<1>(spiral.block(ids[2]));
+                        tuned.push_back({ offset,
+                                          ScalarVector2i(size.x() + size_x.x(), size.y() + size_y.y()),
+                                          2 * m_block_size, cost, 0 });
+                        for (size_t id : ids)
+                            done[id] = true;
+                        merged++;
+                        ENOKI_MARK_USED(block_id);
+                    }
+                }
+
+                // Split expensive blocks into 4^k smaller ones
+                for (size_t i = 0; i < block_count; ++i) {
+                    if (done[i])
+                        continue;
+                    auto [offset, size, block_id] = spiral.block(i);
+                    ENOKI_MARK_USED(block_id);
 
-                    render_block(scene, sensor, sampler, block,
-                                 aovs.get(), samples_per_pass, block_id);
+                    uint32_t bs = m_block_size;
+                    ScalarFloat cost = block_cost[i];
+                    while (cost > target && bs / 2 >= min_size) {
+                        bs /= 2;
+                        cost /= 4.f;
+                    }
+                    if (bs < m_block_size)
+                        split++;
+
+                    for (int y = 0; y < size.y(); y += (int) bs)
+                        for (int x = 0; x < size.x(); x += (int) bs)
+                            tuned.push_back({ ScalarPoint2i(offset + ScalarVector2i(x, y)),
+                                              min(ScalarVector2i((int) bs), size - ScalarVector2i(x, y)),
+                                              bs, cost, 0 });
+                }
+
+                // Allocate the seed ranges (largest blocks first to keep them aligned)
+                std::stable_sort(tuned.begin(), tuned.end(),
+                                 [](const TunedBlock &a, const TunedBlock &b) {
+                                     return a.block_size > b.block_size;
+                                 });
+                for (TunedBlock &b : tuned) {
+                    b.seed_offset = seed_stride;
+                    seed_stride += (size_t) b.block_size * b.block_size;
+                }
+                seed_stride = (seed_stride + max_units - 1) / max_units * max_units;
+
+                // Hand out the most expensive blocks first
+                std::stable_sort(tuned.begin(), tuned.end(),
+                                 [](const TunedBlock &a, const TunedBlock &b) {
+                                     return a.cost > b.cost;
+                                 });
+
+                Log(Info, "Tuned block layout: %i blocks (%i split, %i groups merged).",
+                    tuned.size(), split, merged);
+            };
+
+            // Render a pass using the tuned block layout
+            auto render_tuned = [&](size_t pass) {
+                std::atomic<size_t> block_cursor(0);
+                detail::ProgressCounter tuned_done(progress, tuned.size(), 1.f / n_passes,
+                                                   pass / (float) n_passes);
+
+                tbb::parallel_for(
+                    tbb::blocked_range<size_t>(0, tuned.size(), 1),
+                    [&](const tbb::blocked_range<size_t> &range) {
+                        ScopedSetThreadEnvironment set_env(env);
+                        Worker temporary, &worker = acquire_worker(temporary);
+                        Sampler *sampler = worker.sampler;
+                        ImageBlock *block = worker.block;
+                        Float *aovs = worker.aovs.data();
+                        scoped_flush_denormals flush_denormals(true);
+
+                        for (auto i = range.begin(); i != range.end() && !should_stop(); ++i) {
+                            size_t slot = block_cursor++;
+                            const TunedBlock &b = tuned[slot];
+                            block->set_size(b.size);
+                            block->set_offset(b.offset);
+
+                            if (m_sample_count_aov)
+                                aovs[sample_count_channel] = sample_count_value(pass);
+
+                            size_t block_id = (seed_base + (pass - 1) * seed_stride + b.seed_offset) /
+                                              ((size_t) b.block_size * b.block_size);
+                            render_block(scene, sensor, sampler, block, aovs,
+                                         samples_per_pass, block_id, b.block_size);
+
+                            film->put(block, sequence_base + slot);
+
+                            m_blocks_done.fetch_add(1, std::memory_order_relaxed);
+                            m_samples_done.fetch_add(hprod(b.size) * samples_per_pass,
+                                                     std::memory_order_relaxed);
+                            tuned_done.add();
+                        }
+                        worker.busy = false;
+                    }
+                );
+
+                sequence_base += tuned.size();
+            };
 
-                    film->put(block);
+            bool tune = m_tuned_scheduler && n_passes > 1,
+                 hooks = uses_pass_hooks();
+            if (!checkpoint && start_pass == 0 && !tune && !hooks) {
+                render_blocks(0, total_blocks, m_lock_free_scheduler);
+            } else {
+                /* Checkpoints must capture the film after a whole number of
+                   passes, the tuned scheduler needs the costs of a whole
+                   pass, and the pass hooks must run in between, so render one
+                   pass at a time */
+                size_t block_count = spiral.block_count();
+                Timer checkpoint_timer;
+                for (size_t pass = start_pass; pass < n_passes && !should_stop(); ++pass) {
+                    if (hooks)
+                        prepare_pass(scene, sensor, pass, n_passes);
 
-                    /* Critical section: update progress bar */ {
-                        std::lock_guard<std::mutex> lock(mutex);
-                        blocks_done++;
-                        progress->update(blocks_done / (ScalarFloat) total_blocks);
+                    if (!tuned.empty()) {
+                        render_tuned(pass);
+                        if (!should_stop())
+                            end_pass(pass);
+                    } else {
+                        if (tune)
+                            block_cost.assign(block_count, 0.f);
+                        render_blocks(pass * block_count, (pass + 1) * block_count, true);
+                        if (tune && !should_stop())
+                            tune_blocks();
+                        block_cost.clear();
+                    }
+
+                    if (hooks && !should_stop())
+                        finish_pass(scene, sensor, pass, n_passes);
+
+                    if (checkpoint && !should_stop() && pass + 1 < n_passes &&
+                        checkpoint_timer.value() > 1000.f * m_checkpoint_interval) {
+                        write_checkpoint(film, total_spp, samples_per_pass, pass + 1);
+                        checkpoint_timer.reset();
                     }
                 }
             }
-        );
+
+            // The checkpoint is obsolete once the render has completed
+            if (!should_stop() && !m_checkpoint_file.empty() && fs::exists(m_checkpoint_file))
+                fs::remove(m_checkpoint_file);
+        } else {
+            Log(Info, "Adaptive sampling enabled (threshold = %.4f, at least %i passes).",
+                m_adaptive_threshold, m_adaptive_min_passes);
+            if (m_checkpoint_interval > 0.f || m_resume)
+                Log(Warn, "Checkpointing is not supported in combination with "
+                          "adaptive sampling, ignoring.");
+
+            struct AdaptiveBlock {
+                ScalarPoint2i offset;
+                ScalarVector2i size;
+                size_t index;
+                uint32_t passes;
+                bool converged;
+            };
+
+            // Enumerate the blocks of a single pass (in spiral order)
+            std::vector<AdaptiveBlock> blocks;
+            blocks.reserve(spiral.block_count());
+            for (size_t i = 0; i < spiral.block_count(); ++i) {
+                auto [offset, size, block_id] = spiral.block(i);
+                blocks.push_back({ offset, size, block_id, 0u, false });
+            }
+
+            /* Running mean and sum of squared deviations (Welford) of the
+               luminance estimates computed by the individual passes */
+            size_t pixel_count = (size_t) hprod(film_size);
+            std::vector<ScalarFloat> mean(pixel_count, 0.f), m2(pixel_count, 0.f);
+
+            // Updates the per-pixel statistics and checks for convergence
+            auto update_block = [&](const ImageBlock *block, AdaptiveBlock &b) {
+                const ScalarFloat *data = (const ScalarFloat *) block->data().data();
+                int border = block->border_size();
+                size_t stride = (size_t) (b.size.x() + 2 * border),
+                       ch     = block->channel_count();
+                ScalarPoint2i rel = b.offset - film->crop_offset();
+
+                ScalarFloat n = (ScalarFloat) ++b.passes, error = 0.f;
+                for (int y = 0; y < b.size.y(); ++y) {
+                    for (int x = 0; x < b.size.x(); ++x) {
+                        const ScalarFloat *v = data + ((y + border) * stride + x + border) * ch;
+                        ScalarFloat value = v[4] > 0.f ? v[1] / v[4] : 0.f;
+                        size_t idx = (size_t) (rel.y() + y) * film_size.x() + rel.x() + x;
+
+                        ScalarFloat delta = value - mean[idx];
+                        mean[idx] += delta / n;
+                        m2[idx] += delta * (value - mean[idx]);
+
+                        // Relative variance of the per-pixel mean estimate
+                        if (n > 1.f)
+                            error += m2[idx] / (n * (n - 1.f) *
+                                                sqr(std::max(mean[idx], ScalarFloat(1e-3f))));
+                    }
+                }
+
+                error = std::sqrt(error / hprod(b.size));
+                b.converged = b.passes >= m_adaptive_min_passes &&
+                              error < m_adaptive_threshold;
+            };
+
+            std::vector<size_t> active(blocks.size());
+            std::iota(active.begin(), active.end(), 0);
+
+            bool hooks = uses_pass_hooks();
+            for (size_t pass = 0; pass < n_passes && !active.empty() && !should_stop(); ++pass) {
+                // Unique block identifiers, consistent with the non-adaptive mode
+                size_t pass_offset = (n_passes - 1 - pass) * blocks.size();
+
+                if (hooks)
+                    prepare_pass(scene, sensor, pass, n_passes);
+
+                tbb::parallel_for(
+                    tbb::blocked_range<size_t>(0, active.size(), 1),
+                    [&](const tbb::blocked_range<size_t> &range) {
+                        ScopedSetThreadEnvironment set_env(env);
+                        Worker temporary, &worker = acquire_worker(temporary);
+                        Sampler *sampler = worker.sampler;
+                        ImageBlock *block = worker.block;
+                        Float *aovs = worker.aovs.data();
+                        scoped_flush_denormals flush_denormals(true);
+
+                        for (auto i = range.begin(); i != range.end() && !should_stop(); ++i) {
+                            AdaptiveBlock &b = blocks[active[i]];
+                            block->set_size(b.size);
+                            block->set_offset(b.offset);
+
+                            if (m_sample_count_aov)
+                                aovs[sample_count_channel] = sample_count_value(pass);
+
+                            render_block(scene, sensor, sampler, block, aovs,
+                                         samples_per_pass, b.index + pass_offset);
+
+                            film->put(block, sequence_base + i);
+                            update_block(block, b);
+
+                            m_blocks_done.fetch_add(1, std::memory_order_relaxed);
+                            m_samples_done.fetch_add(hprod(b.size) * samples_per_pass,
+                                                     std::memory_order_relaxed);
+
+                            // Converged blocks will not be rendered in the remaining passes
+                            blocks_done.add(b.converged ? n_passes - pass : 1);
+                        }
+                        worker.busy = false;
+                    }
+                );
+
+                if (!should_stop())
+                    end_pass(pass);
+
+                if (hooks && !should_stop())
+                    finish_pass(scene, sensor, pass, n_passes);
+
+                sequence_base += active.size();
+                active.erase(std::remove_if(active.begin(), active.end(),
+                                            [&](size_t i) { return blocks[i].converged; }),
+                             active.end());
+            }
+
+            size_t samples_taken = 0;
+            for (const AdaptiveBlock &b : blocks)
+                samples_taken += (size_t) b.passes * samples_per_pass * hprod(b.size);
+            Log(Info, "Adaptive sampling: %.1f samples per pixel on average (maximum: %i).",
+                samples_taken / (double) pixel_count, total_spp);
+        }
+
+        float previous_end = 0.f;
+        for (float t : pass_end) {
+            if (t < 0.f)
+                continue;
+            m_pass_times.push_back(t - previous_end);
+            previous_end = t;
+        }
     } else {
         Log(Info, "Start rendering...");
 
@@ -144,31 +882,98 @@ MTS_VARIANT bool SamplingIntegrator<Float, Spectrum>::render(Scene *scene, Senso
         sampler->set_samples_per_wavefront((uint32_t) samples_per_pass);
 
         ScalarFloat diff_scale_factor = rsqrt((ScalarFloat) sampler->sample_count());
-        ScalarUInt32 wavefront_size = hprod(film_size) * (uint32_t) samples_per_pass;
-        if (sampler->wavefront_size() != wavefront_size)
-            sampler->seed(0, wavefront_size);
 
-        UInt32 idx = arange<UInt32>(wavefront_size);
-        if (samples_per_pass != 1)
-            idx /= (uint32_t) samples_per_pass;
-
-        ref<ImageBlock> block = new ImageBlock(film_size, channels.size(),
-                                               film->reconstruction_filter(),
-                                               !has_aovs);
-        block->clear();
-        block->set_offset(sensor->film()->crop_offset());
+        if (m_adaptive_threshold > 0.f)
+            Log(Warn, "Adaptive sampling is not supported by GPU variants, ignoring.");
 
-        Vector2f pos = Vector2f(Float(idx % uint32_t(film_size[0])),
-                                Float(idx / uint32_t(film_size[0])));
-        pos += block->offset();
+        /* Split the wavefront into chunks of whole image rows when it would
+           exceed the memory budget */
+        uint32_t chunk_rows = (uint32_t) film_size.y();
+        if (m_gpu_memory_budget > 0) {
+            size_t row_bytes = (size_t) film_size.x() *
+                (samples_per_pass * MTS_GPU_BYTES_PER_SAMPLE + channels.size() * sizeof(ScalarFloat));
+            chunk_rows = (uint32_t) std::min((size_t) film_size.y(),
+                                             std::max((size_t) 1, m_gpu_memory_budget / row_bytes));
+        }
 
         std::vector<Float> aovs(channels.size());
+        ScalarPoint2i crop_offset = film->crop_offset();
+
+        // Render the rows [y, y + rows) of the film
+        auto render_chunk = [&](uint32_t y, uint32_t rows, bool chunked) {
+            ScalarUInt32 chunk_size = (uint32_t) film_size.x() * rows * (uint32_t) samples_per_pass;
+            if (chunked)
+                sampler->seed_chunk(0, (size_t) y * film_size.x() * samples_per_pass, chunk_size);
+            else if (sampler->wavefront_size() != chunk_size)
+                sampler->seed(0, chunk_size);
 
-        for (size_t i = 0; i < n_passes; i++)
-            render_sample(scene, sensor, sampler, block, aovs.data(),
-                          pos, diff_scale_factor);
+            UInt32 idx = arange<UInt32>(chunk_size);
+            if (samples_per_pass != 1)
+                idx /= (uint32_t) samples_per_pass;
 
-        film->put(block);
+            ref<ImageBlock> block = new ImageBlock(ScalarVector2i(film_size.x(), (int) rows),
+                                                   channels.size(),
+                                                   block_filter(film),
+                                                   !has_aovs);
+            block->clear();
+            block->set_offset(crop_offset + ScalarVector2i(0, (int) y));
+
+            Vector2f pos = Vector2f(Float(idx % uint32_t(film_size[0])),
+                                    Float(idx / uint32_t(film_size[0])));
+            pos += block->offset();
+            sampler->set_pixel(Point2u(pos));
+
+            for (size_t i = 0; i < n_passes; i++) {
+                if (m_sample_count_aov)
+                    aovs[sample_count_channel] = sample_count_value(i);
+                render_sample(scene, sensor, sampler, block, aovs.data(),
+                              pos, diff_scale_factor);
+
+                /* Flush the accumulation of this pass into the block. The kernel
+                   is launched without synchronizing, so that the host records
+                   the next pass while it executes. */
+                if (m_pipeline_passes)
+                    cuda_eval();
+            }
+
+            film->put(block);
+            m_samples_done.fetch_add((size_t) chunk_size * n_passes, std::memory_order_relaxed);
+        };
+
+        // Rows [y_begin, y_end) of this device slice (see set_device_slice())
+        uint32_t y_begin = (uint32_t) ((uint64_t) film_size.y() * m_slice_index / m_slice_count),
+                 y_end   = (uint32_t) ((uint64_t) film_size.y() * (m_slice_index + 1) / m_slice_count),
+                 slice_rows = y_end - y_begin;
+        if (m_slice_count > 1)
+            Log(Info, "Rendering the rows [%i, %i) of slice %i/%i.",
+                y_begin, y_end, m_slice_index + 1, m_slice_count);
+
+        chunk_rows = std::min(chunk_rows, slice_rows);
+        if (slice_rows == 0) {
+            // Nothing to do
+        } else if (chunk_rows == (uint32_t) film_size.y()) {
+            render_chunk(0, chunk_rows, false);
+        } else if (chunk_rows == slice_rows) {
+            render_chunk(y_begin, slice_rows, true);
+        } else {
+            uint32_t chunk_count = (slice_rows + chunk_rows - 1) / chunk_rows;
+            Log(Info, "Splitting the wavefront into %i chunks of %i rows (%s budget).",
+                chunk_count, chunk_rows, util::mem_string(m_gpu_memory_budget));
+
+            ref<ProgressReporter> progress = new ProgressReporter("Rendering");
+            for (uint32_t i = 0; i < chunk_count && !should_stop(); ++i) {
+                uint32_t y = y_begin + i * chunk_rows;
+                render_chunk(y, std::min(chunk_rows, y_end - y), true);
+
+                // Launch the chunk now, so that its memory is released before the next one
+                cuda_eval();
+                progress->update((i + 1) / (ScalarFloat) chunk_count);
+            }
+        }
+
+        // All passes are fused into the kernels of the chunks
+        if (!should_stop())
+            m_pass_times.push_back(render_time());
     }
 
     if (!m_stop)
@@ -178,15 +983,710 @@ MTS_VARIANT bool SamplingIntegrator<Float, Spectrum>::render(Scene *scene, Senso
     return !m_stop;
 }
 
+MTS_VARIANT bool
+SamplingIntegrator<Float, Spectrum>::render_preview(Scene *scene, Sensor *sensor,
+                                                    const std::function<void(uint32_t, size_t)> &update) {
+    bool result = false;
+    if (run_in_thread_pool([&]() { result = render_preview(scene, sensor, update); }))
+        return result;
+
+    ScopedPhase sp(ProfilerPhase::Render);
+    m_stop = false;
+
+    ref<Film> film = sensor->film();
+    if (film->streaming())
+        Throw("render_preview(): the film must not be written while rendering!");
+
+    std::vector<std::string> channels = film_channels(film);
+    bool has_aovs = channels.size() > 5;
+    size_t sample_count_channel = channels.size() - 1,
+           total_spp = sensor->sampler()->sample_count();
+    film->prepare(channels);
+
+    m_render_timer.reset();
+    m_blocks_done = 0;
+    m_samples_done = 0;
+
+    if constexpr (!is_cuda_array_v<Float>) {
+        /* Small blocks keep the threads busy at the coarse levels and bound
+           the work that is lost when the preview is restarted */
+        const uint32_t block_size = 32;
+        Spiral spiral(film, block_size);
+        size_t block_count = spiral.block_count();
+
+        /* Weight of the coarse levels, small enough for the first full
+           resolution pass to hide them, but representable in the film */
+        const ScalarFloat coarse_weight = 1e-4f;
+
+        if (!m_box_filter)
+            m_box_filter = PluginManager::instance()->create_object<ReconstructionFilter>(
+                Properties("box"));
+
+        ThreadEnvironment env;
+
+        // Render all blocks of a level, or a full resolution pass (stride 1)
+        auto render_level = [&](uint32_t stride, size_t seed_base, size_t pass) {
+            std::atomic<size_t> block_cursor(0);
+
+            tbb::parallel_for(
+                tbb::blocked_range<size_t>(0, block_count, 1),
+                [&](const tbb::blocked_range<size_t> &range) {
+                    ScopedSetThreadEnvironment set_env(env);
+                    ref<Sampler> sampler = sensor->sampler()->clone();
+                    ref<ImageBlock> block = new ImageBlock(
+                        ScalarVector2i(block_size), channels.size(),
+                        stride == 1 ? block_filter(film) : m_box_filter.get(), !has_aovs,
+                        true, stride == 1);
+                    scoped_flush_denormals flush_denormals(true);
+                    std::unique_ptr<Float[]> aovs(new Float[channels.size()]);
+
+                    for (auto i = range.begin(); i != range.end() && !should_stop(); ++i) {
+                        size_t index = block_cursor++;
+                        auto [offset, size, block_id] = spiral.block(index);
+                        block->set_size(size);
+                        block->set_offset(offset);
+                        if (m_sample_count_aov)
+                            aovs[sample_count_channel] = ScalarFloat(2 * pass + 1);
+
+                        if (stride == 1) {
+                            render_block(scene, sensor, sampler, block, aovs.get(), 1,
+                                         seed_base + block_id, block_size);
+                        } else {
+                            render_coarse_block(scene, sensor, sampler, block, aovs.get(),
+                                                stride, seed_base + block_id);
+                            block->data() *= coarse_weight;
+                        }
+
+                        film->put(block);
+                        m_blocks_done.fetch_add(1, std::memory_order_relaxed);
+                        if (stride == 1)
+                            m_samples_done.fetch_add(hprod(size), std::memory_order_relaxed);
+                    }
+                }
+            );
+        };
+
+        Log(Info, "Starting preview (%ix%i, up to %i sample%s, initial stride %i)",
+            film->crop_size().x(), film->crop_size().y(), total_spp,
+            total_spp == 1 ? "" : "s", m_preview_stride);
+
+        // Sampler seeds advance by one spiral traversal per level and pass
+        size_t seed_base = 0;
+        for (uint32_t stride = m_preview_stride; stride > 1 && !should_stop(); stride /= 2) {
+            render_level(stride, seed_base, 0);
+            seed_base += block_count;
+            if (!should_stop() && update)
+                update(stride, 0);
+        }
+
+        for (size_t pass = 0; pass < total_spp && !should_stop(); ++pass) {
+            render_level(1, seed_base, pass);
+            seed_base += block_count;
+            if (!should_stop() && update)
+                update(1, pass + 1);
+        }
+    } else {
+        // The full resolution passes are cheap enough on the GPU
+        ScalarVector2i film_size = film->crop_size();
+        ScalarUInt32 wavefront_size = (uint32_t) hprod(film_size);
+        ref<Sampler> sampler = sensor->sampler();
+        sampler->set_samples_per_wavefront(1);
+        ScalarFloat diff_scale_factor = rsqrt((ScalarFloat) total_spp);
+
+        ref<ImageBlock> block = new ImageBlock(film_size, channels.size(),
+                                               block_filter(film), !has_aovs);
+        block->set_offset(film->crop_offset());
+        std::vector<Float> aovs(channels.size());
+
+        UInt32 idx = arange<UInt32>(wavefront_size);
+        Vector2f pos = Vector2f(Float(idx % uint32_t(film_size[0])),
+                                Float(idx / uint32_t(film_size[0])));
+        pos += block->offset();
+
+        for (size_t pass = 0; pass < total_spp && !should_stop(); ++pass) {
+            block->clear();
+            sampler->seed(pass, wavefront_size);
+            sampler->set_pixel(Point2u(pos));
+            if (m_sample_count_aov)
+                aovs[sample_count_channel] = ScalarFloat(2 * pass + 1);
+
+            render_sample(scene, sensor, sampler, block, aovs.data(), pos, diff_scale_factor);
+            film->put(block);
+            m_samples_done.fetch_add(wavefront_size, std::memory_order_relaxed);
+
+            if (update)
+                update(1, pass + 1);
+        }
+    }
+
+    return !m_stop;
+}
+
+MTS_VARIANT void SamplingIntegrator<Float, Spectrum>::render_coarse_block(
+    const Scene *scene, const Sensor *sensor, Sampler *sampler, ImageBlock *block,
+    Float *aovs, uint32_t stride, size_t block_id) const {
+    ScopedPhase sp(ProfilerPhase::RenderBlock);
+    block->clear();
+
+    ScalarVector2u size(block->size()),
+                   cells = (size + stride - 1) / stride;
+    uint32_t cell_count = hprod(cells);
+    ScalarFloat diff_scale_factor = rsqrt((ScalarFloat) sampler->sample_count());
+
+    // Trace one ray through the central pixel of each cell
+    if constexpr (!is_array_v<Float>) {
+        for (uint32_t i = 0; i < cell_count && !should_stop(); ++i) {
+            sampler->seed(block_id * cell_count + i);
+            ScalarPoint2u cell(i % cells.x(), i / cells.x()),
+                          pos = min(cell * stride + stride / 2, ScalarPoint2u(size - 1u));
+            pos += block->offset();
+            sampler->set_pixel(pos);
+            render_sample(scene, sensor, sampler, block, aovs, pos, diff_scale_factor);
+        }
+    } else if constexpr (!is_cuda_array_v<Float>) {
+        sampler->seed(block_id);
+        for (auto [index, active] : range<UInt32>(cell_count)) {
+            if (should_stop())
+                break;
+            Point2u cell(index % cells.x(), index / cells.x()),
+                    pos = min(cell * stride + stride / 2, Point2u(size - 1u));
+            pos += block->offset();
+            sampler->set_pixel(pos);
+            render_sample(scene, sensor, sampler, block, aovs, pos, diff_scale_factor, active);
+        }
+    } else {
+        ENOKI_MARK_USED(scene);
+        ENOKI_MARK_USED(sensor);
+        ENOKI_MARK_USED(aovs);
+        ENOKI_MARK_USED(diff_scale_factor);
+        Throw("Not implemented for CUDA arrays.");
+    }
+
+    if constexpr (!is_cuda_array_v<Float>) {
+        // Replicate the value of the central pixel over the cell
+        size_t channel_count = block->channel_count();
+        ScalarFloat *data = (ScalarFloat *) block->data().data();
+        for (uint32_t y = 0; y < size.y(); ++y) {
+            for (uint32_t x = 0; x < size.x(); ++x) {
+                uint32_t cx = std::min(x / stride * stride + stride / 2, size.x() - 1),
+                         cy = std::min(y / stride * stride + stride / 2, size.y() - 1);
+                if (cx == x && cy == y)
+                    continue;
+                std::memcpy(data + ((size_t) y * size.x() + x) * channel_count,
+                            data + ((size_t) cy * size.x() + cx) * channel_count,
+                            channel_count * sizeof(ScalarFloat));
+            }
+        }
+    }
+}
+
+MTS_VARIANT bool
+SamplingIntegrator<Float, Spectrum>::render_batch(Scene *scene,
+                                                  const std::vector<Sensor *> &sensors) {
+    if constexpr (is_cuda_array_v<Float>) {
+        return Base::render_batch(scene, sensors);
+    } else {
+        bool result = false;
+        if (run_in_thread_pool([&]() { result = render_batch(scene, sensors); }))
+            return result;
+
+        if (m_adaptive_threshold > 0.f || m_tuned_scheduler || m_resume ||
+            (m_checkpoint_interval > 0.f && !m_checkpoint_file.empty()) ||
+            uses_pass_hooks()) {
+            Log(Warn, "render_batch(): adaptive sampling, the tuned scheduler, "
+                      "checkpoints and pass hooks require separate render jobs, "
+                      "rendering the sensors one at a time.");
+            return Base::render_batch(scene, sensors);
+        }
+
+        // The sensors share the channels of the image blocks
+        for (Sensor *sensor : sensors) {
+            if (sensor->film()->variance_channel_count() !=
+                    sensors[0]->film()->variance_channel_count() ||
+                sensor->film()->band_count() != sensors[0]->film()->band_count()) {
+                Log(Warn, "render_batch(): films with different variance or band "
+                          "channels require separate render jobs, rendering the "
+                          "sensors one at a time.");
+                return Base::render_batch(scene, sensors);
+            }
+        }
+
+        ScopedPhase sp(ProfilerPhase::Render);
+        m_stop = false;
+
+        std::vector<std::string> channels = film_channels(sensors.empty() ? nullptr
+                                                                          : sensors[0]->film());
+        bool has_aovs = channels.size() > 5;
+        size_t sample_count_channel = channels.size() - 1;
+        size_t n_threads = thread_count();
+
+        struct SensorJob {
+            Sensor *sensor;
+            ref<Film> film;
+            ref<Spiral> spiral;
+            size_t samples_per_pass;
+            size_t n_passes;
+        };
+
+        std::vector<SensorJob> jobs;
+        ScalarVector2i max_size(0);
+        for (Sensor *sensor : sensors) {
+            ref<Film> film = sensor->film();
+            film->prepare(channels);
+            max_size = max(max_size, film->crop_size());
+
+            size_t samples_per_pass = pass_sample_count(sensor);
+            if (film->streaming())
+                samples_per_pass = sensor->sampler()->sample_count();
+            size_t n_passes = (sensor->sampler()->sample_count() + samples_per_pass - 1) /
+                              samples_per_pass;
+            jobs.push_back({ sensor, film, nullptr, samples_per_pass, n_passes });
+        }
+
+        // The block size is shared by all sensors (it determines the sampler seeds)
+        configure_block_size(max_size, n_threads);
+
+        /* Interleave the block traversals of the sensors in a round-robin
+           fashion, so that small films (e.g. radiance meters) do not end up
+           at the tail of the job */
+        std::vector<std::pair<uint32_t, size_t>> work;
+        for (size_t i = 0; i < jobs.size(); ++i)
+            jobs[i].spiral = new Spiral(jobs[i].film, m_block_size, jobs[i].n_passes,
+                                        jobs[i].film->streaming());
+        for (size_t index = 0;; ++index) {
+            bool added = false;
+            for (size_t i = 0; i < jobs.size(); ++i) {
+                if (index < jobs[i].spiral->block_count() * jobs[i].n_passes) {
+                    work.emplace_back((uint32_t) i, index);
+                    added = true;
+                }
+            }
+            if (!added)
+                break;
+        }
+
+        Log(Info, "Starting batch render job (%i sensor%s, %i blocks, %i thread%s)",
+            jobs.size(), jobs.size() == 1 ? "" : "s", work.size(),
+            n_threads, n_threads == 1 ? "" : "s");
+        if (m_timeout > 0.f)
+            Log(Info, "Timeout specified: %.2f seconds.", m_timeout);
+
+        ThreadEnvironment env;
+        ref<ProgressReporter> progress = new ProgressReporter("Rendering");
+        std::atomic<size_t> block_cursor(0);
+        detail::ProgressCounter blocks_done(progress, work.size());
+
+        m_render_timer.reset();
+        m_blocks_done = 0;
+        m_samples_done = 0;
+        tbb::parallel_for(
+            tbb::blocked_range<size_t>(0, work.size(), 1),
+            [&](const tbb::blocked_range<size_t> &range) {
+                ScopedSetThreadEnvironment set_env(env);
+                scoped_flush_denormals flush_denormals(true);
+                std::unique_ptr<Float[]> aovs(new Float[channels.size()]);
+
+                // Created on demand: each sensor has its own sampler and filter
+                std::vector<ref<Sampler>> samplers(jobs.size());
+                std::vector<ref<ImageBlock>> blocks(jobs.size());
+
+                for (auto i = range.begin(); i != range.end() && !should_stop(); ++i) {
+                    auto [job_index, index] = work[block_cursor++];
+                    SensorJob &job = jobs[job_index];
+
+                    if (!samplers[job_index]) {
+                        samplers[job_index] = job.sensor->sampler()->clone();
+                        blocks[job_index] = new ImageBlock(m_block_size, channels.size(),
+                                                           block_filter(job.film),
+                                                           !has_aovs);
+                    }
+                    ImageBlock *block = blocks[job_index];
+
+                    auto [offset, size, block_id] = job.spiral->block(index);
+                    block->set_size(size);
+                    block->set_offset(offset);
+
+                    if (m_sample_count_aov) {
+                        size_t pass = job.n_passes - 1 - block_id / job.spiral->block_count();
+                        aovs[sample_count_channel] =
+                            ScalarFloat((2 * pass + 1) * job.samples_per_pass);
+                    }
+
+                    render_block(scene, job.sensor, samplers[job_index], block,
+                                 aovs.get(), job.samples_per_pass, block_id);
+
+                    job.film->put(block, index);
+
+                    m_blocks_done.fetch_add(1, std::memory_order_relaxed);
+                    m_samples_done.fetch_add(hprod(size) * job.samples_per_pass,
+                                             std::memory_order_relaxed);
+                    blocks_done.add();
+                }
+            }
+        );
+
+        if (!m_stop)
+            Log(Info, "Rendering finished. (took %s)",
+                util::time_string(m_render_timer.value(), true));
+
+        return !m_stop;
+    }
+}
+
+MTS_VARIANT bool SamplingIntegrator<Float, Spectrum>::render_master(Scene *scene,
+                                                                    Sensor *sensor,
+                                                                    const std::string &address) {
+#if defined(MTS_ENABLE_ZMQ)
+    if constexpr (!is_cuda_array_v<Float>) {
+        using detail::RemoteWorkItem;
+        ENOKI_MARK_USED(scene);
+        ScopedPhase sp(ProfilerPhase::Render);
+        m_stop = false;
+
+        ref<Film> film = sensor->film();
+        size_t samples_per_pass = pass_sample_count(sensor),
+               n_passes = sensor->sampler()->sample_count() / samples_per_pass;
+
+        std::vector<std::string> channels = film_channels(film);
+        film->prepare(channels);
+
+        /* Workers must use the same block size as the master, since it affects
+           the sample seeds. Don't adapt it to the local thread count. */
+        configure_block_size(film->crop_size(), 1);
+
+        Spiral spiral(film, m_block_size, n_passes);
+        size_t block_count = spiral.block_count(),
+               total_blocks = block_count * n_passes;
+
+        std::vector<RemoteWorkItem> items(total_blocks);
+        for (size_t i = 0; i < total_blocks; ++i) {
+            auto [offset, size, block_id] = spiral.block(i);
+            items[i] = { { offset.x(), offset.y() }, { size.x(), size.y() },
+                         m_block_size, (uint64_t) block_id, i / block_count, i };
+        }
+        std::vector<bool> completed(total_blocks, false);
+
+        zmq::context context;
+        zmq::socket socket(context, zmq::socket::router);
+        socket.setsockopt(ZMQ_LINGER, 0);
+        socket.bind(address);
+
+        Log(Info, "Serving %i blocks (%ix%i, %i passes) to remote workers on \"%s\" ..",
+            total_blocks, film->crop_size().x(), film->crop_size().y(), n_passes, address);
+
+        ref<ImageBlock> block = new ImageBlock(m_block_size, channels.size(),
+                                               block_filter(film), false);
+        ref<ProgressReporter> progress = new ProgressReporter("Rendering");
+        size_t next_item = 0, reissue_item = 0, blocks_done = 0;
+        m_render_timer.reset();
+        m_blocks_done = 0;
+        m_samples_done = 0;
+
+        while (blocks_done < total_blocks && !should_stop()) {
+            // Poll so that cancel() and timeouts take effect while waiting
+            zmq_pollitem_t poll_item { (void *) socket, 0, ZMQ_POLLIN, 0 };
+            if (zmq_poll(&poll_item, 1, 100) <= 0)
+                continue;
+
+            // Envelope of a REQ socket: identity, empty delimiter, payload
+            zmq::message identity, delimiter, header, data;
+            socket.recvmore(identity);
+            socket.recvmore(delimiter);
+            socket.recv(header);
+            if (socket.more())
+                socket.recv(data);
+
+            if (header.size() == sizeof(RemoteWorkItem)) {
+                RemoteWorkItem item;
+                memcpy(&item, header.data(), sizeof(RemoteWorkItem));
+
+                block->set_offset(ScalarPoint2i(item.offset[0], item.offset[1]));
+                block->set_size(ScalarVector2i(item.size[0], item.size[1]));
+                size_t expected = channels.size() * sizeof(ScalarFloat) *
+                    hprod(block->size() + 2 * block->border_size());
+
+                if (item.index >= total_blocks || data.size() != expected) {
+                    Log(Warn, "Discarding malformed result received from a worker.");
+                } else if (!completed[item.index]) {
+                    memcpy(block->data().data(), data.data(), expected);
+                    film->put(block, item.index);
+                    completed[item.index] = true;
+                    blocks_done++;
+                    m_blocks_done.fetch_add(1, std::memory_order_relaxed);
+                    m_samples_done.fetch_add(hprod(block->size()) * samples_per_pass,
+                                             std::memory_order_relaxed);
+                    progress->update(blocks_done / (ScalarFloat) total_blocks);
+                }
+            }
+
+            // Hand out the next block, or reissue one that is still outstanding
+            const RemoteWorkItem *reply = nullptr;
+            if (next_item < total_blocks) {
+                reply = &items[next_item++];
+            } else if (blocks_done < total_blocks) {
+                while (completed[reissue_item])
+                    reissue_item = (reissue_item + 1) % total_blocks;
+                reply = &items[reissue_item];
+                reissue_item = (reissue_item + 1) % total_blocks;
+            }
+
+            socket.sendmore(identity);
+            socket.sendmore(delimiter);
+            if (reply)
+                socket.send(*reply);
+            else
+                socket.send();
+        }
+
+        if (!m_stop)
+            Log(Info, "Rendering finished. (took %s)",
+                util::time_string(m_render_timer.value(), true));
+
+        return blocks_done == total_blocks;
+    } else {
+        ENOKI_MARK_USED(scene);
+        ENOKI_MARK_USED(sensor);
+        ENOKI_MARK_USED(address);
+        Throw("render_master(): distributed rendering is not supported by GPU variants.");
+    }
+#else
+    ENOKI_MARK_USED(scene);
+    ENOKI_MARK_USED(sensor);
+    ENOKI_MARK_USED(address);
+    Throw("render_master(): Mitsuba was compiled without ZeroMQ support "
+          "(MTS_ENABLE_ZMQ).");
+#endif
+}
+
+MTS_VARIANT bool SamplingIntegrator<Float, Spectrum>::render_worker(Scene *scene,
+                                                                    Sensor *sensor,
+                                                                    const std::string &address) {
+#if defined(MTS_ENABLE_ZMQ)
+    if constexpr (!is_cuda_array_v<Float>) {
+        using detail::RemoteWorkItem;
+        bool result = false;
+        if (run_in_thread_pool([&]() { result = render_worker(scene, sensor, address); }))
+            return result;
+
+        ScopedPhase sp(ProfilerPhase::Render);
+        m_stop = false;
+
+        ref<Film> film = sensor->film();
+        std::vector<std::string> channels = film_channels(film);
+        bool has_aovs = channels.size() > 5;
+        size_t samples_per_pass = pass_sample_count(sensor),
+               n_threads = thread_count();
+        configure_block_size(film->crop_size(), 1);
+
+        Log(Info, "Connecting to render master at \"%s\" (%i thread%s) ..",
+            address, n_threads, n_threads == 1 ? "" : "s");
+
+        zmq::context context;
+        ThreadEnvironment env;
+        std::atomic<size_t> blocks_rendered(0);
+        m_render_timer.reset();
+
+        tbb::parallel_for(
+            tbb::blocked_range<size_t>(0, n_threads, 1),
+            [&](const tbb::blocked_range<size_t> &range) {
+                ScopedSetThreadEnvironment set_env(env);
+                scoped_flush_denormals flush_denormals(true);
+
+                for (auto t = range.begin(); t != range.end(); ++t) {
+                    zmq::socket socket(context, zmq::socket::req);
+                    socket.setsockopt(ZMQ_LINGER, 0);
+                    socket.connect(address);
+
+                    ref<Sampler> sampler = sensor->sampler()->clone();
+                    ref<ImageBlock> block = new ImageBlock(m_block_size, channels.size(),
+                                                           block_filter(film),
+                                                           !has_aovs);
+                    std::unique_ptr<Float[]> aovs(new Float[channels.size()]);
+
+                    // Announce that this thread is ready to accept work
+                    socket.send();
+
+                    while (!should_stop()) {
+                        zmq::message reply;
+                        if (!socket.recv(reply))
+                            break; // Timeout: the master has shut down
+
+                        // An empty reply indicates that there is no more work
+                        if (reply.size() != sizeof(RemoteWorkItem))
+                            break;
+
+                        /* The master replies immediately once a connection
+                           is established, so time out from now on */
+                        socket.setsockopt(ZMQ_RCVTIMEO, (int) 30000);
+
+                        RemoteWorkItem item;
+                        memcpy(&item, reply.data(), sizeof(RemoteWorkItem));
+                        if (item.block_size != m_block_size)
+                            Throw("render_worker(): block size mismatch (%i vs. %i), "
+                                  "is the scene identical to the master's?",
+                                  item.block_size, m_block_size);
+
+                        block->set_offset(ScalarPoint2i(item.offset[0], item.offset[1]));
+                        block->set_size(ScalarVector2i(item.size[0], item.size[1]));
+
+                        // Same encoding as in render()
+                        if (m_sample_count_aov)
+                            aovs[channels.size() - 1] =
+                                ScalarFloat((2 * item.pass + 1) * samples_per_pass);
+
+                        render_block(scene, sensor, sampler, block, aovs.get(),
+                                     samples_per_pass, (size_t) item.block_id);
+                        if (should_stop())
+                            break;
+
+                        size_t bytes = channels.size() * sizeof(ScalarFloat) *
+                            hprod(block->size() + 2 * block->border_size());
+                        socket.sendmore(item);
+                        socket.send(block->data().data(), bytes);
+                        blocks_rendered++;
+                    }
+                }
+            }
+        );
+
+        Log(Info, "Worker finished, rendered %i blocks. (took %s)",
+            (size_t) blocks_rendered, util::time_string(m_render_timer.value(), true));
+
+        return !m_stop;
+    } else {
+        ENOKI_MARK_USED(scene);
+        ENOKI_MARK_USED(sensor);
+        ENOKI_MARK_USED(address);
+        Throw("render_worker(): distributed rendering is not supported by GPU variants.");
+    }
+#else
+    ENOKI_MARK_USED(scene);
+    ENOKI_MARK_USED(sensor);
+    ENOKI_MARK_USED(address);
+    Throw("render_worker(): Mitsuba was compiled without ZeroMQ support "
+          "(MTS_ENABLE_ZMQ).");
+#endif
+}
+
+MTS_VARIANT void
+SamplingIntegrator<Float, Spectrum>::render_single_pixel(const Scene *scene,
+                                                         const Sensor *sensor,
+                                                         const std::vector<std::string> &channels,
+                                                         size_t sample_count) {
+    ref<Film> film = sensor->film();
+    const ReconstructionFilter *filter = block_filter(film);
+    size_t channel_count = channels.size();
+
+    ScalarPoint2i pixel = film->crop_offset();
+    ScalarFloat diff_scale_factor = rsqrt((ScalarFloat) sample_count);
+
+    // Several chunks per thread, each a multiple of the packet size
+    size_t packet_size = array_size_v<Float>,
+           chunk_count = std::max((size_t) 1, std::min(4 * thread_count(),
+                                  sample_count / packet_size)),
+           chunk_size  = (sample_count + chunk_count - 1) / chunk_count;
+    chunk_size = (chunk_size + packet_size - 1) / packet_size * packet_size;
+    chunk_count = (sample_count + chunk_size - 1) / chunk_size;
+
+    std::vector<double> total(channel_count, 0.0);
+    std::mutex total_mutex;
+
+    ThreadEnvironment env;
+    ref<ProgressReporter> progress = new ProgressReporter("Rendering");
+    detail::ProgressCounter chunks_done(progress, chunk_count);
+
+    tbb::parallel_for(
+        tbb::blocked_range<size_t>(0, chunk_count, 1),
+        [&](const tbb::blocked_range<size_t> &chunks) {
+            ScopedSetThreadEnvironment set_env(env);
+            ScopedPhase sp(ProfilerPhase::RenderBlock);
+            ref<Sampler> sampler = sensor->sampler()->clone();
+            scoped_flush_denormals flush_denormals(true);
+            std::unique_ptr<Float[]> aovs(new Float[channel_count]);
+            std::vector<double> chunk_sum(channel_count);
+
+            // The sample count AOV holds the total number of samples (single pass)
+            if (m_sample_count_aov)
+                aovs[channel_count - 1] = (ScalarFloat) sample_count;
+
+            // Accumulate a sample (or a packet of samples) of the pixel
+            auto add_sample = [&](Mask active) {
+                auto [splat_position, sample_weight] =
+                    eval_sample(scene, sensor, sampler, aovs.get(), channel_count,
+                                Vector2f(pixel), diff_scale_factor, active);
+                sampler->advance();
+
+                /* Only the filter weight of the pixel itself matters: the film
+                   discards the contributions to its neighbors */
+                if (filter->radius() > 0.5f + math::RayEpsilon<Float>) {
+                    Vector2f p = ScalarVector2f(pixel) + .5f - splat_position;
+                    sample_weight *= filter->eval_discretized(p.x(), active) *
+                                     filter->eval_discretized(p.y(), active);
+                }
+
+                for (size_t k = 0; k < channel_count; ++k)
+                    chunk_sum[k] += (double) hsum(
+                        select(active, aovs[k] * sample_weight, Float(0.f)));
+            };
+
+            for (auto i = chunks.begin(); i != chunks.end() && !should_stop(); ++i) {
+                size_t begin = i * chunk_size,
+                       count = std::min(chunk_size, sample_count - begin);
+
+                sampler->seed(i);
+                sampler->set_pixel(ScalarPoint2u(pixel));
+                std::fill(chunk_sum.begin(), chunk_sum.end(), 0.0);
+
+                if constexpr (!is_array_v<Float>) {
+                    for (size_t j = 0; j < count && !should_stop(); ++j)
+                        add_sample(true);
+                } else {
+                    for (auto [index, active] : range<UInt32>((uint32_t) count)) {
+                        if (should_stop())
+                            break;
+                        ENOKI_MARK_USED(index);
+                        add_sample(active);
+                    }
+                }
+
+                {
+                    std::lock_guard<std::mutex> guard(total_mutex);
+                    for (size_t k = 0; k < channel_count; ++k)
+                        total[k] += chunk_sum[k];
+                }
+
+                m_blocks_done.fetch_add(1, std::memory_order_relaxed);
+                m_samples_done.fetch_add(count, std::memory_order_relaxed);
+                chunks_done.add();
+            }
+        }
+    );
+
+    if (should_stop())
+        return;
+
+    ref<ImageBlock> block = new ImageBlock(ScalarVector2i(1), channel_count, filter,
+                                           channel_count <= 5, true, false);
+    block->set_offset(pixel);
+    ScalarFloat *data = (ScalarFloat *) block->data().data();
+    for (size_t k = 0; k < channel_count; ++k)
+        data[k] = (ScalarFloat) total[k];
+    film->put(block);
+}
+
 MTS_VARIANT void SamplingIntegrator<Float, Spectrum>::render_block(const Scene *scene,
                                                                    const Sensor *sensor,
                                                                    Sampler *sampler,
                                                                    ImageBlock *block,
                                                                    Float *aovs,
                                                                    size_t sample_count_,
-                                                                   size_t block_id) const {
+                                                                   size_t block_id,
+                                                                   uint32_t block_size) const {
+    ScopedPhase sp(ProfilerPhase::RenderBlock);
     block->clear();
-    uint32_t pixel_count  = (uint32_t)(m_block_size * m_block_size),
+    if (block_size == 0)
+        block_size = m_block_size;
+    uint32_t pixel_count  = (uint32_t)(block_size * block_size),
              sample_count = (uint32_t)(sample_count_ == (size_t) -1
                                            ? sampler->sample_count()
                                            : sample_count_);
@@ -202,6 +1702,8 @@ MTS_VARIANT void SamplingIntegrator<Float, Spectrum>::render_block(const Scene *
                 continue;
 
             pos += block->offset();
+            sampler->set_pixel(pos);
+
             for (uint32_t j = 0; j < sample_count && !should_stop(); ++j) {
                 render_sample(scene, sensor, sampler, block, aovs,
                               pos, diff_scale_factor);
@@ -211,12 +1713,19 @@ MTS_VARIANT void SamplingIntegrator<Float, Spectrum>::render_block(const Scene *
         // Ensure that the sample generation is fully deterministic
         sampler->seed(block_id);
 
+        if (m_wavefront && supports_wavefront()) {
+            render_block_wavefront(scene, sensor, sampler, block, aovs,
+                                   pixel_count, sample_count, diff_scale_factor);
+            return;
+        }
+
         for (auto [index, active] : range<UInt32>(pixel_count * sample_count)) {
             if (should_stop())
                 break;
             Point2u pos = enoki::morton_decode<Point2u>(index / UInt32(sample_count));
             active &= !any(pos >= block->size());
             pos += block->offset();
+            sampler->set_pixel(pos);
             render_sample(scene, sensor, sampler, block, aovs, pos, diff_scale_factor, active);
         }
     } else {
@@ -230,6 +1739,149 @@ MTS_VARIANT void SamplingIntegrator<Float, Spectrum>::render_block(const Scene *
     }
 }
 
+MTS_VARIANT void SamplingIntegrator<Float, Spectrum>::render_block_wavefront(
+    const Scene *scene, const Sensor *sensor, Sampler *sampler, ImageBlock *block,
+    Float *aovs, uint32_t pixel_count, uint32_t sample_count,
+    ScalarFloat diff_scale_factor) const {
+    if constexpr (is_array_v<Float> && !is_cuda_array_v<Float>) {
+        size_t packet_count = (pixel_count * sample_count + Float::Size - 1) / Float::Size,
+               ray_count    = packet_count * Float::Size;
+
+        DynamicRayDifferential3f rays;
+        DynamicSpectrum ray_weights, result;
+        DynamicUInt32 seeds;
+        DynamicMask active, valid;
+        make_dynamic_t<Vector2f> positions;
+        make_dynamic_t<Float> sample_weights;
+
+        set_slices(rays, ray_count);
+        set_slices(ray_weights, ray_count);
+        set_slices(result, ray_count);
+        set_slices(seeds, ray_count);
+        set_slices(active, ray_count);
+        set_slices(valid, ray_count);
+        set_slices(positions, ray_count);
+        if (m_filter_importance_sampling)
+            set_slices(sample_weights, ray_count);
+
+        Timer block_timer;
+
+        // ---------------------- Camera ray generation ----------------------
+
+        size_t i = 0;
+        for (auto [index, active_p] : range<UInt32>(pixel_count * sample_count)) {
+            Point2u pos = enoki::morton_decode<Point2u>(index / UInt32(sample_count));
+            active_p &= !any(pos >= block->size());
+            pos += block->offset();
+            sampler->set_pixel(pos);
+
+            Point2f pixel_sample = sampler->next_2d(active_p);
+            Vector2f position_sample = pos + pixel_sample,
+                     splat_position  = position_sample;
+            if (m_filter_importance_sampling) {
+                Float sample_weight;
+                std::tie(position_sample, splat_position, sample_weight) =
+                    sample_filter(sensor, Vector2f(pos), pixel_sample, active_p);
+                packet(sample_weights, i) = sample_weight;
+            }
+
+            Point2f aperture_sample(.5f);
+            if (sensor->needs_aperture_sample())
+                aperture_sample = sampler->next_2d(active_p);
+
+            Float time = sensor->shutter_open();
+            if (sensor->shutter_open_time() > 0.f)
+                time += sampler->next_1d(active_p) * sensor->shutter_open_time();
+
+            Float wavelength_sample = sampler->next_1d(active_p);
+
+            Vector2f adjusted_position =
+                (position_sample - sensor->film()->crop_offset()) /
+                sensor->film()->crop_size();
+
+            auto [ray, ray_weight] = sensor->sample_ray_differential(
+                time, wavelength_sample, adjusted_position, aperture_sample);
+            ray.scale_differential(diff_scale_factor);
+
+            /* Later bounces draw their random numbers from a per-path seed
+               that follows the path through compaction */
+            UInt32 seed = sample_tea_32(
+                reinterpret_array<UInt32>(sampler->next_1d(active_p)), index);
+
+            packet(rays, i)        = ray;
+            packet(ray_weights, i) = ray_weight;
+            packet(positions, i)   = splat_position;
+            packet(seeds, i)       = seed;
+            packet(active, i)      = active_p;
+            ++i;
+
+            sampler->advance();
+        }
+
+        if (should_stop())
+            return;
+
+        sample_wavefront(scene, rays, seeds, sensor->medium(), active, result, valid);
+
+        /* The paths of the block are traced together: distribute the time
+           evenly over its pixels */
+        if (m_render_time_aov)
+            aovs[render_time_channel(sensor->film(), block->channel_count())] =
+                block_timer.value_in<std::chrono::nanoseconds>() * 1e-3f / pixel_count;
+
+        // ------------------------- Film accumulation ------------------------
+
+        for (i = 0; i < packet_count; ++i) {
+            Mask active_p = packet(active, i);
+            UnpolarizedSpectrum spec_u =
+                depolarize(packet(ray_weights, i) * packet(result, i));
+
+            Color3f xyz;
+            if constexpr (is_monochromatic_v<Spectrum>) {
+                xyz = spec_u.x();
+            } else if constexpr (is_rgb_v<Spectrum>) {
+                xyz = srgb_to_xyz(spec_u, active_p);
+            } else {
+                static_assert(is_spectral_v<Spectrum>);
+                xyz = spectrum_to_xyz(spec_u, packet(rays, i).wavelengths, active_p);
+            }
+
+            aovs[0] = xyz.x();
+            aovs[1] = xyz.y();
+            aovs[2] = xyz.z();
+            aovs[3] = select(packet(valid, i), Float(1.f), Float(0.f));
+            aovs[4] = 1.f;
+
+            eval_bands(sensor->film(), aovs, block->channel_count(), spec_u,
+                       packet(rays, i).wavelengths);
+
+            eval_variance(sensor->film(), aovs, block->channel_count(), xyz, active_p);
+
+            if (m_filter_importance_sampling) {
+                // The sample count AOV is shared by all samples of the block
+                Float sample_count_value = aovs[block->channel_count() - 1];
+                for (size_t k = 0; k < block->channel_count(); ++k)
+                    aovs[k] *= packet(sample_weights, i);
+                block->put(packet(positions, i), aovs, active_p);
+                if (m_sample_count_aov)
+                    aovs[block->channel_count() - 1] = sample_count_value;
+            } else {
+                block->put(packet(positions, i), aovs, active_p);
+            }
+        }
+    } else {
+        ENOKI_MARK_USED(scene);
+        ENOKI_MARK_USED(sensor);
+        ENOKI_MARK_USED(sampler);
+        ENOKI_MARK_USED(block);
+        ENOKI_MARK_USED(aovs);
+        ENOKI_MARK_USED(pixel_count);
+        ENOKI_MARK_USED(sample_count);
+        ENOKI_MARK_USED(diff_scale_factor);
+        Throw("render_block_wavefront(): only supported by CPU packet variants.");
+    }
+}
+
 MTS_VARIANT void
 SamplingIntegrator<Float, Spectrum>::render_sample(const Scene *scene,
                                                    const Sensor *sensor,
@@ -239,17 +1891,66 @@ SamplingIntegrator<Float, Spectrum>::render_sample(const Scene *scene,
                                                    const Vector2f &pos,
                                                    ScalarFloat diff_scale_factor,
                                                    Mask active) const {
-    Vector2f position_sample = pos + sampler->next_2d(active);
+    auto [splat_position, sample_weight] =
+        eval_sample(scene, sensor, sampler, aovs, block->channel_count(), pos,
+                    diff_scale_factor, active);
+
+    if (m_filter_importance_sampling) {
+        // The sample count AOV is shared by all samples of the block
+        Float sample_count_value = aovs[block->channel_count() - 1];
+        for (size_t k = 0; k < block->channel_count(); ++k)
+            aovs[k] *= sample_weight;
+        block->put(splat_position, aovs, active);
+        if (m_sample_count_aov)
+            aovs[block->channel_count() - 1] = sample_count_value;
+    } else {
+        block->put(splat_position, aovs, active);
+    }
+
+    sampler->advance();
+}
+
+MTS_VARIANT std::pair<typename SamplingIntegrator<Float, Spectrum>::Vector2f, Float>
+SamplingIntegrator<Float, Spectrum>::eval_sample(const Scene *scene,
+                                                 const Sensor *sensor,
+                                                 Sampler *sampler,
+                                                 Float *aovs,
+                                                 size_t channel_count,
+                                                 const Vector2f &pos,
+                                                 ScalarFloat diff_scale_factor,
+                                                 Mask active) const {
+    std::chrono::steady_clock::time_point start_time;
+    if (m_render_time_aov)
+        start_time = std::chrono::steady_clock::now();
+
+    bool needs_aperture = sensor->needs_aperture_sample(),
+         needs_time     = sensor->shutter_open_time() > 0.f;
+
+    // Draw all the dimensions of the camera ray at once
+    Float camera_sample[6];
+    const Float *ptr = camera_sample;
+    sampler->next_nd(camera_sample, 3 + (needs_aperture ? 2 : 0) + (needs_time ? 1 : 0),
+                     active);
+
+    Vector2f position_sample = pos + Vector2f(ptr[0], ptr[1]),
+             splat_position  = position_sample;
+    Float sample_weight = 1.f;
+    if (m_filter_importance_sampling)
+        std::tie(position_sample, splat_position, sample_weight) =
+            sample_filter(sensor, pos, Vector2f(ptr[0], ptr[1]), active);
+    ptr += 2;
 
     Point2f aperture_sample(.5f);
-    if (sensor->needs_aperture_sample())
-        aperture_sample = sampler->next_2d(active);
+    if (needs_aperture) {
+        aperture_sample = Point2f(ptr[0], ptr[1]);
+        ptr += 2;
+    }
 
     Float time = sensor->shutter_open();
-    if (sensor->shutter_open_time() > 0.f)
-        time += sampler->next_1d(active) * sensor->shutter_open_time();
+    if (needs_time)
+        time += *ptr++ * sensor->shutter_open_time();
 
-    Float wavelength_sample = sampler->next_1d(active);
+    Float wavelength_sample = *ptr;
 
     Vector2f adjusted_position =
         (position_sample - sensor->film()->crop_offset()) /
@@ -282,9 +1983,93 @@ SamplingIntegrator<Float, Spectrum>::render_sample(const Scene *scene,
     aovs[3] = select(result.second, Float(1.f), Float(0.f));
     aovs[4] = 1.f;
 
-    block->put(position_sample, aovs, active);
+    eval_bands(sensor->film(), aovs, channel_count, spec_u, ray.wavelengths);
 
-    sampler->advance();
+    eval_variance(sensor->film(), aovs, channel_count, xyz, active);
+
+    /* Time of the sample scaled by the number of samples per pixel, so that
+       the average computed by the film yields the total time of the pixel */
+    if (m_render_time_aov) {
+        std::chrono::duration<float, std::micro> elapsed =
+            std::chrono::steady_clock::now() - start_time;
+        aovs[render_time_channel(sensor->film(), channel_count)] =
+            elapsed.count() * sampler->sample_count() / array_size_v<Float>;
+    }
+
+    return { splat_position, sample_weight };
+}
+
+MTS_VARIANT size_t
+SamplingIntegrator<Float, Spectrum>::render_time_channel(const Film *film,
+                                                         size_t channel_count) const {
+    // The variance and sample count channels follow the render time (see film_channels())
+    return channel_count - 1 - film->variance_channel_count() -
+           (m_sample_count_aov ? 1 : 0);
+}
+
+MTS_VARIANT void
+SamplingIntegrator<Float, Spectrum>::eval_variance(const Film *film, Float *aovs,
+                                                   size_t channel_count,
+                                                   const Color3f &xyz,
+                                                   Mask active) const {
+    size_t count = film->variance_channel_count();
+    if (count == 0)
+        return;
+
+    // The variance channels precede the sample count channel (see film_channels())
+    Float *moments = aovs + channel_count - count - (m_sample_count_aov ? 1 : 0);
+    if (count == 1) {
+        moments[0] = sqr(xyz.y());
+    } else {
+        Color3f rgb = xyz_to_srgb(xyz, active);
+        for (size_t k = 0; k < 3; ++k)
+            moments[k] = sqr(rgb[k]);
+    }
+}
+
+MTS_VARIANT void
+SamplingIntegrator<Float, Spectrum>::eval_bands(const Film *film, Float *aovs,
+                                                size_t channel_count,
+                                                const UnpolarizedSpectrum &value,
+                                                const Wavelength &wavelengths) const {
+    if constexpr (is_spectral_v<Spectrum>) {
+        size_t band_count = film->band_count();
+        if (band_count == 0)
+            return;
+
+        // The bands precede the render time, variance and sample count channels
+        size_t offset = channel_count - band_count - (m_render_time_aov ? 1 : 0) -
+                        film->variance_channel_count() - (m_sample_count_aov ? 1 : 0);
+
+        /* The samples are divided by the PDF of their wavelength: the mean of
+           those within a band estimates the integral of the radiance over the
+           band, which is divided by its width */
+        ScalarVector2f range = film->band_range();
+        ScalarFloat inv_width = band_count / (range.y() - range.x());
+        Wavelength band = floor((wavelengths - range.x()) * inv_width);
+
+        for (size_t k = 0; k < band_count; ++k)
+            aovs[offset + k] =
+                hmean(select(eq(band, (ScalarFloat) k), value, 0.f)) * inv_width;
+    } else {
+        ENOKI_MARK_USED(film);
+        ENOKI_MARK_USED(aovs);
+        ENOKI_MARK_USED(channel_count);
+        ENOKI_MARK_USED(value);
+        ENOKI_MARK_USED(wavelengths);
+    }
+}
+
+MTS_VARIANT std::tuple<typename SamplingIntegrator<Float, Spectrum>::Vector2f,
+                       typename SamplingIntegrator<Float, Spectrum>::Vector2f, Float>
+SamplingIntegrator<Float, Spectrum>::sample_filter(const Sensor *sensor, const Vector2f &pos,
+                                                   const Vector2f &sample, Mask active) const {
+    const ReconstructionFilter *rfilter = sensor->film()->reconstruction_filter();
+    auto [offset_x, weight_x] = rfilter->sample(sample.x(), active);
+    auto [offset_y, weight_y] = rfilter->sample(sample.y(), active);
+
+    Vector2f center = pos + .5f;
+    return { center + Vector2f(offset_x, offset_y), center, weight_x * weight_y };
 }
 
 MTS_VARIANT std::pair<Spectrum, typename SamplingIntegrator<Float, Spectrum>::Mask>
@@ -297,6 +2082,39 @@ SamplingIntegrator<Float, Spectrum>::sample(const Scene * /* scene */,
     NotImplementedError("sample");
 }
 
+MTS_VARIANT std::pair<Spectrum, typename SamplingIntegrator<Float, Spectrum>::Mask>
+SamplingIntegrator<Float, Spectrum>::sample_with_interaction(const Scene *scene,
+                                                             Sampler *sampler,
+                                                             const RayDifferential3f &ray,
+                                                             const SurfaceInteraction3f & /* si */,
+                                                             const Medium *medium,
+                                                             Float *aovs,
+                                                             Mask active) const {
+    return sample(scene, sampler, ray, medium, aovs, active);
+}
+
+MTS_VARIANT void
+SamplingIntegrator<Float, Spectrum>::sample_adjoint(const Scene * /* scene */,
+                                                    Sampler * /* sampler */,
+                                                    const RayDifferential3f & /* ray */,
+                                                    const Medium * /* medium */,
+                                                    const Spectrum & /* radiance */,
+                                                    const Spectrum & /* adjoint */,
+                                                    Mask /* active */) const {
+    NotImplementedError("sample_adjoint");
+}
+
+MTS_VARIANT void
+SamplingIntegrator<Float, Spectrum>::sample_wavefront(const Scene * /* scene */,
+                                                      const DynamicRayDifferential3f & /* rays */,
+                                                      const DynamicUInt32 & /* seeds */,
+                                                      const Medium * /* medium */,
+                                                      const DynamicMask & /* active */,
+                                                      DynamicSpectrum & /* result */,
+                                                      DynamicMask & /* valid */) const {
+    NotImplementedError("sample_wavefront");
+}
+
 // -----------------------------------------------------------------------------
 
 MTS_VARIANT MonteCarloIntegrator<Float, Spectrum>::MonteCarloIntegrator(const Properties &props)
@@ -0,0 +1,161 @@
+#include <mitsuba/core/math.h>
+#include <mitsuba/render/irradiancecache.h>
+
+NAMESPACE_BEGIN(mitsuba)
+
+MTS_VARIANT IrradianceCache<Float, Spectrum>::Node::Node() : entries(nullptr) {
+    for (size_t i = 0; i < 8; ++i)
+        children[i] = nullptr;
+}
+
+MTS_VARIANT IrradianceCache<Float, Spectrum>::Node::~Node() {
+    for (size_t i = 0; i < 8; ++i)
+        delete children[i].load(std::memory_order_relaxed);
+
+    Entry *entry = entries.load(std::memory_order_relaxed);
+    while (entry) {
+        Entry *next = entry->next;
+        delete entry;
+        entry = next;
+    }
+}
+
+MTS_VARIANT IrradianceCache<Float, Spectrum>::IrradianceCache(const ScalarBoundingBox3f &bbox,
+                                                             ScalarFloat error)
+    : m_root(new Node()), m_error(error), m_record_count(0) {
+    if (!(error > 0.f))
+        Throw("IrradianceCache: the error threshold must be positive!");
+
+    // Cubic root node, which is slightly enlarged to contain the boundary
+    if (bbox.valid()) {
+        m_center = bbox.center();
+        m_half_size = .5f * hmax(bbox.extents()) * 1.01f;
+    } else {
+        m_center = 0.f;
+        m_half_size = 1.f;
+    }
+    m_half_size = std::max(m_half_size, math::Epsilon<ScalarFloat>);
+}
+
+MTS_VARIANT IrradianceCache<Float, Spectrum>::~IrradianceCache() { delete m_root; }
+
+MTS_VARIANT void IrradianceCache<Float, Spectrum>::insert(const Record &record) const {
+    // Descend while the children still cover the radius within which the record is used
+    ScalarFloat valid_radius = m_error * record.radius;
+    Node *node = m_root;
+    ScalarPoint3f c = m_center;
+    ScalarFloat h = m_half_size;
+
+    for (size_t depth = 0; depth < MaxDepth && .5f * h >= valid_radius; ++depth) {
+        uint32_t index = 0;
+        for (size_t i = 0; i < 3; ++i) {
+            if (record.p[i] >= c[i])
+                index |= 1u << i;
+        }
+
+        h *= .5f;
+        for (size_t i = 0; i < 3; ++i)
+            c[i] += (index & (1u << i)) ? h : -h;
+
+        Node *child = node->children[index].load(std::memory_order_acquire);
+        if (!child) {
+            // Another thread may create the same child first, which is then used instead
+            Node *created = new Node();
+            if (node->children[index].compare_exchange_strong(child, created,
+                                                              std::memory_order_acq_rel,
+                                                              std::memory_order_acquire))
+                child = created;
+            else
+                delete created;
+        }
+        node = child;
+    }
+
+    Entry *entry = new Entry{ record, node->entries.load(std::memory_order_relaxed) };
+    while (!node->entries.compare_exchange_weak(entry->next, entry,
+                                                std::memory_order_release,
+                                                std::memory_order_relaxed))
+        ;
+    m_record_count.fetch_add(1, std::memory_order_relaxed);
+}
+
+MTS_VARIANT bool IrradianceCache<Float, Spectrum>::lookup(const ScalarPoint3f &p,
+                                                         const ScalarVector3f &n,
+                                                         ScalarColor3f &irradiance) const {
+    ScalarColor3f sum(0.f);
+    ScalarFloat weight_sum = 0.f;
+    lookup(m_root, m_center, m_half_size, p, n, sum, weight_sum);
+
+    if (weight_sum == 0.f)
+        return false;
+
+    irradiance = sum / weight_sum;
+    return true;
+}
+
+MTS_VARIANT void IrradianceCache<Float, Spectrum>::lookup(const Node *node,
+                                                         const ScalarPoint3f &c, ScalarFloat h,
+                                                         const ScalarPoint3f &p,
+                                                         const ScalarVector3f &n,
+                                                         ScalarColor3f &sum,
+                                                         ScalarFloat &weight_sum) const {
+    /* The records of a node lie within it and are used within its half
+       size, hence the node is only relevant when the node enlarged by half
+       of its size on each side contains the lookup point */
+    if (hmax(abs(p - c)) > 2.f * h)
+        return;
+
+    for (const Entry *entry = node->entries.load(std::memory_order_acquire); entry;
+         entry = entry->next) {
+        const Record &r = entry->record;
+        ScalarVector3f d = p - r.p;
+
+        // Weight of Ward et al., which only accepts records with an error below the threshold
+        ScalarFloat error = norm(d) / r.radius +
+                            std::sqrt(std::max(0.f, 1.f - dot(n, r.n)));
+        if (error >= m_error)
+            continue;
+
+        // Skip records in front of the lookup point, which may see different surfaces
+        if (dot(d, .5f * (n + r.n)) < -.01f * r.radius)
+            continue;
+
+        ScalarFloat weight = 1.f / std::max(error, 1e-3f);
+        ScalarVector3f rotation = cross(r.n, n);
+        for (size_t i = 0; i < 3; ++i) {
+            ScalarFloat value = r.irradiance[i] + dot(rotation, r.grad_r[i]) +
+                                dot(d, r.grad_t[i]);
+            sum[i] += weight * std::max(value, 0.f);
+        }
+        weight_sum += weight;
+    }
+
+    for (size_t i = 0; i < 8; ++i) {
+        const Node *child = node->children[i].load(std::memory_order_acquire);
+        if (!child)
+            continue;
+        ScalarPoint3f cc = c;
+        for (size_t j = 0; j < 3; ++j)
+            cc[j] += (i & (1u << j)) ? .5f * h : -.5f * h;
+        lookup(child, cc, .5f * h, p, n, sum, weight_sum);
+    }
+}
+
+MTS_VARIANT void IrradianceCache<Float, Spectrum>::clear() {
+    delete m_root;
+    m_root = new Node();
+    m_record_count = 0;
+}
+
+MTS_VARIANT std::string IrradianceCache<Float, Spectrum>::to_string() const {
+    std::ostringstream oss;
+    oss << "IrradianceCache[" << std::endl
+        << "  record_count = " << record_count() << "," << std::endl
+        << "  error = " << m_error << std::endl
+        << "]";
+    return oss.str();
+}
+
+MTS_IMPLEMENT_CLASS_VARIANT(IrradianceCache, Object)
+MTS_INSTANTIATE_CLASS(IrradianceCache)
+NAMESPACE_END(mitsuba)
@@ -1,9 +1,41 @@
 #include <mitsuba/render/kdtree.h>
 #include <mitsuba/render/mesh.h>
+#include <mitsuba/core/fstream.h>
+#include <mitsuba/core/hash.h>
+#include <mitsuba/core/mmap.h>
 #include <mitsuba/core/properties.h>
+#include <algorithm>
+
+#define MTS_KD_CACHE_MAGIC "MTS_KDC"
+#define MTS_KD_CACHE_VERSION 1
+
+/// Alignment of the node and index lists within a cache file
+#define MTS_KD_CACHE_ALIGNMENT 64
 
 NAMESPACE_BEGIN(mitsuba)
 
+NAMESPACE_BEGIN(detail)
+/// Header of a kd-tree cache file, followed by the node and index lists
+struct KDTreeCacheHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t scalar_size;
+    uint64_t key;
+    uint32_t node_count;
+    uint32_t index_count;
+    uint32_t primitive_count;
+    uint32_t node_size;
+    double bbox_min[3];
+    double bbox_max[3];
+    uint64_t node_offset;
+    uint64_t index_offset;
+};
+
+inline uint64_t kd_cache_align(uint64_t offset) {
+    return (offset + MTS_KD_CACHE_ALIGNMENT - 1) / MTS_KD_CACHE_ALIGNMENT * MTS_KD_CACHE_ALIGNMENT;
+}
+NAMESPACE_END(detail)
+
 MTS_VARIANT ShapeKDTree<Float, Spectrum>::ShapeKDTree(const Properties &props)
     : Base(SurfaceAreaHeuristic3f(
           /* kd-tree construction: Relative cost of a shape intersection
@@ -44,21 +76,435 @@ MTS_VARIANT ShapeKDTree<Float, Spectrum>::ShapeKDTree(const Properties &props)
     if (props.has_property("kd_exact_primitive_threshold"))
         set_exact_primitive_threshold(props.int_("kd_exact_primitive_threshold"));
 
+    /* kd-tree construction: Budget for the temporary memory used by the
+       builder (in MiB, 0 = unlimited, see \ref set_memory_budget()) */
+    if (props.has_property("kd_memory_budget")) {
+        int budget = props.int_("kd_memory_budget");
+        if (budget < 0)
+            Throw("The \"kd_memory_budget\" property must be >= 0!");
+        set_memory_budget((size_t) budget * 1024 * 1024);
+    }
+
+    /* kd-tree construction: Directory in which built trees are cached, so
+       that later loads of the same geometry skip the construction */
+    m_cache_dir = props.string("kd_cache_dir", "");
+
+    /* kd-tree construction: Store the primitive lists of the leaves with
+       16-bit offsets where possible (see \ref for_each_primitive()) */
+    m_compact_indices = props.bool_("kd_compact_indices", false);
+
+    /* kd-tree traversal: Store precomputed triangle data in leaf order
+       (one of "none", "edges" or "watertight", see \ref TriangleRecord) */
+    std::string records = props.string("kd_triangle_records", "none");
+    if (records == "none")
+        m_triangle_records = TriangleRecords::None;
+    else if (records == "edges")
+        m_triangle_records = TriangleRecords::Edges;
+    else if (records == "watertight")
+        m_triangle_records = TriangleRecords::Watertight;
+    else
+        Throw("Invalid \"kd_triangle_records\" value \"%s\", must be one of: "
+              "\"none\", \"edges\", or \"watertight\"", records);
+
+    if (m_compact_indices && m_triangle_records != TriangleRecords::None)
+        Throw("The \"kd_compact_indices\" and \"kd_triangle_records\" "
+              "options cannot be combined!");
+
+    /* kd-tree traversal: Intersect the analytic shapes of leaves holding at
+       least this many of the same kind in SIMD batches (0 = disabled, see
+       \ref ShapeBatch). Only supported by the scalar variants. */
+    int shape_batches = props.int_("kd_shape_batches", 0);
+    if (shape_batches < 0)
+        Throw("The \"kd_shape_batches\" property must be >= 0!");
+    m_shape_batches = (uint32_t) shape_batches;
+    if (is_array_v<Float> && m_shape_batches > 0) {
+        Log(Warn, "The \"kd_shape_batches\" property is only supported by "
+                  "scalar variants and will be ignored.");
+        m_shape_batches = 0;
+    }
+
     m_primitive_map.push_back(0);
 }
 
 MTS_VARIANT void ShapeKDTree<Float, Spectrum>::build() {
+    if (m_cache_dir.empty()) {
+        build_tree();
+        return;
+    }
+
+    uint64_t key = cache_key();
+    fs::path filename = m_cache_dir / fs::path(tfm::format("%016x.kdtree", key));
+    if (fs::exists(filename) && load_cache(filename, key)) {
+        build_triangle_records();
+        build_shape_batches();
+        m_memory.set(m_index_count * sizeof(Index) + m_node_count * sizeof(KDNode) +
+                     record_storage());
+        return;
+    }
+
+    build_tree();
+
+    if (!fs::exists(m_cache_dir))
+        fs::create_directory(m_cache_dir);
+    try {
+        write_cache(filename, key);
+    } catch (const std::exception &e) {
+        Log(Warn, "Could not write the kd-tree cache \"%s\": %s", filename.string(), e.what());
+    }
+}
+
+MTS_VARIANT void ShapeKDTree<Float, Spectrum>::build_tree() {
     Timer timer;
     Log(Info, "Building a SAH kd-tree (%i primitives) ..",
         primitive_count());
 
     Base::build();
 
+    Timer post_timer;
+    if (m_compact_indices)
+        compact_indices();
+
+    build_triangle_records();
+    build_shape_batches();
+    m_build_stats.time_postprocessing = (float) post_timer.value();
+
+    m_memory.set(m_index_count * sizeof(Index) + m_node_count * sizeof(KDNode) +
+                 record_storage());
+
     Log(Info, "Finished. (%s of storage, took %s)",
-        util::mem_string(m_index_count * sizeof(Index) +
-                        m_node_count * sizeof(KDNode)),
-        util::time_string(timer.value())
-    );
+        util::mem_string(m_memory.size()), util::time_string(timer.value()));
+}
+
+MTS_VARIANT void ShapeKDTree<Float, Spectrum>::build_triangle_records() {
+    m_records.reset();
+    if (m_triangle_records == TriangleRecords::None || m_index_count == 0)
+        return;
+
+    m_records.reset(new TriangleRecord[m_index_count]);
+    for (Size i = 0; i < m_index_count; ++i) {
+        TriangleRecord &rec = m_records[i];
+        Index prim_index = m_index_data[i],
+              shape_index = find_shape(prim_index);
+        const Shape *shape = m_shapes[shape_index];
+
+        // Moving meshes must interpolate their vertices along the ray time
+        if (!shape->is_mesh() || shape->has_motion()) {
+            memset(rec.v, 0, sizeof(rec.v));
+            rec.shape_index = NonMeshRecord;
+            rec.prim_index = m_index_data[i];
+            continue;
+        }
+
+        const Mesh *mesh = (const Mesh *) shape;
+        auto fi = mesh->face_indices(prim_index);
+        ScalarPoint3f p[3] = { mesh->vertex_position(fi[0]),
+                               mesh->vertex_position(fi[1]),
+                               mesh->vertex_position(fi[2]) };
+
+        if (m_triangle_records == TriangleRecords::Edges) {
+            p[1] -= p[0];
+            p[2] -= p[0];
+        }
+
+        for (size_t k = 0; k < 3; ++k)
+            for (size_t l = 0; l < 3; ++l)
+                rec.v[k][l] = p[k][l];
+        rec.shape_index = shape_index;
+        rec.prim_index = prim_index;
+    }
+}
+
+MTS_VARIANT void ShapeKDTree<Float, Spectrum>::build_shape_batches() {
+    m_batches.clear();
+    m_leaf_batches.clear();
+    m_batch_indices.clear();
+    if (m_shape_batches == 0 || m_node_count == 0)
+        return;
+
+    constexpr size_t KindCount = (size_t) AnalyticShape::Cylinder + 1;
+    std::vector<Index> kinds[KindCount];
+    ScalarFloat params[AnalyticParameterCount];
+
+    const KDNode *nodes = local_nodes();
+    m_leaf_batches.resize(m_node_count, LeafBatches{ 0, 0, 0, 0 });
+
+    for (Size i = 0; i < m_node_count; ++i) {
+        const KDNode *node = nodes + i;
+        if (!node->leaf() || node->primitive_count() < m_shape_batches)
+            continue;
+
+        // Sort the primitives of the leaf by kind (moving shapes are not batched)
+        for (std::vector<Index> &prims : kinds)
+            prims.clear();
+        for_each_primitive(node, local_indices(), [&](Index prim_index) {
+            Index local_index = prim_index;
+            const Shape *shape = m_shapes[find_shape(local_index)];
+            AnalyticShape kind = shape->has_motion() ? AnalyticShape::None
+                                                     : shape->analytic_parameters(params);
+            kinds[(size_t) kind].push_back(prim_index);
+            return false;
+        });
+
+        LeafBatches leaf{ (Index) m_batches.size(), 0, (Index) m_batch_indices.size(), 0 };
+        for (size_t k = 0; k < KindCount; ++k) {
+            const std::vector<Index> &prims = kinds[k];
+            if (k == (size_t) AnalyticShape::None || prims.size() < m_shape_batches) {
+                m_batch_indices.insert(m_batch_indices.end(), prims.begin(), prims.end());
+                continue;
+            }
+
+            for (size_t j = 0; j < prims.size(); j += BatchSize) {
+                ShapeBatch batch;
+                memset(&batch, 0, sizeof(ShapeBatch));
+                batch.kind = (AnalyticShape) k;
+                batch.size = (uint32_t) std::min(BatchSize, prims.size() - j);
+
+                for (uint32_t l = 0; l < batch.size; ++l) {
+                    Index prim_index = prims[j + l];
+                    const Shape *shape = m_shapes[find_shape(prim_index)];
+                    shape->analytic_parameters(params);
+                    for (size_t p = 0; p < AnalyticParameterCount; ++p)
+                        batch.params[p][l] = params[p];
+                    batch.shape[l] = shape;
+                    batch.prim_index[l] = prim_index;
+                }
+                m_batches.push_back(batch);
+            }
+        }
+
+        leaf.batch_count = (Index) m_batches.size() - leaf.batch_offset;
+        leaf.index_count = (Index) m_batch_indices.size() - leaf.index_offset;
+        if (leaf.batch_count > 0)
+            m_leaf_batches[i] = leaf;
+        else
+            m_batch_indices.resize(leaf.index_offset);
+    }
+
+    if (m_batches.empty()) {
+        m_leaf_batches.clear();
+        m_batch_indices.clear();
+        return;
+    }
+
+    m_batches.shrink_to_fit();
+    m_batch_indices.shrink_to_fit();
+    Log(Debug, "Gathered %i batches of analytic shapes.", m_batches.size());
+}
+
+MTS_VARIANT size_t ShapeKDTree<Float, Spectrum>::record_storage() const {
+    return (m_records ? m_index_count * sizeof(TriangleRecord) : 0) +
+           m_batches.size() * sizeof(ShapeBatch) +
+           m_leaf_batches.size() * sizeof(LeafBatches) +
+           m_batch_indices.size() * sizeof(Index);
+}
+
+MTS_VARIANT void ShapeKDTree<Float, Spectrum>::compact_indices() {
+    std::vector<uint16_t> words;
+    words.reserve(m_index_count);
+    auto append_32 = [&](Index value) {
+        words.push_back((uint16_t) (value & 0xFFFFu));
+        words.push_back((uint16_t) (value >> 16));
+    };
+
+    KDNode *nodes = m_nodes.get();
+    for (Size i = 0; i < m_node_count; ++i) {
+        KDNode &node = nodes[i];
+        if (!node.leaf() || node.primitive_count() == 0)
+            continue;
+
+        const Index *prims = m_indices.get() + node.primitive_offset();
+        Index count = node.primitive_count();
+        if (!node.set_leaf_node(words.size(), count))
+            Throw("compact_indices(): the index list is too large!");
+
+        if (count == 1) {
+            append_32(prims[0]);
+            continue;
+        }
+
+        auto [min_it, max_it] = std::minmax_element(prims, prims + count);
+        if (*max_it - *min_it <= 0xFFFFu) {
+            append_32(*min_it);
+            for (Index k = 0; k < count; ++k)
+                words.push_back((uint16_t) (prims[k] - *min_it));
+        } else {
+            append_32(CompactWide);
+            for (Index k = 0; k < count; ++k)
+                append_32(prims[k]);
+        }
+    }
+
+    if (words.empty())
+        return;
+
+    Size old_count = m_index_count;
+    m_index_count = Size((words.size() + 1) / 2);
+    m_indices.reset(new Index[m_index_count]);
+    m_indices[m_index_count - 1] = 0;
+    memcpy(m_indices.get(), words.data(), words.size() * sizeof(uint16_t));
+    m_index_data = m_indices.get();
+    Base::replicate_numa();
+
+    Log(Debug, "Compacted the kd-tree index list from %s to %s",
+        util::mem_string(old_count * sizeof(Index)),
+        util::mem_string(m_index_count * sizeof(Index)));
+}
+
+MTS_VARIANT void ShapeKDTree<Float, Spectrum>::rebuild() {
+    clear();
+
+    m_primitive_map.clear();
+    m_primitive_map.push_back(0);
+    m_bbox.reset();
+    for (Shape *shape : m_shapes) {
+        m_primitive_map.push_back(m_primitive_map.back() +
+                                  shape->primitive_count());
+        m_bbox.expand(shape->bbox());
+    }
+
+    build_tree();
+}
+
+MTS_VARIANT uint64_t ShapeKDTree<Float, Spectrum>::cache_key() const {
+    uint64_t key = (uint64_t) MTS_KD_CACHE_VERSION;
+    auto add = [&](const void *ptr, size_t size) { key = hash_buffer(ptr, size, key); };
+    auto add_value = [&](auto value) { add(&value, sizeof(value)); };
+
+    // Build parameters
+    add_value(cost_model().query_cost());
+    add_value(cost_model().traversal_cost());
+    add_value(cost_model().empty_space_bonus());
+    add_value(max_depth());
+    add_value(min_max_bins());
+    add_value(clip_primitives());
+    add_value(retract_bad_splits());
+    add_value(max_bad_refines());
+    add_value(stop_primitives());
+    add_value(exact_primitive_threshold());
+    add_value(m_compact_indices);
+
+    // Geometry
+    for (const Shape *shape : m_shapes) {
+        std::string name = shape->class_()->name();
+        add(name.data(), name.size());
+        add_value(shape->primitive_count());
+
+        if (shape->is_mesh()) {
+            const Mesh *mesh = (const Mesh *) shape;
+            add(mesh->vertex_positions_buffer().data(),
+                mesh->vertex_count() * 3 * sizeof(float));
+            if (slices(mesh->faces_buffer()) != 0) {
+                add(mesh->faces_buffer().data(),
+                    mesh->face_count() * 3 * sizeof(Index));
+            } else {
+                // 16-bit face indices (see Mesh::compress_vertex_data())
+                for (Index i = 0; i < mesh->face_count(); ++i) {
+                    auto fi = mesh->face_indices(i);
+                    Index indices[3] = { fi[0], fi[1], fi[2] };
+                    add(indices, sizeof(indices));
+                }
+            }
+        } else {
+            for (Index i = 0; i < shape->primitive_count(); ++i)
+                add_value(shape->bbox(i));
+        }
+    }
+
+    return key;
+}
+
+MTS_VARIANT bool ShapeKDTree<Float, Spectrum>::load_cache(const fs::path &filename,
+                                                          uint64_t key) {
+    using detail::KDTreeCacheHeader;
+
+    ref<MemoryMappedFile> mmap;
+    try {
+        mmap = new MemoryMappedFile(filename, false);
+    } catch (const std::exception &e) {
+        Log(Warn, "Could not open the kd-tree cache \"%s\": %s", filename.string(), e.what());
+        return false;
+    }
+
+    const uint8_t *data = (const uint8_t *) mmap->data();
+    KDTreeCacheHeader header;
+    if (mmap->size() < sizeof(KDTreeCacheHeader))
+        return false;
+    memcpy(&header, data, sizeof(KDTreeCacheHeader));
+
+    if (strncmp(header.magic, MTS_KD_CACHE_MAGIC, sizeof(header.magic)) != 0 ||
+        header.version != MTS_KD_CACHE_VERSION ||
+        header.scalar_size != sizeof(ScalarFloat) ||
+        header.node_size != sizeof(KDNode) ||
+        header.key != key || header.primitive_count != primitive_count() ||
+        header.node_offset % MTS_KD_CACHE_ALIGNMENT != 0 ||
+        header.index_offset % MTS_KD_CACHE_ALIGNMENT != 0 ||
+        header.node_offset + header.node_count * sizeof(KDNode) > mmap->size() ||
+        header.index_offset + header.index_count * sizeof(Index) > mmap->size()) {
+        Log(Warn, "Ignoring the invalid or outdated kd-tree cache \"%s\".", filename.string());
+        return false;
+    }
+
+    ScalarBoundingBox3f bbox;
+    for (size_t i = 0; i < 3; ++i) {
+        bbox.min[i] = (ScalarFloat) header.bbox_min[i];
+        bbox.max[i] = (ScalarFloat) header.bbox_max[i];
+    }
+
+    // Traversals visit the nodes in an incoherent order: load them in the background
+    mmap->prefetch(header.node_offset, header.node_count * sizeof(KDNode));
+    mmap->prefetch(header.index_offset, header.index_count * sizeof(Index));
+
+    set_external_storage((const KDNode *) (data + header.node_offset), header.node_count,
+                         (const Index *) (data + header.index_offset), header.index_count,
+                         bbox, mmap);
+
+    Log(Info, "Loaded the kd-tree from the cache \"%s\" (%s).", filename.string(),
+        util::mem_string(mmap->size()));
+    return true;
+}
+
+MTS_VARIANT void ShapeKDTree<Float, Spectrum>::write_cache(const fs::path &filename,
+                                                           uint64_t key) const {
+    using detail::KDTreeCacheHeader;
+    using detail::kd_cache_align;
+
+    KDTreeCacheHeader header;
+    memset(&header, 0, sizeof(KDTreeCacheHeader));
+    strncpy(header.magic, MTS_KD_CACHE_MAGIC, sizeof(header.magic));
+    header.version         = MTS_KD_CACHE_VERSION;
+    header.scalar_size     = sizeof(ScalarFloat);
+    header.key             = key;
+    header.node_count      = m_node_count;
+    header.index_count     = m_index_count;
+    header.primitive_count = primitive_count();
+    header.node_size       = sizeof(KDNode);
+    for (size_t i = 0; i < 3; ++i) {
+        header.bbox_min[i] = (double) m_bbox.min[i];
+        header.bbox_max[i] = (double) m_bbox.max[i];
+    }
+    header.node_offset  = kd_cache_align(sizeof(KDTreeCacheHeader));
+    header.index_offset = kd_cache_align(header.node_offset + m_node_count * sizeof(KDNode));
+
+    // Write to a temporary file first so that readers never see a truncated cache
+    fs::path tmp_file = filename;
+    tmp_file.replace_extension(".tmp");
+
+    /* scope */ {
+        std::vector<uint8_t> padding(MTS_KD_CACHE_ALIGNMENT, 0);
+        ref<FileStream> stream = new FileStream(tmp_file, FileStream::ETruncReadWrite);
+        stream->write(&header, sizeof(KDTreeCacheHeader));
+        stream->write(padding.data(), header.node_offset - sizeof(KDTreeCacheHeader));
+        stream->write(m_node_data, m_node_count * sizeof(KDNode));
+        stream->write(padding.data(), header.index_offset - header.node_offset -
+                                      m_node_count * sizeof(KDNode));
+        stream->write(m_index_data, m_index_count * sizeof(Index));
+        stream->close();
+    }
+
+    if (!fs::rename(tmp_file, filename))
+        Throw("could not rename \"%s\" to \"%s\"!", tmp_file.string(), filename.string());
+
+    Log(Info, "Wrote the kd-tree to the cache \"%s\".", filename.string());
 }
 
 MTS_VARIANT void ShapeKDTree<Float, Spectrum>::add_shape(Shape *shape) {
@@ -69,6 +515,189 @@ MTS_VARIANT void ShapeKDTree<Float, Spectrum>::add_shape(Shape *shape) {
     m_bbox.expand(shape->bbox());
 }
 
+MTS_VARIANT typename ShapeKDTree<Float, Spectrum>::DynamicPreliminaryIntersection3f
+ShapeKDTree<Float, Spectrum>::ray_intersect_stream(const DynamicRay3f &rays,
+                                                   bool shadow_ray) const {
+    if constexpr (is_array_v<Float> && !is_cuda_array_v<Float>) {
+        if (shadow_ray)
+            return ray_intersect_stream_impl<true>(rays);
+        else
+            return ray_intersect_stream_impl<false>(rays);
+    } else {
+        ENOKI_MARK_USED(rays);
+        ENOKI_MARK_USED(shadow_ray);
+        NotImplementedError("ray_intersect_stream");
+    }
+}
+
+MTS_VARIANT template <bool ShadowRay>
+typename ShapeKDTree<Float, Spectrum>::DynamicPreliminaryIntersection3f
+ShapeKDTree<Float, Spectrum>::ray_intersect_stream_impl(const DynamicRay3f &rays) const {
+    if constexpr (is_array_v<Float> && !is_cuda_array_v<Float>) {
+        constexpr size_t PacketSize = Float::Size;
+
+        /// Ray in the list of a node, along with its valid interval within the node
+        struct StreamItem {
+            uint32_t ray;
+            ScalarFloat mint, maxt;
+        };
+
+        /// Node to be visited by the rays in <tt>items[begin, end)</tt>
+        struct StreamEntry {
+            const KDNode *node;
+            size_t begin, end;
+        };
+
+        uint32_t count = (uint32_t) slices(rays);
+        DynamicPreliminaryIntersection3f result;
+        set_slices(result, count);
+
+        const ScalarFloat *o[3], *d[3], *d_rcp[3];
+        for (size_t a = 0; a < 3; ++a) {
+            o[a]     = rays.o[a].data();
+            d[a]     = rays.d[a].data();
+            d_rcp[a] = rays.d_rcp[a].data();
+        }
+
+        /* Current maximum distance of every ray: shortened by hits, and set
+           to -inf when a shadow ray is occluded so that it gets culled */
+        std::vector<ScalarFloat> ray_maxt(rays.maxt.data(), rays.maxt.data() + count);
+
+        // Clear the intersections and clip the rays against the tree bounds
+        std::vector<StreamItem> items;
+        items.reserve(count);
+        PreliminaryIntersection3f pi_miss = zero<PreliminaryIntersection3f>();
+        pi_miss.t = math::Infinity<Float>;
+        for (uint32_t i = 0; i < count; i += (uint32_t) PacketSize) {
+            UInt32 index = UInt32(i) + arange<UInt32>();
+            scatter(result, pi_miss, index, index < count);
+        }
+        for (uint32_t i = 0; i < count; ++i) {
+            ScalarFloat mint = rays.mint.data()[i], maxt = ray_maxt[i];
+            for (size_t a = 0; a < 3; ++a) {
+                ScalarFloat t0 = (m_bbox.min[a] - o[a][i]) * d_rcp[a][i],
+                            t1 = (m_bbox.max[a] - o[a][i]) * d_rcp[a][i];
+                if (t0 > t1)
+                    std::swap(t0, t1);
+                // The current interval is the first argument so that NaNs are ignored
+                mint = std::max(mint, t0);
+                maxt = std::min(maxt, t1);
+            }
+            if (mint <= maxt)
+                items.push_back({ i, mint, maxt });
+        }
+
+        std::vector<StreamEntry> stack;
+        std::vector<StreamItem> left, right;
+        if (!items.empty())
+            stack.push_back({ local_nodes(), 0, items.size() });
+        const Index *indices = local_indices();
+
+        while (!stack.empty()) {
+            StreamEntry entry = stack.back();
+            stack.pop_back();
+            const KDNode *node = entry.node;
+
+            if (likely(!node->leaf())) {
+                Index axis = node->axis();
+                ScalarFloat split = node->split();
+
+                // Distribute the rays among the children
+                left.clear();
+                right.clear();
+                size_t left_first_count = 0;
+                for (size_t k = entry.begin; k < entry.end; ++k) {
+                    StreamItem item = items[k];
+                    uint32_t r = item.ray;
+                    ScalarFloat maxt = std::min(item.maxt, ray_maxt[r]);
+                    if (item.mint > maxt)
+                        continue;
+
+                    ScalarFloat t_plane = (split - o[axis][r]) * d_rcp[axis][r];
+                    bool left_first  = (o[axis][r] < split) ||
+                                       (o[axis][r] == split && d[axis][r] >= 0.f),
+                         start_after = t_plane < item.mint,
+                         end_before  = t_plane > maxt || t_plane < 0.f || !std::isfinite(t_plane);
+                    left_first_count += left_first ? 1 : 0;
+
+                    if (start_after || end_before) {
+                        bool visit_left = end_before == left_first;
+                        (visit_left ? left : right).push_back({ r, item.mint, maxt });
+                    } else {
+                        (left_first ? left : right).push_back({ r, item.mint, t_plane });
+                        (left_first ? right : left).push_back({ r, t_plane, maxt });
+                    }
+                }
+
+                // The lists of this node are no longer needed
+                items.resize(entry.begin);
+
+                /* Visit the child that is closer for most of the rays first,
+                   so that its hits cull the rays from the other list */
+                bool left_first = 2 * left_first_count >= entry.end - entry.begin;
+                const std::vector<StreamItem> &first  = left_first ? left : right,
+                                              &second = left_first ? right : left;
+                const KDNode *first_node  = node->left() + (left_first ? 0 : 1),
+                             *second_node = node->left() + (left_first ? 1 : 0);
+
+                if (!second.empty()) {
+                    stack.push_back({ second_node, items.size(), items.size() + second.size() });
+                    items.insert(items.end(), second.begin(), second.end());
+                }
+                if (!first.empty()) {
+                    stack.push_back({ first_node, items.size(), items.size() + first.size() });
+                    items.insert(items.end(), first.begin(), first.end());
+                }
+            } else if (node->primitive_count() > 0) {
+                // Intersect the primitives of the leaf with packets of rays
+                for (size_t k = entry.begin; k < entry.end; k += PacketSize) {
+                    alignas(alignof(UInt32)) uint32_t index_s[PacketSize], active_s[PacketSize];
+                    for (size_t j = 0; j < PacketSize; ++j) {
+                        bool valid = k + j < entry.end;
+                        const StreamItem &item = items[valid ? k + j : entry.begin];
+                        index_s[j]  = item.ray;
+                        active_s[j] = valid && item.mint <= ray_maxt[item.ray];
+                    }
+
+                    UInt32 index = load<UInt32>(index_s);
+                    Mask active  = neq(load<UInt32>(active_s), 0u);
+                    if (none(active))
+                        continue;
+
+                    Ray3f ray = gather<Ray3f>(rays, index, active);
+                    ray.maxt = gather<Float>(ray_maxt.data(), index, active);
+
+                    PreliminaryIntersection3f pi;
+                    intersect_leaf<ShadowRay>(node, indices, ray, active,
+                        [&](const PreliminaryIntersection3f &prim_pi) {
+                            Mask hit = active && prim_pi.is_valid();
+                            masked(pi, hit) = prim_pi;
+
+                            if constexpr (ShadowRay)
+                                active &= !hit;
+                            else
+                                masked(ray.maxt, hit) = prim_pi.t;
+                            return none(active);
+                        });
+
+                    Mask hit = pi.is_valid();
+                    if (any(hit)) {
+                        scatter(result, pi, index, hit);
+                        scatter(ray_maxt.data(),
+                                ShadowRay ? Float(-math::Infinity<ScalarFloat>) : pi.t,
+                                index, hit);
+                    }
+                }
+            }
+        }
+
+        return result;
+    } else {
+        ENOKI_MARK_USED(rays);
+        NotImplementedError("ray_intersect_stream");
+    }
+}
+
 MTS_VARIANT std::string ShapeKDTree<Float, Spectrum>::to_string() const {
     std::ostringstream oss;
     oss << "ShapeKDTreeKDTree[" << std::endl
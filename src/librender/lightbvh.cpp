@@ -0,0 +1,398 @@
+#include <mitsuba/core/logger.h>
+#include <mitsuba/render/lightbvh.h>
+#include <algorithm>
+#include <functional>
+
+NAMESPACE_BEGIN(mitsuba)
+
+NAMESPACE_BEGIN(detail)
+/// Bounds of a set of emitters (see \ref LightBVH)
+template <typename Float> struct LightBounds {
+    using Vector3f      = Vector<Float, 3>;
+    using BoundingBox3f = BoundingBox<Point<Float, 3>>;
+
+    BoundingBox3f bbox;
+    Vector3f axis;
+    Float cos_theta_o, cos_theta_e, power;
+
+    /// Merge two bounds, which requires a cone that encloses both cones
+    static LightBounds merge(const LightBounds &a, const LightBounds &b) {
+        LightBounds result;
+        result.bbox = a.bbox;
+        result.bbox.expand(b.bbox);
+        result.power = a.power + b.power;
+        result.cos_theta_e = std::min(a.cos_theta_e, b.cos_theta_e);
+
+        const Float pi = math::Pi<Float>;
+        Float theta_a = std::acos(clamp(a.cos_theta_o, -1.f, 1.f)),
+              theta_b = std::acos(clamp(b.cos_theta_o, -1.f, 1.f)),
+              theta_d = std::acos(clamp(dot(a.axis, b.axis), -1.f, 1.f));
+
+        result.axis        = a.axis;
+        result.cos_theta_o = -1.f;
+        if (std::min(theta_d + theta_b, pi) <= theta_a) {
+            result.cos_theta_o = a.cos_theta_o;
+        } else if (std::min(theta_d + theta_a, pi) <= theta_b) {
+            result.axis        = b.axis;
+            result.cos_theta_o = b.cos_theta_o;
+        } else {
+            // Rotate the axis of 'a' towards 'b' so that the cone encloses both
+            Float theta_o = .5f * (theta_a + theta_d + theta_b);
+            Vector3f w = cross(a.axis, b.axis);
+            Float w_norm = norm(w);
+            if (theta_o < pi && w_norm > 0.f) {
+                Float theta_r = theta_o - theta_a;
+                result.axis = normalize(a.axis * std::cos(theta_r) +
+                                        cross(w / w_norm, a.axis) * std::sin(theta_r));
+                result.cos_theta_o = std::cos(theta_o);
+            }
+        }
+        return result;
+    }
+
+    /// Load the bounds of a node stored by \ref store()
+    static LightBounds load(const Float *data) {
+        LightBounds result;
+        for (size_t k = 0; k < 3; ++k) {
+            result.bbox.min[k] = data[k];
+            result.bbox.max[k] = data[k + 3];
+            result.axis[k]     = data[k + 6];
+        }
+        result.cos_theta_o = data[9];
+        result.cos_theta_e = data[10];
+        result.power       = data[11];
+        return result;
+    }
+
+    /// Store the bounds of a node (\ref LightBVH::NodeSize values)
+    void store(Float *data) const {
+        for (size_t k = 0; k < 3; ++k) {
+            data[k]     = bbox.min[k];
+            data[k + 3] = bbox.max[k];
+            data[k + 6] = axis[k];
+        }
+        data[9]  = cos_theta_o;
+        data[10] = cos_theta_e;
+        data[11] = power;
+    }
+};
+
+/// Power of an emitter, or a unit power if it cannot be estimated
+template <typename Emitter> auto emitter_power(const Emitter *emitter) {
+    try {
+        return emitter->power();
+    } catch (const std::exception &e) {
+        Log(Warn, "Unable to estimate the power of emitter \"%s\", assuming a unit "
+                  "power (%s)", emitter->id(), e.what());
+        return decltype(emitter->power())(1.f);
+    }
+}
+NAMESPACE_END(detail)
+
+MTS_VARIANT LightBVH<Float, Spectrum>::LightBVH(const host_vector<ref<Emitter>, Float> &emitters) {
+    using Bounds = detail::LightBounds<ScalarFloat>;
+
+    struct Item {
+        uint32_t emitter;
+        ScalarPoint3f center;
+        Bounds bounds;
+    };
+
+    uint32_t emitter_count = (uint32_t) emitters.size();
+    std::vector<uint32_t> kind(emitter_count, Unused), trail(emitter_count, 0u), unbounded;
+    std::vector<Item> items;
+
+    for (uint32_t i = 0; i < emitter_count; ++i) {
+        const Emitter *emitter = emitters[i].get();
+
+        ScalarFloat power = detail::emitter_power(emitter);
+        if (!(power > 0.f))
+            continue;
+
+        ScalarBoundingBox3f bbox = emitter->bbox();
+        if (!bbox.valid()) {
+            kind[i] = Unbounded;
+            unbounded.push_back(i);
+            continue;
+        }
+
+        Item item;
+        item.emitter = i;
+        item.center  = bbox.center();
+        item.bounds.bbox  = bbox;
+        item.bounds.power = power;
+        std::tie(item.bounds.axis, item.bounds.cos_theta_o, item.bounds.cos_theta_e) =
+            emitter->emission_cone();
+        kind[i] = Bounded;
+        items.push_back(item);
+    }
+
+    std::vector<ScalarFloat> node_data;
+    std::vector<uint32_t> node_child;
+
+    // Build the nodes in depth-first order, so that the first child follows its parent
+    auto build = [&](auto &build_ref, size_t begin, size_t end, uint32_t depth,
+                     uint32_t path) -> Bounds {
+        uint32_t index = (uint32_t) node_child.size();
+        node_child.push_back(0u);
+        node_data.resize(node_data.size() + NodeSize);
+        m_max_depth = std::max(m_max_depth, depth);
+
+        Bounds bounds;
+        if (end - begin == 1) {
+            const Item &item = items[begin];
+            node_child[index] = item.emitter | LeafFlag;
+            trail[item.emitter] = path;
+            bounds = item.bounds;
+        } else {
+            if (depth >= 32)
+                Throw("LightBVH: the hierarchy is too deep!");
+
+            // Split at the median of the centers along the largest axis
+            ScalarBoundingBox3f centers;
+            for (size_t i = begin; i < end; ++i)
+                centers.expand(items[i].center);
+            uint32_t axis = centers.major_axis();
+            size_t mid = (begin + end) / 2;
+            std::nth_element(items.begin() + begin, items.begin() + mid, items.begin() + end,
+                             [axis](const Item &a, const Item &b) {
+                                 return a.center[axis] < b.center[axis];
+                             });
+
+            Bounds left  = build_ref(build_ref, begin, mid, depth + 1, path);
+            uint32_t right_index = (uint32_t) node_child.size();
+            Bounds right = build_ref(build_ref, mid, end, depth + 1, path | (1u << depth));
+            node_child[index] = right_index;
+            bounds = Bounds::merge(left, right);
+        }
+
+        bounds.store(node_data.data() + (size_t) index * NodeSize);
+        return bounds;
+    };
+
+    if (!items.empty())
+        build(build, 0, items.size(), 0, 0u);
+
+    m_node_count      = node_child.size();
+    m_unbounded_count = (uint32_t) unbounded.size();
+    if (m_unbounded_count > 0)
+        m_unbounded_prob = items.empty() ? 1.f : m_unbounded_count / (m_unbounded_count + 1.f);
+
+    m_node_data     = DynamicBuffer<Float>::copy(node_data.data(), node_data.size());
+    m_node_child    = DynamicBuffer<UInt32>::copy(node_child.data(), node_child.size());
+    m_emitter_kind  = DynamicBuffer<UInt32>::copy(kind.data(), kind.size());
+    m_emitter_trail = DynamicBuffer<UInt32>::copy(trail.data(), trail.size());
+    m_unbounded     = DynamicBuffer<UInt32>::copy(unbounded.data(), unbounded.size());
+
+    Log(Debug, "Light BVH: %i nodes over %i emitters (depth %i), %i unbounded emitters",
+        m_node_count, items.size(), m_max_depth, m_unbounded_count);
+}
+
+MTS_VARIANT LightBVH<Float, Spectrum>::~LightBVH() { }
+
+MTS_VARIANT Float LightBVH<Float, Spectrum>::importance(const Point3f &p, const UInt32 &node,
+                                                           Mask active) const {
+    UInt32 offset = node * NodeSize;
+    auto fetch = [&](uint32_t k) { return gather<Float>(m_node_data, offset + k, active); };
+
+    Point3f p_min(fetch(0), fetch(1), fetch(2)),
+            p_max(fetch(3), fetch(4), fetch(5));
+    Vector3f axis(fetch(6), fetch(7), fetch(8));
+    Float cos_theta_o = fetch(9), cos_theta_e = fetch(10), power = fetch(11);
+
+    // Distance to the center, clamped to the radius of the bounding sphere
+    Point3f center = .5f * (p_min + p_max);
+    Vector3f wi    = p - center;
+    Float dist_2   = squared_norm(wi),
+          radius_2 = squared_norm(p_max - center);
+    Mask inside    = dist_2 <= radius_2;
+    wi *= rsqrt(dist_2);
+
+    /* Smallest angle between the direction towards 'p' and the cone of
+       emission, after accounting for the extent of the bounding sphere */
+    Float cos_theta_w = dot(axis, wi),
+          sin_theta_w = safe_sqrt(1.f - sqr(cos_theta_w)),
+          sin_theta_o = safe_sqrt(1.f - sqr(cos_theta_o)),
+          cos_theta_b = safe_sqrt(1.f - radius_2 / dist_2),
+          sin_theta_b = safe_sqrt(1.f - sqr(cos_theta_b));
+
+    Mask within_o = cos_theta_w > cos_theta_o;
+    Float cos_theta_x = select(within_o, 1.f, cos_theta_w * cos_theta_o + sin_theta_w * sin_theta_o),
+          sin_theta_x = select(within_o, 0.f, sin_theta_w * cos_theta_o - cos_theta_w * sin_theta_o),
+          cos_theta_p = select(cos_theta_x > cos_theta_b, 1.f,
+                               cos_theta_x * cos_theta_b + sin_theta_x * sin_theta_b);
+    masked(cos_theta_p, inside) = 1.f;
+
+    Float result = power * cos_theta_p /
+                   max(max(dist_2, radius_2), math::RayEpsilon<Float>);
+    return select(active && cos_theta_p >= cos_theta_e, result, 0.f);
+}
+
+MTS_VARIANT std::tuple<typename LightBVH<Float, Spectrum>::UInt32, Float, Float>
+LightBVH<Float, Spectrum>::sample(const Interaction3f &ref, Float sample, Mask active) const {
+    UInt32 index(0);
+    Float pmf(0.f);
+    Mask traverse = active;
+
+    // Sample the unbounded emitters uniformly
+    if (m_unbounded_count > 0) {
+        Mask unbounded = active && sample < m_unbounded_prob;
+        Float u = sample * (m_unbounded_count / m_unbounded_prob);
+        UInt32 slot = min(UInt32(u), m_unbounded_count - 1);
+        masked(index, unbounded)  = gather<UInt32>(m_unbounded, slot, unbounded);
+        masked(pmf, unbounded)    = m_unbounded_prob / m_unbounded_count;
+        masked(sample, unbounded) = u - Float(slot);
+
+        traverse &= !unbounded;
+        masked(sample, traverse) = (sample - m_unbounded_prob) / (1.f - m_unbounded_prob);
+    }
+
+    if (m_node_count == 0)
+        return { index, pmf, min(sample, math::OneMinusEpsilon<Float>) };
+
+    // Descend from the root, choosing children proportionally to their importance
+    masked(pmf, traverse) = 1.f - m_unbounded_prob;
+    UInt32 node(0);
+    while (any(traverse)) {
+        UInt32 child = gather<UInt32>(m_node_child, node, traverse);
+        Mask leaf = traverse && neq(child & LeafFlag, 0u);
+        masked(index, leaf) = child & ~LeafFlag;
+        traverse &= !leaf;
+        if (none(traverse))
+            break;
+
+        UInt32 left = node + 1u;
+        Float importance_left  = importance(ref.p, left, traverse),
+              importance_right = importance(ref.p, child, traverse),
+              prob_left = importance_left / (importance_left + importance_right);
+
+        // No emitter of the node contributes to the reference point
+        Mask failed = traverse && !(importance_left + importance_right > 0.f);
+        masked(pmf, failed) = 0.f;
+        traverse &= !failed;
+
+        Mask go_left = sample < prob_left;
+        masked(sample, traverse) = select(go_left, sample / prob_left,
+                                          (sample - prob_left) / (1.f - prob_left));
+        masked(pmf, traverse) *= select(go_left, prob_left, 1.f - prob_left);
+        masked(node, traverse) = select(go_left, left, child);
+    }
+
+    return { index, pmf, min(sample, math::OneMinusEpsilon<Float>) };
+}
+
+MTS_VARIANT Float LightBVH<Float, Spectrum>::pdf(const Interaction3f &ref, UInt32 index,
+                                                    Mask active) const {
+    UInt32 kind = gather<UInt32>(m_emitter_kind, index, active);
+    Float pmf(0.f);
+    if (m_unbounded_count > 0)
+        masked(pmf, active && eq(kind, (uint32_t) Unbounded)) =
+            m_unbounded_prob / m_unbounded_count;
+
+    Mask traverse = active && eq(kind, (uint32_t) Bounded);
+    if (m_node_count == 0 || none_or<false>(traverse))
+        return pmf;
+
+    // Retrace the path of the emitter from the root
+    UInt32 trail = gather<UInt32>(m_emitter_trail, index, traverse), node(0);
+    masked(pmf, traverse) = 1.f - m_unbounded_prob;
+    while (any(traverse)) {
+        UInt32 child = gather<UInt32>(m_node_child, node, traverse);
+        traverse &= eq(child & LeafFlag, 0u);
+        if (none(traverse))
+            break;
+
+        UInt32 left = node + 1u;
+        Float importance_left  = importance(ref.p, left, traverse),
+              importance_right = importance(ref.p, child, traverse),
+              total = importance_left + importance_right,
+              prob_left = select(total > 0.f, importance_left / total, 0.f);
+
+        Mask go_right = neq(trail & 1u, 0u);
+        masked(pmf, traverse)  *= select(total > 0.f, select(go_right, 1.f - prob_left, prob_left), 0.f);
+        masked(node, traverse)  = select(go_right, child, left);
+        masked(trail, traverse) = trail >> 1;
+    }
+
+    return pmf;
+}
+
+MTS_VARIANT bool LightBVH<Float, Spectrum>::refit(const host_vector<ref<Emitter>, Float> &emitters,
+                                                  const std::vector<uint32_t> &changed) {
+    using Bounds = detail::LightBounds<ScalarFloat>;
+
+    // The buffers are read and updated on the host
+    m_emitter_kind  = m_emitter_kind.managed();
+    m_emitter_trail = m_emitter_trail.managed();
+    m_node_child    = m_node_child.managed();
+    const uint32_t *kind  = m_emitter_kind.data(),
+                   *trail = m_emitter_trail.data(),
+                   *node_child = m_node_child.data();
+
+    std::vector<std::pair<uint32_t, Bounds>> leaves;
+    for (uint32_t i : changed) {
+        const Emitter *emitter = emitters[i].get();
+        ScalarFloat power = detail::emitter_power(emitter);
+        ScalarBoundingBox3f bbox = emitter->bbox();
+
+        uint32_t new_kind = !(power > 0.f) ? Unused : (bbox.valid() ? Bounded : Unbounded);
+        if (new_kind != kind[i])
+            return false;
+        if (new_kind != Bounded)
+            continue;
+
+        Bounds bounds;
+        bounds.bbox  = bbox;
+        bounds.power = power;
+        std::tie(bounds.axis, bounds.cos_theta_o, bounds.cos_theta_e) =
+            emitter->emission_cone();
+        leaves.emplace_back(i, bounds);
+    }
+
+    if (leaves.empty())
+        return true;
+
+    m_node_data = m_node_data.managed();
+    ScalarFloat *node_data = m_node_data.data();
+
+    // Update the leaves and collect the inner nodes on their paths from the root
+    std::vector<uint32_t> nodes;
+    for (const auto &[emitter, bounds] : leaves) {
+        uint32_t node = 0, path = trail[emitter];
+        while (!(node_child[node] & LeafFlag)) {
+            nodes.push_back(node);
+            node = (path & 1u) ? node_child[node] : node + 1u;
+            path >>= 1;
+        }
+        Assert(node_child[node] == (emitter | LeafFlag));
+        bounds.store(node_data + (size_t) node * NodeSize);
+    }
+
+    /* Children follow their parents in depth-first order, hence merging
+       the nodes by decreasing index updates the children first */
+    std::sort(nodes.begin(), nodes.end(), std::greater<uint32_t>());
+    nodes.erase(std::unique(nodes.begin(), nodes.end()), nodes.end());
+    for (uint32_t node : nodes) {
+        Bounds left  = Bounds::load(node_data + (size_t) (node + 1) * NodeSize),
+               right = Bounds::load(node_data + (size_t) node_child[node] * NodeSize);
+        Bounds::merge(left, right).store(node_data + (size_t) node * NodeSize);
+    }
+
+    Log(Debug, "Light BVH: refitted %i emitters (%i inner nodes)", leaves.size(),
+        nodes.size());
+    return true;
+}
+
+MTS_VARIANT std::string LightBVH<Float, Spectrum>::to_string() const {
+    std::ostringstream oss;
+    oss << "LightBVH[" << std::endl
+        << "  node_count = " << m_node_count << "," << std::endl
+        << "  max_depth = " << m_max_depth << "," << std::endl
+        << "  unbounded_count = " << m_unbounded_count << std::endl
+        << "]";
+    return oss.str();
+}
+
+MTS_IMPLEMENT_CLASS_VARIANT(LightBVH, Object)
+MTS_INSTANTIATE_CLASS(LightBVH)
+NAMESPACE_END(mitsuba)
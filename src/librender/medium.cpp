@@ -2,6 +2,7 @@
 #include <mitsuba/core/properties.h>
 #include <mitsuba/render/medium.h>
 #include <mitsuba/render/phase.h>
+#include <mitsuba/render/sampler.h>
 #include <mitsuba/render/scene.h>
 #include <mitsuba/render/texture.h>
 
@@ -77,7 +78,8 @@ Medium<Float, Spectrum>::sample_interaction(const Ray3f &ray, Float sample,
 MTS_VARIANT
 std::pair<typename Medium<Float, Spectrum>::UnpolarizedSpectrum,
           typename Medium<Float, Spectrum>::UnpolarizedSpectrum>
-Medium<Float, Spectrum>::eval_tr_and_pdf(const MediumInteraction3f &mi,
+Medium<Float, Spectrum>::eval_tr_and_pdf(const Ray3f & /* ray */,
+                                         const MediumInteraction3f &mi,
                                          const SurfaceInteraction3f &si,
                                          Mask active) const {
     MTS_MASKED_FUNCTION(ProfilerPhase::MediumEvaluate, active);
@@ -88,6 +90,41 @@ Medium<Float, Spectrum>::eval_tr_and_pdf(const MediumInteraction3f &mi,
     return { tr, pdf };
 }
 
+MTS_VARIANT typename Medium<Float, Spectrum>::UnpolarizedSpectrum
+Medium<Float, Spectrum>::eval_transmittance(const Ray3f &ray_, Sampler *sampler,
+                                            UInt32 channel, bool /* residual */,
+                                            Mask active) const {
+    MTS_MASKED_FUNCTION(ProfilerPhase::MediumEvaluate, active);
+
+    Ray3f ray(ray_);
+    UnpolarizedSpectrum transmittance(1.f);
+    while (any(active)) {
+        MediumInteraction3f mi =
+            sample_interaction(ray, sampler->next_1d(active), channel, active);
+        Mask collided = active && mi.is_valid();
+
+        /* Weight the flight by its transmittance over the sampling density of
+           the selected channel. With a gray majorant, this reduces to the null
+           collision probability sigma_n / majorant. */
+        Float m = mi.combined_extinction[0];
+        if constexpr (is_rgb_v<Spectrum>) { // Handle RGB rendering
+            masked(m, eq(channel, 1u)) = mi.combined_extinction[1];
+            masked(m, eq(channel, 2u)) = mi.combined_extinction[2];
+        }
+        Float t = min(mi.t, ray.maxt) - mi.mint;
+        UnpolarizedSpectrum weight = exp(-t * (mi.combined_extinction - m));
+        masked(weight, collided) *= select(m > 0.f, mi.sigma_n / m, 0.f);
+        masked(transmittance, active) *= weight;
+
+        // Continue from the null collision
+        active = collided && any(neq(transmittance, 0.f));
+        masked(ray.o, active)    = mi.p;
+        masked(ray.mint, active) = 0.f;
+        masked(ray.maxt, active) = ray.maxt - mi.t;
+    }
+    return transmittance;
+}
+
 MTS_IMPLEMENT_CLASS_VARIANT(Medium, Object, "medium")
 MTS_INSTANTIATE_CLASS(Medium)
 NAMESPACE_END(mitsuba)
@@ -1,4 +1,5 @@
 #include <mitsuba/core/fstream.h>
+#include <mitsuba/core/hash.h>
 #include <mitsuba/core/timer.h>
 #include <mitsuba/core/transform.h>
 #include <mitsuba/core/util.h>
@@ -6,8 +7,15 @@
 #include <mitsuba/render/emitter.h>
 #include <mitsuba/render/interaction.h>
 #include <mitsuba/render/mesh.h>
+#include <mitsuba/render/mtsmesh.h>
 #include <mitsuba/render/records.h>
 #include <mitsuba/render/scene.h>
+#include <enoki/half.h>
+#include <enoki/morton.h>
+#include <tbb/parallel_for.h>
+#include <tbb/task.h>
+#include <algorithm>
+#include <atomic>
 #include <mutex>
 
 #if defined(MTS_ENABLE_EMBREE)
@@ -29,6 +37,19 @@ MTS_VARIANT Mesh<Float, Spectrum>::Mesh(const Properties &props) : Base(props) {
        appearance. Default: ``false`` */
     if (props.bool_("face_normals", false))
         m_disable_vertex_normals = true;
+
+    /* When set to ``true``, the plugin stores the normals, texture coordinates
+       and attributes in compact 16-bit encodings (see compress_vertex_data()).
+       Default: ``false`` */
+    m_compress_vertex_data = props.bool_("compress_vertex_data", false);
+
+    /* When set to ``true``, the plugin reorders the faces and vertices after
+       loading them (see sort_spatially()). Default: ``false`` */
+    m_sort_spatially = props.bool_("sort_spatially", false);
+    if (m_sort_spatially && is_cuda_array_v<Float>) {
+        Log(Warn, "\"sort_spatially\" is not supported in GPU variants, ignoring.");
+        m_sort_spatially = false;
+    }
 }
 
 MTS_VARIANT
@@ -57,6 +78,16 @@ Mesh<Float, Spectrum>::Mesh(const std::string &name, ScalarSize vertex_count,
 
 MTS_VARIANT Mesh<Float, Spectrum>::~Mesh() { }
 
+MTS_VARIANT void Mesh<Float, Spectrum>::set_children() {
+    Base::set_children();
+    update_memory_record();
+}
+
+MTS_VARIANT void Mesh<Float, Spectrum>::update_memory_record() {
+    m_memory.set(vertex_data_bytes() * m_vertex_count + face_data_bytes() * m_face_count +
+                 slices(m_vertex_positions_end_buf) * sizeof(InputFloat));
+}
+
 MTS_VARIANT typename Mesh<Float, Spectrum>::ScalarBoundingBox3f
 Mesh<Float, Spectrum>::bbox() const {
     return m_bbox;
@@ -76,11 +107,81 @@ Mesh<Float, Spectrum>::bbox(ScalarIndex index) const {
                   v1 = vertex_position(fi[1]),
                   v2 = vertex_position(fi[2]);
 
-    return typename Mesh<Float, Spectrum>::ScalarBoundingBox3f(min(min(v0, v1), v2),
-                                                               max(max(v0, v1), v2));
+    ScalarBoundingBox3f result(min(min(v0, v1), v2), max(max(v0, v1), v2));
+
+    // A moving triangle stays within the bounds of both keyframes
+    if (has_vertex_motion()) {
+        for (int k = 0; k < 3; ++k)
+            result.expand(ScalarPoint3f(
+                gather<InputPoint3f>(m_vertex_positions_end_buf, fi[k])));
+    }
+
+    return result;
+}
+
+MTS_VARIANT void Mesh<Float, Spectrum>::set_vertex_motion(ScalarFloat time_start,
+                                                          ScalarFloat time_end) {
+    if (!(time_end > time_start))
+        Throw("set_vertex_motion(): the end of the motion (%f) must come after "
+              "its start (%f)!", time_end, time_start);
+
+    m_motion_time_start = time_start;
+    m_motion_time_scale = 1.f / (time_end - time_start);
+
+    if (!has_vertex_motion()) {
+        m_vertex_positions_end_buf = FloatStorage::copy(m_vertex_positions_buf.data(),
+                                                        m_vertex_count * 3);
+        m_vertex_positions_end_buf.managed();
+        if constexpr (is_cuda_array_v<Float>)
+            cuda_sync();
+        update_memory_record();
+    }
+}
+
+MTS_VARIANT typename Mesh<Float, Spectrum>::ScalarVector2f
+Mesh<Float, Spectrum>::motion_time_range() const {
+    if (!has_vertex_motion())
+        return Base::motion_time_range();
+    return ScalarVector2f(m_motion_time_start,
+                          m_motion_time_start + 1.f / m_motion_time_scale);
+}
+
+MTS_VARIANT std::pair<typename Mesh<Float, Spectrum>::ScalarBoundingBox3f,
+                      typename Mesh<Float, Spectrum>::ScalarBoundingBox3f>
+Mesh<Float, Spectrum>::bbox_motion(ScalarIndex index, ScalarFloat time_start,
+                                   ScalarFloat time_end) const {
+    if (!has_vertex_motion())
+        return Base::bbox_motion(index, time_start, time_end);
+
+    auto fi = face_indices(index);
+    auto bbox_at = [&](ScalarFloat time) {
+        ScalarBoundingBox3f result;
+        for (int k = 0; k < 3; ++k)
+            result.expand(ScalarPoint3f(vertex_position_at(fi[k], time)));
+        return result;
+    };
+
+    /* The vertices move linearly between the two keyframes and are at rest
+       otherwise, hence sampling the bounds at the keyframes suffices */
+    ScalarVector2f range = motion_time_range();
+    std::vector<ScalarFloat> times = { time_start };
+    for (ScalarFloat time : { range.x(), range.y() }) {
+        if (time > time_start && time < time_end)
+            times.push_back(time);
+    }
+    times.push_back(time_end);
+
+    std::vector<ScalarBoundingBox3f> boxes;
+    for (ScalarFloat time : times)
+        boxes.push_back(bbox_at(time));
+
+    return fit_linear_bounds(times, boxes);
 }
 
 MTS_VARIANT void Mesh<Float, Spectrum>::write_ply(const std::string &filename) const {
+    if (has_compressed_vertex_data())
+        Throw("\"%s\": cannot export a mesh with compressed vertex data!", m_name);
+
     ref<FileStream> stream = new FileStream(filename, FileStream::ETruncReadWrite);
 
     std::vector<std::pair<std::string, const MeshAttribute&>> vertex_attributes;
@@ -106,152 +207,419 @@ MTS_VARIANT void Mesh<Float, Spectrum>::write_ply(const std::string &filename) c
     else
         stream->write_line("format binary_little_endian 1.0");
 
+    // The values are written with the precision in which they are stored
+    const char *type = sizeof(InputFloat) == sizeof(double) ? "double" : "float";
+
     stream->write_line(tfm::format("element vertex %i", m_vertex_count));
-    stream->write_line("property float x");
-    stream->write_line("property float y");
-    stream->write_line("property float z");
+    stream->write_line(tfm::format("property %s x", type));
+    stream->write_line(tfm::format("property %s y", type));
+    stream->write_line(tfm::format("property %s z", type));
 
     if (has_vertex_normals()) {
-        stream->write_line("property float nx");
-        stream->write_line("property float ny");
-        stream->write_line("property float nz");
+        stream->write_line(tfm::format("property %s nx", type));
+        stream->write_line(tfm::format("property %s ny", type));
+        stream->write_line(tfm::format("property %s nz", type));
     }
 
     if (has_vertex_texcoords()) {
-        stream->write_line("property float u");
-        stream->write_line("property float v");
+        stream->write_line(tfm::format("property %s u", type));
+        stream->write_line(tfm::format("property %s v", type));
     }
 
     for (const auto&[name, attribute]: vertex_attributes)
         for (size_t i = 0; i < attribute.size; ++i)
-            stream->write_line(tfm::format("property float %s_%zu", name.c_str(), i));
+            stream->write_line(tfm::format("property %s %s_%zu", type, name.c_str(), i));
 
     stream->write_line(tfm::format("element face %i", m_face_count));
     stream->write_line("property list uchar int vertex_indices");
 
     for (const auto&[name, attribute]: face_attributes)
         for (size_t i = 0; i < attribute.size; ++i)
-            stream->write_line(tfm::format("property float %s_%zu", name.c_str(), i));
+            stream->write_line(tfm::format("property %s %s_%zu", type, name.c_str(), i));
 
     stream->write_line("end_header");
 
+    /* Assemble the interleaved records of a block of elements in parallel
+       and write each block with a single call */
+    auto write_records = [&](size_t count, size_t record_size, auto fill) {
+        const size_t block_size = std::max((size_t) 1, ((size_t) 32 << 20) / record_size);
+        std::unique_ptr<uint8_t[]> buffer(
+            new uint8_t[std::min(count, block_size) * record_size]);
+
+        for (size_t start = 0; start < count; start += block_size) {
+            size_t end = std::min(count, start + block_size);
+            tbb::parallel_for(
+                tbb::blocked_range<size_t>(start, end, 16384),
+                [&](const tbb::blocked_range<size_t> &range) {
+                    for (size_t i = range.begin(); i != range.end(); ++i)
+                        fill(i, buffer.get() + (i - start) * record_size);
+                }
+            );
+            stream->write(buffer.get(), (end - start) * record_size);
+        }
+    };
+
+    // Copy 'size' values of element 'i' from 'src' and advance the output pointer
+    auto copy_values = [](uint8_t *&dst, const void *src, size_t i, size_t size) {
+        memcpy(dst, (const uint8_t *) src + i * size, size);
+        dst += size;
+    };
+
     // Write vertices data
     const InputFloat* position_ptr = m_vertex_positions_buf.data();
-    const InputFloat* normal_ptr   = m_vertex_normals_buf.data();
-    const InputFloat* texcoord_ptr = m_vertex_texcoords_buf.data();
+    const InputFloat* normal_ptr   = has_vertex_normals() ? m_vertex_normals_buf.data() : nullptr;
+    const InputFloat* texcoord_ptr = has_vertex_texcoords() ? m_vertex_texcoords_buf.data() : nullptr;
 
-    std::vector<const InputFloat*> vertex_attributes_ptr;
+    size_t vertex_record_size = (3 + (normal_ptr ? 3 : 0) + (texcoord_ptr ? 2 : 0)) *
+                                sizeof(InputFloat);
     for (const auto&[name, attribute]: vertex_attributes)
-        vertex_attributes_ptr.push_back(attribute.buf.data());
-
-    for (size_t i = 0; i < m_vertex_count; i++) {
-        // Write positions
-        stream->write(position_ptr, 3 * sizeof(InputFloat));
-        position_ptr += 3;
-        // Write normals
-        if (has_vertex_normals()) {
-            stream->write(normal_ptr, 3 * sizeof(InputFloat));
-            normal_ptr += 3;
-        }
-        // Write texture coordinates
-        if (has_vertex_texcoords()) {
-            stream->write(texcoord_ptr, 2 * sizeof(InputFloat));
-            texcoord_ptr += 2;
-        }
+        vertex_record_size += attribute.size * sizeof(InputFloat);
+
+    write_records(m_vertex_count, vertex_record_size, [&](size_t i, uint8_t *dst) {
+        copy_values(dst, position_ptr, i, 3 * sizeof(InputFloat));
+        if (normal_ptr)
+            copy_values(dst, normal_ptr, i, 3 * sizeof(InputFloat));
+        if (texcoord_ptr)
+            copy_values(dst, texcoord_ptr, i, 2 * sizeof(InputFloat));
+        for (const auto&[name, attribute]: vertex_attributes)
+            copy_values(dst, attribute.buf.data(), i, attribute.size * sizeof(InputFloat));
+    });
+
+    // Write faces data
+    const ScalarIndex* face_ptr = m_faces_buf.data();
+
+    size_t face_record_size = sizeof(uint8_t) + 3 * sizeof(ScalarIndex);
+    for (const auto&[name, attribute]: face_attributes)
+        face_record_size += attribute.size * sizeof(InputFloat);
 
-        for (size_t j = 0; j < vertex_attributes_ptr.size(); ++j) {
-            const auto&[name, attribute] = vertex_attributes[j];
-            stream->write(vertex_attributes_ptr[j], attribute.size * sizeof(InputFloat));
-            vertex_attributes_ptr[j] += attribute.size;
+    write_records(m_face_count, face_record_size, [&](size_t i, uint8_t *dst) {
+        *dst++ = 3;
+        copy_values(dst, face_ptr, i, 3 * sizeof(ScalarIndex));
+        for (const auto&[name, attribute]: face_attributes)
+            copy_values(dst, attribute.buf.data(), i, attribute.size * sizeof(InputFloat));
+    });
+
+    Log(Info, "\"%s\": wrote %i faces, %i vertices (%s in %s)",
+        filename, m_face_count, m_vertex_count,
+        util::mem_string(m_face_count * face_data_bytes() +
+                            m_vertex_count * vertex_data_bytes()),
+        util::time_string(timer.value())
+    );
+}
+
+MTS_VARIANT void Mesh<Float, Spectrum>::write_ply_async(const std::string &filename) const {
+    class WriteTask : public tbb::task {
+        ref<const Mesh> mesh;
+        std::string filename;
+
+    public:
+        WriteTask(const Mesh *mesh, const std::string &filename)
+            : mesh(mesh), filename(filename) { }
+
+        tbb::task* execute() override {
+            try {
+                mesh->write_ply(filename);
+            } catch (const std::exception &e) {
+                Log(Warn, "write_ply_async(): could not write \"%s\": %s",
+                    filename, e.what());
+            }
+            return nullptr;
         }
+    };
+
+    WriteTask *t = new (tbb::task::allocate_root()) WriteTask(this, filename);
+    tbb::task::enqueue(*t);
+}
+
+MTS_VARIANT void Mesh<Float, Spectrum>::write_mtsmesh(const std::string &filename) const {
+    using detail::MeshCacheHeader;
+    using detail::MeshCacheAttribute;
+    using detail::MeshCacheFlags;
+    using detail::mesh_cache_align;
+
+    if (has_compressed_vertex_data())
+        Throw("\"%s\": cannot export a mesh with compressed vertex data!", m_name);
+
+    if (has_vertex_motion())
+        Log(Warn, "\"%s\": the vertex motion is not stored in the mesh cache \"%s\"",
+            m_name, filename);
+
+    if (m_face_count > 0)
+        ensure_pmf_built();
+
+    if constexpr (is_cuda_array_v<Float>)
+        cuda_sync();
+
+    // Sort the attributes so that the file contents are deterministic
+    std::vector<std::pair<std::string, const MeshAttribute *>> attributes;
+    for (const auto &[name, attribute] : m_mesh_attributes)
+        attributes.push_back({ name, &attribute });
+    std::sort(attributes.begin(), attributes.end(),
+              [](const auto &a, const auto &b) { return a.first < b.first; });
+
+    MeshCacheHeader header;
+    memset(&header, 0, sizeof(MeshCacheHeader));
+    strncpy(header.magic, MTS_MESH_CACHE_MAGIC, sizeof(header.magic));
+    header.version         = MTS_MESH_CACHE_VERSION;
+    header.vertex_count    = m_vertex_count;
+    header.face_count      = m_face_count;
+    header.name_length     = (uint32_t) m_name.size();
+    header.attribute_count = (uint32_t) attributes.size();
+    for (size_t i = 0; i < 3; ++i) {
+        header.bbox_min[i] = (double) m_bbox.min[i];
+        header.bbox_max[i] = (double) m_bbox.max[i];
     }
 
-    const ScalarIndex* face_ptr = m_faces_buf.data();
+    // Lay out the data arrays after the name and the attribute table
+    size_t offset = sizeof(MeshCacheHeader) + m_name.size();
+    for (const auto &[name, attribute] : attributes)
+        offset += sizeof(MeshCacheAttribute) + name.size();
+
+    std::vector<std::pair<const void *, size_t>> arrays;
+    auto add_array = [&](const void *ptr, size_t size) {
+        offset = mesh_cache_align(offset);
+        arrays.push_back({ ptr, size });
+        size_t result = offset;
+        offset += size;
+        return (uint64_t) result;
+    };
+
+    const size_t vertex_count = (size_t) m_vertex_count;
+    header.positions_offset =
+        add_array(m_vertex_positions_buf.data(), vertex_count * 3 * sizeof(InputFloat));
+    if (has_vertex_normals()) {
+        header.flags |= (uint32_t) MeshCacheFlags::HasNormals;
+        header.normals_offset =
+            add_array(m_vertex_normals_buf.data(), vertex_count * 3 * sizeof(InputFloat));
+    }
+    if (has_vertex_texcoords()) {
+        header.flags |= (uint32_t) MeshCacheFlags::HasTexcoords;
+        header.texcoords_offset =
+            add_array(m_vertex_texcoords_buf.data(), vertex_count * 2 * sizeof(InputFloat));
+    }
+    if (m_disable_vertex_normals)
+        header.flags |= (uint32_t) MeshCacheFlags::FaceNormals;
+    if constexpr (is_spectral_v<Spectrum>)
+        header.flags |= (uint32_t) MeshCacheFlags::SpectralColors;
+    header.faces_offset =
+        add_array(m_faces_buf.data(), (size_t) m_face_count * 3 * sizeof(ScalarIndex));
+
+    std::vector<MeshCacheAttribute> attribute_table;
+    for (const auto &[name, attribute] : attributes) {
+        MeshCacheAttribute entry;
+        memset(&entry, 0, sizeof(MeshCacheAttribute));
+        entry.name_length    = (uint32_t) name.size();
+        entry.face_attribute = attribute->type == MeshAttributeType::Face;
+        entry.size           = (uint32_t) attribute->size;
+        entry.offset         = add_array(attribute->buf.data(),
+                                         attribute->buf.size() * sizeof(InputFloat));
+        attribute_table.push_back(entry);
+    }
 
-    std::vector<const InputFloat*> face_attributes_ptr;
-    for (const auto&[name, attribute]: face_attributes)
-        face_attributes_ptr.push_back(attribute.buf.data());
+    if (!m_area_pmf.empty()) {
+        header.flags |= (uint32_t) MeshCacheFlags::HasAreaPMF;
+        header.pmf_scalar_size   = sizeof(ScalarFloat);
+        header.pmf_valid[0]      = m_area_pmf.valid().x();
+        header.pmf_valid[1]      = m_area_pmf.valid().y();
+        header.pmf_sum           = (double) m_area_pmf.sum();
+        header.pmf_normalization = (double) m_area_pmf.normalization();
+        header.pmf_offset = add_array(m_area_pmf.pmf().data(),
+                                      m_area_pmf.size() * sizeof(ScalarFloat));
+        header.cdf_offset = add_array(m_area_pmf.cdf().data(),
+                                      m_area_pmf.size() * sizeof(ScalarFloat));
+    }
 
-    // Write faces data
-    uint8_t vertex_indices_count = 3;
-    for (size_t i = 0; i < m_face_count; i++) {
-        // Write vertex count
-        stream->write(&vertex_indices_count, sizeof(uint8_t));
-
-        // Write positions
-        stream->write(face_ptr, 3 * sizeof(ScalarIndex));
-        face_ptr += 3;
-
-        for (size_t j = 0; j < face_attributes_ptr.size(); ++j) {
-            const auto&[name, attribute] = face_attributes[j];
-            stream->write(face_attributes_ptr[j], attribute.size * sizeof(InputFloat));
-            face_attributes_ptr[j] += attribute.size;
+    Log(Info, "Writing mesh to \"%s\" ..", filename);
+    Timer timer;
+
+    // Write to a temporary file first so that readers never see a truncated file
+    fs::path tmp_file = filename;
+    tmp_file.replace_extension(".tmp");
+
+    /* scope */ {
+        std::vector<uint8_t> padding(MTS_MESH_CACHE_ALIGNMENT, 0);
+        ref<FileStream> stream = new FileStream(tmp_file, FileStream::ETruncReadWrite);
+        stream->write(&header, sizeof(MeshCacheHeader));
+        stream->write(m_name.data(), m_name.size());
+        for (size_t i = 0; i < attributes.size(); ++i) {
+            stream->write(&attribute_table[i], sizeof(MeshCacheAttribute));
+            stream->write(attributes[i].first.data(), attributes[i].first.size());
+        }
+        for (const auto &[ptr, size] : arrays) {
+            stream->write(padding.data(), mesh_cache_align(stream->tell()) - stream->tell());
+            stream->write(ptr, size);
         }
+        stream->close();
     }
 
+    if (!fs::rename(tmp_file, filename))
+        Throw("could not rename \"%s\" to \"%s\"!", tmp_file.string(), filename);
+
     Log(Info, "\"%s\": wrote %i faces, %i vertices (%s in %s)",
         filename, m_face_count, m_vertex_count,
-        util::mem_string(m_face_count * face_data_bytes() +
-                            m_vertex_count * vertex_data_bytes()),
+        util::mem_string(offset),
         util::time_string(timer.value())
     );
 }
 
+MTS_VARIANT uint64_t Mesh<Float, Spectrum>::placement_invariant_hash() const {
+    if constexpr (is_cuda_array_v<Float>)
+        cuda_sync();
+
+    uint64_t hash = hash_buffer(&m_vertex_count, sizeof(ScalarSize));
+    hash = hash_buffer(&m_face_count, sizeof(ScalarSize), hash);
+    hash = hash_buffer(m_faces_buf.data(), slices(m_faces_buf) * sizeof(ScalarIndex), hash);
+    hash = hash_buffer(m_vertex_texcoords_buf.data(),
+                       slices(m_vertex_texcoords_buf) * sizeof(InputFloat), hash);
+
+    // Visit the attributes in a deterministic order
+    std::vector<std::string> names;
+    for (const auto &[name, attribute] : m_mesh_attributes)
+        names.push_back(name);
+    std::sort(names.begin(), names.end());
+    for (const std::string &name : names) {
+        const FloatStorage &buf = m_mesh_attributes.find(name)->second.buf;
+        hash = hash_buffer(name.data(), name.size(), hash);
+        hash = hash_buffer(buf.data(), slices(buf) * sizeof(InputFloat), hash);
+    }
+
+    return hash;
+}
+
+MTS_VARIANT bool Mesh<Float, Spectrum>::is_placed_copy_of(const Mesh *other,
+                                                          ScalarTransform4f &transform) const {
+    auto same_buffer = [](const auto &a, const auto &b) {
+        using Value = std::decay_t<decltype(*a.data())>;
+        return slices(a) == slices(b) &&
+               (slices(a) == 0 || memcmp(a.data(), b.data(), slices(a) * sizeof(Value)) == 0);
+    };
+
+    if (m_vertex_count != other->m_vertex_count || m_face_count != other->m_face_count ||
+        has_vertex_normals() != other->has_vertex_normals() ||
+        m_disable_vertex_normals != other->m_disable_vertex_normals ||
+        has_vertex_motion() || other->has_vertex_motion() ||
+        has_compressed_vertex_data() || other->has_compressed_vertex_data() ||
+        m_mesh_attributes.size() != other->m_mesh_attributes.size())
+        return false;
+
+    if constexpr (is_cuda_array_v<Float>)
+        cuda_sync();
+
+    if (!same_buffer(m_faces_buf, other->m_faces_buf) ||
+        !same_buffer(m_vertex_texcoords_buf, other->m_vertex_texcoords_buf))
+        return false;
+
+    for (const auto &[name, attribute] : m_mesh_attributes) {
+        auto it = other->m_mesh_attributes.find(name);
+        if (it == other->m_mesh_attributes.end() || it->second.size != attribute.size ||
+            it->second.type != attribute.type || !same_buffer(it->second.buf, attribute.buf))
+            return false;
+    }
+
+    // Map the vertices of 'other' into the placement of this mesh
+    ScalarTransform4f relative = m_to_world * other->m_to_world.inverse();
+    ScalarFloat tolerance =
+        1e-4f * std::max(hmax(max(abs(m_bbox.min), abs(m_bbox.max))), ScalarFloat(1e-3f));
+
+    for (ScalarSize i = 0; i < m_vertex_count; ++i) {
+        ScalarPoint3f p = relative.transform_affine(ScalarPoint3f(other->vertex_position(i)));
+        if (hmax(abs(p - ScalarPoint3f(vertex_position(i)))) > tolerance)
+            return false;
+    }
+
+    transform = relative;
+    return true;
+}
+
 MTS_VARIANT void Mesh<Float, Spectrum>::recompute_vertex_normals() {
     if (!has_vertex_normals())
         Throw("Storing new normals in a Mesh that didn't have normals at "
               "construction time is not implemented yet.");
 
+    // Compute the normals in single precision and encode them again afterwards
+    bool compressed = slices(m_vertex_normals_oct_buf) != 0;
+    if (compressed) {
+        m_vertex_normals_buf = empty<FloatStorage>(m_vertex_count * 3);
+        m_vertex_normals_oct_buf = DynamicBuffer<UInt32>();
+    }
+
     /* Weighting scheme based on "Computing Vertex Normals from Polygonal Facets"
        by Grit Thuermer and Charles A. Wuethrich, JGT 1998, Vol 3 */
 
     if constexpr (!is_dynamic_v<Float>) {
-        size_t invalid_counter = 0;
-        std::vector<InputNormal3f> normals(m_vertex_count, zero<InputNormal3f>());
+        std::atomic<size_t> invalid_counter(0);
+
+        /* Faces are processed in parallel, hence the contributions to each
+           vertex are accumulated using atomic compare-and-swap operations */
+        std::unique_ptr<std::atomic<InputFloat>[]> normals(
+            new std::atomic<InputFloat>[(size_t) m_vertex_count * 3]());
+
+        auto atomic_add = [](std::atomic<InputFloat> &target, InputFloat value) {
+            InputFloat current = target.load(std::memory_order_relaxed);
+            while (!target.compare_exchange_weak(current, current + value,
+                                                 std::memory_order_relaxed))
+                ;
+        };
 
-        for (ScalarSize i = 0; i < m_face_count; ++i) {
-            auto fi = face_indices(i);
-            Assert(fi[0] < m_vertex_count &&
-                   fi[1] < m_vertex_count &&
-                   fi[2] < m_vertex_count);
-
-            InputPoint3f v[3] = { vertex_position(fi[0]),
-                                  vertex_position(fi[1]),
-                                  vertex_position(fi[2]) };
-
-            InputVector3f side_0 = v[1] - v[0],
-                          side_1 = v[2] - v[0];
-            InputNormal3f n = cross(side_0, side_1);
-            InputFloat length_sqr = squared_norm(n);
-            if (likely(length_sqr > 0)) {
-                n *= rsqrt(length_sqr);
-
-                // Use Enoki to compute the face angles at the same time
-                auto side1 = transpose(Array<Packet<InputFloat, 3>, 3>{ side_0, v[2] - v[1], v[0] - v[2] });
-                auto side2 = transpose(Array<Packet<InputFloat, 3>, 3>{ side_1, v[0] - v[1], v[1] - v[2] });
-                InputVector3f face_angles = unit_angle(normalize(side1), normalize(side2));
-
-                for (size_t j = 0; j < 3; ++j)
-                    normals[fi[j]] += n * face_angles[j];
+        tbb::parallel_for(
+            tbb::blocked_range<ScalarSize>(0, m_face_count, 4096),
+            [&](const tbb::blocked_range<ScalarSize> &range) {
+                for (ScalarSize i = range.begin(); i != range.end(); ++i) {
+                    auto fi = face_indices(i);
+                    Assert(fi[0] < m_vertex_count &&
+                           fi[1] < m_vertex_count &&
+                           fi[2] < m_vertex_count);
+
+                    InputPoint3f v[3] = { vertex_position(fi[0]),
+                                          vertex_position(fi[1]),
+                                          vertex_position(fi[2]) };
+
+                    InputVector3f side_0 = v[1] - v[0],
+                                  side_1 = v[2] - v[0];
+                    InputNormal3f n = cross(side_0, side_1);
+                    InputFloat length_sqr = squared_norm(n);
+                    if (likely(length_sqr > 0)) {
+                        n *= rsqrt(length_sqr);
+
+                        // Use Enoki to compute the face angles at the same time
+                        auto side1 = transpose(Array<Packet<InputFloat, 3>, 3>{ side_0, v[2] - v[1], v[0] - v[2] });
+                        auto side2 = transpose(Array<Packet<InputFloat, 3>, 3>{ side_1, v[0] - v[1], v[1] - v[2] });
+                        InputVector3f face_angles = unit_angle(normalize(side1), normalize(side2));
+
+                        for (size_t j = 0; j < 3; ++j)
+                            for (size_t k = 0; k < 3; ++k)
+                                atomic_add(normals[(size_t) fi[j] * 3 + k],
+                                           n[k] * face_angles[j]);
+                    }
+                }
             }
-        }
+        );
 
-        for (ScalarSize i = 0; i < m_vertex_count; i++) {
-            InputNormal3f n = normals[i];
-            InputFloat length = norm(n);
-            if (likely(length != 0.f)) {
-                n /= length;
-            } else {
-                n = InputNormal3f(1, 0, 0); // Choose some bogus value
-                invalid_counter++;
+        tbb::parallel_for(
+            tbb::blocked_range<ScalarSize>(0, m_vertex_count, 16384),
+            [&](const tbb::blocked_range<ScalarSize> &range) {
+                size_t invalid = 0;
+                for (ScalarSize i = range.begin(); i != range.end(); ++i) {
+                    InputNormal3f n(normals[(size_t) i * 3 + 0].load(std::memory_order_relaxed),
+                                    normals[(size_t) i * 3 + 1].load(std::memory_order_relaxed),
+                                    normals[(size_t) i * 3 + 2].load(std::memory_order_relaxed));
+                    InputFloat length = norm(n);
+                    if (likely(length != 0.f)) {
+                        n /= length;
+                    } else {
+                        n = InputNormal3f(1, 0, 0); // Choose some bogus value
+                        invalid++;
+                    }
+
+                    store(m_vertex_normals_buf.data() + 3 * i, n);
+                }
+                invalid_counter += invalid;
             }
-
-            store(m_vertex_normals_buf.data() + 3 * i, n);
-        }
+        );
 
         if (invalid_counter > 0)
             Log(Warn, "\"%s\": computed vertex normals (%i invalid vertices!)",
-                m_name, invalid_counter);
+                m_name, invalid_counter.load());
     } else {
         auto fi = face_indices(arange<UInt32>(m_face_count));
 
@@ -274,16 +642,239 @@ MTS_VARIANT void Mesh<Float, Spectrum>::recompute_vertex_normals() {
         for (size_t i = 0; i < 3; ++i)
             scatter(m_vertex_normals_buf, normals[i], ni + i);
     }
+
+    if (compressed)
+        compress_vertex_normals();
 }
 
 MTS_VARIANT void Mesh<Float, Spectrum>::recompute_bbox() {
     m_bbox.reset();
     for (ScalarSize i = 0; i < m_vertex_count; ++i)
         m_bbox.expand(vertex_position(i));
+
+    if (has_vertex_motion()) {
+        for (ScalarSize i = 0; i < m_vertex_count; ++i)
+            m_bbox.expand(gather<InputPoint3f>(m_vertex_positions_end_buf, i));
+    }
+}
+
+NAMESPACE_BEGIN(detail)
+/// Encode a direction as two signed 16-bit octahedral coordinates
+inline uint32_t encode_octahedral(const Array<float, 3> &v) {
+    float sum = std::abs(v.x()) + std::abs(v.y()) + std::abs(v.z());
+    if (!(sum > 0.f))
+        return 0;
+
+    float x = v.x() / sum, y = v.y() / sum;
+
+    // Fold the lower hemisphere over the diagonals
+    if (v.z() < 0.f) {
+        float x_folded = (1.f - std::abs(y)) * (x >= 0.f ? 1.f : -1.f);
+        y = (1.f - std::abs(x)) * (y >= 0.f ? 1.f : -1.f);
+        x = x_folded;
+    }
+
+    auto quantize = [](float value) {
+        value = std::min(std::max(value, -1.f), 1.f);
+        return (uint32_t) (std::lround(value * 32767.f) & 0xFFFF);
+    };
+
+    return quantize(x) | (quantize(y) << 16);
+}
+NAMESPACE_END(detail)
+
+MTS_VARIANT bool Mesh<Float, Spectrum>::has_compressed_vertex_data() const {
+    if (slices(m_vertex_normals_oct_buf) != 0 || slices(m_vertex_texcoords_q_buf) != 0 ||
+        slices(m_faces_u16_buf) != 0)
+        return true;
+    for (const auto &[name, attribute] : m_mesh_attributes)
+        if (slices(attribute.half_buf) != 0)
+            return true;
+    return false;
+}
+
+MTS_VARIANT void Mesh<Float, Spectrum>::compress_vertex_data() {
+    if constexpr (is_cuda_array_v<Float>) {
+        Log(Warn, "\"%s\": compressed vertex data is not supported in GPU variants, "
+                  "ignoring.", m_name);
+    } else {
+        Timer timer;
+        size_t size_before = vertex_data_bytes() * m_vertex_count +
+                             face_data_bytes() * m_face_count;
+
+        if (slices(m_vertex_normals_buf) != 0)
+            compress_vertex_normals();
+
+        // Quantize the texture coordinates relative to their bounding box
+        if (slices(m_vertex_texcoords_buf) != 0) {
+            const InputFloat *uv_ptr = m_vertex_texcoords_buf.data();
+            InputPoint2f uv_min(math::Infinity<InputFloat>),
+                         uv_max(-math::Infinity<InputFloat>);
+            for (ScalarSize i = 0; i < m_vertex_count; ++i) {
+                InputPoint2f uv = load_unaligned<InputPoint2f>(uv_ptr + 2 * i);
+                uv_min = min(uv_min, uv);
+                uv_max = max(uv_max, uv);
+            }
+
+            InputVector2f extent = uv_max - uv_min,
+                          inv_scale = select(extent > 0.f, 65535.f / extent, 0.f);
+            m_texcoord_offset = uv_min;
+            m_texcoord_scale  = extent * (1.f / 65535.f);
+
+            m_vertex_texcoords_q_buf = empty<DynamicBuffer<UInt32>>(m_vertex_count);
+            uint32_t *q_ptr = m_vertex_texcoords_q_buf.data();
+            for (ScalarSize i = 0; i < m_vertex_count; ++i) {
+                InputVector2f t =
+                    (load_unaligned<InputPoint2f>(uv_ptr + 2 * i) - uv_min) * inv_scale;
+                q_ptr[i] = (uint32_t) std::lround(t.x()) |
+                           ((uint32_t) std::lround(t.y()) << 16);
+            }
+            m_vertex_texcoords_buf = FloatStorage();
+        }
+
+        // Store the attributes as pairs of half precision values
+        for (auto &[name, attribute] : m_mesh_attributes) {
+            size_t count = slices(attribute.buf);
+            if (count == 0)
+                continue;
+
+            const InputFloat *src = attribute.buf.data();
+            attribute.half_buf = zero<DynamicBuffer<UInt32>>((count + 1) / 2);
+            uint32_t *dst = attribute.half_buf.data();
+            for (size_t i = 0; i < count; ++i)
+                dst[i / 2] |= (uint32_t) enoki::half::float32_to_float16(src[i])
+                              << (16 * (i % 2));
+            attribute.buf = FloatStorage();
+        }
+
+#if !defined(MTS_ENABLE_EMBREE)
+        // Use 16-bit face indices when they can address all vertices
+        if (m_vertex_count <= 0x10000 && slices(m_faces_buf) != 0) {
+            size_t count = (size_t) m_face_count * 3;
+            const ScalarIndex *src = m_faces_buf.data();
+            m_faces_u16_buf = zero<DynamicBuffer<UInt32>>((count + 1) / 2);
+            uint32_t *dst = m_faces_u16_buf.data();
+            for (size_t i = 0; i < count; ++i)
+                dst[i / 2] |= src[i] << (16 * (i % 2));
+            m_faces_buf = DynamicBuffer<UInt32>();
+        }
+#endif
+
+        update_memory_record();
+
+        Log(Debug, "\"%s\": compressed vertex data from %s to %s (took %s)", m_name,
+            util::mem_string(size_before),
+            util::mem_string(vertex_data_bytes() * m_vertex_count +
+                             face_data_bytes() * m_face_count),
+            util::time_string(timer.value()));
+    }
+}
+
+MTS_VARIANT void Mesh<Float, Spectrum>::sort_spatially() {
+    if constexpr (is_cuda_array_v<Float>) {
+        Throw("sort_spatially(): not supported in GPU variants!");
+    } else {
+        if (has_compressed_vertex_data())
+            Throw("sort_spatially(): the mesh \"%s\" has compressed vertex data!", m_name);
+
+        Timer timer;
+
+        // Morton codes of the face centroids on a 1024^3 grid
+        ScalarVector3f scale =
+            1023.f / max(m_bbox.extents(), math::Epsilon<ScalarFloat>);
+        std::vector<std::pair<uint32_t, ScalarIndex>> keys(m_face_count);
+        tbb::parallel_for(
+            tbb::blocked_range<ScalarSize>(0, m_face_count, 16384),
+            [&](const tbb::blocked_range<ScalarSize> &range) {
+                for (ScalarSize i = range.begin(); i != range.end(); ++i) {
+                    auto fi = face_indices(i);
+                    ScalarPoint3f c(vertex_position(fi[0]) + vertex_position(fi[1]) +
+                                    vertex_position(fi[2]));
+                    ScalarVector3f cell =
+                        clamp((c * (1.f / 3.f) - m_bbox.min) * scale, 0.f, 1023.f);
+                    keys[i] = { enoki::morton_encode(ScalarVector3u(cell)), i };
+                }
+            }
+        );
+        std::sort(keys.begin(), keys.end());
+
+        std::vector<ScalarIndex> face_order(m_face_count), vertex_order,
+                                 vertex_map(m_vertex_count, (ScalarIndex) -1);
+        vertex_order.reserve(m_vertex_count);
+
+        // Renumber the vertices in the order of their first use
+        DynamicBuffer<UInt32> faces = empty<DynamicBuffer<UInt32>>(m_face_count * 3);
+        ScalarIndex *faces_ptr = faces.data();
+        for (ScalarSize i = 0; i < m_face_count; ++i) {
+            face_order[i] = keys[i].second;
+            auto fi = face_indices(face_order[i]);
+            for (size_t j = 0; j < 3; ++j) {
+                ScalarIndex &index = vertex_map[fi[j]];
+                if (index == (ScalarIndex) -1) {
+                    index = (ScalarIndex) vertex_order.size();
+                    vertex_order.push_back(fi[j]);
+                }
+                faces_ptr[i * 3 + j] = index;
+            }
+        }
+
+        // Unreferenced vertices go last
+        for (ScalarSize i = 0; i < m_vertex_count; ++i) {
+            if (vertex_map[i] == (ScalarIndex) -1) {
+                vertex_map[i] = (ScalarIndex) vertex_order.size();
+                vertex_order.push_back(i);
+            }
+        }
+
+        auto permute = [](FloatStorage &buf, size_t dim,
+                          const std::vector<ScalarIndex> &order) {
+            if (slices(buf) == 0)
+                return;
+            FloatStorage result = empty<FloatStorage>(order.size() * dim);
+            const InputFloat *src = buf.data();
+            InputFloat *dst = result.data();
+            for (size_t i = 0; i < order.size(); ++i)
+                memcpy(dst + i * dim, src + (size_t) order[i] * dim,
+                       dim * sizeof(InputFloat));
+            result.managed();
+            buf = std::move(result);
+        };
+
+        permute(m_vertex_positions_buf, 3, vertex_order);
+        permute(m_vertex_positions_end_buf, 3, vertex_order);
+        permute(m_vertex_normals_buf, 3, vertex_order);
+        permute(m_vertex_texcoords_buf, 2, vertex_order);
+        for (auto &[name, attribute] : m_mesh_attributes)
+            permute(attribute.buf, attribute.size,
+                    attribute.type == MeshAttributeType::Face ? face_order
+                                                              : vertex_order);
+
+        faces.managed();
+        m_faces_buf = std::move(faces);
+
+        // The area PMF and the parameterization refer to the old face order
+        m_area_pmf = DiscreteDistribution<Float>();
+        m_parameterization = nullptr;
+
+        Log(Debug, "\"%s\": sorted %i faces spatially (took %s)", m_name, m_face_count,
+            util::time_string(timer.value()));
+    }
+}
+
+MTS_VARIANT void Mesh<Float, Spectrum>::compress_vertex_normals() {
+    if constexpr (!is_cuda_array_v<Float>) {
+        const InputFloat *normal_ptr = m_vertex_normals_buf.data();
+        m_vertex_normals_oct_buf = empty<DynamicBuffer<UInt32>>(m_vertex_count);
+        uint32_t *oct_ptr = m_vertex_normals_oct_buf.data();
+        for (ScalarSize i = 0; i < m_vertex_count; ++i)
+            oct_ptr[i] = detail::encode_octahedral(
+                load_unaligned<InputNormal3f>(normal_ptr + 3 * i));
+        m_vertex_normals_buf = FloatStorage();
+    }
 }
 
 MTS_VARIANT void Mesh<Float, Spectrum>::build_pmf() {
-    std::lock_guard<tbb::spin_mutex> lock(m_mutex);
+    std::unique_lock<tbb::spin_mutex> lock(m_mutex);
 
     if (!m_area_pmf.empty())
         return; // already built!
@@ -293,21 +884,104 @@ MTS_VARIANT void Mesh<Float, Spectrum>::build_pmf() {
 
     // TODO could use manage() as area_pmf doesn't need to be differentiable
     if constexpr (!is_dynamic_v<Float>) {
-        std::vector<ScalarFloat> table(m_face_count);
-        for (ScalarIndex i = 0; i < m_face_count; i++)
-            table[i] = face_area(i);
+        using PMFStorage = typename DiscreteDistribution<Float>::FloatStorage;
+        using ScalarVector2u = typename DiscreteDistribution<Float>::ScalarVector2u;
+
+        /* Release the lock while building the table: the parallel loops below
+           may execute other tasks on this thread that also request it */
+        lock.unlock();
+
+        /* Compute the face areas and the CDF in parallel: the first pass sums
+           up the areas of fixed-size blocks of faces, and the second one
+           accumulates them within each block starting from the prefix sum of
+           the preceding blocks. The fixed block size keeps the result
+           independent of the number of threads. */
+        const size_t block_size  = 16384,
+                     block_count = ((size_t) m_face_count + block_size - 1) / block_size;
+
+        PMFStorage pmf = empty<PMFStorage>(m_face_count),
+                   cdf = empty<PMFStorage>(m_face_count);
+        ScalarFloat *pmf_ptr = pmf.data(),
+                    *cdf_ptr = cdf.data();
+
+        std::vector<double> block_sum(block_count);
+        std::vector<ScalarVector2u> block_valid(block_count);
+
+        auto for_each_block = [&](auto func) {
+            tbb::parallel_for(
+                tbb::blocked_range<size_t>(0, block_count, 1),
+                [&](const tbb::blocked_range<size_t> &range) {
+                    for (size_t b = range.begin(); b != range.end(); ++b)
+                        func(b, b * block_size,
+                             std::min(b * block_size + block_size, (size_t) m_face_count));
+                }
+            );
+        };
 
-        m_area_pmf = DiscreteDistribution<Float>(
-            table.data(),
-            m_face_count
-        );
+        for_each_block([&](size_t b, size_t start, size_t end) {
+            double sum = 0.0;
+            for (size_t i = start; i < end; ++i) {
+                ScalarFloat area = face_area((ScalarIndex) i);
+                pmf_ptr[i] = area;
+                sum += (double) area;
+            }
+            block_sum[b] = sum;
+        });
+
+        double sum = 0.0;
+        for (size_t b = 0; b < block_count; ++b) {
+            double block_start = sum;
+            sum += block_sum[b];
+            block_sum[b] = block_start;
+        }
+
+        for_each_block([&](size_t b, size_t start, size_t end) {
+            double partial = block_sum[b];
+            ScalarVector2u valid((uint32_t) -1);
+            for (size_t i = start; i < end; ++i) {
+                ScalarFloat area = pmf_ptr[i];
+                partial += (double) area;
+                cdf_ptr[i] = (ScalarFloat) partial;
+                if (area > 0.f) {
+                    if (valid.x() == (uint32_t) -1)
+                        valid.x() = (uint32_t) i;
+                    valid.y() = (uint32_t) i;
+                }
+            }
+            block_valid[b] = valid;
+        });
+
+        ScalarVector2u valid((uint32_t) -1);
+        for (size_t b = 0; b < block_count; ++b) {
+            if (block_valid[b].x() == (uint32_t) -1)
+                continue;
+            if (valid.x() == (uint32_t) -1)
+                valid.x() = block_valid[b].x();
+            valid.y() = block_valid[b].y();
+        }
+
+        if (valid.x() == (uint32_t) -1)
+            Throw("Cannot create sampling table for a mesh without surface area: %s",
+                  to_string());
+
+        // Constant-time sampling for meshes with many faces
+        DiscreteDistribution<Float> area_pmf(
+            std::move(pmf), std::move(cdf), (ScalarFloat) sum,
+            (ScalarFloat) (1.0 / sum), valid);
+        area_pmf.build_alias_table();
+
+        lock.lock();
+        if (m_area_pmf.empty())
+            m_area_pmf = std::move(area_pmf);
     } else {
         Float table = face_area(arange<UInt32>(m_face_count)).managed();
 
-        m_area_pmf = DiscreteDistribution<Float>(
+        DiscreteDistribution<Float> area_pmf(
             table.data(),
             m_face_count
         );
+        area_pmf.build_alias_table();
+        m_area_pmf = std::move(area_pmf);
     }
 }
 
@@ -324,6 +998,7 @@ MTS_VARIANT void Mesh<Float, Spectrum>::build_parameterization() {
         new Mesh(m_name + "_param", m_vertex_count, m_face_count,
                  props, false, false);
     mesh->m_faces_buf = m_faces_buf;
+    mesh->m_faces_u16_buf = m_faces_u16_buf;
 
     ScalarFloat *pos_out = (ScalarFloat *) mesh->m_vertex_positions_buf.data();
     for (size_t i = 0; i < m_vertex_count; ++i) {
@@ -349,6 +1024,50 @@ Mesh<Float, Spectrum>::surface_area() const {
     return m_area_pmf.sum();
 }
 
+MTS_VARIANT std::pair<typename Mesh<Float, Spectrum>::ScalarVector3f,
+                      typename Mesh<Float, Spectrum>::ScalarFloat>
+Mesh<Float, Spectrum>::normal_cone() const {
+    // Unnormalized face normals, whose norm is twice the area of the faces
+    std::vector<ScalarVector3f> normals(m_face_count);
+    if constexpr (is_cuda_array_v<Float>) {
+        auto fi = face_indices(arange<UInt32>(m_face_count));
+        auto p0 = vertex_position(fi[0]),
+             p1 = vertex_position(fi[1]),
+             p2 = vertex_position(fi[2]);
+        auto n = cross(p1 - p0, p2 - p0);
+        for (size_t k = 0; k < 3; ++k) {
+            Float values = n[k].managed();
+            for (size_t i = 0; i < m_face_count; ++i)
+                normals[i][k] = values.data()[i];
+        }
+    } else {
+        for (size_t i = 0; i < m_face_count; ++i) {
+            auto fi = face_indices((ScalarIndex) i);
+            ScalarPoint3f p0 = vertex_position(fi[0]),
+                          p1 = vertex_position(fi[1]),
+                          p2 = vertex_position(fi[2]);
+            normals[i] = cross(p1 - p0, p2 - p0);
+        }
+    }
+
+    // The axis is the area-weighted mean normal, and the angle covers all faces
+    ScalarVector3f sum(0.f);
+    for (const ScalarVector3f &n : normals)
+        sum += n;
+    ScalarFloat length = norm(sum);
+    if (!(length > 0.f))
+        return Base::normal_cone();
+
+    ScalarVector3f axis = sum / length;
+    ScalarFloat cos_theta = 1.f;
+    for (const ScalarVector3f &n : normals) {
+        ScalarFloat n_length = norm(n);
+        if (n_length > 0.f)
+            cos_theta = std::min(cos_theta, dot(axis, n) / n_length);
+    }
+    return { axis, std::max(cos_theta, -1.f) };
+}
+
 MTS_VARIANT typename Mesh<Float, Spectrum>::PositionSample3f
 Mesh<Float, Spectrum>::sample_position(Float time, const Point2f &sample_, Mask active) const {
     ensure_pmf_built();
@@ -360,9 +1079,9 @@ Mesh<Float, Spectrum>::sample_position(Float time, const Point2f &sample_, Mask
 
     Array<Index, 3> fi = face_indices(face_idx, active);
 
-    Point3f p0 = vertex_position(fi[0], active),
-            p1 = vertex_position(fi[1], active),
-            p2 = vertex_position(fi[2], active);
+    Point3f p0 = vertex_position_at(fi[0], time, active),
+            p1 = vertex_position_at(fi[1], time, active),
+            p2 = vertex_position_at(fi[2], time, active);
 
     Vector3f e0 = p1 - p0, e1 = p2 - p0;
     Point2f b = warp::square_to_uniform_triangle(sample);
@@ -422,11 +1141,16 @@ MTS_VARIANT Float Mesh<Float, Spectrum>::pdf_position(const PositionSample3f &,
 MTS_VARIANT typename Mesh<Float, Spectrum>::Point3f
 Mesh<Float, Spectrum>::barycentric_coordinates(const SurfaceInteraction3f &si,
                                                Mask active) const {
-    auto fi = face_indices(si.prim_index, active);
+    return barycentric_coordinates(si, face_indices(si.prim_index, active), active);
+}
 
-    Point3f p0 = vertex_position(fi[0], active),
-            p1 = vertex_position(fi[1], active),
-            p2 = vertex_position(fi[2], active);
+MTS_VARIANT typename Mesh<Float, Spectrum>::Point3f
+Mesh<Float, Spectrum>::barycentric_coordinates(const SurfaceInteraction3f &si,
+                                               const Vector3u &fi,
+                                               Mask active) const {
+    Point3f p0 = vertex_position_at(fi[0], si.time, active),
+            p1 = vertex_position_at(fi[1], si.time, active),
+            p2 = vertex_position_at(fi[2], si.time, active);
 
     Vector3f rel = si.p - p0,
              du  = p1 - p0,
@@ -456,6 +1180,7 @@ Mesh<Float, Spectrum>::compute_surface_interaction(const Ray3f &ray,
     bool differentiable = false;
     if constexpr (is_diff_array_v<Float>)
         differentiable = requires_gradient(m_vertex_positions_buf) ||
+                         requires_gradient(m_vertex_positions_end_buf) ||
                          requires_gradient(ray.o) || requires_gradient(ray.d);
 
     // Recompute ray intersection to get differentiable prim_uv and t
@@ -470,9 +1195,9 @@ Mesh<Float, Spectrum>::compute_surface_interaction(const Ray3f &ray,
 
     auto fi = face_indices(pi.prim_index, active);
 
-    Point3f p0 = vertex_position(fi[0], active),
-            p1 = vertex_position(fi[1], active),
-            p2 = vertex_position(fi[2], active);
+    Point3f p0 = vertex_position_at(fi[0], ray.time, active),
+            p1 = vertex_position_at(fi[1], ray.time, active),
+            p2 = vertex_position_at(fi[2], ray.time, active);
 
     Vector3f dp0 = p1 - p0,
              dp1 = p2 - p0;
@@ -544,9 +1269,8 @@ Mesh<Float, Spectrum>::compute_surface_interaction(const Ray3f &ray,
     return si;
 }
 
-MTS_VARIANT void Mesh<Float, Spectrum>::add_attribute(const std::string& name,
-                                                      size_t dim,
-                                                      const FloatStorage& buffer) {
+MTS_VARIANT typename Mesh<Float, Spectrum>::MeshAttributeType
+Mesh<Float, Spectrum>::check_attribute(const std::string &name, size_t dim) const {
     auto attribute = m_mesh_attributes.find(name);
     if (attribute != m_mesh_attributes.end())
         Throw("add_attribute(): attribute %s already exists.", name.c_str());
@@ -556,7 +1280,17 @@ MTS_VARIANT void Mesh<Float, Spectrum>::add_attribute(const std::string& name,
     if (!is_vertex_attr && !is_face_attr)
         Throw("add_attribute(): attribute name must start with either \"vertex_\" of \"face_\".");
 
-    MeshAttributeType type = is_vertex_attr ? MeshAttributeType::Vertex : MeshAttributeType::Face;
+    if (dim == 0)
+        Throw("add_attribute(): attribute %s must have at least one channel.", name.c_str());
+
+    return is_vertex_attr ? MeshAttributeType::Vertex : MeshAttributeType::Face;
+}
+
+MTS_VARIANT void Mesh<Float, Spectrum>::add_attribute(const std::string& name,
+                                                      size_t dim,
+                                                      const FloatStorage& buffer) {
+    MeshAttributeType type = check_attribute(name, dim);
+    bool is_vertex_attr = type == MeshAttributeType::Vertex;
 
     // In spectral modes, convert RGB color to srgb model coefs if attribute name contains 'color'
     if constexpr (is_spectral_v<Spectrum>) {
@@ -570,22 +1304,31 @@ MTS_VARIANT void Mesh<Float, Spectrum>::add_attribute(const std::string& name,
         }
     }
 
-    m_mesh_attributes.insert({ name, { dim, type, buffer } });
+    m_mesh_attributes.insert({ name, { dim, type, buffer, {} } });
+    update_memory_record();
 }
 
-MTS_VARIANT typename Mesh<Float, Spectrum>::UnpolarizedSpectrum
-Mesh<Float, Spectrum>::eval_attribute(const std::string& name,
-                                      const SurfaceInteraction3f &si,
-                                      Mask active) const {
+MTS_VARIANT const typename Mesh<Float, Spectrum>::MeshAttribute &
+Mesh<Float, Spectrum>::attribute(const std::string &name, size_t size,
+                                 const char *caller) const {
     const auto& it = m_mesh_attributes.find(name);
     if (it == m_mesh_attributes.end())
         Throw("Invalid attribute requested %s.", name.c_str());
+    if (size != 0 && it->second.size != size)
+        Throw("%s(): Attribute \"%s\" requested but had size %u.", caller, name,
+              it->second.size);
+    return it->second;
+}
 
-    const auto& attr = it->second;
+MTS_VARIANT typename Mesh<Float, Spectrum>::UnpolarizedSpectrum
+Mesh<Float, Spectrum>::eval_attribute(const std::string& name,
+                                      const SurfaceInteraction3f &si,
+                                      Mask active) const {
+    const auto& attr = attribute(name, 0, "eval_attribute");
     if (attr.size == 1)
-        return interpolate_attribute<1, false>(attr.type, attr.buf, si, active);
+        return interpolate_attribute<1, false>(attr, si, active);
     else if (attr.size == 3) {
-        auto result = interpolate_attribute<3, false>(attr.type, attr.buf, si, active);
+        auto result = interpolate_attribute<3, false>(attr, si, active);
         if constexpr (is_monochromatic_v<Spectrum>)
             return luminance(result);
         else
@@ -599,30 +1342,55 @@ MTS_VARIANT Float
 Mesh<Float, Spectrum>::eval_attribute_1(const std::string& name,
                                         const SurfaceInteraction3f &si,
                                         Mask active) const {
-    const auto& it = m_mesh_attributes.find(name);
-    if (it == m_mesh_attributes.end())
-        Throw("Invalid attribute requested %s.", name.c_str());
-
-    const auto& attr = it->second;
-    if (attr.size == 1)
-        return interpolate_attribute<1, true>(attr.type, attr.buf, si, active);
-    else
-        Throw("eval_attribute_1(): Attribute \"%s\" requested but had size %u.", name, attr.size);
+    return interpolate_attribute<1, true>(attribute(name, 1, "eval_attribute_1"), si, active);
 }
 
 MTS_VARIANT typename Mesh<Float, Spectrum>::Color3f
 Mesh<Float, Spectrum>::eval_attribute_3(const std::string& name,
                                         const SurfaceInteraction3f &si,
                                         Mask active) const {
-    const auto& it = m_mesh_attributes.find(name);
-    if (it == m_mesh_attributes.end())
-        Throw("Invalid attribute requested %s.", name.c_str());
+    return interpolate_attribute<3, true>(attribute(name, 3, "eval_attribute_3"), si, active);
+}
+
+MTS_VARIANT template <uint32_t Size, typename Result>
+std::vector<Result>
+Mesh<Float, Spectrum>::eval_attributes(const std::vector<std::string> &names,
+                                       const SurfaceInteraction3f &si, Mask active,
+                                       const char *caller) const {
+    std::vector<const MeshAttribute *> attributes(names.size());
+    bool has_vertex_attributes = false;
+    for (size_t i = 0; i < names.size(); ++i) {
+        attributes[i] = &attribute(names[i], Size, caller);
+        has_vertex_attributes |= attributes[i]->type == MeshAttributeType::Vertex;
+    }
+
+    // Fetch the triangle once for all vertex attributes
+    Vector3u fi;
+    Point3f b;
+    if (has_vertex_attributes) {
+        fi = face_indices(si.prim_index, active);
+        b = barycentric_coordinates(si, fi, active);
+    }
+
+    std::vector<Result> result;
+    result.reserve(names.size());
+    for (const MeshAttribute *attr : attributes)
+        result.push_back(interpolate_attribute<Size, true>(*attr, si, fi, b, active));
+    return result;
+}
+
+MTS_VARIANT std::vector<Float>
+Mesh<Float, Spectrum>::eval_attributes_1(const std::vector<std::string> &names,
+                                         const SurfaceInteraction3f &si,
+                                         Mask active) const {
+    return eval_attributes<1, Float>(names, si, active, "eval_attributes_1");
+}
 
-    const auto& attr = it->second;
-    if (attr.size == 3) {
-        return interpolate_attribute<3, true>(attr.type, attr.buf, si, active);
-    } else
-        Throw("eval_attribute_3(): Attribute \"%s\" requested but had size %u.", name, attr.size);
+MTS_VARIANT std::vector<typename Mesh<Float, Spectrum>::Color3f>
+Mesh<Float, Spectrum>::eval_attributes_3(const std::vector<std::string> &names,
+                                         const SurfaceInteraction3f &si,
+                                         Mask active) const {
+    return eval_attributes<3, Color3f>(names, si, active, "eval_attributes_3");
 }
 
 namespace {
@@ -682,6 +1450,13 @@ MTS_VARIANT typename Mesh<Float, Spectrum>::ScalarBoundingBox3f
 Mesh<Float, Spectrum>::bbox(ScalarIndex index, const ScalarBoundingBox3f &clip) const {
     using ScalarPoint3d = mitsuba::Point<double, 3>;
 
+    // Clip the bounds of the swept triangle when the vertices move
+    if (has_vertex_motion()) {
+        ScalarBoundingBox3f result = bbox(index);
+        result.clip(clip);
+        return result;
+    }
+
     // Reserve room for some additional vertices
     ScalarPoint3d vertices1[max_vertices], vertices2[max_vertices];
     size_t n_vertices = 3;
@@ -760,32 +1535,48 @@ MTS_VARIANT std::string Mesh<Float, Spectrum>::to_string() const {
 MTS_VARIANT size_t Mesh<Float, Spectrum>::vertex_data_bytes() const {
     size_t vertex_data_bytes = 3 * sizeof(InputFloat);
 
-    if (has_vertex_normals())
+    if (slices(m_vertex_normals_oct_buf) != 0)
+        vertex_data_bytes += sizeof(uint32_t);
+    else if (has_vertex_normals())
         vertex_data_bytes += 3 * sizeof(InputFloat);
-    if (has_vertex_texcoords())
+    if (slices(m_vertex_texcoords_q_buf) != 0)
+        vertex_data_bytes += sizeof(uint32_t);
+    else if (has_vertex_texcoords())
         vertex_data_bytes += 2 * sizeof(InputFloat);
 
     for (const auto&[name, attribute]: m_mesh_attributes)
         if (attribute.type == MeshAttributeType::Vertex)
-            vertex_data_bytes += attribute.size * sizeof(InputFloat);
+            vertex_data_bytes += attribute.size *
+                (slices(attribute.half_buf) != 0 ? sizeof(uint16_t) : sizeof(InputFloat));
 
     return vertex_data_bytes;
 }
 
 MTS_VARIANT size_t Mesh<Float, Spectrum>::face_data_bytes() const {
-    size_t face_data_bytes = 3 * sizeof(ScalarIndex);
+    size_t face_data_bytes =
+        3 * (slices(m_faces_u16_buf) != 0 ? sizeof(uint16_t) : sizeof(ScalarIndex));
 
     for (const auto&[name, attribute]: m_mesh_attributes)
         if (attribute.type == MeshAttributeType::Face)
-            face_data_bytes += attribute.size * sizeof(InputFloat);
+            face_data_bytes += attribute.size *
+                (slices(attribute.half_buf) != 0 ? sizeof(uint16_t) : sizeof(InputFloat));
 
     return face_data_bytes;
 }
 
 #if defined(MTS_ENABLE_EMBREE)
 MTS_VARIANT RTCGeometry Mesh<Float, Spectrum>::embree_geometry(RTCDevice device) {
+    if (has_vertex_motion())
+        Log(Warn, "\"%s\": vertex motion is not supported by Embree and will "
+                  "be ignored.", m_name);
     RTCGeometry geom = rtcNewGeometry(device, RTC_GEOMETRY_TYPE_TRIANGLE);
+    rtcSetGeometryBuildQuality(geom, m_accel_refit ? RTC_BUILD_QUALITY_REFIT
+                                                   : RTC_BUILD_QUALITY_MEDIUM);
+    embree_update_geometry(geom);
+    return geom;
+}
 
+MTS_VARIANT void Mesh<Float, Spectrum>::embree_update_geometry(RTCGeometry geom) {
     rtcSetSharedGeometryBuffer(geom, RTC_BUFFER_TYPE_VERTEX, 0, RTC_FORMAT_FLOAT3,
                                m_vertex_positions_buf.data(), 0, 3 * sizeof(InputFloat),
                                m_vertex_count);
@@ -794,7 +1585,6 @@ MTS_VARIANT RTCGeometry Mesh<Float, Spectrum>::embree_geometry(RTCDevice device)
                                m_face_count);
 
     rtcCommitGeometry(geom);
-    return geom;
 }
 #endif
 
@@ -803,6 +1593,10 @@ static const uint32_t triangle_input_flags =  OPTIX_GEOMETRY_FLAG_DISABLE_ANYHIT
 
 MTS_VARIANT void Mesh<Float, Spectrum>::optix_prepare_geometry() {
     if constexpr (is_cuda_array_v<Float>) {
+        if (has_vertex_motion())
+            Log(Warn, "\"%s\": vertex motion is not supported by OptiX and will "
+                      "be ignored.", m_name);
+
         m_vertex_buffer_ptr = (void*) m_vertex_positions_buf.data();
 
         if (!m_optix_data_ptr)
@@ -837,19 +1631,30 @@ MTS_VARIANT void Mesh<Float, Spectrum>::traverse(TraversalCallback *callback) {
 
     callback->put_parameter("vertex_count",         m_vertex_count);
     callback->put_parameter("face_count",           m_face_count);
-    callback->put_parameter("faces_buf",            m_faces_buf);
+    if (slices(m_faces_u16_buf) == 0)
+        callback->put_parameter("faces_buf", m_faces_buf);
     callback->put_parameter("vertex_positions_buf", m_vertex_positions_buf);
-    callback->put_parameter("vertex_normals_buf",   m_vertex_normals_buf);
-    callback->put_parameter("vertex_texcoords_buf", m_vertex_texcoords_buf);
+    if (has_vertex_motion())
+        callback->put_parameter("vertex_positions_end_buf", m_vertex_positions_end_buf);
+
+    // Compressed vertex data is not exposed
+    if (slices(m_vertex_normals_oct_buf) == 0)
+        callback->put_parameter("vertex_normals_buf", m_vertex_normals_buf);
+    if (slices(m_vertex_texcoords_q_buf) == 0)
+        callback->put_parameter("vertex_texcoords_buf", m_vertex_texcoords_buf);
 
     for(auto &[name, attribute]: m_mesh_attributes)
-        callback->put_parameter(tfm::format("%s_buf", name.c_str()), attribute.buf);
+        if (slices(attribute.half_buf) == 0)
+            callback->put_parameter(tfm::format("%s_buf", name.c_str()), attribute.buf);
 }
 
 MTS_VARIANT void Mesh<Float, Spectrum>::parameters_changed(const std::vector<std::string> &keys) {
-    if (keys.empty() || string::contains(keys, "vertex_positions_buf")) {
+    if (keys.empty() || string::contains(keys, "vertex_positions_buf") ||
+        string::contains(keys, "vertex_positions_end_buf") ||
+        string::contains(keys, "faces_buf")) {
         if constexpr (is_cuda_array_v<Float>) {
             m_vertex_positions_buf.managed();
+            m_vertex_positions_end_buf.managed();
             cuda_eval();
             cuda_sync();
         }
@@ -870,12 +1675,23 @@ MTS_VARIANT void Mesh<Float, Spectrum>::parameters_changed(const std::vector<std
 #endif
 
         Base::parameters_changed();
+    } else {
+#if defined(MTS_ENABLE_OPTIX)
+        // The attribute buffers may have been reallocated
+        if (string::contains(keys, "vertex_normals_buf") ||
+            string::contains(keys, "vertex_texcoords_buf"))
+            optix_prepare_geometry();
+#endif
+
+        // Attributes do not affect the acceleration data structure
+        Base::parameters_changed(keys);
     }
 }
 
 MTS_VARIANT bool Mesh<Float, Spectrum>::parameters_grad_enabled() const {
     if constexpr (is_diff_array_v<Float>) {
         return requires_gradient(m_vertex_positions_buf) ||
+               requires_gradient(m_vertex_positions_end_buf) ||
                requires_gradient(m_vertex_normals_buf) ||
                requires_gradient(m_vertex_texcoords_buf);
     }
@@ -9,22 +9,27 @@
 extern "C" __global__ void __raygen__rg() {
     unsigned int launch_index = calculate_launch_index();
 
-    Vector3f ro = Vector3f(params.in_o[0][launch_index],
-                           params.in_o[1][launch_index],
-                           params.in_o[2][launch_index]),
-             rd = Vector3f(params.in_d[0][launch_index],
-                           params.in_d[1][launch_index],
-                           params.in_d[2][launch_index]);
-    float mint = params.in_mint[launch_index],
-          maxt = params.in_maxt[launch_index];
+    /* Shadow rays read their inputs from separate data pointers, starting at
+       \c shadow_offset, so that a single launch can trace the continuation
+       rays and the shadow rays of a bounce together */
+    bool ray_test = params.is_ray_test(launch_index);
+    unsigned int index = ray_test ? launch_index - params.shadow_offset : launch_index;
+    bool *in_mask = ray_test ? params.in_shadow_mask : params.in_mask;
+    float **in_o  = ray_test ? params.in_shadow_o : params.in_o,
+          **in_d  = ray_test ? params.in_shadow_d : params.in_d;
+
+    Vector3f ro = Vector3f(in_o[0][index], in_o[1][index], in_o[2][index]),
+             rd = Vector3f(in_d[0][index], in_d[1][index], in_d[2][index]);
+    float mint = ray_test ? params.in_shadow_mint[index] : params.in_mint[index],
+          maxt = ray_test ? params.in_shadow_maxt[index] : params.in_maxt[index];
 
     // Replace inf with very large float value as it isn't supported by Optix
     if (maxt == CUDART_INF_F)
         maxt = CUDART_MAX_NORMAL_F;
 
-    if (params.is_ray_test()) {
-        if (!params.in_mask[launch_index]) {
-            params.out_hit[launch_index] = false;
+    if (ray_test) {
+        if (!in_mask[index]) {
+            write_output_hit_params(params, launch_index, false);
         } else {
             optixTrace(
                 params.handle,
@@ -36,7 +41,7 @@ extern "C" __global__ void __raygen__rg() {
                 );
         }
     } else {
-        if (!params.in_mask[launch_index]) {
+        if (!in_mask[index]) {
             params.out_shape_ptr[launch_index] = 0;
             params.out_t[launch_index] = CUDART_INF_F;
         } else {
@@ -55,8 +60,8 @@ extern "C" __global__ void __raygen__rg() {
 extern "C" __global__ void __miss__ms() {
     unsigned int launch_index = calculate_launch_index();
 
-    if (params.is_ray_test()) {
-        params.out_hit[launch_index] = false;
+    if (params.is_ray_test(launch_index)) {
+        write_output_hit_params(params, launch_index, false);
     } else {
         params.out_shape_ptr[launch_index] = 0;
         params.out_t[launch_index] = CUDART_INF_F;
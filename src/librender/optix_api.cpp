@@ -17,6 +17,7 @@
 #include <mitsuba/core/filesystem.h>
 #include <mitsuba/render/optix_api.h>
 #include <mitsuba/render/optix/shapes.h>
+#include <cstdlib>
 
 #if !defined(MTS_USE_OPTIX_HEADERS)
 // Driver API
@@ -24,6 +25,10 @@ const char* (*optixGetErrorName)(OptixResult) = nullptr;
 const char* (*optixGetErrorString)(OptixResult) = nullptr;
 OptixResult (*optixDeviceContextCreate)(CUcontext, const OptixDeviceContextOptions*, OptixDeviceContext*) = nullptr;
 OptixResult (*optixDeviceContextDestroy)(OptixDeviceContext) = nullptr;
+OptixResult (*optixDeviceContextSetCacheEnabled)(OptixDeviceContext, int) = nullptr;
+OptixResult (*optixDeviceContextSetCacheLocation)(OptixDeviceContext, const char*) = nullptr;
+OptixResult (*optixDeviceContextSetCacheDatabaseSizes)(OptixDeviceContext, size_t, size_t) = nullptr;
+OptixResult (*optixDeviceContextGetCacheEnabled)(OptixDeviceContext, int*) = nullptr;
 OptixResult (*optixModuleCreateFromPTX)(OptixDeviceContext, const OptixModuleCompileOptions*, const OptixPipelineCompileOptions*, const char*, size_t, char*, size_t*, OptixModule*) = nullptr;
 OptixResult (*optixModuleDestroy)(OptixModule) = nullptr;
 OptixResult (*optixProgramGroupCreate)(OptixDeviceContext, const OptixProgramGroupDesc*, unsigned int, const OptixProgramGroupOptions*, char*, size_t*, OptixProgramGroup*) = nullptr;
@@ -164,6 +169,10 @@ bool optix_initialize() {
     LOAD(optixGetErrorString, 1);
     LOAD(optixDeviceContextCreate, 2);
     LOAD(optixDeviceContextDestroy, 3);
+    LOAD(optixDeviceContextSetCacheEnabled, 6);
+    LOAD(optixDeviceContextSetCacheLocation, 7);
+    LOAD(optixDeviceContextSetCacheDatabaseSizes, 8);
+    LOAD(optixDeviceContextGetCacheEnabled, 9);
     LOAD(optixModuleCreateFromPTX, 12);
     LOAD(optixModuleDestroy, 13);
     LOAD(optixProgramGroupCreate, 14);
@@ -189,7 +198,9 @@ void optix_shutdown() {
 
     #define Z(x) x = nullptr
     Z(optixGetErrorName); Z(optixGetErrorString); Z(optixDeviceContextCreate);
-    Z(optixDeviceContextDestroy); Z(optixModuleCreateFromPTX); Z(optixModuleDestroy);
+    Z(optixDeviceContextDestroy); Z(optixDeviceContextSetCacheEnabled);
+    Z(optixDeviceContextSetCacheLocation); Z(optixDeviceContextSetCacheDatabaseSizes);
+    Z(optixDeviceContextGetCacheEnabled); Z(optixModuleCreateFromPTX); Z(optixModuleDestroy);
     Z(optixProgramGroupCreate); Z(optixProgramGroupDestroy);
     Z(optixPipelineCreate); Z(optixPipelineDestroy); Z(optixAccelComputeMemoryUsage);
     Z(optixAccelBuild); Z(optixAccelCompact); Z(optixSbtRecordPackHeader);
@@ -210,6 +221,91 @@ void optix_shutdown() {
     optix_init_attempted = false;
 }
 
+/// Default location of a disk cache named \c name (empty if it cannot be determined)
+static fs::path user_cache_path(const char *name) {
+#if defined(_WIN32)
+    const char *base = getenv("LOCALAPPDATA");
+    if (!base || !*base)
+        return fs::path();
+    return fs::path(base) / "mitsuba" / name;
+#else
+    const char *base = getenv("XDG_CACHE_HOME");
+    if (base && *base)
+        return fs::path(base) / "mitsuba" / name;
+    base = getenv("HOME");
+    if (!base || !*base)
+        return fs::path();
+    return fs::path(base) / ".cache" / "mitsuba" / name;
+#endif
+}
+
+/// Set an environment variable of the process
+static bool set_environment(const char *name, const std::string &value) {
+#if defined(_WIN32)
+    return _putenv_s(name, value.c_str()) == 0;
+#else
+    return setenv(name, value.c_str(), 1) == 0;
+#endif
+}
+
+/// Create a directory along with its missing parents
+static bool create_directories(const fs::path &path) {
+    if (path.empty() || fs::is_directory(path))
+        return true;
+    return create_directories(path.parent_path()) && fs::create_directory(path);
+}
+
+void optix_configure_cache(OptixDeviceContext context) {
+    int enabled = 0;
+    if (optixDeviceContextGetCacheEnabled(context, &enabled) != OPTIX_SUCCESS || !enabled) {
+        Log(Debug, "The OptiX disk cache is disabled.");
+        return;
+    }
+
+    if (!getenv("OPTIX_CACHE_PATH")) {
+        fs::path path = user_cache_path("optix");
+        if (path.empty() || !create_directories(path) ||
+            optixDeviceContextSetCacheLocation(context, path.string().c_str()) != OPTIX_SUCCESS) {
+            Log(Warn, "optix_configure_cache(): could not use \"%s\" as the location of the "
+                "OptiX disk cache, keeping the default location.", path.string());
+        } else {
+            Log(Debug, "OptiX disk cache: \"%s\"", path.string());
+        }
+    }
+
+    if (!getenv("OPTIX_CACHE_MAXSIZE")) {
+        // Shrink the cache to half of its size once it exceeds 1 GiB
+        const size_t high_water_mark = (size_t) 1 << 30;
+        if (optixDeviceContextSetCacheDatabaseSizes(context, high_water_mark / 2,
+                                                    high_water_mark) != OPTIX_SUCCESS)
+            Log(Warn, "optix_configure_cache(): could not set the size of the OptiX disk cache.");
+    }
+}
+
+void cuda_configure_cache() {
+    const char *disabled = getenv("CUDA_CACHE_DISABLE");
+    if (disabled && std::string(disabled) == "1") {
+        Log(Debug, "The CUDA compute cache is disabled.");
+        return;
+    }
+
+    if (!getenv("CUDA_CACHE_PATH")) {
+        fs::path path = user_cache_path("cuda");
+        if (path.empty() || !create_directories(path) ||
+            !set_environment("CUDA_CACHE_PATH", path.string())) {
+            Log(Warn, "cuda_configure_cache(): could not use \"%s\" as the location of the "
+                "CUDA compute cache, keeping the default location.", path.string());
+        } else {
+            Log(Debug, "CUDA compute cache: \"%s\"", path.string());
+        }
+    }
+
+    // The size of the cache is limited to 4 GiB by the driver
+    if (!getenv("CUDA_CACHE_MAXSIZE") &&
+        !set_environment("CUDA_CACHE_MAXSIZE", std::to_string((size_t) 1 << 30)))
+        Log(Warn, "cuda_configure_cache(): could not set the size of the CUDA compute cache.");
+}
+
 void __rt_check(OptixResult errval, const char *file, const int line) {
     if (errval != OPTIX_SUCCESS) {
         const char *message = optixGetErrorString(errval);
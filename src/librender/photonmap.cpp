@@ -0,0 +1,133 @@
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <mitsuba/core/math.h>
+#include <mitsuba/render/photonmap.h>
+#include <tbb/blocked_range.h>
+#include <tbb/parallel_for.h>
+
+NAMESPACE_BEGIN(mitsuba)
+
+MTS_VARIANT PhotonMap<Float, Spectrum>::PhotonMap() { }
+
+MTS_VARIANT PhotonMap<Float, Spectrum>::~PhotonMap() { }
+
+MTS_VARIANT uint32_t PhotonMap<Float, Spectrum>::bucket(const Vector<int32_t, 3> &cell) const {
+    uint32_t hash = ((uint32_t) cell.x() * 73856093u) ^
+                    ((uint32_t) cell.y() * 19349663u) ^
+                    ((uint32_t) cell.z() * 83492791u);
+    return hash & m_bucket_mask;
+}
+
+MTS_VARIANT void PhotonMap<Float, Spectrum>::build(std::vector<Photon> &&photons,
+                                                  ScalarFloat radius) {
+    if (!(radius > 0.f))
+        Throw("PhotonMap::build(): the lookup radius must be positive!");
+
+    size_t count = photons.size();
+    if (count > (size_t) std::numeric_limits<uint32_t>::max())
+        Throw("PhotonMap::build(): too many photons (%i)!", count);
+
+    m_radius = radius;
+    m_inv_cell_size = 1.f / (2.f * radius);
+
+    uint32_t bucket_count =
+        math::round_to_power_of_two((uint32_t) std::max(count, (size_t) 1));
+    m_bucket_mask = bucket_count - 1;
+
+    // 1. Count the photons of every bucket
+    std::vector<uint32_t> buckets(count);
+    std::unique_ptr<std::atomic<uint32_t>[]> counts(new std::atomic<uint32_t>[bucket_count]);
+    for (uint32_t i = 0; i < bucket_count; ++i)
+        counts[i] = 0;
+
+    tbb::parallel_for(
+        tbb::blocked_range<size_t>(0, count, 4096),
+        [&](const tbb::blocked_range<size_t> &range) {
+            for (size_t i = range.begin(); i != range.end(); ++i) {
+                Vector<int32_t, 3> cell(floor(photons[i].p * m_inv_cell_size));
+                buckets[i] = bucket(cell);
+                counts[buckets[i]].fetch_add(1, std::memory_order_relaxed);
+            }
+        });
+
+    // 2. Offsets of the buckets
+    m_bucket_start.resize(bucket_count + 1);
+    uint32_t sum = 0;
+    for (uint32_t i = 0; i < bucket_count; ++i) {
+        m_bucket_start[i] = sum;
+        sum += counts[i].load(std::memory_order_relaxed);
+        counts[i] = m_bucket_start[i];
+    }
+    m_bucket_start[bucket_count] = sum;
+
+    // 3. Scatter the photon indices, and restore their order within each bucket
+    std::vector<uint32_t> order(count);
+    tbb::parallel_for(
+        tbb::blocked_range<size_t>(0, count, 4096),
+        [&](const tbb::blocked_range<size_t> &range) {
+            for (size_t i = range.begin(); i != range.end(); ++i)
+                order[counts[buckets[i]].fetch_add(1, std::memory_order_relaxed)] =
+                    (uint32_t) i;
+        });
+
+    tbb::parallel_for(
+        tbb::blocked_range<uint32_t>(0, bucket_count, 1024),
+        [&](const tbb::blocked_range<uint32_t> &range) {
+            for (uint32_t i = range.begin(); i != range.end(); ++i)
+                std::sort(order.begin() + m_bucket_start[i],
+                          order.begin() + m_bucket_start[i + 1]);
+        });
+
+    // 4. Store the photons contiguously
+    std::vector<Photon> sorted(count);
+    tbb::parallel_for(
+        tbb::blocked_range<size_t>(0, count, 4096),
+        [&](const tbb::blocked_range<size_t> &range) {
+            for (size_t i = range.begin(); i != range.end(); ++i)
+                sorted[i] = photons[order[i]];
+        });
+
+    m_photons = std::move(sorted);
+    photons.clear();
+}
+
+MTS_VARIANT void PhotonMap<Float, Spectrum>::query(const ScalarPoint3f &p,
+                                                  std::vector<uint32_t> &result) const {
+    if (m_photons.empty())
+        return;
+
+    // The lookup sphere overlaps at most two cells along each axis
+    Vector<int32_t, 3> base(floor((p - m_radius) * m_inv_cell_size));
+    ScalarFloat radius2 = m_radius * m_radius;
+
+    // Distinct cells may share a bucket, which must then only be visited once
+    uint32_t visited[8];
+    size_t visited_count = 0;
+
+    for (int i = 0; i < 8; ++i) {
+        Vector<int32_t, 3> cell = base + Vector<int32_t, 3>(i & 1, (i >> 1) & 1, i >> 2);
+        uint32_t b = bucket(cell);
+        if (std::find(visited, visited + visited_count, b) != visited + visited_count)
+            continue;
+        visited[visited_count++] = b;
+
+        for (uint32_t j = m_bucket_start[b]; j < m_bucket_start[b + 1]; ++j) {
+            if (squared_norm(m_photons[j].p - p) <= radius2)
+                result.push_back(j);
+        }
+    }
+}
+
+MTS_VARIANT std::string PhotonMap<Float, Spectrum>::to_string() const {
+    std::ostringstream oss;
+    oss << "PhotonMap[" << std::endl
+        << "  photon_count = " << m_photons.size() << "," << std::endl
+        << "  radius = " << m_radius << std::endl
+        << "]";
+    return oss.str();
+}
+
+MTS_IMPLEMENT_CLASS_VARIANT(PhotonMap, Object)
+MTS_INSTANTIATE_CLASS(PhotonMap)
+NAMESPACE_END(mitsuba)
@@ -0,0 +1,21 @@
+#include <mitsuba/render/denoiser.h>
+#include <mitsuba/python/python.h>
+
+MTS_PY_EXPORT(Denoiser) {
+    auto denoiser = MTS_PY_CLASS(Denoiser, Object);
+
+    py::enum_<Denoiser::Backend>(denoiser, "Backend", D(Denoiser, Backend))
+        .value("Auto",    Denoiser::Backend::Auto,    D(Denoiser, Backend, Auto))
+        .value("Builtin", Denoiser::Backend::Builtin, D(Denoiser, Backend, Builtin))
+        .value("OIDN",    Denoiser::Backend::OIDN,    D(Denoiser, Backend, OIDN));
+
+    denoiser
+        .def(py::init<Denoiser::Backend, float>(),
+             "backend"_a = Denoiser::Backend::Auto, "strength"_a = 1.f, D(Denoiser, Denoiser))
+        .def("denoise", &Denoiser::denoise, "color"_a, "albedo"_a = nullptr,
+             "normal"_a = nullptr, D(Denoiser, denoise),
+             py::call_guard<py::gil_scoped_release>())
+        .def_method(Denoiser, backend)
+        .def_method(Denoiser, strength)
+        .def_static("has_oidn", &Denoiser::has_oidn, D(Denoiser, has_oidn));
+}
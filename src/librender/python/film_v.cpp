@@ -11,15 +11,31 @@ MTS_PY_EXPORT(Film) {
     MTS_PY_IMPORT_TYPES(Film)
     MTS_PY_CLASS(Film, Object)
         .def_method(Film, prepare, "channels"_a)
-        .def_method(Film, put, "block"_a)
+        .def("put", py::overload_cast<const ImageBlock *>(&Film::put),
+            "block"_a, D(Film, put))
+        .def("put", py::overload_cast<const ImageBlock *, size_t>(&Film::put),
+            "block"_a, "index"_a, D(Film, put, 2))
+        .def("splat", vectorize(&Film::splat), "pos"_a, "value"_a, "wavelengths"_a,
+            "active"_a = true, D(Film, splat))
         .def_method(Film, set_destination_file, "filename"_a)
-        .def("develop", py::overload_cast<>(&Film::develop))
+        .def("develop", py::overload_cast<>(&Film::develop),
+            py::call_guard<py::gil_scoped_release>())
         .def("develop", py::overload_cast<const ScalarPoint2i &, const ScalarVector2i &,
                                             const ScalarPoint2i &, Bitmap *>(
                 &Film::develop, py::const_),
-            "offset"_a, "size"_a, "target_offset"_a, "target"_a)
+            "offset"_a, "size"_a, "target_offset"_a, "target"_a,
+            py::call_guard<py::gil_scoped_release>())
         .def_method(Film, destination_exists, "basename"_a)
         .def_method(Film, bitmap, "raw"_a = false)
+        .def_method(Film, denoised_bitmap)
+        .def("snapshot", &Film::snapshot, py::call_guard<py::gil_scoped_release>(),
+            D(Film, snapshot))
+        .def_method(Film, streaming)
+        .def_method(Film, has_variance)
+        .def_method(Film, has_color_variance)
+        .def_method(Film, variance_channel_count)
+        .def_method(Film, band_count)
+        .def_method(Film, band_range)
         .def_method(Film, has_high_quality_edges)
         .def_method(Film, size)
         .def_method(Film, crop_size)
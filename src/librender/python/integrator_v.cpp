@@ -24,6 +24,10 @@ static void (*sigint_handler_prev)(int) = nullptr;
 MTS_VARIANT class PySamplingIntegrator : public SamplingIntegrator<Float, Spectrum> {
 public:
     MTS_IMPORT_TYPES(SamplingIntegrator, Scene, Sampler, Medium, Emitter, EmitterPtr, BSDF, BSDFPtr)
+    using typename SamplingIntegrator::DynamicUInt32;
+    using typename SamplingIntegrator::DynamicMask;
+    using typename SamplingIntegrator::DynamicSpectrum;
+    using typename SamplingIntegrator::DynamicRayDifferential3f;
 
     PySamplingIntegrator(const Properties &props) : SamplingIntegrator(props) { }
 
@@ -48,6 +52,45 @@ public:
         }
     }
 
+    /**
+     * Batch bridge: the samples of a whole image block are passed to a single
+     * call of the Python implementation (if any) instead of one call per
+     * packet. Only used by the CPU packet variants (see \ref supports_wavefront()).
+     */
+    void sample_wavefront(const Scene *scene,
+                          const DynamicRayDifferential3f &rays,
+                          const DynamicUInt32 &seeds,
+                          const Medium *medium,
+                          const DynamicMask &active,
+                          DynamicSpectrum &result,
+                          DynamicMask &valid) const override {
+        py::gil_scoped_acquire gil;
+        py::function overload = py::get_overload(this, "sample_wavefront");
+
+        if (overload) {
+            using PyReturn = std::tuple<DynamicSpectrum, DynamicMask>;
+            std::tie(result, valid) =
+                overload(scene, rays, seeds, medium, active).template cast<PyReturn>();
+
+            if (slices(result) != slices(rays) || slices(valid) != slices(rays))
+                Throw("SamplingIntegrator.sample_wavefront() must return arrays with "
+                      "one entry per ray (expected %i, got %i and %i)!",
+                      slices(rays), slices(result), slices(valid));
+        } else {
+            SamplingIntegrator::sample_wavefront(scene, rays, seeds, medium, active,
+                                                 result, valid);
+        }
+    }
+
+    bool supports_wavefront() const override {
+        if constexpr (is_array_v<Float> && !is_cuda_array_v<Float>) {
+            py::gil_scoped_acquire gil;
+            return (bool) py::get_overload(this, "sample_wavefront");
+        } else {
+            return false;
+        }
+    }
+
     std::vector<std::string> aov_names() const override {
         PYBIND11_OVERLOAD(std::vector<std::string>, SamplingIntegrator, aov_names, );
     }
@@ -75,6 +118,17 @@ void bind_integrator_sample(Class &integrator) {
         },
         "scene"_a, "sampler"_a, "ray"_a, "medium"_a = nullptr, "active"_a = true,
         D(SamplingIntegrator, sample));
+
+    integrator.def(
+        "sample_adjoint",
+        [](const SamplingIntegrator *integrator, const Scene *scene, Sampler *sampler,
+           const RayDifferential3f &ray, const Medium *medium, const Spectrum &radiance,
+           const Spectrum &adjoint, Mask active) {
+            py::gil_scoped_release release;
+            integrator->sample_adjoint(scene, sampler, ray, medium, radiance, adjoint, active);
+        },
+        "scene"_a, "sampler"_a, "ray"_a, "medium"_a, "radiance"_a, "adjoint"_a,
+        "active"_a = true, D(SamplingIntegrator, sample_adjoint));
 }
 
 template <typename FloatP, typename SpectrumP, typename Class,
@@ -153,14 +207,35 @@ MTS_PY_EXPORT(Integrator) {
                 return res;
             },
             D(Integrator, render), "scene"_a, "sensor"_a)
-        .def_method(Integrator, cancel);
+        .def("render_batch",
+            [](Integrator *integrator, Scene *scene, const std::vector<Sensor *> &sensors) {
+                py::gil_scoped_release release;
+                return integrator->render_batch(scene, sensors);
+            },
+            D(Integrator, render_batch), "scene"_a, "sensors"_a)
+        .def_method(Integrator, cancel)
+        .def_method(Integrator, set_thread_pool, "pool"_a)
+        .def("thread_pool", py::overload_cast<>(&Integrator::thread_pool),
+             D(Integrator, thread_pool));
 
     auto integrator =
         py::class_<SamplingIntegrator, PySamplingIntegrator, Integrator,
                     ref<SamplingIntegrator>>(m, "SamplingIntegrator", D(SamplingIntegrator))
             .def(py::init<const Properties&>())
             .def_method(SamplingIntegrator, aov_names)
-            .def_method(SamplingIntegrator, should_stop);
+            .def("render_preview",
+                [](SamplingIntegrator *integrator, Scene *scene, Sensor *sensor,
+                   const std::function<void(uint32_t, size_t)> &update) {
+                    py::gil_scoped_release release;
+                    return integrator->render_preview(scene, sensor, update);
+                },
+                "scene"_a, "sensor"_a, "update"_a = py::none(),
+                D(SamplingIntegrator, render_preview))
+            .def_method(SamplingIntegrator, should_stop)
+            .def_method(SamplingIntegrator, blocks_done)
+            .def_method(SamplingIntegrator, samples_done)
+            .def_method(SamplingIntegrator, render_time)
+            .def_method(SamplingIntegrator, pass_times);
 
     bind_integrator_sample<Float, Spectrum>(integrator);
 
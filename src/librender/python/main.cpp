@@ -1,6 +1,7 @@
 #include <mitsuba/python/python.h>
 
 MTS_PY_DECLARE(BSDFContext);
+MTS_PY_DECLARE(Denoiser);
 MTS_PY_DECLARE(EmitterExtras);
 MTS_PY_DECLARE(HitComputeFlags);
 MTS_PY_DECLARE(MicrofacetType);
@@ -12,6 +13,7 @@ PYBIND11_MODULE(render_ext, m) {
     m.attr("__name__") = "mitsuba.render";
 
     MTS_PY_IMPORT(BSDFContext);
+    MTS_PY_IMPORT(Denoiser);
     MTS_PY_IMPORT(EmitterExtras);
     MTS_PY_IMPORT(HitComputeFlags);
     MTS_PY_IMPORT(MicrofacetType);
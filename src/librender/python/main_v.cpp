@@ -86,8 +86,12 @@ PYBIND11_MODULE(MODULE_NAME, m) {
 
     using Float = MTS_VARIANT_FLOAT;
 #if defined(MTS_ENABLE_OPTIX)
-    if constexpr (is_cuda_array_v<Float>)
+    if constexpr (is_cuda_array_v<Float>) {
+        /* Only effective if no CUDA operation was performed yet, otherwise
+           the driver already uses the cache given by the environment */
+        cuda_configure_cache();
         optix_initialize();
+    }
 #endif
 
     // Create sub-modules
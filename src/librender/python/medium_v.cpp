@@ -41,7 +41,8 @@ MTS_PY_EXPORT(Medium) {
             .def("get_combined_extinction", vectorize(&Medium::get_combined_extinction), "mi"_a, "active"_a=true)
             .def("get_scattering_coefficients", vectorize(&Medium::get_scattering_coefficients), "mi"_a, "active"_a=true)
             .def("sample_interaction", vectorize(&Medium::sample_interaction), "ray"_a, "sample"_a, "channel"_a, "active"_a=true)
-            .def("eval_tr_and_pdf", vectorize(&Medium::eval_tr_and_pdf), "mi"_a, "si"_a, "active"_a=true)
+            .def("eval_tr_and_pdf", vectorize(&Medium::eval_tr_and_pdf), "ray"_a, "mi"_a, "si"_a, "active"_a=true)
+            .def("eval_transmittance", vectorize(&Medium::eval_transmittance), "ray"_a, "sampler"_a, "channel"_a, "residual"_a=false, "active"_a=true)
             .def_method(Medium, phase_function)
             .def_method(Medium, use_emitter_sampling)
             // .def_method(Medium, is_homogeneous)
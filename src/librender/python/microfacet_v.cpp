@@ -7,22 +7,25 @@ MTS_PY_EXPORT(MicrofacetDistribution) {
 
     py::class_<MicrofacetDistribution>(m, "MicrofacetDistribution", D(MicrofacetDistribution))
         // TODO is this needed?
-        .def(py::init([](MicrofacetType t, ScalarFloat alpha, bool sv) {
-            return MicrofacetDistribution(t, alpha, sv);
-        }), "type"_a, "alpha"_a, "sample_visible"_a = true)
-        .def(py::init([](MicrofacetType t, ScalarFloat alpha_u, ScalarFloat alpha_v, bool sv) {
-            return MicrofacetDistribution(t, alpha_u, alpha_v, sv);
-        }), "type"_a, "alpha_u"_a, "alpha_v"_a, "sample_visible"_a = true)
-        .def(py::init<MicrofacetType, const Float &, bool>(), "type"_a, "alpha"_a,
-            "sample_visible"_a = true)
-        .def(py::init<MicrofacetType, const Float &, const Float &, bool>(), "type"_a, "alpha_u"_a,
-            "alpha_v"_a, "sample_visible"_a = true)
+        .def(py::init([](MicrofacetType t, ScalarFloat alpha, bool sv, bool ts) {
+            return MicrofacetDistribution(t, alpha, sv, ts);
+        }), "type"_a, "alpha"_a, "sample_visible"_a = true, "tabulated_sampling"_a = false)
+        .def(py::init([](MicrofacetType t, ScalarFloat alpha_u, ScalarFloat alpha_v, bool sv,
+                         bool ts) {
+            return MicrofacetDistribution(t, alpha_u, alpha_v, sv, ts);
+        }), "type"_a, "alpha_u"_a, "alpha_v"_a, "sample_visible"_a = true,
+            "tabulated_sampling"_a = false)
+        .def(py::init<MicrofacetType, const Float &, bool, bool>(), "type"_a, "alpha"_a,
+            "sample_visible"_a = true, "tabulated_sampling"_a = false)
+        .def(py::init<MicrofacetType, const Float &, const Float &, bool, bool>(), "type"_a,
+            "alpha_u"_a, "alpha_v"_a, "sample_visible"_a = true, "tabulated_sampling"_a = false)
         .def(py::init<const Properties &>())
         .def_method(MicrofacetDistribution, type)
         .def_method(MicrofacetDistribution, alpha)
         .def_method(MicrofacetDistribution, alpha_u)
         .def_method(MicrofacetDistribution, alpha_v)
         .def_method(MicrofacetDistribution, sample_visible)
+        .def_method(MicrofacetDistribution, tabulated_sampling)
         .def_method(MicrofacetDistribution, is_anisotropic)
         .def_method(MicrofacetDistribution, is_isotropic)
         .def_method(MicrofacetDistribution, scale_alpha, "value"_a)
@@ -11,8 +11,18 @@ MTS_PY_EXPORT(Sampler) {
         .def_method(Sampler, advance)
         .def("seed", vectorize(&Sampler::seed),
              "seed_offset"_a, "wavefront_size"_a = 1, D(Sampler, seed))
+        .def_method(Sampler, seed_chunk, "seed_offset"_a, "offset"_a, "wavefront_size"_a)
         .def("next_1d", vectorize(&Sampler::next_1d),
              "active"_a = true, D(Sampler, next_1d))
         .def("next_2d", vectorize(&Sampler::next_2d),
-             "active"_a = true, D(Sampler, next_2d));
+             "active"_a = true, D(Sampler, next_2d))
+        .def("next_nd",
+             [](Sampler &sampler, size_t count, Mask active) {
+                 std::vector<Float> values(count);
+                 sampler.next_nd(values.data(), count, active);
+                 return values;
+             },
+             "count"_a, "active"_a = true, D(Sampler, next_nd))
+        .def("set_pixel", vectorize(&Sampler::set_pixel),
+             "pixel"_a, D(Sampler, set_pixel));
 }
@@ -9,7 +9,7 @@
 MTS_PY_EXPORT(ShapeKDTree) {
     MTS_PY_IMPORT_TYPES(ShapeKDTree, Shape, Mesh)
 #if !defined(MTS_ENABLE_EMBREE)
-    MTS_PY_CLASS(ShapeKDTree, Object)
+    auto kdtree = MTS_PY_CLASS(ShapeKDTree, Object)
         .def(py::init<const Properties &>(), D(ShapeKDTree, ShapeKDTree))
         .def_method(ShapeKDTree, add_shape)
         .def_method(ShapeKDTree, primitive_count)
@@ -27,7 +27,40 @@ MTS_PY_EXPORT(ShapeKDTree) {
         .def("__len__", &ShapeKDTree::primitive_count)
         .def("bbox", [] (ShapeKDTree &s) { return s.bbox(); })
         .def_method(ShapeKDTree, build)
-        .def_method(ShapeKDTree, build);
+        .def("build_statistics", [](const ShapeKDTree &s) {
+            const auto &st = s.build_statistics();
+            py::dict d;
+            d["final_cost"]             = st.final_cost;
+            d["exp_traversal_steps"]    = st.exp_traversal_steps;
+            d["exp_leaves_visited"]     = st.exp_leaves_visited;
+            d["exp_primitives_queried"] = st.exp_primitives_queried;
+            d["node_count"]             = st.node_count;
+            d["leaf_count"]             = st.leaf_count;
+            d["nonempty_leaf_count"]    = st.nonempty_leaf_count;
+            d["index_count"]            = st.index_count;
+            d["max_depth"]              = st.max_depth;
+            d["max_prims_in_leaf"]      = st.max_prims_in_leaf;
+            d["avg_prims_in_leaf"]      = st.avg_prims_in_leaf;
+            d["retracted_splits"]       = st.retracted_splits;
+            d["bad_refines"]            = st.bad_refines;
+            d["pruned"]                 = st.pruned;
+            d["work_units"]             = st.work_units;
+            d["temp_storage"]           = st.temp_storage;
+            d["peak_storage"]           = st.peak_storage;
+            d["budget_fallbacks"]       = st.budget_fallbacks;
+            d["sequential_splits"]      = st.sequential_splits;
+            d["parallel_sorts"]         = st.parallel_sorts;
+            d["time_setup"]             = st.time_setup;
+            d["time_construction"]      = st.time_construction;
+            d["time_finalization"]      = st.time_finalization;
+            d["time_postprocessing"]    = st.time_postprocessing;
+            return d;
+        }, D(TShapeKDTree, build_statistics));
+
+    if constexpr (is_array_v<Float> && !is_cuda_array_v<Float>) {
+        kdtree.def("ray_intersect_stream", &ShapeKDTree::ray_intersect_stream,
+                   "rays"_a, "shadow_ray"_a = false, D(ShapeKDTree, ray_intersect_stream));
+    }
 #else
     ENOKI_MARK_USED(m);
 #endif
@@ -35,7 +68,7 @@ MTS_PY_EXPORT(ShapeKDTree) {
 
 MTS_PY_EXPORT(Scene) {
     MTS_PY_IMPORT_TYPES(Scene, Integrator, SamplingIntegrator, MonteCarloIntegrator, Sensor)
-    MTS_PY_CLASS(Scene, Object)
+    auto scene = MTS_PY_CLASS(Scene, Object)
         .def(py::init<const Properties>())
         .def("ray_intersect_preliminary",
              vectorize(&Scene::ray_intersect_preliminary),
@@ -49,11 +82,19 @@ MTS_PY_EXPORT(Scene) {
         .def("ray_test",
             vectorize(&Scene::ray_test),
             "ray"_a, "active"_a = true)
+        .def("ray_intersect_and_test",
+            vectorize(&Scene::ray_intersect_and_test),
+            "ray"_a, "shadow_ray"_a, "active"_a = true, "shadow_active"_a = true,
+            "flags"_a = HitComputeFlags::All, D(Scene, ray_intersect_and_test))
 #if !defined(MTS_ENABLE_EMBREE)
         .def("ray_intersect_naive",
             vectorize(&Scene::ray_intersect_naive),
             "ray"_a, "active"_a = true)
 #endif
+        .def("sample_emitter_ray",
+            vectorize(&Scene::sample_emitter_ray),
+            "time"_a, "sample1"_a, "sample2"_a, "sample3"_a, "active"_a = true,
+            D(Scene, sample_emitter_ray))
         .def("sample_emitter_direction",
             vectorize(&Scene::sample_emitter_direction),
             "ref"_a, "sample"_a, "test_visibility"_a = true, "mask"_a = true)
@@ -62,6 +103,7 @@ MTS_PY_EXPORT(Scene) {
             "ref"_a, "ds"_a, "active"_a = true)
         // Accessors
         .def_method(Scene, bbox)
+        .def_method(Scene, accel_name)
         .def("sensors", py::overload_cast<>(&Scene::sensors), D(Scene, sensors))
         .def("emitters", py::overload_cast<>(&Scene::emitters), D(Scene, emitters))
         .def_method(Scene, environment)
@@ -87,5 +129,12 @@ MTS_PY_EXPORT(Scene) {
             },
             D(Scene, integrator))
         .def_method(Scene, shapes_grad_enabled)
+        .def_method(Scene, has_polarizing_bsdfs)
         .def("__repr__", &Scene::to_string);
+
+    // Batched ray tracing operates on the dynamic arrays exposed by packet variants
+    if constexpr (is_array_v<Float> && !is_cuda_array_v<Float>) {
+        scene.def("ray_intersect_batch", &Scene::ray_intersect_batch,
+                  "rays"_a, "sort"_a = true, D(Scene, ray_intersect_batch));
+    }
 }
\ No newline at end of file
@@ -7,8 +7,46 @@
 #include <mitsuba/render/mesh.h>
 #include <mitsuba/render/shape.h>
 #include <mitsuba/python/python.h>
+#include <mitsuba/python/dlpack.h>
 #include <pybind11/numpy.h>
 
+/**
+ * \brief Look up a buffer of a mesh by name ("vertex_positions",
+ * "vertex_positions_end", "vertex_normals", "vertex_texcoords", "faces", or
+ * the name of a mesh attribute)
+ *
+ * Returns a pointer to its storage, its data type, and its shape (the number
+ * of vertices or faces by the number of entries per element).
+ */
+template <typename Mesh>
+std::tuple<void *, dlpack::DataType, std::vector<int64_t>>
+mesh_buffer(Mesh &mesh, const std::string &name) {
+    auto result = [&](auto &buf, size_t count, Struct::Type type) {
+        size_t size = slices(buf);
+        if (size == 0 || count == 0)
+            Throw("Mesh: buffer \"%s\" is empty (or stored in compressed form)!", name);
+        return std::make_tuple((void *) buf.data(), dlpack::data_type(type),
+                               std::vector<int64_t>{ (int64_t) count,
+                                                     (int64_t) (size / count) });
+    };
+
+    if (name == "vertex_positions")
+        return result(mesh.vertex_positions_buffer(), mesh.vertex_count(), Struct::Type::Float32);
+    else if (name == "vertex_positions_end")
+        return result(mesh.vertex_positions_end_buffer(), mesh.vertex_count(), Struct::Type::Float32);
+    else if (name == "vertex_normals")
+        return result(mesh.vertex_normals_buffer(), mesh.vertex_count(), Struct::Type::Float32);
+    else if (name == "vertex_texcoords")
+        return result(mesh.vertex_texcoords_buffer(), mesh.vertex_count(), Struct::Type::Float32);
+    else if (name == "faces")
+        return result(mesh.faces_buffer(), mesh.face_count(), Struct::Type::UInt32);
+    else
+        return result(mesh.attribute_buffer(name),
+                      string::starts_with(name, "face_") ? mesh.face_count()
+                                                         : mesh.vertex_count(),
+                      Struct::Type::Float32);
+}
+
 MTS_PY_EXPORT(Shape) {
     MTS_PY_IMPORT_TYPES(Shape, Mesh)
 
@@ -28,6 +66,10 @@ MTS_PY_EXPORT(Shape) {
              "ray"_a, "flags"_a = HitComputeFlags::All, "active"_a = true,
              D(Shape, ray_intersect))
         .def("ray_test", vectorize(&Shape::ray_test), "ray"_a, "active"_a = true)
+        .def("ray_intersect_primitive", vectorize(&Shape::ray_intersect_primitive),
+             "index"_a, "ray"_a, "active"_a = true, D(Shape, ray_intersect_primitive))
+        .def("ray_test_primitive", vectorize(&Shape::ray_test_primitive),
+             "index"_a, "ray"_a, "active"_a = true, D(Shape, ray_test_primitive))
         .def("compute_surface_interaction", &Shape::compute_surface_interaction,
                 "ray"_a, "pi"_a, "flags"_a = HitComputeFlags::All, "active"_a = true)
         .def("bbox", py::overload_cast<>(
@@ -37,8 +79,13 @@ MTS_PY_EXPORT(Shape) {
         .def("bbox", py::overload_cast<ScalarUInt32, const ScalarBoundingBox3f &>(
             &Shape::bbox, py::const_), D(Shape, bbox, 3), "index"_a, "clip"_a)
         .def_method(Shape, surface_area)
+        .def_method(Shape, normal_cone)
         .def_method(Shape, id)
         .def_method(Shape, is_mesh)
+        .def_method(Shape, accel_refit)
+        .def_method(Shape, geometry_dirty)
+        .def_method(Shape, emitter_dirty)
+        .def_method(Shape, clear_dirty)
         .def_method(Shape, is_medium_transition)
         .def_method(Shape, interior_medium)
         .def_method(Shape, exterior_medium)
@@ -50,7 +97,10 @@ MTS_PY_EXPORT(Shape) {
         .def("bsdf", py::overload_cast<>(&Shape::bsdf, py::const_))
         .def_method(Shape, parameters_grad_enabled)
         .def_method(Shape, primitive_count)
-        .def_method(Shape, effective_primitive_count);
+        .def_method(Shape, effective_primitive_count)
+        .def_method(Shape, has_motion)
+        .def_method(Shape, motion_time_range)
+        .def_method(Shape, bbox_motion, "index"_a, "time_start"_a, "time_end"_a);
 
     using ScalarSize = typename Mesh::ScalarSize;
     MTS_PY_CLASS(Mesh, Shape)
@@ -65,12 +115,29 @@ MTS_PY_EXPORT(Shape) {
         .def_method(Mesh, has_vertex_texcoords)
         .def_method(Mesh, recompute_vertex_normals)
         .def_method(Mesh, recompute_bbox)
+        .def_method(Mesh, has_compressed_vertex_data)
+        .def_method(Mesh, compress_vertex_data)
+        .def_method(Mesh, sort_spatially)
+        .def("eval_attributes_1", &Mesh::eval_attributes_1, "names"_a, "si"_a,
+             "active"_a = true, D(Mesh, eval_attributes_1))
+        .def("eval_attributes_3", &Mesh::eval_attributes_3, "names"_a, "si"_a,
+             "active"_a = true, D(Mesh, eval_attributes_3))
+        .def_method(Mesh, has_vertex_motion)
+        .def_method(Mesh, set_vertex_motion, "time_start"_a, "time_end"_a)
         .def("write_ply", &Mesh::write_ply, "filename"_a,
              "Export mesh as a binary PLY file")
+        .def("write_ply_async", &Mesh::write_ply_async, "filename"_a,
+             D(Mesh, write_ply_async))
+        .def("write_mtsmesh", &Mesh::write_mtsmesh, "filename"_a,
+             D(Mesh, write_mtsmesh))
         .def("vertex_positions_buffer",
              py::overload_cast<>(&Mesh::vertex_positions_buffer),
              D(Mesh, vertex_positions_buffer),
              py::return_value_policy::reference_internal)
+        .def("vertex_positions_end_buffer",
+             py::overload_cast<>(&Mesh::vertex_positions_end_buffer),
+             D(Mesh, vertex_positions_end_buffer),
+             py::return_value_policy::reference_internal)
         .def("vertex_normals_buffer",
              py::overload_cast<>(&Mesh::vertex_normals_buffer),
              D(Mesh, vertex_normals_buffer),
@@ -85,6 +152,28 @@ MTS_PY_EXPORT(Shape) {
              D(Mesh, attribute_buffer), py::return_value_policy::reference_internal)
         .def("add_attribute", &Mesh::add_attribute, "name"_a, "size"_a, "buffer"_a,
              D(Mesh, add_attribute), py::return_value_policy::reference_internal)
+        .def("buffer_dlpack", [](py::object self, const std::string &name) {
+                auto [data, dtype, shape] = mesh_buffer(self.cast<Mesh &>(), name);
+                return dlpack::export_tensor(data, dtype, std::move(shape),
+                                             is_cuda_array_v<Float> ? dlpack::CUDA
+                                                                    : dlpack::CPU,
+                                             self);
+            }, "name"_a,
+            "Export a buffer of the mesh (see buffer_view()) as a DLPack capsule that "
+            "aliases its memory, which resides on the GPU in CUDA variants")
+        .def("buffer_view", [](py::object self, const std::string &name) {
+                auto [data, dtype, shape] = mesh_buffer(self.cast<Mesh &>(), name);
+                py::dtype dt = dtype.code == dlpack::Float ? py::dtype::of<float>()
+                                                           : py::dtype::of<uint32_t>();
+                // The array references the mesh, which keeps the buffer alive
+                return py::array(dt, shape, data, self);
+            }, "name"_a,
+            "Return a NumPy array of shape ``(count, dimension)`` that aliases the "
+            "memory of a buffer of the mesh (``vertex_positions``, "
+            "``vertex_positions_end``, ``vertex_normals``, ``vertex_texcoords``, "
+            "``faces``, or the name of a mesh attribute) without copying it. In CUDA "
+            "variants, the buffers are allocated in managed memory that is also "
+            "accessible from the host.")
         .def("ray_intersect_triangle", vectorize(&Mesh::ray_intersect_triangle),
              "index"_a, "ray"_a, "active"_a = true,
              D(Mesh, ray_intersect_triangle))
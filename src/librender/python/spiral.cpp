@@ -4,12 +4,14 @@
 MTS_PY_EXPORT(Spiral) {
     using Vector2i = typename Spiral::Vector2i;
     MTS_PY_CLASS(Spiral, Object)
-        .def(py::init<Vector2i, Vector2i, size_t, size_t>(),
+        .def(py::init<Vector2i, Vector2i, size_t, size_t, bool>(),
             "size"_a, "offset"_a, "block_size"_a = MTS_BLOCK_SIZE, "passes"_a = 1,
-            D(Spiral, Spiral))
+            "scanline"_a = false, D(Spiral, Spiral))
         .def_method(Spiral, max_block_size)
         .def_method(Spiral, block_count)
+        .def_method(Spiral, scanline)
         .def_method(Spiral, reset)
         .def_method(Spiral, set_passes)
-        .def_method(Spiral, next_block);
+        .def_method(Spiral, next_block)
+        .def_method(Spiral, block, "index"_a);
 }
@@ -9,6 +9,8 @@ MTS_PY_EXPORT(Texture) {
         .def("mean", &Texture::mean, D(Texture, mean))
         .def("is_spatially_varying", &Texture::is_spatially_varying,
              D(Texture, is_spatially_varying))
+        .def("needs_differentials", &Texture::needs_differentials,
+             D(Texture, needs_differentials))
         .def("eval",
             vectorize(&Texture::eval),
             "si"_a, "active"_a = true, D(Texture, eval))
@@ -52,9 +54,21 @@ MTS_PY_EXPORT(Volume) {
         .def("max",
             &Volume::max,
             D(Volume, max))
+        .def("max_per_cell",
+            &Volume::max_per_cell,
+            "cells"_a, D(Volume, max_per_cell))
+        .def("min_per_cell",
+            &Volume::min_per_cell,
+            "cells"_a, D(Volume, min_per_cell))
+        .def("max_per_cell_and_band",
+            &Volume::max_per_cell_and_band,
+            "cells"_a, "bands"_a, D(Volume, max_per_cell_and_band))
         .def("bbox",
             &Volume::bbox,
             D(Volume, bbox))
+        .def("world_to_local",
+            &Volume::world_to_local,
+            D(Volume, world_to_local))
         .def("resolution",
             &Volume::resolution,
             D(Volume, resolution));
@@ -0,0 +1,208 @@
+#include <mitsuba/core/properties.h>
+#include <mitsuba/render/rrs.h>
+#include <mitsuba/render/scene.h>
+
+NAMESPACE_BEGIN(mitsuba)
+
+MTS_VARIANT RRSCache<Float, Spectrum>::RRSCache(const Properties &props) {
+    if constexpr (is_cuda_array_v<Float>)
+        Throw("Adaptive Russian roulette and splitting is only supported by the CPU variants.");
+
+    m_learning_passes = props.size_("rrs_learning_passes", 4);
+    if (m_learning_passes == 0)
+        Throw("\"rrs_learning_passes\" must be at least 1!");
+
+    m_resolution = (uint32_t) props.size_("rrs_resolution", 16);
+    if (m_resolution == 0 || m_resolution > 256)
+        Throw("\"rrs_resolution\" must be in the range [1, 256]!");
+
+    m_min_survival = props.float_("rrs_min_survival", .05f);
+    m_max_split    = props.float_("rrs_max_split", 8.f);
+    if (!(m_min_survival > 0.f && m_min_survival <= 1.f))
+        Throw("\"rrs_min_survival\" must be in the range (0, 1]!");
+    if (!(m_max_split >= 1.f))
+        Throw("\"rrs_max_split\" must be at least 1!");
+
+    m_cells = std::unique_ptr<Cell[]>(new Cell[m_resolution * m_resolution * m_resolution]);
+    m_cell_factor.assign(m_resolution * m_resolution * m_resolution, -1.f);
+}
+
+MTS_VARIANT RRSCache<Float, Spectrum>::~RRSCache() { }
+
+MTS_VARIANT void RRSCache<Float, Spectrum>::prepare_pass(const Scene *scene, size_t pass) {
+    // Start learning from scratch in every render job
+    if (pass == 0) {
+        m_bbox = scene->bbox();
+        if (!m_bbox.valid())
+            m_bbox = ScalarBoundingBox3f(ScalarPoint3f(0.f), ScalarPoint3f(1.f));
+
+        size_t cell_count = m_resolution * m_resolution * m_resolution;
+        m_cells = std::unique_ptr<Cell[]>(new Cell[cell_count]);
+        m_cell_factor.assign(cell_count, -1.f);
+        m_pixel_radiance  = 0.0;
+        m_pixel_radiance2 = 0.0;
+        m_pixel_cost      = 0.0;
+        m_pixel_count = 0;
+        m_pixel_factor = 0.f;
+    }
+
+    m_learning = pass < m_learning_passes;
+    m_ready = !m_learning && m_pixel_factor > 0.f;
+}
+
+MTS_VARIANT void RRSCache<Float, Spectrum>::finish_pass(size_t pass) {
+    if (!m_learning)
+        return;
+
+    // Image-wide variance and cost of a sample
+    double n = (double) m_pixel_count,
+           mean = (double) m_pixel_radiance / n,
+           var  = (double) m_pixel_radiance2 / n - mean * mean,
+           cost = (double) m_pixel_cost / n;
+    m_pixel_factor = (m_pixel_count > 0 && var > 0.0) ? (ScalarFloat) std::sqrt(cost / var) : 0.f;
+
+    size_t learned = 0;
+    for (size_t i = 0; i < m_cell_factor.size(); ++i) {
+        const Cell &cell = m_cells[i];
+        uint32_t count = cell.count.load(std::memory_order_relaxed);
+        if (count < MinCellSamples) {
+            m_cell_factor[i] = -1.f;
+            continue;
+        }
+        double radiance2 = (double) cell.radiance2 / count,
+               cell_cost = (double) cell.cost / count;
+        m_cell_factor[i] = (ScalarFloat) std::sqrt(radiance2 / std::max(cell_cost, 1.0));
+        learned++;
+    }
+
+    Log(Debug, "Russian roulette and splitting after pass %i: %i/%i cells learned.",
+        pass + 1, learned, m_cell_factor.size());
+}
+
+MTS_VARIANT uint32_t RRSCache<Float, Spectrum>::cell_index(const ScalarPoint3f &p) const {
+    ScalarVector3f x = (p - m_bbox.min) / max(m_bbox.extents(), math::Epsilon<ScalarFloat>);
+    ScalarFloat r = (ScalarFloat) m_resolution;
+    uint32_t ix = (uint32_t) std::min(std::max(x.x() * r, 0.f), r - 1.f),
+             iy = (uint32_t) std::min(std::max(x.y() * r, 0.f), r - 1.f),
+             iz = (uint32_t) std::min(std::max(x.z() * r, 0.f), r - 1.f);
+    return (iz * m_resolution + iy) * m_resolution + ix;
+}
+
+NAMESPACE_BEGIN(detail)
+template <typename Float> auto rrs_lane(const Float &v, size_t i) {
+    if constexpr (is_array_v<Float>) {
+        return v.coeff(i);
+    } else {
+        ENOKI_MARK_USED(i);
+        return v;
+    }
+}
+
+template <typename Point3f> auto rrs_lane_point(const Point3f &p, size_t i) {
+    using ScalarPoint3f = Point<scalar_t<Point3f>, 3>;
+    return ScalarPoint3f(rrs_lane(p.x(), i), rrs_lane(p.y(), i), rrs_lane(p.z(), i));
+}
+
+template <typename Float, typename Mask> bool rrs_lane_mask(const Mask &m, size_t i) {
+    return rrs_lane(select(m, Float(1.f), Float(0.f)), i) != 0.f;
+}
+NAMESPACE_END(detail)
+
+MTS_VARIANT std::pair<Float, Mask>
+RRSCache<Float, Spectrum>::factor(const Point3f &p, const Float &weight, Mask active) const {
+    constexpr size_t Lanes = is_array_v<Float> ? array_size_v<Float> : 1;
+    Float cell_factor(-1.f);
+
+    if constexpr (!is_cuda_array_v<Float>) {
+        for (size_t i = 0; i < Lanes; ++i) {
+            if (!detail::rrs_lane_mask<Float>(active, i))
+                continue;
+            ScalarFloat value = m_cell_factor[cell_index(detail::rrs_lane_point(p, i))];
+            if constexpr (is_array_v<Float>)
+                cell_factor.coeff(i) = value;
+            else
+                cell_factor = value;
+        }
+    } else {
+        ENOKI_MARK_USED(p);
+    }
+
+    Mask valid = active && cell_factor >= 0.f;
+    Float q = clamp(weight * cell_factor * m_pixel_factor, m_min_survival, m_max_split);
+    return { select(valid, q, 1.f), valid };
+}
+
+MTS_VARIANT std::pair<typename RRSCache<Float, Spectrum>::UInt32, Float>
+RRSCache<Float, Spectrum>::split(const Point3f &p, const Float &weight, const Float &rr_prob,
+                                 const Float &sample, bool allow_split, Mask active) const {
+    auto [q, adaptive] = factor(p, weight, active);
+    q = select(adaptive, q, rr_prob);
+    if (!allow_split)
+        q = min(q, 1.f);
+
+    // Stochastic rounding keeps the expected number of copies equal to the factor
+    UInt32 copies = select(active, UInt32(floor(q + sample)), 0u);
+    return { copies, q };
+}
+
+MTS_VARIANT void RRSCache<Float, Spectrum>::record(const Vertex *vertices, uint32_t count,
+                                                  const Float &radiance, const UInt32 &length,
+                                                  Mask active) const {
+    if constexpr (!is_cuda_array_v<Float>) {
+        constexpr size_t Lanes = is_array_v<Float> ? array_size_v<Float> : 1;
+
+        for (size_t i = 0; i < Lanes; ++i) {
+            if (!detail::rrs_lane_mask<Float>(active, i))
+                continue;
+
+            ScalarFloat radiance_i = detail::rrs_lane(radiance, i);
+            uint32_t length_i = (uint32_t) detail::rrs_lane(length, i);
+            if (!std::isfinite(radiance_i))
+                continue;
+
+            m_pixel_radiance  += (double) radiance_i;
+            m_pixel_radiance2 += (double) radiance_i * radiance_i;
+            m_pixel_cost      += (double) length_i;
+            m_pixel_count.fetch_add(1, std::memory_order_relaxed);
+
+            for (uint32_t j = 0; j < count; ++j) {
+                const Vertex &v = vertices[j];
+                ScalarFloat weight = detail::rrs_lane(v.weight, i);
+                if (!detail::rrs_lane_mask<Float>(v.active, i) || !(weight > 0.f))
+                    continue;
+
+                // Radiance gathered by the remainder of the path, and its cost
+                ScalarFloat value = (radiance_i - detail::rrs_lane(v.radiance, i)) / weight;
+                uint32_t length_v = (uint32_t) detail::rrs_lane(v.length, i);
+                if (!std::isfinite(value))
+                    continue;
+
+                Cell &cell = m_cells[cell_index(detail::rrs_lane_point(v.p, i))];
+                cell.radiance2 += (double) value * value;
+                cell.cost += (double) (length_i >= length_v ? length_i - length_v + 1 : 1);
+                cell.count.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+    } else {
+        ENOKI_MARK_USED(vertices);
+        ENOKI_MARK_USED(count);
+        ENOKI_MARK_USED(radiance);
+        ENOKI_MARK_USED(length);
+        ENOKI_MARK_USED(active);
+    }
+}
+
+MTS_VARIANT std::string RRSCache<Float, Spectrum>::to_string() const {
+    std::ostringstream oss;
+    oss << "RRSCache[" << std::endl
+        << "  learning_passes = " << m_learning_passes << "," << std::endl
+        << "  resolution = " << m_resolution << "," << std::endl
+        << "  min_survival = " << m_min_survival << "," << std::endl
+        << "  max_split = " << m_max_split << std::endl
+        << "]";
+    return oss.str();
+}
+
+MTS_IMPLEMENT_CLASS_VARIANT(RRSCache, Object)
+MTS_INSTANTIATE_CLASS(RRSCache)
+NAMESPACE_END(mitsuba)
@@ -16,6 +16,7 @@ MTS_VARIANT Sampler<Float, Spectrum>::Sampler(const Properties &props) {
     m_sample_index = 0;
     m_samples_per_wavefront = 1;
     m_wavefront_size = 0;
+    m_wavefront_offset = 0;
 }
 
 MTS_VARIANT Sampler<Float, Spectrum>::~Sampler() { }
@@ -27,6 +28,17 @@ MTS_VARIANT void Sampler<Float, Spectrum>::seed(uint64_t /*seed_offset*/,
     m_sample_index = 0;
 }
 
+MTS_VARIANT void Sampler<Float, Spectrum>::seed_chunk(uint64_t seed_offset, size_t offset,
+                                                      size_t wavefront_size) {
+    if (offset % m_samples_per_wavefront != 0)
+        Throw("seed_chunk(): the offset must be a multiple of samples_per_wavefront!");
+
+    // Only consulted while seeding; the lane index within a pixel is unaffected
+    m_wavefront_offset = (uint32_t) offset;
+    seed(seed_offset, wavefront_size);
+    m_wavefront_offset = 0;
+}
+
 MTS_VARIANT void Sampler<Float, Spectrum>::advance() {
     Assert(m_sample_index < (m_sample_count / m_samples_per_wavefront));
     m_dimension_index = 0u;
@@ -42,6 +54,19 @@ Sampler<Float, Spectrum>::next_2d(Mask) {
     NotImplementedError("next_2d");
 }
 
+MTS_VARIANT void Sampler<Float, Spectrum>::next_nd(Float *values, size_t count, Mask active) {
+    for (size_t i = 0; i + 1 < count; i += 2) {
+        Point2f value = next_2d(active);
+        values[i]     = value.x();
+        values[i + 1] = value.y();
+    }
+
+    if (count % 2 == 1)
+        values[count - 1] = next_1d(active);
+}
+
+MTS_VARIANT void Sampler<Float, Spectrum>::set_pixel(const Point2u & /*pixel*/) { }
+
 MTS_VARIANT void
 Sampler<Float, Spectrum>::set_samples_per_wavefront(uint32_t samples_per_wavefront) {
     if constexpr (is_scalar_v<Float>)
@@ -54,7 +79,13 @@ Sampler<Float, Spectrum>::set_samples_per_wavefront(uint32_t samples_per_wavefro
 
 MTS_VARIANT typename Sampler<Float, Spectrum>::UInt32
 Sampler<Float, Spectrum>::compute_per_sequence_seed(uint32_t seed_offset) const {
-    UInt32 indices = arange<UInt32>(m_wavefront_size);
+    return compute_per_sequence_seed(seed_offset, m_wavefront_offset);
+}
+
+MTS_VARIANT typename Sampler<Float, Spectrum>::UInt32
+Sampler<Float, Spectrum>::compute_per_sequence_seed(uint32_t seed_offset,
+                                                    uint32_t wavefront_offset) const {
+    UInt32 indices = arange<UInt32>(m_wavefront_size) + wavefront_offset;
     UInt32 sequence_idx = m_samples_per_wavefront * (indices / m_samples_per_wavefront);
     return sample_tea_32(UInt32(m_base_seed), sequence_idx + UInt32(seed_offset));
 }
@@ -87,7 +118,7 @@ MTS_VARIANT void PCG32Sampler<Float, Spectrum>::seed(uint64_t seed_offset,
     uint64_t seed_value = m_base_seed + seed_offset;
 
     if constexpr (is_dynamic_array_v<Float>) {
-        UInt64 idx = arange<UInt64>(wavefront_size);
+        UInt64 idx = arange<UInt64>(wavefront_size) + (uint64_t) m_wavefront_offset;
         m_rng.seed(sample_tea_64(UInt64(seed_value), idx),
                    sample_tea_64(idx, UInt64(seed_value)));
     } else {
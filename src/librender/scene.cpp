@@ -1,9 +1,20 @@
+#include <algorithm>
+#include <numeric>
+#include <unordered_map>
+#include <enoki/morton.h>
+#include <mitsuba/core/hash.h>
+#include <mitsuba/core/memory.h>
 #include <mitsuba/core/properties.h>
 #include <mitsuba/core/plugin.h>
+#include <mitsuba/core/profiler.h>
+#include <mitsuba/core/statistics.h>
+#include <mitsuba/core/string.h>
 #include <mitsuba/render/bsdf.h>
 #include <mitsuba/render/medium.h>
 #include <mitsuba/render/scene.h>
+#include <mitsuba/render/bvh.h>
 #include <mitsuba/render/kdtree.h>
+#include <mitsuba/render/lightbvh.h>
 #include <mitsuba/render/integrator.h>
 #include <enoki/stl.h>
 
@@ -58,6 +69,10 @@ MTS_VARIANT Scene<Float, Spectrum>::Scene(const Properties &props) {
         }
     }
 
+    // Share the geometry of meshes that were replicated without instancing
+    if (props.bool_("dedup_geometry", false))
+        deduplicate_geometry();
+
     if (m_sensors.empty()) {
         Log(Warn, "No sensors found! Instantiating a perspective camera..");
         Properties sensor_props("perspective");
@@ -91,16 +106,147 @@ MTS_VARIANT Scene<Float, Spectrum>::Scene(const Properties &props) {
             create_object<Integrator>(Properties("path"));
     }
 
-    if constexpr (is_cuda_array_v<Float>)
-        accel_init_gpu(props);
-    else
-        accel_init_cpu(props);
+    {
+#if defined(MTS_ENABLE_EMBREE)
+        const char *accel_name = is_cuda_array_v<Float> ? "OptiX" : "Embree";
+#else
+        const char *accel_name = is_cuda_array_v<Float> ? "OptiX" : "kd-tree";
+#endif
+        ScopedLoadEvent load_event(LoadEvent::BuildAccel, id().empty() ? "scene" : id(),
+                                   accel_name);
+        if constexpr (is_cuda_array_v<Float>)
+            accel_init_gpu(props);
+        else
+            accel_init_cpu(props);
+    }
 
     // Create emitters' shapes (environment luminaires)
     for (Emitter *emitter: m_emitters)
         emitter->set_scene(this);
 
+    // Distant sensors depend on the bounds of the scene as well
+    for (Sensor *sensor: m_sensors)
+        sensor->set_scene(this);
+
+    for (uint32_t i = 0; i < (uint32_t) m_emitters.size(); ++i)
+        m_emitters[i]->set_index(i);
+
+    std::string emitter_sampler = props.string("emitter_sampler", "uniform");
+    if (emitter_sampler == "bvh") {
+        if (m_emitters.size() > 1)
+            m_light_bvh = new LightBVH(m_emitters);
+    } else if (emitter_sampler == "power") {
+        if (m_emitters.size() > 1)
+            build_emitter_distr();
+    } else if (emitter_sampler != "uniform") {
+        Throw("Invalid emitter sampler \"%s\", must be one of: \"uniform\", "
+              "\"power\", or \"bvh\"!", emitter_sampler);
+    }
+
     m_shapes_grad_enabled = false;
+
+    m_polarizing = false;
+    if constexpr (is_polarized_v<Spectrum>) {
+        for (Shape *shape : m_shapes)
+            if (shape->bsdf())
+                m_polarizing |= has_flag(shape->bsdf()->flags(), BSDFFlags::Polarizing);
+        for (ShapeGroup *shapegroup : m_shapegroups)
+            m_polarizing |= shapegroup->has_polarizing_bsdfs();
+    }
+
+    MemoryAccounting::print_report(Debug);
+}
+
+MTS_VARIANT void Scene<Float, Spectrum>::build_emitter_distr(const std::vector<uint32_t> &changed) {
+    if (changed.empty() || m_emitter_power.size() != m_emitters.size()) {
+        m_emitter_power.resize(m_emitters.size());
+        for (size_t i = 0; i < m_emitters.size(); ++i)
+            m_emitter_power[i] = std::max(m_emitters[i]->power(), (ScalarFloat) 0.f);
+    } else {
+        for (uint32_t i : changed)
+            m_emitter_power[i] = std::max(m_emitters[i]->power(), (ScalarFloat) 0.f);
+    }
+
+    std::vector<ScalarFloat> power(m_emitter_power);
+    if (std::all_of(power.begin(), power.end(), [](ScalarFloat p) { return p == 0.f; })) {
+        Log(Warn, "None of the emitters has any power, sampling them uniformly instead.");
+        std::fill(power.begin(), power.end(), 1.f);
+    }
+
+    m_emitter_distr = DiscreteDistribution<Float>(power.data(), power.size());
+    m_emitter_distr.build_alias_table();
+}
+
+MTS_VARIANT void Scene<Float, Spectrum>::deduplicate_geometry() {
+    struct Group {
+        Mesh *prototype;
+        std::vector<std::pair<size_t, ScalarTransform4f>> members;
+    };
+
+    std::vector<Group> groups;
+    std::unordered_map<uint64_t, std::vector<size_t>> buckets;
+
+    for (size_t i = 0; i < m_shapes.size(); ++i) {
+        Shape *shape = m_shapes[i];
+        if (!shape->is_mesh() || shape->is_emitter() || shape->is_sensor() ||
+            shape->is_medium_transition() || shape->has_motion())
+            continue;
+
+        Mesh *mesh = (Mesh *) shape;
+        uint64_t key = hash_combine(mesh->placement_invariant_hash(),
+                                    (size_t) mesh->bsdf());
+        std::vector<size_t> &bucket = buckets[key];
+
+        bool found = false;
+        for (size_t g : bucket) {
+            ScalarTransform4f transform;
+            if (groups[g].prototype->bsdf() == mesh->bsdf() &&
+                mesh->is_placed_copy_of(groups[g].prototype, transform)) {
+                groups[g].members.emplace_back(i, transform);
+                found = true;
+                break;
+            }
+        }
+
+        if (!found) {
+            bucket.push_back(groups.size());
+            groups.push_back(Group{ mesh, { { i, ScalarTransform4f() } } });
+        }
+    }
+
+    size_t group_count = 0, instance_count = 0;
+    for (const Group &group : groups) {
+        if (group.members.size() < 2)
+            continue;
+
+        Properties group_props("shapegroup");
+        group_props.set_object("shape", group.prototype);
+        ref<Shape> shapegroup =
+            PluginManager::instance()->create_object<Shape>(group_props);
+        m_shapegroups.push_back((ShapeGroup *) shapegroup.get());
+        m_children.push_back(shapegroup.get());
+
+        for (const auto &[index, transform] : group.members) {
+            Properties instance_props("instance");
+            instance_props.set_object("shapegroup", shapegroup.get());
+            instance_props.set_transform("to_world", transform);
+            ref<Shape> instance =
+                PluginManager::instance()->create_object<Shape>(instance_props);
+
+            auto it = std::find(m_children.begin(), m_children.end(),
+                                ref<Object>(m_shapes[index].get()));
+            if (it != m_children.end())
+                *it = instance.get();
+            m_shapes[index] = instance;
+        }
+
+        group_count++;
+        instance_count += group.members.size();
+    }
+
+    if (group_count > 0)
+        Log(Info, "Replaced %i duplicate meshes by instances of %i shape groups",
+            instance_count, group_count);
 }
 
 MTS_VARIANT Scene<Float, Spectrum>::~Scene() {
@@ -113,6 +259,7 @@ MTS_VARIANT Scene<Float, Spectrum>::~Scene() {
 MTS_VARIANT typename Scene<Float, Spectrum>::SurfaceInteraction3f
 Scene<Float, Spectrum>::ray_intersect(const Ray3f &ray, Mask active) const {
     MTS_MASKED_FUNCTION(ProfilerPhase::RayIntersect, active);
+    stats_count(StatsCounter::Rays, active);
 
     if constexpr (is_cuda_array_v<Float>)
         return ray_intersect_gpu(ray, HitComputeFlags::All, active);
@@ -123,6 +270,7 @@ Scene<Float, Spectrum>::ray_intersect(const Ray3f &ray, Mask active) const {
 MTS_VARIANT typename Scene<Float, Spectrum>::SurfaceInteraction3f
 Scene<Float, Spectrum>::ray_intersect(const Ray3f &ray, HitComputeFlags flags, Mask active) const {
     MTS_MASKED_FUNCTION(ProfilerPhase::RayIntersect, active);
+    stats_count(StatsCounter::Rays, active);
 
     if constexpr (is_cuda_array_v<Float>)
         return ray_intersect_gpu(ray, flags, active);
@@ -132,12 +280,89 @@ Scene<Float, Spectrum>::ray_intersect(const Ray3f &ray, HitComputeFlags flags, M
 
 MTS_VARIANT typename Scene<Float, Spectrum>::PreliminaryIntersection3f
 Scene<Float, Spectrum>::ray_intersect_preliminary(const Ray3f &ray, Mask active) const {
+    stats_count(StatsCounter::Rays, active);
+
     if constexpr (is_cuda_array_v<Float>)
         return ray_intersect_preliminary_gpu(ray, active);
     else
         return ray_intersect_preliminary_cpu(ray, active);
 }
 
+MTS_VARIANT typename Scene<Float, Spectrum>::DynamicPreliminaryIntersection3f
+Scene<Float, Spectrum>::ray_intersect_batch(const DynamicRay3f &rays, bool sort) const {
+    if constexpr (is_cuda_array_v<Float>) {
+        ENOKI_MARK_USED(sort);
+        return ray_intersect_preliminary(rays);
+    } else if constexpr (is_array_v<Float>) {
+#if defined(MTS_ENABLE_EMBREE)
+        ENOKI_MARK_USED(sort);
+        stats_add(StatsCounter::Rays, slices(rays));
+        return ray_intersect_batch_cpu(rays);
+#else
+        size_t count = slices(rays);
+
+        // Padded to full packets so that the last packet can be loaded as a whole
+        std::vector<uint32_t> order(count + Float::Size, 0);
+        std::iota(order.begin(), order.begin() + count, 0u);
+        if (sort)
+            sort_rays(rays, order.data(), count);
+
+        DynamicPreliminaryIntersection3f result;
+        set_slices(result, count);
+
+        for (size_t i = 0; i < count; i += Float::Size) {
+            UInt32 index = load_unaligned<UInt32>(order.data() + i);
+            Mask active = UInt32((uint32_t) i) + arange<UInt32>() < UInt32((uint32_t) count);
+
+            Ray3f ray = gather<Ray3f>(rays, index, active);
+            PreliminaryIntersection3f pi = ray_intersect_preliminary(ray, active);
+            scatter(result, pi, index, active);
+        }
+
+        return result;
+#endif
+    } else {
+        ENOKI_MARK_USED(rays);
+        ENOKI_MARK_USED(sort);
+        NotImplementedError("ray_intersect_batch");
+    }
+}
+
+MTS_VARIANT void Scene<Float, Spectrum>::sort_rays(const DynamicRay3f &rays,
+                                                   uint32_t *indices,
+                                                   size_t count) const {
+    if constexpr (!is_cuda_array_v<Float>) {
+        // 9 bits per axis for the origin cell, 3 bits for the direction octant
+        const uint32_t grid_res = 511;
+        ScalarVector3f scale = grid_res / max(m_bbox.extents(), math::Epsilon<ScalarFloat>);
+
+        std::vector<std::pair<uint32_t, uint32_t>> keys(count);
+        for (size_t i = 0; i < count; ++i) {
+            uint32_t index = indices[i];
+            ScalarPoint3f o = slice(rays.o, index);
+            ScalarVector3f d = slice(rays.d, index);
+
+            ScalarVector3u cell(clamp((o - m_bbox.min) * scale, 0.f, (ScalarFloat) grid_res));
+            uint32_t octant = (d.x() < 0.f ? 1u : 0u) |
+                              (d.y() < 0.f ? 2u : 0u) |
+                              (d.z() < 0.f ? 4u : 0u);
+
+            keys[i] = { (octant << 27) | enoki::morton_encode(cell), index };
+        }
+
+        // Ties are broken by the index to keep the order deterministic
+        std::sort(keys.begin(), keys.end());
+
+        for (size_t i = 0; i < count; ++i)
+            indices[i] = keys[i].second;
+    } else {
+        ENOKI_MARK_USED(rays);
+        ENOKI_MARK_USED(indices);
+        ENOKI_MARK_USED(count);
+        NotImplementedError("sort_rays");
+    }
+}
+
 MTS_VARIANT typename Scene<Float, Spectrum>::SurfaceInteraction3f
 Scene<Float, Spectrum>::ray_intersect_naive(const Ray3f &ray, Mask active) const {
     MTS_MASKED_FUNCTION(ProfilerPhase::RayIntersect, active);
@@ -154,6 +379,7 @@ Scene<Float, Spectrum>::ray_intersect_naive(const Ray3f &ray, Mask active) const
 MTS_VARIANT typename Scene<Float, Spectrum>::Mask
 Scene<Float, Spectrum>::ray_test(const Ray3f &ray, Mask active) const {
     MTS_MASKED_FUNCTION(ProfilerPhase::RayTest, active);
+    stats_count(StatsCounter::ShadowRays, active);
 
     if constexpr (is_cuda_array_v<Float>)
         return ray_test_gpu(ray, active);
@@ -161,6 +387,61 @@ Scene<Float, Spectrum>::ray_test(const Ray3f &ray, Mask active) const {
         return ray_test_cpu(ray, active);
 }
 
+MTS_VARIANT std::pair<typename Scene<Float, Spectrum>::SurfaceInteraction3f,
+                      typename Scene<Float, Spectrum>::Mask>
+Scene<Float, Spectrum>::ray_intersect_and_test(const Ray3f &ray, const Ray3f &shadow_ray,
+                                               Mask active, Mask shadow_active,
+                                               HitComputeFlags flags) const {
+    MTS_MASKED_FUNCTION(ProfilerPhase::RayIntersect, active);
+    stats_count(StatsCounter::Rays, active);
+    stats_count(StatsCounter::ShadowRays, shadow_active);
+
+    if constexpr (is_cuda_array_v<Float>) {
+        Mask hit;
+        SurfaceInteraction3f si =
+            ray_intersect_gpu(ray, flags, active, &shadow_ray, shadow_active, &hit);
+        return { si, hit };
+    } else {
+        return { ray_intersect_cpu(ray, flags, active), ray_test_cpu(shadow_ray, shadow_active) };
+    }
+}
+
+MTS_VARIANT std::pair<typename Scene<Float, Spectrum>::Ray3f, Spectrum>
+Scene<Float, Spectrum>::sample_emitter_ray(Float time, Float sample1, const Point2f &sample2,
+                                           const Point2f &sample3, Mask active) const {
+    MTS_MASKED_FUNCTION(ProfilerPhase::SampleEmitterRay, active);
+
+    using EmitterPtr = replace_scalar_t<Float, Emitter*>;
+
+    if (unlikely(m_emitters.empty()))
+        return { zero<Ray3f>(), 0.f };
+
+    if (m_emitters.size() == 1) {
+        // Fast path if there is only one emitter
+        return m_emitters[0]->sample_ray(time, sample1, sample2, sample3, active);
+    }
+
+    UInt32 index;
+    Float emitter_pdf;
+    if (!m_emitter_distr.empty()) {
+        // Pick an emitter proportionally to its power
+        std::tie(index, sample1, emitter_pdf) =
+            m_emitter_distr.sample_reuse_pmf(sample1, active);
+    } else {
+        // Randomly pick an emitter, and rescale the sample to lie in [0, 1) again
+        emitter_pdf = 1.f / m_emitters.size();
+        index = min(UInt32(sample1 * (ScalarFloat) m_emitters.size()),
+                    (uint32_t) m_emitters.size() - 1);
+        sample1 = (sample1 - index * emitter_pdf) * m_emitters.size();
+    }
+
+    EmitterPtr emitter = gather<EmitterPtr>(m_emitters.data(), index, active);
+    auto [ray, spec] = emitter->sample_ray(time, sample1, sample2, sample3, active);
+
+    // Account for the discrete probability of sampling this emitter
+    return { ray, spec * select(active && emitter_pdf > 0.f, rcp(emitter_pdf), 0.f) };
+}
+
 MTS_VARIANT std::pair<typename Scene<Float, Spectrum>::DirectionSample3f, Spectrum>
 Scene<Float, Spectrum>::sample_emitter_direction(const Interaction3f &ref, const Point2f &sample_,
                                                  bool test_visibility, Mask active) const {
@@ -176,6 +457,34 @@ Scene<Float, Spectrum>::sample_emitter_direction(const Interaction3f &ref, const
         if (m_emitters.size() == 1) {
             // Fast path if there is only one emitter
             std::tie(ds, spec) = m_emitters[0]->sample_direction(ref, sample, active);
+        } else if (m_light_bvh) {
+            // Pick an emitter according to its estimated contribution
+            auto [index, emitter_pdf, sample_x] = m_light_bvh->sample(ref, sample.x(), active);
+            active &= emitter_pdf > 0.f;
+            sample.x() = sample_x;
+
+            EmitterPtr emitter = gather<EmitterPtr>(m_emitters.data(), index, active);
+
+            // Sample a direction towards the emitter
+            std::tie(ds, spec) = emitter->sample_direction(ref, sample, active);
+
+            // Account for the discrete probability of sampling this emitter
+            ds.pdf = select(active, ds.pdf * emitter_pdf, 0.f);
+            spec *= select(active, rcp(emitter_pdf), 0.f);
+        } else if (!m_emitter_distr.empty()) {
+            // Pick an emitter proportionally to its power
+            auto [index, sample_x, emitter_pdf] =
+                m_emitter_distr.sample_reuse_pmf(sample.x(), active);
+            sample.x() = sample_x;
+
+            EmitterPtr emitter = gather<EmitterPtr>(m_emitters.data(), index, active);
+
+            // Sample a direction towards the emitter
+            std::tie(ds, spec) = emitter->sample_direction(ref, sample, active);
+
+            // Account for the discrete probability of sampling this emitter
+            ds.pdf *= emitter_pdf;
+            spec *= rcp(emitter_pdf);
         } else {
             ScalarFloat emitter_pdf = 1.f / m_emitters.size();
 
@@ -213,6 +522,33 @@ Scene<Float, Spectrum>::sample_emitter_direction(const Interaction3f &ref, const
     return { ds, spec };
 }
 
+MTS_VARIANT void
+Scene<Float, Spectrum>::sample_emitter_directions(const Interaction3f &ref, const Point2f *samples,
+                                                  size_t count, DirectionSample3f *ds, Spectrum *spec,
+                                                  bool test_visibility, Mask active) const {
+    // Draw all samples first, so that the shadow rays are traced back to back
+    for (size_t i = 0; i < count; ++i)
+        std::tie(ds[i], spec[i]) = sample_emitter_direction(ref, samples[i], false, active);
+
+    if (test_visibility)
+        ray_test_emitter_directions(ref, ds, count, spec, active);
+}
+
+MTS_VARIANT void
+Scene<Float, Spectrum>::ray_test_emitter_directions(const Interaction3f &ref,
+                                                    const DirectionSample3f *ds, size_t count,
+                                                    Spectrum *values, Mask active) const {
+    for (size_t i = 0; i < count; ++i) {
+        Mask active_i = active && neq(ds[i].pdf, 0.f) && any(neq(depolarize(values[i]), 0.f));
+        if (none_or<false>(active_i))
+            continue;
+
+        Ray3f ray(ref.p, ds[i].d, math::RayEpsilon<Float> * (1.f + hmax(abs(ref.p))),
+                  ds[i].dist * (1.f - math::ShadowEpsilon<Float>), ref.time, ref.wavelengths);
+        values[i][ray_test(ray, active_i)] = 0.f;
+    }
+}
+
 MTS_VARIANT Float
 Scene<Float, Spectrum>::pdf_emitter_direction(const Interaction3f &ref,
                                               const DirectionSample3f &ds,
@@ -224,6 +560,14 @@ Scene<Float, Spectrum>::pdf_emitter_direction(const Interaction3f &ref,
     if (m_emitters.size() == 1) {
         // Fast path if there is only one emitter
         return m_emitters[0]->pdf_direction(ref, ds, active);
+    } else if (m_light_bvh) {
+        EmitterPtr emitter = reinterpret_array<EmitterPtr>(ds.object);
+        return emitter->pdf_direction(ref, ds, active) *
+               m_light_bvh->pdf(ref, emitter->index(active), active);
+    } else if (!m_emitter_distr.empty()) {
+        EmitterPtr emitter = reinterpret_array<EmitterPtr>(ds.object);
+        return emitter->pdf_direction(ref, ds, active) *
+               m_emitter_distr.eval_pmf_normalized(emitter->index(active), active);
     } else {
         return reinterpret_array<EmitterPtr>(ds.object)->pdf_direction(ref, ds, active) *
             (1.f / m_emitters.size());
@@ -239,24 +583,83 @@ MTS_VARIANT void Scene<Float, Spectrum>::traverse(TraversalCallback *callback) {
     }
 }
 
+MTS_VARIANT bool
+Scene<Float, Spectrum>::accel_refit_only(const std::vector<uint32_t> &changed_shapes) const {
+    if (changed_shapes.empty())
+        return false;
+    for (uint32_t i : changed_shapes) {
+        const Shape *shape = m_shapes[i].get();
+        if (!shape->is_mesh() || !shape->accel_refit())
+            return false;
+    }
+    return true;
+}
+
 MTS_VARIANT void Scene<Float, Spectrum>::parameters_changed(const std::vector<std::string> &keys) {
-    if (m_environment)
-        m_environment->set_scene(this); // TODO use parameters_changed({"scene"})
-
-    bool update_accel = false;
-    for (auto &s : m_shapes) {
-        if (string::contains(keys, s->id()) || string::contains(keys, s->class_()->name())) {
-            update_accel = true;
-            break;
-        }
+    auto modified = [&](const Object *obj) {
+        return keys.empty() || string::contains(keys, obj->id()) ||
+               string::contains(keys, obj->class_()->name());
+    };
+
+    /* Instances must be refreshed when the geometry of their shape group was
+       modified, since the group's bounding box (and, with Embree, its BVH)
+       may have changed */
+    bool shapegroup_changed = false;
+    for (auto &s : m_shapegroups) {
+        shapegroup_changed |= modified(s.get()) && s->geometry_dirty();
+        s->clear_dirty();
+    }
+
+    /* Shapes report which derived data their changes invalidated, so that
+       e.g. modifying a BSDF or a texture neither rebuilds the acceleration
+       data structure nor the emitter sampling distributions */
+    std::vector<uint32_t> changed_shapes, changed_emitters;
+    for (uint32_t i = 0; i < (uint32_t) m_shapes.size(); ++i) {
+        Shape *shape = m_shapes[i].get();
+        bool changed = modified(shape);
+        bool instance_changed = shapegroup_changed && shape->is_instance();
+        if ((changed && shape->geometry_dirty()) || instance_changed)
+            changed_shapes.push_back(i);
+        if (((changed && shape->emitter_dirty()) || instance_changed) && shape->is_emitter())
+            changed_emitters.push_back(shape->emitter()->index());
+        shape->clear_dirty();
     }
 
-    if (update_accel) {
+    if (!changed_shapes.empty() || shapegroup_changed) {
+        m_bbox.reset();
+        for (auto &s : m_shapes)
+            m_bbox.expand(s->bbox());
+
         if constexpr (is_cuda_array_v<Float>)
-            accel_parameters_changed_gpu();
-        else {
-            // TODO update Embree BVH or Mitsuba kdtree if necessary
+            accel_parameters_changed_gpu(changed_shapes);
+        else
+            accel_parameters_changed_cpu(changed_shapes);
+
+        // The environment emitter depends on the bounding sphere of the scene
+        if (m_environment) {
+            m_environment->set_scene(this); // TODO use parameters_changed({"scene"})
+            changed_emitters.push_back(m_environment->index());
         }
+        for (auto &sensor : m_sensors)
+            sensor->set_scene(this);
+    }
+
+    for (auto &e : m_emitters) {
+        if (!e->shape() && modified(e.get()))
+            changed_emitters.push_back(e->index());
+    }
+
+    /* The power and bounds of the changed emitters may differ: only update
+       their entries of the emitter sampling structures, which leaves the
+       acceleration data structure untouched */
+    if (!changed_emitters.empty()) {
+        std::sort(changed_emitters.begin(), changed_emitters.end());
+        changed_emitters.erase(std::unique(changed_emitters.begin(), changed_emitters.end()),
+                               changed_emitters.end());
+        if (m_light_bvh && !m_light_bvh->refit(m_emitters, changed_emitters))
+            m_light_bvh = new LightBVH(m_emitters);
+        if (!m_emitter_distr.empty())
+            build_emitter_distr(changed_emitters);
     }
 
     // Checks whether any of the shape's parameters require gradient
@@ -269,6 +672,16 @@ MTS_VARIANT void Scene<Float, Spectrum>::parameters_changed(const std::vector<st
     }
 }
 
+MTS_VARIANT std::string Scene<Float, Spectrum>::accel_name() const {
+    if constexpr (is_cuda_array_v<Float>)
+        return "optix";
+#if defined(MTS_ENABLE_EMBREE)
+    return "embree";
+#else
+    return m_accel_bvh ? "bvh" : "kdtree";
+#endif
+}
+
 MTS_VARIANT std::string Scene<Float, Spectrum>::to_string() const {
     std::ostringstream oss;
     oss << "Scene[" << std::endl
@@ -1,4 +1,5 @@
 #include <embree3/rtcore.h>
+#include <atomic>
 
 NAMESPACE_BEGIN(mitsuba)
 
@@ -21,21 +22,98 @@ NAMESPACE_BEGIN(mitsuba)
 
 static RTCDevice __embree_device = nullptr;
 
-MTS_VARIANT void Scene<Float, Spectrum>::accel_init_cpu(const Properties &/*props*/) {
+/// Memory currently allocated by Embree (tracked by the device memory monitor)
+static std::atomic<int64_t> __embree_memory { 0 };
+
+static bool embree_memory_monitor(void * /* ptr */, ssize_t bytes, bool /* post */) {
+    __embree_memory += (int64_t) bytes;
+    return true;
+}
+
+MTS_VARIANT void Scene<Float, Spectrum>::accel_init_cpu(const Properties &props) {
     static_assert(is_float_v<scalar_t<Float>>, "Embree is not supported in double precision mode.");
-    if (!__embree_device)
+    if (!__embree_device) {
         __embree_device = rtcNewDevice("");
+        rtcSetDeviceMemoryMonitorFunction(__embree_device, embree_memory_monitor, nullptr);
+    }
+
+    /* Embree: Quality of the top-level BVH ("low", "medium" or "high"). Lower
+       qualities build faster (e.g. for previews), at the cost of slower
+       traversal. Refitting is selected per mesh (see \ref Shape::accel_refit()) */
+    std::string quality = string::to_lower(props.string("embree_build_quality", "medium"));
+    RTCBuildQuality build_quality;
+    if (quality == "low")
+        build_quality = RTC_BUILD_QUALITY_LOW;
+    else if (quality == "medium")
+        build_quality = RTC_BUILD_QUALITY_MEDIUM;
+    else if (quality == "high")
+        build_quality = RTC_BUILD_QUALITY_HIGH;
+    else if (quality == "refit")
+        Throw("Embree only refits geometries: set \"accel_refit\" on the meshes "
+              "to be refitted instead of \"embree_build_quality\".");
+    else
+        Throw("Invalid \"embree_build_quality\" value \"%s\", must be one of: "
+              "\"low\", \"medium\", or \"high\"", quality);
+
+    /* Embree: Scene flags. "embree_compact" reduces the memory footprint at
+       the cost of slower traversal, "embree_robust" avoids optimizations that
+       reduce the arithmetic accuracy, and "embree_dynamic" optimizes the
+       scene for frequent updates (see \ref parameters_changed()) */
+    int scene_flags = RTC_SCENE_FLAG_NONE;
+    if (props.bool_("embree_compact", false))
+        scene_flags |= RTC_SCENE_FLAG_COMPACT;
+    if (props.bool_("embree_robust", false))
+        scene_flags |= RTC_SCENE_FLAG_ROBUST;
+    if (props.bool_("embree_dynamic", true))
+        scene_flags |= RTC_SCENE_FLAG_DYNAMIC;
+
+    if (props.bool_("occluder_cache", false))
+        Log(Warn, "The occluder cache is not supported by the Embree backend, ignoring.");
 
     Timer timer;
+    int64_t memory = __embree_memory;
     RTCScene embree_scene = rtcNewScene(__embree_device);
-    rtcSetSceneFlags(embree_scene, RTC_SCENE_FLAG_DYNAMIC);
+    rtcSetSceneFlags(embree_scene, (RTCSceneFlags) scene_flags);
+    rtcSetSceneBuildQuality(embree_scene, build_quality);
     m_accel = embree_scene;
 
     for (Shape *shape : m_shapes)
          rtcAttachGeometry(embree_scene, shape->embree_geometry(__embree_device));
 
     rtcCommitScene(embree_scene);
-    Log(Info, "Embree ready. (took %s)", util::time_string(timer.value()));
+    Log(Info, "Embree ready. (%s quality%s%s%s, %s of storage, took %s)", quality,
+        (scene_flags & RTC_SCENE_FLAG_COMPACT) ? ", compact" : "",
+        (scene_flags & RTC_SCENE_FLAG_ROBUST) ? ", robust" : "",
+        (scene_flags & RTC_SCENE_FLAG_DYNAMIC) ? ", dynamic" : "",
+        util::mem_string((size_t) std::max(__embree_memory - memory, (int64_t) 0)),
+        util::time_string(timer.value()));
+}
+
+MTS_VARIANT void Scene<Float, Spectrum>::accel_parameters_changed_cpu(
+    const std::vector<uint32_t> &changed_shapes) {
+    RTCScene embree_scene = (RTCScene) m_accel;
+    Timer timer;
+
+    // Geometry IDs match the shape indices (see accel_init_cpu())
+    for (uint32_t i : changed_shapes) {
+        Shape *shape = m_shapes[i].get();
+        if (shape->is_mesh() && shape->accel_refit()) {
+            // Refit the existing geometry (built with RTC_BUILD_QUALITY_REFIT)
+            ((Mesh *) shape)->embree_update_geometry(rtcGetGeometry(embree_scene, i));
+            continue;
+        }
+
+        RTCGeometry geom = shape->embree_geometry(__embree_device);
+        rtcDetachGeometry(embree_scene, i);
+        rtcAttachGeometryByID(embree_scene, geom, i);
+        rtcReleaseGeometry(geom);
+    }
+
+    rtcCommitScene(embree_scene);
+    Log(Debug, "Embree updated %i shapes. (%s of storage in use, took %s)",
+        changed_shapes.size(),
+        util::mem_string((size_t) std::max(__embree_memory.load(), (int64_t) 0)),
+        util::time_string(timer.value()));
 }
 
 MTS_VARIANT void Scene<Float, Spectrum>::accel_release_cpu() {
@@ -262,6 +340,97 @@ Scene<Float, Spectrum>::ray_intersect_cpu(const Ray3f &ray, HitComputeFlags flag
     }
 }
 
+MTS_VARIANT typename Scene<Float, Spectrum>::DynamicPreliminaryIntersection3f
+Scene<Float, Spectrum>::ray_intersect_batch_cpu(const DynamicRay3f &rays) const {
+    if constexpr (is_array_v<Float> && !is_cuda_array_v<Float>) {
+        using DynamicFloat  = make_dynamic_t<Float>;
+        using DynamicUInt32 = make_dynamic_t<UInt32>;
+        using ShapePtr      = replace_scalar_t<Float, const Shape *>;
+
+        size_t count = slices(rays);
+        DynamicPreliminaryIntersection3f result;
+        set_slices(result, count);
+        if (count == 0)
+            return result;
+
+        RTCIntersectContext context;
+        rtcInitIntersectContext(&context);
+        context.flags = RTC_INTERSECT_CONTEXT_FLAG_INCOHERENT;
+
+        /* The ray stream is passed in structure-of-arrays layout: Embree reads
+           the origins, directions and extents from the buffers of 'rays',
+           and only writes to 'tfar' and to the hit buffers */
+        DynamicFloat tfar(rays.maxt), ng_x, ng_y, ng_z, u, v;
+        DynamicUInt32 zeros = zero<DynamicUInt32>(count), prim_id,
+                      geom_id = full<DynamicUInt32>(RTC_INVALID_GEOMETRY_ID, count),
+                      inst_id[RTC_MAX_INSTANCE_LEVEL_COUNT];
+        for (DynamicFloat *buf : { &ng_x, &ng_y, &ng_z, &u, &v })
+            set_slices(*buf, count);
+        set_slices(prim_id, count);
+
+        auto w = [](const DynamicFloat &buf) { return const_cast<float *>(buf.data()); };
+
+        RTCRayHitNp rh;
+        rh.ray.org_x = w(rays.o.x()); rh.ray.org_y = w(rays.o.y()); rh.ray.org_z = w(rays.o.z());
+        rh.ray.dir_x = w(rays.d.x()); rh.ray.dir_y = w(rays.d.y()); rh.ray.dir_z = w(rays.d.z());
+        rh.ray.tnear = w(rays.mint);
+        rh.ray.tfar  = tfar.data();
+        rh.ray.time  = w(rays.time);
+        rh.ray.mask  = rh.ray.id = rh.ray.flags = zeros.data();
+        rh.hit.Ng_x = ng_x.data(); rh.hit.Ng_y = ng_y.data(); rh.hit.Ng_z = ng_z.data();
+        rh.hit.u = u.data(); rh.hit.v = v.data();
+        rh.hit.primID = prim_id.data();
+        rh.hit.geomID = geom_id.data();
+        for (size_t l = 0; l < RTC_MAX_INSTANCE_LEVEL_COUNT; ++l) {
+            inst_id[l] = full<DynamicUInt32>(RTC_INVALID_GEOMETRY_ID, count);
+            rh.hit.instID[l] = inst_id[l].data();
+        }
+
+        rtcIntersectNp((RTCScene) m_accel, &context, &rh, (unsigned int) count);
+
+        ScopedPhase sp(ProfilerPhase::CreateSurfaceInteraction);
+        for (size_t i = 0; i < count; i += Float::Size) {
+            UInt32 index = arange<UInt32>() + (uint32_t) i;
+            Mask active = index < (uint32_t) count;
+
+            Float t = gather<Float>(tfar, index, active);
+            Mask hit = active && neq(gather<UInt32>(geom_id, index, active),
+                                     RTC_INVALID_GEOMETRY_ID);
+
+            PreliminaryIntersection3f pi = zero<PreliminaryIntersection3f>();
+            pi.t = select(hit, t, math::Infinity<Float>);
+
+            if (any(hit)) {
+                UInt32 shape_index = gather<UInt32>(geom_id, index, hit);
+
+                // We get level 0 because we only support one level of instancing
+                UInt32 inst_index = gather<UInt32>(inst_id[0], index, hit);
+
+                Mask hit_not_inst = hit &&  eq(inst_index, RTC_INVALID_GEOMETRY_ID);
+                Mask hit_inst     = hit && neq(inst_index, RTC_INVALID_GEOMETRY_ID);
+
+                // Set si.instance and si.shape
+                ShapePtr shape = gather<ShapePtr>(m_shapes.data(),
+                                                  select(hit_inst, inst_index, shape_index), hit);
+                masked(pi.instance, hit_inst)  = shape;
+                masked(pi.shape, hit_not_inst) = shape;
+
+                pi.prim_index  = gather<UInt32>(prim_id, index, hit);
+                pi.shape_index = shape_index;
+                pi.prim_uv = Point2f(gather<Float>(u, index, hit),
+                                     gather<Float>(v, index, hit));
+            }
+
+            scatter(result, pi, index, active);
+        }
+
+        return result;
+    } else {
+        ENOKI_MARK_USED(rays);
+        Throw("ray_intersect_batch_cpu() should only be called in CPU packet mode.");
+    }
+}
+
 MTS_VARIANT typename Scene<Float, Spectrum>::Mask
 Scene<Float, Spectrum>::ray_test_cpu(const Ray3f &ray, Mask active) const {
     if constexpr (!is_cuda_array_v<Float>) {
@@ -1,30 +1,157 @@
 NAMESPACE_BEGIN(mitsuba)
 
 MTS_VARIANT void Scene<Float, Spectrum>::accel_init_cpu(const Properties &props) {
-    ShapeKDTree *kdtree = new ShapeKDTree(props);
-    kdtree->inc_ref();
-    for (Shape *shape : m_shapes)
-        kdtree->add_shape(shape);
-    kdtree->build();
-    m_accel = kdtree;
+    /* Acceleration data structure: "kdtree" (SAH kd-tree, default) or "bvh"
+       (binned SAH BVH with SIMD-wide nodes, see \ref ShapeBVH) */
+    std::string accel = string::to_lower(props.string("accel", "kdtree"));
+
+    /* Place the instances in a separate top-level BVH when using a kd-tree
+       (see \ref m_instance_accel) */
+    bool instance_bvh = props.bool_("instance_bvh", true);
+
+    /* Test the previous occluder of each thread before tracing shadow rays
+       (see \ref ray_test()) */
+    if (props.bool_("occluder_cache", false))
+        m_occluder_cache = new ThreadLocal<OccluderCache>();
+
+    accel_build_shapegroups();
+
+    if (accel == "bvh") {
+        ShapeBVH *bvh = new ShapeBVH(props);
+        bvh->inc_ref();
+        for (Shape *shape : m_shapes)
+            bvh->add_shape(shape);
+        bvh->build();
+        m_accel = bvh;
+        m_accel_bvh = true;
+    } else if (accel == "kdtree") {
+        ShapeKDTree *kdtree = new ShapeKDTree(props);
+        kdtree->inc_ref();
+        for (Shape *shape : m_shapes) {
+            if (instance_bvh && shape->is_instance()) {
+                if (!m_instance_accel) {
+                    m_instance_accel = new ShapeBVH(props);
+                    m_instance_accel->inc_ref();
+                }
+                m_instance_accel->add_shape(shape);
+            } else {
+                kdtree->add_shape(shape);
+            }
+        }
+        kdtree->build();
+        if (m_instance_accel)
+            m_instance_accel->build();
+        m_accel = kdtree;
+    } else {
+        Throw("Invalid acceleration data structure \"%s\": must be \"kdtree\" or \"bvh\".",
+              accel);
+    }
+}
+
+MTS_VARIANT void Scene<Float, Spectrum>::accel_build_shapegroups() {
+    if (m_shapegroups.empty())
+        return;
+
+    /* Start with the largest groups, so that the small ones fill the gaps at
+       the end. Threads that run out of groups help with the parallel parts of
+       the builds that are still running. */
+    std::vector<ShapeGroup *> groups;
+    for (auto &shapegroup : m_shapegroups)
+        groups.push_back(shapegroup.get());
+    std::stable_sort(groups.begin(), groups.end(), [](ShapeGroup *a, ShapeGroup *b) {
+        return a->primitive_count() > b->primitive_count();
+    });
+
+    Timer timer;
+    std::atomic<size_t> next { 0 };
+    size_t workers = std::min(groups.size(), (size_t) tbb::this_task_arena::max_concurrency());
+    tbb::parallel_for(
+        tbb::blocked_range<size_t>(0, workers, 1),
+        [&](const tbb::blocked_range<size_t> &range) {
+            for (size_t w = range.begin(); w != range.end(); ++w) {
+                for (size_t i = next++; i < groups.size(); i = next++) {
+                    /* Isolate the build: a thread waiting for a part of it must
+                       not start another group, whose allocators it would share */
+                    tbb::this_task_arena::isolate([&] { groups[i]->accel_build(); });
+                }
+            }
+        });
+
+    Log(Info, "Built the kd-trees of %i shape groups (took %s)", groups.size(),
+        util::time_string(timer.value()));
+}
+
+MTS_VARIANT void Scene<Float, Spectrum>::accel_parameters_changed_cpu(
+    const std::vector<uint32_t> &changed_shapes) {
+    /* The cached occluders may refer to primitives that no longer exist (or
+       have moved). No rays are traced concurrently, hence clearing is safe. */
+    if (m_occluder_cache)
+        m_occluder_cache->clear();
+
+    bool instances_changed = false, others_changed = false;
+    for (uint32_t i : changed_shapes) {
+        if (m_instance_accel && m_shapes[i]->is_instance())
+            instances_changed = true;
+        else
+            others_changed = true;
+    }
+
+    if (instances_changed)
+        m_instance_accel->rebuild();
+
+    if (!others_changed)
+        return;
+
+    if (m_accel_bvh && accel_refit_only(changed_shapes))
+        ((ShapeBVH *) m_accel)->refit();
+    else if (m_accel_bvh)
+        ((ShapeBVH *) m_accel)->rebuild();
+    else
+        ((ShapeKDTree *) m_accel)->rebuild();
 }
 
 MTS_VARIANT void Scene<Float, Spectrum>::accel_release_cpu() {
-    ((ShapeKDTree *) m_accel)->dec_ref();
+    if (m_accel_bvh)
+        ((ShapeBVH *) m_accel)->dec_ref();
+    else
+        ((ShapeKDTree *) m_accel)->dec_ref();
     m_accel = nullptr;
+
+    if (m_instance_accel) {
+        m_instance_accel->dec_ref();
+        m_instance_accel = nullptr;
+    }
+
+    delete m_occluder_cache;
+    m_occluder_cache = nullptr;
 }
 
 MTS_VARIANT typename Scene<Float, Spectrum>::PreliminaryIntersection3f
 Scene<Float, Spectrum>::ray_intersect_preliminary_cpu(const Ray3f &ray, Mask active) const {
-    const ShapeKDTree *kdtree = (const ShapeKDTree *) m_accel;
-    return kdtree->template ray_intersect_preliminary<false>(ray, active);
+    PreliminaryIntersection3f pi;
+    if (m_accel_bvh) {
+        const ShapeBVH *bvh = (const ShapeBVH *) m_accel;
+        pi = bvh->template ray_intersect_preliminary<false>(ray, active);
+    } else {
+        const ShapeKDTree *kdtree = (const ShapeKDTree *) m_accel;
+        pi = kdtree->template ray_intersect_preliminary<false>(ray, active);
+    }
+
+    if (m_instance_accel) {
+        // Only look for instances in front of the closest hit so far
+        Ray3f ray_inst(ray);
+        masked(ray_inst.maxt, pi.is_valid()) = pi.t;
+        PreliminaryIntersection3f pi_inst =
+            m_instance_accel->template ray_intersect_preliminary<false>(ray_inst, active);
+        masked(pi, pi_inst.is_valid()) = pi_inst;
+    }
+
+    return pi;
 }
 
 MTS_VARIANT typename Scene<Float, Spectrum>::SurfaceInteraction3f
 Scene<Float, Spectrum>::ray_intersect_cpu(const Ray3f &ray, HitComputeFlags flags, Mask active) const {
-    const ShapeKDTree *kdtree = (const ShapeKDTree *) m_accel;
-
-    PreliminaryIntersection3f pi = kdtree->template ray_intersect_preliminary<false>(ray, active);
+    PreliminaryIntersection3f pi = ray_intersect_preliminary_cpu(ray, active);
     active &= pi.is_valid();
 
     SurfaceInteraction3f si;
@@ -42,9 +169,19 @@ Scene<Float, Spectrum>::ray_intersect_cpu(const Ray3f &ray, HitComputeFlags flag
 
 MTS_VARIANT typename Scene<Float, Spectrum>::SurfaceInteraction3f
 Scene<Float, Spectrum>::ray_intersect_naive_cpu(const Ray3f &ray, Mask active) const {
-    const ShapeKDTree *kdtree = (const ShapeKDTree *) m_accel;
+    PreliminaryIntersection3f pi;
+    if (m_accel_bvh)
+        pi = ((const ShapeBVH *) m_accel)->template ray_intersect_naive<false>(ray, active);
+    else
+        pi = ((const ShapeKDTree *) m_accel)->template ray_intersect_naive<false>(ray, active);
 
-    auto pi = kdtree->template ray_intersect_naive<false>(ray, active);
+    if (m_instance_accel) {
+        Ray3f ray_inst(ray);
+        masked(ray_inst.maxt, pi.is_valid()) = pi.t;
+        PreliminaryIntersection3f pi_inst =
+            m_instance_accel->template ray_intersect_naive<false>(ray_inst, active);
+        masked(pi, pi_inst.is_valid()) = pi_inst;
+    }
     active &= pi.is_valid();
 
     SurfaceInteraction3f si;
@@ -62,8 +199,66 @@ Scene<Float, Spectrum>::ray_intersect_naive_cpu(const Ray3f &ray, Mask active) c
 
 MTS_VARIANT typename Scene<Float, Spectrum>::Mask
 Scene<Float, Spectrum>::ray_test_cpu(const Ray3f &ray, Mask active) const {
-    const ShapeKDTree *kdtree = (ShapeKDTree *) m_accel;
-    return kdtree->template ray_intersect_preliminary<true>(ray, active).is_valid();
+    Mask hit = false;
+
+    OccluderCache *cache = nullptr;
+    if (m_occluder_cache) {
+        cache = &((OccluderCache &) *m_occluder_cache);
+        if (cache->shape) {
+            if (cache->shape->is_mesh())
+                hit = ((const Mesh *) cache->shape)->ray_intersect_triangle(
+                    cache->prim_index, ray, active).is_valid();
+            else
+                hit = cache->shape->ray_test_primitive(cache->prim_index, ray, active);
+
+            cache->queries++;
+            cache->hits += any(hit) ? 1 : 0;
+            if (cache->queries == 4096)
+                cache->flush();
+
+            active &= !hit;
+            if (none(active))
+                return hit;
+        }
+    }
+
+    PreliminaryIntersection3f pi;
+    if (m_accel_bvh) {
+        const ShapeBVH *bvh = (const ShapeBVH *) m_accel;
+        pi = bvh->template ray_intersect_preliminary<true>(ray, active);
+    } else {
+        const ShapeKDTree *kdtree = (const ShapeKDTree *) m_accel;
+        pi = kdtree->template ray_intersect_preliminary<true>(ray, active);
+    }
+    Mask pi_hit = active && pi.is_valid();
+    hit |= pi_hit;
+
+    /* Remember the occluder of the first blocked ray. Instances are not
+       cached, since testing them amounts to a full traversal. */
+    if (cache && any(pi_hit)) {
+        if constexpr (is_array_v<Float>) {
+            for (size_t i = 0; i < array_size_v<Float>; ++i) {
+                if (pi_hit.coeff(i)) {
+                    const Shape *shape = pi.shape.coeff(i);
+                    if (!shape->is_instance()) {
+                        cache->shape = shape;
+                        cache->prim_index = pi.prim_index.coeff(i);
+                    }
+                    break;
+                }
+            }
+        } else if (!pi.shape->is_instance()) {
+            cache->shape = pi.shape;
+            cache->prim_index = pi.prim_index;
+        }
+    }
+
+    // Only trace the rays that are not occluded yet through the instances
+    if (m_instance_accel && any(active && !hit))
+        hit |= m_instance_accel->template ray_intersect_preliminary<true>(
+                   ray, active && !hit).is_valid();
+
+    return hit;
 }
 
 NAMESPACE_END(mitsuba)
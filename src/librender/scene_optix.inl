@@ -1,5 +1,6 @@
 #include "librender_ptx.h"
 #include <iomanip>
+#include <mutex>
 
 #include <mitsuba/render/optix/common.h>
 #include <mitsuba/render/optix/shapes.h>
@@ -35,21 +36,44 @@ struct OptixState {
     OptixAccelData accel;
     OptixTraversableHandle ias_handle = 0ull;
     void* ias_buffer = nullptr;
+    /// Total size of the GAS and IAS owned by the scene in bytes (for the log)
+    size_t accel_size = 0;
 
     void* params;
-    char *custom_optix_shapes_program_names[2 * custom_optix_shapes_count];
 
     enoki::CUDAArray<const void*> shapes_ptr;
 };
 
-MTS_VARIANT void Scene<Float, Spectrum>::accel_init_gpu(const Properties &/*props*/) {
-    if constexpr (is_cuda_array_v<Float>) {
-        Log(Info, "Building scene in OptiX ..");
-        m_accel = new OptixState();
-        OptixState &s = *(OptixState *) m_accel;
+/**
+ * \brief OptiX context, module, program groups and pipeline
+ *
+ * They do not depend on the scene, and are thus shared by all scenes of the
+ * process: only the first one (or the first one created after all others were
+ * released) pays for the compilation of the PTX. The compiled module is
+ * additionally kept in the disk cache of OptiX (see \ref optix_configure_cache()),
+ * which speeds up the startup of later processes.
+ */
+struct OptixProgramState {
+    OptixDeviceContext context = nullptr;
+    OptixPipeline pipeline = nullptr;
+    OptixModule module = nullptr;
+    OptixProgramGroup program_groups[ProgramGroupCount];
+    char *custom_optix_shapes_program_names[2 * custom_optix_shapes_count];
 
-        // Copy shapes pointers to the GPU
-        s.shapes_ptr = enoki::CUDAArray<const void*>::copy((void**)m_shapes.data(), m_shapes.size());
+    /// Number of scenes using this state
+    size_t ref_count = 0;
+};
+
+static OptixProgramState optix_program_state;
+static std::mutex optix_program_mutex;
+
+/// Create (or reference) the shared OptiX program state and copy its handles into \c s
+static void optix_acquire_program(OptixState &s) {
+    std::lock_guard<std::mutex> guard(optix_program_mutex);
+    OptixProgramState &p = optix_program_state;
+
+    if (p.ref_count == 0) {
+        Timer timer;
 
         // ------------------------
         //  OptiX context creation
@@ -63,7 +87,8 @@ MTS_VARIANT void Scene<Float, Spectrum>::accel_init_gpu(const Properties &/*prop
     #else
         options.logCallbackLevel          = 3;
     #endif
-        rt_check(optixDeviceContextCreate(cuCtx, &options, &s.context));
+        rt_check(optixDeviceContextCreate(cuCtx, &options, &p.context));
+        optix_configure_cache(p.context);
 
         // ----------------------------------------------
         //  Pipeline generation - Create Module from PTX
@@ -98,14 +123,14 @@ MTS_VARIANT void Scene<Float, Spectrum>::accel_init_gpu(const Properties &/*prop
     #endif
 
         rt_check_log(optixModuleCreateFromPTX(
-            s.context,
+            p.context,
             &module_compile_options,
             &pipeline_compile_options,
             (const char *)optix_rt_ptx,
             optix_rt_ptx_size,
             optix_log_buffer,
             &optix_log_buffer_size,
-            &s.module
+            &p.module
         ));
 
         // ---------------------------------------------
@@ -118,45 +143,45 @@ MTS_VARIANT void Scene<Float, Spectrum>::accel_init_gpu(const Properties &/*prop
         memset(prog_group_descs, 0, sizeof(prog_group_descs));
 
         prog_group_descs[0].kind                     = OPTIX_PROGRAM_GROUP_KIND_RAYGEN;
-        prog_group_descs[0].raygen.module            = s.module;
+        prog_group_descs[0].raygen.module            = p.module;
         prog_group_descs[0].raygen.entryFunctionName = "__raygen__rg";
 
         prog_group_descs[1].kind                   = OPTIX_PROGRAM_GROUP_KIND_MISS;
-        prog_group_descs[1].miss.module            = s.module;
+        prog_group_descs[1].miss.module            = p.module;
         prog_group_descs[1].miss.entryFunctionName = "__miss__ms";
 
         prog_group_descs[2].kind                         = OPTIX_PROGRAM_GROUP_KIND_HITGROUP;
-        prog_group_descs[2].hitgroup.moduleCH            = s.module;
+        prog_group_descs[2].hitgroup.moduleCH            = p.module;
         prog_group_descs[2].hitgroup.entryFunctionNameCH = "__closesthit__mesh";
 
         for (size_t i = 0; i < custom_optix_shapes_count; i++) {
             prog_group_descs[3+i].kind                         = OPTIX_PROGRAM_GROUP_KIND_HITGROUP;
 
             std::string name = string::to_lower(custom_optix_shapes[i]);
-            s.custom_optix_shapes_program_names[2*i] = strdup(("__closesthit__" + name).c_str());
-            s.custom_optix_shapes_program_names[2*i+1] = strdup(("__intersection__" + name).c_str());
+            p.custom_optix_shapes_program_names[2*i] = strdup(("__closesthit__" + name).c_str());
+            p.custom_optix_shapes_program_names[2*i+1] = strdup(("__intersection__" + name).c_str());
 
-            prog_group_descs[3+i].hitgroup.moduleCH            = s.module;
-            prog_group_descs[3+i].hitgroup.entryFunctionNameCH = s.custom_optix_shapes_program_names[2*i];
-            prog_group_descs[3+i].hitgroup.moduleIS            = s.module;
-            prog_group_descs[3+i].hitgroup.entryFunctionNameIS = s.custom_optix_shapes_program_names[2*i+1];
+            prog_group_descs[3+i].hitgroup.moduleCH            = p.module;
+            prog_group_descs[3+i].hitgroup.entryFunctionNameCH = p.custom_optix_shapes_program_names[2*i];
+            prog_group_descs[3+i].hitgroup.moduleIS            = p.module;
+            prog_group_descs[3+i].hitgroup.entryFunctionNameIS = p.custom_optix_shapes_program_names[2*i+1];
         }
 
     #if defined(MTS_OPTIX_DEBUG)
         OptixProgramGroupDesc &exception_prog_group_desc = prog_group_descs[ProgramGroupCount-1];
         exception_prog_group_desc.kind                         = OPTIX_PROGRAM_GROUP_KIND_EXCEPTION;
-        exception_prog_group_desc.hitgroup.moduleCH            = s.module;
+        exception_prog_group_desc.hitgroup.moduleCH            = p.module;
         exception_prog_group_desc.hitgroup.entryFunctionNameCH = "__exception__err";
     #endif
 
         rt_check_log(optixProgramGroupCreate(
-            s.context,
+            p.context,
             prog_group_descs,
             ProgramGroupCount,
             &program_group_options,
             optix_log_buffer,
             &optix_log_buffer_size,
-            s.program_groups
+            p.program_groups
         ));
 
         // ---------------------------------------
@@ -172,16 +197,62 @@ MTS_VARIANT void Scene<Float, Spectrum>::accel_init_gpu(const Properties &/*prop
     #endif
         pipeline_link_options.overrideUsesMotionBlur = false;
         rt_check_log(optixPipelineCreate(
-            s.context,
+            p.context,
             &pipeline_compile_options,
             &pipeline_link_options,
-            s.program_groups,
+            p.program_groups,
             ProgramGroupCount,
             optix_log_buffer,
             &optix_log_buffer_size,
-            &s.pipeline
+            &p.pipeline
         ));
 
+        Log(Debug, "OptiX pipeline created (took %s)", util::time_string(timer.value()));
+    }
+
+    p.ref_count++;
+    s.context = p.context;
+    s.pipeline = p.pipeline;
+    s.module = p.module;
+    memcpy(s.program_groups, p.program_groups, sizeof(p.program_groups));
+}
+
+/// Release a reference to the shared OptiX program state, destroying it with the last one
+static void optix_release_program() {
+    std::lock_guard<std::mutex> guard(optix_program_mutex);
+    OptixProgramState &p = optix_program_state;
+    if (--p.ref_count > 0)
+        return;
+
+    rt_check(optixPipelineDestroy(p.pipeline));
+    for (size_t i = 0; i < ProgramGroupCount; i++)
+        rt_check(optixProgramGroupDestroy(p.program_groups[i]));
+    for (size_t i = 0; i < 2 * custom_optix_shapes_count; i++)
+        free(p.custom_optix_shapes_program_names[i]);
+    rt_check(optixModuleDestroy(p.module));
+    rt_check(optixDeviceContextDestroy(p.context));
+    p.context = nullptr;
+    p.pipeline = nullptr;
+    p.module = nullptr;
+}
+
+MTS_VARIANT void Scene<Float, Spectrum>::accel_init_gpu(const Properties &props) {
+    if constexpr (is_cuda_array_v<Float>) {
+        Log(Info, "Building scene in OptiX ..");
+        m_accel = new OptixState();
+        OptixState &s = *(OptixState *) m_accel;
+
+        /* OptiX: Compact the acceleration structures after their build
+           (\c optixAccelCompact), which usually saves a third of their
+           device memory at the cost of a slightly longer build */
+        s.accel.compact = props.bool_("optix_compact", true);
+
+        // Copy shapes pointers to the GPU
+        s.shapes_ptr = enoki::CUDAArray<const void*>::copy((void**)m_shapes.data(), m_shapes.size());
+
+        // Compile the pipeline, or reuse the one of the other scenes
+        optix_acquire_program(s);
+
         // ---------------------------------
         //  Shader Binding Table generation
         // ---------------------------------
@@ -223,7 +294,11 @@ MTS_VARIANT void Scene<Float, Spectrum>::accel_init_gpu(const Properties &/*prop
         // --------------------------------------
 
         // Build and bind GAS and IAS for all the shapes and instances in the scene
+        Timer timer;
         accel_parameters_changed_gpu();
+        Log(Info, "OptiX ready. (%s of acceleration structures%s, took %s)",
+            util::mem_string(s.accel_size), s.accel.compact ? ", compacted" : "",
+            util::time_string(timer.value()));
 
         // Allocate launch-varying OptixParams data structure
         s.params = cuda_malloc(sizeof(OptixParams));
@@ -233,17 +308,40 @@ MTS_VARIANT void Scene<Float, Spectrum>::accel_init_gpu(const Properties &/*prop
     }
 }
 
-MTS_VARIANT void Scene<Float, Spectrum>::accel_parameters_changed_gpu() {
+MTS_VARIANT void Scene<Float, Spectrum>::accel_parameters_changed_gpu(
+    const std::vector<uint32_t> &changed_shapes) {
     if constexpr (is_cuda_array_v<Float>) {
         if (m_shapes.empty())
             return;
 
         OptixState &s = *(OptixState *) m_accel;
 
-        // Build geometry acceleration structures for all the shapes
-        build_gas(s.context, m_shapes, s.accel);
+        /* The pipeline, the shader binding table and the acceleration
+           structures of unmodified shapes persist across updates. When only
+           instances changed (e.g. their transforms), all GAS are reused and
+           only the IAS are rebuilt. Otherwise, build geometry acceleration
+           structures for all the shapes, or only update the refitted meshes
+           when no other shape changed */
+        bool geometry_changed = changed_shapes.empty();
+        for (uint32_t i : changed_shapes)
+            geometry_changed |= !m_shapes[i]->is_instance();
+
+        if (geometry_changed)
+            build_gas(s.context, m_shapes, s.accel, accel_refit_only(changed_shapes));
         for (auto& shapegroup: m_shapegroups)
-            shapegroup->optix_build_gas(s.context);
+            shapegroup->optix_build_gas(s.context, s.accel.compact);
+
+        // Statistics of the GAS owned by the scene
+        s.accel_size = 0;
+        for (const OptixAccelData::HandleData *h : { &s.accel.meshes, &s.accel.meshes_refit,
+                                                     &s.accel.others })
+            s.accel_size += h->size;
+
+        // Release the previous "master" IAS
+        if (s.ias_buffer) {
+            DeviceMemoryPool::free(s.ias_buffer);
+            s.ias_buffer = nullptr;
+        }
 
         // Gather information about the instance acceleration structures to be built
         std::vector<OptixInstance> ias;
@@ -252,7 +350,6 @@ MTS_VARIANT void Scene<Float, Spectrum>::accel_parameters_changed_gpu() {
 
         // If there is only a single IAS, no need to build the "master" IAS
         if (ias.size() == 1) {
-            s.ias_buffer = nullptr;
             s.ias_handle = ias[0].traversableHandle;
             return;
         }
@@ -260,11 +357,13 @@ MTS_VARIANT void Scene<Float, Spectrum>::accel_parameters_changed_gpu() {
         // Build a "master" IAS that contains all the IAS of the scene (meshes,
         // custom shapes, instances, ...)
         OptixAccelBuildOptions accel_options = {};
-        accel_options.buildFlags = OPTIX_BUILD_FLAG_ALLOW_COMPACTION | OPTIX_BUILD_FLAG_PREFER_FAST_TRACE;
+        accel_options.buildFlags = OPTIX_BUILD_FLAG_PREFER_FAST_TRACE;
+        if (s.accel.compact)
+            accel_options.buildFlags |= OPTIX_BUILD_FLAG_ALLOW_COMPACTION;
         accel_options.operation  = OPTIX_BUILD_OPERATION_BUILD;
         accel_options.motionOptions.numKeys = 0;
 
-        void* d_ias = cuda_malloc(ias.size() * sizeof(OptixInstance));
+        void* d_ias = DeviceMemoryPool::malloc(ias.size() * sizeof(OptixInstance));
         cuda_memcpy_to_device(d_ias, ias.data(), ias.size() * sizeof(OptixInstance));
 
         OptixBuildInput build_input;
@@ -276,8 +375,12 @@ MTS_VARIANT void Scene<Float, Spectrum>::accel_parameters_changed_gpu() {
 
         OptixAccelBufferSizes buffer_sizes;
         rt_check(optixAccelComputeMemoryUsage(s.context, &accel_options, &build_input, 1, &buffer_sizes));
-        void* d_temp_buffer = cuda_malloc(buffer_sizes.tempSizeInBytes);
-        s.ias_buffer    = cuda_malloc(buffer_sizes.outputSizeInBytes);
+        void* d_temp_buffer = DeviceMemoryPool::malloc(buffer_sizes.tempSizeInBytes);
+        s.ias_buffer    = DeviceMemoryPool::malloc(buffer_sizes.outputSizeInBytes + 8);
+
+        OptixAccelEmitDesc emit_property = {};
+        emit_property.type   = OPTIX_PROPERTY_TYPE_COMPACTED_SIZE;
+        emit_property.result = (CUdeviceptr)((char*)s.ias_buffer + buffer_sizes.outputSizeInBytes);
 
         rt_check(optixAccelBuild(
             s.context,
@@ -290,12 +393,33 @@ MTS_VARIANT void Scene<Float, Spectrum>::accel_parameters_changed_gpu() {
             (CUdeviceptr)s.ias_buffer,
             buffer_sizes.outputSizeInBytes,
             &s.ias_handle,
-            0, // emitted property list
-            0  // num emitted properties
+            s.accel.compact ? &emit_property : nullptr, // emitted property list
+            s.accel.compact ? 1u : 0u                   // num emitted properties
         ));
 
-        cuda_free(d_temp_buffer);
-        cuda_free(d_ias);
+        DeviceMemoryPool::free(d_temp_buffer);
+        DeviceMemoryPool::free(d_ias);
+
+        size_t ias_size = buffer_sizes.outputSizeInBytes;
+        if (s.accel.compact) {
+            size_t compact_size;
+            cuda_memcpy_from_device(&compact_size, (void*)emit_property.result, sizeof(size_t));
+            if (compact_size < ias_size) {
+                void* compact_buffer = DeviceMemoryPool::malloc(compact_size);
+                rt_check(optixAccelCompact(
+                    s.context,
+                    0, // CUDA stream
+                    s.ias_handle,
+                    (CUdeviceptr)compact_buffer,
+                    compact_size,
+                    &s.ias_handle
+                ));
+                DeviceMemoryPool::free(s.ias_buffer);
+                s.ias_buffer = compact_buffer;
+                ias_size = compact_size;
+            }
+        }
+        s.accel_size += ias_size;
     }
 }
 
@@ -304,14 +428,8 @@ MTS_VARIANT void Scene<Float, Spectrum>::accel_release_gpu() {
         OptixState &s = *(OptixState *) m_accel;
         cuda_free((void*)s.sbt.raygenRecord);
         cuda_free((void*)s.params);
-        cuda_free(s.ias_buffer);
-        rt_check(optixPipelineDestroy(s.pipeline));
-        for (size_t i = 0; i < ProgramGroupCount; i++)
-            rt_check(optixProgramGroupDestroy(s.program_groups[i]));
-        for (size_t i = 0; i < 2 * custom_optix_shapes_count; i++)
-            free(s.custom_optix_shapes_program_names[i]);
-        rt_check(optixModuleDestroy(s.module));
-        rt_check(optixDeviceContextDestroy(s.context));
+        DeviceMemoryPool::free(s.ias_buffer);
+        optix_release_program();
 
         delete (OptixState *) m_accel;
         m_accel = nullptr;
@@ -323,7 +441,9 @@ void launch_optix_kernel(const OptixState &s,
                          const OptixParams &params,
                          size_t ray_count) {
 
-    cuda_memcpy_to_device(s.params, &params, sizeof(OptixParams));
+    /* Upload the parameters in stream order: the host does not wait for
+       kernels that are still in flight and use the previous contents. */
+    cuda_memcpy_to_device_async(s.params, &params, sizeof(OptixParams));
 
     unsigned int width = 1, height = (unsigned int) ray_count;
     while (!(height & 1) && width < height) {
@@ -342,7 +462,7 @@ void launch_optix_kernel(const OptixState &s,
         1u // depth
     );
     if (rt == OPTIX_ERROR_HOST_OUT_OF_MEMORY) {
-        cuda_malloc_trim();
+        DeviceMemoryPool::trim();
         rt = optixLaunch(
             s.pipeline,
             0, // default cuda stream
@@ -424,7 +544,9 @@ Scene<Float, Spectrum>::ray_intersect_preliminary_gpu(const Ray3f &ray_, Mask ac
 }
 
 MTS_VARIANT typename Scene<Float, Spectrum>::SurfaceInteraction3f
-Scene<Float, Spectrum>::ray_intersect_gpu(const Ray3f &ray_, HitComputeFlags flags, Mask active) const {
+Scene<Float, Spectrum>::ray_intersect_gpu(const Ray3f &ray_, HitComputeFlags flags, Mask active,
+                                          const Ray3f *shadow_ray_, Mask shadow_active,
+                                          Mask *shadow_hit) const {
     if constexpr (is_cuda_array_v<Float>) {
         Assert(!m_shapes.empty());
         OptixState &s = *(OptixState *) m_accel;
@@ -433,6 +555,8 @@ Scene<Float, Spectrum>::ray_intersect_gpu(const Ray3f &ray_, HitComputeFlags fla
             // Differentiable SurfaceInteraction needs to be computed outside of the OptiX kernel
             if (!has_flag(flags, HitComputeFlags::NonDifferentiable) &&
                 (requires_gradient(ray_.o) || shapes_grad_enabled())) {
+                if (shadow_ray_)
+                    *shadow_hit = ray_test_gpu(*shadow_ray_, shadow_active);
                 auto pi = ray_intersect_preliminary_gpu(ray_, active);
                 return pi.compute_surface_interaction(ray_, flags, pi.is_valid());
             }
@@ -443,6 +567,18 @@ Scene<Float, Spectrum>::ray_intersect_gpu(const Ray3f &ray_, HitComputeFlags fla
         set_slices(ray, ray_count);
         set_slices(active, ray_count);
 
+        /* Coalesced launch: the shadow rays are traced by the same kernel,
+           after the \c ray_count regular rays (see \ref ray_intersect_and_test()) */
+        Ray3f shadow_ray;
+        size_t shadow_count = 0;
+        if (shadow_ray_) {
+            shadow_ray = *shadow_ray_;
+            shadow_count = std::max(slices(shadow_ray.o), slices(shadow_ray.d));
+            set_slices(shadow_ray, shadow_count);
+            set_slices(shadow_active, shadow_count);
+            *shadow_hit = empty<Mask>(shadow_count);
+        }
+
         // Allocate only the required fields of the SurfaceInteraction struct
         SurfaceInteraction3f si = empty<SurfaceInteraction3f>(1); // needed for virtual calls
 
@@ -522,9 +658,18 @@ Scene<Float, Spectrum>::ray_intersect_gpu(const Ray3f &ray_, HitComputeFlags fla
         bind_data(&params.out_prim_index, si.prim_index);
         bind_data(&params.out_inst_index, instance_index);
         params.out_shape_ptr = (unsigned long long*)si.shape.data();
+        if (shadow_count > 0) {
+            bind_data(&params.in_shadow_mask, shadow_active);
+            bind_data(params.in_shadow_o, shadow_ray.o);
+            bind_data(params.in_shadow_d, shadow_ray.d);
+            bind_data(&params.in_shadow_mint, shadow_ray.mint);
+            bind_data(&params.in_shadow_maxt, shadow_ray.maxt);
+            bind_data(&params.out_hit, *shadow_hit);
+            params.shadow_offset = (unsigned int) ray_count;
+        }
         params.handle = s.ias_handle;
 
-        launch_optix_kernel(s, params, ray_count);
+        launch_optix_kernel(s, params, ray_count + shadow_count);
 
         si.time = ray.time;
         si.wavelengths = ray.wavelengths;
@@ -547,6 +692,9 @@ Scene<Float, Spectrum>::ray_intersect_gpu(const Ray3f &ray_, HitComputeFlags fla
         ENOKI_MARK_USED(ray_);
         ENOKI_MARK_USED(flags);
         ENOKI_MARK_USED(active);
+        ENOKI_MARK_USED(shadow_ray_);
+        ENOKI_MARK_USED(shadow_active);
+        ENOKI_MARK_USED(shadow_hit);
         Throw("ray_intersect_gpu() should only be called in GPU mode.");
     }
 }
@@ -568,11 +716,11 @@ Scene<Float, Spectrum>::ray_test_gpu(const Ray3f &ray_, Mask active) const {
         OptixParams params = {};
 
         // Bind GPU data pointers to be filled by the OptiX kernel
-        bind_data(&params.in_mask, active);
-        bind_data(params.in_o, ray.o);
-        bind_data(params.in_d, ray.d);
-        bind_data(&params.in_mint, ray.mint);
-        bind_data(&params.in_maxt, ray.maxt);
+        bind_data(&params.in_shadow_mask, active);
+        bind_data(params.in_shadow_o, ray.o);
+        bind_data(params.in_shadow_d, ray.d);
+        bind_data(&params.in_shadow_mint, ray.mint);
+        bind_data(&params.in_shadow_maxt, ray.maxt);
         bind_data(&params.out_hit, hit);
         params.handle = s.ias_handle;
 
@@ -5,6 +5,7 @@
 #include <mitsuba/render/sensor.h>
 #include <mitsuba/render/medium.h>
 #include <mitsuba/core/plugin.h>
+#include <mitsuba/core/string.h>
 
 #if defined(MTS_ENABLE_EMBREE)
     #include <embree3/rtcore.h>
@@ -36,6 +37,7 @@ NAMESPACE_BEGIN(mitsuba)
 MTS_VARIANT Shape<Float, Spectrum>::Shape(const Properties &props) : m_id(props.id()) {
     m_to_world = props.transform("to_world", ScalarTransform4f());
     m_to_object = m_to_world.inverse();
+    m_accel_refit = props.bool_("accel_refit", false);
 
     for (auto &[name, obj] : props.objects(false)) {
         Emitter *emitter = dynamic_cast<Emitter *>(obj.get());
@@ -333,6 +335,23 @@ Shape<Float, Spectrum>::ray_test(const Ray3f &ray, Mask active) const {
     return ray_intersect_preliminary(ray, active).is_valid();
 }
 
+MTS_VARIANT typename Shape<Float, Spectrum>::PreliminaryIntersection3f
+Shape<Float, Spectrum>::ray_intersect_primitive(ScalarIndex /*index*/, const Ray3f &ray,
+                                                Mask active) const {
+    return ray_intersect_preliminary(ray, active);
+}
+
+MTS_VARIANT typename Shape<Float, Spectrum>::Mask
+Shape<Float, Spectrum>::ray_test_primitive(ScalarIndex /*index*/, const Ray3f &ray,
+                                           Mask active) const {
+    return ray_test(ray, active);
+}
+
+MTS_VARIANT AnalyticShape
+Shape<Float, Spectrum>::analytic_parameters(ScalarFloat * /*params*/) const {
+    return AnalyticShape::None;
+}
+
 MTS_VARIANT typename Shape<Float, Spectrum>::SurfaceInteraction3f
 Shape<Float, Spectrum>::compute_surface_interaction(const Ray3f & /*ray*/,
                                                     PreliminaryIntersection3f /*pi*/,
@@ -376,6 +395,12 @@ Shape<Float, Spectrum>::surface_area() const {
     NotImplementedError("surface_area");
 }
 
+MTS_VARIANT std::pair<typename Shape<Float, Spectrum>::ScalarVector3f,
+                      typename Shape<Float, Spectrum>::ScalarFloat>
+Shape<Float, Spectrum>::normal_cone() const {
+    return { ScalarVector3f(0.f, 0.f, 1.f), -1.f };
+}
+
 MTS_VARIANT typename Shape<Float, Spectrum>::ScalarBoundingBox3f
 Shape<Float, Spectrum>::bbox(ScalarIndex) const {
     return bbox();
@@ -388,6 +413,50 @@ Shape<Float, Spectrum>::bbox(ScalarIndex index, const ScalarBoundingBox3f &clip)
     return result;
 }
 
+MTS_VARIANT bool Shape<Float, Spectrum>::has_motion() const {
+    return false;
+}
+
+MTS_VARIANT typename Shape<Float, Spectrum>::ScalarVector2f
+Shape<Float, Spectrum>::motion_time_range() const {
+    return ScalarVector2f(0.f);
+}
+
+MTS_VARIANT std::pair<typename Shape<Float, Spectrum>::ScalarBoundingBox3f,
+                      typename Shape<Float, Spectrum>::ScalarBoundingBox3f>
+Shape<Float, Spectrum>::bbox_motion(ScalarIndex index, ScalarFloat, ScalarFloat) const {
+    ScalarBoundingBox3f result = bbox(index);
+    return { result, result };
+}
+
+MTS_VARIANT std::pair<typename Shape<Float, Spectrum>::ScalarBoundingBox3f,
+                      typename Shape<Float, Spectrum>::ScalarBoundingBox3f>
+Shape<Float, Spectrum>::fit_linear_bounds(const std::vector<ScalarFloat> &times,
+                                          const std::vector<ScalarBoundingBox3f> &boxes) {
+    Assert(!times.empty() && times.size() == boxes.size());
+    ScalarBoundingBox3f b0 = boxes.front(), b1 = boxes.back();
+    ScalarFloat duration = times.back() - times.front();
+    if (!(duration > 0.f)) {
+        for (const ScalarBoundingBox3f &box : boxes)
+            b0.expand(box);
+        return { b0, b0 };
+    }
+
+    /* Shifting both boxes by the same amount shifts every interpolated box,
+       hence the samples that were already contained remain so */
+    for (size_t i = 1; i + 1 < boxes.size(); ++i) {
+        ScalarFloat alpha = (times[i] - times.front()) / duration;
+        ScalarPoint3f min = fmadd(b1.min - b0.min, alpha, b0.min),
+                      max = fmadd(b1.max - b0.max, alpha, b0.max);
+        ScalarVector3f d_min = enoki::min(boxes[i].min - min, 0.f),
+                       d_max = enoki::max(boxes[i].max - max, 0.f);
+        b0.min += d_min; b1.min += d_min;
+        b0.max += d_max; b1.max += d_max;
+    }
+
+    return { b0, b1 };
+}
+
 MTS_VARIANT typename Shape<Float, Spectrum>::ScalarSize
 Shape<Float, Spectrum>::primitive_count() const {
     return 1;
@@ -413,11 +482,22 @@ MTS_VARIANT void Shape<Float, Spectrum>::traverse(TraversalCallback *callback) {
 }
 
 MTS_VARIANT
-void Shape<Float, Spectrum>::parameters_changed(const std::vector<std::string> &/*keys*/) {
-    if (m_emitter)
-        m_emitter->parameters_changed({"parent"});
-    if (m_sensor)
-        m_sensor->parameters_changed({"parent"});
+void Shape<Float, Spectrum>::parameters_changed(const std::vector<std::string> &keys) {
+    /* Derived classes call this function without keys after modifying
+       their geometry. Other changes (e.g. of the BSDF) do not affect the
+       data that the scene derives from the shape. */
+    bool geometry = keys.empty() || string::contains(keys, "to_world");
+
+    if (geometry) {
+        m_geometry_dirty = true;
+        if (m_emitter)
+            m_emitter->parameters_changed({"parent"});
+        if (m_sensor)
+            m_sensor->parameters_changed({"parent"});
+    }
+
+    if (m_emitter && (geometry || string::contains(keys, "emitter")))
+        m_emitter_dirty = true;
 }
 
 MTS_VARIANT bool Shape<Float, Spectrum>::parameters_grad_enabled() const {
@@ -1,4 +1,5 @@
 #include <mitsuba/core/properties.h>
+#include <mitsuba/render/bsdf.h>
 #include <mitsuba/render/shapegroup.h>
 #include <mitsuba/render/optix_api.h>
 
@@ -21,11 +22,16 @@ MTS_VARIANT ShapeGroup<Float, Spectrum>::ShapeGroup(const Properties &props) {
             ShapeGroup *shapegroup = dynamic_cast<ShapeGroup *>(kv.second.get());
             if (shapegroup)
                 Throw("Nested ShapeGroup is not permitted");
-            if (shape->is_emitter())
-                Throw("Instancing of emitters is not supported");
+            if (shape->is_emitter()) {
+                if constexpr (is_cuda_array_v<Float>)
+                    Throw("Instancing of emitters is only supported in CPU variants");
+                m_emitter_shapes.push_back(shape);
+            }
             if (shape->is_sensor())
                 Throw("Instancing of sensors is not supported");
             else {
+                if (shape->bsdf())
+                    m_polarizing |= has_flag(shape->bsdf()->flags(), BSDFFlags::Polarizing);
 #if defined(MTS_ENABLE_EMBREE) || defined(MTS_ENABLE_OPTIX)
                 m_shapes.push_back(shape);
                 m_bbox.expand(shape->bbox());
@@ -39,11 +45,57 @@ MTS_VARIANT ShapeGroup<Float, Spectrum>::ShapeGroup(const Properties &props) {
         }
     }
 #if !defined(MTS_ENABLE_EMBREE)
-    if (!m_kdtree->ready())
-        m_kdtree->build();
-
+    /* The tree is built later (see accel_build()), hence the bounds are enlarged
+       here like the kd-tree enlarges them, since instances use them right away */
+    m_kdtree_ready = m_kdtree->ready();
     m_bbox = m_kdtree->bbox();
+    if (!m_kdtree_ready && m_bbox.valid()) {
+        ScalarVector3f extra = (m_bbox.extents() + 1.f) * math::Epsilon<ScalarFloat>;
+        m_bbox.min -= extra;
+        m_bbox.max += extra;
+    }
 #endif
+
+    if (!m_emitter_shapes.empty())
+        build_emitter_distr();
+}
+
+MTS_VARIANT void ShapeGroup<Float, Spectrum>::build_emitter_distr() {
+    std::vector<ScalarFloat> area(m_emitter_shapes.size());
+    for (size_t i = 0; i < m_emitter_shapes.size(); ++i)
+        area[i] = m_emitter_shapes[i]->surface_area();
+
+    m_emitter_distr = DiscreteDistribution<Float>(area.data(), area.size());
+    m_emitter_area = m_emitter_distr.sum();
+    if (!(m_emitter_area > 0.f))
+        Throw("The emissive shapes of shape group \"%s\" have no surface area!", m_id);
+}
+
+MTS_VARIANT std::pair<typename ShapeGroup<Float, Spectrum>::PositionSample3f,
+                      typename ShapeGroup<Float, Spectrum>::ShapePtr>
+ShapeGroup<Float, Spectrum>::sample_emitter_position(Float time, const Point2f &sample_,
+                                                     Mask active) const {
+    MTS_MASK_ARGUMENT(active);
+    Assert(has_emitters());
+
+    // Pick an emissive shape proportionally to its area, and reuse the sample
+    Point2f sample(sample_);
+    UInt32 index;
+    std::tie(index, sample.y()) = m_emitter_distr.sample_reuse(sample.y(), active);
+
+    ShapePtr shape = gather<ShapePtr>(m_emitter_shapes.data(), index, active);
+    PositionSample3f ps = shape->sample_position(time, sample, active);
+    ps.pdf = select(active, rcp(m_emitter_area), 0.f);
+
+    return { ps, shape };
+}
+
+MTS_VARIANT typename ShapeGroup<Float, Spectrum>::ScalarFloat
+ShapeGroup<Float, Spectrum>::emitter_power() const {
+    ScalarFloat power = 0.f;
+    for (auto &shape : m_emitter_shapes)
+        power += shape->emitter()->power();
+    return power;
 }
 
 MTS_VARIANT ShapeGroup<Float, Spectrum>::~ShapeGroup() {
@@ -58,6 +110,7 @@ MTS_VARIANT RTCGeometry ShapeGroup<Float, Spectrum>::embree_geometry(RTCDevice d
     if constexpr (!is_cuda_array_v<Float>) {
         // Construct the BVH only once
         if (m_embree_scene == nullptr) {
+            m_embree_device = device;
             m_embree_scene = rtcNewScene(device);
             for (auto shape : m_shapes)
                 rtcAttachGeometry(m_embree_scene, shape->embree_geometry(device));
@@ -72,6 +125,17 @@ MTS_VARIANT RTCGeometry ShapeGroup<Float, Spectrum>::embree_geometry(RTCDevice d
     }
 }
 #else
+MTS_VARIANT void ShapeGroup<Float, Spectrum>::accel_build() {
+    if (m_kdtree_ready.load(std::memory_order_acquire))
+        return;
+
+    std::lock_guard<std::mutex> guard(m_kdtree_mutex);
+    if (!m_kdtree_ready.load(std::memory_order_relaxed)) {
+        m_kdtree->build();
+        m_kdtree_ready.store(true, std::memory_order_release);
+    }
+}
+
 MTS_VARIANT typename ShapeGroup<Float, Spectrum>::PreliminaryIntersection3f
 ShapeGroup<Float, Spectrum>::ray_intersect_preliminary(const Ray3f &ray,
                                                        Mask active) const {
@@ -80,6 +144,9 @@ ShapeGroup<Float, Spectrum>::ray_intersect_preliminary(const Ray3f &ray,
     if constexpr (is_cuda_array_v<Float>)
         Throw("ShapeGroup::ray_intersect_preliminary() should only be called in CPU mode.");
 
+    if (unlikely(!m_kdtree_ready.load(std::memory_order_acquire)))
+        const_cast<ShapeGroup *>(this)->accel_build();
+
     return m_kdtree->template ray_intersect_preliminary<false>(ray, active);
 }
 
@@ -90,6 +157,9 @@ ShapeGroup<Float, Spectrum>::ray_test(const Ray3f &ray, Mask active) const {
     if constexpr (is_cuda_array_v<Float>)
         Throw("ShapeGroup::ray_test() should only be called in CPU mode.");
 
+    if (unlikely(!m_kdtree_ready.load(std::memory_order_acquire)))
+        const_cast<ShapeGroup *>(this)->accel_build();
+
     return m_kdtree->template ray_intersect_preliminary<true>(ray, active).is_valid();
 }
 #endif
@@ -138,6 +208,98 @@ ShapeGroup<Float, Spectrum>::primitive_count() const {
 #endif
 }
 
+/// Name under which a child shape is reported by \ref ShapeGroup::traverse()
+template <typename ShapeT> std::string shapegroup_child_name(const ShapeT *shape) {
+    std::string id = shape->id();
+    if (id.empty() || string::starts_with(id, "_unnamed_"))
+        id = shape->class_()->name();
+    return id;
+}
+
+/// Was the geometry of a child shape modified? (also resets its flags)
+template <typename ShapeT>
+bool shapegroup_child_changed(const std::vector<std::string> &keys, ShapeT *shape) {
+    bool changed = keys.empty() ||
+                   (string::contains(keys, shapegroup_child_name(shape)) &&
+                    shape->geometry_dirty());
+    shape->clear_dirty();
+    return changed;
+}
+
+MTS_VARIANT void ShapeGroup<Float, Spectrum>::traverse(TraversalCallback *callback) {
+#if defined(MTS_ENABLE_EMBREE)
+    for (auto &shape : m_shapes)
+        callback->put_object(shapegroup_child_name(shape.get()), shape.get());
+#else
+    for (size_t i = 0; i < m_kdtree->shape_count(); ++i)
+        callback->put_object(shapegroup_child_name(m_kdtree->shape(i)), m_kdtree->shape(i));
+#endif
+}
+
+MTS_VARIANT void ShapeGroup<Float, Spectrum>::parameters_changed(const std::vector<std::string> &keys) {
+#if defined(MTS_ENABLE_EMBREE)
+    std::vector<uint32_t> changed;
+    for (size_t i = 0; i < m_shapes.size(); ++i) {
+        if (shapegroup_child_changed(keys, m_shapes[i].get()))
+            changed.push_back((uint32_t) i);
+    }
+    if (changed.empty())
+        return;
+
+    m_bbox.reset();
+    for (auto shape : m_shapes)
+        m_bbox.expand(shape->bbox());
+
+    if constexpr (!is_cuda_array_v<Float>) {
+        /* Only re-create the geometries that changed. Their buffers may have
+           been reallocated, so updating the shared buffers is not enough. */
+        if (m_embree_scene) {
+            for (uint32_t i : changed) {
+                Base *shape = m_shapes[i].get();
+                if (shape->is_mesh() && shape->accel_refit()) {
+                    ((Mesh *) shape)->embree_update_geometry(rtcGetGeometry(m_embree_scene, i));
+                    continue;
+                }
+
+                RTCGeometry geom = shape->embree_geometry(m_embree_device);
+                rtcDetachGeometry(m_embree_scene, i);
+                rtcAttachGeometryByID(m_embree_scene, geom, i);
+                rtcReleaseGeometry(geom);
+            }
+            rtcCommitScene(m_embree_scene);
+        }
+    }
+#else
+    bool changed = false;
+    for (size_t i = 0; i < m_kdtree->shape_count(); ++i)
+        changed |= shapegroup_child_changed(keys, m_kdtree->shape(i));
+    if (!changed)
+        return;
+
+    if constexpr (!is_cuda_array_v<Float>) {
+        std::lock_guard<std::mutex> guard(m_kdtree_mutex);
+        m_kdtree->rebuild();
+        m_kdtree_ready = true;
+        m_bbox = m_kdtree->bbox();
+    } else {
+        m_bbox.reset();
+        for (size_t i = 0; i < m_kdtree->shape_count(); ++i)
+            m_bbox.expand(m_kdtree->shape(i)->bbox());
+    }
+#endif
+
+#if defined(MTS_ENABLE_OPTIX)
+    // Rebuilt by the next call to Scene::accel_parameters_changed_gpu()
+    optix_accel_ready = false;
+#endif
+
+    if (!m_emitter_shapes.empty())
+        build_emitter_distr();
+
+    // The instances referencing this group must be refreshed
+    m_geometry_dirty = true;
+}
+
 #if defined(MTS_ENABLE_OPTIX)
 MTS_VARIANT void ShapeGroup<Float, Spectrum>::optix_prepare_ias(
     const OptixDeviceContext &context, std::vector<OptixInstance> &instances,
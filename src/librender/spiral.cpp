@@ -5,14 +5,32 @@
 
 NAMESPACE_BEGIN(mitsuba)
 
-Spiral::Spiral(Vector2i size, Vector2i offset, size_t block_size, size_t passes)
+Spiral::Spiral(Vector2i size, Vector2i offset, size_t block_size, size_t passes, bool scanline)
     : m_block_size(block_size),
       m_size(size), m_offset(offset),
-      m_remaining_passes(passes) {
+      m_remaining_passes(passes), m_passes(passes), m_scanline(scanline) {
 
     m_blocks = Vector2i(ceil(Vector2f(m_size) / m_block_size));
     m_block_count = hprod(m_blocks);
 
+    // Record the traversal order of a single pass for lock-free access
+    reset();
+    m_block_list.reserve(m_block_count);
+    if (scanline) {
+        for (int y = 0; y < m_blocks.y(); ++y) {
+            for (int x = 0; x < m_blocks.x(); ++x) {
+                Vector2i offset(Vector2i(x, y) * (int) m_block_size);
+                m_block_list.emplace_back(offset + m_offset,
+                                          min((int) m_block_size, m_size - offset));
+            }
+        }
+    } else {
+        for (size_t i = 0; i < m_block_count; ++i) {
+            auto [offset, size, block_id] = next_block();
+            ENOKI_MARK_USED(block_id);
+            m_block_list.emplace_back(offset, size);
+        }
+    }
     reset();
 }
 
@@ -40,6 +58,11 @@ std::tuple<Spiral::Vector2i, Spiral::Vector2i, size_t> Spiral::next_block() {
     // Calculate a unique identifer per block
     size_t block_id = m_block_counter + (m_remaining_passes - 1) * m_block_count;
 
+    if (m_scanline) {
+        const auto &[offset, size] = m_block_list[m_block_counter++];
+        return { offset, size, block_id };
+    }
+
     Vector2i offset(m_position * (int) m_block_size);
     Vector2i size = min((int) m_block_size, m_size - offset);
     offset += m_offset;
@@ -71,5 +94,19 @@ std::tuple<Spiral::Vector2i, Spiral::Vector2i, size_t> Spiral::next_block() {
     return { offset, size, block_id };
 }
 
+std::tuple<Spiral::Vector2i, Spiral::Vector2i, size_t> Spiral::block(size_t index) const {
+    if (m_block_count == 0 || index >= m_block_count * m_passes)
+        return { Vector2i(0), Vector2i(0), (size_t) -1 };
+
+    size_t pass = index / m_block_count,
+           i    = index % m_block_count;
+
+    // Same identifiers as those generated by next_block()
+    size_t block_id = i + (m_passes - 1 - pass) * m_block_count;
+
+    const auto &[offset, size] = m_block_list[i];
+    return { offset, size, block_id };
+}
+
 MTS_IMPLEMENT_CLASS(Spiral, Object)
 NAMESPACE_END(mitsuba)
@@ -0,0 +1,62 @@
+import mitsuba
+import pytest
+import numpy as np
+
+
+def noisy_image(albedo, seed=0):
+    np.random.seed(seed)
+    noise = np.random.uniform(0.0, 2.0, size=albedo.shape[:2] + (1,))
+    return (albedo * noise).astype(np.float32)
+
+
+def test01_reduces_noise(variant_scalar_rgb):
+    from mitsuba.core import Bitmap
+    from mitsuba.render import Denoiser
+
+    albedo = np.full((32, 48, 3), 0.5, dtype=np.float32)
+    color = noisy_image(albedo)
+
+    denoiser = Denoiser(Denoiser.Backend.Builtin)
+    assert denoiser.backend() == Denoiser.Backend.Builtin
+    result = np.array(denoiser.denoise(Bitmap(color)))
+
+    assert result.shape == color.shape
+    assert np.std(result) < 0.25 * np.std(color)
+    assert np.abs(np.mean(result) - np.mean(color)) < 0.05
+
+
+def test02_preserves_albedo_edges(variant_scalar_rgb):
+    from mitsuba.core import Bitmap
+    from mitsuba.render import Denoiser
+
+    """Two regions with very different albedos must not bleed into each
+    other when the albedo is given as a guide"""
+    albedo = np.full((32, 32, 3), 0.1, dtype=np.float32)
+    albedo[:, 16:, :] = 0.9
+    color = noisy_image(albedo)
+
+    denoiser = Denoiser(Denoiser.Backend.Builtin)
+    result = np.array(denoiser.denoise(Bitmap(color), Bitmap(albedo)))
+
+    assert np.all(np.abs(np.mean(result[:, :16], axis=1) - 0.1) < 0.05)
+    assert np.all(np.abs(np.mean(result[:, 16:], axis=1) - 0.9) < 0.2)
+    assert np.std(result[:, :16]) < 0.5 * np.std(color[:, :16])
+
+
+def test03_errors(variant_scalar_rgb):
+    from mitsuba.core import Bitmap
+    from mitsuba.render import Denoiser
+
+    with pytest.raises(RuntimeError):
+        Denoiser(Denoiser.Backend.Builtin, strength=0.0)
+
+    if not Denoiser.has_oidn():
+        assert Denoiser().backend() == Denoiser.Backend.Builtin
+        with pytest.raises(RuntimeError):
+            Denoiser(Denoiser.Backend.OIDN)
+
+    # The guides must have the size of the image
+    denoiser = Denoiser(Denoiser.Backend.Builtin)
+    with pytest.raises(RuntimeError):
+        denoiser.denoise(Bitmap(np.zeros((4, 4, 3), dtype=np.float32)),
+                         Bitmap(np.zeros((4, 5, 3), dtype=np.float32)))
@@ -247,4 +247,41 @@ def test06_put_values_basic(variant_scalar_spectral):
             # we'll just add one sample right in the center of each pixel.
             im.put([j + 0.5, i + 0.5], wavelengths, spectrum, alpha=1.0)
 
-    check_value(im, ref, atol=1e-6)
\ No newline at end of file
+    check_value(im, ref, atol=1e-6)
+
+@pytest.mark.parametrize('filter_xml', [
+    '<rfilter version="2.0.0" type="tent"/>',
+    '<rfilter version="2.0.0" type="gaussian"><float name="stddev" value="0.375"/></rfilter>',
+    '<rfilter version="2.0.0" type="gaussian"><float name="stddev" value="1"/></rfilter>'
+])
+def test07_put_footprints(variant_scalar_rgb, filter_xml):
+    from mitsuba.core.xml import load_string
+    from mitsuba.render import ImageBlock
+
+    """The specialized footprints of put() (2-4 taps) must match the
+    separable reference, as well as the generic loop of wider filters"""
+    rfilter = load_string(filter_xml)
+    im = ImageBlock([9, 7], 5, filter=rfilter, warn_negative=False)
+    im.clear()
+
+    border = im.border_size()
+    ref = np.zeros(shape=(im.height() + 2 * border, im.width() + 2 * border, 5))
+    radius = int(math.ceil(rfilter.radius()))
+
+    np.random.seed(0)
+    for i in range(20):
+        position = np.random.uniform(size=2) * [9, 7]
+        value = np.random.uniform(size=5)
+        im.put(position, value)
+
+        pos = position - 0.5 + border
+        lo = np.ceil(pos - radius).astype(np.int)
+        for dy in range(lo[1], lo[1] + 2 * radius + 1):
+            for dx in range(lo[0], lo[0] + 2 * radius + 1):
+                if dx < 0 or dy < 0 or dx >= ref.shape[1] or dy >= ref.shape[0]:
+                    continue
+                weight = rfilter.eval_discretized(dx - pos[0]) * \
+                         rfilter.eval_discretized(dy - pos[1])
+                ref[dy, dx, :] += weight * value
+
+    check_value(im, ref, atol=1e-6)
@@ -37,7 +37,7 @@ def _save(film, int_name, suffix=''):
     scene_i += 1
 
 
-def check_scene(int_name, scene_name, is_empty=False):
+def check_scene(int_name, scene_name, is_empty=False, xml=""):
     from mitsuba.core.xml import load_string
     from mitsuba.core import Bitmap, Struct
 
@@ -45,7 +45,7 @@ def check_scene(int_name, scene_name, is_empty=False):
 
     print("variant_name:", variant_name)
 
-    integrator = make_integrator(int_name, "")
+    integrator = make_integrator(int_name, xml)
     scene = SCENES[scene_name]['factory']()
     integrator_type = {
         'direct': 'direct',
@@ -148,6 +148,205 @@ def test06_render_timeout(variants_cpu_rgb, int_name):
     assert ek.allclose(timeout, effective, atol=0.5)
 
 
+@pytest.mark.parametrize(*integrators)
+def test07_render_adaptive(variants_cpu_rgb, int_name):
+    from mitsuba.python.test.scenes import make_empty_scene
+
+    # An empty scene converges immediately: every block should stop after
+    # the minimum number of passes
+    integrator = make_integrator(int_name, """
+        <integer name="samples_per_pass" value="4"/>
+        <float name="adaptive_threshold" value="0.01"/>
+        <integer name="adaptive_min_passes" value="2"/>
+        <boolean name="sample_count_aov" value="true"/>
+    """)
+    scene = make_empty_scene(spp=64)
+    sensor = scene.sensors()[0]
+    assert integrator.render(scene, sensor)
+
+    values = np.array(sensor.film().bitmap(raw=False), copy=False)
+    assert ek.allclose(np.mean(values[:, :, -1]), 2 * 4, rtol=5e-2)
+
+    with pytest.raises(RuntimeError):
+        make_integrator(int_name, """<integer name="adaptive_min_passes" value="1"/>""")
+
+
+@pytest.mark.parametrize(*integrators)
+def test08_render_atomic_scheduler(variants_cpu_rgb, int_name):
+    from mitsuba.core import Bitmap, Struct
+    scene = SCENES['teapot']['factory']()
+    sensor = scene.sensors()[0]
+
+    def render(scheduler):
+        integrator = make_integrator(int_name, """
+            <integer name="samples_per_pass" value="8"/>
+            <string name="block_scheduler" value="{}"/>
+        """.format(scheduler))
+        assert integrator.render(scene, sensor)
+        return np.array(sensor.film().bitmap(raw=True), copy=True)
+
+    # Blocks are seeded deterministically, so the scheduler must not matter
+    assert np.allclose(render('spiral'), render('atomic'))
+
+    with pytest.raises(RuntimeError):
+        make_integrator(int_name, """<string name="block_scheduler" value="foo"/>""")
+
+@pytest.mark.parametrize('scene_name', ['teapot', 'box', 'museum_plane'])
+def test09_render_wavefront(variants_cpu_rgb, scene_name):
+    # Wavefront mode uses different random numbers, but must converge to the
+    # same image. Scalar variants ignore the parameter (with a warning).
+    check_scene('path', scene_name,
+                xml="""<boolean name="wavefront" value="true"/>""")
+
+@pytest.mark.parametrize(*integrators)
+def test10_render_tuned_scheduler(variants_cpu_rgb, int_name):
+    # The block layout of later passes depends on measured timings, so only
+    # check that the image converges to the reference
+    check_scene(int_name, 'teapot', xml="""
+        <integer name="samples_per_pass" value="8"/>
+        <string name="block_scheduler" value="tuned"/>
+    """)
+
+@pytest.mark.parametrize(*integrators)
+def test11_render_batch(variants_cpu_rgb, int_name):
+    # Render the teapot scene from its own sensor and the one of the box scene
+    scene = SCENES['teapot']['factory']()
+    sensors = [SCENES[name]['factory']().sensors()[0] for name in ['teapot', 'box']]
+
+    # Seeds depend on the block size, which must hence be fixed for the comparison
+    integrator = make_integrator(int_name, """
+        <integer name="block_size" value="16"/>
+        <integer name="samples_per_pass" value="8"/>
+    """)
+
+    assert integrator.render_batch(scene, sensors)
+    batch = [np.array(s.film().bitmap(raw=True), copy=True) for s in sensors]
+
+    for sensor, ref in zip(sensors, batch):
+        assert integrator.render(scene, sensor)
+        assert np.allclose(np.array(sensor.film().bitmap(raw=True), copy=False), ref)
+
+@pytest.mark.parametrize(*integrators)
+def test12_render_deterministic(variants_cpu_rgb, int_name):
+    from mitsuba.core import set_thread_count, util
+    from mitsuba.core.xml import load_string
+
+    # Gaussian filter: blocks overlap through their borders
+    scene = load_string("""
+        <scene version="2.0.0">
+            <sensor type="perspective">
+                <film type="hdrfilm">
+                    <integer name="width" value="40"/>
+                    <integer name="height" value="32"/>
+                    <string name="accumulation" value="deterministic"/>
+                    <rfilter type="gaussian"/>
+                </film>
+                <sampler type="independent">
+                    <integer name="sample_count" value="16"/>
+                </sampler>
+            </sensor>
+            <shape type="sphere"/>
+            <emitter type="constant"/>
+        </scene>
+    """)
+
+    # The block size affects the sampler seeds and must not depend on the thread count
+    integrator = make_integrator(int_name, """
+        <integer name="block_size" value="8"/>
+        <integer name="samples_per_pass" value="4"/>
+    """)
+    film = scene.sensors()[0].film()
+
+    images = []
+    try:
+        for thread_count in [1, 3, 8]:
+            set_thread_count(thread_count)
+            assert integrator.render(scene, scene.sensors()[0])
+            images.append(np.array(film.bitmap(raw=True), copy=True))
+    finally:
+        set_thread_count(util.core_count())
+
+    for image in images[1:]:
+        assert np.array_equal(image, images[0])
+
+@pytest.mark.parametrize(*integrators)
+def test13_render_pipelined(variant_gpu_rgb, int_name):
+    # Passes evaluated one at a time must converge to the same image
+    check_scene(int_name, 'teapot', xml="""
+        <integer name="samples_per_pass" value="4"/>
+        <boolean name="pipeline_passes" value="true"/>
+    """)
+
+@pytest.mark.parametrize(*integrators)
+def test14_render_counters(variants_cpu_rgb, int_name):
+    from mitsuba.core.xml import load_string
+
+    scene = load_string("""
+        <scene version="2.0.0">
+            <sensor type="perspective">
+                <film type="hdrfilm">
+                    <integer name="width" value="40"/>
+                    <integer name="height" value="32"/>
+                </film>
+                <sampler type="independent">
+                    <integer name="sample_count" value="8"/>
+                </sampler>
+            </sensor>
+            <shape type="sphere"/>
+        </scene>
+    """)
+
+    integrator = make_integrator(int_name, """
+        <integer name="block_size" value="16"/>
+        <integer name="samples_per_pass" value="4"/>
+    """)
+    assert integrator.render(scene, scene.sensors()[0])
+
+    # 3x2 blocks, rendered in 2 passes
+    assert integrator.blocks_done() == 12
+    assert integrator.samples_done() == 40 * 32 * 8
+    assert integrator.render_time() >= 0
+
+    pass_times = integrator.pass_times()
+    assert len(pass_times) == 2
+    assert all(t >= 0 for t in pass_times)
+
+
+@pytest.mark.parametrize('scene_name', ['teapot', 'box'])
+def test15_render_guided(variants_cpu_rgb, scene_name):
+    # The guided path tracer learns over the passes, but must converge to the
+    # same image as the path tracer
+    check_scene('guided', scene_name, xml="""
+        <integer name="samples_per_pass" value="4"/>
+    """)
+
+
+@pytest.mark.parametrize('scene_name', ['teapot', 'box'])
+def test16_render_emitter_samples(variants_cpu_rgb, scene_name):
+    # Multi-sample next event estimation traces the shadow rays in batches
+    check_scene('path', scene_name, xml="""
+        <integer name="emitter_samples" value="11"/>
+    """)
+
+
+@pytest.mark.parametrize('scene_name', ['teapot', 'box'])
+def test17_render_wavefront_sort_materials(variants_cpu_rgb, scene_name):
+    # Random numbers are derived from per-path seeds, so the order in which
+    # paths are shaded must not change the image
+    scene = SCENES[scene_name]['factory']()
+    sensor = scene.sensors()[0]
+
+    def render(sort):
+        integrator = make_integrator('path', """
+            <boolean name="wavefront" value="true"/>
+            <boolean name="sort_materials" value="{}"/>
+        """.format('true' if sort else 'false'))
+        assert integrator.render(scene, sensor)
+        return np.array(sensor.film().bitmap(raw=True), copy=True)
+
+    assert np.allclose(render(True), render(False))
+
+
 def make_reference_renders():
     mitsuba.set_variant('scalar_rgb')
     from mitsuba.core import Bitmap, Struct
@@ -191,3 +390,344 @@ def make_reference_renders():
 
 if __name__ == '__main__':
     make_reference_renders()
+
+
+@pytest.mark.parametrize('scene_name', ['teapot', 'box'])
+def test18_render_filter_importance_sampling(variants_cpu_rgb, scene_name):
+    # Sampling the film's reconstruction filter must converge to the same
+    # image as splatting the samples over the filter footprint
+    check_scene('path', scene_name, xml="""
+        <boolean name="filter_importance_sampling" value="true"/>
+    """)
+
+
+@pytest.mark.parametrize(*integrators)
+def test19_render_thread_pool(variants_cpu_rgb, int_name):
+    from mitsuba.core import ThreadPool
+
+    scene = SCENES['teapot']['factory']()
+    sensor = scene.sensors()[0]
+
+    def render(integrator):
+        assert integrator.render(scene, sensor)
+        return np.array(sensor.film().bitmap(raw=True), copy=True)
+
+    # Seeds depend on the block size, which must hence be fixed for the comparison
+    xml = """
+        <integer name="block_size" value="16"/>
+        <integer name="samples_per_pass" value="8"/>
+    """
+    integrator = make_integrator(int_name, xml)
+    assert integrator.thread_pool() is None
+    reference = render(integrator)
+
+    integrator.set_thread_pool(ThreadPool(2, [0]))
+    assert integrator.thread_pool().thread_count() == 2
+    assert np.allclose(render(integrator), reference)
+
+    integrator = make_integrator(int_name, xml + """
+        <integer name="thread_count" value="3"/>
+        <string name="thread_affinity" value="0"/>
+    """)
+    assert integrator.thread_pool().thread_count() == 3
+    assert integrator.thread_pool().cores() == [0]
+    assert np.allclose(render(integrator), reference)
+
+    assert ThreadPool.parse_cores("0-2,5") == [0, 1, 2, 5]
+    with pytest.raises(RuntimeError):
+        make_integrator(int_name, """<string name="thread_affinity" value="a-b"/>""")
+
+
+def test20_render_releases_gil(variants_cpu_rgb):
+    import threading, time
+
+    if mitsuba.core.DEBUG:
+        pytest.skip("Timeout is unreliable in debug mode.")
+
+    integrator = make_integrator('path', """<float name="timeout" value="0.5"/>""")
+    scene = SCENES['teapot']['factory'](spp=100000)
+    sensor = scene.sensors()[0]
+
+    # Python threads keep running while the scene renders
+    ticks, done = [], threading.Event()
+    def count():
+        while not done.is_set():
+            ticks.append(time.time())
+            time.sleep(0.005)
+
+    thread = threading.Thread(target=count)
+    thread.start()
+    start = time.time()
+    assert integrator.render(scene, sensor)
+    end = time.time()
+    done.set()
+    thread.join()
+
+    assert len([t for t in ticks if start < t < end]) > 10
+
+
+def test21_render_preview(variants_cpu_rgb):
+    from mitsuba.core import Bitmap, Struct
+
+    integrator = make_integrator('path', """<integer name="preview_stride" value="4"/>""")
+    scene = SCENES['teapot']['factory'](spp=4)
+    sensor = scene.sensors()[0]
+    film = sensor.film()
+
+    # Coarse levels first, then full resolution passes of one sample per pixel
+    updates, tiles = [], []
+    def update(stride, spp):
+        updates.append((stride, spp))
+        tiles.append(len(film.snapshot()))
+    assert integrator.render_preview(scene, sensor, update)
+    assert updates == [(4, 0), (2, 0), (1, 1), (1, 2), (1, 3), (1, 4)]
+    assert all(count > 0 for count in tiles)
+    assert integrator.samples_done() == ek.hprod(film.crop_size()) * 4
+
+    # The coarse levels do not bias the refined image
+    converted = film.bitmap(raw=True).convert(Bitmap.PixelFormat.RGBA, Struct.Type.Float32, False)
+    means = np.mean(np.array(converted, copy=False), axis=(0, 1))
+    assert ek.allclose(means, SCENES['teapot']['full'], rtol=5e-2)
+
+    # A canceled preview returns early and can be restarted on the same scene
+    updates = []
+    def cancel(stride, spp):
+        updates.append((stride, spp))
+        integrator.cancel()
+    assert not integrator.render_preview(scene, sensor, cancel)
+    assert updates == [(4, 0)]
+    assert integrator.render_preview(scene, sensor)
+
+
+@pytest.mark.parametrize(*integrators)
+def test22_render_time_aov(variants_cpu_rgb, int_name):
+    from mitsuba.python.test.scenes import make_empty_scene
+
+    integrator = make_integrator(int_name, """
+        <boolean name="render_time_aov" value="true"/>
+        <boolean name="sample_count_aov" value="true"/>
+    """)
+    scene = make_empty_scene(spp=16)
+    sensor = scene.sensors()[0]
+    assert integrator.render(scene, sensor)
+
+    # The render time precedes the sample count channel
+    values = np.array(sensor.film().bitmap(raw=False), copy=False)
+    assert np.all(values[:, :, -2] >= 0)
+    assert np.any(values[:, :, -2] > 0)
+    assert ek.allclose(np.mean(values[:, :, -1]), 16, rtol=5e-2)
+
+
+@pytest.mark.parametrize('rfilter', ['box', 'gaussian'])
+def test20_render_single_pixel(variants_cpu_rgb, rfilter):
+    from mitsuba.core.xml import load_string
+
+    # Single-pixel films bypass the image blocks
+    scene = load_string("""
+        <scene version="2.0.0">
+            <sensor type="radiancemeter">
+                <film type="hdrfilm">
+                    <integer name="width" value="1"/>
+                    <integer name="height" value="1"/>
+                    <rfilter type="{rfilter}"/>
+                </film>
+                <sampler type="independent">
+                    <integer name="sample_count" value="1000"/>
+                </sampler>
+            </sensor>
+            <emitter type="constant">
+                <rgb name="radiance" value="0.5, 1, 2"/>
+            </emitter>
+        </scene>
+    """.format(rfilter=rfilter))
+
+    integrator = make_integrator('path')
+    sensor = scene.sensors()[0]
+    assert integrator.render(scene, sensor)
+
+    assert integrator.samples_done() == 1000
+    assert len(integrator.pass_times()) == 1
+
+    value = np.array(sensor.film().bitmap()).ravel()
+    assert np.allclose(value[:3], [0.5, 1, 2], rtol=1e-3)
+
+
+@pytest.mark.parametrize('int_name', ['path', 'volpath'])
+@pytest.mark.parametrize('scene_name', ['teapot', 'box'])
+def test23_render_adaptive_rr(variants_cpu_rgb, int_name, scene_name):
+    # Efficiency-aware Russian roulette and splitting learns its factors
+    # during the first passes, but must converge to the same image
+    check_scene(int_name, scene_name, xml="""
+        <string name="rr_mode" value="adaptive"/>
+        <integer name="rrs_learning_passes" value="2"/>
+        <integer name="rr_depth" value="2"/>
+        <integer name="samples_per_pass" value="4"/>
+    """)
+
+
+def test24_adaptive_rr_checks(variant_scalar_rgb):
+    with pytest.raises(RuntimeError, match='Russian roulette mode'):
+        make_integrator('path', '<string name="rr_mode" value="efficient"/>')
+    with pytest.raises(RuntimeError, match='rrs_max_split'):
+        make_integrator('path', '<string name="rr_mode" value="adaptive"/>'
+                                '<float name="rrs_max_split" value="0.5"/>')
+
+    integrator = make_integrator('path', '<string name="rr_mode" value="adaptive"/>')
+    assert 'rr_mode = adaptive' in str(integrator)
+
+
+@pytest.mark.parametrize('scene_name', ['teapot', 'box'])
+def test25_render_ptracer(variants_cpu_rgb, scene_name):
+    # Light tracing splats its paths into the film, and must match the
+    # average color of the path tracer
+    from mitsuba.core import Bitmap, Struct
+
+    integrator = make_integrator('ptracer')
+    scene = SCENES[scene_name]['factory']()
+    sensor = scene.sensors()[0]
+    assert integrator.render(scene, sensor)
+
+    converted = sensor.film().bitmap(raw=False).convert(
+        Bitmap.PixelFormat.RGB, Struct.Type.Float32, False)
+    means = np.mean(np.array(converted, copy=False), axis=(0, 1))
+    assert ek.allclose(means, SCENES[scene_name]['full'][:3], rtol=1e-1)
+
+
+def test26_ptracer_checks(variant_scalar_rgb):
+    from mitsuba.core.xml import load_string
+    from mitsuba.core import Ray3f, Point2f
+
+    with pytest.raises(RuntimeError, match='max_depth'):
+        make_integrator('ptracer', '<integer name="max_depth" value="-2"/>')
+
+    # Rays leaving the emitters of the scene carry its total power
+    scene = load_string("""
+        <scene version="2.0.0">
+            <emitter type="point">
+                <spectrum name="intensity" value="2"/>
+            </emitter>
+            <emitter type="point">
+                <point name="position" x="1" y="0" z="0"/>
+                <spectrum name="intensity" value="2"/>
+            </emitter>
+        </scene>
+    """)
+    ray, weight = scene.sample_emitter_ray(0, 0.3, Point2f(0.5), Point2f(0.5))
+    assert ek.allclose(ray.o, [0, 0, 0])
+    assert ek.allclose(weight, 2 * 4 * ek.pi * 2)
+
+
+@pytest.mark.parametrize('scene_name', ['teapot', 'box'])
+def test27_render_photonmapper(variants_cpu_rgb, scene_name):
+    # Progressive photon mapping is consistent: with a small radius, the
+    # average color matches the path tracer
+    check_scene('photonmapper', scene_name, xml="""
+        <integer name="photon_count" value="200000"/>
+        <integer name="samples_per_pass" value="4"/>
+    """)
+
+
+def test28_photonmapper_checks(variant_scalar_rgb):
+    with pytest.raises(RuntimeError, match='alpha'):
+        make_integrator('photonmapper', '<float name="alpha" value="1"/>')
+    with pytest.raises(RuntimeError, match='photon_count'):
+        make_integrator('photonmapper', '<integer name="photon_count" value="0"/>')
+
+    integrator = make_integrator('photonmapper', '<float name="radius" value="0.5"/>')
+    assert 'radius = 0.5' in str(integrator)
+
+
+@pytest.mark.parametrize('scene_name', ['teapot', 'box'])
+def test29_render_irrcache(variants_cpu_rgb, scene_name):
+    # The interpolation of the cached irradiance is biased, but the average
+    # color stays close to the path tracer
+    from mitsuba.core import Bitmap, Struct
+
+    integrator = make_integrator('irrcache', '<float name="cache_error" value="0.1"/>')
+    scene = SCENES[scene_name]['factory']()
+    sensor = scene.sensors()[0]
+    assert integrator.render(scene, sensor)
+
+    converted = sensor.film().bitmap(raw=False).convert(
+        Bitmap.PixelFormat.RGB, Struct.Type.Float32, False)
+    means = np.mean(np.array(converted, copy=False), axis=(0, 1))
+    assert ek.allclose(means, SCENES[scene_name]['full'][:3], rtol=1e-1)
+
+
+def test30_irrcache_checks(variant_scalar_rgb):
+    with pytest.raises(RuntimeError, match='cache_error'):
+        make_integrator('irrcache', '<float name="cache_error" value="0"/>')
+    with pytest.raises(RuntimeError, match='cache_samples'):
+        make_integrator('irrcache', '<integer name="cache_samples" value="0"/>')
+
+    # The hemisphere is split into M x N strata with N ~ pi * M
+    integrator = make_integrator('irrcache', '<integer name="cache_samples" value="100"/>')
+    assert 'cache_samples = 102' in str(integrator)
+
+
+def test31_python_sample_wavefront(variant_packet_rgb):
+    """A Python integrator overriding sample_wavefront() receives the samples
+    of whole image blocks instead of single packets in the packet variants"""
+    from mitsuba.core import Color3f, ScalarTransform4f
+    from mitsuba.core.xml import load_dict
+    from mitsuba.render import SamplingIntegrator, register_integrator
+
+    calls = []
+
+    class BatchedIntegrator(SamplingIntegrator):
+        def __init__(self, props):
+            SamplingIntegrator.__init__(self, props)
+
+        def sample_wavefront(self, scene, rays, seeds, medium, active):
+            calls.append(ek.slices(active))
+            si = scene.ray_intersect(rays, active)
+            return Color3f(ek.select(si.is_valid(), 1.0, 0.0)), si.is_valid()
+
+        def aov_names(self):
+            return []
+
+        def to_string(self):
+            return "BatchedIntegrator[]"
+
+    register_integrator("batched_wavefront", lambda props: BatchedIntegrator(props))
+
+    scene = load_dict({
+        "type" : "scene",
+        "integrator" : {
+            "type" : "batched_wavefront",
+            "wavefront" : True
+        },
+        "sensor" : {
+            "type" : "perspective",
+            "fov" : 30.0,
+            "to_world" : ScalarTransform4f.look_at(origin=[0, 0, 5],
+                                                   target=[0, 0, 0],
+                                                   up=[0, 1, 0]),
+            "film" : {
+                "type" : "hdrfilm",
+                "width" : 32,
+                "height" : 32,
+                "rfilter" : { "type" : "box" }
+            },
+            "sampler" : {
+                "type" : "independent",
+                "sample_count" : 4
+            }
+        },
+        "shape" : {
+            "type" : "sphere",
+            "radius" : 1.0
+        }
+    })
+
+    sensor = scene.sensors()[0]
+    assert scene.integrator().render(scene, sensor)
+
+    # Each call covers many packets, and all samples are processed
+    assert len(calls) > 0
+    assert max(calls) > 16
+    assert sum(calls) >= 32 * 32 * 4
+
+    image = np.array(sensor.film().bitmap(raw=False))
+    assert np.allclose(image[16, 16, :3], 1.0, atol=1e-3)
+    assert np.allclose(image[0, 0, :3], 0.0)
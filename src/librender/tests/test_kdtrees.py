@@ -131,3 +131,488 @@ def test03_depth_packet_stairs(variant_packet_rgb):
     # TODO: spot-check (here, we only check consistency)
     assert ek.all(res_shadow == res.is_valid())
     compare_results(res_naive, res, atol=1e-6)
+
+
+def test04_batch_packet_stairs(variant_packet_rgb):
+    from mitsuba.core import Ray3f, Vector3f, Float, UInt32, Properties
+    from mitsuba.render import Scene
+
+    props = Properties("scene")
+    props["_unnamed_0"] = create_stairs(11)
+    scene = Scene(props)
+
+    # Incoherent rays: scattered origins above the stairs, pointing up or down
+    n = 256
+    idx = ek.arange(UInt32, n)
+    rays = Ray3f.zero(n)
+    rays.o = Vector3f(Float(idx) / n, Float((idx * 37) % n) / n, 2)
+    rays.d = Vector3f(0, 0, ek.select(idx % 3 == 0, 1.0, -1.0))
+    rays.mint = 0
+    rays.maxt = 100
+    rays.update()
+
+    res = scene.ray_intersect_preliminary(rays)
+
+    # Hits must be returned in the original order, whether sorted or not
+    for sort in [False, True]:
+        res_batch = scene.ray_intersect_batch(rays, sort)
+        assert ek.all(res_batch.is_valid() == res.is_valid())
+        assert ek.allclose(ek.select(res.is_valid(), res_batch.t, 0),
+                           ek.select(res.is_valid(), res.t, 0))
+
+
+def make_bvh_scene(n_steps):
+    from mitsuba.core import Properties
+    from mitsuba.render import Scene
+
+    props = Properties("scene")
+    props["accel"] = "bvh"
+    props["bvh_max_leaf_prims"] = 2
+    props["_unnamed_0"] = create_stairs(n_steps)
+    return Scene(props)
+
+
+def test05_bvh_scalar_stairs(variant_scalar_rgb):
+    from mitsuba.core import Ray3f, Vector3f
+
+    if mitsuba.core.MTS_ENABLE_EMBREE:
+        pytest.skip("EMBREE enabled")
+
+    scene = make_bvh_scene(20)
+
+    n = 64
+    inv_n = 1.0 / (n - 1)
+    for x in range(n - 1):
+        for y in range(n - 1):
+            # Oblique rays, so that the traversal order of the children matters
+            r = Ray3f([x * inv_n, y * inv_n, 2], ek.normalize(Vector3f(0.1, -0.3, -1)), 0.5, [])
+            r.mint = 0
+            r.maxt = 100
+
+            res_naive = scene.ray_intersect_naive(r)
+            res       = scene.ray_intersect(r)
+            assert ek.all(scene.ray_test(r) == res_naive.is_valid())
+            compare_results(res_naive, res, atol=1e-6)
+
+
+def test06_bvh_packet_stairs(variant_packet_rgb):
+    from mitsuba.core import Ray3f, Vector3f, Float, UInt32
+
+    if mitsuba.core.MTS_ENABLE_EMBREE:
+        pytest.skip("EMBREE enabled")
+
+    scene = make_bvh_scene(11)
+
+    # Incoherent rays: scattered origins above the stairs, pointing up or down
+    n = 256
+    idx = ek.arange(UInt32, n)
+    rays = Ray3f.zero(n)
+    rays.o = Vector3f(Float(idx) / n, Float((idx * 37) % n) / n, 2)
+    rays.d = ek.normalize(Vector3f(0.2, 0.1, ek.select(idx % 3 == 0, 1.0, -1.0)))
+    rays.mint = 0
+    rays.maxt = 100
+    rays.update()
+
+    res_naive  = scene.ray_intersect_naive(rays)
+    res        = scene.ray_intersect(rays)
+    res_shadow = scene.ray_test(rays)
+
+    assert ek.all(res_shadow == res_naive.is_valid())
+    compare_results(res_naive, res, atol=1e-6)
+
+
+def test07_kdtree_cache(variant_scalar_rgb, tmpdir):
+    from mitsuba.core import Properties, Ray3f, Vector3f
+    from mitsuba.render import Scene
+    import os
+
+    if mitsuba.core.MTS_ENABLE_EMBREE:
+        pytest.skip("EMBREE enabled")
+
+    def make_scene():
+        props = Properties("scene")
+        props["kd_cache_dir"] = str(tmpdir)
+        props["_unnamed_0"] = create_stairs(20)
+        return Scene(props)
+
+    # The first scene builds the tree and writes it, the second one loads it
+    scene_built = make_scene()
+    assert len([f for f in os.listdir(str(tmpdir)) if f.endswith(".kdtree")]) == 1
+    scene_cached = make_scene()
+
+    n = 32
+    inv_n = 1.0 / (n - 1)
+    for x in range(n - 1):
+        for y in range(n - 1):
+            r = Ray3f([x * inv_n, y * inv_n, 2], ek.normalize(Vector3f(0.1, -0.3, -1)), 0.5, [])
+            r.mint = 0
+            r.maxt = 100
+
+            res_built  = scene_built.ray_intersect(r)
+            res_cached = scene_cached.ray_intersect(r)
+            compare_results(res_built, res_cached)
+
+
+@fresolver_append_path
+def test08_accel_refit(variants_cpu_rgb):
+    from mitsuba.core import xml, Ray3f
+    from mitsuba.python.util import traverse
+
+    # The native backend only refits its BVH
+    accel = '' if mitsuba.core.MTS_ENABLE_EMBREE else '<string name="accel" value="bvh"/>'
+    scene = xml.load_string('''
+        <scene version="2.0.0">
+            %s
+            <shape type="obj" id="rect">
+                <string name="filename" value="resources/data/common/meshes/rectangle.obj"/>
+                <boolean name="accel_refit" value="true"/>
+            </shape>
+        </scene>
+    ''' % accel)
+
+    mesh = scene.shapes()[0]
+    assert mesh.accel_refit()
+
+    ray = Ray3f([0.2, 0.3, -10], [0, 0, 1], 0, [])
+    assert ek.allclose(scene.ray_intersect(ray).t, 10)
+
+    # Move the rectangle along the Z axis, which refits the hierarchy
+    params = traverse(scene)
+    positions = mesh.vertex_positions_buffer()
+    for i in range(2, len(positions), 3):
+        positions[i] += 1.0
+    params.set_dirty('rect.vertex_positions_buf')
+    params.update()
+
+    assert ek.allclose(scene.ray_intersect(ray).t, 11)
+
+    # The old position must not be hit anymore
+    ray.maxt = 10.5
+    assert not ek.any(scene.ray_test(ray))
+
+
+def test09_compact_indices(variants_cpu_rgb):
+    from mitsuba.core import Properties, Ray3f, Vector3f
+    from mitsuba.render import Scene
+
+    if mitsuba.core.MTS_ENABLE_EMBREE:
+        pytest.skip("EMBREE enabled")
+
+    props = Properties("scene")
+    props["kd_compact_indices"] = True
+    props["kd_stop_prims"] = 8
+    props["_unnamed_0"] = create_stairs(20)
+    scene = Scene(props)
+
+    n = 32
+    inv_n = 1.0 / (n - 1)
+    for x in range(n - 1):
+        for y in range(n - 1):
+            r = Ray3f([x * inv_n, y * inv_n, 2], ek.normalize(Vector3f(0.1, -0.3, -1)), 0.5, [])
+            r.mint = 0
+            r.maxt = 100
+
+            res_naive = scene.ray_intersect_naive(r)
+            res       = scene.ray_intersect(r)
+            assert ek.all(scene.ray_test(r) == res_naive.is_valid())
+            compare_results(res_naive, res, atol=1e-6)
+
+
+def test10_stream_packet_stairs(variant_packet_rgb):
+    from mitsuba.core import Properties, Ray3f, Vector3f, Float, UInt32
+    from mitsuba.render import ShapeKDTree
+
+    if mitsuba.core.MTS_ENABLE_EMBREE:
+        pytest.skip("EMBREE enabled")
+
+    kdtree = ShapeKDTree(Properties())
+    kdtree.add_shape(create_stairs(11))
+    kdtree.build()
+    scene = make_synthetic_scene(11)
+
+    # Incoherent rays: scattered origins above the stairs, pointing up or down
+    n = 1000
+    idx = ek.arange(UInt32, n)
+    rays = Ray3f.zero(n)
+    rays.o = Vector3f(Float(idx) / n, Float((idx * 37) % n) / n, 2)
+    rays.d = ek.normalize(Vector3f(0.2, 0.1, ek.select(idx % 3 == 0, 1.0, -1.0)))
+    rays.mint = 0
+    rays.maxt = 100
+    rays.update()
+
+    res = scene.ray_intersect_preliminary(rays)
+    res_stream = kdtree.ray_intersect_stream(rays)
+    assert ek.all(res_stream.is_valid() == res.is_valid())
+    assert ek.allclose(ek.select(res.is_valid(), res_stream.t, 0),
+                       ek.select(res.is_valid(), res.t, 0), atol=1e-6)
+
+    res_shadow = kdtree.ray_intersect_stream(rays, shadow_ray=True)
+    assert ek.all(res_shadow.is_valid() == res.is_valid())
+
+
+@pytest.mark.parametrize("records", ["edges", "watertight"])
+def test11_triangle_records(variants_cpu_rgb, records):
+    from mitsuba.core import Properties, Ray3f, Vector3f
+    from mitsuba.render import Scene
+
+    if mitsuba.core.MTS_ENABLE_EMBREE:
+        pytest.skip("EMBREE enabled")
+
+    props = Properties("scene")
+    props["kd_triangle_records"] = records
+    props["_unnamed_0"] = create_stairs(20)
+    scene = Scene(props)
+
+    n = 32
+    inv_n = 1.0 / (n - 1)
+    for x in range(n - 1):
+        for y in range(n - 1):
+            r = Ray3f([x * inv_n, y * inv_n, 2], ek.normalize(Vector3f(0.1, -0.3, -1)), 0.5, [])
+            r.mint = 0
+            r.maxt = 100
+
+            res_naive = scene.ray_intersect_naive(r)
+            res       = scene.ray_intersect(r)
+            assert ek.all(scene.ray_test(r) == res_naive.is_valid())
+            compare_results(res_naive, res, atol=1e-5)
+
+
+def test12_build_statistics(variant_scalar_rgb):
+    from mitsuba.core import Properties
+    from mitsuba.render import ShapeKDTree
+
+    if mitsuba.core.MTS_ENABLE_EMBREE:
+        pytest.skip("EMBREE enabled")
+
+    kdtree = ShapeKDTree(Properties())
+    kdtree.add_shape(create_stairs(20))
+    kdtree.build()
+
+    stats = kdtree.build_statistics()
+    assert stats["node_count"] > 1
+    assert stats["leaf_count"] > 0
+    assert stats["nonempty_leaf_count"] <= stats["leaf_count"]
+    assert stats["index_count"] >= kdtree.primitive_count()
+    assert stats["max_depth"] > 0
+    assert stats["max_prims_in_leaf"] > 0
+    assert stats["final_cost"] > 0
+    assert stats["exp_primitives_queried"] > 0
+    assert stats["temp_storage"] > 0
+    assert ek.allclose(stats["avg_prims_in_leaf"],
+                       stats["index_count"] / stats["nonempty_leaf_count"])
+
+
+def test13_memory_budget(variant_scalar_rgb):
+    from mitsuba.core import Properties, Ray3f, Vector3f
+    from mitsuba.render import Scene, ShapeKDTree
+
+    if mitsuba.core.MTS_ENABLE_EMBREE:
+        pytest.skip("EMBREE enabled")
+
+    # The edge events of 8000 triangles don't fit into a 1 MiB budget
+    props = Properties()
+    props["kd_memory_budget"] = 1
+    kdtree = ShapeKDTree(props)
+    kdtree.add_shape(create_stairs(2000))
+    kdtree.build()
+
+    stats = kdtree.build_statistics()
+    assert stats["budget_fallbacks"] > 0
+    assert stats["node_count"] > 1
+
+    props = Properties("scene")
+    props["kd_memory_budget"] = 1
+    props["_unnamed_0"] = create_stairs(2000)
+    scene = Scene(props)
+
+    n = 8
+    inv_n = 1.0 / (n - 1)
+    for x in range(n):
+        for y in range(n):
+            r = Ray3f([x * inv_n, y * inv_n, 2], ek.normalize(Vector3f(0.1, -0.3, -1)), 0.5, [])
+            r.mint = 0
+            r.maxt = 100
+
+            res_naive = scene.ray_intersect_naive(r)
+            res       = scene.ray_intersect(r)
+            assert ek.all(scene.ray_test(r) == res_naive.is_valid())
+            compare_results(res_naive, res, atol=1e-5)
+
+
+@pytest.mark.parametrize("accel", ["kdtree", "bvh"])
+def test14_occluder_cache(variants_cpu_rgb, accel):
+    from mitsuba.core import Properties, Ray3f, Vector3f
+    from mitsuba.render import Scene
+
+    if mitsuba.core.MTS_ENABLE_EMBREE:
+        pytest.skip("EMBREE enabled")
+
+    props = Properties("scene")
+    props["accel"] = accel
+    props["occluder_cache"] = True
+    props["_unnamed_0"] = create_stairs(20)
+    scene = Scene(props)
+
+    # Neighboring rays (which often share the occluder) interleaved with
+    # rays that miss the stairs, which must not be reported as occluded
+    n = 32
+    inv_n = 1.0 / (n - 1)
+    for x in range(n - 1):
+        for y in range(n - 1):
+            for d in [Vector3f(0.1, -0.3, -1), Vector3f(0, 0, 1)]:
+                r = Ray3f([x * inv_n, y * inv_n, 2], ek.normalize(d), 0.5, [])
+                r.mint = 0
+                r.maxt = 100
+
+                res_naive = scene.ray_intersect_naive(r)
+                assert ek.all(scene.ray_test(r) == res_naive.is_valid())
+                assert ek.all(scene.ray_test(r) == res_naive.is_valid())
+
+
+@fresolver_append_path
+@pytest.mark.parametrize("accel", ["kdtree", "bvh"])
+def test14_occluder_cache_update(variants_cpu_rgb, accel):
+    from mitsuba.core import xml, Ray3f
+    from mitsuba.python.util import traverse
+
+    if mitsuba.core.MTS_ENABLE_EMBREE:
+        pytest.skip("EMBREE enabled")
+
+    scene = xml.load_string('''
+        <scene version="2.0.0">
+            <string name="accel" value="%s"/>
+            <boolean name="occluder_cache" value="true"/>
+            <shape type="obj" id="rect">
+                <string name="filename" value="resources/data/common/meshes/rectangle.obj"/>
+            </shape>
+        </scene>
+    ''' % accel)
+
+    # Caches the rectangle as the occluder of this thread
+    ray = Ray3f([0.2, 0.3, -10], [0, 0, 1], 0, [])
+    ray.maxt = 10.5
+    assert ek.all(scene.ray_test(ray))
+
+    # Move the rectangle past the end of the ray
+    params = traverse(scene)
+    positions = scene.shapes()[0].vertex_positions_buffer()
+    for i in range(2, len(positions), 3):
+        positions[i] += 1.0
+    params.set_dirty('rect.vertex_positions_buf')
+    params.update()
+
+    assert not ek.any(scene.ray_test(ray))
+    ray.maxt = 11.5
+    assert ek.all(scene.ray_test(ray))
+
+
+@pytest.mark.parametrize("accel", ["kdtree", "bvh"])
+def test15_vertex_motion(variant_scalar_rgb, accel):
+    from mitsuba.core import Properties, Ray3f, Vector3f
+    from mitsuba.render import Scene
+
+    if mitsuba.core.MTS_ENABLE_EMBREE:
+        pytest.skip("EMBREE enabled")
+
+    # Stairs that slide by half their depth along Y while the shutter is open
+    mesh = create_stairs(20)
+    mesh.set_vertex_motion(0.2, 0.8)
+    assert mesh.has_vertex_motion() and mesh.has_motion()
+    assert ek.allclose(mesh.motion_time_range(), [0.2, 0.8])
+
+    positions = mesh.vertex_positions_end_buffer()
+    for i in range(1, len(positions), 3):
+        positions[i] += 0.5
+    mesh.recompute_bbox()
+    assert ek.allclose(mesh.bbox().max.y, 1.5)
+
+    props = Properties("scene")
+    props["accel"] = accel
+    props["bvh_max_leaf_prims"] = 2
+    props["_unnamed_0"] = mesh
+    scene = Scene(props)
+
+    n = 24
+    inv_n = 1.0 / (n - 1)
+    for time in [0.0, 0.35, 0.5, 0.8, 1.0]:
+        for x in range(n):
+            for y in range(n):
+                r = Ray3f([x * inv_n, y * inv_n * 1.5, 2],
+                          ek.normalize(Vector3f(0.1, -0.3, -1)), time, [])
+                r.mint = 0
+                r.maxt = 100
+
+                res_naive = scene.ray_intersect_naive(r)
+                res       = scene.ray_intersect(r)
+                assert ek.all(scene.ray_test(r) == res_naive.is_valid())
+                compare_results(res_naive, res, atol=1e-6)
+
+    # The stairs only cover the region behind the origin at the start
+    r = Ray3f([0.5, 0.1, 2], [0, 0, -1], 0.0, [])
+    assert scene.ray_test(r)
+    r.time = 1.0
+    assert not scene.ray_test(r)
+
+
+def test16_shape_batches(variant_scalar_rgb):
+    from mitsuba.core import Ray3f, Vector3f
+    from mitsuba.core.xml import load_string
+
+    if mitsuba.core.MTS_ENABLE_EMBREE:
+        pytest.skip("EMBREE enabled")
+
+    # Overlapping spheres, disks, rectangles, and cylinders in large leaves
+    shapes = ""
+    for i in range(5):
+        for j in range(5):
+            x, y = 0.25 * i, 0.25 * j
+            shapes += """
+                <shape type="sphere">
+                    <point name="center" x="{x}" y="{y}" z="0"/>
+                    <float name="radius" value="0.15"/>
+                </shape>
+                <shape type="disk">
+                    <transform name="to_world">
+                        <scale value="0.1"/>
+                        <rotate x="1" angle="30"/>
+                        <translate x="{x}" y="{y}" z="0.3"/>
+                    </transform>
+                </shape>
+                <shape type="rectangle">
+                    <transform name="to_world">
+                        <scale value="0.08"/>
+                        <rotate y="1" angle="-20"/>
+                        <translate x="{x}" y="{y}" z="0.5"/>
+                    </transform>
+                </shape>
+                <shape type="cylinder">
+                    <point name="p0" x="{x}" y="{y}" z="-0.4"/>
+                    <point name="p1" x="{x}" y="{y2}" z="0.2"/>
+                    <float name="radius" value="0.05"/>
+                </shape>""".format(x=x, y=y, y2=y + 0.1)
+
+    scene = load_string("""
+        <scene version="2.0.0">
+            <integer name="kd_stop_prims" value="64"/>
+            <integer name="kd_shape_batches" value="2"/>
+            %s
+        </scene>
+    """ % shapes)
+
+    n = 40
+    inv_n = 1.0 / (n - 1)
+    for x in range(n):
+        for y in range(n):
+            for z in [2, 0]:
+                # Rays from above, and from within the spheres (exiting them)
+                r = Ray3f([x * inv_n * 1.2 - 0.1, y * inv_n * 1.2 - 0.1, z],
+                          ek.normalize(Vector3f(0.2, -0.1, -1)), 0.5, [])
+                r.mint = 0
+                r.maxt = 100
+
+                res_naive = scene.ray_intersect_naive(r)
+                res       = scene.ray_intersect(r)
+                assert ek.all(scene.ray_test(r) == res_naive.is_valid())
+                compare_results(res_naive, res, atol=1e-5)
+                if res.is_valid():
+                    assert ek.allclose(res.uv, res_naive.uv, atol=1e-4)
@@ -231,6 +231,14 @@ def test08_mesh_add_attribute(variant_scalar_rgb):
   ]
 ]"""
 
+    # Invalid names and channel counts are rejected
+    with pytest.raises(RuntimeError):
+        m.add_attribute("vertex_color", 3, [0.0] * 9)
+    with pytest.raises(RuntimeError):
+        m.add_attribute("color", 3, [0.0] * 9)
+    with pytest.raises(RuntimeError):
+        m.add_attribute("vertex_empty", 0, [])
+
 @fresolver_append_path
 def test09_eval_parameterization(variant_scalar_rgb, variant_packet_rgb):
     from mitsuba.core.xml import load_string
@@ -648,3 +656,545 @@ def test16_differentiable_surface_interaction_params_backward(variant_gpu_autodi
     assert ek.allclose(ek.gradient(params[vertex_texcoords_key]),
                        [0, 2, 0, 0, 0, 0, 0, -2], atol=1e-5)
 
+
+@pytest.mark.parametrize('face_normals', [True, False])
+def test17_obj_parallel_loader(variant_scalar_rgb, tmpdir, face_normals):
+    """The parallel OBJ loader must produce the same triangles as the
+    sequential one, up to the order of the vertices"""
+    from mitsuba.core.xml import load_dict
+    import numpy as np
+
+    # Grid of quads, which share positions but not texture coordinates along a seam
+    n = 160
+    filename = str(tmpdir.join('grid.obj'))
+    vertices = ['%.9g %.9g %.4e' % (x / (n - 1.0), -y * 1e-3 / 3, (x * y) % 7)
+                for y in range(n) for x in range(n)]
+    with open(filename, 'w') as f:
+        for v in vertices:
+            f.write('v %s\n' % v)
+        f.write('vt 0 0\nvt 1 0\nvt 0 1\nvt 1 1\nvn 0 0 1\nvn 0 1 0\n')
+        for y in range(n - 1):
+            for x in range(n - 1):
+                i = y * n + x + 1
+                t = 1 if x < n // 2 else 3
+                f.write('f %i/%i/1 %i/%i/1 %i/%i/2 %i/%i/2\n' %
+                        (i, t, i + 1, t, i + n + 1, t + 1, i + n, t + 1))
+
+    def load(parallel_threshold):
+        mesh = load_dict({
+            'type' : 'obj',
+            'filename' : filename,
+            'face_normals' : face_normals,
+            'parallel_threshold' : parallel_threshold
+        })
+        faces = np.array(mesh.faces_buffer()).reshape(-1, 3)
+        positions = np.array(mesh.vertex_positions_buffer()).reshape(-1, 3)
+        texcoords = np.array(mesh.vertex_texcoords_buffer()).reshape(-1, 2)
+        return mesh, positions[faces], texcoords[faces]
+
+    mesh_seq, p_seq, uv_seq = load(1 << 40)
+    mesh_par, p_par, uv_par = load(0)
+
+    assert mesh_seq.vertex_count() == mesh_par.vertex_count()
+    assert mesh_seq.face_count() == mesh_par.face_count() == 2 * (n - 1) ** 2
+    assert np.all(p_seq == p_par)
+    assert np.all(uv_seq == uv_par)
+    assert ek.allclose(mesh_par.bbox().min, mesh_seq.bbox().min)
+    assert ek.allclose(mesh_par.bbox().max, mesh_seq.bbox().max)
+    if not face_normals:
+        faces = np.array(mesh_par.faces_buffer()).reshape(-1, 3)
+        normals = np.array(mesh_par.vertex_normals_buffer()).reshape(-1, 3)
+        assert np.allclose(normals[faces[0]], [[0, 0, 1], [0, 0, 1], [0, 1, 0]])
+
+    # Compare against the reference conversion of the decimal numbers
+    expected = np.float32([[float(t) for t in v.split()] for v in vertices])
+    positions = np.array(mesh_par.vertex_positions_buffer()).reshape(-1, 3)
+    assert np.all(np.unique(positions, axis=0) == np.unique(expected, axis=0))
+
+
+@pytest.mark.parametrize('layout', ['positions', 'full', 'double'])
+def test18_ply_parallel_loader(variant_scalar_rgb, tmpdir, layout):
+    """Memory-mapped binary PLY files must load exactly like the ones that
+    are read through the stream-based loader"""
+    from mitsuba.core import ScalarTransform4f
+    from mitsuba.core.xml import load_dict
+    import numpy as np
+
+    n = 50
+    x, y = np.meshgrid(np.linspace(0, 1, n), np.linspace(0, 2, n))
+    z = np.sin(x * 5) * y
+
+    ptype = 'f8' if layout == 'double' else 'f4'
+    fields = [('x', ptype), ('y', ptype), ('z', ptype)]
+    if layout != 'positions':
+        fields += [('nx', 'f4'), ('ny', 'f4'), ('nz', 'f4'),
+                   ('u', 'f4'), ('v', 'f4'), ('r', 'f4'), ('g', 'f4'), ('b', 'f4')]
+    vertices = np.zeros(n * n, dtype=np.dtype(fields).newbyteorder('<'))
+    vertices['x'], vertices['y'], vertices['z'] = x.ravel(), y.ravel(), z.ravel()
+    if layout != 'positions':
+        vertices['nz'] = 1
+        vertices['u'], vertices['v'] = x.ravel(), y.ravel() / 2
+        vertices['r'] = np.arange(n * n) / (n * n)
+
+    idx = np.arange(n * n).reshape(n, n)[:-1, :-1].ravel()
+    indices = np.concatenate([np.stack([idx, idx + 1, idx + n + 1], axis=1),
+                              np.stack([idx, idx + n + 1, idx + n], axis=1)])
+    faces = np.zeros(len(indices), dtype=np.dtype(
+        [('count', 'u1'), ('i', '<i4', 3), ('weight_x', '<f4')]))
+    faces['count'] = 3
+    faces['i'] = indices
+    faces['weight_x'] = np.arange(len(indices))
+
+    type_names = { 'f4' : 'float', 'f8' : 'double' }
+    filename = str(tmpdir.join('grid.ply'))
+    with open(filename, 'wb') as f:
+        header = 'ply\nformat binary_little_endian 1.0\nelement vertex %i\n' % len(vertices)
+        for name, dtype in fields:
+            header += 'property %s %s\n' % (type_names[dtype], name)
+        header += 'element face %i\n' % len(faces)
+        header += 'property list uchar int vertex_indices\nproperty float weight_x\nend_header\n'
+        f.write(header.encode())
+        f.write(vertices.tobytes())
+        f.write(faces.tobytes())
+
+    def load(parallel_threshold):
+        return load_dict({
+            'type' : 'ply',
+            'filename' : filename,
+            'to_world' : ScalarTransform4f.rotate([1, 0, 0], 30),
+            # Without normals, the records of 'positions' are used as is
+            'face_normals' : layout == 'positions',
+            'parallel_threshold' : parallel_threshold
+        })
+
+    mesh_seq, mesh_par = load(1 << 40), load(0)
+    assert mesh_seq.vertex_count() == mesh_par.vertex_count() == n * n
+    assert mesh_seq.face_count() == mesh_par.face_count() == 2 * (n - 1) ** 2
+    for buf in ['faces_buffer', 'vertex_positions_buffer',
+                'vertex_normals_buffer', 'vertex_texcoords_buffer']:
+        assert np.all(np.array(getattr(mesh_seq, buf)()) ==
+                      np.array(getattr(mesh_par, buf)()))
+    for attr in ['face_weight'] + (['vertex_color'] if layout != 'positions' else []):
+        assert np.all(np.array(mesh_seq.attribute_buffer(attr)) ==
+                      np.array(mesh_par.attribute_buffer(attr)))
+    assert ek.allclose(mesh_par.bbox().min, mesh_seq.bbox().min)
+    assert ek.allclose(mesh_par.bbox().max, mesh_seq.bbox().max)
+
+
+@pytest.mark.parametrize('double_precision', [False, True])
+def test19_serialized_block_compressed(variant_scalar_rgb, tmpdir, double_precision):
+    """Version 5 .serialized shapes must load like the zlib stream-based
+    version 4 ones, also when both are stored in the same file"""
+    from mitsuba.core.xml import load_dict
+    import numpy as np
+    import struct
+    import zlib
+
+    n = 40
+    x, y = np.meshgrid(np.linspace(0, 1, n), np.linspace(0, 2, n))
+    positions = np.stack([x.ravel(), y.ravel(), np.sin(x * 5).ravel() * y.ravel()], axis=1)
+    normals = np.tile([0.0, 0.0, 1.0], (n * n, 1))
+    texcoords = np.stack([x.ravel(), y.ravel() / 2], axis=1)
+    colors = np.random.rand(n * n, 3)
+    idx = np.arange(n * n).reshape(n, n)[:-1, :-1].ravel()
+    faces = np.concatenate([np.stack([idx, idx + 1, idx + n + 1], axis=1),
+                            np.stack([idx, idx + n + 1, idx + n], axis=1)])
+
+    dtype = '<f8' if double_precision else '<f4'
+    flags = 0x0001 | 0x0002 | 0x0008 | (0x2000 if double_precision else 0x1000)
+    arrays = [positions.astype(dtype).tobytes(), normals.astype(dtype).tobytes(),
+              texcoords.astype(dtype).tobytes(), colors.astype(dtype).tobytes(),
+              faces.astype('<u4').tobytes()]
+    header = struct.pack('<I', flags) + b'grid\0' + struct.pack('<QQ', n * n, len(faces))
+
+    shape_v4 = struct.pack('<HH', 0x041C, 4) + zlib.compress(header + b''.join(arrays))
+
+    # Split every array into several blocks of whole values
+    step = 8 * 1000
+    chunks = [a[i:i + step] for a in arrays for i in range(0, len(a), step)]
+    blocks = [zlib.compress(c) for c in chunks]
+    table, offset = b'', 4 + len(header) + 4 + 24 * len(blocks)
+    for block, chunk in zip(blocks, chunks):
+        table += struct.pack('<QQQ', offset, len(block), len(chunk))
+        offset += len(block)
+    shape_v5 = (struct.pack('<HH', 0x041C, 5) + header + struct.pack('<I', len(blocks)) +
+                table + b''.join(blocks))
+
+    filename = str(tmpdir.join('grid.serialized'))
+    with open(filename, 'wb') as f:
+        f.write(shape_v4 + shape_v5)
+        f.write(struct.pack('<QQI', 0, len(shape_v4), 2))
+
+    def load(shape_index):
+        return load_dict({
+            'type' : 'serialized',
+            'filename' : filename,
+            'shape_index' : shape_index
+        })
+
+    mesh_v4, mesh_v5 = load(0), load(1)
+    assert mesh_v5.vertex_count() == n * n
+    assert mesh_v5.face_count() == len(faces)
+    for buf in ['faces_buffer', 'vertex_positions_buffer',
+                'vertex_normals_buffer', 'vertex_texcoords_buffer']:
+        assert np.all(np.array(getattr(mesh_v4, buf)()) ==
+                      np.array(getattr(mesh_v5, buf)()))
+    assert ek.allclose(mesh_v4.bbox().min, mesh_v5.bbox().min)
+    assert ek.allclose(mesh_v4.bbox().max, mesh_v5.bbox().max)
+
+
+@fresolver_append_path
+@pytest.mark.parametrize('transformed', [False, True])
+def test20_mtsmesh_roundtrip(variant_scalar_rgb, tmpdir, transformed):
+    """Meshes written with write_mtsmesh() must load with the same contents,
+    bounding box and area sampling table"""
+    from mitsuba.core import ScalarTransform4f
+    from mitsuba.core.xml import load_dict
+    import numpy as np
+
+    to_world = ScalarTransform4f.translate([1, 2, 3]) * ScalarTransform4f.scale([2, 2, 2])
+
+    def load_ply(**kwargs):
+        mesh = load_dict(dict(type='ply',
+                              filename='resources/data/tests/ply/cbox_smallbox.ply',
+                              **kwargs))
+        mesh.add_attribute('face_weight', 1, np.arange(mesh.face_count(), dtype=np.float32))
+        return mesh
+
+    filename = str(tmpdir.join('smallbox.mtsmesh'))
+    reference = load_ply()
+    reference.surface_area()  # builds the area PMF that is written to the file
+    reference.write_mtsmesh(filename)
+
+    if transformed:
+        reference = load_ply(to_world=to_world)
+        mesh = load_dict({ 'type' : 'mtsmesh', 'filename' : filename, 'to_world' : to_world })
+    else:
+        mesh = load_dict({ 'type' : 'mtsmesh', 'filename' : filename })
+
+    assert mesh.vertex_count() == reference.vertex_count()
+    assert mesh.face_count() == reference.face_count()
+    assert np.all(np.array(mesh.faces_buffer()) == np.array(reference.faces_buffer()))
+    assert np.allclose(np.array(mesh.vertex_positions_buffer()),
+                       np.array(reference.vertex_positions_buffer()))
+    assert np.allclose(np.array(mesh.vertex_normals_buffer()),
+                       np.array(reference.vertex_normals_buffer()))
+    assert np.all(np.array(mesh.attribute_buffer('face_weight')) ==
+                  np.array(reference.attribute_buffer('face_weight')))
+    assert ek.allclose(mesh.bbox().min, reference.bbox().min)
+    assert ek.allclose(mesh.bbox().max, reference.bbox().max)
+    assert ek.allclose(mesh.surface_area(), reference.surface_area())
+
+    for sample in [[0.1, 0.2], [0.5, 0.5], [0.9, 0.3]]:
+        ps, ps_ref = mesh.sample_position(0, sample), reference.sample_position(0, sample)
+        assert ek.allclose(ps.p, ps_ref.p, atol=1e-4)
+        assert ek.allclose(ps.pdf, ps_ref.pdf)
+
+
+def test21_compressed_vertex_data(variant_scalar_rgb):
+    """Compressed normals, texture coordinates and attributes must decode to
+    values close to the original ones during intersection queries"""
+    from mitsuba.core import Ray3f, Vector3f
+    from mitsuba.core.xml import load_dict
+    from mitsuba.render import Mesh
+
+    def create_mesh():
+        m = Mesh("MyMesh", 3, 1, has_vertex_normals=True, has_vertex_texcoords=True)
+        m.vertex_positions_buffer()[:] = [0.0, 0.0, 0.0, 1.0, 0.0, 0.0, 0.0, 1.0, 0.0]
+        m.vertex_normals_buffer()[:] = [0.0, 0.0, 1.0, 0.6, 0.0, 0.8, 0.0, -0.6, -0.8]
+        m.vertex_texcoords_buffer()[:] = [0.25, -1.5, 3.0, 0.5, 1.0, 2.0]
+        m.faces_buffer()[:] = [0, 1, 2]
+        m.parameters_changed()
+        m.add_attribute("vertex_color", 3, [0.1, 0.2, 0.3, 0.9, 0.5, 0.0, 0.25, 1.0, 0.75])
+        return m
+
+    reference, mesh = create_mesh(), create_mesh()
+    mesh.compress_vertex_data()
+
+    assert mesh.has_compressed_vertex_data()
+    assert not reference.has_compressed_vertex_data()
+    assert mesh.has_vertex_normals() and mesh.has_vertex_texcoords()
+    assert len(mesh.vertex_normals_buffer()) == 0
+    assert "vertices = [78 B of vertex data]" in str(mesh)
+
+    texture = load_dict({ "type" : "mesh_attribute", "name" : "vertex_color" })
+
+    for x, y in [(0.1, 0.1), (0.6, 0.3), (0.2, 0.7), (0.0, 0.0)]:
+        ray = Ray3f(Vector3f(x, y, -1.0), Vector3f(0.0, 0.0, 1.0), 0, [])
+        si = mesh.ray_intersect_triangle(0, ray).compute_surface_interaction(ray)
+        si_ref = reference.ray_intersect_triangle(0, ray).compute_surface_interaction(ray)
+
+        assert ek.allclose(si.sh_frame.n, si_ref.sh_frame.n, atol=1e-3)
+        assert ek.allclose(si.uv, si_ref.uv, atol=1e-4)
+        assert ek.allclose(si.dp_du, si_ref.dp_du, atol=1e-3)
+        assert ek.allclose(texture.eval(si), texture.eval(si_ref), atol=1e-3)
+
+    with pytest.raises(Exception) as e:
+        mesh.write_ply("compressed.ply")
+    e.match("compressed vertex data")
+
+
+@fresolver_append_path
+def test22_compressed_face_indices(variant_scalar_rgb):
+    """Meshes with 16-bit face indices must be intersected and sampled like
+    the original ones"""
+    from mitsuba.core import Ray3f, Vector3f
+    from mitsuba.core.xml import load_dict
+    import numpy as np
+
+    def load_scene(compress):
+        return load_dict({
+            "type" : "scene",
+            "mesh" : {
+                "type" : "ply",
+                "filename" : "resources/data/tests/ply/cbox_smallbox.ply",
+                "compress_vertex_data" : compress
+            }
+        })
+
+    scene, scene_ref = load_scene(True), load_scene(False)
+    mesh, reference = scene.shapes()[0], scene_ref.shapes()[0]
+
+    assert mesh.has_compressed_vertex_data()
+    assert mesh.face_count() == reference.face_count()
+    for i in range(mesh.face_count()):
+        assert mesh.bbox(i) == reference.bbox(i)
+
+    assert ek.allclose(mesh.surface_area(), reference.surface_area())
+    for sample in [[0.1, 0.2], [0.5, 0.5], [0.9, 0.3]]:
+        ps, ps_ref = mesh.sample_position(0, sample), reference.sample_position(0, sample)
+        assert ek.allclose(ps.p, ps_ref.p, atol=1e-4)
+
+    center = reference.bbox().center()
+    for d in [[0, 0, 1], [0, 1, 0], [1, 0, 0], [0.3, -0.4, 0.5]]:
+        d = ek.normalize(Vector3f(d))
+        ray = Ray3f(center - 1000 * d, d, 0, [])
+        si, si_ref = scene.ray_intersect(ray), scene_ref.ray_intersect(ray)
+        assert si.is_valid() and si_ref.is_valid()
+        assert si.prim_index == si_ref.prim_index
+        assert ek.allclose(si.p, si_ref.p, atol=1e-3)
+        assert ek.allclose(si.sh_frame.n, si_ref.sh_frame.n, atol=1e-3)
+
+
+def test23_parallel_normals_and_pmf(variant_scalar_rgb):
+    """Normals and area sampling tables of meshes that span several blocks of
+    the parallel loops must match a direct computation"""
+    from mitsuba.render import Mesh
+    import numpy as np
+
+    # Tessellated unit sphere (without the poles)
+    n_theta, n_phi = 100, 200
+    theta, phi = np.meshgrid(np.linspace(0.1, np.pi - 0.1, n_theta),
+                             np.linspace(0, 2 * np.pi, n_phi, endpoint=False),
+                             indexing='ij')
+    positions = np.stack([np.sin(theta) * np.cos(phi),
+                          np.sin(theta) * np.sin(phi),
+                          np.cos(theta)], axis=-1).reshape(-1, 3)
+
+    idx = np.arange(n_theta * n_phi).reshape(n_theta, n_phi)
+    i0, i1 = idx[:-1, :], np.roll(idx, -1, axis=1)[:-1, :]
+    i2, i3 = idx[1:, :], np.roll(idx, -1, axis=1)[1:, :]
+    faces = np.concatenate([np.stack([i0, i2, i1], axis=-1).reshape(-1, 3),
+                            np.stack([i1, i2, i3], axis=-1).reshape(-1, 3)])
+
+    m = Mesh("Sphere", len(positions), len(faces), has_vertex_normals=True)
+    m.vertex_positions_buffer()[:] = positions.astype(np.float32).ravel()
+    m.faces_buffer()[:] = faces.astype(np.uint32).ravel()
+    m.parameters_changed()
+
+    # Interior vertices of the smooth sphere have radial normals
+    normals = np.array(m.vertex_normals_buffer()).reshape(-1, 3)
+    interior = idx[1:-1, :].ravel()
+    assert np.allclose(normals[interior], positions[interior], atol=1e-3)
+
+    p = positions.astype(np.float32)
+    areas = 0.5 * np.linalg.norm(np.cross(p[faces[:, 1]] - p[faces[:, 0]],
+                                          p[faces[:, 2]] - p[faces[:, 0]]), axis=1)
+    assert ek.allclose(m.surface_area(), np.sum(areas, dtype=np.float64), rtol=1e-5)
+
+    # Samples near the end of the CDF must land on the last faces
+    ps = m.sample_position(0, [0.5, 0.9999999])
+    assert ek.allclose(ps.pdf, 1.0 / m.surface_area(), rtol=1e-4)
+
+
+@fresolver_append_path
+def test24_mtsmesh_mapped_sorted(variant_scalar_rgb, tmpdir):
+    """Spatially sorted meshes must contain the same triangles, and meshes
+    that refer to a memory-mapped cache file must render like copied ones"""
+    from mitsuba.core import Ray3f, Vector3f
+    from mitsuba.core.xml import load_dict
+    import numpy as np
+
+    ply = { "type" : "ply", "filename" : "resources/data/tests/ply/cbox_smallbox.ply" }
+    reference = load_dict(ply)
+    mesh = load_dict(ply)
+    mesh.sort_spatially()
+
+    def triangles(m):
+        p = np.array(m.vertex_positions_buffer()).reshape(-1, 3)
+        f = np.array(m.faces_buffer()).reshape(-1, 3)
+        t = [tuple(sorted(tuple(v) for v in p[face])) for face in f]
+        return sorted(t)
+
+    assert mesh.vertex_count() == reference.vertex_count()
+    assert triangles(mesh) == triangles(reference)
+    assert ek.allclose(mesh.surface_area(), reference.surface_area())
+
+    filename = str(tmpdir.join('smallbox_sorted.mtsmesh'))
+    mesh.write_mtsmesh(filename)
+
+    scene_ref = load_dict({ "type" : "scene", "mesh" : ply })
+    scene = load_dict({
+        "type" : "scene",
+        "mesh" : { "type" : "mtsmesh", "filename" : filename, "mmap" : True }
+    })
+    mapped = scene.shapes()[0]
+    assert np.all(np.array(mapped.faces_buffer()) == np.array(mesh.faces_buffer()))
+    assert ek.allclose(mapped.surface_area(), reference.surface_area())
+
+    center = reference.bbox().center()
+    for d in [[0, 0, 1], [0, 1, 0], [1, 0, 0], [0.3, -0.4, 0.5]]:
+        d = ek.normalize(Vector3f(d))
+        ray = Ray3f(center - 1000 * d, d, 0, [])
+        si, si_ref = scene.ray_intersect(ray), scene_ref.ray_intersect(ray)
+        assert si.is_valid() and si_ref.is_valid()
+        assert ek.allclose(si.p, si_ref.p, atol=1e-3)
+        assert ek.allclose(si.sh_frame.n, si_ref.sh_frame.n, atol=1e-3)
+
+
+@fresolver_append_path
+def test25_write_ply_roundtrip(variant_scalar_rgb, tmpdir):
+    """Meshes exported with write_ply() must load with the same vertex, face
+    and attribute data"""
+    from mitsuba.core.xml import load_dict
+    import numpy as np
+
+    reference = load_dict({ "type" : "ply",
+                            "filename" : "resources/data/tests/ply/cbox_smallbox.ply" })
+    n_v, n_f = reference.vertex_count(), reference.face_count()
+    reference.add_attribute("vertex_color", 3, np.linspace(0, 1, 3 * n_v, dtype=np.float32))
+    reference.add_attribute("face_weight", 1, np.arange(n_f, dtype=np.float32))
+
+    filename = str(tmpdir.join('smallbox.ply'))
+    reference.write_ply(filename)
+    mesh = load_dict({ "type" : "ply", "filename" : filename })
+
+    assert mesh.vertex_count() == n_v and mesh.face_count() == n_f
+    assert np.all(np.array(mesh.faces_buffer()) == np.array(reference.faces_buffer()))
+    for name in ["vertex_color", "face_weight"]:
+        assert np.all(np.array(mesh.attribute_buffer(name)) ==
+                      np.array(reference.attribute_buffer(name)))
+    assert np.all(np.array(mesh.vertex_positions_buffer()) ==
+                  np.array(reference.vertex_positions_buffer()))
+    assert np.all(np.array(mesh.vertex_normals_buffer()) ==
+                  np.array(reference.vertex_normals_buffer()))
+
+
+def test26_memory_accounting(variant_scalar_rgb):
+    from mitsuba.core import MemoryAccounting, MemoryCategory
+    from mitsuba.render import Mesh
+
+    before = MemoryAccounting.current(MemoryCategory.Geometry)
+    m = Mesh("tri", 3, 1)
+    # Three single precision positions per vertex and three 32 bit indices per face
+    assert MemoryAccounting.current(MemoryCategory.Geometry) == before + 3 * 12 + 12
+
+    del m
+    assert MemoryAccounting.current(MemoryCategory.Geometry) == before
+
+
+def test27_serialized_zstd_blocks(variant_scalar_rgb, tmpdir):
+    """Version 5 .serialized shapes can store their blocks as zstd frames"""
+    from mitsuba.core import MemoryStream, ZStream
+    from mitsuba.core.xml import load_dict
+    import numpy as np
+    import struct
+
+    if not ZStream.has_zstd():
+        pytest.skip('Compiled without zstd support')
+
+    def compress(data):
+        stream = MemoryStream()
+        zstream = ZStream(stream, ZStream.EZstdStream)
+        zstream.write(data)
+        zstream.close()
+        stream.seek(0)
+        return stream.read(stream.size())
+
+    positions = np.array([[0, 0, 0], [1, 0, 0], [0, 1, 0], [1, 1, 0]], dtype='<f4')
+    faces = np.array([[0, 1, 2], [1, 3, 2]], dtype='<u4')
+    chunks = [positions.tobytes(), faces.tobytes()]
+    blocks = [compress(c) for c in chunks]
+
+    header = struct.pack('<I', 0x1000 | 0x4000) + b'quad\0' + struct.pack('<QQ', 4, 2)
+    table, offset = b'', 4 + len(header) + 4 + 24 * len(blocks)
+    for block, chunk in zip(blocks, chunks):
+        table += struct.pack('<QQQ', offset, len(block), len(chunk))
+        offset += len(block)
+
+    filename = str(tmpdir.join('quad.serialized'))
+    with open(filename, 'wb') as f:
+        f.write(struct.pack('<HH', 0x041C, 5) + header + struct.pack('<I', len(blocks)) +
+                table + b''.join(blocks))
+
+    mesh = load_dict({ 'type' : 'serialized', 'filename' : filename })
+    assert np.all(np.array(mesh.faces_buffer()) == faces.ravel())
+    assert np.all(np.array(mesh.vertex_positions_buffer()) == positions.ravel())
+
+
+def test28_buffer_views(variant_scalar_rgb):
+    from mitsuba.render import Mesh
+    import numpy as np
+
+    m = Mesh("MyMesh", 3, 1)
+    m.vertex_positions_buffer()[:] = [0.0, 0.0, 0.0, 1.0, 0.2, 0.0, 0.2, 1.0, 0.0]
+    m.faces_buffer()[:] = [0, 1, 2]
+
+    positions, faces = m.buffer_view('vertex_positions'), m.buffer_view('faces')
+    assert positions.shape == (3, 3) and positions.dtype == np.float32
+    assert faces.shape == (1, 3) and faces.dtype == np.uint32
+    assert np.all(faces == [[0, 1, 2]])
+
+    # Modifications are visible on both sides, as the memory is shared
+    positions[1, 2] = 4
+    assert ek.allclose(m.vertex_positions_buffer()[5], 4)
+    m.vertex_positions_buffer()[0] = 3
+    assert positions[0, 0] == 3
+
+    # The views keep the mesh alive
+    del m
+    assert positions[1, 2] == 4 and positions[0, 0] == 3
+
+    m = Mesh("MyMesh", 3, 1)
+    assert 'dltensor' in repr(m.buffer_dlpack('faces'))
+    with pytest.raises(RuntimeError):
+        m.buffer_view('vertex_normals')
+    with pytest.raises(RuntimeError):
+        m.buffer_view('vertex_missing')
+
+
+@fresolver_append_path
+def test29_sort_spatially_on_load(variant_scalar_rgb):
+    """Meshes loaded with the ``sort_spatially`` property contain the same
+    triangles, with the vertices numbered in the order of their first use"""
+    from mitsuba.core.xml import load_dict
+    import numpy as np
+
+    ply = { "type" : "ply", "filename" : "resources/data/tests/ply/cbox_smallbox.ply" }
+    reference = load_dict(ply)
+    mesh = load_dict(dict(ply, sort_spatially=True))
+
+    def triangles(m):
+        p = np.array(m.vertex_positions_buffer()).reshape(-1, 3)
+        f = np.array(m.faces_buffer()).reshape(-1, 3)
+        return sorted(tuple(sorted(tuple(v) for v in p[face])) for face in f)
+
+    assert mesh.face_count() == reference.face_count()
+    assert triangles(mesh) == triangles(reference)
+    assert ek.allclose(mesh.surface_area(), reference.surface_area())
+
+    # Every face introduces at most the next unused vertex indices
+    next_index = 0
+    for index in np.array(mesh.faces_buffer()):
+        assert index <= next_index
+        next_index = max(next_index, index + 1)
@@ -333,4 +333,31 @@ def test06_chi2(variant_packet_rgb, md_type_name, alpha, sample_visible, angle):
         ires=10
     )
 
-    assert chi2.run()
\ No newline at end of file
+    assert chi2.run()
+
+@pytest.mark.parametrize("alpha", [(0.1, 0.1), (0.3, 0.3), (0.05, 0.4)])
+def test07_sample_tabulated_beckmann(variant_packet_rgb, alpha):
+    from mitsuba.core import Vector3f
+    from mitsuba.render import MicrofacetDistribution, MicrofacetType
+
+    mdf_ref = MicrofacetDistribution(MicrofacetType.Beckmann, alpha[0], alpha[1], True, False)
+    mdf_tab = MicrofacetDistribution(MicrofacetType.Beckmann, alpha[0], alpha[1], True, True)
+    assert mdf_tab.tabulated_sampling() and not mdf_ref.tabulated_sampling()
+
+    # Compare against the analytic sampling routine for various incident directions
+    steps = 32
+    u = ek.linspace(Float, 0.01, 0.99, steps)
+    u1, u2 = ek.meshgrid(u, u)
+
+    for theta in [0, 0.4, 0.9, 1.3, 1.5]:
+        for phi in [0, 2]:
+            wi = Vector3f(ek.sin(theta) * ek.cos(phi), ek.sin(theta) * ek.sin(phi), ek.cos(theta))
+            ek.set_slices(wi, steps * steps)
+
+            m_ref, pdf_ref = mdf_ref.sample(wi, [u1, u2])
+            m_tab, pdf_tab = mdf_tab.sample(wi, [u1, u2])
+
+            assert ek.allclose(m_ref, m_tab, atol=2e-3)
+
+            # Densities are evaluated analytically for the sampled normal
+            assert ek.allclose(pdf_tab, mdf_ref.pdf(wi, m_tab), rtol=1e-4)
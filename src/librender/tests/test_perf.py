@@ -0,0 +1,91 @@
+import mitsuba
+import pytest
+
+from .mesh_generation import create_stairs
+
+# Timed benchmarks, only run with 'pytest --perf' (see src/conftest.py)
+pytestmark = pytest.mark.perf
+
+
+def make_render_scene(resolution, spp):
+    from mitsuba.core.xml import load_string
+
+    return load_string("""
+        <scene version="2.0.0">
+            <integrator type="path">
+                <integer name="max_depth" value="6"/>
+            </integrator>
+            <sensor type="perspective">
+                <transform name="to_world">
+                    <lookat origin="0, -4, 2" target="0, 0, 0.5" up="0, 0, 1"/>
+                </transform>
+                <film type="hdrfilm">
+                    <integer name="width" value="{res}"/>
+                    <integer name="height" value="{res}"/>
+                    <rfilter type="gaussian"/>
+                </film>
+                <sampler type="independent">
+                    <integer name="sample_count" value="{spp}"/>
+                </sampler>
+            </sensor>
+            <shape type="rectangle">
+                <transform name="to_world"><scale value="4"/></transform>
+                <bsdf type="diffuse"/>
+            </shape>
+            <shape type="sphere">
+                <point name="center" x="-0.8" y="0" z="0.5"/>
+                <float name="radius" value="0.5"/>
+                <bsdf type="roughconductor"/>
+            </shape>
+            <shape type="sphere">
+                <point name="center" x="0.8" y="0" z="0.5"/>
+                <float name="radius" value="0.5"/>
+                <bsdf type="dielectric"/>
+            </shape>
+            <shape type="rectangle">
+                <transform name="to_world">
+                    <rotate x="1" angle="180"/><translate z="3"/>
+                </transform>
+                <emitter type="area"><rgb name="radiance" value="5"/></emitter>
+            </shape>
+            <emitter type="constant"><rgb name="radiance" value="0.2"/></emitter>
+        </scene>
+    """.format(res=resolution, spp=spp))
+
+
+def test01_perf_kdtree_build(variant_scalar_rgb, benchmark):
+    from mitsuba.core import Properties
+    from mitsuba.render import Scene
+
+    # ~80K triangles
+    mesh = create_stairs(20000)
+
+    def build():
+        props = Properties("scene")
+        props["_unnamed_0"] = mesh
+        Scene(props)
+
+    benchmark(build)
+
+
+def test02_perf_load(variant_scalar_rgb, benchmark):
+    from mitsuba.core.xml import load_string
+
+    # Many small objects: measures XML parsing and plugin instantiation
+    shapes = ''.join("""
+        <shape type="sphere">
+            <point name="center" x="{x}" y="{y}" z="0"/>
+            <float name="radius" value="0.1"/>
+            <bsdf type="roughplastic">
+                <texture type="checkerboard" name="diffuse_reflectance"/>
+            </bsdf>
+        </shape>""".format(x=i % 20, y=i // 20) for i in range(400))
+
+    xml = '<scene version="2.0.0">%s</scene>' % shapes
+    benchmark(lambda: load_string(xml))
+
+
+def test03_perf_render(variants_cpu_rgb, benchmark):
+    scene = make_render_scene(resolution=64, spp=16)
+    sensor = scene.sensors()[0]
+    benchmark(lambda: scene.integrator().render(scene, sensor), repeat=3)
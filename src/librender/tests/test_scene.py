@@ -102,3 +102,411 @@ def test03_shapes_parameters_grad_enabled(variant_gpu_autodiff_rgb):
     params.set_dirty(shape_param_key)
     params.update()
     assert scene.shapes_grad_enabled() == True
+
+
+@fresolver_append_path
+def test04_parameters_changed_rebuilds_accel(variant_scalar_rgb):
+    from mitsuba.core import xml, Ray3f
+    from mitsuba.python.util import traverse
+
+    scene = xml.load_dict({
+        'type' : 'scene',
+        'rect' : {
+            'type' : 'obj',
+            'filename' : 'resources/data/common/meshes/rectangle.obj'
+        }
+    })
+
+    ray = Ray3f(o=[0, 0, -8], d=[0, 0, 1], time=0.0, wavelengths=[])
+    assert ek.allclose(scene.ray_intersect(ray).t, 8)
+
+    # Move the mesh away from the origin along the ray
+    params = traverse(scene)
+    positions = params['rect.vertex_positions_buf']
+    for i in range(len(positions) // 3):
+        positions[3 * i + 2] += 2
+    params['rect.vertex_positions_buf'] = positions
+    params.update()
+
+    assert ek.allclose(scene.ray_intersect(ray).t, 10)
+    assert ek.allclose(scene.bbox().min.z, 2)
+
+
+@fresolver_append_path
+def test05_parameters_changed_instance(variant_scalar_rgb):
+    from mitsuba.core import xml, Ray3f, ScalarTransform4f as T
+    from mitsuba.python.util import traverse
+
+    scene = xml.load_dict({
+        'type' : 'scene',
+        'group_0' : {
+            'type' : 'shapegroup',
+            'rect' : {
+                'type' : 'obj',
+                'filename' : 'resources/data/common/meshes/rectangle.obj'
+            }
+        },
+        'instance' : {
+            'type' : 'instance',
+            'group' : { 'type' : 'ref', 'id' : 'group_0' }
+        }
+    })
+
+    ray = Ray3f(o=[0, 0, -8], d=[0, 0, 1], time=0.0, wavelengths=[])
+    assert ek.allclose(scene.ray_intersect(ray).t, 8)
+
+    # Instance transforms only refresh the top level of the scene
+    params = traverse(scene)
+    params['instance.to_world'] = T.translate([0, 0, 3])
+    params.update()
+    assert ek.allclose(scene.ray_intersect(ray).t, 11)
+
+    # Geometry changes within the shape group rebuild the group
+    key = [k for k in params.keys() if k.endswith('vertex_positions_buf')][0]
+    positions = params[key]
+    for i in range(len(positions) // 3):
+        positions[3 * i + 2] -= 1
+    params[key] = positions
+    params.update()
+    assert ek.allclose(scene.ray_intersect(ray).t, 10)
+
+
+def test06_render_sequence(variant_scalar_rgb):
+    from mitsuba.core import xml, ScalarTransform4f as T
+    from mitsuba.python.util import traverse, render_sequence
+    import numpy as np
+
+    def make_scene(origin):
+        return xml.load_dict({
+            'type' : 'scene',
+            'sensor' : {
+                'type' : 'perspective',
+                'to_world' : T.look_at(origin=origin, target=[0, 0, 0], up=[0, 1, 0]),
+                'film' : {
+                    'type' : 'hdrfilm',
+                    'width' : 8, 'height' : 8,
+                    'rfilter' : { 'type' : 'box' }
+                },
+                'sampler' : { 'type' : 'independent', 'sample_count' : 4 }
+            },
+            'sphere' : { 'type' : 'sphere', 'center' : [0.5, 0, 0] },
+            'emitter' : { 'type' : 'constant' },
+            'integrator' : { 'type' : 'path' }
+        })
+
+    origins = [[0, 0, 5], [3, 0, 4], [0, 3, 4]]
+    scene = make_scene(origins[0])
+    key = 'sensor.to_world'
+    assert key in traverse(scene)
+
+    frames = [{ key : T.look_at(origin=o, target=[0, 0, 0], up=[0, 1, 0]) }
+              for o in origins]
+    bitmaps = render_sequence(scene, frames)
+    assert len(bitmaps) == len(origins)
+
+    # Each frame must match a scene loaded with the frame's camera
+    for o, bitmap in zip(origins, bitmaps):
+        ref = make_scene(o)
+        ref.integrator().render(ref, ref.sensors()[0])
+        assert np.allclose(np.array(bitmap), np.array(ref.sensors()[0].film().bitmap()))
+
+
+@fresolver_append_path
+def test07_embree_scene_properties(variants_cpu_rgb):
+    from mitsuba.core import xml, Ray3f
+
+    if not mitsuba.core.MTS_ENABLE_EMBREE:
+        pytest.skip("EMBREE disabled")
+
+    def make_scene(**kwargs):
+        return xml.load_dict(dict({
+            'type' : 'scene',
+            'rect' : {
+                'type' : 'obj',
+                'filename' : 'resources/data/common/meshes/rectangle.obj'
+            }
+        }, **kwargs))
+
+    ray = Ray3f(o=[0, 0, -8], d=[0, 0, 1], time=0.0, wavelengths=[])
+    for quality in ['low', 'medium', 'high']:
+        for compact in [False, True]:
+            scene = make_scene(embree_build_quality=quality, embree_compact=compact,
+                               embree_robust=True, embree_dynamic=False)
+            assert ek.allclose(scene.ray_intersect(ray).t, 8)
+
+    with pytest.raises(RuntimeError, match='accel_refit'):
+        make_scene(embree_build_quality='refit')
+    with pytest.raises(RuntimeError, match='embree_build_quality'):
+        make_scene(embree_build_quality='best')
+
+
+@fresolver_append_path
+def test08_dedup_geometry(variant_scalar_rgb):
+    """Meshes that only differ by their placement must be replaced by instances
+    when 'dedup_geometry' is set, without affecting the intersections"""
+    from mitsuba.core import xml, Ray3f, ScalarTransform4f as T
+
+    shared_bsdf = xml.load_dict({ 'type' : 'diffuse' })
+    other_bsdf = xml.load_dict({ 'type' : 'diffuse' })
+    transforms = [T.translate([-3, 0, 0]),
+                  T.translate([3, 0, 0]) * T.rotate([0, 1, 0], 30) * T.scale([2, 1, 1]),
+                  T.translate([0, 3, 0]) * T.scale([0.5, 0.5, 0.5]),
+                  T.translate([0, -3, 0])]
+
+    def make_scene(dedup):
+        scene = { 'type' : 'scene', 'dedup_geometry' : dedup }
+        for i, to_world in enumerate(transforms):
+            scene['box_%i' % i] = {
+                'type' : 'ply',
+                'filename' : 'resources/data/tests/ply/cbox_smallbox.ply',
+                'to_world' : to_world,
+                'bsdf' : other_bsdf if i == 3 else shared_bsdf
+            }
+        return xml.load_dict(scene)
+
+    scene, reference = make_scene(True), make_scene(False)
+
+    names = sorted(s.class_().name() for s in scene.shapes())
+    assert names == ['Instance', 'Instance', 'Instance', 'PLYMesh']
+    assert all(s.class_().name() == 'PLYMesh' for s in reference.shapes())
+
+    for o in [[-3, 0, -10], [3, 0.1, -10], [0, 3.05, -10], [0, -3, -10], [1.5, 1.5, -10]]:
+        ray = Ray3f(o=o, d=[0, 0, 1], time=0.0, wavelengths=[])
+        si, si_ref = scene.ray_intersect(ray), reference.ray_intersect(ray)
+        assert si.is_valid() == si_ref.is_valid()
+        if si_ref.is_valid():
+            assert ek.allclose(si.t, si_ref.t, atol=1e-4)
+            assert ek.allclose(si.n, si_ref.n, atol=1e-4)
+
+
+@fresolver_append_path
+def test09_light_bvh(variant_scalar_rgb):
+    """Emitters sampled with 'emitter_sampler=bvh' must report the same
+    density through pdf_emitter_direction(), and emitters that face away from
+    the reference point must never be chosen"""
+    from mitsuba.core import xml, ScalarTransform4f as T
+    from mitsuba.render import SurfaceInteraction3f
+
+    def make_scene(sampler):
+        scene = { 'type' : 'scene', 'emitter_sampler' : sampler }
+        for i in range(16):
+            scene['light_%i' % i] = {
+                'type' : 'rectangle',
+                # The first half of the lights faces -y, the others face +y
+                'to_world' : T.translate([(i % 4) * 2.0, 0, (i // 4) * 2.0 + 1]) *
+                             T.rotate([1, 0, 0], 90 if i < 8 else -90) *
+                             T.scale([0.5, 0.5, 0.5]),
+                'emitter' : { 'type' : 'area', 'radiance' : { 'type' : 'rgb', 'value' : i + 1.0 } }
+            }
+        scene['point'] = { 'type' : 'point', 'position' : [3, -5, 3] }
+        scene['env'] = { 'type' : 'constant' }
+        return xml.load_dict(scene)
+
+    scene = make_scene('bvh')
+    assert len(scene.emitters()) == 18
+
+    import numpy as np
+    rng = np.random.RandomState(1234)
+    for ref_y in [-3.0, 3.0]:
+        it = SurfaceInteraction3f()
+        it.p = [1.0, ref_y, 2.0]
+        it.time = 0.0
+        for k in range(200):
+            ds, spec = scene.sample_emitter_direction(it, rng.uniform(size=2), False)
+            if ds.pdf == 0:
+                continue
+            assert ek.allclose(scene.pdf_emitter_direction(it, ds), ds.pdf, rtol=1e-4)
+            # Rectangles only emit on the side of their normal
+            if ds.d[1] != 0 and ds.dist < 100:
+                assert ek.dot(ds.n, ds.d) < 0 or ds.n[1] == 0
+
+    with pytest.raises(RuntimeError, match='emitter sampler'):
+        make_scene('random')
+
+
+def test10_power_emitter_sampler(variant_scalar_rgb):
+    """Emitters sampled with 'emitter_sampler=power' must be chosen
+    proportionally to their power"""
+    from mitsuba.core import xml
+    from mitsuba.render import SurfaceInteraction3f
+
+    scene = xml.load_dict({
+        'type' : 'scene',
+        'emitter_sampler' : 'power',
+        'dim' : { 'type' : 'point', 'position' : [0, 0, 2], 'intensity' : 1.0 },
+        'bright' : { 'type' : 'point', 'position' : [0, 0, -2], 'intensity' : 3.0 }
+    })
+
+    it = SurfaceInteraction3f()
+    it.p = [0, 0, 0]
+    it.time = 0.0
+
+    ds, _ = scene.sample_emitter_direction(it, [0.1, 0.5], False)
+    assert ek.allclose(ds.p, [0, 0, 2])
+    assert ek.allclose(ds.pdf, 0.25)
+
+    ds, _ = scene.sample_emitter_direction(it, [0.9, 0.5], False)
+    assert ek.allclose(ds.p, [0, 0, -2])
+    assert ek.allclose(ds.pdf, 0.75)
+
+
+@fresolver_append_path
+def test11_parameters_changed_dependencies(variant_scalar_rgb):
+    """Only changes of the geometry should update the acceleration data
+    structure, and only changes of the emitters their distributions"""
+    from mitsuba.core import xml
+    from mitsuba.render import SurfaceInteraction3f
+    from mitsuba.python.util import traverse
+
+    scene = xml.load_dict({
+        'type' : 'scene',
+        'emitter_sampler' : 'power',
+        'rect' : {
+            'type' : 'obj',
+            'filename' : 'resources/data/common/meshes/rectangle.obj',
+            'bsdf' : { 'type' : 'diffuse' }
+        },
+        'dim' : { 'type' : 'point', 'position' : [0, 0, 2], 'intensity' : 1.0 },
+        'bright' : { 'type' : 'point', 'position' : [0, 0, -2], 'intensity' : 3.0 }
+    })
+    rect = scene.shapes()[0]
+
+    rect.parameters_changed(['bsdf'])
+    assert not rect.geometry_dirty() and not rect.emitter_dirty()
+    rect.parameters_changed(['vertex_positions_buf'])
+    assert rect.geometry_dirty()
+    scene.parameters_changed(['rect'])
+    assert not rect.geometry_dirty()
+
+    # Material changes are propagated without affecting the shape
+    params = traverse(scene)
+    params['rect.bsdf.reflectance.value'] = [0.2, 0.4, 0.6]
+    params.update()
+    assert not rect.geometry_dirty()
+
+    # Emitter changes rebuild the emitter sampling distribution
+    params['dim.intensity.value'] = [3.0, 3.0, 3.0]
+    params.update()
+
+    it = SurfaceInteraction3f()
+    it.p = [0, 0, 0]
+    it.time = 0.0
+
+    ds, _ = scene.sample_emitter_direction(it, [0.1, 0.5], False)
+    assert ek.allclose(ds.p, [0, 0, 2])
+    assert ek.allclose(ds.pdf, 0.5)
+
+
+def test12_polarizing_bsdfs(variant_scalar_mono_polarized):
+    """Scenes without polarizing BSDFs are detected, in which case the path
+    tracer only tracks the first entry of the Mueller matrices"""
+    from mitsuba.core import xml, Transform4f
+    from mitsuba.render import BSDFFlags, has_flag
+
+    def make_scene(bsdf):
+        return xml.load_dict({
+            'type' : 'scene',
+            'integrator' : { 'type' : 'path' },
+            'sensor' : {
+                'type' : 'perspective',
+                'to_world' : Transform4f.look_at(
+                    origin=[0, 0, 3], target=[0, 0, 0], up=[0, 1, 0]),
+                'film' : { 'type' : 'hdrfilm', 'width' : 8, 'height' : 8 },
+                'sampler' : { 'type' : 'independent', 'sample_count' : 4 }
+            },
+            'rect' : { 'type' : 'rectangle', 'bsdf' : bsdf },
+            'light' : { 'type' : 'constant' }
+        })
+
+    diffuse = make_scene({ 'type' : 'diffuse' })
+    assert not diffuse.has_polarizing_bsdfs()
+    assert diffuse.integrator().render(diffuse, diffuse.sensors()[0])
+
+    conductor = make_scene({ 'type' : 'conductor' })
+    assert conductor.has_polarizing_bsdfs()
+    assert has_flag(conductor.shapes()[0].bsdf().flags(), BSDFFlags.Polarizing)
+
+    # Wrapped BSDFs propagate the flags of the nested ones
+    twosided = make_scene({ 'type' : 'twosided', 'nested' : { 'type' : 'conductor' } })
+    assert twosided.has_polarizing_bsdfs()
+
+
+def test13_ray_intersect_and_test(variants_vec_rgb):
+    """The coalesced intersection and shadow ray test matches separate calls,
+    also when the two rays have a different number of lanes"""
+    from mitsuba.core import xml, Ray3f, Vector3f, Float
+
+    scene = xml.load_dict({
+        'type' : 'scene',
+        'rect' : { 'type' : 'rectangle' },
+        'sphere' : { 'type' : 'sphere', 'center' : [0, 0, -3], 'radius' : 0.5 }
+    })
+
+    x = ek.linspace(Float, -1.5, 1.5, 7)
+    ray = Ray3f(Vector3f(x, 0.1, 2), Vector3f(0, 0, -1), 0, [])
+    shadow_ray = Ray3f(Vector3f(0.25, 0.1, 2), Vector3f(0, 0, -1), 0, [])
+    shadow_ray.maxt = 1.5
+
+    si, occluded = scene.ray_intersect_and_test(ray, shadow_ray)
+    si_ref = scene.ray_intersect(ray)
+
+    assert ek.all(ek.eq(si.is_valid(), si_ref.is_valid()))
+    assert ek.allclose(ek.select(si.is_valid(), si.t, 0), ek.select(si_ref.is_valid(), si_ref.t, 0))
+    assert ek.all(ek.eq(occluded, scene.ray_test(shadow_ray)))
+    assert ek.all(~occluded)
+
+    shadow_ray.maxt = 3
+    _, occluded = scene.ray_intersect_and_test(ray, shadow_ray, shadow_active=False)
+    assert ek.all(~occluded)
+    _, occluded = scene.ray_intersect_and_test(ray, shadow_ray)
+    assert ek.all(occluded)
+
+
+@pytest.mark.parametrize("sampler", ['bvh', 'power'])
+def test14_emitter_update(variant_scalar_rgb, sampler):
+    """Changing the radiance of emitters only updates their entries of the
+    emitter sampling structures, which then match a newly built scene"""
+    from mitsuba.core import xml, ScalarTransform4f as T
+    from mitsuba.render import SurfaceInteraction3f
+    from mitsuba.python.util import traverse
+
+    def make_scene(radiance):
+        scene = { 'type' : 'scene', 'emitter_sampler' : sampler }
+        for i, value in enumerate(radiance):
+            scene['light_%i' % i] = {
+                'type' : 'rectangle',
+                'to_world' : T.translate([(i % 4) * 2.0, 0, (i // 4) * 2.0 + 1]) *
+                             T.rotate([1, 0, 0], 90) * T.scale([0.5, 0.5, 0.5]),
+                'emitter' : { 'type' : 'area', 'radiance' : { 'type' : 'rgb', 'value' : value } }
+            }
+        return xml.load_dict(scene)
+
+    radiance = [i + 1.0 for i in range(8)]
+    scene = make_scene(radiance)
+    params = traverse(scene)
+
+    it = SurfaceInteraction3f()
+    it.p = [1.0, -3.0, 2.0]
+    it.time = 0.0
+
+    def check(radiance):
+        reference = make_scene(radiance)
+        for k in range(16):
+            sample = [(k + 0.5) / 16, 0.3]
+            ds, _ = scene.sample_emitter_direction(it, sample, False)
+            ds_ref, _ = reference.sample_emitter_direction(it, sample, False)
+            assert ek.allclose(ds.p, ds_ref.p)
+            assert ek.allclose(ds.pdf, ds_ref.pdf, rtol=1e-4)
+
+    radiance[2] = 20.0
+    radiance[5] = 0.5
+    params['light_2.emitter.radiance.value'] = [20.0] * 3
+    params['light_5.emitter.radiance.value'] = [0.5] * 3
+    params.update()
+    check(radiance)
+
+    # Emitters without power are never sampled
+    radiance[3] = 0.0
+    params['light_3.emitter.radiance.value'] = [0.0] * 3
+    params.update()
+    check(radiance)
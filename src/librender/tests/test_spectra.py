@@ -146,3 +146,19 @@ def test06_rgb2spec_fetch_eval_mean(variant_scalar_spectral):
         assert not ek.any(ek.isnan(coeff)), "{} => coeff = {}".format(rgb, coeff)
         assert not ek.any(ek.isnan(mean)),  "{} => mean = {}".format(rgb, mean)
         assert not ek.any(ek.isnan(value)), "{} => value = {}".format(rgb, value)
+
+
+def test07_sample_rgb_spectrum_xyz(variant_scalar_spectral):
+    """The fused sampling routine should match sampling followed by a lookup
+    of the CIE 1931 color matching functions"""
+
+    from mitsuba.core import sample_rgb_spectrum, sample_rgb_spectrum_xyz, cie1931_xyz
+
+    for sample in [0.0, 0.1, 0.25, 0.5, 0.8, 0.99]:
+        wav, weight = sample_rgb_spectrum(sample)
+        wav_xyz, xyz = sample_rgb_spectrum_xyz(sample)
+        assert ek.allclose(wav_xyz, wav)
+        assert ek.allclose(xyz, cie1931_xyz(wav) * weight)
+
+    # Unlike the other nodes, the last one has no successor in the table
+    assert ek.allclose(cie1931_xyz(830), cie1931_xyz(829.9999), atol=1e-4)
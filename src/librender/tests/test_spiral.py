@@ -82,3 +82,43 @@ def test03_normal_film(variant_scalar_rgb):
     # Resetting and re-querying the blocks should yield the exact same results.
     s.reset()
     check_first_blocks(extract_blocks(s), expected, n_total=110)
+
+
+def test04_random_access(variant_scalar_rgb):
+    from mitsuba.render import Spiral
+
+    # Random access should reproduce the sequence generated by next_block()
+    f = make_film(318, 322)
+    s = Spiral(f.size(), f.crop_offset(), passes=3)
+    blocks = extract_blocks(s, max_blocks=400)
+    assert len(blocks) == 3 * s.block_count()
+
+    for i, b in enumerate(blocks):
+        (bo, bs, bi) = s.block(i)
+        assert ek.all(bo == b[0])
+        assert ek.all(bs == b[1])
+        assert bi == b[2]
+
+    # Past the end of the traversal
+    assert ek.all(s.block(len(blocks))[1] == 0)
+
+
+def test05_scanline(variant_scalar_rgb):
+    from mitsuba.render import Spiral
+
+    # Blocks are generated row by row, and identified as in the spiral order
+    f = make_film(70, 40)
+    s = Spiral(f.size(), [2, 3], passes=2, scanline=True)
+    assert s.scanline()
+    blocks = extract_blocks(s)
+    assert len(blocks) == 2 * s.block_count() == 12
+
+    expected = [[[2, 3], [32, 32]], [[34, 3], [32, 32]], [[66, 3], [6, 32]],
+                [[2, 35], [32, 8]], [[34, 35], [32, 8]], [[66, 35], [6, 8]]]
+    check_first_blocks(blocks[:6], expected)
+    check_first_blocks(blocks[6:], expected)
+    assert [b[2] for b in blocks] == list(range(6, 12)) + list(range(6))
+
+    for i, b in enumerate(blocks):
+        (bo, bs, bi) = s.block(i)
+        assert ek.all(bo == b[0]) and ek.all(bs == b[1]) and bi == b[2]
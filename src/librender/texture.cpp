@@ -114,6 +114,26 @@ Volume<Float, Spectrum>::eval_gradient(const Interaction3f & /*it*/, Mask /*acti
 MTS_VARIANT typename Volume<Float, Spectrum>::ScalarFloat
 Volume<Float, Spectrum>::max() const { NotImplementedError("max"); }
 
+MTS_VARIANT std::vector<typename Volume<Float, Spectrum>::ScalarFloat>
+Volume<Float, Spectrum>::max_per_cell(const ScalarVector3i &cells) const {
+    return std::vector<ScalarFloat>((size_t) hprod(cells), max());
+}
+
+MTS_VARIANT std::vector<typename Volume<Float, Spectrum>::ScalarFloat>
+Volume<Float, Spectrum>::min_per_cell(const ScalarVector3i &cells) const {
+    return std::vector<ScalarFloat>((size_t) hprod(cells), 0.f);
+}
+
+MTS_VARIANT std::vector<typename Volume<Float, Spectrum>::ScalarFloat>
+Volume<Float, Spectrum>::max_per_cell_and_band(const ScalarVector3i &cells,
+                                               uint32_t bands) const {
+    std::vector<ScalarFloat> values = max_per_cell(cells), result;
+    result.reserve(values.size() * bands);
+    for (ScalarFloat value : values)
+        result.insert(result.end(), bands, value);
+    return result;
+}
+
 MTS_VARIANT typename Volume<Float, Spectrum>::ScalarVector3i
 Volume<Float, Spectrum>::resolution() const {
     return ScalarVector3i(1, 1, 1);
@@ -11,7 +11,9 @@ MTS_PY_EXPORT(Texture) {
                 D(GPUTexture, GPUTexture),"bitmap"_a,
                 "min_interpolation_mode"_a = nanogui::Texture::InterpolationMode::Bilinear,
                 "mag_interpolation_mode"_a = nanogui::Texture::InterpolationMode::Bilinear,
-                "wrap_mode"_a              = nanogui::Texture::WrapMode::ClampToEdge);
+                "wrap_mode"_a              = nanogui::Texture::WrapMode::ClampToEdge)
+            .def("upload_region", &mitsuba::GPUTexture::upload_region, "bitmap"_a, "offset"_a,
+                D(GPUTexture, upload_region));
     }
 }
 
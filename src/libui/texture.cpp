@@ -65,6 +65,19 @@ GPUTexture::GPUTexture(const Bitmap *bitmap, InterpolationMode min_interpolation
     upload((const uint8_t *) source->data());
 }
 
+void GPUTexture::upload_region(const Bitmap *bitmap, const Vector<int, 2> &offset) {
+    ref<const Bitmap> source = bitmap;
+    if (convert_pixel_format(bitmap->pixel_format()) != m_pixel_format ||
+        convert_component_format(bitmap->component_format()) != m_component_format) {
+        source = bitmap->convert(convert_pixel_format(m_pixel_format),
+                                 convert_component_format(m_component_format),
+                                 bitmap->srgb_gamma());
+    }
+    upload_sub_region((const uint8_t *) source->data(),
+                      nanogui::Vector2i(offset.x(), offset.y()),
+                      nanogui::Vector2i((int) source->width(), (int) source->height()));
+}
+
 GPUTexture::~GPUTexture() { }
 
 NAMESPACE_END(mitsuba)
@@ -12,12 +12,66 @@
 
 NAMESPACE_BEGIN(mitsuba)
 
+/**!
+
+.. _medium-heterogeneous:
+
+Heterogeneous medium (:monosp:`heterogeneous`)
+-----------------------------------------------
+
+.. pluginparameters::
+
+ * - albedo
+   - |float|, |spectrum| or |texture|
+   - Single-scattering albedo of the medium (Default: 0.75).
+
+ * - sigma_t
+   - |float|, |spectrum| or |texture|
+   - Extinction coefficient in inverse scene units (Default: 1).
+
+ * - scale
+   - |float|
+   - Optional scale factor that will be applied to the extinction parameter.
+     (Default: 1)
+
+ * - majorant_resolution
+   - |int|
+   - Resolution of a coarse grid of local majorants along each axis (limited
+     to the resolution of ``sigma_t``). Zero disables the grid, in which case
+     the maximum of ``sigma_t`` is used everywhere. (Default: 0)
+
+ * - majorant_bands
+   - |int|
+   - Number of wavelength bands with separate majorants in spectral variants.
+     RGB variants always use one majorant per color channel. (Default: 8)
+
+Free-flight distances are sampled with delta tracking. When a majorant grid
+is enabled, the sampling marches through its cells with a 3D digital
+differential analyzer (DDA) and uses the maximum extinction within each cell
+as the majorant, which avoids most of the null collisions in media with
+dense cores and thin fringes. Cells without any extinction are skipped
+entirely. The grid also stores the minimum extinction within each cell,
+which serves as the control extinction of residual ratio tracking when an
+integrator requests it for the transmittance of shadow rays.
+
+Unless ``has_spectral_extinction`` is disabled, the majorants vary within
+the spectrum: each color channel has its own majorant in RGB variants, and
+the wavelength range is split into ``majorant_bands`` bands in spectral
+variants. Free-flight distances are sampled with the majorant of the hero
+wavelength (or of the sampled channel), while the integrator weights the
+other wavelengths by their own majorants, which avoids most of the null
+collisions of wavelengths with a small extinction.
+
+ */
+
 template <typename Float, typename Spectrum>
 class HeterogeneousMedium final : public Medium<Float, Spectrum> {
 public:
     MTS_IMPORT_BASE(Medium, m_is_homogeneous, m_has_spectral_extinction)
     MTS_IMPORT_TYPES(Scene, Sampler, Texture, Volume)
 
+    using Mask3f = mask_t<Vector3f>;
+
     HeterogeneousMedium(const Properties &props) : Base(props) {
         m_is_homogeneous = false;
         m_albedo = props.volume<Volume>("albedo", 0.75f);
@@ -26,16 +80,189 @@ public:
         m_scale = props.float_("scale", 1.0f);
         m_has_spectral_extinction = props.bool_("has_spectral_extinction", true);
 
-        m_max_density = m_scale * m_sigmat->max();
-        m_aabb        = m_sigmat->bbox();
+        m_majorant_resolution = ScalarVector3i(props.int_("majorant_resolution", 0));
+        if (any(m_majorant_resolution < 0))
+            Throw("The majorant resolution must not be negative!");
+
+        // Spectral bands of the majorants (see Volume::max_per_cell_and_band())
+        int bands = props.int_("majorant_bands", 8);
+        if (bands < 1)
+            Throw("The number of majorant bands must be positive!");
+        if (!m_has_spectral_extinction)
+            m_band_count = 1;
+        else if constexpr (is_rgb_v<Spectrum>)
+            m_band_count = 3;
+        else if constexpr (is_spectral_v<Spectrum>)
+            m_band_count = (uint32_t) bands;
+        else
+            m_band_count = 1;
+        m_band_scale = m_band_count / (MTS_WAVELENGTH_MAX - MTS_WAVELENGTH_MIN);
+
+        m_aabb = m_sigmat->bbox();
+        update_majorants();
     }
 
     UnpolarizedSpectrum
-    get_combined_extinction(const MediumInteraction3f & /* mi */,
+    get_combined_extinction(const MediumInteraction3f &mi,
                             Mask active) const override {
-        // TODO: This could be a spectral quantity (at least in RGB mode)
         MTS_MASKED_FUNCTION(ProfilerPhase::MediumEvaluate, active);
-        return m_max_density;
+        if (!m_has_majorant_grid)
+            return gather_bands(m_max_density, 0u, mi.wavelengths, active);
+
+        // Look up the cell of the majorant grid that contains the interaction
+        ScalarVector3f res(m_majorant_resolution);
+        Point3f p = m_sigmat->world_to_local().transform_affine(mi.p) * res;
+        Vector3f cell = clamp(floor(p), 0.f, res - 1.f);
+        return majorant(cell, mi.wavelengths, active);
+    }
+
+    MediumInteraction3f sample_interaction(const Ray3f &ray, Float sample,
+                                           UInt32 channel, Mask active) const override {
+        if (!m_has_majorant_grid)
+            return Base::sample_interaction(ray, sample, channel, active);
+
+        MTS_MASKED_FUNCTION(ProfilerPhase::MediumSample, active);
+
+        MediumInteraction3f mi;
+        mi.sh_frame    = Frame3f(ray.d);
+        mi.wi          = -ray.d;
+        mi.time        = ray.time;
+        mi.wavelengths = ray.wavelengths;
+        mi.medium      = this;
+
+        ScalarVector3f res(m_majorant_resolution);
+        auto [running, mint, maxt, cell, step, t_delta, t_next] = dda_init(ray, active);
+        masked(mint, !running) = 0.f;
+
+        // Optical depth of the majorant of the sampled channel that must be traversed
+        Float tau = -enoki::log(1.f - sample),
+              t = mint,
+              sampled_t = math::Infinity<Float>;
+        UnpolarizedSpectrum local_majorant(0.f);
+        Mask valid_mi = false;
+
+        while (any(running)) {
+            UnpolarizedSpectrum m_cell = majorant(cell, ray.wavelengths, running);
+            Float t_exit = min(hmin(t_next), maxt),
+                  m = channel_value(m_cell, channel),
+                  depth = m * (t_exit - t);
+
+            // Has the free-flight distance been reached within this cell?
+            Mask found = running && m > 0.f && depth >= tau;
+            masked(sampled_t, found) = t + tau / m;
+            masked(local_majorant, found) = m_cell;
+            valid_mi |= found;
+            running &= !found;
+
+            // Otherwise, advance to the next cell along the axes that are crossed first
+            masked(tau, running) -= depth;
+            masked(t, running) = t_exit;
+            Mask3f advance = eq(t_next, t_exit) && running;
+            masked(cell, advance) += step;
+            masked(t_next, advance) += t_delta;
+            running &= t < maxt && all(cell >= 0.f && cell < res);
+        }
+
+        mi.t    = select(valid_mi, sampled_t, math::Infinity<Float>);
+        mi.p    = ray(select(valid_mi, sampled_t, mint));
+        mi.mint = mint;
+        mi.combined_extinction = local_majorant;
+
+        // Use the majorant of the cell directly, which is consistent with the sampled distance
+        mi.sigma_t = m_scale * m_sigmat->eval(mi, valid_mi);
+        mi.sigma_s = mi.sigma_t * m_albedo->eval(mi, valid_mi);
+        mi.sigma_n = mi.combined_extinction - mi.sigma_t;
+        return mi;
+    }
+
+    std::pair<UnpolarizedSpectrum, UnpolarizedSpectrum>
+    eval_tr_and_pdf(const Ray3f &ray, const MediumInteraction3f &mi,
+                    const SurfaceInteraction3f &si, Mask active) const override {
+        // A gray majorant cancels out, so that its variation along the ray does not matter
+        if (!m_has_majorant_grid || m_band_count == 1)
+            return Base::eval_tr_and_pdf(ray, mi, si, active);
+
+        MTS_MASKED_FUNCTION(ProfilerPhase::MediumEvaluate, active);
+
+        // Integrate the majorant of each wavelength up to the collision or the surface
+        Ray3f segment(ray);
+        segment.maxt = min(ray.maxt, min(mi.t, si.t));
+
+        ScalarVector3f res(m_majorant_resolution);
+        auto [running, mint, maxt, cell, step, t_delta, t_next] = dda_init(segment, active);
+        UnpolarizedSpectrum depth(0.f);
+        Float t = mint;
+
+        while (any(running)) {
+            Float t_exit = min(hmin(t_next), maxt);
+            masked(depth, running) += majorant(cell, ray.wavelengths, running) * (t_exit - t);
+            masked(t, running) = t_exit;
+            Mask3f advance = eq(t_next, t_exit) && running;
+            masked(cell, advance) += step;
+            masked(t_next, advance) += t_delta;
+            running &= t < maxt && all(cell >= 0.f && cell < res);
+        }
+
+        UnpolarizedSpectrum tr  = exp(-depth),
+                            pdf = select(si.t < mi.t, tr, tr * mi.combined_extinction);
+        return { tr, pdf };
+    }
+
+    UnpolarizedSpectrum eval_transmittance(const Ray3f &ray, Sampler *sampler,
+                                           UInt32 channel, bool residual,
+                                           Mask active) const override {
+        if (!m_has_majorant_grid || (!residual && m_band_count == 1))
+            return Base::eval_transmittance(ray, sampler, channel, residual, active);
+
+        MTS_MASKED_FUNCTION(ProfilerPhase::MediumEvaluate, active);
+
+        MediumInteraction3f mi;
+        mi.time        = ray.time;
+        mi.wavelengths = ray.wavelengths;
+
+        /* Residual ratio tracking: the minimum extinction of each cell serves
+           as a control whose transmittance is computed analytically, and only
+           the remaining extinction is tracked with the residual majorant. The
+           tracking majorant is the largest one of the wavelengths, and plain
+           ratio tracking uses no control. */
+        ScalarVector3f res(m_majorant_resolution);
+        auto [running, mint, maxt, cell, step, t_delta, t_next] = dda_init(ray, active);
+        UnpolarizedSpectrum transmittance(1.f);
+        Float tau = -enoki::log(1.f - sampler->next_1d(running)),
+              t = mint,
+              control_depth = 0.f;
+
+        while (any(running)) {
+            Float t_exit = min(hmin(t_next), maxt),
+                  control = residual ? minorant(cell, running) : Float(0.f),
+                  m = hmax(majorant(cell, ray.wavelengths, running)) - control,
+                  depth = m * (t_exit - t);
+
+            // Weight tentative collisions of the residual by the null collision probability
+            Mask collided = running && m > 0.f && depth >= tau;
+            if (any_or<true>(collided)) {
+                Float t_collision = t + tau / m;
+                mi.p = ray(t_collision);
+                UnpolarizedSpectrum sigma_r = m_scale * m_sigmat->eval(mi, collided) - control;
+                masked(transmittance, collided) *= 1.f - sigma_r / m;
+                masked(control_depth, collided) += control * (t_collision - t);
+                masked(t, collided) = t_collision;
+                masked(tau, collided) = -enoki::log(1.f - sampler->next_1d(collided));
+            }
+
+            // Otherwise, advance to the next cell along the axes that are crossed first
+            Mask advancing = running && !collided;
+            masked(tau, advancing) -= depth;
+            masked(control_depth, advancing) += control * (t_exit - t);
+            masked(t, advancing) = t_exit;
+            Mask3f advance = eq(t_next, t_exit) && advancing;
+            masked(cell, advance) += step;
+            masked(t_next, advance) += t_delta;
+            running &= t < maxt && all(cell >= 0.f && cell < res) &&
+                       any(neq(transmittance, 0.f));
+        }
+
+        return transmittance * exp(-control_depth);
     }
 
     std::tuple<UnpolarizedSpectrum, UnpolarizedSpectrum, UnpolarizedSpectrum>
@@ -60,23 +287,163 @@ public:
         Base::traverse(callback);
     }
 
+    void parameters_changed(const std::vector<std::string> &/*keys*/ = {}) override {
+        update_majorants();
+    }
+
     std::string to_string() const override {
         std::ostringstream oss;
         oss << "HeterogeneousMedium[" << std::endl
             << "  albedo  = " << string::indent(m_albedo) << std::endl
             << "  sigma_t = " << string::indent(m_sigmat) << std::endl
-            << "  scale   = " << string::indent(m_scale) << std::endl
+            << "  scale   = " << string::indent(m_scale) << "," << std::endl
+            << "  majorant_resolution = " << m_majorant_resolution << "," << std::endl
+            << "  majorant_bands = " << m_band_count << std::endl
             << "]";
         return oss.str();
     }
 
     MTS_DECLARE_CLASS()
+private:
+    /// Recompute the global majorant and the majorant and minorant grids (if enabled)
+    void update_majorants() {
+        std::vector<ScalarFloat> max_density =
+            m_band_count == 1
+                ? std::vector<ScalarFloat>{ m_sigmat->max() }
+                : m_sigmat->max_per_cell_and_band(ScalarVector3i(1), m_band_count);
+        for (ScalarFloat &value : max_density)
+            value *= m_scale;
+        m_max_density = DynamicBuffer<Float>::copy(max_density.data(), max_density.size());
+
+        m_has_majorant_grid = all(m_majorant_resolution > 0);
+        if (!m_has_majorant_grid)
+            return;
+
+        m_majorant_resolution = min(m_majorant_resolution, m_sigmat->resolution());
+        std::vector<ScalarFloat> majorants =
+            m_band_count == 1
+                ? m_sigmat->max_per_cell(m_majorant_resolution)
+                : m_sigmat->max_per_cell_and_band(m_majorant_resolution, m_band_count);
+        for (ScalarFloat &value : majorants)
+            value *= m_scale;
+        m_majorant_grid = DynamicBuffer<Float>::copy(majorants.data(), majorants.size());
+
+        std::vector<ScalarFloat> minorants = m_sigmat->min_per_cell(m_majorant_resolution);
+        for (ScalarFloat &value : minorants)
+            value *= m_scale;
+        m_minorant_grid = DynamicBuffer<Float>::copy(minorants.data(), minorants.size());
+    }
+
+    /**
+     * \brief Prepare the traversal of the majorant grid along a ray by a 3D
+     * digital differential analyzer
+     *
+     * Returns the lanes that overlap the grid, the overlapping segment of the
+     * ray, the first cell, the step and the ray distance between cell
+     * boundaries along each axis, and the distances to the next boundaries.
+     */
+    std::tuple<Mask, Float, Float, Vector3f, Vector3f, Vector3f, Vector3f>
+    dda_init(const Ray3f &ray, Mask active) const {
+        /* Transform the ray into the coordinates of the majorant grid, whose
+           cells have unit size. Its direction is not normalized, so that the
+           ray parameter still measures distances along the original ray. */
+        const ScalarTransform4f &to_local = m_sigmat->world_to_local();
+        ScalarVector3f res(m_majorant_resolution);
+        Ray3f local_ray(to_local.transform_affine(ray.o) * res,
+                        to_local.transform_affine(ray.d) * res,
+                        ray.time, ray.wavelengths);
+
+        auto [aabb_its, mint, maxt] =
+            ScalarBoundingBox3f(ScalarPoint3f(0.f), ScalarPoint3f(res)).ray_intersect(local_ray);
+        active &= aabb_its;
+        mint = max(ray.mint, mint);
+        maxt = min(ray.maxt, maxt);
+        active &= mint < maxt;
+
+        const Vector3f &o = local_ray.o, &d = local_ray.d;
+        Mask3f positive = d >= 0.f;
+        Vector3f step = select(positive, Vector3f(1.f), Vector3f(-1.f)),
+                 cell = clamp(floor(fmadd(d, mint, o)), 0.f, res - 1.f),
+                 t_delta = abs(local_ray.d_rcp),
+                 t_next = select(neq(d, 0.f),
+                                 (cell + select(positive, Vector3f(1.f), Vector3f(0.f)) - o) *
+                                     local_ray.d_rcp,
+                                 Vector3f(math::Infinity<Float>));
+        return { active, mint, maxt, cell, step, t_delta, t_next };
+    }
+
+    /// Index of the cell with (integer-valued) coordinates \c cell in the majorant grid
+    MTS_INLINE UInt32 cell_index(const Vector3f &cell) const {
+        return UInt32(fmadd(fmadd(cell.z(), (ScalarFloat) m_majorant_resolution.y(),
+                                  cell.y()), (ScalarFloat) m_majorant_resolution.x(),
+                            cell.x()));
+    }
+
+    /**
+     * \brief Fetch the majorants of entry \c index of \c buffer, which stores
+     * \ref m_band_count bands per entry, at the bands of the given wavelengths
+     */
+    MTS_INLINE UnpolarizedSpectrum gather_bands(const DynamicBuffer<Float> &buffer,
+                                                const UInt32 &index,
+                                                const Wavelength &wavelengths,
+                                                Mask active) const {
+        if (m_band_count == 1) {
+            ENOKI_MARK_USED(wavelengths);
+            return UnpolarizedSpectrum(gather<Float>(buffer, index, active));
+        }
+
+        UInt32 offset = index * m_band_count;
+        UnpolarizedSpectrum result;
+        for (size_t i = 0; i < array_size_v<UnpolarizedSpectrum>; ++i) {
+            UInt32 band;
+            if constexpr (is_spectral_v<Spectrum>)
+                band = UInt32(clamp((wavelengths[i] - MTS_WAVELENGTH_MIN) * m_band_scale,
+                                    0.f, m_band_count - 1.f));
+            else
+                band = (uint32_t) i;
+            result[i] = gather<Float>(buffer, offset + band, active);
+        }
+        return result;
+    }
+
+    /// Component of \c spec that drives the free-flight sampling of \c channel
+    MTS_INLINE Float channel_value(const UnpolarizedSpectrum &spec, const UInt32 &channel) const {
+        Float value = spec[0];
+        if constexpr (is_rgb_v<Spectrum>) { // Handle RGB rendering
+            masked(value, eq(channel, 1u)) = spec[1];
+            masked(value, eq(channel, 2u)) = spec[2];
+        } else {
+            ENOKI_MARK_USED(channel);
+        }
+        return value;
+    }
+
+    /// Fetch the majorants of the cell with (integer-valued) coordinates \c cell
+    MTS_INLINE UnpolarizedSpectrum majorant(const Vector3f &cell, const Wavelength &wavelengths,
+                                            Mask active) const {
+        return gather_bands(m_majorant_grid, cell_index(cell), wavelengths, active);
+    }
+
+    /// Fetch the minimum extinction of the cell with (integer-valued) coordinates \c cell
+    MTS_INLINE Float minorant(const Vector3f &cell, Mask active) const {
+        return gather<Float>(m_minorant_grid, cell_index(cell), active);
+    }
+
 private:
     ref<Volume> m_sigmat, m_albedo;
     ScalarFloat m_scale;
 
     ScalarBoundingBox3f m_aabb;
-    ScalarFloat m_max_density;
+
+    /// Spectral bands of the majorants, and their number per nanometer
+    uint32_t m_band_count;
+    ScalarFloat m_band_scale;
+
+    /// Global majorant and coarse grid of local majorants (see \ref update_majorants())
+    DynamicBuffer<Float> m_max_density;
+    ScalarVector3i m_majorant_resolution;
+    DynamicBuffer<Float> m_majorant_grid, m_minorant_grid;
+    bool m_has_majorant_grid = false;
 };
 
 MTS_IMPLEMENT_CLASS_VARIANT(HeterogeneousMedium, Medium)
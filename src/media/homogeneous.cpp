@@ -48,6 +48,21 @@ public:
         return { sigmas, sigman, sigmat };
     }
 
+    UnpolarizedSpectrum eval_transmittance(const Ray3f &ray, Sampler * /* sampler */,
+                                           UInt32 /* channel */, bool /* residual */,
+                                           Mask active) const override {
+        MTS_MASKED_FUNCTION(ProfilerPhase::MediumEvaluate, active);
+
+        // The transmittance of a homogeneous medium is known analytically
+        MediumInteraction3f mi;
+        mi.p           = ray(ray.mint);
+        mi.time        = ray.time;
+        mi.wavelengths = ray.wavelengths;
+        UnpolarizedSpectrum sigmat = eval_sigmat(mi),
+                            tau    = select(neq(sigmat, 0.f), sigmat * (ray.maxt - ray.mint), 0.f);
+        return select(active, exp(-tau), 1.f);
+    }
+
     std::tuple<Mask, Float, Float>
     intersect_aabb(const Ray3f & /* ray */) const override {
         return { true, 0.f, math::Infinity<Float> };
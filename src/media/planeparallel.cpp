@@ -0,0 +1,318 @@
+#include <enoki/stl.h>
+
+#include <mitsuba/core/frame.h>
+#include <mitsuba/core/math.h>
+#include <mitsuba/core/properties.h>
+#include <mitsuba/core/spectrum.h>
+#include <mitsuba/core/string.h>
+#include <mitsuba/core/transform.h>
+#include <mitsuba/render/interaction.h>
+#include <mitsuba/render/medium.h>
+#include <mitsuba/render/sampler.h>
+#include <mitsuba/render/scene.h>
+#include <mitsuba/render/texture.h>
+
+NAMESPACE_BEGIN(mitsuba)
+
+/**!
+
+.. _medium-planeparallel:
+
+Plane-parallel medium (:monosp:`planeparallel`)
+-----------------------------------------------
+
+.. pluginparameters::
+
+ * - albedo
+   - |float|, |spectrum| or |texture|
+   - Single-scattering albedo of the medium (Default: 0.75).
+
+ * - sigma_t
+   - |string|
+   - Comma-separated list of the extinction coefficients of the layers in
+     inverse scene units, from the bottom to the top.
+
+ * - altitudes
+   - |string|
+   - Comma-separated, increasing list of the altitudes of the layer
+     boundaries, which has one more entry than ``sigma_t``. (Default: layers
+     of equal thickness between the altitudes 0 and 1)
+
+ * - scale
+   - |float|
+   - Optional scale factor that will be applied to the extinction parameter.
+     (Default: 1)
+
+ * - to_world
+   - |transform|
+   - Transformation from the local frame of the profile, whose altitude is
+     measured along the Z axis, to world space. (Default: none)
+
+This medium models a layered atmosphere that is unbounded horizontally and
+whose extinction only varies with the altitude, as a piecewise constant
+vertical profile. Compared to an equivalent ``grid3d`` volume in a
+:ref:`heterogeneous <medium-heterogeneous>` medium, it only stores one value
+per layer.
+
+Free-flight distances are sampled exactly: the sampling marches through the
+layer boundaries crossed by the ray, which are found analytically, and
+inverts the optical depth within the layer where the sampled depth is
+reached. All sampled collisions are thus real, and the transmittance of
+shadow rays is computed analytically instead of being estimated by ratio
+tracking. The extinction is not spectrally varying.
+
+ */
+
+template <typename Float, typename Spectrum>
+class PlaneParallelMedium final : public Medium<Float, Spectrum> {
+public:
+    MTS_IMPORT_BASE(Medium, m_is_homogeneous, m_has_spectral_extinction)
+    MTS_IMPORT_TYPES(Scene, Sampler, Texture, Volume)
+
+    using Int32 = int32_array_t<Float>;
+
+    PlaneParallelMedium(const Properties &props) : Base(props) {
+        m_is_homogeneous = false;
+        m_has_spectral_extinction = false;
+        m_albedo = props.volume<Volume>("albedo", 0.75f);
+        m_scale = props.float_("scale", 1.0f);
+        m_to_local = props.transform("to_world", ScalarTransform4f()).inverse();
+
+        m_sigmat_values = parse_list(props.string("sigma_t"), "sigma_t");
+        if (m_sigmat_values.empty())
+            Throw("The extinction profile must contain at least one layer!");
+        for (ScalarFloat value : m_sigmat_values) {
+            if (!(value >= 0.f))
+                Throw("The extinction coefficients must not be negative!");
+        }
+
+        size_t layer_count = m_sigmat_values.size();
+        if (props.has_property("altitudes")) {
+            m_altitude_values = parse_list(props.string("altitudes"), "altitudes");
+            if (m_altitude_values.size() != layer_count + 1)
+                Throw("The profile has %i layers and thus requires %i altitudes (got %i)!",
+                      layer_count, layer_count + 1, m_altitude_values.size());
+            for (size_t i = 0; i < layer_count; ++i) {
+                if (!(m_altitude_values[i] < m_altitude_values[i + 1]))
+                    Throw("The altitudes must be strictly increasing!");
+            }
+        } else {
+            for (size_t i = 0; i <= layer_count; ++i)
+                m_altitude_values.push_back(ScalarFloat(i) / ScalarFloat(layer_count));
+        }
+
+        m_altitudes = DynamicBuffer<Float>::copy(m_altitude_values.data(),
+                                                 m_altitude_values.size());
+        update_profile();
+    }
+
+    UnpolarizedSpectrum
+    get_combined_extinction(const MediumInteraction3f &mi,
+                            Mask active) const override {
+        // The extinction of the layer is an exact majorant
+        MTS_MASKED_FUNCTION(ProfilerPhase::MediumEvaluate, active);
+        return eval_sigmat(layer(m_to_local.transform_affine(mi.p).z()), active);
+    }
+
+    MediumInteraction3f sample_interaction(const Ray3f &ray, Float sample,
+                                           UInt32 channel, Mask active) const override {
+        MTS_MASKED_FUNCTION(ProfilerPhase::MediumSample, active);
+        ENOKI_MARK_USED(channel);
+
+        MediumInteraction3f mi;
+        mi.sh_frame    = Frame3f(ray.d);
+        mi.wi          = -ray.d;
+        mi.time        = ray.time;
+        mi.wavelengths = ray.wavelengths;
+        mi.medium      = this;
+
+        auto [running, mint, maxt, oz, dz, index] = traversal_init(ray, active);
+        masked(mint, !running) = 0.f;
+
+        // Optical depth that must be traversed
+        Float tau = -enoki::log(1.f - sample),
+              t = mint,
+              sampled_t = math::Infinity<Float>,
+              sigmat = 0.f;
+        Mask valid_mi = false;
+
+        while (any(running)) {
+            Float t_exit = max(layer_exit(oz, dz, index, maxt, running), t),
+                  s = eval_sigmat(index, running),
+                  depth = select(s > 0.f, s * (t_exit - t), 0.f);
+
+            // Has the free-flight distance been reached within this layer?
+            Mask found = running && s > 0.f && depth >= tau;
+            masked(sampled_t, found) = t + tau / s;
+            masked(sigmat, found) = s;
+            valid_mi |= found;
+            running &= !found;
+
+            // Otherwise, advance to the next layer along the ray
+            masked(tau, running) -= depth;
+            masked(t, running) = t_exit;
+            masked(index, running) += select(dz > 0.f, Int32(1), Int32(-1));
+            running &= t < maxt && index >= 0 && index < (int32_t) m_sigmat_values.size();
+        }
+
+        mi.t    = select(valid_mi, sampled_t, math::Infinity<Float>);
+        mi.p    = ray(select(valid_mi, sampled_t, mint));
+        mi.mint = mint;
+        mi.combined_extinction = sigmat;
+        mi.sigma_t = sigmat;
+        mi.sigma_s = mi.sigma_t * m_albedo->eval(mi, valid_mi);
+        mi.sigma_n = 0.f;
+        return mi;
+    }
+
+    UnpolarizedSpectrum eval_transmittance(const Ray3f &ray, Sampler * /* sampler */,
+                                           UInt32 /* channel */, bool /* residual */,
+                                           Mask active) const override {
+        MTS_MASKED_FUNCTION(ProfilerPhase::MediumEvaluate, active);
+
+        // Accumulate the optical depth of the layers crossed by the segment
+        auto [running, mint, maxt, oz, dz, index] = traversal_init(ray, active);
+        Float t = mint, depth = 0.f;
+
+        while (any(running)) {
+            Float t_exit = max(layer_exit(oz, dz, index, maxt, running), t);
+            Float s = eval_sigmat(index, running);
+            masked(depth, running && s > 0.f) += s * (t_exit - t);
+            masked(t, running) = t_exit;
+            masked(index, running) += select(dz > 0.f, Int32(1), Int32(-1));
+            running &= t < maxt && index >= 0 && index < (int32_t) m_sigmat_values.size();
+        }
+
+        return exp(-depth);
+    }
+
+    std::tuple<UnpolarizedSpectrum, UnpolarizedSpectrum, UnpolarizedSpectrum>
+    get_scattering_coefficients(const MediumInteraction3f &mi,
+                                Mask active) const override {
+        MTS_MASKED_FUNCTION(ProfilerPhase::MediumEvaluate, active);
+        UnpolarizedSpectrum sigmat =
+            eval_sigmat(layer(m_to_local.transform_affine(mi.p).z()), active);
+        UnpolarizedSpectrum sigmas = sigmat * m_albedo->eval(mi, active);
+        UnpolarizedSpectrum sigman = 0.f;
+        return { sigmas, sigman, sigmat };
+    }
+
+    std::tuple<Mask, Float, Float>
+    intersect_aabb(const Ray3f &ray) const override {
+        // Intersect the ray with the slab between the lowest and highest altitudes
+        Float oz = m_to_local.transform_affine(ray.o).z(),
+              dz = m_to_local.transform_affine(ray.d).z();
+        ScalarFloat bottom = m_altitude_values.front(), top = m_altitude_values.back();
+
+        Float rcp_dz = rcp(dz),
+              t0 = (bottom - oz) * rcp_dz,
+              t1 = (top - oz) * rcp_dz;
+        Mask parallel = eq(dz, 0.f);
+        Float mint = select(parallel, -math::Infinity<Float>, min(t0, t1)),
+              maxt = select(parallel, math::Infinity<Float>, max(t0, t1));
+        Mask valid = !parallel || (oz >= bottom && oz <= top);
+        return { valid, mint, maxt };
+    }
+
+    void traverse(TraversalCallback *callback) override {
+        callback->put_parameter("scale", m_scale);
+        callback->put_object("albedo", m_albedo.get());
+        Base::traverse(callback);
+    }
+
+    void parameters_changed(const std::vector<std::string> &/*keys*/ = {}) override {
+        update_profile();
+    }
+
+    std::string to_string() const override {
+        std::ostringstream oss;
+        oss << "PlaneParallelMedium[" << std::endl
+            << "  albedo      = " << string::indent(m_albedo) << std::endl
+            << "  layer_count = " << m_sigmat_values.size() << "," << std::endl
+            << "  altitudes   = [" << m_altitude_values.front() << ", "
+            << m_altitude_values.back() << "]," << std::endl
+            << "  scale       = " << string::indent(m_scale) << std::endl
+            << "]";
+        return oss.str();
+    }
+
+    MTS_DECLARE_CLASS()
+private:
+    /// Parse a comma-separated list of floating point values
+    static std::vector<ScalarFloat> parse_list(const std::string &str, const char *name) {
+        std::vector<ScalarFloat> result;
+        for (const std::string &token : string::tokenize(str, " ,")) {
+            try {
+                result.push_back((ScalarFloat) std::stod(token));
+            } catch (...) {
+                Throw("Could not parse floating point value '%s' of '%s'", token, name);
+            }
+        }
+        return result;
+    }
+
+    /// Upload the (scaled) extinction of the layers
+    void update_profile() {
+        std::vector<ScalarFloat> sigmat(m_sigmat_values);
+        for (ScalarFloat &value : sigmat)
+            value *= m_scale;
+        m_sigmat = DynamicBuffer<Float>::copy(sigmat.data(), sigmat.size());
+    }
+
+    /// Index of the layer that contains the altitude \c z (clamped to the profile)
+    MTS_INLINE Int32 layer(const Float &z) const {
+        return Int32(math::find_interval(
+            (uint32_t) m_altitude_values.size(),
+            [&](UInt32 index, mask_t<UInt32> active) {
+                return gather<Float>(m_altitudes, index, active) <= z;
+            }));
+    }
+
+    /// Fetch the extinction of the layer \c index
+    MTS_INLINE Float eval_sigmat(const Int32 &index, Mask active) const {
+        return gather<Float>(m_sigmat, UInt32(index), active);
+    }
+
+    /**
+     * \brief Prepare the traversal of the layers along a ray
+     *
+     * Returns the lanes that overlap the profile, the overlapping segment of
+     * the ray, the altitude of its origin and its vertical direction in the
+     * local frame, and the first layer.
+     */
+    std::tuple<Mask, Float, Float, Float, Float, Int32>
+    traversal_init(const Ray3f &ray, Mask active) const {
+        auto [slab_its, mint, maxt] = intersect_aabb(ray);
+        active &= slab_its;
+        mint = max(ray.mint, mint);
+        maxt = min(ray.maxt, maxt);
+        active &= mint < maxt;
+
+        /* The direction is not normalized, so that the ray parameter still
+           measures distances along the original ray */
+        Float oz = m_to_local.transform_affine(ray.o).z(),
+              dz = m_to_local.transform_affine(ray.d).z();
+        return { active, mint, maxt, oz, dz, layer(fmadd(dz, mint, oz)) };
+    }
+
+    /// Ray distance at which the layer \c index is left (limited to \c maxt)
+    MTS_INLINE Float layer_exit(const Float &oz, const Float &dz, const Int32 &index,
+                                const Float &maxt, Mask active) const {
+        UInt32 boundary = UInt32(index) + select(dz > 0.f, UInt32(1), UInt32(0));
+        Float altitude = gather<Float>(m_altitudes, boundary, active);
+        return select(neq(dz, 0.f), min((altitude - oz) / dz, maxt), maxt);
+    }
+
+private:
+    ref<Volume> m_albedo;
+    ScalarFloat m_scale;
+    ScalarTransform4f m_to_local;
+
+    /// Vertical profile (see \ref update_profile())
+    std::vector<ScalarFloat> m_sigmat_values, m_altitude_values;
+    DynamicBuffer<Float> m_sigmat, m_altitudes;
+};
+
+MTS_IMPLEMENT_CLASS_VARIANT(PlaneParallelMedium, Medium)
+MTS_EXPORT_PLUGIN(PlaneParallelMedium, "Plane-parallel Medium")
+NAMESPACE_END(mitsuba)
@@ -0,0 +1,138 @@
+import numpy as np
+
+import mitsuba
+import pytest
+import enoki as ek
+
+
+SIGMA_T = [1.0, 2.0, 0.5]
+ALTITUDES = [0.0, 1.0, 3.0, 4.0]
+
+
+def create_medium():
+    from mitsuba.core.xml import load_string
+    return load_string("""<medium version="2.0.0" type="planeparallel">
+            <string name="sigma_t" value="1, 2, 0.5"/>
+            <string name="altitudes" value="0, 1, 3, 4"/>
+        </medium>""")
+
+
+def optical_depth(o, d, mint, maxt):
+    """Analytic optical depth of the ray segment [mint, maxt] (d is normalized)"""
+    depth = 0.0
+    for i, s in enumerate(SIGMA_T):
+        z0, z1 = ALTITUDES[i], ALTITUDES[i + 1]
+        if d[2] == 0:
+            if z0 <= o[2] < z1:
+                depth += s * (maxt - mint)
+            continue
+        t0, t1 = (z0 - o[2]) / d[2], (z1 - o[2]) / d[2]
+        t0, t1 = max(min(t0, t1), mint), min(max(t0, t1), maxt)
+        if t1 > t0:
+            depth += s * (t1 - t0)
+    return depth
+
+
+def sample_distance(o, d, tau, maxt=1e4, steps=200):
+    """Invert the analytic optical depth by bisection, or return None when it is not reached"""
+    if optical_depth(o, d, 0.0, maxt) < tau:
+        return None
+    lo, hi = 0.0, maxt
+    for _ in range(steps):
+        mid = 0.5 * (lo + hi)
+        if optical_depth(o, d, 0.0, mid) < tau:
+            lo = mid
+        else:
+            hi = mid
+    return 0.5 * (lo + hi)
+
+
+def make_ray(o, d, maxt=None):
+    from mitsuba.core import Ray3f
+    ray = Ray3f(o, d, 0.0, 0.0)
+    if maxt is not None:
+        ray.maxt = maxt
+    return ray
+
+
+RAYS = [
+    # Vertical rays crossing all layers, upwards and downwards
+    ([0.0, 0.0, -1.0], [0.0, 0.0, 1.0]),
+    ([0.5, 0.2, 5.0], [0.0, 0.0, -1.0]),
+    # Oblique rays starting inside a layer
+    ([0.0, 0.0, 0.5], [0.6, 0.0, 0.8]),
+    ([1.0, 2.0, 3.5], [0.0, -0.6, -0.8]),
+    # Grazing rays that travel far within each layer
+    ([0.0, 0.0, -0.1], [0.999, 0.0, 0.0447]),
+    ([0.0, 0.0, 3.9], [0.0, 0.9995, -0.0316]),
+]
+
+
+def test01_create(variant_scalar_rgb):
+    medium = create_medium()
+    assert medium is not None
+
+    from mitsuba.core.xml import load_string
+    with pytest.raises(RuntimeError):
+        load_string("""<medium version="2.0.0" type="planeparallel">
+                <string name="sigma_t" value="1, 2"/>
+                <string name="altitudes" value="0, 1"/>
+            </medium>""")
+
+
+@pytest.mark.parametrize("o, d", RAYS)
+def test02_eval_transmittance(variant_scalar_rgb, o, d):
+    medium = create_medium()
+    d = list(np.array(d) / np.linalg.norm(d))
+
+    for maxt in [0.3, 2.0, 50.0, None]:
+        ray = make_ray(o, d, maxt)
+        expected = np.exp(-optical_depth(o, d, 0.0, ray.maxt))
+        tr = medium.eval_transmittance(ray, None, 0)
+        assert np.allclose(tr, expected, rtol=1e-4, atol=1e-6)
+
+
+def test03_eval_transmittance_outside(variant_scalar_rgb):
+    """Rays that miss the slab or run parallel to its boundaries"""
+    medium = create_medium()
+
+    # Above the slab and pointing away from it, or parallel to it
+    for o, d in [([0, 0, 5], [0, 0, 1]), ([0, 0, 5], [1, 0, 0]),
+                 ([0, 0, -2], [0, 0.6, -0.8])]:
+        assert np.allclose(medium.eval_transmittance(make_ray(o, d), None, 0), 1.0)
+
+    # Parallel to the boundaries within the second layer
+    ray = make_ray([0, 0, 2], [1, 0, 0], 0.7)
+    assert np.allclose(medium.eval_transmittance(ray, None, 0), np.exp(-2.0 * 0.7))
+
+    # Segment ending before the slab is reached
+    ray = make_ray([0, 0, -2], [0, 0, 1], 1.5)
+    assert np.allclose(medium.eval_transmittance(ray, None, 0), 1.0)
+
+
+@pytest.mark.parametrize("o, d", RAYS)
+def test04_sample_interaction(variant_scalar_rgb, o, d):
+    medium = create_medium()
+    d = list(np.array(d) / np.linalg.norm(d))
+    ray = make_ray(o, d)
+
+    for sample in np.linspace(0.01, 0.99, 7):
+        mi = medium.sample_interaction(ray, sample, 0)
+        expected = sample_distance(o, d, -np.log(1.0 - sample))
+        if expected is None:
+            assert not mi.is_valid()
+        else:
+            assert mi.is_valid()
+            assert np.allclose(mi.t, expected, rtol=1e-4, atol=1e-5)
+            assert np.allclose(mi.p, np.array(o) + expected * np.array(d),
+                               rtol=1e-4, atol=1e-4)
+
+
+def test05_sample_interaction_outside(variant_scalar_rgb):
+    """Rays that miss the slab never produce a collision"""
+    medium = create_medium()
+    for o, d in [([0, 0, 5], [0, 0, 1]), ([0, 0, 5], [1, 0, 0]),
+                 ([0, 0, -2], [0, 0.6, -0.8])]:
+        for sample in [0.1, 0.5, 0.9]:
+            mi = medium.sample_interaction(make_ray(o, d), sample, 0)
+            assert not mi.is_valid()
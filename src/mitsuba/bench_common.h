@@ -0,0 +1,123 @@
+#pragma once
+
+#include <mitsuba/core/argparser.h>
+#include <mitsuba/core/bitmap.h>
+#include <mitsuba/core/filesystem.h>
+#include <mitsuba/core/fresolver.h>
+#include <mitsuba/core/jit.h>
+#include <mitsuba/core/logger.h>
+#include <mitsuba/core/math.h>
+#include <mitsuba/core/profiler.h>
+#include <mitsuba/core/thread.h>
+#include <mitsuba/core/timer.h>
+#include <mitsuba/core/util.h>
+#include <iostream>
+#include <string>
+#include <vector>
+
+/**
+ * Shared scaffolding of the benchmark executables (bench_*.cpp), which are
+ * built by the \c add_bench() function of src/mitsuba/CMakeLists.txt.
+ */
+
+NAMESPACE_BEGIN(mitsuba)
+NAMESPACE_BEGIN(harness)
+
+using StringVec = std::vector<std::string>;
+
+/// Return the value of the "-t/--threads" option (default: number of cores)
+inline size_t thread_count(const ArgParser::Arg *arg) {
+    int count = *arg ? arg->as_int() : util::core_count();
+    if (count < 1)
+        Throw("Thread count must be >= 1!");
+    return (size_t) count;
+}
+
+/// Return the values of the positional arguments
+inline std::vector<std::string> extra_args(const ArgParser::Arg *arg) {
+    std::vector<std::string> result;
+    while (arg && *arg) {
+        result.push_back(arg->as_string());
+        arg = arg->next();
+    }
+    return result;
+}
+
+/// Let the file resolver find the resources next to the Mitsuba libraries
+inline void add_library_path() {
+    ref<FileResolver> fr = Thread::thread()->file_resolver();
+    filesystem::path base_path = util::library_path().parent_path();
+    if (!fr->contains(base_path))
+        fr->append(base_path);
+}
+
+/// Run 'func' 'repeat' times and return the time of the fastest run in ms
+template <typename Func> float best_time(size_t repeat, Func &&func) {
+    float best = math::Infinity<float>;
+    for (size_t it = 0; it < repeat; ++it) {
+        Timer timer;
+        func();
+        best = std::min(best, (float) timer.value());
+    }
+    return best;
+}
+
+/**
+ * \brief Entry point of a benchmark
+ *
+ * Initializes the framework, registers the "-h/--help" and "-r/--repeat"
+ * options and parses the command line, reports critical exceptions and
+ * finally shuts the framework down.
+ *
+ * \param help
+ *    Prints the usage of the benchmark
+ *
+ * \param setup
+ *    Registers the options of the benchmark in the given \ref ArgParser and
+ *    returns the function that runs it. The latter receives the repeat count
+ *    and returns the exit code.
+ */
+template <typename Setup>
+int run_bench(int argc, char *argv[], void (*help)(), Setup &&setup) {
+    Jit::static_initialization();
+    Class::static_initialization();
+    Thread::static_initialization();
+    Logger::static_initialization();
+    Bitmap::static_initialization();
+    Profiler::static_initialization();
+
+    int exit_code = 0;
+
+    try {
+        ArgParser parser;
+        auto arg_repeat = parser.add(StringVec{ "-r", "--repeat" }, true);
+        auto arg_help   = parser.add(StringVec{ "-h", "--help" });
+        auto run = setup(parser);
+
+        parser.parse(argc, argv);
+
+        if (*arg_help) {
+            help();
+        } else {
+            int repeat = *arg_repeat ? arg_repeat->as_int() : 1;
+            if (repeat < 1)
+                Throw("--repeat: the repeat count must be >= 1!");
+            exit_code = run((size_t) repeat);
+        }
+    } catch (const std::exception &e) {
+        std::cerr << "Caught a critical exception: " << e.what() << std::endl;
+        exit_code = -1;
+    }
+
+    Profiler::static_shutdown();
+    Bitmap::static_shutdown();
+    Logger::static_shutdown();
+    Thread::static_shutdown();
+    Class::static_shutdown();
+    Jit::static_shutdown();
+
+    return exit_code;
+}
+
+NAMESPACE_END(harness)
+NAMESPACE_END(mitsuba)
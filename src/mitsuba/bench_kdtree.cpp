@@ -0,0 +1,226 @@
+#include "bench_common.h"
+
+#include <mitsuba/core/plugin.h>
+#include <mitsuba/core/properties.h>
+#include <mitsuba/render/kdtree.h>
+#include <mitsuba/render/scene.h>
+#include <tbb/task_arena.h>
+#include <tbb/task_scheduler_init.h>
+#include <iomanip>
+
+using namespace mitsuba;
+
+static void help() {
+    std::cout << R"(
+Usage: bench_kdtree [options] <One or more OBJ/PLY/serialized meshes>
+
+Builds the SAH kd-tree over the given meshes using a grid of construction
+settings (primitive clipping on/off, several exact primitive thresholds) and
+prints the resulting build statistics.
+
+Options:
+
+    -h, --help
+        Display this help text.
+
+    -m, --mode
+        Variant used to load the meshes and build the tree.
+
+        Default: )" MTS_DEFAULT_VARIANT R"(
+
+    -t <count>, --threads <count>
+        Build with the specified number of threads.
+
+    -r <count>, --repeat <count>
+        Build every configuration <count> times and report the fastest run.
+
+    -e <values>, --exact <values>
+        Comma-separated list of exact primitive thresholds to test.
+
+        Default: 0,4096,65536
+
+    -s <counts>, --scaling <counts>
+        Instead of the grid of settings, build the tree with the default
+        settings using each of the comma-separated thread counts (e.g.
+        1,2,4,8,16,32,64,128), and report the build times and the speedups
+        relative to the first count.
+
+)";
+}
+
+template <typename Float, typename Spectrum>
+void bench(const std::vector<std::string> &filenames,
+           const std::vector<int> &thresholds,
+           const std::vector<int> &thread_counts, size_t repeat) {
+    using Shape       = typename mitsuba::Shape<Float, Spectrum>;
+    using ShapeKDTree = typename mitsuba::ShapeKDTree<Float, Spectrum>;
+
+    if constexpr (is_cuda_array_v<Float>) {
+        ENOKI_MARK_USED(filenames);
+        ENOKI_MARK_USED(thresholds);
+        ENOKI_MARK_USED(thread_counts);
+        ENOKI_MARK_USED(repeat);
+        Throw("bench_kdtree requires a CPU variant!");
+    } else {
+        std::vector<ref<Shape>> shapes;
+        for (const std::string &filename : filenames) {
+            std::string ext = string::to_lower(fs::path(filename).extension().string());
+            if (!ext.empty())
+                ext = ext.substr(1);
+            Properties props(ext);
+            props.set_string("filename", filename);
+            shapes.push_back(PluginManager::instance()->create_object<Shape>(props));
+        }
+
+        if (!thread_counts.empty()) {
+            std::cout << std::left
+                      << std::setw(9)  << "threads"
+                      << std::setw(11) << "build [ms]"
+                      << std::setw(10) << "speedup"
+                      << std::setw(12) << "efficiency"
+                      << std::setw(13) << "work units"
+                      << "parallel sorts" << std::endl;
+
+            float base_time = 0.f;
+            for (int count : thread_counts) {
+                float best_time = math::Infinity<float>;
+                typename ShapeKDTree::BuildStatistics stats;
+
+                // Limit the concurrency of the build to the tested thread count
+                tbb::task_arena arena(count);
+                for (size_t i = 0; i < repeat; ++i) {
+                    ref<ShapeKDTree> kdtree = new ShapeKDTree(Properties());
+                    for (Shape *shape : shapes)
+                        kdtree->add_shape(shape);
+
+                    Timer timer;
+                    arena.execute([&]() { kdtree->build(); });
+                    float time = (float) timer.value();
+
+                    if (time < best_time) {
+                        best_time = time;
+                        stats = kdtree->build_statistics();
+                    }
+                }
+
+                if (base_time == 0.f)
+                    base_time = best_time;
+                float speedup = base_time / best_time;
+
+                std::cout << std::left << std::fixed << std::setprecision(2)
+                          << std::setw(9)  << count
+                          << std::setw(11) << best_time
+                          << std::setw(10) << speedup
+                          << std::setw(12) << speedup * thread_counts[0] / (float) count
+                          << std::setw(13) << stats.work_units
+                          << stats.parallel_sorts << std::endl;
+            }
+            return;
+        }
+
+        std::cout << std::left
+                  << std::setw(6)  << "clip"
+                  << std::setw(8)  << "exact"
+                  << std::setw(11) << "build [ms]"
+                  << std::setw(11) << "cost"
+                  << std::setw(10) << "nodes"
+                  << std::setw(10) << "indices"
+                  << std::setw(7)  << "depth"
+                  << std::setw(10) << "prims/lf"
+                  << std::setw(10) << "trav/q"
+                  << std::setw(10) << "prims/q"
+                  << "temp. storage" << std::endl;
+
+        for (bool clip : { true, false }) {
+            for (int threshold : thresholds) {
+                float best_time = math::Infinity<float>;
+                typename ShapeKDTree::BuildStatistics stats;
+
+                for (size_t i = 0; i < repeat; ++i) {
+                    Properties props;
+                    props.set_bool("kd_clip", clip);
+                    props.set_int("kd_exact_primitive_threshold", threshold);
+
+                    ref<ShapeKDTree> kdtree = new ShapeKDTree(props);
+                    for (Shape *shape : shapes)
+                        kdtree->add_shape(shape);
+
+                    Timer timer;
+                    kdtree->build();
+                    float time = (float) timer.value();
+
+                    if (time < best_time) {
+                        best_time = time;
+                        stats = kdtree->build_statistics();
+                    }
+                }
+
+                std::cout << std::left << std::fixed << std::setprecision(2)
+                          << std::setw(6)  << (clip ? "yes" : "no")
+                          << std::setw(8)  << threshold
+                          << std::setw(11) << best_time
+                          << std::setw(11) << stats.final_cost
+                          << std::setw(10) << stats.node_count
+                          << std::setw(10) << stats.index_count
+                          << std::setw(7)  << stats.max_depth
+                          << std::setw(10) << stats.avg_prims_in_leaf
+                          << std::setw(10) << stats.exp_traversal_steps
+                          << std::setw(10) << stats.exp_primitives_queried
+                          << util::mem_string(stats.temp_storage) << std::endl;
+            }
+        }
+    }
+}
+
+int main(int argc, char *argv[]) {
+    return harness::run_bench(argc, argv, help, [](ArgParser &parser) {
+        // Ensure that the mitsuba-render shared library is loaded
+        librender_nop();
+
+        auto arg_threads = parser.add(harness::StringVec{ "-t", "--threads" }, true);
+        auto arg_exact   = parser.add(harness::StringVec{ "-e", "--exact" }, true);
+        auto arg_scaling = parser.add(harness::StringVec{ "-s", "--scaling" }, true);
+        auto arg_mode    = parser.add(harness::StringVec{ "-m", "--mode" }, true);
+        auto arg_extra   = parser.add("", true);
+
+        return [=](size_t repeat) {
+            if (!*arg_extra) {
+                help();
+                return -1;
+            }
+
+            std::string mode = (*arg_mode ? arg_mode->as_string() : MTS_DEFAULT_VARIANT);
+
+            std::vector<int> thresholds;
+            for (const std::string &value :
+                 string::tokenize(*arg_exact ? arg_exact->as_string() : "0,4096,65536", ","))
+                thresholds.push_back(std::stoi(value));
+
+            std::vector<int> thread_counts;
+            if (*arg_scaling) {
+                for (const std::string &value :
+                     string::tokenize(arg_scaling->as_string(), ","))
+                    thread_counts.push_back(std::stoi(value));
+                for (int count : thread_counts) {
+                    if (count < 1)
+                        Throw("--scaling: thread counts must be >= 1!");
+                }
+            }
+
+            // Only show the warnings and errors of the builder itself
+            Thread::thread()->logger()->set_log_level(Warn);
+
+            size_t thread_count = harness::thread_count(arg_threads);
+            // The scheduler must provide enough workers for the largest arena
+            for (int count : thread_counts)
+                thread_count = std::max(thread_count, (size_t) count);
+            tbb::task_scheduler_init init((int) thread_count);
+
+            harness::add_library_path();
+            std::vector<std::string> filenames = harness::extra_args(arg_extra);
+
+            MTS_INVOKE_VARIANT(mode, bench, filenames, thresholds, thread_counts, repeat);
+            return 0;
+        };
+    });
+}
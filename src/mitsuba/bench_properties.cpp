@@ -0,0 +1,107 @@
+#include "bench_common.h"
+
+#include <mitsuba/core/plugin.h>
+#include <mitsuba/core/properties.h>
+#include <mitsuba/core/xml.h>
+#include <mitsuba/render/scene.h>
+#include <iomanip>
+#include <sstream>
+
+using namespace mitsuba;
+
+static void help() {
+    std::cout << R"(
+Usage: bench_properties [options]
+
+Measures the cost of filling and querying Properties instances like the
+plugins do, and the time needed to load a generated scene with a large
+number of shapes (which additionally exercises the Properties instance of
+the scene that references all of them).
+
+Options:
+
+    -h, --help
+        Display this help text.
+
+    -m, --mode
+        Variant used to load the scene.
+
+        Default: )" MTS_DEFAULT_VARIANT R"(
+
+    -n <count>, --objects <count>
+        Number of Properties instances and of shapes in the scene.
+
+        Default: 100000
+
+    -r <count>, --repeat <count>
+        Run every configuration <count> times and report the fastest run.
+
+)";
+}
+
+/// Fill and query 'count' Properties instances with the parameters of a typical plugin
+static void bench_lookup(size_t count) {
+    const char *names[] = { "radius", "center", "flip_normals", "to_world",
+                            "id", "max_depth", "rr_depth", "samples_per_pass" };
+    float checksum = 0.f;
+    for (size_t i = 0; i < count; ++i) {
+        Properties props("sphere");
+        for (size_t j = 0; j < 8; ++j)
+            props.set_float(names[j], (float) j);
+        for (size_t j = 0; j < 8; ++j)
+            checksum += props.float_(names[j]);
+        checksum += props.float_("missing", 0.f);
+        checksum += (float) props.unqueried().size();
+    }
+    if (checksum < 0.f)
+        std::cout << checksum;
+}
+
+/// Return the description of a scene containing 'count' spheres
+static std::string scene_string(size_t count) {
+    std::ostringstream oss;
+    oss << "<scene version=\"2.0.0\">" << std::endl
+        << "    <bsdf type=\"diffuse\" id=\"mat\"/>" << std::endl;
+    for (size_t i = 0; i < count; ++i)
+        oss << "    <shape type=\"sphere\"><float name=\"radius\" value=\"0.1\"/>"
+            << "<point name=\"center\" x=\"" << i << "\" y=\"0\" z=\"0\"/>"
+            << "<ref id=\"mat\"/></shape>" << std::endl;
+    oss << "</scene>" << std::endl;
+    return oss.str();
+}
+
+int main(int argc, char *argv[]) {
+    return harness::run_bench(argc, argv, help, [](ArgParser &parser) {
+        // Ensure that the mitsuba-render shared library is loaded
+        librender_nop();
+
+        auto arg_objects = parser.add(harness::StringVec{ "-n", "--objects" }, true);
+        auto arg_mode    = parser.add(harness::StringVec{ "-m", "--mode" }, true);
+
+        return [=](size_t repeat) {
+            std::string mode = (*arg_mode ? arg_mode->as_string() : MTS_DEFAULT_VARIANT);
+            int count = *arg_objects ? arg_objects->as_int() : 100000;
+            if (count < 1)
+                Throw("--objects: the object count must be >= 1!");
+
+            // Only show the warnings and errors of the plugins
+            Thread::thread()->logger()->set_log_level(Warn);
+
+            std::string scene = scene_string((size_t) count);
+            float lookup_time = harness::best_time(repeat, [&]() { bench_lookup((size_t) count); }),
+                  scene_time  = harness::best_time(repeat, [&]() { xml::load_string(scene, mode); });
+
+            std::cout << std::left << std::fixed << std::setprecision(2)
+                      << std::setw(14) << "benchmark"
+                      << std::setw(11) << "time [ms]"
+                      << "us/object" << std::endl
+                      << std::setw(14) << "properties"
+                      << std::setw(11) << lookup_time
+                      << (lookup_time * 1e3 / count) << std::endl
+                      << std::setw(14) << "scene"
+                      << std::setw(11) << scene_time
+                      << (scene_time * 1e3 / count) << std::endl;
+            return 0;
+        };
+    });
+}
@@ -0,0 +1,481 @@
+#include "bench_common.h"
+
+#include <mitsuba/core/fstream.h>
+#include <mitsuba/core/random.h>
+#include <mitsuba/core/string.h>
+#include <mitsuba/core/warp.h>
+#include <mitsuba/core/xml.h>
+#include <mitsuba/render/emitter.h>
+#include <mitsuba/render/film.h>
+#include <mitsuba/render/scene.h>
+#include <mitsuba/render/sensor.h>
+#include <tbb/parallel_for.h>
+#include <tbb/task_scheduler_init.h>
+#include <atomic>
+#include <iomanip>
+
+#if defined(MTS_ENABLE_OPTIX)
+#  include <enoki/cuda.h>
+#endif
+
+using namespace mitsuba;
+
+static void help() {
+    std::cout << R"(
+Usage: bench_rays [options] <One or more scene XML files>
+
+Measures the ray tracing throughput of the acceleration data structure of
+each scene. Three fixed sets of rays are cast: primary rays through the
+pixels of the first sensor, diffuse rays that are cosine-distributed about
+the normal at the surface hit by each primary ray, and shadow rays from
+those surface points towards sampled emitter positions. Every set is timed
+through Scene::ray_intersect(), Scene::ray_intersect_preliminary() and
+Scene::ray_test(), and the throughput is reported in millions of rays per
+second along with the fraction of rays that hit the scene.
+
+The backend is determined by the variant and by the build: GPU variants use
+OptiX, while CPU variants use Embree when Mitsuba was compiled with it and
+the native kd-tree or BVH otherwise. The acceleration data structure that
+each scene actually uses is reported along with its results.
+
+Options:
+
+    -h, --help
+        Display this help text.
+
+    -m, --mode
+        Variant used to load the scenes and trace the rays.
+
+        Default: )" MTS_DEFAULT_VARIANT R"(
+
+    -a <name>, --accel <name>
+        Native acceleration data structure ("kdtree" or "bvh"), which is
+        passed to the scene loader as the parameter $accel. Scenes select
+        it with <string name="accel" value="$accel"/>, and a warning is
+        shown for scenes that use another one.
+
+    -s <count>, --spp <count>
+        Number of primary rays per pixel.
+
+        Default: 1
+
+    -d <directory>, --rays <directory>
+        Directory storing the ray sets (one '.rays' file per scene). Ray
+        sets are loaded from it when present and otherwise generated and
+        stored there, so that subsequent runs (e.g. with other variants or
+        builds) trace exactly the same rays.
+
+    -t <count>, --threads <count>
+        Trace with the specified number of threads (CPU variants).
+
+    -r <count>, --repeat <count>
+        Run every configuration <count> times and report the fastest run.
+
+    -c, --csv
+        Print the results as comma-separated values.
+
+)";
+}
+
+/// File format identifier and version of stored ray sets
+static const uint32_t RayFileMagic   = 0x5359524D; // 'MRYS'
+static const uint32_t RayFileVersion = 1;
+
+/// Number of entries following the rays of a set (covers the largest packet)
+static const size_t RayPadding = 64;
+
+/// Set of rays stored in host memory as a structure of arrays
+struct RaySet {
+    std::string name;
+    size_t size = 0;
+
+    /// Origin, direction, minimum and maximum extent
+    std::vector<float> data[8];
+
+    void resize(size_t n) {
+        size = n;
+        for (auto &v : data)
+            v.assign(n + RayPadding, 0.f);
+    }
+
+    /// Only keep the rays whose entry in \c valid is nonzero
+    RaySet compact(const std::string &name_, const std::vector<float> &valid) const {
+        RaySet result;
+        result.name = name_;
+        size_t count = 0;
+        for (size_t i = 0; i < size; ++i)
+            count += valid[i] != 0.f;
+        result.resize(count);
+        for (size_t i = 0, j = 0; i < size; ++i) {
+            if (valid[i] == 0.f)
+                continue;
+            for (size_t k = 0; k < 8; ++k)
+                result.data[k][j] = data[k][i];
+            ++j;
+        }
+        return result;
+    }
+};
+
+static void write_rays(const fs::path &path, const std::vector<RaySet> &sets) {
+    ref<FileStream> stream = new FileStream(path, FileStream::ETruncReadWrite);
+    stream->write(RayFileMagic);
+    stream->write(RayFileVersion);
+    stream->write((uint32_t) sets.size());
+    for (const RaySet &set : sets) {
+        stream->write(set.name);
+        stream->write((uint64_t) set.size);
+        for (const auto &v : set.data)
+            stream->write_array(v.data(), set.size);
+    }
+}
+
+static std::vector<RaySet> read_rays(const fs::path &path) {
+    ref<FileStream> stream = new FileStream(path);
+    uint32_t magic, version, count;
+    stream->read(magic);
+    stream->read(version);
+    if (magic != RayFileMagic || version != RayFileVersion)
+        Throw("\"%s\": not a ray set file (or unsupported version)!", path.string());
+    stream->read(count);
+
+    std::vector<RaySet> sets(count);
+    for (RaySet &set : sets) {
+        uint64_t size;
+        stream->read(set.name);
+        stream->read(size);
+        set.resize((size_t) size);
+        for (auto &v : set.data)
+            stream->read_array(v.data(), set.size);
+    }
+    return sets;
+}
+
+/// Load the entries <tt>[offset, offset + count)</tt> of a host array
+template <typename Float>
+Float load_host(const std::vector<float> &v, size_t offset, size_t count) {
+    if constexpr (is_cuda_array_v<Float>)
+        return DynamicBuffer<Float>::copy(v.data() + offset, count);
+    else if constexpr (is_array_v<Float>)
+        return load_unaligned<Float>(v.data() + offset);
+    else
+        return v[offset];
+}
+
+/// Store a value into the entries starting at \c offset of a host array
+template <typename Float>
+void store_host(std::vector<float> &v, size_t offset, const Float &value) {
+    if constexpr (is_cuda_array_v<Float>) {
+#if defined(MTS_ENABLE_OPTIX)
+        auto value_d = detach(value);
+        cuda_eval();
+        cuda_memcpy_from_device(v.data() + offset, value_d.data(),
+                                slices(value_d) * sizeof(float));
+#else
+        ENOKI_MARK_USED(v);
+        ENOKI_MARK_USED(offset);
+        ENOKI_MARK_USED(value);
+#endif
+    } else if constexpr (is_array_v<Float>) {
+        store_unaligned(v.data() + offset, value);
+    } else {
+        v[offset] = value;
+    }
+}
+
+/**
+ * \brief Invoke <tt>func(offset, count)</tt> on consecutive chunks of
+ * \c size entries
+ *
+ * Chunks hold a single packet (or a single entry in scalar variants) and are
+ * processed in parallel. GPU variants process all entries at once.
+ */
+template <typename Float, typename Func>
+void for_each_chunk(size_t size, Func &&func) {
+    if constexpr (is_cuda_array_v<Float>) {
+        func((size_t) 0, size);
+    } else {
+        constexpr size_t Width = is_array_v<Float> ? array_size_v<Float> : 1;
+        size_t chunks = (size + Width - 1) / Width;
+        tbb::parallel_for(
+            tbb::blocked_range<size_t>(0, chunks, 64),
+            [&](const tbb::blocked_range<size_t> &range) {
+                for (size_t i = range.begin(); i != range.end(); ++i)
+                    func(i * Width, std::min(Width, size - i * Width));
+            }
+        );
+    }
+}
+
+template <typename Float, typename Spectrum>
+std::vector<RaySet> generate_rays(const Scene<Float, Spectrum> *scene, uint32_t spp) {
+    MTS_IMPORT_TYPES()
+    using UInt32 = uint32_array_t<Float>;
+
+    const Sensor<Float, Spectrum> *sensor = scene->sensors()[0].get();
+    ScalarVector2i film_size = sensor->film()->crop_size();
+    size_t size = (size_t) hprod(film_size) * spp;
+
+    // Random numbers of all rays (stratified by pixel for the primary rays)
+    std::vector<float> samples[7];
+    PCG32<uint32_t> rng;
+    for (auto &v : samples)
+        v.resize(size + RayPadding);
+    for (size_t i = 0; i < size; ++i) {
+        size_t pixel = i / spp;
+        samples[0][i] = ((pixel % film_size.x()) + rng.next_float32()) / film_size.x();
+        samples[1][i] = ((pixel / film_size.x()) + rng.next_float32()) / film_size.y();
+        for (size_t k = 2; k < 7; ++k)
+            samples[k][i] = rng.next_float32();
+    }
+
+    RaySet primary, diffuse, shadow;
+    primary.name = "primary";
+    primary.resize(size);
+    diffuse.resize(size);
+    shadow.resize(size);
+    std::vector<float> valid_diffuse(size + RayPadding),
+                       valid_shadow(size + RayPadding);
+
+    ScalarBoundingBox3f bbox = scene->bbox();
+    bool has_emitters = !scene->emitters().empty();
+
+    auto store_ray = [](RaySet &set, size_t offset, const Ray3f &ray) {
+        for (size_t k = 0; k < 3; ++k) {
+            store_host(set.data[k], offset, ray.o[k]);
+            store_host(set.data[3 + k], offset, ray.d[k]);
+        }
+        store_host(set.data[6], offset, ray.mint);
+        store_host(set.data[7], offset, ray.maxt);
+    };
+
+    for_each_chunk<Float>(size, [&](size_t offset, size_t count) {
+        auto sample = [&](size_t k) { return load_host<Float>(samples[k], offset, count); };
+
+        Mask active = true;
+        if constexpr (is_array_v<Float> && !is_cuda_array_v<Float>)
+            active = arange<UInt32>() < UInt32((uint32_t) count);
+
+        auto [ray, weight] = sensor->sample_ray(0.f, sample(2), Point2f(sample(0), sample(1)),
+                                                Point2f(sample(3), sample(4)), active);
+        ENOKI_MARK_USED(weight);
+        store_ray(primary, offset, ray);
+
+        SurfaceInteraction3f si = scene->ray_intersect(ray, active);
+        active &= si.is_valid();
+
+        // Diffuse bounce
+        Vector3f wo = warp::square_to_cosine_hemisphere(Point2f(sample(5), sample(6)));
+        store_ray(diffuse, offset, si.spawn_ray(si.to_world(wo)));
+        store_host(valid_diffuse, offset, select(active, Float(1.f), Float(0.f)));
+
+        // Shadow rays towards a point on an emitter (or in the bounding box)
+        Point3f target;
+        if (has_emitters) {
+            auto [ds, emitter_val] =
+                scene->sample_emitter_direction(si, Point2f(sample(2), sample(3)), false, active);
+            ENOKI_MARK_USED(emitter_val);
+            active &= ds.pdf > 0.f;
+            target = ds.p;
+        } else {
+            target = bbox.min + bbox.extents() * Vector3f(sample(2), sample(3), sample(4));
+        }
+        store_ray(shadow, offset, si.spawn_ray_to(target));
+        store_host(valid_shadow, offset, select(active, Float(1.f), Float(0.f)));
+    });
+
+    return { primary, diffuse.compact("diffuse", valid_diffuse),
+             shadow.compact("shadow", valid_shadow) };
+}
+
+template <typename Float, typename Spectrum>
+void bench(const std::vector<std::string> &filenames, const std::string &mode,
+           const std::string &accel, const fs::path &ray_dir, uint32_t spp,
+           size_t repeat, bool csv) {
+    MTS_IMPORT_TYPES()
+    using Scene = mitsuba::Scene<Float, Spectrum>;
+    using UInt32 = uint32_array_t<Float>;
+
+    const char *queries[] = { "ray_intersect", "preliminary", "ray_test" };
+
+    if (csv)
+        std::cout << "scene,variant,backend,rays,query,count,time_ms,mrays_per_s,hit_ratio"
+                  << std::endl;
+    else
+        std::cout << "Variant: " << mode << std::endl
+                  << std::left
+                  << std::setw(20) << "scene"
+                  << std::setw(10) << "backend"
+                  << std::setw(10) << "rays"
+                  << std::setw(15) << "query"
+                  << std::setw(11) << "count"
+                  << std::setw(11) << "time [ms]"
+                  << std::setw(10) << "Mrays/s"
+                  << "hits" << std::endl;
+
+    for (const std::string &filename : filenames) {
+        fs::path path(filename);
+
+        // Resolve the resources of the scene relative to its directory
+        ref<FileResolver> fr = new FileResolver(*Thread::thread()->file_resolver());
+        if (!fr->contains(path.parent_path()))
+            fr->append(path.parent_path());
+        Thread::thread()->set_file_resolver(fr);
+
+        xml::ParameterList params;
+        if (!accel.empty())
+            params.emplace_back("accel", accel);
+        ref<Object> parsed = xml::load_file(path, mode, params);
+        const Scene *scene = dynamic_cast<const Scene *>(parsed.get());
+        if (!scene)
+            Throw("\"%s\": does not describe a scene!", filename);
+        if (scene->sensors().empty())
+            Throw("\"%s\": the scene does not contain a sensor!", filename);
+
+        std::string backend = scene->accel_name();
+        if (!accel.empty() && backend != accel && (backend == "kdtree" || backend == "bvh"))
+            Log(Warn, "\"%s\": the scene uses the acceleration data structure \"%s\" "
+                "instead of \"%s\" (it does not set accel to $accel).", filename,
+                backend, accel);
+
+        std::vector<RaySet> sets;
+        fs::path ray_path;
+        if (!ray_dir.empty())
+            ray_path = ray_dir / fs::path(path.filename().string() + ".rays");
+
+        if (!ray_path.empty() && fs::exists(ray_path)) {
+            sets = read_rays(ray_path);
+        } else {
+            sets = generate_rays(scene, spp);
+            if (!ray_path.empty())
+                write_rays(ray_path, sets);
+        }
+
+        for (const RaySet &set : sets) {
+            if (set.size == 0)
+                continue;
+
+            auto load_ray = [&](size_t offset, size_t count) {
+                auto entry = [&](size_t k) { return load_host<Float>(set.data[k], offset, count); };
+                return Ray3f(Point3f(entry(0), entry(1), entry(2)),
+                             Vector3f(entry(3), entry(4), entry(5)),
+                             entry(6), entry(7), 0.f, zero<Wavelength>());
+            };
+
+            // GPU variants upload the rays only once
+            Ray3f rays_gpu;
+            if constexpr (is_cuda_array_v<Float>) {
+                rays_gpu = load_ray(0, set.size);
+                cuda_eval();
+                cuda_sync();
+            }
+
+            for (size_t query = 0; query < 3; ++query) {
+                float best_time = math::Infinity<float>;
+                size_t hits = 0;
+
+                for (size_t it = 0; it < repeat; ++it) {
+                    std::atomic<size_t> hit_count(0);
+
+                    auto trace = [&](const Ray3f &ray, Mask active) -> Mask {
+                        switch (query) {
+                            case 0:  return scene->ray_intersect(ray, active).is_valid() && active;
+                            case 1:  return scene->ray_intersect_preliminary(ray, active).is_valid() && active;
+                            default: return scene->ray_test(ray, active) && active;
+                        }
+                    };
+
+                    Timer timer;
+                    if constexpr (is_cuda_array_v<Float>) {
+                        Mask hit = trace(rays_gpu, true);
+                        cuda_eval();
+                        cuda_sync();
+                        best_time = std::min(best_time, (float) timer.value());
+                        hit_count = (size_t) count(detach(hit));
+                    } else {
+                        for_each_chunk<Float>(set.size, [&](size_t offset, size_t count_) {
+                            Mask active = true;
+                            if constexpr (is_array_v<Float>)
+                                active = arange<UInt32>() < UInt32((uint32_t) count_);
+                            Mask hit = trace(load_ray(offset, count_), active);
+                            if constexpr (is_array_v<Float>)
+                                hit_count += (size_t) count(hit);
+                            else
+                                hit_count += hit ? 1 : 0;
+                        });
+                        best_time = std::min(best_time, (float) timer.value());
+                    }
+                    hits = hit_count;
+                }
+
+                float mrays = (float) (set.size / (best_time * 1e3));
+                float hit_ratio = (float) hits / (float) set.size;
+                std::string scene_name = path.filename().string();
+
+                if (csv)
+                    std::cout << scene_name << "," << mode << "," << backend << ","
+                              << set.name << "," << queries[query] << "," << set.size << ","
+                              << best_time << "," << mrays << "," << hit_ratio << std::endl;
+                else
+                    std::cout << std::left << std::fixed << std::setprecision(2)
+                              << std::setw(20) << scene_name
+                              << std::setw(10) << backend
+                              << std::setw(10) << set.name
+                              << std::setw(15) << queries[query]
+                              << std::setw(11) << set.size
+                              << std::setw(11) << best_time
+                              << std::setw(10) << mrays
+                              << (hit_ratio * 100.f) << "%" << std::endl;
+            }
+        }
+    }
+}
+
+int main(int argc, char *argv[]) {
+    return harness::run_bench(argc, argv, help, [](ArgParser &parser) {
+        // Ensure that the mitsuba-render shared library is loaded
+        librender_nop();
+
+        auto arg_accel   = parser.add(harness::StringVec{ "-a", "--accel" }, true);
+        auto arg_spp     = parser.add(harness::StringVec{ "-s", "--spp" }, true);
+        auto arg_rays    = parser.add(harness::StringVec{ "-d", "--rays" }, true);
+        auto arg_threads = parser.add(harness::StringVec{ "-t", "--threads" }, true);
+        auto arg_csv     = parser.add(harness::StringVec{ "-c", "--csv" });
+        auto arg_mode    = parser.add(harness::StringVec{ "-m", "--mode" }, true);
+        auto arg_extra   = parser.add("", true);
+
+        return [=](size_t repeat) {
+            if (!*arg_extra) {
+                help();
+                return -1;
+            }
+
+            std::string mode = (*arg_mode ? arg_mode->as_string() : MTS_DEFAULT_VARIANT);
+            std::string accel = *arg_accel ? string::to_lower(arg_accel->as_string()) : "";
+            if (!accel.empty() && accel != "kdtree" && accel != "bvh")
+                Throw("--accel: must be \"kdtree\" or \"bvh\"!");
+            int spp = *arg_spp ? arg_spp->as_int() : 1;
+            if (spp < 1)
+                Throw("--spp: the sample count must be >= 1!");
+
+            fs::path ray_dir;
+            if (*arg_rays) {
+                ray_dir = arg_rays->as_string();
+                if (!fs::exists(ray_dir) && !fs::create_directory(ray_dir))
+                    Throw("Could not create the ray set directory \"%s\"!", ray_dir.string());
+            }
+
+            // Only show the warnings and errors of the scene loader
+            Thread::thread()->logger()->set_log_level(Warn);
+
+            tbb::task_scheduler_init init((int) harness::thread_count(arg_threads));
+
+            harness::add_library_path();
+            std::vector<std::string> filenames = harness::extra_args(arg_extra);
+
+            MTS_INVOKE_VARIANT(mode, bench, filenames, mode, accel, ray_dir,
+                               (uint32_t) spp, repeat, (bool) *arg_csv);
+            return 0;
+        };
+    });
+}
@@ -0,0 +1,159 @@
+#include "bench_common.h"
+
+#include <mitsuba/core/plugin.h>
+#include <mitsuba/core/properties.h>
+#include <mitsuba/render/sampler.h>
+#include <iomanip>
+
+using namespace mitsuba;
+
+static void help() {
+    std::cout << R"(
+Usage: bench_sampler [options] <One or more sampler plugins>
+
+Generates samples with the given sampler plugins (e.g. ldsampler,
+multijitter), both with the per-sample state computed when seeding and in
+stateless mode, and prints the generation time and a checksum of the
+samples for each configuration.
+
+Options:
+
+    -h, --help
+        Display this help text.
+
+    -m, --mode
+        Variant used to generate the samples.
+
+        Default: )" MTS_DEFAULT_VARIANT R"(
+
+    -s <count>, --spp <count>
+        Number of samples per pixel.
+
+        Default: 64
+
+    -p <count>, --pixels <count>
+        Number of pixels (sequences).
+
+        Default: 65536
+
+    -d <count>, --dimensions <count>
+        Number of 2D samples drawn for every sample.
+
+        Default: 16
+
+    -r <count>, --repeat <count>
+        Run every configuration <count> times and report the fastest run.
+
+)";
+}
+
+template <typename Float, typename Spectrum>
+void bench(const std::vector<std::string> &plugins, uint32_t spp, uint32_t pixels,
+           uint32_t dimensions, size_t repeat) {
+    using Sampler = typename mitsuba::Sampler<Float, Spectrum>;
+    using Point2f = Point<Float, 2>;
+
+    std::cout << std::left
+              << std::setw(14) << "plugin"
+              << std::setw(11) << "stateless"
+              << std::setw(11) << "time [ms]"
+              << std::setw(15) << "ns/dimension"
+              << "checksum" << std::endl;
+
+    for (const std::string &plugin : plugins) {
+        for (bool stateless : { false, true }) {
+            Properties props(plugin);
+            props.set_int("sample_count", (int) spp);
+            props.set_bool("stateless", stateless);
+            ref<Sampler> sampler = PluginManager::instance()->create_object<Sampler>(props);
+            spp = sampler->sample_count();
+
+            float best_time = math::Infinity<float>;
+            double checksum = 0.0;
+
+            for (size_t it = 0; it < repeat; ++it) {
+                Timer timer;
+                Point2f sum = zero<Point2f>();
+
+                if constexpr (is_dynamic_array_v<Float>) {
+                    // Generate all samples of all pixels in a single wavefront
+                    sampler->set_samples_per_wavefront(spp);
+                    sampler->seed(0, (size_t) pixels * spp);
+                    for (uint32_t d = 0; d < dimensions; ++d)
+                        sum += sampler->next_2d();
+                    if constexpr (is_cuda_array_v<Float>) {
+                        cuda_eval();
+                        cuda_sync();
+                    }
+                } else {
+                    for (uint32_t i = 0; i < pixels; ++i) {
+                        sampler->seed(i);
+                        for (uint32_t j = 0; j < spp; ++j) {
+                            for (uint32_t d = 0; d < dimensions; ++d)
+                                sum += sampler->next_2d();
+                            sampler->advance();
+                        }
+                    }
+                }
+
+                float time = (float) timer.value();
+                if (time < best_time) {
+                    best_time = time;
+                    auto total = hsum_nested(sum);
+                    if constexpr (is_dynamic_array_v<decltype(total)>)
+                        checksum = (double) total.coeff(0);
+                    else
+                        checksum = (double) total;
+                }
+            }
+
+            double evals = (double) pixels * spp * dimensions * 2;
+            if constexpr (is_array_v<Float> && !is_dynamic_array_v<Float>)
+                evals *= Float::Size;
+
+            std::cout << std::left << std::fixed << std::setprecision(2)
+                      << std::setw(14) << plugin
+                      << std::setw(11) << (stateless ? "yes" : "no")
+                      << std::setw(11) << best_time
+                      << std::setw(15) << (best_time * 1e6 / evals)
+                      << checksum << std::endl;
+        }
+    }
+}
+
+int main(int argc, char *argv[]) {
+    return harness::run_bench(argc, argv, help, [](ArgParser &parser) {
+        // Ensure that the mitsuba-render shared library is loaded
+        librender_nop();
+
+        auto arg_spp    = parser.add(harness::StringVec{ "-s", "--spp" }, true);
+        auto arg_pixels = parser.add(harness::StringVec{ "-p", "--pixels" }, true);
+        auto arg_dims   = parser.add(harness::StringVec{ "-d", "--dimensions" }, true);
+        auto arg_mode   = parser.add(harness::StringVec{ "-m", "--mode" }, true);
+        auto arg_extra  = parser.add("", true);
+
+        return [=](size_t repeat) {
+            if (!*arg_extra) {
+                help();
+                return -1;
+            }
+
+            std::string mode = (*arg_mode ? arg_mode->as_string() : MTS_DEFAULT_VARIANT);
+            int spp    = *arg_spp ? arg_spp->as_int() : 64,
+                pixels = *arg_pixels ? arg_pixels->as_int() : 65536,
+                dims   = *arg_dims ? arg_dims->as_int() : 16;
+
+            if (spp < 1 || pixels < 1 || dims < 1)
+                Throw("The sample, pixel and dimension counts must be >= 1!");
+
+            // Only show the warnings and errors of the samplers
+            Thread::thread()->logger()->set_log_level(Warn);
+
+            std::vector<std::string> plugins = harness::extra_args(arg_extra);
+
+            MTS_INVOKE_VARIANT(mode, bench, plugins, (uint32_t) spp, (uint32_t) pixels,
+                               (uint32_t) dims, repeat);
+            return 0;
+        };
+    });
+}
@@ -0,0 +1,449 @@
+#include "bench_common.h"
+
+#include <mitsuba/core/random.h>
+#include <mitsuba/core/spectrum.h>
+#include <mitsuba/core/string.h>
+#include <mitsuba/core/warp.h>
+#include <mitsuba/core/xml.h>
+#include <mitsuba/render/bsdf.h>
+#include <mitsuba/render/emitter.h>
+#include <mitsuba/render/scene.h>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+
+using namespace mitsuba;
+
+static void help() {
+    std::cout << R"(
+Usage: bench_shading [options] [<plugin names>]
+
+Instantiates the BSDF and emitter plugins with representative parameters and
+measures the time per call of their sampling, evaluation and density
+queries on batches of random surface interactions:
+
+    BSDFs:    BSDF::sample(), BSDF::eval(), BSDF::pdf()
+    Emitters: Emitter::sample_direction(), Emitter::eval(),
+              Emitter::pdf_direction()
+
+The results are written in JSON format. When plugin names are specified,
+only the configurations of these plugins are benchmarked.
+
+Options:
+
+    -h, --help
+        Display this help text.
+
+    -m <variants>, --mode <variants>
+        Comma-separated list of the variants to benchmark (e.g.
+        scalar_rgb,packet_rgb). GPU variants are not supported.
+
+        Default: )" MTS_DEFAULT_VARIANT R"(
+
+    -n <count>, --queries <count>
+        Number of calls per query (in packet variants, each packet holds
+        several queries).
+
+        Default: 1000000
+
+    -r <count>, --repeat <count>
+        Run every query <count> times and report the fastest run.
+
+    -f <file>, --measured <file>
+        Measured BSDF data file (.bsdf) used to benchmark the 'measured'
+        plugin, which is skipped otherwise.
+
+    -o <file>, --output <file>
+        Write the JSON output to <file> instead of the standard output.
+
+)";
+}
+
+/// Plugin configuration that is benchmarked
+struct Config {
+    std::string plugin, name, xml;
+};
+
+/// Number of distinct interactions of a batch, which is processed repeatedly
+static const size_t BatchSize = 16384;
+
+static std::vector<Config> bsdf_configs(const std::string &measured,
+                                        const std::string &bitmap) {
+    std::vector<Config> configs = {
+        { "diffuse", "default", R"(<bsdf type="diffuse"/>)" },
+        { "diffuse", "rgb",
+          R"(<bsdf type="diffuse"><rgb name="reflectance" value="0.2, 0.5, 0.8"/></bsdf>)" },
+        { "conductor", "default", R"(<bsdf type="conductor"/>)" },
+        { "roughconductor", "ggx_0.2",
+          R"(<bsdf type="roughconductor"><float name="alpha" value="0.2"/></bsdf>)" },
+        { "roughconductor", "beckmann_0.2",
+          R"(<bsdf type="roughconductor"><float name="alpha" value="0.2"/>
+                <string name="distribution" value="beckmann"/></bsdf>)" },
+        { "roughconductor", "ggx_aniso",
+          R"(<bsdf type="roughconductor"><float name="alpha_u" value="0.05"/>
+                <float name="alpha_v" value="0.3"/></bsdf>)" },
+        { "dielectric", "default", R"(<bsdf type="dielectric"/>)" },
+        { "thindielectric", "default", R"(<bsdf type="thindielectric"/>)" },
+        { "roughdielectric", "ggx_0.2",
+          R"(<bsdf type="roughdielectric"><float name="alpha" value="0.2"/></bsdf>)" },
+        { "roughdielectric", "beckmann_0.2",
+          R"(<bsdf type="roughdielectric"><float name="alpha" value="0.2"/>
+                <string name="distribution" value="beckmann"/></bsdf>)" },
+        { "roughdielectric", "ggx_textured",
+          R"(<bsdf type="roughdielectric">
+                <texture type="checkerboard" name="alpha">
+                    <rgb name="color0" value="0.05"/><rgb name="color1" value="0.3"/>
+                </texture>
+             </bsdf>)" },
+        { "plastic", "default", R"(<bsdf type="plastic"/>)" },
+        { "roughplastic", "ggx_0.1",
+          R"(<bsdf type="roughplastic"><float name="alpha" value="0.1"/></bsdf>)" },
+        { "roughplastic", "ggx_rgb",
+          R"(<bsdf type="roughplastic"><float name="alpha" value="0.1"/>
+                <rgb name="diffuse_reflectance" value="0.2, 0.5, 0.8"/></bsdf>)" },
+        { "twosided", "diffuse",
+          R"(<bsdf type="twosided"><bsdf type="diffuse"/></bsdf>)" },
+        { "blendbsdf", "diffuse_roughconductor",
+          R"(<bsdf type="blendbsdf"><float name="weight" value="0.5"/>
+                <bsdf type="diffuse"/>
+                <bsdf type="roughconductor"><float name="alpha" value="0.2"/></bsdf>
+             </bsdf>)" },
+        { "mask", "diffuse",
+          R"(<bsdf type="mask"><bsdf type="diffuse"/></bsdf>)" },
+        { "bumpmap", "diffuse",
+          R"(<bsdf type="bumpmap"><texture type="checkerboard"/><bsdf type="diffuse"/></bsdf>)" },
+        { "null", "default", R"(<bsdf type="null"/>)" },
+    };
+
+    if (!bitmap.empty())
+        configs.push_back({ "normalmap", "diffuse",
+            R"(<bsdf type="normalmap">
+                <texture type="bitmap" name="normalmap">
+                    <string name="filename" value=")" + bitmap + R"("/>
+                    <boolean name="raw" value="true"/>
+                </texture>
+                <bsdf type="diffuse"/>
+             </bsdf>)" });
+
+    if (!measured.empty())
+        configs.push_back({ "measured", fs::path(measured).filename().string(),
+            R"(<bsdf type="measured"><string name="filename" value=")" + measured +
+            R"("/></bsdf>)" });
+
+    return configs;
+}
+
+static std::vector<Config> emitter_configs(const std::string &bitmap) {
+    std::vector<Config> configs = {
+        { "point", "default",
+          R"(<emitter type="point"><point name="position" x="0" y="0" z="5"/></emitter>)" },
+        { "spot", "default",
+          R"(<emitter type="spot">
+                <transform name="to_world"><lookat origin="0, 0, 5" target="0, 0, 0"/></transform>
+             </emitter>)" },
+        { "directional", "default",
+          R"(<emitter type="directional"><vector name="direction" x="0" y="0" z="-1"/></emitter>)" },
+        { "constant", "default", R"(<emitter type="constant"/>)" },
+        { "area", "rectangle",
+          R"(<shape type="rectangle">
+                <transform name="to_world">
+                    <rotate x="1" angle="180"/><translate z="2"/>
+                </transform>
+                <emitter type="area"/>
+             </shape>)" },
+        { "area", "sphere",
+          R"(<shape type="sphere">
+                <point name="center" x="0" y="0" z="3"/>
+                <emitter type="area"/>
+             </shape>)" },
+    };
+
+    if (!bitmap.empty()) {
+        configs.push_back({ "envmap", "64x32",
+            R"(<emitter type="envmap"><string name="filename" value=")" + bitmap +
+            R"("/></emitter>)" });
+        configs.push_back({ "projector", "64x32",
+            R"(<emitter type="projector">
+                <transform name="to_world"><lookat origin="0, 0, 5" target="0, 0, 0"/></transform>
+                <texture type="bitmap" name="irradiance">
+                    <string name="filename" value=")" + bitmap + R"("/>
+                </texture>
+             </emitter>)" });
+    }
+
+    return configs;
+}
+
+/// Time \c passes calls of \c func on every entry of a batch and return ns per call
+template <typename Func>
+double time_query(size_t batch, size_t passes, size_t width, size_t repeat, Func &&func) {
+    double best = std::numeric_limits<double>::infinity();
+    for (size_t it = 0; it < repeat; ++it) {
+        Timer timer;
+        for (size_t p = 0; p < passes; ++p)
+            for (size_t i = 0; i < batch; ++i)
+                func(i);
+        best = std::min(best, (double) timer.value_in<std::chrono::microseconds>());
+    }
+    return best * 1e3 / ((double) batch * passes * width);
+}
+
+template <typename Float, typename Spectrum>
+void bench(const std::string &mode, const std::vector<std::string> &filter,
+           const std::string &measured, const std::string &bitmap, size_t queries,
+           size_t repeat, std::ostream &os, bool first_variant) {
+    MTS_IMPORT_TYPES()
+    using BSDF    = mitsuba::BSDF<Float, Spectrum>;
+    using Emitter = mitsuba::Emitter<Float, Spectrum>;
+    using Scene   = mitsuba::Scene<Float, Spectrum>;
+
+    if constexpr (is_cuda_array_v<Float>) {
+        ENOKI_MARK_USED(filter);
+        ENOKI_MARK_USED(measured);
+        ENOKI_MARK_USED(bitmap);
+        ENOKI_MARK_USED(queries);
+        ENOKI_MARK_USED(repeat);
+        ENOKI_MARK_USED(os);
+        ENOKI_MARK_USED(first_variant);
+        Throw("bench_shading: variant \"%s\" is not supported, use a scalar "
+              "or packet variant!", mode);
+    } else {
+        constexpr size_t Width = is_array_v<Float> ? array_size_v<Float> : 1;
+        size_t batch  = BatchSize / Width,
+               passes = std::max(queries / BatchSize, (size_t) 1);
+
+        // Random interactions on the plane z=0 with upper-hemisphere directions
+        PCG32<UInt32> rng(PCG32_DEFAULT_STATE, PCG32_DEFAULT_STREAM + arange<UInt64>());
+        std::vector<SurfaceInteraction3f> si(batch);
+        std::vector<Point2f> sample2(batch);
+        std::vector<Float> sample1(batch);
+        std::vector<Vector3f> wo_refl(batch), wo_sphere(batch);
+        for (size_t i = 0; i < batch; ++i) {
+            auto next_2d = [&]() {
+                Float a = rng.next_float32();
+                return Point2f(a, rng.next_float32());
+            };
+            SurfaceInteraction3f s = zero<SurfaceInteraction3f>();
+            Point2f uv = next_2d();
+            s.p = Point3f(uv.x() * 2.f - 1.f, uv.y() * 2.f - 1.f, 0.f);
+            s.uv = uv;
+            s.n = Normal3f(0.f, 0.f, 1.f);
+            s.sh_frame = Frame3f(s.n);
+            s.dp_du = Vector3f(2.f, 0.f, 0.f);
+            s.dp_dv = Vector3f(0.f, 2.f, 0.f);
+            s.wi = warp::square_to_cosine_hemisphere(next_2d());
+            s.time = 0.f;
+            s.wavelengths = sample_wavelength<Float, Spectrum>(rng.next_float32()).first;
+            si[i] = s;
+
+            sample1[i] = rng.next_float32();
+            sample2[i] = next_2d();
+            wo_refl[i] = warp::square_to_cosine_hemisphere(next_2d());
+            wo_sphere[i] = warp::square_to_uniform_sphere(next_2d());
+        }
+
+        // Sink for the results, which prevents the compiler from eliminating the queries
+        Float sink = 0.f;
+        auto consume = [&](const auto &value) { sink += hsum(depolarize(value)); };
+
+        auto selected = [&](const Config &config) {
+            return filter.empty() || std::find(filter.begin(), filter.end(),
+                                               config.plugin) != filter.end();
+        };
+
+        std::vector<std::string> results;
+        auto report = [&](const Config &config, const char *kind, const char *names[3],
+                          double ns[3]) {
+            std::ostringstream oss;
+            oss << std::fixed << std::setprecision(2)
+                << "      { \"kind\": \"" << kind << "\", \"plugin\": \"" << config.plugin
+                << "\", \"config\": \"" << config.name << "\"";
+            for (size_t k = 0; k < 3; ++k)
+                oss << ", \"" << names[k] << "_ns\": " << ns[k];
+            oss << " }";
+            results.push_back(oss.str());
+        };
+
+        // ------------------------------- BSDFs -------------------------------
+
+        for (const Config &config : bsdf_configs(measured, bitmap)) {
+            if (!selected(config))
+                continue;
+
+            ref<BSDF> bsdf;
+            try {
+                // Standalone BSDFs require the version attribute on their own tag
+                std::string xml = config.xml;
+                xml.insert(5, " version=\"2.0.0\"");
+                ref<Object> obj = xml::load_string(xml, mode);
+                bsdf = dynamic_cast<BSDF *>(obj.get());
+            } catch (const std::exception &e) {
+                Log(Warn, "Skipping BSDF \"%s\" (%s): %s", config.plugin, config.name, e.what());
+                continue;
+            }
+
+            BSDFContext ctx;
+            const std::vector<Vector3f> &wo =
+                has_flag(bsdf->flags(), BSDFFlags::Transmission) ? wo_sphere : wo_refl;
+            const char *names[3] = { "sample", "eval", "pdf" };
+            double ns[3];
+
+            ns[0] = time_query(batch, passes, Width, repeat, [&](size_t i) {
+                auto [bs, weight] = bsdf->sample(ctx, si[i], sample1[i], sample2[i]);
+                consume(weight);
+                sink += hsum(bs.pdf);
+            });
+            ns[1] = time_query(batch, passes, Width, repeat, [&](size_t i) {
+                consume(bsdf->eval(ctx, si[i], wo[i]));
+            });
+            ns[2] = time_query(batch, passes, Width, repeat, [&](size_t i) {
+                sink += hsum(bsdf->pdf(ctx, si[i], wo[i]));
+            });
+
+            report(config, "bsdf", names, ns);
+        }
+
+        // ------------------------------ Emitters -----------------------------
+
+        for (const Config &config : emitter_configs(bitmap)) {
+            if (!selected(config))
+                continue;
+
+            /* Emitters are part of a scene, which computes the bounds
+               required by infinite emitters */
+            ref<Object> obj;
+            const Emitter *emitter = nullptr;
+            try {
+                obj = xml::load_string("<scene version=\"2.0.0\">"
+                                       "<shape type=\"rectangle\"/>" + config.xml + "</scene>",
+                                       mode);
+                Scene *scene = dynamic_cast<Scene *>(obj.get());
+                for (const auto &e : scene->emitters())
+                    emitter = e.get();
+            } catch (const std::exception &e) {
+                Log(Warn, "Skipping emitter \"%s\" (%s): %s", config.plugin, config.name,
+                    e.what());
+                continue;
+            }
+            if (!emitter)
+                continue;
+
+            // Direction samples and the interactions on the emitter, for eval() and pdf()
+            std::vector<DirectionSample3f> ds(batch);
+            std::vector<SurfaceInteraction3f> si_e(batch);
+            for (size_t i = 0; i < batch; ++i) {
+                ds[i] = emitter->sample_direction(si[i], sample2[i]).first;
+                si_e[i] = SurfaceInteraction3f(ds[i], si[i].wavelengths);
+                si_e[i].wi = has_flag(emitter->flags(), EmitterFlags::Infinite)
+                                 ? -ds[i].d
+                                 : si_e[i].to_local(-ds[i].d);
+            }
+
+            const char *names[3] = { "sample_direction", "eval", "pdf_direction" };
+            double ns[3];
+
+            ns[0] = time_query(batch, passes, Width, repeat, [&](size_t i) {
+                auto [d, value] = emitter->sample_direction(si[i], sample2[i]);
+                consume(value);
+                sink += hsum(d.pdf);
+            });
+            ns[1] = time_query(batch, passes, Width, repeat, [&](size_t i) {
+                consume(emitter->eval(si_e[i]));
+            });
+            ns[2] = time_query(batch, passes, Width, repeat, [&](size_t i) {
+                sink += hsum(emitter->pdf_direction(si[i], ds[i]));
+            });
+
+            report(config, "emitter", names, ns);
+        }
+
+        if (!first_variant)
+            os << "," << std::endl;
+        os << "    \"" << mode << "\": {" << std::endl
+           << "      \"packet_size\": " << Width << "," << std::endl
+           << "      \"checksum\": " << (double) hsum(sink) << "," << std::endl
+           << "      \"results\": [" << std::endl;
+        for (size_t i = 0; i < results.size(); ++i)
+            os << "  " << results[i] << (i + 1 < results.size() ? "," : "") << std::endl;
+        os << "      ]" << std::endl
+           << "    }";
+    }
+}
+
+int main(int argc, char *argv[]) {
+    return harness::run_bench(argc, argv, help, [](ArgParser &parser) {
+        // Ensure that the mitsuba-render shared library is loaded
+        librender_nop();
+
+        auto arg_queries  = parser.add(harness::StringVec{ "-n", "--queries" }, true);
+        auto arg_measured = parser.add(harness::StringVec{ "-f", "--measured" }, true);
+        auto arg_output   = parser.add(harness::StringVec{ "-o", "--output" }, true);
+        auto arg_mode     = parser.add(harness::StringVec{ "-m", "--mode" }, true);
+        auto arg_extra    = parser.add("", true);
+
+        return [=](size_t repeat) {
+            std::string modes = *arg_mode ? arg_mode->as_string() : MTS_DEFAULT_VARIANT;
+            int queries = *arg_queries ? arg_queries->as_int() : 1000000;
+            if (queries < 1)
+                Throw("--queries: the query count must be >= 1!");
+
+            std::string measured = *arg_measured ? arg_measured->as_string() : "";
+
+            std::vector<std::string> filter = harness::extra_args(arg_extra);
+
+            // Only show the warnings and errors of the plugins
+            Thread::thread()->logger()->set_log_level(Warn);
+
+            harness::add_library_path();
+
+            /* Image used by the environment map, the projector and the normal
+               map (in place of a file that would need to be shipped) */
+            fs::path bitmap_path = fs::current_path() / "bench_shading_tmp.exr";
+            ref<Bitmap> bitmap = new Bitmap(Bitmap::PixelFormat::RGB, Struct::Type::Float32,
+                                            Vector2u(64, 32));
+            float *ptr = (float *) bitmap->data();
+            for (uint32_t y = 0; y < 32; ++y) {
+                for (uint32_t x = 0; x < 64; ++x) {
+                    *ptr++ = 0.5f + 0.4f * std::sin(x * 0.3f);
+                    *ptr++ = 0.5f + 0.4f * std::cos(y * 0.4f);
+                    *ptr++ = 1.f;
+                }
+            }
+            bitmap->write(bitmap_path);
+
+            try {
+                std::ofstream file;
+                if (*arg_output) {
+                    file.open(arg_output->as_string());
+                    if (!file.good())
+                        Throw("Could not open \"%s\"!", arg_output->as_string());
+                }
+                std::ostream &os = *arg_output ? file : std::cout;
+
+                os << "{" << std::endl
+                   << "  \"queries\": " << queries << "," << std::endl
+                   << "  \"repeat\": " << repeat << "," << std::endl
+#if defined(MTS_ENABLE_DEVIRTUALIZATION)
+                   << "  \"devirtualized\": true," << std::endl
+#else
+                   << "  \"devirtualized\": false," << std::endl
+#endif
+                   << "  \"variants\": {" << std::endl;
+
+                bool first = true;
+                for (const std::string &mode : string::tokenize(modes, ",")) {
+                    MTS_INVOKE_VARIANT(mode, bench, mode, filter, measured,
+                                       bitmap_path.string(), (size_t) queries, repeat, os, first);
+                    first = false;
+                }
+
+                os << std::endl << "  }" << std::endl << "}" << std::endl;
+            } catch (...) {
+                fs::remove(bitmap_path);
+                throw;
+            }
+            fs::remove(bitmap_path);
+            return 0;
+        };
+    });
+}
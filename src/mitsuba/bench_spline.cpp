@@ -0,0 +1,173 @@
+#include "bench_common.h"
+
+#include <mitsuba/core/distr_1d.h>
+#include <mitsuba/core/spline.h>
+#include <iomanip>
+#include <random>
+
+using namespace mitsuba;
+
+static void help() {
+    std::cout << R"(
+Usage: bench_spline [options]
+
+Evaluates and samples spline interpolants and continuous 1D distributions
+of a tabulated function, once with one scalar query at a time and once with
+the batched entry points that process the queries in SIMD packets, and
+prints the time of both along with the largest difference of their results.
+
+Options:
+
+    -h, --help
+        Display this help text.
+
+    -n <count>, --queries <count>
+        Number of queries per benchmark.
+
+        Default: 1000000
+
+    -s <count>, --size <count>
+        Number of entries of the tabulated function (per dimension in 2D).
+
+        Default: 256
+
+    -r <count>, --repeat <count>
+        Run every configuration <count> times and report the fastest run.
+
+)";
+}
+
+int main(int argc, char *argv[]) {
+    return harness::run_bench(argc, argv, help, [](ArgParser &parser) {
+        auto arg_queries = parser.add(harness::StringVec{ "-n", "--queries" }, true);
+        auto arg_size    = parser.add(harness::StringVec{ "-s", "--size" }, true);
+
+        return [=](size_t repeat) {
+            int count = *arg_queries ? arg_queries->as_int() : 1000000,
+                size  = *arg_size ? arg_size->as_int() : 256;
+
+            if (count < 1)
+                Throw("--queries: the query count must be >= 1!");
+            if (size < 4)
+                Throw("--size: the tabulated function needs at least 4 entries!");
+
+            // Tabulate a smooth positive function on irregularly spaced nodes
+            std::mt19937 rng(0);
+            std::uniform_real_distribution<float> uniform(0.f, 1.f);
+
+            std::vector<float> nodes(size), values(size), cdf(size),
+                               values_2d((size_t) size * size);
+            for (int i = 0; i < size; ++i) {
+                float t = i / float(size - 1);
+                nodes[i] = t * t;
+                values[i] = 1.5f + std::sin(10.f * t);
+            }
+            for (int i = 0; i < size * size; ++i)
+                values_2d[i] = values[i % size] * values[i / size];
+            spline::integrate_1d(0.f, 1.f, values.data(), (uint32_t) size, cdf.data());
+
+            ContinuousDistribution<float> distr(Vector<float, 2>(0.f, 1.f),
+                                                values.data(), size);
+            IrregularContinuousDistribution<float> distr_irr(nodes.data(), values.data(),
+                                                             size);
+
+            std::vector<float> xs(count), ys(count), out_query(count), out_batch(count);
+            for (int i = 0; i < count; ++i) {
+                xs[i] = uniform(rng);
+                ys[i] = uniform(rng);
+            }
+
+            std::cout << std::left
+                      << std::setw(22) << "benchmark"
+                      << std::setw(13) << "query [ms]"
+                      << std::setw(13) << "batch [ms]"
+                      << std::setw(10) << "speedup"
+                      << "max. error" << std::endl;
+
+            auto report = [&](const char *name, auto query, auto batch) {
+                float query_time = harness::best_time(repeat, [&]() {
+                    for (int i = 0; i < count; ++i)
+                        out_query[i] = query(xs[i], ys[i]);
+                });
+                float batch_time = harness::best_time(repeat, [&]() {
+                    batch(xs.data(), ys.data(), out_batch.data(), (size_t) count);
+                });
+
+                float error = 0.f;
+                for (int i = 0; i < count; ++i)
+                    error = std::max(error, std::abs(out_query[i] - out_batch[i]));
+
+                std::cout << std::left << std::fixed << std::setprecision(2)
+                          << std::setw(22) << name
+                          << std::setw(13) << query_time
+                          << std::setw(13) << batch_time
+                          << std::setw(10) << (query_time / batch_time)
+                          << std::scientific << error << std::endl;
+            };
+
+            report("eval_1d (uniform)",
+                [&](float x, float) {
+                    return spline::eval_1d(0.f, 1.f, values.data(), (uint32_t) size, x);
+                },
+                [&](const float *x, const float *, float *out, size_t n) {
+                    spline::eval_1d_batch(0.f, 1.f, values.data(), (uint32_t) size,
+                                          x, out, n);
+                });
+
+            report("eval_1d (irregular)",
+                [&](float x, float) {
+                    return spline::eval_1d(nodes.data(), values.data(), (uint32_t) size, x);
+                },
+                [&](const float *x, const float *, float *out, size_t n) {
+                    spline::eval_1d_batch(nodes.data(), values.data(), (uint32_t) size,
+                                          x, out, n);
+                });
+
+            report("sample_1d (uniform)",
+                [&](float x, float) {
+                    return std::get<0>(spline::sample_1d(0.f, 1.f, values.data(), cdf.data(),
+                                                         (uint32_t) size, x));
+                },
+                [&](const float *x, const float *, float *out, size_t n) {
+                    spline::sample_1d_batch(0.f, 1.f, values.data(), cdf.data(),
+                                            (uint32_t) size, x, out, (float *) nullptr,
+                                            (float *) nullptr, n);
+                });
+
+            report("eval_2d",
+                [&](float x, float y) {
+                    return spline::eval_2d(nodes.data(), (uint32_t) size, nodes.data(),
+                                           (uint32_t) size, values_2d.data(), x, y);
+                },
+                [&](const float *x, const float *y, float *out, size_t n) {
+                    spline::eval_2d_batch(nodes.data(), (uint32_t) size, nodes.data(),
+                                          (uint32_t) size, values_2d.data(), x, y, out, n);
+                });
+
+            report("distr.eval_pdf",
+                [&](float x, float) { return distr.eval_pdf(x); },
+                [&](const float *x, const float *, float *out, size_t n) {
+                    distr.eval_pdf_batch(x, out, n);
+                });
+
+            report("distr.sample",
+                [&](float x, float) { return distr.sample(x); },
+                [&](const float *x, const float *, float *out, size_t n) {
+                    distr.sample_batch(x, out, n);
+                });
+
+            report("distr_irr.eval_pdf",
+                [&](float x, float) { return distr_irr.eval_pdf(x); },
+                [&](const float *x, const float *, float *out, size_t n) {
+                    distr_irr.eval_pdf_batch(x, out, n);
+                });
+
+            report("distr_irr.sample",
+                [&](float x, float) { return distr_irr.sample(x); },
+                [&](const float *x, const float *, float *out, size_t n) {
+                    distr_irr.sample_batch(x, out, n);
+                });
+            return 0;
+        };
+    });
+}
@@ -0,0 +1,114 @@
+#include "bench_common.h"
+
+#include <mitsuba/core/tls.h>
+#include <tbb/blocked_range.h>
+#include <tbb/parallel_for.h>
+#include <tbb/task_scheduler_init.h>
+#include <iomanip>
+
+using namespace mitsuba;
+
+static void help() {
+    std::cout << R"(
+Usage: bench_tls [options]
+
+Measures the cost of accessing the entries of ThreadLocal objects and
+compares it to native thread_local variables, using one or several threads
+that each increment the entries of a set of TLS objects in turn.
+
+Options:
+
+    -h, --help
+        Display this help text.
+
+    -t <count>, --threads <count>
+        Access the entries from the specified number of threads.
+
+        Default: number of cores
+
+    -o <count>, --objects <count>
+        Number of TLS objects accessed in turn (at most 64).
+
+        Default: 8
+
+    -n <count>, --accesses <count>
+        Number of accesses per thread (in millions).
+
+        Default: 100
+
+    -r <count>, --repeat <count>
+        Run every configuration <count> times and report the fastest run.
+
+)";
+}
+
+static constexpr size_t MaxObjects = 64;
+static thread_local uint64_t native_entries[MaxObjects];
+
+/// Run 'func(accesses)' on 'thread_count' threads
+template <typename Func> void run(size_t thread_count, size_t accesses, Func func) {
+    tbb::parallel_for(
+        tbb::blocked_range<size_t>(0, thread_count, 1),
+        [&](const tbb::blocked_range<size_t> &range) {
+            for (size_t i = range.begin(); i != range.end(); ++i)
+                func(accesses);
+        }
+    );
+}
+
+int main(int argc, char *argv[]) {
+    return harness::run_bench(argc, argv, help, [](ArgParser &parser) {
+        auto arg_threads  = parser.add(harness::StringVec{ "-t", "--threads" }, true);
+        auto arg_objects  = parser.add(harness::StringVec{ "-o", "--objects" }, true);
+        auto arg_accesses = parser.add(harness::StringVec{ "-n", "--accesses" }, true);
+
+        return [=](size_t repeat) {
+            size_t thread_count = harness::thread_count(arg_threads);
+            int objects  = *arg_objects ? arg_objects->as_int() : 8,
+                accesses = *arg_accesses ? arg_accesses->as_int() : 100;
+
+            if (objects < 1 || objects > (int) MaxObjects)
+                Throw("--objects: the object count must be between 1 and %i!", MaxObjects);
+            if (accesses < 1)
+                Throw("--accesses: the access count must be >= 1!");
+
+            tbb::task_scheduler_init init((int) thread_count);
+            size_t thread_accesses = (size_t) accesses * 1000000;
+
+            std::vector<std::unique_ptr<ThreadLocal<uint64_t>>> tls(objects);
+            for (auto &t : tls)
+                t.reset(new ThreadLocal<uint64_t>());
+
+            auto bench_tls = [&](size_t n) {
+                for (size_t i = 0; i < n; ++i) {
+                    uint64_t &value = *tls[i % objects];
+                    ++value;
+                }
+            };
+
+            auto bench_native = [&](size_t n) {
+                for (size_t i = 0; i < n; ++i)
+                    ++native_entries[i % objects];
+            };
+
+            std::cout << std::left
+                      << std::setw(14) << "storage"
+                      << std::setw(11) << "time [ms]"
+                      << "ns/access" << std::endl;
+
+            auto report = [&](const char *name, auto func) {
+                float best_time = harness::best_time(repeat, [&]() {
+                    run(thread_count, thread_accesses, func);
+                });
+                std::cout << std::left << std::fixed << std::setprecision(2)
+                          << std::setw(14) << name
+                          << std::setw(11) << best_time
+                          << (best_time * 1e6 / thread_accesses) << std::endl;
+            };
+
+            report("ThreadLocal", bench_tls);
+            report("thread_local", bench_native);
+            return 0;
+        };
+    });
+}
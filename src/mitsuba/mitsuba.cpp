@@ -5,8 +5,11 @@
 #include <mitsuba/core/fstream.h>
 #include <mitsuba/core/jit.h>
 #include <mitsuba/core/logger.h>
+#include <mitsuba/core/memory.h>
 #include <mitsuba/core/profiler.h>
+#include <mitsuba/core/statistics.h>
 #include <mitsuba/core/thread.h>
+#include <mitsuba/core/timer.h>
 #include <mitsuba/core/util.h>
 #include <mitsuba/core/vector.h>
 #include <mitsuba/core/xml.h>
@@ -19,9 +22,18 @@
 #include <mitsuba/render/optix_api.h>
 #endif
 
+#if defined(MTS_ENABLE_ZMQ)
+#  include <mitsuba/core/zmq11.h>
+#endif
+
+#include <list>
+
 
 #if !defined(__WINDOWS__)
 #  include <signal.h>
+#  include <spawn.h>
+#  include <sys/wait.h>
+extern char **environ;
 #endif
 
 using namespace mitsuba;
@@ -50,9 +62,50 @@ Options:
     -v, --verbose
         Be more verbose. (can be specified multiple times)
 
+    --timeline <file>
+        Record the beginning and the end of the profiled phases (image
+        blocks, kd-tree construction, ..) on every thread, and write them
+        to <file> in the JSON trace event format, which can be opened with
+        chrome://tracing or Perfetto.
+
+    --perf-counters
+        Sample the hardware performance counters (cycles, instructions,
+        cache and branch misses) along with the profiled phases, and report
+        the instructions per cycle and the miss rates of every phase (Linux
+        only).
+
+    --profile-objects
+        Attribute the profiled phases to the plugin instances that run
+        them (e.g. the individual BSDFs and textures of the scene), and
+        report the 20 most expensive ones.
+
+    --load-profile
+        Only load the scene(s) and report the time taken by the individual
+        steps: plugin loading, XML parsing, the instantiation of every
+        object (with its ID and plugin type), mesh and texture loading,
+        and the acceleration data structure construction. The scene is
+        not rendered.
+
+    --stats-json <file>
+        Write a machine-readable report to <file> in JSON format, with the
+        loading time, acceleration data structure build time and memory,
+        render time of every pass, samples per second and ray counts of
+        every scene, followed by the profile and the peak memory usage of
+        the process. The ray counts require a build with the CMake option
+        MTS_ENABLE_STATISTICS, the profile one with MTS_ENABLE_PROFILER.
+
+    --async-log
+        Pass the log messages to the console on a background thread,
+        so that verbose logging does not slow down the rendering
+        threads. Debug and info messages may be dropped under load.
+
     -t <count>, --threads <count>
         Render with the specified number of threads.
 
+    -n, --numa
+        Pin the rendering threads to the NUMA nodes of the machine
+        (round-robin) and keep a copy of the kd-tree on each node.
+
     -D <key>=<value>, --define <key>=<value>
         Define a constant that can referenced as "$key"
         within the scene description.
@@ -61,23 +114,261 @@ Options:
         Index of the sensor to render with (following the declaration
         order in the scene file). Default value: 0.
 
+    -b, --batch
+        Render all sensors of the scene in a single job. The image of
+        the i-th sensor is written to "<filename>_<i>.exr".
+
+    --sweep <key>=<value1>,<value2>,..
+        Render the scene once for every value of the constant "$key"
+        (for every combination of values when specified multiple times).
+        The scene is only loaded once: the objects that are not affected
+        by a change are reused, and floating point parameters are updated
+        in place when possible. The image of the i-th configuration is
+        written to "<filename>_<i>.exr".
+
     -u, --update
         When specified, Mitsuba will update the scene's
         XML description to the latest version.
 
+    --xml-cache <directory>
+        Store the parsed scene descriptions in the given directory, which
+        skips the XML parsing stage when the same scene is loaded again.
+
+    --xml-dedup
+        Share identical BSDFs and textures (including RGB and spectrum
+        values) between their users instead of creating one object each.
+
     -a <path1>;<path2>;..
         Add one or more entries to the resource search path.
 
     -o <filename>, --output <filename>
         Write the output image to the file "filename".
+
+    -r, --resume
+        Resume an interrupted render from its checkpoint file (written
+        when the integrator's "checkpoint_interval" parameter is set).
+
+    -l <address>, --listen <address>
+        Distributed rendering: act as the master and hand out image
+        blocks to workers connecting to the given ZeroMQ address
+        (e.g. "tcp://*:5555"). The output image is written by the master.
+
+    -c <address>, --connect <address>
+        Distributed rendering: act as a worker and render image blocks
+        for the master at the given address (e.g. "tcp://host:5555").
+        The same scene must be specified as on the master.
+
+    --server <address>
+        Render server: keep the process and the loaded scenes resident and
+        render the requests received on the given ZeroMQ address (e.g.
+        "tcp://*:5556"). A request is a multipart message with the scene
+        file, the output file (may be empty) and any number of "key=value"
+        parameter overrides. The reply is "ok <seconds>" or "error <message>".
+        The request "shutdown" stops the server.
+
+    --server-cache <count>
+        Number of loaded scenes kept by the render server (least recently
+        used first out). Scenes with different parameters count as
+        different scenes. Default value: 4.
+
+    --devices <count>
+        GPU variants: render with <count> GPUs. One process is started
+        per GPU (selected through CUDA_VISIBLE_DEVICES), which loads its
+        own copy of the scene and renders a slice of the image rows. The
+        slices are merged into the output image by the first process.
 )";
 }
 
+/// Figures of the last rendering, reported by --stats-json
+struct RenderReport {
+    /// Time taken by Integrator::render() (in seconds)
+    float render_time = 0.f;
+    /// Number of samples rendered (sampling integrators only)
+    size_t samples = 0;
+    /// Duration of the passes (see SamplingIntegrator::pass_times())
+    std::vector<float> pass_times;
+};
+
+static RenderReport render_report;
+
+/// Entry of a scene in the report of --stats-json
+struct SceneReport {
+    std::string filename;
+    /// Loading and acceleration build time (in seconds)
+    float load_time = 0.f, accel_time = 0.f;
+    /// Peak memory of the kd-tree (see MemoryAccounting)
+    size_t accel_memory = 0;
+    bool rendered = false;
+    /// Time of the rendering, including the development of the film
+    float total_render_time = 0.f;
+    RenderReport render;
+    uint64_t rays = 0, shadow_rays = 0;
+};
+
+static std::string json_escape(const std::string &str) {
+    std::string result;
+    for (char c : str) {
+        if (c == '"' || c == '\\')
+            result += '\\';
+        result += c;
+    }
+    return result;
+}
+
+static void write_stats_json(const fs::path &filename, const std::string &mode,
+                             const std::vector<SceneReport> &scenes) {
+    std::ostringstream oss;
+    oss << "{" << std::endl
+        << "  \"variant\": \"" << mode << "\"," << std::endl
+        << "  \"threads\": " << __global_thread_count << "," << std::endl
+        << "  \"scenes\": [";
+    for (size_t i = 0; i < scenes.size(); ++i) {
+        const SceneReport &scene = scenes[i];
+        const RenderReport &render = scene.render;
+        oss << (i > 0 ? "," : "") << std::endl
+            << "    {" << std::endl
+            << "      \"file\": \"" << json_escape(scene.filename) << "\"," << std::endl
+            << "      \"load_time\": " << scene.load_time << "," << std::endl
+            << "      \"accel_build_time\": " << scene.accel_time << "," << std::endl
+            << "      \"accel_memory\": " << scene.accel_memory << "," << std::endl
+            << "      \"rendered\": " << (scene.rendered ? "true" : "false") << "," << std::endl
+            << "      \"total_render_time\": " << scene.total_render_time << "," << std::endl
+            << "      \"render_time\": " << render.render_time << "," << std::endl
+            << "      \"pass_times\": [";
+        for (size_t j = 0; j < render.pass_times.size(); ++j)
+            oss << (j > 0 ? ", " : "") << render.pass_times[j];
+        oss << "]," << std::endl
+            << "      \"samples\": " << render.samples << "," << std::endl
+            << "      \"samples_per_second\": "
+            << (render.render_time > 0.f ? render.samples / render.render_time : 0.f)
+            << "," << std::endl;
+        if (Statistics::enabled())
+            oss << "      \"rays\": " << scene.rays << "," << std::endl
+                << "      \"shadow_rays\": " << scene.shadow_rays << std::endl;
+        else
+            oss << "      \"rays\": null," << std::endl
+                << "      \"shadow_rays\": null" << std::endl;
+        oss << "    }";
+    }
+    oss << std::endl << "  ]," << std::endl << "  \"profile\": {";
+
+    // Share of the profiler samples of every phase (empty without MTS_ENABLE_PROFILER)
+    auto profile = Profiler::flat_profile();
+    for (size_t i = 0; i < profile.size(); ++i)
+        oss << (i > 0 ? "," : "") << std::endl
+            << "    \"" << profile[i].first << "\": " << profile[i].second;
+    oss << (profile.empty() ? "" : "\n  ") << "}," << std::endl
+        << "  \"peak_memory\": " << util::peak_memory_usage() << std::endl
+        << "}" << std::endl;
+
+    ref<FileStream> stream = new FileStream(filename, FileStream::ETruncReadWrite);
+    std::string str = oss.str();
+    stream->write(str.data(), str.size());
+    stream->close();
+    Log(Info, "Wrote the render statistics to \"%s\".", filename.string());
+}
+
 std::function<void(void)> develop_callback;
 std::mutex develop_callback_mutex;
 
+/// Processes rendering the other slices of the image (see --devices)
+#if !defined(__WINDOWS__)
+std::vector<pid_t> slice_processes;
+#endif
+
+/// File storing the film state of an image slice rendered by another process
+static fs::path slice_filename(const fs::path &filename, uint32_t slice_index) {
+    fs::path result = filename;
+    result.replace_extension();
+    return fs::path(result.string() + tfm::format("_slice%i.mtsfilm", slice_index));
+}
+
+/**
+ * Wait for the processes started by spawn_slice_processes() (after
+ * terminating them if \c terminate is set), returns \c true if all succeeded
+ */
+static bool wait_slice_processes(bool terminate = false) {
+    bool success = true;
+#if !defined(__WINDOWS__)
+    for (pid_t pid : slice_processes) {
+        if (terminate)
+            kill(pid, SIGTERM);
+        int status = 0;
+        if (waitpid(pid, &status, 0) != pid || !WIFEXITED(status) ||
+            WEXITSTATUS(status) != 0)
+            success = false;
+    }
+    slice_processes.clear();
+#else
+    ENOKI_MARK_USED(terminate);
+#endif
+    return success;
+}
+
+/**
+ * Start one process per additional GPU, which renders the slice i/count of
+ * the image with the same command line. The current process is restricted
+ * to the first GPU and renders the first slice.
+ */
+static void spawn_slice_processes(int argc, char *argv[], uint32_t count) {
+#if !defined(__WINDOWS__)
+    // GPUs visible to this process (all of them unless restricted by the user)
+    std::vector<std::string> devices;
+    if (const char *visible = getenv("CUDA_VISIBLE_DEVICES"))
+        devices = string::tokenize(visible, ",");
+    else
+        for (uint32_t i = 0; i < count; ++i)
+            devices.push_back(std::to_string(i));
+    if (devices.size() < count)
+        Throw("--devices: only %i devices are visible (CUDA_VISIBLE_DEVICES)!",
+              devices.size());
+
+    std::vector<std::string> env;
+    for (char **e = environ; *e; ++e) {
+        if (!string::starts_with(*e, "CUDA_VISIBLE_DEVICES="))
+            env.push_back(*e);
+    }
+
+    for (uint32_t i = 1; i < count; ++i) {
+        std::vector<std::string> args(argv, argv + argc);
+        args.push_back("--device-slice");
+        args.push_back(tfm::format("%i/%i", i, count));
+
+        std::vector<std::string> envs = env;
+        envs.push_back("CUDA_VISIBLE_DEVICES=" + devices[i]);
+
+        auto c_strings = [](std::vector<std::string> &v) {
+            std::vector<char *> result;
+            for (std::string &str : v)
+                result.push_back(&str[0]);
+            result.push_back(nullptr);
+            return result;
+        };
+        std::vector<char *> c_args = c_strings(args), c_envs = c_strings(envs);
+
+        pid_t pid;
+        if (posix_spawn(&pid, "/proc/self/exe", nullptr, nullptr, c_args.data(), c_envs.data()) != 0 &&
+            posix_spawnp(&pid, argv[0], nullptr, nullptr, c_args.data(), c_envs.data()) != 0)
+            Throw("--devices: could not start the process for slice %i!", i);
+        slice_processes.push_back(pid);
+    }
+
+    setenv("CUDA_VISIBLE_DEVICES", devices[0].c_str(), 1);
+    std::string device_list = devices[0];
+    for (uint32_t i = 1; i < count; ++i)
+        device_list += ", " + devices[i];
+    Log(Info, "Rendering with %i GPUs (devices %s).", count, device_list);
+#else
+    ENOKI_MARK_USED(argc);
+    ENOKI_MARK_USED(argv);
+    ENOKI_MARK_USED(count);
+    Throw("--devices is not supported on Windows!");
+#endif
+}
+
 template <typename Float, typename Spectrum>
-bool render(Object *scene_, size_t sensor_i, filesystem::path filename) {
+bool render(Object *scene_, size_t sensor_i, filesystem::path filename, bool resume,
+            uint32_t slice_index, uint32_t slice_count) {
     auto *scene = dynamic_cast<Scene<Float, Spectrum> *>(scene_);
     if (!scene)
         Throw("Root element of the input file must be a <scene> tag!");
@@ -93,15 +384,141 @@ bool render(Object *scene_, size_t sensor_i, filesystem::path filename) {
     if (!integrator)
         Throw("No integrator specified for scene: %s", scene);
 
+    auto *sampling_integrator =
+        dynamic_cast<SamplingIntegrator<Float, Spectrum> *>(integrator.get());
+    if (sampling_integrator) {
+        fs::path checkpoint = sampling_integrator->checkpoint_file();
+        if (checkpoint.empty()) {
+            checkpoint = filename;
+            checkpoint.replace_extension("mtsckpt");
+        }
+        sampling_integrator->set_checkpoint(checkpoint, resume);
+        sampling_integrator->set_device_slice(slice_index, slice_count);
+    } else if (resume) {
+        Log(Warn, "The integrator does not support checkpoints, ignoring --resume.");
+    }
+
+    if (slice_count > 1 && !sampling_integrator)
+        Throw("--devices requires a sampling-based integrator!");
+    if (slice_count > 1 && film->streaming())
+        Throw("--devices is not supported by films that are written while rendering!");
+
     /* critical section */ {
         std::lock_guard<std::mutex> guard(develop_callback_mutex);
-        develop_callback = [&]() { film->develop(); };
+        develop_callback = [&]() {
+            if (film->streaming())
+                Log(Warn, "The film is written while rendering, cannot develop it early.");
+            else
+                film->develop();
+        };
     }
+    Timer render_timer;
     bool success = integrator->render(scene, sensor.get());
+    render_report.render_time = render_timer.value_in<std::chrono::microseconds>() * 1e-6f;
+    if (sampling_integrator) {
+        render_report.samples = sampling_integrator->samples_done();
+        render_report.pass_times = sampling_integrator->pass_times();
+    }
     /* critical section */ {
         std::lock_guard<std::mutex> guard(develop_callback_mutex);
         develop_callback = nullptr;
     }
+
+    if (slice_count > 1) {
+        if (slice_index != 0) {
+            // Hand the film state over to the first process
+            if (success) {
+                fs::path tmp_file = slice_filename(filename, slice_index);
+                tmp_file.replace_extension(".tmp");
+                ref<FileStream> stream = new FileStream(tmp_file, FileStream::ETruncReadWrite);
+                film->write_state(stream);
+                stream->close();
+                if (!fs::rename(tmp_file, slice_filename(filename, slice_index)))
+                    Throw("Could not write the film state of slice %i!", slice_index);
+            }
+            return success;
+        }
+
+        // Merge the film states of the other slices
+        success = wait_slice_processes() && success;
+        for (uint32_t i = 1; i < slice_count; ++i) {
+            fs::path slice_file = slice_filename(filename, i);
+            if (!fs::exists(slice_file))
+                continue;
+            if (success) {
+                ref<FileStream> stream = new FileStream(slice_file, FileStream::ERead);
+                film->read_state(stream, true);
+            }
+            fs::remove(slice_file);
+        }
+    }
+
+    if (success)
+        film->develop();
+    else
+        Log(Warn, "\U0000274C Rendering failed, result not saved.");
+    return success;
+}
+
+template <typename Float, typename Spectrum>
+bool render_batch(Object *scene_, filesystem::path filename) {
+    auto *scene = dynamic_cast<Scene<Float, Spectrum> *>(scene_);
+    if (!scene)
+        Throw("Root element of the input file must be a <scene> tag!");
+
+    auto integrator = scene->integrator();
+    if (!integrator)
+        Throw("No integrator specified for scene: %s", scene);
+
+    // Sensor i writes to "<filename>_<i>.exr"
+    std::vector<Sensor<Float, Spectrum> *> sensors;
+    for (size_t i = 0; i < scene->sensors().size(); ++i) {
+        auto sensor = scene->sensors()[i];
+        fs::path sensor_filename = filename;
+        sensor_filename.replace_extension();
+        sensor_filename = fs::path(sensor_filename.string() + tfm::format("_%i.exr", i));
+        sensor->film()->set_destination_file(sensor_filename);
+        sensors.push_back(sensor.get());
+    }
+
+    Timer render_timer;
+    bool success = integrator->render_batch(scene, sensors);
+    render_report.render_time = render_timer.value_in<std::chrono::microseconds>() * 1e-6f;
+    if (auto *sampling_integrator =
+            dynamic_cast<SamplingIntegrator<Float, Spectrum> *>(integrator.get()))
+        render_report.samples = sampling_integrator->samples_done();
+    if (success) {
+        for (auto *sensor : sensors)
+            sensor->film()->develop();
+    } else {
+        Log(Warn, "\U0000274C Rendering failed, result not saved.");
+    }
+    return success;
+}
+
+template <typename Float, typename Spectrum>
+bool render_distributed(Object *scene_, size_t sensor_i, filesystem::path filename,
+                        const std::string &address, bool master) {
+    auto *scene = dynamic_cast<Scene<Float, Spectrum> *>(scene_);
+    if (!scene)
+        Throw("Root element of the input file must be a <scene> tag!");
+    if (sensor_i >= scene->sensors().size())
+        Throw("Specified sensor index is out of bounds!");
+    auto sensor = scene->sensors()[sensor_i];
+
+    auto *integrator =
+        dynamic_cast<SamplingIntegrator<Float, Spectrum> *>(scene->integrator());
+    if (!integrator)
+        Throw("Distributed rendering requires a sampling-based integrator!");
+
+    if (!master)
+        return integrator->render_worker(scene, sensor.get(), address);
+
+    auto film = sensor->film();
+    filename.replace_extension("exr");
+    film->set_destination_file(filename);
+
+    bool success = integrator->render_master(scene, sensor.get(), address);
     if (success)
         film->develop();
     else
@@ -109,6 +526,149 @@ bool render(Object *scene_, size_t sensor_i, filesystem::path filename) {
     return success;
 }
 
+/**
+ * Render server (see --server): answer render requests on \c address until
+ * a "shutdown" request is received. The \c cache_size most recently used
+ * scenes are kept in memory, keyed by their file name and parameters.
+ */
+static void run_server(const std::string &address, const std::string &mode,
+                       const xml::ParameterList &base_params, size_t sensor_i,
+                       size_t cache_size, FileResolver *fr) {
+#if defined(MTS_ENABLE_ZMQ)
+    zmq::context context;
+    zmq::socket socket(context, zmq::socket::rep);
+    socket.setsockopt(ZMQ_LINGER, 0);
+    socket.bind(address);
+    Log(Info, "Render server listening on \"%s\" (caching up to %i scene%s) ..",
+        address, cache_size, cache_size == 1 ? "" : "s");
+
+    // Loaded scenes, most recently used first
+    std::list<std::pair<std::string, ref<Object>>> cache;
+    ref<Thread> thread = Thread::thread();
+
+    while (true) {
+        std::vector<std::string> request;
+        do {
+            std::string frame;
+            socket.recv(frame);
+            request.push_back(frame);
+        } while (socket.more());
+
+        if (request.size() == 1 && request[0] == "shutdown") {
+            socket.send(std::string("ok"));
+            break;
+        }
+
+        std::string reply;
+        try {
+            if (request.size() < 2)
+                Throw("Expected a request with the scene file, the output file and "
+                      "the parameters!");
+
+            fs::path scene_file(request[0]), filename(request[1]);
+            if (filename.empty())
+                filename = scene_file;
+
+            xml::ParameterList params = base_params;
+            std::string key = request[0];
+            for (size_t i = 2; i < request.size(); ++i) {
+                auto sep = request[i].find('=');
+                if (sep == std::string::npos)
+                    Throw("Parameter \"%s\": expected a key=value pair!", request[i]);
+                params.emplace_back(request[i].substr(0, sep), request[i].substr(sep + 1));
+                key += "\n" + request[i];
+            }
+
+            // Resolve the resources of the scene relative to its directory
+            ref<FileResolver> fr2 = new FileResolver(*fr);
+            fs::path scene_dir = scene_file.parent_path();
+            if (!fr2->contains(scene_dir))
+                fr2->append(scene_dir);
+            thread->set_file_resolver(fr2);
+
+            auto it = std::find_if(cache.begin(), cache.end(),
+                                   [&](const auto &entry) { return entry.first == key; });
+            if (it != cache.end()) {
+                cache.splice(cache.begin(), cache, it);
+            } else {
+                Timer load_timer;
+                ref<Object> parsed = xml::load_file(scene_file, mode, params);
+                Log(Info, "Loaded \"%s\" in %s.", scene_file.string(),
+                    util::time_string(load_timer.value(), true));
+                cache.emplace_front(key, parsed);
+                if (cache.size() > cache_size)
+                    cache.pop_back();
+            }
+
+            Timer render_timer;
+            bool success = MTS_INVOKE_VARIANT(mode, render, cache.front().second.get(),
+                                              sensor_i, filename, false, 0u, 1u);
+            if (!success)
+                Throw("Rendering failed!");
+            reply = tfm::format("ok %.3f", render_timer.value() / 1000.f);
+        } catch (const std::exception &e) {
+            Log(Warn, "Render request failed: %s", e.what());
+            reply = std::string("error ") + e.what();
+        }
+        thread->set_file_resolver(fr);
+        socket.send(reply);
+    }
+    Log(Info, "Render server shut down.");
+#else
+    ENOKI_MARK_USED(address);
+    ENOKI_MARK_USED(mode);
+    ENOKI_MARK_USED(base_params);
+    ENOKI_MARK_USED(sensor_i);
+    ENOKI_MARK_USED(cache_size);
+    ENOKI_MARK_USED(fr);
+    Throw("--server: Mitsuba was compiled without ZeroMQ support (MTS_ENABLE_ZMQ).");
+#endif
+}
+
+/**
+ * Parameter sweep (see --sweep): load \c scene_file once per configuration of
+ * \c sweep (the cartesian product of the values of every key), reusing the
+ * objects of the previous configuration that did not change, and write the
+ * image of the i-th configuration to "<filename>_<i>.exr".
+ */
+static bool render_sweep(const fs::path &scene_file, fs::path filename,
+                         const std::string &mode, const xml::ParameterList &base_params,
+                         const std::vector<std::pair<std::string, std::vector<std::string>>> &sweep,
+                         size_t sensor_i) {
+    size_t config_count = 1;
+    for (const auto &[key, values] : sweep)
+        config_count *= values.size();
+
+    filename.replace_extension();
+    ref<xml::InstanceCache> cache = new xml::InstanceCache();
+    bool success = true;
+
+    for (size_t i = 0; i < config_count; ++i) {
+        // The first key varies the slowest
+        xml::ParameterList params = base_params;
+        std::string description;
+        size_t index = i;
+        for (auto it = sweep.rbegin(); it != sweep.rend(); ++it) {
+            const std::string &value = it->second[index % it->second.size()];
+            index /= it->second.size();
+            params.emplace_back(it->first, value);
+            description = it->first + "=" + value + (description.empty() ? "" : ", ") + description;
+        }
+        Log(Info, "Sweep configuration %i/%i: %s", i + 1, config_count, description);
+
+        Timer load_timer;
+        ref<Object> parsed = xml::load_file(scene_file, mode, params, false, cache.get());
+        Log(Info, "Loaded configuration %i in %s (%i objects reused, %i updated, %i created).",
+            i + 1, util::time_string(load_timer.value(), true), cache->reused(),
+            cache->updated(), cache->created());
+
+        fs::path config_filename(filename.string() + tfm::format("_%i.exr", i));
+        success &= MTS_INVOKE_VARIANT(mode, render, parsed.get(), sensor_i,
+                                      config_filename, false, 0u, 1u);
+    }
+    return success;
+}
+
 #if !defined(__WINDOWS__)
 // Handle the hang-up signal and write a partially rendered image to disk
 void hup_signal_handler(int signal) {
@@ -134,16 +694,35 @@ int main(int argc, char *argv[]) {
     ArgParser parser;
     using StringVec    = std::vector<std::string>;
     auto arg_threads   = parser.add(StringVec{ "-t", "--threads" }, true);
+    auto arg_numa      = parser.add(StringVec{ "-n", "--numa" }, false);
     auto arg_verbose   = parser.add(StringVec{ "-v", "--verbose" }, false);
+    auto arg_async_log = parser.add(StringVec{ "--async-log" }, false);
+    auto arg_timeline  = parser.add(StringVec{ "--timeline" }, true);
+    auto arg_perf      = parser.add(StringVec{ "--perf-counters" }, false);
+    auto arg_objects   = parser.add(StringVec{ "--profile-objects" }, false);
+    auto arg_load_prof = parser.add(StringVec{ "--load-profile" }, false);
+    auto arg_stats     = parser.add(StringVec{ "--stats-json" }, true);
     auto arg_define    = parser.add(StringVec{ "-D", "--define" }, true);
     auto arg_sensor_i  = parser.add(StringVec{ "-s", "--sensor" }, true);
     auto arg_output    = parser.add(StringVec{ "-o", "--output" }, true);
     auto arg_update    = parser.add(StringVec{ "-u", "--update" }, false);
+    auto arg_xml_cache = parser.add(StringVec{ "--xml-cache" }, true);
+    auto arg_xml_dedup = parser.add(StringVec{ "--xml-dedup" }, false);
+    auto arg_batch     = parser.add(StringVec{ "-b", "--batch" }, false);
+    auto arg_resume    = parser.add(StringVec{ "-r", "--resume" }, false);
+    auto arg_listen    = parser.add(StringVec{ "-l", "--listen" }, true);
+    auto arg_connect   = parser.add(StringVec{ "-c", "--connect" }, true);
+    auto arg_server    = parser.add(StringVec{ "--server" }, true);
+    auto arg_srv_cache = parser.add(StringVec{ "--server-cache" }, true);
+    auto arg_sweep     = parser.add(StringVec{ "--sweep" }, true);
+    auto arg_devices   = parser.add(StringVec{ "--devices" }, true);
+    auto arg_slice     = parser.add(StringVec{ "--device-slice" }, true);
     auto arg_help      = parser.add(StringVec{ "-h", "--help" });
     auto arg_mode      = parser.add(StringVec{ "-m", "--mode" }, true);
     auto arg_paths     = parser.add(StringVec{ "-a" }, true);
     auto arg_extra     = parser.add("", true);
     bool print_profile = false;
+    std::vector<SceneReport> scene_reports;
     xml::ParameterList params;
     std::string error_msg;
 
@@ -169,6 +748,30 @@ int main(int argc, char *argv[]) {
                 logger->set_log_level(Debug);
         }
 
+        if (*arg_async_log)
+            Thread::thread()->logger()->set_async(true);
+
+        if (*arg_timeline) {
+            Profiler::set_timeline(true);
+            if (!Profiler::timeline())
+                Log(Warn, "--timeline: Mitsuba was compiled without support for the profiler!");
+        }
+
+        if (*arg_perf)
+            Profiler::set_hardware_counters(true);
+
+        if (*arg_objects)
+            Profiler::set_object_attribution(true);
+
+        if (*arg_load_prof)
+            LoadProfiler::set_enabled(true);
+
+        if (*arg_xml_cache)
+            xml::set_cache_dir(arg_xml_cache->as_string());
+
+        if (*arg_xml_dedup)
+            xml::set_deduplication(true);
+
         while (arg_define && *arg_define) {
             std::string value = arg_define->as_string();
             auto sep = value.find('=');
@@ -180,8 +783,50 @@ int main(int argc, char *argv[]) {
         }
         std::string mode = (*arg_mode ? arg_mode->as_string() : MTS_DEFAULT_VARIANT);
 
+        std::vector<std::pair<std::string, std::vector<std::string>>> sweep;
+        while (arg_sweep && *arg_sweep) {
+            std::string value = arg_sweep->as_string();
+            auto sep = value.find('=');
+            if (sep == std::string::npos)
+                Throw("--sweep: expect key=value1,value2,.. pair!");
+            auto values = string::tokenize(value.substr(sep + 1), ",");
+            if (values.empty())
+                Throw("--sweep: no values specified for \"%s\"!", value.substr(0, sep));
+            sweep.emplace_back(value.substr(0, sep), values);
+            arg_sweep = arg_sweep->next();
+        }
+        if (!sweep.empty() && (*arg_listen || *arg_connect || *arg_batch ||
+                               *arg_resume || *arg_server || *arg_devices))
+            Throw("--sweep cannot be combined with --listen, --connect, --batch, "
+                  "--resume, --server or --devices!");
+
+        /* Multi-GPU rendering: the processes of the other GPUs must be started
+           (and the device of this one selected) before CUDA is initialized */
+        uint32_t slice_index = 0, slice_count = 1;
+        if (*arg_slice) {
+            auto tokens = string::tokenize(arg_slice->as_string(), "/");
+            if (tokens.size() != 2)
+                Throw("--device-slice: expected <index>/<count>!");
+            slice_index = (uint32_t) std::stoul(tokens[0]);
+            slice_count = (uint32_t) std::stoul(tokens[1]);
+        } else if (*arg_devices) {
+            slice_count = (uint32_t) arg_devices->as_int();
+            if (slice_count < 1)
+                Throw("--devices: the device count must be >= 1!");
+            if (!string::starts_with(mode, "gpu"))
+                Throw("--devices requires a GPU variant!");
+            if (*arg_listen || *arg_connect || *arg_batch)
+                Throw("--devices cannot be combined with --listen, --connect or --batch!");
+            if (*arg_extra && arg_extra->next())
+                Throw("--devices only supports a single scene file!");
+            if (slice_count > 1)
+                spawn_slice_processes(argc, argv, slice_count);
+        }
+
 #if defined(MTS_ENABLE_OPTIX)
         if (string::starts_with(mode, "gpu")) {
+            // Must precede the initialization of the CUDA driver by cie_alloc()
+            cuda_configure_cache();
             cie_alloc();
             optix_initialize();
         }
@@ -194,6 +839,14 @@ int main(int argc, char *argv[]) {
             __global_thread_count = arg_threads->as_int();
         if (__global_thread_count < 1)
             Throw("Thread count must be >= 1!");
+
+        // Must be set before the TBB worker threads are created
+        if (*arg_numa) {
+            if (Thread::numa_node_count() > 1)
+                Thread::set_numa_pinning(true);
+            else
+                Log(Warn, "No NUMA nodes detected, ignoring --numa.");
+        }
         tbb::task_scheduler_init init((int) __global_thread_count);
 
         // Append the mitsuba directory to the FileResolver search path list
@@ -212,7 +865,7 @@ int main(int argc, char *argv[]) {
             }
         }
 
-        if (!*arg_extra || *arg_help) {
+        if ((!*arg_extra && !*arg_server) || *arg_help) {
             help((int) __global_thread_count);
         } else {
             Log(Info, "%s", util::info_build((int) __global_thread_count));
@@ -224,6 +877,18 @@ int main(int argc, char *argv[]) {
 #endif
         }
 
+        if (*arg_server && !*arg_help) {
+            if (*arg_extra)
+                Throw("--server does not accept scene files, they are specified "
+                      "by the render requests!");
+            int cache_size = *arg_srv_cache ? arg_srv_cache->as_int() : 4;
+            if (cache_size < 1)
+                Throw("--server-cache: the cache size must be >= 1!");
+            run_server(arg_server->as_string(), mode, params, sensor_i,
+                       (size_t) cache_size, fr);
+            print_profile = true;
+        }
+
         while (arg_extra && *arg_extra) {
             filesystem::path filename(arg_extra->as_string());
             ref<FileResolver> fr2 = new FileResolver(*fr);
@@ -237,18 +902,85 @@ int main(int argc, char *argv[]) {
             if (*arg_output)
                 filename = arg_output->as_string();
 
+            // The acceleration build time of --stats-json is taken from the load profile
+            if (*arg_stats) {
+                LoadProfiler::set_enabled(true);
+                MemoryAccounting::reset_peak();
+                Statistics::reset();
+                render_report = RenderReport();
+            }
+
+            if (!sweep.empty()) {
+                print_profile = render_sweep(arg_extra->as_string(), filename, mode,
+                                             params, sweep, sensor_i) || print_profile;
+                arg_extra = arg_extra->next();
+                continue;
+            }
+
             // Try and parse a scene from the passed file.
+            Timer load_timer;
             ref<Object> parsed =
                 xml::load_file(arg_extra->as_string(), mode, params, *arg_update);
 
-            bool success = MTS_INVOKE_VARIANT(mode, render, parsed.get(),
-                                              sensor_i, filename);
+            SceneReport scene_report;
+            scene_report.filename = arg_extra->as_string();
+            scene_report.load_time = load_timer.value_in<std::chrono::microseconds>() * 1e-6f;
+            scene_report.accel_time = (float) LoadProfiler::total(LoadEvent::BuildAccel);
+            scene_report.accel_memory = MemoryAccounting::peak(MemoryCategory::KDTree);
+
+            if (*arg_load_prof) {
+                Log(Info, "Loaded \"%s\" in %s.", arg_extra->as_string(),
+                    util::time_string(load_timer.value(), true));
+                LoadProfiler::print_report();
+                if (*arg_stats)
+                    scene_reports.push_back(scene_report);
+                arg_extra = arg_extra->next();
+                continue;
+            }
+
+            if (*arg_listen && *arg_connect)
+                Throw("--listen and --connect cannot be specified at the same time!");
+
+            Timer render_timer;
+            bool success;
+            if (*arg_listen)
+                success = MTS_INVOKE_VARIANT(mode, render_distributed, parsed.get(), sensor_i,
+                                             filename, arg_listen->as_string(), true);
+            else if (*arg_connect)
+                success = MTS_INVOKE_VARIANT(mode, render_distributed, parsed.get(), sensor_i,
+                                             filename, arg_connect->as_string(), false);
+            else if (*arg_batch)
+                success = MTS_INVOKE_VARIANT(mode, render_batch, parsed.get(), filename);
+            else
+                success = MTS_INVOKE_VARIANT(mode, render, parsed.get(),
+                                             sensor_i, filename, (bool) *arg_resume,
+                                             slice_index, slice_count);
             print_profile = print_profile || success;
+
+            if (*arg_stats) {
+                scene_report.rendered = success;
+                scene_report.total_render_time =
+                    render_timer.value_in<std::chrono::microseconds>() * 1e-6f;
+                scene_report.render = render_report;
+                scene_report.rays = Statistics::counter(StatsCounter::Rays);
+                scene_report.shadow_rays = Statistics::counter(StatsCounter::ShadowRays);
+                scene_reports.push_back(scene_report);
+            }
             arg_extra = arg_extra->next();
         }
+
+        if (*arg_stats)
+            write_stats_json(arg_stats->as_string(), mode, scene_reports);
+
+        if (Profiler::timeline()) {
+            Profiler::set_timeline(false);
+            Profiler::write_timeline(arg_timeline->as_string());
+        }
     } catch (const std::exception &e) {
+        wait_slice_processes(true);
         error_msg = std::string("Caught a critical exception: ") + e.what();
     } catch (...) {
+        wait_slice_processes(true);
         error_msg = std::string("Caught a critical exception of unknown type!");
     }
 
@@ -280,8 +1012,11 @@ int main(int argc, char *argv[]) {
     }
 
     Profiler::static_shutdown();
-    if (print_profile)
+    if (print_profile) {
         Profiler::print_report();
+        if (Statistics::enabled())
+            Statistics::print_report();
+    }
     Bitmap::static_shutdown();
     Logger::static_shutdown();
     Thread::static_shutdown();
@@ -194,6 +194,126 @@ def render(scene,
     return image
 
 
+def render_adjoint(scene,
+                   image_adjoint,
+                   optimizer: 'mitsuba.python.autodiff.Optimizer',
+                   spp: int = None,
+                   sensor_index=0):
+    """
+    Backpropagate the gradient of an objective function with respect to the
+    image of ``scene`` to the scene parameters using *path replay
+    backpropagation*.
+
+    Reverse-mode differentiation of :py:func:`render()` records the
+    computation graph of all samples, whose size grows with the number of
+    samples per pixel and the path length. This function instead renders the
+    image once without recording a graph, and then replays the same paths
+    using the ``sample_adjoint()`` method of the integrator, which propagates
+    the gradient of each path vertex right away. Its memory usage is
+    therefore independent of the path length. Only integrators implementing
+    ``sample_adjoint()`` (e.g. :ref:`path <integrator-path>`) are supported.
+
+    The gradients are accumulated in the parameters of ``optimizer`` and can
+    be used by a subsequent call to ``optimizer.step()``. The function returns
+    the (detached) image, which is equivalent to the result of
+    :py:func:`render()` for integrators without AOVs.
+
+    Parameter ``image_adjoint`` (``Float``):
+        Gradient of the objective function with respect to the image, with
+        the same layout as the output of :py:func:`render()`. It is
+        distributed evenly to the samples of each pixel, which is exact for a
+        box reconstruction filter.
+
+    Parameter ``optimizer`` (:py:class:`mitsuba.python.autodiff.Optimizer`):
+        The optimizer referencing the differentiable scene parameters, whose
+        gradients are disabled during the primal pass.
+
+    Parameter ``spp`` (``None`` or ``int``):
+        Number of samples per pixel, overriding the value that is specified
+        in the scene if not ``None``.
+
+    Parameter ``sensor_index`` (``int``):
+        When the scene contains more than one sensor/camera, this parameter
+        can be specified to select the desired sensor.
+    """
+    from mitsuba.core import (Float, UInt32, Vector2f,
+                              is_monochromatic, is_rgb, is_polarized)
+
+    if is_polarized:
+        raise Exception('render_adjoint(): polarized variants are not '
+                        'supported!')
+
+    sensor = scene.sensors()[sensor_index]
+    film = sensor.film()
+    sampler = sensor.sampler()
+    integrator = scene.integrator()
+    film_size = film.crop_size()
+    if spp is None:
+        spp = sampler.sample_count()
+
+    total_sample_count = ek.hprod(film_size) * spp
+    channel_count = 1 if is_monochromatic else 3
+
+    def sample_rays():
+        # Both passes must start from the same sampler state
+        sampler.seed(0, total_sample_count)
+
+        idx = ek.arange(UInt32, total_sample_count)
+        idx //= spp
+        scale = Vector2f(1.0 / film_size[0], 1.0 / film_size[1])
+        pos = Vector2f(Float(idx % int(film_size[0])),
+                       Float(idx // int(film_size[0])))
+        pos += sampler.next_2d()
+
+        rays, weights = sensor.sample_ray_differential(
+            time=0,
+            sample1=sampler.next_1d(),
+            sample2=pos * scale,
+            sample3=0
+        )
+        return idx, rays, ek.detach(weights)
+
+    def to_rgb(spec, wavelengths):
+        if is_monochromatic:
+            return [spec[0]]
+        elif is_rgb:
+            return spec
+        else:
+            from mitsuba.core import spectrum_to_xyz, xyz_to_srgb
+            return xyz_to_srgb(spectrum_to_xyz(spec, wavelengths))
+
+    # Primal pass, which does not record a computation graph
+    with optimizer.disable_gradients():
+        idx, rays, weights = sample_rays()
+        radiance, _, _ = integrator.sample(scene, sampler, rays)
+        radiance = ek.detach(radiance)
+
+    # Pull the adjoint of every pixel back to the radiance of its samples
+    spec = type(radiance)(radiance)
+    ek.set_requires_gradient(spec)
+    rgb = to_rgb(spec * weights, rays.wavelengths)
+    loss = Float(0)
+    for i in range(channel_count):
+        pixel_adjoint = ek.gather(image_adjoint, idx * channel_count + i)
+        loss += ek.hsum(rgb[i] * ek.detach(pixel_adjoint))
+    ek.backward(loss / spp)
+    adjoint = ek.gradient(spec)
+    del rgb, loss, spec
+
+    # Replay the paths while propagating the adjoint to the scene parameters
+    _, rays, _ = sample_rays()
+    integrator.sample_adjoint(scene, sampler, rays, None, radiance, adjoint)
+
+    # Reconstruct the primal image (box filter)
+    rgb = to_rgb(radiance * weights, rays.wavelengths)
+    image = ek.zero(Float, ek.hprod(film_size) * channel_count)
+    for i in range(channel_count):
+        ek.scatter_add(target=image, source=ek.detach(rgb[i]) / spp,
+                       index=idx * channel_count + i)
+
+    return image
+
+
 class Optimizer:
     """
     Base class of all gradient-based optimizers (currently SGD and Adam)
@@ -188,3 +188,55 @@ def traverse(node: 'mitsuba.core.Object') -> ParameterMap:
     node.traverse(cb)
 
     return ParameterMap(cb.properties, cb.hierarchy)
+
+
+def render_sequence(scene: 'mitsuba.render.Scene', frames,
+                    output: str = None, sensor_index: int = 0):
+    """
+    Render an animation sequence of the scene ``scene`` without reloading it.
+
+    Each element of ``frames`` is a dictionary that maps parameter keys (as
+    returned by :py:func:`mitsuba.python.util.traverse()`) to their value in
+    the corresponding frame, e.g. ``'PerspectiveCamera.to_world'``,
+    ``'instance.to_world'`` or ``'mesh.vertex_positions_buf'``. Parameters
+    that are not listed keep their value from the previous frame.
+
+    The modified objects are notified through
+    :py:meth:`~mitsuba.python.util.ParameterMap.update()` before each frame,
+    so that the scene only refreshes the parts of its acceleration data
+    structure affected by the change (e.g. the kd-tree of a modified shape
+    group, while the trees of untouched groups are reused).
+
+    Parameter ``output`` (``str``):
+        Optional format string (e.g. ``'frame_%03i.exr'``) specifying the
+        file names of the developed frames. When not specified, the frames are
+        returned as a list of bitmaps instead.
+
+    Parameter ``sensor_index`` (``int``):
+        Index of the sensor used to render the sequence.
+    """
+    params = traverse(scene)
+    sensor = scene.sensors()[sensor_index]
+    film = sensor.film()
+    integrator = scene.integrator()
+
+    bitmaps = []
+    for i, frame in enumerate(frames):
+        for key, value in frame.items():
+            if key not in params:
+                raise KeyError('render_sequence(): unknown parameter "%s" '
+                               'in frame %i' % (key, i))
+            params[key] = value
+        params.update()
+
+        if not integrator.render(scene, sensor):
+            raise RuntimeError('render_sequence(): rendering of frame %i '
+                               'was cancelled' % i)
+
+        if output is None:
+            bitmaps.append(film.bitmap())
+        else:
+            film.set_destination_file(output % i)
+            film.develop()
+
+    return bitmaps if output is None else None
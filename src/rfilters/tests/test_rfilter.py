@@ -134,3 +134,25 @@ def test09_resampler_filter_only(variant_scalar_rgb):
     assert ek.allclose(b[0], (G(0) * a[0] + G(1) * (a[1] + a[2])) / (G(0) + 2*G(1)))
     assert ek.allclose(b[1], (G(0) * a[1] + G(1) * (a[0] + a[2])) / (G(0) + 2*G(1)))
     assert ek.allclose(b[2], (G(0) * a[2] + G(1) * (a[0] + a[1])) / (G(0) + 2*G(1)))
+
+
+@pytest.mark.parametrize('name', ['gaussian', 'tent', 'lanczos'])
+def test10_sample(variant_scalar_rgb, name):
+    from mitsuba.core.xml import load_string
+    import numpy as np
+
+    f = load_string("<rfilter version='2.0.0' type='%s'/>" % name)
+    offsets, weights = zip(*[f.sample(u) for u in np.linspace(0, 1, 1001)[:-1]])
+    offsets, weights = np.array(offsets), np.array(weights)
+
+    assert np.all(np.abs(offsets) <= f.radius())
+    # Symmetric filters are sampled symmetrically
+    assert ek.allclose(np.mean(offsets), 0, atol=1e-3)
+    if name == 'lanczos':
+        # The negative lobes are sampled with a negative weight
+        assert np.any(weights < 0)
+        assert np.all(weights[np.abs(offsets) < 1] > 0)
+    else:
+        assert ek.allclose(weights, 1)
+    # The expected weight matches the normalized filter
+    assert ek.allclose(np.mean(weights), 1, atol=1e-2)
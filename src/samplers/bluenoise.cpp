@@ -0,0 +1,298 @@
+#include <mitsuba/core/profiler.h>
+#include <mitsuba/core/properties.h>
+#include <mitsuba/core/spectrum.h>
+#include <mitsuba/core/random.h>
+#include <mitsuba/core/qmc.h>
+#include <mitsuba/render/sampler.h>
+#include <enoki/dynamic.h>
+
+NAMESPACE_BEGIN(mitsuba)
+
+/**!
+
+.. _sampler-bluenoise:
+
+Blue noise sampler (:monosp:`bluenoise`)
+----------------------------------------
+
+.. pluginparameters::
+
+ * - sample_count
+   - |int|
+   - Number of samples per pixel. This value should be a power of two, and is otherwise
+     rounded up to the next one. (Default: 4)
+ * - seed
+   - |int|
+   - Seed offset (Default: 0)
+
+This plugin distributes the Monte Carlo error of the image as a blue noise in screen space,
+which is perceptually much more pleasant than the white noise of the other samplers at very
+low sample counts (1-4 samples per pixel), and typically looks like an image rendered with
+about twice as many samples. It is therefore well-suited for previews and interactive
+rendering.
+
+Following the idea of Heitz et al. :cite:`Heitz2019Low`, the samples of all pixels are
+drawn from a single Owen-scrambled Sobol' sequence (as in the :ref:`sobol <sampler-sobol>`
+sampler), which is then decorrelated between pixels using a tileable table. The table is
+the :math:`64\times 64` ranking of a blue noise dither mask built with the void-and-cluster
+method of Ulichney :cite:`Ulichney1993Void`, and every dimension of the samples of a pixel
+is toroidally shifted by the value of the table at the position of the pixel (using a
+different offset into the table for every dimension). Neighboring pixels thus receive
+very different samples for every given sample index, while the samples of every individual
+pixel remain stratified.
+
+Rather than optimizing the scrambling and ranking keys of the Sobol' sequence for a given
+integrand dimensionality as in the original method, this sampler uses the same blue noise
+mask for all dimensions. The blue noise distribution hence is best for the first dimensions
+of a path and in the regions where the integrand is smooth in screen space.
+
+The screen-space position of the samples is provided by the rendering algorithm
+(see :code:`Sampler::set_pixel()`). The sampler behaves like a randomized Sobol' sampler
+when this information is not available.
+
+ */
+
+NAMESPACE_BEGIN(detail)
+
+/// Resolution of the tileable blue noise mask of the blue noise sampler
+static constexpr uint32_t BlueNoiseRes = 64;
+
+/**
+ * \brief Build a tileable blue noise mask with values in <tt>(0, 1)</tt> using
+ * the void-and-cluster method
+ *
+ * The mask is computed once and then shared by all instances of the sampler.
+ */
+static const std::vector<float> &blue_noise_mask() {
+    static std::vector<float> mask = []() {
+        constexpr uint32_t res = BlueNoiseRes, n = res * res;
+        constexpr float sigma = 1.5f;
+
+        // Toroidal Gaussian filter that defines the energy of the pattern
+        std::vector<float> filter(n), energy(n, 0.f);
+        for (uint32_t y = 0; y < res; ++y) {
+            for (uint32_t x = 0; x < res; ++x) {
+                float dx = (float) std::min(x, res - x),
+                      dy = (float) std::min(y, res - y);
+                filter[y * res + x] = std::exp(-(dx * dx + dy * dy) / (2.f * sigma * sigma));
+            }
+        }
+
+        std::vector<uint8_t> pattern(n, 0);
+        auto toggle = [&](uint32_t i, bool value) {
+            pattern[i] = value;
+            float sign = value ? 1.f : -1.f;
+            uint32_t px = i % res, py = i / res;
+            for (uint32_t y = 0; y < res; ++y) {
+                const float *row = filter.data() + ((y + res - py) % res) * res;
+                for (uint32_t x = 0; x < res; ++x)
+                    energy[y * res + x] += sign * row[(x + res - px) % res];
+            }
+        };
+
+        // Find the set pixel with the highest energy, or the unset one with the lowest
+        auto tightest_cluster = [&]() {
+            uint32_t best = 0;
+            float best_energy = -math::Infinity<float>;
+            for (uint32_t i = 0; i < n; ++i) {
+                if (pattern[i] && energy[i] > best_energy) {
+                    best = i;
+                    best_energy = energy[i];
+                }
+            }
+            return best;
+        };
+
+        auto largest_void = [&]() {
+            uint32_t best = 0;
+            float best_energy = math::Infinity<float>;
+            for (uint32_t i = 0; i < n; ++i) {
+                if (!pattern[i] && energy[i] < best_energy) {
+                    best = i;
+                    best_energy = energy[i];
+                }
+            }
+            return best;
+        };
+
+        // Random initial binary pattern with 10% of set pixels
+        PCG32<uint32_t> rng;
+        uint32_t initial_count = n / 10;
+        for (uint32_t count = 0; count < initial_count; ) {
+            uint32_t i = rng.next_uint32_bounded(n);
+            if (!pattern[i]) {
+                toggle(i, true);
+                ++count;
+            }
+        }
+
+        // Move the pixels of the tightest cluster into the largest void until convergence
+        for (uint32_t it = 0; it < n; ++it) {
+            uint32_t cluster = tightest_cluster();
+            toggle(cluster, false);
+            uint32_t void_ = largest_void();
+            toggle(void_, true);
+            if (void_ == cluster)
+                break;
+        }
+
+        std::vector<uint32_t> rank(n);
+        std::vector<uint8_t> initial_pattern = pattern;
+        std::vector<float> initial_energy = energy;
+
+        // Rank the pixels of the initial pattern by removing the tightest clusters
+        for (uint32_t r = initial_count; r-- > 0; ) {
+            uint32_t cluster = tightest_cluster();
+            toggle(cluster, false);
+            rank[cluster] = r;
+        }
+
+        /* Rank the remaining pixels by filling the largest voids. Past half of
+           the pixels, this is equivalent to removing the tightest clusters of
+           unset pixels since the filter has a constant sum. */
+        pattern = initial_pattern;
+        energy = initial_energy;
+        for (uint32_t r = initial_count; r < n; ++r) {
+            uint32_t void_ = largest_void();
+            toggle(void_, true);
+            rank[void_] = r;
+        }
+
+        std::vector<float> result(n);
+        for (uint32_t i = 0; i < n; ++i)
+            result[i] = (rank[i] + .5f) / n;
+        return result;
+    }();
+
+    return mask;
+}
+
+NAMESPACE_END(detail)
+
+template <typename Float, typename Spectrum>
+class BlueNoiseSampler final : public Sampler<Float, Spectrum> {
+public:
+    MTS_IMPORT_BASE(Sampler, m_sample_count, m_base_seed, seeded,
+                    m_samples_per_wavefront, m_wavefront_size, m_sample_index,
+                    m_dimension_index, current_sample_index)
+    MTS_IMPORT_TYPES()
+
+    BlueNoiseSampler(const Properties &props = Properties()) : Base(props) {
+        // The stratification is only complete for power-of-two sample counts
+        ScalarUInt32 sample_count = math::round_to_power_of_two(m_sample_count);
+
+        if (m_sample_count != sample_count)
+            Log(Warn, "Sample count should be a power of two, rounding to %i", sample_count);
+
+        m_sample_count = sample_count;
+
+        const std::vector<float> &mask = detail::blue_noise_mask();
+        std::vector<ScalarFloat> values(mask.begin(), mask.end());
+        m_mask = DynamicBuffer<Float>::copy(values.data(), values.size());
+    }
+
+    ref<Sampler<Float, Spectrum>> clone() override {
+        BlueNoiseSampler *sampler        = new BlueNoiseSampler();
+        sampler->m_sample_count          = m_sample_count;
+        sampler->m_samples_per_wavefront = m_samples_per_wavefront;
+        sampler->m_base_seed             = m_base_seed;
+        return sampler;
+    }
+
+    void seed(uint64_t seed_offset, size_t wavefront_size) override {
+        Base::seed(seed_offset, wavefront_size);
+        m_pixel = zero<Point2u>();
+    }
+
+    void set_pixel(const Point2u &pixel) override {
+        m_pixel = pixel & (detail::BlueNoiseRes - 1);
+    }
+
+    Float next_1d(Mask active = true) override {
+        Assert(seeded());
+
+        uint32_t dim = m_dimension_index++;
+        UInt32 seed = sample_tea_32(UInt32(m_base_seed), UInt32(dim));
+
+        // Shuffle the samples order and scramble the first dimension of the Sobol' sequence
+        UInt32 i = nested_uniform_scramble_2(sample_index(), seed);
+        UInt32 x = nested_uniform_scramble_2(reverse_bits_32(i),
+                                             sample_tea_32(seed, UInt32(0x48bc48eb)));
+
+        return shift(to_float(x), 2 * dim, active);
+    }
+
+    Point2f next_2d(Mask active = true) override {
+        Assert(seeded());
+
+        uint32_t dim = m_dimension_index++;
+        UInt32 seed = sample_tea_32(UInt32(m_base_seed), UInt32(dim));
+
+        // Shuffle the samples order and scramble both dimensions of the Sobol' sequence
+        UInt32 i = nested_uniform_scramble_2(sample_index(), seed);
+        UInt32 x = nested_uniform_scramble_2(reverse_bits_32(i),
+                                             sample_tea_32(seed, UInt32(0x98bc51ab))),
+               y = nested_uniform_scramble_2(sobol_2_bits(i),
+                                             sample_tea_32(seed, UInt32(0x04223e2d)));
+
+        return Point2f(shift(to_float(x), 2 * dim, active),
+                       shift(to_float(y), 2 * dim + 1, active));
+    }
+
+    std::string to_string() const override {
+        std::ostringstream oss;
+        oss << "BlueNoiseSampler[" << std::endl
+            << "  sample_count = " << m_sample_count << std::endl
+            << "]";
+        return oss.str();
+    }
+
+    MTS_DECLARE_CLASS()
+private:
+    /// Index of the current sample within the sequence of its pixel
+    UInt32 sample_index() const {
+        if constexpr (is_array_v<Float> && !is_cuda_array_v<Float>) {
+            /* Without a wavefront, the lanes of the packets hold consecutive
+               samples of the same or of neighboring pixels */
+            if (m_wavefront_size == 1)
+                return (m_sample_index * UInt32(Float::Size) + arange<UInt32>()) %
+                       m_sample_count;
+        }
+        return current_sample_index();
+    }
+
+    /**
+     * \brief Toroidally shift the value \c u by the blue noise mask at the
+     * position of the pixel, offset by a pseudorandom amount for the
+     * dimension \c dim
+     */
+    Float shift(const Float &u, uint32_t dim, Mask active) const {
+        constexpr uint32_t res = detail::BlueNoiseRes;
+        uint32_t offset = sample_tea_32((uint32_t) m_base_seed, dim ^ 0x2c1b3c6du);
+        UInt32 x = (m_pixel.x() + (offset & (res - 1))) & (res - 1),
+               y = (m_pixel.y() + ((offset >> 8) & (res - 1))) & (res - 1);
+
+        Float result = u + gather<Float>(m_mask, y * res + x, active);
+        masked(result, result >= 1.f) -= 1.f;
+        return min(result, math::OneMinusEpsilon<Float>);
+    }
+
+    /// Convert a 32 bit fixed-point value into a number on <tt>[0, 1)</tt>
+    Float to_float(const UInt32 &x) const {
+        if constexpr (is_double_v<Float>)
+            return Float(x) * Float(1.0 / 4294967296.0);
+        else
+            return reinterpret_array<Float>(sr<9>(x) | 0x3f800000u) - 1.f;
+    }
+
+private:
+    /// Tileable blue noise mask
+    DynamicBuffer<Float> m_mask;
+
+    /// Position of the current pixel within the blue noise mask
+    Point2u m_pixel;
+};
+
+MTS_IMPLEMENT_CLASS_VARIANT(BlueNoiseSampler, Sampler)
+MTS_EXPORT_PLUGIN(BlueNoiseSampler, "Blue Noise Sampler");
+NAMESPACE_END(mitsuba)
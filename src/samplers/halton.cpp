@@ -0,0 +1,180 @@
+#include <mitsuba/core/profiler.h>
+#include <mitsuba/core/properties.h>
+#include <mitsuba/core/spectrum.h>
+#include <mitsuba/core/qmc.h>
+#include <mitsuba/render/sampler.h>
+
+NAMESPACE_BEGIN(mitsuba)
+
+/**!
+
+.. _sampler-halton:
+
+Halton sampler (:monosp:`halton`)
+---------------------------------
+
+.. pluginparameters::
+
+ * - sample_count
+   - |int|
+   - Number of samples per pixel (Default: 4)
+ * - scramble
+   - |int|
+   - Permutation applied to the digits of the radical inverse: ``-1`` selects the
+     Faure permutations, ``0`` disables scrambling, and any other value builds
+     pseudorandom permutations seeded by it. (Default: -1)
+ * - seed
+   - |int|
+   - Seed offset (Default: 0)
+
+This plugin implements a sampler based on the Halton sequence, where dimension :math:`d`
+of sample :math:`i` is the radical inverse of :math:`i` in the :math:`d`-th prime base.
+The digits of the radical inverse are optionally run through the scrambling permutations
+of Faure :cite:`Faure1992Good`, which greatly reduce the correlation between the higher
+dimensions of the plain sequence.
+
+Rather than drawing the samples of all pixels from independently randomized copies
+of the sequence, the sampler enumerates a single sequence following the approach of
+Grünschloß et al. :cite:`Grunschloss2012Enumerating`: the first two dimensions are split
+into :math:`2^8\times 3^5` elementary intervals, and every pixel receives the samples
+that fall into its own interval. These two dimensions, rescaled to the interval, provide
+the position of the sample within the pixel, and the remaining dimensions are taken from
+the same samples of the sequence, so that different pixels never share any sample.
+As the indices of the samples of a pixel are consecutive multiples of the number of
+intervals, this mapping is computed with a handful of integer operations.
+
+The radical inverse is evaluated for all the samples of a packet at once, and the
+permutation tables are shared by all the copies of the sampler used by the rendering
+threads. Only the first 1024 dimensions have their own prime base; dimensions beyond
+this limit reuse the bases of the lower dimensions. Since the digit permutations are
+looked up in tables that reside in host memory, this plugin is not available in the
+GPU variants.
+
+ */
+
+template <typename Float, typename Spectrum>
+class HaltonSampler final : public Sampler<Float, Spectrum> {
+public:
+    MTS_IMPORT_BASE(Sampler, m_sample_count, m_base_seed, seeded,
+                    m_samples_per_wavefront, m_wavefront_size, m_wavefront_offset,
+                    m_dimension_index, current_sample_index)
+    MTS_IMPORT_TYPES()
+
+    HaltonSampler(const Properties &props = Properties()) : Base(props) {
+        if constexpr (is_cuda_array_v<Float>)
+            Throw("The Halton sampler is not supported in GPU variants!");
+
+        int scramble = props.int_("scramble", -1);
+        m_scramble = scramble != 0;
+        m_inverse = new RadicalInverse(8161, scramble);
+    }
+
+    ref<Sampler<Float, Spectrum>> clone() override {
+        // Share the tables of the radical inverse rather than recomputing them
+        HaltonSampler *sampler           = new HaltonSampler(m_inverse, m_scramble);
+        sampler->m_sample_count          = m_sample_count;
+        sampler->m_samples_per_wavefront = m_samples_per_wavefront;
+        sampler->m_base_seed             = m_base_seed;
+        return sampler;
+    }
+
+    void seed(uint64_t seed_offset, size_t wavefront_size) override {
+        Base::seed(seed_offset, wavefront_size);
+
+        // Index of the sequence (pixel) of every lane of the wavefront
+        UInt32 indices = arange<UInt32>(m_wavefront_size) + m_wavefront_offset;
+        UInt64 sequence = UInt64(m_samples_per_wavefront * (indices / m_samples_per_wavefront) +
+                                 UInt32(seed_offset) + UInt32(m_base_seed));
+
+        /* Find the first sample of the sequence that falls into its elementary
+           interval, i.e. the index that is congruent to the interval position
+           modulo 2^8 and 3^5 (Chinese remainder theorem). Sequences that do not
+           fit into the intervals use subsequent blocks of samples. */
+        UInt64 x = sequence & UInt64(Scale2 - 1),
+               y = (sequence >> Log2Scale2) % UInt64(Scale3),
+               block = sequence / UInt64(IntervalCount);
+
+        m_sequence_offset = (x * UInt64(CRTFactor2) + y * UInt64(CRTFactor3)) % UInt64(IntervalCount) +
+                            block * UInt64((uint64_t) m_sample_count * IntervalCount);
+    }
+
+    Float next_1d(Mask /*active*/ = true) override {
+        Assert(seeded());
+        return sample(m_dimension_index++, sample_index());
+    }
+
+    Point2f next_2d(Mask /*active*/ = true) override {
+        Assert(seeded());
+        UInt64 index = sample_index();
+        Float x = sample(m_dimension_index++, index),
+              y = sample(m_dimension_index++, index);
+        return Point2f(x, y);
+    }
+
+    std::string to_string() const override {
+        std::ostringstream oss;
+        oss << "HaltonSampler[" << std::endl
+            << "  sample_count = " << m_sample_count << "," << std::endl
+            << "  scramble = " << (m_scramble ? m_inverse->scramble() : 0) << std::endl
+            << "]";
+        return oss.str();
+    }
+
+    MTS_DECLARE_CLASS()
+private:
+    HaltonSampler(RadicalInverse *inverse, bool scramble)
+        : Base(Properties()), m_inverse(inverse), m_scramble(scramble) { }
+
+    /// Index of the current sample within the Halton sequence
+    UInt64 sample_index() const {
+        return m_sequence_offset + UInt64(current_sample_index()) * UInt64(IntervalCount);
+    }
+
+    /// Evaluate the dimension \c dim of the Halton sequence for the samples \c index
+    Float sample(uint32_t dim, UInt64 index) const {
+        if constexpr (is_cuda_array_v<Float>) {
+            ENOKI_MARK_USED(dim);
+            ENOKI_MARK_USED(index);
+            return 0.f;
+        } else {
+            if (dim == 0) {
+                // Position within the elementary interval along the first dimension
+                index = index >> Log2Scale2;
+            } else if (dim == 1) {
+                index = m_divisor_3(index);
+            } else if (unlikely(dim >= m_inverse->bases())) {
+                dim = 2 + (dim - 2) % ((uint32_t) m_inverse->bases() - 2);
+            }
+
+            if (m_scramble)
+                return m_inverse->eval_scrambled<Float>(dim, index);
+            else
+                return m_inverse->eval<Float>(dim, index);
+        }
+    }
+
+private:
+    /// Number of elementary intervals along the first two dimensions (2^8 and 3^5)
+    static constexpr uint64_t Log2Scale2 = 8, Scale2 = 256, Scale3 = 243,
+                              IntervalCount = Scale2 * Scale3;
+
+    /* Factors of the Chinese remainder theorem: 3^5 * (3^-5 mod 2^8) and
+       2^8 * (2^-8 mod 3^5) */
+    static constexpr uint64_t CRTFactor2 = Scale3 * 59, CRTFactor3 = Scale2 * 187;
+
+    /// Precomputed tables of the radical inverse, shared by all clones
+    ref<RadicalInverse> m_inverse;
+
+    /// Fast division by 3^5
+    enoki::divisor<uint64_t> m_divisor_3 = enoki::divisor<uint64_t>(Scale3);
+
+    /// Whether the digits are run through the scrambling permutations
+    bool m_scramble = true;
+
+    /// Index of the first sample of each sequence
+    UInt64 m_sequence_offset;
+};
+
+MTS_IMPLEMENT_CLASS_VARIANT(HaltonSampler, Sampler)
+MTS_EXPORT_PLUGIN(HaltonSampler, "Halton Sampler");
+NAMESPACE_END(mitsuba)
@@ -81,6 +81,12 @@ public:
         return Point2f(f1, f2);
     }
 
+    void next_nd(Float *values, size_t count, Mask active = true) override {
+        Assert(seeded());
+        for (size_t i = 0; i < count; ++i)
+            values[i] = m_rng.template next_float<Float>(active);
+    }
+
     std::string to_string() const override {
         std::ostringstream oss;
         oss << "IndependentSampler[" << std::endl
@@ -13,6 +13,21 @@ NAMESPACE_BEGIN(mitsuba)
 Low discrepancy sampler (:monosp:`ldsampler`)
 ---------------------------------------------
 
+.. pluginparameters::
+
+ * - sample_count
+   - |int|
+   - Number of samples per pixel. This value should be a square power of two, and is otherwise
+     rounded up to the next one. (Default: 4)
+ * - seed
+   - |int|
+   - Seed offset (Default: 0)
+ * - stateless
+   - |bool|
+   - Recompute the per-pixel scrambling seeds on the fly instead of storing them for every
+     sample of a wavefront. This saves 4 bytes per sample in GPU variants, at the cost of
+     one additional hash per dimension. (Default: False)
+
 This plugin implements a simple hybrid sampler that combines aspects of a Quasi-Monte Carlo sequence
 with a pseudorandom number generator based on a technique proposed by Kollig and Keller
 :cite:`Kollig2002Efficient`. It is a good and fast general-purpose sample generator. Other QMC
@@ -61,7 +76,7 @@ template <typename Float, typename Spectrum>
 class LowDiscrepancySampler  final : public Sampler<Float, Spectrum> {
 public:
     MTS_IMPORT_BASE(Sampler, m_sample_count, m_base_seed, seeded,
-                    m_samples_per_wavefront, m_dimension_index,
+                    m_samples_per_wavefront, m_wavefront_offset, m_dimension_index,
                     current_sample_index, compute_per_sequence_seed)
     MTS_IMPORT_TYPES()
 
@@ -75,6 +90,7 @@ public:
             Log(Warn, "Sample count should be square and power of two, rounding to %i", sqr(res));
 
         m_sample_count = sqr(res);
+        m_stateless = props.bool_("stateless", false);
     }
 
     ref<Sampler<Float, Spectrum>> clone() override {
@@ -82,41 +98,50 @@ public:
         sampler->m_sample_count          = m_sample_count;
         sampler->m_samples_per_wavefront = m_samples_per_wavefront;
         sampler->m_base_seed             = m_base_seed;
+        sampler->m_stateless             = m_stateless;
         return sampler;
     }
 
     void seed(uint64_t seed_offset, size_t wavefront_size) override {
         Base::seed(seed_offset, wavefront_size);
-        m_scramble_seed = compute_per_sequence_seed(seed_offset);
+        if (m_stateless) {
+            m_seed_offset = (uint32_t) seed_offset;
+            m_seed_wavefront_offset = m_wavefront_offset;
+            m_scramble_seed = UInt32();
+        } else {
+            m_scramble_seed = compute_per_sequence_seed(seed_offset);
+        }
     }
 
     Float next_1d(Mask /*active*/ = true) override {
         Assert(seeded());
+        UInt32 scramble_seed = this->scramble_seed();
 
         UInt32 sample_indices = current_sample_index();
-        UInt32 perm_seed = m_scramble_seed + m_dimension_index++;
+        UInt32 perm_seed = scramble_seed + m_dimension_index++;
 
         // Shuffle the samples order
         UInt32 i = permute(sample_indices, m_sample_count, perm_seed);
 
         // Compute scramble value (unique per sequence)
-        UInt32 scramble = sample_tea_32(m_scramble_seed, UInt32(0x48bc48eb));
+        UInt32 scramble = sample_tea_32(scramble_seed, UInt32(0x48bc48eb));
 
         return radical_inverse_2(i, scramble);
     }
 
     Point2f next_2d(Mask /*active*/ = true) override {
         Assert(seeded());
+        UInt32 scramble_seed = this->scramble_seed();
 
         UInt32 sample_indices = current_sample_index();
-        UInt32 perm_seed = m_scramble_seed + m_dimension_index++;
+        UInt32 perm_seed = scramble_seed + m_dimension_index++;
 
         // Shuffle the samples order
         UInt32 i = permute(sample_indices, m_sample_count, perm_seed);
 
         // Compute scramble values (unique per sequence) for both axis
-        UInt32 scramble_x = sample_tea_32(m_scramble_seed, UInt32(0x98bc51ab));
-        UInt32 scramble_y = sample_tea_32(m_scramble_seed, UInt32(0x04223e2d));
+        UInt32 scramble_x = sample_tea_32(scramble_seed, UInt32(0x98bc51ab));
+        UInt32 scramble_y = sample_tea_32(scramble_seed, UInt32(0x04223e2d));
 
         Float x = radical_inverse_2(i, scramble_x),
               y = sobol_2(i, scramble_y);
@@ -124,18 +149,55 @@ public:
         return Point2f(x, y);
     }
 
+    void next_nd(Float *values, size_t count, Mask /*active*/ = true) override {
+        Assert(seeded());
+        UInt32 scramble_seed = this->scramble_seed();
+
+        // The sample index and scramble values are shared by all dimensions
+        UInt32 sample_indices = current_sample_index();
+        UInt32 scramble_x = sample_tea_32(scramble_seed, UInt32(0x98bc51ab)),
+               scramble_y = sample_tea_32(scramble_seed, UInt32(0x04223e2d));
+
+        for (size_t k = 0; k + 1 < count; k += 2) {
+            UInt32 i = permute(sample_indices, m_sample_count,
+                               scramble_seed + m_dimension_index++);
+            values[k]     = radical_inverse_2(i, scramble_x);
+            values[k + 1] = sobol_2(i, scramble_y);
+        }
+
+        if (count % 2 == 1) {
+            UInt32 i = permute(sample_indices, m_sample_count,
+                               scramble_seed + m_dimension_index++);
+            values[count - 1] =
+                radical_inverse_2(i, sample_tea_32(scramble_seed, UInt32(0x48bc48eb)));
+        }
+    }
+
     std::string to_string() const override {
         std::ostringstream oss;
         oss << "LowDiscrepancySampler [" << std::endl
-            << "  sample_count = " << m_sample_count << std::endl
+            << "  sample_count = " << m_sample_count << "," << std::endl
+            << "  stateless = " << m_stateless << std::endl
             << "]";
         return oss.str();
     }
 
     MTS_DECLARE_CLASS()
+private:
+    /// Per-sequence scramble seed, which is recomputed in stateless mode
+    UInt32 scramble_seed() const {
+        if (m_stateless)
+            return compute_per_sequence_seed(m_seed_offset, m_seed_wavefront_offset);
+        return m_scramble_seed;
+    }
+
 private:
     /// Per-sequence scramble seed
     UInt32 m_scramble_seed;
+
+    /// Seed and wavefront offset used to recompute the scramble seed in stateless mode
+    uint32_t m_seed_offset = 0, m_seed_wavefront_offset = 0;
+    bool m_stateless;
 };
 
 MTS_IMPLEMENT_CLASS_VARIANT(LowDiscrepancySampler , Sampler)
@@ -24,6 +24,13 @@ Correlated Multi-Jittered sampler (:monosp:`multijitter`)
  * - jitter
    - |bool|
    - Adds additional random jitter withing the substratum (Default: True)
+ * - stateless
+   - |bool|
+   - Recompute the per-pixel permutation seeds on the fly, and derive the jitter from a hash of
+     the seed, dimension and sample index instead of a random number generator. This removes
+     all per-sample state of the sampler (20 bytes per sample of a wavefront), which saves a
+     lot of memory in GPU variants at high sample counts, at the cost of a few more integer
+     operations per dimension. (Default: False)
 
 This plugin implements the methods introduced in Pixar's tech memo :cite:`kensler1967correlated`.
 
@@ -61,12 +68,13 @@ template <typename Float, typename Spectrum>
 class MultijitterSampler final : public PCG32Sampler<Float, Spectrum> {
 public:
     MTS_IMPORT_BASE(PCG32Sampler, m_sample_count, m_base_seed, m_rng, seeded,
-                    m_samples_per_wavefront, m_dimension_index,
+                    m_samples_per_wavefront, m_wavefront_offset, m_dimension_index,
                     current_sample_index, compute_per_sequence_seed)
     MTS_IMPORT_TYPES()
 
     MultijitterSampler(const Properties &props = Properties()) : Base(props) {
         m_jitter = props.bool_("jitter", true);
+        m_stateless = props.bool_("stateless", false);
 
         // Find stratification grid resolution with aspect ratio close to 1
         m_resolution[1] = uint32_t(sqrt(ScalarFloat(m_sample_count)));
@@ -84,6 +92,7 @@ public:
     ref<Sampler<Float, Spectrum>> clone() override {
         MultijitterSampler *sampler = new MultijitterSampler();
         sampler->m_jitter                = m_jitter;
+        sampler->m_stateless             = m_stateless;
         sampler->m_sample_count          = m_sample_count;
         sampler->m_inv_sample_count      = m_inv_sample_count;
         sampler->m_resolution            = m_resolution;
@@ -95,21 +104,29 @@ public:
     }
 
     void seed(uint64_t seed_offset, size_t wavefront_size) override {
-        Base::seed(seed_offset, wavefront_size);
-        m_permutation_seed = compute_per_sequence_seed(seed_offset);
+        if (m_stateless) {
+            // Skip the random number generator of the base class
+            Sampler<Float, Spectrum>::seed(seed_offset, wavefront_size);
+            m_seed_offset = (uint32_t) seed_offset;
+            m_seed_wavefront_offset = m_wavefront_offset;
+            m_permutation_seed = UInt32();
+        } else {
+            Base::seed(seed_offset, wavefront_size);
+            m_permutation_seed = compute_per_sequence_seed(seed_offset);
+        }
     }
 
     Float next_1d(Mask active = true) override {
         Assert(seeded());
 
         UInt32 sample_indices = current_sample_index();
-        UInt32 perm_seed = m_permutation_seed + m_dimension_index++;
+        UInt32 perm_seed = permutation_seed() + m_dimension_index++;
 
         // Shuffle the samples order
         Float p = permute_kensler(sample_indices, m_sample_count, perm_seed * 0x45fbe943, active);
 
         // Add a random perturbation
-        Float j = m_jitter ? m_rng.template next_float<Float>(active) : 0.5f;
+        Float j = m_jitter ? jitter(sample_indices, perm_seed * 0x45fbe943, active) : 0.5f;
 
         return (p + j) * m_inv_sample_count;
     }
@@ -118,7 +135,7 @@ public:
         Assert(seeded());
 
         UInt32 sample_indices = current_sample_index();
-        UInt32 perm_seed = m_permutation_seed + m_dimension_index++;
+        UInt32 perm_seed = permutation_seed() + m_dimension_index++;
 
         // Shuffle the samples order
         UInt32 s = permute_kensler(sample_indices, m_sample_count, perm_seed * 0x51633e2d, active);
@@ -134,8 +151,8 @@ public:
         // Add random perturbations on both axis
         Float jx = 0.5f, jy = 0.5f;
         if (m_jitter) {
-            jx = m_rng.template next_float<Float>(active);
-            jy = m_rng.template next_float<Float>(active);
+            jx = jitter(sample_indices, perm_seed * 0x68bc21eb, active);
+            jy = jitter(sample_indices, perm_seed * 0x02e5be93, active);
         }
 
         // Construct the final 2D point
@@ -147,14 +164,31 @@ public:
         std::ostringstream oss;
         oss << "MultijitterSampler[" << std::endl
             << "  sample_count = " << m_sample_count << std::endl
-            << "  jitter = " << m_jitter << std::endl
+            << "  jitter = " << m_jitter << "," << std::endl
+            << "  stateless = " << m_stateless << std::endl
             << "]";
         return oss.str();
     }
 
     MTS_DECLARE_CLASS()
+private:
+    /// Per-sequence permutation seed, which is recomputed in stateless mode
+    UInt32 permutation_seed() const {
+        if (m_stateless)
+            return compute_per_sequence_seed(m_seed_offset, m_seed_wavefront_offset);
+        return m_permutation_seed;
+    }
+
+    /// Random perturbation within a substratum (hashed from \c key in stateless mode)
+    Float jitter(const UInt32 &sample_indices, const UInt32 &key, Mask active) {
+        if (m_stateless)
+            return Float(sample_tea_float32(key, sample_indices));
+        return m_rng.template next_float<Float>(active);
+    }
+
 private:
     bool m_jitter;
+    bool m_stateless;
 
     /// Stratification grid resolution and precomputed variables
     ScalarPoint2u m_resolution;
@@ -164,6 +198,9 @@ private:
 
     /// Per-sequence permutation seed
     UInt32 m_permutation_seed;
+
+    /// Seed and wavefront offset used to recompute the permutation seed in stateless mode
+    uint32_t m_seed_offset = 0, m_seed_wavefront_offset = 0;
 };
 
 MTS_IMPLEMENT_CLASS_VARIANT(MultijitterSampler, Sampler)
@@ -0,0 +1,133 @@
+#include <mitsuba/core/profiler.h>
+#include <mitsuba/core/properties.h>
+#include <mitsuba/core/spectrum.h>
+#include <mitsuba/core/qmc.h>
+#include <mitsuba/render/sampler.h>
+
+NAMESPACE_BEGIN(mitsuba)
+
+/**!
+
+.. _sampler-sobol:
+
+Owen-scrambled Sobol sampler (:monosp:`sobol`)
+----------------------------------------------
+
+.. pluginparameters::
+
+ * - sample_count
+   - |int|
+   - Number of samples per pixel. This value should be a power of two, and is otherwise
+     rounded up to the next one. (Default: 4)
+ * - seed
+   - |int|
+   - Seed offset (Default: 0)
+
+This plugin generates the first two dimensions of the Sobol' sequence, which form a
+(0, 2)-sequence in base 2, and randomizes them using the hash-based nested uniform
+(Owen) scrambling proposed by Burley :cite:`Burley2020Practical`. Each 1D or 2D request
+uses a fresh scramble, and also shuffles the order of the samples, which decorrelates the
+dimensions of a path while preserving the stratification of every individual dimension
+(and pair of dimensions obtained from a call to ``next_2d()``) over the samples of a pixel.
+
+Owen scrambling is known to improve the convergence rate of the error for smooth
+integrands beyond that of plain randomized quasi-Monte Carlo, so images typically have
+noticeably less noise than with the :ref:`independent <sampler-independent>` sampler at
+the same number of samples per pixel.
+
+Unlike the :ref:`ldsampler <sampler-ldsampler>`, this sampler neither uses shuffle
+networks nor precomputed tables: any dimension of any sample is computed directly from
+the sample index, the dimension index and a per-pixel seed using a handful of integer
+operations. This makes it well-suited for vectorized and GPU variants.
+
+ */
+
+template <typename Float, typename Spectrum>
+class SobolSampler final : public Sampler<Float, Spectrum> {
+public:
+    MTS_IMPORT_BASE(Sampler, m_sample_count, m_base_seed, seeded,
+                    m_samples_per_wavefront, m_dimension_index,
+                    current_sample_index, compute_per_sequence_seed)
+    MTS_IMPORT_TYPES()
+
+    SobolSampler(const Properties &props = Properties()) : Base(props) {
+        // The stratification is only complete for power-of-two sample counts
+        ScalarUInt32 sample_count = math::round_to_power_of_two(m_sample_count);
+
+        if (m_sample_count != sample_count)
+            Log(Warn, "Sample count should be a power of two, rounding to %i", sample_count);
+
+        m_sample_count = sample_count;
+    }
+
+    ref<Sampler<Float, Spectrum>> clone() override {
+        SobolSampler *sampler            = new SobolSampler();
+        sampler->m_sample_count          = m_sample_count;
+        sampler->m_samples_per_wavefront = m_samples_per_wavefront;
+        sampler->m_base_seed             = m_base_seed;
+        return sampler;
+    }
+
+    void seed(uint64_t seed_offset, size_t wavefront_size) override {
+        Base::seed(seed_offset, wavefront_size);
+        m_scramble_seed = compute_per_sequence_seed(seed_offset);
+    }
+
+    Float next_1d(Mask /*active*/ = true) override {
+        Assert(seeded());
+
+        UInt32 seed = sample_tea_32(m_scramble_seed, UInt32(m_dimension_index++));
+
+        // Shuffle the samples order
+        UInt32 i = nested_uniform_scramble_2(current_sample_index(), seed);
+
+        // Scramble the first dimension of the Sobol' sequence
+        UInt32 x = nested_uniform_scramble_2(reverse_bits_32(i),
+                                             sample_tea_32(seed, UInt32(0x48bc48eb)));
+
+        return to_float(x);
+    }
+
+    Point2f next_2d(Mask /*active*/ = true) override {
+        Assert(seeded());
+
+        UInt32 seed = sample_tea_32(m_scramble_seed, UInt32(m_dimension_index++));
+
+        // Shuffle the samples order
+        UInt32 i = nested_uniform_scramble_2(current_sample_index(), seed);
+
+        // Scramble both dimensions of the Sobol' sequence independently
+        UInt32 x = nested_uniform_scramble_2(reverse_bits_32(i),
+                                             sample_tea_32(seed, UInt32(0x98bc51ab))),
+               y = nested_uniform_scramble_2(sobol_2_bits(i),
+                                             sample_tea_32(seed, UInt32(0x04223e2d)));
+
+        return Point2f(to_float(x), to_float(y));
+    }
+
+    std::string to_string() const override {
+        std::ostringstream oss;
+        oss << "SobolSampler[" << std::endl
+            << "  sample_count = " << m_sample_count << std::endl
+            << "]";
+        return oss.str();
+    }
+
+    MTS_DECLARE_CLASS()
+private:
+    /// Convert a 32 bit fixed-point value into a number on <tt>[0, 1)</tt>
+    Float to_float(const UInt32 &x) const {
+        if constexpr (is_double_v<Float>)
+            return Float(x) * Float(1.0 / 4294967296.0);
+        else
+            return reinterpret_array<Float>(sr<9>(x) | 0x3f800000u) - 1.f;
+    }
+
+private:
+    /// Per-sequence scramble seed
+    UInt32 m_scramble_seed;
+};
+
+MTS_IMPLEMENT_CLASS_VARIANT(SobolSampler, Sampler)
+MTS_EXPORT_PLUGIN(SobolSampler, "Owen-scrambled Sobol Sampler");
+NAMESPACE_END(mitsuba)
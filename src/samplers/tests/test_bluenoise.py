@@ -0,0 +1,69 @@
+import mitsuba
+import pytest
+import enoki as ek
+import numpy as np
+
+from .utils import check_uniform_scalar_sampler, check_uniform_wavefront_sampler
+
+def test01_bluenoise_scalar(variant_scalar_rgb):
+    from mitsuba.core import xml
+
+    sampler = xml.load_dict({
+        "type" : "bluenoise",
+        "sample_count" : 1024,
+    })
+
+    check_uniform_scalar_sampler(sampler)
+
+
+def test02_bluenoise_wavefront(variant_gpu_rgb):
+    from mitsuba.core import xml
+
+    sampler = xml.load_dict({
+        "type" : "bluenoise",
+        "sample_count" : 1024,
+    })
+
+    check_uniform_wavefront_sampler(sampler)
+
+
+def test03_bluenoise_screen_space(variant_scalar_rgb):
+    from mitsuba.core import xml
+
+    sampler = xml.load_dict({
+        "type" : "bluenoise",
+        "sample_count" : 1,
+    })
+
+    # The first sample of neighboring pixels is distributed as a blue noise
+    res = 64
+    image_1d = np.zeros((res, res))
+    image_2d = np.zeros((res, res))
+    for y in range(res):
+        for x in range(res):
+            sampler.seed(y * res + x)
+            sampler.set_pixel([x, y])
+            image_2d[y, x] = sampler.next_2d().y
+            image_1d[y, x] = sampler.next_1d()
+
+    freq = np.fft.fftfreq(res)
+    radius = np.sqrt(freq[:, None]**2 + freq[None, :]**2)
+    low, high = (radius > 0) & (radius < 0.1), radius > 0.3
+
+    for image in [image_1d, image_2d]:
+        # Every value appears once up to the toroidal shift
+        assert np.all(np.histogram(image, bins=res, range=(0, 1))[0] == res)
+
+        power = np.abs(np.fft.fft2(image - np.mean(image)))**2
+        assert np.mean(power[low]) < 0.01 * np.mean(power[high])
+
+
+def test04_bluenoise_sample_count(variant_scalar_rgb):
+    from mitsuba.core import xml
+
+    sampler = xml.load_dict({
+        "type" : "bluenoise",
+        "sample_count" : 3,
+    })
+
+    assert sampler.sample_count() == 4
@@ -0,0 +1,74 @@
+import mitsuba
+import pytest
+import enoki as ek
+import numpy as np
+
+from .utils import check_uniform_scalar_sampler, check_uniform_wavefront_sampler
+
+def test01_halton_scalar(variant_scalar_rgb):
+    from mitsuba.core import xml
+
+    sampler = xml.load_dict({
+        "type" : "halton",
+        "sample_count" : 1024,
+    })
+
+    check_uniform_scalar_sampler(sampler)
+
+
+def test02_halton_wavefront(variant_packet_rgb):
+    from mitsuba.core import xml
+
+    sampler = xml.load_dict({
+        "type" : "halton",
+        "sample_count" : 1024,
+    })
+
+    check_uniform_wavefront_sampler(sampler)
+
+
+def test03_halton_interval_mapping(variant_scalar_rgb):
+    from mitsuba.core import xml
+    from mitsuba.core import RadicalInverse
+
+    sampler = xml.load_dict({
+        "type" : "halton",
+        "sample_count" : 16,
+        "scramble" : 0,
+    })
+    inv = RadicalInverse()
+
+    # The samples of a pixel are those of the sequence in its elementary interval
+    seen = set()
+    for seed in [0, 1, 255, 256, 1000]:
+        sampler.seed(seed)
+        for i in range(16):
+            v = sampler.next_2d()
+            w = sampler.next_1d()
+            index = next(j for j in range(256 * 243)
+                         if j % 256 == seed % 256 and j % 243 == (seed // 256) % 243)
+            index += i * 256 * 243
+            assert ek.allclose(v.x, inv.eval(0, index // 256))
+            assert ek.allclose(v.y, inv.eval(1, index // 243))
+            assert ek.allclose(w, inv.eval(2, index))
+            assert index not in seen
+            seen.add(index)
+            sampler.advance()
+
+
+def test04_halton_clone(variant_scalar_rgb):
+    from mitsuba.core import xml
+
+    sampler = xml.load_dict({
+        "type" : "halton",
+        "sample_count" : 64,
+    })
+    clone = sampler.clone()
+
+    sampler.seed(12)
+    clone.seed(12)
+    for i in range(64):
+        assert ek.allclose(sampler.next_2d(), clone.next_2d())
+        assert ek.allclose(sampler.next_1d(), clone.next_1d())
+        sampler.advance()
+        clone.advance()
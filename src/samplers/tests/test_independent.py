@@ -41,3 +41,15 @@ def test03_clone(variant_scalar_rgb, sampler):
     for i in range(5):
         assert ek.all(sampler.next_1d() != sampler2.next_1d())
         assert ek.all(sampler.next_2d() != sampler2.next_2d())
+
+
+def test04_next_nd(variant_scalar_rgb):
+    # Bulk generation matches the corresponding calls to next_2d() and next_1d()
+    s1, s2 = make_sampler(), make_sampler()
+    for count in [1, 4, 5]:
+        values = s1.next_nd(count)
+        assert len(values) == count
+        for i in range(count // 2):
+            assert ek.allclose(values[2 * i:2 * i + 2], s2.next_2d())
+        if count % 2 == 1:
+            assert ek.allclose(values[-1], s2.next_1d())
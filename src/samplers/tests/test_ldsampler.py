@@ -64,3 +64,50 @@ def test03_ldsampler_deterministic_values(variant_scalar_rgb):
 
     for v in values_2d_dim1:
         assert ek.allclose(sampler.next_2d(), v)
+
+
+def test04_ldsampler_next_nd(variant_scalar_rgb):
+    from mitsuba.core import xml
+
+    s1, s2 = [xml.load_dict({ "type" : "ldsampler", "sample_count" : 64 }) for i in range(2)]
+    s1.seed(3)
+    s2.seed(3)
+
+    # Bulk generation matches the corresponding calls to next_2d() and next_1d()
+    for i in range(64):
+        values = s1.next_nd(5)
+        for j in range(2):
+            assert ek.allclose(values[2 * j:2 * j + 2], s2.next_2d())
+        assert ek.allclose(values[4], s2.next_1d())
+        s1.advance()
+        s2.advance()
+
+
+def test05_ldsampler_stateless(variant_scalar_rgb):
+    from mitsuba.core import xml
+
+    s1, s2 = [xml.load_dict({ "type" : "ldsampler", "sample_count" : 64,
+                              "stateless" : stateless }) for stateless in [False, True]]
+    s1.seed(7)
+    s2.seed(7)
+
+    # Recomputing the seeds on the fly produces the same samples
+    for i in range(64):
+        assert ek.allclose(s1.next_2d(), s2.next_2d())
+        assert ek.allclose(s1.next_1d(), s2.next_1d())
+        s1.advance()
+        s2.advance()
+
+
+def test06_ldsampler_stateless_wavefront(variant_gpu_rgb):
+    from mitsuba.core import xml
+
+    s1, s2 = [xml.load_dict({ "type" : "ldsampler", "sample_count" : 64,
+                              "stateless" : stateless }) for stateless in [False, True]]
+
+    for s in [s1, s2]:
+        s.set_samples_per_wavefront(64)
+        s.seed_chunk(3, 128, 256)
+
+    assert ek.allclose(s1.next_2d(), s2.next_2d())
+    assert ek.allclose(s1.next_1d(), s2.next_1d())
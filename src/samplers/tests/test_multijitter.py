@@ -25,3 +25,27 @@ def test02_multijitter_wavefront(variant_gpu_rgb):
     })
 
     check_uniform_wavefront_sampler(sampler)
+
+
+def test03_multijitter_stateless_scalar(variant_scalar_rgb):
+    from mitsuba.core import xml
+
+    sampler = xml.load_dict({
+        "type" : "multijitter",
+        "sample_count" : 1024,
+        "stateless" : True,
+    })
+
+    check_uniform_scalar_sampler(sampler)
+
+
+def test04_multijitter_stateless_wavefront(variant_gpu_rgb):
+    from mitsuba.core import xml
+
+    sampler = xml.load_dict({
+        "type" : "multijitter",
+        "sample_count" : 1024,
+        "stateless" : True,
+    })
+
+    check_uniform_wavefront_sampler(sampler)
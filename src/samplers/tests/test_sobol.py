@@ -0,0 +1,63 @@
+import mitsuba
+import pytest
+import enoki as ek
+import numpy as np
+
+from .utils import check_uniform_scalar_sampler, check_uniform_wavefront_sampler
+
+def test01_sobol_scalar(variant_scalar_rgb):
+    from mitsuba.core import xml
+
+    sampler = xml.load_dict({
+        "type" : "sobol",
+        "sample_count" : 1024,
+    })
+
+    check_uniform_scalar_sampler(sampler)
+
+
+def test02_sobol_wavefront(variant_gpu_rgb):
+    from mitsuba.core import xml
+
+    sampler = xml.load_dict({
+        "type" : "sobol",
+        "sample_count" : 1024,
+    })
+
+    check_uniform_wavefront_sampler(sampler)
+
+
+def test03_sobol_higher_dimensions(variant_scalar_rgb):
+    from mitsuba.core import xml
+
+    sampler = xml.load_dict({
+        "type" : "sobol",
+        "sample_count" : 1024,
+    })
+    sampler.seed(0)
+
+    # Every 2D request is a scrambled (0, 10, 2)-net over the samples of a pixel
+    res = 32
+    hist = np.zeros((res, res))
+    values_1d = np.zeros(1024)
+    for i in range(1024):
+        for j in range(5):
+            sampler.next_2d()
+        v = sampler.next_2d()
+        hist[int(v.x * res), int(v.y * res)] += 1
+        values_1d[i] = sampler.next_1d()
+        sampler.advance()
+
+    assert np.all(hist == 1)
+    assert np.all(np.histogram(values_1d, bins=1024, range=(0, 1))[0] == 1)
+
+
+def test04_sobol_sample_count(variant_scalar_rgb):
+    from mitsuba.core import xml
+
+    sampler = xml.load_dict({
+        "type" : "sobol",
+        "sample_count" : 100,
+    })
+
+    assert sampler.sample_count() == 128
@@ -25,3 +25,25 @@ def test02_stratified_wavefront(variant_gpu_rgb):
     })
 
     check_uniform_wavefront_sampler(sampler)
+
+
+def test03_stratified_seed_chunk(variant_gpu_rgb):
+    from mitsuba.core import xml
+
+    sampler = xml.load_dict({
+        "type" : "stratified",
+        "sample_count" : 16,
+    })
+    sampler.set_samples_per_wavefront(4)
+
+    # A chunk of the wavefront must reproduce the corresponding lanes of the full one
+    sampler.seed(0, 64)
+    ref_1d = sampler.next_1d().numpy()
+    ref_2d = sampler.next_2d().numpy()
+
+    sampler.seed_chunk(0, 24, 16)
+    assert ek.allclose(sampler.next_1d().numpy(), ref_1d[24:40])
+    assert ek.allclose(sampler.next_2d().numpy(), ref_2d[24:40])
+
+    with pytest.raises(RuntimeError):
+        sampler.seed_chunk(0, 2, 16)
@@ -0,0 +1,229 @@
+#include <mitsuba/core/fwd.h>
+#include <mitsuba/core/properties.h>
+#include <mitsuba/core/transform.h>
+#include <mitsuba/core/warp.h>
+#include <mitsuba/render/fwd.h>
+#include <mitsuba/render/scene.h>
+#include <mitsuba/render/sensor.h>
+#include <mitsuba/render/shape.h>
+
+NAMESPACE_BEGIN(mitsuba)
+
+/**!
+
+.. _sensor-distantflux:
+
+Distant flux sensor (:monosp:`distantflux`)
+-------------------------------------------
+
+.. pluginparameters::
+
+ * - to_world
+   - |transform|
+   - Sensor-to-world transformation matrix. The measured hemisphere is centered
+     around the local Z axis. (Default: none, i.e. the upper hemisphere of world
+     space)
+ * - direction
+   - |vector|
+   - Alternative (and exclusive) to ``to_world``. Axis of the measured
+     hemisphere in world coordinates.
+ * - target
+   - |point| or nested :paramtype:`shape`
+   - Optional. Where the ray origins are sampled: a single point, or the
+     surface of a shape (which is not part of the scene). By default, the
+     origins are uniformly distributed over the footprint of the scene, i.e.
+     the bounding rectangle of the scene in the local XY plane, placed at the
+     top of the scene.
+
+This sensor plugin measures the radiant flux that leaves the scene through a
+target surface, e.g. the top of a large terrain or canopy, binned into
+directions. Every pixel of the film is mapped to a bin of the hemisphere with
+the concentric cosine-weighted mapping, so that all pixels cover the same
+projected solid angle. The pixel values add up to the flux that leaves the
+scene through the target, in units of power (or of power per unit area for a
+target point). A film of 1 by 1 pixels thus records the total flux.
+
+Rays start outside the bounding sphere of the scene and travel towards the
+sampled target points, which do not need to lie on the scene geometry. When the
+target is a shape, positions are sampled by the shape itself, including any
+importance-driven density it provides. Compared to placing many
+:monosp:`radiancemeter` or :monosp:`irradiancemeter` sensors, no ray misses the
+region of interest, and all directions are evaluated by a single render.
+
+.. code-block:: xml
+
+    <sensor type="distantflux">
+        <shape type="rectangle" name="target">
+            <transform name="to_world">
+                <scale value="100"/>
+            </transform>
+        </shape>
+        <film type="hdrfilm">
+            <integer name="width" value="32"/>
+            <integer name="height" value="32"/>
+            <rfilter type="box"/>
+        </film>
+    </sensor>
+
+*/
+
+MTS_VARIANT class DistantFluxSensor final : public Sensor<Float, Spectrum> {
+public:
+    MTS_IMPORT_BASE(Sensor, m_film, m_world_transform, m_resolution)
+    MTS_IMPORT_TYPES(Scene, Shape)
+
+    DistantFluxSensor(const Properties &props) : Base(props) {
+        /* Until `set_scene` is called, we have no information
+           about the scene and default to the unit bounding sphere. */
+        m_bsphere = ScalarBoundingSphere3f(ScalarPoint3f(0.f), 1.f);
+
+        if (props.has_property("direction")) {
+            if (props.has_property("to_world"))
+                Throw("Only one of the parameters 'direction' and 'to_world' "
+                      "can be specified at the same time!'");
+
+            ScalarVector3f direction(normalize(props.vector3f("direction")));
+            auto [up, unused] = coordinate_system(direction);
+
+            m_world_transform =
+                new AnimatedTransform(ScalarTransform4f::look_at(
+                    ScalarPoint3f(0.0f), ScalarPoint3f(direction), up));
+        }
+
+        for (auto &[name, obj] : props.objects(false)) {
+            Shape *shape = dynamic_cast<Shape *>(obj.get());
+            if (shape) {
+                if (m_target_shape)
+                    Throw("Only a single target shape can be specified!");
+                m_target_shape = shape;
+                props.mark_queried(name);
+            }
+        }
+
+        if (props.has_property("target") &&
+            props.type("target") != Properties::Type::Object) {
+            if (m_target_shape)
+                Throw("Only one of a target point and a target shape can be specified!");
+            m_target_type = TargetType::Point;
+            m_target_point = props.point3f("target");
+        } else if (m_target_shape) {
+            m_target_type = TargetType::Shape;
+        } else {
+            m_target_type = TargetType::Footprint;
+        }
+
+        if (m_film->reconstruction_filter()->radius() >
+            0.5f + math::RayEpsilon<Float>)
+            Log(Warn, "This sensor should be used with a reconstruction filter "
+                      "with a radius of 0.5 or lower (e.g. default box)");
+    }
+
+    void set_scene(const Scene *scene) override {
+        ScalarBoundingBox3f bbox = scene->bbox();
+        m_bsphere = bbox.bounding_sphere();
+        m_bsphere.radius =
+            max(math::RayEpsilon<Float>,
+                m_bsphere.radius * (1.f + math::RayEpsilon<Float>));
+
+        if (m_target_type == TargetType::Footprint && bbox.valid()) {
+            // Bounding rectangle of the scene in the local frame of the sensor
+            ScalarTransform4f to_local = m_world_transform->eval(0.f).inverse();
+            ScalarBoundingBox3f local;
+            for (int i = 0; i < 8; ++i)
+                local.expand(to_local * bbox.corner(i));
+            m_footprint = local;
+        }
+    }
+
+    std::pair<Ray3f, Spectrum> sample_ray(Float time, Float wavelength_sample,
+                                          const Point2f &film_sample,
+                                          const Point2f &aperture_sample,
+                                          Mask active) const override {
+        MTS_MASKED_FUNCTION(ProfilerPhase::EndpointSampleRay, active);
+
+        // 1. Sample spectrum
+        auto [wavelengths, wav_weight] =
+            sample_wavelength<Float, Spectrum>(wavelength_sample);
+
+        // 2. Map the film position to a direction of the hemisphere
+        const Transform4f &trafo = m_world_transform->eval(time, active);
+        Vector3f d = normalize(trafo.transform_affine(
+            warp::square_to_cosine_hemisphere(film_sample)));
+
+        // 3. Sample the target point (density per unit area)
+        Point3f p;
+        Float pdf;
+        switch (m_target_type) {
+            case TargetType::Shape: {
+                    PositionSample3f ps =
+                        m_target_shape->sample_position(time, aperture_sample, active);
+                    p = ps.p;
+                    pdf = ps.pdf;
+                }
+                break;
+
+            case TargetType::Point:
+                p = m_target_point;
+                pdf = 1.f;
+                break;
+
+            default: {
+                    ScalarVector3f extents = m_footprint.extents();
+                    Point3f local(m_footprint.min.x() + aperture_sample.x() * extents.x(),
+                                  m_footprint.min.y() + aperture_sample.y() * extents.y(),
+                                  m_footprint.max.z());
+                    p = trafo.transform_affine(local);
+                    pdf = rcp(max(extents.x() * extents.y(), math::Epsilon<ScalarFloat>));
+                }
+                break;
+        }
+        active &= pdf > 0.f;
+
+        /* 4. Start outside of the scene and travel towards the target point.
+              The concentric mapping covers the same projected solid angle in
+              every pixel, hence the cosine cancels out */
+        Float dist = norm(p - m_bsphere.center) + m_bsphere.radius;
+        Ray3f ray(p + d * dist, -d, time, wavelengths);
+
+        Spectrum weight = wav_weight * (math::Pi<ScalarFloat> / hprod(m_resolution)) / pdf;
+
+        return std::make_pair(ray, weight & active);
+    }
+
+    ScalarBoundingBox3f bbox() const override {
+        // Return an invalid bounding box
+        return ScalarBoundingBox3f();
+    }
+
+    std::string to_string() const override {
+        std::ostringstream oss;
+        oss << "DistantFluxSensor[" << std::endl
+            << "  world_transform = " << string::indent(m_world_transform) << "," << std::endl
+            << "  target = ";
+        if (m_target_type == TargetType::Shape)
+            oss << string::indent(m_target_shape);
+        else if (m_target_type == TargetType::Point)
+            oss << m_target_point;
+        else
+            oss << "<footprint of the scene>";
+        oss << "," << std::endl
+            << "  film = " << string::indent(m_film) << "," << std::endl
+            << "]";
+        return oss.str();
+    }
+
+    MTS_DECLARE_CLASS()
+private:
+    enum class TargetType { Shape, Point, Footprint };
+
+    TargetType m_target_type;
+    ref<Shape> m_target_shape;
+    ScalarPoint3f m_target_point;
+    ScalarBoundingBox3f m_footprint = ScalarBoundingBox3f(ScalarPoint3f(-1.f, -1.f, 0.f),
+                                                          ScalarPoint3f(1.f, 1.f, 0.f));
+    ScalarBoundingSphere3f m_bsphere;
+};
+
+MTS_IMPLEMENT_CLASS_VARIANT(DistantFluxSensor, Sensor)
+MTS_EXPORT_PLUGIN(DistantFluxSensor, "DistantFluxSensor");
+NAMESPACE_END(mitsuba)
@@ -0,0 +1,185 @@
+#include <mitsuba/core/fwd.h>
+#include <mitsuba/core/properties.h>
+#include <mitsuba/core/string.h>
+#include <mitsuba/core/transform.h>
+#include <mitsuba/render/fwd.h>
+#include <mitsuba/render/sensor.h>
+
+NAMESPACE_BEGIN(mitsuba)
+
+/**!
+
+.. _sensor-mradiancemeter:
+
+Multi-radiance meter (:monosp:`mradiancemeter`)
+-----------------------------------------------
+
+.. pluginparameters::
+
+ * - origins
+   - |string|
+   - Comma-separated list of locations from which the sensors will be recording
+     in world coordinates (e.g. ``"0, 0, 1, 1, 0, 1"`` for two sensors).
+ * - directions
+   - |string|
+   - Comma-separated list of directions in which the sensors are pointing in
+     world coordinates. Must have as many entries as ``origins``.
+
+This sensor plugin aggregates an arbitrary number of :ref:`radiance meters
+<sensor-radiancemeter>`, which measure the incident power per unit area per
+unit solid angle along a set of rays. Sensor ``i`` of the list maps to pixel
+``(i, 0)`` of the film, which must have a size of N by 1 pixels for N sensors.
+
+A single call to ``render()`` thus performs the measurements of all sensors
+in the same wavefront, which is much faster than rendering thousands of
+separate :monosp:`radiancemeter` sensors with 1 by 1 pixel films.
+
+.. code-block:: xml
+
+    <sensor type="mradiancemeter">
+        <string name="origins" value="0, 0, 0,   1, 0, 0"/>
+        <string name="directions" value="0, 0, 1,   0, 1, 0"/>
+        <film type="hdrfilm">
+            <integer name="width" value="2"/>
+            <integer name="height" value="1"/>
+            <rfilter type="box"/>
+        </film>
+    </sensor>
+
+*/
+
+MTS_VARIANT class MultiRadianceMeter final : public Sensor<Float, Spectrum> {
+public:
+    MTS_IMPORT_BASE(Sensor, m_film, m_needs_sample_3)
+    MTS_IMPORT_TYPES()
+
+    using FloatStorage = DynamicBuffer<replace_scalar_t<Float, ScalarFloat>>;
+
+    MultiRadianceMeter(const Properties &props) : Base(props) {
+        if (props.has_property("to_world"))
+            Throw("Found a 'to_world' transformation -- this is not allowed. "
+                  "Use the 'origins' and 'directions' parameters instead.");
+
+        std::vector<ScalarFloat> origins    = parse_list(props, "origins"),
+                                 directions = parse_list(props, "directions");
+
+        if (origins.size() != directions.size())
+            Throw("The lists of origins and directions must have the same length!");
+
+        m_sensor_count = (uint32_t) (origins.size() / 3);
+        if (m_sensor_count == 0)
+            Throw("At least one origin and direction must be specified!");
+
+        for (uint32_t i = 0; i < m_sensor_count; ++i) {
+            ScalarVector3f d = load_unaligned<ScalarVector3f>(directions.data() + 3 * i);
+            if (squared_norm(d) == 0.f)
+                Throw("The direction of sensor %i is zero!", i);
+            store_unaligned(directions.data() + 3 * i, normalize(d));
+            m_bbox.expand(load_unaligned<ScalarPoint3f>(origins.data() + 3 * i));
+        }
+
+        m_origins    = FloatStorage::copy(origins.data(), origins.size());
+        m_directions = FloatStorage::copy(directions.data(), directions.size());
+
+        if (m_film->size() != ScalarPoint2i(m_sensor_count, 1))
+            Throw("This sensor requires a film of size %ix1 pixels (one "
+                  "pixel per sensor)!", m_sensor_count);
+
+        if (m_film->reconstruction_filter()->radius() >
+            0.5f + math::RayEpsilon<Float>)
+            Log(Warn, "This sensor should be used with a reconstruction filter "
+                      "with a radius of 0.5 or lower (e.g. default box)");
+
+        // The position sample selects the sensor, the aperture sample is unused
+        m_needs_sample_3 = false;
+    }
+
+    std::pair<Ray3f, Spectrum> sample_ray(Float time, Float wavelength_sample,
+                                          const Point2f &position_sample,
+                                          const Point2f & /*aperture_sample*/,
+                                          Mask active) const override {
+        MTS_MASKED_FUNCTION(ProfilerPhase::EndpointSampleRay, active);
+        Ray3f ray;
+        ray.time = time;
+
+        // 1. Sample spectrum
+        auto [wavelengths, wav_weight] =
+            sample_wavelength<Float, Spectrum>(wavelength_sample);
+        ray.wavelengths = wavelengths;
+
+        // 2. Look up the origin and direction of the sensor
+        UInt32 index = sensor_index(position_sample);
+        ray.o = gather<Point3f>(m_origins, index, active);
+        ray.d = gather<Vector3f>(m_directions, index, active);
+
+        ray.update();
+
+        return std::make_pair(ray, wav_weight);
+    }
+
+    std::pair<RayDifferential3f, Spectrum>
+    sample_ray_differential(Float time, Float wavelength_sample,
+                            const Point2f &position_sample,
+                            const Point2f &aperture_sample,
+                            Mask active) const override {
+        MTS_MASKED_FUNCTION(ProfilerPhase::EndpointSampleRay, active);
+
+        auto [ray, wav_weight] = sample_ray(time, wavelength_sample, position_sample,
+                                            aperture_sample, active);
+
+        // Neighboring pixels belong to unrelated sensors: no differentials
+        RayDifferential3f ray_diff(ray);
+        ray_diff.has_differentials = false;
+
+        return std::make_pair(ray_diff, wav_weight);
+    }
+
+    ScalarBoundingBox3f bbox() const override { return m_bbox; }
+
+    std::string to_string() const override {
+        std::ostringstream oss;
+        oss << "MultiRadianceMeter[" << std::endl
+            << "  sensor_count = " << m_sensor_count << "," << std::endl
+            << "  film = " << m_film << "," << std::endl
+            << "]";
+        return oss.str();
+    }
+
+    MTS_DECLARE_CLASS()
+private:
+    /// Parse a comma-separated list of 3D points or vectors
+    static std::vector<ScalarFloat> parse_list(const Properties &props,
+                                               const std::string &name) {
+        std::vector<std::string> tokens = string::tokenize(props.string(name));
+        if (tokens.size() % 3 != 0)
+            Throw("The '%s' list must contain a multiple of three values!", name);
+
+        std::vector<ScalarFloat> result(tokens.size());
+        for (size_t i = 0; i < tokens.size(); ++i) {
+            try {
+                result[i] = (ScalarFloat) std::stof(tokens[i]);
+            } catch (...) {
+                Throw("Could not parse value \"%s\" of the '%s' list!", tokens[i], name);
+            }
+        }
+        return result;
+    }
+
+    /// Map a position sample (relative to the crop window) to the sensor of its pixel
+    UInt32 sensor_index(const Point2f &position_sample) const {
+        ScalarFloat offset = (ScalarFloat) m_film->crop_offset().x(),
+                    size   = (ScalarFloat) m_film->crop_size().x();
+        return min(UInt32(max(offset + position_sample.x() * size, 0.f)),
+                   m_sensor_count - 1);
+    }
+
+private:
+    uint32_t m_sensor_count;
+    FloatStorage m_origins;
+    FloatStorage m_directions;
+    ScalarBoundingBox3f m_bbox;
+};
+
+MTS_IMPLEMENT_CLASS_VARIANT(MultiRadianceMeter, Sensor)
+MTS_EXPORT_PLUGIN(MultiRadianceMeter, "MultiRadianceMeter");
+NAMESPACE_END(mitsuba)
@@ -201,6 +201,56 @@ public:
         return std::make_pair(ray, wav_weight);
     }
 
+    /**
+     * \brief Connect a reference point to the pinhole
+     *
+     * The \c uv field of the returned sample holds the position on the film
+     * (in pixels, as expected by \ref Film::splat()), and the weight is the
+     * importance of the direction divided by the squared distance. Points
+     * outside of the clip range or of the crop window receive a zero weight.
+     */
+    std::pair<DirectionSample3f, Spectrum>
+    sample_direction(const Interaction3f &it, const Point2f & /*sample*/,
+                     Mask active) const override {
+        MTS_MASKED_FUNCTION(ProfilerPhase::EndpointSampleDirection, active);
+
+        // Transform the reference point into the local coordinate system
+        auto trafo = m_world_transform->eval(it.time, active);
+        Point3f ref_p = trafo.inverse().transform_affine(it.p);
+
+        // Check if it lies within the clip range
+        active &= ref_p.z() >= m_near_clip && ref_p.z() <= m_far_clip;
+
+        // Project onto the film (the sample space covers the crop window)
+        Point3f screen_p = m_camera_to_sample * ref_p;
+        active &= screen_p.x() >= 0.f && screen_p.x() <= 1.f &&
+                  screen_p.y() >= 0.f && screen_p.y() <= 1.f;
+
+        Vector3f local_d(ref_p);
+        Float dist = norm(local_d), inv_dist = rcp(dist);
+        local_d *= inv_dist;
+
+        DirectionSample3f ds;
+        ds.p = trafo.translation();
+        ds.n = trafo * Vector3f(0.f, 0.f, 1.f);
+        ds.uv = Point2f(screen_p.x(), screen_p.y()) * m_resolution +
+                ScalarVector2f(m_film->crop_offset());
+        ds.time = it.time;
+        ds.pdf = select(active, Float(1.f), Float(0.f));
+        ds.delta = true;
+        ds.object = this;
+        ds.d = (ds.p - it.p) * inv_dist;
+        ds.dist = dist;
+
+        Float value = importance(local_d) * inv_dist * inv_dist;
+        return { ds, unpolarized<Spectrum>(UnpolarizedSpectrum(select(active, value, 0.f))) };
+    }
+
+    Float pdf_direction(const Interaction3f &, const DirectionSample3f &,
+                        Mask) const override {
+        return 0.f;
+    }
+
     ScalarBoundingBox3f bbox() const override {
         return m_world_transform->translation_bounds();
     }
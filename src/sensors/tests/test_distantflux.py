@@ -0,0 +1,101 @@
+import pytest
+
+import enoki as ek
+import mitsuba
+
+
+def make_scene(sensor, shapes={}, radiance=None, spp=64, pixels=1):
+    from mitsuba.core.xml import load_dict
+
+    sensor = dict(sensor)
+    sensor["film"] = {
+        "type": "hdrfilm",
+        "width": pixels,
+        "height": pixels,
+        "pixel_format": "rgb",
+        "rfilter": {"type": "box"}
+    }
+    sensor["sampler"] = {"type": "independent", "sample_count": spp}
+
+    scene = {"type": "scene", "integrator": {"type": "path"}, "sensor": sensor}
+    scene.update(shapes)
+    if radiance is not None:
+        scene["emitter"] = {
+            "type": "constant",
+            "radiance": {"type": "uniform", "value": radiance}
+        }
+    return load_dict(scene)
+
+
+def render(scene):
+    import numpy as np
+
+    sensor = scene.sensors()[0]
+    scene.integrator().render(scene, sensor)
+    return np.array(sensor.film().bitmap())
+
+
+def test_construct(variant_scalar_rgb):
+    from mitsuba.core.xml import load_dict
+    from mitsuba.core import ScalarTransform4f
+
+    sensor = load_dict({"type": "distantflux", "direction": [0, 0, 1]})
+    assert not sensor.bbox().valid()  # Degenerate bounding box
+
+    # Test raise on both a direction and a transformation
+    with pytest.raises(RuntimeError):
+        load_dict({"type": "distantflux", "direction": [0, 0, 1],
+                   "to_world": ScalarTransform4f.translate([1, 0, 0])})
+
+    # Test raise on both a target point and a target shape
+    with pytest.raises(RuntimeError):
+        load_dict({"type": "distantflux", "target": [0, 0, 0],
+                   "shape": {"type": "rectangle"}})
+
+
+@pytest.mark.parametrize("radiance", [0.5, 2.0])
+def test_target_shape(variant_scalar_rgb, radiance):
+    import numpy as np
+    from mitsuba.core import ScalarTransform4f
+
+    # A target of area 16 under a constant sky: the exitant flux is pi * L * A
+    sensor = {
+        "type": "distantflux",
+        "target": {
+            "type": "rectangle",
+            "to_world": ScalarTransform4f.scale([2, 2, 1])
+        }
+    }
+
+    img = render(make_scene(sensor, radiance=radiance))
+    assert np.allclose(img, np.pi * radiance * 16, rtol=1e-4)
+
+    # Every direction bin receives the same share of the flux
+    img = render(make_scene(sensor, radiance=radiance, pixels=4))
+    assert np.allclose(np.sum(img, axis=(0, 1)), np.pi * radiance * 16, rtol=1e-4)
+    assert np.allclose(img, np.pi * radiance, rtol=1e-4)
+
+
+def test_footprint(variant_scalar_rgb):
+    import numpy as np
+    from mitsuba.core import ScalarTransform4f
+
+    # By default the origins cover the top of the scene: an emissive ground
+    # plane of area 36 with radiance 1.5 emits a flux of pi * 1.5 * 36
+    ground = {
+        "ground": {
+            "type": "rectangle",
+            "to_world": ScalarTransform4f.scale([3, 3, 1]),
+            "emitter": {
+                "type": "area",
+                "radiance": {"type": "uniform", "value": 1.5}
+            }
+        }
+    }
+
+    img = render(make_scene({"type": "distantflux"}, shapes=ground))
+    assert np.allclose(img, np.pi * 1.5 * 36, rtol=1e-3)
+
+    # Looking at the back of the ground plane, nothing is emitted
+    img = render(make_scene({"type": "distantflux", "direction": [0, 0, -1]}, shapes=ground))
+    assert np.allclose(img, 0)
@@ -0,0 +1,101 @@
+import pytest
+
+import enoki as ek
+import mitsuba
+
+
+def make_sensor(origins, directions, pixels=None):
+    from mitsuba.core.xml import load_dict
+
+    to_str = lambda values: ', '.join(str(v) for x in values for v in x)
+
+    return load_dict({
+        "type": "mradiancemeter",
+        "origins": to_str(origins),
+        "directions": to_str(directions),
+        "film": {
+            "type": "hdrfilm",
+            "width": len(origins) if pixels is None else pixels,
+            "height": 1,
+            "rfilter": {"type": "box"}
+        }
+    })
+
+
+def test_construct(variant_scalar_rgb):
+    sensor = make_sensor([[0, 0, 0], [1, 2, 3]], [[0, 0, 1], [0, 2, 0]])
+    assert ek.allclose(sensor.bbox().min, [0, 0, 0])
+    assert ek.allclose(sensor.bbox().max, [1, 2, 3])
+
+    # Test raise on mismatched lists
+    with pytest.raises(RuntimeError):
+        make_sensor([[0, 0, 0], [1, 0, 0]], [[0, 0, 1]])
+
+    # Test raise on wrong film size
+    with pytest.raises(RuntimeError):
+        make_sensor([[0, 0, 0], [1, 0, 0]], [[0, 0, 1], [0, 0, 1]], pixels=1)
+
+
+def test_sample_ray(variant_scalar_rgb):
+    origins = [[0, 0, 0], [-1, -1, 0.5], [4, 1, 0]]
+    directions = [[0, 0, 1], [-1, -1, 0], [2, 0, 0]]
+    sensor = make_sensor(origins, directions)
+
+    # Position samples are relative to the film: pixel i selects sensor i
+    for i in range(3):
+        sample1 = [(i + 0.3) / 3, 0.87]
+        sample2 = [0.16, 0.44]
+
+        ray = sensor.sample_ray(1., 1., sample1, sample2, True)
+        assert ek.allclose(ray[0].o, origins[i])
+        assert ek.allclose(ray[0].d, ek.normalize(directions[i]))
+
+        ray = sensor.sample_ray_differential(1., 1., sample1, sample2, True)
+        assert ek.allclose(ray[0].o, origins[i])
+        assert ek.allclose(ray[0].d, ek.normalize(directions[i]))
+        assert not ray[0].has_differentials
+
+
+def test_render(variants_vec_rgb):
+    # All sensors are rendered at once: each pixel measures its own ray
+    from mitsuba.core.xml import load_dict
+    import numpy as np
+
+    n = 8
+    origins = [[0, 0, 0]] * n
+    # Sensors alternately look at the emissive plane above and into the void
+    directions = [[0, 0, 1] if i % 2 == 0 else [0, 0, -1] for i in range(n)]
+
+    to_str = lambda values: ', '.join(str(v) for x in values for v in x)
+    scene = load_dict({
+        "type": "scene",
+        "integrator": { "type": "path" },
+        "sensor": {
+            "type": "mradiancemeter",
+            "origins": to_str(origins),
+            "directions": to_str(directions),
+            "film": {
+                "type": "hdrfilm",
+                "width": n,
+                "height": 1,
+                "pixel_format": "rgb",
+                "rfilter": { "type": "box" }
+            },
+            "sampler": { "type": "independent", "sample_count": 4 }
+        },
+        "shape": {
+            "type": "rectangle",
+            "to_world": mitsuba.core.ScalarTransform4f.translate([0, 0, 1]) *
+                        mitsuba.core.ScalarTransform4f.rotate([1, 0, 0], 180),
+            "emitter": {
+                "type": "area",
+                "radiance": { "type": "uniform", "value": 2.0 }
+            }
+        }
+    })
+
+    sensor = scene.sensors()[0]
+    scene.integrator().render(scene, sensor)
+    img = np.array(sensor.film().bitmap()).reshape(n, -1)
+    assert np.allclose(img[0::2], 2.0)
+    assert np.allclose(img[1::2], 0.0)
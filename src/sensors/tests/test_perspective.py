@@ -162,3 +162,31 @@ def test04_fov_axis(variant_packet_spectral, origin, direction, fov):
             check_fov(camera, sample)
 
 
+
+
+@pytest.mark.parametrize("origin", origins)
+@pytest.mark.parametrize("direction", directions)
+def test05_sample_direction(variant_packet_rgb, origin, direction):
+    # Points seen through a film position connect back to that position
+    from mitsuba.render import SurfaceInteraction3f
+
+    camera = create_camera(origin, direction)
+    pos_sample = [[0.2, 0.6, 0.5], [0.1, 0.9, 0.5]]
+    ray, _ = camera.sample_ray(0, 0, pos_sample, 0)
+
+    it = SurfaceInteraction3f.zero(3)
+    it.p = ray(10)
+    it.time = 0.0
+
+    ds, weight = camera.sample_direction(it, [0, 0])
+    assert ek.allclose(ds.uv, [[0.2 * 512, 0.6 * 512, 0.5 * 512],
+                               [0.1 * 256, 0.9 * 256, 0.5 * 256]], rtol=1e-4)
+    assert ek.allclose(ds.d, -ray.d, atol=1e-6)
+    assert ek.allclose(ds.dist, 10)
+    assert ek.allclose(ds.pdf, 1)
+    assert ek.all(weight > 0)
+
+    # Points behind the camera are not visible
+    it.p = ray(-10)
+    ds, weight = camera.sample_direction(it, [0, 0])
+    assert ek.allclose(weight, 0)
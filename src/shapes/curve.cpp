@@ -0,0 +1,478 @@
+#include <mitsuba/core/fresolver.h>
+#include <mitsuba/core/fwd.h>
+#include <mitsuba/core/math.h>
+#include <mitsuba/core/mmap.h>
+#include <mitsuba/core/profiler.h>
+#include <mitsuba/core/properties.h>
+#include <mitsuba/core/string.h>
+#include <mitsuba/core/timer.h>
+#include <mitsuba/core/transform.h>
+#include <mitsuba/core/util.h>
+#include <mitsuba/render/fwd.h>
+#include <mitsuba/render/interaction.h>
+#include <mitsuba/render/shape.h>
+
+NAMESPACE_BEGIN(mitsuba)
+
+/**!
+
+.. _shape-curve:
+
+Curves (:monosp:`curve`)
+----------------------------------------------------
+
+.. pluginparameters::
+
+ * - filename
+   - |string|
+   - Filename of the curve file that should be loaded
+ * - basis
+   - |string|
+   - Interpolation of the control points: ``bspline`` (uniform cubic
+     B-spline) or ``linear``. (Default: ``bspline``)
+ * - subdivisions
+   - |int|
+   - Number of linear pieces that approximate a B-spline segment during
+     the intersection tests (Default: 6)
+ * - to_world
+   - |transform|
+   - Specifies an optional linear object-to-world transformation. The radii
+     are scaled by the cube root of its determinant, hence non-uniform
+     scales are not permitted! (Default: none, i.e. object space = world space)
+
+This shape plugin describes a set of tubes following curves with a varying
+radius, which is meant for hair and fur. Unlike tessellated meshes or
+individual :ref:`cylinder <shape-cylinder>` shapes, only the control
+points are stored (16 bytes per point and 4 bytes per segment), and every
+curve segment is a separate primitive of the acceleration data structure.
+
+The curve file is a text file with one control point per line, given by
+its position and the radius of the tube at that point (``x y z radius``).
+Curves are separated by empty lines, and lines starting with ``#`` are
+ignored. A B-spline curve with :math:`n` control points has :math:`n - 3`
+segments (they do not interpolate the first and last control points), and
+a linear curve :math:`n - 1` segments.
+
+.. code-block:: none
+
+    # A single strand made of three B-spline segments
+    0 0 0 0.010
+    0 0 1 0.010
+    0 1 2 0.008
+    0 1 3 0.006
+    1 1 4 0.004
+    1 1 5 0.002
+
+The tubes are open, and their ``u`` texture coordinate goes along every
+segment while ``v`` goes around it. When Mitsuba is compiled with Embree,
+the native round curves of Embree are used instead of the builtin
+intersection routine, which approximates B-spline segments by
+``subdivisions`` cones. GPU variants do not support curves yet.
+
+.. code-block:: xml
+
+    <shape type="curve">
+        <string name="filename" value="hair.txt"/>
+        <bsdf type="roughconductor"/>
+    </shape>
+ */
+
+template <typename Float, typename Spectrum>
+class Curve final : public Shape<Float, Spectrum> {
+public:
+    MTS_IMPORT_BASE(Shape, m_to_world, set_children, get_children_string)
+    MTS_IMPORT_TYPES()
+
+    using typename Base::ScalarIndex;
+    using typename Base::ScalarSize;
+    using FloatStorage = DynamicBuffer<replace_scalar_t<Float, ScalarFloat>>;
+    using IndexStorage = DynamicBuffer<replace_scalar_t<Float, ScalarIndex>>;
+
+    Curve(const Properties &props) : Base(props) {
+        if constexpr (is_cuda_array_v<Float>)
+            Throw("The curve shape is not supported in GPU variants yet!");
+
+        std::string basis = props.string("basis", "bspline");
+        if (basis == "bspline")
+            m_bspline = true;
+        else if (basis == "linear")
+            m_bspline = false;
+        else
+            Throw("Invalid curve basis \"%s\", must be \"bspline\" or \"linear\"!", basis);
+
+        int subdivisions = props.int_("subdivisions", 6);
+        if (subdivisions < 1)
+            Throw("The number of subdivisions must be >= 1!");
+        m_subdivisions = m_bspline ? (uint32_t) subdivisions : 1u;
+
+        auto fs = Thread::thread()->file_resolver();
+        fs::path file_path = fs->resolve(props.string("filename"));
+        m_name = file_path.filename().string();
+
+        Log(Debug, "Loading curves from \"%s\" ..", m_name);
+        if (!fs::exists(file_path))
+            Throw("Curve file \"%s\" not found!", file_path.string());
+        ScopedLoadEvent load_event(LoadEvent::LoadGeometry, m_name);
+
+        ref<MemoryMappedFile> mmap = new MemoryMappedFile(file_path);
+        Timer timer;
+        load(file_path, (const char *) mmap->data(), mmap->size());
+
+        Log(Debug, "\"%s\": read %i curves, %i segments, %i control points (%s in %s)",
+            m_name, m_curve_count, m_segment_count, m_point_count,
+            util::mem_string(m_point_count * 4 * sizeof(ScalarFloat) +
+                             m_segment_count * sizeof(ScalarIndex)),
+            util::time_string(timer.value()));
+
+        set_children();
+    }
+
+    /// Parse the curve file and fill the control point and segment buffers
+    void load(const fs::path &file_path, const char *data, size_t size) {
+        std::vector<ScalarVector4f> points;
+        std::vector<ScalarIndex> segments;
+        size_t curve_start = 0, line_number = 0;
+        ScalarIndex min_points = m_bspline ? 4 : 2;
+        m_curve_count = 0;
+
+        auto end_curve = [&]() {
+            ScalarIndex count = ScalarIndex(points.size() - curve_start);
+            if (count == 0)
+                return;
+            if (count < min_points) {
+                Log(Warn, "\"%s\": skipping a curve with only %i control points (line %i).",
+                    m_name, count, line_number);
+                points.resize(curve_start);
+                return;
+            }
+            for (ScalarIndex i = 0; i + min_points <= count; ++i)
+                segments.push_back(ScalarIndex(curve_start) + i);
+            curve_start = points.size();
+            m_curve_count++;
+        };
+
+        // Radii follow the (uniform) scale of the transform
+        ScalarVector3f x = m_to_world.transform_affine(ScalarVector3f(1.f, 0.f, 0.f)),
+                       y = m_to_world.transform_affine(ScalarVector3f(0.f, 1.f, 0.f)),
+                       z = m_to_world.transform_affine(ScalarVector3f(0.f, 0.f, 1.f));
+        ScalarFloat radius_scale = std::cbrt(std::abs(dot(x, cross(y, z))));
+
+        const char *cur = data, *eof = data + size;
+        while (cur < eof) {
+            const char *eol = cur;
+            while (eol < eof && *eol != '\n')
+                ++eol;
+            line_number++;
+
+            // Skip leading whitespace
+            while (cur < eol && (*cur == ' ' || *cur == '\t' || *cur == '\r'))
+                ++cur;
+
+            if (cur == eol) {
+                end_curve();
+            } else if (*cur != '#') {
+                ScalarFloat v[4];
+                for (int i = 0; i < 4; ++i) {
+                    char *next;
+                    v[i] = string::parse_float(cur, &next);
+                    if (next == cur || next > eol)
+                        Throw("Error while parsing \"%s\" (line %i): expected four "
+                              "values (x y z radius)!", file_path.string(), line_number);
+                    cur = next;
+                }
+                ScalarPoint3f p = m_to_world.transform_affine(ScalarPoint3f(v[0], v[1], v[2]));
+                points.emplace_back(p.x(), p.y(), p.z(), v[3] * radius_scale);
+            }
+            cur = eol + 1;
+        }
+        end_curve();
+
+        if (segments.empty())
+            Throw("\"%s\": the file does not contain any curves!", m_name);
+
+        m_point_count = ScalarSize(points.size());
+        m_segment_count = ScalarSize(segments.size());
+
+        m_control_points_buf = FloatStorage::copy((const ScalarFloat *) points.data(),
+                                                  m_point_count * 4);
+        m_segments_buf = IndexStorage::copy(segments.data(), m_segment_count);
+
+        m_bbox.reset();
+        for (const ScalarVector4f &p : points)
+            m_bbox.expand(point_bbox(p));
+    }
+
+    ScalarBoundingBox3f bbox() const override { return m_bbox; }
+
+    ScalarBoundingBox3f bbox(ScalarIndex index) const override {
+        Assert(index < m_segment_count);
+
+        // The tube around a B-spline segment stays within the convex hull of its control points
+        ScalarIndex first = gather<ScalarIndex>(m_segments_buf, index);
+        ScalarBoundingBox3f result;
+        for (ScalarIndex i = 0; i < (m_bspline ? 4u : 2u); ++i) {
+            ScalarVector4f p = gather<ScalarVector4f>(m_control_points_buf, first + i);
+            result.expand(point_bbox(p));
+        }
+        return result;
+    }
+
+    ScalarSize primitive_count() const override { return m_segment_count; }
+
+    ScalarFloat surface_area() const override {
+        // Lateral area of the cones used by the intersection routine
+        ScalarFloat area = 0.f;
+        for (ScalarIndex i = 0; i < m_segment_count; ++i) {
+            ScalarVector4f p[4];
+            load_segment(i, p);
+            ScalarVector4f prev = eval(p, 0.f).first;
+            for (uint32_t j = 1; j <= m_subdivisions; ++j) {
+                ScalarVector4f next = eval(p, j / (ScalarFloat) m_subdivisions).first;
+                // Slant height of the cone (the radius is the last component)
+                area += math::Pi<ScalarFloat> * (prev.w() + next.w()) * norm(next - prev);
+                prev = next;
+            }
+        }
+        return area;
+    }
+
+    // =============================================================
+    //! @{ \name Ray tracing routines
+    // =============================================================
+
+    PreliminaryIntersection3f ray_intersect_preliminary(const Ray3f &ray,
+                                                        Mask active) const override {
+        MTS_MASK_ARGUMENT(active);
+
+        // Brute force: only used when the shape is intersected outside of a scene
+        PreliminaryIntersection3f pi = zero<PreliminaryIntersection3f>();
+        pi.t = math::Infinity<Float>;
+        for (ScalarIndex i = 0; i < m_segment_count; ++i) {
+            PreliminaryIntersection3f prim_pi = ray_intersect_primitive(i, ray, active);
+            masked(pi, prim_pi.t < pi.t) = prim_pi;
+        }
+        pi.shape = this;
+        return pi;
+    }
+
+    Mask ray_test(const Ray3f &ray, Mask active) const override {
+        MTS_MASK_ARGUMENT(active);
+        return ray_intersect_preliminary(ray, active).is_valid();
+    }
+
+    PreliminaryIntersection3f ray_intersect_primitive(ScalarIndex index, const Ray3f &ray,
+                                                      Mask active) const override {
+        MTS_MASK_ARGUMENT(active);
+
+        ScalarVector4f p[4];
+        load_segment(index, p);
+
+        PreliminaryIntersection3f pi = zero<PreliminaryIntersection3f>();
+        pi.t = math::Infinity<Float>;
+
+        ScalarFloat du = 1.f / m_subdivisions;
+        ScalarVector4f prev = eval(p, 0.f).first;
+        for (uint32_t i = 1; i <= m_subdivisions; ++i) {
+            ScalarVector4f next = eval(p, i * du).first;
+            intersect_cone(pi, ray, prev, next, (i - 1) * du, du, active);
+            prev = next;
+        }
+
+        pi.prim_index = index;
+        pi.shape = this;
+        return pi;
+    }
+
+    Mask ray_test_primitive(ScalarIndex index, const Ray3f &ray,
+                            Mask active) const override {
+        MTS_MASK_ARGUMENT(active);
+        return ray_intersect_primitive(index, ray, active).is_valid();
+    }
+
+    SurfaceInteraction3f compute_surface_interaction(const Ray3f &ray,
+                                                     PreliminaryIntersection3f pi,
+                                                     HitComputeFlags flags,
+                                                     Mask active) const override {
+        MTS_MASK_ARGUMENT(active);
+
+        active &= pi.is_valid();
+
+        SurfaceInteraction3f si = zero<SurfaceInteraction3f>();
+        si.t = select(active, pi.t, math::Infinity<Float>);
+        si.p = ray(pi.t);
+
+        // Evaluate the curve at the parameter of the hit (also set by Embree)
+        UInt32 first = gather<UInt32>(m_segments_buf, pi.prim_index, active);
+        Vector4f p[4];
+        for (uint32_t i = 0; i < (m_bspline ? 4u : 2u); ++i)
+            p[i] = gather<Vector4f>(m_control_points_buf, first + i, active);
+        auto [c, dc] = eval(p, pi.prim_uv.x());
+
+        Vector3f dc_du(dc.x(), dc.y(), dc.z());
+        Float inv_length = rsqrt(squared_norm(dc_du));
+        Vector3f w = dc_du * inv_length;
+
+        // Direction from the center line to the hit point
+        Vector3f e = si.p - Point3f(c.x(), c.y(), c.z());
+        e = fnmadd(w, dot(e, w), e);
+        Float e_norm2 = squared_norm(e);
+        e = select(e_norm2 > 0.f, e * rsqrt(e_norm2), coordinate_system(w).first);
+
+        // Tilt the normal of the tube according to the variation of the radius
+        si.n = Normal3f(normalize(fnmadd(w, dc.w() * inv_length, e)));
+        si.sh_frame.n = si.n;
+
+        auto [s, t] = coordinate_system(w);
+        Float phi = atan2(dot(e, t), dot(e, s));
+        masked(phi, phi < 0.f) += 2.f * math::Pi<Float>;
+        si.uv = Point2f(pi.prim_uv.x(), phi * math::InvTwoPi<Float>);
+
+        si.dp_du = dc_du;
+        si.dp_dv = cross(w, e) * (2.f * math::Pi<Float> * c.w());
+        si.time = ray.time;
+
+        if (has_flag(flags, HitComputeFlags::dNSdUV)) {
+            si.dn_du = Vector3f(0.f);
+            si.dn_dv = cross(w, e) * (2.f * math::Pi<Float>);
+        }
+
+        return si;
+    }
+
+    //! @}
+    // =============================================================
+
+#if defined(MTS_ENABLE_EMBREE)
+    RTCGeometry embree_geometry(RTCDevice device) override {
+        if constexpr (!is_cuda_array_v<Float>) {
+            RTCGeometry geom = rtcNewGeometry(device, m_bspline
+                                                          ? RTC_GEOMETRY_TYPE_ROUND_BSPLINE_CURVE
+                                                          : RTC_GEOMETRY_TYPE_ROUND_LINEAR_CURVE);
+            rtcSetSharedGeometryBuffer(geom, RTC_BUFFER_TYPE_VERTEX, 0, RTC_FORMAT_FLOAT4,
+                                       m_control_points_buf.data(), 0, 4 * sizeof(ScalarFloat),
+                                       m_point_count);
+            rtcSetSharedGeometryBuffer(geom, RTC_BUFFER_TYPE_INDEX, 0, RTC_FORMAT_UINT,
+                                       m_segments_buf.data(), 0, sizeof(ScalarIndex),
+                                       m_segment_count);
+            rtcCommitGeometry(geom);
+            return geom;
+        } else {
+            Throw("embree_geometry() should only be called in CPU mode.");
+        }
+    }
+#endif
+
+    std::string to_string() const override {
+        std::ostringstream oss;
+        oss << "Curve[" << std::endl
+            << "  name = \"" << m_name << "\"," << std::endl
+            << "  basis = " << (m_bspline ? "bspline" : "linear") << "," << std::endl
+            << "  bbox = " << string::indent(m_bbox) << "," << std::endl
+            << "  curve_count = " << m_curve_count << "," << std::endl
+            << "  segment_count = " << m_segment_count << "," << std::endl
+            << "  point_count = " << m_point_count << "," << std::endl
+            << "  " << string::indent(get_children_string()) << std::endl
+            << "]";
+        return oss.str();
+    }
+
+    MTS_DECLARE_CLASS()
+private:
+    /// Bounding box of the sphere around a control point
+    static ScalarBoundingBox3f point_bbox(const ScalarVector4f &p) {
+        ScalarPoint3f center(p.x(), p.y(), p.z());
+        return ScalarBoundingBox3f(center - p.w(), center + p.w());
+    }
+
+    /// Fetch the control points of a segment (4 for B-splines, 2 for linear curves)
+    MTS_INLINE void load_segment(ScalarIndex index, ScalarVector4f *p) const {
+        ScalarIndex first = gather<ScalarIndex>(m_segments_buf, index);
+        for (ScalarIndex i = 0; i < (m_bspline ? 4u : 2u); ++i)
+            p[i] = gather<ScalarVector4f>(m_control_points_buf, first + i);
+    }
+
+    /// Evaluate the position and radius of a segment and their derivative at \c u
+    template <typename Vector4, typename Value>
+    MTS_INLINE std::pair<Vector4, Vector4> eval(const Vector4 *p, const Value &u) const {
+        if (!m_bspline)
+            return { p[0] * (1.f - u) + p[1] * u, p[1] - p[0] };
+
+        // Uniform cubic B-spline basis functions and their derivatives
+        Value u2 = sqr(u), u3 = u2 * u, v = 1.f - u;
+        Value b0 = v * v * v * (1.f / 6.f),
+              b1 = (3.f * u3 - 6.f * u2 + 4.f) * (1.f / 6.f),
+              b2 = (-3.f * u3 + 3.f * u2 + 3.f * u + 1.f) * (1.f / 6.f),
+              b3 = u3 * (1.f / 6.f);
+        Value d0 = -.5f * sqr(v),
+              d1 = (3.f * u2 - 4.f * u) * .5f,
+              d2 = (-3.f * u2 + 2.f * u + 1.f) * .5f,
+              d3 = .5f * u2;
+
+        return { p[0] * b0 + p[1] * b1 + p[2] * b2 + p[3] * b3,
+                 p[0] * d0 + p[1] * d1 + p[2] * d2 + p[3] * d3 };
+    }
+
+    /**
+     * \brief Intersect the open cone between the points \c a and \c b (with
+     * their radius in the last component), and update \c pi if the hit is
+     * closer. The segment parameter of the hit is mapped to
+     * <tt>[u0, u0 + du]</tt>.
+     */
+    MTS_INLINE void intersect_cone(PreliminaryIntersection3f &pi, const Ray3f &ray,
+                                   const ScalarVector4f &a, const ScalarVector4f &b,
+                                   ScalarFloat u0, ScalarFloat du, Mask active) const {
+        ScalarPoint3f p0(a.x(), a.y(), a.z()), p1(b.x(), b.y(), b.z());
+        ScalarFloat length = norm(p1 - p0);
+        if (unlikely(length == 0.f))
+            return;
+        Vector3f w((p1 - p0) / length);
+        ScalarFloat slope = (b.w() - a.w()) / length;
+
+        /* Move the ray origin next to the segment, which avoids the
+           cancellation of the large terms of the quadratic equation */
+        Float dd = squared_norm(ray.d),
+              t0 = dot(Point3f(p0 + .5f * (p1 - p0)) - ray.o, ray.d) / dd;
+        Vector3f m = ray(t0) - Point3f(p0);
+
+        Float dw = dot(ray.d, w), mw = dot(m, w),
+              rho = fmadd(slope, mw, a.w()), sigma = slope * dw;
+
+        Float A = dd - sqr(dw) - sqr(sigma),
+              B = 2.f * (dot(m, ray.d) - dw * mw - rho * sigma),
+              C = squared_norm(m) - sqr(mw) - sqr(rho);
+
+        auto [solution_found, near_t, far_t] = math::solve_quadratic(A, B, C);
+
+        // Hits must be on the segment, and not on the mirrored nappe of the cone
+        auto valid = [&](const Float &t) {
+            Float z = fmadd(dw, t, mw);
+            return z >= 0.f && z <= length && fmadd(sigma, t, rho) >= 0.f &&
+                   t + t0 >= ray.mint && t + t0 <= ray.maxt && t + t0 < pi.t;
+        };
+
+        active &= solution_found;
+        Mask near_valid = active && valid(near_t),
+             far_valid  = active && !near_valid && valid(far_t),
+             hit        = near_valid || far_valid;
+
+        Float t = select(near_valid, near_t, far_t);
+        masked(pi.t, hit) = t + t0;
+        masked(pi.prim_uv, hit) = Point2f(u0 + du * fmadd(dw, t, mw) / length, 0.f);
+    }
+
+private:
+    std::string m_name;
+    bool m_bspline;
+    uint32_t m_subdivisions;
+    ScalarSize m_curve_count = 0, m_segment_count = 0, m_point_count = 0;
+    ScalarBoundingBox3f m_bbox;
+
+    /// Control points (position and radius in world space)
+    FloatStorage m_control_points_buf;
+    /// Index of the first control point of every segment
+    IndexStorage m_segments_buf;
+};
+
+MTS_IMPLEMENT_CLASS_VARIANT(Curve, Shape)
+MTS_EXPORT_PLUGIN(Curve, "Curve intersection primitive");
+NAMESPACE_END(mitsuba)
@@ -1,6 +1,7 @@
 #include <mitsuba/core/fwd.h>
 #include <mitsuba/core/math.h>
 #include <mitsuba/core/properties.h>
+#include <mitsuba/core/string.h>
 #include <mitsuba/core/transform.h>
 #include <mitsuba/core/util.h>
 #include <mitsuba/core/warp.h>
@@ -333,6 +334,15 @@ public:
         return valid_intersection;
     }
 
+    AnalyticShape analytic_parameters(ScalarFloat params[AnalyticParameterCount]) const override {
+        for (size_t i = 0; i < 3; ++i)
+            for (size_t j = 0; j < 4; ++j)
+                params[4 * i + j] = m_to_object.matrix(i, j);
+        params[12] = m_radius;
+        params[13] = m_length;
+        return AnalyticShape::Cylinder;
+    }
+
     SurfaceInteraction3f compute_surface_interaction(const Ray3f &ray,
                                                      PreliminaryIntersection3f pi,
                                                      HitComputeFlags flags,
@@ -394,12 +404,14 @@ public:
         Base::traverse(callback);
     }
 
-    void parameters_changed(const std::vector<std::string> &/*keys*/) override {
-        update();
-        Base::parameters_changed();
+    void parameters_changed(const std::vector<std::string> &keys) override {
+        if (keys.empty() || string::contains(keys, "to_world")) {
+            update();
 #if defined(MTS_ENABLE_OPTIX)
-        optix_prepare_geometry();
+            optix_prepare_geometry();
 #endif
+        }
+        Base::parameters_changed(keys);
     }
 
 #if defined(MTS_ENABLE_OPTIX)
@@ -110,6 +110,10 @@ public:
         return math::Pi<ScalarFloat> * m_du * h;
     }
 
+    std::pair<ScalarVector3f, ScalarFloat> normal_cone() const override {
+        return { ScalarVector3f(m_frame.n), 1.f };
+    }
+
     // =============================================================
     //! @{ \name Sampling routines
     // =============================================================
@@ -176,6 +180,13 @@ public:
                       && local.x()*local.x() + local.y()*local.y() <= 1;
     }
 
+    AnalyticShape analytic_parameters(ScalarFloat params[AnalyticParameterCount]) const override {
+        for (size_t i = 0; i < 3; ++i)
+            for (size_t j = 0; j < 4; ++j)
+                params[4 * i + j] = m_to_object.matrix(i, j);
+        return AnalyticShape::Disk;
+    }
+
     SurfaceInteraction3f compute_surface_interaction(const Ray3f &ray,
                                                      PreliminaryIntersection3f pi,
                                                      HitComputeFlags flags,
@@ -228,12 +239,14 @@ public:
         Base::traverse(callback);
     }
 
-    void parameters_changed(const std::vector<std::string> &/*keys*/) override {
-        update();
-        Base::parameters_changed();
+    void parameters_changed(const std::vector<std::string> &keys) override {
+        if (keys.empty() || string::contains(keys, "to_world")) {
+            update();
 #if defined(MTS_ENABLE_OPTIX)
-        optix_prepare_geometry();
+            optix_prepare_geometry();
 #endif
+        }
+        Base::parameters_changed(keys);
     }
 
 #if defined(MTS_ENABLE_OPTIX)
@@ -5,7 +5,10 @@
 #include <mitsuba/core/transform.h>
 #include <mitsuba/render/interaction.h>
 #include <mitsuba/render/bsdf.h>
+#include <mitsuba/render/emitter.h>
 #include <mitsuba/render/shapegroup.h>
+#include <mitsuba/core/spectrum.h>
+#include <mitsuba/core/warp.h>
 
 #if defined(MTS_ENABLE_EMBREE)
     #include <embree3/rtcore.h>
@@ -14,6 +17,9 @@
 
 NAMESPACE_BEGIN(mitsuba)
 
+template <typename Float, typename Spectrum>
+class InstanceAreaLight;
+
 /**!
 
 .. _shape-instance:
@@ -27,8 +33,9 @@ Instance (:monosp:`instance`)
    - :paramtype:`shapegroup`
    - A reference to a shape group that should be instantiated.
  * - to_world
-   - |transform|
-   - Specifies a linear object-to-world transformation. (Default: none (i.e. object space = world space))
+   - |transform| or :monosp:`animation`
+   - Specifies a linear object-to-world transformation, or a keyframed sequence of them (see below).
+     (Default: none (i.e. object space = world space))
 
 This plugin implements a geometry instance used to efficiently replicate geometry many times. For
 details on how to create instances, refer to the :ref:`shape-shapegroup` plugin.
@@ -40,30 +47,74 @@ details on how to create instances, refer to the :ref:`shape-shapegroup` plugin.
     The Stanford bunny loaded a single time and instantiated 1365 times (equivalent to 100 million
     triangles)
 
+Instances support motion blur: when ``to_world`` is specified as an animation, the transformation
+is interpolated between its keyframes at the time of each ray, and the instance stays at rest before
+the first and after the last keyframe.
+
+.. code-block:: xml
+
+    <shape type="instance">
+        <ref id="my_shape_group"/>
+        <animation name="to_world">
+            <transform time="0">
+                <translate x="0"/>
+            </transform>
+            <transform time="1">
+                <translate x="1"/>
+                <rotate y="1" angle="45"/>
+            </transform>
+        </animation>
+    </shape>
+
+Animated instances are only supported by the native ray tracing kernels, where the BVH holding
+the instances (see the ``instance_bvh`` and ``accel`` scene parameters) interpolates the bounds of
+its nodes along the time of the ray as well.
+
+Shapes with an attached :ref:`area <emitter-area>` emitter can be instanced as well, e.g. to
+replicate a light fixture thousands of times without flattening the scene. Every instance of such a
+group is then a separate emitter of the scene (so that the ``emitter_sampler`` of the scene can pick
+the instances that matter), which samples the emissive shapes of the group through the
+transformation of the instance. The shapes are chosen proportionally to their area, and the
+sampling distributions of meshes are shared by all instances. The emitted radiance is specified
+once, by the emitters within the shape group. Emissive instances are only supported by the CPU
+variants.
+
 .. warning::
 
     - Note that it is not possible to assign a different material to each instance — the material
       assignment specified within the shape group is the one that matters.
-    - Shape groups cannot be used to replicate shapes with attached emitters, sensors, or
-      subsurface scattering models.
+    - Shape groups cannot be used to replicate shapes with attached sensors or subsurface
+      scattering models.
 
  */
 
 template <typename Float, typename Spectrum>
 class Instance final: public Shape<Float, Spectrum> {
 public:
-    MTS_IMPORT_BASE(Shape, m_id, m_to_world, m_to_object)
+    MTS_IMPORT_BASE(Shape, m_id, m_to_world, m_to_object, m_emitter, set_children)
     MTS_IMPORT_TYPES(BSDF, ShapeGroup)
 
     using typename Base::ScalarSize;
+    using typename Base::ScalarIndex;
 
     Instance(const Properties &props) {
         m_id = props.id();
 
-        m_to_world = props.transform("to_world", ScalarTransform4f());
+        if (props.has_property("to_world") &&
+            props.type("to_world") == Properties::Type::Object) {
+            m_animation = props.animated_transform("to_world");
+            m_to_world = m_animation->eval(ScalarFloat((*m_animation)[0].time));
+            if (m_animation->size() < 2)
+                m_animation = nullptr;
+        } else {
+            m_to_world = props.transform("to_world", ScalarTransform4f());
+        }
         m_to_object = m_to_world.inverse();
+        update_affine();
 
         for (auto &kv : props.objects()) {
+            if (kv.first == "to_world")
+                continue;
             Base *shape = dynamic_cast<Base *>(kv.second.get());
             if (shape && shape->is_shapegroup()) {
                 if (m_shapegroup)
@@ -76,6 +127,12 @@ public:
 
         if (!m_shapegroup)
             Throw("A reference to a 'shapegroup' must be specified!");
+
+        // Every instance of emissive shapes is a separate emitter of the scene
+        if (m_shapegroup->has_emitters()) {
+            m_emitter = new InstanceAreaLight<Float, Spectrum>(Properties("instance_area"));
+            set_children();
+        }
     }
 
     ScalarBoundingBox3f bbox() const override {
@@ -85,12 +142,38 @@ public:
         if (!bbox.valid())
             return bbox;
 
+        if (m_animation) {
+            ScalarVector2f range = motion_time_range();
+            ScalarBoundingBox3f result;
+            for (const ScalarBoundingBox3f &box : sample_bbox(range.x(), range.y()).second)
+                result.expand(box);
+            return result;
+        }
+
         ScalarBoundingBox3f result;
         for (int i = 0; i < 8; ++i)
             result.expand(m_to_world * bbox.corner(i));
         return result;
     }
 
+    bool has_motion() const override { return m_animation != nullptr; }
+
+    ScalarVector2f motion_time_range() const override {
+        if (!m_animation)
+            return Base::motion_time_range();
+        return ScalarVector2f((*m_animation)[0].time,
+                              (*m_animation)[m_animation->size() - 1].time);
+    }
+
+    std::pair<ScalarBoundingBox3f, ScalarBoundingBox3f>
+    bbox_motion(ScalarIndex index, ScalarFloat time_start,
+                ScalarFloat time_end) const override {
+        if (!m_animation || !m_shapegroup->bbox().valid())
+            return Base::bbox_motion(index, time_start, time_end);
+        auto [times, boxes] = sample_bbox(time_start, time_end);
+        return Base::fit_linear_bounds(times, boxes);
+    }
+
     ScalarSize primitive_count() const override { return 1; }
 
     ScalarSize effective_primitive_count() const override {
@@ -100,6 +183,64 @@ public:
     //! @}
     // =============================================================
 
+    // =============================================================
+    //! @{ \name Sampling routines
+    // =============================================================
+
+    /**
+     * \brief Sample a point on the emissive shapes of the shape group, in
+     * world space, and also return the shape that was chosen
+     *
+     * The density of the object space sample (see \ref
+     * ShapeGroup::sample_emitter_position()) is converted to world space
+     * using the change in area caused by the transformation at that point.
+     */
+    std::pair<PositionSample3f, ShapePtr> sample_emitter(Float time, const Point2f &sample,
+                                                         Mask active) const {
+        MTS_MASK_ARGUMENT(active);
+
+        auto [ps, shape] = m_shapegroup->sample_emitter_position(time, sample, active);
+
+        if (likely(!m_animation)) {
+            to_world_sample(ps, m_affine_to_world, m_affine_det);
+        } else {
+            Transform4f to_world = m_animation->eval(time, active);
+            to_world_sample(ps, to_world, transform_det(to_world));
+        }
+
+        ps.object = (const Object *) this;
+        return { ps, shape };
+    }
+
+    PositionSample3f sample_position(Float time, const Point2f &sample,
+                                     Mask active) const override {
+        if (!m_shapegroup->has_emitters())
+            Throw("Instance: only the emissive shapes of a shape group can be sampled!");
+        return sample_emitter(time, sample, active).first;
+    }
+
+    Float pdf_position(const PositionSample3f &ps, Mask active) const override {
+        MTS_MASK_ARGUMENT(active);
+
+        if (!m_shapegroup->has_emitters())
+            Throw("Instance: only the emissive shapes of a shape group can be sampled!");
+
+        /* The density of the group is constant in object space. Transforming
+           the normal to object space yields the inverse of the area change */
+        Float pdf;
+        if (likely(!m_animation)) {
+            pdf = norm(m_affine_to_object.transform_affine(ps.n)) / m_affine_det;
+        } else {
+            Transform4f to_world = m_animation->eval(ps.time, active);
+            pdf = norm(to_world.inverse().transform_affine(ps.n)) / transform_det(to_world);
+        }
+
+        return select(active, pdf / m_shapegroup->emitter_area(), 0.f);
+    }
+
+    //! @}
+    // =============================================================
+
     // =============================================================
     //! @{ \name Ray tracing routines
     // =============================================================
@@ -108,8 +249,13 @@ public:
                                                         Mask active) const override {
         MTS_MASK_ARGUMENT(active);
 
-        PreliminaryIntersection3f pi = m_shapegroup->ray_intersect_preliminary(
-            m_to_object.transform_affine(ray), active);
+        PreliminaryIntersection3f pi;
+        if (likely(!m_animation))
+            pi = m_shapegroup->ray_intersect_preliminary(
+                m_affine_to_object.transform_affine(ray), active);
+        else
+            pi = m_shapegroup->ray_intersect_preliminary(
+                m_animation->eval(ray.time, active).inverse().transform_affine(ray), active);
 
         pi.instance = this;
 
@@ -118,7 +264,10 @@ public:
 
     Mask ray_test(const Ray3f &ray, Mask active) const override {
         MTS_MASK_ARGUMENT(active);
-        return m_shapegroup->ray_test(m_to_object.transform_affine(ray), active);
+        if (likely(!m_animation))
+            return m_shapegroup->ray_test(m_affine_to_object.transform_affine(ray), active);
+        return m_shapegroup->ray_test(
+            m_animation->eval(ray.time, active).inverse().transform_affine(ray), active);
     }
 
     SurfaceInteraction3f compute_surface_interaction(const Ray3f &ray,
@@ -127,59 +276,48 @@ public:
                                                      Mask active) const override {
         MTS_MASK_ARGUMENT(active);
 
-        SurfaceInteraction3f si = m_shapegroup->compute_surface_interaction(
-            m_to_object.transform_affine(ray), pi, flags, active);
-
-        si.p = m_to_world.transform_affine(si.p);
-        si.n = normalize(m_to_world.transform_affine(si.n));
+        if (likely(!m_animation))
+            return compute_surface_interaction_impl(ray, pi, flags, active,
+                                                    m_affine_to_world, m_affine_to_object);
 
-        if (likely(has_flag(flags, HitComputeFlags::ShadingFrame))) {
-            si.sh_frame.n = normalize(m_to_world.transform_affine(si.sh_frame.n));
-            si.initialize_sh_frame();
-        }
-
-        if (likely(has_flag(flags, HitComputeFlags::dPdUV))) {
-            si.dp_du = m_to_world.transform_affine(si.dp_du);
-            si.dp_dv = m_to_world.transform_affine(si.dp_dv);
-        }
-
-        if (has_flag(flags, HitComputeFlags::dNGdUV) || has_flag(flags, HitComputeFlags::dNSdUV)) {
-            Normal3f n = has_flag(flags, HitComputeFlags::dNGdUV) ? si.n : si.sh_frame.n;
+        Transform4f to_world = m_animation->eval(ray.time, active);
+        return compute_surface_interaction_impl(ray, pi, flags, active,
+                                                to_world, to_world.inverse());
+    }
 
-            // Determine the length of the transformed normal before it was re-normalized
-            Normal3f tn = m_to_world.transform_affine(
-                normalize(m_to_object.transform_affine(n)));
-            Float inv_len = rcp(norm(tn));
-            tn *= inv_len;
+    //! @}
+    // =============================================================
 
-            // Apply transform to dn_du and dn_dv
-            si.dn_du = m_to_world.transform_affine(Normal3f(si.dn_du)) * inv_len;
-            si.dn_dv = m_to_world.transform_affine(Normal3f(si.dn_dv)) * inv_len;
+    void traverse(TraversalCallback *callback) override {
+        // The referenced shape group is a child of the scene and traversed there
+        callback->put_parameter("to_world", m_to_world);
+    }
 
-            si.dn_du -= tn * dot(tn, si.dn_du);
-            si.dn_dv -= tn * dot(tn, si.dn_dv);
+    void parameters_changed(const std::vector<std::string> &keys) override {
+        if (keys.empty() || string::contains(keys, "to_world")) {
+            m_to_object = m_to_world.inverse();
+            update_affine();
         }
-
-        si.instance = this;
-
-        return si;
+        Base::parameters_changed(keys);
     }
 
-    //! @}
-    // =============================================================
-
     std::string to_string() const override {
         std::ostringstream oss;
             oss << "Instance[" << std::endl
                 << "  shapegroup = " << string::indent(m_shapegroup) << std::endl
-                << "  to_world = " << string::indent(m_to_world, 13) << "," << std::endl
-                << "]";
+                << "  to_world = " << string::indent(m_to_world, 13) << "," << std::endl;
+            if (m_animation)
+                oss << "  animation = " << string::indent(m_animation) << "," << std::endl;
+            oss << "]";
         return oss.str();
     }
 
 #if defined(MTS_ENABLE_EMBREE)
     RTCGeometry embree_geometry(RTCDevice device) override {
         if constexpr (!is_cuda_array_v<Float>) {
+            if (m_animation)
+                Log(Warn, "Instance: animated transformations are not supported by "
+                          "Embree, using the first keyframe.");
             RTCGeometry instance = m_shapegroup->embree_geometry(device);
             rtcSetGeometryTimeStepCount(instance, 1);
             rtcSetGeometryTransform(instance, 0, RTC_FORMAT_FLOAT4X4_COLUMN_MAJOR, &m_to_world.matrix);
@@ -196,6 +334,9 @@ public:
                                    std::vector<OptixInstance>& instances,
                                    uint32_t instance_id,
                                    const ScalarTransform4f& transf) override {
+        if (m_animation)
+            Log(Warn, "Instance: animated transformations are not supported by "
+                      "OptiX, using the first keyframe.");
         m_shapegroup->optix_prepare_ias(context, instances, instance_id, transf * m_to_world);
     }
 
@@ -207,9 +348,275 @@ public:
 
     MTS_DECLARE_CLASS()
 private:
+    friend class InstanceAreaLight<Float, Spectrum>;
+
+    /**
+     * \brief Update the compact copies of the static transformation that are
+     * used during ray traversal
+     *
+     * The inverse is derived from the compact world transformation, which is
+     * cheap when it is rigid or uniformly scaled.
+     */
+    void update_affine() {
+        m_affine_to_world = ScalarAffineTransform4f(m_to_world);
+        m_affine_to_object = m_affine_to_world.inverse();
+        m_affine_det = transform_det(m_affine_to_world);
+    }
+
+    /// Absolute value of the determinant of the linear part of a transformation
+    template <typename Transform> static auto transform_det(const Transform &trafo) {
+        auto x = trafo.transform_affine(ScalarVector3f(1.f, 0.f, 0.f)),
+             y = trafo.transform_affine(ScalarVector3f(0.f, 1.f, 0.f)),
+             z = trafo.transform_affine(ScalarVector3f(0.f, 0.f, 1.f));
+        return abs(dot(x, cross(y, z)));
+    }
+
+    /**
+     * \brief Transform an object space position sample of the shape group to
+     * world space
+     *
+     * Under the linear part \c M of the transformation, a surface element
+     * with normal \c n is scaled by <tt>|det(M)| * |M^-T n|</tt>.
+     */
+    template <typename Transform>
+    static void to_world_sample(PositionSample3f &ps, const Transform &to_world,
+                                const Float &det) {
+        Normal3f n = to_world.transform_affine(ps.n);
+        Float n_norm = norm(n);
+
+        ps.p = to_world.transform_affine(ps.p);
+        ps.n = n / n_norm;
+        ps.pdf /= det * n_norm;
+    }
+
+    /// Transform the interaction computed by the shape group to world space
+    template <typename Transform>
+    SurfaceInteraction3f compute_surface_interaction_impl(const Ray3f &ray,
+                                                          PreliminaryIntersection3f pi,
+                                                          HitComputeFlags flags,
+                                                          Mask active,
+                                                          const Transform &to_world,
+                                                          const Transform &to_object) const {
+        SurfaceInteraction3f si = m_shapegroup->compute_surface_interaction(
+            to_object.transform_affine(ray), pi, flags, active);
+
+        si.p = to_world.transform_affine(si.p);
+        si.n = normalize(to_world.transform_affine(si.n));
+
+        if (likely(has_flag(flags, HitComputeFlags::ShadingFrame))) {
+            si.sh_frame.n = normalize(to_world.transform_affine(si.sh_frame.n));
+            si.initialize_sh_frame();
+        }
+
+        if (likely(has_flag(flags, HitComputeFlags::dPdUV))) {
+            si.dp_du = to_world.transform_affine(si.dp_du);
+            si.dp_dv = to_world.transform_affine(si.dp_dv);
+        }
+
+        if (has_flag(flags, HitComputeFlags::dNGdUV) || has_flag(flags, HitComputeFlags::dNSdUV)) {
+            Normal3f n = has_flag(flags, HitComputeFlags::dNGdUV) ? si.n : si.sh_frame.n;
+
+            // Determine the length of the transformed normal before it was re-normalized
+            Normal3f tn = to_world.transform_affine(
+                normalize(to_object.transform_affine(n)));
+            Float inv_len = rcp(norm(tn));
+            tn *= inv_len;
+
+            // Apply transform to dn_du and dn_dv
+            si.dn_du = to_world.transform_affine(Normal3f(si.dn_du)) * inv_len;
+            si.dn_dv = to_world.transform_affine(Normal3f(si.dn_dv)) * inv_len;
+
+            si.dn_du -= tn * dot(tn, si.dn_du);
+            si.dn_dv -= tn * dot(tn, si.dn_dv);
+        }
+
+        si.instance = this;
+
+        return si;
+    }
+
+    /**
+     * \brief Sample the world space bounds of the instance throughout the
+     * time interval <tt>[time_start, time_end]</tt>
+     *
+     * The samples include the keyframes and are padded by half the distance
+     * that the corners travel until the next sample, which accounts for the
+     * rotational motion in between.
+     */
+    std::pair<std::vector<ScalarFloat>, std::vector<ScalarBoundingBox3f>>
+    sample_bbox(ScalarFloat time_start, ScalarFloat time_end) const {
+        const ScalarBoundingBox3f &bbox = m_shapegroup->bbox();
+
+        std::vector<ScalarFloat> keyframes = { time_start };
+        for (size_t i = 0; i < m_animation->size(); ++i) {
+            ScalarFloat time = (*m_animation)[i].time;
+            if (time > time_start && time < time_end)
+                keyframes.push_back(time);
+        }
+        keyframes.push_back(time_end);
+
+        std::vector<ScalarFloat> times;
+        for (size_t i = 0; i + 1 < keyframes.size(); ++i) {
+            for (size_t j = 0; j < MotionSamples; ++j)
+                times.push_back(keyframes[i] + (keyframes[i + 1] - keyframes[i]) *
+                                                   (ScalarFloat) j / MotionSamples);
+        }
+        times.push_back(time_end);
+
+        std::vector<std::array<ScalarPoint3f, 8>> corners(times.size());
+        for (size_t i = 0; i < times.size(); ++i) {
+            ScalarTransform4f trafo = m_animation->eval(times[i]);
+            for (int k = 0; k < 8; ++k)
+                corners[i][k] = trafo * bbox.corner(k);
+        }
+
+        std::vector<ScalarBoundingBox3f> boxes(times.size());
+        for (size_t i = 0; i < times.size(); ++i) {
+            ScalarFloat pad = 0.f;
+            for (size_t j : { i == 0 ? i : i - 1, i }) {
+                if (j + 1 == times.size())
+                    continue;
+                for (int k = 0; k < 8; ++k)
+                    pad = std::max(pad, .5f * norm(corners[j + 1][k] - corners[j][k]));
+            }
+            for (int k = 0; k < 8; ++k)
+                boxes[i].expand(corners[i][k]);
+            boxes[i].min -= pad;
+            boxes[i].max += pad;
+        }
+
+        return { times, boxes };
+    }
+
+    /// Number of bounding box samples per keyframe interval of the animation
+    static constexpr size_t MotionSamples = 16;
+
    ref<ShapeGroup> m_shapegroup;
+   ref<const AnimatedTransform> m_animation;
+   ScalarAffineTransform4f m_affine_to_world;
+   ScalarAffineTransform4f m_affine_to_object;
+   ScalarFloat m_affine_det;
+};
+
+/**
+ * \brief Area emitter of an instance of emissive shapes (internal)
+ *
+ * The emitted radiance is provided by the emitters within the shape group,
+ * and positions are sampled by \ref Instance::sample_emitter().
+ */
+template <typename Float, typename Spectrum>
+class InstanceAreaLight final : public Emitter<Float, Spectrum> {
+public:
+    MTS_IMPORT_BASE(Emitter, m_flags, m_shape)
+    MTS_IMPORT_TYPES()
+
+    using InstanceT = Instance<Float, Spectrum>;
+
+    InstanceAreaLight(const Properties &props) : Base(props) {
+        m_flags = +EmitterFlags::Surface;
+    }
+
+    Spectrum eval(const SurfaceInteraction3f &si, Mask active) const override {
+        MTS_MASKED_FUNCTION(ProfilerPhase::EndpointEvaluate, active);
+
+        // 'si.shape' is the emissive shape within the shape group
+        return si.shape->emitter(active)->eval(si, active);
+    }
+
+    std::pair<Ray3f, Spectrum> sample_ray(Float time, Float wavelength_sample,
+                                          const Point2f &sample2, const Point2f &sample3,
+                                          Mask active) const override {
+        MTS_MASKED_FUNCTION(ProfilerPhase::EndpointSampleRay, active);
+
+        // 1. Sample a position on the emissive shapes of the instance
+        auto [ps, shape] = instance()->sample_emitter(time, sample2, active);
+        active &= neq(ps.pdf, 0.f);
+
+        // 2. Sample the directional component and the wavelengths
+        Vector3f local = warp::square_to_cosine_hemisphere(sample3);
+        auto [wavelengths, wav_weight] = sample_wavelength<Float, Spectrum>(wavelength_sample);
+
+        SurfaceInteraction3f si(ps, wavelengths);
+        si.shape = shape;
+        si.wi = local;
+
+        Spectrum spec = shape->emitter(active)->eval(si, active) * wav_weight *
+                        (math::Pi<Float> / ps.pdf);
+
+        return { Ray3f(si.p, si.to_world(local), time, wavelengths), spec & active };
+    }
+
+    std::pair<DirectionSample3f, Spectrum>
+    sample_direction(const Interaction3f &it, const Point2f &sample, Mask active) const override {
+        MTS_MASKED_FUNCTION(ProfilerPhase::EndpointSampleDirection, active);
+
+        auto [ps, shape] = instance()->sample_emitter(it.time, sample, active);
+
+        DirectionSample3f ds(ps);
+        ds.d = ds.p - it.p;
+
+        Float dist_squared = squared_norm(ds.d);
+        ds.dist = sqrt(dist_squared);
+        ds.d /= ds.dist;
+
+        Float dp = dot(ds.d, ds.n);
+        active &= dp < 0.f && neq(ds.pdf, 0.f);
+        ds.pdf = select(active, ds.pdf * dist_squared / -dp, 0.f);
+        ds.object = this;
+
+        SurfaceInteraction3f si(ps, it.wavelengths);
+        si.shape = shape;
+        si.wi = si.to_local(-ds.d);
+
+        Spectrum spec = shape->emitter(active)->eval(si, active) / ds.pdf;
+
+        return { ds, spec & active };
+    }
+
+    Float pdf_direction(const Interaction3f & /* it */, const DirectionSample3f &ds,
+                        Mask active) const override {
+        MTS_MASKED_FUNCTION(ProfilerPhase::EndpointEvaluate, active);
+
+        Float dp = dot(ds.d, ds.n);
+        active &= dp < 0.f;
+
+        Float value = instance()->pdf_position(ds, active) * sqr(ds.dist) / -dp;
+        return select(active, value, 0.f);
+    }
+
+    ScalarBoundingBox3f bbox() const override { return m_shape->bbox(); }
+
+    ScalarFloat power() const override {
+        // Scale the power of the group by the average change in area
+        const InstanceT *inst = instance();
+        return inst->m_shapegroup->emitter_power() * std::cbrt(sqr(inst->m_affine_det));
+    }
+
+    std::string to_string() const override {
+        std::ostringstream oss;
+        oss << "InstanceAreaLight[" << std::endl
+            << "  shapegroup = \"" << instance()->m_shapegroup->id() << "\"" << std::endl
+            << "]";
+        return oss.str();
+    }
+
+    MTS_DECLARE_CLASS()
+private:
+    const InstanceT *instance() const { return static_cast<const InstanceT *>(m_shape); }
 };
 
 MTS_IMPLEMENT_CLASS_VARIANT(Instance, Shape)
 MTS_EXPORT_PLUGIN(Instance, "Instanced geometry")
+
+/* The emitter is created by the instances and not by the plugin manager, hence
+   the standard MTS_IMPLEMENT_CLASS_VARIANT macro cannot be used */
+template <typename Float, typename Spectrum>
+Class *InstanceAreaLight<Float, Spectrum>::m_class
+    = new Class("InstanceAreaLight", "Emitter",
+                ::mitsuba::detail::get_variant<Float, Spectrum>(), nullptr, nullptr);
+
+template <typename Float, typename Spectrum>
+const Class *InstanceAreaLight<Float, Spectrum>::class_() const {
+    return m_class;
+}
 NAMESPACE_END(mitsuba)
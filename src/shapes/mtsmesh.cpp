@@ -0,0 +1,318 @@
+#include <mitsuba/render/mesh.h>
+#include <mitsuba/render/mtsmesh.h>
+#include <mitsuba/core/fresolver.h>
+#include <mitsuba/core/mmap.h>
+#include <mitsuba/core/profiler.h>
+#include <mitsuba/core/properties.h>
+#include <mitsuba/core/timer.h>
+#include <mitsuba/core/util.h>
+#include <tbb/parallel_for.h>
+#include <limits>
+#include <mutex>
+
+NAMESPACE_BEGIN(mitsuba)
+
+/**!
+
+.. _shape-mtsmesh:
+
+Mesh cache loader (:monosp:`mtsmesh`)
+-------------------------------------
+
+.. pluginparameters::
+
+ * - filename
+   - |string|
+   - Filename of the :monosp:`.mtsmesh` file that should be loaded
+ * - face_normals
+   - |bool|
+   - When set to |true|, any existing or computed vertex normals are
+     discarded and *face normals* will instead be used during rendering.
+     This gives the rendered object a faceted appearance. (Default: |false|)
+ * - to_world
+   - |transform|
+   - Specifies an optional linear object-to-world transformation.
+     (Default: none, i.e. object space = world space)
+ * - mmap
+   - |bool|
+   - Use the arrays within the memory-mapped file directly instead of copying
+     them (CPU variants only, see below). (Default: |false|)
+ * - compress_vertex_data
+   - |bool|
+   - Store the vertex normals, texture coordinates and attributes in compact
+     16-bit encodings, which roughly halves their memory usage at the cost of a
+     small quantization error (CPU variants only). (Default: |false|)
+
+This plugin loads the native mesh cache format of Mitsuba 2, which is
+written by the ``write_mtsmesh()`` method of any mesh:
+
+.. code-block:: python
+
+    mesh = load_dict({ 'type': 'ply', 'filename': 'bunny.ply' })
+    mesh.write_mtsmesh('bunny.mtsmesh')
+
+Besides the vertex positions, normals, texture coordinates, faces and mesh
+attributes, the file stores data that is otherwise derived while loading: the
+bounding box, the vertex normals computed for meshes that did not provide
+any, and the table used to sample positions proportionally to the surface
+area. The arrays are aligned for direct access within a memory mapping, so
+that loading a mesh amounts to mapping the file and copying the arrays into
+the mesh buffers. When a :monosp:`to_world` transformation is specified, the
+positions, normals and bounding box are transformed and the area table is
+recomputed on demand.
+
+The :monosp:`mmap` parameter lets the mesh buffers point into a copy-on-write
+mapping of the file. The operating system then reads the geometry on demand
+and may evict it again under memory pressure, which allows rendering scenes
+whose geometry exceeds the available memory (at the cost of disk accesses).
+Modifications such as a :monosp:`to_world` transformation or normals computed
+while loading turn the affected pages into regular memory. Writing the cache
+after calling ``sort_spatially()`` on the mesh keeps nearby triangles close
+within the file, so that ray tracing touches fewer pages.
+
+The file uses the byte order of the machine that wrote it and is not meant
+as an interchange format: keep the original mesh and regenerate the cache
+when needed.
+ */
+
+template <typename Float, typename Spectrum>
+class MTSMesh final : public Mesh<Float, Spectrum> {
+public:
+    MTS_IMPORT_BASE(Mesh, m_name, m_bbox, m_to_world, m_vertex_count, m_face_count,
+                    m_vertex_positions_buf, m_vertex_normals_buf, m_vertex_texcoords_buf,
+                    m_faces_buf, m_mesh_attributes, m_disable_vertex_normals, m_area_pmf,
+                    add_attribute, check_attribute, has_vertex_normals,
+                    recompute_vertex_normals, vertex_position, vertex_normal,
+                    m_compress_vertex_data, compress_vertex_data, set_children)
+    MTS_IMPORT_TYPES()
+
+    using typename Base::ScalarSize;
+    using typename Base::ScalarIndex;
+    using typename Base::InputFloat;
+    using typename Base::InputPoint3f;
+    using typename Base::InputNormal3f;
+    using typename Base::FloatStorage;
+    using typename Base::MeshAttribute;
+    using typename Base::MeshAttributeType;
+    using PMFStorage = typename DiscreteDistribution<Float>::FloatStorage;
+    using ScalarVector2u = typename DiscreteDistribution<Float>::ScalarVector2u;
+
+    MTSMesh(const Properties &props) : Base(props) {
+        using detail::MeshCacheHeader;
+        using detail::MeshCacheAttribute;
+        using detail::MeshCacheFlags;
+
+        auto fs = Thread::thread()->file_resolver();
+        fs::path file_path = fs->resolve(props.string("filename"));
+        m_name = file_path.filename().string();
+
+        Log(Debug, "Loading mesh from \"%s\" ..", m_name);
+        if (!fs::exists(file_path))
+            fail("file not found");
+        ScopedLoadEvent load_event(LoadEvent::LoadGeometry, m_name);
+
+        /* Mapped arrays require the packet alignment that the file provides,
+           and the GPU variants need to copy the data to the device anyway */
+        bool mapped = props.bool_("mmap", false);
+        if (mapped && is_cuda_array_v<Float>) {
+            Log(Warn, "\"%s\": the 'mmap' parameter is not supported in GPU variants", m_name);
+            mapped = false;
+        }
+
+        // Unless the arrays are used in place, the whole file is copied below
+        ref<MemoryMappedFile> mmap = mapped ? MemoryMappedFile::map_copy_on_write(file_path)
+                                            : new MemoryMappedFile(file_path, false, true);
+        Timer timer;
+
+        const uint8_t *data = (const uint8_t *) mmap->data();
+        size_t size = mmap->size();
+
+        MeshCacheHeader header;
+        if (size < sizeof(MeshCacheHeader))
+            fail("file is truncated");
+        memcpy(&header, data, sizeof(MeshCacheHeader));
+
+        if (strncmp(header.magic, MTS_MESH_CACHE_MAGIC, sizeof(header.magic)) != 0)
+            fail("invalid file format");
+        if (header.version != MTS_MESH_CACHE_VERSION)
+            fail("incompatible file version %i (expected %i)", header.version,
+                 MTS_MESH_CACHE_VERSION);
+        if (header.vertex_count > (uint64_t) std::numeric_limits<ScalarSize>::max() ||
+            header.face_count > (uint64_t) std::numeric_limits<ScalarSize>::max())
+            fail("mesh is too large");
+
+        m_vertex_count = (ScalarSize) header.vertex_count;
+        m_face_count   = (ScalarSize) header.face_count;
+
+        uint32_t flags = header.flags;
+        bool has_normals = detail::has_flag(flags, MeshCacheFlags::HasNormals);
+        if (detail::has_flag(flags, MeshCacheFlags::FaceNormals))
+            m_disable_vertex_normals = true;
+
+        // Return a pointer to an array of 'count' values stored at 'offset'
+        auto array_ptr = [&](uint64_t offset, size_t count, size_t value_size) {
+            if (offset % MTS_MESH_CACHE_ALIGNMENT != 0 || offset > size ||
+                count * value_size > size - offset)
+                fail("invalid array offset");
+            return data + offset;
+        };
+
+        // Create a buffer that refers to the mapped array or holds a copy of it
+        auto load_array = [&](auto &buffer, uint64_t offset, size_t count) {
+            using Buffer = std::decay_t<decltype(buffer)>;
+            using Value  = std::decay_t<decltype(*buffer.data())>;
+            const uint8_t *ptr = array_ptr(offset, count, sizeof(Value));
+            if (mapped)
+                buffer = Buffer::map((void *) ptr, count);
+            else
+                buffer = Buffer::copy(ptr, count);
+        };
+
+        size_t vertex_count = (size_t) m_vertex_count,
+               face_count   = (size_t) m_face_count;
+
+        load_array(m_vertex_positions_buf, header.positions_offset, vertex_count * 3);
+
+        if (has_normals && !m_disable_vertex_normals)
+            load_array(m_vertex_normals_buf, header.normals_offset, vertex_count * 3);
+        else if (!m_disable_vertex_normals)
+            m_vertex_normals_buf = empty<FloatStorage>(vertex_count * 3);
+
+        if (detail::has_flag(flags, MeshCacheFlags::HasTexcoords))
+            load_array(m_vertex_texcoords_buf, header.texcoords_offset, vertex_count * 2);
+
+        load_array(m_faces_buf, header.faces_offset, face_count * 3);
+
+        m_vertex_positions_buf.managed();
+        m_vertex_normals_buf.managed();
+        m_vertex_texcoords_buf.managed();
+        m_faces_buf.managed();
+
+        // Name and attribute table
+        size_t table_offset = sizeof(MeshCacheHeader) + header.name_length;
+        for (uint32_t i = 0; i < header.attribute_count; ++i) {
+            MeshCacheAttribute entry;
+            if (table_offset + sizeof(MeshCacheAttribute) > size)
+                fail("file is truncated");
+            memcpy(&entry, data + table_offset, sizeof(MeshCacheAttribute));
+            table_offset += sizeof(MeshCacheAttribute);
+            if (table_offset + entry.name_length > size)
+                fail("file is truncated");
+            std::string name((const char *) data + table_offset, entry.name_length);
+            table_offset += entry.name_length;
+
+            size_t count = (entry.face_attribute ? face_count : vertex_count) * entry.size;
+            FloatStorage buf;
+            load_array(buf, entry.offset, count);
+            buf.managed();
+
+            /* Spectral variants convert color attributes into model
+               coefficients when they are added to the mesh */
+            bool color = entry.size == 3 && name.find("color") != std::string::npos;
+            bool spectral_colors = detail::has_flag(flags, MeshCacheFlags::SpectralColors);
+            if (color && spectral_colors && !is_spectral_v<Spectrum>)
+                fail("attribute \"%s\" was written by a spectral variant", name);
+
+            /* Other attributes are inserted as they are, which avoids a copy,
+               after the checks of add_attribute() */
+            if (!(color && is_spectral_v<Spectrum> && !spectral_colors)) {
+                MeshAttributeType type = check_attribute(name, entry.size);
+                if ((type == MeshAttributeType::Face) != (bool) entry.face_attribute)
+                    fail("the name of attribute \"%s\" does not match its type", name);
+                m_mesh_attributes.insert(
+                    { name, MeshAttribute{ entry.size, type, std::move(buf), {} } });
+            } else {
+                add_attribute(name, entry.size, buf);
+            }
+        }
+
+        if constexpr (is_cuda_array_v<Float>)
+            cuda_sync();
+
+        bool transformed = props.has_property("to_world");
+        if (transformed) {
+            InputFloat* position_ptr = m_vertex_positions_buf.data();
+            InputFloat* normal_ptr   = m_vertex_normals_buf.data();
+            bool transform_normals = has_normals && has_vertex_normals();
+            std::mutex bbox_mutex;
+
+            tbb::parallel_for(
+                tbb::blocked_range<ScalarSize>(0, m_vertex_count, 16384),
+                [&](const tbb::blocked_range<ScalarSize> &range) {
+                    ScalarBoundingBox3f bbox;
+                    for (ScalarSize i = range.begin(); i != range.end(); ++i) {
+                        InputPoint3f p = m_to_world.transform_affine(vertex_position(i));
+                        store_unaligned(position_ptr + i * 3, p);
+                        bbox.expand(p);
+
+                        if (transform_normals) {
+                            InputNormal3f n =
+                                normalize(m_to_world.transform_affine(vertex_normal(i)));
+                            store_unaligned(normal_ptr + i * 3, n);
+                        }
+                    }
+
+                    std::lock_guard<std::mutex> guard(bbox_mutex);
+                    m_bbox.expand(bbox);
+                }
+            );
+        } else {
+            for (size_t i = 0; i < 3; ++i) {
+                m_bbox.min[i] = (ScalarFloat) header.bbox_min[i];
+                m_bbox.max[i] = (ScalarFloat) header.bbox_max[i];
+            }
+
+            // The area PMF is only valid for the untransformed mesh
+            if (detail::has_flag(flags, MeshCacheFlags::HasAreaPMF) &&
+                header.pmf_scalar_size == sizeof(ScalarFloat)) {
+                const ScalarFloat *pmf = (const ScalarFloat *) array_ptr(
+                    header.pmf_offset, face_count, sizeof(ScalarFloat));
+                const ScalarFloat *cdf = (const ScalarFloat *) array_ptr(
+                    header.cdf_offset, face_count, sizeof(ScalarFloat));
+                m_area_pmf = DiscreteDistribution<Float>(
+                    PMFStorage::copy(pmf, face_count), PMFStorage::copy(cdf, face_count),
+                    (ScalarFloat) header.pmf_sum, (ScalarFloat) header.pmf_normalization,
+                    ScalarVector2u(header.pmf_valid[0], header.pmf_valid[1]));
+                // The alias table is cheap to rebuild and not stored in the cache
+                m_area_pmf.build_alias_table();
+            }
+        }
+
+        Log(Debug, "\"%s\": read %i faces, %i vertices (%s in %s)",
+            m_name, m_face_count, m_vertex_count, util::mem_string(size),
+            util::time_string(timer.value())
+        );
+
+        if (!m_disable_vertex_normals && !has_normals) {
+            Timer timer2;
+            recompute_vertex_normals();
+            Log(Debug, "\"%s\": computed vertex normals (took %s)", m_name,
+                util::time_string(timer2.value()));
+        }
+
+        if (m_compress_vertex_data)
+            compress_vertex_data();
+
+        // Keep the mapping alive as long as the buffers refer to it
+        if (mapped)
+            m_mmap = mmap;
+
+        set_children();
+    }
+
+    MTS_DECLARE_CLASS()
+
+private:
+    template <typename... Args>
+    [[noreturn]] void fail(const char *descr, Args... args) const {
+        Throw(("Error while loading mesh cache \"%s\": " + std::string(descr) + "!")
+                  .c_str(), m_name, args...);
+    }
+
+private:
+    ref<MemoryMappedFile> m_mmap;
+};
+
+MTS_IMPLEMENT_CLASS_VARIANT(MTSMesh, Mesh)
+MTS_EXPORT_PLUGIN(MTSMesh, "Mitsuba mesh cache file")
+NAMESPACE_END(mitsuba)
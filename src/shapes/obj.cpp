@@ -1,9 +1,13 @@
 #include <mitsuba/render/mesh.h>
 #include <mitsuba/core/fresolver.h>
+#include <mitsuba/core/profiler.h>
 #include <mitsuba/core/properties.h>
 #include <mitsuba/core/mmap.h>
 #include <mitsuba/core/util.h>
+#include <mitsuba/core/string.h>
 #include <mitsuba/core/timer.h>
+#include <tbb/parallel_for.h>
+#include <atomic>
 
 NAMESPACE_BEGIN(mitsuba)
 
@@ -31,11 +35,31 @@ Wavefront OBJ mesh loader (:monosp:`obj`)
    - |transform|
    - Specifies an optional linear object-to-world transformation.
      (Default: none, i.e. object space = world space)
+ * - compress_vertex_data
+   - |bool|
+   - Store the vertex normals, texture coordinates and attributes in compact
+     16-bit encodings, which roughly halves their memory usage at the cost of a
+     small quantization error (CPU variants only). (Default: |false|)
+ * - sort_spatially
+   - |bool|
+   - Reorder the faces along a Morton curve of their centroids and renumber the
+     vertices in the order of their first use, which makes the memory accesses of
+     the ray intersection and emitter sampling more coherent for meshes whose
+     triangles were exported in an arbitrary order (CPU variants only).
+     (Default: |false|)
+ * - parallel_threshold
+   - |int|
+   - Files of at least this many bytes are parsed by several threads. (Default: 16 MiB)
 
 This plugin implements a simple loader for Wavefront OBJ files. It handles
 meshes containing triangles and quadrilaterals, and it also imports vertex normals
 and texture coordinates.
 
+Large files are split into chunks on line boundaries that are parsed in parallel,
+followed by a parallel pass that merges identical position/texture
+coordinate/normal index triplets into shared vertices. The resulting vertex order
+differs from the one of the sequential loader used for smaller files.
+
 Loading an ordinary OBJ file is as simple as writing:
 
 .. code-block:: xml
@@ -77,7 +101,8 @@ public:
     MTS_IMPORT_BASE(Mesh, m_name, m_bbox, m_to_world, m_vertex_count, m_face_count,
                     m_vertex_positions_buf, m_vertex_normals_buf, m_vertex_texcoords_buf,
                     m_faces_buf, m_disable_vertex_normals, recompute_vertex_normals,
-                    has_vertex_normals, set_children)
+                    has_vertex_normals, m_compress_vertex_data, m_sort_spatially,
+                    compress_vertex_data, sort_spatially, set_children)
     MTS_IMPORT_TYPES()
 
     using typename Base::ScalarSize;
@@ -88,65 +113,113 @@ public:
     using typename Base::InputVector3f;
     using typename Base::InputNormal3f;
     using typename Base::FloatStorage;
+    using InputBoundingBox3f = BoundingBox<InputPoint3f>;
+
+    using ScalarIndex3 = std::array<ScalarIndex, 3>;
+
+    /// Vertex data and triangles parsed from a contiguous range of lines
+    struct Chunk {
+        std::vector<InputVector3f> vertices;
+        std::vector<InputNormal3f> normals;
+        std::vector<InputVector2f> texcoords;
+        std::vector<ScalarIndex3> triangles;
+        /// Position/texcoord/normal indices of the face corners (parallel loader only)
+        std::vector<ScalarIndex3> corners;
+        InputBoundingBox3f bbox;
+    };
 
     InputFloat strtof(const char *nptr, char **endptr) {
-            return std::strtof(nptr, endptr);
+        return string::parse_float(nptr, endptr);
     }
 
     OBJMesh(const Properties &props) : Base(props) {
         /* Causes all texture coordinates to be vertically flipped.
            Enabled by default, for consistence with the Mitsuba 1 behavior. */
-        bool flip_tex_coords = props.bool_("flip_tex_coords", true);
+        m_flip_tex_coords = props.bool_("flip_tex_coords", true);
+
+        /* Files of at least this many bytes are split into chunks that are
+           parsed in parallel */
+        size_t parallel_threshold = props.size_("parallel_threshold", 16 * 1024 * 1024);
 
         auto fs = Thread::thread()->file_resolver();
         fs::path file_path = fs->resolve(props.string("filename"));
         m_name = file_path.filename().string();
 
-
-        auto fail = [&](const char *descr, auto... args) {
-            Throw(("Error while loading OBJ file \"%s\": " + std::string(descr))
-                      .c_str(), m_name, args...);
-        };
-
         Log(Debug, "Loading mesh from \"%s\" ..", m_name);
         if (!fs::exists(file_path))
             fail("file not found");
+        ScopedLoadEvent load_event(LoadEvent::LoadGeometry, m_name);
 
         ref<MemoryMappedFile> mmap = new MemoryMappedFile(file_path);
+        Timer timer;
 
-        using ScalarIndex3 = std::array<ScalarIndex, 3>;
+        const char *data = (const char *) mmap->data();
+        size_t size = mmap->size();
 
-        struct VertexBinding {
-            ScalarIndex3 key {{ 0, 0, 0 }};
-            ScalarIndex value { 0 };
-            VertexBinding *next { nullptr };
-        };
+        // Every thread parses its range from start to end
+        mmap->advise(MemoryMappedFile::Access::Sequential);
 
-        /// Temporary buffers for vertices, normals, and texture coordinates
-        std::vector<InputVector3f> vertices;
-        std::vector<InputNormal3f> normals;
-        std::vector<InputVector2f> texcoords;
-        std::vector<ScalarIndex3> triangles;
-        std::vector<VertexBinding> vertex_map;
+        bool has_texcoords;
+        if (size < parallel_threshold || util::core_count() == 1) {
+            has_texcoords = load_sequential(data, size);
+        } else {
+            mmap->prefetch();
+            has_texcoords = load_parallel(data, size);
+        }
 
-        size_t vertex_guess = mmap->size() / 100;
-        vertices.reserve(vertex_guess);
-        normals.reserve(vertex_guess);
-        texcoords.reserve(vertex_guess);
-        triangles.reserve(vertex_guess * 2);
-        vertex_map.resize(vertex_guess);
+        size_t vertex_data_bytes = 3 * sizeof(InputFloat);
+        if (has_vertex_normals())
+            vertex_data_bytes += 3 * sizeof(InputFloat);
+        if (has_texcoords)
+            vertex_data_bytes += 2 * sizeof(InputFloat);
 
-        ScalarIndex vertex_ctr = 0;
+        Log(Debug, "\"%s\": read %i faces, %i vertices (%s in %s)",
+            m_name, m_face_count, m_vertex_count,
+            util::mem_string(m_face_count * 3 * sizeof(ScalarIndex) +
+                             m_vertex_count * vertex_data_bytes),
+            util::time_string(timer.value())
+        );
+
+        if (!m_disable_vertex_normals && !m_has_normals) {
+            Timer timer2;
+            recompute_vertex_normals();
+            Log(Debug, "\"%s\": computed vertex normals (took %s)", m_name,
+                util::time_string(timer2.value()));
+        }
+
+        if (m_sort_spatially)
+            sort_spatially();
 
-        const char *ptr = (const char *) mmap->data();
-        const char *eof = ptr + mmap->size();
+        if (m_compress_vertex_data)
+            compress_vertex_data();
+
+        set_children();
+    }
+
+    MTS_DECLARE_CLASS()
+
+private:
+    template <typename... Args>
+    [[noreturn]] void fail(const char *descr, Args... args) const {
+        Throw(("Error while loading OBJ file \"%s\": " + std::string(descr))
+                  .c_str(), m_name, args...);
+    }
+
+    /**
+     * \brief Parse the lines in <tt>[ptr, end)</tt> into \c chunk
+     *
+     * Each face corner is passed to \c corner_id, which returns the index
+     * stored in the triangles of the chunk.
+     */
+    template <typename CornerFunc>
+    void parse_lines(const char *ptr, const char *end, Chunk &chunk,
+                     CornerFunc &&corner_id) {
         char buf[1025];
-        Timer timer;
 
-        while (ptr < eof) {
+        while (ptr < end) {
             // Determine the offset of the next newline
             const char *next = ptr;
-            advance<false>(&next, eof, "\n");
+            advance<false>(&next, end, "\n");
 
             // Copy buf into a 0-terminated buffer
             size_t size = next - ptr;
@@ -172,8 +245,8 @@ public:
                 p = m_to_world.transform_affine(p);
                 if (unlikely(!all(enoki::isfinite(p))))
                     fail("mesh contains invalid vertex position data");
-                m_bbox.expand(p);
-                vertices.push_back(p);
+                chunk.bbox.expand(p);
+                chunk.vertices.push_back(p);
             } else if (cur[0] == 'v' && cur[1] == 'n' && (cur[2] == ' ' || cur[2] == '\t')) {
                 // Vertex normal
                 InputNormal3f n;
@@ -186,7 +259,7 @@ public:
                 n = normalize(m_to_world.transform_affine(n));
                 if (unlikely(!all(enoki::isfinite(n))))
                     fail("mesh contains invalid vertex normal data");
-                normals.push_back(n);
+                chunk.normals.push_back(n);
             } else if (cur[0] == 'v' && cur[1] == 't' && (cur[2] == ' ' || cur[2] == '\t')) {
                 // Texture coordinate
                 InputVector2f uv;
@@ -196,10 +269,10 @@ public:
                     uv[i] = strtof(cur, (char **) &cur);
                     parse_error |= cur == orig;
                 }
-                if (flip_tex_coords)
+                if (m_flip_tex_coords)
                     uv.y() = 1.f - uv.y();
 
-                texcoords.push_back(uv);
+                chunk.texcoords.push_back(uv);
             } else if (cur[0] == 'f' && (cur[1] == ' ' || cur[1] == '\t')) {
                 // Face specification
                 cur += 2;
@@ -228,31 +301,7 @@ public:
 
                     if (*next2 == ' ' || *next2 == '\t' || *next2 == '\0' || *next2 == '\r') {
                         type_index = 0;
-                        size_t map_index = key[0] - 1;
-
-                        if (unlikely(map_index >= vertices.size()))
-                            fail("reference to invalid vertex %i!", key[0]);
-                        if (unlikely(vertex_map.size() < vertices.size()))
-                            vertex_map.resize(vertices.size());
-
-                        // Hash table lookup
-                        VertexBinding *entry = &vertex_map[map_index];
-                        while (entry->key != key && entry->next != nullptr)
-                            entry = entry->next;
-
-                        ScalarIndex id;
-                        if (entry->key == key) {
-                            // Hit
-                            id = entry->value;
-                        } else {
-                            // Miss
-                            if (entry->key != ScalarIndex3{{0, 0, 0}}) {
-                                entry->next = new VertexBinding();
-                                entry = entry->next;
-                            }
-                            entry->key = key;
-                            id = entry->value = vertex_ctr++;
-                        }
+                        ScalarIndex id = corner_id(key);
 
                         if (vertex_index < 3) {
                             tri[vertex_index] = id;
@@ -263,7 +312,7 @@ public:
                         vertex_index++;
 
                         if (vertex_index >= 3)
-                            triangles.push_back(tri);
+                            chunk.triangles.push_back(tri);
                     }
 
                     cur = next2;
@@ -274,15 +323,14 @@ public:
                 fail("could not parse line \"%s\"", buf);
             ptr = next + 1;
         }
+    }
 
-        m_vertex_count = vertex_ctr;
-        m_face_count = (ScalarSize) triangles.size();
-
-        m_faces_buf = DynamicBuffer<UInt32>::copy(triangles.data(), m_face_count * 3);
+    /// Allocate the mesh buffers once the vertex and face counts are known
+    void allocate_buffers(bool has_texcoords) {
         m_vertex_positions_buf = empty<FloatStorage>(m_vertex_count * 3);
         if (!m_disable_vertex_normals)
             m_vertex_normals_buf = empty<FloatStorage>(m_vertex_count * 3);
-        if (!texcoords.empty())
+        if (has_texcoords)
             m_vertex_texcoords_buf = empty<FloatStorage>(m_vertex_count * 2);
 
         // TODO this is needed for the bbox(..) methods, but is it slower?
@@ -293,60 +341,307 @@ public:
 
         if constexpr (is_cuda_array_v<Float>)
             cuda_sync();
+    }
+
+    /// Write the attributes of the vertex \c id referenced by a face corner
+    void store_vertex(ScalarIndex id, const ScalarIndex3 &key,
+                      const std::vector<InputVector3f> &vertices,
+                      const std::vector<InputNormal3f> &normals,
+                      const std::vector<InputVector2f> &texcoords) {
+        InputFloat* position_ptr = m_vertex_positions_buf.data() + id * 3;
+        InputFloat* normal_ptr   = m_vertex_normals_buf.data() + id * 3;
+        InputFloat* texcoord_ptr = m_vertex_texcoords_buf.data() + id * 2;
+
+        store_unaligned(position_ptr, vertices[key[0] - 1]);
+
+        if (key[1]) {
+            size_t map_index = key[1] - 1;
+            if (unlikely(map_index >= texcoords.size()))
+                fail("reference to invalid texture coordinate %i!", key[1]);
+            store_unaligned(texcoord_ptr, texcoords[map_index]);
+        }
+
+        if (!m_disable_vertex_normals && key[2]) {
+            size_t map_index = key[2] - 1;
+            if (unlikely(map_index >= normals.size()))
+                fail("reference to invalid normal %i!", key[2]);
+            store_unaligned(normal_ptr, normals[key[2] - 1]);
+        }
+    }
+
+    /// Single-threaded loader, returns whether the file has texture coordinates
+    bool load_sequential(const char *data, size_t size) {
+        struct VertexBinding {
+            ScalarIndex3 key {{ 0, 0, 0 }};
+            ScalarIndex value { 0 };
+            VertexBinding *next { nullptr };
+        };
+
+        /// Temporary buffers for vertices, normals, and texture coordinates
+        Chunk chunk;
+        std::vector<VertexBinding> vertex_map;
+
+        size_t vertex_guess = size / 100;
+        chunk.vertices.reserve(vertex_guess);
+        chunk.normals.reserve(vertex_guess);
+        chunk.texcoords.reserve(vertex_guess);
+        chunk.triangles.reserve(vertex_guess * 2);
+        vertex_map.resize(vertex_guess);
+
+        ScalarIndex vertex_ctr = 0;
+
+        parse_lines(data, data + size, chunk, [&](const ScalarIndex3 &key) {
+            size_t map_index = key[0] - 1;
+
+            if (unlikely(map_index >= chunk.vertices.size()))
+                fail("reference to invalid vertex %i!", key[0]);
+            if (unlikely(vertex_map.size() < chunk.vertices.size()))
+                vertex_map.resize(chunk.vertices.size());
+
+            // Hash table lookup
+            VertexBinding *entry = &vertex_map[map_index];
+            while (entry->key != key && entry->next != nullptr)
+                entry = entry->next;
+
+            if (entry->key == key)
+                return entry->value; // Hit
+
+            // Miss
+            if (entry->key != ScalarIndex3{{0, 0, 0}}) {
+                entry->next = new VertexBinding();
+                entry = entry->next;
+            }
+            entry->key = key;
+            return entry->value = vertex_ctr++;
+        });
+
+        m_bbox = chunk.bbox;
+        m_has_normals = !chunk.normals.empty();
+        m_vertex_count = vertex_ctr;
+        m_face_count = (ScalarSize) chunk.triangles.size();
+
+        m_faces_buf = DynamicBuffer<UInt32>::copy(chunk.triangles.data(), m_face_count * 3);
+        allocate_buffers(!chunk.texcoords.empty());
 
         for (const auto& v_ : vertex_map) {
             const VertexBinding *v = &v_;
 
             while (v && v->key != ScalarIndex3{{0, 0, 0}}) {
-                InputFloat* position_ptr   = m_vertex_positions_buf.data() + v->value * 3;
-                InputFloat* normal_ptr   = m_vertex_normals_buf.data() + v->value * 3;
-                InputFloat* texcoord_ptr = m_vertex_texcoords_buf.data() + v->value * 2;
-                auto key = v->key;
-
-                store_unaligned(position_ptr, vertices[key[0] - 1]);
-
-                if (key[1]) {
-                    size_t map_index = key[1] - 1;
-                    if (unlikely(map_index >= texcoords.size()))
-                        fail("reference to invalid texture coordinate %i!", key[1]);
-                    store_unaligned(texcoord_ptr, texcoords[map_index]);
-                }
+                store_vertex(v->value, v->key, chunk.vertices, chunk.normals,
+                             chunk.texcoords);
+                v = v->next;
+            }
+        }
 
-                if (!m_disable_vertex_normals && key[2]) {
-                    size_t map_index = key[2] - 1;
-                    if (unlikely(map_index >= normals.size()))
-                        fail("reference to invalid normal %i!", key[2]);
-                    store_unaligned(normal_ptr, normals[key[2] - 1]);
+        return !chunk.texcoords.empty();
+    }
+
+    /**
+     * \brief Multi-threaded loader, returns whether the file has texture
+     * coordinates
+     *
+     * The file is split into chunks on line boundaries, which are parsed in
+     * parallel. The face corners of each chunk are then grouped by their
+     * position index, which allows merging identical corners into shared
+     * vertices in parallel as well.
+     */
+    bool load_parallel(const char *data, size_t size) {
+        const char *eof = data + size;
+
+        // Split the file into chunks (at least 1 MiB, ~16 per core) that end after a newline
+        size_t chunk_size = std::max(size / (16 * (size_t) util::core_count()),
+                                     (size_t) 1024 * 1024);
+        std::vector<const char *> bounds = { data };
+        while (bounds.back() < eof) {
+            const char *next = bounds.back() + std::min(chunk_size, (size_t) (eof - bounds.back()));
+            advance<false>(&next, eof, "\n");
+            bounds.push_back(next < eof ? next + 1 : eof);
+        }
+        size_t chunk_count = bounds.size() - 1;
+
+        // Parse the chunks, where faces temporarily refer to their corners
+        std::vector<Chunk> chunks(chunk_count);
+        tbb::parallel_for(
+            tbb::blocked_range<size_t>(0, chunk_count, 1),
+            [&](const tbb::blocked_range<size_t> &range) {
+                for (size_t i = range.begin(); i != range.end(); ++i) {
+                    Chunk &chunk = chunks[i];
+                    size_t guess = (bounds[i + 1] - bounds[i]) / 100;
+                    chunk.vertices.reserve(guess);
+                    chunk.triangles.reserve(guess * 2);
+                    chunk.corners.reserve(guess * 2);
+                    parse_lines(bounds[i], bounds[i + 1], chunk,
+                        [&chunk](const ScalarIndex3 &key) {
+                            chunk.corners.push_back(key);
+                            return (ScalarIndex) (chunk.corners.size() - 1);
+                        });
                 }
+            }
+        );
 
-                v = v->next;
+        // Concatenate the chunks
+        std::vector<size_t> vertex_offset(chunk_count + 1, 0), normal_offset(chunk_count + 1, 0),
+                            texcoord_offset(chunk_count + 1, 0), triangle_offset(chunk_count + 1, 0),
+                            corner_offset(chunk_count + 1, 0);
+        for (size_t i = 0; i < chunk_count; ++i) {
+            vertex_offset[i + 1]   = vertex_offset[i]   + chunks[i].vertices.size();
+            normal_offset[i + 1]   = normal_offset[i]   + chunks[i].normals.size();
+            texcoord_offset[i + 1] = texcoord_offset[i] + chunks[i].texcoords.size();
+            triangle_offset[i + 1] = triangle_offset[i] + chunks[i].triangles.size();
+            corner_offset[i + 1]   = corner_offset[i]   + chunks[i].corners.size();
+            m_bbox.expand(chunks[i].bbox);
+        }
+
+        size_t position_count = vertex_offset.back(), corner_count = corner_offset.back();
+        if (corner_count >= (size_t) std::numeric_limits<ScalarIndex>::max())
+            fail("too many face corners (%i)!", corner_count);
+
+        std::vector<InputVector3f> vertices(position_count);
+        std::vector<InputNormal3f> normals(normal_offset.back());
+        std::vector<InputVector2f> texcoords(texcoord_offset.back());
+        std::vector<ScalarIndex3> corners(corner_count);
+        std::vector<ScalarIndex3> triangles(triangle_offset.back());
+
+        tbb::parallel_for(
+            tbb::blocked_range<size_t>(0, chunk_count, 1),
+            [&](const tbb::blocked_range<size_t> &range) {
+                for (size_t i = range.begin(); i != range.end(); ++i) {
+                    Chunk &chunk = chunks[i];
+                    std::copy(chunk.vertices.begin(), chunk.vertices.end(),
+                              vertices.begin() + vertex_offset[i]);
+                    std::copy(chunk.normals.begin(), chunk.normals.end(),
+                              normals.begin() + normal_offset[i]);
+                    std::copy(chunk.texcoords.begin(), chunk.texcoords.end(),
+                              texcoords.begin() + texcoord_offset[i]);
+                    std::copy(chunk.corners.begin(), chunk.corners.end(),
+                              corners.begin() + corner_offset[i]);
+                    ScalarIndex offset = (ScalarIndex) corner_offset[i];
+                    for (size_t j = 0; j < chunk.triangles.size(); ++j) {
+                        const ScalarIndex3 &tri = chunk.triangles[j];
+                        triangles[triangle_offset[i] + j] = {{ tri[0] + offset,
+                                                               tri[1] + offset,
+                                                               tri[2] + offset }};
+                    }
+                    chunk = Chunk();
+                }
             }
+        );
+        chunks.clear();
+
+        // Group the corners by position index (counting sort)
+        std::unique_ptr<std::atomic<ScalarIndex>[]> slot(
+            new std::atomic<ScalarIndex>[position_count + 1]);
+        for (size_t i = 0; i <= position_count; ++i)
+            slot[i].store(0, std::memory_order_relaxed);
+
+        tbb::parallel_for(
+            tbb::blocked_range<size_t>(0, corner_count, 65536),
+            [&](const tbb::blocked_range<size_t> &range) {
+                for (size_t i = range.begin(); i != range.end(); ++i) {
+                    size_t map_index = corners[i][0] - 1;
+                    if (unlikely(map_index >= position_count))
+                        fail("reference to invalid vertex %i!", corners[i][0]);
+                    slot[map_index + 1].fetch_add(1, std::memory_order_relaxed);
+                }
+            }
+        );
+
+        std::vector<ScalarIndex> group_offset(position_count + 1);
+        for (size_t i = 0; i < position_count; ++i) {
+            group_offset[i + 1] = group_offset[i] + slot[i + 1].load(std::memory_order_relaxed);
+            slot[i + 1].store(group_offset[i], std::memory_order_relaxed);
         }
 
-        size_t vertex_data_bytes = 3 * sizeof(InputFloat);
-        if (has_vertex_normals())
-            vertex_data_bytes += 3 * sizeof(InputFloat);
-        if (!texcoords.empty())
-            vertex_data_bytes += 2 * sizeof(InputFloat);
+        std::vector<ScalarIndex> grouped(corner_count);
+        tbb::parallel_for(
+            tbb::blocked_range<size_t>(0, corner_count, 65536),
+            [&](const tbb::blocked_range<size_t> &range) {
+                for (size_t i = range.begin(); i != range.end(); ++i) {
+                    ScalarIndex pos = slot[corners[i][0]].fetch_add(1, std::memory_order_relaxed);
+                    grouped[pos] = (ScalarIndex) i;
+                }
+            }
+        );
+        slot.reset();
+
+        /* Merge identical corners of each group. The groups are sorted by
+           corner index first, which makes the result deterministic. */
+        std::vector<ScalarIndex> corner_vertex(corner_count);
+        std::vector<size_t> group_vertex_count(position_count + 1, 0);
+        tbb::parallel_for(
+            tbb::blocked_range<size_t>(0, position_count, 4096),
+            [&](const tbb::blocked_range<size_t> &range) {
+                // First corner of each distinct triplet of the current group
+                std::vector<ScalarIndex> unique;
+                for (size_t g = range.begin(); g != range.end(); ++g) {
+                    ScalarIndex *begin = grouped.data() + group_offset[g],
+                                *end   = grouped.data() + group_offset[g + 1];
+                    std::sort(begin, end);
+
+                    unique.clear();
+                    for (ScalarIndex *it = begin; it != end; ++it) {
+                        ScalarIndex id = 0;
+                        while (id < unique.size() && corners[unique[id]] != corners[*it])
+                            ++id;
+                        if (id == unique.size())
+                            unique.push_back(*it);
+                        corner_vertex[*it] = id;
+                    }
+                    group_vertex_count[g + 1] = unique.size();
+                }
+            }
+        );
 
-        Log(Debug, "\"%s\": read %i faces, %i vertices (%s in %s)",
-            m_name, m_face_count, m_vertex_count,
-            util::mem_string(m_face_count * 3 * sizeof(ScalarIndex) +
-                             m_vertex_count * vertex_data_bytes),
-            util::time_string(timer.value())
+        // Assign the final vertex indices in order of the position index
+        for (size_t g = 0; g < position_count; ++g)
+            group_vertex_count[g + 1] += group_vertex_count[g];
+        if (group_vertex_count.back() >= std::numeric_limits<ScalarIndex>::max())
+            fail("too many vertices!");
+
+        m_vertex_count = (ScalarSize) group_vertex_count.back();
+        m_face_count = (ScalarSize) triangles.size();
+        m_has_normals = !normals.empty();
+
+        tbb::parallel_for(
+            tbb::blocked_range<size_t>(0, triangles.size(), 65536),
+            [&](const tbb::blocked_range<size_t> &range) {
+                for (size_t i = range.begin(); i != range.end(); ++i) {
+                    ScalarIndex3 &tri = triangles[i];
+                    for (size_t k = 0; k < 3; ++k)
+                        tri[k] = (ScalarIndex) group_vertex_count[corners[tri[k]][0] - 1] +
+                                 corner_vertex[tri[k]];
+                }
+            }
         );
 
-        if (!m_disable_vertex_normals && normals.empty()) {
-            Timer timer2;
-            recompute_vertex_normals();
-            Log(Debug, "\"%s\": computed vertex normals (took %s)", m_name,
-                util::time_string(timer2.value()));
-        }
+        m_faces_buf = DynamicBuffer<UInt32>::copy(triangles.data(), m_face_count * 3);
+        triangles = std::vector<ScalarIndex3>();
+        allocate_buffers(!texcoords.empty());
+
+        /* Vertex indices are handed out in order of the first corner that
+           refers to them, which is the corner to take the attributes from */
+        tbb::parallel_for(
+            tbb::blocked_range<size_t>(0, position_count, 4096),
+            [&](const tbb::blocked_range<size_t> &range) {
+                for (size_t g = range.begin(); g != range.end(); ++g) {
+                    ScalarIndex next_id = 0;
+                    for (ScalarIndex k = group_offset[g]; k < group_offset[g + 1]; ++k) {
+                        ScalarIndex corner = grouped[k];
+                        if (corner_vertex[corner] != next_id)
+                            continue;
+                        store_vertex((ScalarIndex) group_vertex_count[g] + next_id, corners[corner],
+                                     vertices, normals, texcoords);
+                        next_id++;
+                    }
+                }
+            }
+        );
 
-        set_children();
+        return !texcoords.empty();
     }
 
-    MTS_DECLARE_CLASS()
+    bool m_flip_tex_coords;
+    bool m_has_normals = false;
 };
 
 MTS_IMPLEMENT_CLASS_VARIANT(OBJMesh, Mesh)
@@ -60,8 +60,8 @@ extern "C" __global__ void __intersection__cylinder() {
 extern "C" __global__ void __closesthit__cylinder() {
     unsigned int launch_index = calculate_launch_index();
 
-    if (params.is_ray_test()) {
-        params.out_hit[launch_index] = true;
+    if (params.is_ray_test(launch_index)) {
+        write_output_hit_params(params, launch_index, true);
     } else {
         const OptixHitGroupData *sbt_data = (OptixHitGroupData *) optixGetSbtDataPointer();
         OptixCylinderData *cylinder = (OptixCylinderData *)sbt_data->data;
@@ -26,8 +26,8 @@ DEVICE Array<T, 3> load_3d(const Array<T, 3> *buf, size_t i) {
 extern "C" __global__ void __closesthit__mesh() {
     unsigned int launch_index = calculate_launch_index();
 
-    if (params.is_ray_test()) { // ray_test
-        params.out_hit[launch_index] = true;
+    if (params.is_ray_test(launch_index)) { // ray_test
+        write_output_hit_params(params, launch_index, true);
     } else {
         const OptixHitGroupData *sbt_data = (OptixHitGroupData *) optixGetSbtDataPointer();
         OptixMeshData *mesh = (OptixMeshData *)sbt_data->data;
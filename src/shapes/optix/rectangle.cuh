@@ -31,8 +31,8 @@ extern "C" __global__ void __intersection__rectangle() {
 extern "C" __global__ void __closesthit__rectangle() {
     unsigned int launch_index = calculate_launch_index();
 
-    if (params.is_ray_test()) { // ray_test
-        params.out_hit[launch_index] = true;
+    if (params.is_ray_test(launch_index)) { // ray_test
+        write_output_hit_params(params, launch_index, true);
     } else {
         const OptixHitGroupData *sbt_data = (OptixHitGroupData *) optixGetSbtDataPointer();
         OptixRectangleData *rect = (OptixRectangleData *)sbt_data->data;
@@ -48,8 +48,8 @@ extern "C" __global__ void __intersection__sphere() {
 extern "C" __global__ void __closesthit__sphere() {
     unsigned int launch_index = calculate_launch_index();
 
-    if (params.is_ray_test()) {
-        params.out_hit[launch_index] = true;
+    if (params.is_ray_test(launch_index)) {
+        write_output_hit_params(params, launch_index, true);
     } else {
         const OptixHitGroupData *sbt_data = (OptixHitGroupData *) optixGetSbtDataPointer();
         OptixSphereData *sphere = (OptixSphereData *)sbt_data->data;
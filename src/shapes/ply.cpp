@@ -1,14 +1,19 @@
 #include <mitsuba/render/mesh.h>
+#include <mitsuba/core/afstream.h>
 #include <mitsuba/core/fstream.h>
 #include <mitsuba/core/mstream.h>
 #include <mitsuba/core/fresolver.h>
+#include <mitsuba/core/mmap.h>
+#include <mitsuba/core/profiler.h>
 #include <mitsuba/core/properties.h>
 #include <mitsuba/core/util.h>
 #include <mitsuba/core/timer.h>
 #include <enoki/half.h>
+#include <tbb/parallel_for.h>
 #include <unordered_map>
 #include <unordered_set>
 #include <fstream>
+#include <mutex>
 
 NAMESPACE_BEGIN(mitsuba)
 
@@ -33,6 +38,26 @@ PLY (Stanford Triangle Format) mesh loader (:monosp:`ply`)
    - |transform|
    - Specifies an optional linear object-to-world transformation.
      (Default: none, i.e. object space = world space)
+ * - compress_vertex_data
+   - |bool|
+   - Store the vertex normals, texture coordinates and attributes in compact
+     16-bit encodings, which roughly halves their memory usage at the cost of a
+     small quantization error (CPU variants only). (Default: |false|)
+ * - sort_spatially
+   - |bool|
+   - Reorder the faces along a Morton curve of their centroids and renumber the
+     vertices in the order of their first use, which makes the memory accesses of
+     the ray intersection and emitter sampling more coherent for meshes whose
+     triangles were exported in an arbitrary order (CPU variants only).
+     (Default: |false|)
+ * - parallel_threshold
+   - |int|
+   - Binary files of at least this many bytes are memory-mapped and converted by several
+     threads. (Default: 16 MiB)
+ * - read_ahead
+   - |bool|
+   - Read smaller binary files on a background thread ahead of their conversion, which
+     hides the latency of slow storage such as network file systems. (Default: |false|)
 
 .. subfigstart::
 .. subfigure:: ../../resources/data/docs/images/render/shape_ply_bunny.jpg
@@ -47,6 +72,11 @@ ASCII and binary format, which is preferred for performance reasons). The
 current plugin implementation supports triangle meshes with optional UV
 coordinates, vertex normals and other custom vertex or face attributes.
 
+Large little-endian binary files whose vertex data is stored using 32-bit floats
+and whose faces use 32-bit indices are memory-mapped, and their element records
+are converted in parallel straight into the mesh buffers. Other files are read
+sequentially.
+
 Consecutive attributes with names sharing a common prefix and using one of the following schemes:
 
 ``{prefix}_{x|y|z|w}``, ``{prefix}_{r|g|b|a}``, ``{prefix}_{0|1|2|3}``, ``{prefix}_{1|2|3|4}``
@@ -69,7 +99,8 @@ public:
     MTS_IMPORT_BASE(Mesh, m_name, m_bbox, m_to_world, m_vertex_count, m_face_count,
                     m_vertex_positions_buf, m_vertex_normals_buf, m_vertex_texcoords_buf,
                     m_faces_buf, add_attribute, m_disable_vertex_normals, has_vertex_normals,
-                    has_vertex_texcoords, recompute_vertex_normals, set_children)
+                    has_vertex_texcoords, recompute_vertex_normals, m_compress_vertex_data,
+                    m_sort_spatially, compress_vertex_data, sort_spatially, set_children)
     MTS_IMPORT_TYPES()
 
     using typename Base::ScalarSize;
@@ -94,6 +125,14 @@ public:
         std::vector<PLYElement> elements;
     };
 
+    /// Copy of a 32-bit field from a PLY record into a converted record
+    struct PLYFieldCopy {
+        size_t src_offset;
+        size_t dst_offset;
+        bool missing;
+        uint32_t default_value;
+    };
+
     struct PLYAttributeDescriptor {
         std::string name;
         size_t dim;
@@ -104,6 +143,10 @@ public:
         /// Process vertex/index records in large batches
         constexpr size_t elements_per_packet = 1024;
 
+        /* Binary files of at least this many bytes are memory-mapped and
+           their records are converted in parallel */
+        size_t parallel_threshold = props.size_("parallel_threshold", 16 * 1024 * 1024);
+
         auto fs = Thread::thread()->file_resolver();
         fs::path file_path = fs->resolve(props.string("filename"));
         m_name = file_path.filename().string();
@@ -115,6 +158,7 @@ public:
         Log(Debug, "Loading mesh from \"%s\" ..", m_name);
         if (!fs::exists(file_path))
             fail("file not found");
+        ScopedLoadEvent load_event(LoadEvent::LoadGeometry, m_name);
 
         ref<Stream> stream = new FileStream(file_path);
         Timer timer;
@@ -134,6 +178,22 @@ public:
             fail(e.what());
         }
 
+        ref<MemoryMappedFile> mmap;
+        if (!header.ascii && stream->size() >= parallel_threshold &&
+            util::core_count() > 1 &&
+            Struct::host_byte_order() == Struct::ByteOrder::LittleEndian) {
+            mmap = new MemoryMappedFile(file_path);
+            // Load the body while the header is processed and the buffers are allocated
+            mmap->prefetch(stream->tell());
+        }
+
+        if (!header.ascii && !mmap && props.bool_("read_ahead", false)) {
+            // Continue reading the body of the file through a read-ahead stream
+            size_t offset = stream->tell();
+            stream = new AsyncFileStream(file_path);
+            stream->seek(offset);
+        }
+
         bool has_vertex_normals = false;
         bool has_vertex_texcoords = false;
 
@@ -184,13 +244,6 @@ public:
                 size_t i_struct_size = el.struct_->size();
                 size_t o_struct_size = vertex_struct->size();
 
-                ref<StructConverter> conv;
-                try {
-                    conv = new StructConverter(el.struct_, vertex_struct);
-                } catch (const std::exception &e) {
-                    fail(e.what());
-                }
-
                 m_vertex_count = (ScalarSize) el.count;
                 m_vertex_positions_buf = empty<FloatStorage>(m_vertex_count * 3);
                 if (!m_disable_vertex_normals)
@@ -210,68 +263,105 @@ public:
                 if constexpr (is_cuda_array_v<Float>)
                     cuda_sync();
 
-                size_t packet_count     = el.count / elements_per_packet;
-                size_t remainder_count  = el.count % elements_per_packet;
-                size_t i_packet_size    = i_struct_size * elements_per_packet;
-                size_t i_remainder_size = i_struct_size * remainder_count;
-                size_t o_packet_size    = o_struct_size * elements_per_packet;
-
-                std::unique_ptr<uint8_t[]> buf(new uint8_t[i_packet_size]);
-                std::unique_ptr<uint8_t[]> buf_o(new uint8_t[o_packet_size]);
-
                 InputFloat* position_ptr = m_vertex_positions_buf.data();
                 InputFloat* normal_ptr   = m_vertex_normals_buf.data();
                 InputFloat* texcoord_ptr = m_vertex_texcoords_buf.data();
 
-                for (size_t i = 0; i <= packet_count; ++i) {
-                    uint8_t *target = (uint8_t *) buf_o.get();
-                    size_t psize = (i != packet_count) ? i_packet_size : i_remainder_size;
-                    size_t count = (i != packet_count) ? elements_per_packet : remainder_count;
-                    stream->read(buf.get(), psize);
-                    if (unlikely(!conv->convert(count, buf.get(), buf_o.get())))
-                        fail("incompatible contents -- is this a triangle mesh?");
-
-                    for (size_t j = 0; j < count; ++j) {
-                        InputPoint3f p = enoki::load<InputPoint3f>(target);
-                        p = m_to_world.transform_affine(p);
-                        if (unlikely(!all(enoki::isfinite(p))))
-                            fail("mesh contains invalid vertex positions/normal data");
-                        m_bbox.expand(p);
-                        store_unaligned(position_ptr, p);
-                        position_ptr += 3;
-
-                        if (has_vertex_normals) {
-                            InputNormal3f n = enoki::load<InputNormal3f>(
-                                target + sizeof(InputFloat) * 3);
-                            n = normalize(m_to_world.transform_affine(n));
-                            store_unaligned(normal_ptr, n);
-                            normal_ptr += 3;
-                        }
+                size_t attribute_offset =
+                    sizeof(InputFloat) *
+                    (!m_disable_vertex_normals
+                         ? (has_vertex_texcoords ? 8 : 6)
+                         : (has_vertex_texcoords ? 5 : 3));
+
+                // Store the converted vertex record 'target' at position 'index'
+                auto store_vertex = [&](size_t index, const uint8_t *target,
+                                        ScalarBoundingBox3f &bbox) {
+                    InputPoint3f p = enoki::load_unaligned<InputPoint3f>(target);
+                    p = m_to_world.transform_affine(p);
+                    if (unlikely(!all(enoki::isfinite(p))))
+                        fail("mesh contains invalid vertex positions/normal data");
+                    bbox.expand(p);
+                    store_unaligned(position_ptr + index * 3, p);
+
+                    if (has_vertex_normals) {
+                        InputNormal3f n = enoki::load_unaligned<InputNormal3f>(
+                            target + sizeof(InputFloat) * 3);
+                        n = normalize(m_to_world.transform_affine(n));
+                        store_unaligned(normal_ptr + index * 3, n);
+                    }
 
-                        if (has_vertex_texcoords) {
-                            InputVector2f uv = enoki::load<InputVector2f>(
-                                target + (m_disable_vertex_normals
-                                              ? sizeof(InputFloat) * 3
-                                              : sizeof(InputFloat) * 6));
-                            store_unaligned(texcoord_ptr, uv);
-                            texcoord_ptr += 2;
-                        }
+                    if (has_vertex_texcoords) {
+                        InputVector2f uv = enoki::load_unaligned<InputVector2f>(
+                            target + (m_disable_vertex_normals
+                                          ? sizeof(InputFloat) * 3
+                                          : sizeof(InputFloat) * 6));
+                        store_unaligned(texcoord_ptr + index * 2, uv);
+                    }
+
+                    size_t target_offset = attribute_offset;
+                    for (size_t k = 0; k < vertex_attributes_descriptors.size(); ++k) {
+                        auto& descr = vertex_attributes_descriptors[k];
+                        memcpy(descr.buf.data() + index * descr.dim,
+                               target + target_offset,
+                               descr.dim * sizeof(InputFloat));
+                        target_offset += descr.dim * sizeof(InputFloat);
+                    }
+                };
+
+                std::vector<PLYFieldCopy> plan;
+                bool identity = false;
+                if (mmap && direct_copy_plan(el.struct_, vertex_struct, plan, identity)) {
+                    const uint8_t *src = map_element(mmap, stream, el);
+                    std::mutex bbox_mutex;
+
+                    tbb::parallel_for(
+                        tbb::blocked_range<size_t>(0, el.count, elements_per_packet),
+                        [&](const tbb::blocked_range<size_t> &range) {
+                            std::unique_ptr<uint8_t[]> buf_o(new uint8_t[o_struct_size]);
+                            ScalarBoundingBox3f bbox;
+
+                            for (size_t i = range.begin(); i != range.end(); ++i) {
+                                const uint8_t *target = src + i * i_struct_size;
+                                if (!identity) {
+                                    convert_direct(plan, target, buf_o.get());
+                                    target = buf_o.get();
+                                }
+                                store_vertex(i, target, bbox);
+                            }
 
-                        size_t target_offset =
-                            sizeof(InputFloat) *
-                            (!m_disable_vertex_normals
-                                 ? (has_vertex_texcoords ? 8 : 6)
-                                 : (has_vertex_texcoords ? 5 : 3));
-
-                        for (size_t k = 0; k < vertex_attributes_descriptors.size(); ++k) {
-                            auto& descr = vertex_attributes_descriptors[k];
-                            memcpy(descr.buf.data() + (i * elements_per_packet + j) * descr.dim,
-                                   target + target_offset,
-                                   descr.dim * sizeof(InputFloat));
-                            target_offset += descr.dim * sizeof(InputFloat);
+                            std::lock_guard<std::mutex> guard(bbox_mutex);
+                            m_bbox.expand(bbox);
                         }
+                    );
+                } else {
+                    ref<StructConverter> conv;
+                    try {
+                        conv = new StructConverter(el.struct_, vertex_struct);
+                    } catch (const std::exception &e) {
+                        fail(e.what());
+                    }
 
-                        target += o_struct_size;
+                    size_t packet_count     = el.count / elements_per_packet;
+                    size_t remainder_count  = el.count % elements_per_packet;
+                    size_t i_packet_size    = i_struct_size * elements_per_packet;
+                    size_t i_remainder_size = i_struct_size * remainder_count;
+                    size_t o_packet_size    = o_struct_size * elements_per_packet;
+
+                    std::unique_ptr<uint8_t[]> buf(new uint8_t[i_packet_size]);
+                    std::unique_ptr<uint8_t[]> buf_o(new uint8_t[o_packet_size]);
+
+                    for (size_t i = 0; i <= packet_count; ++i) {
+                        uint8_t *target = (uint8_t *) buf_o.get();
+                        size_t psize = (i != packet_count) ? i_packet_size : i_remainder_size;
+                        size_t count = (i != packet_count) ? elements_per_packet : remainder_count;
+                        stream->read(buf.get(), psize);
+                        if (unlikely(!conv->convert(count, buf.get(), buf_o.get())))
+                            fail("incompatible contents -- is this a triangle mesh?");
+
+                        for (size_t j = 0; j < count; ++j) {
+                            store_vertex(i * elements_per_packet + j, target, m_bbox);
+                            target += o_struct_size;
+                        }
                     }
                 }
 
@@ -303,13 +393,6 @@ public:
                 size_t i_struct_size = el.struct_->size();
                 size_t o_struct_size = face_struct->size();
 
-                ref<StructConverter> conv;
-                try {
-                    conv = new StructConverter(el.struct_, face_struct);
-                } catch (const std::exception &e) {
-                    fail(e.what());
-                }
-
                 m_face_count = (ScalarSize) el.count;
                 m_faces_buf = empty<DynamicBuffer<UInt32>>(m_face_count * 3);
                 m_faces_buf.managed();
@@ -321,39 +404,76 @@ public:
 
                 ScalarIndex* face_ptr = m_faces_buf.data();
 
-                size_t packet_count     = el.count / elements_per_packet;
-                size_t remainder_count  = el.count % elements_per_packet;
-                size_t i_packet_size    = i_struct_size * elements_per_packet;
-                size_t i_remainder_size = i_struct_size * remainder_count;
-                size_t o_packet_size    = o_struct_size * elements_per_packet;
-
-                std::unique_ptr<uint8_t[]> buf(new uint8_t[i_packet_size]);
-                std::unique_ptr<uint8_t[]> buf_o(new uint8_t[o_packet_size]);
-
-                for (size_t i = 0; i <= packet_count; ++i) {
-                    uint8_t *target = (uint8_t *) buf_o.get();
-                    size_t psize = (i != packet_count) ? i_packet_size : i_remainder_size;
-                    size_t count = (i != packet_count) ? elements_per_packet : remainder_count;
-
-                    stream->read(buf.get(), psize);
-                    if (unlikely(!conv->convert(count, buf.get(), buf_o.get())))
-                        fail("incompatible contents -- is this a triangle mesh?");
-
-                    for (size_t j = 0; j < count; ++j) {
-                        ScalarIndex3 fi = enoki::load<ScalarIndex3>(target);
-                        store_unaligned(face_ptr, fi);
-                        face_ptr += 3;
-
-                        size_t target_offset = sizeof(InputFloat) * 3;
-                        for (size_t k = 0; k < face_attributes_descriptors.size(); ++k) {
-                            auto& descr = face_attributes_descriptors[k];
-                            memcpy(descr.buf.data() + (i * elements_per_packet + j) * descr.dim,
-                                   target + target_offset,
-                                   descr.dim * sizeof(InputFloat));
-                            target_offset += descr.dim * sizeof(InputFloat);
+                // Store the converted face record 'target' at position 'index'
+                auto store_face = [&](size_t index, const uint8_t *target) {
+                    ScalarIndex3 fi = enoki::load_unaligned<ScalarIndex3>(target);
+                    store_unaligned(face_ptr + index * 3, fi);
+
+                    size_t target_offset = sizeof(InputFloat) * 3;
+                    for (size_t k = 0; k < face_attributes_descriptors.size(); ++k) {
+                        auto& descr = face_attributes_descriptors[k];
+                        memcpy(descr.buf.data() + index * descr.dim,
+                               target + target_offset,
+                               descr.dim * sizeof(InputFloat));
+                        target_offset += descr.dim * sizeof(InputFloat);
+                    }
+                };
+
+                /* The list length is not part of the converted record, but
+                   it must be checked against the value 3 */
+                const Struct::Field &count_field = el.struct_->field(field_name + ".count");
+                std::vector<PLYFieldCopy> plan;
+                bool identity = false;
+                if (mmap && count_field.is_integer() &&
+                    direct_copy_plan(el.struct_, face_struct, plan, identity)) {
+                    const uint8_t *src = map_element(mmap, stream, el);
+                    const uint64_t expected_count = 3;
+
+                    tbb::parallel_for(
+                        tbb::blocked_range<size_t>(0, el.count, elements_per_packet),
+                        [&](const tbb::blocked_range<size_t> &range) {
+                            std::unique_ptr<uint8_t[]> buf_o(new uint8_t[o_struct_size]);
+
+                            for (size_t i = range.begin(); i != range.end(); ++i) {
+                                const uint8_t *record = src + i * i_struct_size;
+                                if (unlikely(memcmp(record + count_field.offset,
+                                                    &expected_count, count_field.size) != 0))
+                                    fail("incompatible contents -- is this a triangle mesh?");
+                                convert_direct(plan, record, buf_o.get());
+                                store_face(i, buf_o.get());
+                            }
                         }
+                    );
+                } else {
+                    ref<StructConverter> conv;
+                    try {
+                        conv = new StructConverter(el.struct_, face_struct);
+                    } catch (const std::exception &e) {
+                        fail(e.what());
+                    }
 
-                        target += o_struct_size;
+                    size_t packet_count     = el.count / elements_per_packet;
+                    size_t remainder_count  = el.count % elements_per_packet;
+                    size_t i_packet_size    = i_struct_size * elements_per_packet;
+                    size_t i_remainder_size = i_struct_size * remainder_count;
+                    size_t o_packet_size    = o_struct_size * elements_per_packet;
+
+                    std::unique_ptr<uint8_t[]> buf(new uint8_t[i_packet_size]);
+                    std::unique_ptr<uint8_t[]> buf_o(new uint8_t[o_packet_size]);
+
+                    for (size_t i = 0; i <= packet_count; ++i) {
+                        uint8_t *target = (uint8_t *) buf_o.get();
+                        size_t psize = (i != packet_count) ? i_packet_size : i_remainder_size;
+                        size_t count = (i != packet_count) ? elements_per_packet : remainder_count;
+
+                        stream->read(buf.get(), psize);
+                        if (unlikely(!conv->convert(count, buf.get(), buf_o.get())))
+                            fail("incompatible contents -- is this a triangle mesh?");
+
+                        for (size_t j = 0; j < count; ++j) {
+                            store_face(i * elements_per_packet + j, target);
+                            target += o_struct_size;
+                        }
                     }
                 }
 
@@ -383,10 +503,92 @@ public:
                 util::time_string(timer2.value()));
         }
 
+        if (m_sort_spatially)
+            sort_spatially();
+
+        if (m_compress_vertex_data)
+            compress_vertex_data();
+
         set_children();
     }
 
 private:
+    /**
+     * \brief Check whether the records of a binary PLY element can be
+     * converted into \c target without a \ref StructConverter
+     *
+     * This is the case when the element is stored in little endian byte
+     * order and every 32-bit field of \c target either has a 32-bit float
+     * or integer counterpart in \c source, or specifies a default value
+     * and is missing from \c source. On success, \c plan lists the field
+     * copies and \c identity indicates whether the records of both
+     * structures are laid out identically, in which case the source
+     * records can be used as is.
+     */
+    bool direct_copy_plan(const Struct *source, const Struct *target,
+                          std::vector<PLYFieldCopy> &plan, bool &identity) {
+        if (source->byte_order() != Struct::ByteOrder::LittleEndian)
+            return false;
+
+        identity = source->size() == target->size();
+        for (const Struct::Field &field : *target) {
+            PLYFieldCopy copy { 0, field.offset, false, 0 };
+            if (source->has_field(field.name)) {
+                const Struct::Field &src_field = source->field(field.name);
+                if (field.type == Struct::Type::Float32) {
+                    if (src_field.type != Struct::Type::Float32)
+                        return false;
+                } else if (field.type == Struct::Type::UInt32) {
+                    if (src_field.type != Struct::Type::UInt32 &&
+                        src_field.type != Struct::Type::Int32)
+                        return false;
+                } else {
+                    return false;
+                }
+                copy.src_offset = src_field.offset;
+                identity &= copy.src_offset == copy.dst_offset;
+            } else if (has_flag(field.flags, Struct::Flags::Default)) {
+                copy.missing = true;
+                if (field.type == Struct::Type::Float32) {
+                    float value = (float) field.default_;
+                    memcpy(&copy.default_value, &value, sizeof(float));
+                } else {
+                    copy.default_value = (uint32_t) field.default_;
+                }
+                identity = false;
+            } else {
+                return false;
+            }
+            plan.push_back(copy);
+        }
+        return true;
+    }
+
+    /// Convert a single record according to a plan from \ref direct_copy_plan()
+    static void convert_direct(const std::vector<PLYFieldCopy> &plan,
+                               const uint8_t *src, uint8_t *dst) {
+        for (const PLYFieldCopy &copy : plan) {
+            if (copy.missing)
+                memcpy(dst + copy.dst_offset, &copy.default_value, sizeof(uint32_t));
+            else
+                memcpy(dst + copy.dst_offset, src + copy.src_offset, sizeof(uint32_t));
+        }
+    }
+
+    /**
+     * \brief Return a pointer to the records of the element \c el within
+     * the memory-mapped file and advance \c stream past them
+     */
+    const uint8_t *map_element(const MemoryMappedFile *mmap, Stream *stream,
+                               const PLYElement &el) {
+        size_t offset = stream->tell(),
+               size   = el.struct_->size() * el.count;
+        if (offset + size > mmap->size())
+            Throw("Error while loading PLY file \"%s\": file is truncated!", m_name);
+        stream->seek(offset + size);
+        return (const uint8_t *) mmap->data() + offset;
+    }
+
     PLYHeader parse_ply_header(Stream *stream) {
         Struct::ByteOrder byte_order = Struct::host_byte_order();
         bool ply_tag_seen = false;
@@ -104,6 +104,10 @@ public:
         return norm(cross(m_frame.s, m_frame.t));
     }
 
+    std::pair<ScalarVector3f, ScalarFloat> normal_cone() const override {
+        return { ScalarVector3f(m_frame.n), 1.f };
+    }
+
     // =============================================================
     //! @{ \name Sampling routines
     // =============================================================
@@ -172,6 +176,13 @@ public:
                       && abs(local.y()) <= 1.f;
     }
 
+    AnalyticShape analytic_parameters(ScalarFloat params[AnalyticParameterCount]) const override {
+        for (size_t i = 0; i < 3; ++i)
+            for (size_t j = 0; j < 4; ++j)
+                params[4 * i + j] = m_to_object.matrix(i, j);
+        return AnalyticShape::Rectangle;
+    }
+
     SurfaceInteraction3f compute_surface_interaction(const Ray3f &ray,
                                                      PreliminaryIntersection3f pi,
                                                      HitComputeFlags flags,
@@ -211,12 +222,14 @@ public:
         Base::traverse(callback);
     }
 
-    void parameters_changed(const std::vector<std::string> &/*keys*/) override {
-        update();
-        Base::parameters_changed();
+    void parameters_changed(const std::vector<std::string> &keys) override {
+        if (keys.empty() || string::contains(keys, "to_world")) {
+            update();
 #if defined(MTS_ENABLE_OPTIX)
-        optix_prepare_geometry();
+            optix_prepare_geometry();
 #endif
+        }
+        Base::parameters_changed(keys);
     }
 
 #if defined(MTS_ENABLE_OPTIX)
@@ -1,9 +1,14 @@
 #include <mitsuba/render/mesh.h>
+#include <mitsuba/core/afstream.h>
 #include <mitsuba/core/fstream.h>
 #include <mitsuba/core/zstream.h>
 #include <mitsuba/core/fresolver.h>
+#include <mitsuba/core/mmap.h>
+#include <mitsuba/core/profiler.h>
 #include <mitsuba/core/properties.h>
 #include <mitsuba/core/timer.h>
+#include <tbb/parallel_for.h>
+#include <mutex>
 
 NAMESPACE_BEGIN(mitsuba)
 
@@ -32,6 +37,22 @@ Serialized mesh loader (:monosp:`serialized`)
    - |transform|
    - Specifies an optional linear object-to-world transformation.
      (Default: none, i.e. object space = world space)
+ * - compress_vertex_data
+   - |bool|
+   - Store the vertex normals, texture coordinates and attributes in compact
+     16-bit encodings, which roughly halves their memory usage at the cost of a
+     small quantization error (CPU variants only). (Default: |false|)
+ * - sort_spatially
+   - |bool|
+   - Reorder the faces along a Morton curve of their centroids and renumber the
+     vertices in the order of their first use, which makes the memory accesses of
+     the ray intersection and emitter sampling more coherent for meshes whose
+     triangles were exported in an arbitrary order (CPU variants only).
+     (Default: |false|)
+ * - read_ahead
+   - |bool|
+   - Read the file on a background thread ahead of the decompression, which hides
+     the latency of slow storage such as network file systems. (Default: |false|)
 
 The serialized mesh format represents the most space and time-efficient way
 of getting geometry information into Mitsuba 2. It stores indexed triangle meshes
@@ -97,6 +118,47 @@ follows:
             :monosp:`uint32` or in :monosp:`uint64` format (the latter is used when the number of
             vertices exceeds :code:`0xFFFFFFFF`).
 
+Block-compressed version
+************************
+
+Version :code:`0x0005` of the format stores the same arrays, but compresses
+them as a sequence of independent :monosp:`zlib` blocks that are listed in
+an offset table. The loader memory-maps the file and decompresses these
+blocks in parallel, and blocks holding data that is not needed (e.g. vertex
+colors) are not decompressed at all. Following the format and version
+identifiers, the header is stored uncompressed:
+
+.. figtable::
+    :label: table-serialized-format-v5
+
+    .. list-table::
+        :widths: 20 80
+        :header-rows: 1
+
+        * - Type
+          - Content
+        * - :monosp:`uint32`
+          - Flags (as above)
+        * - :monosp:`string`
+          - A null-terminated string (utf-8), which denotes the name of the shape.
+        * - :monosp:`uint64`
+          - Number of vertices in the mesh
+        * - :monosp:`uint64`
+          - Number of triangles in the mesh
+        * - :monosp:`uint32`
+          - Number of compressed blocks
+        * - :monosp:`uint64` :math:`\times 3`
+          - For every block: the offset of its compressed data in bytes (relative to the
+            file format identifier of the shape), its compressed size, and its
+            decompressed size.
+
+The decompressed blocks, concatenated in the order of the table, contain the
+arrays listed above. A block may not span more than one array, and each
+block of an array in double precision must hold a whole number of values.
+When the flags include :code:`0x4000`, every block is instead a :monosp:`zstd`
+frame, which decompresses several times faster (this requires a version of
+Mitsuba that was compiled with :monosp:`zstd` support).
+
 Multiple shapes
 ***************
 
@@ -137,6 +199,7 @@ at the end of the file, which specifies the starting position of each sub-mesh:
 #define MTS_FILEFORMAT_HEADER     0x041C
 #define MTS_FILEFORMAT_VERSION_V3 0x0003
 #define MTS_FILEFORMAT_VERSION_V4 0x0004
+#define MTS_FILEFORMAT_VERSION_V5 0x0005
 
 template <typename Float, typename Spectrum>
 class SerializedMesh final : public Mesh<Float, Spectrum> {
@@ -144,7 +207,8 @@ public:
     MTS_IMPORT_BASE(Mesh,m_name, m_bbox, m_to_world, m_vertex_count, m_face_count,
                     m_vertex_positions_buf, m_vertex_normals_buf, m_vertex_texcoords_buf,
                     m_faces_buf, m_disable_vertex_normals, has_vertex_normals, has_vertex_texcoords,
-                    recompute_vertex_normals, vertex_position, vertex_normal, set_children)
+                    recompute_vertex_normals, vertex_position, vertex_normal, m_compress_vertex_data,
+                    m_sort_spatially, compress_vertex_data, sort_spatially, set_children)
     MTS_IMPORT_TYPES()
 
     using typename Base::ScalarSize;
@@ -161,7 +225,8 @@ public:
         HasColors       = 0x0008,
         FaceNormals     = 0x0010,
         SinglePrecision = 0x1000,
-        DoublePrecision = 0x2000
+        DoublePrecision = 0x2000,
+        ZstdBlocks      = 0x4000  // version 5 only
     };
 
     constexpr bool has_flag(TriMeshFlags flags, TriMeshFlags f) {
@@ -190,8 +255,13 @@ public:
             fail("shape index must be nonnegative!");
 
         m_name = tfm::format("%s@%i", file_path.filename(), shape_index);
+        ScopedLoadEvent load_event(LoadEvent::LoadGeometry, m_name);
 
-        ref<Stream> stream = new FileStream(file_path);
+        ref<Stream> stream;
+        if (props.bool_("read_ahead", false))
+            stream = new AsyncFileStream(file_path);
+        else
+            stream = new FileStream(file_path);
         Timer timer;
         stream->set_byte_order(Stream::ELittleEndian);
 
@@ -203,9 +273,11 @@ public:
             fail("encountered an invalid file format!");
 
         if (version != MTS_FILEFORMAT_VERSION_V3 &&
-            version != MTS_FILEFORMAT_VERSION_V4)
+            version != MTS_FILEFORMAT_VERSION_V4 &&
+            version != MTS_FILEFORMAT_VERSION_V5)
             fail("encountered an incompatible file version!");
 
+        size_t shape_offset = 0;
         if (shape_index != 0) {
             size_t file_size = stream->size();
 
@@ -222,30 +294,42 @@ public:
                                  shape_index, count - 1));
 
             // Seek to the correct position
-            if (version == MTS_FILEFORMAT_VERSION_V4) {
+            if (version != MTS_FILEFORMAT_VERSION_V3) {
                 stream->seek(file_size -
                              sizeof(uint64_t) * (count - shape_index) -
                              sizeof(uint32_t));
                 size_t offset = 0;
                 stream->read(offset);
-                stream->seek(offset);
+                shape_offset = offset;
             } else {
-                Assert(version == MTS_FILEFORMAT_VERSION_V3);
                 stream->seek(file_size -
                              sizeof(uint32_t) * (count - shape_index + 1));
                 uint32_t offset = 0;
                 stream->read(offset);
-                stream->seek(offset);
+                shape_offset = offset;
             }
-            stream->skip(sizeof(short) * 2); // Skip the header
+            stream->seek(shape_offset);
+
+            // The shapes of a file may use different versions
+            stream->read(format);
+            stream->read(version);
+            if (format != MTS_FILEFORMAT_HEADER)
+                fail("encountered an invalid file format!");
+            if (version != MTS_FILEFORMAT_VERSION_V3 &&
+                version != MTS_FILEFORMAT_VERSION_V4 &&
+                version != MTS_FILEFORMAT_VERSION_V5)
+                fail("encountered an incompatible file version!");
         }
 
-        stream = new ZStream(stream);
-        stream->set_byte_order(Stream::ELittleEndian);
+        // Version 5 only compresses the arrays, which are read further below
+        if (version != MTS_FILEFORMAT_VERSION_V5) {
+            stream = new ZStream(stream);
+            stream->set_byte_order(Stream::ELittleEndian);
+        }
 
         uint32_t flags = 0;
         stream->read(flags);
-        if (version == MTS_FILEFORMAT_VERSION_V4) {
+        if (version != MTS_FILEFORMAT_VERSION_V3) {
             char ch = 0;
             m_name = "";
             do {
@@ -281,23 +365,31 @@ public:
 
         bool double_precision = has_flag(flags, TriMeshFlags::DoublePrecision);
 
-        read_helper(stream, double_precision, m_vertex_positions_buf.data(), 3);
-
-        if (has_flag(flags, TriMeshFlags::HasNormals)) {
-            if (m_disable_vertex_normals)
-                // Skip over vertex normals provided in the file.
-                advance_helper(stream, double_precision, 3);
-            else
-                read_helper(stream, double_precision, m_vertex_normals_buf.data(), 3);
-        }
+        if (version == MTS_FILEFORMAT_VERSION_V5) {
+            try {
+                read_blocks(file_path, stream, shape_offset, flags);
+            } catch (const std::exception &e) {
+                fail(e.what());
+            }
+        } else {
+            read_helper(stream, double_precision, m_vertex_positions_buf.data(), 3);
+
+            if (has_flag(flags, TriMeshFlags::HasNormals)) {
+                if (m_disable_vertex_normals)
+                    // Skip over vertex normals provided in the file.
+                    advance_helper(stream, double_precision, 3);
+                else
+                    read_helper(stream, double_precision, m_vertex_normals_buf.data(), 3);
+            }
 
-        if (has_flag(flags, TriMeshFlags::HasTexcoords))
-            read_helper(stream, double_precision, m_vertex_texcoords_buf.data(), 2);
+            if (has_flag(flags, TriMeshFlags::HasTexcoords))
+                read_helper(stream, double_precision, m_vertex_texcoords_buf.data(), 2);
 
-        if (has_flag(flags, TriMeshFlags::HasColors))
-            advance_helper(stream, double_precision, 3); // TODO
+            if (has_flag(flags, TriMeshFlags::HasColors))
+                advance_helper(stream, double_precision, 3); // TODO
 
-        stream->read(m_faces_buf.data(), m_face_count * sizeof(ScalarIndex) * 3);
+            stream->read(m_faces_buf.data(), m_face_count * sizeof(ScalarIndex) * 3);
+        }
 
         size_t vertex_data_bytes = 3 * sizeof(InputFloat);
         if (has_vertex_normals())
@@ -315,18 +407,26 @@ public:
         // Post-processing
         InputFloat* position_ptr = m_vertex_positions_buf.data();
         InputFloat* normal_ptr   = m_vertex_normals_buf.data();
-        for (ScalarSize i = 0; i < m_vertex_count; ++i) {
-            InputPoint3f p = m_to_world.transform_affine(vertex_position(i));
-            store_unaligned(position_ptr, p);
-            position_ptr += 3;
-            m_bbox.expand(p);
-
-            if (has_vertex_normals()) {
-                InputNormal3f n = normalize(m_to_world.transform_affine(vertex_normal(i)));
-                store_unaligned(normal_ptr, n);
-                normal_ptr += 3;
+        std::mutex bbox_mutex;
+        tbb::parallel_for(
+            tbb::blocked_range<ScalarSize>(0, m_vertex_count, 16384),
+            [&](const tbb::blocked_range<ScalarSize> &range) {
+                ScalarBoundingBox3f bbox;
+                for (ScalarSize i = range.begin(); i != range.end(); ++i) {
+                    InputPoint3f p = m_to_world.transform_affine(vertex_position(i));
+                    store_unaligned(position_ptr + i * 3, p);
+                    bbox.expand(p);
+
+                    if (has_vertex_normals()) {
+                        InputNormal3f n = normalize(m_to_world.transform_affine(vertex_normal(i)));
+                        store_unaligned(normal_ptr + i * 3, n);
+                    }
+                }
+
+                std::lock_guard<std::mutex> guard(bbox_mutex);
+                m_bbox.expand(bbox);
             }
-        }
+        );
 
         if (!m_disable_vertex_normals && !has_flag(flags, TriMeshFlags::HasNormals)) {
             Timer timer2;
@@ -335,6 +435,12 @@ public:
                 util::time_string(timer2.value()));
         }
 
+        if (m_sort_spatially)
+            sort_spatially();
+
+        if (m_compress_vertex_data)
+            compress_vertex_data();
+
         set_children();
     }
 
@@ -345,12 +451,129 @@ public:
             for (size_t i = 0; i < m_vertex_count * dim; ++i)
                 dst[i] = (float) values[i];
         } else {
-            std::unique_ptr<float[]> values(new float[m_vertex_count * dim]);
-            stream->read_array(values.get(), m_vertex_count * dim);
-            memcpy(dst, values.get(), m_vertex_count * sizeof(InputFloat) * dim);
+            stream->read_array(dst, m_vertex_count * dim);
         }
     }
 
+    /**
+     * \brief Read the arrays of a version 5 shape, whose header has just
+     * been read from \c stream
+     *
+     * The blocks listed in the offset table are decompressed in parallel,
+     * straight into the mesh buffers when no conversion is needed.
+     */
+    void read_blocks(const fs::path &file_path, Stream *stream,
+                     size_t shape_offset, uint32_t flags) {
+        struct Block {
+            uint64_t offset, compressed_size, size;
+            size_t array, array_offset;
+        };
+
+        /// Destination of one of the arrays stored in the file
+        struct Array {
+            uint8_t *dst;     ///< Mesh buffer, or \c nullptr to skip the data
+            size_t size;      ///< Size in the file (bytes)
+            bool convert;     ///< Convert from double precision?
+        };
+
+        bool dp = has_flag(flags, TriMeshFlags::DoublePrecision);
+        size_t value_size = dp ? sizeof(double) : sizeof(float);
+        ZStream::EStreamType stream_type = has_flag(flags, TriMeshFlags::ZstdBlocks)
+                                               ? ZStream::EZstdStream
+                                               : ZStream::EDeflateStream;
+        if (stream_type == ZStream::EZstdStream && !ZStream::has_zstd())
+            Throw("the blocks are compressed using zstd, which is unsupported by "
+                  "this build of Mitsuba");
+
+        std::vector<Array> arrays;
+        arrays.push_back({ (uint8_t *) m_vertex_positions_buf.data(),
+                           (size_t) m_vertex_count * 3 * value_size, dp });
+        if (has_flag(flags, TriMeshFlags::HasNormals))
+            arrays.push_back({ m_disable_vertex_normals
+                                   ? nullptr : (uint8_t *) m_vertex_normals_buf.data(),
+                               (size_t) m_vertex_count * 3 * value_size, dp });
+        if (has_flag(flags, TriMeshFlags::HasTexcoords))
+            arrays.push_back({ (uint8_t *) m_vertex_texcoords_buf.data(),
+                               (size_t) m_vertex_count * 2 * value_size, dp });
+        if (has_flag(flags, TriMeshFlags::HasColors))
+            arrays.push_back({ nullptr, (size_t) m_vertex_count * 3 * value_size, dp });
+        arrays.push_back({ (uint8_t *) m_faces_buf.data(),
+                           (size_t) m_face_count * 3 * sizeof(ScalarIndex), false });
+
+        ref<MemoryMappedFile> mmap = new MemoryMappedFile(file_path);
+        const uint8_t *data = (const uint8_t *) mmap->data() + shape_offset;
+        size_t data_size = mmap->size() - shape_offset;
+
+        uint32_t block_count = 0;
+        stream->read(block_count);
+
+        // Assign each block to the array that it belongs to
+        std::vector<Block> blocks(block_count);
+        size_t array_index = 0, array_offset = 0;
+        for (Block &block : blocks) {
+            stream->read(block.offset);
+            stream->read(block.compressed_size);
+            stream->read(block.size);
+
+            while (array_index < arrays.size() && array_offset == arrays[array_index].size) {
+                array_index++;
+                array_offset = 0;
+            }
+
+            if (block.offset > data_size || block.compressed_size > data_size - block.offset)
+                Throw("block lies outside of the file");
+            if (array_index == arrays.size() ||
+                block.size > arrays[array_index].size - array_offset)
+                Throw("block does not fit into the mesh arrays");
+            if (arrays[array_index].convert && block.size % sizeof(double) != 0)
+                Throw("block holds a partial double precision value");
+
+            block.array = array_index;
+            block.array_offset = array_offset;
+            array_offset += block.size;
+        }
+
+        while (array_index < arrays.size() && array_offset == arrays[array_index].size) {
+            array_index++;
+            array_offset = 0;
+        }
+        if (array_index != arrays.size())
+            Throw("blocks do not cover the mesh arrays");
+
+        // Start reading the blocks that will be decompressed
+        for (const Block &block : blocks)
+            if (arrays[block.array].dst)
+                mmap->prefetch(shape_offset + block.offset, block.compressed_size);
+
+        tbb::parallel_for(
+            tbb::blocked_range<size_t>(0, blocks.size(), 1),
+            [&](const tbb::blocked_range<size_t> &range) {
+                for (size_t i = range.begin(); i != range.end(); ++i) {
+                    const Block &block = blocks[i];
+                    const Array &array = arrays[block.array];
+                    if (!array.dst)
+                        continue;
+
+                    const uint8_t *src = data + block.offset;
+                    if (!array.convert) {
+                        ZStream::decompress(src, block.compressed_size,
+                                            array.dst + block.array_offset, block.size,
+                                            stream_type);
+                    } else {
+                        size_t count = block.size / sizeof(double);
+                        std::unique_ptr<double[]> values(new double[count]);
+                        ZStream::decompress(src, block.compressed_size,
+                                            values.get(), block.size, stream_type);
+                        InputFloat *dst = (InputFloat *) array.dst +
+                                          block.array_offset / sizeof(double);
+                        for (size_t j = 0; j < count; ++j)
+                            dst[j] = (InputFloat) values[j];
+                    }
+                }
+            }
+        );
+    }
+
     /**
      * Simply advances the stream without outputing to the mesh.
      * Since compressed streams do not provide `tell` and `seek`
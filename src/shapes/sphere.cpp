@@ -1,6 +1,7 @@
 #include <mitsuba/core/fwd.h>
 #include <mitsuba/core/math.h>
 #include <mitsuba/core/properties.h>
+#include <mitsuba/core/string.h>
 #include <mitsuba/core/transform.h>
 #include <mitsuba/core/util.h>
 #include <mitsuba/core/warp.h>
@@ -332,6 +333,13 @@ public:
         return solution_found && !out_bounds && !in_bounds && active;
     }
 
+    AnalyticShape analytic_parameters(ScalarFloat params[AnalyticParameterCount]) const override {
+        for (size_t i = 0; i < 3; ++i)
+            params[i] = m_center[i];
+        params[3] = m_radius;
+        return AnalyticShape::Sphere;
+    }
+
     SurfaceInteraction3f compute_surface_interaction(const Ray3f &ray,
                                                      PreliminaryIntersection3f pi,
                                                      HitComputeFlags flags,
@@ -410,12 +418,14 @@ public:
         Base::traverse(callback);
     }
 
-    void parameters_changed(const std::vector<std::string> &/*keys*/) override {
-        update();
-        Base::parameters_changed();
+    void parameters_changed(const std::vector<std::string> &keys) override {
+        if (keys.empty() || string::contains(keys, "to_world")) {
+            update();
 #if defined(MTS_ENABLE_OPTIX)
-        optix_prepare_geometry();
+            optix_prepare_geometry();
 #endif
+        }
+        Base::parameters_changed(keys);
     }
 
 #if defined(MTS_ENABLE_OPTIX)
@@ -0,0 +1,453 @@
+#include <mitsuba/core/fresolver.h>
+#include <mitsuba/core/fstream.h>
+#include <mitsuba/core/fwd.h>
+#include <mitsuba/core/math.h>
+#include <mitsuba/core/profiler.h>
+#include <mitsuba/core/properties.h>
+#include <mitsuba/core/string.h>
+#include <mitsuba/core/struct.h>
+#include <mitsuba/core/timer.h>
+#include <mitsuba/core/transform.h>
+#include <mitsuba/core/util.h>
+#include <mitsuba/render/fwd.h>
+#include <mitsuba/render/interaction.h>
+#include <mitsuba/render/shape.h>
+#include <unordered_map>
+
+NAMESPACE_BEGIN(mitsuba)
+
+/**!
+
+.. _shape-spheres:
+
+Sphere set (:monosp:`spheres`)
+----------------------------------------------------
+
+.. pluginparameters::
+
+ * - filename
+   - |string|
+   - Filename of the PLY file (or the raw binary file) with the centers and
+     radii of the spheres
+ * - radius
+   - |float|
+   - Radius of the spheres whose radius is not specified by the file
+     (Default: 1)
+ * - to_world
+   - |transform|
+   - Specifies an optional linear object-to-world transformation of the
+     centers. The radii are scaled by the cube root of its determinant,
+     hence non-uniform scales are not permitted! (Default: none, i.e. object
+     space = world space)
+
+This shape plugin describes a large set of spheres (e.g. particles written by
+a simulation) that share the same BSDF, emitter and media. Unlike individual
+:ref:`sphere <shape-sphere>` shapes, every sphere only occupies 16 bytes (its
+center and radius), and is a separate primitive of the acceleration data
+structure of the scene.
+
+The spheres are loaded from the ``vertex`` element of a PLY file (in ASCII or
+binary format), whose ``x``, ``y`` and ``z`` properties specify the centers
+and an optional ``radius`` (or ``pscale``) property the radii. Any other file
+is read as a sequence of little endian 32-bit floating point records ``x y z
+radius``.
+
+The ``u`` and ``v`` texture coordinates are the spherical coordinates of the
+hit around the center of the sphere. When Mitsuba is compiled with Embree, the
+native sphere primitives of Embree are used. GPU variants do not support
+sphere sets yet.
+
+.. code-block:: xml
+
+    <shape type="spheres">
+        <string name="filename" value="particles.ply"/>
+        <float name="radius" value="0.01"/>
+        <bsdf type="dielectric"/>
+    </shape>
+ */
+
+template <typename Float, typename Spectrum>
+class Spheres final : public Shape<Float, Spectrum> {
+public:
+    MTS_IMPORT_BASE(Shape, m_to_world, set_children, get_children_string)
+    MTS_IMPORT_TYPES()
+
+    using typename Base::ScalarIndex;
+    using typename Base::ScalarSize;
+    using FloatStorage = DynamicBuffer<replace_scalar_t<Float, ScalarFloat>>;
+
+    Spheres(const Properties &props) : Base(props) {
+        if constexpr (is_cuda_array_v<Float>)
+            Throw("The spheres shape is not supported in GPU variants yet!");
+
+        ScalarFloat default_radius = props.float_("radius", 1.f);
+
+        auto fs = Thread::thread()->file_resolver();
+        fs::path file_path = fs->resolve(props.string("filename"));
+        m_name = file_path.filename().string();
+
+        Log(Debug, "Loading spheres from \"%s\" ..", m_name);
+        if (!fs::exists(file_path))
+            Throw("Sphere file \"%s\" not found!", file_path.string());
+        ScopedLoadEvent load_event(LoadEvent::LoadGeometry, m_name);
+
+        ref<FileStream> stream = new FileStream(file_path);
+        Timer timer;
+
+        std::vector<float> spheres;
+        char magic[4] = { 0, 0, 0, 0 };
+        if (stream->size() >= 4)
+            stream->read(magic, 4);
+        stream->seek(0);
+
+        try {
+            if (strncmp(magic, "ply", 3) == 0 && (magic[3] == '\n' || magic[3] == '\r'))
+                spheres = load_ply(stream, (float) default_radius);
+            else
+                spheres = load_raw(stream);
+        } catch (const std::exception &e) {
+            Throw("Error while loading \"%s\": %s!", m_name, e.what());
+        }
+
+        m_sphere_count = ScalarSize(spheres.size() / 4);
+        if (m_sphere_count == 0)
+            Throw("\"%s\": the file does not contain any spheres!", m_name);
+
+        // Radii follow the (uniform) scale of the transform
+        ScalarVector3f x = m_to_world.transform_affine(ScalarVector3f(1.f, 0.f, 0.f)),
+                       y = m_to_world.transform_affine(ScalarVector3f(0.f, 1.f, 0.f)),
+                       z = m_to_world.transform_affine(ScalarVector3f(0.f, 0.f, 1.f));
+        ScalarFloat radius_scale = std::cbrt(std::abs(dot(x, cross(y, z))));
+
+        m_spheres_buf = empty<FloatStorage>(m_sphere_count * 4);
+        ScalarFloat *ptr = m_spheres_buf.data();
+        m_bbox.reset();
+        m_surface_area = 0.f;
+        for (ScalarSize i = 0; i < m_sphere_count; ++i) {
+            const float *v = spheres.data() + 4 * i;
+            ScalarPoint3f p = m_to_world.transform_affine(ScalarPoint3f(v[0], v[1], v[2]));
+            ScalarFloat radius = std::abs(v[3]) * radius_scale;
+            if (unlikely(!all(enoki::isfinite(p)) || !std::isfinite(radius)))
+                Throw("\"%s\": invalid sphere center or radius (sphere %i)!", m_name, i);
+            store_unaligned(ptr + 4 * i, ScalarVector4f(p.x(), p.y(), p.z(), radius));
+            m_bbox.expand(ScalarBoundingBox3f(p - radius, p + radius));
+            m_surface_area += 4.f * math::Pi<ScalarFloat> * sqr(radius);
+        }
+
+        Log(Debug, "\"%s\": read %i spheres (%s in %s)", m_name, m_sphere_count,
+            util::mem_string(m_sphere_count * 4 * sizeof(ScalarFloat)),
+            util::time_string(timer.value()));
+
+        set_children();
+    }
+
+    /// Load the spheres from the "vertex" element of a PLY file
+    std::vector<float> load_ply(Stream *stream, float default_radius) {
+        std::unordered_map<std::string, Struct::Type> fmt_map = {
+            { "char",  Struct::Type::Int8 },    { "uchar",   Struct::Type::UInt8 },
+            { "short", Struct::Type::Int16 },   { "ushort",  Struct::Type::UInt16 },
+            { "int",   Struct::Type::Int32 },   { "uint",    Struct::Type::UInt32 },
+            { "float", Struct::Type::Float32 }, { "double",  Struct::Type::Float64 },
+            { "int8",  Struct::Type::Int8 },    { "uint8",   Struct::Type::UInt8 },
+            { "int16", Struct::Type::Int16 },   { "uint16",  Struct::Type::UInt16 },
+            { "int32", Struct::Type::Int32 },   { "uint32",  Struct::Type::UInt32 },
+            { "float32", Struct::Type::Float32 }, { "float64", Struct::Type::Float64 }
+        };
+
+        bool ascii = false;
+        Struct::ByteOrder byte_order = Struct::host_byte_order();
+        ref<Struct> vertex_struct;
+        size_t vertex_count = 0;
+        bool vertex_element = false, vertex_seen = false;
+
+        while (true) {
+            std::string line = stream->read_line();
+            std::istringstream iss(line);
+            std::string token;
+            if (!(iss >> token) || token == "ply" || token == "comment" || token == "obj_info")
+                continue;
+
+            if (token == "format") {
+                iss >> token;
+                if (token == "ascii")
+                    ascii = true;
+                else if (token == "binary_little_endian")
+                    byte_order = Struct::ByteOrder::LittleEndian;
+                else if (token == "binary_big_endian")
+                    byte_order = Struct::ByteOrder::BigEndian;
+                else
+                    Throw("invalid PLY header: invalid token after \"format\"");
+            } else if (token == "element") {
+                if (!(iss >> token))
+                    Throw("invalid PLY header: missing token after \"element\"");
+                if (vertex_seen)
+                    vertex_element = false; // Later elements are not read
+                else if (token == "vertex") {
+                    vertex_element = vertex_seen = true;
+                    if (!(iss >> vertex_count))
+                        Throw("invalid PLY header: missing vertex count");
+                    vertex_struct = new Struct(true, byte_order);
+                } else {
+                    Throw("the \"vertex\" element must be the first one of the file");
+                }
+            } else if (token == "property") {
+                if (!vertex_element)
+                    continue;
+                std::string type, name;
+                if (!(iss >> type >> name) || type == "list")
+                    Throw("invalid PLY header: unsupported vertex property \"%s\"", line);
+                auto it = fmt_map.find(type);
+                if (it == fmt_map.end())
+                    Throw("invalid PLY header: unknown format type \"%s\"", type);
+                vertex_struct->append(name == "pscale" ? "radius" : name, it->second);
+            } else if (token == "end_header") {
+                break;
+            } else {
+                Throw("invalid PLY header: unknown token \"%s\"", token);
+            }
+        }
+
+        if (!vertex_struct || !vertex_struct->has_field("x") ||
+            !vertex_struct->has_field("y") || !vertex_struct->has_field("z"))
+            Throw("the file has no vertex positions");
+
+        ref<Struct> target_struct = new Struct();
+        for (auto name : { "x", "y", "z" })
+            target_struct->append(name, Struct::Type::Float32);
+        target_struct->append("radius", Struct::Type::Float32, +Struct::Flags::Default,
+                              default_radius);
+
+        std::vector<float> result(vertex_count * 4);
+        if (ascii) {
+            // Field indices of the target record (-1: not read)
+            std::vector<int> target_index;
+            for (const Struct::Field &field : *vertex_struct) {
+                int index = -1;
+                for (int i = 0; i < 4; ++i)
+                    if (field.name == target_struct->operator[](i).name)
+                        index = i;
+                target_index.push_back(index);
+            }
+
+            std::fstream &is = *((FileStream *) stream)->native();
+            for (size_t i = 0; i < vertex_count; ++i) {
+                float *target = result.data() + 4 * i;
+                target[3] = default_radius;
+                for (int index : target_index) {
+                    double value;
+                    if (!(is >> value))
+                        Throw("could not parse vertex %i", i);
+                    if (index >= 0)
+                        target[index] = (float) value;
+                }
+            }
+        } else {
+            ref<StructConverter> conv = new StructConverter(vertex_struct, target_struct);
+
+            // Convert the records in batches
+            constexpr size_t batch_size = 1024;
+            size_t record_size = vertex_struct->size();
+            std::unique_ptr<uint8_t[]> buf(new uint8_t[batch_size * record_size]);
+            for (size_t i = 0; i < vertex_count; i += batch_size) {
+                size_t count = std::min(batch_size, vertex_count - i);
+                stream->read(buf.get(), count * record_size);
+                if (unlikely(!conv->convert(count, buf.get(), result.data() + 4 * i)))
+                    Throw("incompatible contents");
+            }
+        }
+        return result;
+    }
+
+    /// Load the spheres from a file of little endian (x, y, z, radius) records
+    std::vector<float> load_raw(Stream *stream) {
+        size_t size = stream->size();
+        if (size % (4 * sizeof(float)) != 0)
+            Throw("the size of the file is not a multiple of 16 bytes");
+        std::vector<float> result(size / sizeof(float));
+        stream->set_byte_order(Stream::ELittleEndian);
+        stream->read_array(result.data(), result.size());
+        return result;
+    }
+
+    ScalarBoundingBox3f bbox() const override { return m_bbox; }
+
+    ScalarBoundingBox3f bbox(ScalarIndex index) const override {
+        Assert(index < m_sphere_count);
+        ScalarVector4f s = gather<ScalarVector4f>(m_spheres_buf, index);
+        ScalarPoint3f center(s.x(), s.y(), s.z());
+        return ScalarBoundingBox3f(center - s.w(), center + s.w());
+    }
+
+    ScalarSize primitive_count() const override { return m_sphere_count; }
+
+    ScalarFloat surface_area() const override { return m_surface_area; }
+
+    // =============================================================
+    //! @{ \name Ray tracing routines
+    // =============================================================
+
+    PreliminaryIntersection3f ray_intersect_preliminary(const Ray3f &ray,
+                                                        Mask active) const override {
+        MTS_MASK_ARGUMENT(active);
+
+        // Brute force: only used when the shape is intersected outside of a scene
+        PreliminaryIntersection3f pi = zero<PreliminaryIntersection3f>();
+        pi.t = math::Infinity<Float>;
+        for (ScalarIndex i = 0; i < m_sphere_count; ++i) {
+            PreliminaryIntersection3f prim_pi = ray_intersect_primitive(i, ray, active);
+            masked(pi, prim_pi.t < pi.t) = prim_pi;
+        }
+        pi.shape = this;
+        return pi;
+    }
+
+    Mask ray_test(const Ray3f &ray, Mask active) const override {
+        MTS_MASK_ARGUMENT(active);
+        return ray_intersect_preliminary(ray, active).is_valid();
+    }
+
+    PreliminaryIntersection3f ray_intersect_primitive(ScalarIndex index, const Ray3f &ray,
+                                                      Mask active) const override {
+        MTS_MASK_ARGUMENT(active);
+
+        auto [solution_found, near_t, far_t] = intersect_sphere(index, ray);
+        Float mint = ray.mint, maxt = ray.maxt;
+
+        // Sphere doesn't intersect with the segment on the ray
+        Mask out_bounds = !(near_t <= maxt && far_t >= mint); // NaN-aware conditionals
+
+        // Sphere fully contains the segment of the ray
+        Mask in_bounds = near_t < mint && far_t > maxt;
+
+        active &= solution_found && !out_bounds && !in_bounds;
+
+        PreliminaryIntersection3f pi = zero<PreliminaryIntersection3f>();
+        pi.t = select(active, select(near_t < mint, far_t, near_t),
+                      math::Infinity<Float>);
+        pi.prim_index = index;
+        pi.shape = this;
+        return pi;
+    }
+
+    Mask ray_test_primitive(ScalarIndex index, const Ray3f &ray,
+                            Mask active) const override {
+        MTS_MASK_ARGUMENT(active);
+
+        auto [solution_found, near_t, far_t] = intersect_sphere(index, ray);
+        Float mint = ray.mint, maxt = ray.maxt;
+
+        Mask out_bounds = !(near_t <= maxt && far_t >= mint); // NaN-aware conditionals
+        Mask in_bounds  = near_t < mint && far_t > maxt;
+
+        return solution_found && !out_bounds && !in_bounds && active;
+    }
+
+    SurfaceInteraction3f compute_surface_interaction(const Ray3f &ray,
+                                                     PreliminaryIntersection3f pi,
+                                                     HitComputeFlags flags,
+                                                     Mask active) const override {
+        MTS_MASK_ARGUMENT(active);
+
+        active &= pi.is_valid();
+
+        Vector4f s = gather<Vector4f>(m_spheres_buf, pi.prim_index, active);
+        Point3f center(s.x(), s.y(), s.z());
+        Float radius = s.w();
+
+        SurfaceInteraction3f si = zero<SurfaceInteraction3f>();
+        si.t = select(active, pi.t, math::Infinity<Float>);
+
+        Vector3f n = normalize(ray(pi.t) - center);
+        si.n = si.sh_frame.n = Normal3f(n);
+
+        // Re-project onto the sphere to improve accuracy
+        si.p = fmadd(n, radius, center);
+
+        Float rd_2  = sqr(n.x()) + sqr(n.y()),
+              theta = unit_angle_z(n),
+              phi   = atan2(n.y(), n.x());
+        masked(phi, phi < 0.f) += 2.f * math::Pi<Float>;
+        si.uv = Point2f(phi * math::InvTwoPi<Float>, theta * math::InvPi<Float>);
+
+        Float rd      = sqrt(rd_2),
+              inv_rd  = rcp(rd),
+              cos_phi = n.x() * inv_rd,
+              sin_phi = n.y() * inv_rd;
+
+        Vector3f dn_du = Vector3f(-n.y(), n.x(), 0.f) * (2.f * math::Pi<Float>),
+                 dn_dv = Vector3f(n.z() * cos_phi, n.z() * sin_phi, -rd) * math::Pi<Float>;
+        masked(dn_dv, active && eq(rd, 0.f)) = Vector3f(math::Pi<Float>, 0.f, 0.f);
+
+        si.dp_du = dn_du * radius;
+        si.dp_dv = dn_dv * radius;
+        if (has_flag(flags, HitComputeFlags::dNSdUV)) {
+            si.dn_du = dn_du;
+            si.dn_dv = dn_dv;
+        }
+        si.time = ray.time;
+
+        return si;
+    }
+
+    //! @}
+    // =============================================================
+
+#if defined(MTS_ENABLE_EMBREE)
+    RTCGeometry embree_geometry(RTCDevice device) override {
+        if constexpr (!is_cuda_array_v<Float>) {
+            RTCGeometry geom = rtcNewGeometry(device, RTC_GEOMETRY_TYPE_SPHERE_POINT);
+            rtcSetSharedGeometryBuffer(geom, RTC_BUFFER_TYPE_VERTEX, 0, RTC_FORMAT_FLOAT4,
+                                       m_spheres_buf.data(), 0, 4 * sizeof(ScalarFloat),
+                                       m_sphere_count);
+            rtcCommitGeometry(geom);
+            return geom;
+        } else {
+            Throw("embree_geometry() should only be called in CPU mode.");
+        }
+    }
+#endif
+
+    std::string to_string() const override {
+        std::ostringstream oss;
+        oss << "Spheres[" << std::endl
+            << "  name = \"" << m_name << "\"," << std::endl
+            << "  bbox = " << string::indent(m_bbox) << "," << std::endl
+            << "  sphere_count = " << m_sphere_count << "," << std::endl
+            << "  surface_area = " << m_surface_area << "," << std::endl
+            << "  " << string::indent(get_children_string()) << std::endl
+            << "]";
+        return oss.str();
+    }
+
+    MTS_DECLARE_CLASS()
+private:
+    /// Solve the ray-sphere equation of a sphere (in double precision on the CPU)
+    MTS_INLINE std::tuple<Mask, Float, Float> intersect_sphere(ScalarIndex index,
+                                                              const Ray3f &ray) const {
+        using Double = std::conditional_t<is_cuda_array_v<Float>, Float, Float64>;
+        using Double3 = Vector<Double, 3>;
+
+        ScalarVector4f s = gather<ScalarVector4f>(m_spheres_buf, index);
+        Double3 o = Double3(ray.o) - Double3(ScalarVector3f(s.x(), s.y(), s.z()));
+        Double3 d(ray.d);
+
+        Double A = squared_norm(d);
+        Double B = scalar_t<Double>(2.f) * dot(o, d);
+        Double C = squared_norm(o) - sqr((scalar_t<Double>) s.w());
+
+        auto [solution_found, near_t, far_t] = math::solve_quadratic(A, B, C);
+        return { solution_found, Float(near_t), Float(far_t) };
+    }
+
+    std::string m_name;
+    ScalarSize m_sphere_count = 0;
+    ScalarBoundingBox3f m_bbox;
+    ScalarFloat m_surface_area;
+
+    /// Centers and radii of the spheres (in world space)
+    FloatStorage m_spheres_buf;
+};
+
+MTS_IMPLEMENT_CLASS_VARIANT(Spheres, Shape)
+MTS_EXPORT_PLUGIN(Spheres, "Sphere set intersection primitive");
+NAMESPACE_END(mitsuba)
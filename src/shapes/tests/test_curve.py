@@ -0,0 +1,94 @@
+import mitsuba
+import pytest
+import enoki as ek
+
+
+def write_curves(tmpdir, curves):
+    filename = str(tmpdir.join('curves.txt'))
+    with open(filename, 'w') as f:
+        f.write('# x y z radius\n')
+        f.write('\n\n'.join('\n'.join(' '.join(str(v) for v in p) for p in c)
+                            for c in curves))
+    return filename
+
+
+def test01_create(variant_scalar_rgb, tmpdir):
+    from mitsuba.core import xml
+
+    filename = write_curves(tmpdir, [[[0, 0, 0, 1], [0, 0, 2, 1], [0, 0, 3, 0.5]],
+                                     [[5, 0, 0, 1], [5, 0, 1, 1]]])
+    s = xml.load_dict({'type' : 'curve', 'filename' : filename, 'basis' : 'linear'})
+    assert s.primitive_count() == 3
+    assert ek.allclose(s.bbox().min, [-1, -1, -1])
+    assert ek.allclose(s.bbox().max, [6, 1, 3.5])
+    assert ek.allclose(s.surface_area(),
+                       2 * ek.pi * 2 + ek.pi * 1.5 * ek.sqrt(1.25) + 2 * ek.pi)
+
+    # B-spline curves need at least four control points
+    with pytest.raises(RuntimeError, match='does not contain any curves'):
+        xml.load_dict({'type' : 'curve', 'filename' : filename})
+    with pytest.raises(RuntimeError, match='Invalid curve basis'):
+        xml.load_dict({'type' : 'curve', 'filename' : filename, 'basis' : 'cubic'})
+
+
+def test02_ray_intersect_linear(variant_scalar_rgb, tmpdir):
+    from mitsuba.core import xml, Ray3f
+
+    filename = write_curves(tmpdir, [[[0, 0, 0, 0.5], [0, 0, 2, 0.5], [2, 0, 2, 0.5]]])
+    scene = xml.load_dict({
+        'type' : 'scene',
+        'curve' : { 'type' : 'curve', 'filename' : filename, 'basis' : 'linear' }
+    })
+
+    # Ray against the side of the first segment
+    si = scene.ray_intersect(Ray3f([-3, 0, 1], [1, 0, 0], 0, []))
+    assert si.is_valid()
+    assert ek.allclose(si.t, 2.5)
+    assert ek.allclose(si.n, [-1, 0, 0], atol=1e-5)
+    assert si.prim_index == 0
+    assert ek.allclose(si.uv[0], 0.5)
+
+    # Ray against the second segment
+    si = scene.ray_intersect(Ray3f([1, 0, 5], [0, 0, -1], 0, []))
+    assert si.is_valid()
+    assert ek.allclose(si.t, 2.5)
+    assert si.prim_index == 1
+    assert ek.allclose(si.n, [0, 0, 1], atol=1e-5)
+
+    # Rays passing next to the curve
+    assert not scene.ray_test(Ray3f([-3, 0, 1], [0, 1, 0], 0, []))
+    assert not scene.ray_test(Ray3f([3, 0, 1], [0, 0, 1], 0, []))
+
+
+def test03_ray_intersect_bspline(variant_scalar_rgb, tmpdir):
+    from mitsuba.core import xml, Ray3f
+
+    # Equally spaced collinear control points: the curve goes from z=1 to z=3
+    filename = write_curves(tmpdir, [[[0, 0, z, 0.25] for z in range(5)]])
+    scene = xml.load_dict({
+        'type' : 'scene',
+        'curve' : { 'type' : 'curve', 'filename' : filename }
+    })
+    curve = scene.shapes()[0]
+    assert curve.primitive_count() == 2
+
+    for z in [1.1, 1.5, 2.5, 2.9]:
+        si = scene.ray_intersect(Ray3f([0, -2, z], [0, 1, 0], 0, []))
+        assert si.is_valid()
+        assert ek.allclose(si.t, 1.75, atol=1e-4)
+        assert ek.allclose(si.p, [0, -0.25, z], atol=1e-4)
+        assert ek.allclose(si.n, [0, -1, 0], atol=1e-4)
+        assert si.prim_index == (0 if z < 2 else 1)
+
+    for z in [0.9, 3.1]:
+        assert not scene.ray_test(Ray3f([0, -2, z], [0, 1, 0], 0, []))
+
+    # The shape can also be intersected on its own
+    si = curve.ray_intersect(Ray3f([0, -2, 1.5], [0, 1, 0], 0, []))
+    assert ek.allclose(si.t, 1.75, atol=1e-4)
+
+    # Individual segments
+    ray = Ray3f([0, -2, 1.5], [0, 1, 0], 0, [])
+    assert curve.ray_test_primitive(0, ray)
+    assert not curve.ray_test_primitive(1, ray)
+    assert curve.ray_intersect_primitive(0, ray).prim_index == 0
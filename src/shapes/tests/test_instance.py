@@ -205,3 +205,203 @@ def test03_ray_intersect_instance(variants_all_rgb):
     ray = Ray3f([0.5, 0.5, -12], [0.0, 0.0, 1.0], 0.0, [])
     pi = scene.ray_intersect_preliminary(ray)
     assert 'instance = nullptr' in str(pi) or 'instance = [nullptr]' in str(pi)
+
+
+def test04_instance_bvh(variant_scalar_rgb):
+    """The top-level instance BVH of the native backend must find the same
+    hits as the kd-tree holding the instances directly"""
+    from mitsuba.core import xml, Ray3f, ScalarTransform4f as T
+
+    if mitsuba.core.MTS_ENABLE_EMBREE:
+        pytest.skip("EMBREE enabled")
+
+    def make_scene(instance_bvh):
+        scene_dict = {
+            'type' : 'scene',
+            'instance_bvh' : instance_bvh,
+            'group_0' : {
+                'type' : 'shapegroup',
+                'shape' : { 'type' : 'sphere', 'radius' : 0.3 }
+            },
+            'shape' : {
+                'type' : 'rectangle',
+                'to_world' : T.translate([0.0, 0.0, 1.0]) * T.scale(2.0)
+            }
+        }
+        # Overlapping instances at different depths
+        for i in range(8):
+            for j in range(8):
+                scene_dict['instance_%i_%i' % (i, j)] = {
+                    'type' : 'instance',
+                    'group' : { 'type' : 'ref', 'id' : 'group_0' },
+                    'to_world' : T.translate([(i - 3.5) * 0.25, (j - 3.5) * 0.25,
+                                              ((i + j) % 3) * 0.2])
+                }
+        return xml.load_dict(scene_dict)
+
+    scene_bvh, scene_kd = make_scene(True), make_scene(False)
+
+    n = 24
+    for x in range(n):
+        for y in range(n):
+            ray = Ray3f([x / (n - 1) * 2.4 - 1.2, y / (n - 1) * 2.4 - 1.2, -5],
+                        [0.0, 0.0, 1.0], 0.0, [])
+            si_bvh, si_kd = scene_bvh.ray_intersect(ray), scene_kd.ray_intersect(ray)
+            assert si_bvh.is_valid() == si_kd.is_valid()
+            assert ek.allclose(si_bvh.t, si_kd.t)
+            assert scene_bvh.ray_test(ray) == scene_kd.ray_test(ray)
+
+
+@pytest.mark.parametrize("instance_bvh", [True, False])
+def test05_animated_instance(variant_scalar_rgb, instance_bvh):
+    from mitsuba.core import xml, Ray3f
+
+    if mitsuba.core.MTS_ENABLE_EMBREE:
+        pytest.skip("EMBREE enabled")
+
+    scene = xml.load_string('''
+        <scene version="2.0.0">
+            <boolean name="instance_bvh" value="%s"/>
+            <shapegroup id="group_0">
+                <shape type="rectangle">
+                    <transform name="to_world">
+                        <scale value="0.25"/>
+                    </transform>
+                </shape>
+            </shapegroup>
+            <shape type="instance">
+                <ref id="group_0"/>
+                <animation name="to_world">
+                    <transform time="0">
+                        <translate x="-1"/>
+                    </transform>
+                    <transform time="1">
+                        <translate x="1" z="0.5"/>
+                        <rotate y="1" angle="30"/>
+                    </transform>
+                </animation>
+            </shape>
+        </scene>
+    ''' % ("true" if instance_bvh else "false"))
+
+    instance = scene.shapes()[0]
+    assert instance.has_motion()
+    assert ek.allclose(instance.motion_time_range(), [0, 1])
+
+    # Follow the center of the rectangle, which moves linearly
+    for time in [0.0, 0.25, 0.5, 0.75, 1.0]:
+        x = -1 + 2 * time
+        ray = Ray3f([x, 0, -5], [0, 0, 1], time, [])
+        si = scene.ray_intersect(ray)
+        assert si.is_valid()
+        assert si.instance is not None
+        assert ek.allclose(si.t, 5 + 0.5 * time, atol=1e-4)
+        assert ek.allclose(si.p, [x, 0, 0.5 * time], atol=1e-4)
+        assert scene.ray_test(ray)
+
+        # The rectangle has moved away from the start position
+        if time > 0.5:
+            assert not scene.ray_test(Ray3f([-1, 0, -5], [0, 0, 1], time, []))
+
+
+@fresolver_append_path
+def test06_emissive_instance(variant_scalar_rgb):
+    """Every instance of emissive shapes is an emitter, which samples the
+    shapes of the group through the transformation of the instance"""
+    from mitsuba.core import xml, Ray3f, ScalarTransform4f as T
+    from mitsuba.render import SurfaceInteraction3f
+
+    scene = xml.load_dict({
+        'type' : 'scene',
+        'group_0' : {
+            'type' : 'shapegroup',
+            'rect' : {
+                'type' : 'rectangle',
+                'emitter' : { 'type' : 'area', 'radiance' : { 'type' : 'rgb', 'value' : 2.0 } }
+            },
+            'mesh' : {
+                'type' : 'obj',
+                'filename' : 'resources/data/common/meshes/rectangle.obj',
+                'to_world' : T.translate([3, 0, 0]),
+                'emitter' : { 'type' : 'area', 'radiance' : { 'type' : 'rgb', 'value' : 3.0 } }
+            }
+        },
+        # Stretched within the plane of the rectangles: the area doubles
+        'instance_0' : {
+            'type' : 'instance',
+            'group' : { 'type' : 'ref', 'id' : 'group_0' },
+            'to_world' : T.translate([0, 0, -3]) * T.scale([2, 1, 1])
+        },
+        # Stretched along their normal: the area is unchanged
+        'instance_1' : {
+            'type' : 'instance',
+            'group' : { 'type' : 'ref', 'id' : 'group_0' },
+            'to_world' : T.translate([0, -6, 5]) * T.rotate([1, 0, 0], -90) * T.scale([1, 1, 3])
+        }
+    })
+
+    assert len(scene.emitters()) == 2
+    assert all(e.class_().name() == 'InstanceAreaLight' for e in scene.emitters())
+
+    it = SurfaceInteraction3f()
+    it.p = [0.3, 0.2, 5.0]
+    it.time = 0.0
+
+    import numpy as np
+    rng = np.random.RandomState(1234)
+    for k in range(100):
+        ds, spec = scene.sample_emitter_direction(it, rng.uniform(size=2), False)
+        assert ds.pdf > 0
+        assert ek.allclose(scene.pdf_emitter_direction(it, ds), ds.pdf, rtol=1e-4)
+
+        # Uniform density over the world space area of the chosen instance
+        first = ds.p[2] < 0
+        area = 16.0 if first else 8.0
+        cos_theta = -ek.dot(ds.d, ds.n)
+        assert ek.allclose(ds.pdf, 0.5 / area * ds.dist**2 / cos_theta, rtol=1e-4)
+
+        radiance = 3.0 if ds.p[0] > (3.0 if first else 1.5) else 2.0
+        assert ek.allclose(spec * ds.pdf, radiance, rtol=1e-4)
+
+        # Hitting the same point resolves to the emitter of the instance
+        si = scene.ray_intersect(Ray3f(it.p, ds.d, 0, []))
+        assert ek.allclose(si.t, ds.dist, rtol=1e-4)
+        emitter = si.emitter(scene)
+        assert emitter.class_().name() == 'InstanceAreaLight'
+        assert ek.allclose(emitter.eval(si), radiance)
+
+
+def test07_many_shapegroups(variant_scalar_rgb):
+    """The kd-trees of shape groups of different sizes are built concurrently
+    by the scene, which must not change the hits of their instances"""
+    from mitsuba.core import xml, Ray3f, ScalarTransform4f as T
+
+    scene_dict = { 'type' : 'scene' }
+    for i in range(12):
+        group = { 'type' : 'shapegroup' }
+        # Groups with one to twelve spheres along the z axis
+        for k in range(i + 1):
+            group['sphere_%i' % k] = {
+                'type' : 'sphere',
+                'radius' : 0.2,
+                'center' : [0.0, 0.0, 0.5 * k]
+            }
+        scene_dict['group_%i' % i] = group
+        scene_dict['instance_%i' % i] = {
+            'type' : 'instance',
+            'group' : { 'type' : 'ref', 'id' : 'group_%i' % i },
+            'to_world' : T.translate([float(i), 0.0, 0.0])
+        }
+    scene = xml.load_dict(scene_dict)
+
+    for i in range(12):
+        # Rays along the z axis of each instance hit its first sphere
+        si = scene.ray_intersect(Ray3f([float(i), 0.0, -5.0], [0.0, 0.0, 1.0], 0.0, []))
+        assert si.is_valid()
+        assert ek.allclose(si.t, 4.8)
+
+        # Rays from the side hit the last sphere of the group
+        ray = Ray3f([float(i), -5.0, 0.5 * i], [0.0, 1.0, 0.0], 0.0, [])
+        assert ek.allclose(scene.ray_intersect(ray).t, 4.8)
+        ray = Ray3f([float(i), -5.0, 0.5 * (i + 1)], [0.0, 1.0, 0.0], 0.0, [])
+        assert not scene.ray_test(ray)
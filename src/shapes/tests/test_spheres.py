@@ -0,0 +1,82 @@
+import mitsuba
+import pytest
+import enoki as ek
+import struct
+
+SPHERES = [(0, 0, 0, 1), (3, 0, 0, 0.5), (0, 4, 1, 2)]
+
+
+def write_ply(filename, spheres, binary, radius=True):
+    props = ['x', 'y', 'z'] + (['radius'] if radius else [])
+    header = 'ply\nformat %s 1.0\ncomment test\nelement vertex %i\n' % (
+        'binary_little_endian' if binary else 'ascii', len(spheres))
+    header += ''.join('property float %s\n' % p for p in props)
+    header += 'end_header\n'
+    with open(filename, 'wb') as f:
+        f.write(header.encode())
+        for s in spheres:
+            s = s[:len(props)]
+            if binary:
+                f.write(struct.pack('<%if' % len(s), *s))
+            else:
+                f.write((' '.join(str(v) for v in s) + '\n').encode())
+
+
+def test01_load(variant_scalar_rgb, tmpdir):
+    from mitsuba.core import xml
+
+    names = []
+    for binary in [False, True]:
+        names.append(str(tmpdir.join('spheres_%i.ply' % binary)))
+        write_ply(names[-1], SPHERES, binary)
+    names.append(str(tmpdir.join('spheres.bin')))
+    with open(names[-1], 'wb') as f:
+        for s in SPHERES:
+            f.write(struct.pack('<4f', *s))
+
+    for filename in names:
+        s = xml.load_dict({'type' : 'spheres', 'filename' : filename})
+        assert s.primitive_count() == 3
+        assert ek.allclose(s.surface_area(), 4 * ek.pi * (1 + 0.25 + 4))
+        assert ek.allclose(s.bbox().min, [-2, -1, -1])
+        assert ek.allclose(s.bbox().max, [3.5, 6, 3])
+
+    # Radius of the spheres without a radius property, scaled by the transform
+    from mitsuba.core import ScalarTransform4f
+    filename = str(tmpdir.join('centers.ply'))
+    write_ply(filename, SPHERES, True, radius=False)
+    s = xml.load_dict({'type' : 'spheres', 'filename' : filename, 'radius' : 0.1,
+                       'to_world' : ScalarTransform4f.scale(2)})
+    assert ek.allclose(s.surface_area(), 3 * 4 * ek.pi * 0.2**2)
+    assert ek.allclose(s.bbox().max, [6.2, 8.2, 2.2])
+
+
+def test02_ray_intersect(variant_scalar_rgb, tmpdir):
+    from mitsuba.core import xml, Ray3f
+
+    filename = str(tmpdir.join('spheres.ply'))
+    write_ply(filename, SPHERES, True)
+    scene = xml.load_dict({
+        'type' : 'scene',
+        'spheres' : { 'type' : 'spheres', 'filename' : filename }
+    })
+
+    si = scene.ray_intersect(Ray3f([3, -5, 0], [0, 1, 0], 0, []))
+    assert si.is_valid()
+    assert si.prim_index == 1
+    assert ek.allclose(si.t, 4.5)
+    assert ek.allclose(si.p, [3, -0.5, 0])
+    assert ek.allclose(si.n, [0, -1, 0])
+    assert ek.allclose(si.uv, [0.75, 0.5])
+
+    # Closest of two spheres along the ray
+    si = scene.ray_intersect(Ray3f([0, -5, 0.5], [0, 1, 0], 0, []))
+    assert si.prim_index == 0
+    assert scene.ray_test(Ray3f([0, 10, 1], [0, -1, 0], 0, []))
+    assert not scene.ray_test(Ray3f([2.1, -5, 0], [0, 1, 0], 0, []))
+
+    shape = scene.shapes()[0]
+    ray = Ray3f([0, 10, 1], [0, -1, 0], 0, [])
+    assert ek.allclose(shape.ray_intersect(ray).t, 4)
+    assert shape.ray_intersect_primitive(2, ray).prim_index == 2
+    assert not shape.ray_test_primitive(1, ray)
@@ -15,6 +15,25 @@ Irregular spectrum (:monosp:`irregular`)
 This spectrum returns linearly interpolated reflectance or emission values from *irregularly*
 placed samples.
 
+.. pluginparameters::
+
+ * - wavelengths
+   - |string|
+   - Comma-separated list of the wavelengths (in nanometers) at which the spectrum is specified.
+ * - values
+   - |string|
+   - Comma-separated list of the values of the spectrum at these wavelengths.
+ * - resample_step
+   - |float|
+   - When positive, the spectrum is resampled on a regular grid with (at most) this spacing in
+     nanometers when it is loaded. Lookups then directly index the grid instead of searching the
+     interval that contains each wavelength. (Default: 0, i.e. disabled)
+ * - resample_tolerance
+   - |float|
+   - Largest admissible difference between the resampled and original spectra, relative to the
+     largest value. The irregular representation is kept (with a warning) when it is exceeded.
+     (Default: 0.001)
+
  */
 
 template <typename Float, typename Spectrum>
@@ -62,6 +81,16 @@ public:
                 wavelengths, values, size
             );
         }
+
+        // Long tables are sampled in constant time (short ones keep the monotonic CDF mapping)
+        if (m_distr.size() > 64)
+            m_distr.build_alias_table();
+
+        m_resample_step = props.float_("resample_step", 0.f);
+        m_resample_tolerance = props.float_("resample_tolerance", 1e-3f);
+        if (m_resample_step < 0.f || m_resample_tolerance < 0.f)
+            Throw("IrregularSpectrum: 'resample_step' and 'resample_tolerance' must be non-negative!");
+        resample();
     }
 
     void traverse(TraversalCallback *callback) override {
@@ -71,13 +100,17 @@ public:
 
     void parameters_changed(const std::vector<std::string> &/*keys*/) override {
         m_distr.update();
+        resample();
     }
 
     UnpolarizedSpectrum eval(const SurfaceInteraction3f &si, Mask active) const override {
         MTS_MASKED_FUNCTION(ProfilerPhase::TextureEvaluate, active);
 
-        if constexpr (is_spectral_v<Spectrum>)
+        if constexpr (is_spectral_v<Spectrum>) {
+            if (m_resampled)
+                return m_regular.eval_pdf(si.wavelengths, active);
             return m_distr.eval_pdf(si.wavelengths, active);
+        }
         else {
             ENOKI_MARK_USED(si);
             NotImplementedError("eval");
@@ -87,8 +120,11 @@ public:
     Wavelength pdf_spectrum(const SurfaceInteraction3f &si, Mask active) const override {
         MTS_MASKED_FUNCTION(ProfilerPhase::TextureEvaluate, active);
 
-        if constexpr (is_spectral_v<Spectrum>)
+        if constexpr (is_spectral_v<Spectrum>) {
+            if (m_resampled)
+                return m_regular.eval_pdf_normalized(si.wavelengths, active);
             return m_distr.eval_pdf_normalized(si.wavelengths, active);
+        }
         else {
             ENOKI_MARK_USED(si);
             NotImplementedError("pdf");
@@ -100,8 +136,11 @@ public:
                                                       Mask active) const override {
         MTS_MASKED_FUNCTION(ProfilerPhase::TextureSample, active);
 
-        if constexpr (is_spectral_v<Spectrum>)
+        if constexpr (is_spectral_v<Spectrum>) {
+            if (m_resampled)
+                return { m_regular.sample(sample, active), m_regular.integral() };
             return { m_distr.sample(sample, active), m_distr.integral() };
+        }
         else {
             ENOKI_MARK_USED(sample);
             NotImplementedError("sample");
@@ -109,20 +148,85 @@ public:
     }
 
     ScalarFloat mean() const override {
-        return m_distr.integral() / (MTS_WAVELENGTH_MAX - MTS_WAVELENGTH_MIN);
+        ScalarFloat integral = m_resampled ? m_regular.integral() : m_distr.integral();
+        return integral / (MTS_WAVELENGTH_MAX - MTS_WAVELENGTH_MIN);
     }
 
     std::string to_string() const override {
         std::ostringstream oss;
         oss << "IrregularSpectrum[" << std::endl
-            << "  distr = " << string::indent(m_distr) << std::endl
-            << "]";
+            << "  distr = " << string::indent(m_distr);
+        if (m_resampled)
+            oss << "," << std::endl
+                << "  resampled = " << string::indent(m_regular);
+        oss << std::endl << "]";
         return oss.str();
     }
 
     MTS_DECLARE_CLASS()
 private:
+    /**
+     * \brief Resample the spectrum on a regular grid if requested
+     *
+     * The grid interpolant differs the most from the original one at the
+     * irregular nodes, which are checked against the tolerance. When it is
+     * exceeded, lookups keep using the irregular representation.
+     */
+    void resample() {
+        m_resampled = false;
+        m_regular = ContinuousDistribution<Wavelength>();
+        if (m_resample_step <= 0.f)
+            return;
+
+        const ScalarFloat *nodes  = m_distr.nodes().data(),
+                          *values = m_distr.pdf().data();
+        size_t size = m_distr.size();
+        ScalarVector2f range = m_distr.range();
+
+        size_t grid_size = std::max((size_t) 2, (size_t) std::ceil(
+            (range.y() - range.x()) / m_resample_step) + 1);
+        ScalarFloat grid_step = (range.y() - range.x()) / (grid_size - 1);
+
+        // Sample the irregular interpolant at the grid points
+        std::vector<ScalarFloat> data(grid_size);
+        for (size_t i = 0, j = 0; i < grid_size; ++i) {
+            ScalarFloat x = i + 1 < grid_size ? range.x() + i * grid_step : range.y();
+            while (j + 2 < size && nodes[j + 1] <= x)
+                ++j;
+            ScalarFloat width = nodes[j + 1] - nodes[j],
+                        t = width > 0.f ? clamp((x - nodes[j]) / width, 0.f, 1.f) : 1.f;
+            data[i] = lerp(values[j], values[j + 1], t);
+        }
+
+        // Compare both interpolants at the irregular nodes
+        ScalarFloat max_error = 0.f, max_value = 0.f;
+        for (size_t i = 0; i < size; ++i) {
+            ScalarFloat t = (nodes[i] - range.x()) / grid_step;
+            size_t index = std::min((size_t) std::max(t, 0.f), grid_size - 2);
+            ScalarFloat value = lerp(data[index], data[index + 1],
+                                     clamp(t - index, 0.f, 1.f));
+            max_error = std::max(max_error, std::abs(value - values[i]));
+            max_value = std::max(max_value, std::abs(values[i]));
+        }
+
+        if (max_error > m_resample_tolerance * max_value) {
+            Log(Warn, "IrregularSpectrum: resampling with a step of %g nm yields a relative "
+                      "error of %g (> %g), keeping the irregular representation.",
+                m_resample_step, max_error / max_value, m_resample_tolerance);
+            return;
+        }
+
+        m_regular = ContinuousDistribution<Wavelength>(range, data.data(), grid_size);
+        if (m_regular.size() > 64)
+            m_regular.build_alias_table();
+        m_resampled = true;
+    }
+
     IrregularContinuousDistribution<Wavelength> m_distr;
+    ContinuousDistribution<Wavelength> m_regular;
+    ScalarFloat m_resample_step;
+    ScalarFloat m_resample_tolerance;
+    bool m_resampled = false;
 };
 
 MTS_IMPLEMENT_CLASS_VARIANT(IrregularSpectrum, Texture)
@@ -54,6 +54,10 @@ public:
                 wavelength_range, values, size
             );
         }
+
+        // Long tables are sampled in constant time (short ones keep the monotonic CDF mapping)
+        if (m_distr.size() > 64)
+            m_distr.build_alias_table();
     }
 
     void traverse(TraversalCallback *callback) override {
@@ -60,6 +60,14 @@ public:
             return m_value;
     }
 
+    ScalarFloat mean() const override {
+        // Approximates the mean of the product by the product of the means
+        if constexpr (is_spectral_v<Spectrum>)
+            return scalar_cast(hmean(srgb_model_mean(m_value))) * m_d65->mean();
+        else
+            return scalar_cast(hmean(hmean(m_value)));
+    }
+
     void traverse(TraversalCallback *callback) override {
         callback->put_parameter("value", m_value);
     }
@@ -45,3 +45,30 @@ def test02_sample_spectrum(variant_scalar_spectral, obj):
         obj.sample_spectrum(si, .5),
         [576.777, 212.5]
     )
+
+
+def test03_resample(variant_scalar_spectral):
+    from mitsuba.core.xml import load_string
+    from mitsuba.render import SurfaceInteraction3f
+
+    def load(step):
+        return load_string('''
+            <spectrum version='2.0.0' type='irregular'>
+                <string name="wavelengths" value="500, 520, 600, 650"/>
+                <string name="values" value="1, 1.2, 2, .5"/>
+                <float name="resample_step" value="%f"/>
+            </spectrum>''' % step)
+
+    irregular, regular = load(0), load(10)
+    assert 'resampled' not in str(irregular)
+    assert 'resampled' in str(regular)
+
+    si = SurfaceInteraction3f()
+    for i in range(26):
+        si.wavelengths = 440 + 10 * i
+        assert ek.allclose(regular.eval(si), irregular.eval(si))
+        assert ek.allclose(regular.pdf_spectrum(si), irregular.pdf_spectrum(si))
+    assert ek.allclose(regular.mean(), irregular.mean())
+
+    # Grid points that miss the nodes exceed the tolerance: keep the original spectrum
+    assert 'resampled' not in str(load(7))
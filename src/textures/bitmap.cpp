@@ -1,14 +1,23 @@
+#include <mitsuba/core/afstream.h>
 #include <mitsuba/core/bitmap.h>
 #include <mitsuba/core/fresolver.h>
+#include <mitsuba/core/hash.h>
+#include <mitsuba/core/memory.h>
 #include <mitsuba/core/plugin.h>
+#include <mitsuba/core/profiler.h>
 #include <mitsuba/core/properties.h>
 #include <mitsuba/core/spectrum.h>
+#include <mitsuba/core/tilecache.h>
 #include <mitsuba/core/distr_2d.h>
+#include <mitsuba/render/cuda_texture.h>
 #include <mitsuba/render/interaction.h>
 #include <mitsuba/render/texture.h>
 #include <mitsuba/render/srgb.h>
+#include <enoki/half.h>
+#include <atomic>
 #include <mutex>
-#include <tbb/spin_mutex.h>
+#include <unordered_map>
+#include <tbb/parallel_for.h>
 
 NAMESPACE_BEGIN(mitsuba)
 
@@ -35,6 +44,18 @@ Bitmap texture (:monosp:`bitmap`)
      - ``nearest``: disable filtering and interpolation. In this mode, the plugin
        performs nearest neighbor lookups of texture values.
 
+     - ``trilinear``: interpolate within a MIP map pyramid, choosing the level
+       from the size of the pixel footprint in texture space.
+
+     - ``anisotropic``: combine several trilinear lookups along the major axis
+       of the pixel footprint, which keeps textures seen at grazing angles
+       sharp. This approximates elliptically weighted average (EWA) filtering.
+
+ * - max_anisotropy
+   - |int|
+   - Maximum number of trilinear lookups of the ``anisotropic`` filter, which
+     bounds the ratio of the axes of the footprints that it resolves. (Default: 8)
+
  * - wrap_mode
    - |string|
    - Controls the behavior of texture evaluations that fall outside of the
@@ -58,6 +79,72 @@ Bitmap texture (:monosp:`bitmap`)
      values. A 4x4 matrix can also be provided, in which case the extra row and
      column are ignored.
 
+ * - tiled
+   - |bool|
+   - Keep the texture on disk and only load the tiles that are accessed through
+     a global cache of fixed size? (Default: false)
+
+ * - tile_size
+   - |int|
+   - Edge length (in pixels) of the tiles of a ``tiled`` texture. (Default: 64)
+
+ * - compressed
+   - |bool|
+   - Store the texture in the block compressed BC1 (color) or BC4 (monochrome)
+     formats, which reduces its memory usage by a factor of 6 or 4 (with three
+     or one channels), at the cost of some accuracy and of decoding every texel
+     lookup. (Default: false)
+
+ * - half_precision
+   - |bool|
+   - Store the texels as half precision floating point values, which halves
+     the memory usage and bandwidth of the texture lookups. Their values are
+     converted to single precision when they are fetched. (Default: false)
+
+ * - blocked
+   - |bool|
+   - Store the pixels in blocks of 8x8 pixels instead of rows, so that the
+     pixels accessed by an interpolated lookup are usually close to each other
+     in memory. This improves the cache hit rate of incoherent lookups into
+     large textures. (Default: false)
+
+ * - read_ahead
+   - |bool|
+   - Read the image file on a background thread ahead of its decoding, which hides
+     the latency of slow storage such as network file systems. (Default: false)
+
+ * - coefficient_interpolation
+   - |bool|
+   - In spectral variants, interpolate the coefficients of the spectral
+     upsampling model of neighboring texels and evaluate the model once per
+     lookup, instead of evaluating it for each texel and interpolating the
+     resulting spectra. This is faster, but blends saturated colors slightly
+     differently. (Default: false)
+
+ * - cuda_texture
+   - |bool|
+   - In GPU variants, perform the lookups of ``nearest`` and ``bilinear``
+     textures through the texture units of the GPU, which interpolate and wrap
+     the coordinates in hardware and have a dedicated cache. (Default: false)
+
+ * - cache_lookups
+   - |bool|
+   - In scalar variants, remember the most recent lookups of each rendering thread,
+     so that BSDFs evaluating the texture several times at the same surface
+     interaction (e.g. for emitter sampling and BSDF sampling) only filter it
+     once. (Default: false)
+
+ * - shared
+   - |bool|
+   - Share the loaded image with the other bitmap textures that reference the same
+     file with the same settings? Disable this when the pixels of such textures are
+     optimized separately. (Default: true)
+
+ * - lazy
+   - |bool|
+   - Only read the header of the image when the scene is loaded, and decode the
+     pixels when the texture is used for the first time? (Default: false)
+
 This plugin provides a bitmap texture that performs interpolated lookups given
 a JPEG, PNG, OpenEXR, RGBE, TGA, or BMP input file.
 
@@ -74,15 +161,331 @@ These conversions can alternatively be disabled with the :paramtype:`raw` flag,
 e.g. when textured data is already in linear space or does not represent colors
 at all.
 
+The ``trilinear`` and ``anisotropic`` filters downsample the image into a MIP map
+pyramid when it is loaded, which adds a third to the memory usage of the
+texture. They require the UV partials of the surface interaction, which the
+BSDFs compute from the ray differentials of camera rays. Other rays (e.g. after
+the first bounce) carry no differentials and use the full-resolution level. The
+``data`` parameter exposed by such a texture holds all levels of the pyramid,
+starting with the full-resolution image.
+
+Block compressed textures split each level into blocks of 4x4 pixels that store
+two endpoint colors and a 2 or 3 bit index per pixel, which selects a color on
+the line between them. Unless :paramtype:`raw` is set, the colors are encoded
+with the sRGB transfer curve to preserve their precision in dark regions.
+Spectral variants cannot compress color textures (the model coefficients do not
+fit into these formats) and store them uncompressed. Like tiled textures,
+compressed ones cannot be importance sampled or differentiated.
+
+Textures stored with :paramtype:`half_precision` keep roughly three significant
+digits and can represent values of up to 65504, which suffices for most color
+and HDR data. They can be importance sampled, but their pixels are not exposed
+as a differentiable parameter, and neither are the pixels of :paramtype:`blocked`
+textures (whose storage order differs from the image).
+
+With :paramtype:`cuda_texture`, GPU variants keep a second copy of the pixels in
+a CUDA texture object and resolve the ``nearest`` and ``bilinear`` lookups with
+the texture hardware. It computes the interpolation weights with 8 bits of
+fractional precision, and breaks the fusion of the surrounding computation into
+a single kernel at every lookup. This pays off for large textures that are
+accessed incoherently. Lookups that require gradients (with respect to the
+pixels or to the UV coordinates) always use the software implementation. The
+option is ignored by CPU variants, and by textures using the other filters or
+one of the more compact storage formats. In spectral variants, bilinear lookups
+of color textures additionally require :paramtype:`coefficient_interpolation`.
+
+With :paramtype:`cache_lookups`, each rendering thread keeps a small table of
+the results of its recent lookups, which are identified by the texture, the UV
+coordinates and their partials, and the wavelengths. A repeated lookup at the
+same surface interaction is then answered from the table instead of being
+filtered again, which pays off for the more expensive filters and storage
+formats. The table is ignored by vectorized and GPU variants, and the entries
+of a texture are invalidated when its parameters change.
+
+Textures that load the same file with the same settings only load and convert it
+once, and then share the result (including its parameters, which are exposed by
+each of them). It is released once none of these textures is used anymore.
+
+Scenes with many large textures can enable :paramtype:`tiled`, which converts the
+image into a MIP map pyramid of square tiles the first time it is loaded and
+stores the result next to the original file (``<filename>.<mode>.mtstex``). The
+file is regenerated when the image or the tiling parameters change. Renderings
+then only read the tiles that they actually access through a cache that is shared
+by all tiled textures (1 GiB by default, see ``TileCache.set_capacity()`` in
+Python), and which evicts the least recently used tiles when it is full. The
+profiler reports the number of lookups and cache misses. Tiled textures are only
+supported by CPU variants and cannot be importance sampled or differentiated. Their
+mean value is estimated from the coarsest level of the pyramid.
+
+Textures with :paramtype:`lazy` enabled only read the resolution and the pixel
+format of the image while the scene is loaded, so that scenes referencing many
+textures, of which only some are visible, load quickly and do not hold the
+pixels of unused textures in memory. The first texture lookup, mean query,
+sampling operation, or parameter traversal decodes the image (once, even when
+several rendering threads arrive at the same time) and then proceeds as if the
+texture had been loaded directly. Such lazily decoded textures still share their
+pixels with the other textures that load the same file with the same settings.
+The option is ignored by GPU variants, where the decoding would have to happen
+while a kernel is being recorded.
+
 */
 
-enum class FilterType { Nearest, Bilinear };
+enum class FilterType { Nearest, Bilinear, Trilinear, Anisotropic };
 enum class WrapMode { Repeat, Mirror, Clamp };
 
 // Forward declaration of specialized bitmap texture
 template <typename Float, typename Spectrum, uint32_t Channels, bool Raw>
 class BitmapTextureImpl;
 
+// Forward declaration of the texture that decodes the image upon first use
+template <typename Float, typename Spectrum>
+class LazyBitmapTexture;
+
+NAMESPACE_BEGIN(detail)
+/// Per-thread statistics of the tiled textures, reported to the profiler in batches
+struct TileCacheStatistics {
+    uint32_t queries = 0, misses = 0;
+
+    ~TileCacheStatistics() { flush(); }
+
+    void add(uint32_t queries_, uint32_t misses_) {
+        queries += queries_;
+        misses += misses_;
+        if (queries >= (1u << 16))
+            flush();
+    }
+
+    void flush() {
+        profiler_count(ProfilerCounter::TileCacheQueries, queries);
+        profiler_count(ProfilerCounter::TileCacheMisses, misses);
+        queries = misses = 0;
+    }
+};
+
+static thread_local TileCacheStatistics tile_cache_statistics;
+
+/**
+ * \brief Per-thread table of recent lookups of bitmap textures in scalar
+ * variants (see the ``cache_lookups`` parameter)
+ *
+ * The entries are direct-mapped by a hash of the texture and the UV
+ * coordinates. The texture is identified by a unique id, which changes along
+ * with its parameters, so that stale entries are never matched.
+ */
+template <typename SurfaceInteraction3f, typename Value> struct LookupCache {
+    using Point2f    = decltype(SurfaceInteraction3f::uv);
+    using Vector2f   = decltype(SurfaceInteraction3f::duv_dx);
+    using Wavelength = decltype(SurfaceInteraction3f::wavelengths);
+
+    static constexpr size_t Size = 32;
+
+    struct Entry {
+        uint64_t id = 0;
+        Point2f uv;
+        Vector2f duv_dx, duv_dy;
+        Wavelength wavelengths;
+        Value value;
+    };
+
+    template <typename Func>
+    Value lookup(uint64_t id, const SurfaceInteraction3f &si, Func &&func) {
+        uint32_t u = memcpy_cast<uint32_t>(si.uv.x()),
+                 v = memcpy_cast<uint32_t>(si.uv.y());
+        size_t index = hash_combine(hash_combine((size_t) id, u), v) % Size;
+
+        Entry &entry = entries[index];
+        if (entry.id == id && entry.uv == si.uv && entry.duv_dx == si.duv_dx &&
+            entry.duv_dy == si.duv_dy && same_wavelengths(entry, si))
+            return entry.value;
+
+        entry.value       = func();
+        entry.id          = id;
+        entry.uv          = si.uv;
+        entry.duv_dx      = si.duv_dx;
+        entry.duv_dy      = si.duv_dy;
+        entry.wavelengths = si.wavelengths;
+        return entry.value;
+    }
+
+    static bool same_wavelengths(const Entry &entry, const SurfaceInteraction3f &si) {
+        if constexpr (array_size_v<Wavelength> > 0)
+            return entry.wavelengths == si.wavelengths;
+        else
+            return true;
+    }
+
+    Entry entries[Size];
+};
+
+/// Return the table of recent lookups of the calling thread
+template <typename SurfaceInteraction3f, typename Value>
+LookupCache<SurfaceInteraction3f, Value> &lookup_cache() {
+    static thread_local LookupCache<SurfaceInteraction3f, Value> cache;
+    return cache;
+}
+
+/// Source of the ids identifying the entries of a texture in the \ref LookupCache
+inline uint64_t next_lookup_cache_id() {
+    static std::atomic<uint64_t> id { 1 };
+    return id.fetch_add(1, std::memory_order_relaxed);
+}
+
+/// Inverse of the sRGB transfer function (scalar version used by the encoders)
+inline float linear_to_srgb(float value) {
+    value = std::min(std::max(value, 0.f), 1.f);
+    if (value <= 0.0031308f)
+        return 12.92f * value;
+    return 1.055f * std::pow(value, 1.f / 2.4f) - 0.055f;
+}
+
+/// Quantize an RGB color in [0, 1] to the 5:6:5 format of BC1 endpoints
+inline uint32_t bc1_pack_565(const float *c) {
+    return ((uint32_t) std::lround(c[0] * 31.f) << 11) |
+           ((uint32_t) std::lround(c[1] * 63.f) << 5) |
+            (uint32_t) std::lround(c[2] * 31.f);
+}
+
+inline void bc1_unpack_565(uint32_t v, float *c) {
+    c[0] = ((v >> 11) & 31) / 31.f;
+    c[1] = ((v >> 5) & 63) / 63.f;
+    c[2] = (v & 31) / 31.f;
+}
+
+/**
+ * \brief Compress a block of 4x4 RGB pixels in [0, 1] into the BC1 format
+ *
+ * The endpoints are the corners of the bounding box of the colors along the
+ * diagonal that follows their correlation, inset by 1/16 of its extent.
+ */
+inline uint64_t bc1_encode_block(const float (&pixels)[16][3]) {
+    float lo[3], hi[3], mean[3] = { 0.f, 0.f, 0.f };
+    for (int c = 0; c < 3; ++c) {
+        lo[c] = hi[c] = pixels[0][c];
+        for (int i = 0; i < 16; ++i) {
+            lo[c] = std::min(lo[c], pixels[i][c]);
+            hi[c] = std::max(hi[c], pixels[i][c]);
+            mean[c] += pixels[i][c] * (1.f / 16.f);
+        }
+    }
+
+    // Flip the green and blue ranges when they are anti-correlated with red
+    for (int c = 1; c < 3; ++c) {
+        float cov = 0.f;
+        for (int i = 0; i < 16; ++i)
+            cov += (pixels[i][0] - mean[0]) * (pixels[i][c] - mean[c]);
+        if (cov < 0.f)
+            std::swap(lo[c], hi[c]);
+    }
+
+    for (int c = 0; c < 3; ++c) {
+        float inset = (hi[c] - lo[c]) * (1.f / 16.f);
+        hi[c] -= inset;
+        lo[c] += inset;
+    }
+
+    uint32_t c0 = bc1_pack_565(hi), c1 = bc1_pack_565(lo);
+    if (c0 < c1)
+        std::swap(c0, c1);
+    if (c0 == c1)
+        return (uint64_t) c0 | ((uint64_t) c1 << 16);
+
+    // Four-color mode (c0 > c1)
+    float palette[4][3];
+    bc1_unpack_565(c0, palette[0]);
+    bc1_unpack_565(c1, palette[1]);
+    for (int c = 0; c < 3; ++c) {
+        palette[2][c] = (2.f * palette[0][c] + palette[1][c]) * (1.f / 3.f);
+        palette[3][c] = (palette[0][c] + 2.f * palette[1][c]) * (1.f / 3.f);
+    }
+
+    uint32_t indices = 0;
+    for (int i = 0; i < 16; ++i) {
+        uint32_t best = 0;
+        float best_dist = std::numeric_limits<float>::infinity();
+        for (uint32_t j = 0; j < 4; ++j) {
+            float dist = 0.f;
+            for (int c = 0; c < 3; ++c)
+                dist += (pixels[i][c] - palette[j][c]) * (pixels[i][c] - palette[j][c]);
+            if (dist < best_dist) {
+                best_dist = dist;
+                best = j;
+            }
+        }
+        indices |= best << (2 * i);
+    }
+
+    return (uint64_t) c0 | ((uint64_t) c1 << 16) | ((uint64_t) indices << 32);
+}
+
+/// Compress a block of 4x4 single-channel pixels in [0, 1] into the BC4 format
+inline uint64_t bc4_encode_block(const float (&pixels)[16]) {
+    float lo = pixels[0], hi = pixels[0];
+    for (int i = 1; i < 16; ++i) {
+        lo = std::min(lo, pixels[i]);
+        hi = std::max(hi, pixels[i]);
+    }
+
+    uint32_t a0 = (uint32_t) std::lround(hi * 255.f),
+             a1 = (uint32_t) std::lround(lo * 255.f);
+    uint64_t result = a0 | (a1 << 8);
+    if (a0 == a1)
+        return result;
+
+    // Eight-value mode (a0 > a1): index 0 and 1 are the endpoints
+    for (int i = 0; i < 16; ++i) {
+        float t = (hi - pixels[i]) / (hi - lo) * 7.f;
+        uint32_t step = std::min((uint32_t) std::lround(t), 7u),
+                 index = step == 0 ? 0 : (step == 7 ? 1 : step + 1);
+        result |= (uint64_t) index << (16 + 3 * i);
+    }
+
+    return result;
+}
+
+/**
+ * \brief Compress an image with 1 or 3 channels in [0, 1] into 4x4 blocks
+ * (BC4 and BC1, respectively), which are appended to \c blocks in row-major
+ * order. Pixels beyond the boundary of the image repeat the last row/column.
+ */
+template <typename Scalar>
+void bc_encode(const Scalar *data, uint32_t width, uint32_t height,
+               uint32_t channels, bool srgb, std::vector<uint64_t> &blocks) {
+    uint32_t blocks_x = (width + 3) / 4, blocks_y = (height + 3) / 4;
+    size_t offset = blocks.size();
+    blocks.resize(offset + (size_t) blocks_x * blocks_y);
+
+    tbb::parallel_for(
+        tbb::blocked_range<uint32_t>(0, blocks_y),
+        [&](const tbb::blocked_range<uint32_t> &range) {
+            for (uint32_t by = range.begin(); by != range.end(); ++by) {
+                for (uint32_t bx = 0; bx < blocks_x; ++bx) {
+                    float pixels[16][3];
+                    for (uint32_t i = 0; i < 16; ++i) {
+                        uint32_t x = std::min(bx * 4 + i % 4, width - 1),
+                                 y = std::min(by * 4 + i / 4, height - 1);
+                        const Scalar *ptr = data + ((size_t) y * width + x) * channels;
+                        for (uint32_t c = 0; c < channels; ++c) {
+                            float value = std::min(std::max((float) ptr[c], 0.f), 1.f);
+                            pixels[i][c] = srgb ? linear_to_srgb(value) : value;
+                        }
+                    }
+
+                    uint64_t &block = blocks[offset + (size_t) by * blocks_x + bx];
+                    if (channels == 3) {
+                        block = bc1_encode_block(pixels);
+                    } else {
+                        float values[16];
+                        for (int i = 0; i < 16; ++i)
+                            values[i] = pixels[i][0];
+                        block = bc4_encode_block(values);
+                    }
+                }
+            }
+        }
+    );
+}
+NAMESPACE_END(detail)
+
 /// Bilinearly interpolated bitmap texture.
 template <typename Float, typename Spectrum>
 class BitmapTexture final : public Texture<Float, Spectrum> {
@@ -95,16 +498,23 @@ public:
         FileResolver* fs = Thread::thread()->file_resolver();
         fs::path file_path = fs->resolve(props.string("filename"));
         m_name = file_path.filename().string();
-        Log(Debug, "Loading bitmap texture from \"%s\" ..", m_name);
 
         std::string filter_type = props.string("filter_type", "bilinear");
         if (filter_type == "nearest")
             m_filter_type = FilterType::Nearest;
         else if (filter_type == "bilinear")
             m_filter_type = FilterType::Bilinear;
+        else if (filter_type == "trilinear")
+            m_filter_type = FilterType::Trilinear;
+        else if (filter_type == "anisotropic")
+            m_filter_type = FilterType::Anisotropic;
         else
-            Throw("Invalid filter type \"%s\", must be one of: \"nearest\", or "
-                  "\"bilinear\"!", filter_type);
+            Throw("Invalid filter type \"%s\", must be one of: \"nearest\", "
+                  "\"bilinear\", \"trilinear\", or \"anisotropic\"!", filter_type);
+
+        m_max_anisotropy = props.int_("max_anisotropy", 8);
+        if (m_max_anisotropy < 1)
+            Throw("The maximum anisotropy must be at least 1!");
 
         std::string wrap_mode = props.string("wrap_mode", "repeat");
         if (wrap_mode == "repeat")
@@ -117,7 +527,219 @@ public:
             Throw("Invalid wrap mode \"%s\", must be one of: \"repeat\", "
                   "\"mirror\", or \"clamp\"!", wrap_mode);
 
-        m_bitmap = new Bitmap(file_path);
+        /* Should Mitsuba disable transformations to the stored color data?
+           (e.g. sRGB to linear, spectral upsampling, etc.) */
+        m_raw = props.bool_("raw", false);
+
+        if (props.bool_("tiled", false)) {
+            if constexpr (is_cuda_array_v<Float>)
+                Throw("Tiled bitmap textures are not supported in GPU variants!");
+
+            m_tile_size = (uint32_t) props.size_("tile_size", 64);
+            if (m_tile_size == 0)
+                Throw("The tile size must be positive!");
+        }
+
+        m_compressed = props.bool_("compressed", false);
+        if (m_compressed && m_tile_size > 0)
+            Throw("Block compressed textures cannot be tiled!");
+
+        m_half = props.bool_("half_precision", false);
+        if (m_half && (m_compressed || m_tile_size > 0))
+            Throw("Half precision storage cannot be combined with tiled or "
+                  "block compressed textures!");
+
+        m_blocked = props.bool_("blocked", false);
+        if (m_blocked && (m_compressed || m_tile_size > 0))
+            Throw("The blocked pixel layout cannot be combined with tiled or "
+                  "block compressed textures!");
+
+        m_read_ahead = props.bool_("read_ahead", false);
+        m_interpolate_coefficients = props.bool_("coefficient_interpolation", false);
+
+        m_cache_lookups = props.bool_("cache_lookups", false);
+        if (m_cache_lookups && is_array_v<Float>) {
+            Log(Warn, "BitmapTexture: lookups are only cached in scalar variants, ignoring "
+                "the \"cache_lookups\" option of texture \"%s\".", m_name);
+            m_cache_lookups = false;
+        }
+
+        m_cuda_texture = props.bool_("cuda_texture", false);
+        if (m_cuda_texture && is_cuda_array_v<Float> &&
+            (m_filter_type == FilterType::Trilinear || m_filter_type == FilterType::Anisotropic ||
+             m_compressed || m_half || m_blocked)) {
+            Log(Warn, "BitmapTexture: texture objects are only used by the \"nearest\" and "
+                "\"bilinear\" filters with single precision storage, ignoring the "
+                "\"cuda_texture\" option of texture \"%s\".", m_name);
+            m_cuda_texture = false;
+        }
+
+        bool lazy = props.bool_("lazy", false);
+        if (lazy && is_cuda_array_v<Float>) {
+            Log(Warn, "BitmapTexture: textures are always decoded while loading the scene "
+                "in GPU variants, ignoring the \"lazy\" option of texture \"%s\".", m_name);
+            lazy = false;
+        }
+
+        if (lazy) {
+            load_lazy(props, file_path);
+        } else if (!props.bool_("shared", true)) {
+            load(file_path);
+            m_impl = expand_1();
+        } else {
+            load_shared(file_path);
+        }
+
+        // The pixels are now held by the implementation
+        m_bitmap = nullptr;
+        m_mip_levels.clear();
+        m_tiled = nullptr;
+    }
+
+    bool needs_differentials() const override {
+        return m_filter_type == FilterType::Trilinear ||
+               m_filter_type == FilterType::Anisotropic;
+    }
+
+    /**
+     * Return the implementation specialized to the actual loaded image, which
+     * is shared by all textures with the same file and settings
+     */
+    std::vector<ref<Object>> expand() const override {
+        return { m_impl };
+    }
+
+    MTS_DECLARE_CLASS()
+
+protected:
+    /**
+     * Only read the header of the image, and create a texture that loads it
+     * with the remaining settings when it is first used
+     */
+    void load_lazy(const Properties &props, const fs::path &file_path) {
+        ref<Bitmap> header = Bitmap::read_header(file_path);
+
+        uint32_t channel_count;
+        switch (header->pixel_format()) {
+            case Bitmap::PixelFormat::Y:
+            case Bitmap::PixelFormat::YA:
+                channel_count = 1;
+                break;
+
+            case Bitmap::PixelFormat::RGB:
+            case Bitmap::PixelFormat::RGBA:
+            case Bitmap::PixelFormat::XYZ:
+            case Bitmap::PixelFormat::XYZA:
+                channel_count = 3;
+                break;
+
+            default:
+                Throw("The texture needs to have a known pixel "
+                      "format (Y[A], RGB[A], XYZ[A] are supported).");
+        }
+
+        // The file is resolved now, since the rendering threads may use a different resolver
+        Properties props_eager(props);
+        props_eager.set_string("filename", file_path.string(), false);
+        props_eager.set_bool("lazy", false, false);
+
+        // Smaller images are up-sampled by load()
+        ScalarVector2i resolution = max(ScalarVector2i(header->size()), 2);
+
+        Log(Debug, "Deferring the decoding of bitmap texture \"%s\" (%ix%i, %i channel%s)",
+            m_name, resolution.x(), resolution.y(), channel_count,
+            channel_count == 1 ? "" : "s");
+
+        m_impl = new LazyBitmapTexture<Float, Spectrum>(
+            props_eager, m_name, resolution, channel_count, needs_differentials());
+    }
+
+    /// Share the result of \ref load() with other textures with the same settings
+    void load_shared(const fs::path &file_path) {
+        std::string key = tfm::format("%s|%i|%i|%i|%i|%i|%i|%i|%i|%i|%i|%i|%s", file_path.string(),
+                                      (int) m_raw, (int) m_filter_type, (int) m_wrap_mode,
+                                      m_max_anisotropy, m_tile_size, (int) m_compressed,
+                                      (int) m_half, (int) m_blocked,
+                                      (int) m_interpolate_coefficients, (int) m_cuda_texture,
+                                      (int) m_cache_lookups, m_transform.matrix);
+
+        std::shared_ptr<CacheEntry> entry;
+        {
+            std::lock_guard<std::mutex> guard(cache_mutex());
+            auto &cache = shared_cache();
+
+            // Drop the textures that are no longer used by any scene
+            for (auto it = cache.begin(); it != cache.end(); ) {
+                if (it->second->impl && it->second->impl->ref_count() == 1)
+                    it = cache.erase(it);
+                else
+                    ++it;
+            }
+
+            auto &value = cache[key];
+            if (!value)
+                value = std::make_shared<CacheEntry>();
+            entry = value;
+        }
+
+        // Only one thread loads the texture, the others wait for it
+        std::lock_guard<std::mutex> guard(entry->mutex);
+        if (entry->impl) {
+            Log(Debug, "Reusing bitmap texture \"%s\"", m_name);
+            m_impl = entry->impl;
+            return;
+        }
+
+        load(file_path);
+        m_impl = expand_1();
+
+        std::lock_guard<std::mutex> cache_guard(cache_mutex());
+        entry->impl = m_impl;
+    }
+
+    /// Load the image and convert it into the representation used for rendering
+    void load(const fs::path &file_path) {
+        Log(Debug, "Loading bitmap texture from \"%s\" ..", m_name);
+        ScopedLoadEvent load_event(LoadEvent::LoadTexture, m_name);
+
+        // Reuse the tiled version of the texture if it is up to date
+        fs::path tiled_path;
+        uint64_t tiled_tag = 0;
+        if (m_tile_size > 0) {
+            const char *mode = m_raw ? "raw" : (is_spectral_v<Spectrum> ? "spectral" : "linear");
+            tiled_path = file_path.string() + tfm::format(".%s.mtstex", mode);
+            // Also hash the modification time, since images may be rewritten at the same size
+            tiled_tag = hash_combine(hash_combine(hash_combine(fs::file_size(file_path),
+                                                               fs::last_write_time(file_path)),
+                                                  m_tile_size),
+                                     (size_t) m_wrap_mode);
+
+            if (fs::exists(tiled_path)) {
+                try {
+                    ref<TiledImage> image = new TiledImage(tiled_path);
+                    if (image->tag() == tiled_tag && image->tile_size() == m_tile_size &&
+                        (image->channel_count() == 1 || image->channel_count() == 3))
+                        m_tiled = image;
+                } catch (const std::exception &e) {
+                    Log(Warn, "BitmapTexture: could not open \"%s\" (%s), regenerating it..",
+                        tiled_path.string(), e.what());
+                }
+            }
+
+            if (m_tiled) {
+                Log(Debug, "Using the tiled version \"%s\" of the texture",
+                    tiled_path.filename().string());
+                m_mean = tiled_mean();
+                return;
+            }
+        }
+
+        if (m_read_ahead) {
+            ref<Stream> stream = new AsyncFileStream(file_path);
+            m_bitmap = new Bitmap(stream);
+        } else {
+            m_bitmap = new Bitmap(file_path);
+        }
 
         /* Convert to linear RGB float bitmap, will be converted
            into spectral profile coefficients below (in place) */
@@ -140,9 +762,6 @@ public:
                       "format (Y[A], RGB[A], XYZ[A] are supported).");
         }
 
-        /* Should Mitsuba disable transformations to the stored color data?
-           (e.g. sRGB to linear, spectral upsampling, etc.) */
-        m_raw = props.bool_("raw", false);
         if (m_raw) {
             /* Don't undo gamma correction in the conversion below.
                This is needed, e.g., for normal maps. */
@@ -160,6 +779,28 @@ public:
             m_bitmap = m_bitmap->resample(max(m_bitmap->size(), 2), rfilter);
         }
 
+        /* Build the MIP map pyramid from the linear values, since the spectral
+           model coefficients computed below cannot be averaged */
+        if (needs_differentials() || !tiled_path.empty()) {
+            using ReconstructionFilter = Bitmap::ReconstructionFilter;
+            ref<ReconstructionFilter> rfilter =
+                PluginManager::instance()->create_object<ReconstructionFilter>(Properties("box"));
+
+            FilterBoundaryCondition bc;
+            switch (m_wrap_mode) {
+                case WrapMode::Repeat: bc = FilterBoundaryCondition::Repeat; break;
+                case WrapMode::Mirror: bc = FilterBoundaryCondition::Mirror; break;
+                default:               bc = FilterBoundaryCondition::Clamp;  break;
+            }
+
+            const Bitmap *level = m_bitmap;
+            while (any(level->size() > 1u)) {
+                m_mip_levels.push_back(level->resample(max(level->size() / 2u, 1u),
+                                                       rfilter, { bc, bc }));
+                level = m_mip_levels.back();
+            }
+        }
+
         ScalarFloat *ptr = (ScalarFloat *) m_bitmap->data();
         size_t pixel_count = m_bitmap->pixel_count();
         bool bad = false;
@@ -203,23 +844,32 @@ public:
                 "exceed the [0, 1] range!", m_name);
 
         m_mean = ScalarFloat(mean / pixel_count);
-    }
 
-    /**
-     * Recursively expand into an implementation specialized to the
-     * actual loaded image.
-     */
-    std::vector<ref<Object>> expand() const override {
-        Properties props;
-        props.set_id(this->id());
-        return { ref<Object>(expand_1()) };
-    }
+        if (m_bitmap->channel_count() == 3 && is_spectral_v<Spectrum> && !m_raw) {
+            for (Bitmap *level : m_mip_levels) {
+                ScalarFloat *level_ptr = (ScalarFloat *) level->data();
+                for (size_t i = 0; i < level->pixel_count(); ++i) {
+                    ScalarColor3f value = load_unaligned<ScalarColor3f>(level_ptr);
+                    store_unaligned(level_ptr, srgb_model_fetch(value));
+                    level_ptr += 3;
+                }
+            }
+        }
 
-    MTS_DECLARE_CLASS()
+        if (m_compressed && m_bitmap->channel_count() == 3 &&
+            is_spectral_v<Spectrum> && !m_raw) {
+            Log(Warn, "BitmapTexture: the spectral upsampling coefficients of texture "
+                "\"%s\" cannot be block compressed, storing it uncompressed.", m_name);
+            m_compressed = false;
+        }
+
+        if (!tiled_path.empty())
+            write_tiled(tiled_path, tiled_tag);
+    }
 
-protected:
     Object* expand_1() const {
-        return m_bitmap->channel_count() == 1 ? expand_2<1>() : expand_2<3>();
+        size_t channel_count = m_tiled ? m_tiled->channel_count() : m_bitmap->channel_count();
+        return channel_count == 1 ? expand_2<1>() : expand_2<3>();
     }
 
     template <uint32_t Channels> Object* expand_2() const {
@@ -229,17 +879,103 @@ protected:
     template <uint32_t Channels, bool Raw> Object* expand_3() const {
         Properties props;
         return new BitmapTextureImpl<Float, Spectrum, Channels, Raw>(
-            props, m_bitmap, m_name, m_transform, m_mean, m_filter_type, m_wrap_mode);
+            props, m_bitmap, m_mip_levels, m_tiled, m_compressed, m_half, m_blocked,
+            m_interpolate_coefficients, m_cuda_texture, m_cache_lookups, m_name, m_transform,
+            m_mean, m_filter_type, m_wrap_mode, m_max_anisotropy);
+    }
+
+    /**
+     * Store the converted image and its MIP map pyramid as a tiled image file,
+     * which replaces the in-memory copy
+     */
+    void write_tiled(const fs::path &path, uint64_t tag) {
+        std::vector<ref<Bitmap>> levels = { m_bitmap };
+        levels.insert(levels.end(), m_mip_levels.begin(), m_mip_levels.end());
+
+        std::vector<const float *> data;
+        std::vector<TiledImage::Vector2u> sizes;
+        for (ref<Bitmap> &level : levels) {
+            if (level->component_format() != Struct::Type::Float32)
+                level = level->convert(level->pixel_format(), Struct::Type::Float32, false);
+            data.push_back((const float *) level->data());
+            sizes.push_back(TiledImage::Vector2u(level->size()));
+        }
+
+        try {
+            TiledImage::write(path, data, sizes, (uint32_t) m_bitmap->channel_count(),
+                              m_tile_size, tag);
+            m_tiled = new TiledImage(path);
+        } catch (const std::exception &e) {
+            Log(Warn, "BitmapTexture: could not write \"%s\" (%s), keeping the texture "
+                "\"%s\" in memory!", path.string(), e.what(), m_name);
+            if (!needs_differentials())
+                m_mip_levels.clear();
+            return;
+        }
+
+        Log(Debug, "Wrote the tiled version \"%s\" of the texture (%s)",
+            path.filename().string(), util::mem_string(fs::file_size(path)));
+
+        m_mean = tiled_mean();
+        m_bitmap = nullptr;
+        m_mip_levels.clear();
+    }
+
+    /// Estimate the mean value of a tiled texture from the coarsest level
+    ScalarFloat tiled_mean() const {
+        std::unique_ptr<float[]> tile(new float[m_tiled->tile_bytes() / sizeof(float)]);
+        m_tiled->read_tile(m_tiled->tile_index(m_tiled->level_count() - 1, 0, 0), tile.get());
+
+        if (m_tiled->channel_count() == 1)
+            return (ScalarFloat) tile[0];
+
+        ScalarColor3f value(tile[0], tile[1], tile[2]);
+        if constexpr (is_spectral_v<Spectrum>) {
+            if (!m_raw)
+                return srgb_model_mean(value);
+        }
+        return luminance(value);
+    }
+
+    /// Entry of the cache of loaded textures (see \ref load_shared())
+    struct CacheEntry {
+        std::mutex mutex;
+        ref<Object> impl;
+    };
+
+    static std::mutex &cache_mutex() {
+        static std::mutex mutex;
+        return mutex;
+    }
+
+    static std::unordered_map<std::string, std::shared_ptr<CacheEntry>> &shared_cache() {
+        static std::unordered_map<std::string, std::shared_ptr<CacheEntry>> cache;
+        return cache;
     }
 
 protected:
+    /// Implementation specialized to the loaded image (see \ref expand())
+    ref<Object> m_impl;
     ref<Bitmap> m_bitmap;
+    /// Downsampled versions of \c m_bitmap (only used by the MIP map filters)
+    std::vector<ref<Bitmap>> m_mip_levels;
+    /// Tiled version of the texture (\c nullptr unless \c tiled is set)
+    ref<TiledImage> m_tiled;
+    uint32_t m_tile_size = 0;
+    bool m_compressed;
+    bool m_half;
+    bool m_blocked;
+    bool m_read_ahead;
+    bool m_interpolate_coefficients;
+    bool m_cuda_texture;
+    bool m_cache_lookups;
     std::string m_name;
     ScalarTransform3f m_transform;
     bool m_raw;
     ScalarFloat m_mean;
     FilterType m_filter_type;
     WrapMode m_wrap_mode;
+    int m_max_anisotropy;
 };
 
 template <typename Float, typename Spectrum, uint32_t Channels, bool Raw>
@@ -247,21 +983,145 @@ class BitmapTextureImpl final : public Texture<Float, Spectrum> {
 public:
     MTS_IMPORT_TYPES(Texture)
 
+    // Storage representation underlying this texture
+    using StorageType = std::conditional_t<Channels == 1, Float, Color3f>;
+
     BitmapTextureImpl(const Properties &props,
                       const Bitmap *bitmap,
+                      const std::vector<ref<Bitmap>> &mip_levels,
+                      TiledImage *tiled,
+                      bool compressed,
+                      bool half,
+                      bool blocked,
+                      bool interpolate_coefficients,
+                      bool cuda_texture,
+                      bool cache_lookups,
                       const std::string &name,
                       const ScalarTransform3f &transform,
                       ScalarFloat mean,
                       FilterType filter_type,
-                      WrapMode wrap_mode)
+                      WrapMode wrap_mode,
+                      int max_anisotropy)
         : Texture(props),
-          m_resolution(ScalarVector2i(bitmap->size())),
-          m_inv_resolution_x((int) bitmap->width()),
-          m_inv_resolution_y((int) bitmap->height()),
+          m_resolution(tiled ? ScalarVector2i(tiled->level_size(0))
+                             : ScalarVector2i(bitmap->size())),
+          m_inv_resolution_x(m_resolution.x()),
+          m_inv_resolution_y(m_resolution.y()),
           m_name(name), m_transform(transform), m_mean(mean),
-          m_filter_type(filter_type), m_wrap_mode(wrap_mode){
-        m_data = DynamicBuffer<Float>::copy(bitmap->data(),
-            hprod(m_resolution) * Channels);
+          m_filter_type(filter_type), m_wrap_mode(wrap_mode),
+          m_max_anisotropy(max_anisotropy), m_tiled(tiled),
+          m_compressed(compressed), m_half(half), m_blocked(blocked),
+          m_interpolate_coefficients(interpolate_coefficients) {
+        if (cache_lookups)
+            m_cache_id = detail::next_lookup_cache_id();
+
+        if (tiled) {
+            // The pixels stay on disk, only the resolution of the levels is needed
+            std::vector<int32_t> level_info;
+            for (uint32_t i = 0; i < tiled->level_count(); ++i)
+                level_info.insert(level_info.end(), { 0, (int32_t) tiled->level_size(i).x(),
+                                                      (int32_t) tiled->level_size(i).y() });
+            m_level_count = tiled->level_count();
+            m_level_info = DynamicBuffer<Int32>::copy(level_info.data(), level_info.size());
+            return; // The tile cache accounts for its own memory
+        }
+
+        if (compressed) {
+            /* Compress the levels of the MIP map pyramid (if any), and store the
+               offset (in blocks) and resolution of each one */
+            std::vector<const Bitmap *> levels = { bitmap };
+            for (const Bitmap *level : mip_levels)
+                levels.push_back(level);
+
+            std::vector<int32_t> level_info;
+            std::vector<uint64_t> blocks;
+            for (const Bitmap *level : levels) {
+                level_info.insert(level_info.end(), { (int32_t) blocks.size(),
+                                                      (int32_t) level->width(),
+                                                      (int32_t) level->height() });
+                detail::bc_encode((const ScalarFloat *) level->data(), (uint32_t) level->width(),
+                                  (uint32_t) level->height(), Channels, !Raw, blocks);
+            }
+
+            m_level_count = (uint32_t) levels.size();
+            m_level_info = DynamicBuffer<Int32>::copy(level_info.data(), level_info.size());
+            m_blocks = DynamicBuffer<UInt64>::copy(blocks.data(), blocks.size());
+            update_memory_record();
+            return;
+        }
+
+        if (mip_levels.empty() && !half && !blocked) {
+            m_data = DynamicBuffer<Float>::copy(bitmap->data(),
+                hprod(m_resolution) * Channels);
+            if (cuda_texture)
+                init_cuda_texture((const ScalarFloat *) bitmap->data());
+            update_memory_record();
+            return;
+        }
+
+        /* Concatenate the levels of the MIP map pyramid, and store the
+           offset (in pixels) and resolution of each one */
+        std::vector<const Bitmap *> levels = { bitmap };
+        for (const Bitmap *level : mip_levels)
+            levels.push_back(level);
+
+        std::vector<int32_t> level_info;
+        size_t pixel_count = 0;
+        for (const Bitmap *level : levels) {
+            level_info.insert(level_info.end(), { (int32_t) pixel_count,
+                                                  (int32_t) level->width(),
+                                                  (int32_t) level->height() });
+            pixel_count += blocked ? blocked_size(level->width(), level->height())
+                                   : level->pixel_count();
+        }
+
+        m_level_count = (uint32_t) levels.size();
+        m_level_info = DynamicBuffer<Int32>::copy(level_info.data(), level_info.size());
+
+        // Copy the pixels of all levels into \c ptr in their storage order
+        auto arrange = [&](ScalarFloat *ptr) {
+            for (const Bitmap *level : levels) {
+                const ScalarFloat *src = (const ScalarFloat *) level->data();
+                if (!blocked) {
+                    memcpy(ptr, src, level->buffer_size());
+                    ptr += level->pixel_count() * Channels;
+                    continue;
+                }
+
+                /* The padding of the blocks at the right and bottom boundaries is
+                   never accessed, but is filled by repeating the last column or row */
+                int32_t width = (int32_t) level->width(), height = (int32_t) level->height();
+                for (int32_t y = 0; y < ((height + 7) & ~7); ++y) {
+                    for (int32_t x = 0; x < ((width + 7) & ~7); ++x) {
+                        size_t source = (size_t) std::min(y, height - 1) * width +
+                                        (size_t) std::min(x, width - 1);
+                        memcpy(ptr + (size_t) blocked_index(width, x, y) * Channels,
+                               src + source * Channels, sizeof(ScalarFloat) * Channels);
+                    }
+                }
+                ptr += blocked_size(level->width(), level->height()) * Channels;
+            }
+        };
+
+        if (half) {
+            // Store the channel values as pairs of half precision values
+            size_t count = pixel_count * Channels;
+            std::unique_ptr<ScalarFloat[]> values(new ScalarFloat[count]);
+            arrange(values.get());
+
+            std::vector<uint32_t> words((count + 1) / 2, 0u);
+            for (size_t i = 0; i < count; ++i)
+                words[i / 2] |= (uint32_t) enoki::half::float32_to_float16(
+                                    (float) values[i]) << (16 * (i % 2));
+            m_data_half = DynamicBuffer<UInt32>::copy(words.data(), words.size());
+            update_memory_record();
+            return;
+        }
+
+        m_data = empty<DynamicBuffer<Float>>(pixel_count * Channels);
+        m_data = m_data.managed();
+        arrange(m_data.data());
+        update_memory_record();
     }
 
     UnpolarizedSpectrum eval(const SurfaceInteraction3f &si, Mask active) const override {
@@ -273,7 +1133,7 @@ public:
                   "into spectra was explicitly disabled! (raw=true)",
                   to_string());
         } else {
-            auto result = interpolate(si, active);
+            auto result = lookup(si, active);
 
             if constexpr (Channels == 3 && is_monochromatic_v<Spectrum>)
                 return luminance(result);
@@ -292,7 +1152,7 @@ public:
                   "spectra had previously been requested! (raw=false)",
                   to_string());
         } else {
-            auto result = interpolate(si, active);
+            auto result = lookup(si, active);
 
             if constexpr (Channels == 3)
                 return luminance(result);
@@ -312,9 +1172,7 @@ public:
                   to_string());
         }
         else {
-            if (m_filter_type == FilterType::Bilinear) {
-                // Storage representation underlying this texture
-                using StorageType = std::conditional_t<Channels == 1, Float, Color3f>;
+            if (m_filter_type != FilterType::Nearest) {
                 using Int4 = Array<Int32, 4>;
                 using Int24 = Array<Int4, 2>;
 
@@ -336,19 +1194,16 @@ public:
                 Int24 uv_i_w = wrap(Int24(Int4(0, 1, 0, 1) + uv_i.x(),
                                           Int4(0, 0, 1, 1) + uv_i.y()));
 
-                Int4 index = uv_i_w.x() + uv_i_w.y() * m_resolution.x();
-
-                auto convert_to_monochrome = [](const auto& a) {
+                auto fetch = [&](size_t i) {
+                    StorageType v = texel(0, 0, m_resolution.x(), uv_i_w.x()[i],
+                                          uv_i_w.y()[i], active);
                     if constexpr (Channels == 3)
-                        return luminance(a);
+                        return luminance(v);
                     else
-                        return a;
+                        return v;
                 };
 
-                Float f00 = convert_to_monochrome(gather<StorageType>(m_data, index.x(), active));
-                Float f10 = convert_to_monochrome(gather<StorageType>(m_data, index.y(), active));
-                Float f01 = convert_to_monochrome(gather<StorageType>(m_data, index.z(), active));
-                Float f11 = convert_to_monochrome(gather<StorageType>(m_data, index.w(), active));
+                Float f00 = fetch(0), f10 = fetch(1), f01 = fetch(2), f11 = fetch(3);
 
                 // Partials w.r.t. pixel coordinate x and y
                 Vector2f df_xy{ fmadd(w0.y(), f10 - f00, w1.y() * (f11 - f01)),
@@ -379,7 +1234,7 @@ public:
                   "previously been requested! (raw=false)",
                   to_string());
         } else {
-            return interpolate(si, active);
+            return lookup(si, active);
         }
     }
 
@@ -400,16 +1255,340 @@ public:
         }
     }
 
-    MTS_INLINE auto interpolate(const SurfaceInteraction3f &si, Mask active) const {
-        // Storage representation underlying this texture
-        using StorageType = std::conditional_t<Channels == 1, Float, Color3f>;
+    /// Wrap the per-lane coordinates \c value to the per-lane resolution \c res
+    Int32 wrap(const Int32 &value, const Int32 &res) const {
+        if (m_wrap_mode == WrapMode::Clamp) {
+            return clamp(value, 0, res - 1);
+        } else {
+            Int32 div = value / res,
+                  mod = value - div * res;
+
+            masked(mod, mod < 0) += res;
+
+            if (m_wrap_mode == WrapMode::Mirror)
+                mod = select(eq(div & 1, 0) ^ (value < 0), mod, res - 1 - mod);
+
+            return mod;
+        }
+    }
+
+    /**
+     * \brief Fetch the pixel <tt>(x, y)</tt> of a level of the MIP map pyramid
+     *
+     * \c offset and \c width specify the position of the level within \ref
+     * m_data (or \ref m_data_half) and its resolution. They are ignored by
+     * tiled textures.
+     */
+    MTS_INLINE StorageType texel(const Int32 &level, const Int32 &offset, const Int32 &width,
+                                 const Int32 &x, const Int32 &y, Mask active) const {
+        if (m_tiled)
+            return texel_tiled(level, x, y, active);
+        else if (m_compressed)
+            return texel_compressed(offset, width, x, y, active);
+
+        Int32 index = offset + (m_blocked ? blocked_index(width, x, y) : y * width + x);
+        if (m_half)
+            return texel_half(index, active);
+        return gather<StorageType>(m_data, index, active);
+    }
+
+    /**
+     * \brief Index of the pixel <tt>(x, y)</tt> within a level whose pixels are
+     * stored in blocks of 8x8 pixels
+     *
+     * The blocks are stored in row-major order, and so are the pixels within
+     * each of them. Bilinear lookups thus usually access neighboring memory.
+     */
+    template <typename Int>
+    MTS_INLINE static Int blocked_index(const Int &width, const Int &x, const Int &y) {
+        Int blocks_x = (width + 7) >> 3;
+        return ((((y >> 3) * blocks_x + (x >> 3)) << 6) | ((y & 7) << 3)) | (x & 7);
+    }
+
+    /// Number of pixels of a level stored in blocks of 8x8 pixels (including padding)
+    static size_t blocked_size(size_t width, size_t height) {
+        return ((width + 7) / 8) * ((height + 7) / 8) * 64;
+    }
+
+    /// Fetch the pixel with index \c index of a texture stored in half precision
+    MTS_INLINE StorageType texel_half(const Int32 &index, Mask active) const {
+        UInt32 i = UInt32(index) * Channels;
+        if constexpr (Channels == 1) {
+            return StorageType(decode_half(gather_uint16(m_data_half, i, active)));
+        } else {
+            StorageType result;
+            for (uint32_t c = 0; c < Channels; ++c)
+                result[c] = Float(decode_half(gather_uint16(m_data_half, i + c, active)));
+            return result;
+        }
+    }
+
+    /// Decode a pixel of a block compressed level whose blocks start at \c offset
+    StorageType texel_compressed(const Int32 &offset, const Int32 &width,
+                                 const Int32 &x, const Int32 &y, Mask active) const {
+        Int32 block = offset + (y >> 2) * ((width + 3) >> 2) + (x >> 2);
+        UInt64 bits = gather<UInt64>(m_blocks, block, active);
+
+        // Index of the pixel within the block
+        UInt32 pixel = UInt32(((y & 3) << 2) + (x & 3));
+
+        StorageType result;
+        if constexpr (Channels == 3) {
+            // BC1: two 5:6:5 endpoints followed by 2 bit indices
+            UInt32 c0 = UInt32(bits) & 0xFFFFu,
+                   c1 = (UInt32(bits) >> 16) & 0xFFFFu,
+                   index = (UInt32(bits >> 32) >> (pixel << 1)) & 3u;
+
+            auto unpack = [](const UInt32 &c) {
+                return Color3f(Float((c >> 11) & 31u) * (1.f / 31.f),
+                               Float((c >> 5) & 63u) * (1.f / 63.f),
+                               Float(c & 31u) * (1.f / 31.f));
+            };
+
+            // The three-color mode (c0 <= c1) uses index 3 for black
+            Mask four_colors = c0 > c1;
+            Float t = select(eq(index, 1u), 1.f, 0.f);
+            masked(t, eq(index, 2u)) = select(four_colors, 1.f / 3.f, .5f);
+            masked(t, eq(index, 3u)) = 2.f / 3.f;
+
+            Color3f e0 = unpack(c0);
+            result = fmadd(unpack(c1) - e0, t, e0);
+            masked(result, !four_colors && eq(index, 3u)) = 0.f;
+        } else {
+            // BC4: two 8 bit endpoints followed by 3 bit indices
+            UInt32 a0 = UInt32(bits) & 0xFFu,
+                   a1 = (UInt32(bits) >> 8) & 0xFFu,
+                   index = UInt32(bits >> UInt64(pixel * 3u + 16u)) & 7u;
+
+            // The six-value mode (a0 <= a1) uses index 6 and 7 for 0 and 1
+            Mask eight_values = a0 > a1;
+            Float t = select(eight_values, Float(index - 1u) * (1.f / 7.f),
+                                           Float(index - 1u) * (1.f / 5.f));
+            masked(t, eq(index, 0u)) = 0.f;
+            masked(t, eq(index, 1u)) = 1.f;
+
+            Float v0 = Float(a0) * (1.f / 255.f), v1 = Float(a1) * (1.f / 255.f);
+            result = fmadd(v1 - v0, t, v0);
+            masked(result, !eight_values && eq(index, 6u)) = 0.f;
+            masked(result, !eight_values && eq(index, 7u)) = 1.f;
+        }
+
+        // Undo the sRGB encoding applied by the encoder
+        if constexpr (!Raw)
+            result = select(result <= 0.04045f, result * (1.f / 12.92f),
+                            pow(fmadd(result, 1.f / 1.055f, 0.055f / 1.055f), 2.4f));
+
+        return result;
+    }
+
+    /// Fetch a pixel of a tiled texture through the tile cache (one lane at a time)
+    StorageType texel_tiled(const Int32 &level, const Int32 &x, const Int32 &y,
+                            Mask active) const {
+        StorageType result = zero<StorageType>();
+
+        if constexpr (is_cuda_array_v<Float>) {
+            ENOKI_MARK_USED(level); ENOKI_MARK_USED(x);
+            ENOKI_MARK_USED(y); ENOKI_MARK_USED(active);
+            Throw("Tiled bitmap textures are not supported in GPU variants!");
+        } else {
+            TileCache *cache = TileCache::instance();
+            uint32_t tile_size = m_tiled->tile_size(), queries = 0, misses = 0;
+
+            for (size_t i = 0; i < array_size_v<Float>; ++i) {
+                if (!slice(active, i))
+                    continue;
+
+                uint32_t xi = (uint32_t) slice(x, i),
+                         yi = (uint32_t) slice(y, i);
+
+                bool hit;
+                TileCache::Tile tile = cache->tile(m_tiled, (uint32_t) slice(level, i),
+                                                   xi, yi, hit);
+                const float *ptr = tile.get() +
+                    ((yi % tile_size) * tile_size + xi % tile_size) * Channels;
+
+                if constexpr (Channels == 1) {
+                    slice(result, i) = ptr[0];
+                } else {
+                    for (size_t j = 0; j < Channels; ++j)
+                        slice(result[j], i) = ptr[j];
+                }
+
+                queries++;
+                misses += hit ? 0 : 1;
+            }
+
+            detail::tile_cache_statistics.add(queries, misses);
+        }
+
+        return result;
+    }
 
+    /// Bilinear lookup within the given level of the MIP map pyramid
+    MTS_INLINE auto interpolate_level(const Int32 &level, const Point2f &uv,
+                                      const Wavelength &wavelengths, Mask active) const {
+        Vector3i info = gather<Vector3i>(m_level_info, level, active);
+        Vector2i res(info.y(), info.z());
+
+        // Scale to the level resolution and apply shift
+        Point2f p = fmadd(uv, Vector2f(res), -.5f);
+        Vector2i p_i = floor2int<Vector2i>(p);
+
+        // Interpolation weights
+        Point2f w1 = p - Point2f(p_i),
+                w0 = 1.f - w1;
+
+        Int32 x0 = wrap(p_i.x(), res.x()), x1 = wrap(p_i.x() + 1, res.x()),
+              y0 = wrap(p_i.y(), res.y()), y1 = wrap(p_i.y() + 1, res.y());
+
+        if constexpr (is_spectral_v<Spectrum> && !Raw && Channels == 3) {
+            if (m_interpolate_coefficients) {
+                // Interpolate the model coefficients and evaluate them once
+                StorageType c00 = texel(level, info.x(), res.x(), x0, y0, active),
+                            c10 = texel(level, info.x(), res.x(), x1, y0, active),
+                            c01 = texel(level, info.x(), res.x(), x0, y1, active),
+                            c11 = texel(level, info.x(), res.x(), x1, y1, active);
+
+                StorageType c0 = fmadd(w0.x(), c00, w1.x() * c10),
+                            c1 = fmadd(w0.x(), c01, w1.x() * c11);
+
+                return srgb_model_eval<UnpolarizedSpectrum>(
+                    fmadd(w0.y(), c0, w1.y() * c1), wavelengths);
+            }
+        }
+
+        auto fetch = [&](const Int32 &x, const Int32 &y) {
+            StorageType v = texel(level, info.x(), res.x(), x, y, active);
+            if constexpr (is_spectral_v<Spectrum> && !Raw && Channels == 3)
+                return srgb_model_eval<UnpolarizedSpectrum>(v, wavelengths);
+            else
+                return v;
+        };
+
+        auto v00 = fetch(x0, y0), v10 = fetch(x1, y0),
+             v01 = fetch(x0, y1), v11 = fetch(x1, y1);
+
+        auto v0 = fmadd(w0.x(), v00, w1.x() * v10),
+             v1 = fmadd(w0.x(), v01, w1.x() * v11);
+
+        return fmadd(w0.y(), v0, w1.y() * v1);
+    }
+
+    /// Linear interpolation between the two levels that bracket \c lod
+    MTS_INLINE auto interpolate_trilinear(const Float &lod, const Point2f &uv,
+                                          const Wavelength &wavelengths,
+                                          Mask active) const {
+        Float level = clamp(lod, 0.f, Float(m_level_count - 1));
+        Int32 level_0 = floor2int<Int32>(level),
+              level_1 = min(level_0 + 1, (int32_t) m_level_count - 1);
+        Float t = level - Float(level_0);
+
+        auto v0 = interpolate_level(level_0, uv, wavelengths, active),
+             v1 = interpolate_level(level_1, uv, wavelengths, active && t > 0.f);
+
+        return fmadd(v0, 1.f - t, v1 * t);
+    }
+
+    /// Lookup using the MIP map pyramid and the UV partials of \c si
+    auto interpolate_mip(const SurfaceInteraction3f &si, const Point2f &uv,
+                         Mask active) const {
+        // Footprint of the pixel in texels of the full-resolution level
+        Vector2f dx = m_transform.transform_affine(si.duv_dx) * m_resolution,
+                 dy = m_transform.transform_affine(si.duv_dy) * m_resolution;
+
+        if (m_filter_type == FilterType::Trilinear) {
+            Float width = max(hmax(abs(dx)), hmax(abs(dy)));
+            return interpolate_trilinear(log2(width), uv, si.wavelengths, active);
+        }
+
+        /* Approximate an elliptical filter by several trilinear lookups
+           along the major axis of the footprint, weighted by a Gaussian */
+        Float len_x = norm(dx), len_y = norm(dy);
+        Mask x_major = len_x > len_y;
+        Float major = select(x_major, len_x, len_y),
+              minor = select(x_major, len_y, len_x);
+        Vector2f axis = select(x_major, dx, dy) * rcp(Vector2f(m_resolution));
+
+        Float count = clamp(ceil(major / minor), 1.f, (ScalarFloat) m_max_anisotropy);
+        masked(count, !(minor > 0.f)) = (ScalarFloat) m_max_anisotropy;
+        Float lod = log2(max(major / count, minor));
+
+        // GPU variants cannot query the largest count without a synchronization
+        uint32_t max_count = (uint32_t) m_max_anisotropy;
+        if constexpr (!is_array_v<Float>)
+            max_count = (uint32_t) count;
+        else if constexpr (!is_cuda_array_v<Float>)
+            max_count = (uint32_t) hmax(count);
+
+        using ResultType = decltype(interpolate_trilinear(lod, uv, si.wavelengths, active));
+        ResultType result = zero<ResultType>();
+        Float weight_sum = 0.f;
+        for (uint32_t i = 0; i < max_count; ++i) {
+            Mask active_i = active && Float((ScalarFloat) i) < count;
+            Float s = fmsub(2.f, (i + .5f) / count, 1.f),
+                  weight = select(active_i, exp(-2.f * sqr(s)), 0.f);
+            Point2f p = fmadd(axis, .5f * s, uv);
+            result = fmadd(interpolate_trilinear(lod, p, si.wavelengths, active_i),
+                           weight, result);
+            weight_sum += weight;
+        }
+
+        return result * rcp(weight_sum);
+    }
+
+    /// Nearest or bilinear lookup through the texture object \c m_cuda_texture
+    MTS_INLINE auto interpolate_cuda(const Point2f &uv, const Wavelength &wavelengths,
+                                     Mask active) const {
+        auto values = m_cuda_texture->eval<Channels>(uv);
+
+        StorageType v;
+        if constexpr (Channels == 1)
+            v = Float(values.x());
+        else
+            v = StorageType(values);
+        masked(v, !active) = zero<StorageType>();
+
+        if constexpr (is_spectral_v<Spectrum> && !Raw && Channels == 3)
+            return srgb_model_eval<UnpolarizedSpectrum>(v, wavelengths);
+        else
+            return v;
+    }
+
+    /// Variant of \ref interpolate() that consults the per-thread \ref detail::LookupCache
+    MTS_INLINE auto lookup(const SurfaceInteraction3f &si, Mask active) const {
+        if constexpr (!is_array_v<Float>) {
+            if (m_cache_id != 0) {
+                using Value = decltype(interpolate(si, active));
+                return detail::lookup_cache<SurfaceInteraction3f, Value>().lookup(
+                    m_cache_id, si, [&]() { return interpolate(si, active); });
+            }
+        }
+        return interpolate(si, active);
+    }
+
+    MTS_INLINE auto interpolate(const SurfaceInteraction3f &si, Mask active) const {
         if constexpr (!is_array_v<Mask>)
             active = true;
 
         Point2f uv = m_transform.transform_affine(si.uv);
 
-        if (m_filter_type == FilterType::Bilinear) {
+        if constexpr (is_cuda_array_v<Float>) {
+            // The texture units cannot propagate gradients
+            bool differentiable = false;
+            if constexpr (is_diff_array_v<Float>)
+                differentiable = requires_gradient(m_data) || requires_gradient(uv);
+
+            if (m_cuda_texture && !differentiable)
+                return interpolate_cuda(uv, si.wavelengths, active);
+        }
+
+        if (m_filter_type == FilterType::Trilinear ||
+            m_filter_type == FilterType::Anisotropic) {
+            return interpolate_mip(si, uv, active);
+        } else if (m_filter_type == FilterType::Bilinear) {
+            if (m_tiled || m_compressed || m_half || m_blocked)
+                return interpolate_level(0, uv, si.wavelengths, active);
+
             using Int4  = Array<Int32, 4>;
             using Int24 = Array<Int4, 2>;
 
@@ -437,6 +1616,15 @@ public:
 
             // Bilinear interpolation
             if constexpr (is_spectral_v<Spectrum> && !Raw && Channels == 3) {
+                if (m_interpolate_coefficients) {
+                    // Interpolate the model coefficients and evaluate them once
+                    StorageType v0 = fmadd(w0.x(), v00, w1.x() * v10),
+                                v1 = fmadd(w0.x(), v01, w1.x() * v11);
+
+                    return srgb_model_eval<UnpolarizedSpectrum>(
+                        fmadd(w0.y(), v0, w1.y() * v1), si.wavelengths);
+                }
+
                 // Evaluate spectral upsampling model from stored coefficients
                 UnpolarizedSpectrum c00, c10, c01, c11, c0, c1;
 
@@ -463,9 +1651,7 @@ public:
             Vector2i uv_i   = floor2int<Vector2i>(uv),
                      uv_i_w = wrap(uv_i);
 
-            Int32 index = uv_i_w.x() + uv_i_w.y() * m_resolution.x();
-
-            StorageType v = gather<StorageType>(m_data, index, active);
+            StorageType v = texel(0, 0, m_resolution.x(), uv_i_w.x(), uv_i_w.y(), active);
             if constexpr (is_spectral_v<Spectrum> && !Raw && Channels == 3)
                 return srgb_model_eval<UnpolarizedSpectrum>(v, si.wavelengths);
             else
@@ -475,16 +1661,13 @@ public:
 
     std::pair<Point2f, Float> sample_position(const Point2f &sample,
                                               Mask active = true) const override {
-        if (!m_distr2d) {
-            // Construct 2D distribution upon first access, avoid races
-            std::lock_guard<tbb::spin_mutex> guard(m_mutex);
-            if (!m_distr2d) {
-                auto self = const_cast<BitmapTextureImpl *>(this);
-                self->rebuild_internals(false, true);
-            }
-        }
+        if (m_tiled || m_compressed)
+            Throw("sample_position(): the %s bitmap texture %s cannot be sampled!",
+                  m_tiled ? "tiled" : "compressed", m_name);
 
-        auto [pos, pdf, sample2] = m_distr2d->sample(sample, active);
+        const DiscreteDistribution2D<Float> *distr2d = distr();
+
+        auto [pos, pdf, sample2] = distr2d->sample(sample, active);
         ScalarVector2f inv_resolution = rcp(ScalarVector2f(m_resolution));
 
         if (m_filter_type == FilterType::Nearest) {
@@ -515,16 +1698,13 @@ public:
     }
 
     Float pdf_position(const Point2f &pos_, Mask active = true) const override {
-        if (!m_distr2d) {
-            // Construct 2D distribution upon first access, avoid races
-            std::lock_guard<tbb::spin_mutex> guard(m_mutex);
-            if (!m_distr2d) {
-                auto self = const_cast<BitmapTextureImpl *>(this);
-                self->rebuild_internals(false, true);
-            }
-        }
+        if (m_tiled || m_compressed)
+            Throw("pdf_position(): the %s bitmap texture %s cannot be sampled!",
+                  m_tiled ? "tiled" : "compressed", m_name);
 
-        if (m_filter_type == FilterType::Bilinear) {
+        const DiscreteDistribution2D<Float> *distr2d = distr();
+
+        if (m_filter_type != FilterType::Nearest) {
             using Int4  = Array<Int32, 4>;
             using Int24 = Array<Int4, 2>;
 
@@ -538,10 +1718,10 @@ public:
             Point2f w1 = uv - Point2f(uv_i),
                     w0 = 1.f - w1;
 
-            Float v00 = m_distr2d->pdf(wrap(uv_i + Point2i(0, 0)), active),
-                  v10 = m_distr2d->pdf(wrap(uv_i + Point2i(1, 0)), active),
-                  v01 = m_distr2d->pdf(wrap(uv_i + Point2i(0, 1)), active),
-                  v11 = m_distr2d->pdf(wrap(uv_i + Point2i(1, 1)), active);
+            Float v00 = distr2d->pdf(wrap(uv_i + Point2i(0, 0)), active),
+                  v10 = distr2d->pdf(wrap(uv_i + Point2i(1, 0)), active),
+                  v01 = distr2d->pdf(wrap(uv_i + Point2i(0, 1)), active),
+                  v11 = distr2d->pdf(wrap(uv_i + Point2i(1, 1)), active);
 
             Float v0 = fmadd(w0.x(), v00, w1.x() * v10),
                   v1 = fmadd(w0.x(), v01, w1.x() * v11);
@@ -554,20 +1734,40 @@ public:
             // Integer pixel positions for bilinear interpolation
             Vector2i uv_i = wrap(floor2int<Vector2i>(uv));
 
-            return m_distr2d->pdf(uv_i, active) * hprod(m_resolution);
+            return distr2d->pdf(uv_i, active) * hprod(m_resolution);
         }
     }
 
     void traverse(TraversalCallback *callback) override {
-        callback->put_parameter("data", m_data);
+        // Only the pixels of textures stored as plain single precision arrays can be modified
+        if (!m_tiled && !m_compressed && !m_half && !m_blocked)
+            callback->put_parameter("data", m_data);
         callback->put_parameter("resolution", m_resolution);
         callback->put_parameter("transform", m_transform);
     }
 
     void parameters_changed(const std::vector<std::string> &keys = {}) override {
-        if (keys.empty() || string::contains(keys, "data")) {
-            /// Convert m_data into a managed array (available in CPU/GPU address space)
-            rebuild_internals(true, m_distr2d != nullptr);
+        // Any change invalidates the cached lookups of this texture
+        if (m_cache_id != 0)
+            m_cache_id = detail::next_lookup_cache_id();
+
+        if (!m_tiled && !m_compressed && !m_half && !m_blocked &&
+            (keys.empty() || string::contains(keys, "data"))) {
+            /* Convert m_data into a managed array (available in CPU/GPU address
+               space) and recompute the mean. The sampling distribution is
+               only rebuilt upon its next access, which is skipped entirely
+               when the texture is not importance sampled. */
+            m_distr2d.reset();
+            rebuild_internals(true, false);
+
+            if constexpr (is_cuda_array_v<Float>) {
+                if (m_cuda_texture) {
+                    // Recreate the texture object, whose resolution may have changed
+                    m_cuda_texture = nullptr;
+                    init_cuda_texture(m_data.data());
+                    update_memory_record();
+                }
+            }
         }
     }
 
@@ -579,6 +1779,11 @@ public:
 
     bool is_spatially_varying() const override { return true; }
 
+    bool needs_differentials() const override {
+        return m_filter_type == FilterType::Trilinear ||
+               m_filter_type == FilterType::Anisotropic;
+    }
+
     std::string to_string() const override {
         std::ostringstream oss;
         oss << "BitmapTextureImpl[" << std::endl
@@ -586,6 +1791,15 @@ public:
             << "  resolution = \"" << m_resolution << "\"," << std::endl
             << "  raw = " << (int) Raw << "," << std::endl
             << "  mean = " << m_mean << "," << std::endl
+            << "  mip_levels = " << m_level_count << "," << std::endl
+            << "  tiled = " << (m_tiled ? "true" : "false") << "," << std::endl
+            << "  compressed = " << (m_compressed ? "true" : "false") << "," << std::endl
+            << "  half_precision = " << (m_half ? "true" : "false") << "," << std::endl
+            << "  blocked = " << (m_blocked ? "true" : "false") << "," << std::endl
+            << "  coefficient_interpolation = "
+            << (m_interpolate_coefficients ? "true" : "false") << "," << std::endl
+            << "  cuda_texture = " << (m_cuda_texture ? "true" : "false") << "," << std::endl
+            << "  cache_lookups = " << (m_cache_id != 0 ? "true" : "false") << "," << std::endl
             << "  transform = " << string::indent(m_transform) << std::endl
             << "]";
         return oss.str();
@@ -594,38 +1808,100 @@ public:
     MTS_DECLARE_CLASS()
 
 protected:
+    /**
+     * \brief Return the 2D sampling distribution, which is constructed upon
+     * first access
+     *
+     * The distribution is published through an atomic pointer, so that only
+     * the threads that arrive while it is being built need to wait.
+     */
+    MTS_INLINE const DiscreteDistribution2D<Float> *distr() const {
+        const DiscreteDistribution2D<Float> *distr2d =
+            m_distr2d_ptr.load(std::memory_order_acquire);
+        if (likely(distr2d))
+            return distr2d;
+
+        std::lock_guard<std::mutex> guard(m_mutex);
+        distr2d = m_distr2d_ptr.load(std::memory_order_relaxed);
+        if (!distr2d) {
+            const_cast<BitmapTextureImpl *>(this)->rebuild_internals(false, true);
+            distr2d = m_distr2d.get();
+        }
+        return distr2d;
+    }
+
     /**
      * \brief Recompute mean and 2D sampling distribution (if requested)
      * following an update
      */
     void rebuild_internals(bool init_mean, bool init_distr) {
+        size_t pixel_count = (size_t) hprod(m_resolution);
+
         // Recompute the mean texture value following an update
-        m_data = m_data.managed();
-        const ScalarFloat *ptr = m_data.data();
+        std::unique_ptr<ScalarFloat[]> decoded;
+        const ScalarFloat *ptr;
+        if (m_half || m_blocked) {
+            /* Decode the full-resolution level of a half precision or
+               blocked texture into a row-major array */
+            const uint32_t *words = nullptr;
+            const ScalarFloat *values = nullptr;
+            if (m_half) {
+                m_data_half = m_data_half.managed();
+                words = m_data_half.data();
+            } else {
+                m_data = m_data.managed();
+                values = m_data.data();
+            }
+
+            decoded.reset(new ScalarFloat[pixel_count * Channels]);
+            for (int32_t y = 0; y < m_resolution.y(); ++y) {
+                for (int32_t x = 0; x < m_resolution.x(); ++x) {
+                    size_t target = ((size_t) y * m_resolution.x() + x) * Channels,
+                           source = (size_t) (m_blocked ? blocked_index(m_resolution.x(), x, y)
+                                                        : y * m_resolution.x() + x) * Channels;
+                    for (uint32_t c = 0; c < Channels; ++c, ++source)
+                        decoded[target + c] =
+                            m_half ? (ScalarFloat) enoki::half::float16_to_float32(
+                                         (uint16_t) (words[source / 2] >> (16 * (source % 2))))
+                                   : values[source];
+                }
+            }
+            ptr = decoded.get();
+        } else {
+            m_data = m_data.managed();
+            ptr = m_data.data();
+        }
 
         double mean = 0.0;
-        size_t pixel_count = (size_t) hprod(m_resolution);
         bool bad = false;
 
         if (Channels == 3) {
-            std::unique_ptr<ScalarFloat[]> importance_map(
-                init_distr ? new ScalarFloat[pixel_count] : nullptr);
-
-            for (size_t i = 0; i < pixel_count; ++i) {
-                ScalarColor3f value = load_unaligned<ScalarColor3f>(ptr);
-                ScalarFloat tmp;
-                if constexpr (is_spectral_v<Spectrum> && !Raw) {
-                    tmp = srgb_model_mean(value);
-                } else {
-                    if (!all(value >= 0 && value <= 1))
-                        bad = true;
-                    tmp = luminance(value);
+            std::unique_ptr<ScalarFloat[]> importance_map(new ScalarFloat[pixel_count]);
+            std::atomic<bool> bad_any(false);
+
+            // Evaluate the importance of the pixels in parallel
+            tbb::parallel_for(
+                tbb::blocked_range<size_t>(0, pixel_count, 16384),
+                [&](const tbb::blocked_range<size_t> &range) {
+                    bool bad_range = false;
+                    for (size_t i = range.begin(); i != range.end(); ++i) {
+                        ScalarColor3f value = load_unaligned<ScalarColor3f>(ptr + 3 * i);
+                        if constexpr (is_spectral_v<Spectrum> && !Raw) {
+                            importance_map[i] = srgb_model_mean(value);
+                        } else {
+                            if (!all(value >= 0 && value <= 1))
+                                bad_range = true;
+                            importance_map[i] = luminance(value);
+                        }
+                    }
+                    if (bad_range)
+                        bad_any.store(true, std::memory_order_relaxed);
                 }
-                if (init_distr)
-                    importance_map[i] = tmp;
-                mean += (double) tmp;
-                ptr += 3;
-            }
+            );
+            bad = bad_any.load();
+
+            for (size_t i = 0; i < pixel_count; ++i)
+                mean += (double) importance_map[i];
 
             if (init_distr)
                 m_distr2d = std::make_unique<DiscreteDistribution2D<Float>>(
@@ -643,6 +1919,8 @@ protected:
                     ptr, m_resolution);
         }
 
+        m_distr2d_ptr.store(m_distr2d.get(), std::memory_order_release);
+
         if (init_mean)
             m_mean = ScalarFloat(mean / pixel_count);
 
@@ -652,6 +1930,43 @@ protected:
                 "exceed the [0, 1] range!", m_name);
     }
 
+protected:
+    /// Account for the memory of the texel storage (see \ref MemoryCategory::Textures)
+    void update_memory_record() {
+        m_memory.set(slices(m_data) * sizeof(ScalarFloat) + slices(m_blocks) * sizeof(uint64_t) +
+                     slices(m_data_half) * sizeof(uint32_t) +
+                     (m_cuda_texture ? m_cuda_texture->size_bytes() : 0));
+    }
+
+    /**
+     * \brief Create the texture object that performs the lookups on the GPU
+     * (see the \c cuda_texture parameter) from host-accessible pixels
+     */
+    void init_cuda_texture(const ScalarFloat *data) {
+        if constexpr (is_cuda_array_v<Float>) {
+            if (is_spectral_v<Spectrum> && !Raw && Channels == 3 &&
+                m_filter_type == FilterType::Bilinear && !m_interpolate_coefficients) {
+                Log(Warn, "BitmapTexture: bilinear lookups of spectral textures only use "
+                    "texture objects with \"coefficient_interpolation\" enabled, ignoring the "
+                    "\"cuda_texture\" option of texture \"%s\".", m_name);
+                return;
+            }
+
+            size_t shape[2] = { (size_t) m_resolution.x(), (size_t) m_resolution.y() };
+            CUDATexture::WrapMode wrap_mode =
+                m_wrap_mode == WrapMode::Repeat ? CUDATexture::WrapMode::Repeat :
+                (m_wrap_mode == WrapMode::Mirror ? CUDATexture::WrapMode::Mirror
+                                                 : CUDATexture::WrapMode::Clamp);
+            m_cuda_texture = new CUDATexture(
+                2, shape, Channels, data,
+                m_filter_type == FilterType::Nearest ? CUDATexture::FilterMode::Nearest
+                                                     : CUDATexture::FilterMode::Linear,
+                wrap_mode);
+        } else {
+            ENOKI_MARK_USED(data);
+        }
+    }
+
 protected:
     DynamicBuffer<Float> m_data;
     ScalarVector2i m_resolution;
@@ -663,12 +1978,157 @@ protected:
     FilterType m_filter_type;
     WrapMode m_wrap_mode;
 
+    // MIP map pyramid: number of levels and the (offset, width, height) of each
+    uint32_t m_level_count = 1;
+    DynamicBuffer<Int32> m_level_info;
+    int m_max_anisotropy;
+
+    /// Tiled version of the texture, whose pixels are fetched through the \ref TileCache
+    ref<TiledImage> m_tiled;
+
+    /// Blocks of all levels of a block compressed texture (BC1 or BC4)
+    DynamicBuffer<UInt64> m_blocks;
+    bool m_compressed;
+
+    /// Pixels of all levels stored as pairs of half precision values
+    DynamicBuffer<UInt32> m_data_half;
+    bool m_half;
+
+    /// Are the pixels stored in blocks of 8x8 pixels? (see \ref blocked_index())
+    bool m_blocked;
+
+    /// Interpolate the spectral model coefficients rather than the spectra?
+    bool m_interpolate_coefficients;
+
+    /// Texture object performing the lookups in GPU variants (see \ref CUDATexture)
+    ref<CUDATexture> m_cuda_texture;
+
+    /// Id of the entries of this texture in the \ref detail::LookupCache (0 if disabled)
+    uint64_t m_cache_id = 0;
+
+    MemoryRecord m_memory { MemoryCategory::Textures };
+
     // Optional: distribution for importance sampling
-    mutable tbb::spin_mutex m_mutex;
+    mutable std::mutex m_mutex;
     std::unique_ptr<DiscreteDistribution2D<Float>> m_distr2d;
+    mutable std::atomic<const DiscreteDistribution2D<Float> *> m_distr2d_ptr { nullptr };
+};
+
+/**
+ * Bitmap texture whose image is decoded when it is first used (see the
+ * \c lazy option), which then forwards all queries to the texture that
+ * \ref BitmapTexture creates from the same settings
+ */
+template <typename Float, typename Spectrum>
+class LazyBitmapTexture final : public Texture<Float, Spectrum> {
+public:
+    MTS_IMPORT_BASE(Texture)
+    MTS_IMPORT_TYPES()
+
+    LazyBitmapTexture(const Properties &props, const std::string &name,
+                      const ScalarVector2i &resolution, uint32_t channel_count,
+                      bool needs_differentials)
+        : Base(Properties()), m_props(props), m_name(name), m_resolution(resolution),
+          m_channel_count(channel_count), m_needs_differentials(needs_differentials) { }
+
+    UnpolarizedSpectrum eval(const SurfaceInteraction3f &si, Mask active) const override {
+        return texture()->eval(si, active);
+    }
+
+    Float eval_1(const SurfaceInteraction3f &si, Mask active = true) const override {
+        return texture()->eval_1(si, active);
+    }
+
+    Vector2f eval_1_grad(const SurfaceInteraction3f &si, Mask active = true) const override {
+        return texture()->eval_1_grad(si, active);
+    }
+
+    Color3f eval_3(const SurfaceInteraction3f &si, Mask active = true) const override {
+        return texture()->eval_3(si, active);
+    }
+
+    std::pair<Point2f, Float> sample_position(const Point2f &sample,
+                                              Mask active = true) const override {
+        return texture()->sample_position(sample, active);
+    }
+
+    Float pdf_position(const Point2f &pos, Mask active = true) const override {
+        return texture()->pdf_position(pos, active);
+    }
+
+    void traverse(TraversalCallback *callback) override {
+        const_cast<Base *>(texture())->traverse(callback);
+    }
+
+    void parameters_changed(const std::vector<std::string> &keys = {}) override {
+        const_cast<Base *>(texture())->parameters_changed(keys);
+    }
+
+    /// Known from the header, hence the image is only decoded if it was already accessed
+    ScalarVector2i resolution() const override {
+        const Base *texture = m_texture_ptr.load(std::memory_order_acquire);
+        return texture ? texture->resolution() : m_resolution;
+    }
+
+    ScalarFloat mean() const override { return texture()->mean(); }
+
+    bool is_spatially_varying() const override { return true; }
+
+    bool needs_differentials() const override { return m_needs_differentials; }
+
+    std::string to_string() const override {
+        const Base *texture = m_texture_ptr.load(std::memory_order_acquire);
+        std::ostringstream oss;
+        oss << "LazyBitmapTexture[" << std::endl
+            << "  name = \"" << m_name << "\"," << std::endl
+            << "  resolution = \"" << m_resolution << "\"," << std::endl
+            << "  channel_count = " << m_channel_count << "," << std::endl
+            << "  texture = " << (texture ? string::indent(texture) : "<not decoded>")
+            << std::endl
+            << "]";
+        return oss.str();
+    }
+
+    MTS_DECLARE_CLASS()
+
+protected:
+    /**
+     * \brief Return the texture with the decoded image, which is loaded upon
+     * first access
+     *
+     * The texture is published through an atomic pointer, so that only the
+     * threads that arrive while the image is being decoded need to wait.
+     */
+    MTS_INLINE const Base *texture() const {
+        const Base *texture = m_texture_ptr.load(std::memory_order_acquire);
+        if (likely(texture))
+            return texture;
+
+        std::lock_guard<std::mutex> guard(m_mutex);
+        texture = m_texture_ptr.load(std::memory_order_relaxed);
+        if (!texture) {
+            ref<Base> bitmap = PluginManager::instance()->create_object<Base>(m_props);
+            m_texture = (Base *) bitmap->expand().at(0).get();
+            texture = m_texture.get();
+            m_texture_ptr.store(texture, std::memory_order_release);
+        }
+        return texture;
+    }
+
+protected:
+    Properties m_props;
+    std::string m_name;
+    ScalarVector2i m_resolution;
+    uint32_t m_channel_count;
+    bool m_needs_differentials;
+
+    mutable std::mutex m_mutex;
+    mutable ref<Base> m_texture;
+    mutable std::atomic<const Base *> m_texture_ptr { nullptr };
 };
 
 MTS_IMPLEMENT_CLASS_VARIANT(BitmapTexture, Texture)
+MTS_IMPLEMENT_CLASS_VARIANT(LazyBitmapTexture, Texture)
 MTS_EXPORT_PLUGIN(BitmapTexture, "Bitmap texture")
 
 
@@ -1,12 +1,18 @@
 #include <enoki/stl.h>
+#include <algorithm>
 
+#include <mitsuba/core/memory.h>
 #include <mitsuba/core/properties.h>
 #include <mitsuba/core/spectrum.h>
 #include <mitsuba/core/string.h>
 #include <mitsuba/core/transform.h>
+#include <mitsuba/core/util.h>
+#include <mitsuba/render/cuda_texture.h>
 #include <mitsuba/render/srgb.h>
 #include <mitsuba/render/texture.h>
 #include <mitsuba/render/volume_texture.h>
+#include <enoki/half.h>
+#include <tbb/parallel_reduce.h>
 
 #include "volume_data.h"
 
@@ -15,6 +21,9 @@ NAMESPACE_BEGIN(mitsuba)
 enum class FilterType { Nearest, Trilinear };
 enum class WrapMode { Repeat, Mirror, Clamp };
 
+/// Formats of the stored voxel values (see the \c storage property)
+enum class StorageFormat { Float32, Float16, UInt16, UInt8 };
+
 
 // Forward declaration of specialized GridVolume
 template <typename Float, typename Spectrum, uint32_t Channels, bool Raw>
@@ -32,6 +41,45 @@ class GridVolumeImpl;
  * operation makes sense after the file has been mapped into memory:
  *     data[((zpos*yres + ypos)*xres + xpos)*channels + chan]}
  *     where (xpos, ypos, zpos, chan) denotes the lookup location.
+ *
+ * Sparse storage:
+ * When the \c sparse property is set, the grid is stored as a two-level
+ * tree in the spirit of NanoVDB: a coarse table references bricks of 8x8x8
+ * voxels, and bricks whose voxels are all zero are not stored (they share a
+ * single background brick). Point lookups fetch the brick index and then the
+ * voxel, which works in all variants (including the GPU ones). The file is
+ * streamed eight slices at a time, so that dense volumes that are mostly
+ * empty never need to fit in memory. The maximum value of each brick is
+ * available through \ref max_per_cell(), e.g. for local majorants. Sparse
+ * grids do not expose their voxels as a differentiable parameter.
+ *
+ * Memory mapping:
+ * Dense grids map the file into memory (copy-on-write), so that its pages
+ * are shared with the page cache and with other processes rendering the same
+ * volume. In CPU variants, single precision grids use the mapped voxels in
+ * place when they are aligned for packet access (which depends on the packet
+ * width, since the voxels start 48 bytes into the file), and otherwise copy
+ * them. Conversions (spectral upsampling, double precision, and the byte order
+ * of big endian hosts) and the mean and maximum run in parallel.
+ *
+ * Reduced precision:
+ * The \c storage property selects the format of the stored values:
+ * \c float32 (the default), \c float16, or the quantized formats \c uint16
+ * and \c uint8, which map the range of each channel of the grid linearly to
+ * the integers by means of a per-channel scale and offset. The values are
+ * converted back to single precision when they are fetched, i.e. before the
+ * trilinear interpolation. Such grids also do not expose their voxels as a
+ * differentiable parameter.
+ *
+ * Texture objects:
+ * When the \c cuda_texture property is set, GPU variants additionally store
+ * the voxels of dense single precision grids in a CUDA texture object (see
+ * \ref CUDATexture), whose lookups are interpolated and wrapped by the texture
+ * units and go through their dedicated cache. The hardware computes the
+ * interpolation weights with 8 bits of fractional precision. Lookups that
+ * require gradients use the software implementation, and so do the trilinear
+ * lookups of spectral color grids (which evaluate the spectral model at each
+ * voxel before interpolating).
  */
 template <typename Float, typename Spectrum>
 class GridVolume final : public Volume<Float, Spectrum> {
@@ -61,39 +109,33 @@ public:
                   "\"mirror\", or \"clamp\"!", wrap_mode);
 
 
-        auto [metadata, raw_data] = read_binary_volume_data<Float>(props.string("filename"));
-        m_metadata                = metadata;
-        m_raw                     = props.bool_("raw", false);
-        ScalarUInt32 size         = hprod(m_metadata.shape);
-        // Apply spectral conversion if necessary
-        if (is_spectral_v<Spectrum> && m_metadata.channel_count == 3 && !m_raw) {
-            ScalarFloat *ptr = raw_data.get();
-            auto scaled_data = std::unique_ptr<ScalarFloat[]>(new ScalarFloat[size * 4]);
-            ScalarFloat *scaled_data_ptr = scaled_data.get();
-            double mean = 0.0;
-            ScalarFloat max = 0.0;
-            for (ScalarUInt32 i = 0; i < size; ++i) {
-                ScalarColor3f rgb = load_unaligned<ScalarColor3f>(ptr);
-                // TODO: Make this scaling optional if the RGB values are between 0 and 1
-                ScalarFloat scale = hmax(rgb) * 2.f;
-                ScalarColor3f rgb_norm = rgb / std::max((ScalarFloat) 1e-8, scale);
-                ScalarVector3f coeff = srgb_model_fetch(rgb_norm);
-                mean += (double) (srgb_model_mean(coeff) * scale);
-                max = std::max(max, scale);
-                store_unaligned(scaled_data_ptr, concat(coeff, scale));
-                ptr += 3;
-                scaled_data_ptr += 4;
-            }
-            m_metadata.mean = mean;
-            m_metadata.max = max;
-            m_data = DynamicBuffer<Float>::copy(scaled_data.get(), size * 4);
+        std::string storage = props.string("storage", "float32");
+        if (storage == "float32")
+            m_format = StorageFormat::Float32;
+        else if (storage == "float16")
+            m_format = StorageFormat::Float16;
+        else if (storage == "uint16")
+            m_format = StorageFormat::UInt16;
+        else if (storage == "uint8")
+            m_format = StorageFormat::UInt8;
+        else
+            Throw("Invalid storage format \"%s\", must be one of: \"float32\", "
+                  "\"float16\", \"uint16\", or \"uint8\"!", storage);
+
+        m_raw = props.bool_("raw", false);
+        if (props.bool_("sparse", false)) {
+            load_sparse(props.string("filename"));
         } else {
-            m_data = DynamicBuffer<Float>::copy(raw_data.get(), size * m_metadata.channel_count);
+            load_dense(props.string("filename"));
         }
 
+        if (m_format != StorageFormat::Float32)
+            pack();
+
         // Mark values which are only used in the implementation class as queried
         props.mark_queried("use_grid_bbox");
         props.mark_queried("max_value");
+        props.mark_queried("cuda_texture");
     }
 
     template <uint32_t Channels, bool Raw> using Impl = GridVolumeImpl<Float, Spectrum, Channels, Raw>;
@@ -105,12 +147,10 @@ public:
         ref<Object> result;
         switch (m_metadata.channel_count) {
             case 1:
-                result = m_raw ? (Object *) new Impl<1, true>(m_props, m_metadata, m_data, m_filter_type, m_wrap_mode)
-                               : (Object *) new Impl<1, false>(m_props, m_metadata, m_data, m_filter_type, m_wrap_mode);
+                result = m_raw ? expand_impl<1, true>() : expand_impl<1, false>();
                 break;
             case 3:
-                result = m_raw ? (Object *) new Impl<3, true>(m_props, m_metadata, m_data, m_filter_type, m_wrap_mode)
-                               : (Object *) new Impl<3, false>(m_props, m_metadata, m_data, m_filter_type, m_wrap_mode);
+                result = m_raw ? expand_impl<3, true>() : expand_impl<3, false>();
                 break;
             default:
                 Throw("Unsupported channel count: %d (expected 1 or 3)", m_metadata.channel_count);
@@ -119,9 +159,260 @@ public:
     }
 
     MTS_DECLARE_CLASS()
+protected:
+    template <uint32_t Channels, bool Raw> Object *expand_impl() const {
+        return new Impl<Channels, Raw>(m_props, m_metadata, m_data, m_mmap, m_brick_index,
+                                       m_format, m_packed, m_offset, m_scale, m_filter_type,
+                                       m_wrap_mode);
+    }
+
+    /**
+     * Convert the values in \c m_data to the reduced precision format \c
+     * m_format, and store them as packed 8 or 16-bit values in \c m_packed
+     */
+    void pack() {
+        m_data = m_data.managed();
+        const ScalarFloat *ptr = m_data.data();
+
+        bool uses_srgb_model = is_spectral_v<Spectrum> && m_metadata.channel_count == 3 && !m_raw;
+        const size_t stride = uses_srgb_model ? 4 : m_metadata.channel_count,
+                     count  = slices(m_data);
+
+        // Per-channel range of the quantized formats
+        uint32_t bits = m_format == StorageFormat::UInt8 ? 8 : 16,
+                 per_word = 32 / bits,
+                 max_code = (1u << bits) - 1;
+        ScalarVector4f inv_scale(0.f);
+        if (m_format != StorageFormat::Float16) {
+            ScalarVector4f lo(math::Infinity<ScalarFloat>), hi(-math::Infinity<ScalarFloat>);
+            for (size_t i = 0; i < count; ++i) {
+                lo[i % stride] = std::min(lo[i % stride], ptr[i]);
+                hi[i % stride] = std::max(hi[i % stride], ptr[i]);
+            }
+            for (size_t c = 0; c < stride; ++c) {
+                m_offset[c] = lo[c];
+                m_scale[c] = (hi[c] - lo[c]) / max_code;
+                inv_scale[c] = m_scale[c] > 0.f ? 1.f / m_scale[c] : 0.f;
+            }
+        }
+
+        std::vector<uint32_t> words((count + per_word - 1) / per_word, 0u);
+        for (size_t i = 0; i < count; ++i) {
+            uint32_t code;
+            if (m_format == StorageFormat::Float16) {
+                code = enoki::half::float32_to_float16((float) ptr[i]);
+            } else {
+                size_t c = i % stride;
+                code = (uint32_t) std::min(std::max(
+                    std::lround((ptr[i] - m_offset[c]) * inv_scale[c]), 0l), (long) max_code);
+            }
+            words[i / per_word] |= code << (bits * (i % per_word));
+        }
+
+        Log(Debug, "Stored the grid volume data from file %s in %i-bit precision (%s)",
+            m_metadata.filename, bits, util::mem_string(words.size() * sizeof(uint32_t)));
+
+        m_packed = DynamicBuffer<UInt32>::copy(words.data(), words.size());
+        m_data = DynamicBuffer<Float>();
+    }
+
+    /**
+     * Load the volume from a memory mapping of the file. Unless the values
+     * need to be converted, the voxels are used directly from the mapping.
+     */
+    void load_dense(const std::string &filename) {
+        ref<MemoryMappedFile> mmap;
+        const float *values;
+        std::tie(m_metadata, mmap, values) = map_binary_volume_data<Float>(filename);
+
+        using Range = tbb::blocked_range<size_t>;
+        using Statistics = std::pair<double, ScalarFloat>;
+        auto combine = [](const Statistics &a, const Statistics &b) {
+            return Statistics(a.first + b.first, std::max(a.second, b.second));
+        };
+
+        const size_t size = (size_t) hprod(m_metadata.shape),
+                     channels = m_metadata.channel_count,
+                     grain_size = 16384;
+
+        // Apply spectral conversion if necessary
+        if (is_spectral_v<Spectrum> && channels == 3 && !m_raw) {
+            auto scaled_data = std::unique_ptr<ScalarFloat[]>(new ScalarFloat[size * 4]);
+            ScalarFloat *scaled_data_ptr = scaled_data.get();
+            Statistics stats = tbb::parallel_reduce(
+                Range(0, size, grain_size), Statistics(0.0, 0.f),
+                [&](const Range &range, Statistics stats) {
+                    for (size_t i = range.begin(); i != range.end(); ++i) {
+                        ScalarColor3f rgb(values[3 * i], values[3 * i + 1], values[3 * i + 2]);
+                        // TODO: Make this scaling optional if the RGB values are between 0 and 1
+                        ScalarFloat scale = hmax(rgb) * 2.f;
+                        ScalarColor3f rgb_norm = rgb / std::max((ScalarFloat) 1e-8, scale);
+                        ScalarVector3f coeff = srgb_model_fetch(rgb_norm);
+                        stats.first += (double) (srgb_model_mean(coeff) * scale);
+                        stats.second = std::max(stats.second, scale);
+                        store_unaligned(scaled_data_ptr + 4 * i, concat(coeff, scale));
+                    }
+                    return stats;
+                }, combine);
+            m_metadata.mean = stats.first;
+            m_metadata.max = stats.second;
+            m_data = DynamicBuffer<Float>::copy(scaled_data.get(), size * 4);
+
+            Log(Debug, "Loaded grid volume data from file %s: dimensions %s, mean value %f, "
+                "max value %f", filename, m_metadata.shape, m_metadata.mean, m_metadata.max);
+            return;
+        }
+
+        const size_t count = size * channels;
+        Statistics stats = tbb::parallel_reduce(
+            Range(0, count, grain_size), Statistics(0.0, -math::Infinity<ScalarFloat>),
+            [&](const Range &range, Statistics stats) {
+                for (size_t i = range.begin(); i != range.end(); ++i) {
+                    stats.first += (double) values[i];
+                    stats.second = std::max(stats.second, (ScalarFloat) values[i]);
+                }
+                return stats;
+            }, combine);
+        m_metadata.mean = stats.first / (double) count;
+        m_metadata.max = stats.second;
+
+        Log(Debug, "Loaded grid volume data from file %s: dimensions %s, mean value %f, "
+            "max value %f", filename, m_metadata.shape, m_metadata.mean, m_metadata.max);
+
+        /* Values that are aligned for packet access are used in place, unless
+           they are packed into a reduced precision format below. The GPU
+           variants need a copy on the device anyway. */
+        if constexpr (!is_dynamic_array_v<Float> && std::is_same_v<ScalarFloat, float>) {
+            using Packet = typename DynamicBuffer<Float>::Packet;
+            if ((uintptr_t) values % alignof(Packet) == 0 && m_format == StorageFormat::Float32) {
+                m_data = DynamicBuffer<Float>::map((void *) values, count);
+                m_mmap = mmap;
+                return;
+            }
+        }
+
+        if constexpr (std::is_same_v<ScalarFloat, float>) {
+            m_data = DynamicBuffer<Float>::copy(values, count);
+        } else {
+            auto converted = std::unique_ptr<ScalarFloat[]>(new ScalarFloat[count]);
+            ScalarFloat *converted_ptr = converted.get();
+            tbb::parallel_for(Range(0, count, grain_size), [&](const Range &range) {
+                for (size_t i = range.begin(); i != range.end(); ++i)
+                    converted_ptr[i] = (ScalarFloat) values[i];
+            });
+            m_data = DynamicBuffer<Float>::copy(converted.get(), count);
+        }
+    }
+
+    /**
+     * Load the volume as bricks of 8x8x8 voxels (see the class description),
+     * reading the file one layer of bricks at a time
+     */
+    void load_sparse(const std::string &filename) {
+        auto [metadata, f] = open_binary_volume_data<Float>(filename);
+        m_metadata = metadata;
+
+        bool uses_srgb_model = is_spectral_v<Spectrum> && m_metadata.channel_count == 3 && !m_raw;
+        const size_t channels = m_metadata.channel_count,
+                     stride   = uses_srgb_model ? 4 : channels;
+        const ScalarVector3i shape = m_metadata.shape,
+                             bricks = (shape + 7) / 8;
+
+        // Brick 0 holds the background value (zero) of the empty bricks
+        std::vector<int32_t> brick_index((size_t) hprod(bricks), 0);
+        std::vector<ScalarFloat> data(512 * stride, 0.f);
+
+        size_t slice_size = (size_t) shape.x() * shape.y() * channels;
+        std::unique_ptr<float[]> slab(new float[8 * slice_size]);
+
+        double mean = 0.0;
+        ScalarFloat max = 0.f;
+        size_t brick_count = 1;
+        for (int32_t bz = 0; bz < bricks.z(); ++bz) {
+            int32_t depth = std::min(8, shape.z() - 8 * bz);
+            f.read(reinterpret_cast<char *>(slab.get()), sizeof(float) * depth * slice_size);
+            if (!f)
+                Throw("Failed to read the voxels of volume file %s", filename);
+
+            for (int32_t by = 0; by < bricks.y(); ++by) {
+                for (int32_t bx = 0; bx < bricks.x(); ++bx) {
+                    int32_t height = std::min(8, shape.y() - 8 * by),
+                            width  = std::min(8, shape.x() - 8 * bx);
+
+                    auto voxel = [&](int32_t x, int32_t y, int32_t z) {
+                        return slab.get() + (((size_t) z * shape.y() + 8 * by + y) * shape.x() +
+                                             8 * bx + x) * channels;
+                    };
+
+                    // Skip the bricks whose voxels are all zero
+                    bool empty = true;
+                    for (int32_t z = 0; z < depth && empty; ++z)
+                        for (int32_t y = 0; y < height && empty; ++y)
+                            for (size_t i = 0; i < width * channels; ++i)
+                                if (voxel(0, y, z)[i] != 0.f) {
+                                    empty = false;
+                                    break;
+                                }
+                    if (empty)
+                        continue;
+
+                    brick_index[((size_t) bz * bricks.y() + by) * bricks.x() + bx] =
+                        (int32_t) brick_count;
+                    ScalarFloat *target = &*data.insert(data.end(), 512 * stride, 0.f);
+                    ++brick_count;
+
+                    for (int32_t z = 0; z < depth; ++z) {
+                        for (int32_t y = 0; y < height; ++y) {
+                            for (int32_t x = 0; x < width; ++x) {
+                                const float *value = voxel(x, y, z);
+                                ScalarFloat *out = target + ((z << 6) | (y << 3) | x) * stride;
+                                if (uses_srgb_model) {
+                                    ScalarColor3f rgb(value[0], value[1], value[2]);
+                                    ScalarFloat scale = hmax(rgb) * 2.f;
+                                    ScalarColor3f rgb_norm = rgb / std::max((ScalarFloat) 1e-8, scale);
+                                    ScalarVector3f coeff = srgb_model_fetch(rgb_norm);
+                                    mean += (double) (srgb_model_mean(coeff) * scale);
+                                    max = std::max(max, scale);
+                                    store_unaligned(out, concat(coeff, scale));
+                                } else {
+                                    for (size_t c = 0; c < channels; ++c) {
+                                        out[c] = value[c];
+                                        mean += (double) value[c];
+                                        max = std::max(max, (ScalarFloat) value[c]);
+                                    }
+                                }
+                            }
+                        }
+                    }
+                }
+            }
+        }
+
+        if (brick_count >= (1u << 22))
+            Throw("Volume file %s has too many non-empty bricks (%i) to be stored sparsely",
+                  filename, brick_count);
+
+        m_metadata.mean = mean / (double) (hprod(shape) * (uses_srgb_model ? 1 : channels));
+        m_metadata.max = max;
+        m_data = DynamicBuffer<Float>::copy(data.data(), data.size());
+        m_brick_index = DynamicBuffer<Int32>::copy(brick_index.data(), brick_index.size());
+
+        Log(Debug, "Loaded sparse grid volume data from file %s: dimensions %s, %i of %i "
+            "bricks stored (%s)", filename, shape, brick_count - 1, hprod(bricks),
+            util::mem_string(data.size() * sizeof(ScalarFloat)));
+    }
+
 protected:
     bool m_raw;
     DynamicBuffer<Float> m_data;
+    /// Mapping of the file that holds the values of \c m_data (if they are used in place)
+    ref<MemoryMappedFile> m_mmap;
+    /// Brick of each 8x8x8 block of voxels of a sparse grid (empty for dense grids)
+    DynamicBuffer<Int32> m_brick_index;
+    /// Values in reduced precision formats, with the scale and offset of quantized ones
+    StorageFormat m_format;
+    DynamicBuffer<UInt32> m_packed;
+    ScalarVector4f m_offset = 0.f, m_scale = 0.f;
     VolumeMetadata m_metadata;
     Properties m_props;
     FilterType m_filter_type;
@@ -136,17 +427,31 @@ public:
 
     GridVolumeImpl(const Properties &props, const VolumeMetadata &meta,
                const DynamicBuffer<Float> &data,
+               const MemoryMappedFile *mmap,
+               const DynamicBuffer<Int32> &brick_index,
+               StorageFormat format,
+               const DynamicBuffer<UInt32> &packed,
+               const ScalarVector4f &offset,
+               const ScalarVector4f &scale,
                FilterType filter_type,
                WrapMode wrap_mode)
         : Base(props),
-            m_data(data),
+            // Keep referring to the mapped values instead of copying them
+            m_data(mmap ? DynamicBuffer<Float>::map((void *) data.data(), slices(data)) : data),
+            m_mmap(mmap),
+            m_brick_index(brick_index),
+            m_sparse(slices(brick_index) > 0),
+            m_bricks((meta.shape + 7) / 8),
+            m_format(format), m_packed(packed), m_offset(offset), m_scale(scale),
             m_metadata(meta),
             m_inv_resolution_x((int) m_metadata.shape.x()),
             m_inv_resolution_y((int) m_metadata.shape.y()),
             m_inv_resolution_z((int) m_metadata.shape.z()),
             m_filter_type(filter_type), m_wrap_mode(wrap_mode){
 
-
+        m_memory.set(slices(m_data) * sizeof(ScalarFloat) +
+                     slices(m_brick_index) * sizeof(int32_t) +
+                     slices(m_packed) * sizeof(uint32_t));
 
         m_size     = hprod(m_metadata.shape);
         if (props.bool_("use_grid_bbox", false)) {
@@ -158,6 +463,17 @@ public:
             m_fixed_max    = true;
             m_metadata.max = props.float_("max_value");
         }
+
+        if (props.bool_("cuda_texture", false) && is_cuda_array_v<Float>) {
+            constexpr bool uses_srgb_model = is_spectral_v<Spectrum> && !Raw && Channels == 3;
+            if (m_sparse || m_format != StorageFormat::Float32 ||
+                (uses_srgb_model && m_filter_type == FilterType::Trilinear))
+                Log(Warn, "GridVolume: texture objects are only used by dense single precision "
+                    "grids (and for nearest neighbor lookups of spectral color grids), "
+                    "ignoring the \"cuda_texture\" option.");
+            else
+                init_cuda_texture();
+        }
     }
 
     UnpolarizedSpectrum eval(const Interaction3f &it, Mask active) const override {
@@ -265,6 +581,23 @@ public:
         if constexpr (!is_array_v<Mask>)
             active = true;
 
+        if constexpr (is_cuda_array_v<Float>) {
+            // The texture units cannot propagate gradients
+            bool differentiable = false;
+            if constexpr (is_diff_array_v<Float>)
+                differentiable = requires_gradient(m_data) || requires_gradient(p);
+
+            if (m_cuda_texture && !differentiable) {
+                StorageType v(m_cuda_texture->eval<array_size_v<StorageType>>(p));
+                masked(v, !active) = zero<StorageType>();
+
+                if constexpr (uses_srgb_model)
+                    return v.w() * srgb_model_eval<UnpolarizedSpectrum>(head<3>(v), wavelengths);
+                else
+                    return v;
+            }
+        }
+
         const uint32_t nx = m_metadata.shape.x();
         const uint32_t ny = m_metadata.shape.y();
 
@@ -288,17 +621,23 @@ public:
                                       Int8(0, 0, 0, 0, 1, 1, 1, 1) + p_i.z()));
 
             // (z * ny + y) * nx + x
-            Int8 index = fmadd(fmadd(pi_i_w.z(), ny, pi_i_w.y()), nx, pi_i_w.x());
+            Int8 index;
+            if (m_sparse) {
+                for (size_t k = 0; k < 8; ++k)
+                    index[k] = sparse_index(pi_i_w.x()[k], pi_i_w.y()[k], pi_i_w.z()[k], active);
+            } else {
+                index = fmadd(fmadd(pi_i_w.z(), ny, pi_i_w.y()), nx, pi_i_w.x());
+            }
 
             // Load 8 grid positions to perform trilinear interpolation
-            auto d000 = gather<StorageType>(m_data, index[0], active),
-                 d100 = gather<StorageType>(m_data, index[1], active),
-                 d010 = gather<StorageType>(m_data, index[2], active),
-                 d110 = gather<StorageType>(m_data, index[3], active),
-                 d001 = gather<StorageType>(m_data, index[4], active),
-                 d101 = gather<StorageType>(m_data, index[5], active),
-                 d011 = gather<StorageType>(m_data, index[6], active),
-                 d111 = gather<StorageType>(m_data, index[7], active);
+            auto d000 = fetch<StorageType>(index[0], active),
+                 d100 = fetch<StorageType>(index[1], active),
+                 d010 = fetch<StorageType>(index[2], active),
+                 d110 = fetch<StorageType>(index[3], active),
+                 d001 = fetch<StorageType>(index[4], active),
+                 d101 = fetch<StorageType>(index[5], active),
+                 d011 = fetch<StorageType>(index[6], active),
+                 d111 = fetch<StorageType>(index[7], active);
 
             ResultType v000, v001, v010, v011, v100, v101, v110, v111;
             Float scale = 1.f;
@@ -347,9 +686,10 @@ public:
             Vector3i p_i   = floor2int<Vector3i>(p),
                     p_i_w = wrap(p_i);
 
-            Int32 index = fmadd(fmadd(p_i_w.z(), ny, p_i_w.y()), nx, p_i_w.x());
+            Int32 index = m_sparse ? sparse_index(p_i_w.x(), p_i_w.y(), p_i_w.z(), active)
+                                   : fmadd(fmadd(p_i_w.z(), ny, p_i_w.y()), nx, p_i_w.x());
 
-            StorageType v = gather<StorageType>(m_data, index, active);
+            StorageType v = fetch<StorageType>(index, active);
 
             if constexpr (uses_srgb_model)
                 return v.w() * srgb_model_eval<UnpolarizedSpectrum>(head<3>(v), wavelengths);
@@ -359,17 +699,262 @@ public:
         }
     }
 
+    /// Fetch the stored values of the voxel with index \c index
+    template <typename StorageType>
+    MTS_INLINE StorageType fetch(const Int32 &index, Mask active) const {
+        if (m_format == StorageFormat::Float32)
+            return gather<StorageType>(m_data, index, active);
+
+        constexpr size_t Stride = array_size_v<StorageType>;
+        UInt32 first = UInt32(index) * (uint32_t) Stride;
+
+        StorageType result;
+        for (size_t c = 0; c < Stride; ++c) {
+            UInt32 element = first + (uint32_t) c, code;
+            if (m_format == StorageFormat::UInt8) {
+                UInt32 word = gather<UInt32>(m_packed, element >> 2, active);
+                code = (word >> ((element & 3u) << 3)) & 0xFFu;
+            } else {
+                code = gather_uint16(m_packed, element, active);
+            }
+
+            if (m_format == StorageFormat::Float16)
+                result[c] = Float(decode_half(code));
+            else
+                result[c] = fmadd(Float(code), m_scale[c], m_offset[c]);
+        }
+        return result;
+    }
+
+    /// Host-side version of \ref fetch() for a single stored value
+    ScalarFloat stored_value(const ScalarFloat *data, const uint32_t *packed,
+                             size_t element) const {
+        constexpr size_t Stride = is_spectral_v<Spectrum> && !Raw && Channels == 3 ? 4 : Channels;
+
+        if (m_format == StorageFormat::Float32)
+            return data[element];
+        else if (m_format == StorageFormat::Float16)
+            return (ScalarFloat) enoki::half::float16_to_float32(
+                (uint16_t) (packed[element / 2] >> (16 * (element % 2))));
+
+        uint32_t bits = m_format == StorageFormat::UInt8 ? 8 : 16,
+                 per_word = 32 / bits,
+                 code = (packed[element / per_word] >> (bits * (element % per_word))) &
+                        ((1u << bits) - 1);
+        return m_offset[element % Stride] + code * m_scale[element % Stride];
+    }
+
+    /// Index of the voxel <tt>(x, y, z)</tt> within the bricks of a sparse grid
+    MTS_INLINE Int32 sparse_index(const Int32 &x, const Int32 &y, const Int32 &z,
+                                  Mask active) const {
+        Int32 brick = gather<Int32>(
+            m_brick_index, fmadd(fmadd(z >> 3, m_bricks.y(), y >> 3), m_bricks.x(), x >> 3),
+            active);
+        return (brick << 9) | ((z & 7) << 6) | ((y & 7) << 3) | (x & 7);
+    }
+
     ScalarFloat max() const override { return m_metadata.max; }
+
+    std::vector<ScalarFloat> max_per_cell(const ScalarVector3i &cells) const override {
+        return extremum_per_cell(cells, true);
+    }
+
+    std::vector<ScalarFloat> min_per_cell(const ScalarVector3i &cells) const override {
+        return extremum_per_cell(cells, false);
+    }
+
+    std::vector<ScalarFloat> max_per_cell_and_band(const ScalarVector3i &cells,
+                                                   uint32_t bands) const override {
+        if (bands == 0 || (is_rgb_v<Spectrum> && bands != 3))
+            Throw("max_per_cell_and_band(): invalid number of bands (%i)!", bands);
+        return extremum_per_cell(cells, true, bands);
+    }
+
+    /**
+     * \brief Shared implementation of \ref max_per_cell(), \ref min_per_cell()
+     * and \ref max_per_cell_and_band()
+     *
+     * The extremum is taken separately for each of \c bands spectral bands,
+     * which only differ for the color channels of RGB variants and for the
+     * spectral model of spectral variants.
+     */
+    std::vector<ScalarFloat> extremum_per_cell(const ScalarVector3i &cells,
+                                               bool maximum, uint32_t bands = 1) const {
+        constexpr bool uses_srgb_model = is_spectral_v<Spectrum> && !Raw && Channels == 3;
+        constexpr uint32_t stride = uses_srgb_model ? 4 : Channels;
+
+        // The spectral model is only bounded from below by zero
+        if (uses_srgb_model && !maximum)
+            return std::vector<ScalarFloat>((size_t) hprod(cells) * bands, 0.f);
+        auto combine = [maximum](ScalarFloat a, ScalarFloat b) {
+            return maximum ? std::max(a, b) : std::min(a, b);
+        };
+        const ScalarFloat initial = maximum ? 0.f : math::Infinity<ScalarFloat>;
+
+        /* Components whose extremum is tracked: the scale factor and the
+           maximum of the spectral model within each band, each color channel,
+           or only the extremum over all channels */
+        const bool per_band = uses_srgb_model && bands > 1,
+                   per_channel = is_rgb_v<Spectrum> && Channels == 3 && bands == 3;
+        const uint32_t components = per_band ? bands + 1 : (per_channel ? 3 : 1);
+
+        // Access the voxels on the host
+        DynamicBuffer<Float> data(m_data);
+        data = data.managed();
+        DynamicBuffer<UInt32> packed(m_packed);
+        packed = packed.managed();
+        const ScalarFloat *ptr = data.data();
+        const uint32_t *packed_ptr = packed.data();
+
+        /* Extremum of each node, i.e. each voxel of a dense grid or each brick
+           of a sparse one (the scale factor bounds the spectral model) */
+        const ScalarVector3i &shape = m_metadata.shape;
+        const int32_t node_shift = m_sparse ? 3 : 0;
+        const size_t node_size = (size_t) 1 << (3 * node_shift);
+        ScalarVector3i nodes = m_sparse ? m_bricks : shape;
+        std::vector<int32_t> brick_index;
+        if (m_sparse) {
+            DynamicBuffer<Int32> index(m_brick_index);
+            index = index.managed();
+            brick_index.assign(index.data(), index.data() + hprod(nodes));
+        }
+
+        const size_t node_count = (size_t) hprod(nodes);
+        std::vector<ScalarFloat> node_value(node_count * components, initial);
+        for (size_t i = 0; i < node_count; ++i) {
+            size_t first = m_sparse ? (size_t) brick_index[i] * node_size : i;
+            ScalarFloat *value = node_value.data() + i * components;
+            for (size_t j = first; j < first + node_size; ++j) {
+                if constexpr (uses_srgb_model) {
+                    value[0] = combine(value[0], stored_value(ptr, packed_ptr, j * stride + 3));
+                    if (per_band) {
+                        ScalarVector3f coeff(stored_value(ptr, packed_ptr, j * stride),
+                                             stored_value(ptr, packed_ptr, j * stride + 1),
+                                             stored_value(ptr, packed_ptr, j * stride + 2));
+                        for (uint32_t b = 0; b < bands; ++b)
+                            value[1 + b] = combine(value[1 + b],
+                                                   srgb_model_max(coeff, b, bands));
+                    }
+                } else {
+                    for (size_t c = 0; c < Channels; ++c) {
+                        ScalarFloat &v = value[per_channel ? c : 0];
+                        v = combine(v, stored_value(ptr, packed_ptr, j * stride + c));
+                    }
+                }
+            }
+        }
+
+        /* Trilinear interpolation reaches half a voxel beyond the cell, which
+           may wrap around the boundaries of the volume */
+        int32_t margin = m_filter_type == FilterType::Trilinear ? 1 : 0;
+        auto wrap_1 = [&](int32_t value, int32_t res) {
+            if (m_wrap_mode == WrapMode::Clamp)
+                return std::min(std::max(value, 0), res - 1);
+            int32_t mod = value % res;
+            if (mod < 0)
+                mod += res;
+            if (m_wrap_mode == WrapMode::Mirror &&
+                ((value < 0 ? (-value - 1) / res + 1 : value / res) & 1))
+                mod = res - 1 - mod;
+            return mod;
+        };
+
+        // Nodes that contain the (wrapped) voxels in [lo, hi) along one axis
+        auto node_range = [&](int32_t lo, int32_t hi, uint32_t axis) {
+            std::vector<int32_t> range;
+            for (int32_t v = lo; v < hi; ++v) {
+                int32_t node = wrap_1(v, shape[axis]) >> node_shift;
+                if (std::find(range.begin(), range.end(), node) == range.end())
+                    range.push_back(node);
+            }
+            return range;
+        };
+
+        std::vector<ScalarFloat> result((size_t) hprod(cells) * bands, 0.f),
+                                 value(components);
+        size_t index = 0;
+        for (int32_t cz = 0; cz < cells.z(); ++cz) {
+            for (int32_t cy = 0; cy < cells.y(); ++cy) {
+                for (int32_t cx = 0; cx < cells.x(); ++cx, ++index) {
+                    ScalarVector3i c(cx, cy, cz),
+                                   lo = c * shape / cells - margin,
+                                   hi = ((c + 1) * shape + cells - 1) / cells + margin;
+
+                    std::vector<int32_t> range_x = node_range(lo.x(), hi.x(), 0),
+                                         range_y = node_range(lo.y(), hi.y(), 1),
+                                         range_z = node_range(lo.z(), hi.z(), 2);
+
+                    std::fill(value.begin(), value.end(), initial);
+                    for (int32_t z : range_z)
+                        for (int32_t y : range_y)
+                            for (int32_t x : range_x) {
+                                const ScalarFloat *node = node_value.data() + components *
+                                    (((size_t) z * nodes.y() + y) * nodes.x() + x);
+                                for (uint32_t k = 0; k < components; ++k)
+                                    value[k] = combine(value[k], node[k]);
+                            }
+
+                    /* The scale factor and the spectral model are interpolated
+                       separately, hence their maxima bound the product */
+                    for (uint32_t b = 0; b < bands; ++b)
+                        result[index * bands + b] =
+                            per_band ? value[0] * value[1 + b]
+                                     : value[per_channel ? b : 0];
+                }
+            }
+        }
+
+        return result;
+    }
+
+    /**
+     * \brief Maximum of the spectral model with coefficients \c coeff within
+     * the band \c band of \c bands equal bands of the wavelength range
+     *
+     * The model is an increasing function of a quadratic polynomial of the
+     * wavelength, which reaches its maximum at the ends of the band or at its
+     * vertex. The bound is slightly enlarged to account for the rounding of
+     * the single precision evaluation.
+     */
+    static ScalarFloat srgb_model_max(const ScalarVector3f &coeff, uint32_t band,
+                                      uint32_t bands) {
+        if (std::isinf(coeff.z()))
+            return coeff.z() > 0.f ? 1.f : 0.f;
+
+        double width = (MTS_WAVELENGTH_MAX - MTS_WAVELENGTH_MIN) / (double) bands,
+               lo = MTS_WAVELENGTH_MIN + band * width,
+               hi = lo + width;
+        auto poly = [&](double lambda) {
+            return ((double) coeff.x() * lambda + coeff.y()) * lambda + coeff.z();
+        };
+
+        double x = std::max(poly(lo), poly(hi));
+        if (coeff.x() < 0.f) {
+            double vertex = -coeff.y() / (2.0 * coeff.x());
+            if (vertex > lo && vertex < hi)
+                x = std::max(x, poly(vertex));
+        }
+
+        double value = .5 * x / std::sqrt(x * x + 1.0) + .5;
+        return (ScalarFloat) std::max(0.0, std::min(1.0, value * (1.0 + 1e-4) + 1e-6));
+    }
+
     ScalarVector3i resolution() const override { return m_metadata.shape; };
     auto data_size() const { return m_data.size(); }
 
     void traverse(TraversalCallback *callback) override {
-        callback->put_parameter("data", m_data);
-        callback->put_parameter("size", m_size);
+        // The voxels of sparse and reduced precision grids cannot be modified
+        if (!m_sparse && m_format == StorageFormat::Float32) {
+            callback->put_parameter("data", m_data);
+            callback->put_parameter("size", m_size);
+        }
         Base::traverse(callback);
     }
 
     void parameters_changed(const std::vector<std::string> &/*keys*/) override {
+        if (m_sparse || m_format != StorageFormat::Float32)
+            return;
+
         auto new_size = data_size();
         if (m_size != new_size) {
             // Only support a special case: resolution doubling along all axes
@@ -388,6 +973,36 @@ public:
             auto maximum = hmax(hmax(m_data));
             m_metadata.max = slice(maximum, 0);
         }
+
+        if (m_cuda_texture) {
+            // Recreate the texture object, whose resolution may have changed
+            m_cuda_texture = nullptr;
+            init_cuda_texture();
+        }
+    }
+
+    /// Create the texture object that performs the lookups on the GPU
+    void init_cuda_texture() {
+        if constexpr (is_cuda_array_v<Float>) {
+            constexpr bool uses_srgb_model = is_spectral_v<Spectrum> && !Raw && Channels == 3;
+
+            // Access the voxels on the host
+            DynamicBuffer<Float> data(m_data);
+            data = data.managed();
+
+            size_t shape[3] = { (size_t) m_metadata.shape.x(), (size_t) m_metadata.shape.y(),
+                                (size_t) m_metadata.shape.z() };
+            CUDATexture::WrapMode wrap_mode =
+                m_wrap_mode == WrapMode::Repeat ? CUDATexture::WrapMode::Repeat :
+                (m_wrap_mode == WrapMode::Mirror ? CUDATexture::WrapMode::Mirror
+                                                 : CUDATexture::WrapMode::Clamp);
+            m_cuda_texture = new CUDATexture(
+                3, shape, uses_srgb_model ? 4 : Channels, data.data(),
+                m_filter_type == FilterType::Nearest ? CUDATexture::FilterMode::Nearest
+                                                     : CUDATexture::FilterMode::Linear,
+                wrap_mode);
+            m_memory.set(slices(m_data) * sizeof(ScalarFloat) + m_cuda_texture->size_bytes());
+        }
     }
 
     std::string to_string() const override {
@@ -397,7 +1012,9 @@ public:
             << "  dimensions = " << m_metadata.shape << "," << std::endl
             << "  mean = " << m_metadata.mean << "," << std::endl
             << "  max = " << m_metadata.max << "," << std::endl
-            << "  channels = " << m_metadata.channel_count << std::endl
+            << "  channels = " << m_metadata.channel_count << "," << std::endl
+            << "  sparse = " << (m_sparse ? "true" : "false") << "," << std::endl
+            << "  cuda_texture = " << (m_cuda_texture ? "true" : "false") << std::endl
             << "]";
         return oss.str();
     }
@@ -405,6 +1022,15 @@ public:
     MTS_DECLARE_CLASS()
 protected:
     DynamicBuffer<Float> m_data;
+    ref<const MemoryMappedFile> m_mmap;
+    /// Brick of each 8x8x8 block of voxels of a sparse grid (see \ref sparse_index())
+    DynamicBuffer<Int32> m_brick_index;
+    bool m_sparse;
+    ScalarVector3i m_bricks;
+    /// Values in reduced precision formats (see \ref fetch())
+    StorageFormat m_format;
+    DynamicBuffer<UInt32> m_packed;
+    ScalarVector4f m_offset, m_scale;
     bool m_fixed_max = false;
     VolumeMetadata m_metadata;
     enoki::divisor<int32_t> m_inv_resolution_x, m_inv_resolution_y, m_inv_resolution_z;
@@ -412,6 +1038,12 @@ protected:
     ScalarUInt32 m_size;
     FilterType m_filter_type;
     WrapMode m_wrap_mode;
+
+    /// Texture object performing the lookups in GPU variants (see \ref CUDATexture)
+    ref<CUDATexture> m_cuda_texture;
+
+    /// Memory of the voxel storage (see \ref MemoryCategory::Volumes)
+    MemoryRecord m_memory { MemoryCategory::Volumes };
 };
 
 MTS_IMPLEMENT_CLASS_VARIANT(GridVolume, Volume)
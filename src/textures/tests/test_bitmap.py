@@ -59,4 +59,353 @@ def test02_eval_grad(variant_scalar_rgb):
             fv = bitmap.eval_1(si)
             gradient_finite_difference = Vector2f((fu - f)/delta, (fv - f)/delta)
             gradient_analytic = bitmap.eval_1_grad(si)
-            assert ek.allclose(0, ek.abs(gradient_finite_difference/gradient_analytic - 1.0), atol = 1e04)
\ No newline at end of file
+            assert ek.allclose(0, ek.abs(gradient_finite_difference/gradient_analytic - 1.0), atol = 1e04)
+
+@fresolver_append_path
+@pytest.mark.parametrize('filter_type', ['trilinear', 'anisotropic'])
+def test03_eval_mip(variant_scalar_rgb, filter_type):
+    # MIP map lookups must match bilinear ones without a footprint, and
+    # approach the mean value of the texture for large footprints
+    from mitsuba.render import SurfaceInteraction3f
+    from mitsuba.core.xml import load_string
+    from mitsuba.core import Vector2f
+    import numpy as np
+    import enoki as ek
+
+    def load(filter_type):
+        return load_string("""
+        <texture type="bitmap" version="2.0.0">
+            <string name="filename" value="resources/data/common/textures/noise_8x8.png"/>
+            <string name="filter_type" value="%s"/>
+        </texture>""" % filter_type).expand()[0]
+
+    bitmap, reference = load(filter_type), load('bilinear')
+    assert bitmap.needs_differentials() and not reference.needs_differentials()
+
+    si = SurfaceInteraction3f()
+    for uv in np.random.rand(10, 2):
+        si.uv = Vector2f(uv)
+        si.duv_dx = si.duv_dy = Vector2f(0, 0)
+        assert ek.allclose(bitmap.eval_1(si), reference.eval_1(si), atol=1e-5)
+
+        si.duv_dx, si.duv_dy = Vector2f(4, 0), Vector2f(0, 4)
+        assert ek.allclose(bitmap.eval_1(si), bitmap.mean(), atol=1e-3)
+
+        # A footprint that is stretched along the u axis blurs it more
+        si.duv_dx, si.duv_dy = Vector2f(0.5, 0), Vector2f(0, 0.05)
+        value = bitmap.eval_1(si)
+        assert value >= 0 and value <= 1
+
+
+@pytest.mark.parametrize('filter_type', ['nearest', 'bilinear', 'trilinear'])
+def test04_eval_tiled(variant_scalar_rgb, tmpdir, filter_type):
+    # Tiled textures must match in-memory ones and reuse their tiled version
+    from mitsuba.render import SurfaceInteraction3f
+    from mitsuba.core import Vector2f, Thread, TileCache
+    from mitsuba.core.xml import load_string
+    import numpy as np
+    import enoki as ek
+    import shutil
+    import os
+
+    fs = Thread.thread().file_resolver()
+    filename = str(tmpdir.join('noise_8x8.png'))
+    shutil.copy(str(fs.resolve('resources/data/common/textures/noise_8x8.png')), filename)
+
+    def load(tiled):
+        return load_string("""
+        <texture type="bitmap" version="2.0.0">
+            <string name="filename" value="%s"/>
+            <string name="filter_type" value="%s"/>
+            <boolean name="tiled" value="%s"/>
+            <integer name="tile_size" value="4"/>
+        </texture>""" % (filename, filter_type, tiled)).expand()[0]
+
+    reference, bitmap = load('false'), load('true')
+    assert os.path.exists(filename + '.linear.mtstex')
+
+    cache = TileCache.instance()
+    misses = cache.miss_count()
+
+    si = SurfaceInteraction3f()
+    for uv in np.random.rand(20, 2):
+        si.uv = Vector2f(uv)
+        si.duv_dx, si.duv_dy = Vector2f(uv[0] * 0.5, 0), Vector2f(0, uv[1] * 0.5)
+        assert ek.allclose(bitmap.eval_1(si), reference.eval_1(si), atol=1e-5)
+
+    # The pyramid of the 8x8 image has 7 tiles, which are only loaded once
+    assert cache.miss_count() - misses <= 7
+    assert cache.hit_count() > 0
+
+    # Loading the texture again reuses the tiled file
+    mtime = os.path.getmtime(filename + '.linear.mtstex')
+    bitmap = load('true')
+    assert os.path.getmtime(filename + '.linear.mtstex') == mtime
+    si.uv = Vector2f(0.3, 0.6)
+    assert ek.allclose(bitmap.eval_1(si), reference.eval_1(si), atol=1e-5)
+
+
+@fresolver_append_path
+def test05_shared(variant_scalar_rgb):
+    # Textures with the same file and settings share their implementation
+    from mitsuba.core.xml import load_string
+
+    def load(raw='false', shared='true'):
+        return load_string("""
+        <texture type="bitmap" version="2.0.0">
+            <string name="filename" value="resources/data/common/textures/noise_8x8.png"/>
+            <boolean name="raw" value="%s"/>
+            <boolean name="shared" value="%s"/>
+        </texture>""" % (raw, shared)).expand()[0]
+
+    a, b = load(), load()
+    assert a is b
+    assert load(raw='true') is not a
+    assert load(shared='false') is not a
+
+
+@fresolver_append_path
+@pytest.mark.parametrize('raw', ['false', 'true'])
+def test06_eval_compressed(variant_scalar_rgb, raw):
+    # Block compressed textures must approximate uncompressed ones
+    from mitsuba.render import SurfaceInteraction3f
+    from mitsuba.core.xml import load_string
+    from mitsuba.core import Vector2f
+    import numpy as np
+    import enoki as ek
+
+    def load(filename, compressed):
+        return load_string("""
+        <texture type="bitmap" version="2.0.0">
+            <string name="filename" value="resources/data/common/textures/%s"/>
+            <boolean name="raw" value="%s"/>
+            <boolean name="compressed" value="%s"/>
+        </texture>""" % (filename, raw, compressed)).expand()[0]
+
+    si = SurfaceInteraction3f()
+    for filename in ['carrot.png', 'noise_8x8.png']:
+        reference, bitmap = load(filename, 'false'), load(filename, 'true')
+        assert 'compressed = true' in str(bitmap)
+
+        for uv in np.random.rand(20, 2):
+            si.uv = Vector2f(uv)
+            assert ek.allclose(bitmap.eval_3(si), reference.eval_3(si), atol=0.1)
+
+
+@fresolver_append_path
+@pytest.mark.parametrize('filter_type', ['bilinear', 'trilinear'])
+def test07_eval_half(variant_scalar_rgb, filter_type):
+    # Half precision textures must match single precision ones up to rounding
+    from mitsuba.render import SurfaceInteraction3f
+    from mitsuba.core.xml import load_string
+    from mitsuba.core import Vector2f
+    import numpy as np
+    import enoki as ek
+
+    def load(half):
+        return load_string("""
+        <texture type="bitmap" version="2.0.0">
+            <string name="filename" value="resources/data/common/textures/carrot.png"/>
+            <string name="filter_type" value="%s"/>
+            <boolean name="half_precision" value="%s"/>
+        </texture>""" % (filter_type, half)).expand()[0]
+
+    reference, bitmap = load('false'), load('true')
+    assert 'half_precision = true' in str(bitmap)
+
+    si = SurfaceInteraction3f()
+    for uv in np.random.rand(20, 2):
+        si.uv = Vector2f(uv)
+        assert ek.allclose(bitmap.eval_3(si), reference.eval_3(si), atol=2e-3)
+        assert ek.allclose(bitmap.pdf_position(si.uv), reference.pdf_position(si.uv),
+                           rtol=1e-2)
+
+
+@fresolver_append_path
+@pytest.mark.parametrize('filter_type', ['nearest', 'bilinear', 'trilinear'])
+@pytest.mark.parametrize('wrap_mode', ['repeat', 'clamp', 'mirror'])
+def test08_eval_blocked(variant_scalar_rgb, filter_type, wrap_mode):
+    # The blocked pixel layout must not change the result of lookups
+    from mitsuba.render import SurfaceInteraction3f
+    from mitsuba.core.xml import load_string
+    from mitsuba.core import Vector2f
+    import numpy as np
+    import enoki as ek
+
+    def load(blocked):
+        return load_string("""
+        <texture type="bitmap" version="2.0.0">
+            <string name="filename" value="resources/data/common/textures/carrot.png"/>
+            <string name="filter_type" value="%s"/>
+            <string name="wrap_mode" value="%s"/>
+            <boolean name="blocked" value="%s"/>
+        </texture>""" % (filter_type, wrap_mode, blocked)).expand()[0]
+
+    reference, bitmap = load('false'), load('true')
+    assert 'blocked = true' in str(bitmap)
+
+    si = SurfaceInteraction3f()
+    for uv in np.random.rand(20, 2) * 3 - 1:
+        si.uv = Vector2f(uv)
+        assert ek.allclose(bitmap.eval_3(si), reference.eval_3(si))
+        assert ek.allclose(bitmap.pdf_position(si.uv), reference.pdf_position(si.uv))
+
+
+@fresolver_append_path
+def test09_eval_coefficient_interpolation(variant_scalar_spectral):
+    # Interpolating the spectral model coefficients must stay close to the
+    # interpolation of the spectra
+    from mitsuba.render import SurfaceInteraction3f
+    from mitsuba.core.xml import load_string
+    from mitsuba.core import Vector2f
+    import numpy as np
+    import enoki as ek
+
+    def load(interpolate):
+        return load_string("""
+        <texture type="bitmap" version="2.0.0">
+            <string name="filename" value="resources/data/common/textures/carrot.png"/>
+            <boolean name="coefficient_interpolation" value="%s"/>
+        </texture>""" % interpolate).expand()[0]
+
+    reference, bitmap = load('false'), load('true')
+    assert 'coefficient_interpolation = true' in str(bitmap)
+
+    si = SurfaceInteraction3f()
+    si.wavelengths = [450, 500, 550, 600]
+    for uv in np.random.rand(20, 2):
+        si.uv = Vector2f(uv)
+        assert ek.allclose(bitmap.eval(si), reference.eval(si), atol=5e-2)
+
+
+@fresolver_append_path
+@pytest.mark.parametrize('filter_type', ['nearest', 'bilinear'])
+@pytest.mark.parametrize('wrap_mode', ['repeat', 'clamp', 'mirror'])
+def test10_eval_cuda_texture(variant_gpu_rgb, filter_type, wrap_mode):
+    # Lookups through the texture hardware must match the software lookups
+    # up to the precision of the interpolation weights
+    from mitsuba.render import SurfaceInteraction3f
+    from mitsuba.core.xml import load_string
+    from mitsuba.core import Float, Vector2f
+    import numpy as np
+    import enoki as ek
+
+    def load(cuda_texture):
+        return load_string("""
+        <texture type="bitmap" version="2.0.0">
+            <string name="filename" value="resources/data/common/textures/carrot.png"/>
+            <string name="filter_type" value="%s"/>
+            <string name="wrap_mode" value="%s"/>
+            <boolean name="cuda_texture" value="%s"/>
+        </texture>""" % (filter_type, wrap_mode, cuda_texture)).expand()[0]
+
+    reference, bitmap = load('false'), load('true')
+    assert 'cuda_texture = true' in str(bitmap)
+    assert 'cuda_texture = false' in str(reference)
+
+    uv = np.random.rand(2, 1000) * 3 - 1
+    si = SurfaceInteraction3f()
+    si.uv = Vector2f(Float(uv[0]), Float(uv[1]))
+
+    # Nearest neighbor lookups may round differently at texel boundaries
+    err = ek.hmax(ek.abs(bitmap.eval_3(si) - reference.eval_3(si)))
+    assert ek.count(err > 1e-2) < 10
+
+
+@fresolver_append_path
+@pytest.mark.parametrize('filter_type', ['bilinear', 'trilinear'])
+def test11_eval_cache_lookups(variant_scalar_rgb, filter_type):
+    # Cached lookups must match uncached ones, also after the pixels change
+    from mitsuba.render import SurfaceInteraction3f
+    from mitsuba.core.xml import load_string
+    from mitsuba.python.util import traverse
+    from mitsuba.core import Vector2f
+    import numpy as np
+    import enoki as ek
+
+    def load(cache):
+        return load_string("""
+        <texture type="bitmap" version="2.0.0">
+            <string name="filename" value="resources/data/common/textures/carrot.png"/>
+            <string name="filter_type" value="%s"/>
+            <boolean name="cache_lookups" value="%s"/>
+            <boolean name="shared" value="false"/>
+        </texture>""" % (filter_type, cache)).expand()[0]
+
+    reference, bitmap = load('false'), load('true')
+    assert 'cache_lookups = true' in str(bitmap)
+
+    si = SurfaceInteraction3f()
+    uvs = np.random.rand(20, 2)
+    for uv in uvs:
+        si.uv = Vector2f(uv)
+        value = bitmap.eval_3(si)
+        assert ek.allclose(value, reference.eval_3(si))
+        assert ek.allclose(bitmap.eval_3(si), value)
+        assert ek.allclose(bitmap.eval_1(si), reference.eval_1(si))
+
+    params = traverse(bitmap)
+    params['data'] = params['data'] * 0.5
+    params.set_dirty('data')
+    params.update()
+
+    for uv in uvs:
+        si.uv = Vector2f(uv)
+        assert ek.allclose(bitmap.eval_3(si), 0.5 * reference.eval_3(si))
+
+
+@fresolver_append_path
+def test12_eval_lazy(variant_scalar_rgb):
+    # Lazily decoded textures only read the header until they are first used
+    from mitsuba.render import SurfaceInteraction3f
+    from mitsuba.core.xml import load_string
+    from mitsuba.core import Vector2f
+    import numpy as np
+    import enoki as ek
+
+    def load(lazy):
+        return load_string("""
+        <texture type="bitmap" version="2.0.0">
+            <string name="filename" value="resources/data/common/textures/carrot.png"/>
+            <boolean name="lazy" value="%s"/>
+        </texture>""" % lazy).expand()[0]
+
+    reference, bitmap = load('false'), load('true')
+    assert '<not decoded>' in str(bitmap)
+    assert ek.all(bitmap.resolution() == reference.resolution())
+
+    si = SurfaceInteraction3f()
+    for uv in np.random.rand(20, 2):
+        si.uv = Vector2f(uv)
+        assert ek.allclose(bitmap.eval_3(si), reference.eval_3(si))
+    assert '<not decoded>' not in str(bitmap)
+    assert ek.allclose(bitmap.mean(), reference.mean())
+
+
+@fresolver_append_path
+def test13_shared_deduplication(variant_scalar_rgb):
+    # Textures with shared=false are not merged by the scene loader either
+    from mitsuba.core import xml
+
+    def bsdfs(shared):
+        scene = xml.load_string("""<scene version="2.0.0">""" + "".join("""
+            <shape type="sphere">
+                <float name="radius" value="%i"/>
+                <bsdf type="diffuse">
+                    <texture type="bitmap" name="reflectance">
+                        <string name="filename" value="resources/data/common/textures/carrot.png"/>
+                        <boolean name="shared" value="%s"/>
+                    </texture>
+                </bsdf>
+            </shape>""" % (i + 1, shared) for i in range(2)) + "</scene>")
+        shapes = sorted(scene.shapes(), key=lambda s: s.bbox().max.x)
+        return [s.bsdf() for s in shapes]
+
+    xml.set_deduplication(True)
+    try:
+        b = bsdfs('true')
+        assert b[0] is b[1]
+        b = bsdfs('false')
+        assert b[0] is not b[1]
+    finally:
+        xml.set_deduplication(False)
@@ -125,4 +125,23 @@ def test03_invalid_attribute(variant_scalar_rgb):
 
     with pytest.raises(Exception) as e:
         texture.eval(si)
-    e.match("Invalid attribute requested")
\ No newline at end of file
+    e.match("Invalid attribute requested")
+
+def test04_eval_batched(variant_scalar_rgb):
+    mesh = create_rectangle()
+
+    for u, v in [(0.0, 0.0), (1.0, 0.0), (0.3, 0.4), (0.5, 0.5), (0.8, 0.9)]:
+        si = mesh.eval_parameterization([u, v])
+
+        values = mesh.eval_attributes_3(["vertex_color", "face_color"], si)
+        assert len(values) == 2
+        assert ek.allclose(values[0], [u, v, 0])
+        assert ek.allclose(values[1], [0, 0, si.prim_index])
+
+        values = mesh.eval_attributes_1(["face_mono", "vertex_mono"], si)
+        assert ek.allclose(values[0], si.prim_index)
+        assert ek.allclose(values[1], 1 + u + 2 * v)
+
+    with pytest.raises(Exception) as e:
+        mesh.eval_attributes_1(["vertex_mono", "vertex_color"], si)
+    e.match("requested but had size 3")
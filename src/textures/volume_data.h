@@ -6,9 +6,13 @@
 /// @file Helper functions for volume data handling.
 #include <mitsuba/core/fresolver.h>
 #include <mitsuba/core/math.h>
+#include <mitsuba/core/mmap.h>
+#include <mitsuba/core/stream.h>
 #include <mitsuba/core/thread.h>
 #include <mitsuba/core/transform.h>
 #include <mitsuba/render/volume_texture.h>
+#include <tbb/blocked_range.h>
+#include <tbb/parallel_for.h>
 
 NAMESPACE_BEGIN(mitsuba)
 
@@ -35,13 +39,16 @@ auto bbox_transform(const BoundingBox<Point<Float, 3>> &bbox) {
 NAMESPACE_END(detail)
 
 /**
- * Reads a Mitsuba binary volume file.
+ * Opens a Mitsuba binary volume file and reads its header.
+ *
+ * The returned stream is positioned at the start of the voxel data, which
+ * consists of \c channel_count single precision values per voxel (with \c x
+ * varying fastest). The \c mean and \c max fields of the metadata are left
+ * for the caller to compute.
  */
-// TODO: document data format.
-// TODO: what if Float is a GPU array, should we upload to it directly?
 template <typename Float>
-std::pair<VolumeMetadata, std::unique_ptr<scalar_t<Float>[]>>
-read_binary_volume_data(const std::string &filename) {
+std::pair<VolumeMetadata, std::ifstream>
+open_binary_volume_data(const std::string &filename) {
     MTS_IMPORT_CORE_TYPES()
 
     VolumeMetadata meta;
@@ -82,6 +89,60 @@ read_binary_volume_data(const std::string &filename) {
     meta.mean      = 0.;
     meta.max       = -math::Infinity<ScalarFloat>;
 
+    return { meta, std::move(f) };
+}
+
+/**
+ * Maps the voxel data of a Mitsuba binary volume file into memory.
+ *
+ * The file is mapped copy-on-write, hence its pages are shared with the page
+ * cache (and with other processes that map the same file) until they are
+ * modified. The returned pointer refers to the \c channel_count values per
+ * voxel within the mapping, which are converted in place (and in parallel)
+ * to the byte order of the host if necessary. Like \ref
+ * open_binary_volume_data(), the \c mean and \c max fields of the metadata
+ * are left for the caller to compute.
+ */
+template <typename Float>
+std::tuple<VolumeMetadata, ref<MemoryMappedFile>, const float *>
+map_binary_volume_data(const std::string &filename) {
+    auto [meta, f] = open_binary_volume_data<Float>(filename);
+    size_t offset = (size_t) f.tellg(),
+           count  = (size_t) hprod(meta.shape) * meta.channel_count;
+    f.close();
+
+    ref<MemoryMappedFile> mmap = MemoryMappedFile::map_copy_on_write(meta.filename);
+    if (mmap->size() < offset + count * sizeof(float))
+        Throw("Volume file %s is truncated", filename);
+
+    float *values = (float *) ((uint8_t *) mmap->data() + offset);
+
+    // The voxels are stored in little endian byte order
+    if (Stream::host_byte_order() != Stream::ELittleEndian) {
+        tbb::parallel_for(
+            tbb::blocked_range<size_t>(0, count, 65536),
+            [values](const tbb::blocked_range<size_t> &range) {
+                for (size_t i = range.begin(); i != range.end(); ++i)
+                    values[i] = detail::swap(values[i]);
+            });
+    }
+
+    return { meta, mmap, values };
+}
+
+/**
+ * Reads a Mitsuba binary volume file.
+ */
+// TODO: document data format.
+// TODO: what if Float is a GPU array, should we upload to it directly?
+template <typename Float>
+std::pair<VolumeMetadata, std::unique_ptr<scalar_t<Float>[]>>
+read_binary_volume_data(const std::string &filename) {
+    MTS_IMPORT_CORE_TYPES()
+
+    auto [meta, f] = open_binary_volume_data<Float>(filename);
+    size_t size    = hprod(meta.shape);
+
     auto raw_data = std::unique_ptr<ScalarFloat[]>(new ScalarFloat[size * meta.channel_count]);
     size_t k      = 0;
     for (size_t i = 0; i < size; ++i) {